@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short common helpers for the microbenchmarks
+ *
+ * Each benchmark runs its body a number of times, and prints one JSON object
+ * per line on stdout with the best and median costs per operation, in
+ * nanoseconds and in the units of the checkasm cycle timer.
+ */
+
+#ifndef _BENCHMARKS_BENCH_H_
+/** @hidden */
+#define _BENCHMARKS_BENCH_H_
+
+#include "config.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+/* config variables expected by the FFmpeg timer */
+#define ARCH_AARCH64 0
+#define ARCH_ARM 0
+#define ARCH_PPC 0
+#define CONFIG_LINUX_PERF 0
+#define HAVE_MACH_ABSOLUTE_TIME 0
+#define HAVE_RDTSC 0
+#if defined(__i686__) || defined(__x86_64__)
+#define ARCH_X86 1
+#if defined(__x86_64__)
+#define ARCH_X86_64 1
+#else
+#define ARCH_X86_64 0
+#endif
+#define HAVE_INLINE_ASM 1
+#else
+#define ARCH_X86 0
+#define ARCH_X86_64 0
+#define HAVE_INLINE_ASM 0
+#endif
+#include "timer.h"
+
+/** default number of runs of each benchmark */
+#define BENCH_RUNS 7
+
+/** function running a benchmark body
+ *
+ * @param opaque benchmark private data
+ * @param ops number of operations to run
+ */
+typedef void (*bench_cb)(void *opaque, uint64_t ops);
+
+/** @This holds the benchmark options. */
+struct bench_opts {
+    /** number of runs of each benchmark */
+    unsigned int runs;
+    /** multiplier of the number of operations */
+    double scale;
+    /** only run the benchmarks starting with this prefix, or NULL */
+    const char *filter;
+};
+
+/** @This parses the command line of a benchmark program, which is
+ * [scale [runs [filter]]].
+ *
+ * @param opts filled in with the options
+ * @param argc number of arguments
+ * @param argv arguments
+ */
+static inline void bench_init(struct bench_opts *opts, int argc, char **argv)
+{
+    opts->runs = BENCH_RUNS;
+    opts->scale = 1.;
+    opts->filter = NULL;
+    if (argc > 1)
+        opts->scale = atof(argv[1]);
+    if (argc > 2)
+        opts->runs = atoi(argv[2]);
+    if (argc > 3)
+        opts->filter = argv[3];
+    if (opts->scale <= 0.)
+        opts->scale = 1.;
+    if (!opts->runs)
+        opts->runs = 1;
+}
+
+/** @This returns the monotonic time in nanoseconds.
+ *
+ * @return current time
+ */
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+/** @This returns the value of the cycle timer, or 0 if it is unavailable.
+ *
+ * @return current cycle count
+ */
+static inline uint64_t bench_now_cycles(void)
+{
+#ifdef AV_READ_TIME
+    return AV_READ_TIME();
+#else
+    return 0;
+#endif
+}
+
+/** @internal @This compares two doubles for qsort.
+ */
+static inline int bench_cmp(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+/** @This runs a benchmark and prints its result.
+ *
+ * @param opts benchmark options
+ * @param name name of the benchmark
+ * @param threads number of threads involved, for the report
+ * @param ops number of operations per run, before scaling
+ * @param cb function running the benchmark body
+ * @param opaque benchmark private data
+ */
+static inline void bench_run(const struct bench_opts *opts, const char *name,
+                             unsigned int threads, uint64_t ops,
+                             bench_cb cb, void *opaque)
+{
+    if (opts->filter != NULL &&
+        strncmp(name, opts->filter, strlen(opts->filter)))
+        return;
+
+    ops *= opts->scale;
+    if (!ops)
+        ops = 1;
+    double ns[opts->runs], cycles[opts->runs];
+
+    /* warm up caches and pools */
+    cb(opaque, ops / 10 + 1);
+
+    for (unsigned int i = 0; i < opts->runs; i++) {
+        uint64_t start_cycles = bench_now_cycles();
+        uint64_t start_ns = bench_now_ns();
+        cb(opaque, ops);
+        ns[i] = (double)(bench_now_ns() - start_ns) / ops;
+        cycles[i] = (double)(bench_now_cycles() - start_cycles) / ops;
+    }
+    qsort(ns, opts->runs, sizeof(double), bench_cmp);
+    qsort(cycles, opts->runs, sizeof(double), bench_cmp);
+
+    printf("{\"bench\":\"%s\",\"threads\":%u,\"ops\":%"PRIu64","
+           "\"runs\":%u,\"ns_per_op\":%.3f,\"ns_per_op_median\":%.3f,"
+           "\"cycles_per_op\":%.3f,\"cycles_per_op_median\":%.3f}\n",
+           name, threads, ops, opts->runs, ns[0], ns[opts->runs / 2],
+           cycles[0], cycles[opts->runs / 2]);
+    fflush(stdout);
+}
+
+#endif
@@ -0,0 +1,608 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short end-to-end pipeline benchmarks
+ *
+ * Each case builds a representative graph, pushes a canned stream through it
+ * as fast as possible, and prints one JSON object with the packet and frame
+ * rates, followed by one JSON object per instrumented stage with the time
+ * spent in its input function (including the downstream pipes it calls
+ * synchronously), see @ref upipe_stats_enable.
+ *
+ * The cases are:
+ * @list
+ * @item ts2es: TS demux and framers, as in examples/ts2es.c, fed from memory
+ * with the TS file given in UPIPE_BENCH_TS (by default tests/upipe_ts_test.ts),
+ * looped to build a larger input (requires upipe-ts)
+ * @item udp_loopback: udpsink to udpsrc on the loopback interface, with a
+ * bounded number of datagrams in flight
+ * @end list
+ *
+ * This file is built against upump-ev, or against upump-uring when
+ * BENCH_UPUMP_URING is defined.
+ */
+
+#undef NDEBUG
+
+#include "bench.h"
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_upump_mgr.h>
+#include <upipe/uprobe_uclock.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/uprobe_select_flows.h>
+#include <upipe/umem.h>
+#include <upipe/umem_pool.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_std.h>
+#include <upipe/uclock.h>
+#include <upipe/uclock_std.h>
+#include <upipe/upump.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe-modules/upipe_udp_source.h>
+#include <upipe-modules/upipe_udp_sink.h>
+#ifdef BENCH_UPUMP_URING
+#include <upump-uring/upump_uring.h>
+#else
+#include <upump-ev/upump_ev.h>
+#endif
+#ifdef BENCH_TS
+#include <upipe-ts/upipe_ts_demux.h>
+#include <upipe-framers/upipe_auto_framer.h>
+#endif
+
+#include <assert.h>
+
+#define UPROBE_LOG_LEVEL    UPROBE_LOG_WARNING
+#define UMEM_POOL           512
+#define UDICT_POOL_DEPTH    500
+#define UREF_POOL_DEPTH     500
+#define UBUF_POOL_DEPTH     3000
+#define UBUF_SHARED_POOL_DEPTH 50
+#define UPUMP_POOL          10
+#define UPUMP_BLOCKER_POOL  10
+#define MAX_STAGES          8
+#define TS_SIZE             188
+#define TS_CHUNK            (7 * TS_SIZE)
+#define NB_TS_LOOPS         20
+#define NB_DATAGRAMS        100000
+#define DATAGRAM_SIZE       1316
+#define DATAGRAM_BURST      16
+#define DATAGRAMS_IN_FLIGHT 256
+#define UDP_PORT_BASE       42000
+#define UDP_DRAIN           (UCLOCK_FREQ / 10)
+
+/** common benchmark environment */
+struct bench_env {
+    struct umem_mgr *umem_mgr;
+    struct uref_mgr *uref_mgr;
+    struct ubuf_mgr *ubuf_mgr;
+    struct upump_mgr *upump_mgr;
+    struct uclock *uclock;
+    struct uprobe *uprobe;
+};
+
+/** instrumented stage */
+struct bench_stage {
+    /** pipe, which is used */
+    struct upipe *upipe;
+    /** name of the stage */
+    char name[32];
+};
+
+/** result of a case */
+struct bench_result {
+    /** number of packets entering the graph */
+    uint64_t packets;
+    /** number of octets entering the graph */
+    uint64_t bytes;
+    /** number of urefs leaving the graph */
+    uint64_t frames;
+    /** wall-clock duration of the run, in ns */
+    uint64_t duration;
+    /** instrumented stages */
+    struct bench_stage stages[MAX_STAGES];
+    /** instrumentation counters of the stages */
+    struct upipe_stats stats[MAX_STAGES];
+    /** number of instrumented stages */
+    unsigned int nb_stages;
+};
+
+/** @internal @This adds an instrumented stage to a result. */
+static void bench_add_stage(struct bench_env *env,
+                            struct bench_result *result,
+                            struct upipe *upipe, const char *name)
+{
+    if (result->nb_stages >= MAX_STAGES || upipe->stats != NULL)
+        return;
+    ubase_assert(upipe_stats_enable(upipe, env->uclock, 0));
+    struct bench_stage *stage = &result->stages[result->nb_stages++];
+    stage->upipe = upipe_use(upipe);
+    snprintf(stage->name, sizeof(stage->name), "%s", name);
+}
+
+/** @internal @This reads and releases the instrumented stages. */
+static void bench_collect_stages(struct bench_result *result)
+{
+    for (unsigned int i = 0; i < result->nb_stages; i++) {
+        ubase_assert(upipe_get_stats(result->stages[i].upipe,
+                                     &result->stats[i]));
+        upipe_release(result->stages[i].upipe);
+        result->stages[i].upipe = NULL;
+    }
+}
+
+/** @internal @This prints the result of a case. */
+static void bench_print_result(const char *name,
+                               const struct bench_result *result)
+{
+    double seconds = (double)result->duration / 1000000000.;
+    if (seconds <= 0.)
+        seconds = 1e-9;
+    printf("{\"bench\":\"%s\",\"threads\":1,\"packets\":%"PRIu64","
+           "\"frames\":%"PRIu64",\"seconds\":%.6f,\"packets_per_s\":%.1f,"
+           "\"frames_per_s\":%.1f,\"mbit_per_s\":%.3f}\n",
+           name, result->packets, result->frames, seconds,
+           result->packets / seconds, result->frames / seconds,
+           result->bytes * 8 / seconds / 1000000.);
+    for (unsigned int i = 0; i < result->nb_stages; i++) {
+        const struct upipe_stats *stats = &result->stats[i];
+        double cpu_ns = stats->input_time * 1000. / (UCLOCK_FREQ / 1000000);
+        printf("{\"bench\":\"%s\",\"stage\":\"%s\",\"urefs\":%"PRIu64","
+               "\"bytes\":%"PRIu64",\"cpu_ns\":%.0f,\"cpu_ns_per_uref\":%.1f,"
+               "\"cpu_share\":%.4f,\"p99_ns\":%.0f,\"max_ns\":%.0f}\n",
+               name, result->stages[i].name, stats->urefs, stats->bytes,
+               cpu_ns, stats->urefs ? cpu_ns / stats->urefs : 0.,
+               cpu_ns / result->duration,
+               upipe_stats_latency_percentile(stats, 99) * 1000. /
+                   (UCLOCK_FREQ / 1000000),
+               stats->max_input_time * 1000. / (UCLOCK_FREQ / 1000000));
+    }
+    fflush(stdout);
+}
+
+/** @internal @This allocates a block uref holding a copy of a buffer. */
+static struct uref *bench_block_alloc(struct bench_env *env,
+                                      const uint8_t *buffer, int size)
+{
+    struct uref *uref = uref_block_alloc(env->uref_mgr, env->ubuf_mgr, size);
+    assert(uref != NULL);
+    uint8_t *w;
+    int w_size = -1;
+    ubase_assert(uref_block_write(uref, 0, &w_size, &w));
+    assert(w_size == size);
+    memcpy(w, buffer, size);
+    ubase_assert(uref_block_unmap(uref, 0));
+    return uref;
+}
+
+/** pipe counting the urefs leaving the graph */
+struct bench_sink {
+    /** number of urefs received */
+    uint64_t urefs;
+    /** number of octets received */
+    uint64_t bytes;
+    /** date of the last uref received, in ns */
+    uint64_t last;
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(bench_sink, upipe, 0);
+
+/** @internal @This counts and frees a uref. */
+static void bench_sink_input(struct upipe *upipe, struct uref *uref,
+                             struct upump **upump_p)
+{
+    struct bench_sink *bench_sink = bench_sink_from_upipe(upipe);
+    size_t size;
+    bench_sink->urefs++;
+    bench_sink->last = bench_now_ns();
+    if (uref->ubuf != NULL && ubase_check(uref_block_size(uref, &size)))
+        bench_sink->bytes += size;
+    uref_free(uref);
+}
+
+/** @internal @This accepts all flows. */
+static int bench_sink_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal */
+static struct upipe_mgr bench_sink_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = NULL,
+    .upipe_input = bench_sink_input,
+    .upipe_control = bench_sink_control
+};
+
+/** @internal @This initializes a counting sink. */
+static void bench_sink_init(struct bench_sink *bench_sink,
+                            struct uprobe *uprobe)
+{
+    bench_sink->urefs = 0;
+    bench_sink->bytes = 0;
+    bench_sink->last = 0;
+    upipe_init(&bench_sink->upipe, &bench_sink_mgr, uprobe);
+}
+
+#ifdef BENCH_TS
+/** context of the ts2es case */
+struct bench_ts {
+    struct bench_env *env;
+    struct bench_result *result;
+    struct uprobe uprobe_es;
+    struct bench_sink sink;
+    /** number of elementary streams */
+    unsigned int nb_es;
+};
+
+/** @internal @This connects the selected elementary streams to the sink. */
+static int bench_ts_catch_es(struct uprobe *uprobe, struct upipe *upipe,
+                             int event, va_list args)
+{
+    struct bench_ts *ctx = container_of(uprobe, struct bench_ts, uprobe_es);
+    if (event != UPROBE_NEED_OUTPUT)
+        return uprobe_throw_next(uprobe, upipe, event, args);
+
+    char name[32];
+    snprintf(name, sizeof(name), "es %u", ctx->nb_es++);
+    bench_add_stage(ctx->env, ctx->result, upipe, name);
+    return upipe_set_output(upipe, &ctx->sink.upipe);
+}
+
+/** @internal @This loads a TS file in chunks of TS packets. */
+static unsigned int bench_ts_load(struct bench_env *env, const char *path,
+                                  struct uref **chunks, unsigned int max)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "unable to open %s\n", path);
+        return 0;
+    }
+    unsigned int nb = 0;
+    for (;;) {
+        uint8_t buffer[TS_CHUNK];
+        size_t size = fread(buffer, 1, TS_CHUNK, file);
+        size -= size % TS_SIZE;
+        if (!size || nb >= max)
+            break;
+        chunks[nb++] = bench_block_alloc(env, buffer, size);
+    }
+    fclose(file);
+    return nb;
+}
+
+/** runs the ts2es case */
+static void bench_ts2es(struct bench_env *env, const struct bench_opts *opts)
+{
+#define MAX_TS_CHUNKS 65536
+    const char *path = getenv("UPIPE_BENCH_TS");
+    if (path == NULL)
+        path = BENCH_TS;
+    struct uref **chunks = malloc(sizeof(struct uref *) * MAX_TS_CHUNKS);
+    assert(chunks != NULL);
+    unsigned int nb_chunks = bench_ts_load(env, path, chunks, MAX_TS_CHUNKS);
+    if (!nb_chunks) {
+        free(chunks);
+        return;
+    }
+    unsigned int loops = NB_TS_LOOPS * opts->scale;
+    if (!loops)
+        loops = 1;
+
+    struct upipe_mgr *upipe_ts_demux_mgr = upipe_ts_demux_mgr_alloc();
+    assert(upipe_ts_demux_mgr != NULL);
+    struct upipe_mgr *upipe_autof_mgr = upipe_autof_mgr_alloc();
+    assert(upipe_autof_mgr != NULL);
+    upipe_ts_demux_mgr_set_autof_mgr(upipe_ts_demux_mgr, upipe_autof_mgr);
+    upipe_mgr_release(upipe_autof_mgr);
+
+    struct bench_result best;
+    memset(&best, 0, sizeof(best));
+    for (unsigned int run = 0; run < opts->runs; run++) {
+        struct bench_result result;
+        memset(&result, 0, sizeof(result));
+        struct bench_ts ctx;
+        ctx.env = env;
+        ctx.result = &result;
+        ctx.nb_es = 0;
+        uprobe_init(&ctx.uprobe_es, bench_ts_catch_es,
+                    uprobe_use(env->uprobe));
+        bench_sink_init(&ctx.sink, uprobe_use(env->uprobe));
+
+        struct upipe *ts_demux = upipe_void_alloc(upipe_ts_demux_mgr,
+            uprobe_pfx_alloc(
+                uprobe_selflow_alloc(uprobe_use(env->uprobe),
+                    uprobe_selflow_alloc(
+                        uprobe_selflow_alloc(uprobe_use(env->uprobe),
+                            uprobe_use(&ctx.uprobe_es),
+                            UPROBE_SELFLOW_PIC, "auto"),
+                        uprobe_use(&ctx.uprobe_es),
+                        UPROBE_SELFLOW_SOUND, "auto"),
+                    UPROBE_SELFLOW_VOID, "auto"),
+                UPROBE_LOG_LEVEL, "ts demux"));
+        assert(ts_demux != NULL);
+        bench_add_stage(env, &result, ts_demux, "ts demux");
+        struct uref *flow_def = uref_block_flow_alloc_def(env->uref_mgr,
+                                                          "mpegts.");
+        assert(flow_def != NULL);
+        ubase_assert(upipe_set_flow_def(ts_demux, flow_def));
+        uref_free(flow_def);
+
+        uint64_t start = bench_now_ns();
+        for (unsigned int i = 0; i < loops; i++)
+            for (unsigned int j = 0; j < nb_chunks; j++) {
+                struct uref *uref = uref_dup(chunks[j]);
+                assert(uref != NULL);
+                size_t size;
+                ubase_assert(uref_block_size(uref, &size));
+                result.packets += size / TS_SIZE;
+                result.bytes += size;
+                upipe_input(ts_demux, uref, NULL);
+            }
+        result.duration = bench_now_ns() - start;
+
+        bench_collect_stages(&result);
+        upipe_release(ts_demux);
+        result.frames = ctx.sink.urefs;
+        upipe_clean(&ctx.sink.upipe);
+        uprobe_clean(&ctx.uprobe_es);
+
+        if (!run || result.duration < best.duration)
+            best = result;
+    }
+    bench_print_result("ts2es", &best);
+
+    upipe_mgr_release(upipe_ts_demux_mgr);
+    for (unsigned int i = 0; i < nb_chunks; i++)
+        uref_free(chunks[i]);
+    free(chunks);
+#undef MAX_TS_CHUNKS
+}
+#endif
+
+/** context of the udp_loopback case */
+struct bench_udp {
+    struct bench_env *env;
+    struct bench_sink sink;
+    struct upipe *udpsrc;
+    struct upipe *udpsink;
+    struct upump *send_pump;
+    struct upump *drain_pump;
+    /** datagram to send */
+    struct uref *datagram;
+    /** number of datagrams left to send */
+    uint64_t left;
+    /** number of datagrams sent */
+    uint64_t sent;
+};
+
+/** @internal @This stops the source once in-flight datagrams are drained. */
+static void bench_udp_drain(struct upump *upump)
+{
+    struct bench_udp *ctx = upump_get_opaque(upump, struct bench_udp *);
+    upump_stop(upump);
+    upipe_set_uri(ctx->udpsrc, NULL);
+}
+
+/** @internal @This sends datagrams, keeping a bounded number in flight so
+ * that the socket buffers don't overflow. */
+static void bench_udp_send(struct upump *upump)
+{
+    struct bench_udp *ctx = upump_get_opaque(upump, struct bench_udp *);
+    for (unsigned int i = 0; i < DATAGRAM_BURST && ctx->left; i++) {
+        if (ctx->sent - ctx->sink.urefs >= DATAGRAMS_IN_FLIGHT)
+            return;
+        struct uref *uref = uref_dup(ctx->datagram);
+        assert(uref != NULL);
+        upipe_input(ctx->udpsink, uref, NULL);
+        ctx->sent++;
+        ctx->left--;
+    }
+    if (!ctx->left) {
+        upump_stop(upump);
+        upump_start(ctx->drain_pump);
+    }
+}
+
+/** runs the udp_loopback case */
+static void bench_udp_loopback(struct bench_env *env,
+                               const struct bench_opts *opts)
+{
+    struct upipe_mgr *upipe_udpsrc_mgr = upipe_udpsrc_mgr_alloc();
+    assert(upipe_udpsrc_mgr != NULL);
+    struct upipe_mgr *upipe_udpsink_mgr = upipe_udpsink_mgr_alloc();
+    assert(upipe_udpsink_mgr != NULL);
+
+    struct bench_udp ctx;
+    ctx.env = env;
+    uint8_t payload[DATAGRAM_SIZE];
+    memset(payload, 0, sizeof(payload));
+    ctx.datagram = bench_block_alloc(env, payload, DATAGRAM_SIZE);
+
+    struct bench_result best;
+    memset(&best, 0, sizeof(best));
+    for (unsigned int run = 0; run < opts->runs; run++) {
+        struct bench_result result;
+        memset(&result, 0, sizeof(result));
+        bench_sink_init(&ctx.sink, uprobe_use(env->uprobe));
+
+        ctx.udpsrc = upipe_void_alloc(upipe_udpsrc_mgr,
+                uprobe_pfx_alloc(uprobe_use(env->uprobe), UPROBE_LOG_LEVEL,
+                                 "udp source"));
+        assert(ctx.udpsrc != NULL);
+        ubase_assert(upipe_set_output(ctx.udpsrc, &ctx.sink.upipe));
+        ubase_assert(upipe_set_output_size(ctx.udpsrc, DATAGRAM_SIZE));
+        char uri[64];
+        unsigned int port;
+        for (port = UDP_PORT_BASE; port < UDP_PORT_BASE + 100; port++) {
+            snprintf(uri, sizeof(uri), "@127.0.0.1:%u", port);
+            if (ubase_check(upipe_set_uri(ctx.udpsrc, uri)))
+                break;
+        }
+        assert(port < UDP_PORT_BASE + 100);
+
+        ctx.udpsink = upipe_void_alloc(upipe_udpsink_mgr,
+                uprobe_pfx_alloc(uprobe_use(env->uprobe), UPROBE_LOG_LEVEL,
+                                 "udp sink"));
+        assert(ctx.udpsink != NULL);
+        struct uref *flow_def = uref_block_flow_alloc_def(env->uref_mgr,
+                                                          "mpegts.");
+        assert(flow_def != NULL);
+        ubase_assert(upipe_set_flow_def(ctx.udpsink, flow_def));
+        uref_free(flow_def);
+        ubase_assert(upipe_set_uri(ctx.udpsink, uri + 1));
+        bench_add_stage(env, &result, ctx.udpsink, "udp sink");
+        bench_add_stage(env, &result, &ctx.sink.upipe, "sink");
+
+        ctx.left = NB_DATAGRAMS * opts->scale;
+        if (!ctx.left)
+            ctx.left = 1;
+        ctx.sent = 0;
+        ctx.send_pump = upump_alloc_idler(env->upump_mgr, bench_udp_send,
+                                          &ctx, NULL);
+        assert(ctx.send_pump != NULL);
+        ctx.drain_pump = upump_alloc_timer(env->upump_mgr, bench_udp_drain,
+                                           &ctx, NULL, UDP_DRAIN, 0);
+        assert(ctx.drain_pump != NULL);
+        upump_start(ctx.send_pump);
+
+        uint64_t start = bench_now_ns();
+        upump_mgr_run(env->upump_mgr, NULL);
+        result.duration = ctx.sink.last > start ? ctx.sink.last - start : 0;
+        result.packets = ctx.sink.urefs;
+        result.bytes = ctx.sink.bytes;
+        result.frames = ctx.sink.urefs;
+
+        bench_collect_stages(&result);
+        upump_free(ctx.send_pump);
+        upump_free(ctx.drain_pump);
+        upipe_release(ctx.udpsink);
+        upipe_release(ctx.udpsrc);
+        upipe_clean(&ctx.sink.upipe);
+
+        if (!run || result.duration < best.duration)
+            best = result;
+    }
+    bench_print_result("udp_loopback", &best);
+
+    uref_free(ctx.datagram);
+    upipe_mgr_release(upipe_udpsink_mgr);
+    upipe_mgr_release(upipe_udpsrc_mgr);
+}
+
+/** @internal @This is the default probe. */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    return UBASE_ERR_NONE;
+}
+
+int main(int argc, char **argv)
+{
+    struct bench_opts opts;
+    bench_init(&opts, argc, argv);
+
+    struct bench_env env;
+    env.umem_mgr = umem_pool_mgr_alloc_simple(UMEM_POOL);
+    assert(env.umem_mgr != NULL);
+    struct udict_mgr *udict_mgr =
+        udict_inline_mgr_alloc(UDICT_POOL_DEPTH, env.umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    env.uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
+    assert(env.uref_mgr != NULL);
+    udict_mgr_release(udict_mgr);
+    env.ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_SHARED_POOL_DEPTH, env.umem_mgr, 0, 0, 0, 0);
+    assert(env.ubuf_mgr != NULL);
+#ifdef BENCH_UPUMP_URING
+    env.upump_mgr = upump_uring_mgr_alloc(UPUMP_POOL, UPUMP_BLOCKER_POOL);
+#else
+    env.upump_mgr = upump_ev_mgr_alloc_default(UPUMP_POOL, UPUMP_BLOCKER_POOL);
+#endif
+    if (env.upump_mgr == NULL) {
+        fprintf(stderr, "unable to allocate the event loop\n");
+        return 77;
+    }
+    env.uclock = uclock_std_alloc(0);
+    assert(env.uclock != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    env.uprobe = uprobe_stdio_alloc(&uprobe, stderr, UPROBE_LOG_LEVEL);
+    assert(env.uprobe != NULL);
+    env.uprobe = uprobe_uref_mgr_alloc(env.uprobe, env.uref_mgr);
+    assert(env.uprobe != NULL);
+    env.uprobe = uprobe_upump_mgr_alloc(env.uprobe, env.upump_mgr);
+    assert(env.uprobe != NULL);
+    env.uprobe = uprobe_uclock_alloc(env.uprobe, env.uclock);
+    assert(env.uprobe != NULL);
+    env.uprobe = uprobe_ubuf_mem_alloc(env.uprobe, env.umem_mgr,
+                                       UBUF_POOL_DEPTH, UBUF_POOL_DEPTH);
+    assert(env.uprobe != NULL);
+
+#ifdef BENCH_TS
+    if (opts.filter == NULL || !strncmp("ts2es", opts.filter,
+                                        strlen(opts.filter)))
+        bench_ts2es(&env, &opts);
+#endif
+    if (opts.filter == NULL || !strncmp("udp_loopback", opts.filter,
+                                        strlen(opts.filter)))
+        bench_udp_loopback(&env, &opts);
+
+    uprobe_release(env.uprobe);
+    uprobe_clean(&uprobe);
+    uclock_release(env.uclock);
+    upump_mgr_release(env.upump_mgr);
+    ubuf_mgr_release(env.ubuf_mgr);
+    uref_mgr_release(env.uref_mgr);
+    umem_mgr_release(env.umem_mgr);
+    return 0;
+}
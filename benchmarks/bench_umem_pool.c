@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short microbenchmarks for umem pool contention
+ */
+
+#undef NDEBUG
+
+#include "bench.h"
+
+#include <upipe/ubase.h>
+#include <upipe/umem.h>
+#include <upipe/umem_pool.h>
+#include <upipe-pthread/umem_pool_tls.h>
+
+#include <pthread.h>
+#include <assert.h>
+
+#define UMEM_POOL           512
+#define MAGAZINE_SIZE       32
+#define MAX_THREADS         64
+#define NB_OPS              1000000
+#define BURST               8
+#define BUFFER_SIZE         1316
+
+/** benchmark context */
+struct bench_umem {
+    /** manager under test */
+    struct umem_mgr *mgr;
+    /** number of threads of the current run */
+    unsigned int threads;
+    /** number of operations per thread */
+    uint64_t ops;
+};
+
+static void *bench_umem_thread(void *opaque)
+{
+    struct bench_umem *ctx = opaque;
+    struct umem umems[BURST];
+    for (uint64_t i = 0; i < ctx->ops; i += BURST) {
+        for (int j = 0; j < BURST; j++)
+            assert(umem_alloc(ctx->mgr, &umems[j], BUFFER_SIZE));
+        for (int j = 0; j < BURST; j++)
+            umem_free(&umems[j]);
+    }
+    return NULL;
+}
+
+/** allocates and frees buffers from all threads at once */
+static void bench_umem_contention(void *opaque, uint64_t ops)
+{
+    struct bench_umem *ctx = opaque;
+    pthread_t ids[ctx->threads];
+    ctx->ops = ops / ctx->threads;
+    for (unsigned int i = 0; i < ctx->threads; i++)
+        assert(!pthread_create(&ids[i], NULL, bench_umem_thread, ctx));
+    for (unsigned int i = 0; i < ctx->threads; i++)
+        assert(!pthread_join(ids[i], NULL));
+}
+
+static void bench_umem_mgr(const struct bench_opts *opts, const char *name,
+                           struct umem_mgr *mgr)
+{
+    struct bench_umem ctx;
+    ctx.mgr = mgr;
+    for (ctx.threads = 1; ctx.threads <= MAX_THREADS; ctx.threads *= 2)
+        bench_run(opts, name, ctx.threads, NB_OPS,
+                  bench_umem_contention, &ctx);
+    umem_mgr_release(mgr);
+}
+
+int main(int argc, char **argv)
+{
+    struct bench_opts opts;
+    bench_init(&opts, argc, argv);
+
+    struct umem_mgr *mgr = umem_pool_mgr_alloc_simple(UMEM_POOL);
+    assert(mgr != NULL);
+    bench_umem_mgr(&opts, "umem_pool_contention", mgr);
+
+    mgr = umem_pool_mgr_alloc_tls_simple(UMEM_POOL, MAGAZINE_SIZE);
+    assert(mgr != NULL);
+    bench_umem_mgr(&opts, "umem_pool_tls_contention", mgr);
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short microbenchmarks for upump timers
+ *
+ * This file is built against upump-ev, or against upump-uring when
+ * BENCH_UPUMP_URING is defined.
+ */
+
+#undef NDEBUG
+
+#include "bench.h"
+
+#include <upipe/ubase.h>
+#include <upipe/uclock.h>
+#include <upipe/upump.h>
+#ifdef BENCH_UPUMP_URING
+#include <upump-uring/upump_uring.h>
+#define BENCH_UPUMP "upump_uring"
+#else
+#include <upump-ev/upump_ev.h>
+#define BENCH_UPUMP "upump_ev"
+#endif
+
+#include <assert.h>
+
+#define UPUMP_POOL          64
+#define UPUMP_BLOCKER_POOL  0
+#define NB_CHURN_OPS        1000000
+#define NB_FIRE_OPS         20000
+#define TIMEOUT             UCLOCK_FREQ
+
+/** benchmark context */
+struct bench_upump {
+    struct upump_mgr *upump_mgr;
+    /** number of timer events left in the current run */
+    uint64_t left;
+};
+
+static void bench_timer_cb(struct upump *upump)
+{
+    struct bench_upump *ctx = upump_get_opaque(upump, struct bench_upump *);
+    if (!--ctx->left)
+        upump_stop(upump);
+}
+
+/** allocates, starts, stops and frees a timer, as a pipe rearming a
+ * timeout would */
+static void bench_timer_alloc_free(void *opaque, uint64_t ops)
+{
+    struct bench_upump *ctx = opaque;
+    for (uint64_t i = 0; i < ops; i++) {
+        struct upump *upump = upump_alloc_timer(ctx->upump_mgr,
+                bench_timer_cb, ctx, NULL, TIMEOUT, 0);
+        assert(upump != NULL);
+        upump_start(upump);
+        upump_stop(upump);
+        upump_free(upump);
+    }
+}
+
+/** restarts an allocated timer */
+static void bench_timer_start_stop(void *opaque, uint64_t ops)
+{
+    struct bench_upump *ctx = opaque;
+    struct upump *upump = upump_alloc_timer(ctx->upump_mgr,
+            bench_timer_cb, ctx, NULL, TIMEOUT, 0);
+    assert(upump != NULL);
+    for (uint64_t i = 0; i < ops; i++) {
+        upump_start(upump);
+        upump_stop(upump);
+    }
+    upump_free(upump);
+}
+
+/** restarts an allocated coarse timer */
+static void bench_timer_coarse_start_stop(void *opaque, uint64_t ops)
+{
+    struct bench_upump *ctx = opaque;
+    struct upump *upump = upump_alloc_timer_coarse(ctx->upump_mgr,
+            bench_timer_cb, ctx, NULL, TIMEOUT, 0);
+    assert(upump != NULL);
+    for (uint64_t i = 0; i < ops; i++) {
+        upump_start(upump);
+        upump_stop(upump);
+    }
+    upump_free(upump);
+}
+
+/** dispatches an expiring timer from the event loop */
+static void bench_timer_fire(void *opaque, uint64_t ops)
+{
+    struct bench_upump *ctx = opaque;
+    struct upump *upump = upump_alloc_timer(ctx->upump_mgr,
+            bench_timer_cb, ctx, NULL, 1, 1);
+    assert(upump != NULL);
+    ctx->left = ops;
+    upump_start(upump);
+    upump_mgr_run(ctx->upump_mgr, NULL);
+    assert(!ctx->left);
+    upump_free(upump);
+}
+
+int main(int argc, char **argv)
+{
+    struct bench_opts opts;
+    bench_init(&opts, argc, argv);
+
+    struct bench_upump ctx;
+#ifdef BENCH_UPUMP_URING
+    ctx.upump_mgr = upump_uring_mgr_alloc(UPUMP_POOL, UPUMP_BLOCKER_POOL);
+#else
+    ctx.upump_mgr = upump_ev_mgr_alloc_default(UPUMP_POOL, UPUMP_BLOCKER_POOL);
+#endif
+    if (ctx.upump_mgr == NULL) {
+        fprintf(stderr, "unable to allocate the event loop\n");
+        return 77;
+    }
+
+    bench_run(&opts, BENCH_UPUMP "_timer_alloc_free", 1, NB_CHURN_OPS,
+              bench_timer_alloc_free, &ctx);
+    bench_run(&opts, BENCH_UPUMP "_timer_start_stop", 1, NB_CHURN_OPS,
+              bench_timer_start_stop, &ctx);
+    bench_run(&opts, BENCH_UPUMP "_timer_coarse_start_stop", 1, NB_CHURN_OPS,
+              bench_timer_coarse_start_stop, &ctx);
+    bench_run(&opts, BENCH_UPUMP "_timer_fire", 1, NB_FIRE_OPS,
+              bench_timer_fire, &ctx);
+
+    upump_mgr_release(ctx.upump_mgr);
+    return 0;
+}
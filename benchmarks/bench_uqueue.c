@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short microbenchmarks for uqueue across threads
+ */
+
+#undef NDEBUG
+
+#include "bench.h"
+
+#include <upipe/ubase.h>
+#include <upipe/uqueue.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <assert.h>
+
+#define UQUEUE_DEPTH        64
+#define NB_PING_PONG_OPS    200000
+#define NB_STREAM_OPS       1000000
+#define SPINS_BEFORE_YIELD  1024
+
+/** benchmark context */
+struct bench_uqueue {
+    /** queue from the main thread to the peer */
+    struct uqueue ping;
+    /** queue from the peer to the main thread */
+    struct uqueue pong;
+    /** number of operations of the current run */
+    uint64_t ops;
+    /** dummy element */
+    struct uchain elem;
+};
+
+/** @internal @This pops an element, busy-polling the queue */
+static void *bench_pop(struct uqueue *uqueue)
+{
+    unsigned int spins = 0;
+    void *elem;
+    while ((elem = uqueue_pop(uqueue, void *)) == NULL)
+        if (++spins % SPINS_BEFORE_YIELD == 0)
+            sched_yield();
+    return elem;
+}
+
+/** @internal @This pushes an element, busy-polling the queue */
+static void bench_push(struct uqueue *uqueue, void *elem)
+{
+    unsigned int spins = 0;
+    while (!uqueue_push(uqueue, elem))
+        if (++spins % SPINS_BEFORE_YIELD == 0)
+            sched_yield();
+}
+
+static void *bench_pong_thread(void *opaque)
+{
+    struct bench_uqueue *ctx = opaque;
+    for (uint64_t i = 0; i < ctx->ops; i++)
+        bench_push(&ctx->pong, bench_pop(&ctx->ping));
+    return NULL;
+}
+
+/** bounces a single element between two threads */
+static void bench_uqueue_ping_pong(void *opaque, uint64_t ops)
+{
+    struct bench_uqueue *ctx = opaque;
+    ctx->ops = ops;
+    pthread_t id;
+    assert(!pthread_create(&id, NULL, bench_pong_thread, ctx));
+    for (uint64_t i = 0; i < ops; i++) {
+        bench_push(&ctx->ping, &ctx->elem);
+        assert(bench_pop(&ctx->pong) == &ctx->elem);
+    }
+    assert(!pthread_join(id, NULL));
+}
+
+static void *bench_sink_thread(void *opaque)
+{
+    struct bench_uqueue *ctx = opaque;
+    for (uint64_t i = 0; i < ctx->ops; i++)
+        bench_pop(&ctx->ping);
+    return NULL;
+}
+
+/** streams elements from one thread to another */
+static void bench_uqueue_stream(void *opaque, uint64_t ops)
+{
+    struct bench_uqueue *ctx = opaque;
+    ctx->ops = ops;
+    pthread_t id;
+    assert(!pthread_create(&id, NULL, bench_sink_thread, ctx));
+    for (uint64_t i = 0; i < ops; i++)
+        bench_push(&ctx->ping, &ctx->elem);
+    assert(!pthread_join(id, NULL));
+}
+
+int main(int argc, char **argv)
+{
+    struct bench_opts opts;
+    bench_init(&opts, argc, argv);
+
+    uint8_t ping_buffer[uqueue_sizeof(UQUEUE_DEPTH)];
+    uint8_t pong_buffer[uqueue_sizeof(UQUEUE_DEPTH)];
+    struct bench_uqueue ctx;
+    assert(uqueue_init(&ctx.ping, UQUEUE_DEPTH, ping_buffer));
+    assert(uqueue_init(&ctx.pong, UQUEUE_DEPTH, pong_buffer));
+    uchain_init(&ctx.elem);
+
+    bench_run(&opts, "uqueue_ping_pong", 2, NB_PING_PONG_OPS,
+              bench_uqueue_ping_pong, &ctx);
+    bench_run(&opts, "uqueue_stream", 2, NB_STREAM_OPS,
+              bench_uqueue_stream, &ctx);
+
+    uqueue_clean(&ctx.ping);
+    uqueue_clean(&ctx.pong);
+    return 0;
+}
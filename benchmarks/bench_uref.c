@@ -0,0 +1,333 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short microbenchmarks for uref, udict and ubuf_block
+ */
+
+#undef NDEBUG
+
+#include "bench.h"
+
+#include <upipe/umem.h>
+#include <upipe/umem_pool.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_attr.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_std.h>
+
+#include <assert.h>
+
+#define UMEM_POOL           512
+#define UDICT_POOL_DEPTH    64
+#define UREF_POOL_DEPTH     64
+#define UBUF_POOL_DEPTH     64
+#define UBUF_SHARED_POOL_DEPTH 64
+#define NB_OPS              1000000
+#define NB_CHAIN_OPS        100000
+#define BLOCK_SIZE          1316
+#define CHAIN_LENGTH        7
+#define TS_SIZE             188
+
+UREF_ATTR_UNSIGNED(bench, index, "x.index", benchmark index)
+UREF_ATTR_STRING(bench, name, "x.name", benchmark name)
+UREF_ATTR_UNSIGNED(bench, attr0, "x.attr0", filler attribute)
+UREF_ATTR_UNSIGNED(bench, attr1, "x.attr1", filler attribute)
+UREF_ATTR_UNSIGNED(bench, attr2, "x.attr2", filler attribute)
+UREF_ATTR_UNSIGNED(bench, attr3, "x.attr3", filler attribute)
+
+/** benchmark context */
+struct bench_uref {
+    struct uref_mgr *uref_mgr;
+    struct ubuf_mgr *ubuf_mgr;
+    /** manager allocating small blocks from slab elements */
+    struct ubuf_mgr *slab_mgr;
+    /** uref carrying a typical set of attributes */
+    struct uref *uref;
+    /** block allocated with atomic, then thread-local reference counts */
+    struct ubuf *ubuf[2];
+};
+
+static void bench_ubuf_block_alloc_free(struct ubuf_mgr *mgr, uint64_t ops)
+{
+    for (uint64_t i = 0; i < ops; i++) {
+        struct ubuf *ubuf = ubuf_block_alloc(mgr, TS_SIZE);
+        assert(ubuf != NULL);
+        ubuf_free(ubuf);
+    }
+}
+
+static void bench_ubuf_block_alloc_ts(void *opaque, uint64_t ops)
+{
+    struct bench_uref *ctx = opaque;
+    bench_ubuf_block_alloc_free(ctx->ubuf_mgr, ops);
+}
+
+static void bench_ubuf_block_alloc_ts_slab(void *opaque, uint64_t ops)
+{
+    struct bench_uref *ctx = opaque;
+    bench_ubuf_block_alloc_free(ctx->slab_mgr, ops);
+}
+
+static void bench_ubuf_block_dup_free(struct ubuf *ubuf, uint64_t ops)
+{
+    for (uint64_t i = 0; i < ops; i++) {
+        struct ubuf *dup = ubuf_dup(ubuf);
+        assert(dup != NULL);
+        ubuf_free(dup);
+    }
+}
+
+static void bench_ubuf_block_dup_atomic(void *opaque, uint64_t ops)
+{
+    struct bench_uref *ctx = opaque;
+    bench_ubuf_block_dup_free(ctx->ubuf[0], ops);
+}
+
+static void bench_ubuf_block_dup_local(void *opaque, uint64_t ops)
+{
+    struct bench_uref *ctx = opaque;
+    bench_ubuf_block_dup_free(ctx->ubuf[1], ops);
+}
+
+/** cuts a datagram into TS packets, as a framer would */
+static void bench_ubuf_block_slice(struct ubuf *ubuf, uint64_t ops)
+{
+    for (uint64_t i = 0; i < ops; i++) {
+        for (int offset = 0; offset + TS_SIZE <= BLOCK_SIZE;
+             offset += TS_SIZE) {
+            struct ubuf *slice = ubuf_block_splice(ubuf, offset, TS_SIZE);
+            assert(slice != NULL);
+            ubuf_free(slice);
+        }
+    }
+}
+
+static void bench_ubuf_block_slice_atomic(void *opaque, uint64_t ops)
+{
+    struct bench_uref *ctx = opaque;
+    bench_ubuf_block_slice(ctx->ubuf[0], ops);
+}
+
+static void bench_ubuf_block_slice_local(void *opaque, uint64_t ops)
+{
+    struct bench_uref *ctx = opaque;
+    bench_ubuf_block_slice(ctx->ubuf[1], ops);
+}
+
+static void bench_uref_alloc_free(void *opaque, uint64_t ops)
+{
+    struct bench_uref *ctx = opaque;
+    for (uint64_t i = 0; i < ops; i++) {
+        struct uref *uref = uref_alloc(ctx->uref_mgr);
+        assert(uref != NULL);
+        uref_free(uref);
+    }
+}
+
+static void bench_uref_dup_free(void *opaque, uint64_t ops)
+{
+    struct bench_uref *ctx = opaque;
+    for (uint64_t i = 0; i < ops; i++) {
+        struct uref *uref = uref_dup(ctx->uref);
+        assert(uref != NULL);
+        uref_free(uref);
+    }
+}
+
+static void bench_udict_set_unsigned(void *opaque, uint64_t ops)
+{
+    struct bench_uref *ctx = opaque;
+    for (uint64_t i = 0; i < ops; i++)
+        ubase_assert(uref_bench_set_index(ctx->uref, i));
+}
+
+static void bench_udict_get_unsigned(void *opaque, uint64_t ops)
+{
+    struct bench_uref *ctx = opaque;
+    uint64_t index;
+    for (uint64_t i = 0; i < ops; i++)
+        ubase_assert(uref_bench_get_index(ctx->uref, &index));
+}
+
+static void bench_udict_set_string(void *opaque, uint64_t ops)
+{
+    static const char *names[] = { "first", "second" };
+    struct bench_uref *ctx = opaque;
+    for (uint64_t i = 0; i < ops; i++)
+        ubase_assert(uref_bench_set_name(ctx->uref, names[i & 1]));
+}
+
+static void bench_udict_get_string(void *opaque, uint64_t ops)
+{
+    struct bench_uref *ctx = opaque;
+    const char *name;
+    for (uint64_t i = 0; i < ops; i++)
+        ubase_assert(uref_bench_get_name(ctx->uref, &name));
+}
+
+static void bench_udict_get_shorthand(void *opaque, uint64_t ops)
+{
+    struct bench_uref *ctx = opaque;
+    const char *def;
+    for (uint64_t i = 0; i < ops; i++)
+        ubase_assert(uref_flow_get_def(ctx->uref, &def));
+}
+
+static void bench_udict_get_missing(void *opaque, uint64_t ops)
+{
+    struct bench_uref *ctx = opaque;
+    uint64_t value;
+    for (uint64_t i = 0; i < ops; i++)
+        ubase_nassert(uref_clock_get_latency(ctx->uref, &value));
+}
+
+/** appends packets to a block, then reads TS packets from a slice of it, as
+ * a demux would */
+static void bench_ubuf_block_chain(void *opaque, uint64_t ops)
+{
+    struct bench_uref *ctx = opaque;
+    for (uint64_t i = 0; i < ops; i++) {
+        struct uref *uref = uref_block_alloc(ctx->uref_mgr, ctx->ubuf_mgr,
+                                             BLOCK_SIZE);
+        assert(uref != NULL);
+        for (int j = 1; j < CHAIN_LENGTH; j++) {
+            struct ubuf *ubuf = ubuf_block_alloc(ctx->ubuf_mgr, BLOCK_SIZE);
+            assert(ubuf != NULL);
+            ubase_assert(uref_block_append(uref, ubuf));
+        }
+
+        struct uref *slice = uref_block_splice(uref, TS_SIZE,
+                (CHAIN_LENGTH - 1) * BLOCK_SIZE);
+        assert(slice != NULL);
+        uref_free(uref);
+
+        int offset = 0;
+        uint8_t sum = 0;
+        for (;;) {
+            const uint8_t *buffer;
+            int size = TS_SIZE;
+            if (!ubase_check(uref_block_read(slice, offset, &size, &buffer)))
+                break;
+            sum += buffer[0];
+            uref_block_unmap(slice, offset);
+            offset += size;
+        }
+        assert(offset == (CHAIN_LENGTH - 1) * BLOCK_SIZE);
+        (void)sum;
+        uref_free(slice);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    struct bench_opts opts;
+    bench_init(&opts, argc, argv);
+
+    struct umem_mgr *umem_mgr = umem_pool_mgr_alloc_simple(UMEM_POOL);
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                   udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_SHARED_POOL_DEPTH, umem_mgr, 0, 0, 0, 0);
+    assert(ubuf_mgr != NULL);
+    struct ubuf_mgr *local_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_SHARED_POOL_DEPTH, umem_mgr, 0, 0, 0, 0);
+    assert(local_mgr != NULL);
+    ubase_assert(ubuf_block_mem_mgr_set_local(local_mgr, true));
+    struct ubuf_mgr *slab_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_SHARED_POOL_DEPTH, umem_mgr, 0, 0, 0, 0);
+    assert(slab_mgr != NULL);
+    ubase_assert(ubuf_block_mem_mgr_set_slab(slab_mgr, 256, UBUF_POOL_DEPTH));
+
+    struct bench_uref ctx;
+    ctx.uref_mgr = uref_mgr;
+    ctx.ubuf_mgr = ubuf_mgr;
+    ctx.slab_mgr = slab_mgr;
+    ctx.uref = uref_alloc(uref_mgr);
+    assert(ctx.uref != NULL);
+    ubase_assert(uref_flow_set_def(ctx.uref, "block.mpegts."));
+    ubase_assert(uref_bench_set_attr0(ctx.uref, 0));
+    ubase_assert(uref_bench_set_attr1(ctx.uref, 1));
+    ubase_assert(uref_bench_set_attr2(ctx.uref, 2));
+    ubase_assert(uref_bench_set_attr3(ctx.uref, 3));
+    ubase_assert(uref_bench_set_name(ctx.uref, "first"));
+    ubase_assert(uref_bench_set_index(ctx.uref, 0));
+    uref_clock_set_pts_prog(ctx.uref, UINT32_MAX);
+    ctx.ubuf[0] = ubuf_block_alloc(ubuf_mgr, BLOCK_SIZE);
+    assert(ctx.ubuf[0] != NULL);
+    ctx.ubuf[1] = ubuf_block_alloc(local_mgr, BLOCK_SIZE);
+    assert(ctx.ubuf[1] != NULL);
+
+    bench_run(&opts, "uref_alloc_free", 1, NB_OPS,
+              bench_uref_alloc_free, &ctx);
+    bench_run(&opts, "uref_dup_free", 1, NB_OPS, bench_uref_dup_free, &ctx);
+    bench_run(&opts, "udict_set_unsigned", 1, NB_OPS,
+              bench_udict_set_unsigned, &ctx);
+    bench_run(&opts, "udict_get_unsigned", 1, NB_OPS,
+              bench_udict_get_unsigned, &ctx);
+    bench_run(&opts, "udict_set_string", 1, NB_OPS,
+              bench_udict_set_string, &ctx);
+    bench_run(&opts, "udict_get_string", 1, NB_OPS,
+              bench_udict_get_string, &ctx);
+    bench_run(&opts, "udict_get_shorthand", 1, NB_OPS,
+              bench_udict_get_shorthand, &ctx);
+    bench_run(&opts, "udict_get_missing", 1, NB_OPS,
+              bench_udict_get_missing, &ctx);
+    bench_run(&opts, "ubuf_block_chain", 1, NB_CHAIN_OPS,
+              bench_ubuf_block_chain, &ctx);
+    bench_run(&opts, "ubuf_block_alloc_ts", 1, NB_OPS,
+              bench_ubuf_block_alloc_ts, &ctx);
+    bench_run(&opts, "ubuf_block_alloc_ts_slab", 1, NB_OPS,
+              bench_ubuf_block_alloc_ts_slab, &ctx);
+    bench_run(&opts, "ubuf_block_dup_atomic", 1, NB_OPS,
+              bench_ubuf_block_dup_atomic, &ctx);
+    bench_run(&opts, "ubuf_block_dup_local", 1, NB_OPS,
+              bench_ubuf_block_dup_local, &ctx);
+    bench_run(&opts, "ubuf_block_slice_atomic", 1, NB_CHAIN_OPS,
+              bench_ubuf_block_slice_atomic, &ctx);
+    bench_run(&opts, "ubuf_block_slice_local", 1, NB_CHAIN_OPS,
+              bench_ubuf_block_slice_local, &ctx);
+
+    ubuf_free(ctx.ubuf[0]);
+    ubuf_free(ctx.ubuf[1]);
+    uref_free(ctx.uref);
+    ubuf_mgr_release(slab_mgr);
+    ubuf_mgr_release(local_mgr);
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    return 0;
+}
@@ -151,6 +151,7 @@ static uint64_t timestamp_highest = TS_CLOCK_MAX;
 static uint64_t seek = 0;
 static uint64_t sequence = 0;
 static uint64_t mux_max_delay = UINT64_MAX;
+static unsigned int prefetch = 0;
 static struct upipe *src = NULL;
 static struct upipe *hls = NULL;
 static struct upipe *variant = NULL;
@@ -651,6 +652,8 @@ static int catch_playlist(struct uprobe *uprobe,
     case UPROBE_HLS_PLAYLIST_RELOADED: {
         UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_PLAYLIST_SIGNATURE);
         uprobe_notice(uprobe, NULL, "playlist reloaded");
+        if (prefetch)
+            upipe_hls_playlist_set_prefetch(upipe, prefetch);
         uint64_t at = probe_playlist->at;
         if (at) {
             uint64_t remain = 0;
@@ -1228,6 +1231,7 @@ enum opt {
     OPT_DUMP,
     OPT_HELP,
     OPT_MUX_MAX_DELAY,
+    OPT_PREFETCH,
 };
 
 static struct option options[] = {
@@ -1254,6 +1258,7 @@ static struct option options[] = {
     { "dump", required_argument, NULL, OPT_DUMP },
     { "help", no_argument, NULL, OPT_HELP },
     { "mux-max-delay", required_argument, NULL, OPT_MUX_MAX_DELAY },
+    { "prefetch", required_argument, NULL, OPT_PREFETCH },
     { 0, 0, 0, 0 },
 };
 
@@ -1377,6 +1382,9 @@ int main(int argc, char **argv)
         case OPT_MUX_MAX_DELAY:
             mux_max_delay = strtoull(optarg, NULL, 10);
             break;
+        case OPT_PREFETCH:
+            prefetch = strtoul(optarg, NULL, 10);
+            break;
 
         case OPT_HELP:
             usage(argv[0], NULL);
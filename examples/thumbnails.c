@@ -0,0 +1,397 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe example extracting one thumbnail every few seconds
+ *
+ * Only the random access points closest to the wanted times are read and
+ * decoded: the source seeks from one thumbnail to the next, non-key packets
+ * are dropped before the decoder, and the decoder skips non-key frames.
+ * Pictures are then downscaled directly to the thumbnail size.
+ */
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_select_flows.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_upump_mgr.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/uclock.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_pic.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/upipe.h>
+#include <upipe/upump.h>
+#include <upump-ev/upump_ev.h>
+#include <upipe-modules/upipe_file_sink.h>
+#include <upipe-modules/upipe_probe_uref.h>
+#include <upipe-av/upipe_av.h>
+#include <upipe-av/upipe_avformat_source.h>
+#include <upipe-av/upipe_avcodec_decode.h>
+#include <upipe-av/upipe_avcodec_encode.h>
+#include <upipe-swscale/upipe_sws.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <limits.h>
+#include <assert.h>
+
+#include <libswscale/swscale.h>
+
+#define UDICT_POOL_DEPTH    50
+#define UREF_POOL_DEPTH     50
+#define UBUF_POOL_DEPTH     50
+#define UPUMP_POOL          10
+#define UPUMP_BLOCKER_POOL  10
+#define DEFAULT_INTERVAL    10
+#define DEFAULT_WIDTH       320
+
+#define UPROBE_LOG_LEVEL UPROBE_LOG_NOTICE
+
+static enum uprobe_log_level loglevel = UPROBE_LOG_LEVEL;
+
+static struct uprobe *logger;
+static struct uprobe uprobe_rap;
+static struct uprobe uprobe_avcdec;
+static struct uprobe uprobe_thumb;
+static struct upipe_mgr *upipe_avcdec_mgr;
+static struct upipe_mgr *upipe_avcenc_mgr;
+static struct upipe_mgr *upipe_sws_mgr;
+static struct upipe_mgr *upipe_fsink_mgr;
+static struct upipe_mgr *upipe_probe_uref_mgr;
+
+static const char *srcpath, *dstprefix;
+/** interval between thumbnails */
+static uint64_t interval = DEFAULT_INTERVAL * UCLOCK_FREQ;
+/** width of the thumbnails */
+static uint64_t thumb_hsize = DEFAULT_WIDTH;
+/** time of the next thumbnail */
+static uint64_t next_time = 0;
+/** time of the last thumbnail */
+static uint64_t last_time = UINT64_MAX;
+/** true if the source has just been asked to seek */
+static bool seeked = true;
+/** number of written thumbnails */
+static unsigned int thumb_nb = 0;
+
+static struct upipe *upipe_source;
+static struct upipe *thumb_sink;
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [-d] [-q] [-i <seconds>] [-w <width>] <source> <destination prefix>\n", argv0);
+    fprintf(stderr, "   -d: force debug log level\n");
+    fprintf(stderr, "   -q: quieter log\n");
+    fprintf(stderr, "   -i: interval between thumbnails (default %d)\n",
+            DEFAULT_INTERVAL);
+    fprintf(stderr, "   -w: width of the thumbnails (default %d)\n",
+            DEFAULT_WIDTH);
+    exit(EXIT_FAILURE);
+}
+
+/** returns the drop flag of a probe_uref event, or NULL */
+static bool *probe_uref_drop(int event, va_list args)
+{
+    if (event != UPROBE_PROBE_UREF)
+        return NULL;
+
+    va_list args_copy;
+    va_copy(args_copy, args);
+    unsigned int signature = va_arg(args_copy, unsigned int);
+    va_arg(args_copy, struct uref *);
+    va_arg(args_copy, struct upump **);
+    bool *drop = va_arg(args_copy, bool *);
+    va_end(args_copy);
+    return signature == UPIPE_PROBE_UREF_SIGNATURE ? drop : NULL;
+}
+
+/** catch coded packets before the decoder, and only keep the wanted random
+ * access points */
+static int rap_catch(struct uprobe *uprobe, struct upipe *upipe,
+                     int event, va_list args)
+{
+    bool *drop = probe_uref_drop(event, args);
+    if (drop == NULL)
+        return uprobe_throw_next(uprobe, upipe, event, args);
+
+    va_list args_copy;
+    va_copy(args_copy, args);
+    va_arg(args_copy, unsigned int);
+    struct uref *uref = va_arg(args_copy, struct uref *);
+    va_end(args_copy);
+
+    if (!ubase_check(uref_pic_get_key(uref))) {
+        *drop = true;
+        return UBASE_ERR_NONE;
+    }
+
+    /* the packet was just read, so this is its time */
+    uint64_t time = 0;
+    upipe_avfsrc_get_time(upipe_source, &time);
+    if ((last_time != UINT64_MAX && time <= last_time) ||
+        (!seeked && time < next_time)) {
+        *drop = true;
+        return UBASE_ERR_NONE;
+    }
+    upipe_dbg_va(upipe, "thumbnail at %"PRIu64" ms",
+                 time * 1000 / UCLOCK_FREQ);
+    last_time = time;
+    while (next_time <= time)
+        next_time += interval;
+
+    /* if the source cannot seek, keyframes are filtered while reading */
+    seeked = ubase_check(upipe_avfsrc_set_time(upipe_source, next_time));
+    return UBASE_ERR_NONE;
+}
+
+/** catch encoded thumbnails, and write each of them to a new file */
+static int thumb_catch(struct uprobe *uprobe, struct upipe *upipe,
+                       int event, va_list args)
+{
+    bool *drop = probe_uref_drop(event, args);
+    if (drop == NULL)
+        return uprobe_throw_next(uprobe, upipe, event, args);
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s%06u.jpg", dstprefix, thumb_nb++);
+    if (!ubase_check(upipe_fsink_set_path(thumb_sink, path,
+                                          UPIPE_FSINK_OVERWRITE)))
+        *drop = true;
+    return UBASE_ERR_NONE;
+}
+
+/** avcdec callback */
+static int avcdec_catch(struct uprobe *uprobe, struct upipe *upipe,
+                        int event, va_list args)
+{
+    if (event != UPROBE_NEED_OUTPUT)
+        return uprobe_throw_next(uprobe, upipe, event, args);
+
+    struct uref *flow_def = va_arg(args, struct uref *);
+
+    uint64_t hsize, vsize;
+    struct urational sar;
+    if (unlikely(!ubase_check(uref_pic_flow_get_hsize(flow_def, &hsize)) ||
+                 !ubase_check(uref_pic_flow_get_vsize(flow_def, &vsize)) ||
+                 !hsize || !vsize)) {
+        upipe_err_va(upipe, "incompatible flow def");
+        upipe_release(upipe_source);
+        upipe_source = NULL;
+        return UBASE_ERR_UNHANDLED;
+    }
+    if (!ubase_check(uref_pic_flow_get_sar(flow_def, &sar)) ||
+        !sar.num || !sar.den)
+        sar.num = sar.den = 1;
+    uint64_t thumb_vsize = (thumb_hsize * vsize * sar.den /
+                            (hsize * sar.num) / 2) * 2;
+    if (!thumb_vsize)
+        thumb_vsize = 2;
+
+    /* interlaced content is blended by the vertical downscaling */
+    struct uref *flow_def2 = uref_dup(flow_def);
+    uref_pic_set_progressive(flow_def2);
+    uref_pic_flow_set_hsize(flow_def2, thumb_hsize);
+    uref_pic_flow_set_vsize(flow_def2, thumb_vsize);
+    struct upipe *sws = upipe_flow_alloc_output(upipe, upipe_sws_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), loglevel, "sws"),
+            flow_def2);
+    assert(sws != NULL);
+    upipe_sws_set_flags(sws, SWS_FAST_BILINEAR);
+    upipe = sws;
+
+    uref_pic_flow_clear_format(flow_def2);
+    uref_flow_set_def(flow_def2, "block.mjpeg.pic.");
+    struct upipe *jpegenc = upipe_flow_alloc_output(upipe, upipe_avcenc_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), loglevel, "jpeg"),
+            flow_def2);
+    assert(jpegenc != NULL);
+    upipe_release(upipe);
+    upipe_set_option(jpegenc, "qmax", "4");
+    upipe = jpegenc;
+
+    struct upipe *urefprobe = upipe_void_alloc_output(upipe,
+            upipe_probe_uref_mgr,
+            uprobe_pfx_alloc(uprobe_use(&uprobe_thumb), loglevel, "thumb"));
+    assert(urefprobe != NULL);
+    upipe_release(upipe);
+    upipe = urefprobe;
+
+    struct upipe *fsink = upipe_void_alloc_output(upipe, upipe_fsink_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger),
+            ((loglevel > UPROBE_LOG_DEBUG) ? UPROBE_LOG_WARNING : loglevel),
+            "jpegsink"));
+    assert(fsink != NULL);
+    upipe_release(upipe);
+    upipe_release(thumb_sink);
+    thumb_sink = fsink;
+
+    uref_free(flow_def2);
+    return UBASE_ERR_NONE;
+}
+
+/** split callback */
+static int split_catch(struct uprobe *uprobe, struct upipe *upipe,
+                       int event, va_list args)
+{
+    if (event != UPROBE_NEED_OUTPUT)
+        return uprobe_throw_next(uprobe, upipe, event, args);
+
+    struct upipe *rap = upipe_void_alloc_output(upipe, upipe_probe_uref_mgr,
+            uprobe_pfx_alloc(uprobe_use(&uprobe_rap), loglevel, "rap"));
+    assert(rap != NULL);
+
+    struct upipe *avcdec = upipe_void_alloc_output(rap, upipe_avcdec_mgr,
+            uprobe_pfx_alloc(uprobe_use(&uprobe_avcdec), loglevel, "avcdec"));
+    upipe_release(rap);
+    if (avcdec == NULL) {
+        upipe_err_va(upipe, "incompatible flow def");
+        upipe_release(upipe_source);
+        upipe_source = NULL;
+        return UBASE_ERR_UNHANDLED;
+    }
+    /* some decoders output pictures from packets they were not given */
+    upipe_set_option(avcdec, "skip_frame", "nonkey");
+    upipe_release(avcdec);
+    return UBASE_ERR_NONE;
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+
+    /* parse options */
+    while ((opt = getopt(argc, argv, "dqi:w:")) != -1) {
+        switch (opt) {
+            case 'd':
+                if (loglevel > 0) loglevel--;
+                break;
+            case 'q':
+                if (loglevel < UPROBE_LOG_ERROR) loglevel++;
+                break;
+            case 'i':
+                interval = strtoull(optarg, NULL, 10) * UCLOCK_FREQ;
+                break;
+            case 'w':
+                thumb_hsize = (strtoull(optarg, NULL, 10) / 2) * 2;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (optind >= argc - 1 || !interval || !thumb_hsize) {
+        usage(argv[0]);
+    }
+    srcpath = argv[optind++];
+    dstprefix = argv[optind++];
+
+    /* setup environnement */
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                   udict_mgr, 0);
+    struct upump_mgr *upump_mgr = upump_ev_mgr_alloc_default(UPUMP_POOL,
+            UPUMP_BLOCKER_POOL);
+
+    /* default probe */
+    logger = uprobe_stdio_alloc(NULL, stderr, loglevel);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_upump_mgr_alloc(logger, upump_mgr);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+    uref_mgr_release(uref_mgr);
+    upump_mgr_release(upump_mgr);
+
+    /* other probes */
+    struct uprobe uprobe_catch;
+    uprobe_init(&uprobe_catch, split_catch, uprobe_use(logger));
+    uprobe_init(&uprobe_rap, rap_catch, uprobe_use(logger));
+    uprobe_init(&uprobe_avcdec, avcdec_catch, uprobe_use(logger));
+    uprobe_init(&uprobe_thumb, thumb_catch, uprobe_use(logger));
+
+    /* upipe-av */
+    upipe_av_init(false, uprobe_use(logger));
+
+    /* global pipe managers */
+    upipe_avcdec_mgr = upipe_avcdec_mgr_alloc();
+    upipe_avcenc_mgr = upipe_avcenc_mgr_alloc();
+    upipe_sws_mgr = upipe_sws_mgr_alloc();
+    upipe_fsink_mgr = upipe_fsink_mgr_alloc();
+    upipe_probe_uref_mgr = upipe_probe_uref_mgr_alloc();
+
+    /* avformat source, only the first picture flow is used */
+    struct upipe_mgr *upipe_avfsrc_mgr = upipe_avfsrc_mgr_alloc();
+    upipe_source = upipe_void_alloc(upipe_avfsrc_mgr,
+            uprobe_pfx_alloc(
+                uprobe_selflow_alloc(uprobe_use(logger),
+                    uprobe_selflow_alloc(uprobe_use(logger),
+                        uprobe_use(&uprobe_catch),
+                        UPROBE_SELFLOW_PIC, "auto"),
+                    UPROBE_SELFLOW_VOID, "auto"),
+                loglevel, "avfsrc"));
+    assert(upipe_source != NULL);
+    upipe_mgr_release(upipe_avfsrc_mgr);
+    if (!ubase_check(upipe_set_uri(upipe_source, srcpath)))
+        exit(EXIT_FAILURE);
+
+    /* fire loop ! */
+    upump_mgr_run(upump_mgr, NULL);
+
+    /* release everyhing */
+    upipe_release(upipe_source);
+    upipe_release(thumb_sink);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe_catch);
+    uprobe_clean(&uprobe_rap);
+    uprobe_clean(&uprobe_avcdec);
+    uprobe_clean(&uprobe_thumb);
+
+    upipe_mgr_release(upipe_avcdec_mgr);
+    upipe_mgr_release(upipe_avcenc_mgr);
+    upipe_mgr_release(upipe_sws_mgr);
+    upipe_mgr_release(upipe_fsink_mgr);
+    upipe_mgr_release(upipe_probe_uref_mgr);
+
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+
+    upipe_av_clean();
+
+    fprintf(stderr, "%u thumbnails written\n", thumb_nb);
+    return 0;
+}
@@ -47,6 +47,13 @@
  * The rotate interval is 10sec (10sec at 27MHz gives 27000000).
  * Please pay attention to the trailing slash in "foo/".
  * If no suffix is specified, udpmulticat will send data to a udp socket.
+ *
+ * To record many streams in one process:
+ *   ./udpmulticat -t 4 -D 1048576 -l streams.txt .ts
+ * where each line of streams.txt gives a udp source and a dest dir/prefix.
+ * The file sinks of each stream then run in one of 4 writer threads, and
+ * write 1 MiB aligned chunks with direct I/O. All streams share the same
+ * clock and rotate interval, so their files rotate at the same dates.
  */
 
 #undef NDEBUG
@@ -55,7 +62,6 @@
 #include <upipe/uprobe_stdio.h>
 #include <upipe/uprobe_prefix.h>
 #include <upipe/uprobe_uref_mgr.h>
-#include <upipe/uprobe_upump_mgr.h>
 #include <upipe/uprobe_uclock.h>
 #include <upipe/uprobe_ubuf_mem.h>
 #include <upipe/uclock.h>
@@ -78,6 +84,10 @@
 #include <upipe-modules/upipe_file_sink.h>
 #include <upipe-modules/upipe_multicat_sink.h>
 #include <upipe-modules/upipe_udp_sink.h>
+#include <upipe-modules/upipe_worker_sink.h>
+#include <upipe/uprobe_transfer.h>
+#include <upipe-pthread/uprobe_pthread_upump_mgr.h>
+#include <upipe-pthread/upipe_pthread_transfer.h>
 
 #include <stdbool.h>
 #include <stdlib.h>
@@ -85,6 +95,7 @@
 #include <unistd.h>
 #include <inttypes.h>
 #include <signal.h>
+#include <pthread.h>
 
 #define UDICT_POOL_DEPTH 10
 #define UREF_POOL_DEPTH 10
@@ -92,13 +103,36 @@
 #define UPUMP_POOL 10
 #define UPUMP_BLOCKER_POOL 10
 #define READ_SIZE 4096
+#define XFER_QUEUE 255
+#define XFER_POOL 20
+#define SINK_QUEUE_LENGTH 2000
+#define LINE_SIZE 1024
 #define UPROBE_LOG_LEVEL UPROBE_LOG_WARNING
 
+static enum uprobe_log_level loglevel = UPROBE_LOG_LEVEL;
+static uint64_t rotate = 0;
+static uint64_t rotate_offset = 0;
+static unsigned int direct = 0;
+static uint64_t prealloc = 0;
+static struct uprobe *logger = NULL;
+static struct upipe_mgr *upipe_udpsrc_mgr = NULL;
+static struct upipe_mgr *upipe_multicat_sink_mgr = NULL;
+static struct upipe_mgr *upipe_fsink_mgr = NULL;
+static struct upipe_mgr *upipe_dup_mgr = NULL;
+static struct upipe_mgr *upipe_genaux_mgr = NULL;
+/* manager deporting the sinks to the writer threads, or NULL */
+static struct upipe_mgr *wsink_mgr = NULL;
+
 static void usage(const char *argv0) {
-    fprintf(stdout, "Usage: %s [-d] [-r <rotate>] [-O <rotate offset>] <udp source> <dest dir/prefix> [<suffix>]\n", argv0);
+    fprintf(stdout, "Usage: %s [-d] [-r <rotate>] [-O <rotate offset>] [-t <threads>] [-D <chunk>] [-p <prealloc>] <udp source> <dest dir/prefix> [<suffix>]\n", argv0);
+    fprintf(stdout, "       %s [options] -l <stream list> <suffix>\n", argv0);
     fprintf(stdout, "   -d: force debug log level\n");
     fprintf(stdout, "   -r: rotate interval in 27MHz unit\n");
     fprintf(stdout, "   -O: rotate offset in 27MHz unit\n");
+    fprintf(stdout, "   -t: number of writer threads shared by all streams\n");
+    fprintf(stdout, "   -D: write aligned chunks of the given size with direct I/O\n");
+    fprintf(stdout, "   -p: number of octets to preallocate in each file\n");
+    fprintf(stdout, "   -l: file giving a <udp source> <dest dir/prefix> per line\n");
     fprintf(stdout, "If no <suffix> specified, udpmulticat sends data to a udp socket\n");
     exit(EXIT_FAILURE);
 }
@@ -117,17 +151,111 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** allocates a multicat sink, sharing the time base of all streams */
+static struct upipe *alloc_sink(struct upipe *upipe, struct uprobe *uprobe,
+                                const char *dirpath, const char *suffix,
+                                const char *name)
+{
+    struct upipe *sink = upipe_void_alloc_output(upipe,
+            upipe_multicat_sink_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe), loglevel, name));
+    assert(sink != NULL);
+    upipe_multicat_sink_set_fsink_mgr(sink, upipe_fsink_mgr);
+    if (rotate) {
+        upipe_multicat_sink_set_rotate(sink, rotate, rotate_offset);
+    }
+    if (direct) {
+        ubase_assert(upipe_fsink_set_direct(sink, direct));
+    }
+    if (prealloc) {
+        upipe_fsink_set_preallocate(sink, prealloc);
+    }
+    upipe_multicat_sink_set_path(sink, dirpath, suffix);
+    return sink;
+}
+
+/** sets up the recording of a stream */
+static bool record(const char *srcpath, const char *dirpath,
+                   const char *suffix)
+{
+    struct upipe *upipe_udpsrc = upipe_void_alloc(upipe_udpsrc_mgr,
+            uprobe_pfx_alloc_va(uprobe_use(logger),
+                                loglevel, "udp source %s", srcpath));
+    upipe_set_output_size(upipe_udpsrc, READ_SIZE);
+    upipe_attach_uclock(upipe_udpsrc);
+    if (!ubase_check(upipe_set_uri(upipe_udpsrc, srcpath))) {
+        upipe_release(upipe_udpsrc);
+        return false;
+    }
+
+    struct uprobe *uprobe_sink = uprobe_use(logger);
+    if (wsink_mgr != NULL) {
+        /* the sinks are attached to a writer thread afterwards */
+        uprobe_throw(logger, NULL, UPROBE_FREEZE_UPUMP_MGR);
+        uprobe_release(uprobe_sink);
+        uprobe_sink = uprobe_xfer_alloc(uprobe_use(logger));
+        assert(uprobe_sink != NULL);
+    }
+
+    /* dup */
+    struct upipe *upipe_dup = upipe_void_alloc(upipe_dup_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_sink), loglevel, "dup"));
+    assert(upipe_dup != NULL);
+
+    struct upipe *upipe_dup_data = upipe_void_alloc_sub(upipe_dup,
+                uprobe_pfx_alloc(uprobe_use(uprobe_sink),
+                                 loglevel, "dupdata"));
+    struct upipe *upipe_dup_aux = upipe_void_alloc_sub(upipe_dup,
+                uprobe_pfx_alloc(uprobe_use(uprobe_sink),
+                                 loglevel, "dupaux"));
+
+    /* data files (multicat sink) */
+    struct upipe *datasink = alloc_sink(upipe_dup_data, uprobe_sink,
+                                        dirpath, suffix, "datasink");
+    upipe_release(datasink);
+
+    /* aux block generation pipe */
+    struct upipe *genaux = upipe_void_alloc_output(upipe_dup_aux,
+            upipe_genaux_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_sink),
+                             loglevel, "genaux"));
+
+    /* aux files (multicat sink) */
+    struct upipe *auxsink = alloc_sink(genaux, uprobe_sink,
+                                       dirpath, ".aux", "auxsink");
+    upipe_release(genaux);
+    upipe_release(auxsink);
+    upipe_release(upipe_dup_data);
+    upipe_release(upipe_dup_aux);
+
+    if (wsink_mgr != NULL) {
+        uprobe_throw(logger, NULL, UPROBE_THAW_UPUMP_MGR);
+
+        /* deport to the least loaded writer thread */
+        upipe_dup = upipe_wsink_alloc(wsink_mgr,
+                uprobe_pfx_alloc(uprobe_use(logger), loglevel, "wsink"),
+                upipe_dup,
+                uprobe_pfx_alloc(uprobe_use(logger), loglevel, "wsink_x"),
+                SINK_QUEUE_LENGTH);
+        assert(upipe_dup != NULL);
+    }
+    uprobe_release(uprobe_sink);
+
+    upipe_set_output(upipe_udpsrc, upipe_dup);
+    upipe_release(upipe_dup);
+    return true;
+}
+
 int main(int argc, char *argv[])
 {
-    const char *srcpath, *dirpath, *suffix = NULL;
+    const char *srcpath = NULL, *dirpath = NULL, *suffix = NULL;
+    const char *list = NULL;
     bool udp = false;
-    uint64_t rotate = 0;
-    uint64_t rotate_offset = 0;
+    unsigned int nb_threads = 0;
     int opt;
-    enum uprobe_log_level loglevel = UPROBE_LOG_LEVEL;
 
     /* parse options */
-    while ((opt = getopt(argc, argv, "r:O:d")) != -1) {
+    while ((opt = getopt(argc, argv, "r:O:t:D:p:l:d")) != -1) {
         switch (opt) {
             case 'r':
                 rotate = strtoull(optarg, NULL, 0);
@@ -135,6 +263,20 @@ int main(int argc, char *argv[])
             case 'O':
                 rotate_offset = strtoull(optarg, NULL, 0);
                 break;
+            case 't':
+                nb_threads = strtoul(optarg, NULL, 0);
+                break;
+            case 'D':
+                direct = strtoul(optarg, NULL, 0);
+                if (direct % UPIPE_FSINK_DIRECT_ALIGN)
+                    usage(argv[0]);
+                break;
+            case 'p':
+                prealloc = strtoull(optarg, NULL, 0);
+                break;
+            case 'l':
+                list = optarg;
+                break;
             case 'd':
                 loglevel = UPROBE_LOG_DEBUG;
                 break;
@@ -142,11 +284,17 @@ int main(int argc, char *argv[])
                 usage(argv[0]);
         }
     }
-    if (argc - optind < 2) {
-        usage(argv[0]);
+    if (list != NULL) {
+        if (argc - optind < 1) {
+            usage(argv[0]);
+        }
+    } else {
+        if (argc - optind < 2) {
+            usage(argv[0]);
+        }
+        srcpath = argv[optind++];
+        dirpath = argv[optind++];
     }
-    srcpath = argv[optind++];
-    dirpath = argv[optind++];
     if (argc - optind >= 1) {
         suffix = argv[optind++];
     } else {
@@ -161,37 +309,55 @@ int main(int argc, char *argv[])
                                                    0);
     struct upump_mgr *upump_mgr = upump_ev_mgr_alloc_default(UPUMP_POOL,
             UPUMP_BLOCKER_POOL);
+    /* single time base for the rotations of all streams */
     struct uclock *uclock = uclock_std_alloc(UCLOCK_FLAG_REALTIME);
     struct uprobe uprobe;
     uprobe_init(&uprobe, catch, NULL);
-    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout, loglevel);
+    logger = uprobe_stdio_alloc(&uprobe, stdout, loglevel);
     assert(logger != NULL);
     logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
     assert(logger != NULL);
-    logger = uprobe_upump_mgr_alloc(logger, upump_mgr);
-    assert(logger != NULL);
     logger = uprobe_uclock_alloc(logger, uclock);
     assert(logger != NULL);
     logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
                                    UBUF_POOL_DEPTH);
     assert(logger != NULL);
+    logger = uprobe_pthread_upump_mgr_alloc(logger);
+    assert(logger != NULL);
+    uprobe_pthread_upump_mgr_set(logger, upump_mgr);
 
-    struct upipe_mgr *upipe_multicat_sink_mgr = upipe_multicat_sink_mgr_alloc();
-    struct upipe_mgr *upipe_fsink_mgr = upipe_fsink_mgr_alloc();
-
+    upipe_multicat_sink_mgr = upipe_multicat_sink_mgr_alloc();
+    upipe_fsink_mgr = upipe_fsink_mgr_alloc();
+    upipe_udpsrc_mgr = upipe_udpsrc_mgr_alloc();
+    upipe_dup_mgr = upipe_dup_mgr_alloc();
+    upipe_genaux_mgr = upipe_genaux_mgr_alloc();
 
-    /* udp source */
-    struct upipe_mgr *upipe_udpsrc_mgr = upipe_udpsrc_mgr_alloc();
-    struct upipe *upipe_udpsrc = upipe_void_alloc(upipe_udpsrc_mgr,
-            uprobe_pfx_alloc(uprobe_use(logger),
-                             loglevel, "udp source"));
-    upipe_set_output_size(upipe_udpsrc, READ_SIZE);
-    upipe_attach_uclock(upipe_udpsrc);
-    if (!ubase_check(upipe_set_uri(upipe_udpsrc, srcpath))) {
-        return EXIT_FAILURE;
+    struct upipe_mgr *xfer_mgr = NULL;
+    if (nb_threads && !udp) {
+        /* pool of writer threads shared by all streams */
+        xfer_mgr = upipe_pthread_xfer_pool_alloc(nb_threads, XFER_QUEUE,
+                XFER_POOL, uprobe_use(logger), upump_ev_mgr_alloc_loop,
+                UPUMP_POOL, UPUMP_BLOCKER_POOL, NULL, false);
+        assert(xfer_mgr != NULL);
+        wsink_mgr = upipe_wsink_mgr_alloc(xfer_mgr);
+        assert(wsink_mgr != NULL);
     }
 
     if (udp) {
+        if (list != NULL) {
+            usage(argv[0]);
+        }
+
+        /* udp source */
+        struct upipe *upipe_udpsrc = upipe_void_alloc(upipe_udpsrc_mgr,
+                uprobe_pfx_alloc(uprobe_use(logger),
+                                 loglevel, "udp source"));
+        upipe_set_output_size(upipe_udpsrc, READ_SIZE);
+        upipe_attach_uclock(upipe_udpsrc);
+        if (!ubase_check(upipe_set_uri(upipe_udpsrc, srcpath))) {
+            return EXIT_FAILURE;
+        }
+
         /* send to udp */
         struct upipe_mgr *upipe_udpsink_mgr = upipe_udpsink_mgr_alloc();
         struct upipe *upipe_sink = upipe_void_alloc_output(upipe_udpsrc,
@@ -203,53 +369,35 @@ int main(int argc, char *argv[])
         }
         upipe_release(upipe_sink);
     }
-    else
+    else if (list != NULL)
     {
-        /* dup */
-        struct upipe_mgr *upipe_dup_mgr = upipe_dup_mgr_alloc();
-        struct upipe *upipe_dup = upipe_void_alloc_output(upipe_udpsrc,
-                upipe_dup_mgr,
-                uprobe_pfx_alloc(uprobe_use(logger), loglevel, "dup"));
-
-        struct upipe *upipe_dup_data = upipe_void_alloc_sub(upipe_dup,
-                    uprobe_pfx_alloc(uprobe_use(logger),
-                                     loglevel, "dupdata"));
-        struct upipe *upipe_dup_aux = upipe_void_alloc_sub(upipe_dup,
-                    uprobe_pfx_alloc(uprobe_use(logger),
-                                     loglevel, "dupaux"));
-
-        /* data files (multicat sink) */
-        struct upipe *datasink = upipe_void_alloc_output(upipe_dup_data,
-                upipe_multicat_sink_mgr,
-                uprobe_pfx_alloc(uprobe_use(logger),
-                                 loglevel, "datasink"));
-        upipe_multicat_sink_set_fsink_mgr(datasink, upipe_fsink_mgr);
-        if (rotate) {
-            upipe_multicat_sink_set_rotate(datasink, rotate, rotate_offset);
+        FILE *file = fopen(list, "r");
+        if (file == NULL) {
+            fprintf(stderr, "unable to open %s\n", list);
+            return EXIT_FAILURE;
         }
-        upipe_multicat_sink_set_path(datasink, dirpath, suffix);
-        upipe_release(datasink);
-
-        /* aux block generation pipe */
-        struct upipe_mgr *upipe_genaux_mgr = upipe_genaux_mgr_alloc();
-        struct upipe *genaux = upipe_void_alloc_output(upipe_dup_aux,
-                upipe_genaux_mgr,
-                uprobe_pfx_alloc(uprobe_use(logger),
-                                 loglevel, "genaux"));
-
-        /* aux files (multicat sink) */
-        struct upipe *auxsink = upipe_void_alloc_output(genaux,
-                upipe_multicat_sink_mgr,
-                uprobe_pfx_alloc(uprobe_use(logger),
-                                 loglevel, "auxsink"));
-        upipe_multicat_sink_set_fsink_mgr(auxsink, upipe_fsink_mgr);
-        if (rotate) {
-            upipe_multicat_sink_set_rotate(auxsink, rotate, rotate_offset);
+        char line[LINE_SIZE], src[LINE_SIZE], dst[LINE_SIZE];
+        unsigned int nb_streams = 0;
+        while (fgets(line, sizeof(line), file) != NULL) {
+            if (line[0] == '#' ||
+                sscanf(line, "%1023s %1023s", src, dst) != 2)
+                continue;
+            if (!record(src, dst, suffix)) {
+                fprintf(stderr, "unable to record %s\n", src);
+                return EXIT_FAILURE;
+            }
+            nb_streams++;
+        }
+        fclose(file);
+        if (!nb_streams) {
+            usage(argv[0]);
+        }
+    }
+    else
+    {
+        if (!record(srcpath, dirpath, suffix)) {
+            return EXIT_FAILURE;
         }
-        upipe_multicat_sink_set_path(auxsink, dirpath, ".aux");
-        upipe_release(genaux);
-        upipe_release(auxsink);
-        upipe_release(upipe_dup);
     }
 
     /* fire loop ! */
@@ -257,6 +405,13 @@ int main(int argc, char *argv[])
 
     /* should never be here for the moment. todo: sighandler.
      * release everything */
+    upipe_mgr_release(wsink_mgr);
+    upipe_mgr_release(xfer_mgr);
+    upipe_mgr_release(upipe_genaux_mgr);
+    upipe_mgr_release(upipe_dup_mgr);
+    upipe_mgr_release(upipe_udpsrc_mgr);
+    upipe_mgr_release(upipe_fsink_mgr);
+    upipe_mgr_release(upipe_multicat_sink_mgr);
     uprobe_release(logger);
     uprobe_clean(&uprobe);
 
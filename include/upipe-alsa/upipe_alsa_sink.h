@@ -38,6 +38,45 @@ extern "C" {
 
 #define UPIPE_ALSINK_SIGNATURE UBASE_FOURCC('a', 'l', 's', 's')
 
+/** @This extends upipe_command with specific commands for alsa sinks. */
+enum upipe_alsink_command {
+    UPIPE_ALSINK_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the period duration (uint64_t *) */
+    UPIPE_ALSINK_GET_PERIOD_DURATION,
+    /** sets the period duration (uint64_t) */
+    UPIPE_ALSINK_SET_PERIOD_DURATION,
+};
+
+/** @This returns the duration of an ALSA period. It is the effective
+ * duration once the device is opened, and the requested one before.
+ *
+ * @param upipe description structure of the pipe
+ * @param duration_p filled in with the duration in units of @ref UCLOCK_FREQ
+ * @return an error code
+ */
+static inline int upipe_alsink_get_period_duration(struct upipe *upipe,
+                                                   uint64_t *duration_p)
+{
+    return upipe_control(upipe, UPIPE_ALSINK_GET_PERIOD_DURATION,
+                         UPIPE_ALSINK_SIGNATURE, duration_p);
+}
+
+/** @This sets the duration of an ALSA period. The sink buffers three
+ * periods, so it also sets the sink latency. It must be called before
+ * the device is opened.
+ *
+ * @param upipe description structure of the pipe
+ * @param duration duration in units of @ref UCLOCK_FREQ
+ * @return an error code
+ */
+static inline int upipe_alsink_set_period_duration(struct upipe *upipe,
+                                                   uint64_t duration)
+{
+    return upipe_control(upipe, UPIPE_ALSINK_SET_PERIOD_DURATION,
+                         UPIPE_ALSINK_SIGNATURE, duration);
+}
+
 /** @This returns the management structure for all alsa sinks.
  *
  * @return pointer to manager
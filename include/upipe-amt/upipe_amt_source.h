@@ -38,6 +38,45 @@ extern "C" {
 
 #define UPIPE_AMTSRC_SIGNATURE UBASE_FOURCC('a','m','t','c')
 
+/** @This extends upipe_command with specific commands for amtsrc. */
+enum upipe_amtsrc_command {
+    UPIPE_AMTSRC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** get the maximum number of datagrams read per wakeup
+     * (unsigned int *) **/
+    UPIPE_AMTSRC_GET_BATCH_SIZE,
+    /** set the maximum number of datagrams read per wakeup (unsigned int) **/
+    UPIPE_AMTSRC_SET_BATCH_SIZE,
+};
+
+/** @This returns the maximum number of datagrams read per wakeup.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_size_p filled in with the maximum number of datagrams
+ * @return an error code
+ */
+static inline int upipe_amtsrc_get_batch_size(struct upipe *upipe,
+                                              unsigned int *batch_size_p)
+{
+    return upipe_control(upipe, UPIPE_AMTSRC_GET_BATCH_SIZE,
+                         UPIPE_AMTSRC_SIGNATURE, batch_size_p);
+}
+
+/** @This sets the maximum number of datagrams read per wakeup. The first
+ * datagram is waited for, and the ones already queued by libamt are then
+ * read without waiting, up to this number.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_size maximum number of datagrams (1 disables batching)
+ * @return an error code
+ */
+static inline int upipe_amtsrc_set_batch_size(struct upipe *upipe,
+                                              unsigned int batch_size)
+{
+    return upipe_control(upipe, UPIPE_AMTSRC_SET_BATCH_SIZE,
+                         UPIPE_AMTSRC_SIGNATURE, batch_size);
+}
+
 /** @This returns the management structure for all amtsrc pipes.
  *
  * @param amt_relay IP of the AMT relay
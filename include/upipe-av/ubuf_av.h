@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe ubuf manager for picture formats with libav frame storage
+ *
+ * The ubufs wrap a reference to an AVFrame. When the frame is located in
+ * device memory (hardware decoding), it is only downloaded to system memory
+ * when a plane is mapped or its stride is requested, so that pipes able to
+ * handle the device frame directly avoid the round trip.
+ */
+
+#ifndef _UPIPE_AV_UBUF_AV_H_
+/** @hidden */
+#define _UPIPE_AV_UBUF_AV_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_pic.h>
+#include <upipe/uref.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <libavutil/frame.h>
+
+/** @This is a simple signature to make sure the ubuf_alloc internal API
+ * is used properly. */
+#define UBUF_AV_ALLOC_PICTURE UBASE_FOURCC('a','v','f','p')
+
+/** @This extends ubuf_command with specific commands for libav picture
+ * allocator. */
+enum ubuf_pic_av_command {
+    UBUF_PIC_AV_SENTINEL = UBUF_CONTROL_LOCAL,
+
+    /** returns the wrapped frame (AVFrame **) */
+    UBUF_PIC_AV_GET_FRAME
+};
+
+/** @This returns a new ubuf from a libav picture allocator. A new reference
+ * to the frame is taken.
+ *
+ * @param mgr management structure for this ubuf type
+ * @param frame frame to wrap, in system or device memory
+ * @return pointer to ubuf or NULL in case of failure
+ */
+static inline struct ubuf *ubuf_pic_av_alloc(struct ubuf_mgr *mgr,
+                                             AVFrame *frame)
+{
+    return ubuf_alloc(mgr, UBUF_AV_ALLOC_PICTURE, frame);
+}
+
+/** @This returns the wrapped frame, which may be located in device memory.
+ * The reference counter is not incremented.
+ *
+ * @param ubuf pointer to ubuf
+ * @param frame_p filled in with a pointer to the frame
+ * @return an error code
+ */
+static inline int ubuf_pic_av_get_frame(struct ubuf *ubuf, AVFrame **frame_p)
+{
+    return ubuf_control(ubuf, UBUF_PIC_AV_GET_FRAME, UBUF_AV_ALLOC_PICTURE,
+                        frame_p);
+}
+
+/** @This allocates a new instance of the ubuf manager for picture formats
+ * using libav frames.
+ *
+ * @param ubuf_pool_depth maximum number of ubuf structures in the pool
+ * @param sw_format pixel format of the frames in system memory, that is
+ * the format frames in device memory are downloaded to
+ * @param flow_def flow definition describing the planes of sw_format
+ * @return pointer to manager, or NULL in case of error
+ */
+struct ubuf_mgr *ubuf_pic_av_mgr_alloc(uint16_t ubuf_pool_depth,
+                                       enum AVPixelFormat sw_format,
+                                       struct uref *flow_def);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -72,6 +72,11 @@ static inline int upipe_av_pixfmt_to_flow_def(enum AVPixelFormat pix_fmt,
             UBASE_RETURN(uref_pic_flow_add_plane(flow_def, 2, 2, 1, "u8"))
             UBASE_RETURN(uref_pic_flow_add_plane(flow_def, 2, 2, 1, "v8"))
             break;
+        case AV_PIX_FMT_NV12:
+            UBASE_RETURN(uref_pic_flow_set_macropixel(flow_def, 1))
+            UBASE_RETURN(uref_pic_flow_add_plane(flow_def, 1, 1, 1, "y8"))
+            UBASE_RETURN(uref_pic_flow_add_plane(flow_def, 2, 2, 2, "u8v8"))
+            break;
         case AV_PIX_FMT_YUVA422P:
             UBASE_RETURN(uref_pic_flow_set_macropixel(flow_def, 1))
             UBASE_RETURN(uref_pic_flow_add_plane(flow_def, 1, 1, 1, "y8"))
@@ -235,6 +240,7 @@ static inline enum AVPixelFormat
         AV_PIX_FMT_YUVA420P,
         AV_PIX_FMT_YUV420P,
         AV_PIX_FMT_YUVJ420P,
+        AV_PIX_FMT_NV12,
         AV_PIX_FMT_YUVA422P,
         AV_PIX_FMT_YUV422P,
         AV_PIX_FMT_YUVJ422P,
@@ -304,6 +310,16 @@ static inline enum AVPixelFormat
                     return *pix_fmts;
                 }
                 break;
+            case AV_PIX_FMT_NV12:
+                if (macropixel == 1 &&
+                    u(uref_pic_flow_check_chroma(flow_def, 1, 1, 1, "y8")) &&
+                    u(uref_pic_flow_check_chroma(flow_def, 2, 2, 2, "u8v8"))) {
+                    chroma_p[0] = "y8";
+                    chroma_p[1] = "u8v8";
+                    chroma_p[2] = NULL;
+                    return *pix_fmts;
+                }
+                break;
             case AV_PIX_FMT_YUVA422P:
                 if (macropixel == 1 &&
                     u(uref_pic_flow_check_chroma(flow_def, 1, 1, 1, "y8")) &&
@@ -39,6 +39,85 @@ extern "C" {
 
 #define UPIPE_AVCDEC_SIGNATURE UBASE_FOURCC('a', 'v', 'c', 'd')
 
+/** @This lists the threading modes of avcodec decode pipes, which may be
+ * or'ed together. */
+enum upipe_avcdec_thread_type {
+    /** no threading */
+    UPIPE_AVCDEC_THREAD_NONE = 0,
+    /** decode several frames in parallel (adds one frame of delay per
+     * additional thread) */
+    UPIPE_AVCDEC_THREAD_FRAME = 0x1,
+    /** decode several slices of a frame in parallel */
+    UPIPE_AVCDEC_THREAD_SLICE = 0x2
+};
+
+/** @This extends upipe_command with specific commands for avcodec decode. */
+enum upipe_avcdec_command {
+    UPIPE_AVCDEC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the threading mode and number of threads (int *,
+     * unsigned int *) */
+    UPIPE_AVCDEC_GET_THREADS,
+    /** sets the threading mode and number of threads (int, unsigned int) */
+    UPIPE_AVCDEC_SET_THREADS,
+    /** sets the hardware device used to decode (const char *,
+     * const char *) */
+    UPIPE_AVCDEC_SET_HW_CONFIG
+};
+
+/** @This returns the threading configuration. Once the codec is opened, it
+ * returns the mode and number of threads actually in use.
+ *
+ * @param upipe description structure of the pipe
+ * @param type_p filled in with a combination of
+ * @ref upipe_avcdec_thread_type
+ * @param count_p filled in with the number of threads (0 for automatic)
+ * @return an error code
+ */
+static inline int upipe_avcdec_get_threads(struct upipe *upipe, int *type_p,
+                                           unsigned int *count_p)
+{
+    return upipe_control(upipe, UPIPE_AVCDEC_GET_THREADS,
+                         UPIPE_AVCDEC_SIGNATURE, type_p, count_p);
+}
+
+/** @This sets the threading configuration. It only takes effect before the
+ * codec is opened, that is before the first packet is received.
+ *
+ * @param upipe description structure of the pipe
+ * @param type combination of @ref upipe_avcdec_thread_type
+ * @param count number of threads, or 0 for automatic
+ * @return an error code
+ */
+static inline int upipe_avcdec_set_threads(struct upipe *upipe, int type,
+                                           unsigned int count)
+{
+    return upipe_control(upipe, UPIPE_AVCDEC_SET_THREADS,
+                         UPIPE_AVCDEC_SIGNATURE, type, count);
+}
+
+/** @This sets the hardware device used to decode. Decoded pictures then stay
+ * in device memory, wrapped by the ubuf manager of @ref ubuf_pic_av_alloc,
+ * and are only downloaded when a downstream pipe maps them. If the codec
+ * doesn't support the device, software decoding is used. It only takes
+ * effect before the codec is opened, that is before the first packet is
+ * received.
+ *
+ * @param upipe description structure of the pipe
+ * @param type libav hardware device type (for instance "vaapi", "cuda" or
+ * "qsv"), or NULL to decode in software
+ * @param device device to open (for instance "/dev/dri/renderD128"), or NULL
+ * for the default device
+ * @return an error code
+ */
+static inline int upipe_avcdec_set_hw_config(struct upipe *upipe,
+                                             const char *type,
+                                             const char *device)
+{
+    return upipe_control(upipe, UPIPE_AVCDEC_SET_HW_CONFIG,
+                         UPIPE_AVCDEC_SIGNATURE, type, device);
+}
+
 /** @This returns the management structure for all avcodec decode pipes.
  *
  * @return pointer to manager
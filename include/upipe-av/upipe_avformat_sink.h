@@ -25,6 +25,13 @@
 
 /** @file
  * @short Upipe sink module libavformat wrapper
+ *
+ * If an output is set (for instance a file sink) before the first packet
+ * is muxed, the muxed stream is written to it in large blocks through a
+ * custom I/O context, instead of opening the URI with the libavformat
+ * protocols; the URI is then only used to guess the format. As the output
+ * can't seek, formats such as MP4 must be written fragmented (option
+ * movflags=frag_keyframe+empty_moov).
  */
 
 #ifndef _UPIPE_AV_UPIPE_AVFORMAT_SINK_H_
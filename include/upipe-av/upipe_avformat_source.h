@@ -25,6 +25,12 @@
 
 /** @file
  * @short Upipe source module libavformat wrapper
+ *
+ * When the manager of inner source pipes is set (for instance to an auto
+ * source manager handling file and http URLs), URLs are read by an inner
+ * source pipe through a custom I/O context instead of the libavformat
+ * protocols, and libavformat probes them in a separate thread, so that a
+ * slow URL doesn't stall the other pipes of the event loop.
  */
 
 #ifndef _UPIPE_AV_UPIPE_AVFORMAT_SOURCE_H_
@@ -38,6 +44,7 @@ extern "C" {
 
 #define UPIPE_AVFSRC_SIGNATURE UBASE_FOURCC('a','v','f','r')
 #define UPIPE_AVFSRC_OUTPUT_SIGNATURE UBASE_FOURCC('a','v','f','o')
+#define UPIPE_AVFSRC_IO_SIGNATURE UBASE_FOURCC('a','v','f','i')
 
 /** @This extends upipe_command with specific commands for avformat source. */
 enum upipe_avfsrc_command {
@@ -47,7 +54,11 @@ enum upipe_avfsrc_command {
      * (uint64_t *) */
     UPIPE_AVFSRC_GET_TIME,
     /** asks to read at the given time (uint64_t) */
-    UPIPE_AVFSRC_SET_TIME
+    UPIPE_AVFSRC_SET_TIME,
+    /** returns the fast start mode (bool *) */
+    UPIPE_AVFSRC_GET_FAST_START,
+    /** sets the fast start mode (int) */
+    UPIPE_AVFSRC_SET_FAST_START
 };
 
 /** @deprecated @This returns the content of an avformat option.
@@ -103,6 +114,36 @@ static inline int upipe_avfsrc_set_time(struct upipe *upipe, uint64_t time)
                          time);
 }
 
+/** @This returns the fast start mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param fast_start_p filled in with true in fast start mode
+ * @return an error code
+ */
+static inline int upipe_avfsrc_get_fast_start(struct upipe *upipe,
+                                              bool *fast_start_p)
+{
+    return upipe_control(upipe, UPIPE_AVFSRC_GET_FAST_START,
+                         UPIPE_AVFSRC_SIGNATURE, fast_start_p);
+}
+
+/** @This sets the fast start mode. In fast start mode, flows are declared
+ * from the container metadata (or a very short analysis of the media if the
+ * container has no header), so that outputs can start immediately; their
+ * flow definitions are then updated while the first packets are read.
+ * It only takes effect after the next call to @ref upipe_set_uri.
+ *
+ * @param upipe description structure of the pipe
+ * @param fast_start true to enable fast start mode
+ * @return an error code
+ */
+static inline int upipe_avfsrc_set_fast_start(struct upipe *upipe,
+                                              bool fast_start)
+{
+    return upipe_control(upipe, UPIPE_AVFSRC_SET_FAST_START,
+                         UPIPE_AVFSRC_SIGNATURE, fast_start ? 1 : 0);
+}
+
 /** @This returns the management structure for all avformat sources.
  *
  * @return pointer to manager
@@ -122,6 +163,7 @@ enum upipe_avfsrc_mgr_command {
     UPIPE_AVFSRC_MGR_SET_##NAME##_MGR,
 
     UPIPE_AVFSRC_MGR_GET_SET_MGR(autof, AUTOF)
+    UPIPE_AVFSRC_MGR_GET_SET_MGR(src, SRC)
 #undef UPIPE_AVFSRC_MGR_GET_SET_MGR
 };
 
@@ -156,6 +198,7 @@ static inline int                                                           \
 }
 
 UPIPE_AVFSRC_MGR_GET_SET_MGR2(autof, AUTOF)
+UPIPE_AVFSRC_MGR_GET_SET_MGR2(src, SRC)
 #undef UPIPE_AVFSRC_MGR_GET_SET_MGR2
 
 #ifdef __cplusplus
@@ -58,6 +58,10 @@ enum upipe_bmd_sink_command {
     UPIPE_BMD_SINK_GET_GENLOCK_OFFSET,
     /** sets the genlock offset (int) **/
     UPIPE_BMD_SINK_SET_GENLOCK_OFFSET,
+
+    /** returns the late, dropped and repeated frame counters
+     * (unsigned int *, unsigned int *, unsigned int *) */
+    UPIPE_BMD_SINK_GET_FRAME_STATS,
 };
 
 /** @This returns the management structure for all bmd sinks.
@@ -146,6 +150,26 @@ static inline int upipe_bmd_sink_set_genlock_offset(struct upipe *upipe,
                           UPIPE_BMD_SINK_SIGNATURE, offset);
 }
 
+/** @This returns the number of frames the card displayed late, dropped,
+ * or repeated because no picture was queued in time. These errors are also
+ * accounted in the statistics of the pic subpipe.
+ *
+ * @param upipe description structure of the super pipe
+ * @param late_p filled with the number of late frames, or NULL
+ * @param dropped_p filled with the number of dropped frames, or NULL
+ * @param underruns_p filled with the number of repeated frames, or NULL
+ * @return an error code
+ */
+static inline int upipe_bmd_sink_get_frame_stats(struct upipe *upipe,
+                                                 unsigned int *late_p,
+                                                 unsigned int *dropped_p,
+                                                 unsigned int *underruns_p)
+{
+    return upipe_control(upipe, UPIPE_BMD_SINK_GET_FRAME_STATS,
+                          UPIPE_BMD_SINK_SIGNATURE, late_p, dropped_p,
+                          underruns_p);
+}
+
 /** @This allocates and initializes a bmd sink pipe.
  *
  * @param mgr management structure for bmd sink type
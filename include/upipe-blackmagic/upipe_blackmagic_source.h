@@ -41,6 +41,7 @@ extern "C" {
 #endif
 
 #include <upipe/upipe.h>
+#include <upipe/umem.h>
 
 #define UPIPE_BMD_SRC_SIGNATURE UBASE_FOURCC('b', 'm', 'd', 's')
 #define UPIPE_BMD_SRC_OUTPUT_SIGNATURE UBASE_FOURCC('b', 'm', 'd', 'o')
@@ -52,7 +53,10 @@ enum upipe_bmd_src_command {
     /** returns the pic subpipe (struct upipe **) */
     UPIPE_BMD_SRC_GET_PIC_SUB,
     /** returns the sound subpipe (struct upipe **) */
-    UPIPE_BMD_SRC_GET_SOUND_SUB
+    UPIPE_BMD_SRC_GET_SOUND_SUB,
+    /** sets the umem manager allocating captured frames
+     * (struct umem_mgr *) */
+    UPIPE_BMD_SRC_SET_UMEM_MGR
 };
 
 /** @This returns the management structure for all bmd sources.
@@ -89,6 +93,22 @@ static inline int upipe_bmd_src_get_sound_sub(struct upipe *upipe,
                          UPIPE_BMD_SRC_SIGNATURE, upipe_p);
 }
 
+/** @This sets the umem manager allocating the buffers of captured video
+ * frames, so that the card writes them directly into Upipe memory, for
+ * instance a @ref umem_hugepage_mgr_alloc arena. It must be called before
+ * @ref upipe_set_uri. By default, the buffers are allocated by the driver.
+ *
+ * @param upipe description structure of the super pipe
+ * @param umem_mgr umem manager, which must be thread-safe
+ * @return an error code
+ */
+static inline int upipe_bmd_src_set_umem_mgr(struct upipe *upipe,
+                                             struct umem_mgr *umem_mgr)
+{
+    return upipe_control(upipe, UPIPE_BMD_SRC_SET_UMEM_MGR,
+                         UPIPE_BMD_SRC_SIGNATURE, umem_mgr);
+}
+
 /** @hidden */
 #define ARGS_DECL , struct uprobe *uprobe_pic, struct uprobe *uprobe_sound
 /** @hidden */
@@ -52,6 +52,9 @@ enum upipe_dvbcsa_command {
     /** delete a pid from the encryption/decryption list (uint64_t) */
     UPIPE_DVBCSA_DEL_PID,
 
+    /** set the number of worker threads of batch pipes (unsigned int) */
+    UPIPE_DVBCSA_SET_THREADS,
+
     /** custom dvbcsa commands start here */
     UPIPE_DVBCSA_CONTROL_LOCAL,
 };
@@ -107,6 +110,22 @@ static inline int upipe_dvbcsa_del_pid(struct upipe *upipe,
                          UPIPE_DVBCSA_COMMON_SIGNATURE, pid);
 }
 
+/** @This sets the number of threads processing the batches of a batch
+ * (bitslice) pipe. Batches are dispatched to the threads as they are
+ * complete and the packets are output in their input order. With 0 (the
+ * default), the batches are processed in the thread of the pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param threads number of worker threads
+ * @return an error code
+ */
+static inline int upipe_dvbcsa_set_threads(struct upipe *upipe,
+                                           unsigned int threads)
+{
+    return upipe_control(upipe, UPIPE_DVBCSA_SET_THREADS,
+                         UPIPE_DVBCSA_COMMON_SIGNATURE, threads);
+}
+
 /** @This stores a parsed dvbcsa control word. */
 struct ustring_dvbcsa_cw {
     /** matching part of the string */
@@ -37,6 +37,8 @@ extern "C" {
 
 UREF_ATTR_FLOAT_VA(amax, amplitude, "amax.amp[%" PRIu8"]", max amplitude,
         uint8_t plane, plane)
+UREF_ATTR_FLOAT_VA(amax, rms, "amax.rms[%" PRIu8"]", RMS amplitude,
+        uint8_t plane, plane)
 
 #define UPIPE_AUDIO_MAX_SIGNATURE UBASE_FOURCC('a', 'm', 'a', 'x')
 
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Bin pipe encoding a sound flow into several renditions
+ *
+ * The input is converted once per distinct target sound format, and each
+ * converted flow is shared by all the renditions requesting this format.
+ * Each rendition has its own encoder, which optionally runs in a worker
+ * thread, so that the renditions of a service are encoded in parallel.
+ *
+ * Renditions are allocated with @ref upipe_flad_output_alloc_sub, and two
+ * packets which belong to the caller: the format packet is passed to the
+ * convert manager (for instance swr) to describe the target sound format,
+ * and the flow_def packet is passed to the encode manager (for instance
+ * avcenc). Renditions with identical format packets share the conversion,
+ * and thus receive the very same samples, so that their frames start on the
+ * same sample.
+ */
+
+#ifndef _UPIPE_FILTERS_UPIPE_FILTER_AUDIO_LADDER_H_
+/** @hidden */
+#define _UPIPE_FILTERS_UPIPE_FILTER_AUDIO_LADDER_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_FLAD_SIGNATURE UBASE_FOURCC('f','l','a','d')
+#define UPIPE_FLAD_OUTPUT_SIGNATURE UBASE_FOURCC('f','l','a','o')
+
+/** @This returns the management structure for all flad pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_flad_mgr_alloc(void);
+
+/** @This extends upipe_mgr_command with specific commands for flad. */
+enum upipe_flad_mgr_command {
+    UPIPE_FLAD_MGR_SENTINEL = UPIPE_MGR_CONTROL_LOCAL,
+
+/** @hidden */
+#define UPIPE_FLAD_MGR_GET_SET_MGR(name, NAME)                              \
+    /** returns the current manager for name inner pipes                    \
+     * (struct upipe_mgr **) */                                             \
+    UPIPE_FLAD_MGR_GET_##NAME##_MGR,                                        \
+    /** sets the manager for name inner pipes (struct upipe_mgr *) */       \
+    UPIPE_FLAD_MGR_SET_##NAME##_MGR,
+
+    UPIPE_FLAD_MGR_GET_SET_MGR(dup, DUP)
+    UPIPE_FLAD_MGR_GET_SET_MGR(convert, CONVERT)
+    UPIPE_FLAD_MGR_GET_SET_MGR(encode, ENCODE)
+#undef UPIPE_FLAD_MGR_GET_SET_MGR
+
+    /** returns the number of worker threads (unsigned int *) */
+    UPIPE_FLAD_MGR_GET_WORKERS,
+    /** sets the worker threads (unsigned int, struct upipe_mgr **,
+     * struct uprobe *) */
+    UPIPE_FLAD_MGR_SET_WORKERS
+};
+
+/** @hidden */
+#define UPIPE_FLAD_MGR_GET_SET_MGR2(name, NAME)                             \
+/** @This returns the current manager for name inner pipes.                 \
+ *                                                                          \
+ * @param mgr pointer to manager                                            \
+ * @param p filled in with the name manager                                 \
+ * @return an error code                                                    \
+ */                                                                         \
+static inline int                                                           \
+    upipe_flad_mgr_get_##name##_mgr(struct upipe_mgr *mgr,                  \
+                                    struct upipe_mgr *p)                    \
+{                                                                           \
+    return upipe_mgr_control(mgr, UPIPE_FLAD_MGR_GET_##NAME##_MGR,          \
+                             UPIPE_FLAD_SIGNATURE, p);                      \
+}                                                                           \
+/** @This sets the manager for name inner pipes. This may only be called    \
+ * before any pipe has been allocated.                                      \
+ *                                                                          \
+ * @param mgr pointer to manager                                            \
+ * @param m pointer to name manager                                         \
+ * @return an error code                                                    \
+ */                                                                         \
+static inline int                                                           \
+    upipe_flad_mgr_set_##name##_mgr(struct upipe_mgr *mgr,                  \
+                                    struct upipe_mgr *m)                    \
+{                                                                           \
+    return upipe_mgr_control(mgr, UPIPE_FLAD_MGR_SET_##NAME##_MGR,          \
+                             UPIPE_FLAD_SIGNATURE, m);                      \
+}
+
+UPIPE_FLAD_MGR_GET_SET_MGR2(dup, DUP)
+UPIPE_FLAD_MGR_GET_SET_MGR2(convert, CONVERT)
+UPIPE_FLAD_MGR_GET_SET_MGR2(encode, ENCODE)
+#undef UPIPE_FLAD_MGR_GET_SET_MGR2
+
+/** @This returns the number of worker threads.
+ *
+ * @param mgr pointer to manager
+ * @param nb_workers_p filled in with the number of worker threads
+ * @return an error code
+ */
+static inline int upipe_flad_mgr_get_workers(struct upipe_mgr *mgr,
+                                             unsigned int *nb_workers_p)
+{
+    return upipe_mgr_control(mgr, UPIPE_FLAD_MGR_GET_WORKERS,
+                             UPIPE_FLAD_SIGNATURE, nb_workers_p);
+}
+
+/** @This sets the worker threads used by the encoders. Renditions are
+ * assigned to a worker in a round-robin fashion, and their encoder runs in
+ * the thread of this worker, while the conversion stages remain in the
+ * thread of the flad pipe. With a pool of xfer threads, a single worker
+ * spreads the renditions on the least loaded threads of the pool. This may
+ * only be called before any pipe has been allocated.
+ *
+ * @param mgr pointer to manager
+ * @param nb_workers number of worker threads, or 0 to disable
+ * @param xfer_mgrs array of nb_workers managers, created for instance with
+ * upipe_pthread_xfer_mgr_alloc
+ * @param uprobe_remote probe hierarchy to use in the worker threads (must be
+ * thread-safe)
+ * @return an error code
+ */
+static inline int upipe_flad_mgr_set_workers(struct upipe_mgr *mgr,
+                                             unsigned int nb_workers,
+                                             struct upipe_mgr **xfer_mgrs,
+                                             struct uprobe *uprobe_remote)
+{
+    return upipe_mgr_control(mgr, UPIPE_FLAD_MGR_SET_WORKERS,
+                             UPIPE_FLAD_SIGNATURE, nb_workers, xfer_mgrs,
+                             uprobe_remote);
+}
+
+/** @hidden */
+#define ARGS_DECL , struct uref *format, struct uref *flow_def
+/** @hidden */
+#define ARGS , format, flow_def
+UPIPE_HELPER_ALLOC(flad_output, UPIPE_FLAD_OUTPUT_SIGNATURE)
+#undef ARGS
+#undef ARGS_DECL
+
+#ifdef __cplusplus
+}
+#endif
+#endif
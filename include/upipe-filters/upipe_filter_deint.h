@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe deinterlacing filter
+ */
+
+#ifndef _UPIPE_FILTERS_UPIPE_FILTER_DEINT_H_
+/** @hidden */
+#define _UPIPE_FILTERS_UPIPE_FILTER_DEINT_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_FILTER_DEINT_SIGNATURE UBASE_FOURCC('d','i','n','t')
+
+/** @This enumerates the deinterlacing modes. */
+enum upipe_filter_deint_mode {
+    /** interpolate the missing field from the kept field */
+    UPIPE_FILTER_DEINT_BOB,
+    /** interpolate spatially within the temporal bounds of the neighbors */
+    UPIPE_FILTER_DEINT_MOTION_ADAPTIVE,
+    /** motion adaptive with edge-directed interpolation and vertical detail
+     * check (yadif) */
+    UPIPE_FILTER_DEINT_YADIF,
+};
+
+/** @This extends upipe_command with specific commands for deint pipes. */
+enum upipe_filter_deint_command {
+    UPIPE_FILTER_DEINT_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the deinterlacing mode (int *) */
+    UPIPE_FILTER_DEINT_GET_MODE,
+    /** sets the deinterlacing mode (int) */
+    UPIPE_FILTER_DEINT_SET_MODE,
+};
+
+/** @This returns the deinterlacing mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param mode_p filled in with the deinterlacing mode
+ * @return an error code
+ */
+static inline int upipe_filter_deint_get_mode(struct upipe *upipe,
+                                              int *mode_p)
+{
+    return upipe_control(upipe, UPIPE_FILTER_DEINT_GET_MODE,
+                         UPIPE_FILTER_DEINT_SIGNATURE, mode_p);
+}
+
+/** @This sets the deinterlacing mode. The temporal modes delay the output
+ * by one picture.
+ *
+ * @param upipe description structure of the pipe
+ * @param mode deinterlacing mode
+ * @return an error code
+ */
+static inline int upipe_filter_deint_set_mode(struct upipe *upipe,
+                                              enum upipe_filter_deint_mode mode)
+{
+    return upipe_control(upipe, UPIPE_FILTER_DEINT_SET_MODE,
+                         UPIPE_FILTER_DEINT_SIGNATURE, (int)mode);
+}
+
+/** @This returns the management structure for deint pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_filter_deint_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
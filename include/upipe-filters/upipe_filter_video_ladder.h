@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Bin pipe encoding a picture flow into several renditions
+ *
+ * This is the video counterpart of flad, meant for ABR ladders of x264 or
+ * x265 encoders. The input is scaled once per distinct target picture
+ * format, and each scaled flow is shared by all the renditions requesting
+ * this format; the pictures are passed by refcount, not copied. Each
+ * rendition has its own encoder, which optionally runs in a worker thread,
+ * so that the renditions of a service are encoded in parallel. Worker
+ * threads may be pinned to CPUs with upipe_pthread_xfer_mgr_alloc_affinity.
+ *
+ * Renditions are allocated with @ref upipe_fvlad_output_alloc_sub, with a
+ * format packet which belongs to the caller and is passed to the scale
+ * manager (for instance sws), or NULL to encode the input pictures as is,
+ * and an encoder pipe, for instance x264 or x265, configured by the caller
+ * beforehand. The per-frame statistics of the encoders (such as
+ * UPROBE_X264_STATS) are thrown to their own probe, which is called from
+ * the worker thread when there are workers.
+ */
+
+#ifndef _UPIPE_FILTERS_UPIPE_FILTER_VIDEO_LADDER_H_
+/** @hidden */
+#define _UPIPE_FILTERS_UPIPE_FILTER_VIDEO_LADDER_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_FVLAD_SIGNATURE UBASE_FOURCC('f','v','l','d')
+#define UPIPE_FVLAD_OUTPUT_SIGNATURE UBASE_FOURCC('f','v','l','o')
+
+/** @This returns the management structure for all fvlad pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_fvlad_mgr_alloc(void);
+
+/** @This extends upipe_mgr_command with specific commands for fvlad. */
+enum upipe_fvlad_mgr_command {
+    UPIPE_FVLAD_MGR_SENTINEL = UPIPE_MGR_CONTROL_LOCAL,
+
+/** @hidden */
+#define UPIPE_FVLAD_MGR_GET_SET_MGR(name, NAME)                             \
+    /** returns the current manager for name inner pipes                    \
+     * (struct upipe_mgr **) */                                             \
+    UPIPE_FVLAD_MGR_GET_##NAME##_MGR,                                       \
+    /** sets the manager for name inner pipes (struct upipe_mgr *) */       \
+    UPIPE_FVLAD_MGR_SET_##NAME##_MGR,
+
+    UPIPE_FVLAD_MGR_GET_SET_MGR(dup, DUP)
+    UPIPE_FVLAD_MGR_GET_SET_MGR(scale, SCALE)
+#undef UPIPE_FVLAD_MGR_GET_SET_MGR
+
+    /** returns the number of worker threads (unsigned int *) */
+    UPIPE_FVLAD_MGR_GET_WORKERS,
+    /** sets the worker threads (unsigned int, struct upipe_mgr **,
+     * struct uprobe *) */
+    UPIPE_FVLAD_MGR_SET_WORKERS
+};
+
+/** @hidden */
+#define UPIPE_FVLAD_MGR_GET_SET_MGR2(name, NAME)                            \
+/** @This returns the current manager for name inner pipes.                 \
+ *                                                                          \
+ * @param mgr pointer to manager                                            \
+ * @param p filled in with the name manager                                 \
+ * @return an error code                                                    \
+ */                                                                         \
+static inline int                                                           \
+    upipe_fvlad_mgr_get_##name##_mgr(struct upipe_mgr *mgr,                 \
+                                     struct upipe_mgr **p)                  \
+{                                                                           \
+    return upipe_mgr_control(mgr, UPIPE_FVLAD_MGR_GET_##NAME##_MGR,         \
+                             UPIPE_FVLAD_SIGNATURE, p);                     \
+}                                                                           \
+/** @This sets the manager for name inner pipes. This may only be called    \
+ * before any pipe has been allocated.                                      \
+ *                                                                          \
+ * @param mgr pointer to manager                                            \
+ * @param m pointer to name manager                                         \
+ * @return an error code                                                    \
+ */                                                                         \
+static inline int                                                           \
+    upipe_fvlad_mgr_set_##name##_mgr(struct upipe_mgr *mgr,                 \
+                                     struct upipe_mgr *m)                   \
+{                                                                           \
+    return upipe_mgr_control(mgr, UPIPE_FVLAD_MGR_SET_##NAME##_MGR,         \
+                             UPIPE_FVLAD_SIGNATURE, m);                     \
+}
+
+UPIPE_FVLAD_MGR_GET_SET_MGR2(dup, DUP)
+UPIPE_FVLAD_MGR_GET_SET_MGR2(scale, SCALE)
+#undef UPIPE_FVLAD_MGR_GET_SET_MGR2
+
+/** @This returns the number of worker threads.
+ *
+ * @param mgr pointer to manager
+ * @param nb_workers_p filled in with the number of worker threads
+ * @return an error code
+ */
+static inline int upipe_fvlad_mgr_get_workers(struct upipe_mgr *mgr,
+                                              unsigned int *nb_workers_p)
+{
+    return upipe_mgr_control(mgr, UPIPE_FVLAD_MGR_GET_WORKERS,
+                             UPIPE_FVLAD_SIGNATURE, nb_workers_p);
+}
+
+/** @This sets the worker threads used by the encoders. Renditions are
+ * assigned to a worker in a round-robin fashion, and their encoder runs in
+ * the thread of this worker, while the scaling stages remain in the thread
+ * of the fvlad pipe. This may only be called before any pipe has been
+ * allocated.
+ *
+ * @param mgr pointer to manager
+ * @param nb_workers number of worker threads, or 0 to disable
+ * @param xfer_mgrs array of nb_workers managers, created for instance with
+ * upipe_pthread_xfer_mgr_alloc_affinity
+ * @param uprobe_remote probe hierarchy to use in the worker threads (must be
+ * thread-safe)
+ * @return an error code
+ */
+static inline int upipe_fvlad_mgr_set_workers(struct upipe_mgr *mgr,
+                                              unsigned int nb_workers,
+                                              struct upipe_mgr **xfer_mgrs,
+                                              struct uprobe *uprobe_remote)
+{
+    return upipe_mgr_control(mgr, UPIPE_FVLAD_MGR_SET_WORKERS,
+                             UPIPE_FVLAD_SIGNATURE, nb_workers, xfer_mgrs,
+                             uprobe_remote);
+}
+
+/** @hidden */
+#define ARGS_DECL , struct uref *format, struct upipe *encoder
+/** @hidden */
+#define ARGS , format, encoder
+UPIPE_HELPER_ALLOC(fvlad_output, UPIPE_FVLAD_OUTPUT_SIGNATURE)
+#undef ARGS
+#undef ARGS_DECL
+
+#ifdef __cplusplus
+}
+#endif
+#endif
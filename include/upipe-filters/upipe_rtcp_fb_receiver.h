@@ -25,6 +25,11 @@
 
 /** @file
  * @short Upipe module receiving rfc4585 feedback
+ * The pipe outputs RTP packets unchanged and keeps them for the configured
+ * latency in a single retransmission buffer indexed by sequence number.
+ * Each receiver of the stream gets an input subpipe for its generic NACK
+ * messages, which outputs the requested packets, optionally limited to a
+ * maximum bitrate. Retransmitted packets share the buffers of the stream.
  */
 
 #ifndef _UPIPE_FILTERS_UPIPE_RTCP_FB_RECEIVER_H_
@@ -39,6 +44,46 @@ extern "C" {
 #define UPIPE_RTCPFB_SIGNATURE UBASE_FOURCC('r','t','c','f')
 #define UPIPE_RTCPFB_INPUT_SIGNATURE UBASE_FOURCC('r','t','c','i')
 
+/** @This extends upipe_command with specific commands for rtcpfb input
+ * subpipes. */
+enum upipe_rtcpfb_input_command {
+    UPIPE_RTCPFB_INPUT_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets the maximum retransmission bitrate (uint64_t) */
+    UPIPE_RTCPFB_INPUT_SET_MAX_RATE,
+    /** returns the maximum retransmission bitrate (uint64_t *) */
+    UPIPE_RTCPFB_INPUT_GET_MAX_RATE,
+};
+
+/** @This sets the maximum bitrate of the retransmissions of an input
+ * subpipe. Packets exceeding it are delayed until enough credit is
+ * available, or dropped when they leave the retransmission buffer.
+ *
+ * @param upipe description structure of the subpipe
+ * @param max_rate maximum bitrate in bits per second, 0 for no limit
+ * @return an error code
+ */
+static inline int upipe_rtcpfb_input_set_max_rate(struct upipe *upipe,
+                                                  uint64_t max_rate)
+{
+    return upipe_control(upipe, UPIPE_RTCPFB_INPUT_SET_MAX_RATE,
+                         UPIPE_RTCPFB_INPUT_SIGNATURE, max_rate);
+}
+
+/** @This returns the maximum bitrate of the retransmissions of an input
+ * subpipe.
+ *
+ * @param upipe description structure of the subpipe
+ * @param max_rate_p filled in with the maximum bitrate in bits per second
+ * @return an error code
+ */
+static inline int upipe_rtcpfb_input_get_max_rate(struct upipe *upipe,
+                                                  uint64_t *max_rate_p)
+{
+    return upipe_control(upipe, UPIPE_RTCPFB_INPUT_GET_MAX_RATE,
+                         UPIPE_RTCPFB_INPUT_SIGNATURE, max_rate_p);
+}
+
 /** @This returns the management structure for rtcpfb pipes.
  *
  * @return pointer to manager
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe scene analysis filter
+ *
+ * This pipe analyses a low-resolution proxy of the luma plane of the
+ * incoming pictures, and attaches its decisions to the urefs: scene cuts,
+ * temporal complexity, keyframe placement and a quantizer offset hint. Placed
+ * before the scalers of an ABR ladder, it lets all renditions share the same
+ * decisions; see @ref upipe_x264_set_scene_enforce and
+ * @ref upipe_x265_set_scene_enforce.
+ */
+
+#ifndef _UPIPE_FILTERS_UPIPE_SCENE_ANALYSIS_H_
+/** @hidden */
+#define _UPIPE_FILTERS_UPIPE_SCENE_ANALYSIS_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+#include <upipe/uref_attr.h>
+
+UREF_ATTR_VOID(scene, cut, "scene.cut", scene cut)
+UREF_ATTR_VOID(scene, key, "scene.key", keyframe decision)
+UREF_ATTR_UNSIGNED(scene, complexity, "scene.cplx",
+        mean absolute difference with the previous proxy in 1/16 of luma step)
+UREF_ATTR_INT(scene, qp_offset, "scene.qp", quantizer offset hint)
+
+#define UPIPE_SCENE_ANALYSIS_SIGNATURE UBASE_FOURCC('s','c','n','a')
+
+/** @This extends upipe_command with specific commands for scene analysis
+ * pipes. */
+enum upipe_scene_analysis_command {
+    UPIPE_SCENE_ANALYSIS_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the minimum and maximum keyframe intervals (unsigned int *,
+     * unsigned int *) */
+    UPIPE_SCENE_ANALYSIS_GET_KEYINT,
+    /** sets the minimum and maximum keyframe intervals (unsigned int,
+     * unsigned int) */
+    UPIPE_SCENE_ANALYSIS_SET_KEYINT,
+    /** sets the scene cut threshold (unsigned int) */
+    UPIPE_SCENE_ANALYSIS_SET_THRESHOLD,
+};
+
+/** @This returns the minimum and maximum keyframe intervals.
+ *
+ * @param upipe description structure of the pipe
+ * @param min_p filled in with the minimum number of pictures between two
+ * keyframes
+ * @param max_p filled in with the maximum number of pictures between two
+ * keyframes
+ * @return an error code
+ */
+static inline int upipe_scene_analysis_get_keyint(struct upipe *upipe,
+                                                  unsigned int *min_p,
+                                                  unsigned int *max_p)
+{
+    return upipe_control(upipe, UPIPE_SCENE_ANALYSIS_GET_KEYINT,
+                         UPIPE_SCENE_ANALYSIS_SIGNATURE, min_p, max_p);
+}
+
+/** @This sets the minimum and maximum keyframe intervals. Scene cuts closer
+ * than the minimum interval to the previous keyframe are flagged but do not
+ * trigger a keyframe.
+ *
+ * @param upipe description structure of the pipe
+ * @param min minimum number of pictures between two keyframes
+ * @param max maximum number of pictures between two keyframes
+ * @return an error code
+ */
+static inline int upipe_scene_analysis_set_keyint(struct upipe *upipe,
+                                                  unsigned int min,
+                                                  unsigned int max)
+{
+    return upipe_control(upipe, UPIPE_SCENE_ANALYSIS_SET_KEYINT,
+                         UPIPE_SCENE_ANALYSIS_SIGNATURE, min, max);
+}
+
+/** @This sets the scene cut threshold, with the same meaning as the
+ * scenecut option of x264: a picture is a scene cut when its temporal
+ * difference exceeds (100 - threshold)% of its spatial activity.
+ *
+ * @param upipe description structure of the pipe
+ * @param threshold threshold between 0 (disabled) and 100
+ * @return an error code
+ */
+static inline int upipe_scene_analysis_set_threshold(struct upipe *upipe,
+                                                     unsigned int threshold)
+{
+    return upipe_control(upipe, UPIPE_SCENE_ANALYSIS_SET_THRESHOLD,
+                         UPIPE_SCENE_ANALYSIS_SIGNATURE, threshold);
+}
+
+/** @This returns the management structure for scene analysis pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_scene_analysis_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
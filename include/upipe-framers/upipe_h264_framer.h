@@ -30,11 +30,51 @@ extern "C" {
 #endif
 
 #include <upipe/upipe.h>
+#include <upipe-framers/upipe_h26x_common.h>
 
 #define UPIPE_H264F_SIGNATURE UBASE_FOURCC('2','6','4','f')
 /** We only accept the ISO 14496-10 annex B elementary stream. */
 #define UPIPE_H264F_EXPECTED_FLOW_DEF "block.h264."
 
+/** @This extends upipe_command with specific commands for h264f pipes. */
+enum upipe_h264f_command {
+    UPIPE_H264F_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the parsing depth (enum upipe_h26xf_depth *) */
+    UPIPE_H264F_GET_DEPTH,
+    /** sets the parsing depth (enum upipe_h26xf_depth) */
+    UPIPE_H264F_SET_DEPTH
+};
+
+/** @This returns the parsing depth.
+ *
+ * @param upipe description structure of the pipe
+ * @param depth_p filled in with the parsing depth
+ * @return an error code
+ */
+static inline int upipe_h264f_get_depth(struct upipe *upipe,
+                                        enum upipe_h26xf_depth *depth_p)
+{
+    return upipe_control(upipe, UPIPE_H264F_GET_DEPTH, UPIPE_H264F_SIGNATURE,
+                         depth_p);
+}
+
+/** @This sets the parsing depth. Lighter depths skip the parsing of SEI
+ * messages and the setting of picture attributes which are not needed to
+ * find the boundaries and the dates of access units, for instance when
+ * remultiplexing or monitoring a stream.
+ *
+ * @param upipe description structure of the pipe
+ * @param depth parsing depth
+ * @return an error code
+ */
+static inline int upipe_h264f_set_depth(struct upipe *upipe,
+                                        enum upipe_h26xf_depth depth)
+{
+    return upipe_control(upipe, UPIPE_H264F_SET_DEPTH, UPIPE_H264F_SIGNATURE,
+                         depth);
+}
+
 /** @This returns the management structure for all h264f pipes.
  *
  * @return pointer to manager
@@ -30,11 +30,51 @@ extern "C" {
 #endif
 
 #include <upipe/upipe.h>
+#include <upipe-framers/upipe_h26x_common.h>
 
 #define UPIPE_H265F_SIGNATURE UBASE_FOURCC('h','e','v','f')
 /** We only accept the ISO 14496-10 annex B elementary stream. */
 #define UPIPE_H265F_EXPECTED_FLOW_DEF "block.h265."
 
+/** @This extends upipe_command with specific commands for h265f pipes. */
+enum upipe_h265f_command {
+    UPIPE_H265F_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the parsing depth (enum upipe_h26xf_depth *) */
+    UPIPE_H265F_GET_DEPTH,
+    /** sets the parsing depth (enum upipe_h26xf_depth) */
+    UPIPE_H265F_SET_DEPTH
+};
+
+/** @This returns the parsing depth.
+ *
+ * @param upipe description structure of the pipe
+ * @param depth_p filled in with the parsing depth
+ * @return an error code
+ */
+static inline int upipe_h265f_get_depth(struct upipe *upipe,
+                                        enum upipe_h26xf_depth *depth_p)
+{
+    return upipe_control(upipe, UPIPE_H265F_GET_DEPTH, UPIPE_H265F_SIGNATURE,
+                         depth_p);
+}
+
+/** @This sets the parsing depth. Lighter depths skip the parsing of SEI
+ * messages and the setting of picture attributes which are not needed to
+ * find the boundaries and the dates of access units, for instance when
+ * remultiplexing or monitoring a stream.
+ *
+ * @param upipe description structure of the pipe
+ * @param depth parsing depth
+ * @return an error code
+ */
+static inline int upipe_h265f_set_depth(struct upipe *upipe,
+                                        enum upipe_h26xf_depth depth)
+{
+    return upipe_control(upipe, UPIPE_H265F_SET_DEPTH, UPIPE_H265F_SIGNATURE,
+                         depth);
+}
+
 /** @This returns the management structure for all h265f pipes.
  *
  * @return pointer to manager
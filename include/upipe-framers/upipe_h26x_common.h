@@ -39,6 +39,19 @@ extern "C" {
 /** @hidden */
 enum uref_h26x_encaps;
 
+/** @This defines how deeply the H.26x framers parse the elementary
+ * stream. */
+enum upipe_h26xf_depth {
+    /** parse everything and set all attributes (default) */
+    UPIPE_H26XF_DEPTH_FULL,
+    /** only set the attributes needed for access unit boundaries, random
+     * access points, dates and durations */
+    UPIPE_H26XF_DEPTH_TIMING,
+    /** same as timing, but do not parse SEI messages, so dates and durations
+     * are only derived from the input and from the slice headers */
+    UPIPE_H26XF_DEPTH_BOUNDARIES
+};
+
 /** @This translates the h26x aspect_ratio_idc to urational */
 extern const struct urational upipe_h26xf_sar_from_idc[17];
 
@@ -56,6 +69,31 @@ struct upipe_h26xf_stream {
  */
 void upipe_h26xf_stream_init(struct upipe_h26xf_stream *f);
 
+/** @internal @This gets the next octet in the ubuf while bypassing escape
+ * words. Only the octets actually consumed are read, directly from the mapped
+ * segment.
+ *
+ * @param s helper structure
+ * @param octet_p reference to returned value
+ * @return an error code
+ */
+static inline int upipe_h26xf_stream_next(struct ubuf_block_stream *s,
+                                          uint8_t *octet_p)
+{
+    struct upipe_h26xf_stream *f =
+        container_of(s, struct upipe_h26xf_stream, s);
+    for ( ; ; ) {
+        UBASE_RETURN(ubuf_block_stream_get(s, octet_p))
+        f->zeros <<= 1;
+        if (likely(*octet_p > 3))
+            return UBASE_ERR_NONE;
+        if (!*octet_p)
+            f->zeros |= 1;
+        if (*octet_p != 3 || (f->zeros & 6) != 6) /* not an escape word */
+            return UBASE_ERR_NONE;
+    }
+}
+
 /** @This gets the next octet in the ubuf while bypassing escape words.
  *
  * @param s helper structure
@@ -71,7 +109,7 @@ int upipe_h26xf_stream_get(struct ubuf_block_stream *s, uint8_t *octet_p);
  * @param nb number of bits to ensure
  */
 #define upipe_h26xf_stream_fill_bits(s, nb)                                 \
-    ubuf_block_stream_fill_bits_inner(s, upipe_h26xf_stream_get, nb)
+    ubuf_block_stream_fill_bits_inner(s, upipe_h26xf_stream_next, nb)
 
 /** @internal @This reads an unsigned exp-golomb code from a stream.
  *
@@ -78,6 +78,50 @@ enum upipe_gl_sink_command {
  */
 bool upipe_gl_texture_load_uref(struct uref *uref, unsigned int texture);
 
+/** @This is the number of pixel buffers used to upload pictures. */
+#define UPIPE_GL_TEXTURE_UPLOAD_BUFFERS 3
+
+/** @This stores the state of asynchronous texture uploads. */
+struct upipe_gl_texture_upload {
+    /** ring of pixel buffer objects */
+    unsigned int buffers[UPIPE_GL_TEXTURE_UPLOAD_BUFFERS];
+    /** next pixel buffer object to use */
+    unsigned int index;
+    /** true if pixel buffer objects are not supported */
+    bool fallback;
+    /** texture width */
+    size_t width;
+    /** texture height */
+    size_t height;
+    /** true if the texture is in RGB565 */
+    bool rgb565;
+};
+
+/** @This initializes the state of asynchronous texture uploads.
+ *
+ * @param upload state of asynchronous texture uploads
+ */
+void upipe_gl_texture_upload_init(struct upipe_gl_texture_upload *upload);
+
+/** @This releases the pixel buffer objects. The GL context must be current.
+ *
+ * @param upload state of asynchronous texture uploads
+ */
+void upipe_gl_texture_upload_clean(struct upipe_gl_texture_upload *upload);
+
+/** @This loads a uref picture into the specified texture through a ring of
+ * pixel buffer objects, so that the transfer to the GPU happens while the
+ * next picture is being prepared. It falls back to
+ * @ref upipe_gl_texture_load_uref if pixel buffer objects are unavailable.
+ *
+ * @param upload state of asynchronous texture uploads
+ * @param uref uref structure describing the picture
+ * @param texture GL texture
+ * @return false in case of error
+ */
+bool upipe_gl_texture_upload_uref(struct upipe_gl_texture_upload *upload,
+                                  struct uref *uref, unsigned int texture);
+
 #ifdef __cplusplus
 }
 #endif
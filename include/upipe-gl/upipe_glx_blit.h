@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe GLX (OpenGL/X11) blit module
+ * This module composes the pictures received on its subpipes onto the
+ * pictures received on its input, like upipe_blit, but scales and composes
+ * them on the GPU in an offscreen GLX context. Pictures are uploaded through
+ * pixel buffer objects, and are read back asynchronously, so that the output
+ * is delayed by one picture. Only planar 8-bit 4:2:0 pictures are supported.
+ */
+
+#ifndef _UPIPE_GL_UPIPE_GLX_BLIT_H_
+/** @hidden */
+#define _UPIPE_GL_UPIPE_GLX_BLIT_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_GLX_BLIT_SIGNATURE UBASE_FOURCC('g','l','x','b')
+#define UPIPE_GLX_BLIT_SUB_SIGNATURE UBASE_FOURCC('g','l','x','i')
+
+/** @This extends upipe_command with specific commands for glx blit
+ * subpipes. */
+enum upipe_glx_blit_sub_command {
+    UPIPE_GLX_BLIT_SUB_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** gets the offsets of the rect onto which the input of this subpipe
+     * will be blitted (uint64_t *, uint64_t *, uint64_t *, uint64_t *) */
+    UPIPE_GLX_BLIT_SUB_GET_RECT,
+    /** sets the offsets of the rect onto which the input of this subpipe
+     * will be blitted (uint64_t, uint64_t, uint64_t, uint64_t) */
+    UPIPE_GLX_BLIT_SUB_SET_RECT
+};
+
+/** @This returns the management structure for glx blit pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_glx_blit_mgr_alloc(void);
+
+/** @This gets the offsets (from the respective borders of the frame) of the
+ * rectangle onto which the input of the subpipe will be blitted.
+ *
+ * @param upipe description structure of the pipe
+ * @param loffset_p filled in with the offset from the left border
+ * @param roffset_p filled in with the offset from the right border
+ * @param toffset_p filled in with the offset from the top border
+ * @param boffset_p filled in with the offset from the bottom border
+ * @return an error code
+ */
+static inline int upipe_glx_blit_sub_get_rect(struct upipe *upipe,
+        uint64_t *loffset_p, uint64_t *roffset_p,
+        uint64_t *toffset_p, uint64_t *boffset_p)
+{
+    return upipe_control(upipe, UPIPE_GLX_BLIT_SUB_GET_RECT,
+                         UPIPE_GLX_BLIT_SUB_SIGNATURE,
+                         loffset_p, roffset_p, toffset_p, boffset_p);
+}
+
+/** @This sets the offsets (from the respective borders of the frame) of the
+ * rectangle onto which the input of the subpipe will be scaled and blitted.
+ *
+ * @param upipe description structure of the pipe
+ * @param loffset offset from the left border
+ * @param roffset offset from the right border
+ * @param toffset offset from the top border
+ * @param boffset offset from the bottom border
+ * @return an error code
+ */
+static inline int upipe_glx_blit_sub_set_rect(struct upipe *upipe,
+        uint64_t loffset, uint64_t roffset, uint64_t toffset, uint64_t boffset)
+{
+    return upipe_control(upipe, UPIPE_GLX_BLIT_SUB_SET_RECT,
+                         UPIPE_GLX_BLIT_SUB_SIGNATURE,
+                         loffset, roffset, toffset, boffset);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module splitting 4:2:2 10-bit pictures into SMPTE ST 2110-20
+ * RTP packets
+ *
+ * Input pictures are planar (y10l, u10l, v10l). Each line is split into
+ * packets carrying one sample row data header (RFC 4175), with the marker
+ * bit on the last packet of a frame, or of a field for interlaced pictures.
+ * The output packets include the RTP header.
+ */
+
+#ifndef _UPIPE_HBRMT_UPIPE_RTP_ST2110_PACK_H_
+/** @hidden */
+#define _UPIPE_HBRMT_UPIPE_RTP_ST2110_PACK_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_RTP_ST2110_PACK_SIGNATURE UBASE_FOURCC('r','2','1','p')
+
+/** @This returns the management structure for rtp_st2110_pack pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_rtp_st2110_pack_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
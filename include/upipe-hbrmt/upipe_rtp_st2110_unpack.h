@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module reassembling SMPTE ST 2110-20 RTP packets into
+ * 4:2:2 10-bit pictures
+ *
+ * The pipe is allocated with a flow definition giving the picture format
+ * (hsize, vsize, and progressive for progressive streams). Payloads are
+ * unpacked straight into the lines of the output picture, as indicated by
+ * the row number and offset of each sample row data header (RFC 4175).
+ */
+
+#ifndef _UPIPE_HBRMT_UPIPE_RTP_ST2110_UNPACK_H_
+/** @hidden */
+#define _UPIPE_HBRMT_UPIPE_RTP_ST2110_UNPACK_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_RTP_ST2110_UNPACK_SIGNATURE UBASE_FOURCC('r','2','1','u')
+
+/** @This returns the management structure for rtp_st2110_unpack pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_rtp_st2110_unpack_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -32,6 +32,47 @@ extern "C" {
 
 #define UPIPE_HLS_AUDIO_SIGNATURE UBASE_FOURCC('h','l','s','a')
 
+/** @This extends @ref upipe_command with specific audio rendition
+ * commands. */
+enum upipe_hls_audio_command {
+    UPIPE_HLS_AUDIO_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** switch to another playlist uri (const char *) */
+    UPIPE_HLS_AUDIO_SWITCH_URI,
+};
+
+/** @This converts audio rendition specific command to a string.
+ *
+ * @param cmd @ref upipe_hls_audio_command to convert
+ * @return the corresponding string or NULL if not a valid
+ * @ref upipe_hls_audio_command
+ */
+static inline const char *upipe_hls_audio_command_str(int cmd)
+{
+    switch ((enum upipe_hls_audio_command)cmd) {
+    UBASE_CASE_TO_STR(UPIPE_HLS_AUDIO_SWITCH_URI);
+    case UPIPE_HLS_AUDIO_SENTINEL: break;
+    }
+    return NULL;
+}
+
+/** @This switches the rendition to the playlist of another variant.
+ * Unlike @ref upipe_set_uri, the playlist, id3v2 and framer inner pipes
+ * are kept: the new playlist is loaded in place of the current one, and its
+ * items are played from the end of the item being played, so that the
+ * output continues without a restart.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri uri of the new playlist
+ * @return an error code
+ */
+static inline int upipe_hls_audio_switch_uri(struct upipe *upipe,
+                                             const char *uri)
+{
+    return upipe_control(upipe, UPIPE_HLS_AUDIO_SWITCH_URI,
+                         UPIPE_HLS_AUDIO_SIGNATURE, uri);
+}
+
 struct upipe_mgr *upipe_hls_audio_mgr_alloc(void);
 
 #ifdef __cplusplus
@@ -33,6 +33,83 @@ extern "C" {
 #define UPIPE_HLS_MASTER_SIGNATURE      UBASE_FOURCC('h','l','s','M')
 #define UPIPE_HLS_MASTER_SUB_SIGNATURE  UBASE_FOURCC('h','l','s','m')
 
+/** @This extends @ref upipe_command with specific master sub pipe
+ * commands. */
+enum upipe_hls_master_sub_command {
+    UPIPE_HLS_MASTER_SUB_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** switch to another variant (struct uref *) */
+    UPIPE_HLS_MASTER_SUB_SWITCH,
+    /** enable or disable the bandwidth adaptation (int) */
+    UPIPE_HLS_MASTER_SUB_SET_ADAPTIVE,
+    /** get the last throughput estimate in bits per second (uint64_t *) */
+    UPIPE_HLS_MASTER_SUB_GET_BANDWIDTH,
+};
+
+/** @This converts master sub pipe specific command to a string.
+ *
+ * @param cmd @ref upipe_hls_master_sub_command to convert
+ * @return the corresponding string or NULL if not a valid
+ * @ref upipe_hls_master_sub_command
+ */
+static inline const char *upipe_hls_master_sub_command_str(int cmd)
+{
+    switch ((enum upipe_hls_master_sub_command)cmd) {
+    UBASE_CASE_TO_STR(UPIPE_HLS_MASTER_SUB_SWITCH);
+    UBASE_CASE_TO_STR(UPIPE_HLS_MASTER_SUB_SET_ADAPTIVE);
+    UBASE_CASE_TO_STR(UPIPE_HLS_MASTER_SUB_GET_BANDWIDTH);
+    case UPIPE_HLS_MASTER_SUB_SENTINEL: break;
+    }
+    return NULL;
+}
+
+/** @This switches to another variant of the master playlist without
+ * restarting the playback: the renditions being played load the playlists
+ * of the new variant and splice its items at the end of their current
+ * item, and the pipes after them are kept.
+ *
+ * @param upipe description structure of the sub pipe
+ * @param variant the variant to switch to, as iterated on the master pipe
+ * @return an error code
+ */
+static inline int upipe_hls_master_sub_switch(struct upipe *upipe,
+                                              struct uref *variant)
+{
+    return upipe_control(upipe, UPIPE_HLS_MASTER_SUB_SWITCH,
+                         UPIPE_HLS_MASTER_SUB_SIGNATURE, variant);
+}
+
+/** @This enables or disables the bandwidth adaptation. When enabled, each
+ * new throughput estimate of the playlists selects the variant with the
+ * highest bandwidth the estimate sustains and switches to it, a higher
+ * variant being only selected with a safety margin. It is disabled by
+ * default.
+ *
+ * @param upipe description structure of the sub pipe
+ * @param adaptive true to enable the adaptation
+ * @return an error code
+ */
+static inline int upipe_hls_master_sub_set_adaptive(struct upipe *upipe,
+                                                    bool adaptive)
+{
+    return upipe_control(upipe, UPIPE_HLS_MASTER_SUB_SET_ADAPTIVE,
+                         UPIPE_HLS_MASTER_SUB_SIGNATURE, adaptive ? 1 : 0);
+}
+
+/** @This gets the last throughput estimate of the playlists.
+ *
+ * @param upipe description structure of the sub pipe
+ * @param bandwidth_p filled with the estimate in bits per second, or 0 if
+ * none was received yet
+ * @return an error code
+ */
+static inline int upipe_hls_master_sub_get_bandwidth(struct upipe *upipe,
+                                                     uint64_t *bandwidth_p)
+{
+    return upipe_control(upipe, UPIPE_HLS_MASTER_SUB_GET_BANDWIDTH,
+                         UPIPE_HLS_MASTER_SUB_SIGNATURE, bandwidth_p);
+}
+
 /** @This allocates a hls master pipe manager.
  *
  * @return the pipe manager.
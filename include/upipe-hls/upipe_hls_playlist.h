@@ -50,6 +50,12 @@ enum upipe_hls_playlist_command {
     UPIPE_HLS_PLAYLIST_NEXT,
     /** seek to this offset (uint64_t) */
     UPIPE_HLS_PLAYLIST_SEEK,
+    /** get the number of prefetched items (unsigned int *) */
+    UPIPE_HLS_PLAYLIST_GET_PREFETCH,
+    /** set the number of prefetched items (unsigned int) */
+    UPIPE_HLS_PLAYLIST_SET_PREFETCH,
+    /** get the estimated throughput in bits per second (uint64_t *) */
+    UPIPE_HLS_PLAYLIST_GET_BANDWIDTH,
 };
 
 /** @This converts m3u playlist specific command to a string.
@@ -66,6 +72,9 @@ static inline const char *upipe_hls_playlist_command_str(int cmd)
     UBASE_CASE_TO_STR(UPIPE_HLS_PLAYLIST_PLAY);
     UBASE_CASE_TO_STR(UPIPE_HLS_PLAYLIST_NEXT);
     UBASE_CASE_TO_STR(UPIPE_HLS_PLAYLIST_SEEK);
+    UBASE_CASE_TO_STR(UPIPE_HLS_PLAYLIST_GET_PREFETCH);
+    UBASE_CASE_TO_STR(UPIPE_HLS_PLAYLIST_SET_PREFETCH);
+    UBASE_CASE_TO_STR(UPIPE_HLS_PLAYLIST_GET_BANDWIDTH);
     case UPIPE_HLS_PLAYLIST_SENTINEL: break;
     }
     return NULL;
@@ -135,6 +144,53 @@ static inline int upipe_hls_playlist_seek(struct upipe *upipe, uint64_t at,
                          UPIPE_HLS_PLAYLIST_SIGNATURE, at, offset_p);
 }
 
+/** @This gets the number of items downloaded ahead of the playing one.
+ *
+ * @param upipe description structure of the pipe
+ * @param prefetch_p filled with the number of prefetched items
+ * @return an error code
+ */
+static inline int upipe_hls_playlist_get_prefetch(struct upipe *upipe,
+                                                  unsigned int *prefetch_p)
+{
+    return upipe_control(upipe, UPIPE_HLS_PLAYLIST_GET_PREFETCH,
+                         UPIPE_HLS_PLAYLIST_SIGNATURE, prefetch_p);
+}
+
+/** @This sets the number of items downloaded ahead of the playing one.
+ * Prefetched items are kept in memory until they are played, so that
+ * the next item starts without waiting for its download. The default
+ * is 0, which downloads each item only when it is played.
+ *
+ * @param upipe description structure of the pipe
+ * @param prefetch number of items to prefetch
+ * @return an error code
+ */
+static inline int upipe_hls_playlist_set_prefetch(struct upipe *upipe,
+                                                  unsigned int prefetch)
+{
+    return upipe_control(upipe, UPIPE_HLS_PLAYLIST_SET_PREFETCH,
+                         UPIPE_HLS_PLAYLIST_SIGNATURE, prefetch);
+}
+
+/** @This gets the throughput estimated from the download of the items.
+ * The source pipes report the size and the duration of each download (see
+ * @ref UPROBE_HTTP_SRC_DOWNLOADED), which feed a fast and a slow moving
+ * average; the estimate is the lowest of both, so that it follows a drop
+ * of the throughput at once and a rise only when it lasts.
+ *
+ * @param upipe description structure of the pipe
+ * @param bandwidth_p filled with the estimate in bits per second, or 0 if
+ * no download was measured yet
+ * @return an error code
+ */
+static inline int upipe_hls_playlist_get_bandwidth(struct upipe *upipe,
+                                                   uint64_t *bandwidth_p)
+{
+    return upipe_control(upipe, UPIPE_HLS_PLAYLIST_GET_BANDWIDTH,
+                         UPIPE_HLS_PLAYLIST_SIGNATURE, bandwidth_p);
+}
+
 /** @This extends @ref uprobe_event with specific m3u playlist events. */
 enum uprobe_hls_playlist_event {
     UPROBE_HLS_PLAYLIST_SENTINEL = UPROBE_LOCAL,
@@ -145,6 +201,9 @@ enum uprobe_hls_playlist_event {
     UPROBE_HLS_PLAYLIST_RELOADED,
     /** the item has finished */
     UPROBE_HLS_PLAYLIST_ITEM_END,
+    /** the throughput estimate was updated, in bits per second
+     * (uint64_t) */
+    UPROBE_HLS_PLAYLIST_BANDWIDTH,
 };
 
 /** @This converts hls playlist specific event to a string.
@@ -158,6 +217,7 @@ static inline const char *uprobe_hls_playlist_event_str(int event)
     UBASE_CASE_TO_STR(UPROBE_HLS_PLAYLIST_NEED_RELOAD);
     UBASE_CASE_TO_STR(UPROBE_HLS_PLAYLIST_RELOADED);
     UBASE_CASE_TO_STR(UPROBE_HLS_PLAYLIST_ITEM_END);
+    UBASE_CASE_TO_STR(UPROBE_HLS_PLAYLIST_BANDWIDTH);
     case UPROBE_HLS_PLAYLIST_SENTINEL: break;
     }
     return NULL;
@@ -38,6 +38,63 @@ extern "C" {
 
 #define UPIPE_AGG_SIGNATURE UBASE_FOURCC('a','g','g','g')
 
+/** @This extends @ref upipe_command with specific commands for
+ * aggregate pipe.
+ */
+enum upipe_agg_command {
+    UPIPE_AGG_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** set the maximum delay (uint64_t) in @ref #UCLOCK_FREQ units */
+    UPIPE_AGG_SET_MAX_DELAY,
+    /** get the maximum delay (uint64_t *) in @ref #UCLOCK_FREQ units */
+    UPIPE_AGG_GET_MAX_DELAY,
+};
+
+/** @This converts @ref upipe_agg_command to a string.
+ *
+ * @param command command to convert
+ * @return a string or NULL if invalid
+ */
+static inline const char *upipe_agg_command_str(int command)
+{
+    switch ((enum upipe_agg_command)command) {
+        UBASE_CASE_TO_STR(UPIPE_AGG_SET_MAX_DELAY);
+        UBASE_CASE_TO_STR(UPIPE_AGG_GET_MAX_DELAY);
+        case UPIPE_AGG_SENTINEL: break;
+    }
+    return NULL;
+}
+
+/** @This sets the maximum time a partial aggregation may be kept waiting
+ * for more packets. Once it expires, the partial aggregation is output, so
+ * that low bitrate streams do not suffer from the full MTU latency.
+ * 0 (the default) disables the timer.
+ *
+ * @param upipe description structure of the pipe
+ * @param max_delay maximum delay in @ref #UCLOCK_FREQ units
+ * @return an error code
+ */
+static inline int upipe_agg_set_max_delay(struct upipe *upipe,
+                                          uint64_t max_delay)
+{
+    return upipe_control(upipe, UPIPE_AGG_SET_MAX_DELAY,
+                         UPIPE_AGG_SIGNATURE, max_delay);
+}
+
+/** @This gets the maximum delay of a partial aggregation.
+ *
+ * @param upipe description structure of the pipe
+ * @param max_delay_p filled with the maximum delay in @ref #UCLOCK_FREQ
+ * units
+ * @return an error code
+ */
+static inline int upipe_agg_get_max_delay(struct upipe *upipe,
+                                          uint64_t *max_delay_p)
+{
+    return upipe_control(upipe, UPIPE_AGG_GET_MAX_DELAY,
+                         UPIPE_AGG_SIGNATURE, max_delay_p);
+}
+
 /** @This returns the management structure for all agg pipes.
  *
  * @return pointer to manager
@@ -25,6 +25,10 @@
 
 /** @file
  * @short Upipe module allowing to duplicate to several outputs
+ *
+ * Each output receives its own uref, but the buffers and the attributes are
+ * shared between them, and an attribute space is only copied when an output
+ * modifies it. The last output takes over the incoming uref.
  */
 
 #ifndef _UPIPE_MODULES_UPIPE_DUP_H_
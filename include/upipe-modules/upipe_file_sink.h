@@ -40,6 +40,8 @@ extern "C" {
 
 #define UPIPE_FSINK_SIGNATURE UBASE_FOURCC('f','s','n','k')
 #define UPIPE_FSINK_EXPECTED_FLOW_DEF "block."
+/** alignment of offsets and sizes in direct I/O mode */
+#define UPIPE_FSINK_DIRECT_ALIGN 4096
 
 /** @This defines file opening modes. */
 enum upipe_fsink_mode {
@@ -69,6 +71,12 @@ enum upipe_fsink_command {
     UPIPE_FSINK_SET_SYNC_PERIOD,
     /** gets fdatasync period (uint64_t *) */
     UPIPE_FSINK_GET_SYNC_PERIOD,
+    /** sets direct I/O chunk size, 0 to disable (unsigned int) */
+    UPIPE_FSINK_SET_DIRECT,
+    /** gets direct I/O chunk size (unsigned int *) */
+    UPIPE_FSINK_GET_DIRECT,
+    /** sets preallocated size of files (uint64_t) */
+    UPIPE_FSINK_SET_PREALLOCATE,
 
     /** outer pipes commands begin here */
     UPIPE_FSINK_CONTROL_LOCAL = UPIPE_CONTROL_LOCAL + 0x1000
@@ -93,7 +101,9 @@ static inline int upipe_fsink_get_path(struct upipe *upipe,
                          path_p);
 }
 
-/** @This asks to open the given file.
+/** @This asks to open the given file. @ref upipe_set_uri may also be used,
+ * with a path or a file:// URI, to open a file in
+ * @ref UPIPE_FSINK_OVERWRITE mode.
  *
  * @param upipe description structure of the pipe
  * @param path relative or absolute path of the file
@@ -162,6 +172,50 @@ static inline int upipe_fsink_set_sync_period(struct upipe *upipe,
                          UPIPE_FSINK_SIGNATURE, sync_period);
 }
 
+/** @This sets the direct I/O chunk size, for files opened afterwards. In this
+ * mode, data is accumulated and written by aligned chunks with O_DIRECT,
+ * bypassing the page cache. The tail of the file is written without O_DIRECT
+ * when the file is closed.
+ *
+ * @param upipe description structure of the pipe
+ * @param chunk_size size of chunks, multiple of @ref UPIPE_FSINK_DIRECT_ALIGN,
+ * or 0 to disable direct I/O
+ * @return an error code
+ */
+static inline int upipe_fsink_set_direct(struct upipe *upipe,
+                                         unsigned int chunk_size)
+{
+    return upipe_control(upipe, UPIPE_FSINK_SET_DIRECT,
+                         UPIPE_FSINK_SIGNATURE, chunk_size);
+}
+
+/** @This returns the direct I/O chunk size.
+ *
+ * @param upipe description structure of the pipe
+ * @param chunk_size_p filled in with the size of chunks, or 0
+ * @return an error code
+ */
+static inline int upipe_fsink_get_direct(struct upipe *upipe,
+                                         unsigned int *chunk_size_p)
+{
+    return upipe_control(upipe, UPIPE_FSINK_GET_DIRECT,
+                         UPIPE_FSINK_SIGNATURE, chunk_size_p);
+}
+
+/** @This sets the number of octets to preallocate in files opened
+ * afterwards, without changing their apparent size.
+ *
+ * @param upipe description structure of the pipe
+ * @param size number of octets, or 0 to disable preallocation
+ * @return an error code
+ */
+static inline int upipe_fsink_set_preallocate(struct upipe *upipe,
+                                              uint64_t size)
+{
+    return upipe_control(upipe, UPIPE_FSINK_SET_PREALLOCATE,
+                         UPIPE_FSINK_SIGNATURE, size);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -38,12 +38,51 @@ extern "C" {
 
 #define UPIPE_FSRC_SIGNATURE UBASE_FOURCC('f','s','r','c')
 
+/** @This extends upipe_command with specific commands for file source. */
+enum upipe_fsrc_command {
+    UPIPE_FSRC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets the size of the mapping window (unsigned int) */
+    UPIPE_FSRC_SET_MMAP,
+    /** returns the size of the mapping window (unsigned int *) */
+    UPIPE_FSRC_GET_MMAP
+};
+
 /** @This returns the management structure for all file sources.
  *
  * @return pointer to manager
  */
 struct upipe_mgr *upipe_fsrc_mgr_alloc(void);
 
+/** @This sets the size of the mapping window. In this mode, regular files
+ * are mapped in memory by windows of the given size, and the output buffers
+ * point directly to the mapping instead of being filled with read(). It
+ * requires a block mem ubuf manager, otherwise the pipe reverts to read().
+ *
+ * @param upipe description structure of the pipe
+ * @param window_size size of the mapping window, or 0 to disable mapping
+ * @return an error code
+ */
+static inline int upipe_fsrc_set_mmap(struct upipe *upipe,
+                                      unsigned int window_size)
+{
+    return upipe_control(upipe, UPIPE_FSRC_SET_MMAP, UPIPE_FSRC_SIGNATURE,
+                         window_size);
+}
+
+/** @This returns the size of the mapping window.
+ *
+ * @param upipe description structure of the pipe
+ * @param window_size_p filled in with the size of the mapping window, or 0
+ * @return an error code
+ */
+static inline int upipe_fsrc_get_mmap(struct upipe *upipe,
+                                      unsigned int *window_size_p)
+{
+    return upipe_control(upipe, UPIPE_FSRC_GET_MMAP, UPIPE_FSRC_SIGNATURE,
+                         window_size_p);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module converting the frame rate of a picture flow
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_FRAMERATE_CONV_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_FRAMERATE_CONV_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_FRAMERATE_CONV_SIGNATURE UBASE_FOURCC('f','r','c','v')
+
+/** @This enumerates the conversion modes. */
+enum upipe_framerate_conv_mode {
+    /** repeat or drop the nearest input picture */
+    UPIPE_FRAMERATE_CONV_REPEAT,
+    /** blend the two surrounding input pictures */
+    UPIPE_FRAMERATE_CONV_BLEND,
+};
+
+/** @This extends upipe_command with specific commands for framerate_conv
+ * pipes. */
+enum upipe_framerate_conv_command {
+    UPIPE_FRAMERATE_CONV_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the output frame rate (struct urational *) */
+    UPIPE_FRAMERATE_CONV_GET_FPS,
+    /** sets the output frame rate (struct urational) */
+    UPIPE_FRAMERATE_CONV_SET_FPS,
+    /** returns the conversion mode (int *) */
+    UPIPE_FRAMERATE_CONV_GET_MODE,
+    /** sets the conversion mode (int) */
+    UPIPE_FRAMERATE_CONV_SET_MODE,
+};
+
+/** @This returns the output frame rate.
+ *
+ * @param upipe description structure of the pipe
+ * @param fps_p filled in with the output frame rate
+ * @return an error code
+ */
+static inline int upipe_framerate_conv_get_fps(struct upipe *upipe,
+                                               struct urational *fps_p)
+{
+    return upipe_control(upipe, UPIPE_FRAMERATE_CONV_GET_FPS,
+                         UPIPE_FRAMERATE_CONV_SIGNATURE, fps_p);
+}
+
+/** @This sets the output frame rate.
+ *
+ * @param upipe description structure of the pipe
+ * @param fps output frame rate
+ * @return an error code
+ */
+static inline int upipe_framerate_conv_set_fps(struct upipe *upipe,
+                                               struct urational fps)
+{
+    return upipe_control(upipe, UPIPE_FRAMERATE_CONV_SET_FPS,
+                         UPIPE_FRAMERATE_CONV_SIGNATURE, fps);
+}
+
+/** @This returns the conversion mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param mode_p filled in with the conversion mode
+ * @return an error code
+ */
+static inline int upipe_framerate_conv_get_mode(struct upipe *upipe,
+                                                int *mode_p)
+{
+    return upipe_control(upipe, UPIPE_FRAMERATE_CONV_GET_MODE,
+                         UPIPE_FRAMERATE_CONV_SIGNATURE, mode_p);
+}
+
+/** @This sets the conversion mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param mode conversion mode
+ * @return an error code
+ */
+static inline int upipe_framerate_conv_set_mode(struct upipe *upipe,
+                                                enum upipe_framerate_conv_mode mode)
+{
+    return upipe_control(upipe, UPIPE_FRAMERATE_CONV_SET_MODE,
+                         UPIPE_FRAMERATE_CONV_SIGNATURE, (int)mode);
+}
+
+/** @This returns the management structure for framerate_conv pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_framerate_conv_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
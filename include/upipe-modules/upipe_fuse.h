@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module applying a chain of per-uref stages in one pass
+ *
+ * This pipe replaces a linear chain of stateless pipes (setattr,
+ * setflowdef, probe_uref, custom callbacks) by a single pipe, so that each
+ * uref crosses one input and one output instead of one per stage.
+ * Flow definition stages are applied once when the flow definition
+ * changes, not per uref.
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_FUSE_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_FUSE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+#include <upipe/uref.h>
+
+#include <stdbool.h>
+
+#define UPIPE_FUSE_SIGNATURE UBASE_FOURCC('f','u','s','e')
+
+/** @This is the type of a callback stage.
+ *
+ * @param opaque opaque given when the stage was added
+ * @param upipe description structure of the fused pipe
+ * @param uref uref being processed, may be modified
+ * @param upump_p reference to pump that generated the buffer
+ * @return false if the uref must be dropped
+ */
+typedef bool (*upipe_fuse_cb)(void *opaque, struct upipe *upipe,
+                              struct uref *uref, struct upump **upump_p);
+
+/** @This extends upipe_command with specific commands for fuse pipes. */
+enum upipe_fuse_command {
+    UPIPE_FUSE_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** appends a stage setting attributes into urefs (struct uref *) */
+    UPIPE_FUSE_ADD_SETATTR,
+    /** appends a stage setting attributes into the flow def (struct uref *) */
+    UPIPE_FUSE_ADD_SETFLOWDEF,
+    /** appends a stage throwing UPROBE_PROBE_UREF events (void) */
+    UPIPE_FUSE_ADD_PROBE,
+    /** appends a callback stage (upipe_fuse_cb, void *) */
+    UPIPE_FUSE_ADD_CALLBACK,
+    /** removes all stages (void) */
+    UPIPE_FUSE_CLEAR
+};
+
+/** @This returns the management structure for all fuse pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_fuse_mgr_alloc(void);
+
+/** @This appends a stage setting the attributes of a dictionary into urefs,
+ * like a setattr pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param dict dictionary to set
+ * @return an error code
+ */
+static inline int upipe_fuse_add_setattr(struct upipe *upipe,
+                                         struct uref *dict)
+{
+    return upipe_control(upipe, UPIPE_FUSE_ADD_SETATTR,
+                         UPIPE_FUSE_SIGNATURE, dict);
+}
+
+/** @This appends a stage setting the attributes of a dictionary into the
+ * output flow definition, like a setflowdef pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param dict dictionary to set
+ * @return an error code
+ */
+static inline int upipe_fuse_add_setflowdef(struct upipe *upipe,
+                                            struct uref *dict)
+{
+    return upipe_control(upipe, UPIPE_FUSE_ADD_SETFLOWDEF,
+                         UPIPE_FUSE_SIGNATURE, dict);
+}
+
+/** @This appends a stage throwing UPROBE_PROBE_UREF events with the
+ * probe_uref signature, like a probe_uref pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static inline int upipe_fuse_add_probe(struct upipe *upipe)
+{
+    return upipe_control(upipe, UPIPE_FUSE_ADD_PROBE, UPIPE_FUSE_SIGNATURE);
+}
+
+/** @This appends a callback stage.
+ *
+ * @param upipe description structure of the pipe
+ * @param cb function called for each uref
+ * @param opaque opaque passed to the callback
+ * @return an error code
+ */
+static inline int upipe_fuse_add_callback(struct upipe *upipe,
+                                          upipe_fuse_cb cb, void *opaque)
+{
+    return upipe_control(upipe, UPIPE_FUSE_ADD_CALLBACK,
+                         UPIPE_FUSE_SIGNATURE, cb, opaque);
+}
+
+/** @This removes all stages.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static inline int upipe_fuse_clear(struct upipe *upipe)
+{
+    return upipe_control(upipe, UPIPE_FUSE_CLEAR, UPIPE_FUSE_SIGNATURE);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
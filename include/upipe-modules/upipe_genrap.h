@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module - generates random access point index records
+ * This module outputs, for each random access point of a framed elementary
+ * stream (uref_flow_get_random), an urefblock containing a fixed-size
+ * record with the (network-endian) k.systime, PTS and clock reference of
+ * the access point, and drops the other urefs.
+ * This is typically used as an input for a multicat sink with a dedicated
+ * suffix, so that the multicat source may start reading at a random access
+ * point (see msrc.rap).
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_GENRAP_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_GENRAP_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <upipe/upipe.h>
+#include <upipe-modules/upipe_genaux.h>
+
+#define UPIPE_GENRAP_SIGNATURE UBASE_FOURCC('g','r','a','p')
+/** size of an index record (k.systime, PTS, clock reference) */
+#define UPIPE_GENRAP_RECORD_SIZE (3 * sizeof(uint64_t))
+
+/** @This is the content of an index record. Unknown values are stored as
+ * UINT64_MAX. */
+struct upipe_genrap_record {
+    /** system time of reception of the access point (k.systime) */
+    uint64_t cr_sys;
+    /** original presentation timestamp of the access point */
+    uint64_t pts_orig;
+    /** original clock reference of the access point */
+    uint64_t cr_orig;
+};
+
+/** @This writes an index record to a buffer.
+ *
+ * @param buf destination buffer of UPIPE_GENRAP_RECORD_SIZE octets
+ * @param record record to write
+ */
+static inline void upipe_genrap_write(uint8_t *buf,
+                                      const struct upipe_genrap_record *record)
+{
+    upipe_genaux_hton64(buf, record->cr_sys);
+    upipe_genaux_hton64(buf + 8, record->pts_orig);
+    upipe_genaux_hton64(buf + 16, record->cr_orig);
+}
+
+/** @This reads an index record from a buffer.
+ *
+ * @param buf source buffer of UPIPE_GENRAP_RECORD_SIZE octets
+ * @param record filled in with the record
+ */
+static inline void upipe_genrap_read(const uint8_t *buf,
+                                     struct upipe_genrap_record *record)
+{
+    record->cr_sys = upipe_genaux_ntoh64(buf);
+    record->pts_orig = upipe_genaux_ntoh64(buf + 8);
+    record->cr_orig = upipe_genaux_ntoh64(buf + 16);
+}
+
+/** @This finds, in an array of index records sorted by k.systime, the last
+ * record received before or at the given system time.
+ *
+ * @param buf array of records
+ * @param nb number of records
+ * @param cr_sys wanted system time
+ * @return index of the record, or -1 if all records are later
+ */
+static inline int64_t upipe_genrap_find(const uint8_t *buf, uint64_t nb,
+                                        uint64_t cr_sys)
+{
+    uint64_t low = 0, high = nb;
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+        if (upipe_genaux_ntoh64(buf + mid * UPIPE_GENRAP_RECORD_SIZE) <=
+            cr_sys)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return (int64_t)low - 1;
+}
+
+/** @This returns the management structure for genrap pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_genrap_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module caching the stream since the last random access point
+ * and replaying it to each new output
+ *
+ * Outputs are subpipes, typically one per receiver. When an output is
+ * allocated, it is first sent the cached stream, starting at the last
+ * random access point, and then the live stream, so that a receiver joining
+ * does not have to wait for the next random access point. The cached urefs
+ * share their buffers with the live stream.
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_GOP_CACHE_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_GOP_CACHE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_GOP_CACHE_SIGNATURE UBASE_FOURCC('g','o','p','c')
+#define UPIPE_GOP_CACHE_OUTPUT_SIGNATURE UBASE_FOURCC('g','o','p','o')
+
+/** @This extends upipe_command with specific commands for gop cache pipes. */
+enum upipe_gop_cache_command {
+    UPIPE_GOP_CACHE_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** set the maximum size of the cache (uint64_t) */
+    UPIPE_GOP_CACHE_SET_MAX_SIZE,
+    /** get the maximum size of the cache (uint64_t *) */
+    UPIPE_GOP_CACHE_GET_MAX_SIZE,
+    /** get the current size of the cache (uint64_t *) */
+    UPIPE_GOP_CACHE_GET_SIZE,
+};
+
+/** @This sets the maximum size of the cache. When the stream since the last
+ * random access point exceeds it, the cache is emptied until the next random
+ * access point.
+ *
+ * @param upipe description structure of the pipe
+ * @param max_size maximum size in octets
+ * @return an error code
+ */
+static inline int upipe_gop_cache_set_max_size(struct upipe *upipe,
+                                               uint64_t max_size)
+{
+    return upipe_control(upipe, UPIPE_GOP_CACHE_SET_MAX_SIZE,
+                         UPIPE_GOP_CACHE_SIGNATURE, max_size);
+}
+
+/** @This returns the maximum size of the cache.
+ *
+ * @param upipe description structure of the pipe
+ * @param max_size_p filled in with the maximum size in octets
+ * @return an error code
+ */
+static inline int upipe_gop_cache_get_max_size(struct upipe *upipe,
+                                               uint64_t *max_size_p)
+{
+    return upipe_control(upipe, UPIPE_GOP_CACHE_GET_MAX_SIZE,
+                         UPIPE_GOP_CACHE_SIGNATURE, max_size_p);
+}
+
+/** @This returns the current size of the cache.
+ *
+ * @param upipe description structure of the pipe
+ * @param size_p filled in with the size of the cached urefs in octets
+ * @return an error code
+ */
+static inline int upipe_gop_cache_get_size(struct upipe *upipe,
+                                           uint64_t *size_p)
+{
+    return upipe_control(upipe, UPIPE_GOP_CACHE_GET_SIZE,
+                         UPIPE_GOP_CACHE_SIGNATURE, size_p);
+}
+
+/** @This returns the management structure for all gop cache pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_gop_cache_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short Upipe sink module - HLS packager
+ * This sink cuts a TS stream into segments at the random access points
+ * flagged by @ref upipe_ts_mux, and writes the segments and an m3u8
+ * playlist through writer pipes opened with @ref upipe_set_uri.
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_HLS_SINK_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_HLS_SINK_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/uclock.h>
+#include <upipe/upipe.h>
+
+#define UPIPE_HLS_SINK_SIGNATURE UBASE_FOURCC('h','l','s','k')
+/** default segment duration (6 s) */
+#define UPIPE_HLS_SINK_DEF_DURATION (UCLOCK_FREQ * 6)
+
+/** @This extends upipe_command with specific commands for hls sink. */
+enum upipe_hls_sink_command {
+    UPIPE_HLS_SINK_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets the writer manager (struct upipe_mgr *) */
+    UPIPE_HLS_SINK_SET_WRITER_MGR,
+    /** returns the writer manager (struct upipe_mgr **) */
+    UPIPE_HLS_SINK_GET_WRITER_MGR,
+    /** sets the minimum segment duration (uint64_t) */
+    UPIPE_HLS_SINK_SET_DURATION,
+    /** returns the minimum segment duration (uint64_t *) */
+    UPIPE_HLS_SINK_GET_DURATION
+};
+
+/** @This returns the management structure for hls sink pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_hls_sink_mgr_alloc(void);
+
+/** @This sets the manager used to allocate writer pipes. A writer pipe is
+ * allocated for each segment and for the playlist, and is opened with
+ * @ref upipe_set_uri; the file sink is the usual writer.
+ *
+ * @param upipe description structure of the pipe
+ * @param writer_mgr writer manager
+ * @return an error code
+ */
+static inline int upipe_hls_sink_set_writer_mgr(struct upipe *upipe,
+                                                struct upipe_mgr *writer_mgr)
+{
+    return upipe_control(upipe, UPIPE_HLS_SINK_SET_WRITER_MGR,
+                         UPIPE_HLS_SINK_SIGNATURE, writer_mgr);
+}
+
+/** @This returns the manager used to allocate writer pipes.
+ *
+ * @param upipe description structure of the pipe
+ * @param writer_mgr_p filled in with the writer manager
+ * @return an error code
+ */
+static inline int upipe_hls_sink_get_writer_mgr(struct upipe *upipe,
+                                                struct upipe_mgr **writer_mgr_p)
+{
+    return upipe_control(upipe, UPIPE_HLS_SINK_GET_WRITER_MGR,
+                         UPIPE_HLS_SINK_SIGNATURE, writer_mgr_p);
+}
+
+/** @This sets the minimum duration of a segment. A new segment is started
+ * on the first random access point after this duration
+ * (default: @ref UPIPE_HLS_SINK_DEF_DURATION).
+ *
+ * @param upipe description structure of the pipe
+ * @param duration duration in 27 MHz units
+ * @return an error code
+ */
+static inline int upipe_hls_sink_set_duration(struct upipe *upipe,
+                                              uint64_t duration)
+{
+    return upipe_control(upipe, UPIPE_HLS_SINK_SET_DURATION,
+                         UPIPE_HLS_SINK_SIGNATURE, duration);
+}
+
+/** @This returns the minimum duration of a segment.
+ *
+ * @param upipe description structure of the pipe
+ * @param duration_p filled in with the duration in 27 MHz units
+ * @return an error code
+ */
+static inline int upipe_hls_sink_get_duration(struct upipe *upipe,
+                                              uint64_t *duration_p)
+{
+    return upipe_control(upipe, UPIPE_HLS_SINK_GET_DURATION,
+                         UPIPE_HLS_SINK_SIGNATURE, duration_p);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
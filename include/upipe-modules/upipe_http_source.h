@@ -24,7 +24,7 @@
  */
 
 /** @file
- * @short Upipe source module for http GET requests
+ * @short Upipe source module for http and https GET requests
  */
 
 #ifndef _UPIPE_MODULES_UPIPE_HTTP_SOURCE_H_
@@ -35,6 +35,7 @@ extern "C" {
 #endif
 
 #include <upipe/upipe.h>
+#include <upipe/uclock.h>
 
 #define UPIPE_HTTP_SRC_SIGNATURE UBASE_FOURCC('h','t','t','p')
 
@@ -48,6 +49,10 @@ enum uprobe_http_src_event {
     /** request receive an error code response
      * with the error code (unsigned int) */
     UPROBE_HTTP_SRC_ERROR,
+    /** a response body was completely received, with its size in octets
+     * (uint64_t) and the time elapsed since the request was sent in uclock
+     * units (uint64_t); only thrown when an uclock is attached */
+    UPROBE_HTTP_SRC_DOWNLOADED,
 };
 
 /** @This converts an enum uprobe_http_src_event to a string.
@@ -60,6 +65,7 @@ static inline const char *uprobe_http_src_event_str(int event)
     switch ((enum uprobe_http_src_event)event) {
     UBASE_CASE_TO_STR(UPROBE_HTTP_SRC_REDIRECT);
     UBASE_CASE_TO_STR(UPROBE_HTTP_SRC_ERROR);
+    UBASE_CASE_TO_STR(UPROBE_HTTP_SRC_DOWNLOADED);
     case UPROBE_HTTP_SRC_SENTINEL: break;
     }
     return NULL;
@@ -92,6 +98,23 @@ static inline int upipe_http_src_throw_error(struct upipe *upipe, unsigned code)
                        UPIPE_HTTP_SRC_SIGNATURE, code);
 }
 
+/** @This throws a downloaded event.
+ *
+ * @param upipe description structure of the pipe
+ * @param size size of the response body in octets
+ * @param duration time elapsed since the request was sent
+ * @return an error code
+ */
+static inline int upipe_http_src_throw_downloaded(struct upipe *upipe,
+                                                  uint64_t size,
+                                                  uint64_t duration)
+{
+    upipe_verbose_va(upipe, "throw downloaded %"PRIu64" octets in "
+                     "%"PRIu64" ms", size, duration * 1000 / UCLOCK_FREQ);
+    return upipe_throw(upipe, UPROBE_HTTP_SRC_DOWNLOADED,
+                       UPIPE_HTTP_SRC_SIGNATURE, size, duration);
+}
+
 /** @This extends upipe_command with specific commands for http source. */
 enum upipe_http_src_command {
     UPIPE_HTTP_SRC_SENTINEL = UPIPE_CONTROL_LOCAL,
@@ -140,6 +163,11 @@ enum upipe_http_src_mgr_command {
     UPIPE_HTTP_SRC_MGR_SET_COOKIE,
     /** iterate over cookies */
     UPIPE_HTTP_SRC_MGR_ITERATE_COOKIE,
+
+    /** get the maximum number of idle connections (unsigned int *) */
+    UPIPE_HTTP_SRC_MGR_GET_KEEP_ALIVE,
+    /** set the maximum number of idle connections (unsigned int) */
+    UPIPE_HTTP_SRC_MGR_SET_KEEP_ALIVE,
 };
 
 /** @This sets the proxy url to use by default for the new allocated pipes.
@@ -198,6 +226,35 @@ static inline int upipe_http_src_mgr_iterate_cookie(struct upipe_mgr *mgr,
                              UPIPE_HTTP_SRC_SIGNATURE, domain, path, uchain_p);
 }
 
+/** @This sets the maximum number of idle connections kept by the manager.
+ * When a response is complete and the server allows it, the connection is
+ * kept open and reused by the next pipe requesting the same host and port.
+ *
+ * @param mgr pointer to upipe manager
+ * @param max_idle maximum number of idle connections, 0 to disable
+ * keep-alive
+ * @return an error code
+ */
+static inline int upipe_http_src_mgr_set_keep_alive(struct upipe_mgr *mgr,
+                                                    unsigned int max_idle)
+{
+    return upipe_mgr_control(mgr, UPIPE_HTTP_SRC_MGR_SET_KEEP_ALIVE,
+                             UPIPE_HTTP_SRC_SIGNATURE, max_idle);
+}
+
+/** @This gets the maximum number of idle connections kept by the manager.
+ *
+ * @param mgr pointer to upipe manager
+ * @param max_idle_p filled in with the maximum number of idle connections
+ * @return an error code
+ */
+static inline int upipe_http_src_mgr_get_keep_alive(struct upipe_mgr *mgr,
+                                                    unsigned int *max_idle_p)
+{
+    return upipe_mgr_control(mgr, UPIPE_HTTP_SRC_MGR_GET_KEEP_ALIVE,
+                             UPIPE_HTTP_SRC_SIGNATURE, max_idle_p);
+}
+
 /** @This returns the management structure for all http sources.
  *
  * @return pointer to manager
@@ -27,14 +27,42 @@
 extern "C" {
 #endif
 
+#include <upipe/upipe.h>
+
 # define UPIPE_M3U_READER_SIGNATURE UBASE_FOURCC('m','3','u','r')
 
+/** @This extends upipe_command with specific commands for m3u reader. */
+enum upipe_m3u_reader_command {
+    UPIPE_M3U_READER_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** enables or disables incremental updates (int) */
+    UPIPE_M3U_READER_SET_INCREMENTAL,
+};
+
 /** @This returns the management structure for m3u reader.
  *
  * @return pointer to manager
  */
 struct upipe_mgr *upipe_m3u_reader_mgr_alloc(void);
 
+/** @This enables or disables incremental updates of media playlists.
+ * When enabled, a reload of a live playlist only outputs the last segment
+ * of the previous load and the items following it, and the flow
+ * definition carries the sequence number of that segment in the update
+ * attribute. The segments before it are not parsed again, and the output
+ * is expected to keep the items it already received for them.
+ *
+ * @param upipe description structure of the pipe
+ * @param incremental true to enable incremental updates
+ * @return an error code
+ */
+static inline int upipe_m3u_reader_set_incremental(struct upipe *upipe,
+                                                   bool incremental)
+{
+    return upipe_control(upipe, UPIPE_M3U_READER_SET_INCREMENTAL,
+                         UPIPE_M3U_READER_SIGNATURE, incremental ? 1 : 0);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short Upipe metrics exporter in Prometheus/OpenMetrics text format
+ *
+ * The exporter serves the instrumentation counters of registered pipes
+ * (see @ref upipe_stats_enable), the allocation statistics of registered
+ * umem managers and the lag of the event loop on an HTTP /metrics
+ * endpoint, from the thread of the event loop. The counters are read
+ * without locking, so that the data path of pipes running in other threads
+ * is left untouched; instrumentation must not be disabled on a pipe while
+ * it is registered.
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_METRICS_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_METRICS_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+
+#include <stdio.h>
+
+/** @hidden */
+struct upipe;
+/** @hidden */
+struct umem_mgr;
+/** @hidden */
+struct upump_mgr;
+/** @hidden */
+struct uclock;
+/** @hidden */
+struct upipe_metrics;
+
+/** @This represents a function printing custom metrics in OpenMetrics text
+ * format. */
+typedef void (*upipe_metrics_collector)(void *opaque, FILE *file);
+
+/** @This allocates a metrics exporter.
+ *
+ * @param upump_mgr management structure of the event loop, or NULL if
+ * there is neither an HTTP server nor a loop lag measurement
+ * @param uclock clock used to measure the loop lag, or NULL
+ * @param period period of the loop lag measurement, in units of
+ * @ref UCLOCK_FREQ
+ * @param host address to listen to, or NULL for any address
+ * @param service port to listen to, or NULL to disable the HTTP server
+ * @return pointer to exporter, or NULL in case of error
+ */
+struct upipe_metrics *upipe_metrics_alloc(struct upump_mgr *upump_mgr,
+                                          struct uclock *uclock,
+                                          uint64_t period,
+                                          const char *host,
+                                          const char *service);
+
+/** @This registers a pipe whose instrumentation counters are exported.
+ *
+ * @param metrics pointer to exporter
+ * @param upipe description structure of the pipe, which is used
+ * @param name value of the pipe label
+ * @return an error code
+ */
+int upipe_metrics_add_pipe(struct upipe_metrics *metrics,
+                           struct upipe *upipe, const char *name);
+
+/** @This registers a umem manager whose allocation statistics are exported.
+ *
+ * @param metrics pointer to exporter
+ * @param umem_mgr umem manager, which is used
+ * @param name value of the umem label
+ * @return an error code
+ */
+int upipe_metrics_add_umem_mgr(struct upipe_metrics *metrics,
+                               struct umem_mgr *umem_mgr, const char *name);
+
+/** @This registers a function printing custom metrics.
+ *
+ * @param metrics pointer to exporter
+ * @param collector function printing metrics
+ * @param opaque opaque passed to the function
+ * @return an error code
+ */
+int upipe_metrics_add_collector(struct upipe_metrics *metrics,
+                                upipe_metrics_collector collector,
+                                void *opaque);
+
+/** @This prints all metrics in OpenMetrics text format.
+ *
+ * @param metrics pointer to exporter
+ * @param file file pointer to write to
+ */
+void upipe_metrics_print(struct upipe_metrics *metrics, FILE *file);
+
+/** @This frees a metrics exporter and releases the registered objects.
+ *
+ * @param metrics pointer to exporter
+ */
+void upipe_metrics_free(struct upipe_metrics *metrics);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -42,12 +42,61 @@ extern "C" {
 UREF_ATTR_STRING(msrc_flow, path, "msrc.path", directory path)
 UREF_ATTR_STRING(msrc_flow, data, "msrc.data", data suffix)
 UREF_ATTR_STRING(msrc_flow, aux, "msrc.aux", aux suffix)
+UREF_ATTR_STRING(msrc_flow, rap, "msrc.rap", RAP index suffix)
 UREF_ATTR_UNSIGNED(msrc_flow, rotate, "msrc.rotate", rotate interval)
 UREF_ATTR_UNSIGNED(msrc_flow, offset, "msrc.offset", rotate offset)
+UREF_ATTR_UNSIGNED(msrc_flow, direct, "msrc.direct", direct I/O read size)
 
 #define UPIPE_MSRC_SIGNATURE UBASE_FOURCC('m','s','r','c')
 #define UPIPE_MSRC_DEF_ROTATE UINT64_C(97200000000)
 #define UPIPE_MSRC_DEF_OFFSET UINT64_C(0)
+/** alignment of offsets and sizes in direct I/O mode */
+#define UPIPE_MSRC_DIRECT_ALIGN 4096
+
+/** @This extends upipe_command with specific commands for msrc pipes. */
+enum upipe_msrc_command {
+    UPIPE_MSRC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the bitmap of wanted TS PIDs (const uint8_t **) */
+    UPIPE_MSRC_GET_PID_FILTER,
+    /** sets the bitmap of wanted TS PIDs (const uint8_t *,
+     * struct urefcount *) */
+    UPIPE_MSRC_SET_PID_FILTER
+};
+
+/** @This returns the bitmap of wanted TS PIDs.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid_filter_p filled in with the bitmap, or NULL
+ * @return an error code
+ */
+static inline int upipe_msrc_get_pid_filter(struct upipe *upipe,
+                                            const uint8_t **pid_filter_p)
+{
+    return upipe_control(upipe, UPIPE_MSRC_GET_PID_FILTER,
+                         UPIPE_MSRC_SIGNATURE, pid_filter_p);
+}
+
+/** @This sets a bitmap of wanted TS PIDs (see upipe/uts_filter.h). The TS
+ * packets of the other PIDs, null packets included, are removed from each
+ * record read from the data file before it is output, and records which end
+ * up empty are not output at all. Records which are not made of whole TS
+ * packets are not filtered. The bitmap is not copied; a reference is held
+ * on its owner until the filter is replaced or the pipe is released.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid_filter bitmap of 8192 bits, or NULL to disable filtering
+ * @param owner refcount of the structure holding the bitmap, or NULL if the
+ * bitmap is static
+ * @return an error code
+ */
+static inline int upipe_msrc_set_pid_filter(struct upipe *upipe,
+                                            const uint8_t *pid_filter,
+                                            struct urefcount *owner)
+{
+    return upipe_control(upipe, UPIPE_MSRC_SET_PID_FILTER,
+                         UPIPE_MSRC_SIGNATURE, pid_filter, owner);
+}
 
 /** @This returns the management structure for msrc pipes.
  *
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe sink module sending urefs to a remote host
+ * The sink serializes incoming urefs and their block buffers with
+ * @ref uref_serial_encode and sends them over a TCP connection to a
+ * @ref upipe_net_xfer_src running on another host, where the rest of the
+ * pipeline goes on. Combining a sink and a source in each direction makes it
+ * possible to offload a part of a pipeline (typically an encoder) to another
+ * host, the remote pipes being allocated by the application running there.
+ *
+ * The source grants credits to the sink, so that at most a window of urefs is
+ * in flight; the sink holds incoming urefs and blocks its input while it has
+ * no credits left or while the socket is full. Urefs received while the input
+ * is blocked are sent in batches of a configurable size with a single system
+ * call.
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_NET_XFER_SINK_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_NET_XFER_SINK_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_NET_XFER_SINK_SIGNATURE UBASE_FOURCC('n','x','f','k')
+
+/** @This extends upipe_command with specific commands for net xfer sink. */
+enum upipe_net_xfer_sink_command {
+    UPIPE_NET_XFER_SINK_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** uses a connected socket (int) */
+    UPIPE_NET_XFER_SINK_SET_FD,
+    /** returns the socket (int *) */
+    UPIPE_NET_XFER_SINK_GET_FD,
+    /** sets the maximum number of urefs sent at once (unsigned int) */
+    UPIPE_NET_XFER_SINK_SET_BATCH,
+    /** returns the number of urefs the source allows to send (uint64_t *) */
+    UPIPE_NET_XFER_SINK_GET_CREDITS
+};
+
+/** @This returns the management structure for net xfer sinks.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_net_xfer_sink_mgr_alloc(void);
+
+/** @This uses an already connected stream socket, instead of connecting to
+ * the host:port given to @ref upipe_set_uri. The socket is closed by the
+ * pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param fd connected socket
+ * @return an error code
+ */
+static inline int upipe_net_xfer_sink_set_fd(struct upipe *upipe, int fd)
+{
+    return upipe_control(upipe, UPIPE_NET_XFER_SINK_SET_FD,
+                         UPIPE_NET_XFER_SINK_SIGNATURE, fd);
+}
+
+/** @This returns the socket of the pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param fd_p filled in with the socket, or -1
+ * @return an error code
+ */
+static inline int upipe_net_xfer_sink_get_fd(struct upipe *upipe, int *fd_p)
+{
+    return upipe_control(upipe, UPIPE_NET_XFER_SINK_GET_FD,
+                         UPIPE_NET_XFER_SINK_SIGNATURE, fd_p);
+}
+
+/** @This sets the maximum number of held urefs sent with a single system
+ * call. Urefs received while the input is not blocked are sent immediately.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch maximum number of urefs per system call
+ * @return an error code
+ */
+static inline int upipe_net_xfer_sink_set_batch(struct upipe *upipe,
+                                                unsigned int batch)
+{
+    return upipe_control(upipe, UPIPE_NET_XFER_SINK_SET_BATCH,
+                         UPIPE_NET_XFER_SINK_SIGNATURE, batch);
+}
+
+/** @This returns the number of urefs the remote source currently allows to
+ * send.
+ *
+ * @param upipe description structure of the pipe
+ * @param credits_p filled in with the number of credits
+ * @return an error code
+ */
+static inline int upipe_net_xfer_sink_get_credits(struct upipe *upipe,
+                                                  uint64_t *credits_p)
+{
+    return upipe_control(upipe, UPIPE_NET_XFER_SINK_GET_CREDITS,
+                         UPIPE_NET_XFER_SINK_SIGNATURE, credits_p);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
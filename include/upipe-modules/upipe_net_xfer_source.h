@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe source module receiving urefs from a remote host
+ * The source waits for a connection from a @ref upipe_net_xfer_sink on the
+ * host:port given to @ref upipe_set_uri, and outputs the urefs and flow
+ * definitions it receives. Each time half of the window of credits has been
+ * output, the source grants the same number of credits back to the sink.
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_NET_XFER_SOURCE_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_NET_XFER_SOURCE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_NET_XFER_SRC_SIGNATURE UBASE_FOURCC('n','x','f','s')
+
+/** @This extends upipe_command with specific commands for net xfer source. */
+enum upipe_net_xfer_src_command {
+    UPIPE_NET_XFER_SRC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** uses a connected socket (int) */
+    UPIPE_NET_XFER_SRC_SET_FD,
+    /** returns the socket (int *) */
+    UPIPE_NET_XFER_SRC_GET_FD,
+    /** sets the number of urefs the sink may send ahead (unsigned int) */
+    UPIPE_NET_XFER_SRC_SET_WINDOW,
+    /** returns the number of urefs the sink may send ahead
+     * (unsigned int *) */
+    UPIPE_NET_XFER_SRC_GET_WINDOW,
+    /** sets the maximum size of a received frame (unsigned int) */
+    UPIPE_NET_XFER_SRC_SET_MAX_FRAME_SIZE,
+    /** returns the maximum size of a received frame (unsigned int *) */
+    UPIPE_NET_XFER_SRC_GET_MAX_FRAME_SIZE
+};
+
+/** @This returns the management structure for net xfer sources.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_net_xfer_src_mgr_alloc(void);
+
+/** @This uses an already connected stream socket, instead of waiting for a
+ * connection on the host:port given to @ref upipe_set_uri. The socket is
+ * closed by the pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param fd connected socket
+ * @return an error code
+ */
+static inline int upipe_net_xfer_src_set_fd(struct upipe *upipe, int fd)
+{
+    return upipe_control(upipe, UPIPE_NET_XFER_SRC_SET_FD,
+                         UPIPE_NET_XFER_SRC_SIGNATURE, fd);
+}
+
+/** @This returns the socket of the pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param fd_p filled in with the connected socket, or -1
+ * @return an error code
+ */
+static inline int upipe_net_xfer_src_get_fd(struct upipe *upipe, int *fd_p)
+{
+    return upipe_control(upipe, UPIPE_NET_XFER_SRC_GET_FD,
+                         UPIPE_NET_XFER_SRC_SIGNATURE, fd_p);
+}
+
+/** @This sets the number of urefs the sink may send before they are output
+ * by the source.
+ *
+ * @param upipe description structure of the pipe
+ * @param window number of credits
+ * @return an error code
+ */
+static inline int upipe_net_xfer_src_set_window(struct upipe *upipe,
+                                                unsigned int window)
+{
+    return upipe_control(upipe, UPIPE_NET_XFER_SRC_SET_WINDOW,
+                         UPIPE_NET_XFER_SRC_SIGNATURE, window);
+}
+
+/** @This returns the number of urefs the sink may send before they are
+ * output by the source.
+ *
+ * @param upipe description structure of the pipe
+ * @param window_p filled in with the number of credits
+ * @return an error code
+ */
+static inline int upipe_net_xfer_src_get_window(struct upipe *upipe,
+                                                unsigned int *window_p)
+{
+    return upipe_control(upipe, UPIPE_NET_XFER_SRC_GET_WINDOW,
+                         UPIPE_NET_XFER_SRC_SIGNATURE, window_p);
+}
+
+/** @This sets the maximum size of a frame received from the sink, that is
+ * a serialized uref and its payload. The connection is closed when a frame
+ * exceeds it, since the stream can't be resynchronized.
+ *
+ * @param upipe description structure of the pipe
+ * @param max_frame_size maximum size of a frame, in octets
+ * @return an error code
+ */
+static inline int upipe_net_xfer_src_set_max_frame_size(struct upipe *upipe,
+        unsigned int max_frame_size)
+{
+    return upipe_control(upipe, UPIPE_NET_XFER_SRC_SET_MAX_FRAME_SIZE,
+                         UPIPE_NET_XFER_SRC_SIGNATURE, max_frame_size);
+}
+
+/** @This returns the maximum size of a frame received from the sink.
+ *
+ * @param upipe description structure of the pipe
+ * @param max_frame_size_p filled in with the maximum size of a frame
+ * @return an error code
+ */
+static inline int upipe_net_xfer_src_get_max_frame_size(struct upipe *upipe,
+        unsigned int *max_frame_size_p)
+{
+    return upipe_control(upipe, UPIPE_NET_XFER_SRC_GET_MAX_FRAME_SIZE,
+                         UPIPE_NET_XFER_SRC_SIGNATURE, max_frame_size_p);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -53,14 +53,100 @@ extern "C" {
 
 #include <upipe/upipe.h>
 
+#include <stdint.h>
+#include <stdbool.h>
+
 #define UPIPE_QSINK_SIGNATURE UBASE_FOURCC('q','s','n','k')
 
+/** @This extends upipe_command with specific commands for queue sink. */
+enum upipe_qsink_command {
+    UPIPE_QSINK_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets the wait policy of the queue source on an empty queue
+     * (uint64_t, unsigned int) */
+    UPIPE_QSINK_SET_WAIT_POLICY,
+    /** sets the high and low watermarks of the queue
+     * (unsigned int, unsigned int) */
+    UPIPE_QSINK_SET_WATERMARKS,
+    /** returns the backpressure statistics (struct upipe_qsink_stats *) */
+    UPIPE_QSINK_GET_STATS
+};
+
+/** @This stores the backpressure statistics of a queue sink. */
+struct upipe_qsink_stats {
+    /** current number of urefs in the queue */
+    unsigned int depth;
+    /** high watermark, or 0 if disabled */
+    unsigned int high_mark;
+    /** low watermark */
+    unsigned int low_mark;
+    /** true if upstream pumps are currently blocked on the high watermark */
+    bool blocked;
+    /** number of times upstream pumps were blocked on the high watermark */
+    uint64_t nb_blocks;
+    /** cumulated time spent blocked on the high watermark, in units of
+     * @ref UCLOCK_FREQ */
+    uint64_t blocked_time;
+};
+
 /** @This returns the management structure for all queue sinks.
  *
  * @return pointer to manager
  */
 struct upipe_mgr *upipe_qsink_mgr_alloc(void);
 
+/** @This sets the policy of the queue source, in its own thread, when it
+ * finds the queue empty (see @ref upipe_qsrc_set_wait_policy). Contrary to
+ * the queue source control, this one may be sent from the thread feeding the
+ * queue, for instance on a worker bin.
+ *
+ * @param upipe description structure of the pipe
+ * @param spin time (in 27 MHz ticks, at most one second) to busy-poll
+ * @param yields number of times to yield the CPU
+ * @return an error code
+ */
+static inline int upipe_qsink_set_wait_policy(struct upipe *upipe,
+                                              uint64_t spin,
+                                              unsigned int yields)
+{
+    return upipe_control(upipe, UPIPE_QSINK_SET_WAIT_POLICY,
+                         UPIPE_QSINK_SIGNATURE, spin, yields);
+}
+
+/** @This sets the watermarks of the queue. When the depth of the queue
+ * reaches the high watermark, the pumps feeding the queue sink are blocked,
+ * and they are released when the queue source has drained the queue down to
+ * the low watermark. This throttles sources smoothly, well before the queue
+ * is full. A high watermark of 0 disables the mechanism (default).
+ *
+ * @param upipe description structure of the pipe
+ * @param high_mark depth at which upstream pumps are blocked, at most the
+ * length of the queue, or 0
+ * @param low_mark depth at which upstream pumps are released, lower than
+ * high_mark
+ * @return an error code
+ */
+static inline int upipe_qsink_set_watermarks(struct upipe *upipe,
+                                             unsigned int high_mark,
+                                             unsigned int low_mark)
+{
+    return upipe_control(upipe, UPIPE_QSINK_SET_WATERMARKS,
+                         UPIPE_QSINK_SIGNATURE, high_mark, low_mark);
+}
+
+/** @This returns the backpressure statistics of the queue.
+ *
+ * @param upipe description structure of the pipe
+ * @param stats filled in with the statistics
+ * @return an error code
+ */
+static inline int upipe_qsink_get_stats(struct upipe *upipe,
+                                        struct upipe_qsink_stats *stats)
+{
+    return upipe_control(upipe, UPIPE_QSINK_GET_STATS,
+                         UPIPE_QSINK_SIGNATURE, stats);
+}
+
 /** @hidden */
 #define ARGS_DECL , struct upipe *qsrc
 /** @hidden */
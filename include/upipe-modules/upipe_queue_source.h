@@ -57,7 +57,9 @@ enum upipe_qsrc_command {
     /** returns the maximum length of the queue (unsigned int *) */
     UPIPE_QSRC_GET_MAX_LENGTH,
     /** returns the current length of the queue (unsigned int *) */
-    UPIPE_QSRC_GET_LENGTH
+    UPIPE_QSRC_GET_LENGTH,
+    /** sets the wait policy on an empty queue (uint64_t, unsigned int) */
+    UPIPE_QSRC_SET_WAIT_POLICY
 };
 
 /** @This returns the management structure for all queue sources.
@@ -95,6 +97,25 @@ static inline int upipe_qsrc_get_length(struct upipe *upipe,
                          UPIPE_QSRC_SIGNATURE, length_p);
 }
 
+/** @This sets the policy of the queue source when it finds the queue empty:
+ * it busy-polls the queue for the given time, then yields the CPU the given
+ * number of times, and only then goes back to the event loop to wait on the
+ * eventfd. This trades CPU time for lower wakeup jitter on latency-critical
+ * chains. The default is to wait on the eventfd immediately.
+ *
+ * @param upipe description structure of the pipe
+ * @param spin time (in 27 MHz ticks, at most one second) to busy-poll
+ * @param yields number of times to yield the CPU
+ * @return an error code
+ */
+static inline int upipe_qsrc_set_wait_policy(struct upipe *upipe,
+                                             uint64_t spin,
+                                             unsigned int yields)
+{
+    return upipe_control(upipe, UPIPE_QSRC_SET_WAIT_POLICY,
+                         UPIPE_QSRC_SIGNATURE, spin, yields);
+}
+
 /** @hidden */
 #define ARGS_DECL , unsigned int queue_length
 /** @hidden */
@@ -30,8 +30,56 @@
 extern "C" {
 #endif
 
+#include <upipe/upipe.h>
+
 #define UPIPE_RTP_H264_SIGNATURE UBASE_FOURCC('r','t','p','h')
 
+/** @This extends upipe_command with specific commands for rtp h264 pipes. */
+enum upipe_rtp_h264_command {
+    UPIPE_RTP_H264_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** enable or disable STAP-A aggregation of small NAL units (int) */
+    UPIPE_RTP_H264_SET_AGGREGATE,
+    /** get the STAP-A aggregation mode (int *) */
+    UPIPE_RTP_H264_GET_AGGREGATE,
+};
+
+/** @This enables or disables the aggregation of consecutive small NAL units
+ * of an access unit into STAP-A packets (RFC 6184 5.7.1). It is disabled by
+ * default.
+ *
+ * @param upipe description structure of the pipe
+ * @param aggregate true to enable aggregation
+ * @return an error code
+ */
+static inline int upipe_rtp_h264_set_aggregate(struct upipe *upipe,
+                                               bool aggregate)
+{
+    return upipe_control(upipe, UPIPE_RTP_H264_SET_AGGREGATE,
+                         UPIPE_RTP_H264_SIGNATURE, aggregate ? 1 : 0);
+}
+
+/** @This returns the STAP-A aggregation mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param aggregate_p filled in with true if aggregation is enabled
+ * @return an error code
+ */
+static inline int upipe_rtp_h264_get_aggregate(struct upipe *upipe,
+                                               bool *aggregate_p)
+{
+    int aggregate;
+    UBASE_RETURN(upipe_control(upipe, UPIPE_RTP_H264_GET_AGGREGATE,
+                               UPIPE_RTP_H264_SIGNATURE, &aggregate))
+    if (aggregate_p != NULL)
+        *aggregate_p = !!aggregate;
+    return UBASE_ERR_NONE;
+}
+
+/** @This returns the management structure for rtp h264 pipes.
+ *
+ * @return pointer to manager
+ */
 struct upipe_mgr *upipe_rtp_h264_mgr_alloc(void);
 
 #ifdef __cplusplus
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _UPIPE_MODULES_UPIPE_RTP_H265_H_
+# define _UPIPE_MODULES_UPIPE_RTP_H265_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_RTP_H265_SIGNATURE UBASE_FOURCC('r','t','p','5')
+
+/** @This extends upipe_command with specific commands for rtp h265 pipes. */
+enum upipe_rtp_h265_command {
+    UPIPE_RTP_H265_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** enable or disable AP aggregation of small NAL units (int) */
+    UPIPE_RTP_H265_SET_AGGREGATE,
+    /** get the AP aggregation mode (int *) */
+    UPIPE_RTP_H265_GET_AGGREGATE,
+};
+
+/** @This enables or disables the aggregation of consecutive small NAL units
+ * of an access unit into AP packets (RFC 7798 4.4.2). It is disabled by
+ * default.
+ *
+ * @param upipe description structure of the pipe
+ * @param aggregate true to enable aggregation
+ * @return an error code
+ */
+static inline int upipe_rtp_h265_set_aggregate(struct upipe *upipe,
+                                               bool aggregate)
+{
+    return upipe_control(upipe, UPIPE_RTP_H265_SET_AGGREGATE,
+                         UPIPE_RTP_H265_SIGNATURE, aggregate ? 1 : 0);
+}
+
+/** @This returns the AP aggregation mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param aggregate_p filled in with true if aggregation is enabled
+ * @return an error code
+ */
+static inline int upipe_rtp_h265_get_aggregate(struct upipe *upipe,
+                                               bool *aggregate_p)
+{
+    int aggregate;
+    UBASE_RETURN(upipe_control(upipe, UPIPE_RTP_H265_GET_AGGREGATE,
+                               UPIPE_RTP_H265_SIGNATURE, &aggregate))
+    if (aggregate_p != NULL)
+        *aggregate_p = !!aggregate;
+    return UBASE_ERR_NONE;
+}
+
+/** @This returns the management structure for rtp h265 pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_rtp_h265_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module receiving RTP PCM (AES67, SMPTE 2110-30) into frames
+ *
+ * This pipe takes RTP packets carrying L16 or L24 audio, typically straight
+ * from a batched udpsrc, and places each payload at the position given by
+ * its RTP timestamp into a ring of sound frames. Frames are output as soon as
+ * they are complete, or when the jitter window moves past them, with
+ * silence in place of missing packets.
+ *
+ * The pipe is allocated with a flow definition describing the payload:
+ * block.s16be.sound. or block.s24be.sound., with the rate and the number of
+ * channels.
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_RTP_PCM_RECV_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_RTP_PCM_RECV_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_RTP_PCM_RECV_SIGNATURE UBASE_FOURCC('r','p','c','r')
+
+/** @This extends upipe_command with specific commands for rtp_pcm_recv
+ * pipes. */
+enum upipe_rtp_pcm_recv_command {
+    UPIPE_RTP_PCM_RECV_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the number of samples per output frame (unsigned int *) */
+    UPIPE_RTP_PCM_RECV_GET_FRAME_SIZE,
+    /** sets the number of samples per output frame (unsigned int) */
+    UPIPE_RTP_PCM_RECV_SET_FRAME_SIZE,
+    /** returns the jitter window, in frames (unsigned int *) */
+    UPIPE_RTP_PCM_RECV_GET_LATENCY,
+    /** sets the jitter window, in frames (unsigned int) */
+    UPIPE_RTP_PCM_RECV_SET_LATENCY
+};
+
+/** @This returns the management structure for rtp_pcm_recv pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_rtp_pcm_recv_mgr_alloc(void);
+
+/** @This returns the number of samples per output frame.
+ *
+ * @param upipe description structure of the pipe
+ * @param frame_size_p filled in with the number of samples
+ * @return an error code
+ */
+static inline int upipe_rtp_pcm_recv_get_frame_size(struct upipe *upipe,
+        unsigned int *frame_size_p)
+{
+    return upipe_control(upipe, UPIPE_RTP_PCM_RECV_GET_FRAME_SIZE,
+                         UPIPE_RTP_PCM_RECV_SIGNATURE, frame_size_p);
+}
+
+/** @This sets the number of samples per output frame. Pending frames are
+ * output first.
+ *
+ * @param upipe description structure of the pipe
+ * @param frame_size number of samples
+ * @return an error code
+ */
+static inline int upipe_rtp_pcm_recv_set_frame_size(struct upipe *upipe,
+        unsigned int frame_size)
+{
+    return upipe_control(upipe, UPIPE_RTP_PCM_RECV_SET_FRAME_SIZE,
+                         UPIPE_RTP_PCM_RECV_SIGNATURE, frame_size);
+}
+
+/** @This returns the jitter window.
+ *
+ * @param upipe description structure of the pipe
+ * @param latency_p filled in with the number of frames
+ * @return an error code
+ */
+static inline int upipe_rtp_pcm_recv_get_latency(struct upipe *upipe,
+        unsigned int *latency_p)
+{
+    return upipe_control(upipe, UPIPE_RTP_PCM_RECV_GET_LATENCY,
+                         UPIPE_RTP_PCM_RECV_SIGNATURE, latency_p);
+}
+
+/** @This sets the jitter window, that is the number of frames kept open
+ * after the oldest incomplete one before it is output. Pending frames are
+ * output first.
+ *
+ * @param upipe description structure of the pipe
+ * @param latency number of frames
+ * @return an error code
+ */
+static inline int upipe_rtp_pcm_recv_set_latency(struct upipe *upipe,
+        unsigned int latency)
+{
+    return upipe_control(upipe, UPIPE_RTP_PCM_RECV_SET_LATENCY,
+                         UPIPE_RTP_PCM_RECV_SIGNATURE, latency);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -30,11 +30,25 @@ extern "C" {
 #include <upipe/upipe.h>
 
 #define UPIPE_SEQ_SRC_SIGNATURE UBASE_FOURCC('s','e','q','s')
+#define UPIPE_SEQ_SRC_GATE_SIGNATURE UBASE_FOURCC('s','e','q','g')
 
 struct upipe_mgr *upipe_seq_src_mgr_alloc(void);
 int upipe_seq_src_mgr_set_source_mgr(struct upipe_mgr *mgr,
                                      struct upipe_mgr *source_mgr);
 
+/** @This sets the number of octets to read ahead from the next queued
+ * source while the current one is playing. The next source is opened
+ * beforehand, so that the transition does not wait for open() or for the
+ * first read. If the source manager is a worker manager (see
+ * @ref upipe_wsrc_mgr_alloc), the open and the reads happen on the worker
+ * thread. 0 (the default) disables prefetching.
+ *
+ * @param mgr pointer to sequential source manager
+ * @param size number of octets to prefetch
+ * @return an error code
+ */
+int upipe_seq_src_mgr_set_prefetch(struct upipe_mgr *mgr, uint64_t size);
+
 #ifdef __cplusplus
 }
 #endif
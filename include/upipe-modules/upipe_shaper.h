@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module shaping several flows with hierarchical token buckets
+ *
+ * Each subpipe is a flow with its own rate and burst budget. The super pipe
+ * has an aggregate rate and burst budget shared by all its subpipes. Packets
+ * exceeding the budgets are held, and a single timer releases them in
+ * batches, round-robin between the flows.
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_SHAPER_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_SHAPER_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_SHAPER_SIGNATURE UBASE_FOURCC('s','h','p','r')
+#define UPIPE_SHAPER_SUB_SIGNATURE UBASE_FOURCC('s','h','p','s')
+
+/** @This extends @ref upipe_command with specific commands for shaper
+ * pipes and their subpipes.
+ */
+enum upipe_shaper_command {
+    UPIPE_SHAPER_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** set the rate (uint64_t) in octets per second, 0 for unlimited */
+    UPIPE_SHAPER_SET_RATE,
+    /** get the rate (uint64_t *) in octets per second */
+    UPIPE_SHAPER_GET_RATE,
+    /** set the burst budget (uint64_t) in octets, 0 for automatic */
+    UPIPE_SHAPER_SET_BURST,
+    /** get the burst budget (uint64_t *) in octets */
+    UPIPE_SHAPER_GET_BURST,
+    /** set the timer period (uint64_t) in @ref #UCLOCK_FREQ units */
+    UPIPE_SHAPER_SET_TICK,
+    /** get the timer period (uint64_t *) in @ref #UCLOCK_FREQ units */
+    UPIPE_SHAPER_GET_TICK,
+};
+
+/** @This converts @ref upipe_shaper_command to a string.
+ *
+ * @param command command to convert
+ * @return a string or NULL if invalid
+ */
+static inline const char *upipe_shaper_command_str(int command)
+{
+    switch ((enum upipe_shaper_command)command) {
+        UBASE_CASE_TO_STR(UPIPE_SHAPER_SET_RATE);
+        UBASE_CASE_TO_STR(UPIPE_SHAPER_GET_RATE);
+        UBASE_CASE_TO_STR(UPIPE_SHAPER_SET_BURST);
+        UBASE_CASE_TO_STR(UPIPE_SHAPER_GET_BURST);
+        UBASE_CASE_TO_STR(UPIPE_SHAPER_SET_TICK);
+        UBASE_CASE_TO_STR(UPIPE_SHAPER_GET_TICK);
+        case UPIPE_SHAPER_SENTINEL: break;
+    }
+    return NULL;
+}
+
+/** @This sets the aggregate rate of a shaper pipe.
+ *
+ * @param upipe description structure of the super pipe
+ * @param rate rate in octets per second, 0 for unlimited
+ * @return an error code
+ */
+static inline int upipe_shaper_set_rate(struct upipe *upipe, uint64_t rate)
+{
+    return upipe_control(upipe, UPIPE_SHAPER_SET_RATE,
+                         UPIPE_SHAPER_SIGNATURE, rate);
+}
+
+/** @This gets the aggregate rate of a shaper pipe.
+ *
+ * @param upipe description structure of the super pipe
+ * @param rate_p filled with the rate in octets per second
+ * @return an error code
+ */
+static inline int upipe_shaper_get_rate(struct upipe *upipe,
+                                        uint64_t *rate_p)
+{
+    return upipe_control(upipe, UPIPE_SHAPER_GET_RATE,
+                         UPIPE_SHAPER_SIGNATURE, rate_p);
+}
+
+/** @This sets the aggregate burst budget of a shaper pipe, that is the
+ * number of octets that may be sent at once after an idle period.
+ *
+ * @param upipe description structure of the super pipe
+ * @param burst burst budget in octets, 0 for 10 ms worth of rate
+ * @return an error code
+ */
+static inline int upipe_shaper_set_burst(struct upipe *upipe, uint64_t burst)
+{
+    return upipe_control(upipe, UPIPE_SHAPER_SET_BURST,
+                         UPIPE_SHAPER_SIGNATURE, burst);
+}
+
+/** @This gets the aggregate burst budget of a shaper pipe.
+ *
+ * @param upipe description structure of the super pipe
+ * @param burst_p filled with the burst budget in octets
+ * @return an error code
+ */
+static inline int upipe_shaper_get_burst(struct upipe *upipe,
+                                         uint64_t *burst_p)
+{
+    return upipe_control(upipe, UPIPE_SHAPER_GET_BURST,
+                         UPIPE_SHAPER_SIGNATURE, burst_p);
+}
+
+/** @This sets the period of the timer releasing held packets.
+ *
+ * @param upipe description structure of the super pipe
+ * @param tick timer period in @ref #UCLOCK_FREQ units
+ * @return an error code
+ */
+static inline int upipe_shaper_set_tick(struct upipe *upipe, uint64_t tick)
+{
+    return upipe_control(upipe, UPIPE_SHAPER_SET_TICK,
+                         UPIPE_SHAPER_SIGNATURE, tick);
+}
+
+/** @This gets the period of the timer releasing held packets.
+ *
+ * @param upipe description structure of the super pipe
+ * @param tick_p filled with the timer period in @ref #UCLOCK_FREQ units
+ * @return an error code
+ */
+static inline int upipe_shaper_get_tick(struct upipe *upipe,
+                                        uint64_t *tick_p)
+{
+    return upipe_control(upipe, UPIPE_SHAPER_GET_TICK,
+                         UPIPE_SHAPER_SIGNATURE, tick_p);
+}
+
+/** @This sets the rate of a flow.
+ *
+ * @param upipe description structure of the subpipe
+ * @param rate rate in octets per second, 0 for unlimited
+ * @return an error code
+ */
+static inline int upipe_shaper_sub_set_rate(struct upipe *upipe,
+                                            uint64_t rate)
+{
+    return upipe_control(upipe, UPIPE_SHAPER_SET_RATE,
+                         UPIPE_SHAPER_SUB_SIGNATURE, rate);
+}
+
+/** @This gets the rate of a flow.
+ *
+ * @param upipe description structure of the subpipe
+ * @param rate_p filled with the rate in octets per second
+ * @return an error code
+ */
+static inline int upipe_shaper_sub_get_rate(struct upipe *upipe,
+                                            uint64_t *rate_p)
+{
+    return upipe_control(upipe, UPIPE_SHAPER_GET_RATE,
+                         UPIPE_SHAPER_SUB_SIGNATURE, rate_p);
+}
+
+/** @This sets the burst budget of a flow.
+ *
+ * @param upipe description structure of the subpipe
+ * @param burst burst budget in octets, 0 for 10 ms worth of rate
+ * @return an error code
+ */
+static inline int upipe_shaper_sub_set_burst(struct upipe *upipe,
+                                             uint64_t burst)
+{
+    return upipe_control(upipe, UPIPE_SHAPER_SET_BURST,
+                         UPIPE_SHAPER_SUB_SIGNATURE, burst);
+}
+
+/** @This gets the burst budget of a flow.
+ *
+ * @param upipe description structure of the subpipe
+ * @param burst_p filled with the burst budget in octets
+ * @return an error code
+ */
+static inline int upipe_shaper_sub_get_burst(struct upipe *upipe,
+                                             uint64_t *burst_p)
+{
+    return upipe_control(upipe, UPIPE_SHAPER_GET_BURST,
+                         UPIPE_SHAPER_SUB_SIGNATURE, burst_p);
+}
+
+/** @This returns the management structure for all shaper pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_shaper_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
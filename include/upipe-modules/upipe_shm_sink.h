@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe sink module passing block urefs to another process through
+ * shared memory
+ * The sink creates a shared memory segment named after the URI given to
+ * @ref upipe_set_uri. Upstream pipes asking for a block ubuf manager get
+ * one allocating in the segment, so that their buffers are passed to the
+ * @ref upipe_shm_src of the other process without being copied; other
+ * buffers are copied into the segment. If the ring of the segment is full,
+ * urefs are dropped.
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_SHM_SINK_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_SHM_SINK_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_SHM_SINK_SIGNATURE UBASE_FOURCC('s','h','m','k')
+
+/** @This extends upipe_command with specific commands for shm sink. */
+enum upipe_shm_sink_command {
+    UPIPE_SHM_SINK_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets the geometry of the segment (size_t, unsigned int,
+     * unsigned int) */
+    UPIPE_SHM_SINK_SET_ARENA,
+    /** returns the number of dropped urefs (uint64_t *) */
+    UPIPE_SHM_SINK_GET_DROPPED
+};
+
+/** @This returns the management structure for shm sinks.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_shm_sink_mgr_alloc(void);
+
+/** @This sets the geometry of the segment created by the next call to
+ * @ref upipe_set_uri.
+ *
+ * @param upipe description structure of the pipe
+ * @param slot_size size of a buffer slot in octets
+ * @param nb_slots number of buffer slots
+ * @param ring_length maximum number of urefs waiting for the source
+ * @return an error code
+ */
+static inline int upipe_shm_sink_set_arena(struct upipe *upipe,
+                                           size_t slot_size,
+                                           unsigned int nb_slots,
+                                           unsigned int ring_length)
+{
+    return upipe_control(upipe, UPIPE_SHM_SINK_SET_ARENA,
+                         UPIPE_SHM_SINK_SIGNATURE, slot_size, nb_slots,
+                         ring_length);
+}
+
+/** @This returns the number of urefs dropped because the source didn't keep
+ * up or the segment was exhausted.
+ *
+ * @param upipe description structure of the pipe
+ * @param dropped_p filled in with the number of dropped urefs
+ * @return an error code
+ */
+static inline int upipe_shm_sink_get_dropped(struct upipe *upipe,
+                                             uint64_t *dropped_p)
+{
+    return upipe_control(upipe, UPIPE_SHM_SINK_GET_DROPPED,
+                         UPIPE_SHM_SINK_SIGNATURE, dropped_p);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe source module receiving block urefs from another process
+ * through shared memory
+ * The source attaches the shared memory segment created by a
+ * @ref upipe_shm_sink, named after the URI given to @ref upipe_set_uri,
+ * and polls its ring at a regular interval. Output buffers point directly
+ * to the segment.
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_SHM_SOURCE_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_SHM_SOURCE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_SHM_SRC_SIGNATURE UBASE_FOURCC('s','h','m','s')
+
+/** @This extends upipe_command with specific commands for shm source. */
+enum upipe_shm_src_command {
+    UPIPE_SHM_SRC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets the polling interval (uint64_t) */
+    UPIPE_SHM_SRC_SET_INTERVAL,
+    /** returns the polling interval (uint64_t *) */
+    UPIPE_SHM_SRC_GET_INTERVAL
+};
+
+/** @This returns the management structure for shm sources.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_shm_src_mgr_alloc(void);
+
+/** @This sets the interval at which the ring is polled.
+ *
+ * @param upipe description structure of the pipe
+ * @param interval polling interval in 27 MHz ticks
+ * @return an error code
+ */
+static inline int upipe_shm_src_set_interval(struct upipe *upipe,
+                                             uint64_t interval)
+{
+    return upipe_control(upipe, UPIPE_SHM_SRC_SET_INTERVAL,
+                         UPIPE_SHM_SRC_SIGNATURE, interval);
+}
+
+/** @This returns the interval at which the ring is polled.
+ *
+ * @param upipe description structure of the pipe
+ * @param interval_p filled in with the polling interval in 27 MHz ticks
+ * @return an error code
+ */
+static inline int upipe_shm_src_get_interval(struct upipe *upipe,
+                                             uint64_t *interval_p)
+{
+    return upipe_control(upipe, UPIPE_SHM_SRC_GET_INTERVAL,
+                         UPIPE_SHM_SRC_SIGNATURE, interval_p);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -62,12 +62,36 @@ static inline const char *uprobe_stream_switcher_sub_event_str(int event)
     return NULL;
 }
 
+/** @This extends upipe_command with specific commands for stream switcher. */
+enum upipe_stream_switcher_command {
+    UPIPE_STREAM_SWITCHER_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** enable or disable splicing of unrelated inputs (int) */
+    UPIPE_STREAM_SWITCHER_SET_SPLICE,
+};
+
 /** @This returns the management structure for all stream switchers.
  *
  * @return pointer to manager
  */
 struct upipe_mgr *upipe_stream_switcher_mgr_alloc(void);
 
+/** @This enables or disables splice mode. In splice mode the inputs are not
+ * expected to share the same timeline: the selected input is left on its
+ * next random access point once the waiting input has reached one, and the
+ * timestamps of the new input are rebased to follow the last output frame.
+ *
+ * @param upipe description structure of the pipe
+ * @param splice true to enable splice mode
+ * @return an error code
+ */
+static inline int upipe_stream_switcher_set_splice(struct upipe *upipe,
+                                                   bool splice)
+{
+    return upipe_control(upipe, UPIPE_STREAM_SWITCHER_SET_SPLICE,
+                         UPIPE_STREAM_SWITCHER_SIGNATURE, splice ? 1 : 0);
+}
+
 #ifdef __cplusplus
 }
 #endif
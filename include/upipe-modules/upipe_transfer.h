@@ -81,7 +81,19 @@ enum upipe_xfer_mgr_command {
     /** freeze the remote event loop (void) */
     UPIPE_XFER_MGR_FREEZE,
     /** thaw the remote event loop (void) */
-    UPIPE_XFER_MGR_THAW
+    UPIPE_XFER_MGR_THAW,
+    /** sets the wait policy of the remote event loop on an empty command
+     * queue (uint64_t, unsigned int) */
+    UPIPE_XFER_MGR_SET_WAIT_POLICY,
+    /** returns the number of live xfer pipes (unsigned int *) */
+    UPIPE_XFER_MGR_GET_LOAD,
+    /** returns the manager on which to allocate a new set of pipes
+     * (struct upipe_mgr **) */
+    UPIPE_XFER_MGR_SELECT,
+    /** starts coalescing commands (void) */
+    UPIPE_XFER_MGR_START_BATCH,
+    /** sends the coalesced commands (void) */
+    UPIPE_XFER_MGR_END_BATCH
 };
 
 /** @This returns a management structure for xfer pipes. You would need one
@@ -145,6 +157,88 @@ static inline int upipe_xfer_mgr_thaw(struct upipe_mgr *mgr)
     return upipe_mgr_control(mgr, UPIPE_XFER_MGR_THAW, UPIPE_XFER_SIGNATURE);
 }
 
+/** @This sets the policy of the remote event loop when it finds the queue
+ * of commands empty: it busy-polls the queue for the given time, then yields
+ * the CPU the given number of times, and only then blocks on the eventfd.
+ * This trades CPU time for lower wakeup jitter of the remote thread. It may
+ * be called from any thread.
+ *
+ * @param mgr xfer_mgr structure
+ * @param spin time (in 27 MHz ticks, at most one second) to busy-poll
+ * @param yields number of times to yield the CPU
+ * @return an error code
+ */
+static inline int upipe_xfer_mgr_set_wait_policy(struct upipe_mgr *mgr,
+                                                 uint64_t spin,
+                                                 unsigned int yields)
+{
+    return upipe_mgr_control(mgr, UPIPE_XFER_MGR_SET_WAIT_POLICY,
+                             UPIPE_XFER_SIGNATURE, spin, yields);
+}
+
+/** @This returns the number of xfer pipes currently allocated on the
+ * manager, which is used as an estimate of the load of the remote event loop.
+ *
+ * @param mgr xfer_mgr structure
+ * @param load_p filled in with the number of pipes
+ * @return an error code
+ */
+static inline int upipe_xfer_mgr_get_load(struct upipe_mgr *mgr,
+                                          unsigned int *load_p)
+{
+    return upipe_mgr_control(mgr, UPIPE_XFER_MGR_GET_LOAD,
+                             UPIPE_XFER_SIGNATURE, load_p);
+}
+
+/** @This returns the manager on which a new set of pipes, which must run in
+ * the same event loop, should be allocated. A plain xfer manager returns
+ * itself, whereas a pool of event loops returns its least loaded member.
+ *
+ * @param mgr xfer_mgr structure
+ * @param xfer_mgr_p filled in with a new reference to the selected manager
+ * @return an error code
+ */
+static inline int upipe_xfer_mgr_select(struct upipe_mgr *mgr,
+                                        struct upipe_mgr **xfer_mgr_p)
+{
+    return upipe_mgr_control(mgr, UPIPE_XFER_MGR_SELECT,
+                             UPIPE_XFER_SIGNATURE, xfer_mgr_p);
+}
+
+/** @This starts coalescing the commands sent to the remote pipes (such as
+ * @ref upipe_attach_upump_mgr, @ref upipe_set_output and the releases of
+ * xfer pipes) into a single message, which is sent by
+ * @ref upipe_xfer_mgr_end_batch. This is typically used around the
+ * allocation or the teardown of many pipes, to avoid waking up the remote
+ * thread for each of them. Batches may be nested.
+ *
+ * The batch is shared by all the threads sending commands to the manager, so
+ * commands sent by other threads while it is open are also delayed until it
+ * is ended.
+ *
+ * @param mgr xfer_mgr structure
+ * @return an error code
+ */
+static inline int upipe_xfer_mgr_start_batch(struct upipe_mgr *mgr)
+{
+    return upipe_mgr_control(mgr, UPIPE_XFER_MGR_START_BATCH,
+                             UPIPE_XFER_SIGNATURE);
+}
+
+/** @This ends a batch started by @ref upipe_xfer_mgr_start_batch and sends
+ * the coalesced commands when the outermost batch is ended. If the queue is
+ * full, the commands are kept and the call may be retried; they are also sent
+ * before the next command, which fails if the queue is still full.
+ *
+ * @param mgr xfer_mgr structure
+ * @return an error code
+ */
+static inline int upipe_xfer_mgr_end_batch(struct upipe_mgr *mgr)
+{
+    return upipe_mgr_control(mgr, UPIPE_XFER_MGR_END_BATCH,
+                             UPIPE_XFER_SIGNATURE);
+}
+
 /** @hidden */
 #define ARGS_DECL , struct upipe *upipe_remote
 /** @hidden */
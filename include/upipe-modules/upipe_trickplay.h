@@ -46,7 +46,13 @@ enum upipe_trickp_command {
     /** returns the current playing rate (struct urational *) */
     UPIPE_TRICKP_GET_RATE,
     /** sets the playing rate (struct urational) */
-    UPIPE_TRICKP_SET_RATE
+    UPIPE_TRICKP_SET_RATE,
+    /** returns the rate above which only key pictures are output
+     * (struct urational *) */
+    UPIPE_TRICKP_GET_KEYFRAME_RATE,
+    /** sets the rate above which only key pictures are output
+     * (struct urational) */
+    UPIPE_TRICKP_SET_KEYFRAME_RATE
 };
 
 /** @This returns the management structure for all trickp pipes.
@@ -81,6 +87,36 @@ static inline int upipe_trickp_set_rate(struct upipe *upipe,
                          UPIPE_TRICKP_SIGNATURE, rate);
 }
 
+/** @This returns the rate above which only random access pictures are
+ * output.
+ *
+ * @param upipe description structure of the pipe
+ * @param rate_p filled with the rate (0 = disabled)
+ * @return an error code
+ */
+static inline int upipe_trickp_get_keyframe_rate(struct upipe *upipe,
+                                                 struct urational *rate_p)
+{
+    return upipe_control(upipe, UPIPE_TRICKP_GET_KEYFRAME_RATE,
+                         UPIPE_TRICKP_SIGNATURE, rate_p);
+}
+
+/** @This sets the rate above which only random access pictures are output.
+ * When the playing rate is strictly greater, pictures without the random
+ * flag are skipped in the compressed domain, before they reach the decoder,
+ * so that fast forward only decodes key frames. It is disabled by default.
+ *
+ * @param upipe description structure of the pipe
+ * @param rate new rate (for instance 4/1, 0 = disabled)
+ * @return an error code
+ */
+static inline int upipe_trickp_set_keyframe_rate(struct upipe *upipe,
+                                                 struct urational rate)
+{
+    return upipe_control(upipe, UPIPE_TRICKP_SET_KEYFRAME_RATE,
+                         UPIPE_TRICKP_SIGNATURE, rate);
+}
+
 #ifdef __cplusplus
 }
 #endif
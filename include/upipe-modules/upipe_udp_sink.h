@@ -51,6 +51,26 @@ enum upipe_udpsink_command {
     UPIPE_UDPSINK_SET_FD,
     /** set remote address (const struct sockaddr *, socklen_t) **/
     UPIPE_UDPSINK_SET_PEER,
+    /** get batch mode parameters (unsigned int *, uint64_t *) **/
+    UPIPE_UDPSINK_GET_BATCH,
+    /** set batch mode parameters (unsigned int, uint64_t) **/
+    UPIPE_UDPSINK_SET_BATCH,
+    /** enable or disable segmentation offload (int) **/
+    UPIPE_UDPSINK_SET_GSO,
+    /** set kernel pacing parameters (int, uint64_t) **/
+    UPIPE_UDPSINK_SET_TXTIME,
+    /** set the maximum pacing rate (uint64_t) **/
+    UPIPE_UDPSINK_SET_PACING_RATE,
+    /** enable or disable PCR restamping at launch time (int) **/
+    UPIPE_UDPSINK_SET_PCR_RESTAMP,
+    /** set the burst rate when a receiver joins (uint64_t) **/
+    UPIPE_UDPSINK_SET_BURST,
+    /** add a destination (const struct sockaddr *, socklen_t) **/
+    UPIPE_UDPSINK_ADD_PEER,
+    /** remove a destination (const struct sockaddr *, socklen_t) **/
+    UPIPE_UDPSINK_DEL_PEER,
+    /** get the number of destinations (unsigned int *) **/
+    UPIPE_UDPSINK_GET_PEERS,
 };
 
 /** @This returns the management structure for all udp sinks.
@@ -96,6 +116,175 @@ static inline int upipe_udpsink_set_peer(struct upipe *upipe,
     return upipe_control(upipe, UPIPE_UDPSINK_SET_PEER, UPIPE_UDPSINK_SIGNATURE,
             addr, addrlen);
 }
+
+/** @This adds a destination to an unconnected socket. When destinations
+ * are added, each datagram is sent to all of them with a single sendmmsg()
+ * call, and the remote address set by @ref upipe_udpsink_set_peer is
+ * ignored. Destinations may be added and removed at any time.
+ *
+ * @param upipe description structure of the pipe
+ * @param addr the remote address
+ * @param addrlen the size of addr
+ * @return an error code
+ */
+static inline int upipe_udpsink_add_peer(struct upipe *upipe,
+        const struct sockaddr *addr, socklen_t addrlen)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_ADD_PEER, UPIPE_UDPSINK_SIGNATURE,
+            addr, addrlen);
+}
+
+/** @This removes a destination added by @ref upipe_udpsink_add_peer.
+ *
+ * @param upipe description structure of the pipe
+ * @param addr the remote address
+ * @param addrlen the size of addr
+ * @return an error code
+ */
+static inline int upipe_udpsink_del_peer(struct upipe *upipe,
+        const struct sockaddr *addr, socklen_t addrlen)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_DEL_PEER, UPIPE_UDPSINK_SIGNATURE,
+            addr, addrlen);
+}
+
+/** @This returns the number of destinations added by
+ * @ref upipe_udpsink_add_peer.
+ *
+ * @param upipe description structure of the pipe
+ * @param nb_p filled in with the number of destinations
+ * @return an error code
+ */
+static inline int upipe_udpsink_get_peers(struct upipe *upipe,
+                                          unsigned int *nb_p)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_GET_PEERS,
+                         UPIPE_UDPSINK_SIGNATURE, nb_p);
+}
+
+/** @This gets the batch mode parameters.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_size_p filled in with the maximum number of datagrams sent
+ * at once
+ * @param window_p filled in with the batch window, in 27 MHz units
+ * @return an error code
+ */
+static inline int upipe_udpsink_get_batch(struct upipe *upipe,
+                                          unsigned int *batch_size_p,
+                                          uint64_t *window_p)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_GET_BATCH,
+                         UPIPE_UDPSINK_SIGNATURE, batch_size_p, window_p);
+}
+
+/** @This sets the batch mode parameters. When the batch size is greater
+ * than 1, the held datagrams are sent with a single sendmmsg() call. In live
+ * mode, only the held datagrams that are due within the given window are
+ * sent along with the current one, so that pacing is preserved.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_size maximum number of datagrams sent at once (1 disables
+ * batching)
+ * @param window held datagrams due within this delay (in 27 MHz units) are
+ * sent early
+ * @return an error code
+ */
+static inline int upipe_udpsink_set_batch(struct upipe *upipe,
+                                          unsigned int batch_size,
+                                          uint64_t window)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_SET_BATCH,
+                         UPIPE_UDPSINK_SIGNATURE, batch_size, window);
+}
+
+/** @This enables UDP generic segmentation offload (UDP_SEGMENT) in batch
+ * mode. Consecutive datagrams of the same size are then handed to the kernel
+ * in a single write. Segmentation offload is disabled automatically if the
+ * kernel does not support it.
+ *
+ * @param upipe description structure of the pipe
+ * @param enable true to enable segmentation offload
+ * @return an error code
+ */
+static inline int upipe_udpsink_set_gso(struct upipe *upipe, bool enable)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_SET_GSO,
+                         UPIPE_UDPSINK_SIGNATURE, enable ? 1 : 0);
+}
+
+/** @This enables kernel pacing in live mode. Instead of waking up for each
+ * datagram, the sink hands the datagrams due within the given horizon to the
+ * kernel in batches, each with its launch time (SO_TXTIME), so that the fq or
+ * etf qdisc sends them at the right microsecond. The clock must be the one
+ * expected by the qdisc, typically CLOCK_MONOTONIC for fq and CLOCK_TAI for
+ * etf. If the kernel doesn't support launch times, the socket is
+ * rate-limited by the fq qdisc instead (SO_MAX_PACING_RATE), to the rate set
+ * by @ref upipe_udpsink_set_pacing_rate or slightly above the octetrate of
+ * the flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param clockid clock of the launch times
+ * @param horizon datagrams due within this delay (in 27 MHz units) are handed
+ * to the kernel (0 disables kernel pacing)
+ * @return an error code
+ */
+static inline int upipe_udpsink_set_txtime(struct upipe *upipe,
+                                           clockid_t clockid,
+                                           uint64_t horizon)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_SET_TXTIME,
+                         UPIPE_UDPSINK_SIGNATURE, (int)clockid, horizon);
+}
+
+/** @This sets the maximum pacing rate of the socket. It is enforced by the
+ * fq qdisc.
+ *
+ * @param upipe description structure of the pipe
+ * @param rate maximum rate in octets per second (0 to use the octetrate of
+ * the flow definition when pacing)
+ * @return an error code
+ */
+static inline int upipe_udpsink_set_pacing_rate(struct upipe *upipe,
+                                                uint64_t rate)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_SET_PACING_RATE,
+                         UPIPE_UDPSINK_SIGNATURE, rate);
+}
+
+/** @This enables or disables the restamping of the PCRs of TS datagrams,
+ * right before they are sent. The PCRs are shifted by the difference between
+ * the launch time of the datagram (the time given to the kernel when pacing
+ * with launch times, or the time of the system call otherwise) and the date
+ * it was muxed for, which removes the jitter introduced by late scheduling.
+ * It requires a uclock.
+ *
+ * @param upipe description structure of the pipe
+ * @param enable true to restamp the PCRs
+ * @return an error code
+ */
+static inline int upipe_udpsink_set_pcr_restamp(struct upipe *upipe,
+                                                bool enable)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_SET_PCR_RESTAMP,
+                         UPIPE_UDPSINK_SIGNATURE, enable ? 1 : 0);
+}
+
+/** @This enables burst on join in live mode. When the socket is opened or
+ * its peer changes, late datagrams, such as the cached stream replayed by
+ * a gop cache pipe, are not dropped but sent at the given rate until the
+ * sink catches up with the dates of the live stream.
+ *
+ * @param upipe description structure of the pipe
+ * @param rate burst rate in octets per second (0 disables bursts)
+ * @return an error code
+ */
+static inline int upipe_udpsink_set_burst(struct upipe *upipe, uint64_t rate)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_SET_BURST,
+                         UPIPE_UDPSINK_SIGNATURE, rate);
+}
+
 #ifdef __cplusplus
 }
 #endif
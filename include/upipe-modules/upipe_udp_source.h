@@ -47,6 +47,16 @@ enum upipe_udpsrc_command {
     UPIPE_UDPSRC_GET_FD,
     /** set socket fd (int) **/
     UPIPE_UDPSRC_SET_FD,
+    /** get the maximum number of datagrams read per wakeup
+     * (unsigned int *) **/
+    UPIPE_UDPSRC_GET_BATCH_SIZE,
+    /** set the maximum number of datagrams read per wakeup (unsigned int) **/
+    UPIPE_UDPSRC_SET_BATCH_SIZE,
+    /** get the bitmap of wanted TS PIDs (const uint8_t **) **/
+    UPIPE_UDPSRC_GET_PID_FILTER,
+    /** set the bitmap of wanted TS PIDs (const uint8_t *,
+     * struct urefcount *) **/
+    UPIPE_UDPSRC_SET_PID_FILTER,
 };
 
 /** @This extends uprobe_throw with specific events . */
@@ -81,6 +91,70 @@ static inline int upipe_udpsrc_set_fd(struct upipe *upipe, int fd)
                          fd);
 }
 
+/** @This returns the maximum number of datagrams read per wakeup.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_size_p filled in with the maximum number of datagrams
+ * @return an error code
+ */
+static inline int upipe_udpsrc_get_batch_size(struct upipe *upipe,
+                                              unsigned int *batch_size_p)
+{
+    return upipe_control(upipe, UPIPE_UDPSRC_GET_BATCH_SIZE,
+                         UPIPE_UDPSRC_SIGNATURE, batch_size_p);
+}
+
+/** @This sets the maximum number of datagrams read per wakeup. When greater
+ * than 1, the datagrams are read with a single recvmmsg() call into buffers
+ * that are pre-allocated from the ubuf manager, and each datagram is dated
+ * with its kernel reception timestamp if available.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_size maximum number of datagrams (1 disables batching)
+ * @return an error code
+ */
+static inline int upipe_udpsrc_set_batch_size(struct upipe *upipe,
+                                              unsigned int batch_size)
+{
+    return upipe_control(upipe, UPIPE_UDPSRC_SET_BATCH_SIZE,
+                         UPIPE_UDPSRC_SIGNATURE, batch_size);
+}
+
+/** @This returns the bitmap of wanted TS PIDs.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid_filter_p filled in with the bitmap, or NULL
+ * @return an error code
+ */
+static inline int upipe_udpsrc_get_pid_filter(struct upipe *upipe,
+                                              const uint8_t **pid_filter_p)
+{
+    return upipe_control(upipe, UPIPE_UDPSRC_GET_PID_FILTER,
+                         UPIPE_UDPSRC_SIGNATURE, pid_filter_p);
+}
+
+/** @This sets a bitmap of wanted TS PIDs, with bit (pid & 7) of octet
+ * (pid >> 3) set for each wanted PID, typically the one returned by
+ * upipe_ts_split_get_pid_filter. The TS packets of the other PIDs are dropped
+ * from the received datagrams before any uref is output, and datagrams
+ * which end up empty are not output at all. Datagrams which are not made of
+ * whole TS packets are not filtered. The bitmap is not copied; a reference
+ * is held on its owner until the filter is replaced or the pipe is released.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid_filter bitmap of 8192 bits, or NULL to disable filtering
+ * @param owner refcount of the structure holding the bitmap, or NULL if the
+ * bitmap is static
+ * @return an error code
+ */
+static inline int upipe_udpsrc_set_pid_filter(struct upipe *upipe,
+                                              const uint8_t *pid_filter,
+                                              struct urefcount *owner)
+{
+    return upipe_control(upipe, UPIPE_UDPSRC_SET_PID_FILTER,
+                         UPIPE_UDPSRC_SIGNATURE, pid_filter, owner);
+}
+
 /** @This returns the management structure for all udp socket sources.
  *
  * @return pointer to manager
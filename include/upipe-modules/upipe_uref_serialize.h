@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module serializing urefs and their block buffers into a stream
+ *
+ * Each input uref becomes a frame made of a header, the uref serialized
+ * relatively to the previous uref with @ref uref_serial_encode, and its block
+ * buffer, which is appended by reference. The input flow definition is
+ * written as a frame before the first uref that follows it. The output is a
+ * "block.uref." flow that may be written to a file or sent over a socket.
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_UREF_SERIALIZE_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_UREF_SERIALIZE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_UREFSER_SIGNATURE UBASE_FOURCC('u','r','f','s')
+
+/** @This returns the management structure for uref serializer pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_urefser_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe pool of worker threads running linear subpipelines
+ *
+ * A pool holds one wlin manager per worker thread. Bin pipes keep a pool in
+ * their manager, pick the worker of each subpipeline in a round-robin
+ * fashion and wrap the subpipeline into a wlin pipe (see
+ * @ref upipe_worker_linear.h).
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_WORKER_POOL_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_WORKER_POOL_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/upipe.h>
+#include <upipe-modules/upipe_worker_linear.h>
+
+#include <stdarg.h>
+
+/** length of the queues between a pipe and its workers */
+#define UPIPE_WORK_POOL_QUEUE_LENGTH 255
+
+/** @This is a pool of worker threads. */
+struct upipe_work_pool {
+    /** number of worker threads */
+    unsigned int nb_workers;
+    /** array of wlin managers, one per worker thread */
+    struct upipe_mgr **workers;
+    /** probe hierarchy used in the worker threads */
+    struct uprobe *uprobe;
+    /** index of the worker for the next subpipeline */
+    unsigned int next_worker;
+};
+
+/** @This initializes an empty pool.
+ *
+ * @param pool pointer to the pool
+ */
+void upipe_work_pool_init(struct upipe_work_pool *pool);
+
+/** @This releases the workers of a pool.
+ *
+ * @param pool pointer to the pool
+ */
+void upipe_work_pool_clean(struct upipe_work_pool *pool);
+
+/** @This replaces the worker threads of a pool.
+ *
+ * @param pool pointer to the pool
+ * @param nb_workers number of worker threads, or 0 to disable
+ * @param xfer_mgrs array of xfer managers, one per worker thread
+ * @param uprobe_remote probe hierarchy to use in the worker threads
+ * @return an error code
+ */
+int upipe_work_pool_set(struct upipe_work_pool *pool, unsigned int nb_workers,
+                        struct upipe_mgr **xfer_mgrs,
+                        struct uprobe *uprobe_remote);
+
+/** @This processes a get workers command, with an unsigned int * argument
+ * following the signature.
+ *
+ * @param pool pointer to the pool
+ * @param args arguments of the command
+ * @return an error code
+ */
+int upipe_work_pool_get_workers_va(struct upipe_work_pool *pool,
+                                   va_list args);
+
+/** @This processes a set workers command, with unsigned int,
+ * struct upipe_mgr ** and struct uprobe * arguments following the
+ * signature.
+ *
+ * @param pool pointer to the pool
+ * @param args arguments of the command
+ * @return an error code
+ */
+int upipe_work_pool_set_workers_va(struct upipe_work_pool *pool,
+                                   va_list args);
+
+/** @This returns the wlin manager of the next worker thread, in a
+ * round-robin fashion.
+ *
+ * @param pool pointer to the pool
+ * @return pointer to the wlin manager, or NULL if the pool is empty
+ */
+static inline struct upipe_mgr *
+    upipe_work_pool_next(struct upipe_work_pool *pool)
+{
+    if (!pool->nb_workers)
+        return NULL;
+    return pool->workers[pool->next_worker++ % pool->nb_workers];
+}
+
+/** @This moves a subpipeline to a worker thread.
+ *
+ * @param worker_mgr wlin manager of the worker thread
+ * @param uprobe structure used to raise events by the wlin pipe
+ * @param remote subpipeline to run in the worker thread (belongs to the
+ * callee)
+ * @param uprobe_remote probe hierarchy to use in the worker thread (belongs
+ * to the callee)
+ * @return pointer to the wlin pipe, or NULL in case of error
+ */
+static inline struct upipe *
+    upipe_work_pool_alloc(struct upipe_mgr *worker_mgr, struct uprobe *uprobe,
+                          struct upipe *remote, struct uprobe *uprobe_remote)
+{
+    return upipe_wlin_alloc(worker_mgr, uprobe, remote, uprobe_remote,
+                            UPIPE_WORK_POOL_QUEUE_LENGTH,
+                            UPIPE_WORK_POOL_QUEUE_LENGTH);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -12,7 +12,78 @@ extern "C" {
 #include <upipe/upipe.h>
 
 #define UPIPE_NETMAP_SOURCE_SIGNATURE UBASE_FOURCC('n','t','m','s')
+#define UPIPE_NETMAP_SOURCE_OUTPUT_SIGNATURE UBASE_FOURCC('n','t','m','o')
+
+/** @This extends upipe_command with specific commands for netmap sources. */
+enum upipe_netmap_source_command {
+    UPIPE_NETMAP_SOURCE_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets the use of one transfer thread per ring (bool) */
+    UPIPE_NETMAP_SOURCE_SET_THREADS,
+    /** returns the bitmap of wanted TS PIDs (const uint8_t **) */
+    UPIPE_NETMAP_SOURCE_GET_PID_FILTER,
+    /** sets the bitmap of wanted TS PIDs (const uint8_t *,
+     * struct urefcount *) */
+    UPIPE_NETMAP_SOURCE_SET_PID_FILTER
+};
+
+/** @This sets whether each opened ring is read by its own transfer thread,
+ * instead of all rings being polled from the event loop of the pipe. The
+ * threads allocate buffers, so the uref and ubuf managers must be
+ * thread-safe (this is the case of the standard managers).
+ *
+ * @param upipe description structure of the pipe
+ * @param threads true to start one transfer thread per ring
+ * @return an error code
+ */
+static inline int upipe_netmap_source_set_threads(struct upipe *upipe,
+                                                  bool threads)
+{
+    return upipe_control(upipe, UPIPE_NETMAP_SOURCE_SET_THREADS,
+                         UPIPE_NETMAP_SOURCE_SIGNATURE, threads ? 1 : 0);
+}
+
+/** @This returns the bitmap of wanted TS PIDs.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid_filter_p filled in with the bitmap, or NULL
+ * @return an error code
+ */
+static inline int upipe_netmap_source_get_pid_filter(struct upipe *upipe,
+        const uint8_t **pid_filter_p)
+{
+    return upipe_control(upipe, UPIPE_NETMAP_SOURCE_GET_PID_FILTER,
+                         UPIPE_NETMAP_SOURCE_SIGNATURE, pid_filter_p);
+}
+
+/** @This sets a bitmap of wanted TS PIDs (see upipe/uts_filter.h). The TS
+ * packets of the other PIDs, null packets included, are removed from the
+ * received datagrams in the netmap buffers before any uref is allocated,
+ * and datagrams which end up empty are not output at all. The bitmap is not
+ * copied; a reference is held on its owner until the filter is replaced or
+ * the pipe is released. The transfer threads are stopped while the filter is
+ * replaced, and restarted afterwards.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid_filter bitmap of 8192 bits, or NULL to disable filtering
+ * @param owner refcount of the structure holding the bitmap, or NULL if the
+ * bitmap is static
+ * @return an error code
+ */
+static inline int upipe_netmap_source_set_pid_filter(struct upipe *upipe,
+        const uint8_t *pid_filter, struct urefcount *owner)
+{
+    return upipe_control(upipe, UPIPE_NETMAP_SOURCE_SET_PID_FILTER,
+                         UPIPE_NETMAP_SOURCE_SIGNATURE, pid_filter, owner);
+}
+
 /** @This returns the management structure for netmap_source pipes.
+ *
+ * The uri is of the form netmap:eth0-2/R to read a single hardware ring, or
+ * netmap:eth0 to read all the hardware receive rings of the interface.
+ * UDP datagrams are output on the output subpipe whose flow definition
+ * matches their destination address and port (see uref_netmap_flow.h), or
+ * on the output of the source pipe itself if there is none.
  *
  * @return pointer to manager
  */
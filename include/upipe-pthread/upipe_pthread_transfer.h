@@ -39,11 +39,59 @@ extern "C" {
 #include <upipe/uprobe.h>
 #include <upipe/upump.h>
 
+#include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <pthread.h>
 
 /** @hidden */
 struct umutex;
+/** @hidden */
+struct umem_mgr;
+
+/** @This stores the scheduling and memory options of a thread running an
+ * event loop, for pipes with latency constraints.
+ */
+struct upipe_pthread_attr {
+    /** CPUs to pin the thread to, in the cpulist format of isolcpus (for
+     * instance "2,4-7"), or NULL */
+    const char *cpus;
+    /** NUMA node to pin the thread to, if cpus is NULL, or -1 */
+    int node;
+    /** SCHED_FIFO priority of the thread, or 0 to keep the inherited
+     * scheduling policy */
+    int priority;
+    /** true to lock all current and future pages of the process in memory */
+    bool mlock;
+    /** octets of stack to fault in before running the event loop */
+    size_t prefault_stack;
+    /** true to fill the upump pool of the event loop before running it */
+    bool prefault_pools;
+    /** memory manager whose buffers are faulted in from the thread, or NULL */
+    struct umem_mgr *umem_mgr;
+    /** size of the buffers to fault in */
+    size_t umem_size;
+    /** number of buffers to fault in */
+    unsigned int umem_nb;
+};
+
+/** @This initializes the options of a thread to the defaults, which don't
+ * change the attributes given to pthread_create.
+ *
+ * @param attr options of the thread
+ */
+static inline void upipe_pthread_attr_init(struct upipe_pthread_attr *attr)
+{
+    attr->cpus = NULL;
+    attr->node = -1;
+    attr->priority = 0;
+    attr->mlock = false;
+    attr->prefault_stack = 0;
+    attr->prefault_pools = false;
+    attr->umem_mgr = NULL;
+    attr->umem_size = 0;
+    attr->umem_nb = 0;
+}
 
 /** @This returns a management structure for transfer pipes, using a new
  * pthread. You would need one management structure per target thread.
@@ -67,6 +115,91 @@ struct upipe_mgr *upipe_pthread_xfer_mgr_alloc(uint8_t queue_length,
         uint16_t upump_blocker_pool_depth, struct umutex *mutex,
         pthread_t *pthread_id_p, const pthread_attr_t *restrict attr);
 
+/** @This returns a management structure for transfer pipes, using a new
+ * pthread pinned to a CPU or to the CPUs of a NUMA node. The thread is pinned
+ * before its event loop is allocated, so that combined with
+ * @ref uprobe_ubuf_mem_pool_set_node, the pipes it runs allocate node-local
+ * buffers.
+ *
+ * @param queue_length maximum length of the internal queue of commands
+ * @param msg_pool_depth maximum number of messages in the pool
+ * @param uprobe_pthread_upump_mgr pointer to optional probe, that will be set
+ * with the created upump_mgr
+ * @param upump_mgr_alloc alloc function provided by the upump manager
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @param mutex mutual exclusion pimitives to access the event loop, or NULL
+ * @param pthread_id_p reference to created thread ID (may be NULL)
+ * @param attr pthread attributes
+ * @param cpu CPU to pin the thread to, or -1
+ * @param node NUMA node to pin the thread to, if cpu is -1, or -1
+ * @return pointer to xfer manager
+ */
+struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_affinity(uint8_t queue_length,
+        uint16_t msg_pool_depth, struct uprobe *uprobe_pthread_upump_mgr,
+        upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
+        uint16_t upump_blocker_pool_depth, struct umutex *mutex,
+        pthread_t *pthread_id_p, const pthread_attr_t *restrict attr,
+        int cpu, int node);
+
+/** @This returns a management structure for transfer pipes, using a new
+ * pthread configured with the given options. The thread is pinned, and its
+ * pages are locked and faulted in, before its event loop runs; failing to
+ * apply an option at run time (for lack of privileges) only throws a
+ * warning.
+ *
+ * @param queue_length maximum length of the internal queue of commands
+ * @param msg_pool_depth maximum number of messages in the pool
+ * @param uprobe_pthread_upump_mgr pointer to optional probe, that will be set
+ * with the created upump_mgr
+ * @param upump_mgr_alloc alloc function provided by the upump manager
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @param mutex mutual exclusion pimitives to access the event loop, or NULL
+ * @param pthread_id_p reference to created thread ID (may be NULL)
+ * @param attr pthread attributes
+ * @param pthread_attr options of the thread (see @ref upipe_pthread_attr_init)
+ * @return pointer to xfer manager, or NULL in case of error or invalid
+ * options
+ */
+struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_attr(uint8_t queue_length,
+        uint16_t msg_pool_depth, struct uprobe *uprobe_pthread_upump_mgr,
+        upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
+        uint16_t upump_blocker_pool_depth, struct umutex *mutex,
+        pthread_t *pthread_id_p, const pthread_attr_t *restrict attr,
+        const struct upipe_pthread_attr *pthread_attr);
+
+/** @This returns a management structure for transfer pipes, backed by a pool
+ * of new pthreads each running an event loop. Sets of pipes which must run in
+ * the same event loop, such as the inner pipes of a worker, are placed
+ * together on the thread having the fewest live xfer pipes (see
+ * @ref upipe_xfer_mgr_select), so that a single pool may be shared by all
+ * the @ref upipe_work_mgr_alloc managers of an application. Pipes allocated
+ * directly on the pool are placed individually. The remote event loops
+ * cannot be frozen.
+ *
+ * @param nb_threads number of threads in the pool
+ * @param queue_length maximum length of the internal queue of commands
+ * @param msg_pool_depth maximum number of messages in the pool
+ * @param uprobe_pthread_upump_mgr pointer to optional probe, that will be set
+ * with the created upump_mgr of each thread
+ * @param upump_mgr_alloc alloc function provided by the upump manager
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @param attr pthread attributes
+ * @param pin true to pin the n-th thread to the n-th CPU
+ * @return pointer to xfer manager
+ */
+struct upipe_mgr *upipe_pthread_xfer_pool_alloc(unsigned int nb_threads,
+        uint8_t queue_length, uint16_t msg_pool_depth,
+        struct uprobe *uprobe_pthread_upump_mgr,
+        upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
+        uint16_t upump_blocker_pool_depth, const pthread_attr_t *restrict attr,
+        bool pin);
+
 #ifdef __cplusplus
 }
 #endif
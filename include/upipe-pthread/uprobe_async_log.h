@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short probe logging messages asynchronously from a dedicated thread
+ *
+ * Log events are formatted in the thread throwing them, into a ring
+ * buffer owned by this thread, and written to the stream in batches by a
+ * logger thread. Throwing threads never block: messages are dropped and
+ * counted when their ring is full.
+ */
+
+#ifndef _UPIPE_PTHREAD_UPROBE_ASYNC_LOG_H_
+/** @hidden */
+#define _UPIPE_PTHREAD_UPROBE_ASYNC_LOG_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/uatomic.h>
+#include <upipe/ulist.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_helper_uprobe.h>
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/** @This is the maximum size of a formatted message, longer messages are
+ * truncated. */
+#define UPROBE_ASYNC_LOG_MSG_SIZE 256
+
+/** @This is a super-set of the uprobe structure with additional local
+ * members. */
+struct uprobe_async_log {
+    /** file stream to write to */
+    FILE *stream;
+    /** minimum level of printed messages */
+    enum uprobe_log_level min_level;
+    /** number of messages in each ring (power of 2) */
+    unsigned int ring_size;
+
+    /** key to the ring of the current thread */
+    pthread_key_t key;
+    /** mutex protecting the list of rings and the logger state */
+    pthread_mutex_t mutex;
+    /** condition to wake up the logger thread */
+    pthread_cond_t cond;
+    /** list of rings of all threads */
+    struct uchain rings;
+    /** true if the logger thread must exit */
+    bool stop;
+    /** logger thread */
+    pthread_t thread;
+    /** number of messages dropped */
+    uatomic_uint32_t dropped;
+    /** number of dropped messages already reported */
+    uint32_t reported;
+
+    /** structure exported to modules */
+    struct uprobe uprobe;
+};
+
+UPROBE_HELPER_UPROBE(uprobe_async_log, uprobe)
+
+/** @This initializes an already allocated uprobe_async_log structure, and
+ * starts the logger thread.
+ *
+ * @param uprobe_async_log pointer to the already allocated structure
+ * @param next next probe to test if this one doesn't catch the event
+ * @param stream stdio stream to which to log the messages
+ * @param min_level level at which to log the messages
+ * @param ring_size number of messages buffered per thread
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_async_log_init(struct uprobe_async_log *uprobe_async_log,
+                                     struct uprobe *next, FILE *stream,
+                                     enum uprobe_log_level min_level,
+                                     unsigned int ring_size);
+
+/** @This stops the logger thread after it has written all pending messages,
+ * and cleans a uprobe_async_log structure.
+ *
+ * @param uprobe_async_log structure to clean
+ */
+void uprobe_async_log_clean(struct uprobe_async_log *uprobe_async_log);
+
+/** @This allocates a new uprobe_async_log structure.
+ *
+ * @param next next probe to test if this one doesn't catch the event
+ * @param stream stdio stream to which to log the messages
+ * @param min_level level at which to log the messages
+ * @param ring_size number of messages buffered per thread
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_async_log_alloc(struct uprobe *next, FILE *stream,
+                                      enum uprobe_log_level min_level,
+                                      unsigned int ring_size);
+
+/** @This waits until all the messages logged so far have been written.
+ *
+ * @param uprobe pointer to probe
+ */
+void uprobe_async_log_flush(struct uprobe *uprobe);
+
+/** @This returns the number of messages dropped because a ring was full.
+ *
+ * @param uprobe pointer to probe
+ * @return number of dropped messages
+ */
+unsigned int uprobe_async_log_get_dropped(struct uprobe *uprobe);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -38,6 +38,47 @@ extern "C" {
 
 #define UPIPE_SPEEXDSP_SIGNATURE UBASE_FOURCC('s','p','x','d')
 
+/** @This extends upipe_command with specific commands for speexdsp pipes. */
+enum upipe_speexdsp_command {
+    UPIPE_SPEEXDSP_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the default drift rate (struct urational *) */
+    UPIPE_SPEEXDSP_GET_DRIFT_RATE,
+    /** sets the default drift rate (struct urational) */
+    UPIPE_SPEEXDSP_SET_DRIFT_RATE,
+};
+
+/** @This returns the drift rate applied to buffers that do not carry
+ * their own rate attribute.
+ *
+ * @param upipe description structure of the pipe
+ * @param drift_rate_p filled in with the drift rate
+ * @return an error code
+ */
+static inline int upipe_speexdsp_get_drift_rate(struct upipe *upipe,
+                                                struct urational *drift_rate_p)
+{
+    return upipe_control(upipe, UPIPE_SPEEXDSP_GET_DRIFT_RATE,
+                         UPIPE_SPEEXDSP_SIGNATURE, drift_rate_p);
+}
+
+/** @This sets the drift rate applied to buffers that do not carry their
+ * own rate attribute. A rate of num/den outputs num samples for den input
+ * samples, so that a sink or a synchronizer can slave the resampler to its
+ * clock with ppm-sized steps. The change is applied on the next buffer
+ * without flushing the filter history.
+ *
+ * @param upipe description structure of the pipe
+ * @param drift_rate drift rate
+ * @return an error code
+ */
+static inline int upipe_speexdsp_set_drift_rate(struct upipe *upipe,
+                                                struct urational drift_rate)
+{
+    return upipe_control(upipe, UPIPE_SPEEXDSP_SET_DRIFT_RATE,
+                         UPIPE_SPEEXDSP_SIGNATURE, drift_rate);
+}
+
 /** @This returns the management structure for speexdsp pipes.
  *
  * @return pointer to manager
@@ -38,6 +38,47 @@ extern "C" {
 
 #define UPIPE_SWR_SIGNATURE UBASE_FOURCC('s','w','r',' ')
 
+/** @This extends upipe_command with specific commands for swr pipes. */
+enum upipe_swr_command {
+    UPIPE_SWR_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets the number of samples per output block (unsigned int) */
+    UPIPE_SWR_SET_BLOCK_SIZE,
+    /** returns the number of samples per output block (unsigned int *) */
+    UPIPE_SWR_GET_BLOCK_SIZE
+};
+
+/** @This sets the number of samples per output block. When it is not 0, the
+ * converted samples of consecutive urefs are written into a single output
+ * ubuf of that size, which is output when the samples of the next uref
+ * don't fit anymore. This amortises the allocation of ubufs, and the
+ * processing of urefs by the downstream pipes, at the cost of latency. The
+ * default is 0, outputting one uref per input uref.
+ *
+ * @param upipe description structure of the pipe
+ * @param block_size number of samples per output block, or 0
+ * @return an error code
+ */
+static inline int upipe_swr_set_block_size(struct upipe *upipe,
+                                           unsigned int block_size)
+{
+    return upipe_control(upipe, UPIPE_SWR_SET_BLOCK_SIZE,
+                         UPIPE_SWR_SIGNATURE, block_size);
+}
+
+/** @This returns the number of samples per output block.
+ *
+ * @param upipe description structure of the pipe
+ * @param block_size_p filled in with the number of samples per output block
+ * @return an error code
+ */
+static inline int upipe_swr_get_block_size(struct upipe *upipe,
+                                           unsigned int *block_size_p)
+{
+    return upipe_control(upipe, UPIPE_SWR_GET_BLOCK_SIZE,
+                         UPIPE_SWR_SIGNATURE, block_size_p);
+}
+
 /** @This returns the management structure for swr pipes.
  *
  * @return pointer to manager
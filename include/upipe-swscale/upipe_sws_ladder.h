@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe swscale module scaling a picture to several resolutions
+ *
+ * Each output subpipe is allocated with a flow definition giving its size
+ * and pixel format, like a swscale pipe. Outputs are processed from the
+ * largest to the smallest, and each one is scaled from the smallest
+ * picture already produced that is at least as large, so that an ABR
+ * ladder (1080 -> 720 -> 540 -> 360) is computed in cascade and the source
+ * picture is only read to build the first rung.
+ */
+
+#ifndef _UPIPE_SWSCALE_UPIPE_SWS_LADDER_H_
+/** @hidden */
+#define _UPIPE_SWSCALE_UPIPE_SWS_LADDER_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_SWS_LADDER_SIGNATURE UBASE_FOURCC('s','w','s','l')
+#define UPIPE_SWS_LADDER_OUTPUT_SIGNATURE UBASE_FOURCC('s','w','s','o')
+
+/** @This extends upipe_command with specific commands for the outputs of
+ * sws_ladder pipes. */
+enum upipe_sws_ladder_output_command {
+    UPIPE_SWS_LADDER_OUTPUT_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** set flags (int) */
+    UPIPE_SWS_LADDER_OUTPUT_SET_FLAGS,
+    /** get flags (int *) */
+    UPIPE_SWS_LADDER_OUTPUT_GET_FLAGS,
+    /** forbid scaling from another output (int) */
+    UPIPE_SWS_LADDER_OUTPUT_SET_DIRECT
+};
+
+/** @This gets the swscale flags of an output.
+ *
+ * @param upipe description structure of the output subpipe
+ * @param flags_p filled in with the swscale flags
+ * @return an error code
+ */
+static inline int upipe_sws_ladder_output_get_flags(struct upipe *upipe,
+                                                    int *flags_p)
+{
+    return upipe_control(upipe, UPIPE_SWS_LADDER_OUTPUT_GET_FLAGS,
+                         UPIPE_SWS_LADDER_OUTPUT_SIGNATURE, flags_p);
+}
+
+/** @This sets the swscale flags of an output.
+ *
+ * @param upipe description structure of the output subpipe
+ * @param flags swscale flags
+ * @return an error code
+ */
+static inline int upipe_sws_ladder_output_set_flags(struct upipe *upipe,
+                                                    int flags)
+{
+    return upipe_control(upipe, UPIPE_SWS_LADDER_OUTPUT_SET_FLAGS,
+                         UPIPE_SWS_LADDER_OUTPUT_SIGNATURE, flags);
+}
+
+/** @This sets whether an output must always be scaled from the source
+ * picture, instead of being scaled from a larger output. This trades
+ * performance for quality. The other outputs may still be scaled from this
+ * one.
+ *
+ * @param upipe description structure of the output subpipe
+ * @param direct true to scale from the source picture
+ * @return an error code
+ */
+static inline int upipe_sws_ladder_output_set_direct(struct upipe *upipe,
+                                                     bool direct)
+{
+    return upipe_control(upipe, UPIPE_SWS_LADDER_OUTPUT_SET_DIRECT,
+                         UPIPE_SWS_LADDER_OUTPUT_SIGNATURE, direct ? 1 : 0);
+}
+
+/** @This returns the management structure for sws_ladder pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_sws_ladder_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -51,7 +51,15 @@ enum upipe_ts_demux_command {
     /** returns the currently detected conformance (int *) */
     UPIPE_TS_DEMUX_GET_CONFORMANCE,
     /** sets the conformance (int) */
-    UPIPE_TS_DEMUX_SET_CONFORMANCE
+    UPIPE_TS_DEMUX_SET_CONFORMANCE,
+    /** returns a snapshot of the PSI tables (struct uref **) */
+    UPIPE_TS_DEMUX_GET_SNAPSHOT,
+    /** preloads a snapshot of the PSI tables (struct uref *) */
+    UPIPE_TS_DEMUX_SET_SNAPSHOT,
+
+    /** sets the worker thread of a program (struct upipe_mgr *,
+     * struct uprobe *) */
+    UPIPE_TS_DEMUX_PROGRAM_SET_WORKER
 };
 
 /** @This returns the currently detected conformance mode. It cannot return
@@ -83,6 +91,70 @@ static inline int
                          UPIPE_TS_DEMUX_SIGNATURE, conformance);
 }
 
+/** @This returns a snapshot of the PSI tables in effect, that is the
+ * sections of the PAT and of the PMTs of the allocated programs, as a block
+ * uref which may be stored and given back to @ref upipe_ts_demux_set_snapshot
+ * when the same stream is opened again. The conformance in effect is also
+ * saved as an attribute.
+ *
+ * @param upipe description structure of the pipe
+ * @param snapshot_p filled in with the snapshot, which must be freed by the
+ * caller
+ * @return an error code
+ */
+static inline int upipe_ts_demux_get_snapshot(struct upipe *upipe,
+                                              struct uref **snapshot_p)
+{
+    return upipe_control(upipe, UPIPE_TS_DEMUX_GET_SNAPSHOT,
+                         UPIPE_TS_DEMUX_SIGNATURE, snapshot_p);
+}
+
+/** @This preloads a snapshot of the PSI tables, so that programs and their
+ * outputs may be allocated before the tables are received from the stream.
+ * The PAT is parsed immediately, and the PMT of a program is parsed as soon
+ * as the program is allocated. The tables received afterwards from the stream
+ * are checked against the snapshot, and trigger the usual updates if they
+ * differ. This should be called right after the allocation of the pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param snapshot snapshot returned by @ref upipe_ts_demux_get_snapshot
+ * @return an error code
+ */
+static inline int upipe_ts_demux_set_snapshot(struct upipe *upipe,
+                                              struct uref *snapshot)
+{
+    return upipe_control(upipe, UPIPE_TS_DEMUX_SET_SNAPSHOT,
+                         UPIPE_TS_DEMUX_SIGNATURE, snapshot);
+}
+
+/** @This sets the worker thread of a program. The TS and PES decapsulation
+ * of the outputs of the program, and everything allocated after them by the
+ * autof manager, then run in the thread of the worker, while the PAT, PMT
+ * and PCR are still handled in the thread of the demux. Only the packets of
+ * the PIDs of the program are forwarded to the worker, through one queue per
+ * output.
+ *
+ * Outputs carrying no PES, or belonging to a program without PCR, remain in
+ * the thread of the demux. This may only be called before any output of the
+ * program has been allocated.
+ *
+ * @param upipe description structure of the program subpipe
+ * @param xfer_mgr manager to transfer pipes to the worker thread, created for
+ * instance with upipe_pthread_xfer_mgr_alloc, or NULL to disable
+ * @param uprobe_remote probe hierarchy to use in the worker thread (must be
+ * thread-safe)
+ * @return an error code
+ */
+static inline int
+    upipe_ts_demux_program_set_worker(struct upipe *upipe,
+                                      struct upipe_mgr *xfer_mgr,
+                                      struct uprobe *uprobe_remote)
+{
+    return upipe_control(upipe, UPIPE_TS_DEMUX_PROGRAM_SET_WORKER,
+                         UPIPE_TS_DEMUX_PROGRAM_SIGNATURE, xfer_mgr,
+                         uprobe_remote);
+}
+
 /** @This returns the management structure for all ts_demux pipes.
  *
  * @return pointer to manager
@@ -103,6 +175,7 @@ enum upipe_ts_demux_mgr_command {
 
     UPIPE_TS_DEMUX_MGR_GET_SET_MGR(null, NULL)
     UPIPE_TS_DEMUX_MGR_GET_SET_MGR(setrap, SETRAP)
+    UPIPE_TS_DEMUX_MGR_GET_SET_MGR(setattr, SETATTR)
     UPIPE_TS_DEMUX_MGR_GET_SET_MGR(idem, IDEM)
 
     UPIPE_TS_DEMUX_MGR_GET_SET_MGR(ts_split, TS_SPLIT)
@@ -122,6 +195,12 @@ enum upipe_ts_demux_mgr_command {
 
     UPIPE_TS_DEMUX_MGR_GET_SET_MGR(autof, AUTOF)
 #undef UPIPE_TS_DEMUX_MGR_GET_SET_MGR
+
+    /** returns the number of worker threads (unsigned int *) */
+    UPIPE_TS_DEMUX_MGR_GET_WORKERS,
+    /** sets the worker threads (unsigned int, struct upipe_mgr **,
+     * struct uprobe *) */
+    UPIPE_TS_DEMUX_MGR_SET_WORKERS
 };
 
 /** @hidden */
@@ -156,6 +235,7 @@ static inline int                                                           \
 
 UPIPE_TS_DEMUX_MGR_GET_SET_MGR2(null, NULL)
 UPIPE_TS_DEMUX_MGR_GET_SET_MGR2(setrap, SETRAP)
+UPIPE_TS_DEMUX_MGR_GET_SET_MGR2(setattr, SETATTR)
 UPIPE_TS_DEMUX_MGR_GET_SET_MGR2(idem, IDEM)
 
 UPIPE_TS_DEMUX_MGR_GET_SET_MGR2(ts_split, TS_SPLIT)
@@ -176,6 +256,43 @@ UPIPE_TS_DEMUX_MGR_GET_SET_MGR2(ts_scte35d, TS_SCTE35D)
 UPIPE_TS_DEMUX_MGR_GET_SET_MGR2(autof, AUTOF)
 #undef UPIPE_TS_DEMUX_MGR_GET_SET_MGR2
 
+/** @This returns the number of worker threads used by the framers.
+ *
+ * @param mgr pointer to manager
+ * @param nb_workers_p filled in with the number of worker threads
+ * @return an error code
+ */
+static inline int upipe_ts_demux_mgr_get_workers(struct upipe_mgr *mgr,
+                                                 unsigned int *nb_workers_p)
+{
+    return upipe_mgr_control(mgr, UPIPE_TS_DEMUX_MGR_GET_WORKERS,
+                             UPIPE_TS_DEMUX_SIGNATURE, nb_workers_p);
+}
+
+/** @This sets the worker threads used by the framers. Outputs are assigned
+ * to a worker in a round-robin fashion, and the framer allocated by the
+ * autof manager for each of them runs in the thread of this worker, while
+ * TS and PES decapsulation and clock handling remain in the thread of the
+ * demux. This may only be called before any pipe has been allocated.
+ *
+ * @param mgr pointer to manager
+ * @param nb_workers number of worker threads, or 0 to disable
+ * @param xfer_mgrs array of nb_workers managers, created for instance with
+ * upipe_pthread_xfer_mgr_alloc
+ * @param uprobe_remote probe hierarchy to use in the worker threads (must be
+ * thread-safe)
+ * @return an error code
+ */
+static inline int upipe_ts_demux_mgr_set_workers(struct upipe_mgr *mgr,
+                                                 unsigned int nb_workers,
+                                                 struct upipe_mgr **xfer_mgrs,
+                                                 struct uprobe *uprobe_remote)
+{
+    return upipe_mgr_control(mgr, UPIPE_TS_DEMUX_MGR_SET_WORKERS,
+                             UPIPE_TS_DEMUX_SIGNATURE, nb_workers, xfer_mgrs,
+                             uprobe_remote);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe module analysing a transport stream against ETSI TR 101 290
+ *
+ * The pipe checks the priority 1 and 2 indicators of ETSI TR 101 290 that
+ * can be measured from the transport layer alone. It accepts packets
+ * (block.mpegts.) or bursts of packets (block.mpegtsburst.), and forwards
+ * them unchanged. Errors are counted per indicator, thrown as
+ * @ref UPROBE_TS_ETR290_ERROR events, and added to the instrumentation
+ * counters of the pipe (see @ref upipe_stats_enable), so that they are
+ * exported by the metrics exporter.
+ *
+ * Timeouts are measured on the cr_sys of the packets, and are therefore not
+ * checked on streams without system clock references.
+ */
+
+#ifndef _UPIPE_TS_UPIPE_TS_ETR290_H_
+/** @hidden */
+#define _UPIPE_TS_UPIPE_TS_ETR290_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#include <stdint.h>
+
+#define UPIPE_TS_ETR290_SIGNATURE UBASE_FOURCC('t','s','e','r')
+
+/** @This lists the indicators checked by the pipe. */
+enum upipe_ts_etr290_indicator {
+    /** 1.2 sync byte different from 0x47 */
+    UPIPE_TS_ETR290_SYNC_BYTE = 0,
+    /** 1.3 PAT missing for 0.5 s, scrambled, or wrong table_id on PID 0 */
+    UPIPE_TS_ETR290_PAT,
+    /** 1.4 continuity counter out of order, lost packet, or packet
+     * repeated more than twice */
+    UPIPE_TS_ETR290_CC,
+    /** 1.5 PMT missing for 0.5 s, or scrambled */
+    UPIPE_TS_ETR290_PMT,
+    /** 1.6 PID referred to in a PMT missing for the PID timeout */
+    UPIPE_TS_ETR290_PID,
+    /** 2.1 transport_error_indicator set */
+    UPIPE_TS_ETR290_TRANSPORT,
+    /** 2.2 CRC error in a PAT or PMT section */
+    UPIPE_TS_ETR290_CRC,
+    /** 2.3a PCRs more than 40 ms apart */
+    UPIPE_TS_ETR290_PCR_REPETITION,
+    /** 2.3b PCRs more than 100 ms apart or going backwards, without
+     * discontinuity_indicator */
+    UPIPE_TS_ETR290_PCR_DISCONTINUITY,
+    /** 2.4 PCR more than 500 ns away from the value interpolated with the
+     * rate of the previous PCR interval */
+    UPIPE_TS_ETR290_PCR_ACCURACY,
+
+    /** number of indicators */
+    UPIPE_TS_ETR290_INDICATORS
+};
+
+/** @This returns a string describing an indicator.
+ *
+ * @param indicator indicator
+ * @return description of the indicator
+ */
+static inline const char *
+    upipe_ts_etr290_indicator_str(enum upipe_ts_etr290_indicator indicator)
+{
+    switch (indicator) {
+        case UPIPE_TS_ETR290_SYNC_BYTE: return "Sync_byte_error";
+        case UPIPE_TS_ETR290_PAT: return "PAT_error";
+        case UPIPE_TS_ETR290_CC: return "Continuity_count_error";
+        case UPIPE_TS_ETR290_PMT: return "PMT_error";
+        case UPIPE_TS_ETR290_PID: return "PID_error";
+        case UPIPE_TS_ETR290_TRANSPORT: return "Transport_error";
+        case UPIPE_TS_ETR290_CRC: return "CRC_error";
+        case UPIPE_TS_ETR290_PCR_REPETITION: return "PCR_repetition_error";
+        case UPIPE_TS_ETR290_PCR_DISCONTINUITY:
+            return "PCR_discontinuity_indicator_error";
+        case UPIPE_TS_ETR290_PCR_ACCURACY: return "PCR_accuracy_error";
+        default: return NULL;
+    }
+}
+
+/** @This stores the counters of a ts_etr290 pipe. */
+struct upipe_ts_etr290_counters {
+    /** number of packets analysed */
+    uint64_t packets;
+    /** number of errors, per indicator */
+    uint64_t errors[UPIPE_TS_ETR290_INDICATORS];
+    /** maximum PCR inaccuracy, in units of 27 MHz */
+    uint64_t max_pcr_accuracy;
+};
+
+/** @This extends uprobe_event with specific events for ts_etr290. */
+enum uprobe_ts_etr290_event {
+    UPROBE_TS_ETR290_SENTINEL = UPROBE_LOCAL,
+
+    /** an error was detected (int indicator, unsigned int PID, or 8192 if
+     * the PID is unknown) */
+    UPROBE_TS_ETR290_ERROR
+};
+
+/** @This extends upipe_command with specific commands for ts_etr290. */
+enum upipe_ts_etr290_command {
+    UPIPE_TS_ETR290_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the counters (struct upipe_ts_etr290_counters *) */
+    UPIPE_TS_ETR290_GET_COUNTERS,
+    /** resets the counters (void) */
+    UPIPE_TS_ETR290_RESET_COUNTERS,
+    /** returns the PID timeout (uint64_t *) */
+    UPIPE_TS_ETR290_GET_PID_TIMEOUT,
+    /** sets the PID timeout (uint64_t) */
+    UPIPE_TS_ETR290_SET_PID_TIMEOUT
+};
+
+/** @This returns the counters of the pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param counters_p filled in with the counters
+ * @return an error code
+ */
+static inline int
+    upipe_ts_etr290_get_counters(struct upipe *upipe,
+                                 struct upipe_ts_etr290_counters *counters_p)
+{
+    return upipe_control(upipe, UPIPE_TS_ETR290_GET_COUNTERS,
+                         UPIPE_TS_ETR290_SIGNATURE, counters_p);
+}
+
+/** @This resets the counters of the pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static inline int upipe_ts_etr290_reset_counters(struct upipe *upipe)
+{
+    return upipe_control(upipe, UPIPE_TS_ETR290_RESET_COUNTERS,
+                         UPIPE_TS_ETR290_SIGNATURE);
+}
+
+/** @This returns the time after which a PID referred to in a PMT is
+ * reported missing.
+ *
+ * @param upipe description structure of the pipe
+ * @param timeout_p filled in with the timeout, in units of UCLOCK_FREQ
+ * @return an error code
+ */
+static inline int upipe_ts_etr290_get_pid_timeout(struct upipe *upipe,
+                                                  uint64_t *timeout_p)
+{
+    return upipe_control(upipe, UPIPE_TS_ETR290_GET_PID_TIMEOUT,
+                         UPIPE_TS_ETR290_SIGNATURE, timeout_p);
+}
+
+/** @This sets the time after which a PID referred to in a PMT is reported
+ * missing. The default is 5 seconds.
+ *
+ * @param upipe description structure of the pipe
+ * @param timeout timeout, in units of UCLOCK_FREQ
+ * @return an error code
+ */
+static inline int upipe_ts_etr290_set_pid_timeout(struct upipe *upipe,
+                                                  uint64_t timeout)
+{
+    return upipe_control(upipe, UPIPE_TS_ETR290_SET_PID_TIMEOUT,
+                         UPIPE_TS_ETR290_SIGNATURE, timeout);
+}
+
+/** @This returns the management structure for all ts_etr290 pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_ts_etr290_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
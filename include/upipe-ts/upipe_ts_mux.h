@@ -53,7 +53,9 @@ enum upipe_ts_mux_mode {
     /** constant octetrate */
     UPIPE_TS_MUX_MODE_CBR,
     /** capped octetrate */
-    UPIPE_TS_MUX_MODE_CAPPED
+    UPIPE_TS_MUX_MODE_CAPPED,
+    /** variable octetrate without null packets */
+    UPIPE_TS_MUX_MODE_VBR
 };
 
 /** @This returns a string describing the mode.
@@ -67,6 +69,7 @@ static inline const char *
     switch (mode) {
         case UPIPE_TS_MUX_MODE_CBR: return "CBR";
         case UPIPE_TS_MUX_MODE_CAPPED: return "Capped VBR";
+        case UPIPE_TS_MUX_MODE_VBR: return "VBR";
         default: return "unknown";
     }
 }
@@ -158,6 +161,20 @@ enum upipe_ts_mux_command {
     /** prepares the next access unit/section for the given date
      * (uint64_t, uint64_t) */
     UPIPE_TS_MUX_PREPARE,
+    /** returns the current statistical multiplexing period (uint64_t *) */
+    UPIPE_TS_MUX_GET_STATMUX_PERIOD,
+    /** sets the statistical multiplexing period, or 0 to disable
+     * (uint64_t) */
+    UPIPE_TS_MUX_SET_STATMUX_PERIOD,
+    /** returns the current statistical multiplexing weight of a program
+     * (unsigned int *) */
+    UPIPE_TS_MUX_GET_STATMUX_WEIGHT,
+    /** sets the statistical multiplexing weight of a program (unsigned int) */
+    UPIPE_TS_MUX_SET_STATMUX_WEIGHT,
+    /** returns the maximum delay of a packet in VBR mode (uint64_t *) */
+    UPIPE_TS_MUX_GET_VBR_JITTER,
+    /** sets the maximum delay of a packet in VBR mode (uint64_t) */
+    UPIPE_TS_MUX_SET_VBR_JITTER,
 
     /** ts_encaps commands begin here */
     UPIPE_TS_MUX_ENCAPS = UPIPE_CONTROL_LOCAL + 0x1000,
@@ -712,6 +729,92 @@ static inline int upipe_ts_mux_prepare(struct upipe *upipe, uint64_t cr_sys,
                                UPIPE_TS_MUX_SIGNATURE, cr_sys, latency);
 }
 
+/** @This returns the current statistical multiplexing period.
+ *
+ * @param upipe description structure of the pipe
+ * @param period_p filled in with the period (in 27 MHz units)
+ * @return an error code
+ */
+static inline int upipe_ts_mux_get_statmux_period(struct upipe *upipe,
+                                                  uint64_t *period_p)
+{
+    return upipe_control(upipe, UPIPE_TS_MUX_GET_STATMUX_PERIOD,
+                         UPIPE_TS_MUX_SIGNATURE, period_p);
+}
+
+/** @This sets the statistical multiplexing period. At each period, the
+ * octetrate of the video elementary streams is reallocated between programs
+ * according to the fullness of their T-STD buffers, and the new octetrates
+ * are suggested to the encoders by providing again their flow format
+ * requests. 0 disables statistical multiplexing.
+ *
+ * @param upipe description structure of the pipe
+ * @param period new period (in 27 MHz units)
+ * @return an error code
+ */
+static inline int upipe_ts_mux_set_statmux_period(struct upipe *upipe,
+                                                  uint64_t period)
+{
+    return upipe_control(upipe, UPIPE_TS_MUX_SET_STATMUX_PERIOD,
+                         UPIPE_TS_MUX_SIGNATURE, period);
+}
+
+/** @This returns the current statistical multiplexing weight of a program.
+ *
+ * @param upipe description structure of the program
+ * @param weight_p filled in with the weight
+ * @return an error code
+ */
+static inline int upipe_ts_mux_get_statmux_weight(struct upipe *upipe,
+                                                  unsigned int *weight_p)
+{
+    return upipe_control(upipe, UPIPE_TS_MUX_GET_STATMUX_WEIGHT,
+                         UPIPE_TS_MUX_SIGNATURE, weight_p);
+}
+
+/** @This sets the statistical multiplexing weight of a program. A program
+ * with a weight of 0 keeps its octetrate.
+ *
+ * @param upipe description structure of the program
+ * @param weight new weight
+ * @return an error code
+ */
+static inline int upipe_ts_mux_set_statmux_weight(struct upipe *upipe,
+                                                  unsigned int weight)
+{
+    return upipe_control(upipe, UPIPE_TS_MUX_SET_STATMUX_WEIGHT,
+                         UPIPE_TS_MUX_SIGNATURE, weight);
+}
+
+/** @This returns the maximum delay of a packet in VBR mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param jitter_p filled in with the delay (in 27 MHz units)
+ * @return an error code
+ */
+static inline int upipe_ts_mux_get_vbr_jitter(struct upipe *upipe,
+                                              uint64_t *jitter_p)
+{
+    return upipe_control(upipe, UPIPE_TS_MUX_GET_VBR_JITTER,
+                         UPIPE_TS_MUX_SIGNATURE, jitter_p);
+}
+
+/** @This sets the maximum delay of a packet in VBR mode. In this mode, no
+ * null packet is output, and an output buffer is sent as soon as it is full,
+ * one of its packets is due for decoding, or its first packet has waited for
+ * the given delay.
+ *
+ * @param upipe description structure of the pipe
+ * @param jitter new delay (in 27 MHz units)
+ * @return an error code
+ */
+static inline int upipe_ts_mux_set_vbr_jitter(struct upipe *upipe,
+                                              uint64_t jitter)
+{
+    return upipe_control(upipe, UPIPE_TS_MUX_SET_VBR_JITTER,
+                         UPIPE_TS_MUX_SIGNATURE, jitter);
+}
+
 /** @This returns a description string for local commands.
  *
  * @param cmd control command
@@ -748,6 +851,12 @@ enum upipe_ts_mux_mgr_command {
     UPIPE_TS_MUX_MGR_GET_SET_MGR(ts_psig, TS_PSIG)
     UPIPE_TS_MUX_MGR_GET_SET_MGR(ts_sig, TS_SIG)
 #undef UPIPE_TS_MUX_MGR_GET_SET_MGR
+
+    /** returns the number of worker threads (unsigned int *) */
+    UPIPE_TS_MUX_MGR_GET_WORKERS,
+    /** sets the worker threads (unsigned int, struct upipe_mgr **,
+     * struct uprobe *) */
+    UPIPE_TS_MUX_MGR_SET_WORKERS
 };
 
 
@@ -787,6 +896,45 @@ UPIPE_TS_MUX_MGR_GET_SET_MGR2(ts_psig, TS_PSIG)
 UPIPE_TS_MUX_MGR_GET_SET_MGR2(ts_sig, TS_SIG)
 #undef UPIPE_TS_MUX_MGR_GET_SET_MGR2
 
+/** @This returns the number of worker threads used by the inputs.
+ *
+ * @param mgr pointer to manager
+ * @param nb_workers_p filled in with the number of worker threads
+ * @return an error code
+ */
+static inline int upipe_ts_mux_mgr_get_workers(struct upipe_mgr *mgr,
+                                               unsigned int *nb_workers_p)
+{
+    return upipe_mgr_control(mgr, UPIPE_TS_MUX_MGR_GET_WORKERS,
+                             UPIPE_TS_MUX_SIGNATURE, nb_workers_p);
+}
+
+/** @This sets the worker threads used by the inputs. Programs are assigned
+ * to a worker in a round-robin fashion, and the T-STD pipe of each of their
+ * inputs runs in the thread of this worker, while encapsulation and
+ * scheduling remain in the thread of the mux. This may only be called
+ * before any pipe has been allocated. Changing the maximum retention delay
+ * of a running input freezes the remote event loop, so the xfer managers
+ * must have been allocated with a mutex for that.
+ *
+ * @param mgr pointer to manager
+ * @param nb_workers number of worker threads, or 0 to disable
+ * @param xfer_mgrs array of nb_workers managers, created for instance with
+ * upipe_pthread_xfer_mgr_alloc
+ * @param uprobe_remote probe hierarchy to use in the worker threads (must be
+ * thread-safe)
+ * @return an error code
+ */
+static inline int upipe_ts_mux_mgr_set_workers(struct upipe_mgr *mgr,
+                                               unsigned int nb_workers,
+                                               struct upipe_mgr **xfer_mgrs,
+                                               struct uprobe *uprobe_remote)
+{
+    return upipe_mgr_control(mgr, UPIPE_TS_MUX_MGR_SET_WORKERS,
+                             UPIPE_TS_MUX_SIGNATURE, nb_workers, xfer_mgrs,
+                             uprobe_remote);
+}
+
 #ifdef __cplusplus
 }
 #endif
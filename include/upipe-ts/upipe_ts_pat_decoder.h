@@ -39,7 +39,9 @@ enum upipe_ts_patd_command {
     UPIPE_TS_PATD_SENTINEL = UPIPE_CONTROL_LOCAL,
 
     /** returns the flow definition of the NIT (struct uref **) */
-    UPIPE_TS_PATD_GET_NIT
+    UPIPE_TS_PATD_GET_NIT,
+    /** appends the sections of the PAT in effect (struct uref *) */
+    UPIPE_TS_PATD_EXPORT
 };
 
 /** @This returns the flow definition of the NIT.
@@ -55,6 +57,19 @@ static inline bool upipe_ts_patd_get_nit(struct upipe *upipe,
                          UPIPE_TS_PATD_SIGNATURE, flow_def_p);
 }
 
+/** @This appends the sections of the PAT in effect to a block uref, so that
+ * they can be fed again to a decoder later on.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref block uref to append the sections to
+ * @return an error code
+ */
+static inline int upipe_ts_patd_export(struct upipe *upipe, struct uref *uref)
+{
+    return upipe_control(upipe, UPIPE_TS_PATD_EXPORT,
+                         UPIPE_TS_PATD_SIGNATURE, uref);
+}
+
 /** @This returns the management structure for all ts_patd pipes.
  *
  * @return pointer to manager
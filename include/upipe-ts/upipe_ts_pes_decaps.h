@@ -30,9 +30,52 @@ extern "C" {
 #endif
 
 #include <upipe/upipe.h>
+#include <upipe/uref_attr.h>
 
 #define UPIPE_TS_PESD_SIGNATURE UBASE_FOURCC('t','s','p','d')
 
+UREF_ATTR_UNSIGNED(ts_pesd, pes_size, "t.pesd.size",
+        size of the PES including header in headers-only mode)
+
+/** @This extends upipe_command with specific commands for ts pesd. */
+enum upipe_ts_pesd_command {
+    UPIPE_TS_PESD_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the headers-only mode (bool *) */
+    UPIPE_TS_PESD_GET_HEADERS_ONLY,
+    /** sets the headers-only mode (bool) */
+    UPIPE_TS_PESD_SET_HEADERS_ONLY
+};
+
+/** @This returns true if the pipe only outputs PES headers.
+ *
+ * @param upipe description structure of the pipe
+ * @param headers_only_p filled in with the headers-only mode
+ * @return an error code
+ */
+static inline int upipe_ts_pesd_get_headers_only(struct upipe *upipe,
+                                                 bool *headers_only_p)
+{
+    return upipe_control(upipe, UPIPE_TS_PESD_GET_HEADERS_ONLY,
+                         UPIPE_TS_PESD_SIGNATURE, headers_only_p);
+}
+
+/** @This sets the headers-only mode. In this mode, the pipe doesn't
+ * reassemble the PES payload, and outputs a void flow where each uref
+ * carries the timestamps, the random flag and the size of a PES (unless it
+ * is unbounded). The PES being reassembled is dropped.
+ *
+ * @param upipe description structure of the pipe
+ * @param headers_only true to only output PES headers
+ * @return an error code
+ */
+static inline int upipe_ts_pesd_set_headers_only(struct upipe *upipe,
+                                                 bool headers_only)
+{
+    return upipe_control(upipe, UPIPE_TS_PESD_SET_HEADERS_ONLY,
+                         UPIPE_TS_PESD_SIGNATURE, headers_only ? 1 : 0);
+}
+
 /** @This returns the management structure for all ts_pesd pipes.
  *
  * @return pointer to manager
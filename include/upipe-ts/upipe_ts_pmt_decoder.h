@@ -34,6 +34,44 @@ extern "C" {
 
 #define UPIPE_TS_PMTD_SIGNATURE UBASE_FOURCC('t','s','2','d')
 
+/** @This extends upipe_command with specific commands for ts_pmtd. */
+enum upipe_ts_pmtd_command {
+    UPIPE_TS_PMTD_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the number of unchanged sections (uint64_t *) */
+    UPIPE_TS_PMTD_GET_UNCHANGED,
+    /** appends the section of the PMT in effect (struct uref *) */
+    UPIPE_TS_PMTD_EXPORT
+};
+
+/** @This returns the number of sections which were dropped because they
+ * had the same version, length and CRC as the PMT in effect, before being
+ * merged or parsed.
+ *
+ * @param upipe description structure of the pipe
+ * @param unchanged_p filled in with the number of unchanged sections
+ * @return an error code
+ */
+static inline int upipe_ts_pmtd_get_unchanged(struct upipe *upipe,
+                                              uint64_t *unchanged_p)
+{
+    return upipe_control(upipe, UPIPE_TS_PMTD_GET_UNCHANGED,
+                         UPIPE_TS_PMTD_SIGNATURE, unchanged_p);
+}
+
+/** @This appends the section of the PMT in effect to a block uref, so that
+ * it can be fed again to a decoder later on.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref block uref to append the section to
+ * @return an error code
+ */
+static inline int upipe_ts_pmtd_export(struct upipe *upipe, struct uref *uref)
+{
+    return upipe_control(upipe, UPIPE_TS_PMTD_EXPORT,
+                         UPIPE_TS_PMTD_SIGNATURE, uref);
+}
+
 /** @This returns the management structure for all ts_pmtd pipes.
  *
  * @return pointer to manager
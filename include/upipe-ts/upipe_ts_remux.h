@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module rewriting the PIDs of a transport stream
+ * The packets are forwarded untouched apart from their PID, and the PAT and
+ * PMT are rewritten accordingly, so that a TS can be re-PIDed without
+ * demuxing and remuxing it.
+ */
+
+#ifndef _UPIPE_TS_UPIPE_TS_REMUX_H_
+/** @hidden */
+#define _UPIPE_TS_UPIPE_TS_REMUX_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_TS_REMUX_SIGNATURE UBASE_FOURCC('t','s','r','x')
+
+/** @This extends upipe_command with specific commands for ts remux. */
+enum upipe_ts_remux_command {
+    UPIPE_TS_REMUX_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** maps an input PID to an output PID (unsigned int, unsigned int) */
+    UPIPE_TS_REMUX_SET_PID,
+    /** restores the given input PID (unsigned int) */
+    UPIPE_TS_REMUX_DEL_PID
+};
+
+/** @This maps an input PID to an output PID. Mapping a PID to the null PID
+ * removes it from the stream. The caller must not map two PIDs present in
+ * the stream to the same output PID.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid input PID
+ * @param out_pid output PID
+ * @return an error code
+ */
+static inline int upipe_ts_remux_set_pid(struct upipe *upipe, uint16_t pid,
+                                         uint16_t out_pid)
+{
+    return upipe_control(upipe, UPIPE_TS_REMUX_SET_PID,
+                         UPIPE_TS_REMUX_SIGNATURE, (unsigned int)pid,
+                         (unsigned int)out_pid);
+}
+
+/** @This restores the given input PID, which is then output unchanged.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid input PID
+ * @return an error code
+ */
+static inline int upipe_ts_remux_del_pid(struct upipe *upipe, uint16_t pid)
+{
+    return upipe_control(upipe, UPIPE_TS_REMUX_DEL_PID,
+                         UPIPE_TS_REMUX_SIGNATURE, (unsigned int)pid);
+}
+
+/** @This returns the management structure for all ts_remux pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_ts_remux_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -34,6 +34,29 @@ extern "C" {
 
 #define UPIPE_TS_SDTD_SIGNATURE UBASE_FOURCC('t','s',0x42,'d')
 
+/** @This extends upipe_command with specific commands for ts_sdtd. */
+enum upipe_ts_sdtd_command {
+    UPIPE_TS_SDTD_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the number of unchanged sections (uint64_t *) */
+    UPIPE_TS_SDTD_GET_UNCHANGED
+};
+
+/** @This returns the number of sections which were dropped because they
+ * had the same version, length and CRC as the SDT in effect, before being
+ * merged or parsed.
+ *
+ * @param upipe description structure of the pipe
+ * @param unchanged_p filled in with the number of unchanged sections
+ * @return an error code
+ */
+static inline int upipe_ts_sdtd_get_unchanged(struct upipe *upipe,
+                                              uint64_t *unchanged_p)
+{
+    return upipe_control(upipe, UPIPE_TS_SDTD_GET_UNCHANGED,
+                         UPIPE_TS_SDTD_SIGNATURE, unchanged_p);
+}
+
 /** @This returns the management structure for all ts_sdtd pipes.
  *
  * @return pointer to manager
@@ -45,6 +45,40 @@ enum uprobe_ts_split_event {
     UPROBE_TS_SPLIT_DEL_PID
 };
 
+/** size in octets of the PID filter bitmap, one bit per PID */
+#define UPIPE_TS_SPLIT_PID_FILTER_SIZE (8192 / 8)
+
+/** @This extends upipe_command with specific commands for ts split. */
+enum upipe_ts_split_command {
+    UPIPE_TS_SPLIT_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the bitmap of PIDs having outputs (const uint8_t **,
+     * struct urefcount **) */
+    UPIPE_TS_SPLIT_GET_PID_FILTER
+};
+
+/** @This returns the bitmap of the PIDs having at least one output. Bit
+ * (pid & 7) of octet (pid >> 3) is set when packets of the PID are wanted.
+ * The bitmap is updated in place as outputs are allocated and released, so
+ * that it may be given to a source to drop unwanted packets as early as
+ * possible (see @ref upipe_udpsrc_set_pid_filter), together with the
+ * refcount of its owner. The bitmap remains valid as long as a reference on
+ * the owner is held.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid_filter_p filled in with a pointer to the bitmap
+ * @param owner_p filled in with the refcount of the structure holding the
+ * bitmap (no reference is taken)
+ * @return an error code
+ */
+static inline int upipe_ts_split_get_pid_filter(struct upipe *upipe,
+                                                const uint8_t **pid_filter_p,
+                                                struct urefcount **owner_p)
+{
+    return upipe_control(upipe, UPIPE_TS_SPLIT_GET_PID_FILTER,
+                         UPIPE_TS_SPLIT_SIGNATURE, pid_filter_p, owner_p);
+}
+
 /** @This returns the management structure for all ts_split pipes.
  *
  * @return pointer to manager
@@ -49,7 +49,12 @@ enum upipe_ts_sync_command {
     /** returns the configured number of packets to synchronize with (int *) */
     UPIPE_TS_SYNC_GET_SYNC,
     /** sets the configured number of packets to synchronize with (int) */
-    UPIPE_TS_SYNC_SET_SYNC
+    UPIPE_TS_SYNC_SET_SYNC,
+    /** returns the maximum number of packets per output buffer
+     * (unsigned int *) */
+    UPIPE_TS_SYNC_GET_BATCH,
+    /** sets the maximum number of packets per output buffer (unsigned int) */
+    UPIPE_TS_SYNC_SET_BATCH
 };
 
 /** @This returns the management structure for all ts_sync pipes.
@@ -84,6 +89,34 @@ static inline int upipe_ts_sync_set_sync(struct upipe *upipe, int sync)
                          sync);
 }
 
+/** @This returns the maximum number of packets per output buffer.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_p filled in with the maximum number of packets
+ * @return an error code
+ */
+static inline int upipe_ts_sync_get_batch(struct upipe *upipe,
+                                          unsigned int *batch_p)
+{
+    return upipe_control(upipe, UPIPE_TS_SYNC_GET_BATCH,
+                         UPIPE_TS_SYNC_SIGNATURE, batch_p);
+}
+
+/** @This sets the maximum number of packets per output buffer, once the
+ * synchronization is acquired. With more than one packet, the output flow
+ * definition is block.mpegtsburst. (see @ref uref_ts_burst.h).
+ *
+ * @param upipe description structure of the pipe
+ * @param batch maximum number of packets (default 1)
+ * @return an error code
+ */
+static inline int upipe_ts_sync_set_batch(struct upipe *upipe,
+                                          unsigned int batch)
+{
+    return upipe_control(upipe, UPIPE_TS_SYNC_SET_BATCH,
+                         UPIPE_TS_SYNC_SIGNATURE, batch);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe TS burst attributes
+ * A TS burst is a block containing several aligned and synchronized TS
+ * packets, so that they go through the pipeline in a single uref. It is
+ * identified by the flow definition @ref UREF_TS_BURST_FLOW_DEF. Unless the
+ * burst carries a per-packet index of system clock references, all packets
+ * share the cr_sys of the uref.
+ */
+
+#ifndef _UPIPE_TS_UREF_TS_BURST_H_
+/** @hidden */
+#define _UPIPE_TS_UREF_TS_BURST_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/uref.h>
+#include <upipe/uref_attr.h>
+#include <upipe/uref_clock.h>
+
+#include <string.h>
+#include <stdint.h>
+
+/** @This is the flow definition of TS bursts. */
+#define UREF_TS_BURST_FLOW_DEF "block.mpegtsburst."
+
+UREF_ATTR_OPAQUE(ts_burst, cr_sys_index, "t.burst.cr",
+        per-packet system clock references)
+
+/** @This sets the system clock reference of each packet of a burst.
+ *
+ * @param uref pointer to the uref
+ * @param cr_sys array of system clock references
+ * @param nb number of packets
+ * @return an error code
+ */
+static inline int uref_ts_burst_set_cr_sys(struct uref *uref,
+                                           const uint64_t *cr_sys,
+                                           unsigned int nb)
+{
+    return uref_ts_burst_set_cr_sys_index(uref, (const uint8_t *)cr_sys,
+                                          nb * sizeof(uint64_t));
+}
+
+/** @This returns the system clock reference of a packet of a burst, from
+ * the per-packet index if any, or from the uref otherwise.
+ *
+ * @param uref pointer to the uref
+ * @param nb index of the packet in the burst
+ * @param cr_sys_p filled in with the system clock reference
+ * @return an error code
+ */
+static inline int uref_ts_burst_get_cr_sys(struct uref *uref, unsigned int nb,
+                                           uint64_t *cr_sys_p)
+{
+    const uint8_t *index;
+    size_t size;
+    if (!ubase_check(uref_ts_burst_get_cr_sys_index(uref, &index, &size)))
+        return uref_clock_get_cr_sys(uref, cr_sys_p);
+    if (unlikely((nb + 1) * sizeof(uint64_t) > size))
+        return UBASE_ERR_INVALID;
+    memcpy(cr_sys_p, index + nb * sizeof(uint64_t), sizeof(uint64_t));
+    return UBASE_ERR_NONE;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
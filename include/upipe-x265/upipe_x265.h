@@ -40,6 +40,30 @@ extern "C" {
 
 #define UPIPE_X265_SIGNATURE UBASE_FOURCC('x','2','6','5')
 
+/** @This extends @ref uprobe_event with specific x265 events. */
+enum uprobe_x265_event {
+    UPROBE_X265_SENTINEL = UPROBE_LOCAL,
+
+    /** an encoded frame was output, with the number of pictures still queued
+     * in the encoder and the delay between the last input picture and the
+     * output frame, in units of a 27 MHz clock (unsigned int, uint64_t) */
+    UPROBE_X265_STATS
+};
+
+/** @This converts @ref uprobe_x265_event to a string.
+ *
+ * @param event event to convert
+ * @return a string or NULL if invalid
+ */
+static inline const char *upipe_x265_event_str(int event)
+{
+    switch ((enum uprobe_x265_event)event) {
+    UBASE_CASE_TO_STR(UPROBE_X265_STATS);
+    case UPROBE_X265_SENTINEL: break;
+    }
+    return NULL;
+}
+
 /** @This extends upipe_command with specific commands for x265. */
 enum upipe_x265_command {
     UPIPE_X265_SENTINEL = UPIPE_CONTROL_LOCAL,
@@ -60,7 +84,10 @@ enum upipe_x265_command {
     UPIPE_X265_SET_SC_LATENCY,
 
     /** set slice type enforcement mode (int) */
-    UPIPE_X265_SET_SLICE_TYPE_ENFORCE
+    UPIPE_X265_SET_SLICE_TYPE_ENFORCE,
+
+    /** set scene analysis enforcement mode (int) */
+    UPIPE_X265_SET_SCENE_ENFORCE
 };
 
 /** @This reconfigures encoder with updated parameters.
@@ -141,6 +168,23 @@ static inline int upipe_x265_set_slice_type_enforce(struct upipe *upipe,
                          UPIPE_X265_SIGNATURE, enforce ? 1 : 0);
 }
 
+/** @This sets the scene analysis enforcement mode (true or false). When
+ * enabled, the keyframes are placed on the pictures flagged by a scene
+ * analysis pipe (see @ref upipe_scene_analysis_mgr_alloc), which are coded
+ * as IDR; the scene cut detection, adaptive B-frame placement and CU tree
+ * lookahead of x265 are disabled when the encoder is opened.
+ *
+ * @param upipe description structure of the pipe
+ * @param enforce true if the scene analysis decisions must be enforced
+ * @return an error code
+ */
+static inline int upipe_x265_set_scene_enforce(struct upipe *upipe,
+                                               bool enforce)
+{
+    return upipe_control(upipe, UPIPE_X265_SET_SCENE_ENFORCE,
+                         UPIPE_X265_SIGNATURE, enforce ? 1 : 0);
+}
+
 /** @This returns the management structure for x265 pipes.
  *
  * @return pointer to manager
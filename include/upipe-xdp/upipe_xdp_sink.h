@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe sink module for AF_XDP sockets
+ */
+
+#ifndef _UPIPE_XDP_UPIPE_XDP_SINK_H_
+/** @hidden */
+#define _UPIPE_XDP_UPIPE_XDP_SINK_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_XDP_SINK_SIGNATURE UBASE_FOURCC('x','s','n','k')
+
+/** @This returns the management structure for xdp_sink pipes.
+ *
+ * The uri is of the form eth0-2@239.1.1.1:5004, where 2 is the hardware
+ * queue to send to (0 by default), followed by the destination multicast
+ * address and port. Each input buffer is sent in a single UDP datagram, from
+ * the address of the interface.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_xdp_sink_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
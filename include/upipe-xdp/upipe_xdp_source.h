@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe source module for AF_XDP sockets
+ */
+
+#ifndef _UPIPE_XDP_UPIPE_XDP_SOURCE_H_
+/** @hidden */
+#define _UPIPE_XDP_UPIPE_XDP_SOURCE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_XDP_SOURCE_SIGNATURE UBASE_FOURCC('x','s','r','c')
+
+/** @This returns the management structure for xdp_source pipes.
+ *
+ * The uri is of the form eth0-2@239.1.1.1:5004, where 2 is the hardware
+ * queue to read (0 by default), and the optional address and port select
+ * the IPv4 UDP datagrams redirected to the pipe by its XDP program. The
+ * datagrams are output without copy, in UMEM frames which go back to the
+ * kernel when the urefs are freed.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_xdp_source_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
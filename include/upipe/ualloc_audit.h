@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short Upipe audit of the allocations falling back to the system allocator
+ *
+ * In a properly sized pipeline, structures and buffers come from pools once
+ * the steady state is reached. After @ref ualloc_audit_checkpoint is
+ * called, each time a pool or a memory manager has to fall back to the
+ * system allocator, it is counted along with its call site, so that a chain
+ * may be certified allocation-free, or the culprits found.
+ */
+
+#ifndef _UPIPE_UALLOC_AUDIT_H_
+/** @hidden */
+#define _UPIPE_UALLOC_AUDIT_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** @hidden */
+struct uprobe;
+
+/** @This marks the beginning of the steady state, resets the counters,
+ * and starts auditing fallback allocations.
+ *
+ * @param backtraces true to record the backtrace of each call site, where
+ * supported
+ */
+void ualloc_audit_checkpoint(bool backtraces);
+
+/** @This stops auditing fallback allocations. The counters are kept until
+ * the next checkpoint.
+ */
+void ualloc_audit_disarm(void);
+
+/** @This is called by pools and memory managers when they fall back to the
+ * system allocator. It does nothing unless the audit is armed.
+ *
+ * @param name name of the kind of pool or manager
+ */
+void ualloc_audit_fallback(const char *name);
+
+/** @This returns the number of fallback allocations since the checkpoint.
+ *
+ * @return number of fallback allocations
+ */
+uint64_t ualloc_audit_count(void);
+
+/** @This reports the fallback allocations since the checkpoint as log
+ * events, one warning per call site followed by its backtrace, or a notice
+ * if the steady state was allocation-free.
+ *
+ * @param uprobe pointer to probe hierarchy to throw the events to
+ * @return number of fallback allocations
+ */
+uint64_t ualloc_audit_report(struct uprobe *uprobe);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
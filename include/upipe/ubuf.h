@@ -79,6 +79,9 @@ enum ubuf_command {
     UBUF_SIZE_PICTURE_PLANE,
     /** size sound ubuf (size_t *, uint8_t *) */
     UBUF_SIZE_SOUND,
+    /** size of the spare space after a block ubuf, if its buffer is not
+     * shared (size_t *) */
+    UBUF_SIZE_BLOCK_TAILROOM,
 
     /*
      * Map commands
@@ -125,6 +128,8 @@ enum ubuf_command {
     UBUF_ITERATE_PICTURE_PLANE,
     /** iterate on sound plane channel (const char **) */
     UBUF_ITERATE_SOUND_PLANE,
+    /** switch thread-local reference counts to atomic ones (void) */
+    UBUF_SHARE,
 
     /** non-standard commands implemented by a ubuf manager can start from
      * there */
@@ -232,6 +237,19 @@ static inline struct ubuf *ubuf_dup(struct ubuf *ubuf)
     return dup_ubuf;
 }
 
+/** @This makes sure the reference counts of a ubuf may be manipulated from
+ * any thread, promoting thread-local counters to atomic ones. It must be
+ * called by the thread owning the ubuf before it is handed over to another
+ * thread.
+ *
+ * @param ubuf pointer to ubuf
+ */
+static inline void ubuf_share(struct ubuf *ubuf)
+{
+    /* managers without thread-local counters do not handle the command */
+    ubuf_control(ubuf, UBUF_SHARE);
+}
+
 /** @This frees a ubuf.
  *
  * @param ubuf pointer to ubuf
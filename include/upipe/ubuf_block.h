@@ -42,6 +42,7 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/uio.h>
 #include <assert.h>
@@ -50,6 +51,41 @@ extern "C" {
  * is used properly. */
 #define UBUF_ALLOC_BLOCK UBASE_FOURCC('b','l','c','k')
 
+/** @This is the number of segments a lookup has to walk before an index of
+ * the segments is built in the head block. */
+#define UBUF_BLOCK_INDEX_THRESHOLD 16
+
+/** @This is the default number of segments above which
+ * @ref ubuf_block_compact merges a block ubuf. */
+#define UBUF_BLOCK_COMPACT_THRESHOLD 32
+
+/** @This is the size under which @ref ubuf_block_append_gather copies
+ * appended ubufs instead of linking them, and the minimum size of the
+ * chunks it allocates. */
+#define UBUF_BLOCK_GATHER_SIZE 4096
+
+/** @This is the maximum size of the chunks allocated by
+ * @ref ubuf_block_append_gather. */
+#define UBUF_BLOCK_GATHER_MAX_SIZE 262144
+
+/** @internal @This is an entry of the segment index. */
+struct ubuf_block_index_entry {
+    /** offset of the segment in the whole block */
+    size_t offset;
+    /** pointer to the ubuf of the segment */
+    struct ubuf *ubuf;
+};
+
+/** @internal @This is an offset to segment lookup index of a segmented block
+ * ubuf, built lazily in the head block and dropped by any operation changing
+ * the layout of the segments. */
+struct ubuf_block_index {
+    /** number of entries */
+    unsigned int count;
+    /** entries, sorted by offset */
+    struct ubuf_block_index_entry entries[];
+};
+
 /** @internal @This is a common section of block ubuf, allowing to segment
  * data. In an opaque area you would typically store a pointer to shared
  * buffer space. It is mandatory for block managers to include this
@@ -76,6 +112,8 @@ struct ubuf_block {
 
     /** cached end ubuf */
     struct ubuf *cached_end_ubuf;
+    /** segment index, or NULL if not built */
+    struct ubuf_block_index *index;
 
     /** common structure */
     struct ubuf ubuf;
@@ -112,6 +150,69 @@ static inline int ubuf_block_size(struct ubuf *ubuf, size_t *size_p)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This drops the segment index of a block ubuf, if any.
+ *
+ * @param block pointer to the head block
+ */
+static inline void ubuf_block_index_clean(struct ubuf_block *block)
+{
+    free(block->index);
+    block->index = NULL;
+}
+
+/** @internal @This builds the segment index of a block ubuf. Failure to
+ * allocate the index is not an error, lookups just walk the segments.
+ *
+ * @param ubuf pointer to head ubuf
+ */
+static inline void ubuf_block_index_build(struct ubuf *ubuf)
+{
+    struct ubuf_block *head_block = ubuf_block_from_ubuf(ubuf);
+    unsigned int count = 0;
+    for (struct ubuf *next = ubuf; next != NULL;
+         next = ubuf_block_from_ubuf(next)->next_ubuf)
+        count++;
+
+    struct ubuf_block_index *index = (struct ubuf_block_index *)
+        malloc(sizeof(struct ubuf_block_index) +
+               count * sizeof(struct ubuf_block_index_entry));
+    if (unlikely(index == NULL))
+        return;
+
+    size_t offset = 0;
+    index->count = count;
+    for (unsigned int i = 0; i < count; i++) {
+        struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
+        index->entries[i].offset = offset;
+        index->entries[i].ubuf = ubuf;
+        offset += block->size;
+        ubuf = block->next_ubuf;
+    }
+    head_block->index = index;
+}
+
+/** @internal @This looks up the last segment starting at or before the given
+ * offset in the segment index.
+ *
+ * @param index pointer to the segment index
+ * @param offset offset in the whole block, in octets
+ * @return pointer to the index entry
+ */
+static inline const struct ubuf_block_index_entry *
+    ubuf_block_index_lookup(const struct ubuf_block_index *index,
+                            size_t offset)
+{
+    unsigned int low = 0, high = index->count;
+    while (high - low > 1) {
+        unsigned int mid = low + (high - low) / 2;
+        if (index->entries[mid].offset <= offset)
+            low = mid;
+        else
+            high = mid;
+    }
+    return &index->entries[low];
+}
+
 /** @internal @This returns the ubuf corresponding to the given offset.
  *
  * @param ubuf pointer to head ubuf
@@ -134,20 +235,35 @@ static inline struct ubuf *ubuf_block_get(struct ubuf *ubuf, int *offset_p,
     if (size_p != NULL && *size_p == -1)
         *size_p = block->total_size - *offset_p;
 
-    if (block->cached_offset <= *offset_p) {
+    if (block->cached_offset <= *offset_p &&
+        (head_block->index == NULL ||
+         *offset_p - block->cached_offset <
+             ubuf_block_from_ubuf(block->cached_ubuf)->size)) {
         *offset_p -= block->cached_offset;
         ubuf = block->cached_ubuf;
         block = ubuf_block_from_ubuf(ubuf);
+    } else if (head_block->index != NULL && *offset_p >= 0) {
+        const struct ubuf_block_index_entry *entry =
+            ubuf_block_index_lookup(head_block->index, *offset_p);
+        *offset_p -= entry->offset;
+        ubuf = entry->ubuf;
+        block = ubuf_block_from_ubuf(ubuf);
     }
 
+    unsigned int walked = 0;
     while (*offset_p >= block->size) {
         *offset_p -= block->size;
         ubuf = block->next_ubuf;
         if (unlikely(ubuf == NULL))
             return NULL;
         block = ubuf_block_from_ubuf(ubuf);
+        walked++;
     }
 
+    if (unlikely(walked >= UBUF_BLOCK_INDEX_THRESHOLD &&
+                 head_block->index == NULL))
+        ubuf_block_index_build(&head_block->ubuf);
+
     head_block->cached_ubuf = ubuf;
     head_block->cached_offset = saved_offset - *offset_p;
     return ubuf;
@@ -283,6 +399,8 @@ static inline int ubuf_block_append(struct ubuf *ubuf, struct ubuf *append)
     struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
     struct ubuf_block *head_block = block;
     struct ubuf_block *append_block = ubuf_block_from_ubuf(append);
+    ubuf_block_index_clean(head_block);
+    ubuf_block_index_clean(append_block);
     block->total_size += append_block->total_size;
 
     if (block->cached_end_ubuf != NULL) {
@@ -346,6 +464,7 @@ static inline int ubuf_block_insert(struct ubuf *ubuf, int offset,
     struct ubuf_block *head_block = ubuf_block_from_ubuf(ubuf);
     if (unlikely((ubuf = ubuf_block_get(ubuf, &offset, NULL)) == NULL))
         return UBASE_ERR_INVALID;
+    ubuf_block_index_clean(head_block);
 
     struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
     if (offset < block->size) {
@@ -353,6 +472,7 @@ static inline int ubuf_block_insert(struct ubuf *ubuf, int offset,
     }
 
     struct ubuf_block *insert_block = ubuf_block_from_ubuf(insert);
+    ubuf_block_index_clean(insert_block);
     head_block->total_size += insert_block->total_size;
 
     if (block->next_ubuf != NULL)
@@ -376,6 +496,7 @@ static inline int ubuf_block_delete(struct ubuf *ubuf, int offset, int size)
     struct ubuf_block *head_block = ubuf_block_from_ubuf(ubuf);
     if (unlikely((ubuf = ubuf_block_get(ubuf, &offset, &size)) == NULL))
         return UBASE_ERR_INVALID;
+    ubuf_block_index_clean(head_block);
     int delete_size = size;
 
     do {
@@ -426,6 +547,7 @@ static inline int ubuf_block_truncate(struct ubuf *ubuf, int offset)
 
     struct ubuf_block *head_block = ubuf_block_from_ubuf(ubuf);
     if (!offset) {
+        ubuf_block_index_clean(head_block);
         if (head_block->next_ubuf != NULL) {
             ubuf_free(head_block->next_ubuf);
             head_block->next_ubuf = NULL;
@@ -441,6 +563,7 @@ static inline int ubuf_block_truncate(struct ubuf *ubuf, int offset)
     offset--;
     if (unlikely((ubuf = ubuf_block_get(ubuf, &offset, NULL)) == NULL))
         return UBASE_ERR_INVALID;
+    ubuf_block_index_clean(head_block);
 
     struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
     if (block->next_ubuf != NULL) {
@@ -509,6 +632,7 @@ static inline int ubuf_block_prepend(struct ubuf *ubuf, int prepend)
     if (prepend > block->offset)
         return UBASE_ERR_INVALID;
 
+    ubuf_block_index_clean(block);
     block->offset -= prepend;
     block->size += prepend;
     block->total_size += prepend;
@@ -516,6 +640,67 @@ static inline int ubuf_block_prepend(struct ubuf *ubuf, int prepend)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This returns the last segment of a block ubuf.
+ *
+ * @param ubuf pointer to head ubuf
+ * @return pointer to the last segment
+ */
+static inline struct ubuf *ubuf_block_tail(struct ubuf *ubuf)
+{
+    struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
+    if (block->cached_end_ubuf != NULL) {
+        ubuf = block->cached_end_ubuf;
+        block = ubuf_block_from_ubuf(ubuf);
+    }
+    while (block->next_ubuf != NULL) {
+        ubuf = block->next_ubuf;
+        block = ubuf_block_from_ubuf(ubuf);
+    }
+    return ubuf;
+}
+
+/** @This returns the spare space after the end of a block ubuf, that
+ * @ref ubuf_block_extend may use without allocating. There is no spare space
+ * if the buffer of the last segment is shared.
+ *
+ * @param ubuf pointer to ubuf
+ * @param tailroom_p filled in with the number of spare octets
+ * @return an error code
+ */
+static inline int ubuf_block_tailroom(struct ubuf *ubuf, size_t *tailroom_p)
+{
+    if (unlikely(ubuf->mgr->signature != UBUF_ALLOC_BLOCK))
+        return UBASE_ERR_INVALID;
+    return ubuf_control(ubuf_block_tail(ubuf), UBUF_SIZE_BLOCK_TAILROOM,
+                        tailroom_p);
+}
+
+/** @This extends a block ubuf into the spare space after its end, if
+ * possible. The content of the new octets is undefined.
+ *
+ * @param ubuf pointer to ubuf
+ * @param append number of octets to append
+ * @return an error code
+ */
+static inline int ubuf_block_extend(struct ubuf *ubuf, int append)
+{
+    assert(append >= 0);
+    if (unlikely(ubuf->mgr->signature != UBUF_ALLOC_BLOCK))
+        return UBASE_ERR_INVALID;
+
+    struct ubuf_block *head_block = ubuf_block_from_ubuf(ubuf);
+    struct ubuf *tail = ubuf_block_tail(ubuf);
+    size_t tailroom;
+    UBASE_RETURN(ubuf_control(tail, UBUF_SIZE_BLOCK_TAILROOM, &tailroom))
+    if (append > tailroom)
+        return UBASE_ERR_INVALID;
+
+    ubuf_block_from_ubuf(tail)->size += append;
+    head_block->total_size += append;
+    head_block->cached_end_ubuf = tail;
+    return UBASE_ERR_NONE;
+}
+
 /** @This duplicates part of a ubuf.
  *
  * @param ubuf pointer to ubuf
@@ -554,6 +739,7 @@ static inline struct ubuf *ubuf_block_split(struct ubuf *ubuf, int offset)
     struct ubuf_block *head_block = ubuf_block_from_ubuf(ubuf);
     if (unlikely((ubuf = ubuf_block_get(ubuf, &offset, NULL)) == NULL))
         return NULL;
+    ubuf_block_index_clean(head_block);
 
     struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
     if (offset < block->size)
@@ -568,6 +754,7 @@ static inline struct ubuf *ubuf_block_split(struct ubuf *ubuf, int offset)
 
     if (new_ubuf != NULL) {
         struct ubuf_block *new_block = ubuf_block_from_ubuf(new_ubuf);
+        ubuf_block_index_clean(new_block);
         new_block->total_size = head_block->total_size - saved_offset;
         new_block->cached_ubuf = new_block->cached_end_ubuf = new_ubuf;
         new_block->cached_offset = 0;
@@ -917,6 +1104,96 @@ static inline int ubuf_block_merge(struct ubuf_mgr *mgr, struct ubuf **ubuf_p,
     return UBASE_ERR_NONE;
 }
 
+/** @This merges a segmented ubuf into a newly allocated non-segmented ubuf
+ * if it is made of more than the given number of segments. It is meant to be
+ * called before data is read many times, for instance by framers, so that the
+ * cost of the copy is paid once instead of walking the segments on every
+ * read.
+ *
+ * @param mgr management structure for this ubuf type
+ * @param ubuf_p reference to a pointer to ubuf to possibly replace with a
+ * non-segmented block ubuf
+ * @param threshold maximum number of segments to tolerate, for instance
+ * @ref UBUF_BLOCK_COMPACT_THRESHOLD
+ * @return an error code
+ */
+static inline int ubuf_block_compact(struct ubuf_mgr *mgr,
+                                     struct ubuf **ubuf_p,
+                                     unsigned int threshold)
+{
+    if (unlikely((*ubuf_p)->mgr->signature != UBUF_ALLOC_BLOCK))
+        return UBASE_ERR_INVALID;
+
+    unsigned int count = 0;
+    for (struct ubuf *ubuf = *ubuf_p; ubuf != NULL;
+         ubuf = ubuf_block_from_ubuf(ubuf)->next_ubuf)
+        if (++count > threshold)
+            return ubuf_block_merge(mgr, ubuf_p, 0, -1);
+    return UBASE_ERR_NONE;
+}
+
+/** @This appends a ubuf at the end of a block ubuf, copying it into the
+ * spare space of the last segment when it is small, so that reassembling
+ * many small slices (for instance TS payloads) allocates one segment per
+ * chunk instead of one per slice. Chunks are allocated from the manager of
+ * the appended ubuf, with a size growing with the block ubuf. Large ubufs,
+ * or small ones if no chunk can be allocated, are linked as with
+ * @ref ubuf_block_append.
+ *
+ * @param ubuf pointer to ubuf
+ * @param append pointer to ubuf to be appended; it must no longer be used
+ * afterwards as it is either freed or included in the segmented ubuf
+ * @return an error code
+ */
+static inline int ubuf_block_append_gather(struct ubuf *ubuf,
+                                           struct ubuf *append)
+{
+    if (unlikely(ubuf->mgr->signature != UBUF_ALLOC_BLOCK ||
+                 append->mgr->signature != UBUF_ALLOC_BLOCK))
+        return UBASE_ERR_INVALID;
+
+    struct ubuf_block *head_block = ubuf_block_from_ubuf(ubuf);
+    struct ubuf_block *append_block = ubuf_block_from_ubuf(append);
+    int append_size = append_block->total_size;
+    int offset = head_block->total_size;
+    if (append_size >= UBUF_BLOCK_GATHER_SIZE)
+        return ubuf_block_append(ubuf, append);
+
+    if (!ubase_check(ubuf_block_extend(ubuf, append_size))) {
+        int chunk_size = offset;
+        if (chunk_size < UBUF_BLOCK_GATHER_SIZE)
+            chunk_size = UBUF_BLOCK_GATHER_SIZE;
+        else if (chunk_size > UBUF_BLOCK_GATHER_MAX_SIZE)
+            chunk_size = UBUF_BLOCK_GATHER_MAX_SIZE;
+        struct ubuf *chunk = ubuf_block_alloc(append->mgr, chunk_size);
+        if (unlikely(chunk == NULL))
+            return ubuf_block_append(ubuf, append);
+        ubuf_block_truncate(chunk, 0);
+        ubuf_block_append(ubuf, chunk);
+        if (unlikely(!ubase_check(ubuf_block_extend(ubuf, append_size)))) {
+            ubuf_block_truncate(ubuf, offset);
+            return ubuf_block_append(ubuf, append);
+        }
+    }
+
+    int size = append_size;
+    uint8_t *buffer;
+    if (unlikely(!ubase_check(ubuf_block_write(ubuf, offset, &size,
+                                               &buffer)))) {
+        ubuf_block_truncate(ubuf, offset);
+        return ubuf_block_append(ubuf, append);
+    }
+    assert(size == append_size);
+    int err = ubuf_block_extract(append, 0, append_size, buffer);
+    ubuf_block_unmap(ubuf, offset);
+    if (unlikely(!ubase_check(err))) {
+        ubuf_block_truncate(ubuf, offset);
+        return ubuf_block_append(ubuf, append);
+    }
+    ubuf_free(append);
+    return UBASE_ERR_NONE;
+}
+
 /** @This allocates a new ubuf and copies data from an opaque pointer to it.
  *
  * @param mgr management structure for this ubuf type
@@ -1066,6 +1343,21 @@ static inline int ubuf_block_scan(struct ubuf *ubuf, size_t *offset_p,
     return UBASE_ERR_INVALID;
 }
 
+/** @This scans for an octet word repeated at a given stride in a block ubuf,
+ * for instance the sync words of consecutive TS packets.
+ *
+ * @param ubuf pointer to ubuf
+ * @param offset_p start offset (in octets), written with the offset of the
+ * first wanted word, or first candidate if there aren't enough octets in the
+ * ubuf, or the total size of the ubuf if none was found
+ * @param word word to scan for
+ * @param stride distance between two occurrences of the word, in octets
+ * @param nb number of occurrences of the word
+ * @return UBASE_ERR_NONE if the word was found
+ */
+int ubuf_block_scan_stride(struct ubuf *ubuf, size_t *offset_p,
+                           uint8_t word, size_t stride, unsigned int nb);
+
 /** @This finds a multi-octet word in a block ubuf.
  *
  * @param ubuf pointer to ubuf
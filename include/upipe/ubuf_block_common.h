@@ -60,6 +60,7 @@ static inline void ubuf_block_common_init(struct ubuf *ubuf, bool map)
 
     block->cached_ubuf = block->cached_end_ubuf = ubuf;
     block->cached_offset = 0;
+    block->index = NULL;
     uchain_init(&ubuf->uchain);
 }
 
@@ -179,6 +180,7 @@ static inline int ubuf_block_common_splice(struct ubuf *ubuf,
 static inline void ubuf_block_common_clean(struct ubuf *ubuf)
 {
     struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
+    ubuf_block_index_clean(block);
     struct ubuf *next_ubuf = block->next_ubuf;
     while (next_ubuf != NULL) {
         struct ubuf_block *next_block = ubuf_block_from_ubuf(next_ubuf);
@@ -39,14 +39,21 @@ extern "C" {
 #include <upipe/ubuf_block.h>
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /** @hidden */
 struct umem_mgr;
+/** @hidden */
+struct umem;
 
+/** @This is the signature of a ubuf block mem manager. */
+#define UBUF_BLOCK_MEM_SIGNATURE UBASE_FOURCC('m','e','m','b')
 /** @This is the signature to use to allocate from an ubuf_pic plane. */
 #define UBUF_BLOCK_MEM_ALLOC_FROM_PIC UBASE_FOURCC('m','e','m','p')
 /** @This is the signature to use to allocate from an ubuf_sound plane. */
 #define UBUF_BLOCK_MEM_ALLOC_FROM_SOUND UBASE_FOURCC('m','e','m','s')
+/** @This is the signature to use to allocate from an existing umem. */
+#define UBUF_BLOCK_MEM_ALLOC_FROM_UMEM UBASE_FOURCC('m','e','m','u')
 
 /** @This returns a new ubuf from the block mem allocator, using a chroma of
  * a ubuf pic mem.
@@ -76,6 +83,76 @@ static inline struct ubuf *ubuf_block_mem_alloc_from_sound(struct ubuf_mgr *mgr,
     return ubuf_alloc(mgr, UBUF_BLOCK_MEM_ALLOC_FROM_SOUND, ubuf_sound, channel);
 }
 
+/** @This returns a new ubuf from the block mem allocator, pointing to the
+ * whole buffer of an existing umem, which may have been allocated by another
+ * umem manager (for instance a file mapping). In case of success, the ubuf
+ * takes ownership of the umem, which is freed with the last reference.
+ *
+ * @param mgr management structure for this ubuf type
+ * @param umem umem structure to use, left untouched in case of failure
+ * @return pointer to ubuf or NULL in case of failure
+ */
+static inline struct ubuf *ubuf_block_mem_alloc_from_umem(struct ubuf_mgr *mgr,
+        struct umem *umem)
+{
+    return ubuf_alloc(mgr, UBUF_BLOCK_MEM_ALLOC_FROM_UMEM, umem);
+}
+
+/** @This extends ubuf_mgr_command with specific commands for block mem
+ * manager. */
+enum ubuf_block_mem_mgr_command {
+    UBUF_BLOCK_MEM_MGR_SENTINEL = UBUF_MGR_CONTROL_LOCAL,
+
+    /** counts references of new buffers without atomic operations (int) */
+    UBUF_BLOCK_MEM_MGR_SET_LOCAL,
+    /** allocates small blocks from slab elements (unsigned int,
+     * unsigned int) */
+    UBUF_BLOCK_MEM_MGR_SET_SLAB
+};
+
+/** @This makes the manager count references to the buffers it allocates
+ * with plain arithmetic instead of atomic operations, which speeds up
+ * @ref ubuf_dup and @ref ubuf_block_splice. Buffers must then only be
+ * referenced from the thread which allocated them, until @ref ubuf_share
+ * is called (which the queue sink does for every uref it transmits).
+ * Buffers allocated from pictures and sounds keep the counters of their
+ * original managers. Local mode may only be enabled while the caller holds
+ * the only reference to the manager, typically right after allocating it in
+ * a source which outputs from its own thread, and the manager must then not
+ * be handed to pipes running in other threads, such as the remote side of
+ * an xfer pipe or a worker.
+ *
+ * @param mgr pointer to a ubuf_mgr structure
+ * @param local true to enable thread-local reference counts
+ * @return an error code, UBASE_ERR_BUSY if the manager is already shared
+ */
+static inline int ubuf_block_mem_mgr_set_local(struct ubuf_mgr *mgr,
+                                               bool local)
+{
+    return ubuf_mgr_control(mgr, UBUF_BLOCK_MEM_MGR_SET_LOCAL,
+                            UBUF_BLOCK_MEM_SIGNATURE, local ? 1 : 0);
+}
+
+/** @This makes the manager allocate blocks whose buffer (including prepend,
+ * append and alignment) fits in the given size from a pool of slab
+ * elements, each carrying the ubuf, its shared structure and the buffer in
+ * a single cache-line aligned allocation, instead of three separate pool
+ * operations. Typically a size of 256 octets covers TS packets. It may only
+ * be called once, on initializing the manager.
+ *
+ * @param mgr pointer to a ubuf_mgr structure
+ * @param size size of the buffer of slab elements
+ * @param depth maximum number of elements kept in the pool
+ * @return an error code
+ */
+static inline int ubuf_block_mem_mgr_set_slab(struct ubuf_mgr *mgr,
+                                              unsigned int size,
+                                              unsigned int depth)
+{
+    return ubuf_mgr_control(mgr, UBUF_BLOCK_MEM_MGR_SET_SLAB,
+                            UBUF_BLOCK_MEM_SIGNATURE, size, depth);
+}
+
 /** @This allocates a new instance of the ubuf manager for block formats
  * using umem.
  *
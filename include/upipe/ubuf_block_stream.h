@@ -130,6 +130,27 @@ static inline int ubuf_block_stream_position(struct ubuf_block_stream *s)
     return (s->offset + s->size - (s->end - s->buffer)) * 8 - s->available;
 }
 
+/** @internal @This maps the block section following the current one.
+ *
+ * @param s helper structure
+ * @return an error code
+ */
+static inline int ubuf_block_stream_next(struct ubuf_block_stream *s)
+{
+    if (s->ubuf == NULL)
+        return UBASE_ERR_INVALID;
+    ubuf_block_unmap(s->ubuf, s->offset);
+    s->offset += s->size;
+    s->size = -1;
+    if (unlikely(!ubase_check(ubuf_block_read(s->ubuf, s->offset,
+                                              &s->size, &s->buffer)))) {
+        s->ubuf = NULL;
+        return UBASE_ERR_INVALID;
+    }
+    s->end = s->buffer + s->size;
+    return UBASE_ERR_NONE;
+}
+
 /** @This gets the next octet in the ubuf.
  *
  * @param s helper structure
@@ -139,19 +160,8 @@ static inline int ubuf_block_stream_position(struct ubuf_block_stream *s)
 static inline int ubuf_block_stream_get(struct ubuf_block_stream *s,
                                         uint8_t *octet_p)
 {
-    if (unlikely(s->buffer >= s->end)) {
-        if (s->ubuf == NULL)
-            return UBASE_ERR_INVALID;
-        ubuf_block_unmap(s->ubuf, s->offset);
-        s->offset += s->size;
-        s->size = -1;
-        if (unlikely(!ubase_check(ubuf_block_read(s->ubuf, s->offset,
-                                                  &s->size, &s->buffer)))) {
-            s->ubuf = NULL;
-            return UBASE_ERR_INVALID;
-        }
-        s->end = s->buffer + s->size;
-    }
+    if (unlikely(s->buffer >= s->end))
+        UBASE_RETURN(ubuf_block_stream_next(s))
     *octet_p = *s->buffer++;
     return UBASE_ERR_NONE;
 }
@@ -204,6 +214,123 @@ static inline int ubuf_block_stream_get(struct ubuf_block_stream *s,
         (s)->available -= (nb);                                             \
     } while (0)
 
+/** @This reads the given number of bits (up to 24) from the stream.
+ *
+ * @param s helper structure
+ * @param nb number of bits to read
+ * @return bits read
+ */
+static inline uint32_t ubuf_block_stream_read_bits(struct ubuf_block_stream *s,
+                                                   uint32_t nb)
+{
+    assert(nb <= 24);
+    ubuf_block_stream_fill_bits(s, nb);
+    uint32_t bits = nb ? ubuf_block_stream_show_bits(s, nb) : 0;
+    ubuf_block_stream_skip_bits(s, nb);
+    return bits;
+}
+
+/** @This reads the given number of octets from the stream, copying whole
+ * block sections at once when the stream is octet-aligned. Octets past the
+ * end of the ubuf are read as 0.
+ *
+ * @param s helper structure
+ * @param size number of octets to read
+ * @param buffer buffer to copy the octets to, or NULL to skip them
+ * @return an error code
+ */
+static inline int ubuf_block_stream_read(struct ubuf_block_stream *s,
+                                         int size, uint8_t *buffer)
+{
+    if (s->available % 8) {
+        while (size-- > 0) {
+            uint32_t octet = ubuf_block_stream_read_bits(s, 8);
+            if (buffer != NULL)
+                *buffer++ = octet;
+        }
+        return s->overflow ? UBASE_ERR_INVALID : UBASE_ERR_NONE;
+    }
+
+    while (size > 0 && s->available) {
+        if (buffer != NULL)
+            *buffer++ = ubuf_block_stream_show_bits(s, 8);
+        ubuf_block_stream_skip_bits(s, 8);
+        size--;
+    }
+
+    while (size > 0) {
+        if (unlikely(s->buffer >= s->end &&
+                     !ubase_check(ubuf_block_stream_next(s)))) {
+            if (buffer != NULL)
+                memset(buffer, 0, size);
+            s->overflow = true;
+            return UBASE_ERR_INVALID;
+        }
+        int chunk = s->end - s->buffer;
+        if (chunk > size)
+            chunk = size;
+        if (buffer != NULL) {
+            memcpy(buffer, s->buffer, chunk);
+            buffer += chunk;
+        }
+        s->buffer += chunk;
+        size -= chunk;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @This skips the given number of octets in the stream, without mapping
+ * the block sections in between more than once.
+ *
+ * @param s helper structure
+ * @param size number of octets to skip
+ * @return an error code
+ */
+static inline int ubuf_block_stream_skip(struct ubuf_block_stream *s,
+                                         int size)
+{
+    return ubuf_block_stream_read(s, size, NULL);
+}
+
+/** @This copies the given number of octets from the stream without
+ * consuming them. The stream must be octet-aligned.
+ *
+ * @param s helper structure
+ * @param size number of octets to peek
+ * @param buffer buffer to copy the octets to
+ * @return an error code
+ */
+static inline int ubuf_block_stream_peek(struct ubuf_block_stream *s,
+                                         int size, uint8_t *buffer)
+{
+    if (unlikely(s->available % 8))
+        return UBASE_ERR_INVALID;
+
+    uint32_t bits = s->bits;
+    uint32_t available = s->available;
+    while (size > 0 && available) {
+        *buffer++ = bits >> 24;
+        bits <<= 8;
+        available -= 8;
+        size--;
+    }
+
+    int chunk = s->end - s->buffer;
+    if (chunk > size)
+        chunk = size;
+    if (chunk > 0) {
+        memcpy(buffer, s->buffer, chunk);
+        buffer += chunk;
+        size -= chunk;
+    }
+
+    if (size <= 0)
+        return UBASE_ERR_NONE;
+    if (s->ubuf == NULL)
+        return UBASE_ERR_INVALID;
+    return ubuf_block_extract(s->ubuf, s->offset + s->size, size, buffer);
+}
+
 /** @This initializes the helper structure for octet stream using a ubuf,
  * with an offset in bits
  *
@@ -46,6 +46,9 @@ extern "C" {
 struct ubuf_mem_shared {
     /** number of blocks pointing to the memory area */
     uatomic_uint32_t refcount;
+    /** number of blocks while the memory area is confined to a single
+     * thread, or 0 if the atomic counter is in use */
+    uint32_t local;
     /** pointer to origin pool */
     struct upool *pool;
     /** umem structure pointing to buffer */
@@ -60,7 +63,10 @@ struct ubuf_mem_shared {
 static inline struct ubuf_mem_shared *
     ubuf_mem_shared_use(struct ubuf_mem_shared *shared)
 {
-    uatomic_fetch_add(&shared->refcount, 1);
+    if (shared->local)
+        shared->local++;
+    else
+        uatomic_fetch_add(&shared->refcount, 1);
     return shared;
 }
 
@@ -71,6 +77,8 @@ static inline struct ubuf_mem_shared *
  */
 static inline bool ubuf_mem_shared_release(struct ubuf_mem_shared *shared)
 {
+    if (shared->local)
+        return --shared->local == 0;
     return uatomic_fetch_sub(&shared->refcount, 1) == 1;
 }
 
@@ -81,9 +89,38 @@ static inline bool ubuf_mem_shared_release(struct ubuf_mem_shared *shared)
  */
 static inline bool ubuf_mem_shared_single(struct ubuf_mem_shared *shared)
 {
+    if (shared->local)
+        return shared->local == 1;
     return uatomic_load(&shared->refcount) == 1;
 }
 
+/** @This switches a newly allocated shared buffer to thread-local reference
+ * counting, with plain arithmetic instead of atomic operations. The buffer
+ * must then only be referenced by the current thread, until
+ * @ref ubuf_mem_shared_share is called.
+ *
+ * @param shared pointer to shared buffer, with a single reference
+ */
+static inline void ubuf_mem_shared_set_local(struct ubuf_mem_shared *shared)
+{
+    shared->local = 1;
+}
+
+/** @This switches a shared buffer to atomic reference counting, before it
+ * is handed over to another thread. It does nothing if the reference count
+ * is already atomic.
+ *
+ * @param shared pointer to shared buffer
+ */
+static inline void ubuf_mem_shared_share(struct ubuf_mem_shared *shared)
+{
+    if (likely(!shared->local))
+        return;
+    uint32_t local = shared->local;
+    shared->local = 0;
+    uatomic_store(&shared->refcount, local);
+}
+
 /** @This returns the shared buffer.
  *
  * @param shared pointer to shared buffer
@@ -219,6 +256,7 @@ static struct ubuf_mem_shared                                               \
     if (unlikely(shared == NULL))                                           \
         return NULL;                                                        \
     uatomic_store(&shared->refcount, 1);                                    \
+    shared->local = 0;                                                      \
     return shared;                                                          \
 }                                                                           \
 /** @internal @This deallocates a data structure or places it back into     \
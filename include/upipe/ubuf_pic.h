@@ -324,6 +324,54 @@ static inline int ubuf_pic_resize(struct ubuf *ubuf, int hskip, int vskip,
                         new_hsize, new_vsize);
 }
 
+/** @This blends a line of 8-bit samples into another one,
+ * with dst = (dst * (0xff - a) + src * a) / 0xff.
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param alpha_plane alpha values, or NULL to use alpha for all samples
+ * @param alpha_hsub horizontal subsampling of the samples relative to the
+ * alpha values
+ * @param samples number of samples
+ * @param alpha alpha multiplier
+ */
+void ubuf_pic_blend_8(uint8_t *dst, const uint8_t *src,
+                      const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                      int samples, uint8_t alpha);
+
+/** @This blends a line of 16-bit samples into another one.
+ *
+ * @see ubuf_pic_blend_8
+ */
+void ubuf_pic_blend_16(uint16_t *dst, const uint16_t *src,
+                       const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                       int samples, uint8_t alpha);
+
+/** @This copies the 8-bit samples of a line whose alpha value, multiplied
+ * by alpha / 0xff, is more than a threshold.
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param alpha_plane alpha values
+ * @param alpha_hsub horizontal subsampling of the samples relative to the
+ * alpha values
+ * @param samples number of samples
+ * @param alpha alpha multiplier
+ * @param threshold alpha threshold
+ */
+void ubuf_pic_key_8(uint8_t *dst, const uint8_t *src,
+                    const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                    int samples, uint8_t alpha, uint8_t threshold);
+
+/** @This copies the 16-bit samples of a line whose alpha value is more than
+ * a threshold.
+ *
+ * @see ubuf_pic_key_8
+ */
+void ubuf_pic_key_16(uint16_t *dst, const uint16_t *src,
+                     const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                     int samples, uint8_t alpha, uint8_t threshold);
+
 /** @This blits a picture ubuf to another ubuf.
  *
  * @param dest destination ubuf
@@ -400,44 +448,40 @@ static inline int ubuf_pic_blit_alpha(struct ubuf *dest, struct ubuf *src,
                           src_macropixel_size;
         int plane_vsize = extract_vsize / src_vsub;
 
+        /* planes of 16-bit samples are blended by sample */
+        bool words = src_macropixel_size == 2 * src_macropixel;
+        const uint8_t *alpha_line = alpha_plane;
+
         for (int i = 0; i < plane_vsize; i++) {
             if ((!alpha_plane && alpha == 0xff) || threshold == 0) {
                 memcpy(dest_buffer, src_buffer, plane_hsize);
-            } else if (!alpha_plane) {
-                for (int j = 0; j < plane_hsize; j++) {
-                    dest_buffer[j] = (dest_buffer[j] * (0xff - alpha) + src_buffer[j] * alpha) / 0xff;
-                }
-            } else if (threshold != 0xff) {
+            } else if (!alpha_plane || threshold == 0xff) {
+                /* smooth blending */
+                if (words)
+                    ubuf_pic_blend_16((uint16_t *)dest_buffer,
+                                      (const uint16_t *)src_buffer,
+                                      alpha_line, src_hsub, plane_hsize / 2,
+                                      alpha);
+                else
+                    ubuf_pic_blend_8(dest_buffer, src_buffer, alpha_line,
+                                     src_hsub, plane_hsize, alpha);
+            } else {
                 /* This is an on/off blending
                  * if alpha is over the threshold, we use the subpicture pixel.
                  */
-                if (alpha == 0xff) {
-                    for (int j = 0; j < plane_hsize; j++) {
-                        const uint8_t a = alpha_plane[alpha_stride * (i * src_vsub) + j * src_hsub];
-                        if (a > threshold) dest_buffer[j] = src_buffer[j];
-                    }
-                } else {
-                    for (int j = 0; j < plane_hsize; j++) {
-                        const uint8_t a = (uint16_t)alpha_plane[alpha_stride * (i * src_vsub) + j * src_hsub] * (uint16_t)alpha / 0xff;
-                        if (a > threshold) dest_buffer[j] = src_buffer[j];
-                    }
-                }
-            } else {
-                /* smooth and slow blending */
-                if (alpha == 0xff) {
-                    for (int j = 0; j < plane_hsize; j++) {
-                        const uint8_t a = alpha_plane[alpha_stride * (i * src_vsub) + j * src_hsub];
-                        dest_buffer[j] = (dest_buffer[j] * (0xff - a) + src_buffer[j] * a) / 0xff;
-                    }
-                } else {
-                    for (int j = 0; j < plane_hsize; j++) {
-                        const uint8_t a = (uint16_t)alpha_plane[alpha_stride * (i * src_vsub) + j * src_hsub] * (uint16_t)alpha / 0xff;
-                        dest_buffer[j] = (dest_buffer[j] * (0xff - a) + src_buffer[j] * a) / 0xff;
-                    }
-                }
+                if (words)
+                    ubuf_pic_key_16((uint16_t *)dest_buffer,
+                                    (const uint16_t *)src_buffer,
+                                    alpha_line, src_hsub, plane_hsize / 2,
+                                    alpha, threshold);
+                else
+                    ubuf_pic_key_8(dest_buffer, src_buffer, alpha_line,
+                                   src_hsub, plane_hsize, alpha, threshold);
             }
             dest_buffer += dest_stride;
             src_buffer += src_stride;
+            if (alpha_line != NULL)
+                alpha_line += alpha_stride * src_vsub;
         }
 
         err = ubuf_pic_plane_unmap(dest, chroma,
@@ -477,7 +521,9 @@ static inline int ubuf_pic_blit(struct ubuf *dest, struct ubuf *src,
     size_t alpha_stride = 0;
     int ret;
 
-    if (!ubase_check(ubuf_pic_plane_read(src, "a8", 0, 0, -1, -1, &alpha_plane))) {
+    if (!ubase_check(ubuf_pic_plane_read(src, "a8", src_hoffset, src_voffset,
+                                         extract_hsize, extract_vsize,
+                                         &alpha_plane))) {
         alpha_plane = NULL;
     } else if (unlikely(!ubase_check(ubuf_pic_plane_size(src, "a8", &alpha_stride,
                             NULL, NULL, NULL)))) {
@@ -492,7 +538,8 @@ static inline int ubuf_pic_blit(struct ubuf *dest, struct ubuf *src,
 
 end:
     if (alpha_plane)
-        ubuf_pic_plane_unmap(src, "a8", 0, 0, -1, -1);
+        ubuf_pic_plane_unmap(src, "a8", src_hoffset, src_voffset,
+                             extract_hsize, extract_vsize);
 
     return ret;
 }
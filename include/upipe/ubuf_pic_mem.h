@@ -78,6 +78,34 @@ static inline int ubuf_pic_mem_get_shared(struct ubuf *ubuf,
                         offset_p, size_p);
 }
 
+/** @This extends ubuf_mgr_command with specific commands for pic mem
+ * manager. */
+enum ubuf_pic_mem_mgr_command {
+    UBUF_PIC_MEM_MGR_SENTINEL = UBUF_MGR_CONTROL_LOCAL,
+
+    /** enables the exact-size frame pool (unsigned int) */
+    UBUF_PIC_MEM_MGR_SET_FRAME_POOL
+};
+
+/** @This enables a pool of frames of the exact size of the pictures
+ * allocated by the manager. Released buffers are kept aside and given to the
+ * next picture of the same dimensions, instead of going back to the umem
+ * allocator, whose size classes typically round large frames up to the next
+ * power of 2. Frame buffers are then allocated with their exact size. It
+ * may only be called on initializing the manager, before any ubuf is
+ * allocated.
+ *
+ * @param mgr pointer to a ubuf_mgr structure
+ * @param depth maximum number of frames kept in the pool
+ * @return an error code
+ */
+static inline int ubuf_pic_mem_mgr_set_frame_pool(struct ubuf_mgr *mgr,
+                                                  unsigned int depth)
+{
+    return ubuf_mgr_control(mgr, UBUF_PIC_MEM_MGR_SET_FRAME_POOL,
+                            UBUF_PIC_MEM_SIGNATURE, depth);
+}
+
 /** @This allocates a new instance of the ubuf manager for picture formats
  * using umem.
  *
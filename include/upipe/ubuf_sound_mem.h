@@ -43,6 +43,8 @@ extern "C" {
 /** @This is a simple signature to make sure the ubuf_control internal API
  * is used properly. */
 #define UBUF_SOUND_MEM_SIGNATURE UBASE_FOURCC('m','e','m','s')
+/** @This is the signature to use to allocate a view of another sound ubuf. */
+#define UBUF_SOUND_MEM_ALLOC_VIEW UBASE_FOURCC('m','e','m','v')
 
 /** @hidden */
 struct umem_mgr;
@@ -77,6 +79,26 @@ static inline int ubuf_sound_mem_get_shared(struct ubuf *ubuf,
                         offset_p, size_p);
 }
 
+/** @This returns a new ubuf from the sound mem allocator, mapping planes of
+ * another ubuf sound mem without copying the samples. It allows to extract
+ * a subset of the channels of a planar buffer, or to rename them. The
+ * samples are only copied if the view is written to while the original
+ * buffer is still in use.
+ *
+ * @param mgr management structure for this ubuf type, with the same sample
+ * size as the original ubuf
+ * @param ubuf_orig ubuf sound mem structure to map
+ * @param channels for each plane of the manager, channel of the original
+ * ubuf to map (see channel reference), or NULL to use the same channels as
+ * the manager
+ * @return pointer to ubuf or NULL in case of failure
+ */
+static inline struct ubuf *ubuf_sound_mem_alloc_view(struct ubuf_mgr *mgr,
+        struct ubuf *ubuf_orig, const char *const *channels)
+{
+    return ubuf_alloc(mgr, UBUF_SOUND_MEM_ALLOC_VIEW, ubuf_orig, channels);
+}
+
 /** @This allocates a new instance of the ubuf manager for sound formats
  * using umem.
  *
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short Upipe implementation of uclock based on the CPU time-stamp counter
+ * This clock reads the invariant time-stamp counter of the CPU (RDTSC on
+ * x86, CNTVCT on ARMv8) instead of calling clock_gettime() on every
+ * timestamp. The counter is converted to the 27 MHz clock with a scale that
+ * is recalibrated every second against the monotonic system clock, so that
+ * both clocks never drift apart.
+ */
+
+#ifndef _UPIPE_UCLOCK_TSC_H_
+/** @hidden */
+#define _UPIPE_UCLOCK_TSC_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/uclock.h>
+
+/** @This allocates a new uclock structure based on the time-stamp counter.
+ * If the CPU has no invariant counter, a standard monotonic uclock (see
+ * @ref uclock_std_alloc) is returned instead.
+ *
+ * @return pointer to uclock, or NULL in case of error
+ */
+struct uclock *uclock_tsc_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
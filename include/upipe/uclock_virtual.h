@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short Upipe virtual implementation of uclock
+ * This clock doesn't follow the system time. It only moves forward when it
+ * is told to, typically by an event loop which advances it to the date of
+ * its next timer instead of sleeping (see @ref upump_mgr_set_virtual_clock).
+ * A graph driven by such a clock runs as fast as the CPU allows.
+ */
+
+#ifndef _UPIPE_UCLOCK_VIRTUAL_H_
+/** @hidden */
+#define _UPIPE_UCLOCK_VIRTUAL_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/uclock.h>
+
+/** @This allocates a new virtual uclock structure. Conversions to and from
+ * real time are anchored on the real time at allocation.
+ *
+ * @param start initial date of the clock, in 27 MHz ticks
+ * @return pointer to uclock, or NULL in case of error
+ */
+struct uclock *uclock_virtual_alloc(uint64_t start);
+
+/** @This advances a virtual uclock to the given date. Dates in the past
+ * are ignored, as the clock is monotonic. The clock must only be advanced
+ * from a single thread.
+ *
+ * @param uclock pointer to uclock
+ * @param date new date, in 27 MHz ticks
+ * @return an error code, including @ref UBASE_ERR_INVALID if the uclock is
+ * not virtual
+ */
+int uclock_virtual_advance(struct uclock *uclock, uint64_t date);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
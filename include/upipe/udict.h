@@ -168,6 +168,9 @@ enum udict_command {
     /** name a shorthand attribute (enum udict_type, const char **,
      * enum udict_type *) */
     UDICT_NAME,
+    /** get a hash of the attributes, independent of their order
+     * (uint64_t *) */
+    UDICT_HASH,
 
     /** non-standard commands implemented by a module type can start from
      * there (first arg = signature) */
@@ -279,6 +282,20 @@ static inline struct udict *udict_dup(struct udict *udict)
     return dup_udict;
 }
 
+/** @This returns a hash of the contents of a udict. Two udicts which
+ * compare equal with @ref udict_cmp have the same hash; the converse is
+ * not guaranteed.
+ *
+ * @param udict pointer to the udict
+ * @param hash_p filled in with the hash
+ * @return an error code, UBASE_ERR_UNHANDLED if the udict manager doesn't
+ * support hashing
+ */
+static inline int udict_hash(struct udict *udict, uint64_t *hash_p)
+{
+    return udict_control(udict, UDICT_HASH, hash_p);
+}
+
 /** @This finds an attribute of the given name and type and returns
  * the name and type of the next attribute.
  *
@@ -942,6 +959,28 @@ static inline int udict_cmp(struct udict *udict1, struct udict *udict2)
     return 0;
 }
 
+/** @This checks if two udicts have the same attributes, using the cached
+ * hashes to quickly rule out different udicts.
+ *
+ * @param udict1 pointer to the first udict (may be NULL)
+ * @param udict2 pointer to the second udict (may be NULL)
+ * @return true if both udicts have the same attributes
+ */
+static inline bool udict_equal_fast(struct udict *udict1,
+                                    struct udict *udict2)
+{
+    if (udict1 == udict2)
+        return true;
+    if (udict1 == NULL || udict2 == NULL)
+        return false;
+
+    uint64_t hash1, hash2;
+    if (ubase_check(udict_hash(udict1, &hash1)) &&
+        ubase_check(udict_hash(udict2, &hash2)) && hash1 != hash2)
+        return false;
+    return !udict_cmp(udict1, udict2);
+}
+
 /** @This increments the reference count of a udict manager.
  *
  * @param mgr pointer to udict manager
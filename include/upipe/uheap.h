@@ -0,0 +1,288 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe binary heaps of structures keyed on a date (NOT thread-safe)
+ *
+ * The elements embed a struct uheap_node, and the heap keeps an array of
+ * pointers to them, so that the element with the smallest key is found in
+ * constant time, and elements are inserted or removed in logarithmic time.
+ */
+
+#ifndef _UPIPE_UHEAP_H_
+/** @hidden */
+#define _UPIPE_UHEAP_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+
+/** minimum number of allocated slots */
+#define UHEAP_MIN_ALLOC 16
+
+/** @This is the structure to embed in the elements of a uheap. */
+struct uheap_node {
+    /** key of the element */
+    uint64_t key;
+    /** position of the element in the heap, or UINT_MAX */
+    unsigned int index;
+};
+
+/** @This is a binary min-heap. */
+struct uheap {
+    /** array of elements */
+    struct uheap_node **nodes;
+    /** number of elements */
+    unsigned int size;
+    /** number of allocated slots */
+    unsigned int allocated;
+};
+
+/** @This initializes a node which is not in a heap.
+ *
+ * @param node pointer to a node
+ */
+static inline void uheap_node_init(struct uheap_node *node)
+{
+    node->key = 0;
+    node->index = UINT_MAX;
+}
+
+/** @This checks if a node is in a heap.
+ *
+ * @param node pointer to a node
+ * @return true if the node is in a heap
+ */
+static inline bool uheap_node_is_in(struct uheap_node *node)
+{
+    return node->index != UINT_MAX;
+}
+
+/** @This initializes a uheap.
+ *
+ * @param uheap pointer to a uheap
+ */
+static inline void uheap_init(struct uheap *uheap)
+{
+    uheap->nodes = NULL;
+    uheap->size = 0;
+    uheap->allocated = 0;
+}
+
+/** @This releases the memory of a uheap. The elements are not freed.
+ *
+ * @param uheap pointer to a uheap
+ */
+static inline void uheap_clean(struct uheap *uheap)
+{
+    for (unsigned int i = 0; i < uheap->size; i++)
+        uheap->nodes[i]->index = UINT_MAX;
+    free(uheap->nodes);
+    uheap_init(uheap);
+}
+
+/** @This returns the number of elements of a uheap.
+ *
+ * @param uheap pointer to a uheap
+ * @return number of elements
+ */
+static inline unsigned int uheap_size(struct uheap *uheap)
+{
+    return uheap->size;
+}
+
+/** @This checks if a uheap is empty.
+ *
+ * @param uheap pointer to a uheap
+ * @return true if the uheap is empty
+ */
+static inline bool uheap_empty(struct uheap *uheap)
+{
+    return !uheap->size;
+}
+
+/** @This returns the element with the smallest key, without removing it.
+ *
+ * @param uheap pointer to a uheap
+ * @return pointer to the node, or NULL if the uheap is empty
+ */
+static inline struct uheap_node *uheap_peek(struct uheap *uheap)
+{
+    return uheap->size ? uheap->nodes[0] : NULL;
+}
+
+/** @This returns the element at the given position of the array, to walk
+ * through all elements in no particular order.
+ *
+ * @param uheap pointer to a uheap
+ * @param index position in the array
+ * @return pointer to the node, or NULL if the position is out of range
+ */
+static inline struct uheap_node *uheap_at(struct uheap *uheap,
+                                          unsigned int index)
+{
+    return index < uheap->size ? uheap->nodes[index] : NULL;
+}
+
+/** @internal @This puts a node at the given position.
+ *
+ * @param uheap pointer to a uheap
+ * @param index position in the array
+ * @param node pointer to a node
+ */
+static inline void uheap_place(struct uheap *uheap, unsigned int index,
+                               struct uheap_node *node)
+{
+    uheap->nodes[index] = node;
+    node->index = index;
+}
+
+/** @internal @This moves a node towards the root until the heap is ordered.
+ *
+ * @param uheap pointer to a uheap
+ * @param index position of the node
+ */
+static inline void uheap_sift_up(struct uheap *uheap, unsigned int index)
+{
+    struct uheap_node *node = uheap->nodes[index];
+    while (index) {
+        unsigned int parent = (index - 1) / 2;
+        if (uheap->nodes[parent]->key <= node->key)
+            break;
+        uheap_place(uheap, index, uheap->nodes[parent]);
+        index = parent;
+    }
+    uheap_place(uheap, index, node);
+}
+
+/** @internal @This moves a node towards the leaves until the heap is
+ * ordered.
+ *
+ * @param uheap pointer to a uheap
+ * @param index position of the node
+ */
+static inline void uheap_sift_down(struct uheap *uheap, unsigned int index)
+{
+    struct uheap_node *node = uheap->nodes[index];
+    for ( ; ; ) {
+        unsigned int child = 2 * index + 1;
+        if (child >= uheap->size)
+            break;
+        if (child + 1 < uheap->size &&
+            uheap->nodes[child + 1]->key < uheap->nodes[child]->key)
+            child++;
+        if (node->key <= uheap->nodes[child]->key)
+            break;
+        uheap_place(uheap, index, uheap->nodes[child]);
+        index = child;
+    }
+    uheap_place(uheap, index, node);
+}
+
+/** @This adds an element to a uheap.
+ *
+ * @param uheap pointer to a uheap
+ * @param node pointer to a node which is not in a heap
+ * @param key key of the element
+ * @return an error code
+ */
+static inline int uheap_push(struct uheap *uheap, struct uheap_node *node,
+                             uint64_t key)
+{
+    if (uheap->size >= uheap->allocated) {
+        unsigned int allocated = uheap->allocated ? uheap->allocated * 2 :
+                                 UHEAP_MIN_ALLOC;
+        struct uheap_node **nodes = (struct uheap_node **)
+            realloc(uheap->nodes, sizeof(struct uheap_node *) * allocated);
+        if (unlikely(nodes == NULL))
+            return UBASE_ERR_ALLOC;
+        uheap->nodes = nodes;
+        uheap->allocated = allocated;
+    }
+
+    node->key = key;
+    uheap_place(uheap, uheap->size++, node);
+    uheap_sift_up(uheap, node->index);
+    return UBASE_ERR_NONE;
+}
+
+/** @This removes an element from a uheap.
+ *
+ * @param uheap pointer to a uheap
+ * @param node pointer to a node of the uheap
+ */
+static inline void uheap_delete(struct uheap *uheap, struct uheap_node *node)
+{
+    unsigned int index = node->index;
+    node->index = UINT_MAX;
+    if (index == --uheap->size)
+        return;
+
+    struct uheap_node *last = uheap->nodes[uheap->size];
+    uheap_place(uheap, index, last);
+    if (index && uheap->nodes[(index - 1) / 2]->key > last->key)
+        uheap_sift_up(uheap, index);
+    else
+        uheap_sift_down(uheap, index);
+}
+
+/** @This removes and returns the element with the smallest key.
+ *
+ * @param uheap pointer to a uheap
+ * @return pointer to the node, or NULL if the uheap is empty
+ */
+static inline struct uheap_node *uheap_pop(struct uheap *uheap)
+{
+    struct uheap_node *node = uheap_peek(uheap);
+    if (node != NULL)
+        uheap_delete(uheap, node);
+    return node;
+}
+
+/** @This changes the key of an element of a uheap.
+ *
+ * @param uheap pointer to a uheap
+ * @param node pointer to a node of the uheap
+ * @param key new key of the element
+ */
+static inline void uheap_update(struct uheap *uheap, struct uheap_node *node,
+                                uint64_t key)
+{
+    uint64_t old_key = node->key;
+    node->key = key;
+    if (key < old_key)
+        uheap_sift_up(uheap, node->index);
+    else
+        uheap_sift_down(uheap, node->index);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
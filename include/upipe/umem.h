@@ -39,6 +39,7 @@ extern "C" {
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdarg.h>
 #include <assert.h>
 
 /** @hidden */
@@ -80,6 +81,26 @@ static inline size_t umem_size(struct umem *umem)
     return umem->size;
 }
 
+/** @This defines standard commands which umem managers may implement. */
+enum umem_mgr_command {
+    /** get allocation statistics (struct umem_mgr_stats *) */
+    UMEM_MGR_GET_STATS,
+
+    /** non-standard manager commands implemented by a module type can start
+     * from there (first arg = signature) */
+    UMEM_MGR_CONTROL_LOCAL = 0x8000
+};
+
+/** @This defines the allocation statistics of a umem manager. */
+struct umem_mgr_stats {
+    /** number of allocations served from a cache without contention */
+    uint64_t hits;
+    /** number of allocations that had to refill a cache from a shared pool */
+    uint64_t misses;
+    /** number of allocations that had to revert to the system allocator */
+    uint64_t fallbacks;
+};
+
 /** @This defines a memory allocator management structure.
  */
 struct umem_mgr {
@@ -95,6 +116,8 @@ struct umem_mgr {
 
     /** function to release all buffers kept in pools */
     void (*umem_mgr_vacuum)(struct umem_mgr *);
+    /** control function for standard or local manager commands */
+    int (*umem_mgr_control)(struct umem_mgr *, int, va_list);
 };
 
 /** @This allocates a new umem buffer space.
@@ -151,6 +174,52 @@ static inline void umem_mgr_vacuum(struct umem_mgr *mgr)
         mgr->umem_mgr_vacuum(mgr);
 }
 
+/** @internal @This sends a control command to the umem manager.
+ *
+ * @param mgr pointer to umem manager
+ * @param command control command to send
+ * @param args optional read or write parameters
+ * @return an error code
+ */
+static inline int umem_mgr_control_va(struct umem_mgr *mgr,
+                                      int command, va_list args)
+{
+    assert(mgr != NULL);
+    if (mgr->umem_mgr_control == NULL)
+        return UBASE_ERR_UNHANDLED;
+
+    return mgr->umem_mgr_control(mgr, command, args);
+}
+
+/** @internal @This sends a control command to the umem manager.
+ *
+ * @param mgr pointer to umem manager
+ * @param command control command to send, followed by optional read or write
+ * parameters
+ * @return an error code
+ */
+static inline int umem_mgr_control(struct umem_mgr *mgr, int command, ...)
+{
+    int err;
+    va_list args;
+    va_start(args, command);
+    err = umem_mgr_control_va(mgr, command, args);
+    va_end(args);
+    return err;
+}
+
+/** @This returns the allocation statistics of a umem manager.
+ *
+ * @param mgr pointer to umem manager
+ * @param stats filled in with the statistics
+ * @return an error code
+ */
+static inline int umem_mgr_get_stats(struct umem_mgr *mgr,
+                                     struct umem_mgr_stats *stats)
+{
+    return umem_mgr_control(mgr, UMEM_MGR_GET_STATS, stats);
+}
+
 /** @This increments the reference count of a umem manager.
  *
  * @param mgr pointer to umem manager
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe umem manager carving buffers out of hugepage arenas
+ * This memory allocator maps an arena on hugepages at allocation time (with
+ * a fallback on transparent hugepages), and carves buffers out of it with
+ * the same power of 2's size classes as the umem pool allocator. Released
+ * buffers are kept in pools and never returned to the system, so that the
+ * arena can be locked in memory for live applications.
+ */
+
+#ifndef _UPIPE_UMEM_HUGEPAGE_H_
+/** @hidden */
+#define _UPIPE_UMEM_HUGEPAGE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/umem.h>
+
+/** @This defines the mapping flags of the hugepage arena. */
+enum umem_hugepage_flags {
+    /** use 1 GiB pages instead of 2 MiB pages */
+    UMEM_HUGEPAGE_1G = 0x1,
+    /** lock the arena in memory with mlock() */
+    UMEM_HUGEPAGE_LOCK = 0x2
+};
+
+/** @This returns the mapping flag binding the arena to the given NUMA node,
+ * to be or'ed with @ref umem_hugepage_flags. The kernel still falls back on
+ * other nodes if the requested node runs out of memory. */
+#define UMEM_HUGEPAGE_NODE(node) ((int)((unsigned)(node) + 1) << 8)
+
+/** @internal @This returns the NUMA node encoded in mapping flags, or -1. */
+#define UMEM_HUGEPAGE_FLAGS_NODE(flags) ((int)(((unsigned)(flags) >> 8)) - 1)
+
+/** @This allocates a new instance of the umem hugepage manager, carving
+ * buffers out of an arena mapped on hugepages.
+ *
+ * @param arena_size size (in octets) of the arena, rounded up to the page size
+ * @param flags mapping flags (@ref umem_hugepage_flags), optionally or'ed with
+ * @ref UMEM_HUGEPAGE_NODE
+ * @param pool0_size size (in octets) of the smallest allocatable buffer; it
+ * must be a power of 2
+ * @param nb_pools number of buffer pools to maintain, with sizes in power of
+ * 2's increments, followed, for each pool, by the maximum number of buffers
+ * to carve out of the arena for the pool (unsigned int); larger buffers,
+ * and buffers that do not fit in the arena, will be directly managed
+ * with malloc() and free()
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_hugepage_mgr_alloc(size_t arena_size, int flags,
+                                         size_t pool0_size, size_t nb_pools,
+                                         ...);
+
+/** @This allocates a new instance of the umem hugepage manager, with size
+ * classes matching @ref umem_pool_mgr_alloc_simple.
+ *
+ * @param arena_size size (in octets) of the arena, rounded up to the page size
+ * @param flags mapping flags (@ref umem_hugepage_flags), optionally or'ed with
+ * @ref UMEM_HUGEPAGE_NODE
+ * @param base_pools_depth maximum number of buffers for the smaller buffers;
+ * for larger buffers the same number is used, divided by 2, 4, or 8
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_hugepage_mgr_alloc_simple(size_t arena_size, int flags,
+                                                uint16_t base_pools_depth);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
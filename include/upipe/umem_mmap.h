@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe umem manager using memory mappings
+ * This memory allocator maps each buffer separately with mmap() and unmaps
+ * it with munmap(). Besides anonymous buffers, it allows to map a range of
+ * a file, so that the contents of the file may be exported in ubuf without
+ * being copied.
+ */
+
+#ifndef _UPIPE_UMEM_MMAP_H_
+/** @hidden */
+#define _UPIPE_UMEM_MMAP_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/umem.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** @This returns the umem mmap manager. It is a static structure which is
+ * never deallocated, so that buffers may outlive their users.
+ *
+ * @return pointer to manager
+ */
+struct umem_mgr *umem_mmap_mgr_alloc(void);
+
+/** @This maps a range of a file into a umem. The mapping is private, so that
+ * writing into the buffer doesn't modify the file. The kernel is advised that
+ * the range will be read sequentially and soon.
+ *
+ * @param umem caller-allocated structure, filled in with the mapping (previous
+ * content is discarded)
+ * @param fd file descriptor, open for reading
+ * @param offset offset of the range in the file, multiple of the page size
+ * @param size size of the range
+ * @return false if the file couldn't be mapped (umem left untouched)
+ */
+bool umem_mmap_file(struct umem *umem, int fd, uint64_t offset, size_t size);
+
+/** @This returns the page size, to which file offsets must be aligned.
+ *
+ * @return page size in octets
+ */
+size_t umem_mmap_page_size(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -37,8 +37,41 @@
 extern "C" {
 #endif
 
+#include <upipe/ubase.h>
 #include <upipe/umem.h>
 
+#include <stdint.h>
+
+/** @This is the signature of the local commands of umem pool managers. */
+#define UMEM_POOL_SIGNATURE UBASE_FOURCC('u','m','p','l')
+
+/** @This extends @ref umem_mgr_command with specific commands. */
+enum umem_pool_mgr_command {
+    UMEM_POOL_MGR_SENTINEL = UMEM_MGR_CONTROL_LOCAL,
+
+    /** get the state of a pool (unsigned int,
+     * struct umem_pool_stats *) */
+    UMEM_POOL_MGR_GET_POOL_STATS,
+    /** get the memory held by adaptive pools (uint64_t *, uint64_t *) */
+    UMEM_POOL_MGR_GET_MEMORY
+};
+
+/** @This defines the state of a pool of an adaptive umem pool manager. */
+struct umem_pool_stats {
+    /** size of the buffers of the pool */
+    size_t size;
+    /** current maximum number of buffers kept in the pool */
+    unsigned int depth;
+    /** upper bound of the depth */
+    unsigned int max_depth;
+    /** number of buffers currently kept in the pool */
+    unsigned int cached;
+    /** number of buffers of this size currently allocated */
+    unsigned int in_use;
+    /** peak number of buffers allocated during the current window */
+    unsigned int peak;
+};
+
 /** @This allocates a new instance of the umem pool manager allocating buffers
  * from application memory, using pools in power of 2's.
  *
@@ -62,6 +95,71 @@ struct umem_mgr *umem_pool_mgr_alloc(size_t pool0_size, size_t nb_pools, ...);
  */
 struct umem_mgr *umem_pool_mgr_alloc_simple(uint16_t base_pools_depth);
 
+/** @This allocates a new instance of the umem pool manager allocating buffers
+ * from application memory, using adaptive pools in power of 2's. Each pool
+ * tracks the peak number of its buffers allocated at the same time over a
+ * window of allocations, and at the end of the window grows its depth to
+ * that peak, or shrinks halfway towards it, releasing the buffers it doesn't
+ * need anymore. Pools start empty, and the memory they may keep altogether
+ * is bounded.
+ *
+ * @param pool0_size size (in octets) of the smallest allocatable buffer; it
+ * must be a power of 2
+ * @param nb_pools number of buffer pools to maintain, with sizes in power of
+ * 2's increments; larger buffers will be directly managed with malloc() and
+ * free()
+ * @param max_memory maximum number of octets kept in all pools
+ * @param max_depth maximum number of buffers kept in each pool
+ * @param window number of allocations from a pool between adaptations
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_pool_mgr_alloc_adaptive(size_t pool0_size,
+                                              size_t nb_pools,
+                                              uint64_t max_memory,
+                                              uint16_t max_depth,
+                                              unsigned int window);
+
+/** @This allocates a new instance of the umem pool manager allocating buffers
+ * from application memory, using adaptive pools in power of 2's, with a
+ * simpler API.
+ *
+ * @param max_memory maximum number of octets kept in all pools
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_pool_mgr_alloc_adaptive_simple(uint64_t max_memory);
+
+/** @This gets the state of a pool of an adaptive umem pool manager.
+ *
+ * @param mgr pointer to umem manager
+ * @param pool index of the pool, from the smallest buffers
+ * @param stats filled in with the state of the pool
+ * @return an error code
+ */
+static inline int umem_pool_mgr_get_pool_stats(struct umem_mgr *mgr,
+                                               unsigned int pool,
+                                               struct umem_pool_stats *stats)
+{
+    return umem_mgr_control(mgr, UMEM_POOL_MGR_GET_POOL_STATS,
+                            UMEM_POOL_SIGNATURE, pool, stats);
+}
+
+/** @This gets the memory held by the pools of an adaptive umem pool
+ * manager.
+ *
+ * @param mgr pointer to umem manager
+ * @param reserved_p filled in with the number of octets the pools may
+ * currently keep
+ * @param max_p filled in with the upper bound of reserved_p
+ * @return an error code
+ */
+static inline int umem_pool_mgr_get_memory(struct umem_mgr *mgr,
+                                           uint64_t *reserved_p,
+                                           uint64_t *max_p)
+{
+    return umem_mgr_control(mgr, UMEM_POOL_MGR_GET_MEMORY,
+                            UMEM_POOL_SIGNATURE, reserved_p, max_p);
+}
+
 #ifdef __cplusplus
 }
 #endif
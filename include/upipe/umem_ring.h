@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short Upipe ring memory allocator for single-producer transports
+ * This memory allocator carves buffers out of a preallocated ring. Buffers
+ * must be allocated from a single thread (typically the thread producing
+ * data sent through a queue), but may be freed from any thread and in any
+ * order; released space is reclaimed lazily by the producer in ring order.
+ * When the ring is full, buffers revert to the system allocator.
+ * Allocation statistics are available with @ref umem_mgr_get_stats.
+ */
+
+#ifndef _UPIPE_UMEM_RING_H_
+/** @hidden */
+#define _UPIPE_UMEM_RING_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/umem.h>
+
+/** @This allocates a new instance of the umem ring manager.
+ *
+ * Buffers are aligned on 64 octets and each of them consumes an additional
+ * header of 64 octets in the ring. Resizing a buffer beyond the space
+ * initially reserved for it moves it out of the ring.
+ *
+ * @param ring_size size of the ring in octets
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_ring_mgr_alloc(size_t ring_size);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe shared memory allocator for multi-process pipelines
+ * This memory allocator carves fixed-size slots out of a POSIX shared memory
+ * segment, which may be mapped by several processes. Each slot carries a
+ * reference counter stored in the segment, so that a buffer allocated by one
+ * process may be released by another. The segment also contains a
+ * single-producer, single-consumer ring of fixed-size messages, used to pass
+ * descriptors of buffers between processes.
+ *
+ * Slots referenced by a process that dies are not reclaimed until the
+ * segment is recreated.
+ */
+
+#ifndef _UPIPE_UMEM_SHM_H_
+/** @hidden */
+#define _UPIPE_UMEM_SHM_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/umem.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** @This allocates a new instance of the umem shm manager, and creates the
+ * shared memory segment, replacing any previous segment of the same name.
+ * The name is unlinked when the manager is freed; processes which already
+ * attached the segment keep it mapped.
+ *
+ * Buffers larger than a slot, or allocated while all slots are in use,
+ * revert to the system allocator.
+ *
+ * @param name name of the segment, as passed to shm_open()
+ * @param slot_size size of a slot in octets (rounded up to 64 octets)
+ * @param nb_slots number of slots in the segment
+ * @param ring_length maximum number of messages in the ring
+ * @param msg_size size of a message in octets
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_shm_mgr_alloc(const char *name, size_t slot_size,
+                                    uint32_t nb_slots, uint32_t ring_length,
+                                    size_t msg_size);
+
+/** @This allocates a new instance of the umem shm manager, attaching to an
+ * existing shared memory segment.
+ *
+ * @param name name of the segment, as passed to shm_open()
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_shm_mgr_attach(const char *name);
+
+/** @This returns the size of the slots of a umem shm manager.
+ *
+ * @param mgr pointer to umem shm manager
+ * @return size of a slot in octets
+ */
+size_t umem_shm_mgr_slot_size(struct umem_mgr *mgr);
+
+/** @This returns the size of the messages of a umem shm manager.
+ *
+ * @param mgr pointer to umem shm manager
+ * @return size of a message in octets
+ */
+size_t umem_shm_mgr_msg_size(struct umem_mgr *mgr);
+
+/** @This takes a new reference on the slot containing the given buffer,
+ * so that it may be passed to another process.
+ *
+ * @param mgr pointer to umem shm manager
+ * @param buffer pointer to the beginning of the buffer
+ * @param size size of the buffer in octets
+ * @param slot_p filled in with the index of the slot
+ * @param offset_p filled in with the offset of the buffer in the slot
+ * @return an error code, UBASE_ERR_INVALID if the buffer doesn't lie in a
+ * slot of the segment
+ */
+int umem_shm_mgr_export(struct umem_mgr *mgr, const uint8_t *buffer,
+                        size_t size, uint32_t *slot_p, uint32_t *offset_p);
+
+/** @This allocates a slot and takes a reference to it, without wrapping it
+ * in a umem. It is typically used to copy a buffer into the segment before
+ * passing it to another process.
+ *
+ * @param mgr pointer to umem shm manager
+ * @param slot_p filled in with the index of the slot
+ * @return pointer to the slot buffer, or NULL if all slots are in use
+ */
+uint8_t *umem_shm_mgr_reserve(struct umem_mgr *mgr, uint32_t *slot_p);
+
+/** @This releases a reference on a slot, previously obtained with
+ * @ref umem_shm_mgr_export or @ref umem_shm_mgr_reserve.
+ *
+ * @param mgr pointer to umem shm manager
+ * @param slot index of the slot
+ */
+void umem_shm_mgr_unref(struct umem_mgr *mgr, uint32_t slot);
+
+/** @This wraps a slot into a umem, taking over a reference previously
+ * obtained by any process. The reference is released when the umem is
+ * freed.
+ *
+ * @param mgr pointer to umem shm manager
+ * @param umem caller-allocated structure, filled in with the whole slot
+ * @param slot index of the slot
+ * @return an error code
+ */
+int umem_shm_mgr_import(struct umem_mgr *mgr, struct umem *umem,
+                        uint32_t slot);
+
+/** @This pushes a message into the ring of the segment. There must be only
+ * one producer per segment.
+ *
+ * @param mgr pointer to umem shm manager
+ * @param msg pointer to the message, of the size given on creation
+ * @return false if the ring is full
+ */
+bool umem_shm_mgr_push(struct umem_mgr *mgr, const void *msg);
+
+/** @This pops a message from the ring of the segment. There must be only
+ * one consumer per segment.
+ *
+ * @param mgr pointer to umem shm manager
+ * @param msg filled in with the message, of the size given on creation
+ * @return false if the ring is empty
+ */
+bool umem_shm_mgr_pop(struct umem_mgr *mgr, void *msg);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -39,6 +39,7 @@ extern "C" {
 #include <upipe/uprobe.h>
 #include <upipe/urequest.h>
 #include <upipe/udict_dump.h>
+#include <upipe/utrace.h>
 
 #include <stdint.h>
 #include <stdarg.h>
@@ -52,6 +53,8 @@ struct uref;
 /** @hidden */
 struct uclock;
 /** @hidden */
+struct upipe_stats;
+/** @hidden */
 struct uref_mgr;
 /** @hidden */
 struct upump_mgr;
@@ -81,6 +84,8 @@ enum upipe_command {
     UPIPE_GET_OPTION,
     /** sets a string option (const char *, const char *) */
     UPIPE_SET_OPTION,
+    /** gets the instrumentation counters (struct upipe_stats *) */
+    UPIPE_GET_STATS,
 
     /*
      * Input-related commands, normally called by the upstream pipe
@@ -166,6 +171,10 @@ enum upipe_command {
     UPIPE_CONTROL_LOCAL = 0x8000
 };
 
+/** @This is the number of clock events dispatched through the cache of
+ * struct upipe. */
+#define UPIPE_CLOCK_EVENTS (UPROBE_CLOCK_UTC - UPROBE_CLOCK_REF + 1)
+
 /** @This stores common parameters for upipe structures. */
 struct upipe {
     /** pointer to refcount management structure */
@@ -179,8 +188,291 @@ struct upipe {
     struct uprobe *uprobe;
     /** pointer to the manager for this pipe type */
     struct upipe_mgr *mgr;
+    /** instrumentation counters, or NULL if disabled */
+    struct upipe_stats *stats;
+    /** cached minimum level of printed log events */
+    enum uprobe_log_level log_level;
+    /** value of @ref uprobe_log_generation when log_level was cached */
+    uint32_t log_generation;
+    /** cached first probes catching the per-packet clock events, from
+     * @ref UPROBE_CLOCK_REF to @ref UPROBE_CLOCK_UTC */
+    struct uprobe *uprobe_clock[UPIPE_CLOCK_EVENTS];
+    /** value of @ref uprobe_event_generation when uprobe_clock was cached */
+    uint32_t event_generation;
+};
+
+/** @This is the number of buckets of the input latency histogram. */
+#define UPIPE_STATS_LATENCY_BUCKETS 32
+/** @This is the number of sub-buckets per power of two of the ingress
+ * latency histogram. */
+#define UPIPE_STATS_TRACE_SUB_BUCKETS 8
+/** @This is the number of buckets of the ingress latency histogram; with
+ * 8 sub-buckets per power of two, the last one starts at 2^33 ticks. */
+#define UPIPE_STATS_TRACE_BUCKETS 256
+
+/** @This stores the instrumentation counters of a pipe, see
+ * @ref upipe_stats_enable. Durations are in units of @ref UCLOCK_FREQ. */
+struct upipe_stats {
+    /** number of urefs received */
+    uint64_t urefs;
+    /** number of octets received in block urefs */
+    uint64_t bytes;
+    /** cumulated time spent in the input function */
+    uint64_t input_time;
+    /** maximum time spent in one call to the input function */
+    uint64_t max_input_time;
+    /** number of urefs currently held by the pipe */
+    unsigned int queue;
+    /** maximum number of urefs held by the pipe */
+    unsigned int max_queue;
+    /** number of stream errors detected by the pipe */
+    uint64_t errors;
+    /** last jitter measured by the pipe on clock references */
+    uint64_t jitter;
+    /** maximum jitter measured by the pipe on clock references */
+    uint64_t max_jitter;
+    /** date at which instrumentation was enabled, or 0 without uclock */
+    uint64_t start;
+    /** date of the end of the last input, or 0 without uclock */
+    uint64_t last;
+    /** histogram of the time spent in the input function; bucket n counts
+     * the calls lasting less than 2^(n+1) ticks, the last one catching all
+     * longer calls */
+    uint64_t latency[UPIPE_STATS_LATENCY_BUCKETS];
+
+    /** number of traced urefs received, see @ref upipe_stats_set_trace */
+    uint64_t traced;
+    /** cumulated latency of the traced urefs since their ingress date */
+    uint64_t trace_time;
+    /** maximum latency of a traced uref since its ingress date */
+    uint64_t max_trace;
+    /** log-linear histogram of the latency of the traced urefs, see
+     * @ref upipe_stats_trace_bucket */
+    uint64_t trace[UPIPE_STATS_TRACE_BUCKETS];
+
+    /** octets of the buffers of the urefs held by the pipe, see
+     * @ref upipe_stats_hold */
+    uint64_t held_bytes;
+    /** maximum octets of the buffers of the urefs held by the pipe */
+    uint64_t max_held_bytes;
+    /** octets held above which @ref UPROBE_MEMORY_CAP is thrown, or 0 */
+    uint64_t memory_cap;
 };
 
+/** @This returns the bucket of the ingress latency histogram for a given
+ * latency. Each power of two is divided into
+ * @ref UPIPE_STATS_TRACE_SUB_BUCKETS buckets, so that the relative error is
+ * bounded by 12.5%, the last bucket catching all longer latencies.
+ *
+ * @param latency latency in units of @ref UCLOCK_FREQ
+ * @return index of the bucket
+ */
+static inline unsigned int upipe_stats_trace_bucket(uint64_t latency)
+{
+    if (latency < UPIPE_STATS_TRACE_SUB_BUCKETS)
+        return latency;
+    unsigned int log2 = 63 - __builtin_clzll(latency);
+    unsigned int bucket = (log2 - 2) * UPIPE_STATS_TRACE_SUB_BUCKETS +
+        ((latency >> (log2 - 3)) & (UPIPE_STATS_TRACE_SUB_BUCKETS - 1));
+    return bucket < UPIPE_STATS_TRACE_BUCKETS ?
+           bucket : UPIPE_STATS_TRACE_BUCKETS - 1;
+}
+
+/** @This returns the exclusive upper bound of a bucket of the ingress
+ * latency histogram.
+ *
+ * @param bucket index of the bucket
+ * @return upper bound in units of @ref UCLOCK_FREQ
+ */
+static inline uint64_t upipe_stats_trace_bound(unsigned int bucket)
+{
+    if (bucket < UPIPE_STATS_TRACE_SUB_BUCKETS)
+        return bucket + 1;
+    unsigned int log2 = bucket / UPIPE_STATS_TRACE_SUB_BUCKETS + 2;
+    uint64_t sub = bucket % UPIPE_STATS_TRACE_SUB_BUCKETS;
+    return (UPIPE_STATS_TRACE_SUB_BUCKETS + sub + 1) << (log2 - 3);
+}
+
+/** @This returns an upper bound of the given percentile of the latency of
+ * the traced urefs since their ingress date.
+ *
+ * @param stats instrumentation counters
+ * @param percent percentile to compute, between 0 and 100
+ * @return upper bound, in units of @ref UCLOCK_FREQ, or 0 if no uref was
+ * traced
+ */
+static inline uint64_t upipe_stats_trace_percentile(
+        const struct upipe_stats *stats, unsigned int percent)
+{
+    if (!stats->traced)
+        return 0;
+
+    uint64_t threshold = (stats->traced * percent + 99) / 100;
+    uint64_t count = 0;
+    for (unsigned int i = 0; i < UPIPE_STATS_TRACE_BUCKETS - 1; i++) {
+        count += stats->trace[i];
+        if (count >= threshold)
+            return upipe_stats_trace_bound(i) < stats->max_trace ?
+                   upipe_stats_trace_bound(i) : stats->max_trace;
+    }
+    return stats->max_trace;
+}
+
+/** @This returns an upper bound of the given percentile of the time spent
+ * in the input function, from the latency histogram.
+ *
+ * @param stats instrumentation counters
+ * @param percent percentile to compute, between 0 and 100
+ * @return upper bound, in units of @ref UCLOCK_FREQ, or 0 if no uref was
+ * timed
+ */
+static inline uint64_t upipe_stats_latency_percentile(
+        const struct upipe_stats *stats, unsigned int percent)
+{
+    uint64_t total = 0;
+    for (unsigned int i = 0; i < UPIPE_STATS_LATENCY_BUCKETS; i++)
+        total += stats->latency[i];
+    if (!total)
+        return 0;
+
+    uint64_t threshold = (total * percent + 99) / 100;
+    uint64_t count = 0;
+    for (unsigned int i = 0; i < UPIPE_STATS_LATENCY_BUCKETS - 1; i++) {
+        count += stats->latency[i];
+        if (count >= threshold)
+            return UINT64_C(1) << (i + 1);
+    }
+    return stats->max_input_time;
+}
+
+/** @This enables instrumentation of a pipe. Counting urefs and octets is
+ * always done; the time spent in the input function is only measured if a
+ * uclock is given, which also allows reporting the counters periodically
+ * with a @ref UPROBE_STATS event.
+ *
+ * @param upipe description structure of the pipe
+ * @param uclock clock used to measure time, or NULL
+ * @param period period of the @ref UPROBE_STATS events, or 0 to disable them
+ * @return an error code
+ */
+int upipe_stats_enable(struct upipe *upipe, struct uclock *uclock,
+                       uint64_t period);
+
+/** @This disables instrumentation of a pipe and releases the counters.
+ *
+ * @param upipe description structure of the pipe
+ */
+void upipe_stats_disable(struct upipe *upipe);
+
+/** @This configures latency tracing on an instrumented pipe, which must have
+ * been given a uclock. The pipe stamps an ingress date (@ref
+ * uref_trace_set_ingress) on one uref out of sample among those which do not
+ * have one, using the system date of the clock reference if any, or the
+ * current date. Urefs already stamped upstream are accounted in the ingress
+ * latency histogram of every instrumented pipe they go through.
+ *
+ * @param upipe description structure of the pipe
+ * @param sample sampling period of the stamped urefs, or 0 to only measure
+ * urefs stamped upstream
+ * @return an error code
+ */
+int upipe_stats_set_trace(struct upipe *upipe, unsigned int sample);
+
+/** @This sets the memory cap of an instrumented pipe. When the octets of
+ * the buffers held by the pipe go beyond the cap, a @ref UPROBE_MEMORY_CAP
+ * event is thrown; it is thrown again after they went back under the cap.
+ *
+ * @param upipe description structure of the pipe
+ * @param cap maximum number of octets held, or 0 to disable the event
+ * @return an error code
+ */
+int upipe_stats_set_memory_cap(struct upipe *upipe, uint64_t cap);
+
+/** @internal @This accounts the buffers of a uref taken or given back by an
+ * instrumented pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref taken or given back
+ * @param hold true if the uref is taken
+ */
+void upipe_stats_account(struct upipe *upipe, struct uref *uref, bool hold);
+
+/** @internal @This accounts the buffers of a uref held by a pipe until it is
+ * output or freed. It is called by @ref #UPIPE_HELPER_INPUT.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref held
+ */
+static inline void upipe_stats_hold(struct upipe *upipe, struct uref *uref)
+{
+    if (unlikely(upipe->stats != NULL))
+        upipe_stats_account(upipe, uref, true);
+}
+
+/** @internal @This stops accounting the buffers of a uref previously held
+ * by a pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref no longer held
+ */
+static inline void upipe_stats_unhold(struct upipe *upipe, struct uref *uref)
+{
+    if (unlikely(upipe->stats != NULL))
+        upipe_stats_account(upipe, uref, false);
+}
+
+/** @internal @This sends a uref to an instrumented pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure to send
+ * @param upump_p reference to pump that generated the buffer
+ */
+void upipe_stats_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p);
+
+/** @internal @This updates the number of urefs held by an instrumented pipe.
+ * It is called by @ref #UPIPE_HELPER_INPUT.
+ *
+ * @param upipe description structure of the pipe
+ * @param queue number of urefs currently held
+ */
+static inline void upipe_stats_queue(struct upipe *upipe, unsigned int queue)
+{
+    if (likely(upipe->stats == NULL))
+        return;
+    upipe->stats->queue = queue;
+    if (queue > upipe->stats->max_queue)
+        upipe->stats->max_queue = queue;
+}
+
+/** @This counts stream errors detected by an instrumented pipe, such as
+ * continuity errors.
+ *
+ * @param upipe description structure of the pipe
+ * @param errors number of errors detected
+ */
+static inline void upipe_stats_error(struct upipe *upipe, unsigned int errors)
+{
+    if (likely(upipe->stats == NULL))
+        return;
+    upipe->stats->errors += errors;
+}
+
+/** @This reports the jitter measured by an instrumented pipe on its clock
+ * references.
+ *
+ * @param upipe description structure of the pipe
+ * @param jitter jitter, in units of @ref UCLOCK_FREQ
+ */
+static inline void upipe_stats_jitter(struct upipe *upipe, uint64_t jitter)
+{
+    if (likely(upipe->stats == NULL))
+        return;
+    upipe->stats->jitter = jitter;
+    if (jitter > upipe->stats->max_jitter)
+        upipe->stats->max_jitter = jitter;
+}
+
 UBASE_FROM_TO(upipe, uchain, uchain, uchain)
 
 /** @This defines standard commands which upipe managers may implement. */
@@ -332,6 +624,7 @@ static inline const char *upipe_command_str(struct upipe *upipe, int cmd)
     UBASE_CASE_TO_STR(UPIPE_SET_URI);
     UBASE_CASE_TO_STR(UPIPE_GET_OPTION);
     UBASE_CASE_TO_STR(UPIPE_SET_OPTION);
+    UBASE_CASE_TO_STR(UPIPE_GET_STATS);
     UBASE_CASE_TO_STR(UPIPE_REGISTER_REQUEST);
     UBASE_CASE_TO_STR(UPIPE_UNREGISTER_REQUEST);
     UBASE_CASE_TO_STR(UPIPE_SET_FLOW_DEF);
@@ -422,6 +715,19 @@ static inline struct upipe *upipe_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
+/** @internal @This refreshes the cached first probes catching the clock
+ * events of a pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static inline void upipe_refresh_events(struct upipe *upipe)
+{
+    upipe->event_generation = uprobe_event_generation;
+    for (int i = 0; i < UPIPE_CLOCK_EVENTS; i++)
+        upipe->uprobe_clock[i] =
+            uprobe_find_catcher(upipe->uprobe, UPROBE_CLOCK_REF + i);
+}
+
 /** @This initializes the public members of a pipe.
  *
  * Please note that this function does not _use() the probe, so if you want
@@ -440,6 +746,10 @@ static inline void upipe_init(struct upipe *upipe, struct upipe_mgr *mgr,
     upipe->uprobe = uprobe;
     upipe->refcount = NULL;
     upipe->mgr = mgr;
+    upipe->stats = NULL;
+    upipe->log_generation = uprobe_log_generation;
+    upipe->log_level = uprobe_get_log_level(uprobe);
+    upipe_refresh_events(upipe);
     upipe_mgr_use(mgr);
 }
 
@@ -519,6 +829,8 @@ static inline void upipe_push_probe(struct upipe *upipe, struct uprobe *uprobe)
 {
     uprobe->next = upipe->uprobe;
     upipe->uprobe = uprobe;
+    upipe->log_level = uprobe_get_log_level(upipe->uprobe);
+    upipe_refresh_events(upipe);
 }
 
 /** @This deletes the first probe from the LIFO of probes associated with a
@@ -535,6 +847,8 @@ static inline struct uprobe *upipe_pop_probe(struct upipe *upipe)
     struct uprobe *uprobe = upipe->uprobe;
     if (uprobe != NULL)
         upipe->uprobe = uprobe->next;
+    upipe->log_level = uprobe_get_log_level(upipe->uprobe);
+    upipe_refresh_events(upipe);
     return uprobe;
 }
 
@@ -546,11 +860,15 @@ static inline struct uprobe *upipe_pop_probe(struct upipe *upipe)
 static inline void upipe_clean(struct upipe *upipe)
 {
     assert(upipe != NULL);
+    if (unlikely(upipe->stats != NULL))
+        upipe_stats_disable(upipe);
     uprobe_release(upipe->uprobe);
     upipe_mgr_release(upipe->mgr);
 }
 
-/** @internal @This throws generic events with optional arguments.
+/** @internal @This throws generic events with optional arguments. Clock
+ * events, which are thrown for every packet, are directly dispatched to the
+ * first probe which may catch them.
  *
  * @param upipe description structure of the pipe
  * @param event event to throw
@@ -559,6 +877,14 @@ static inline void upipe_clean(struct upipe *upipe)
  */
 static inline int upipe_throw_va(struct upipe *upipe, int event, va_list args)
 {
+    unsigned int clock = (unsigned int)event - UPROBE_CLOCK_REF;
+    UTRACE3(throw, upipe->uprobe, upipe, event);
+    if (clock < UPIPE_CLOCK_EVENTS) {
+        if (unlikely(upipe->event_generation != uprobe_event_generation))
+            upipe_refresh_events(upipe);
+        return uprobe_throw_va(upipe->uprobe_clock[clock], upipe, event,
+                               args);
+    }
     return uprobe_throw_va(upipe->uprobe, upipe, event, args);
 }
 
@@ -577,6 +903,25 @@ static inline int upipe_throw(struct upipe *upipe, int event, ...)
     return err;
 }
 
+/** @This checks if log events of the given level may be printed by the
+ * probe hierarchy of a pipe, so that formatting may be skipped otherwise. The
+ * level is cached and refreshed when the filter of a probe changes.
+ *
+ * @param upipe description structure of the pipe
+ * @param level level of importance of the message
+ * @return false if the message would be dropped
+ */
+static inline bool upipe_log_enabled(struct upipe *upipe,
+                                     enum uprobe_log_level level)
+{
+    uint32_t log_generation = uprobe_log_generation;
+    if (unlikely(upipe->log_generation != log_generation)) {
+        upipe->log_generation = log_generation;
+        upipe->log_level = uprobe_get_log_level(upipe->uprobe);
+    }
+    return level >= upipe->log_level;
+}
+
 /** @internal @This throws a log event. This event is thrown whenever a pipe
  * wants to send a textual message.
  *
@@ -584,8 +929,12 @@ static inline int upipe_throw(struct upipe *upipe, int event, ...)
  * @param level level of importance of the message
  * @param msg textual message
  */
-#define upipe_log(upipe, level, msg)                                        \
-    uprobe_log((upipe)->uprobe, upipe, level, msg)
+static inline void upipe_log(struct upipe *upipe, enum uprobe_log_level level,
+                             const char *msg)
+{
+    if (upipe_log_enabled(upipe, level))
+        uprobe_log(upipe->uprobe, upipe, level, msg);
+}
 
 /** @internal @This throws a log event, with printf-style message generation.
  *
@@ -598,6 +947,8 @@ static inline void upipe_log_va(struct upipe *upipe,
                                 enum uprobe_log_level level,
                                 const char *format, ...)
 {
+    if (!upipe_log_enabled(upipe, level))
+        return;
     UBASE_VARARG(upipe_log(upipe, level, string))
 }
 
@@ -617,6 +968,8 @@ static inline void upipe_log_va(struct upipe *upipe,
 UBASE_FMT_PRINTF(2, 3)
 static inline void upipe_err_va(struct upipe *upipe, const char *format, ...)
 {
+    if (!upipe_log_enabled(upipe, UPROBE_LOG_ERROR))
+        return;
     UBASE_VARARG(upipe_err(upipe, string))
 }
 
@@ -636,6 +989,8 @@ static inline void upipe_err_va(struct upipe *upipe, const char *format, ...)
 UBASE_FMT_PRINTF(2, 3)
 static inline void upipe_warn_va(struct upipe *upipe, const char *format, ...)
 {
+    if (!upipe_log_enabled(upipe, UPROBE_LOG_WARNING))
+        return;
     UBASE_VARARG(upipe_warn(upipe, string))
 }
 
@@ -655,6 +1010,8 @@ static inline void upipe_warn_va(struct upipe *upipe, const char *format, ...)
 UBASE_FMT_PRINTF(2, 3)
 static inline void upipe_notice_va(struct upipe *upipe, const char *format, ...)
 {
+    if (!upipe_log_enabled(upipe, UPROBE_LOG_NOTICE))
+        return;
     UBASE_VARARG(upipe_notice(upipe, string))
 }
 
@@ -674,6 +1031,8 @@ static inline void upipe_notice_va(struct upipe *upipe, const char *format, ...)
 UBASE_FMT_PRINTF(2, 3)
 static inline void upipe_dbg_va(struct upipe *upipe, const char *format, ...)
 {
+    if (!upipe_log_enabled(upipe, UPROBE_LOG_DEBUG))
+        return;
     UBASE_VARARG(upipe_dbg(upipe, string))
 }
 
@@ -695,6 +1054,8 @@ UBASE_FMT_PRINTF(2, 3)
 static inline void upipe_verbose_va(struct upipe *upipe,
                                     const char *format, ...)
 {
+    if (!upipe_log_enabled(upipe, UPROBE_LOG_VERBOSE))
+        return;
     UBASE_VARARG(upipe_verbose(upipe, string))
 }
 
@@ -1057,7 +1418,12 @@ static inline void upipe_input(struct upipe *upipe, struct uref *uref,
         return;
     }
     upipe_use(upipe);
-    upipe->mgr->upipe_input(upipe, uref, upump_p);
+    UTRACE3(input_enter, upipe, upipe->mgr->upipe_input, uref);
+    if (unlikely(upipe->stats != NULL))
+        upipe_stats_input(upipe, uref, upump_p);
+    else
+        upipe->mgr->upipe_input(upipe, uref, upump_p);
+    UTRACE2(input_exit, upipe, upipe->mgr->upipe_input);
     upipe_release(upipe);
 }
 
@@ -1077,6 +1443,13 @@ static inline int upipe_control_nodbg_va(struct upipe *upipe,
                                          int command, va_list args)
 {
     assert(upipe != NULL);
+    if (unlikely(command == UPIPE_GET_STATS)) {
+        struct upipe_stats *stats_p = va_arg(args, struct upipe_stats *);
+        if (upipe->stats == NULL)
+            return UBASE_ERR_UNHANDLED;
+        *stats_p = *upipe->stats;
+        return UBASE_ERR_NONE;
+    }
     if (upipe->mgr->upipe_control == NULL)
         return UBASE_ERR_UNHANDLED;
 
@@ -1311,6 +1684,18 @@ static inline int upipe_flush(struct upipe *upipe)
     return upipe_control(upipe, UPIPE_FLUSH);
 }
 
+/** @This gets the instrumentation counters of a pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param stats_p filled in with the counters
+ * @return an error code, UBASE_ERR_UNHANDLED if instrumentation is disabled
+ */
+static inline int upipe_get_stats(struct upipe *upipe,
+                                  struct upipe_stats *stats_p)
+{
+    return upipe_control_nodbg(upipe, UPIPE_GET_STATS, stats_p);
+}
+
 /** @This ends the preroll period in a pipe.
  *
  * @param upipe description structure of the pipe
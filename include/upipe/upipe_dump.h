@@ -57,6 +57,14 @@ char *upipe_dump_upipe_label_default(struct upipe *upipe);
  */
 char *upipe_dump_flow_def_label_default(struct uref *flow_def);
 
+/** @This converts a pipe to a label, annotated with its instrumentation
+ * counters if they are enabled (see @ref upipe_stats_enable).
+ *
+ * @param upipe upipe structure
+ * @return allocated string
+ */
+char *upipe_dump_upipe_label_stats(struct upipe *upipe);
+
 /** @This dumps a pipeline in dot format.
  *
  * @param pipe_label function to print pipe labels
@@ -121,6 +129,111 @@ static inline int upipe_dump_open(upipe_dump_pipe_label pipe_label,
     return err;
 }
 
+/** @This dumps a pipeline in JSON format, with the instrumentation counters
+ * of the pipes that have them enabled.
+ *
+ * @param file file pointer to write to
+ * @param ulist list of sources pipes in ulist format
+ * @param args list of sources pipes terminated with NULL
+ */
+void upipe_dump_json_va(FILE *file, struct uchain *ulist, va_list args);
+
+/** @This dumps a pipeline in JSON format with a variable list of arguments.
+ *
+ * @param file file pointer to write to
+ * @param ulist list of sources pipes in ulist format, followed by a list of
+ * source pipes terminated by NULL
+ */
+static inline void upipe_dump_json(FILE *file, struct uchain *ulist, ...)
+{
+    va_list args;
+    va_start(args, ulist);
+    upipe_dump_json_va(file, ulist, args);
+    va_end(args);
+}
+
+/** @This opens a file and dumps a pipeline in JSON format.
+ *
+ * @param path path of the file to open
+ * @param ulist list of sources pipes in ulist format
+ * @param args list of sources pipes terminated with NULL
+ * @return an error code
+ */
+int upipe_dump_json_open_va(const char *path, struct uchain *ulist,
+                            va_list args);
+
+/** @This opens a file and dumps a pipeline in JSON format with a variable
+ * list of arguments.
+ *
+ * @param path path of the file to open
+ * @param ulist list of sources pipes in ulist format, followed by a list of
+ * source pipes terminated by NULL
+ * @return an error code
+ */
+static inline int upipe_dump_json_open(const char *path,
+                                       struct uchain *ulist, ...)
+{
+    va_list args;
+    va_start(args, ulist);
+    int err = upipe_dump_json_open_va(path, ulist, args);
+    va_end(args);
+    return err;
+}
+
+/** @hidden */
+struct upump_mgr;
+/** @hidden */
+struct upipe_dump_profiler;
+
+/** @This allocates a pipeline profiler, which periodically exports a
+ * pipeline in JSON format (see @ref upipe_dump_json_va). The file is
+ * replaced atomically so that it may be polled by another process.
+ *
+ * @param upump_mgr management structure of the event loop, or NULL to only
+ * export with @ref upipe_dump_profiler_export
+ * @param period period of the export, in units of @ref UCLOCK_FREQ
+ * @param path path of the file to write to
+ * @param args list of sources pipes terminated with NULL, which are used by
+ * the profiler
+ * @return pointer to profiler, or NULL in case of error
+ */
+struct upipe_dump_profiler *
+    upipe_dump_profiler_alloc_va(struct upump_mgr *upump_mgr, uint64_t period,
+                                 const char *path, va_list args);
+
+/** @This allocates a pipeline profiler with a variable list of arguments.
+ *
+ * @param upump_mgr management structure of the event loop, or NULL
+ * @param period period of the export, in units of @ref UCLOCK_FREQ
+ * @param path path of the file to write to, followed by a list of source
+ * pipes terminated by NULL
+ * @return pointer to profiler, or NULL in case of error
+ */
+static inline struct upipe_dump_profiler *
+    upipe_dump_profiler_alloc(struct upump_mgr *upump_mgr, uint64_t period,
+                              const char *path, ...)
+{
+    va_list args;
+    va_start(args, path);
+    struct upipe_dump_profiler *profiler =
+        upipe_dump_profiler_alloc_va(upump_mgr, period, path, args);
+    va_end(args);
+    return profiler;
+}
+
+/** @This exports the pipeline of a profiler immediately.
+ *
+ * @param profiler pointer to profiler
+ * @return an error code
+ */
+int upipe_dump_profiler_export(struct upipe_dump_profiler *profiler);
+
+/** @This frees a pipeline profiler and releases its source pipes.
+ *
+ * @param profiler pointer to profiler
+ */
+void upipe_dump_profiler_free(struct upipe_dump_profiler *profiler);
+
 #ifdef __cplusplus
 }
 #endif
@@ -37,6 +37,7 @@ extern "C" {
 #include <upipe/ubase.h>
 #include <upipe/uref.h>
 #include <upipe/uref_attr.h>
+#include <upipe/uref_flow.h>
 #include <upipe/upipe.h>
 
 /** @This declares six functions dealing with the management of flow definitions
@@ -153,7 +154,7 @@ static UBASE_UNUSED bool                                                    \
 {                                                                           \
     struct STRUCTURE *s = STRUCTURE##_from_upipe(upipe);                    \
     return s->FLOW_DEF_ATTR != NULL &&                                      \
-           !udict_cmp(s->FLOW_DEF_ATTR->udict, flow_def_attr->udict);       \
+           uref_flow_def_equal_fast(s->FLOW_DEF_ATTR, flow_def_attr);       \
 }                                                                           \
 /** @internal @This stores a flow def attributes uref, and returns the new  \
  * flow definition.                                                         \
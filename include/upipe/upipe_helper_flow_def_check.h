@@ -37,6 +37,7 @@ extern "C" {
 #include <upipe/ubase.h>
 #include <upipe/uref.h>
 #include <upipe/udict.h>
+#include <upipe/uref_flow.h>
 #include <upipe/upipe.h>
 
 /** @This declares five functions dealing with the checking of input
@@ -119,7 +120,7 @@ static bool STRUCTURE##_check_flow_def_check(struct upipe *upipe,           \
 {                                                                           \
     struct STRUCTURE *s = STRUCTURE##_from_upipe(upipe);                    \
     return s->FLOW_DEF_CHECK != NULL &&                                     \
-           !udict_cmp(s->FLOW_DEF_CHECK->udict, flow_def_check->udict);     \
+           uref_flow_def_equal_fast(s->FLOW_DEF_CHECK, flow_def_check);     \
 }                                                                           \
 /** @internal @This stores a flow def check uref.                           \
  *                                                                          \
@@ -227,6 +227,8 @@ static void STRUCTURE##_hold_input(struct upipe *upipe, struct uref *uref)  \
     struct STRUCTURE *s = STRUCTURE##_from_upipe(upipe);                    \
     ulist_add(&s->UREFS, uref_to_uchain(uref));                             \
     s->NB_UREFS++;                                                          \
+    upipe_stats_queue(upipe, s->NB_UREFS);                                  \
+    upipe_stats_hold(upipe, uref);                                          \
 }                                                                           \
 /** @internal @This pops an uref from the buffered urefs.                   \
  *                                                                          \
@@ -240,7 +242,10 @@ static UBASE_UNUSED struct uref *STRUCTURE##_pop_input(struct upipe *upipe) \
     if (uchain == NULL)                                                     \
         return NULL;                                                        \
     s->NB_UREFS--;                                                          \
-    return uref_from_uchain(uchain);                                        \
+    upipe_stats_queue(upipe, s->NB_UREFS);                                  \
+    struct uref *uref = uref_from_uchain(uchain);                           \
+    upipe_stats_unhold(upipe, uref);                                        \
+    return uref;                                                            \
 }                                                                           \
 /** @internal @This pushes an uref back into the buffered urefs.            \
  *                                                                          \
@@ -253,6 +258,8 @@ static UBASE_UNUSED void STRUCTURE##_unshift_input(struct upipe *upipe,     \
     struct STRUCTURE *s = STRUCTURE##_from_upipe(upipe);                    \
     ulist_unshift(&s->UREFS, uref_to_uchain(uref));                         \
     s->NB_UREFS++;                                                          \
+    upipe_stats_queue(upipe, s->NB_UREFS);                                  \
+    upipe_stats_hold(upipe, uref);                                          \
 }                                                                           \
 /** @internal @This outputs all urefs that have been held.                  \
  *                                                                          \
@@ -265,7 +272,9 @@ static UBASE_UNUSED bool STRUCTURE##_output_input(struct upipe *upipe)      \
     struct uchain *uchain;                                                  \
     while ((uchain = ulist_pop(&s->UREFS)) != NULL) {                       \
         s->NB_UREFS--;                                                      \
+        upipe_stats_queue(upipe, s->NB_UREFS);                              \
         struct uref *uref = uref_from_uchain(uchain);                       \
+        upipe_stats_unhold(upipe, uref);                                    \
         bool (*output)(struct upipe *, struct uref *, struct upump **) =    \
             OUTPUT;                                                         \
         assert(output != NULL);                                             \
@@ -312,12 +321,14 @@ static void STRUCTURE##_clean_input(struct upipe *upipe)                    \
 {                                                                           \
     struct STRUCTURE *s = STRUCTURE##_from_upipe(upipe);                    \
     s->NB_UREFS = 0;                                                        \
+    upipe_stats_queue(upipe, s->NB_UREFS);                                  \
     STRUCTURE##_unblock_input(upipe);                                       \
     struct uchain *uchain, *uchain_tmp;                                     \
     ulist_delete_foreach (&s->UREFS, uchain, uchain_tmp) {                  \
         upipe_dbg_va(upipe, "deleting still-born uref %p",                  \
                      uref_from_uchain(uchain));                             \
         ulist_delete(uchain);                                               \
+        upipe_stats_unhold(upipe, uref_from_uchain(uchain));                \
         uref_free(uref_from_uchain(uchain));                                \
     }                                                                       \
 }                                                                           \
@@ -41,6 +41,7 @@ extern "C" {
 #include <upipe/uref_attr.h>
 #include <upipe/uref_block.h>
 #include <upipe/uref_clock.h>
+#include <upipe/uref_trace.h>
 #include <upipe/upipe.h>
 
 #include <assert.h>
@@ -191,6 +192,18 @@ static struct uref *STRUCTURE##_extract_uref_stream(struct upipe *upipe,    \
     if (unlikely(uref == NULL))                                             \
         return NULL;                                                        \
     uref_block_truncate(uref, extracted);                                   \
+    /* keep the earliest ingress date of the spanned urefs */               \
+    size_t offset = STRUCTURE->NEXT_UREF_SIZE;                              \
+    struct uchain *uchain;                                                  \
+    ulist_foreach (&STRUCTURE->UREFS, uchain) {                             \
+        if (offset >= extracted)                                            \
+            break;                                                          \
+        struct uref *spanned = uref_from_uchain(uchain);                    \
+        uref_trace_merge(uref, spanned);                                    \
+        uint64_t size = 0;                                                  \
+        uref_attr_get_priv(spanned, &size);                                 \
+        offset += size;                                                     \
+    }                                                                       \
     STRUCTURE##_consume_uref_stream(upipe, extracted);                      \
     return uref;                                                            \
 }                                                                           \
@@ -37,6 +37,8 @@ extern "C" {
 #include <upipe/ubase.h>
 #include <upipe/urefcount.h>
 #include <upipe/ulifo.h>
+#include <upipe/ualloc_audit.h>
+#include <upipe/utrace.h>
 
 /** @hidden */
 struct upool;
@@ -114,8 +116,12 @@ static inline void upool_release(struct upool *upool)
 static inline void *upool_alloc_internal(struct upool *upool)
 {
     void *obj = ulifo_pop(&upool->lifo, void *);
-    if (unlikely(obj == NULL))
+    bool fallback = obj == NULL;
+    if (unlikely(fallback)) {
+        ualloc_audit_fallback("upool");
         obj = upool->alloc_cb(upool);
+    }
+    UTRACE3(upool_alloc, upool, obj, fallback);
     if (obj != NULL)
         upool_use(upool);
     return obj;
@@ -136,6 +142,7 @@ static inline void *upool_alloc_internal(struct upool *upool)
  */
 static inline void upool_free(struct upool *upool, void *obj)
 {
+    UTRACE2(upool_free, upool, obj);
     if (unlikely(!ulifo_push(&upool->lifo, obj)))
         upool->free_cb(upool, obj);
     upool_release(upool);
@@ -38,6 +38,7 @@ extern "C" {
 #include <upipe/ulist.h>
 #include <upipe/uref_flow.h>
 #include <upipe/ulog.h>
+#include <upipe/utrace.h>
 
 #include <stdbool.h>
 #include <stdarg.h>
@@ -107,6 +108,12 @@ enum uprobe_event {
     /** a pipe signals that a uref contains a UTC clock reference
      * (struct uref *, uint64_t) */
     UPROBE_CLOCK_UTC,
+    /** a pipe with instrumentation enabled periodically reports its
+     * counters (const struct upipe_stats *) */
+    UPROBE_STATS,
+    /** an instrumented pipe holds more octets of buffers than its memory
+     * cap (uint64_t) */
+    UPROBE_MEMORY_CAP,
 
     /** non-standard events implemented by a module type can start from
      * there (first arg = signature) */
@@ -142,6 +149,8 @@ static inline const char *uprobe_event_str(int event)
     case UPROBE_CLOCK_REF: return "UPROBE_CLOCK_REF";
     case UPROBE_CLOCK_TS: return "UPROBE_CLOCK_TS";
     case UPROBE_CLOCK_UTC: return "UPROBE_CLOCK_UTC";
+    case UPROBE_STATS: return "UPROBE_STATS";
+    case UPROBE_MEMORY_CAP: return "UPROBE_MEMORY_CAP";
     case UPROBE_LOCAL: break;
     }
     return NULL;
@@ -159,8 +168,34 @@ struct uprobe {
     uprobe_throw_func uprobe_throw;
     /** pointer to next probe, to be used by the uprobe_throw function */
     struct uprobe *next;
+
+    /** log events below this level are neither printed nor forwarded */
+    enum uprobe_log_level log_level;
+    /** true if the other log events are forwarded to the next probe, false
+     * if they are printed or if the probe is opaque */
+    bool log_forward;
+    /** mask of standard events (@ref UPROBE_EVENT_BIT) possibly caught by
+     * the probe, the others being forwarded unchanged to the next probe;
+     * local events are always considered caught */
+    uint32_t events;
 };
 
+/** @This returns the bit of a standard event in the events mask of a probe. */
+#define UPROBE_EVENT_BIT(event) (UINT32_C(1) << (event))
+
+/** @This is the events mask of a probe which may catch any event. */
+#define UPROBE_EVENTS_ALL UINT32_MAX
+
+/** @This is incremented whenever the log filter of a probe changes, so that
+ * pipes refresh their cached log level. It is read without barrier, so the
+ * change may be seen with a small delay by other threads. */
+extern volatile uint32_t uprobe_log_generation;
+
+/** @This is incremented whenever the events mask of a probe changes, so that
+ * pipes refresh their cached event dispatch table. It is read without
+ * barrier, like @ref uprobe_log_generation. */
+extern volatile uint32_t uprobe_event_generation;
+
 /** @This increments the reference count of a uprobe.
  *
  * @param uprobe pointer to uprobe
@@ -225,6 +260,78 @@ static inline void uprobe_init(struct uprobe *uprobe,
     uprobe->refcount = NULL;
     uprobe->uprobe_throw = uprobe_throw;
     uprobe->next = next;
+    uprobe->log_level = UPROBE_LOG_VERBOSE;
+    uprobe->log_forward = false;
+    uprobe->events = UPROBE_EVENTS_ALL;
+}
+
+/** @This changes the log filter of a probe, and invalidates the log levels
+ * cached by pipes. Probe implementations may directly set the fields in their
+ * initializer instead, as no pipe uses them yet.
+ *
+ * @param uprobe pointer to probe
+ * @param log_level log events below this level are dropped by the probe
+ * @param log_forward true if the other log events are forwarded unchanged to
+ * the next probe (typically for probes not catching log events)
+ */
+static inline void uprobe_set_log_filter(struct uprobe *uprobe,
+                                         enum uprobe_log_level log_level,
+                                         bool log_forward)
+{
+    uprobe->log_level = log_level;
+    uprobe->log_forward = log_forward;
+    uprobe_log_generation++;
+}
+
+/** @This returns the minimum level of the log events that may be printed by
+ * a probe hierarchy. The walk stops at the first probe which does not
+ * forward log events.
+ *
+ * @param uprobe pointer to probe hierarchy
+ * @return minimum log level
+ */
+static inline enum uprobe_log_level uprobe_get_log_level(struct uprobe *uprobe)
+{
+    enum uprobe_log_level log_level = UPROBE_LOG_VERBOSE;
+    while (uprobe != NULL) {
+        if (uprobe->log_level > log_level)
+            log_level = uprobe->log_level;
+        if (!uprobe->log_forward)
+            break;
+        uprobe = uprobe->next;
+    }
+    return log_level;
+}
+
+/** @This changes the mask of standard events possibly caught by a probe, and
+ * invalidates the dispatch tables cached by pipes. Probe implementations may
+ * directly set the field in their initializer instead, as no pipe uses them
+ * yet.
+ *
+ * @param uprobe pointer to probe
+ * @param events mask of @ref UPROBE_EVENT_BIT of the caught events
+ */
+static inline void uprobe_set_events(struct uprobe *uprobe, uint32_t events)
+{
+    uprobe->events = events;
+    uprobe_event_generation++;
+}
+
+/** @This returns the first probe of a hierarchy which may catch the given
+ * event, skipping the probes which would only forward it.
+ *
+ * @param uprobe pointer to probe hierarchy
+ * @param event event to catch
+ * @return pointer to the first interested probe, or NULL
+ */
+static inline struct uprobe *uprobe_find_catcher(struct uprobe *uprobe,
+                                                 int event)
+{
+    if (event < 0 || event >= 32)
+        return uprobe;
+    while (uprobe != NULL && !(uprobe->events & UPROBE_EVENT_BIT(event)))
+        uprobe = uprobe->next;
+    return uprobe;
 }
 
 /** @This cleans up a uprobe structure. It is typically called by the
@@ -276,6 +383,7 @@ static inline int uprobe_throw(struct uprobe *uprobe, struct upipe *upipe,
                                int event, ...)
 {
     va_list args;
+    UTRACE3(throw, uprobe, upipe, event);
     va_start(args, event);
     int err = uprobe_throw_va(uprobe, upipe, event, args);
     va_end(args);
@@ -324,6 +432,8 @@ static inline void uprobe_log_va(struct uprobe *uprobe, struct upipe *upipe,
                                 enum uprobe_log_level level,
                                 const char *format, ...)
 {
+    if (uprobe_get_log_level(uprobe) > level)
+        return;
     UBASE_VARARG(uprobe_log(uprobe, upipe, level, string))
 }
 
@@ -347,6 +457,8 @@ UBASE_FMT_PRINTF(3, 4)
 static inline void uprobe_err_va(struct uprobe *uprobe, struct upipe *upipe,
                                  const char *format, ...)
 {
+    if (uprobe_get_log_level(uprobe) > UPROBE_LOG_ERROR)
+        return;
     UBASE_VARARG(uprobe_err(uprobe, upipe, string))
 }
 
@@ -370,6 +482,8 @@ UBASE_FMT_PRINTF(3, 4)
 static inline void uprobe_warn_va(struct uprobe *uprobe, struct upipe *upipe,
                                   const char *format, ...)
 {
+    if (uprobe_get_log_level(uprobe) > UPROBE_LOG_WARNING)
+        return;
     UBASE_VARARG(uprobe_warn(uprobe, upipe, string))
 }
 
@@ -393,6 +507,8 @@ UBASE_FMT_PRINTF(3, 4)
 static inline void uprobe_notice_va(struct uprobe *uprobe, struct upipe *upipe,
                                     const char *format, ...)
 {
+    if (uprobe_get_log_level(uprobe) > UPROBE_LOG_NOTICE)
+        return;
     UBASE_VARARG(uprobe_notice(uprobe, upipe, string))
 }
 
@@ -416,6 +532,8 @@ UBASE_FMT_PRINTF(3, 4)
 static inline void uprobe_dbg_va(struct uprobe *uprobe, struct upipe *upipe,
                                  const char *format, ...)
 {
+    if (uprobe_get_log_level(uprobe) > UPROBE_LOG_DEBUG)
+        return;
     UBASE_VARARG(uprobe_dbg(uprobe, upipe, string))
 }
 
@@ -440,6 +558,8 @@ UBASE_FMT_PRINTF(3, 4)
 static inline void uprobe_verbose_va(struct uprobe *uprobe, struct upipe *upipe,
                                  const char *format, ...)
 {
+    if (uprobe_get_log_level(uprobe) > UPROBE_LOG_VERBOSE)
+        return;
     UBASE_VARARG(uprobe_verbose(uprobe, upipe, string))
 }
 
@@ -64,6 +64,22 @@ struct uprobe_dejitter {
     /** PLL drift rate */
     struct urational drift_rate;
 
+    /** loop bandwidth of the PI controller in millihertz, or 0 for the
+     * stepping PLL */
+    unsigned int bandwidth;
+    /** natural pulsation of the loop per tick, in 2^-40 */
+    uint64_t pll_pulsation;
+    /** number of references since the last phase reset */
+    unsigned int pll_phase_count;
+    /** number of references since the drift estimation started */
+    unsigned int pll_drift_count;
+    /** estimated drift of the stream clock, in 2^-32 */
+    int64_t pll_drift;
+    /** average absolute phase error, in ticks */
+    uint64_t pll_deviation;
+    /** probe providing the drift estimation, or NULL */
+    struct uprobe *pll_master;
+
     /** cr_sys of the last debug print */
     uint64_t last_print;
 
@@ -110,6 +126,26 @@ struct uprobe *uprobe_dejitter_alloc(struct uprobe *next, bool enabled,
 void uprobe_dejitter_set(struct uprobe *uprobe, bool enabled,
                          uint64_t deviation);
 
+/** @This switches the dejittering to a proportional-integral clock
+ * recovery with the given loop bandwidth. The first references are
+ * locked on quickly, and discontinuities only reset the phase, keeping the
+ * drift estimation. A bandwidth of 0 restores the stepping PLL.
+ *
+ * @param uprobe pointer to probe
+ * @param bandwidth loop bandwidth in millihertz, or 0
+ */
+void uprobe_dejitter_set_bandwidth(struct uprobe *uprobe,
+                                   unsigned int bandwidth);
+
+/** @This makes a probe use the drift estimated by another uprobe_dejitter,
+ * typically for the programs of a multiplex sharing the clock of the same
+ * source. Only the phase is then recovered locally.
+ *
+ * @param uprobe pointer to probe
+ * @param master pointer to the uprobe_dejitter estimating the drift, or NULL
+ */
+void uprobe_dejitter_set_master(struct uprobe *uprobe, struct uprobe *master);
+
 #ifdef __cplusplus
 }
 #endif
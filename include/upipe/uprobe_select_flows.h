@@ -31,6 +31,12 @@
  *
  * In case of a change of configuration, or if flows are added or deleted,
  * the selections are reconsidered.
+ *
+ * Flows which are not selected are only recorded, and no subpipe is
+ * allocated for them. With upipe_ts_demux, this means that the programs and
+ * elementary streams which are not selected get no PSI or PES decoders and
+ * no framers, and their PIDs are not set on the TS split pipe; deselecting a
+ * flow releases its subpipe, which removes its PIDs.
  */
 
 #ifndef _UPIPE_UPROBE_SELECT_FLOWS_H_
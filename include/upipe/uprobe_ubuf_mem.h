@@ -31,6 +31,7 @@
 /** @hidden */
 #define _UPIPE_UPROBE_UBUF_MEM_H_
 
+#include <upipe/ulist.h>
 #include <upipe/uprobe.h>
 #include <upipe/uprobe_helper_uprobe.h>
 
@@ -41,6 +42,10 @@ extern "C" {
 /** @hidden */
 struct umem_mgr;
 
+/** @This is an alignment suitable for the widest SIMD instruction sets
+ * (a cache line, and the size of an AVX-512 register). */
+#define UPROBE_UBUF_MEM_SIMD_ALIGN 64
+
 /** @This is a super-set of the uprobe structure with additional local
  * members. */
 struct uprobe_ubuf_mem {
@@ -50,6 +55,20 @@ struct uprobe_ubuf_mem {
     uint16_t ubuf_pool_depth;
     /** depth of the shared object pool */
     uint16_t shared_pool_depth;
+    /** minimum alignment of the lines of pictures, in octets */
+    uint64_t pic_align;
+    /** minimum number of extra macropixels before and after lines */
+    uint8_t pic_hmpadding;
+    /** minimum number of extra lines before and after pictures */
+    uint8_t pic_vpadding;
+    /** depth of the exact-size frame pool of picture managers, or 0 */
+    uint16_t pic_frame_pool_depth;
+    /** list of recently allocated managers, most recent first */
+    struct uchain cache;
+    /** number of managers in the cache */
+    unsigned int cache_size;
+    /** maximum number of managers in the cache, or 0 */
+    unsigned int cache_depth;
 
     /** structure exported to modules */
     struct uprobe uprobe;
@@ -98,6 +117,46 @@ struct uprobe *uprobe_ubuf_mem_alloc(struct uprobe *next,
  */
 void uprobe_ubuf_mem_set(struct uprobe *uprobe, struct umem_mgr *umem_mgr);
 
+/** @This sets the minimum alignment and padding of the picture managers
+ * allocated by this probe, whatever the requesting pipes asked for. It
+ * allows SIMD routines anywhere in the pipeline to use their aligned code
+ * paths, and motion search or edge emulation to read outside of the
+ * picture.
+ *
+ * @param uprobe pointer to probe
+ * @param align minimum alignment of lines in octets, for instance
+ * @ref UPROBE_UBUF_MEM_SIMD_ALIGN, or 0
+ * @param hmpadding minimum number of extra macropixels before and after
+ * each line
+ * @param vpadding minimum number of extra lines before and after each
+ * picture
+ */
+void uprobe_ubuf_mem_set_pic_align(struct uprobe *uprobe, uint64_t align,
+                                   uint8_t hmpadding, uint8_t vpadding);
+
+/** @This enables an exact-size frame pool in the picture managers allocated
+ * by this probe, so that decoders, scalers and encoders working on the same
+ * dimensions recycle their frames without the rounding of the umem size
+ * classes.
+ *
+ * @param uprobe pointer to probe
+ * @param depth maximum number of frames kept by each manager, or 0 to
+ * disable
+ */
+void uprobe_ubuf_mem_set_pic_frame_pool(struct uprobe *uprobe,
+                                        uint16_t depth);
+
+/** @This enables a cache of the managers allocated by this probe, keyed by
+ * the requested flow format, so that pipes switching back to a recently
+ * used format get the same manager and its warm pools. The cache is not
+ * thread-safe, so the probe must only be used by pipes of the same thread.
+ *
+ * @param uprobe pointer to probe
+ * @param depth maximum number of managers kept in the cache, or 0 to
+ * disable
+ */
+void uprobe_ubuf_mem_set_cache(struct uprobe *uprobe, unsigned int depth);
+
 #ifdef __cplusplus
 }
 #endif
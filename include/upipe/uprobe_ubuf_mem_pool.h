@@ -42,11 +42,17 @@ extern "C" {
 /** @hidden */
 struct umem_mgr;
 
+/** @This is the maximum number of NUMA nodes having a dedicated umem
+ * manager. */
+#define UPROBE_UBUF_MEM_POOL_MAX_NODES 8
+
 /** @This is a super-set of the uprobe structure with additional local
  * members. */
 struct uprobe_ubuf_mem_pool {
     /** pointer to umem_mgr to use to allocate ubuf manager */
     struct umem_mgr *umem_mgr;
+    /** pointers to umem_mgr to use on a given NUMA node, or NULL */
+    struct umem_mgr *node_umem_mgrs[UPROBE_UBUF_MEM_POOL_MAX_NODES];
     /** depth of the ubuf pool */
     uint16_t ubuf_pool_depth;
     /** depth of the shared object pool */
@@ -110,6 +116,22 @@ struct uprobe *uprobe_ubuf_mem_pool_alloc(struct uprobe *next,
  */
 void uprobe_ubuf_mem_pool_set(struct uprobe *uprobe, struct umem_mgr *umem_mgr);
 
+/** @This changes the umem_mgr used by this probe when the event is thrown
+ * from a thread running on the given NUMA node, so that pipes get node-local
+ * buffers. Threads on nodes without a dedicated manager (or when the node
+ * cannot be determined) use the default umem_mgr. Please note that this
+ * function is not thread-safe, and mustn't be used if the probe may be called
+ * from another thread.
+ *
+ * @param uprobe pointer to probe
+ * @param node NUMA node
+ * @param umem_mgr umem manager to use on this node, or NULL to revert to the
+ * default umem manager
+ * @return an error code
+ */
+int uprobe_ubuf_mem_pool_set_node(struct uprobe *uprobe, unsigned int node,
+                                  struct umem_mgr *umem_mgr);
+
 #ifdef __cplusplus
 }
 #endif
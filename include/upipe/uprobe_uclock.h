@@ -40,6 +40,8 @@ extern "C" {
 
 /** @hidden */
 struct uclock;
+/** @hidden */
+struct upump_mgr;
 
 /** @This is a super-set of the uprobe structure with additional local
  * members. */
@@ -85,6 +87,20 @@ struct uprobe *uprobe_uclock_alloc(struct uprobe *next, struct uclock *uclock);
  */
 void uprobe_uclock_set(struct uprobe *uprobe, struct uclock *uclock);
 
+/** @This allocates a new uprobe_uclock structure providing a virtual clock,
+ * which also drives the timers of the given event loop (see
+ * @ref upump_mgr_set_virtual_clock). All the pipes below the probe then run
+ * faster than real time, which is suitable for file-to-file processing.
+ *
+ * @param next next probe to test if this one doesn't catch the event
+ * @param upump_mgr event loop running the pipes
+ * @param start initial date of the clock, in 27 MHz ticks
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_uclock_alloc_virtual(struct uprobe *next,
+                                           struct upump_mgr *upump_mgr,
+                                           uint64_t start);
+
 #ifdef __cplusplus
 }
 #endif
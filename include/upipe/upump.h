@@ -52,6 +52,10 @@ struct upump_blocker;
 /** @hidden */
 struct umutex;
 
+/** @This is the granularity of coarse timers, in ticks of a 27 MHz clock
+ * (1 ms). */
+#define UPUMP_TIMER_COARSE_TICK UINT64_C(27000)
+
 /** @This defines the standard types of pumps. */
 enum upump_type {
     /** event continuously triggers (no argument) */
@@ -67,6 +71,9 @@ enum upump_type {
     UPUMP_TYPE_FD_WRITE,
     /** event triggers on a UNIX signal (argument = int) */
     UPUMP_TYPE_SIGNAL,
+    /** event triggers once after a given timeout, with a granularity of
+     * @ref UPUMP_TIMER_COARSE_TICK (arguments = uint64_t, uint64_t) */
+    UPUMP_TYPE_TIMER_COARSE,
     /* TODO: Windows objects */
 
     /** non-standard types implemented by a upump handler can start
@@ -90,6 +97,8 @@ enum upump_command {
     UPUMP_ALLOC_BLOCKER,
     /** frees a blocker (struct upump_blocker *) */
     UPUMP_FREE_BLOCKER,
+    /** gets the profiling counters (struct upump_profile *) */
+    UPUMP_GET_PROFILE,
 
     /** non-standard commands implemented by a upump handler can start
      * from there (first arg = signature) */
@@ -99,6 +108,43 @@ enum upump_command {
 /** function called when a pump is triggered */
 typedef void (*upump_cb)(struct upump *);
 
+/** @hidden */
+struct uclock;
+
+/** @This stores the profiling counters of a pump, see
+ * @ref upump_mgr_set_profiling. Durations are in units of @ref UCLOCK_FREQ.
+ */
+struct upump_profile {
+    /** number of calls to the callback */
+    uint64_t count;
+    /** cumulated time spent in the callback */
+    uint64_t run_time;
+    /** maximum time spent in one call to the callback */
+    uint64_t max_run_time;
+    /** cumulated lateness of a timer */
+    uint64_t lateness;
+    /** maximum lateness of a timer */
+    uint64_t max_lateness;
+};
+
+/** @This stores the profiling counters of an event loop, see
+ * @ref upump_mgr_set_profiling. Durations are in units of @ref UCLOCK_FREQ.
+ */
+struct upump_mgr_profile {
+    /** number of loop iterations */
+    uint64_t iterations;
+    /** cumulated duration of the loop iterations */
+    uint64_t total_time;
+    /** cumulated time spent processing events */
+    uint64_t busy_time;
+    /** duration of the last loop iteration */
+    uint64_t last_total_time;
+    /** time spent processing events in the last loop iteration */
+    uint64_t last_busy_time;
+    /** maximum time spent processing events in one loop iteration */
+    uint64_t max_busy_time;
+};
+
 /** @This stores a pump of a given event loop.
  *
  * The structure is not refcounted and shouldn't be used by more than one
@@ -131,6 +177,12 @@ enum upump_mgr_command {
     UPUMP_MGR_RUN,
     /** release all buffers kept in pools (void) */
     UPUMP_MGR_VACUUM,
+    /** enables or disables profiling (struct uclock *) */
+    UPUMP_MGR_SET_PROFILING,
+    /** gets the profiling counters of the loop (struct upump_mgr_profile *) */
+    UPUMP_MGR_GET_PROFILE,
+    /** makes timers run on a virtual clock (struct uclock *) */
+    UPUMP_MGR_SET_VIRTUAL_CLOCK,
 
     /** non-standard manager commands implemented by a upump handler can start
      * from there (first arg = signature) */
@@ -232,6 +284,35 @@ static inline struct upump *upump_alloc_timer(struct upump_mgr *mgr,
                        after, repeat);
 }
 
+/** @This allocates and initializes a pump for a coarse timer. Coarse timers
+ * are kept on a timer wheel shared by the event loop, so that starting and
+ * stopping them is cheap, and all the timers expiring during the same tick
+ * are dispatched together. They trigger up to @ref UPUMP_TIMER_COARSE_TICK
+ * late, and are meant for pipes which tolerate it (timeouts, statistics).
+ * If the event loop doesn't implement them, a normal timer is allocated.
+ *
+ * @param mgr management structure for this event loop
+ * @param cb function to call when the pump triggers
+ * @param opaque pointer to the module's internal structure
+ * @param refcount pointer to urefcount structure to increment during callback,
+ * or NULL
+ * @param after time after which it triggers, in ticks of a 27 MHz monotonic
+ * clock
+ * @param repeat pump will trigger again each repeat occurrence, in ticks
+ * of a 27 MHz monotonic clock (0 to disable)
+ * @return pointer to allocated pump, or NULL in case of failure
+ */
+static inline struct upump *upump_alloc_timer_coarse(struct upump_mgr *mgr,
+        upump_cb cb, void *opaque, struct urefcount *refcount,
+        uint64_t after, uint64_t repeat)
+{
+    struct upump *upump = upump_alloc(mgr, cb, opaque, refcount,
+                                      UPUMP_TYPE_TIMER_COARSE, after, repeat);
+    if (unlikely(upump == NULL))
+        upump = upump_alloc_timer(mgr, cb, opaque, refcount, after, repeat);
+    return upump;
+}
+
 /** @This allocates and initializes a pump for a readable file descriptor.
  *
  * @param mgr management structure for this event loop
@@ -402,6 +483,19 @@ static inline void upump_set_cb(struct upump *upump, upump_cb cb, void *opaque)
     upump->opaque = opaque;
 }
 
+/** @This gets the profiling counters of a pump.
+ *
+ * @param upump description structure of the pump
+ * @param profile filled in with the profiling counters
+ * @return an error code, including @ref UBASE_ERR_INVALID if profiling is
+ * disabled
+ */
+static inline int upump_get_profile(struct upump *upump,
+                                    struct upump_profile *profile)
+{
+    return upump_control(upump, UPUMP_GET_PROFILE, profile);
+}
+
 /** @This increments the reference count of a upump manager.
  *
  * @param mgr pointer to upump manager
@@ -504,6 +598,50 @@ static inline int upump_mgr_vacuum(struct upump_mgr *mgr)
     return upump_mgr_control(mgr, UPUMP_MGR_VACUUM);
 }
 
+/** @This enables or disables the profiling of an event loop. When enabled,
+ * the time spent in the callback of each pump, the lateness of timers and
+ * the utilisation of the loop are measured.
+ *
+ * @param mgr pointer to upump manager
+ * @param uclock clock used to measure time, or NULL to disable profiling
+ * @return an error code
+ */
+static inline int upump_mgr_set_profiling(struct upump_mgr *mgr,
+                                          struct uclock *uclock)
+{
+    return upump_mgr_control(mgr, UPUMP_MGR_SET_PROFILING, uclock);
+}
+
+/** @This gets the profiling counters of an event loop.
+ *
+ * @param mgr pointer to upump manager
+ * @param profile filled in with the profiling counters
+ * @return an error code, including @ref UBASE_ERR_INVALID if profiling is
+ * disabled
+ */
+static inline int upump_mgr_get_profile(struct upump_mgr *mgr,
+                                        struct upump_mgr_profile *profile)
+{
+    return upump_mgr_control(mgr, UPUMP_MGR_GET_PROFILE, profile);
+}
+
+/** @This makes the timers of an event loop run on a virtual clock, allocated
+ * with @ref uclock_virtual_alloc. Whenever the loop has nothing else to do,
+ * instead of sleeping it advances the clock to the date of the next timer and
+ * triggers it immediately, so that a graph reading files runs as fast as the
+ * CPU allows. It must be called before any timer is started, and the clock
+ * must not be shared with another event loop.
+ *
+ * @param mgr pointer to upump manager
+ * @param uclock virtual clock, or NULL to go back to real time
+ * @return an error code
+ */
+static inline int upump_mgr_set_virtual_clock(struct upump_mgr *mgr,
+                                              struct uclock *uclock)
+{
+    return upump_mgr_control(mgr, UPUMP_MGR_SET_VIRTUAL_CLOCK, uclock);
+}
+
 #ifdef __cplusplus
 }
 #endif
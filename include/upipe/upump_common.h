@@ -45,6 +45,13 @@ extern "C" {
 /** @hidden */
 struct upump_blocker;
 
+/** number of bits of the slot index in a level of the timer wheel */
+#define UPUMP_COMMON_WHEEL_BITS 6
+/** number of slots in a level of the timer wheel */
+#define UPUMP_COMMON_WHEEL_SLOTS (1 << UPUMP_COMMON_WHEEL_BITS)
+/** number of levels of the timer wheel */
+#define UPUMP_COMMON_WHEEL_LEVELS 4
+
 /** @This stores upump parameters invisible from modules but usually common.
  */
 struct upump_common {
@@ -55,11 +62,34 @@ struct upump_common {
     /** list of blockers registered on this pump */
     struct uchain blockers;
 
+    /** true if the pump is a timer */
+    bool timer;
+    /** delay of the first trigger of a timer */
+    uint64_t after;
+    /** period of a timer, or 0 */
+    uint64_t repeat;
+    /** expected date of the next trigger of a timer, or 0 if unknown */
+    uint64_t deadline;
+    /** structure for the list of timers scheduled on the virtual clock */
+    struct uchain virtual_uchain;
+    /** date of the next trigger of a timer on the virtual clock */
+    uint64_t virtual_deadline;
+    /** true if the timer may be scheduled on the timer wheel */
+    bool coarse;
+    /** structure for the slot of the timer wheel */
+    struct uchain wheel_uchain;
+    /** tick of the timer wheel at which the timer triggers */
+    uint64_t wheel_expiry;
+    /** profiling counters */
+    struct upump_profile profile;
+
     /** public upump structure */
     struct upump upump;
 };
 
 UBASE_FROM_TO(upump_common, upump, upump, upump)
+UBASE_FROM_TO(upump_common, uchain, virtual_uchain, virtual_uchain)
+UBASE_FROM_TO(upump_common, uchain, wheel_uchain, wheel_uchain)
 
 /** @This allocates and initializes a blocker.
  *
@@ -80,12 +110,42 @@ void upump_common_blocker_free(struct upump_blocker *blocker);
  */
 void upump_common_init(struct upump *upump);
 
+/** @This declares a pump as a timer, so that its lateness is profiled.
+ *
+ * @param upump description structure of the pump
+ * @param after delay of the first trigger
+ * @param repeat period of the timer, or 0
+ */
+void upump_common_set_timer(struct upump *upump, uint64_t after,
+                            uint64_t repeat);
+
+/** @This declares a pump as a coarse timer, scheduled on the timer wheel of
+ * the manager instead of a real watcher (see @ref UPUMP_TYPE_TIMER_COARSE).
+ * The real manager must still be able to start the pump as a normal timer,
+ * which is used as a fallback.
+ *
+ * @param upump description structure of the pump
+ * @param after delay of the first trigger
+ * @param repeat period of the timer, or 0
+ */
+void upump_common_set_timer_coarse(struct upump *upump, uint64_t after,
+                                   uint64_t repeat);
+
 /** @This dispatches a pump.
  *
  * @param upump description structure of the pump
  */
 void upump_common_dispatch(struct upump *upump);
 
+/** @This gets the profiling counters of a pump.
+ *
+ * @param upump description structure of the pump
+ * @param profile filled in with the profiling counters
+ * @return an error code
+ */
+int upump_common_get_profile(struct upump *upump,
+                             struct upump_profile *profile);
+
 /** @This starts a pump if allowed.
  *
  * @param upump description structure of the pump
@@ -132,6 +192,39 @@ struct upump_common_mgr {
     /** function to really stop a watcher */
     void (*upump_real_stop)(struct upump *, bool);
 
+    /** clock used for profiling, or NULL if disabled */
+    struct uclock *uclock;
+    /** virtual clock driving the timers, or NULL for real time */
+    struct uclock *virtual_clock;
+    /** list of timers scheduled on the virtual clock, by deadline */
+    struct uchain virtual_timers;
+    /** number of blocking timers scheduled on the virtual clock */
+    unsigned int nb_virtual_active;
+    /** slots of the timer wheel, from the finest level */
+    struct uchain wheel[UPUMP_COMMON_WHEEL_LEVELS][UPUMP_COMMON_WHEEL_SLOTS];
+    /** next tick of the timer wheel to process */
+    uint64_t wheel_next;
+    /** number of timers scheduled on the timer wheel */
+    unsigned int nb_wheel;
+    /** number of blocking timers scheduled on the timer wheel */
+    unsigned int nb_wheel_active;
+    /** real timer driving the timer wheel, or NULL if it is empty */
+    struct upump *wheel_pump;
+    /** clock giving the date of the ticks of the timer wheel */
+    struct uclock *wheel_clock;
+    /** date at which the next tick of the timer wheel is due */
+    uint64_t wheel_date;
+    /** true while expired timers are being dispatched */
+    bool wheel_running;
+    /** date of the beginning of the current loop iteration, or 0 */
+    uint64_t iteration_start;
+    /** date at which the loop woke up, or 0 if it is sleeping */
+    uint64_t busy_start;
+    /** pump being dispatched while profiling */
+    struct upump_common *current;
+    /** profiling counters */
+    struct upump_mgr_profile profile;
+
     /** structure exported to modules */
     struct upump_mgr mgr;
 };
@@ -148,6 +241,72 @@ UBASE_FROM_TO(upump_common_mgr, upool, upump_blocker_pool, upump_blocker_pool)
  */
 void upump_common_mgr_vacuum(struct upump_mgr *mgr);
 
+/** @This enables or disables profiling.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_common_mgr structure
+ * @param uclock clock used to measure time, or NULL to disable profiling
+ */
+void upump_common_mgr_set_profiling(struct upump_mgr *mgr,
+                                    struct uclock *uclock);
+
+/** @This gets the profiling counters of the event loop.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_common_mgr structure
+ * @param profile filled in with the profiling counters
+ * @return an error code
+ */
+int upump_common_mgr_get_profile(struct upump_mgr *mgr,
+                                 struct upump_mgr_profile *profile);
+
+/** @This makes timers run on a virtual clock. Instead of arming real
+ * timers, started timer pumps are scheduled on the virtual clock, and the
+ * event loop is expected to call @ref upump_common_mgr_dispatch_virtual
+ * whenever it would otherwise sleep. This must be called before any timer
+ * is started.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_common_mgr structure
+ * @param uclock virtual clock (see @ref uclock_virtual_alloc), or NULL to
+ * go back to real time
+ * @return an error code
+ */
+int upump_common_mgr_set_virtual_clock(struct upump_mgr *mgr,
+                                       struct uclock *uclock);
+
+/** @This checks whether timers are scheduled on the virtual clock.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_common_mgr structure
+ * @param active_p filled in with true if one of them is blocking, or NULL
+ * @return true if timers are scheduled
+ */
+bool upump_common_mgr_virtual_pending(struct upump_mgr *mgr, bool *active_p);
+
+/** @This advances the virtual clock to the date of the next timer, and
+ * dispatches it.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_common_mgr structure
+ * @return false if no timer is scheduled
+ */
+bool upump_common_mgr_dispatch_virtual(struct upump_mgr *mgr);
+
+/** @This is called by the event loop when it wakes up to process events.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_common_mgr structure
+ */
+void upump_common_mgr_wake(struct upump_mgr *mgr);
+
+/** @This is called by the event loop before it goes to sleep.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_common_mgr structure
+ */
+void upump_common_mgr_sleep(struct upump_mgr *mgr);
+
 /** @This returns the extra buffer space needed for pools.
  *
  * @param upump_pool_depth maximum number of upump structures in the pool
@@ -40,9 +40,12 @@ extern "C" {
 #include <upipe/ufifo.h>
 #include <upipe/ueventfd.h>
 #include <upipe/upump.h>
+#include <upipe/utrace.h>
 
 #include <stdint.h>
 #include <assert.h>
+#include <time.h>
+#include <sched.h>
 
 /** @This is the implementation of a queue. */
 struct uqueue {
@@ -56,6 +59,13 @@ struct uqueue {
     struct ueventfd event_push;
     /** ueventfd triggered when data can be popped */
     struct ueventfd event_pop;
+    /** time (in ns) to busy-poll an empty queue before yielding */
+    uatomic_uint32_t wait_spin;
+    /** number of times to yield on an empty queue before blocking */
+    uatomic_uint32_t wait_yields;
+    /** number of elements at which event_push is also triggered when the
+     * queue drains, or UINT32_MAX */
+    uatomic_uint32_t low_mark;
 };
 
 /** @This returns the required size of extra data space for uqueue.
@@ -85,10 +95,87 @@ static inline bool uqueue_init(struct uqueue *uqueue, uint8_t length,
 
     ufifo_init(&uqueue->fifo, length, extra);
     uatomic_init(&uqueue->counter, 0);
+    uatomic_init(&uqueue->wait_spin, 0);
+    uatomic_init(&uqueue->wait_yields, 0);
+    uatomic_init(&uqueue->low_mark, UINT32_MAX);
     uqueue->length = length;
     return true;
 }
 
+/** @This sets the wait policy of the consumer, when the queue is found empty.
+ * The consumer first busy-polls the queue for the given time, then yields the
+ * CPU the given number of times, and only then blocks on the eventfd. The
+ * default (0, 0) is to block immediately. This trades CPU time for lower
+ * wakeup jitter. It may be called from any thread.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param spin_ns time (in ns) to busy-poll the queue
+ * @param yields number of times to yield the CPU
+ */
+static inline void uqueue_set_wait_policy(struct uqueue *uqueue,
+                                          uint32_t spin_ns, uint32_t yields)
+{
+    uatomic_store(&uqueue->wait_spin, spin_ns);
+    uatomic_store(&uqueue->wait_yields, yields);
+}
+
+/** @This sets the low mark of the queue. When the consumer drains the queue
+ * down to this number of elements, the push watcher is triggered, as when a
+ * full queue can be written again. This allows the producer to wait for the
+ * queue to drain without polling it. It may be called from any thread.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param low_mark number of elements, or UINT32_MAX to disable
+ */
+static inline void uqueue_set_low_mark(struct uqueue *uqueue,
+                                       uint32_t low_mark)
+{
+    uatomic_store(&uqueue->low_mark, low_mark);
+}
+
+/** @internal @This returns the monotonic time in ns.
+ *
+ * @return current time in ns
+ */
+static inline uint64_t uqueue_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+/** @internal @This waits for an element to be pushed according to the
+ * wait policy.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @return true if an element may be popped
+ */
+static inline bool uqueue_wait_internal(struct uqueue *uqueue)
+{
+    uint32_t spin = uatomic_load(&uqueue->wait_spin);
+    uint32_t yields = uatomic_load(&uqueue->wait_yields);
+    if (likely(!spin && !yields))
+        return false;
+
+    if (spin) {
+        uint64_t deadline = uqueue_now_ns() + spin;
+        do {
+            if ((int32_t)uatomic_load(&uqueue->counter) > 0)
+                return true;
+#if defined(__i386__) || defined(__x86_64__)
+            __builtin_ia32_pause();
+#endif
+        } while (uqueue_now_ns() < deadline);
+    }
+
+    for (uint32_t i = 0; i < yields; i++) {
+        sched_yield();
+        if ((int32_t)uatomic_load(&uqueue->counter) > 0)
+            return true;
+    }
+    return false;
+}
+
 /** @This allocates a watcher triggering when data is ready to be pushed.
  *
  * @param uqueue pointer to a uqueue structure
@@ -140,18 +227,77 @@ static inline bool uqueue_push(struct uqueue *uqueue, void *element)
         ueventfd_read(&uqueue->event_push);
 
         /* double-check */
-        if (likely(!ufifo_push(&uqueue->fifo, element)))
+        if (likely(!ufifo_push(&uqueue->fifo, element))) {
+            UTRACE2(uqueue_push, uqueue, 0);
             return false;
+        }
 
         /* signal that we're alright again */
         ueventfd_write(&uqueue->event_push);
     }
 
+    UTRACE2(uqueue_push, uqueue, 1);
     if (unlikely(uatomic_fetch_add(&uqueue->counter, 1) == 0))
         ueventfd_write(&uqueue->event_pop);
     return true;
 }
 
+/** @internal @This adds pushed elements to the counter of elements, and
+ * triggers the pop watcher if the queue was empty.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param nb number of pushed elements
+ */
+static inline void uqueue_push_account(struct uqueue *uqueue, unsigned int nb)
+{
+    if (unlikely(!nb))
+        return;
+    /* the counter may transiently be negative if elements were popped
+     * before being accounted for */
+    int32_t counter = uatomic_fetch_add(&uqueue->counter, nb);
+    if (unlikely(counter <= 0 && counter + (int32_t)nb > 0))
+        ueventfd_write(&uqueue->event_pop);
+}
+
+/** @This pushes several elements into the queue, updating the counter of
+ * elements with a single atomic operation and triggering the pop watcher
+ * at most once.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param elements array of pointers to elements to push
+ * @param nb number of elements in the array
+ * @return number of elements actually queued, in order; elements beyond that
+ * couldn't be queued because the queue is full
+ */
+static inline unsigned int uqueue_push_batch(struct uqueue *uqueue,
+                                             void **elements, unsigned int nb)
+{
+    unsigned int pushed = 0, accounted = 0;
+    while (pushed < nb) {
+        if (unlikely(!ufifo_push(&uqueue->fifo, elements[pushed]))) {
+            /* account for the elements already pushed, so that the consumer
+             * sees the queue full and triggers the push watcher */
+            uqueue_push_account(uqueue, pushed - accounted);
+            accounted = pushed;
+
+            /* signal that we are full */
+            ueventfd_read(&uqueue->event_push);
+
+            /* double-check */
+            if (likely(!ufifo_push(&uqueue->fifo, elements[pushed])))
+                break;
+
+            /* signal that we're alright again */
+            ueventfd_write(&uqueue->event_push);
+        }
+        pushed++;
+    }
+
+    UTRACE2(uqueue_push, uqueue, pushed);
+    uqueue_push_account(uqueue, pushed - accounted);
+    return pushed;
+}
+
 /** @internal @This pops an element from the queue.
  *
  * @param uqueue pointer to a uqueue structure
@@ -160,6 +306,8 @@ static inline bool uqueue_push(struct uqueue *uqueue, void *element)
 static inline void *uqueue_pop_internal(struct uqueue *uqueue)
 {
     void *element = ufifo_pop(&uqueue->fifo, void *);
+    if (unlikely(element == NULL) && uqueue_wait_internal(uqueue))
+        element = ufifo_pop(&uqueue->fifo, void *);
     if (unlikely(element == NULL)) {
         /* signal that we starve */
         ueventfd_read(&uqueue->event_pop);
@@ -173,7 +321,11 @@ static inline void *uqueue_pop_internal(struct uqueue *uqueue)
         ueventfd_write(&uqueue->event_pop);
     }
 
-    if (unlikely(uatomic_fetch_sub(&uqueue->counter, 1) == uqueue->length))
+    UTRACE2(uqueue_pop, uqueue, 1);
+    uint32_t counter = uatomic_fetch_sub(&uqueue->counter, 1);
+    uint32_t low_mark = uatomic_load(&uqueue->low_mark);
+    if (unlikely(counter == uqueue->length ||
+                 (low_mark != UINT32_MAX && counter == low_mark + 1)))
         ueventfd_write(&uqueue->event_push);
     return element;
 }
@@ -186,6 +338,71 @@ static inline void *uqueue_pop_internal(struct uqueue *uqueue)
  */
 #define uqueue_pop(uqueue, type) (type)uqueue_pop_internal(uqueue)
 
+/** @internal @This removes popped elements from the counter of elements,
+ * and triggers the push watcher if the queue was full or drained to the low
+ * mark.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param nb number of popped elements
+ */
+static inline void uqueue_pop_account(struct uqueue *uqueue, unsigned int nb)
+{
+    if (unlikely(!nb))
+        return;
+    int32_t counter = uatomic_fetch_sub(&uqueue->counter, nb);
+    uint32_t low_mark = uatomic_load(&uqueue->low_mark);
+    if (unlikely((counter >= (int32_t)uqueue->length &&
+                  counter - (int32_t)nb < (int32_t)uqueue->length) ||
+                 (low_mark != UINT32_MAX && counter > (int32_t)low_mark &&
+                  counter - (int32_t)nb <= (int32_t)low_mark)))
+        ueventfd_write(&uqueue->event_push);
+}
+
+/** @This pops several elements from the queue, updating the counter of
+ * elements with a single atomic operation and triggering the push watcher
+ * at most once.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param elements array filled in with pointers to popped elements
+ * @param nb size of the array
+ * @return number of popped elements; if it is lower than nb, the queue was
+ * found empty
+ */
+static inline unsigned int uqueue_pop_batch(struct uqueue *uqueue,
+                                            void **elements, unsigned int nb)
+{
+    unsigned int popped = 0, accounted = 0;
+    while (popped < nb) {
+        void *element = ufifo_pop(&uqueue->fifo, void *);
+        if (unlikely(element == NULL) && !popped &&
+            uqueue_wait_internal(uqueue))
+            element = ufifo_pop(&uqueue->fifo, void *);
+        if (unlikely(element == NULL)) {
+            /* account for the elements already popped, so that the producer
+             * sees the queue empty and triggers the pop watcher */
+            uqueue_pop_account(uqueue, popped - accounted);
+            accounted = popped;
+
+            /* signal that we starve */
+            ueventfd_read(&uqueue->event_pop);
+
+            /* double-check */
+            element = ufifo_pop(&uqueue->fifo, void *);
+            if (likely(element == NULL))
+                break;
+
+            /* signal that we're alright again */
+            ueventfd_write(&uqueue->event_pop);
+        }
+        elements[popped++] = element;
+    }
+
+    if (likely(popped))
+        UTRACE2(uqueue_pop, uqueue, popped);
+    uqueue_pop_account(uqueue, popped - accounted);
+    return popped;
+}
+
 /** @This returns the number of elements in the queue.
  *
  * @param uqueue pointer to a uqueue structure
@@ -203,6 +420,9 @@ static inline unsigned int uqueue_length(struct uqueue *uqueue)
 static inline void uqueue_clean(struct uqueue *uqueue)
 {
     uatomic_clean(&uqueue->counter);
+    uatomic_clean(&uqueue->wait_spin);
+    uatomic_clean(&uqueue->wait_yields);
+    uatomic_clean(&uqueue->low_mark);
     ufifo_clean(&uqueue->fifo);
     ueventfd_clean(&uqueue->event_push);
     ueventfd_clean(&uqueue->event_pop);
@@ -86,6 +86,8 @@ static inline const char *uref_date_type_str(int dt)
 #define UREF_FLAG_BLOCK_END 0x10
 /** the block contains a clock reference */
 #define UREF_FLAG_CLOCK_REF 0x20
+/** the picture is a key picture */
+#define UREF_FLAG_PIC_KEY 0x40
 
 /** position of the bitfield for the type of sys date */
 #define UREF_FLAG_DATE_SYS 0x0400000000000000
@@ -127,6 +129,10 @@ struct uref {
     uint64_t cr_dts_delay;
     /** duration between RAP and CR */
     uint64_t rap_cr_delay;
+    /** duration */
+    uint64_t duration;
+    /** picture number */
+    uint64_t pic_number;
     /** private for local pipe user */
     uint64_t priv;
 };
@@ -192,6 +198,8 @@ static inline void uref_init(struct uref *uref)
     uref->dts_pts_delay = UINT64_MAX;
     uref->cr_dts_delay = UINT64_MAX;
     uref->rap_cr_delay = UINT64_MAX;
+    uref->duration = UINT64_MAX;
+    uref->pic_number = UINT64_MAX;
     uref->priv = UINT64_MAX;
 }
 
@@ -283,6 +291,8 @@ static inline struct uref *uref_dup_inner(struct uref *uref)
     new_uref->dts_pts_delay = uref->dts_pts_delay;
     new_uref->cr_dts_delay = uref->cr_dts_delay;
     new_uref->rap_cr_delay = uref->rap_cr_delay;
+    new_uref->duration = uref->duration;
+    new_uref->pic_number = uref->pic_number;
     new_uref->priv = uref->priv;
 
     return new_uref;
@@ -309,6 +319,17 @@ static inline struct uref *uref_dup(struct uref *uref)
     return new_uref;
 }
 
+/** @This prepares a uref to be handed over to another thread, promoting the
+ * thread-local reference counts of its buffers to atomic ones.
+ *
+ * @param uref pointer to uref structure
+ */
+static inline void uref_share(struct uref *uref)
+{
+    if (uref->ubuf != NULL)
+        ubuf_share(uref->ubuf);
+}
+
 /** @This attaches a ubuf to a given uref. The ubuf pointer may no longer be
  * used by the module afterwards.
  *
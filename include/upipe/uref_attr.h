@@ -46,11 +46,18 @@ extern "C" {
  */
 static inline int uref_attr_import(struct uref *uref, struct uref *uref_attr)
 {
+    /* attributes stored in the uref structure */
+    uref->flags |= uref_attr->flags & UREF_FLAG_PIC_KEY;
+    if (uref_attr->duration != UINT64_MAX)
+        uref->duration = uref_attr->duration;
+    if (uref_attr->pic_number != UINT64_MAX)
+        uref->pic_number = uref_attr->pic_number;
+
     if (uref_attr->udict == NULL)
         return UBASE_ERR_NONE;
     if (uref->udict == NULL) {
         uref->udict = udict_dup(uref_attr->udict);
-        return uref->udict != NULL ? UBASE_ERR_NONE : UBASE_ERR_INVALID;
+        return uref->udict != NULL ? UBASE_ERR_NONE : UBASE_ERR_ALLOC;
     }
     return udict_import(uref->udict, uref_attr->udict);
 }
@@ -994,6 +1001,77 @@ static inline void uref_##group##_copy_##attr(struct uref *uref,            \
         uref_##group##_set_##attr(uref);                                    \
 }
 
+/* @This allows to define accessors for a void attribute directly in the uref
+ * structure, with the same prototypes as @ref UREF_ATTR_VOID_SH. This is
+ * used for per-packet attributes which used to be shorthands.
+ *
+ * @param group group of attributes
+ * @param attr readable name of the attribute, for the function names
+ * @param flag name of the flag in @ref uref_flag
+ * @param desc description of the attribute
+ */
+#define UREF_ATTR_VOID_UREF_SH(group, attr, flag, desc)                     \
+/** @This returns the presence of a desc attribute in a uref.               \
+ *                                                                          \
+ * @param uref pointer to the uref                                          \
+ * @return an error code                                                    \
+ */                                                                         \
+static inline int uref_##group##_get_##attr(struct uref *uref)              \
+{                                                                           \
+    return (uref->flags & flag) ? UBASE_ERR_NONE : UBASE_ERR_INVALID;       \
+}                                                                           \
+/** @This sets a desc attribute in a uref.                                  \
+ *                                                                          \
+ * @param uref pointer to the uref                                          \
+ * @return an error code                                                    \
+ */                                                                         \
+static inline int uref_##group##_set_##attr(struct uref *uref)              \
+{                                                                           \
+    uref->flags |= flag;                                                    \
+    return UBASE_ERR_NONE;                                                  \
+}                                                                           \
+/** @This deletes a desc attribute from a uref.                             \
+ *                                                                          \
+ * @param uref pointer to the uref                                          \
+ * @return an error code                                                    \
+ */                                                                         \
+static inline int uref_##group##_delete_##attr(struct uref *uref)           \
+{                                                                           \
+    UBASE_RETURN(uref_##group##_get_##attr(uref))                           \
+    uref->flags &= ~(uint64_t)flag;                                         \
+    return UBASE_ERR_NONE;                                                  \
+}                                                                           \
+/** @This copies the desc attribute from an uref to another.                \
+ *                                                                          \
+ * @param uref pointer to the uref                                          \
+ * @param uref_src pointer to the source uref                               \
+ * @return an error code                                                    \
+ */                                                                         \
+static inline int uref_##group##_copy_##attr(struct uref *uref,             \
+                                             struct uref *uref_src)         \
+{                                                                           \
+    uref->flags &= ~(uint64_t)flag;                                         \
+    uref->flags |= uref_src->flags & flag;                                  \
+    return UBASE_ERR_NONE;                                                  \
+}                                                                           \
+/** @This compares the desc attribute in two urefs.                         \
+ *                                                                          \
+ * @param uref1 pointer to the first uref                                   \
+ * @param uref2 pointer to the second uref                                  \
+ * @return 0 if both attributes are absent or identical                     \
+ */                                                                         \
+static inline int uref_##group##_cmp_##attr(struct uref *uref1,             \
+                                            struct uref *uref2)             \
+{                                                                           \
+    int err1 = uref_##group##_get_##attr(uref1);                            \
+    int err2 = uref_##group##_get_##attr(uref2);                            \
+    if (!ubase_check(err1) && !ubase_check(err2))                           \
+        return 0;                                                           \
+    if (!ubase_check(err1) || !ubase_check(err2))                           \
+        return -1;                                                          \
+    return 0;                                                               \
+}
+
 
 /*
  * Boolean attributes
@@ -1744,6 +1822,97 @@ static inline int uref_##group##_cmp_##attr(struct uref *uref1,             \
     return v1 - v2;                                                         \
 }
 
+/* @This allows to define accessors for an unsigned attribute directly in the
+ * uref structure, with the same prototypes as @ref UREF_ATTR_UNSIGNED_SH.
+ * This is used for per-packet attributes which used to be shorthands.
+ *
+ * @param group group of attributes
+ * @param attr readable name of the attribute, for the function names
+ * @param member name of the member in uref structure
+ * @param desc description of the attribute
+ */
+#define UREF_ATTR_UNSIGNED_UREF_SH(group, attr, member, desc)               \
+/** @This returns the desc attribute of a uref.                             \
+ *                                                                          \
+ * @param uref pointer to the uref                                          \
+ * @param p pointer to the retrieved value (modified during execution)      \
+ * @return an error code                                                    \
+ */                                                                         \
+static inline int uref_##group##_get_##attr(struct uref *uref, uint64_t *p) \
+{                                                                           \
+    if (uref->member == UINT64_MAX)                                         \
+        return UBASE_ERR_INVALID;                                           \
+    if (p != NULL)                                                          \
+        *p = uref->member;                                                  \
+    return UBASE_ERR_NONE;                                                  \
+}                                                                           \
+/** @This sets the desc attribute of a uref.                                \
+ *                                                                          \
+ * @param uref pointer to the uref                                          \
+ * @param v value to set                                                    \
+ * @return an error code                                                    \
+ */                                                                         \
+static inline int uref_##group##_set_##attr(struct uref *uref, uint64_t v)  \
+{                                                                           \
+    uref->member = v;                                                       \
+    return UBASE_ERR_NONE;                                                  \
+}                                                                           \
+/** @This deletes the desc attribute of a uref.                             \
+ *                                                                          \
+ * @param uref pointer to the uref                                          \
+ * @return an error code                                                    \
+ */                                                                         \
+static inline int uref_##group##_delete_##attr(struct uref *uref)           \
+{                                                                           \
+    UBASE_RETURN(uref_##group##_get_##attr(uref, NULL))                     \
+    uref->member = UINT64_MAX;                                              \
+    return UBASE_ERR_NONE;                                                  \
+}                                                                           \
+/** @This copies the desc attribute from an uref to another.                \
+ *                                                                          \
+ * @param uref pointer to the uref                                          \
+ * @param uref_src pointer to the source uref                               \
+ * @return an error code                                                    \
+ */                                                                         \
+static inline int uref_##group##_copy_##attr(struct uref *uref,             \
+                                             struct uref *uref_src)         \
+{                                                                           \
+    uref->member = uref_src->member;                                        \
+    return UBASE_ERR_NONE;                                                  \
+}                                                                           \
+/** @This compares the desc attribute to given values.                      \
+ *                                                                          \
+ * @param uref pointer to the uref                                          \
+ * @param min minimum value                                                 \
+ * @param max maximum value                                                 \
+ * @return an error code                                                    \
+ */                                                                         \
+static inline int uref_##group##_match_##attr(struct uref *uref,            \
+                                              uint64_t min, uint64_t max)   \
+{                                                                           \
+    uint64_t v;                                                             \
+    UBASE_RETURN(uref_##group##_get_##attr(uref, &v));                      \
+    return (v >= min) && (v <= max) ? UBASE_ERR_NONE : UBASE_ERR_INVALID;   \
+}                                                                           \
+/** @This compares the desc attribute in two urefs.                         \
+ *                                                                          \
+ * @param uref1 pointer to the first uref                                   \
+ * @param uref2 pointer to the second uref                                  \
+ * @return 0 if both attributes are absent or identical                     \
+ */                                                                         \
+static inline int uref_##group##_cmp_##attr(struct uref *uref1,             \
+                                            struct uref *uref2)             \
+{                                                                           \
+    uint64_t v1 = 0, v2 = 0;                                                \
+    int err1 = uref_##group##_get_##attr(uref1, &v1);                       \
+    int err2 = uref_##group##_get_##attr(uref2, &v2);                       \
+    if (!ubase_check(err1) && !ubase_check(err2))                           \
+        return 0;                                                           \
+    if (!ubase_check(err1) || !ubase_check(err2))                           \
+        return -1;                                                          \
+    return v1 - v2;                                                         \
+}
+
 
 
 /*
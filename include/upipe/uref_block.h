@@ -133,6 +133,15 @@ static inline int uref_block_append(struct uref *uref, struct ubuf *append)
     return ubuf_block_append(uref->ubuf, append);
 }
 
+/** @see ubuf_block_append_gather */
+static inline int uref_block_append_gather(struct uref *uref,
+                                           struct ubuf *append)
+{
+    if (uref->ubuf == NULL)
+        return UBASE_ERR_INVALID;
+    return ubuf_block_append_gather(uref->ubuf, append);
+}
+
 /** @see ubuf_block_delete */
 static inline int uref_block_delete(struct uref *uref, int offset, int size)
 {
@@ -286,6 +295,16 @@ static inline int uref_block_merge(struct uref *uref, struct ubuf_mgr *ubuf_mgr,
     return ubuf_block_merge(ubuf_mgr, &uref->ubuf, skip, new_size);
 }
 
+/** @see ubuf_block_compact */
+static inline int uref_block_compact(struct uref *uref,
+                                     struct ubuf_mgr *ubuf_mgr,
+                                     unsigned int threshold)
+{
+    if (uref->ubuf == NULL)
+        return UBASE_ERR_INVALID;
+    return ubuf_block_compact(ubuf_mgr, &uref->ubuf, threshold);
+}
+
 /** @see ubuf_block_compare */
 static inline int uref_block_compare(struct uref *uref, int offset,
                                      struct uref *uref_small)
@@ -321,6 +340,16 @@ static inline int uref_block_scan(struct uref *uref, size_t *offset_p,
     return ubuf_block_scan(uref->ubuf, offset_p, word);
 }
 
+/** @see ubuf_block_scan_stride */
+static inline int uref_block_scan_stride(struct uref *uref, size_t *offset_p,
+                                         uint8_t word, size_t stride,
+                                         unsigned int nb)
+{
+    if (uref->ubuf == NULL)
+        return UBASE_ERR_INVALID;
+    return ubuf_block_scan_stride(uref->ubuf, offset_p, word, stride, nb);
+}
+
 /** @see ubuf_block_find_va */
 static inline int uref_block_find_va(struct uref *uref, size_t *offset_p,
                                      unsigned int nb_octets, va_list args)
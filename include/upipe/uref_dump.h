@@ -62,6 +62,7 @@ static inline void uref_dump(struct uref *uref, struct uprobe *uprobe)
     UREF_DUMP_VOID("f.end", UREF_FLAG_FLOW_END)
     UREF_DUMP_VOID("f.disc", UREF_FLAG_FLOW_DISC)
     UREF_DUMP_VOID("b.start", UREF_FLAG_BLOCK_START)
+    UREF_DUMP_VOID("p.key", UREF_FLAG_PIC_KEY)
 #undef UREF_DUMP_VOID
 
 #define UREF_DUMP_DATE(name, member)                                        \
@@ -98,6 +99,8 @@ static inline void uref_dump(struct uref *uref, struct uprobe *uprobe)
     UREF_DUMP_UNSIGNED("k.dts_pts_delay", dts_pts_delay)
     UREF_DUMP_UNSIGNED("k.cr_dts_delay", cr_dts_delay)
     UREF_DUMP_UNSIGNED("k.rap_cr_delay", rap_cr_delay)
+    UREF_DUMP_UNSIGNED("k.duration", duration)
+    UREF_DUMP_UNSIGNED("p.num", pic_number)
 #undef UREF_DUMP_UNSIGNED
 
     if (uref->udict != NULL)
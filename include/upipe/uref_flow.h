@@ -86,6 +86,23 @@ static inline int uref_flow_set_def_va(struct uref *uref,
     UBASE_VARARG(uref_flow_set_def(uref, string), UBASE_ERR_INVALID)
 }
 
+/** @This checks if two flow definitions have the same attributes. Different
+ * flow definitions are usually ruled out without walking the attributes.
+ *
+ * @param flow_def1 first flow definition
+ * @param flow_def2 second flow definition
+ * @return true if both flow definitions have the same attributes
+ */
+static inline bool uref_flow_def_equal_fast(struct uref *flow_def1,
+                                            struct uref *flow_def2)
+{
+    return (flow_def1->flags & UREF_FLAG_PIC_KEY) ==
+               (flow_def2->flags & UREF_FLAG_PIC_KEY) &&
+           flow_def1->duration == flow_def2->duration &&
+           flow_def1->pic_number == flow_def2->pic_number &&
+           udict_equal_fast(flow_def1->udict, flow_def2->udict);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -40,6 +40,11 @@ UREF_ATTR_UNSIGNED(m3u_playlist_flow, media_sequence,
                    media sequence)
 UREF_ATTR_VOID(m3u_playlist_flow, endlist, "m3u.playlist.endlist",
                endlist)
+UREF_ATTR_UNSIGNED(m3u_playlist_flow, part_target,
+                   "m3u.playlist.part_target",
+                   partial segment target duration)
+UREF_ATTR_UNSIGNED(m3u_playlist_flow, update, "m3u.playlist.update",
+                   first sequence number of an incremental update)
 
 static inline int uref_m3u_playlist_flow_delete(struct uref *uref)
 {
@@ -48,6 +53,8 @@ static inline int uref_m3u_playlist_flow_delete(struct uref *uref)
         uref_m3u_playlist_flow_delete_target_duration,
         uref_m3u_playlist_flow_delete_media_sequence,
         uref_m3u_playlist_flow_delete_endlist,
+        uref_m3u_playlist_flow_delete_part_target,
+        uref_m3u_playlist_flow_delete_update,
     };
 
     return uref_attr_delete_list(uref, list, UBASE_ARRAY_SIZE(list));
@@ -61,6 +68,8 @@ static inline int uref_m3u_playlist_flow_copy(struct uref *uref,
         uref_m3u_playlist_flow_copy_target_duration,
         uref_m3u_playlist_flow_copy_media_sequence,
         uref_m3u_playlist_flow_copy_endlist,
+        uref_m3u_playlist_flow_copy_part_target,
+        uref_m3u_playlist_flow_copy_update,
     };
 
     return uref_attr_copy_list(uref, uref_src, list, UBASE_ARRAY_SIZE(list));
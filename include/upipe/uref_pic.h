@@ -41,8 +41,8 @@ extern "C" {
 
 #include <stdint.h>
 
-UREF_ATTR_UNSIGNED_SH(pic, number, UDICT_TYPE_PIC_NUM, picture number)
-UREF_ATTR_VOID_SH(pic, key, UDICT_TYPE_PIC_KEY, key picture)
+UREF_ATTR_UNSIGNED_UREF_SH(pic, number, pic_number, picture number)
+UREF_ATTR_VOID_UREF_SH(pic, key, UREF_FLAG_PIC_KEY, key picture)
 UREF_ATTR_UNSIGNED_SH(pic, hposition, UDICT_TYPE_PIC_HPOSITION,
         horizontal position)
 UREF_ATTR_UNSIGNED_SH(pic, vposition, UDICT_TYPE_PIC_VPOSITION,
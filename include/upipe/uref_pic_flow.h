@@ -227,6 +227,61 @@ static inline int uref_pic_flow_copy_format(struct uref *uref_dst,
     return UBASE_ERR_NONE;
 }
 
+/** @This amends a flow format so that lines are aligned on the given
+ * alignment, in addition to any alignment it already requires (the least
+ * common multiple is kept). It is typically called by pipes amending a ubuf
+ * manager or flow format request on behalf of their SIMD routines.
+ *
+ * @param uref uref control packet
+ * @param align alignment in octets required by the caller
+ * @return an error code
+ */
+static inline int uref_pic_flow_require_align(struct uref *uref,
+                                              uint64_t align)
+{
+    if (!align)
+        return UBASE_ERR_NONE;
+    uint64_t current;
+    if (!ubase_check(uref_pic_flow_get_align(uref, &current)) || !current)
+        return uref_pic_flow_set_align(uref, align);
+    if (!(current % align))
+        return UBASE_ERR_NONE;
+    return uref_pic_flow_set_align(uref,
+                                   current * align / ubase_gcd(current, align));
+}
+
+/** @This amends a flow format so that buffers have at least the given
+ * padding around the picture, for instance for motion search or edge
+ * emulation. Padding already required by the flow format is kept if it is
+ * larger.
+ *
+ * @param uref uref control packet
+ * @param hmprepend extra macropixels required before each line
+ * @param hmappend extra macropixels required after each line
+ * @param vprepend extra lines required before the picture
+ * @param vappend extra lines required after the picture
+ * @return an error code
+ */
+static inline int uref_pic_flow_require_padding(struct uref *uref,
+        uint8_t hmprepend, uint8_t hmappend,
+        uint8_t vprepend, uint8_t vappend)
+{
+    uint8_t current;
+    if (!ubase_check(uref_pic_flow_get_hmprepend(uref, &current)) ||
+        current < hmprepend)
+        UBASE_RETURN(uref_pic_flow_set_hmprepend(uref, hmprepend))
+    if (!ubase_check(uref_pic_flow_get_hmappend(uref, &current)) ||
+        current < hmappend)
+        UBASE_RETURN(uref_pic_flow_set_hmappend(uref, hmappend))
+    if (!ubase_check(uref_pic_flow_get_vprepend(uref, &current)) ||
+        current < vprepend)
+        UBASE_RETURN(uref_pic_flow_set_vprepend(uref, vprepend))
+    if (!ubase_check(uref_pic_flow_get_vappend(uref, &current)) ||
+        current < vappend)
+        UBASE_RETURN(uref_pic_flow_set_vappend(uref, vappend))
+    return UBASE_ERR_NONE;
+}
+
 /** @This iterates on chroma plane, and returns the highest horizontal and
  * vertical subsampling.
  *
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe ring of urefs indexed by 16-bit sequence numbers
+ *
+ * The ring keeps the urefs of a window of consecutive sequence numbers
+ * (typically RTP), so that insertion at any position, lookup and removal of
+ * the oldest uref are done in constant time. Holes are allowed in the window.
+ */
+
+#ifndef _UPIPE_UREF_RING_H_
+/** @hidden */
+#define _UPIPE_UREF_RING_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+#include <upipe/uref.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+/** maximum number of slots in a ring, so that sequence number comparisons
+ * are not ambiguous */
+#define UREF_RING_MAX_SIZE 32768
+
+/** @This is the implementation of a ring of urefs. */
+struct uref_ring {
+    /** slots, indexed by sequence number */
+    struct uref **urefs;
+    /** number of slots minus 1 */
+    uint16_t mask;
+    /** sequence number of the oldest slot of the window */
+    uint16_t first;
+    /** sequence number of the newest uref */
+    uint16_t last;
+    /** number of urefs in the ring */
+    unsigned int count;
+};
+
+/** @This initializes a ring.
+ *
+ * @param ring pointer to ring
+ * @param size number of slots, must be a power of 2 up to
+ * @ref UREF_RING_MAX_SIZE
+ * @return an error code
+ */
+static inline int uref_ring_init(struct uref_ring *ring, unsigned int size)
+{
+    if (unlikely(!size || size > UREF_RING_MAX_SIZE || (size & (size - 1))))
+        return UBASE_ERR_INVALID;
+    ring->urefs = (struct uref **)calloc(size, sizeof(struct uref *));
+    UBASE_ALLOC_RETURN(ring->urefs)
+    ring->mask = size - 1;
+    ring->first = ring->last = 0;
+    ring->count = 0;
+    return UBASE_ERR_NONE;
+}
+
+/** @This returns the number of urefs in a ring.
+ *
+ * @param ring pointer to ring
+ * @return number of urefs
+ */
+static inline unsigned int uref_ring_count(const struct uref_ring *ring)
+{
+    return ring->count;
+}
+
+/** @This checks if a sequence number is older than the newest uref of the
+ * ring, which means that it is inserted out of order.
+ *
+ * @param ring pointer to ring
+ * @param seqnum sequence number
+ * @return true if the sequence number is older
+ */
+static inline bool uref_ring_is_late(const struct uref_ring *ring,
+                                     uint16_t seqnum)
+{
+    return ring->count && (int16_t)(seqnum - ring->last) < 0;
+}
+
+/** @This checks if a uref with the given sequence number may be inserted
+ * without exceeding the size of the ring.
+ *
+ * @param ring pointer to ring
+ * @param seqnum sequence number
+ * @return true if the uref fits
+ */
+static inline bool uref_ring_fits(const struct uref_ring *ring,
+                                  uint16_t seqnum)
+{
+    if (!ring->count)
+        return true;
+    if ((int16_t)(seqnum - ring->first) < 0)
+        return (uint16_t)(ring->last - seqnum) <= ring->mask;
+    return (uint16_t)(seqnum - ring->first) <= ring->mask;
+}
+
+/** @This returns the uref with the given sequence number.
+ *
+ * @param ring pointer to ring
+ * @param seqnum sequence number
+ * @return pointer to uref, or NULL if it is not in the ring
+ */
+static inline struct uref *uref_ring_get(const struct uref_ring *ring,
+                                         uint16_t seqnum)
+{
+    if (!ring->count ||
+        (uint16_t)(seqnum - ring->first) > (uint16_t)(ring->last - ring->first))
+        return NULL;
+    return ring->urefs[seqnum & ring->mask];
+}
+
+/** @This inserts a uref in a ring.
+ *
+ * @param ring pointer to ring
+ * @param seqnum sequence number of the uref
+ * @param uref pointer to uref
+ * @return an error code, UBASE_ERR_BUSY if a uref with the same sequence
+ * number is already in the ring, and UBASE_ERR_INVALID if it doesn't fit,
+ * in which cases the uref is not inserted
+ */
+static inline int uref_ring_insert(struct uref_ring *ring, uint16_t seqnum,
+                                   struct uref *uref)
+{
+    if (!ring->count) {
+        ring->first = ring->last = seqnum;
+    } else {
+        if (!uref_ring_fits(ring, seqnum))
+            return UBASE_ERR_INVALID;
+        if (uref_ring_get(ring, seqnum) != NULL)
+            return UBASE_ERR_BUSY;
+        if ((int16_t)(seqnum - ring->first) < 0)
+            ring->first = seqnum;
+        else if ((int16_t)(seqnum - ring->last) > 0)
+            ring->last = seqnum;
+    }
+    ring->urefs[seqnum & ring->mask] = uref;
+    ring->count++;
+    return UBASE_ERR_NONE;
+}
+
+/** @This returns the oldest uref of a ring.
+ *
+ * @param ring pointer to ring
+ * @param seqnum_p filled in with the sequence number of the uref (may be
+ * NULL)
+ * @return pointer to uref, or NULL if the ring is empty
+ */
+static inline struct uref *uref_ring_peek(struct uref_ring *ring,
+                                          uint16_t *seqnum_p)
+{
+    if (!ring->count)
+        return NULL;
+    /* skip the holes, later insertions may move the window back */
+    while (ring->urefs[ring->first & ring->mask] == NULL)
+        ring->first++;
+    if (seqnum_p != NULL)
+        *seqnum_p = ring->first;
+    return ring->urefs[ring->first & ring->mask];
+}
+
+/** @This removes the oldest uref of a ring.
+ *
+ * @param ring pointer to ring
+ * @param seqnum_p filled in with the sequence number of the uref (may be
+ * NULL)
+ * @return pointer to uref, or NULL if the ring is empty
+ */
+static inline struct uref *uref_ring_pop(struct uref_ring *ring,
+                                         uint16_t *seqnum_p)
+{
+    struct uref *uref = uref_ring_peek(ring, seqnum_p);
+    if (uref == NULL)
+        return NULL;
+    ring->urefs[ring->first & ring->mask] = NULL;
+    if (--ring->count)
+        ring->first++;
+    return uref;
+}
+
+/** @This frees all urefs of a ring.
+ *
+ * @param ring pointer to ring
+ */
+static inline void uref_ring_flush(struct uref_ring *ring)
+{
+    struct uref *uref;
+    while ((uref = uref_ring_pop(ring, NULL)) != NULL)
+        uref_free(uref);
+}
+
+/** @This frees all urefs of a ring and releases its slots.
+ *
+ * @param ring pointer to ring
+ */
+static inline void uref_ring_clean(struct uref_ring *ring)
+{
+    if (ring->urefs == NULL)
+        return;
+    uref_ring_flush(ring);
+    free(ring->urefs);
+    ring->urefs = NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe compact binary serialization of urefs
+ *
+ * A serialized uref consists of its flags, the clock fields that are set,
+ * and its attributes, all encoded with variable-length integers. The
+ * attributes may be encoded relatively to a reference uref, typically the
+ * previous uref of the same flow: only the attributes that differ are then
+ * written, along with the deletion of the attributes missing from the
+ * uref. The buffer is not part of the serialization, and is expected to be
+ * carried by reference next to it, for instance in the payload of a frame.
+ */
+
+#ifndef _UPIPE_UREF_SERIAL_H_
+/** @hidden */
+#define _UPIPE_UREF_SERIAL_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+#include <upipe/uref.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** size of the header of a frame */
+#define UREF_SERIAL_FRAME_SIZE 9
+
+/** @This is the type of a frame. */
+enum uref_serial_frame {
+    /** flow definition, serialized without reference and without payload */
+    UREF_SERIAL_FRAME_FLOW_DEF = 'F',
+    /** uref, serialized relatively to the previous uref of the flow, and
+     * followed by its block buffer */
+    UREF_SERIAL_FRAME_UREF = 'U'
+};
+
+/** @This serializes a uref, except its buffer.
+ *
+ * @param uref uref to serialize
+ * @param ref reference uref, or NULL to write all attributes
+ * @param buffer buffer to write to, or NULL to only compute the size
+ * @param size_p size of the buffer, filled in with the size of the
+ * serialized uref
+ * @return an error code, UBASE_ERR_NOSPC if the buffer is too small
+ */
+int uref_serial_encode(struct uref *uref, struct uref *ref,
+                       uint8_t *buffer, size_t *size_p);
+
+/** @This deserializes a uref, except its buffer. The attributes of the uref
+ * are replaced.
+ *
+ * @param uref uref to fill in
+ * @param ref reference uref that was passed to @ref uref_serial_encode, or
+ * NULL
+ * @param buffer serialized uref
+ * @param size size of the serialized uref
+ * @return an error code
+ */
+int uref_serial_decode(struct uref *uref, struct uref *ref,
+                       const uint8_t *buffer, size_t size);
+
+/** @This writes the header of a frame.
+ *
+ * @param buffer buffer of at least @ref UREF_SERIAL_FRAME_SIZE octets
+ * @param frame type of frame
+ * @param header_size size of the serialized uref
+ * @param payload_size size of the payload following the serialized uref
+ */
+static inline void uref_serial_write_frame(uint8_t *buffer,
+                                           enum uref_serial_frame frame,
+                                           uint32_t header_size,
+                                           uint32_t payload_size)
+{
+    buffer[0] = frame;
+    buffer[1] = header_size >> 24;
+    buffer[2] = header_size >> 16;
+    buffer[3] = header_size >> 8;
+    buffer[4] = header_size;
+    buffer[5] = payload_size >> 24;
+    buffer[6] = payload_size >> 16;
+    buffer[7] = payload_size >> 8;
+    buffer[8] = payload_size;
+}
+
+/** @This reads the header of a frame.
+ *
+ * @param buffer buffer of at least @ref UREF_SERIAL_FRAME_SIZE octets
+ * @param frame_p filled in with the type of frame
+ * @param header_size_p filled in with the size of the serialized uref
+ * @param payload_size_p filled in with the size of the payload
+ * @return an error code
+ */
+static inline int uref_serial_read_frame(const uint8_t *buffer,
+                                         enum uref_serial_frame *frame_p,
+                                         uint32_t *header_size_p,
+                                         uint32_t *payload_size_p)
+{
+    if (unlikely(buffer[0] != UREF_SERIAL_FRAME_FLOW_DEF &&
+                 buffer[0] != UREF_SERIAL_FRAME_UREF))
+        return UBASE_ERR_INVALID;
+    *frame_p = buffer[0];
+    *header_size_p = ((uint32_t)buffer[1] << 24) | (buffer[2] << 16) |
+                     (buffer[3] << 8) | buffer[4];
+    *payload_size_p = ((uint32_t)buffer[5] << 24) | (buffer[6] << 16) |
+                      (buffer[7] << 8) | buffer[8];
+    return UBASE_ERR_NONE;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe latency tracing attributes for uref
+ *
+ * A pipe configured with @ref upipe_stats_set_trace stamps an ingress date
+ * on sampled urefs; the instrumented pipes further down the chain measure
+ * the latency since that date. The attribute follows the uref through
+ * @ref uref_dup, and pipes building a uref out of several others merge it
+ * with @ref uref_trace_merge.
+ */
+
+#ifndef _UPIPE_UREF_TRACE_H_
+/** @hidden */
+#define _UPIPE_UREF_TRACE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/uref.h>
+#include <upipe/uref_attr.h>
+
+#include <stdint.h>
+
+UREF_ATTR_UNSIGNED(trace, ingress, "t.ingress",
+        ingress date of a sampled uref in uclock units)
+
+/** @This merges the ingress date of a uref into the uref built from it,
+ * which keeps the earliest date.
+ *
+ * @param uref uref built from the other one
+ * @param from uref whose content was merged into uref
+ */
+static inline void uref_trace_merge(struct uref *uref, struct uref *from)
+{
+    uint64_t ingress, current;
+    if (likely(!ubase_check(uref_trace_get_ingress(from, &ingress))))
+        return;
+    if (!ubase_check(uref_trace_get_ingress(uref, &current)) ||
+        ingress < current)
+        uref_trace_set_ingress(uref, ingress);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
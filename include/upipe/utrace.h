@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe static tracepoints
+ *
+ * When <sys/sdt.h> is found at configure time, the hot paths of the core
+ * library contain USDT probes of the "upipe" provider. An inactive probe
+ * is a single nop instruction; perf, bpftrace or systemtap may attach to it
+ * on a running process. Otherwise the probes compile to nothing. Scripts
+ * using them are in tools/bpftrace.
+ *
+ * The probes and their arguments are:
+ * @list
+ * @item input_enter (upipe, input, uref) and input_exit (upipe, input),
+ * around @ref upipe_input, input being the input function of the manager,
+ * whose symbol name identifies the kind of pipe
+ * @item upump_enter (upump, cb) and upump_exit (upump), around the
+ * dispatch of a pump callback
+ * @item upool_alloc (upool, obj, fallback) and upool_free (upool, obj)
+ * @item umem_alloc (umem_mgr, buffer, size, fallback) and umem_free
+ * (umem_mgr, buffer), in @ref umem_pool_mgr_alloc
+ * @item uqueue_push (uqueue, nb) and uqueue_pop (uqueue, nb), nb being
+ * the number of elements actually queued or dequeued; a push of 0 element
+ * means the queue was full
+ * @item throw (uprobe, upipe, event), for each event thrown by a pipe or
+ * to a probe hierarchy
+ * @end list
+ */
+
+#ifndef _UPIPE_UTRACE_H_
+/** @hidden */
+#define _UPIPE_UTRACE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/config.h>
+
+#ifdef UPIPE_HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+
+/** @This fires a tracepoint without arguments. */
+#define UTRACE0(name) DTRACE_PROBE(upipe, name)
+/** @This fires a tracepoint with one argument. */
+#define UTRACE1(name, a) DTRACE_PROBE1(upipe, name, a)
+/** @This fires a tracepoint with two arguments. */
+#define UTRACE2(name, a, b) DTRACE_PROBE2(upipe, name, a, b)
+/** @This fires a tracepoint with three arguments. */
+#define UTRACE3(name, a, b, c) DTRACE_PROBE3(upipe, name, a, b, c)
+/** @This fires a tracepoint with four arguments. */
+#define UTRACE4(name, a, b, c, d) DTRACE_PROBE4(upipe, name, a, b, c, d)
+
+#else
+
+#define UTRACE0(name) do { } while (0)
+#define UTRACE1(name, a) do { } while (0)
+#define UTRACE2(name, a, b) do { } while (0)
+#define UTRACE3(name, a, b, c) do { } while (0)
+#define UTRACE4(name, a, b, c, d) do { } while (0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif
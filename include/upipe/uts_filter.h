@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe in-place filtering of TS packets by PID
+ *
+ * Sources receiving TS packets in datagrams or records may be given a
+ * bitmap of wanted PIDs, with bit (pid & 7) of octet (pid >> 3) set for each
+ * wanted PID, such as the one exported by ts_split. The unwanted packets,
+ * including null packets unless PID 8191 is set, are then removed from the
+ * received buffer before any uref is allocated for it.
+ */
+
+#ifndef _UPIPE_UTS_FILTER_H_
+/** @hidden */
+#define _UPIPE_UTS_FILTER_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/** size of a TS packet */
+#define UTS_FILTER_PACKET_SIZE 188
+/** sync byte of a TS packet */
+#define UTS_FILTER_SYNC 0x47
+/** number of possible PIDs */
+#define UTS_FILTER_PIDS 8192
+/** size of a bitmap of PIDs, in octets */
+#define UTS_FILTER_SIZE (UTS_FILTER_PIDS / 8)
+
+/** @This marks a PID as wanted in a bitmap.
+ *
+ * @param filter bitmap of UTS_FILTER_SIZE octets
+ * @param pid PID
+ */
+static inline void uts_filter_set_pid(uint8_t *filter, uint16_t pid)
+{
+    filter[(pid >> 3) & (UTS_FILTER_SIZE - 1)] |= 1 << (pid & 7);
+}
+
+/** @This marks a PID as unwanted in a bitmap.
+ *
+ * @param filter bitmap of UTS_FILTER_SIZE octets
+ * @param pid PID
+ */
+static inline void uts_filter_clear_pid(uint8_t *filter, uint16_t pid)
+{
+    filter[(pid >> 3) & (UTS_FILTER_SIZE - 1)] &= ~(1 << (pid & 7));
+}
+
+/** @This checks whether a PID is wanted in a bitmap.
+ *
+ * @param filter bitmap of UTS_FILTER_SIZE octets
+ * @param pid PID
+ * @return true if the PID is wanted
+ */
+static inline bool uts_filter_check_pid(const uint8_t *filter, uint16_t pid)
+{
+    return filter[(pid >> 3) & (UTS_FILTER_SIZE - 1)] & (1 << (pid & 7));
+}
+
+/** @This removes in place the TS packets of unwanted PIDs from a buffer,
+ * moving the wanted packets down so that they remain contiguous. Buffers
+ * which are not made of whole TS packets are left untouched, and so are
+ * packets without a sync byte.
+ *
+ * @param filter bitmap of UTS_FILTER_SIZE octets, or NULL to keep everything
+ * @param buffer buffer of TS packets
+ * @param size size of the buffer
+ * @return size of the buffer after filtering, which may be 0
+ */
+static inline size_t uts_filter_compact(const uint8_t *filter,
+                                        uint8_t *buffer, size_t size)
+{
+    if (likely(filter == NULL) || size % UTS_FILTER_PACKET_SIZE)
+        return size;
+
+    size_t kept = 0;
+    for (size_t offset = 0; offset < size;
+         offset += UTS_FILTER_PACKET_SIZE) {
+        const uint8_t *ts = buffer + offset;
+        uint16_t pid = ((ts[1] & 0x1f) << 8) | ts[2];
+        if (ts[0] == UTS_FILTER_SYNC && !uts_filter_check_pid(filter, pid))
+            continue;
+        if (kept != offset)
+            memmove(buffer + kept, ts, UTS_FILTER_PACKET_SIZE);
+        kept += UTS_FILTER_PACKET_SIZE;
+    }
+    return kept;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe in-place access to the PCR of TS packets
+ *
+ * Sinks may correct the PCR of the TS packets they output when a datagram
+ * leaves later or earlier than the date it was muxed for, without parsing
+ * the rest of the stream. An incremental interpolator also dates the packets
+ * between two PCRs without divisions.
+ */
+
+#ifndef _UPIPE_UTS_PCR_H_
+/** @hidden */
+#define _UPIPE_UTS_PCR_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** size of a TS packet */
+#define UTS_PCR_PACKET_SIZE 188
+/** sync byte of a TS packet */
+#define UTS_PCR_SYNC 0x47
+/** size of the TS header up to the end of the PCR */
+#define UTS_PCR_HEADER_SIZE 12
+/** PCR wrap-around, in 27 MHz units */
+#define UTS_PCR_WRAP (UINT64_C(8589934592) * 300)
+
+/** @This returns the PCR of a TS packet.
+ *
+ * @param ts pointer to the first UTS_PCR_HEADER_SIZE octets of the packet
+ * @param pcr_p filled in with the PCR, in 27 MHz units
+ * @return false if the packet carries no PCR
+ */
+static inline bool uts_pcr_get(const uint8_t *ts, uint64_t *pcr_p)
+{
+    if (ts[0] != UTS_PCR_SYNC || !(ts[3] & 0x20) || ts[4] < 7 ||
+        !(ts[5] & 0x10))
+        return false;
+
+    uint64_t base = ((uint64_t)ts[6] << 25) | ((uint64_t)ts[7] << 17) |
+                    ((uint64_t)ts[8] << 9) | ((uint64_t)ts[9] << 1) |
+                    (ts[10] >> 7);
+    uint64_t ext = ((ts[10] & 0x1) << 8) | ts[11];
+    *pcr_p = base * 300 + ext;
+    return true;
+}
+
+/** @This sets the PCR of a TS packet which already carries one.
+ *
+ * @param ts pointer to the first UTS_PCR_HEADER_SIZE octets of the packet
+ * @param pcr PCR, in 27 MHz units
+ */
+static inline void uts_pcr_set(uint8_t *ts, uint64_t pcr)
+{
+    uint64_t base = (pcr / 300) % (UTS_PCR_WRAP / 300);
+    uint64_t ext = pcr % 300;
+    ts[6] = base >> 25;
+    ts[7] = base >> 17;
+    ts[8] = base >> 9;
+    ts[9] = base >> 1;
+    ts[10] = ((base & 0x1) << 7) | 0x7e | (ext >> 8);
+    ts[11] = ext;
+}
+
+/** @This adds a possibly negative delay to a PCR, with wrap-around.
+ *
+ * @param pcr PCR, in 27 MHz units
+ * @param delta delay to add, in 27 MHz units
+ * @return the new PCR
+ */
+static inline uint64_t uts_pcr_add(uint64_t pcr, int64_t delta)
+{
+    int64_t wrapped = delta % (int64_t)UTS_PCR_WRAP;
+    return (pcr + UTS_PCR_WRAP + wrapped) % UTS_PCR_WRAP;
+}
+
+/** @This adds a delay to the PCR of all TS packets of a buffer. Buffers
+ * which are not made of whole TS packets are left untouched.
+ *
+ * @param buffer buffer of TS packets
+ * @param size size of the buffer
+ * @param delta delay to add, in 27 MHz units
+ * @return the number of modified PCRs
+ */
+static inline unsigned int uts_pcr_restamp(uint8_t *buffer, size_t size,
+                                           int64_t delta)
+{
+    unsigned int nb = 0;
+    if (size % UTS_PCR_PACKET_SIZE)
+        return 0;
+
+    for (size_t offset = 0; offset < size; offset += UTS_PCR_PACKET_SIZE) {
+        uint64_t pcr;
+        if (uts_pcr_get(buffer + offset, &pcr)) {
+            uts_pcr_set(buffer + offset, uts_pcr_add(pcr, delta));
+            nb++;
+        }
+    }
+    return nb;
+}
+
+/** fractional bits of the rate of a PCR interpolator */
+#define UTS_PCR_INTERP_SHIFT 32
+/** max interval between two PCRs to measure the rate, in 27 MHz units */
+#define UTS_PCR_INTERP_MAX_DELTA UINT64_C(27000000)
+
+/** @This is the state of an incremental PCR interpolator. Packets are located
+ * by their cumulative octet offset in the stream, and the rate is kept in
+ * fixed point so that interpolating only takes a multiplication and a shift.
+ */
+struct uts_pcr_interp {
+    /** last PCR, in 27 MHz units, or UINT64_MAX */
+    uint64_t pcr;
+    /** offset of the packet carrying the last PCR, in octets */
+    uint64_t offset;
+    /** 27 MHz ticks per octet, in 1/2^UTS_PCR_INTERP_SHIFT, or 0 */
+    uint64_t rate;
+};
+
+/** @This initializes a PCR interpolator.
+ *
+ * @param interp pointer to the interpolator
+ */
+static inline void uts_pcr_interp_init(struct uts_pcr_interp *interp)
+{
+    interp->pcr = UINT64_MAX;
+    interp->offset = 0;
+    interp->rate = 0;
+}
+
+/** @This forgets the last PCR after a discontinuity. The rate is kept, so
+ * that packets may be dated again as soon as the next PCR is received.
+ *
+ * @param interp pointer to the interpolator
+ */
+static inline void uts_pcr_interp_discontinuity(struct uts_pcr_interp *interp)
+{
+    interp->pcr = UINT64_MAX;
+}
+
+/** @This feeds a new PCR to the interpolator, and updates the rate from the
+ * interval with the previous PCR. The PCR may be a raw value, wrapping
+ * around at UTS_PCR_WRAP, or a value on a 64-bit clock.
+ *
+ * @param interp pointer to the interpolator
+ * @param offset offset of the packet carrying the PCR, in octets
+ * @param pcr PCR, in 27 MHz units
+ * @return false if the interval was not usable and the rate was kept
+ */
+static inline bool uts_pcr_interp_update(struct uts_pcr_interp *interp,
+                                         uint64_t offset, uint64_t pcr)
+{
+    bool updated = false;
+    if (interp->pcr != UINT64_MAX && offset > interp->offset) {
+        /* PCRs going backwards look huge */
+        uint64_t delta = (UTS_PCR_WRAP + pcr - interp->pcr) % UTS_PCR_WRAP;
+        if (delta && delta <= UTS_PCR_INTERP_MAX_DELTA) {
+            interp->rate = (delta << UTS_PCR_INTERP_SHIFT) /
+                           (offset - interp->offset);
+            updated = true;
+        }
+    }
+    interp->pcr = pcr;
+    interp->offset = offset;
+    return updated;
+}
+
+/** @This interpolates the PCR of a packet following the last PCR. The
+ * result is not wrapped around, and stays exact as long as the packet is
+ * less than 2^32 ticks (about 159 seconds) away from the last PCR.
+ *
+ * @param interp pointer to the interpolator
+ * @param offset offset of the packet, in octets
+ * @param pcr_p filled in with the PCR, in 27 MHz units
+ * @return false if the interpolator has no PCR or no rate yet
+ */
+static inline bool uts_pcr_interp_get(const struct uts_pcr_interp *interp,
+                                      uint64_t offset, uint64_t *pcr_p)
+{
+    if (interp->pcr == UINT64_MAX || !interp->rate ||
+        offset < interp->offset)
+        return false;
+
+    *pcr_p = interp->pcr +
+        (((offset - interp->offset) * interp->rate +
+          (UINT64_C(1) << (UTS_PCR_INTERP_SHIFT - 1))) >>
+         UTS_PCR_INTERP_SHIFT);
+    return true;
+}
+
+/** @This interpolates the PCRs of consecutive TS packets, typically the
+ * packets of a burst, in a single loop without divisions.
+ *
+ * @param interp pointer to the interpolator
+ * @param offset offset of the first packet, in octets
+ * @param nb number of packets
+ * @param pcrs filled in with the nb PCRs, in 27 MHz units
+ * @return false if the interpolator has no PCR or no rate yet
+ */
+static inline bool uts_pcr_interp_burst(const struct uts_pcr_interp *interp,
+                                        uint64_t offset, unsigned int nb,
+                                        uint64_t *pcrs)
+{
+    if (interp->pcr == UINT64_MAX || !interp->rate ||
+        offset < interp->offset)
+        return false;
+
+    uint64_t base = interp->pcr;
+    uint64_t start = (offset - interp->offset) * interp->rate +
+                     (UINT64_C(1) << (UTS_PCR_INTERP_SHIFT - 1));
+    uint64_t step = UTS_PCR_PACKET_SIZE * interp->rate;
+    for (unsigned int i = 0; i < nb; i++)
+        pcrs[i] = base + ((start + i * step) >> UTS_PCR_INTERP_SHIFT);
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
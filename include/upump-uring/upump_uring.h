@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short declarations for a Upipe main loop using Linux io_uring
+ *
+ * Besides the usual pump types, this event loop provides asynchronous I/O
+ * pumps: a read or a write is submitted on a file descriptor, and the
+ * callback is called when it completes. The inline functions below may be
+ * used by modules without linking with this library; they fail gracefully
+ * when the pump manager is not an io_uring one.
+ */
+
+#ifndef _UPUMP_URING_UPUMP_URING_H_
+/** @hidden */
+#define _UPUMP_URING_UPUMP_URING_H_
+
+#include <upipe/upump.h>
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UPUMP_URING_SIGNATURE UBASE_FOURCC('u','r','n','g')
+
+/** @This extends upump_type with specific types for io_uring. */
+enum upump_uring_type {
+    UPUMP_URING_TYPE_SENTINEL = UPUMP_TYPE_LOCAL,
+
+    /** asynchronous I/O on a file descriptor (int) */
+    UPUMP_URING_TYPE_FD_IO
+};
+
+/** @This extends upump_command with specific commands for io_uring. */
+enum upump_uring_command {
+    UPUMP_URING_SENTINEL = UPUMP_CONTROL_LOCAL,
+
+    /** submits a read (void *, size_t, uint64_t, int) */
+    UPUMP_URING_SUBMIT_READ,
+    /** submits a write (const void *, size_t, uint64_t, int) */
+    UPUMP_URING_SUBMIT_WRITE,
+    /** returns the result of the last completed I/O (ssize_t *) */
+    UPUMP_URING_GET_RESULT
+};
+
+/** @This extends upump_mgr_command with specific commands for io_uring. */
+enum upump_uring_mgr_command {
+    UPUMP_URING_MGR_SENTINEL = UPUMP_MGR_CONTROL_LOCAL,
+
+    /** registers fixed buffers (const struct iovec *, unsigned int) */
+    UPUMP_URING_MGR_REGISTER_BUFFERS,
+    /** unregisters fixed buffers (void) */
+    UPUMP_URING_MGR_UNREGISTER_BUFFERS
+};
+
+/** @This allocates and initializes a upump_mgr structure bound to a new
+ * io_uring instance.
+ *
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @return pointer to the wrapped upump_mgr structure, or NULL if io_uring is
+ * not supported by the kernel
+ */
+struct upump_mgr *upump_uring_mgr_alloc(uint16_t upump_pool_depth,
+                                        uint16_t upump_blocker_pool_depth);
+
+/** @This allocates a pump for asynchronous I/O on a file descriptor. The
+ * callback is called each time a submitted I/O completes. Stopping the pump
+ * doesn't cancel the I/O in flight, whereas @ref upump_free cancels it and
+ * waits for its completion, so that the buffer may be released afterwards.
+ *
+ * @param mgr management structure for this event loop
+ * @param cb function to call when an I/O completes
+ * @param opaque pointer to the module's internal structure
+ * @param refcount pointer to urefcount structure to increment during callback,
+ * or NULL
+ * @param fd file descriptor
+ * @return pointer to allocated pump, or NULL if the manager doesn't support
+ * asynchronous I/O
+ */
+static inline struct upump *upump_uring_alloc_fd_io(struct upump_mgr *mgr,
+        upump_cb cb, void *opaque, struct urefcount *refcount, int fd)
+{
+    if (mgr == NULL || mgr->signature != UPUMP_URING_SIGNATURE)
+        return NULL;
+    return upump_alloc(mgr, cb, opaque, refcount, UPUMP_URING_TYPE_FD_IO, fd);
+}
+
+/** @This submits an asynchronous read. Only one I/O may be in flight per
+ * pump. The buffer must remain valid until completion.
+ *
+ * @param upump description structure of the pump
+ * @param buffer buffer to read into
+ * @param size size of the buffer
+ * @param offset offset in the file, or UINT64_MAX for the current position
+ * @param buf_index index of the registered buffer containing buffer, or -1
+ * @return an error code
+ */
+static inline int upump_uring_submit_read(struct upump *upump, void *buffer,
+                                          size_t size, uint64_t offset,
+                                          int buf_index)
+{
+    return upump_control(upump, UPUMP_URING_SUBMIT_READ,
+                         UPUMP_URING_SIGNATURE, buffer, size, offset,
+                         buf_index);
+}
+
+/** @This submits an asynchronous write. Only one I/O may be in flight per
+ * pump. The buffer must remain valid until completion.
+ *
+ * @param upump description structure of the pump
+ * @param buffer buffer to write
+ * @param size size of the buffer
+ * @param offset offset in the file, or UINT64_MAX for the current position
+ * @param buf_index index of the registered buffer containing buffer, or -1
+ * @return an error code
+ */
+static inline int upump_uring_submit_write(struct upump *upump,
+                                           const void *buffer, size_t size,
+                                           uint64_t offset, int buf_index)
+{
+    return upump_control(upump, UPUMP_URING_SUBMIT_WRITE,
+                         UPUMP_URING_SIGNATURE, buffer, size, offset,
+                         buf_index);
+}
+
+/** @This returns the result of the last completed I/O, to be called from
+ * the callback.
+ *
+ * @param upump description structure of the pump
+ * @param result_p filled in with the number of octets transferred, or a
+ * negative errno value
+ * @return an error code
+ */
+static inline int upump_uring_get_result(struct upump *upump,
+                                         ssize_t *result_p)
+{
+    return upump_control(upump, UPUMP_URING_GET_RESULT,
+                         UPUMP_URING_SIGNATURE, result_p);
+}
+
+/** @This registers fixed buffers with the kernel, to avoid mapping them on
+ * each I/O. Previously registered buffers must be unregistered first.
+ *
+ * @param mgr management structure for this event loop
+ * @param iovecs array of buffers
+ * @param nb number of buffers
+ * @return an error code
+ */
+static inline int upump_uring_mgr_register_buffers(struct upump_mgr *mgr,
+        const struct iovec *iovecs, unsigned int nb)
+{
+    return upump_mgr_control(mgr, UPUMP_URING_MGR_REGISTER_BUFFERS,
+                             UPUMP_URING_SIGNATURE, iovecs, nb);
+}
+
+/** @This unregisters fixed buffers. No I/O using them may be in flight.
+ *
+ * @param mgr management structure for this event loop
+ * @return an error code
+ */
+static inline int upump_uring_mgr_unregister_buffers(struct upump_mgr *mgr)
+{
+    return upump_mgr_control(mgr, UPUMP_URING_MGR_UNREGISTER_BUFFERS,
+                             UPUMP_URING_SIGNATURE);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -115,8 +115,14 @@ struct upipe_alsink {
     snd_pcm_format_t format;
     /** number of planes (1 for planar formats) */
     uint8_t planes;
+    /** requested duration of a period */
+    uint64_t period_request;
     /** duration of a period */
     uint64_t period_duration;
+    /** true if the device ring buffer is written through mmap */
+    bool mmap;
+    /** number of frames to buffer before starting the device */
+    snd_pcm_uframes_t start_frames;
     /** remainder of the number of frames to output per period */
     long long frames_remainder;
 
@@ -282,6 +288,9 @@ static struct upipe *upipe_alsink_alloc(struct upipe_mgr *mgr,
     upipe_alsink_init_uclock(upipe);
     upipe_alsink->latency = 0;
     upipe_alsink->rate = 0;
+    upipe_alsink->period_request = DEFAULT_PERIOD_DURATION;
+    upipe_alsink->period_duration = 0;
+    upipe_alsink->mmap = false;
     upipe_alsink->uri = strdup(DEFAULT_DEVICE);
     upipe_alsink->handle = NULL;
     upipe_alsink->max_urefs = BUFFER_UREFS;
@@ -343,10 +352,19 @@ static bool upipe_alsink_open(struct upipe *upipe)
         goto open_error;
     }
 
+    /* Prefer writing straight into the ring buffer of the device. */
+    snd_pcm_access_t access = upipe_alsink->planes == 1 ?
+                              SND_PCM_ACCESS_MMAP_INTERLEAVED :
+                              SND_PCM_ACCESS_MMAP_NONINTERLEAVED;
+    upipe_alsink->mmap = true;
+    if (snd_pcm_hw_params_test_access(upipe_alsink->handle, hwparams,
+                                      access) < 0) {
+        access = upipe_alsink->planes == 1 ? SND_PCM_ACCESS_RW_INTERLEAVED :
+                                             SND_PCM_ACCESS_RW_NONINTERLEAVED;
+        upipe_alsink->mmap = false;
+    }
     if (snd_pcm_hw_params_set_access(upipe_alsink->handle, hwparams,
-                                     upipe_alsink->planes == 1 ?
-                                     SND_PCM_ACCESS_RW_INTERLEAVED :
-                                     SND_PCM_ACCESS_RW_NONINTERLEAVED) < 0) {
+                                     access) < 0) {
         upipe_err_va(upipe, "can't set interleaved mode (%s)", uri);
         goto open_error;
     }
@@ -370,7 +388,7 @@ static bool upipe_alsink_open(struct upipe *upipe)
     }
 
     upipe_alsink->frames_remainder = 0;
-    snd_pcm_uframes_t frames_in_period = (uint64_t)DEFAULT_PERIOD_DURATION *
+    snd_pcm_uframes_t frames_in_period = upipe_alsink->period_request *
                                          upipe_alsink->rate / UCLOCK_FREQ;
     if (snd_pcm_hw_params_set_period_size_near(upipe_alsink->handle, hwparams,
                                                &frames_in_period, NULL) < 0) {
@@ -401,8 +419,9 @@ static bool upipe_alsink_open(struct upipe *upipe)
     snd_pcm_sw_params_current(upipe_alsink->handle, swparams);
 
     /* Start when the buffer is full enough. */
+    upipe_alsink->start_frames = frames_in_period * 2;
     if (snd_pcm_sw_params_set_start_threshold(upipe_alsink->handle, swparams,
-                                              frames_in_period * 2) < 0) {
+                                              upipe_alsink->start_frames) < 0) {
         upipe_err_va(upipe, "error setting threshold on device %s", uri);
         goto open_error;
     }
@@ -430,7 +449,8 @@ static bool upipe_alsink_open(struct upipe *upipe)
 
     if (!upipe_alsink_check_input(upipe))
         upipe_use(upipe);
-    upipe_notice_va(upipe, "opened device %s", uri);
+    upipe_notice_va(upipe, "opened device %s (%s access)", uri,
+                    upipe_alsink->mmap ? "mmap" : "rw");
     return true;
 
 open_error:
@@ -481,10 +501,96 @@ static bool upipe_alsink_recover(struct upipe *upipe, int err)
     return true;
 }
 
+/** @internal @This is called to write raw data into the mmap'ed ring buffer
+ * of the device, without going through an intermediate buffer.
+ *
+ * @param upipe description structure of the pipe
+ * @param buffers pointer to array of buffers, or NULL to write silence
+ * @param buffer_frames number of frames in buffer
+ * @return the number of frames effectively written, or -1 in case of error
+ */
+static snd_pcm_sframes_t upipe_alsink_mmap_frames(struct upipe *upipe,
+        const void **buffers, snd_pcm_uframes_t buffer_frames)
+{
+    struct upipe_alsink *upipe_alsink = upipe_alsink_from_upipe(upipe);
+    snd_pcm_t *handle = upipe_alsink->handle;
+    snd_pcm_sframes_t avail;
+    while ((avail = snd_pcm_avail_update(handle)) < 0)
+        if (unlikely(!upipe_alsink_recover(upipe, avail)))
+            return -1;
+    if (!avail) {
+        upipe_warn_va(upipe, "ALSA FIFO full, skipping tick");
+        return 0;
+    }
+    if (buffer_frames > (snd_pcm_uframes_t)avail)
+        buffer_frames = avail;
+
+    /* describe the source buffers the way ALSA describes its own */
+    unsigned int channels = upipe_alsink->channels;
+    unsigned int width = snd_pcm_format_physical_width(upipe_alsink->format);
+    snd_pcm_channel_area_t src_areas[channels];
+    if (buffers != NULL) {
+        for (unsigned int i = 0; i < channels; i++) {
+            if (upipe_alsink->planes == 1) {
+                src_areas[i].addr = (void *)buffers[0];
+                src_areas[i].first = i * width;
+                src_areas[i].step = channels * width;
+            } else {
+                src_areas[i].addr = (void *)buffers[i];
+                src_areas[i].first = 0;
+                src_areas[i].step = width;
+            }
+        }
+    }
+
+    snd_pcm_uframes_t written = 0;
+    while (written < buffer_frames) {
+        const snd_pcm_channel_area_t *areas;
+        snd_pcm_uframes_t offset;
+        snd_pcm_uframes_t frames = buffer_frames - written;
+        int err = snd_pcm_mmap_begin(handle, &areas, &offset, &frames);
+        if (unlikely(err < 0)) {
+            if (unlikely(!upipe_alsink_recover(upipe, err)))
+                return -1;
+            break;
+        }
+
+        if (buffers == NULL)
+            snd_pcm_areas_silence(areas, offset, channels, frames,
+                                  upipe_alsink->format);
+        else
+            snd_pcm_areas_copy(areas, offset, src_areas, written, channels,
+                               frames, upipe_alsink->format);
+
+        snd_pcm_sframes_t committed =
+            snd_pcm_mmap_commit(handle, offset, frames);
+        if (unlikely(committed < 0)) {
+            if (unlikely(!upipe_alsink_recover(upipe, committed)))
+                return -1;
+            break;
+        }
+        written += committed;
+        if (unlikely((snd_pcm_uframes_t)committed != frames))
+            break;
+    }
+
+    /* contrary to writes, mmap commits do not start the device */
+    if (snd_pcm_state(handle) == SND_PCM_STATE_PREPARED &&
+        snd_pcm_avail_update(handle) >= 0) {
+        snd_pcm_sframes_t delay;
+        if (snd_pcm_delay(handle, &delay) == 0 &&
+            delay >= (snd_pcm_sframes_t)upipe_alsink->start_frames &&
+            snd_pcm_start(handle) < 0)
+            upipe_warn(upipe, "cannot start device");
+    }
+    return written;
+}
+
 /** @internal @This is called to output raw data to alsa.
  *
  * @param upipe description structure of the pipe
- * @param buffers pointer to array of buffers
+ * @param buffers pointer to array of buffers, or NULL to write silence
+ * in mmap mode
  * @param buffer_frames number of frames in buffer
  * @return the number of frames effectively written, or -1 in case of error
  */
@@ -492,6 +598,9 @@ static snd_pcm_sframes_t upipe_alsink_output_frames(struct upipe *upipe,
         const void **buffers, snd_pcm_uframes_t buffer_frames)
 {
     struct upipe_alsink *upipe_alsink = upipe_alsink_from_upipe(upipe);
+    if (upipe_alsink->mmap)
+        return upipe_alsink_mmap_frames(upipe, buffers, buffer_frames);
+
     snd_pcm_sframes_t frames;
     for ( ; ; ) {
         if (upipe_alsink->planes == 1)
@@ -549,6 +658,9 @@ static snd_pcm_sframes_t upipe_alsink_silence(struct upipe *upipe,
                                               snd_pcm_uframes_t silence_frames)
 {
     struct upipe_alsink *upipe_alsink = upipe_alsink_from_upipe(upipe);
+    if (upipe_alsink->mmap)
+        return upipe_alsink_output_frames(upipe, NULL, silence_frames);
+
     if (upipe_alsink->planes == 1) {
         uint8_t buffer[snd_pcm_frames_to_bytes(upipe_alsink->handle,
                                                silence_frames)];
@@ -826,6 +938,41 @@ static int upipe_alsink_set_uri(struct upipe *upipe, const char *uri)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This returns the duration of a period.
+ *
+ * @param upipe description structure of the pipe
+ * @param duration_p filled in with the duration
+ * @return an error code
+ */
+static int _upipe_alsink_get_period_duration(struct upipe *upipe,
+                                             uint64_t *duration_p)
+{
+    struct upipe_alsink *upipe_alsink = upipe_alsink_from_upipe(upipe);
+    assert(duration_p != NULL);
+    *duration_p = upipe_alsink->handle != NULL ?
+                  upipe_alsink->period_duration :
+                  upipe_alsink->period_request;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the duration of a period.
+ *
+ * @param upipe description structure of the pipe
+ * @param duration requested duration
+ * @return an error code
+ */
+static int _upipe_alsink_set_period_duration(struct upipe *upipe,
+                                             uint64_t duration)
+{
+    struct upipe_alsink *upipe_alsink = upipe_alsink_from_upipe(upipe);
+    if (unlikely(upipe_alsink->handle != NULL))
+        return UBASE_ERR_BUSY;
+    if (unlikely(!duration))
+        return UBASE_ERR_INVALID;
+    upipe_alsink->period_request = duration;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This flushes all currently held buffers, and unblocks the
  * sources.
  *
@@ -932,6 +1079,16 @@ static int upipe_alsink_control(struct upipe *upipe, int command, va_list args)
         }
         case UPIPE_FLUSH:
             return upipe_alsink_flush(upipe);
+        case UPIPE_ALSINK_GET_PERIOD_DURATION: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_ALSINK_SIGNATURE)
+            uint64_t *duration_p = va_arg(args, uint64_t *);
+            return _upipe_alsink_get_period_duration(upipe, duration_p);
+        }
+        case UPIPE_ALSINK_SET_PERIOD_DURATION: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_ALSINK_SIGNATURE)
+            uint64_t duration = va_arg(args, uint64_t);
+            return _upipe_alsink_set_period_duration(upipe, duration);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -28,6 +28,7 @@
  */
 
 #include <upipe/ubase.h>
+#include <upipe/ulist.h>
 #include <upipe/uprobe.h>
 #include <upipe/uclock.h>
 #include <upipe/uref.h>
@@ -69,6 +70,10 @@
 
 /** default size of buffers when unspecified */
 #define UBUF_DEFAULT_SIZE       4096
+/** default number of datagrams read per wakeup */
+#define AMT_DEFAULT_BATCH_SIZE  64
+/** maximum number of datagrams read per wakeup */
+#define AMT_MAX_BATCH_SIZE      1024
 
 /** @hidden */
 static int upipe_amtsrc_check(struct upipe *upipe, struct uref *flow_format);
@@ -125,6 +130,8 @@ struct upipe_amtsrc {
     struct upump *upump;
     /** read size */
     unsigned int output_size;
+    /** maximum number of datagrams read per wakeup */
+    unsigned int batch_size;
 
     /** AMT handle */
     amt_handle_t handle;
@@ -178,6 +185,7 @@ static struct upipe *upipe_amtsrc_alloc(struct upipe_mgr *mgr,
     upipe_amtsrc_init_upump(upipe);
     upipe_amtsrc_init_uclock(upipe);
     upipe_amtsrc_init_output_size(upipe, UBUF_DEFAULT_SIZE);
+    upipe_amtsrc->batch_size = AMT_DEFAULT_BATCH_SIZE;
     upipe_amtsrc->handle = NULL;
     upipe_amtsrc->uri = NULL;
     upipe_throw_ready(upipe);
@@ -186,50 +194,43 @@ static struct upipe *upipe_amtsrc_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
-/** @internal @This reads data from the source and outputs it.
- * It is called either when the idler triggers (permanent storage mode) or
- * when data is available on the udp socket descriptor (live stream mode).
+/** @internal @This polls the AMT channel and reads a datagram if one is
+ * available.
  *
- * @param upump description structure of the read watcher
+ * @param upipe description structure of the pipe
+ * @param timeout poll timeout in milliseconds
+ * @param uref_p filled in with the received datagram, or NULL
+ * @return false if the channel was closed or an error occurred
  */
-static void upipe_amtsrc_worker(struct upump *upump)
+static bool upipe_amtsrc_read(struct upipe *upipe, int timeout,
+                              struct uref **uref_p)
 {
-    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     struct upipe_amtsrc *upipe_amtsrc = upipe_amtsrc_from_upipe(upipe);
     amt_read_event_t ars[1];
     ars[0].handle = upipe_amtsrc->handle;
     ars[0].rstate = AMT_READ_NONE;
+    *uref_p = NULL;
 
-    /* Implementation note: libamt is synchronous, so we have to poll for
-     * input. The timeout is set as low as possible to 1 ms. */
-    if (unlikely(amt_poll(ars, 1, 1) < 0)) {
+    if (unlikely(amt_poll(ars, 1, timeout) < 0)) {
         upipe_err_va(upipe, "poll error from %s", upipe_amtsrc->uri);
-        upipe_amtsrc_set_upump(upipe, NULL);
-        upipe_throw_source_end(upipe);
-        return;
+        return false;
     }
 
     if (unlikely((ars[0].rstate & AMT_READ_CLOSE) ||
                  (ars[0].rstate & AMT_READ_ERR))) {
         upipe_err_va(upipe, "end of %s", upipe_amtsrc->uri);
-        upipe_amtsrc_set_upump(upipe, NULL);
-        upipe_throw_source_end(upipe);
-        return;
+        return false;
     }
 
     if (!(ars[0].rstate & AMT_READ_IN))
-        return;
-
-    uint64_t systime = 0; /* to keep gcc quiet */
-    if (unlikely(upipe_amtsrc->uclock != NULL))
-        systime = uclock_now(upipe_amtsrc->uclock);
+        return true;
 
     struct uref *uref = uref_block_alloc(upipe_amtsrc->uref_mgr,
                                          upipe_amtsrc->ubuf_mgr,
                                          upipe_amtsrc->output_size);
     if (unlikely(uref == NULL)) {
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        return;
+        return true;
     }
 
     uint8_t *buffer;
@@ -238,7 +239,7 @@ static void upipe_amtsrc_worker(struct upump *upump)
                                                &buffer)))) {
         uref_free(uref);
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        return;
+        return true;
     }
     assert(output_size == upipe_amtsrc->output_size);
 
@@ -249,15 +250,63 @@ static void upipe_amtsrc_worker(struct upump *upump)
     if (unlikely(ret == 0)) {
         uref_free(uref);
         upipe_err_va(upipe, "read error from %s", upipe_amtsrc->uri);
-        upipe_amtsrc_set_upump(upipe, NULL);
-        upipe_throw_source_end(upipe);
-        return;
+        return false;
     }
-    if (unlikely(upipe_amtsrc->uclock != NULL))
-        uref_clock_set_cr_sys(uref, systime);
     if (unlikely(ret != upipe_amtsrc->output_size))
         uref_block_resize(uref, 0, ret);
-    upipe_amtsrc_output(upipe, uref, &upipe_amtsrc->upump);
+    *uref_p = uref;
+    return true;
+}
+
+/** @internal @This reads data from the source and outputs it.
+ * It is called when the idler triggers, and drains up to batch_size
+ * datagrams from the AMT channel.
+ *
+ * @param upump description structure of the read watcher
+ */
+static void upipe_amtsrc_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_amtsrc *upipe_amtsrc = upipe_amtsrc_from_upipe(upipe);
+    bool end = false;
+
+    /* Implementation note: libamt is synchronous, so we have to poll for
+     * input. The timeout is set as low as possible to 1 ms for the first
+     * datagram, and the datagrams already queued are then read without
+     * waiting. */
+    struct uchain urefs;
+    ulist_init(&urefs);
+    for (unsigned int i = 0; i < upipe_amtsrc->batch_size; i++) {
+        struct uref *uref;
+        if (unlikely(!upipe_amtsrc_read(upipe, i ? 0 : 1, &uref))) {
+            end = true;
+            break;
+        }
+        if (uref == NULL)
+            break;
+        ulist_add(&urefs, uref_to_uchain(uref));
+    }
+
+    if (!ulist_empty(&urefs) && unlikely(upipe_amtsrc->uclock != NULL)) {
+        uint64_t systime = uclock_now(upipe_amtsrc->uclock);
+        struct uchain *uchain;
+        ulist_foreach (&urefs, uchain)
+            uref_clock_set_cr_sys(uref_from_uchain(uchain), systime);
+    }
+
+    /* the output may change the configuration of the pipe */
+    upipe_use(upipe);
+    if (unlikely(end))
+        upipe_amtsrc_set_upump(upipe, NULL);
+
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&urefs)) != NULL)
+        upipe_amtsrc_output(upipe, uref_from_uchain(uchain),
+                            &upipe_amtsrc->upump);
+
+    if (unlikely(end))
+        upipe_throw_source_end(upipe);
+    upipe_release(upipe);
 }
 
 /** @internal @This checks if the pump may be allocated.
@@ -422,6 +471,8 @@ upipe_amtsrc_set_uri_err:
 static int _upipe_amtsrc_control(struct upipe *upipe,
                                  int command, va_list args)
 {
+    struct upipe_amtsrc *upipe_amtsrc = upipe_amtsrc_from_upipe(upipe);
+
     switch (command) {
         case UPIPE_ATTACH_UPUMP_MGR:
             upipe_amtsrc_set_upump(upipe, NULL);
@@ -448,6 +499,22 @@ static int _upipe_amtsrc_control(struct upipe *upipe,
             const char *uri = va_arg(args, const char *);
             return upipe_amtsrc_set_uri(upipe, uri);
         }
+
+        case UPIPE_AMTSRC_GET_BATCH_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AMTSRC_SIGNATURE)
+            unsigned int *batch_size_p = va_arg(args, unsigned int *);
+            assert(batch_size_p != NULL);
+            *batch_size_p = upipe_amtsrc->batch_size;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_AMTSRC_SET_BATCH_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AMTSRC_SIGNATURE)
+            unsigned int batch_size = va_arg(args, unsigned int);
+            if (unlikely(!batch_size || batch_size > AMT_MAX_BATCH_SIZE))
+                return UBASE_ERR_INVALID;
+            upipe_amtsrc->batch_size = batch_size;
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -0,0 +1,462 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe ubuf manager for picture formats with libav frame storage
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/urefcount.h>
+#include <upipe/upool.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_pic.h>
+#include <upipe/ubuf_pic_common.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe-av/ubuf_av.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <assert.h>
+
+#include <libavutil/frame.h>
+#include <libavutil/hwcontext.h>
+
+/** @This is a super-set of the @ref ubuf (and @ref ubuf_pic_common)
+ * structure with private fields pointing to shared data. */
+struct ubuf_pic_av {
+    /** reference to the frame, in system or device memory */
+    AVFrame *frame;
+    /** reference to the frame downloaded to system memory, or NULL */
+    AVFrame *sw_frame;
+
+    /** common picture structure */
+    struct ubuf_pic_common ubuf_pic_common;
+};
+
+UBASE_FROM_TO(ubuf_pic_av, ubuf, ubuf, ubuf_pic_common.ubuf)
+
+/** @This is a super-set of the ubuf_mgr structure with additional local
+ * members. */
+struct ubuf_pic_av_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** ubuf pool */
+    struct upool ubuf_pool;
+
+    /** pixel format in system memory */
+    enum AVPixelFormat sw_format;
+
+    /** common picture management structure */
+    struct ubuf_pic_common_mgr common_mgr;
+
+    /** extra space for upool */
+    uint8_t upool_extra[];
+};
+
+UBASE_FROM_TO(ubuf_pic_av_mgr, ubuf_mgr, ubuf_mgr, common_mgr.mgr)
+UBASE_FROM_TO(ubuf_pic_av_mgr, urefcount, urefcount, urefcount)
+UBASE_FROM_TO(ubuf_pic_av_mgr, upool, ubuf_pool, ubuf_pool)
+
+/** @internal @This points the planes of the ubuf to a frame in system
+ * memory.
+ *
+ * @param ubuf pointer to ubuf
+ * @param frame frame in system memory
+ * @return an error code
+ */
+static int ubuf_pic_av_init_planes(struct ubuf *ubuf, AVFrame *frame)
+{
+    struct ubuf_pic_av_mgr *pic_mgr = ubuf_pic_av_mgr_from_ubuf_mgr(ubuf->mgr);
+    for (uint8_t plane = 0; plane < pic_mgr->common_mgr.nb_planes; plane++) {
+        if (unlikely(plane >= AV_NUM_DATA_POINTERS ||
+                     frame->data[plane] == NULL))
+            return UBASE_ERR_INVALID;
+        ubuf_pic_common_plane_init(ubuf, plane, frame->data[plane],
+                                   frame->linesize[plane]);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @This allocates a ubuf wrapping a reference to a frame.
+ *
+ * @param mgr common management structure
+ * @param signature must be UBUF_AV_ALLOC_PICTURE (sentinel)
+ * @param args optional arguments (1st = AVFrame *)
+ * @return pointer to ubuf or NULL in case of allocation error
+ */
+static struct ubuf *ubuf_pic_av_alloc_frame(struct ubuf_mgr *mgr,
+                                            uint32_t signature, va_list args)
+{
+    if (unlikely(signature != UBUF_AV_ALLOC_PICTURE))
+        return NULL;
+
+    struct ubuf_pic_av_mgr *pic_mgr = ubuf_pic_av_mgr_from_ubuf_mgr(mgr);
+    AVFrame *frame = va_arg(args, AVFrame *);
+    uint8_t macropixel = pic_mgr->common_mgr.macropixel;
+    if (unlikely(frame->width % macropixel ||
+                 (frame->hw_frames_ctx == NULL &&
+                  frame->format != pic_mgr->sw_format)))
+        return NULL;
+
+    struct ubuf_pic_av *pic_av = upool_alloc(&pic_mgr->ubuf_pool,
+                                             struct ubuf_pic_av *);
+    if (unlikely(pic_av == NULL))
+        return NULL;
+
+    struct ubuf *ubuf = ubuf_pic_av_to_ubuf(pic_av);
+    pic_av->sw_frame = NULL;
+    pic_av->frame = av_frame_clone(frame);
+    if (unlikely(pic_av->frame == NULL)) {
+        upool_free(&pic_mgr->ubuf_pool, pic_av);
+        return NULL;
+    }
+
+    ubuf_pic_common_init(ubuf, 0, 0, frame->width / macropixel,
+                         0, 0, frame->height);
+    /* frames in device memory are mapped on demand */
+    for (uint8_t plane = 0; plane < pic_mgr->common_mgr.nb_planes; plane++)
+        ubuf_pic_common_plane_init(ubuf, plane, NULL, 0);
+    if (frame->hw_frames_ctx == NULL &&
+        unlikely(!ubase_check(ubuf_pic_av_init_planes(ubuf, frame)))) {
+        ubuf_free(ubuf);
+        return NULL;
+    }
+    return ubuf;
+}
+
+/** @internal @This downloads the frame to system memory if it is located
+ * in device memory and hasn't been downloaded yet.
+ *
+ * @param ubuf pointer to ubuf
+ * @return an error code
+ */
+static int ubuf_pic_av_download(struct ubuf *ubuf)
+{
+    struct ubuf_pic_av_mgr *pic_mgr = ubuf_pic_av_mgr_from_ubuf_mgr(ubuf->mgr);
+    struct ubuf_pic_av *pic_av = ubuf_pic_av_from_ubuf(ubuf);
+    if (pic_av->frame->hw_frames_ctx == NULL || pic_av->sw_frame != NULL)
+        return UBASE_ERR_NONE;
+
+    AVFrame *sw_frame = av_frame_alloc();
+    if (unlikely(sw_frame == NULL))
+        return UBASE_ERR_ALLOC;
+    sw_frame->format = pic_mgr->sw_format;
+    if (unlikely(av_hwframe_transfer_data(sw_frame, pic_av->frame, 0) < 0)) {
+        av_frame_free(&sw_frame);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    int err = ubuf_pic_av_init_planes(ubuf, sw_frame);
+    if (unlikely(!ubase_check(err))) {
+        av_frame_free(&sw_frame);
+        return err;
+    }
+    pic_av->sw_frame = sw_frame;
+    return UBASE_ERR_NONE;
+}
+
+/** @This asks for the creation of a new reference to the same buffer space.
+ *
+ * @param ubuf pointer to ubuf
+ * @param new_ubuf_p reference written with a pointer to the newly allocated
+ * ubuf
+ * @return an error code
+ */
+static int ubuf_pic_av_dup(struct ubuf *ubuf, struct ubuf **new_ubuf_p)
+{
+    assert(new_ubuf_p != NULL);
+    struct ubuf_pic_av_mgr *pic_mgr = ubuf_pic_av_mgr_from_ubuf_mgr(ubuf->mgr);
+    struct ubuf_pic_av *pic_av = ubuf_pic_av_from_ubuf(ubuf);
+    struct ubuf_pic_av *new_pic = upool_alloc(&pic_mgr->ubuf_pool,
+                                              struct ubuf_pic_av *);
+    if (unlikely(new_pic == NULL))
+        return UBASE_ERR_ALLOC;
+
+    struct ubuf *new_ubuf = ubuf_pic_av_to_ubuf(new_pic);
+    new_pic->frame = av_frame_clone(pic_av->frame);
+    new_pic->sw_frame = NULL;
+    if (pic_av->sw_frame != NULL)
+        new_pic->sw_frame = av_frame_clone(pic_av->sw_frame);
+    if (unlikely(new_pic->frame == NULL ||
+                 (pic_av->sw_frame != NULL && new_pic->sw_frame == NULL))) {
+        ubuf_free(new_ubuf);
+        return UBASE_ERR_ALLOC;
+    }
+
+    if (unlikely(!ubase_check(ubuf_pic_common_dup(ubuf, new_ubuf)))) {
+        ubuf_free(new_ubuf);
+        return UBASE_ERR_INVALID;
+    }
+    for (uint8_t plane = 0; plane < pic_mgr->common_mgr.nb_planes; plane++) {
+        if (unlikely(!ubase_check(ubuf_pic_common_plane_dup(ubuf, new_ubuf,
+                                                            plane)))) {
+            ubuf_free(new_ubuf);
+            return UBASE_ERR_INVALID;
+        }
+    }
+    *new_ubuf_p = new_ubuf;
+    return UBASE_ERR_NONE;
+}
+
+/** @This returns the wrapped frame. The reference counter is not
+ * incremented.
+ *
+ * @param ubuf pointer to ubuf
+ * @param frame_p filled in with a pointer to the frame
+ * @return an error code
+ */
+static int _ubuf_pic_av_get_frame(struct ubuf *ubuf, AVFrame **frame_p)
+{
+    struct ubuf_pic_av *pic_av = ubuf_pic_av_from_ubuf(ubuf);
+    *frame_p = pic_av->frame;
+    return UBASE_ERR_NONE;
+}
+
+/** @This handles control commands.
+ *
+ * @param ubuf pointer to ubuf
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int ubuf_pic_av_control(struct ubuf *ubuf, int command, va_list args)
+{
+    switch (command) {
+        case UBUF_DUP: {
+            struct ubuf **new_ubuf_p = va_arg(args, struct ubuf **);
+            return ubuf_pic_av_dup(ubuf, new_ubuf_p);
+        }
+        case UBUF_SIZE_PICTURE: {
+            size_t *hsize_p = va_arg(args, size_t *);
+            size_t *vsize_p = va_arg(args, size_t *);
+            uint8_t *macropixel_p = va_arg(args, uint8_t *);
+            return ubuf_pic_common_size(ubuf, hsize_p, vsize_p, macropixel_p);
+        }
+        case UBUF_ITERATE_PICTURE_PLANE: {
+            const char **chroma_p = va_arg(args, const char **);
+            return ubuf_pic_common_plane_iterate(ubuf, chroma_p);
+        }
+        case UBUF_SIZE_PICTURE_PLANE: {
+            const char *chroma = va_arg(args, const char *);
+            size_t *stride_p = va_arg(args, size_t *);
+            uint8_t *hsub_p = va_arg(args, uint8_t *);
+            uint8_t *vsub_p = va_arg(args, uint8_t *);
+            uint8_t *macropixel_size_p = va_arg(args, uint8_t *);
+            /* the stride is only known in system memory */
+            if (stride_p != NULL)
+                UBASE_RETURN(ubuf_pic_av_download(ubuf))
+            return ubuf_pic_common_plane_size(ubuf, chroma, stride_p,
+                                              hsub_p, vsub_p,
+                                              macropixel_size_p);
+        }
+        case UBUF_READ_PICTURE_PLANE: {
+            const char *chroma = va_arg(args, const char *);
+            int hoffset = va_arg(args, int);
+            int voffset = va_arg(args, int);
+            int hsize = va_arg(args, int);
+            int vsize = va_arg(args, int);
+            uint8_t **buffer_p = va_arg(args, uint8_t **);
+            UBASE_RETURN(ubuf_pic_av_download(ubuf))
+            return ubuf_pic_common_plane_map(ubuf, chroma, hoffset, voffset,
+                                             hsize, vsize, buffer_p);
+        }
+        case UBUF_WRITE_PICTURE_PLANE: {
+            /* frames may be referenced by libav */
+            return UBASE_ERR_BUSY;
+        }
+        case UBUF_UNMAP_PICTURE_PLANE: {
+            /* we don't actually care about the parameters */
+            return UBASE_ERR_NONE;
+        }
+        case UBUF_RESIZE_PICTURE: {
+            int hskip = va_arg(args, int);
+            int vskip = va_arg(args, int);
+            int new_hsize = va_arg(args, int);
+            int new_vsize = va_arg(args, int);
+            return ubuf_pic_common_resize(ubuf, hskip, vskip,
+                                          new_hsize, new_vsize);
+        }
+
+        case UBUF_PIC_AV_GET_FRAME: {
+            UBASE_SIGNATURE_CHECK(args, UBUF_AV_ALLOC_PICTURE)
+            AVFrame **frame_p = va_arg(args, AVFrame **);
+            return _ubuf_pic_av_get_frame(ubuf, frame_p);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This recycles or frees a ubuf.
+ *
+ * @param ubuf pointer to a ubuf structure
+ */
+static void ubuf_pic_av_free(struct ubuf *ubuf)
+{
+    struct ubuf_pic_av_mgr *pic_mgr = ubuf_pic_av_mgr_from_ubuf_mgr(ubuf->mgr);
+    struct ubuf_pic_av *pic_av = ubuf_pic_av_from_ubuf(ubuf);
+
+    ubuf_pic_common_clean(ubuf);
+    for (uint8_t plane = 0; plane < pic_mgr->common_mgr.nb_planes; plane++)
+        ubuf_pic_common_plane_clean(ubuf, plane);
+
+    av_frame_free(&pic_av->sw_frame);
+    av_frame_free(&pic_av->frame);
+    upool_free(&pic_mgr->ubuf_pool, pic_av);
+}
+
+/** @internal @This allocates the data structure.
+ *
+ * @param upool pointer to upool
+ * @return pointer to ubuf_pic_av or NULL in case of allocation error
+ */
+static void *ubuf_pic_av_alloc_inner(struct upool *upool)
+{
+    struct ubuf_pic_av_mgr *pic_mgr = ubuf_pic_av_mgr_from_ubuf_pool(upool);
+    struct ubuf_mgr *mgr = ubuf_pic_av_mgr_to_ubuf_mgr(pic_mgr);
+    struct ubuf_pic_av *pic_av = malloc(sizeof(struct ubuf_pic_av) +
+                                        ubuf_pic_common_sizeof(mgr));
+    if (unlikely(pic_av == NULL))
+        return NULL;
+    struct ubuf *ubuf = ubuf_pic_av_to_ubuf(pic_av);
+    ubuf->mgr = mgr;
+    return pic_av;
+}
+
+/** @internal @This frees a ubuf_pic_av.
+ *
+ * @param upool pointer to upool
+ * @param _pic_av pointer to a ubuf_pic_av structure to free
+ */
+static void ubuf_pic_av_free_inner(struct upool *upool, void *_pic_av)
+{
+    struct ubuf_pic_av *pic_av = _pic_av;
+    free(pic_av);
+}
+
+/** @This handles manager control commands.
+ *
+ * @param mgr pointer to ubuf manager
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int ubuf_pic_av_mgr_control(struct ubuf_mgr *mgr,
+                                   int command, va_list args)
+{
+    switch (command) {
+        case UBUF_MGR_VACUUM: {
+            struct ubuf_pic_av_mgr *pic_mgr =
+                ubuf_pic_av_mgr_from_ubuf_mgr(mgr);
+            upool_clean(&pic_mgr->ubuf_pool);
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a ubuf manager.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void ubuf_pic_av_mgr_free(struct urefcount *urefcount)
+{
+    struct ubuf_pic_av_mgr *pic_mgr =
+        ubuf_pic_av_mgr_from_urefcount(urefcount);
+    struct ubuf_mgr *mgr = ubuf_pic_av_mgr_to_ubuf_mgr(pic_mgr);
+    upool_clean(&pic_mgr->ubuf_pool);
+
+    ubuf_pic_common_mgr_clean(mgr);
+
+    urefcount_clean(urefcount);
+    free(pic_mgr);
+}
+
+/** @This allocates a new instance of the ubuf manager for picture formats
+ * using libav frames.
+ *
+ * @param ubuf_pool_depth maximum number of ubuf structures in the pool
+ * @param sw_format pixel format of the frames in system memory, that is
+ * the format frames in device memory are downloaded to
+ * @param flow_def flow definition describing the planes of sw_format
+ * @return pointer to manager, or NULL in case of error
+ */
+struct ubuf_mgr *ubuf_pic_av_mgr_alloc(uint16_t ubuf_pool_depth,
+                                       enum AVPixelFormat sw_format,
+                                       struct uref *flow_def)
+{
+    uint8_t macropixel, planes;
+    if (unlikely(flow_def == NULL ||
+                 !ubase_check(uref_pic_flow_get_macropixel(flow_def,
+                                                           &macropixel)) ||
+                 !ubase_check(uref_pic_flow_get_planes(flow_def, &planes))))
+        return NULL;
+
+    struct ubuf_pic_av_mgr *pic_mgr = malloc(sizeof(struct ubuf_pic_av_mgr) +
+                                             upool_sizeof(ubuf_pool_depth));
+    if (unlikely(pic_mgr == NULL))
+        return NULL;
+
+    struct ubuf_mgr *mgr = ubuf_pic_av_mgr_to_ubuf_mgr(pic_mgr);
+    ubuf_pic_common_mgr_init(mgr, macropixel);
+
+    urefcount_init(ubuf_pic_av_mgr_to_urefcount(pic_mgr),
+                   ubuf_pic_av_mgr_free);
+    pic_mgr->common_mgr.mgr.refcount = ubuf_pic_av_mgr_to_urefcount(pic_mgr);
+
+    mgr->signature = UBUF_AV_ALLOC_PICTURE;
+    mgr->ubuf_alloc = ubuf_pic_av_alloc_frame;
+    mgr->ubuf_control = ubuf_pic_av_control;
+    mgr->ubuf_free = ubuf_pic_av_free;
+    mgr->ubuf_mgr_control = ubuf_pic_av_mgr_control;
+
+    pic_mgr->sw_format = sw_format;
+    upool_init(&pic_mgr->ubuf_pool, mgr->refcount, ubuf_pool_depth,
+               pic_mgr->upool_extra,
+               ubuf_pic_av_alloc_inner, ubuf_pic_av_free_inner);
+
+    for (uint8_t plane = 0; plane < planes; plane++) {
+        const char *chroma;
+        uint8_t hsub, vsub, macropixel_size;
+        if (unlikely(!ubase_check(uref_pic_flow_get_chroma(flow_def,
+                                                     &chroma, plane)) ||
+                     !ubase_check(uref_pic_flow_get_hsubsampling(flow_def,
+                                                     &hsub, plane)) ||
+                     !ubase_check(uref_pic_flow_get_vsubsampling(flow_def,
+                                                     &vsub, plane)) ||
+                     !ubase_check(uref_pic_flow_get_macropixel_size(flow_def,
+                                         &macropixel_size, plane)) ||
+                     !ubase_check(ubuf_pic_common_mgr_add_plane(mgr,
+                                 chroma, hsub, vsub, macropixel_size)))) {
+            ubuf_mgr_release(mgr);
+            return NULL;
+        }
+    }
+
+    return mgr;
+}
@@ -69,13 +69,25 @@
 #include <libavutil/avutil.h>
 #include <libavutil/pixdesc.h>
 #include <libavutil/opt.h>
+#include <libavutil/hwcontext.h>
 #include <upipe-av/upipe_av_pixfmt.h>
 #include <upipe-av/upipe_av_samplefmt.h>
+#include <upipe-av/ubuf_av.h>
 #include "upipe_av_internal.h"
 
 #include <bitstream/dvb/sub.h>
 
 #define EXPECTED_FLOW_DEF "block."
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(59, 59, 100)
+/** libavcodec propagates AVPacket.opaque_ref to the frames of the packet */
+#   define UPIPE_AVCDEC_COPY_OPAQUE
+#else
+/** number of packets tracked while frame threading delays their decoding
+ * (libavcodec doesn't run more than 64 frame threads) */
+#   define PENDING_UREFS 64
+#endif
+/** depth of the pool of ubufs wrapping hardware surfaces */
+#define HW_UBUF_POOL_DEPTH 8
 
 /** @hidden */
 static int upipe_avcdec_check(struct upipe *upipe, struct uref *flow_format);
@@ -145,6 +157,30 @@ struct upipe_avcdec {
     uint64_t iframe_rap;
     /** latest incoming uref */
     struct uref *uref;
+#ifndef UPIPE_AVCDEC_COPY_OPAQUE
+    /** urefs of the packets being decoded by frame threads, indexed by
+     * picture number */
+    struct uref *pending[PENDING_UREFS];
+#endif
+    /** requested threading mode, or -1 for libavcodec's default */
+    int thread_type;
+    /** requested number of threads, or -1 for libavcodec's default */
+    int thread_count;
+
+    /** requested hardware device type, or NULL */
+    char *hw_type;
+    /** requested hardware device, or NULL */
+    char *hw_device;
+    /** pixel format of hardware surfaces, or AV_PIX_FMT_NONE */
+    enum AVPixelFormat hw_pix_fmt;
+    /** current pool of hardware surfaces */
+    const void *hw_frames;
+    /** pixel format hardware surfaces are downloaded to */
+    enum AVPixelFormat hw_sw_format;
+    /** ubuf manager wrapping hardware surfaces */
+    struct ubuf_mgr *hw_ubuf_mgr;
+    /** flow format of the hardware ubuf manager */
+    struct uref *hw_flow_format;
     /** last PTS */
     uint64_t last_pts;
     /** last PTS (systime time) */
@@ -209,6 +245,270 @@ static int upipe_avcdec_check(struct upipe *upipe, struct uref *flow_format)
 
 static void upipe_av_uref_pic_free(void *opaque, uint8_t *data);
 
+/** @internal @This returns the uref of the packet a frame is allocated for.
+ * With frame threading, libavcodec asks for buffers of packets submitted
+ * some time ago, so the latest uref may not be the right one.
+ *
+ * @param upipe description structure of the pipe
+ * @param frame frame being allocated
+ * @return pointer to uref, or NULL
+ */
+static struct uref *upipe_avcdec_frame_uref(struct upipe *upipe,
+                                            AVFrame *frame)
+{
+    struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
+#ifdef UPIPE_AVCDEC_COPY_OPAQUE
+    /* copied from the packet by AV_CODEC_FLAG_COPY_OPAQUE */
+    if (frame->opaque_ref != NULL)
+        return (struct uref *)frame->opaque_ref->data;
+#else
+    if (upipe_avcdec->context->active_thread_type & FF_THREAD_FRAME &&
+        frame->reordered_opaque >= 0) {
+        struct uref *uref =
+            upipe_avcdec->pending[frame->reordered_opaque % PENDING_UREFS];
+        uint64_t number;
+        if (uref != NULL && ubase_check(uref_pic_get_number(uref, &number)) &&
+            number == (uint64_t)frame->reordered_opaque)
+            return uref;
+    }
+#endif
+    return upipe_avcdec->uref;
+}
+
+/** @internal @This allocates the flow definition attributes of a picture.
+ *
+ * @param upipe description structure of the pipe
+ * @param frame frame being allocated
+ * @param pix_fmt pixel format of the picture in system memory
+ * @return pointer to flow definition attributes, or NULL in case of error
+ */
+static struct uref *upipe_avcdec_alloc_pic_flow_def_attr(struct upipe *upipe,
+        AVFrame *frame, enum AVPixelFormat pix_fmt)
+{
+    struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
+    AVCodecContext *context = upipe_avcdec->context;
+
+    struct uref *flow_def_attr = upipe_avcdec_alloc_flow_def_attr(upipe);
+    if (unlikely(flow_def_attr == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
+    if (unlikely(!ubase_check(upipe_av_pixfmt_to_flow_def(pix_fmt,
+                                                          flow_def_attr)))) {
+        uref_free(flow_def_attr);
+        upipe_err_va(upipe, "unhandled pixel format %d", pix_fmt);
+        upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
+        return NULL;
+    }
+
+    UBASE_FATAL(upipe, uref_pic_flow_set_hsize(flow_def_attr, context->width))
+    UBASE_FATAL(upipe, uref_pic_flow_set_vsize(flow_def_attr, context->height))
+    UBASE_FATAL(upipe, uref_pic_flow_set_hsize_visible(flow_def_attr, context->width))
+    UBASE_FATAL(upipe, uref_pic_flow_set_vsize_visible(flow_def_attr, context->height))
+    struct urational fps;
+    if (!ubase_check(uref_pic_flow_get_fps(upipe_avcdec->flow_def_input, &fps))) {
+        fps.num = context->framerate.num;
+        fps.den = context->framerate.den;
+    }
+    if (fps.num && fps.den) {
+        urational_simplify(&fps);
+        UBASE_FATAL(upipe, uref_pic_flow_set_fps(flow_def_attr, fps))
+
+        uint64_t latency = upipe_avcdec->input_latency +
+                           context->delay * UCLOCK_FREQ * fps.den / fps.num;
+        /* frame threading holds back one frame per additional thread */
+        if (context->active_thread_type & FF_THREAD_FRAME &&
+            context->thread_count > 1)
+            latency += (uint64_t)(context->thread_count - 1) *
+                       UCLOCK_FREQ * fps.den / fps.num;
+        UBASE_FATAL(upipe, uref_clock_set_latency(flow_def_attr, latency))
+    }
+    /* set aspect-ratio */
+    if (frame->sample_aspect_ratio.num) {
+        struct urational sar;
+        sar.num = frame->sample_aspect_ratio.num;
+        sar.den = frame->sample_aspect_ratio.den;
+        urational_simplify(&sar);
+        UBASE_FATAL(upipe, uref_pic_flow_set_sar(flow_def_attr, sar))
+    } else if (context->sample_aspect_ratio.num) {
+        struct urational sar = {
+            .num = context->sample_aspect_ratio.num,
+            .den = context->sample_aspect_ratio.den
+        };
+        urational_simplify(&sar);
+        UBASE_FATAL(upipe, uref_pic_flow_set_sar(flow_def_attr, sar))
+    }
+    return flow_def_attr;
+}
+
+/** @internal @This releases the uref tied to a hardware surface.
+ *
+ * @param opaque pointer to uref
+ * @param data unused
+ */
+static void upipe_av_uref_hw_free(void *opaque, uint8_t *data)
+{
+    struct uref *uref = opaque;
+    uref_free(uref_from_uchain(uref->uchain.next));
+    uref_free(uref);
+}
+
+/** @internal @This finds a pixel format hardware surfaces may be downloaded
+ * to, and that upipe can describe.
+ *
+ * @param upipe description structure of the pipe
+ * @param frames_ref reference to the pool of hardware surfaces
+ * @return pixel format, or AV_PIX_FMT_NONE
+ */
+static enum AVPixelFormat upipe_avcdec_hw_sw_format(struct upipe *upipe,
+                                                    AVBufferRef *frames_ref)
+{
+    AVHWFramesContext *frames_ctx = (AVHWFramesContext *)frames_ref->data;
+    struct uref *flow_def = upipe_avcdec_alloc_flow_def_attr(upipe);
+    if (unlikely(flow_def == NULL))
+        return AV_PIX_FMT_NONE;
+
+    enum AVPixelFormat sw_format = AV_PIX_FMT_NONE;
+    enum AVPixelFormat *formats = NULL;
+    if (ubase_check(upipe_av_pixfmt_to_flow_def(frames_ctx->sw_format,
+                                                flow_def)))
+        sw_format = frames_ctx->sw_format;
+    else if (av_hwframe_transfer_get_formats(frames_ref,
+                AV_HWFRAME_TRANSFER_DIRECTION_FROM, &formats, 0) >= 0) {
+        for (int i = 0; formats[i] != AV_PIX_FMT_NONE; i++)
+            if (ubase_check(upipe_av_pixfmt_to_flow_def(formats[i],
+                                                        flow_def))) {
+                sw_format = formats[i];
+                break;
+            }
+        av_free(formats);
+    }
+    uref_free(flow_def);
+    return sw_format;
+}
+
+/** @internal @This is called by avcodec when allocating a new picture in
+ * device memory. The surface is allocated by avcodec, and the uref is tied to
+ * its lifetime.
+ *
+ * @param upipe description structure of the pipe
+ * @param frame avframe handler entering avcodec black magic box
+ * @param uref uref structure of the picture
+ * @param flags get_buffer2 flags
+ * @return a libav error code
+ */
+static int upipe_avcdec_get_buffer_hw(struct upipe *upipe, AVFrame *frame,
+                                      struct uref *uref, int flags)
+{
+    struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
+    AVCodecContext *context = upipe_avcdec->context;
+
+    if (unlikely(context->hw_frames_ctx == NULL)) {
+        upipe_err(upipe, "no hardware frames context");
+        uref_free(uref);
+        return -1;
+    }
+
+    if (unlikely(context->hw_frames_ctx->data != upipe_avcdec->hw_frames)) {
+        /* new pool of surfaces */
+        ubuf_mgr_release(upipe_avcdec->hw_ubuf_mgr);
+        upipe_avcdec->hw_ubuf_mgr = NULL;
+        uref_free(upipe_avcdec->hw_flow_format);
+        upipe_avcdec->hw_flow_format = NULL;
+        upipe_avcdec->hw_frames = context->hw_frames_ctx->data;
+        upipe_avcdec->hw_sw_format =
+            upipe_avcdec_hw_sw_format(upipe, context->hw_frames_ctx);
+    }
+    if (unlikely(upipe_avcdec->hw_sw_format == AV_PIX_FMT_NONE)) {
+        upipe_err(upipe, "no supported format to download surfaces to");
+        upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
+        uref_free(uref);
+        return -1;
+    }
+
+    struct uref *flow_def_attr =
+        upipe_avcdec_alloc_pic_flow_def_attr(upipe, frame,
+                                             upipe_avcdec->hw_sw_format);
+    if (unlikely(flow_def_attr == NULL)) {
+        uref_free(uref);
+        return -1;
+    }
+
+    if (unlikely(upipe_avcdec->hw_ubuf_mgr != NULL &&
+                 udict_cmp(upipe_avcdec->hw_flow_format->udict,
+                           flow_def_attr->udict))) {
+        /* flow format changed */
+        ubuf_mgr_release(upipe_avcdec->hw_ubuf_mgr);
+        upipe_avcdec->hw_ubuf_mgr = NULL;
+        uref_free(upipe_avcdec->hw_flow_format);
+        upipe_avcdec->hw_flow_format = NULL;
+    }
+    if (unlikely(upipe_avcdec->hw_ubuf_mgr == NULL)) {
+        upipe_avcdec->hw_flow_format = uref_dup(flow_def_attr);
+        upipe_avcdec->hw_ubuf_mgr =
+            ubuf_pic_av_mgr_alloc(HW_UBUF_POOL_DEPTH,
+                                  upipe_avcdec->hw_sw_format, flow_def_attr);
+        if (unlikely(upipe_avcdec->hw_flow_format == NULL ||
+                     upipe_avcdec->hw_ubuf_mgr == NULL)) {
+            ubuf_mgr_release(upipe_avcdec->hw_ubuf_mgr);
+            upipe_avcdec->hw_ubuf_mgr = NULL;
+            uref_free(upipe_avcdec->hw_flow_format);
+            upipe_avcdec->hw_flow_format = NULL;
+            goto error;
+        }
+    }
+
+    int err = avcodec_default_get_buffer2(context, frame, flags);
+    if (unlikely(err < 0)) {
+        uref_free(uref);
+        uref_free(flow_def_attr);
+        return err;
+    }
+
+    /* Chain the new flow def attributes to the uref so we can apply them
+     * later. */
+    uref->uchain.next = uref_to_uchain(flow_def_attr);
+
+    /* Use a spare buffer reference to release the uref with the surface. */
+    int i;
+    for (i = 0; i < AV_NUM_DATA_POINTERS && frame->buf[i] != NULL; i++);
+    if (unlikely(i == AV_NUM_DATA_POINTERS ||
+                 (frame->buf[i] = av_buffer_create(NULL, 0,
+                        upipe_av_uref_hw_free, uref, 0)) == NULL)) {
+        uref->uchain.next = NULL;
+        goto error;
+    }
+    return 0;
+
+error:
+    uref_free(uref);
+    uref_free(flow_def_attr);
+    upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+    return -1;
+}
+
+/** @internal @This is called by avcodec to negotiate the pixel format, and
+ * selects hardware surfaces if they are supported.
+ *
+ * @param context current avcodec context
+ * @param fmts pixel formats supported by the codec
+ * @return selected pixel format
+ */
+static enum AVPixelFormat
+    upipe_avcdec_get_format(struct AVCodecContext *context,
+                            const enum AVPixelFormat *fmts)
+{
+    struct upipe *upipe = context->opaque;
+    struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
+
+    for (const enum AVPixelFormat *p = fmts; *p != AV_PIX_FMT_NONE; p++)
+        if (*p == upipe_avcdec->hw_pix_fmt)
+            return *p;
+
+    upipe_warn(upipe, "hardware surfaces not offered, decoding in software");
+    return avcodec_default_get_format(context, fmts);
+}
+
 /* Documentation from libavcodec.h (get_buffer) :
  * The function will set AVFrame.data[], AVFrame.linesize[].
  * AVFrame.extended_data[] must also be set, but it should be the same as
@@ -245,12 +545,13 @@ static int upipe_avcdec_get_buffer_pic(struct AVCodecContext *context,
     struct upipe *upipe = context->opaque;
     struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
 
-    if (unlikely(upipe_avcdec->uref == NULL)) {
+    struct uref *uref = upipe_avcdec_frame_uref(upipe, frame);
+    if (unlikely(uref == NULL)) {
         upipe_dbg(upipe, "get_buffer called without uref");
         return -1;
     }
 
-    struct uref *uref = uref_dup(upipe_avcdec->uref);
+    uref = uref_dup(uref);
     frame->opaque = uref;
 
     uint64_t framenum = 0;
@@ -259,6 +560,10 @@ static int upipe_avcdec_get_buffer_pic(struct AVCodecContext *context,
     upipe_verbose_va(upipe, "Allocating frame for %"PRIu64" (%p) - %dx%d",
                      framenum, frame->opaque, frame->width, frame->height);
 
+    if (upipe_avcdec->hw_pix_fmt != AV_PIX_FMT_NONE &&
+        frame->format == upipe_avcdec->hw_pix_fmt)
+        return upipe_avcdec_get_buffer_hw(upipe, frame, uref, flags);
+
     /* Check if we have a new pixel format. */
     if (unlikely(context->pix_fmt != upipe_avcdec->pix_fmt)) {
         ubuf_mgr_release(upipe_avcdec->ubuf_mgr);
@@ -279,57 +584,14 @@ static int upipe_avcdec_get_buffer_pic(struct AVCodecContext *context,
                 ubase_gcd(align, linesize_align[i]);
 
     /* Prepare flow definition attributes. */
-    struct uref *flow_def_attr = upipe_avcdec_alloc_flow_def_attr(upipe);
+    struct uref *flow_def_attr =
+        upipe_avcdec_alloc_pic_flow_def_attr(upipe, frame,
+                                             upipe_avcdec->pix_fmt);
     if (unlikely(flow_def_attr == NULL)) {
         uref_free(uref);
-        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        return -1;
-    }
-    if (unlikely(!ubase_check(upipe_av_pixfmt_to_flow_def(upipe_avcdec->pix_fmt,
-                                                          flow_def_attr)))) {
-        uref_free(uref);
-        uref_free(flow_def_attr);
-        upipe_err_va(upipe, "unhandled pixel format %d", upipe_avcdec->pix_fmt);
-        upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
         return -1;
     }
-
     UBASE_FATAL(upipe, uref_pic_flow_set_align(flow_def_attr, align))
-    UBASE_FATAL(upipe, uref_pic_flow_set_hsize(flow_def_attr, context->width))
-    UBASE_FATAL(upipe, uref_pic_flow_set_vsize(flow_def_attr, context->height))
-    UBASE_FATAL(upipe, uref_pic_flow_set_hsize_visible(flow_def_attr, context->width))
-    UBASE_FATAL(upipe, uref_pic_flow_set_vsize_visible(flow_def_attr, context->height))
-    struct urational fps;
-    if (!ubase_check(uref_pic_flow_get_fps(upipe_avcdec->flow_def_input, &fps))) {
-        fps.num = context->framerate.num;
-        fps.den = context->framerate.den;
-    }
-    if (fps.num && fps.den) {
-        urational_simplify(&fps);
-        UBASE_FATAL(upipe, uref_pic_flow_set_fps(flow_def_attr, fps))
-
-        uint64_t latency = upipe_avcdec->input_latency +
-                           context->delay * UCLOCK_FREQ * fps.den / fps.num;
-        if (context->active_thread_type == FF_THREAD_FRAME &&
-            context->thread_count != -1)
-            latency += context->thread_count * UCLOCK_FREQ * fps.den / fps.num;
-        UBASE_FATAL(upipe, uref_clock_set_latency(flow_def_attr, latency))
-    }
-    /* set aspect-ratio */
-    if (frame->sample_aspect_ratio.num) {
-        struct urational sar;
-        sar.num = frame->sample_aspect_ratio.num;
-        sar.den = frame->sample_aspect_ratio.den;
-        urational_simplify(&sar);
-        UBASE_FATAL(upipe, uref_pic_flow_set_sar(flow_def_attr, sar))
-    } else if (context->sample_aspect_ratio.num) {
-        struct urational sar = {
-            .num = context->sample_aspect_ratio.num,
-            .den = context->sample_aspect_ratio.den
-        };
-        urational_simplify(&sar);
-        UBASE_FATAL(upipe, uref_pic_flow_set_sar(flow_def_attr, sar))
-    }
 
     if (unlikely(upipe_avcdec->ubuf_mgr != NULL &&
                  udict_cmp(upipe_avcdec->flow_def_format->udict,
@@ -466,10 +728,11 @@ static int upipe_avcdec_get_buffer_sound(struct AVCodecContext *context,
     struct upipe *upipe = context->opaque;
     struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
 
-    if (unlikely(upipe_avcdec->uref == NULL))
+    struct uref *uref = upipe_avcdec_frame_uref(upipe, frame);
+    if (unlikely(uref == NULL))
         return -1;
 
-    struct uref *uref = uref_dup(upipe_avcdec->uref);
+    uref = uref_dup(uref);
     frame->opaque = uref;
 
     uint64_t framenum = 0;
@@ -577,6 +840,58 @@ static void upipe_avcdec_abort_av_deal(struct upipe *upipe)
     }
 }
 
+/** @internal @This opens the requested hardware device, if the codec
+ * supports it.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_avcdec_open_hw(struct upipe *upipe)
+{
+    struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
+    upipe_avcdec->hw_pix_fmt = AV_PIX_FMT_NONE;
+    if (upipe_avcdec->hw_type == NULL)
+        return;
+
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(58, 18, 100)
+    AVCodecContext *context = upipe_avcdec->context;
+    enum AVHWDeviceType type =
+        av_hwdevice_find_type_by_name(upipe_avcdec->hw_type);
+    if (type == AV_HWDEVICE_TYPE_NONE) {
+        upipe_warn_va(upipe, "unknown hardware device type %s",
+                      upipe_avcdec->hw_type);
+        return;
+    }
+
+    enum AVPixelFormat pix_fmt = AV_PIX_FMT_NONE;
+    for (int i = 0; pix_fmt == AV_PIX_FMT_NONE; i++) {
+        const AVCodecHWConfig *config =
+            avcodec_get_hw_config(context->codec, i);
+        if (config == NULL) {
+            upipe_warn_va(upipe, "codec %s doesn't support %s decoding",
+                          context->codec->name, upipe_avcdec->hw_type);
+            return;
+        }
+        if (config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX &&
+            config->device_type == type)
+            pix_fmt = config->pix_fmt;
+    }
+
+    av_buffer_unref(&context->hw_device_ctx);
+    int err = av_hwdevice_ctx_create(&context->hw_device_ctx, type,
+                                     upipe_avcdec->hw_device, NULL, 0);
+    if (unlikely(err < 0)) {
+        upipe_av_strerror(err, buf);
+        upipe_warn_va(upipe, "could not open %s device (%s)",
+                      upipe_avcdec->hw_type, buf);
+        return;
+    }
+    upipe_avcdec->hw_pix_fmt = pix_fmt;
+    context->get_format = upipe_avcdec_get_format;
+#else
+    upipe_warn(upipe, "hardware decoding not supported by libavcodec");
+#endif
+}
+
 /** @internal @This actually calls avcodec_open(). It may only be called by
  * one thread at a time.
  *
@@ -603,6 +918,7 @@ static bool upipe_avcdec_do_av_deal(struct upipe *upipe)
             break;
         case AVMEDIA_TYPE_VIDEO:
             context->get_buffer2 = upipe_avcdec_get_buffer_pic;
+            upipe_avcdec_open_hw(upipe);
 
 #if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(55, 48, 102)
             /* otherwise we need specific prepend/append/align */
@@ -621,6 +937,19 @@ static bool upipe_avcdec_do_av_deal(struct upipe *upipe)
             return false;
     }
 
+    if (upipe_avcdec->thread_type >= 0) {
+        context->thread_type = 0;
+        if (upipe_avcdec->thread_type & UPIPE_AVCDEC_THREAD_FRAME)
+            context->thread_type |= FF_THREAD_FRAME;
+        if (upipe_avcdec->thread_type & UPIPE_AVCDEC_THREAD_SLICE)
+            context->thread_type |= FF_THREAD_SLICE;
+    }
+    if (upipe_avcdec->thread_count >= 0)
+        context->thread_count = upipe_avcdec->thread_count;
+#ifdef UPIPE_AVCDEC_COPY_OPAQUE
+    context->flags |= AV_CODEC_FLAG_COPY_OPAQUE;
+#endif
+
     /* open new context */
     int err;
     if (unlikely((err = avcodec_open2(context, context->codec, NULL)) < 0)) {
@@ -631,6 +960,10 @@ static bool upipe_avcdec_do_av_deal(struct upipe *upipe)
     }
     upipe_notice_va(upipe, "codec %s (%s) %d opened", context->codec->name,
                     context->codec->long_name, context->codec->id);
+    if (context->active_thread_type)
+        upipe_dbg_va(upipe, "using %d %s threads", context->thread_count,
+                     context->active_thread_type & FF_THREAD_FRAME ?
+                     "frame" : "slice");
 
     return true;
 }
@@ -735,8 +1068,10 @@ static void upipe_avcdec_close(struct upipe *upipe)
         return;
     }
 
-    if (upipe_avcdec->context->codec->capabilities & AV_CODEC_CAP_DELAY) {
-        /* Feed avcodec with NULL packets to output the remaining frames */
+    if (upipe_avcdec->context->codec->capabilities & AV_CODEC_CAP_DELAY ||
+        upipe_avcdec->context->active_thread_type & FF_THREAD_FRAME) {
+        /* Feed avcodec with NULL packets to output the remaining frames,
+         * including those still held by frame threads */
         AVPacket avpkt;
         memset(&avpkt, 0, sizeof(AVPacket));
         av_init_packet(&avpkt);
@@ -1020,22 +1355,40 @@ static void upipe_avcdec_output_pic(struct upipe *upipe, struct upump **upump_p)
     upipe_verbose_va(upipe, "%"PRIu64"\t - Picture decoded ! %dx%d - %"PRIu64,
                  upipe_avcdec->counter, frame->width, frame->height, framenum);
 
-    /* Resize the picture (was allocated too big). */
-    if (unlikely(!ubase_check(uref_pic_resize(uref, 0, 0, frame->width, frame->height)))) {
-        upipe_warn_va(upipe, "couldn't resize picture to %dx%d",
-                      frame->width, frame->height);
-        upipe_throw_error(upipe, UBASE_ERR_EXTERNAL);
-    }
+    if (frame->hw_frames_ctx != NULL) {
+        /* Keep the surface in device memory. */
+        uref = uref_dup(uref);
+        if (unlikely(uref == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        struct ubuf *ubuf = ubuf_pic_av_alloc(upipe_avcdec->hw_ubuf_mgr,
+                                              frame);
+        if (unlikely(ubuf == NULL)) {
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        uref_attach_ubuf(uref, ubuf);
+    } else {
+        /* Resize the picture (was allocated too big). */
+        if (unlikely(!ubase_check(uref_pic_resize(uref, 0, 0, frame->width, frame->height)))) {
+            upipe_warn_va(upipe, "couldn't resize picture to %dx%d",
+                          frame->width, frame->height);
+            upipe_throw_error(upipe, UBASE_ERR_EXTERNAL);
+        }
 
-    /* Duplicate uref because it is freed in _release, because the ubuf
-     * is still in use by avcodec. */
-    uref = uref_dup(uref);
-    if (unlikely(uref == NULL)) {
-        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        return;
+        /* Duplicate uref because it is freed in _release, because the ubuf
+         * is still in use by avcodec. */
+        uref = uref_dup(uref);
+        if (unlikely(uref == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
     }
 
-    if (!(context->codec->capabilities & AV_CODEC_CAP_DR1)) {
+    if (frame->hw_frames_ctx == NULL &&
+        !(context->codec->capabilities & AV_CODEC_CAP_DR1)) {
         /* Not direct rendering, copy data. */
         uint8_t planes;
         if (unlikely(!ubase_check(uref_pic_flow_get_planes(flow_def_attr, &planes)))) {
@@ -1244,6 +1597,24 @@ static bool upipe_avcdec_decode_avpkt(struct upipe *upipe, AVPacket *avpkt,
             break;
         }
 
+#ifdef UPIPE_AVCDEC_COPY_OPAQUE
+        case AVMEDIA_TYPE_VIDEO:
+        case AVMEDIA_TYPE_AUDIO:
+            /* an empty packet enters draining mode */
+            len = avcodec_send_packet(context, avpkt->size ? avpkt : NULL);
+            if (len < 0 && len != AVERROR_EOF)
+                upipe_warn(upipe, "Error while decoding frame");
+
+            /* output all frames that have been decoded */
+            while (avcodec_receive_frame(context, upipe_avcdec->frame) >= 0) {
+                gotframe = 1;
+                if (context->codec->type == AVMEDIA_TYPE_VIDEO)
+                    upipe_avcdec_output_pic(upipe, upump_p);
+                else
+                    upipe_avcdec_output_sound(upipe, upump_p);
+            }
+            break;
+#else
         case AVMEDIA_TYPE_VIDEO:
             len = avcodec_decode_video2(context,
                                         upipe_avcdec->frame,
@@ -1271,6 +1642,7 @@ static bool upipe_avcdec_decode_avpkt(struct upipe *upipe, AVPacket *avpkt,
                 upipe_avcdec_output_sound(upipe, upump_p);
             }
             break;
+#endif
 
         default:
             /* should never be here */
@@ -1296,6 +1668,47 @@ static void upipe_avcdec_store_uref(struct upipe *upipe, struct uref *uref)
     upipe_avcdec->uref = uref;
 }
 
+#ifdef UPIPE_AVCDEC_COPY_OPAQUE
+/** @internal @This releases the uref attached to a packet.
+ *
+ * @param opaque unused
+ * @param data pointer to uref
+ */
+static void upipe_avcdec_opaque_free(void *opaque, uint8_t *data)
+{
+    uref_free((struct uref *)data);
+}
+#else
+/** @internal @This keeps a copy of the uref of a packet submitted to frame
+ * threads, until its buffers are allocated.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param number picture number of the uref
+ */
+static void upipe_avcdec_store_pending(struct upipe *upipe, struct uref *uref,
+                                       uint64_t number)
+{
+    struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
+    struct uref **pending_p = &upipe_avcdec->pending[number % PENDING_UREFS];
+    uref_free(*pending_p);
+    *pending_p = uref_dup(uref);
+}
+
+/** @internal @This frees the urefs of packets submitted to frame threads.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_avcdec_clean_pending(struct upipe *upipe)
+{
+    struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
+    for (unsigned int i = 0; i < PENDING_UREFS; i++) {
+        uref_free(upipe_avcdec->pending[i]);
+        upipe_avcdec->pending[i] = NULL;
+    }
+}
+#endif
+
 /** @internal @This decodes packets.
  *
  * @param upipe description structure of the pipe
@@ -1340,7 +1753,8 @@ static bool upipe_avcdec_decode(struct upipe *upipe, struct uref *uref,
     ubuf_free(uref_detach_ubuf(uref));
     memset(avpkt.data + avpkt.size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
 
-    uref_pic_set_number(uref, upipe_avcdec->counter++);
+    uint64_t number = upipe_avcdec->counter++;
+    uref_pic_set_number(uref, number);
     uref_clock_get_rate(uref, &upipe_avcdec->drift_rate);
     uint64_t input_dts, input_dts_sys;
     if (ubase_check(uref_clock_get_dts_prog(uref, &input_dts)) &&
@@ -1350,8 +1764,29 @@ static bool upipe_avcdec_decode(struct upipe *upipe, struct uref *uref,
     }
 
     upipe_avcdec_store_uref(upipe, uref);
+#ifdef UPIPE_AVCDEC_COPY_OPAQUE
+    /* the uref follows the packet through frame threads and reordering */
+    struct uref *opaque = uref_dup(uref);
+    if (unlikely(opaque == NULL ||
+                 (avpkt.opaque_ref = av_buffer_create((uint8_t *)opaque,
+                        sizeof(*opaque), upipe_avcdec_opaque_free, NULL,
+                        AV_BUFFER_FLAG_READONLY)) == NULL)) {
+        uref_free(opaque);
+        free(avpkt.data);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return true;
+    }
+#else
+    AVCodecContext *context = upipe_avcdec->context;
+    context->reordered_opaque = number;
+    if (context->active_thread_type & FF_THREAD_FRAME)
+        upipe_avcdec_store_pending(upipe, uref, number);
+#endif
     upipe_avcdec_decode_avpkt(upipe, &avpkt, upump_p);
 
+#ifdef UPIPE_AVCDEC_COPY_OPAQUE
+    av_buffer_unref(&avpkt.opaque_ref);
+#endif
     free(avpkt.data);
     return true;
 }
@@ -1537,6 +1972,112 @@ static int upipe_avcdec_set_option(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This returns the threading configuration.
+ *
+ * @param upipe description structure of the pipe
+ * @param type_p filled in with a combination of
+ * @ref upipe_avcdec_thread_type
+ * @param count_p filled in with the number of threads (0 for automatic)
+ * @return an error code
+ */
+static int _upipe_avcdec_get_threads(struct upipe *upipe, int *type_p,
+                                     unsigned int *count_p)
+{
+    struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
+    AVCodecContext *context = upipe_avcdec->context;
+    /* libavcodec's defaults */
+    int ff_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    int count = 1;
+
+    if (context != NULL && avcodec_is_open(context)) {
+        ff_type = context->active_thread_type;
+        count = context->thread_count;
+    } else {
+        if (context != NULL) {
+            ff_type = context->thread_type;
+            count = context->thread_count;
+        }
+        if (upipe_avcdec->thread_type >= 0) {
+            ff_type = 0;
+            if (upipe_avcdec->thread_type & UPIPE_AVCDEC_THREAD_FRAME)
+                ff_type |= FF_THREAD_FRAME;
+            if (upipe_avcdec->thread_type & UPIPE_AVCDEC_THREAD_SLICE)
+                ff_type |= FF_THREAD_SLICE;
+        }
+        if (upipe_avcdec->thread_count >= 0)
+            count = upipe_avcdec->thread_count;
+    }
+
+    if (type_p != NULL) {
+        *type_p = UPIPE_AVCDEC_THREAD_NONE;
+        if (ff_type & FF_THREAD_FRAME)
+            *type_p |= UPIPE_AVCDEC_THREAD_FRAME;
+        if (ff_type & FF_THREAD_SLICE)
+            *type_p |= UPIPE_AVCDEC_THREAD_SLICE;
+    }
+    if (count_p != NULL)
+        *count_p = count > 0 ? count : 0;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the threading configuration. It only takes effect
+ * when the codec is opened.
+ *
+ * @param upipe description structure of the pipe
+ * @param type combination of @ref upipe_avcdec_thread_type
+ * @param count number of threads, or 0 for automatic
+ * @return an error code
+ */
+static int _upipe_avcdec_set_threads(struct upipe *upipe, int type,
+                                     unsigned int count)
+{
+    struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
+    if (upipe_avcdec->context != NULL &&
+        avcodec_is_open(upipe_avcdec->context))
+        return UBASE_ERR_BUSY;
+    if (type & ~(UPIPE_AVCDEC_THREAD_FRAME | UPIPE_AVCDEC_THREAD_SLICE))
+        return UBASE_ERR_INVALID;
+#ifndef UPIPE_AVCDEC_COPY_OPAQUE
+    if (count > PENDING_UREFS)
+        return UBASE_ERR_INVALID;
+#endif
+    upipe_avcdec->thread_type = type;
+    upipe_avcdec->thread_count = count;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the hardware device used to decode. It only takes
+ * effect when the codec is opened.
+ *
+ * @param upipe description structure of the pipe
+ * @param type libav hardware device type, or NULL
+ * @param device device to open, or NULL for the default device
+ * @return an error code
+ */
+static int _upipe_avcdec_set_hw_config(struct upipe *upipe, const char *type,
+                                       const char *device)
+{
+    struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
+    if (upipe_avcdec->context != NULL &&
+        avcodec_is_open(upipe_avcdec->context))
+        return UBASE_ERR_BUSY;
+
+    free(upipe_avcdec->hw_type);
+    free(upipe_avcdec->hw_device);
+    upipe_avcdec->hw_type = NULL;
+    upipe_avcdec->hw_device = NULL;
+    if (type == NULL)
+        return UBASE_ERR_NONE;
+
+    upipe_avcdec->hw_type = strdup(type);
+    if (device != NULL)
+        upipe_avcdec->hw_device = strdup(device);
+    if (unlikely(upipe_avcdec->hw_type == NULL ||
+                 (device != NULL && upipe_avcdec->hw_device == NULL)))
+        return UBASE_ERR_ALLOC;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a file source pipe, and
  * checks the status of the pipe afterwards.
  *
@@ -1582,6 +2123,25 @@ static int upipe_avcdec_control(struct upipe *upipe, int command, va_list args)
             return upipe_avcdec_set_option(upipe, option, content);
         }
 
+        case UPIPE_AVCDEC_GET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AVCDEC_SIGNATURE)
+            int *type_p = va_arg(args, int *);
+            unsigned int *count_p = va_arg(args, unsigned int *);
+            return _upipe_avcdec_get_threads(upipe, type_p, count_p);
+        }
+        case UPIPE_AVCDEC_SET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AVCDEC_SIGNATURE)
+            int type = va_arg(args, int);
+            unsigned int count = va_arg(args, unsigned int);
+            return _upipe_avcdec_set_threads(upipe, type, count);
+        }
+        case UPIPE_AVCDEC_SET_HW_CONFIG: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AVCDEC_SIGNATURE)
+            const char *type = va_arg(args, const char *);
+            const char *device = va_arg(args, const char *);
+            return _upipe_avcdec_set_hw_config(upipe, type, device);
+        }
+
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -1597,12 +2157,20 @@ static void upipe_avcdec_free(struct upipe *upipe)
 
     if (upipe_avcdec->context != NULL) {
         free(upipe_avcdec->context->extradata);
+        av_buffer_unref(&upipe_avcdec->context->hw_device_ctx);
         av_free(upipe_avcdec->context);
     }
     av_frame_free(&upipe_avcdec->frame);
 
     upipe_throw_dead(upipe);
     uref_free(upipe_avcdec->uref);
+#ifndef UPIPE_AVCDEC_COPY_OPAQUE
+    upipe_avcdec_clean_pending(upipe);
+#endif
+    ubuf_mgr_release(upipe_avcdec->hw_ubuf_mgr);
+    uref_free(upipe_avcdec->hw_flow_format);
+    free(upipe_avcdec->hw_type);
+    free(upipe_avcdec->hw_device);
     uref_free(upipe_avcdec->flow_def_format);
     uref_free(upipe_avcdec->flow_def_provided);
     upipe_avcdec_abort_av_deal(upipe);
@@ -1656,6 +2224,19 @@ static struct upipe *upipe_avcdec_alloc(struct upipe_mgr *mgr,
     upipe_avcdec->sample_fmt = AV_SAMPLE_FMT_NONE;
     upipe_avcdec->channels = 0;
     upipe_avcdec->uref = NULL;
+#ifndef UPIPE_AVCDEC_COPY_OPAQUE
+    for (unsigned int i = 0; i < PENDING_UREFS; i++)
+        upipe_avcdec->pending[i] = NULL;
+#endif
+    upipe_avcdec->thread_type = -1;
+    upipe_avcdec->thread_count = -1;
+    upipe_avcdec->hw_type = NULL;
+    upipe_avcdec->hw_device = NULL;
+    upipe_avcdec->hw_pix_fmt = AV_PIX_FMT_NONE;
+    upipe_avcdec->hw_frames = NULL;
+    upipe_avcdec->hw_sw_format = AV_PIX_FMT_NONE;
+    upipe_avcdec->hw_ubuf_mgr = NULL;
+    upipe_avcdec->hw_flow_format = NULL;
     upipe_avcdec->flow_def_format = NULL;
     upipe_avcdec->flow_def_provided = NULL;
 
@@ -70,6 +70,7 @@
 
 #include <libavcodec/avcodec.h>
 #include <libavutil/avutil.h>
+#include <libavutil/buffer.h>
 #include <libavutil/pixdesc.h>
 #include <libavutil/opt.h>
 #include <upipe-av/upipe_av_pixfmt.h>
@@ -82,6 +83,9 @@ UREF_ATTR_INT(avcenc, priv, "x.avcenc_priv", avcenc private pts)
 
 /** start offset of avcodec PTS */
 #define AVCPTS_INIT 1
+/** alignment of input planes suggested to upstream pipes, matching the
+ * widest SIMD loads of libavcodec encoders */
+#define AVCENC_ALIGN 64
 
 /** @hidden */
 static int upipe_avcenc_check_ubuf_mgr(struct upipe *upipe,
@@ -536,6 +540,7 @@ static bool upipe_avcenc_encode_frame(struct upipe *upipe,
         if (ubase_check(uref_avcenc_get_priv(uref_chain, &priv)) && priv == pkt_pts) {
             uref = uref_chain;
             ulist_delete(uchain);
+            upipe_stats_unhold(upipe, uref);
             break;
         }
     }
@@ -546,23 +551,7 @@ static bool upipe_avcenc_encode_frame(struct upipe *upipe,
         return false;
     }
 
-    /* unmap input */
-    switch (codec->type) {
-        case AVMEDIA_TYPE_VIDEO: {
-            int i;
-            for (i = 0; i < UPIPE_AV_MAX_PLANES &&
-                        upipe_avcenc->chroma_map[i] != NULL; i++)
-                uref_pic_plane_unmap(uref, upipe_avcenc->chroma_map[i],
-                                     0, 0, -1, -1);
-            break;
-        }
-        case AVMEDIA_TYPE_AUDIO: {
-            break;
-        }
-        default: /* should never be there */
-            uref_free(uref);
-            return false;
-    }
+    /* input planes are unmapped when libavcodec releases the frame */
     uref_attach_ubuf(uref, ubuf);
     uref_avcenc_delete_priv(uref);
 
@@ -622,6 +611,75 @@ static bool upipe_avcenc_encode_frame(struct upipe *upipe,
     return true;
 }
 
+/** @hidden */
+struct upipe_avcenc_plane {
+    /** reference to the picture buffer */
+    struct ubuf *ubuf;
+    /** mapped plane */
+    const char *chroma;
+};
+
+/** @internal @This is called by libavcodec when it releases a plane of an
+ * input frame.
+ *
+ * @param opaque pointer to the plane description
+ * @param data mapped plane
+ */
+static void upipe_avcenc_plane_free(void *opaque, uint8_t *data)
+{
+    struct upipe_avcenc_plane *plane = opaque;
+    ubuf_pic_plane_unmap(plane->ubuf, plane->chroma, 0, 0, -1, -1);
+    ubuf_free(plane->ubuf);
+    free(plane);
+}
+
+/** @internal @This wraps a plane of a picture buffer into a read-only
+ * AVBufferRef, so that libavcodec references the input frame instead of
+ * copying it when it keeps it for later use (B-frames, lookahead, threads).
+ *
+ * @param ubuf picture buffer
+ * @param chroma chroma type
+ * @param data_p filled in with the mapped plane
+ * @param stride_p filled in with the stride of the plane
+ * @return pointer to AVBufferRef, or NULL in case of error
+ */
+static AVBufferRef *upipe_avcenc_plane_ref(struct ubuf *ubuf,
+                                           const char *chroma,
+                                           const uint8_t **data_p,
+                                           size_t *stride_p)
+{
+    size_t vsize;
+    uint8_t vsub;
+    if (unlikely(!ubase_check(ubuf_pic_size(ubuf, NULL, &vsize, NULL)) ||
+                 !ubase_check(ubuf_pic_plane_size(ubuf, chroma, stride_p,
+                                                  NULL, &vsub, NULL))))
+        return NULL;
+
+    struct upipe_avcenc_plane *plane = malloc(sizeof(*plane));
+    if (unlikely(plane == NULL))
+        return NULL;
+    plane->ubuf = ubuf_dup(ubuf);
+    plane->chroma = chroma;
+    if (unlikely(plane->ubuf == NULL)) {
+        free(plane);
+        return NULL;
+    }
+    if (unlikely(!ubase_check(ubuf_pic_plane_read(plane->ubuf, chroma,
+                                                  0, 0, -1, -1, data_p)))) {
+        ubuf_free(plane->ubuf);
+        free(plane);
+        return NULL;
+    }
+
+    AVBufferRef *buf = av_buffer_create((uint8_t *)*data_p,
+                                        *stride_p * vsize / vsub,
+                                        upipe_avcenc_plane_free, plane,
+                                        AV_BUFFER_FLAG_READONLY);
+    if (unlikely(buf == NULL))
+        upipe_avcenc_plane_free(plane, (uint8_t *)*data_p);
+    return buf;
+}
+
 /** @internal @This encodes video frames.
  *
  * @param upipe description structure of the pipe
@@ -644,22 +702,25 @@ static void upipe_avcenc_encode_video(struct upipe *upipe,
         return;
     }
 
+    frame->format = context->pix_fmt;
     int i;
     for (i = 0; i < UPIPE_AV_MAX_PLANES && upipe_avcenc->chroma_map[i] != NULL;
          i++) {
         const uint8_t *data;
         size_t stride;
-        if (unlikely(!ubase_check(uref_pic_plane_read(uref, upipe_avcenc->chroma_map[i],
-                                          0, 0, -1, -1, &data)) ||
-                     !ubase_check(uref_pic_plane_size(uref, upipe_avcenc->chroma_map[i],
-                                          &stride, NULL, NULL, NULL)))) {
+        frame->buf[i] = upipe_avcenc_plane_ref(uref->ubuf,
+                upipe_avcenc->chroma_map[i], &data, &stride);
+        if (unlikely(frame->buf[i] == NULL)) {
             upipe_warn(upipe, "invalid buffer received");
+            av_frame_unref(frame);
             uref_free(uref);
             return;
         }
         frame->data[i] = (uint8_t *)data;
         frame->linesize[i] = stride;
     }
+    /* the planes are now owned by the frame */
+    ubuf_free(uref_detach_ubuf(uref));
 
     /* set frame dimensions */
     frame->width = hsize;
@@ -715,7 +776,9 @@ static void upipe_avcenc_encode_video(struct upipe *upipe,
 
     /* store uref in mapping list */
     ulist_add(&upipe_avcenc->urefs_in_use, uref_to_uchain(uref));
+    upipe_stats_hold(upipe, uref);
     upipe_avcenc_encode_frame(upipe, frame, upump_p);
+    av_frame_unref(frame);
 }
 
 /** @internal @This encodes audio frames.
@@ -773,6 +836,7 @@ static void upipe_avcenc_encode_audio(struct upipe *upipe,
         if (unlikely(!ubase_check(uref_sound_read_uint8_t(uref, 0, extracted,
                                         buffers, AV_NUM_DATA_POINTERS)))) {
             upipe_warn(upipe, "invalid buffer received");
+            upipe_stats_unhold(upipe, uref);
             uref_free(uref_from_uchain(ulist_pop(&upipe_avcenc->sound_urefs)));
             upipe_avcenc->nb_samples -= size;
             free(buf);
@@ -789,10 +853,12 @@ static void upipe_avcenc_encode_audio(struct upipe *upipe,
 
         offset += extracted;
         upipe_avcenc->nb_samples -= extracted;
+        upipe_stats_unhold(upipe, uref);
         if (extracted == size)
             uref_free(uref_from_uchain(ulist_pop(&upipe_avcenc->sound_urefs)));
         else {
             uref_sound_resize(uref, extracted, -1);
+            upipe_stats_hold(upipe, uref);
             uint64_t duration = (uint64_t)extracted * UCLOCK_FREQ /
                                 context->sample_rate;
             uint64_t pts;
@@ -817,6 +883,7 @@ static void upipe_avcenc_encode_audio(struct upipe *upipe,
 
     /* store uref in mapping list */
     ulist_add(&upipe_avcenc->urefs_in_use, uref_to_uchain(main_uref));
+    upipe_stats_hold(upipe, main_uref);
     upipe_avcenc_encode_frame(upipe, frame, upump_p);
     free(buf);
 }
@@ -875,6 +942,7 @@ static bool upipe_avcenc_handle(struct upipe *upipe, struct uref *uref,
             }
 
             ulist_add(&upipe_avcenc->sound_urefs, uref_to_uchain(uref));
+            upipe_stats_hold(upipe, uref);
             upipe_avcenc->nb_samples += size;
 
             while (upipe_avcenc->nb_samples >= context->frame_size)
@@ -1266,6 +1334,12 @@ static int _upipe_avcenc_provide_flow_format(struct upipe *upipe,
                 goto upipe_avcenc_provide_flow_format_err;
         }
 
+        /* planes are passed by reference to libavcodec, which may copy
+         * them if they are not suitably aligned */
+        if (unlikely(!ubase_check(uref_pic_flow_require_align(flow_format,
+                                                AVCENC_ALIGN))))
+            goto upipe_avcenc_provide_flow_format_err;
+
         const AVRational *supported_framerates = codec->supported_framerates;
         struct urational fps = {25, 1};
         if (ubase_check(uref_pic_flow_get_fps(flow_format, &fps)) &&
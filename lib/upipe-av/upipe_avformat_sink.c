@@ -45,6 +45,9 @@
 #include <upipe/upipe_helper_void.h>
 #include <upipe/upipe_helper_flow_def_check.h>
 #include <upipe/upipe_helper_subpipe.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe/upipe_helper_uref_mgr.h>
+#include <upipe/upipe_helper_ubuf_mgr.h>
 #include <upipe-framers/uref_mpga_flow.h>
 #include <upipe-av/upipe_avformat_sink.h>
 
@@ -64,13 +67,46 @@
 #include <assert.h>
 
 #include <libavutil/dict.h>
+#include <libavutil/buffer.h>
 #include <libavformat/avformat.h>
 
+/** size of the custom I/O buffer, written at once to the output */
+#define IO_BUFFER_SIZE (1024 * 1024)
+
+/** @hidden */
+static int upipe_avfsink_check(struct upipe *upipe, struct uref *flow_format);
+
 /** @internal @This is the private context of an avformat source pipe. */
 struct upipe_avfsink {
     /** refcount management structure */
     struct urefcount urefcount;
 
+    /** pipe acting as output, receiving the muxed stream */
+    struct upipe *output;
+    /** output flow definition */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** uref manager */
+    struct uref_mgr *uref_mgr;
+    /** uref manager request */
+    struct urequest uref_mgr_request;
+
+    /** ubuf manager */
+    struct ubuf_mgr *ubuf_mgr;
+    /** flow format packet */
+    struct uref *flow_format;
+    /** ubuf manager request */
+    struct urequest ubuf_mgr_request;
+
+    /** custom I/O context writing to the output, or NULL */
+    AVIOContext *pb;
+    /** pump that generated the buffer being muxed */
+    struct upump **upump_p;
+
     /** list of subs */
     struct uchain subs;
 
@@ -104,6 +140,14 @@ struct upipe_avfsink {
 UPIPE_HELPER_UPIPE(upipe_avfsink, upipe, UPIPE_AVFSINK_SIGNATURE)
 UPIPE_HELPER_UREFCOUNT(upipe_avfsink, urefcount, upipe_avfsink_free)
 UPIPE_HELPER_VOID(upipe_avfsink)
+UPIPE_HELPER_OUTPUT(upipe_avfsink, output, flow_def, output_state,
+                    request_list)
+UPIPE_HELPER_UREF_MGR(upipe_avfsink, uref_mgr, uref_mgr_request, NULL,
+                      upipe_throw_provide_request, NULL)
+UPIPE_HELPER_UBUF_MGR(upipe_avfsink, ubuf_mgr, flow_format, ubuf_mgr_request,
+                      upipe_avfsink_check,
+                      upipe_avfsink_register_output_request,
+                      upipe_avfsink_unregister_output_request)
 
 /** @internal @This is the private context of an output of an avformat source
  * pipe. */
@@ -512,6 +556,11 @@ static struct upipe *upipe_avfsink_alloc(struct upipe_mgr *mgr,
     upipe_avfsink_init_urefcount(upipe);
     upipe_avfsink_init_sub_mgr(upipe);
     upipe_avfsink_init_sub_subs(upipe);
+    upipe_avfsink_init_output(upipe);
+    upipe_avfsink_init_uref_mgr(upipe);
+    upipe_avfsink_init_ubuf_mgr(upipe);
+    upipe_avfsink->pb = NULL;
+    upipe_avfsink->upump_p = NULL;
 
     upipe_avfsink->uri = NULL;
     upipe_avfsink->mime = NULL;
@@ -555,6 +604,153 @@ static struct upipe_avfsink_sub *upipe_avfsink_find_input(struct upipe *upipe)
     return earliest_input;
 }
 
+/** @internal @This receives the ubuf manager for the muxed stream.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_avfsink_check(struct upipe *upipe, struct uref *flow_format)
+{
+    if (flow_format != NULL)
+        upipe_avfsink_store_flow_def(upipe, flow_format);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This is called by libavformat to write the muxed stream to
+ * the output.
+ *
+ * @param opaque description structure of the pipe
+ * @param buf buffer to write
+ * @param size size of the buffer
+ * @return number of octets written, or an avutil error code
+ */
+static int upipe_avfsink_io_write(void *opaque, uint8_t *buf, int size)
+{
+    struct upipe *upipe = opaque;
+    struct upipe_avfsink *upipe_avfsink = upipe_avfsink_from_upipe(upipe);
+
+    struct uref *uref = uref_block_alloc(upipe_avfsink->uref_mgr,
+                                         upipe_avfsink->ubuf_mgr, size);
+    if (unlikely(uref == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return AVERROR(ENOMEM);
+    }
+
+    uint8_t *buffer;
+    int write_size = -1;
+    if (unlikely(!ubase_check(uref_block_write(uref, 0, &write_size,
+                                               &buffer)))) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return AVERROR(ENOMEM);
+    }
+    assert(write_size == size);
+    memcpy(buffer, buf, size);
+    uref_block_unmap(uref, 0);
+
+    upipe_avfsink_output(upipe, uref, upipe_avfsink->upump_p);
+    return size;
+}
+
+/** @internal @This allocates a custom I/O context writing to the output.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_avfsink_io_open(struct upipe *upipe)
+{
+    struct upipe_avfsink *upipe_avfsink = upipe_avfsink_from_upipe(upipe);
+
+    if (unlikely(!upipe_avfsink_demand_uref_mgr(upipe)))
+        return UBASE_ERR_ALLOC;
+    struct uref *flow_def = uref_block_flow_alloc_def(upipe_avfsink->uref_mgr,
+                                                      "");
+    if (unlikely(flow_def == NULL))
+        return UBASE_ERR_ALLOC;
+    if (unlikely(!upipe_avfsink_demand_ubuf_mgr(upipe, flow_def)))
+        return UBASE_ERR_ALLOC;
+
+    uint8_t *buffer = av_malloc(IO_BUFFER_SIZE);
+    if (unlikely(buffer == NULL))
+        return UBASE_ERR_ALLOC;
+    upipe_avfsink->pb = avio_alloc_context(buffer, IO_BUFFER_SIZE, 1, upipe,
+                                           NULL, upipe_avfsink_io_write, NULL);
+    if (unlikely(upipe_avfsink->pb == NULL)) {
+        av_free(buffer);
+        return UBASE_ERR_ALLOC;
+    }
+    /* the output is a stream of blocks */
+    upipe_avfsink->pb->seekable = 0;
+    upipe_avfsink->context->pb = upipe_avfsink->pb;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This flushes and frees the custom I/O context.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_avfsink_io_close(struct upipe *upipe)
+{
+    struct upipe_avfsink *upipe_avfsink = upipe_avfsink_from_upipe(upipe);
+    if (upipe_avfsink->pb == NULL)
+        return;
+    avio_flush(upipe_avfsink->pb);
+    av_freep(&upipe_avfsink->pb->buffer);
+    av_freep(&upipe_avfsink->pb);
+}
+
+/** @internal @This releases a uref wrapped in an AVBufferRef.
+ *
+ * @param opaque pointer to the uref
+ * @param data mapped block data
+ */
+static void upipe_avfsink_buffer_free(void *opaque, uint8_t *data)
+{
+    struct uref *uref = opaque;
+    uref_block_unmap(uref, 0);
+    uref_free(uref);
+}
+
+/** @internal @This fills in an AVPacket with the content of a block uref.
+ * Single-segment blocks are wrapped without copy, and the uref is released
+ * with the packet.
+ *
+ * @param upipe description structure of the pipe
+ * @param avpkt packet to fill in
+ * @param uref uref structure, which belongs to the callee
+ * @param size size of the block
+ * @return an error code
+ */
+static int upipe_avfsink_fill_packet(struct upipe *upipe, AVPacket *avpkt,
+                                     struct uref *uref, size_t size)
+{
+    const uint8_t *buffer;
+    int read_size = -1;
+    if (ubase_check(uref_block_read(uref, 0, &read_size, &buffer))) {
+        if ((size_t)read_size == size) {
+            avpkt->buf = av_buffer_create((uint8_t *)buffer, size,
+                                          upipe_avfsink_buffer_free, uref,
+                                          AV_BUFFER_FLAG_READONLY);
+            if (likely(avpkt->buf != NULL)) {
+                avpkt->data = avpkt->buf->data;
+                avpkt->size = size;
+                return UBASE_ERR_NONE;
+            }
+        }
+        uref_block_unmap(uref, 0);
+    }
+
+    /* segmented block, linearize it */
+    if (unlikely(av_new_packet(avpkt, size) < 0)) {
+        uref_free(uref);
+        return UBASE_ERR_ALLOC;
+    }
+    uref_block_extract(uref, 0, size, avpkt->data);
+    uref_free(uref);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This asks avformat to multiplex some data.
  *
  * @param upipe description structure of the pipe
@@ -572,7 +768,19 @@ static void upipe_avfsink_mux(struct upipe *upipe, struct upump **upump_p)
                 upipe_avfsink->ts_offset = input->next_dts;
             }
             upipe_avfsink->first_dts = input->next_dts;
-            if (!(upipe_avfsink->context->oformat->flags & AVFMT_NOFILE)) {
+            if (upipe_avfsink->output != NULL) {
+                int err = upipe_avfsink_io_open(upipe);
+                if (unlikely(!ubase_check(err))) {
+                    upipe_err(upipe, "couldn't open output");
+                    upipe_throw_fatal(upipe, err);
+                    while (!ulist_empty(&input->urefs)) {
+                        uref_free(uref_from_uchain(ulist_pop(&input->urefs)));
+                    }
+                    upipe_release(upipe_avfsink_sub_to_upipe(input));
+                    return;
+                }
+            } else if (!(upipe_avfsink->context->oformat->flags &
+                         AVFMT_NOFILE)) {
                 AVDictionary *options = NULL;
                 av_dict_copy(&options, upipe_avfsink->options, 0);
                 int error = avio_open2(&upipe_avfsink->context->pb,
@@ -594,6 +802,7 @@ static void upipe_avfsink_mux(struct upipe *upipe, struct upump **upump_p)
 
             AVDictionary *options = NULL;
             av_dict_copy(&options, upipe_avfsink->options, 0);
+            upipe_avfsink->upump_p = upump_p;
             int error = avformat_write_header(upipe_avfsink->context, &options);
             if (unlikely(error < 0)) {
                 upipe_av_strerror(error, buf);
@@ -656,18 +865,12 @@ static void upipe_avfsink_mux(struct upipe *upipe, struct upump **upump_p)
             upipe_release(upipe_avfsink_sub_to_upipe(input));
             continue;
         }
-        avpkt.size = size;
-
-        /* TODO replace with umem */
-        avpkt.data = malloc(avpkt.size);
-        if (unlikely(avpkt.data == NULL)) {
-            uref_free(uref);
+        if (unlikely(!ubase_check(upipe_avfsink_fill_packet(upipe, &avpkt,
+                                                            uref, size)))) {
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             upipe_release(upipe_avfsink_sub_to_upipe(input));
             return;
         }
-        uref_block_extract(uref, 0, avpkt.size, avpkt.data);
-        uref_free(uref);
 
         if (input->next_dts > upipe_avfsink->highest_next_dts) {
             upipe_avfsink->highest_next_dts = input->next_dts;
@@ -675,8 +878,9 @@ static void upipe_avfsink_mux(struct upipe *upipe, struct upump **upump_p)
 
         upipe_release(upipe_avfsink_sub_to_upipe(input));
 
+        upipe_avfsink->upump_p = upump_p;
         int error = av_write_frame(upipe_avfsink->context, &avpkt);
-        free(avpkt.data);
+        av_packet_unref(&avpkt);
         if (unlikely(error < 0)) {
             upipe_av_strerror(error, buf);
             upipe_warn_va(upipe, "write error to %s (%s)", upipe_avfsink->uri, buf);
@@ -867,11 +1071,15 @@ static int upipe_avfsink_set_uri(struct upipe *upipe, const char *uri)
             upipe_notice_va(upipe, "closing URI %s", upipe_avfsink->uri);
         if (upipe_avfsink->opened) {
             upipe_dbg(upipe, "writing trailer");
+            upipe_avfsink->upump_p = NULL;
             av_write_trailer(upipe_avfsink->context);
-            if (!(upipe_avfsink->context->oformat->flags & AVFMT_NOFILE))
+            if (upipe_avfsink->pb == NULL &&
+                !(upipe_avfsink->context->oformat->flags & AVFMT_NOFILE))
                 avio_close(upipe_avfsink->context->pb);
         }
+        upipe_avfsink_io_close(upipe);
         avformat_free_context(upipe_avfsink->context);
+        upipe_avfsink->context = NULL;
     }
     ubase_clean_str(&upipe_avfsink->uri);
 
@@ -915,6 +1123,11 @@ static int upipe_avfsink_control(struct upipe *upipe, int command, va_list args)
         case UPIPE_UNREGISTER_REQUEST:
             return upipe_control_provide_request(upipe, command, args);
 
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_avfsink_control_output(upipe, command, args);
+
         case UPIPE_SET_FLOW_DEF: {
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_avfsink_set_flow_def(upipe, flow_def);
@@ -985,6 +1198,9 @@ static void upipe_avfsink_free(struct upipe *upipe)
 
     av_dict_free(&upipe_avfsink->options);
 
+    upipe_avfsink_clean_ubuf_mgr(upipe);
+    upipe_avfsink_clean_uref_mgr(upipe);
+    upipe_avfsink_clean_output(upipe);
     upipe_avfsink_clean_urefcount(upipe);
     upipe_avfsink_free_void(upipe);
 }
@@ -42,6 +42,8 @@
 #include <upipe/uref_clock.h>
 #include <upipe/uref_dump.h>
 #include <upipe/upump.h>
+#include <upipe/upump_blocker.h>
+#include <upipe/ueventfd.h>
 #include <upipe/ubuf.h>
 #include <upipe/upipe.h>
 #include <upipe/upipe_helper_upipe.h>
@@ -76,14 +78,27 @@
 #include <sys/ioctl.h>
 #include <errno.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include <libavutil/dict.h>
+#include <libavutil/opt.h>
 #include <libavformat/avformat.h>
 
 /** lowest possible timestamp (just an arbitrarily high time) */
 #define AV_CLOCK_MIN UINT32_MAX
 /** offset between DTS and (artificial) clock references */
 #define PCR_OFFSET (UCLOCK_FREQ * 3)
+/** size of the buffer of the custom I/O context */
+#define IO_BUFFER_SIZE 32768
+/** amount of buffered data allowing to read a frame from the custom I/O */
+#define IO_LOW_WATERMARK (1024 * 1024)
+/** amount of buffered data above which the inner source is blocked */
+#define IO_HIGH_WATERMARK (4 * IO_LOW_WATERMARK)
+/** maximum duration analyzed by libavformat in fast start mode, in
+ * AV_TIME_BASE units */
+#define FAST_START_ANALYZE_DURATION (AV_TIME_BASE / 10)
+/** number of packets after which a fast start flow definition is final */
+#define FAST_START_REFINE_PACKETS 64
 
 /** @internal @This is the private context of an avfsrc manager. */
 struct upipe_avfsrc_mgr {
@@ -92,6 +107,8 @@ struct upipe_avfsrc_mgr {
 
     /** pointer to autof manager */
     struct upipe_mgr *autof_mgr;
+    /** pointer to the manager of inner sources, or NULL */
+    struct upipe_mgr *src_mgr;
 
     /** public upipe_mgr structure */
     struct upipe_mgr mgr;
@@ -136,6 +153,8 @@ struct upipe_avfsrc {
     uint64_t timestamp_highest;
     /** last random access point */
     uint64_t systime_rap;
+    /** reading time of the last packet, from the start of the URL */
+    uint64_t time;
 
     /** list of subs */
     struct uchain subs;
@@ -151,9 +170,56 @@ struct upipe_avfsrc {
     AVFormatContext *context;
     /** true if the URL has already been probed by avformat */
     bool probed;
+    /** true if flows are declared from the container metadata only */
+    bool fast_start;
+
+    /** inner source pipe feeding the custom I/O context, or NULL */
+    struct upipe *src;
+    /** probe for the inner source pipe */
+    struct uprobe src_probe;
+    /** custom I/O context, or NULL */
+    AVIOContext *pb;
+    /** mutex protecting the I/O queue */
+    pthread_mutex_t io_mutex;
+    /** signals new data in the I/O queue to the probe thread */
+    pthread_cond_t io_cond;
+    /** urefs received from the inner source */
+    struct uchain io_urefs;
+    /** urefs consumed by libavformat, to be freed in the pipe thread */
+    struct uchain io_done;
+    /** number of octets in the I/O queue */
+    size_t io_size;
+    /** true if the inner source has ended */
+    bool io_eos;
+    /** true if libavformat has read from an empty I/O queue */
+    bool io_underrun;
+    /** list of blockers on the inner source pump */
+    struct uchain io_blockers;
+    /** true if the worker waits for data from the inner source */
+    bool io_waiting;
+    /** probe thread */
+    pthread_t io_thread;
+    /** true if the probe thread has been started and not joined */
+    bool io_thread_running;
+    /** true if the probe thread must give up */
+    bool io_abort;
+    /** true if the probe thread has finished */
+    bool io_probed;
+    /** avformat options for the probe thread */
+    AVDictionary *io_options;
+    /** avformat context opened by the probe thread */
+    AVFormatContext *io_context;
+    /** return code of the probe thread */
+    int io_error;
+    /** signals the pipe thread from the probe thread */
+    struct ueventfd io_event;
+    /** watcher on io_event */
+    struct upump *upump_io;
 
     /** manager to create subs */
     struct upipe_mgr sub_mgr;
+    /** manager to create the pipe receiving data from the inner source */
+    struct upipe_mgr io_mgr;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -171,8 +237,17 @@ UPIPE_HELPER_UCLOCK(upipe_avfsrc, uclock, uclock_request, NULL,
 
 UPIPE_HELPER_UPUMP_MGR(upipe_avfsrc, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_avfsrc, upump, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_avfsrc, upump_io, upump_mgr)
 
 UBASE_FROM_TO(upipe_avfsrc, urefcount, urefcount_real, urefcount_real)
+UBASE_FROM_TO(upipe_avfsrc, upipe_mgr, io_mgr, io_mgr)
+
+/** @hidden */
+static int upipe_avfsrc_catch_src(struct uprobe *uprobe, struct upipe *inner,
+                                  int event, va_list args);
+
+UPIPE_HELPER_UPROBE(upipe_avfsrc, urefcount_real, src_probe,
+                    upipe_avfsrc_catch_src)
 
 /** @hidden */
 static int upipe_avfsrc_sub_check(struct upipe *upipe, struct uref *flow_format);
@@ -196,6 +271,10 @@ struct upipe_avfsrc_sub {
     uint64_t id;
     /** input flow definition */
     struct uref *flow_def;
+    /** true if the next packet follows a seek */
+    bool discontinuity;
+    /** number of packets before the flow definition is final */
+    unsigned int refine;
 
     /** ubuf manager */
     struct ubuf_mgr *ubuf_mgr;
@@ -267,6 +346,8 @@ static struct upipe *upipe_avfsrc_sub_alloc(struct upipe_mgr *mgr,
     upipe_avfsrc_sub_init_sub(upipe);
     upipe_avfsrc_sub->id = UINT64_MAX;
     upipe_avfsrc_sub->flow_def = flow_def;
+    upipe_avfsrc_sub->discontinuity = false;
+    upipe_avfsrc_sub->refine = 0;
 
     uint64_t id;
     const char *def;
@@ -321,6 +402,8 @@ static struct upipe *upipe_avfsrc_sub_alloc(struct upipe_mgr *mgr,
     upipe_avfsrc_sub_store_last_inner(upipe, inner);
 
     upipe_avfsrc->context->streams[id]->discard = AVDISCARD_DEFAULT;
+    if (upipe_avfsrc->fast_start)
+        upipe_avfsrc_sub->refine = FAST_START_REFINE_PACKETS;
     upipe_throw_ready(upipe);
 
     upipe_avfsrc_sub_require_ubuf_mgr(upipe, uref_dup(flow_def));
@@ -452,6 +535,447 @@ static void upipe_avfsrc_init_sub_mgr(struct upipe *upipe)
     sub_mgr->upipe_mgr_control = NULL;
 }
 
+/** @internal @This is the private context of the pipe receiving data from
+ * the inner source of an avformat source pipe. */
+struct upipe_avfsrc_io {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+/** @hidden */
+static void upipe_avfsrc_io_free(struct upipe *upipe);
+
+UPIPE_HELPER_UPIPE(upipe_avfsrc_io, upipe, UPIPE_AVFSRC_IO_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_avfsrc_io, urefcount, upipe_avfsrc_io_free)
+UPIPE_HELPER_VOID(upipe_avfsrc_io)
+
+/** @internal @This frees the urefs consumed by libavformat, and unblocks the
+ * inner source if there is room in the I/O queue.
+ *
+ * @param upipe description structure of the avfsrc pipe
+ */
+static void upipe_avfsrc_io_flush(struct upipe *upipe)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    struct uchain *uchain;
+    pthread_mutex_lock(&upipe_avfsrc->io_mutex);
+    while ((uchain = ulist_pop(&upipe_avfsrc->io_done)) != NULL)
+        uref_free(uref_from_uchain(uchain));
+    bool unblock = upipe_avfsrc->io_size < IO_HIGH_WATERMARK;
+    pthread_mutex_unlock(&upipe_avfsrc->io_mutex);
+
+    if (!unblock)
+        return;
+    struct uchain *uchain_tmp;
+    ulist_delete_foreach (&upipe_avfsrc->io_blockers, uchain, uchain_tmp) {
+        ulist_delete(uchain);
+        upump_blocker_free(upump_blocker_from_uchain(uchain));
+    }
+}
+
+/** @internal @This checks if enough data is buffered to read a frame without
+ * waiting for the inner source.
+ *
+ * @param upipe description structure of the avfsrc pipe
+ * @return true if a frame may be read
+ */
+static bool upipe_avfsrc_io_ready(struct upipe *upipe)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    pthread_mutex_lock(&upipe_avfsrc->io_mutex);
+    bool ready = upipe_avfsrc->io_eos ||
+                 upipe_avfsrc->io_size >= IO_LOW_WATERMARK;
+    pthread_mutex_unlock(&upipe_avfsrc->io_mutex);
+    return ready;
+}
+
+/** @internal @This restarts the worker if it was waiting for data.
+ *
+ * @param upipe description structure of the avfsrc pipe
+ */
+static void upipe_avfsrc_io_wake(struct upipe *upipe)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    if (upipe_avfsrc->io_waiting && upipe_avfsrc->upump != NULL) {
+        upipe_avfsrc->io_waiting = false;
+        upump_start(upipe_avfsrc->upump);
+    }
+}
+
+/** @internal @This signals the end of the inner source.
+ *
+ * @param upipe description structure of the avfsrc pipe
+ */
+static void upipe_avfsrc_io_end(struct upipe *upipe)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    pthread_mutex_lock(&upipe_avfsrc->io_mutex);
+    upipe_avfsrc->io_eos = true;
+    pthread_cond_signal(&upipe_avfsrc->io_cond);
+    pthread_mutex_unlock(&upipe_avfsrc->io_mutex);
+    upipe_avfsrc_io_wake(upipe);
+}
+
+/** @internal @This is called by libavformat to read from the custom I/O
+ * context. It runs either in the probe thread, where it waits for data, or
+ * in the pipe thread, where it never blocks.
+ *
+ * @param opaque pointer to the private structure of the avfsrc pipe
+ * @param buf buffer to fill in
+ * @param size size of the buffer
+ * @return number of octets read, or an avutil error code
+ */
+static int upipe_avfsrc_io_read(void *opaque, uint8_t *buf, int size)
+{
+    struct upipe_avfsrc *upipe_avfsrc = opaque;
+    int done = 0;
+
+    pthread_mutex_lock(&upipe_avfsrc->io_mutex);
+    while (upipe_avfsrc->io_thread_running && !upipe_avfsrc->io_abort &&
+           !upipe_avfsrc->io_eos && ulist_empty(&upipe_avfsrc->io_urefs))
+        pthread_cond_wait(&upipe_avfsrc->io_cond, &upipe_avfsrc->io_mutex);
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&upipe_avfsrc->io_urefs, uchain, uchain_tmp) {
+        if (done >= size)
+            break;
+        struct uref *uref = uref_from_uchain(uchain);
+        size_t uref_size = 0;
+        uref_block_size(uref, &uref_size);
+        int chunk = size - done;
+        if (uref_size < (size_t)chunk)
+            chunk = uref_size;
+        if (unlikely(!ubase_check(uref_block_extract(uref, 0, chunk,
+                                                     buf + done))))
+            chunk = 0;
+        else
+            done += chunk;
+        upipe_avfsrc->io_size -= uref_size;
+        if ((size_t)chunk < uref_size && chunk) {
+            uref_block_resize(uref, chunk, -1);
+            upipe_avfsrc->io_size += uref_size - chunk;
+        } else {
+            ulist_delete(uchain);
+            ulist_add(&upipe_avfsrc->io_done, uchain);
+        }
+    }
+
+    bool signal = upipe_avfsrc->io_thread_running &&
+                  upipe_avfsrc->io_size < IO_HIGH_WATERMARK &&
+                  upipe_avfsrc->io_size + done >= IO_HIGH_WATERMARK;
+    int ret = done;
+    if (!done) {
+        if (upipe_avfsrc->io_abort)
+            ret = AVERROR_EXIT;
+        else if (upipe_avfsrc->io_eos)
+            ret = AVERROR_EOF;
+        else {
+            upipe_avfsrc->io_underrun = true;
+            ret = AVERROR(EAGAIN);
+        }
+    }
+    pthread_mutex_unlock(&upipe_avfsrc->io_mutex);
+
+    if (signal)
+        /* the pipe thread must unblock the inner source */
+        ueventfd_write(&upipe_avfsrc->io_event);
+    return ret;
+}
+
+/** @internal @This is called by libavformat to check if a blocking operation
+ * must be interrupted.
+ *
+ * @param opaque pointer to the private structure of the avfsrc pipe
+ * @return non-zero to interrupt the operation
+ */
+static int upipe_avfsrc_io_interrupt(void *opaque)
+{
+    struct upipe_avfsrc *upipe_avfsrc = opaque;
+    pthread_mutex_lock(&upipe_avfsrc->io_mutex);
+    bool interrupt = upipe_avfsrc->io_abort;
+    pthread_mutex_unlock(&upipe_avfsrc->io_mutex);
+    return interrupt;
+}
+
+/** @internal @This reads the codec parameters of all streams. In fast start
+ * mode, the parameters given by the container header are trusted, and
+ * otherwise only a short duration of media is analyzed.
+ *
+ * @param context avformat context
+ * @param options avformat options
+ * @param fast_start true in fast start mode
+ * @return return code of avformat_find_stream_info()
+ */
+static int upipe_avfsrc_find_stream_info(AVFormatContext *context,
+                                         AVDictionary *options,
+                                         bool fast_start)
+{
+    if (fast_start) {
+        if (context->nb_streams && !(context->ctx_flags & AVFMTCTX_NOHEADER))
+            return 0;
+        av_opt_set_int(context, "analyzeduration",
+                       FAST_START_ANALYZE_DURATION, 0);
+        av_opt_set_int(context, "fpsprobesize", 0, 0);
+    }
+
+    AVDictionary *stream_options[context->nb_streams + 1];
+    for (unsigned i = 0; i < context->nb_streams; i++) {
+        stream_options[i] = NULL;
+        av_dict_copy(&stream_options[i], options, 0);
+    }
+    int error = avformat_find_stream_info(context, stream_options);
+    for (unsigned i = 0; i < context->nb_streams; i++)
+        av_dict_free(&stream_options[i]);
+    return error;
+}
+
+/** @internal @This is the probe thread, opening the URL through the custom
+ * I/O context and probing its streams.
+ *
+ * @param arg pointer to the private structure of the avfsrc pipe
+ * @return NULL
+ */
+static void *upipe_avfsrc_io_thread(void *arg)
+{
+    struct upipe_avfsrc *upipe_avfsrc = arg;
+    AVFormatContext *context = avformat_alloc_context();
+    int error = AVERROR(ENOMEM);
+
+    if (likely(context != NULL)) {
+        context->pb = upipe_avfsrc->pb;
+        context->flags |= AVFMT_FLAG_CUSTOM_IO;
+        context->interrupt_callback.callback = upipe_avfsrc_io_interrupt;
+        context->interrupt_callback.opaque = upipe_avfsrc;
+
+        AVDictionary *options = NULL;
+        av_dict_copy(&options, upipe_avfsrc->io_options, 0);
+        error = avformat_open_input(&context, upipe_avfsrc->url, NULL,
+                                    &options);
+        av_dict_free(&options);
+    }
+
+    if (error >= 0)
+        error = upipe_avfsrc_find_stream_info(context,
+                                              upipe_avfsrc->io_options,
+                                              upipe_avfsrc->fast_start);
+
+    upipe_avfsrc->io_context = context;
+    upipe_avfsrc->io_error = error;
+    pthread_mutex_lock(&upipe_avfsrc->io_mutex);
+    upipe_avfsrc->io_probed = true;
+    pthread_mutex_unlock(&upipe_avfsrc->io_mutex);
+    ueventfd_write(&upipe_avfsrc->io_event);
+    return NULL;
+}
+
+/** @internal @This waits for the end of the probe thread.
+ *
+ * @param upipe description structure of the avfsrc pipe
+ * @param interrupt true if the thread must give up
+ */
+static void upipe_avfsrc_io_join(struct upipe *upipe, bool interrupt)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    if (!upipe_avfsrc->io_thread_running)
+        return;
+
+    if (interrupt) {
+        pthread_mutex_lock(&upipe_avfsrc->io_mutex);
+        upipe_avfsrc->io_abort = true;
+        pthread_cond_signal(&upipe_avfsrc->io_cond);
+        pthread_mutex_unlock(&upipe_avfsrc->io_mutex);
+    }
+    pthread_join(upipe_avfsrc->io_thread, NULL);
+    upipe_avfsrc->io_thread_running = false;
+    upipe_avfsrc->io_abort = false;
+    upipe_avfsrc->io_probed = false;
+    upipe_avfsrc_set_upump_io(upipe, NULL);
+    upipe_avfsrc_io_flush(upipe);
+
+    if (interrupt && upipe_avfsrc->io_context != NULL)
+        avformat_close_input(&upipe_avfsrc->io_context);
+}
+
+/** @internal @This releases the inner source and the custom I/O context.
+ * The avformat context using it must have been closed.
+ *
+ * @param upipe description structure of the avfsrc pipe
+ */
+static void upipe_avfsrc_io_close(struct upipe *upipe)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    assert(!upipe_avfsrc->io_thread_running);
+    upipe_release(upipe_avfsrc->src);
+    upipe_avfsrc->src = NULL;
+    if (upipe_avfsrc->pb != NULL) {
+        av_freep(&upipe_avfsrc->pb->buffer);
+        av_freep(&upipe_avfsrc->pb);
+    }
+
+    struct uchain *uchain;
+    pthread_mutex_lock(&upipe_avfsrc->io_mutex);
+    while ((uchain = ulist_pop(&upipe_avfsrc->io_urefs)) != NULL)
+        uref_free(uref_from_uchain(uchain));
+    upipe_avfsrc->io_size = 0;
+    upipe_avfsrc->io_eos = false;
+    upipe_avfsrc->io_underrun = false;
+    pthread_mutex_unlock(&upipe_avfsrc->io_mutex);
+    upipe_avfsrc_io_flush(upipe);
+    upipe_avfsrc->io_waiting = false;
+}
+
+/** @internal @This is called when the source pump is released by its owner.
+ *
+ * @param blocker description structure of the blocker
+ */
+static void upipe_avfsrc_io_block_cb(struct upump_blocker *blocker)
+{
+    ulist_delete(upump_blocker_to_uchain(blocker));
+    upump_blocker_free(blocker);
+}
+
+/** @internal @This receives data from the inner source.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_avfsrc_io_input(struct upipe *upipe, struct uref *uref,
+                                  struct upump **upump_p)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_io_mgr(upipe->mgr);
+    size_t size;
+    if (unlikely(!ubase_check(uref_block_size(uref, &size)))) {
+        upipe_warn(upipe, "received non-block buffer");
+        uref_free(uref);
+        return;
+    }
+
+    pthread_mutex_lock(&upipe_avfsrc->io_mutex);
+    ulist_add(&upipe_avfsrc->io_urefs, uref_to_uchain(uref));
+    upipe_avfsrc->io_size += size;
+    size = upipe_avfsrc->io_size;
+    pthread_cond_signal(&upipe_avfsrc->io_cond);
+    pthread_mutex_unlock(&upipe_avfsrc->io_mutex);
+
+    struct upipe *avfsrc = upipe_avfsrc_to_upipe(upipe_avfsrc);
+    upipe_avfsrc_io_flush(avfsrc);
+    if (size >= IO_HIGH_WATERMARK && upump_p != NULL && *upump_p != NULL &&
+        upump_blocker_find(&upipe_avfsrc->io_blockers, *upump_p) == NULL) {
+        struct upump_blocker *blocker =
+            upump_blocker_alloc(*upump_p, upipe_avfsrc_io_block_cb, upipe,
+                                upipe->refcount);
+        if (likely(blocker != NULL))
+            ulist_add(&upipe_avfsrc->io_blockers,
+                      upump_blocker_to_uchain(blocker));
+    }
+    if (size >= IO_LOW_WATERMARK)
+        upipe_avfsrc_io_wake(avfsrc);
+}
+
+/** @internal @This processes control commands on the pipe receiving data from
+ * the inner source.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_avfsrc_io_control(struct upipe *upipe,
+                                   int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, request);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return uref_flow_match_def(flow_def, "block.");
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This allocates the pipe receiving data from the inner source.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_avfsrc_io_alloc(struct upipe_mgr *mgr,
+                                           struct uprobe *uprobe,
+                                           uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_avfsrc_io_alloc_void(mgr, uprobe, signature,
+                                                     args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+    upipe_avfsrc_io_init_urefcount(upipe);
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @This frees the pipe receiving data from the inner source.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_avfsrc_io_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    upipe_avfsrc_io_clean_urefcount(upipe);
+    upipe_avfsrc_io_free_void(upipe);
+}
+
+/** @internal @This initializes the manager of the pipe receiving data from
+ * the inner source.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_avfsrc_init_io_mgr(struct upipe *upipe)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    struct upipe_mgr *io_mgr = &upipe_avfsrc->io_mgr;
+    io_mgr->refcount = upipe_avfsrc_to_urefcount_real(upipe_avfsrc);
+    io_mgr->signature = UPIPE_AVFSRC_IO_SIGNATURE;
+    io_mgr->upipe_err_str = NULL;
+    io_mgr->upipe_command_str = NULL;
+    io_mgr->upipe_event_str = NULL;
+    io_mgr->upipe_alloc = upipe_avfsrc_io_alloc;
+    io_mgr->upipe_input = upipe_avfsrc_io_input;
+    io_mgr->upipe_control = upipe_avfsrc_io_control;
+    io_mgr->upipe_mgr_control = NULL;
+}
+
+/** @internal @This catches events thrown by the inner source.
+ *
+ * @param uprobe pointer to the probe in upipe_avfsrc
+ * @param inner pointer to the inner pipe
+ * @param event event triggered by the inner pipe
+ * @param args arguments of the event
+ * @return an error code
+ */
+static int upipe_avfsrc_catch_src(struct uprobe *uprobe, struct upipe *inner,
+                                  int event, va_list args)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_src_probe(uprobe);
+    struct upipe *upipe = upipe_avfsrc_to_upipe(upipe_avfsrc);
+    if (event == UPROBE_SOURCE_END) {
+        upipe_dbg(upipe, "end of inner source");
+        upipe_avfsrc_io_end(upipe);
+        return UBASE_ERR_NONE;
+    }
+    return upipe_throw_proxy(upipe, inner, event, args);
+}
+
 /** @internal @This allocates an avfsrc pipe.
  *
  * @param mgr common management structure
@@ -478,10 +1002,12 @@ static struct upipe *upipe_avfsrc_alloc(struct upipe_mgr *mgr,
     upipe_avfsrc_init_uref_mgr(upipe);
     upipe_avfsrc_init_upump_mgr(upipe);
     upipe_avfsrc_init_upump(upipe);
+    upipe_avfsrc_init_upump_io(upipe);
     upipe_avfsrc_init_uclock(upipe);
     upipe_avfsrc->timestamp_offset = 0;
     upipe_avfsrc->timestamp_highest = AV_CLOCK_MIN;
     upipe_avfsrc->systime_rap = UINT64_MAX;
+    upipe_avfsrc->time = 0;
 
     upipe_avfsrc->url = NULL;
 
@@ -489,7 +1015,35 @@ static struct upipe *upipe_avfsrc_alloc(struct upipe_mgr *mgr,
     upipe_avfsrc->options = NULL;
     upipe_avfsrc->context = NULL;
     upipe_avfsrc->probed = false;
+    upipe_avfsrc->fast_start = false;
+
+    upipe_avfsrc_init_io_mgr(upipe);
+    upipe_avfsrc_init_src_probe(upipe);
+    upipe_avfsrc->src = NULL;
+    upipe_avfsrc->pb = NULL;
+    ulist_init(&upipe_avfsrc->io_urefs);
+    ulist_init(&upipe_avfsrc->io_done);
+    upipe_avfsrc->io_size = 0;
+    upipe_avfsrc->io_eos = false;
+    upipe_avfsrc->io_underrun = false;
+    ulist_init(&upipe_avfsrc->io_blockers);
+    upipe_avfsrc->io_waiting = false;
+    upipe_avfsrc->io_thread_running = false;
+    upipe_avfsrc->io_abort = false;
+    upipe_avfsrc->io_probed = false;
+    upipe_avfsrc->io_options = NULL;
+    upipe_avfsrc->io_context = NULL;
+    upipe_avfsrc->io_error = 0;
+    pthread_mutex_init(&upipe_avfsrc->io_mutex, NULL);
+    pthread_cond_init(&upipe_avfsrc->io_cond, NULL);
+    bool event = ueventfd_init(&upipe_avfsrc->io_event, false);
     upipe_throw_ready(upipe);
+
+    if (unlikely(!event)) {
+        upipe_err(upipe, "unable to allocate event");
+        upipe_release(upipe);
+        return NULL;
+    }
     return upipe;
 }
 
@@ -502,7 +1056,12 @@ static void upipe_avfsrc_abort_av_deal(struct upipe *upipe)
 {
     struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
     if (unlikely(upipe_avfsrc->upump_av_deal != NULL)) {
-        upipe_av_deal_abort(upipe_avfsrc->upump_av_deal);
+        if (upipe_avfsrc->io_thread_running) {
+            /* the probe thread holds the exclusive access */
+            upipe_avfsrc_io_join(upipe, true);
+            upipe_av_deal_yield(upipe_avfsrc->upump_av_deal);
+        } else
+            upipe_av_deal_abort(upipe_avfsrc->upump_av_deal);
         upump_free(upipe_avfsrc->upump_av_deal);
         upipe_avfsrc->upump_av_deal = NULL;
     }
@@ -527,6 +1086,42 @@ static struct upipe_avfsrc_sub *upipe_avfsrc_find_output(struct upipe *upipe,
     return NULL;
 }
 
+/** @hidden */
+static struct uref *upipe_avfsrc_alloc_flow_def(struct upipe *upipe,
+                                                uint64_t id);
+
+/** @internal @This updates the flow definition of an output declared in
+ * fast start mode, if libavformat has found new codec parameters while
+ * reading packets.
+ *
+ * @param upipe description structure of the pipe
+ * @param output output subpipe
+ */
+static void upipe_avfsrc_refine(struct upipe *upipe,
+                                struct upipe_avfsrc_sub *output)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    AVCodecContext *codec = upipe_avfsrc->context->streams[output->id]->codec;
+    output->refine--;
+
+    struct uref *flow_def = upipe_avfsrc_alloc_flow_def(upipe, output->id);
+    if (unlikely(flow_def == NULL))
+        return;
+    struct uref *old_def = codec->opaque;
+    if (old_def != NULL && !udict_cmp(old_def->udict, flow_def->udict)) {
+        uref_free(flow_def);
+        return;
+    }
+
+    upipe_dbg_va(upipe, "refining flow definition of stream %"PRIu64,
+                 output->id);
+    uref_free(old_def);
+    codec->opaque = flow_def;
+    upipe_split_throw_update(upipe);
+    upipe_avfsrc_sub_require_ubuf_mgr(upipe_avfsrc_sub_to_upipe(output),
+                                      uref_dup(flow_def));
+}
+
 /** @internal @This reads data from the source and outputs it.
  * It is called either when the idler triggers (permanent storage mode) or
  * when data is available on the file descriptor (live stream mode).
@@ -539,8 +1134,33 @@ static void upipe_avfsrc_worker(struct upump *upump)
     struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
     AVPacket pkt;
 
+    if (upipe_avfsrc->pb != NULL) {
+        upipe_avfsrc_io_flush(upipe);
+        if (!upipe_avfsrc_io_ready(upipe)) {
+            /* wait for the inner source instead of blocking */
+            upipe_avfsrc->io_waiting = true;
+            upump_stop(upump);
+            return;
+        }
+    }
+
     int error = av_read_frame(upipe_avfsrc->context, &pkt);
     if (unlikely(error < 0)) {
+        if (upipe_avfsrc->pb != NULL) {
+            pthread_mutex_lock(&upipe_avfsrc->io_mutex);
+            bool underrun = upipe_avfsrc->io_underrun &&
+                            !upipe_avfsrc->io_eos;
+            upipe_avfsrc->io_underrun = false;
+            pthread_mutex_unlock(&upipe_avfsrc->io_mutex);
+            if (underrun) {
+                upipe_warn(upipe, "I/O underrun");
+                upipe_avfsrc->pb->eof_reached = 0;
+                upipe_avfsrc->pb->error = 0;
+                upipe_avfsrc->io_waiting = true;
+                upump_stop(upump);
+                return;
+            }
+        }
         upipe_av_strerror(error, buf);
         upipe_err_va(upipe, "read error from %s (%s)", upipe_avfsrc->url, buf);
         upipe_avfsrc_set_upump(upipe, NULL);
@@ -554,6 +1174,8 @@ static void upipe_avfsrc_worker(struct upump *upump)
         av_packet_unref(&pkt);
         return;
     }
+    if (unlikely(output->refine))
+        upipe_avfsrc_refine(upipe, output);
     if (unlikely(output->ubuf_mgr == NULL)) {
         if (unlikely(!upipe_avfsrc_sub_demand_ubuf_mgr(upipe_avfsrc_sub_to_upipe(output), uref_dup(output->flow_def)))) {
             av_packet_unref(&pkt);
@@ -620,6 +1242,18 @@ static void upipe_avfsrc_worker(struct upump *upump)
         /* this is subtly wrong, but whatever */
         upipe_throw_clock_ref(upipe, uref, dts - PCR_OFFSET, 0);
     }
+    int64_t pkt_ts = pkt.pts != (int64_t)AV_NOPTS_VALUE ? pkt.pts : pkt.dts;
+    if (pkt_ts != (int64_t)AV_NOPTS_VALUE) {
+        if (stream->start_time != (int64_t)AV_NOPTS_VALUE)
+            pkt_ts -= stream->start_time;
+        if (pkt_ts >= 0)
+            upipe_avfsrc->time = pkt_ts * stream->time_base.num *
+                                 UCLOCK_FREQ / stream->time_base.den;
+    }
+    if (output->discontinuity) {
+        output->discontinuity = false;
+        uref_flow_set_discontinuity(uref);
+    }
     if (pkt.duration > 0) {
         uint64_t duration = pkt.duration * stream->time_base.num * UCLOCK_FREQ /
                             stream->time_base.den;
@@ -649,6 +1283,7 @@ static bool upipe_avfsrc_start(struct upipe *upipe)
         upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
         return false;
     }
+    upipe_avfsrc->io_waiting = false;
     upipe_avfsrc_set_upump(upipe, upump);
     upump_start(upump);
     return true;
@@ -813,38 +1448,96 @@ static struct uref *alloc_data_def(struct upipe *upipe,
     return NULL;
 }
 
-/** @internal @This probes all flows from the source.
+/** @internal @This returns a flow definition describing the current codec
+ * parameters of a stream.
  *
- * @param upump description structure of the dealer
+ * @param upipe description structure of the pipe
+ * @param id libavformat stream ID
+ * @return pointer to uref control packet, or NULL if the stream is not
+ * supported
  */
-static void upipe_avfsrc_probe(struct upump *upump)
+static struct uref *upipe_avfsrc_alloc_flow_def(struct upipe *upipe,
+                                                uint64_t id)
 {
-    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
-    AVFormatContext *context = upipe_avfsrc->context;
+    AVStream *stream = upipe_avfsrc->context->streams[id];
+    AVCodecContext *codec = stream->codec;
+    struct uref *flow_def;
 
-    if (unlikely(!upipe_av_deal_grab()))
-        return;
+    switch (codec->codec_type) {
+        case AVMEDIA_TYPE_AUDIO:
+            if (codec->codec_id >= AV_CODEC_ID_FIRST_AUDIO &&
+                codec->codec_id < AV_CODEC_ID_ADPCM_IMA_QT)
+                flow_def = alloc_raw_audio_def(upipe,
+                        upipe_avfsrc->uref_mgr, codec);
+            else
+                flow_def = alloc_audio_def(upipe, upipe_avfsrc->uref_mgr,
+                                           codec);
+            break;
+        case AVMEDIA_TYPE_VIDEO:
+            if (codec->codec_id == AV_CODEC_ID_RAWVIDEO)
+                flow_def = alloc_raw_video_def(upipe,
+                        upipe_avfsrc->uref_mgr, codec);
+            else
+                flow_def = alloc_video_def(upipe,
+                        upipe_avfsrc->uref_mgr, upipe_avfsrc->context,
+                        codec, stream);
+            break;
+        case AVMEDIA_TYPE_SUBTITLE:
+            flow_def = alloc_subtitles_def(upipe, upipe_avfsrc->uref_mgr,
+                                           codec);
+            break;
+        default:
+            flow_def = alloc_data_def(upipe, upipe_avfsrc->uref_mgr, codec);
+            break;
+    }
 
-    AVDictionary *options[context->nb_streams];
-    for (unsigned i = 0; i < context->nb_streams; i++) {
-        options[i] = NULL;
-        av_dict_copy(&options[i], upipe_avfsrc->options, 0);
+    if (unlikely(flow_def == NULL)) {
+        upipe_warn_va(upipe, "unsupported track type (%u:%u)",
+                      codec->codec_type, codec->codec_id);
+        return NULL;
     }
-    int error = avformat_find_stream_info(context, options);
+    UBASE_FATAL(upipe, uref_flow_set_id(flow_def, id))
+
+    AVDictionaryEntry *lang = av_dict_get(stream->metadata, "language",
+                                          NULL, 0);
+    if (lang != NULL && lang->value != NULL) {
+        UBASE_FATAL(upipe, uref_flow_set_languages(flow_def, 1))
+        UBASE_FATAL(upipe, uref_flow_set_language(flow_def, lang->value, 0))
+    }
+    if (codec->extradata_size) {
+        UBASE_FATAL(upipe, uref_flow_set_global(flow_def))
+        UBASE_FATAL(upipe, uref_flow_set_headers(flow_def, codec->extradata,
+                                                 codec->extradata_size))
+    }
+    return flow_def;
+}
 
-    upipe_av_deal_yield(upump);
+/** @internal @This declares all flows from the source once it has been
+ * probed, and releases the exclusive access to avcodec_open().
+ *
+ * @param upipe description structure of the pipe
+ * @param error return code of avformat_find_stream_info()
+ */
+static void upipe_avfsrc_probed(struct upipe *upipe, int error)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    AVFormatContext *context = upipe_avfsrc->context;
+
+    upipe_av_deal_yield(upipe_avfsrc->upump_av_deal);
     upump_free(upipe_avfsrc->upump_av_deal);
     upipe_avfsrc->upump_av_deal = NULL;
     upipe_avfsrc->probed = true;
 
-    if (unlikely(error < 0)) {
+    if (unlikely(error < 0 || context == NULL)) {
         upipe_av_strerror(error, buf);
         upipe_err_va(upipe, "can't probe URL %s (%s)", upipe_avfsrc->url, buf);
         if (likely(upipe_avfsrc->url != NULL))
             upipe_notice_va(upipe, "closing URL %s", upipe_avfsrc->url);
-        avformat_close_input(&upipe_avfsrc->context);
+        if (context != NULL)
+            avformat_close_input(&upipe_avfsrc->context);
         upipe_avfsrc->context = NULL;
+        upipe_avfsrc_io_close(upipe);
         ubase_clean_str(&upipe_avfsrc->url);
         return;
     }
@@ -852,63 +1545,94 @@ static void upipe_avfsrc_probe(struct upump *upump)
     for (int i = 0; i < context->nb_streams; i++) {
         AVStream *stream = context->streams[i];
         AVCodecContext *codec = stream->codec;
-        struct uref *flow_def;
 
         // discard all packets from this stream
         stream->discard = AVDISCARD_ALL;
+        codec->opaque = upipe_avfsrc_alloc_flow_def(upipe, i);
+    }
 
-        switch (codec->codec_type) {
-            case AVMEDIA_TYPE_AUDIO:
-                if (codec->codec_id >= AV_CODEC_ID_FIRST_AUDIO &&
-                    codec->codec_id < AV_CODEC_ID_ADPCM_IMA_QT)
-                    flow_def = alloc_raw_audio_def(upipe,
-                            upipe_avfsrc->uref_mgr, codec);
-                else
-                    flow_def = alloc_audio_def(upipe, upipe_avfsrc->uref_mgr,
-                                               codec);
-                break;
-            case AVMEDIA_TYPE_VIDEO:
-                if (codec->codec_id == AV_CODEC_ID_RAWVIDEO)
-                    flow_def = alloc_raw_video_def(upipe,
-                            upipe_avfsrc->uref_mgr, codec);
-                else
-                    flow_def = alloc_video_def(upipe,
-                            upipe_avfsrc->uref_mgr, upipe_avfsrc->context,
-                            codec, stream);
-                break;
-            case AVMEDIA_TYPE_SUBTITLE:
-                flow_def = alloc_subtitles_def(upipe, upipe_avfsrc->uref_mgr,
-                                               codec);
-                break;
-            default:
-                flow_def = alloc_data_def(upipe, upipe_avfsrc->uref_mgr, codec);
-                break;
-        }
+    upipe_split_throw_update(upipe);
+    upipe_avfsrc_start(upipe);
+}
 
-        if (unlikely(flow_def == NULL)) {
-            upipe_warn_va(upipe, "unsupported track type (%u:%u)",
-                          codec->codec_type, codec->codec_id);
-            continue;
-        }
-        UBASE_FATAL(upipe, uref_flow_set_id(flow_def, i))
+/** @internal @This is called when the probe thread signals the pipe thread.
+ *
+ * @param upump description structure of the watcher
+ */
+static void upipe_avfsrc_io_event(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    ueventfd_read(&upipe_avfsrc->io_event);
 
-        AVDictionaryEntry *lang = av_dict_get(stream->metadata, "language",
-                                              NULL, 0);
-        if (lang != NULL && lang->value != NULL) {
-            UBASE_FATAL(upipe, uref_flow_set_languages(flow_def, 1))
-            UBASE_FATAL(upipe, uref_flow_set_language(flow_def, lang->value, 0))
-        }
-        if (codec->extradata_size) {
-            UBASE_FATAL(upipe, uref_flow_set_global(flow_def))
-            UBASE_FATAL(upipe, uref_flow_set_headers(flow_def, codec->extradata,
-                                                     codec->extradata_size))
-        }
+    pthread_mutex_lock(&upipe_avfsrc->io_mutex);
+    bool probed = upipe_avfsrc->io_probed;
+    pthread_mutex_unlock(&upipe_avfsrc->io_mutex);
+    upipe_avfsrc_io_flush(upipe);
+    if (!probed)
+        return;
 
-        codec->opaque = flow_def;
+    upipe_avfsrc_io_join(upipe, false);
+    upipe_avfsrc->context = upipe_avfsrc->io_context;
+    upipe_avfsrc->io_context = NULL;
+    if (likely(upipe_avfsrc->context != NULL))
+        upipe_avfsrc->context->flags |= AVFMT_FLAG_KEEP_SIDE_DATA;
+    upipe_avfsrc_probed(upipe, upipe_avfsrc->io_error);
+}
+
+/** @internal @This starts the probe thread.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_avfsrc_io_start(struct upipe *upipe)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    struct upump *upump = ueventfd_upump_alloc(&upipe_avfsrc->io_event,
+                                               upipe_avfsrc->upump_mgr,
+                                               upipe_avfsrc_io_event, upipe,
+                                               upipe->refcount);
+    if (unlikely(upump == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+        upipe_avfsrc_probed(upipe, AVERROR(ENOMEM));
+        return;
     }
+    upipe_avfsrc_set_upump_io(upipe, upump);
+    upump_start(upump);
 
-    upipe_split_throw_update(upipe);
-    upipe_avfsrc_start(upipe);
+    av_dict_free(&upipe_avfsrc->io_options);
+    av_dict_copy(&upipe_avfsrc->io_options, upipe_avfsrc->options, 0);
+    upipe_avfsrc->io_thread_running = true;
+    if (unlikely(pthread_create(&upipe_avfsrc->io_thread, NULL,
+                                upipe_avfsrc_io_thread, upipe_avfsrc) != 0)) {
+        upipe_err(upipe, "unable to create probe thread");
+        upipe_avfsrc->io_thread_running = false;
+        upipe_avfsrc_set_upump_io(upipe, NULL);
+        upipe_avfsrc_probed(upipe, AVERROR(EAGAIN));
+    }
+}
+
+/** @internal @This probes all flows from the source.
+ *
+ * @param upump description structure of the dealer
+ */
+static void upipe_avfsrc_probe(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    AVFormatContext *context = upipe_avfsrc->context;
+
+    if (unlikely(!upipe_av_deal_grab()))
+        return;
+
+    if (upipe_avfsrc->pb != NULL) {
+        /* the inner source runs in this thread, so reads may not block */
+        upipe_avfsrc_io_start(upipe);
+        return;
+    }
+
+    int error = upipe_avfsrc_find_stream_info(context, upipe_avfsrc->options,
+                                              upipe_avfsrc->fast_start);
+    upipe_avfsrc_probed(upipe, error);
 }
 
 
@@ -1006,6 +1730,57 @@ static int upipe_avfsrc_get_uri(struct upipe *upipe, const char **url_p)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This opens the given URL with an inner source feeding a custom
+ * I/O context.
+ *
+ * @param upipe description structure of the pipe
+ * @param url URL to open
+ * @return an error code
+ */
+static int upipe_avfsrc_io_open(struct upipe *upipe, const char *url)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    struct upipe_avfsrc_mgr *avfsrc_mgr =
+        upipe_avfsrc_mgr_from_upipe_mgr(upipe->mgr);
+
+    struct upipe *io = upipe_void_alloc(&upipe_avfsrc->io_mgr,
+            uprobe_pfx_alloc(uprobe_use(&upipe_avfsrc->src_probe),
+                             UPROBE_LOG_VERBOSE, "io"));
+    if (unlikely(io == NULL))
+        return UBASE_ERR_ALLOC;
+    struct upipe *src = upipe_void_alloc(avfsrc_mgr->src_mgr,
+            uprobe_pfx_alloc(uprobe_use(&upipe_avfsrc->src_probe),
+                             UPROBE_LOG_VERBOSE, "src"));
+    if (unlikely(src == NULL)) {
+        upipe_release(io);
+        return UBASE_ERR_ALLOC;
+    }
+    int err = upipe_set_output(src, io);
+    upipe_release(io);
+    if (ubase_check(err))
+        err = upipe_set_uri(src, url);
+    if (unlikely(!ubase_check(err))) {
+        upipe_err_va(upipe, "can't open URL %s", url);
+        upipe_release(src);
+        return err;
+    }
+
+    uint8_t *buffer = av_malloc(IO_BUFFER_SIZE);
+    AVIOContext *pb = NULL;
+    if (likely(buffer != NULL))
+        pb = avio_alloc_context(buffer, IO_BUFFER_SIZE, 0, upipe_avfsrc,
+                                upipe_avfsrc_io_read, NULL, NULL);
+    if (unlikely(pb == NULL)) {
+        av_free(buffer);
+        upipe_release(src);
+        return UBASE_ERR_ALLOC;
+    }
+    pb->seekable = 0;
+    upipe_avfsrc->src = src;
+    upipe_avfsrc->pb = pb;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This asks to open the given URL.
  *
  * @param upipe description structure of the pipe
@@ -1016,15 +1791,16 @@ static int upipe_avfsrc_set_uri(struct upipe *upipe, const char *url)
 {
     struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
 
+    upipe_avfsrc_abort_av_deal(upipe);
     if (unlikely(upipe_avfsrc->context != NULL)) {
         if (likely(upipe_avfsrc->url != NULL))
             upipe_notice_va(upipe, "closing URL %s", upipe_avfsrc->url);
         avformat_close_input(&upipe_avfsrc->context);
         upipe_avfsrc->context = NULL;
         upipe_avfsrc_set_upump(upipe, NULL);
-        upipe_avfsrc_abort_av_deal(upipe);
         upipe_avfsrc_throw_sub_subs(upipe, UPROBE_SOURCE_END);
     }
+    upipe_avfsrc_io_close(upipe);
     ubase_clean_str(&upipe_avfsrc->url);
 
     if (unlikely(url == NULL))
@@ -1041,19 +1817,26 @@ static int upipe_avfsrc_set_uri(struct upipe *upipe, const char *url)
     struct uref *uref = uref_alloc(upipe_avfsrc->uref_mgr);
     upipe_avfsrc_output(upipe, uref, NULL);
 
-    AVDictionary *options = NULL;
-    av_dict_copy(&options, upipe_avfsrc->options, 0);
-    int error = avformat_open_input(&upipe_avfsrc->context, url, NULL,
-                                    &options);
-    av_dict_free(&options);
-    if (unlikely(error < 0)) {
-        upipe_av_strerror(error, buf);
-        upipe_err_va(upipe, "can't open URL %s (%s)", url, buf);
-        return UBASE_ERR_EXTERNAL;
-    }
+    struct upipe_avfsrc_mgr *avfsrc_mgr =
+        upipe_avfsrc_mgr_from_upipe_mgr(upipe->mgr);
+    if (avfsrc_mgr->src_mgr != NULL) {
+        /* the URL is opened by the probe thread */
+        UBASE_RETURN(upipe_avfsrc_io_open(upipe, url))
+    } else {
+        AVDictionary *options = NULL;
+        av_dict_copy(&options, upipe_avfsrc->options, 0);
+        int error = avformat_open_input(&upipe_avfsrc->context, url, NULL,
+                                        &options);
+        av_dict_free(&options);
+        if (unlikely(error < 0)) {
+            upipe_av_strerror(error, buf);
+            upipe_err_va(upipe, "can't open URL %s (%s)", url, buf);
+            return UBASE_ERR_EXTERNAL;
+        }
 
-    /* http://stackoverflow.com/questions/40991412/ffmpeg-producing-strange-nal-suffixes-for-mpeg-ts-with-h264 */
-    upipe_avfsrc->context->flags |= AVFMT_FLAG_KEEP_SIDE_DATA;
+        /* http://stackoverflow.com/questions/40991412/ffmpeg-producing-strange-nal-suffixes-for-mpeg-ts-with-h264 */
+        upipe_avfsrc->context->flags |= AVFMT_FLAG_KEEP_SIDE_DATA;
+    }
     upipe_avfsrc->timestamp_offset = 0;
     upipe_avfsrc->url = strdup(url);
     upipe_avfsrc->probed = false;
@@ -1073,7 +1856,7 @@ static int _upipe_avfsrc_get_time(struct upipe *upipe, uint64_t *time_p)
     assert(time_p != NULL);
     if (upipe_avfsrc->context != NULL && upipe_avfsrc->context->pb != NULL &&
         upipe_avfsrc->context->pb->seekable & AVIO_SEEKABLE_NORMAL) {
-        *time_p = 0; /* TODO */
+        *time_p = upipe_avfsrc->time;
         return UBASE_ERR_NONE;
     }
     return UBASE_ERR_UNHANDLED;
@@ -1087,8 +1870,63 @@ static int _upipe_avfsrc_get_time(struct upipe *upipe, uint64_t *time_p)
  */
 static int _upipe_avfsrc_set_time(struct upipe *upipe, uint64_t time)
 {
-    //struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
-    return UBASE_ERR_UNHANDLED;
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    AVFormatContext *context = upipe_avfsrc->context;
+    if (context == NULL || context->pb == NULL ||
+        !(context->pb->seekable & AVIO_SEEKABLE_NORMAL))
+        return UBASE_ERR_UNHANDLED;
+
+    /* land on the random access point preceding the wanted time */
+    int64_t timestamp = time / (UCLOCK_FREQ / AV_TIME_BASE);
+    if (context->start_time != (int64_t)AV_NOPTS_VALUE)
+        timestamp += context->start_time;
+    int error = av_seek_frame(context, -1, timestamp, AVSEEK_FLAG_BACKWARD);
+    if (unlikely(error < 0)) {
+        upipe_av_strerror(error, buf);
+        upipe_warn_va(upipe, "unable to seek to %"PRIu64" (%s)", time, buf);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    /* keep the program timestamps increasing past the seek */
+    upipe_avfsrc->timestamp_offset = 0;
+    upipe_avfsrc->systime_rap = UINT64_MAX;
+    upipe_avfsrc->time = time;
+    struct uchain *uchain;
+    ulist_foreach (&upipe_avfsrc->subs, uchain) {
+        struct upipe_avfsrc_sub *output = upipe_avfsrc_sub_from_uchain(uchain);
+        output->discontinuity = true;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the fast start mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param fast_start_p filled in with true in fast start mode
+ * @return an error code
+ */
+static int _upipe_avfsrc_get_fast_start(struct upipe *upipe,
+                                        bool *fast_start_p)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    assert(fast_start_p != NULL);
+    *fast_start_p = upipe_avfsrc->fast_start;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the fast start mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param fast_start true to declare flows from the container metadata
+ * @return an error code
+ */
+static int _upipe_avfsrc_set_fast_start(struct upipe *upipe, bool fast_start)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    if (unlikely(upipe_avfsrc->io_thread_running))
+        return UBASE_ERR_BUSY;
+    upipe_avfsrc->fast_start = fast_start;
+    return UBASE_ERR_NONE;
 }
 
 /** @internal @This processes control commands on an avformat source pipe.
@@ -1151,6 +1989,16 @@ static int _upipe_avfsrc_control(struct upipe *upipe,
             uint64_t time = va_arg(args, uint64_t);
             return _upipe_avfsrc_set_time(upipe, time);
         }
+        case UPIPE_AVFSRC_GET_FAST_START: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AVFSRC_SIGNATURE)
+            bool *fast_start_p = va_arg(args, bool *);
+            return _upipe_avfsrc_get_fast_start(upipe, fast_start_p);
+        }
+        case UPIPE_AVFSRC_SET_FAST_START: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AVFSRC_SIGNATURE)
+            bool fast_start = va_arg(args, int);
+            return _upipe_avfsrc_set_fast_start(upipe, fast_start);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -1215,12 +2063,19 @@ static void upipe_avfsrc_free(struct urefcount *urefcount_real)
 
         avformat_close_input(&upipe_avfsrc->context);
     }
+    upipe_avfsrc_io_close(upipe);
     upipe_throw_dead(upipe);
 
     av_dict_free(&upipe_avfsrc->options);
+    av_dict_free(&upipe_avfsrc->io_options);
     free(upipe_avfsrc->url);
 
+    ueventfd_clean(&upipe_avfsrc->io_event);
+    pthread_cond_destroy(&upipe_avfsrc->io_cond);
+    pthread_mutex_destroy(&upipe_avfsrc->io_mutex);
+    upipe_avfsrc_clean_src_probe(upipe);
     upipe_avfsrc_clean_uclock(upipe);
+    upipe_avfsrc_clean_upump_io(upipe);
     upipe_avfsrc_clean_upump(upipe);
     upipe_avfsrc_clean_upump_mgr(upipe);
     upipe_avfsrc_clean_uref_mgr(upipe);
@@ -1239,6 +2094,10 @@ static void upipe_avfsrc_no_input(struct upipe *upipe)
     struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
     upipe_avfsrc_throw_sub_subs(upipe, UPROBE_SOURCE_END);
     upipe_split_throw_update(upipe);
+    /* the inner source holds the pipe */
+    upipe_release(upipe_avfsrc->src);
+    upipe_avfsrc->src = NULL;
+    upipe_avfsrc_io_end(upipe);
     urefcount_release(upipe_avfsrc_to_urefcount_real(upipe_avfsrc));
 }
 
@@ -1251,6 +2110,7 @@ static void upipe_avfsrc_mgr_free(struct urefcount *urefcount)
     struct upipe_avfsrc_mgr *avfsrc_mgr =
         upipe_avfsrc_mgr_from_urefcount(urefcount);
     upipe_mgr_release(avfsrc_mgr->autof_mgr);
+    upipe_mgr_release(avfsrc_mgr->src_mgr);
 
     urefcount_clean(urefcount);
     free(avfsrc_mgr);
@@ -1288,6 +2148,7 @@ static int upipe_avfsrc_mgr_control(struct upipe_mgr *mgr,
         }
 
         GET_SET_MGR(autof, AUTOF)
+        GET_SET_MGR(src, SRC)
 #undef GET_SET_MGR
 
         default:
@@ -1309,6 +2170,7 @@ struct upipe_mgr *upipe_avfsrc_mgr_alloc(void)
     memset(avfsrc_mgr, 0, sizeof(*avfsrc_mgr));
 
     avfsrc_mgr->autof_mgr = NULL;
+    avfsrc_mgr->src_mgr = NULL;
 
     urefcount_init(upipe_avfsrc_mgr_to_urefcount(avfsrc_mgr),
                    upipe_avfsrc_mgr_free);
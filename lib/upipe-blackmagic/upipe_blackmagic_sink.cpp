@@ -251,6 +251,17 @@ struct upipe_bmd_sink {
 
     uint64_t start_pts;
     uatomic_uint32_t preroll;
+    /** configured number of frames to preroll */
+    unsigned int preroll_frames;
+    /** number of frames prerolled for the current playback */
+    unsigned int preroll_depth;
+
+    /** frames the card displayed late */
+    uatomic_uint32_t late_frames;
+    /** frames the card dropped */
+    uatomic_uint32_t dropped_frames;
+    /** frames repeated because no picture was queued in time */
+    uatomic_uint32_t underruns;
 
     /** vanc/vbi temporary buffer **/
 
@@ -349,7 +360,17 @@ public:
         if (pts == 0) {
             /* preroll has ended, set up our counter */
             pts = ((upipe_bmd_sink_frame*)frame)->pts;
-            pts += PREROLL_FRAMES * upipe_bmd_sink->ticks_per_frame;
+            pts += upipe_bmd_sink->preroll_depth *
+                upipe_bmd_sink->ticks_per_frame;
+        }
+
+        struct upipe *pic = &upipe_bmd_sink->pic_subpipe.upipe;
+        if (result == bmdOutputFrameDisplayedLate) {
+            uatomic_fetch_add(&upipe_bmd_sink->late_frames, 1);
+            upipe_stats_error(pic, 1);
+        } else if (result == bmdOutputFrameDropped) {
+            uatomic_fetch_add(&upipe_bmd_sink->dropped_frames, 1);
+            upipe_stats_error(pic, 1);
         }
 #if 0
         static const char *Result_str[] = {
@@ -858,6 +879,12 @@ static void output_cb(struct upipe *upipe, uint64_t pts)
 
     /* Find a picture */
     struct uref *uref = uqueue_pop(&upipe_bmd_sink_sub->uqueue, struct uref *);
+    upipe_stats_queue(upipe, uqueue_length(&upipe_bmd_sink_sub->uqueue));
+    if (!uref) {
+        /* the last frame is repeated */
+        uatomic_fetch_add(&upipe_bmd_sink->underruns, 1);
+        upipe_stats_error(upipe, 1);
+    }
 
     schedule_frame(upipe, uref, pts);
 
@@ -941,7 +968,8 @@ static bool upipe_bmd_sink_sub_output(struct upipe *upipe, struct uref *uref)
     }
 
     /* next PTS */
-    pts += (PREROLL_FRAMES - uatomic_load(&upipe_bmd_sink->preroll)) *
+    pts += (upipe_bmd_sink->preroll_depth -
+            uatomic_load(&upipe_bmd_sink->preroll)) *
         upipe_bmd_sink->ticks_per_frame;
 
     /* We're done buffering and now prerolling,
@@ -1372,6 +1400,7 @@ static struct upipe *upipe_bmd_sink_alloc(struct upipe_mgr *mgr,
                             &upipe_bmd_sink->sub_mgr, uprobe_subpic, true);
 
     upipe_bmd_sink->audio_buf = (int32_t*)malloc(audio_buf_size);
+    upipe_bmd_sink->preroll_frames = PREROLL_FRAMES;
 
     upipe_bmd_sink->uclock.refcount = upipe->refcount;
     upipe_bmd_sink->uclock.uclock_now = uclock_bmd_sink_now;
@@ -1387,7 +1416,8 @@ static void upipe_bmd_stop(struct upipe *upipe)
 
     upipe_bmd_sink->start_pts = 0;
 
-    uatomic_store(&upipe_bmd_sink->preroll, PREROLL_FRAMES);
+    upipe_bmd_sink->preroll_depth = upipe_bmd_sink->preroll_frames;
+    uatomic_store(&upipe_bmd_sink->preroll, upipe_bmd_sink->preroll_depth);
     upipe_bmd_sink->cb->pts = 0; /* callback is not running anymore */
     __sync_synchronize();
 
@@ -1608,6 +1638,12 @@ static int upipe_bmd_sink_set_option(struct upipe *upipe,
         uatomic_store(&upipe_bmd_sink->cc, strcmp(v, "0"));
     } else if (!strcmp(k, "teletext")) {
         uatomic_store(&upipe_bmd_sink->ttx, strcmp(v, "0"));
+    } else if (!strcmp(k, "preroll")) {
+        /* applied at the next playback start, keep room in the queue */
+        int frames = atoi(v);
+        if (frames < 1 || frames >= UINT8_MAX)
+            return UBASE_ERR_INVALID;
+        upipe_bmd_sink->preroll_frames = frames;
     } else
         return UBASE_ERR_INVALID;
 
@@ -1787,6 +1823,19 @@ static int upipe_bmd_sink_control(struct upipe *upipe, int command, va_list args
             int64_t offset = va_arg(args, int64_t);
             return _upipe_bmd_sink_set_genlock_offset(upipe, offset);
         }
+        case UPIPE_BMD_SINK_GET_FRAME_STATS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_BMD_SINK_SIGNATURE)
+            unsigned int *late_p = va_arg(args, unsigned int *);
+            unsigned int *dropped_p = va_arg(args, unsigned int *);
+            unsigned int *underruns_p = va_arg(args, unsigned int *);
+            if (late_p != NULL)
+                *late_p = uatomic_load(&bmd_sink->late_frames);
+            if (dropped_p != NULL)
+                *dropped_p = uatomic_load(&bmd_sink->dropped_frames);
+            if (underruns_p != NULL)
+                *underruns_p = uatomic_load(&bmd_sink->underruns);
+            return UBASE_ERR_NONE;
+        }
         case UPIPE_SET_OPTION: {
             const char *k = va_arg(args, const char *);
             const char *v = va_arg(args, const char *);
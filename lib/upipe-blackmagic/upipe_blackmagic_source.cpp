@@ -39,6 +39,7 @@
 #include <upipe/uref_clock.h>
 #include <upipe/upump.h>
 #include <upipe/ubuf.h>
+#include <upipe/umem.h>
 #include <upipe/ufifo.h>
 #include <upipe/uqueue.h>
 #include <upipe/upipe.h>
@@ -80,6 +81,8 @@
 #define BMD_CHANNELS 16
 /** blackmagic uri separator */
 #define URI_SEP "://"
+/** alignment of the frame buffers given to the card */
+#define FRAME_BUFFER_ALIGN 64
 
 const static struct {
     const char *name;
@@ -197,6 +200,91 @@ private:
     struct upipe *upipe;
 };
 
+/** @internal @This is the class that allocates the buffers of captured
+ * frames from a umem manager, so that the card writes them directly into
+ * Upipe memory (for instance hugepage pools). */
+class DeckLinkMemoryAllocator : public IDeckLinkMemoryAllocator
+{
+public:
+    DeckLinkMemoryAllocator(struct umem_mgr *_umem_mgr) :
+        umem_mgr(umem_mgr_use(_umem_mgr)) {
+        uatomic_store(&refcount, 1);
+    }
+
+    virtual ~DeckLinkMemoryAllocator(void) {
+        umem_mgr_release(umem_mgr);
+        uatomic_clean(&refcount);
+    }
+
+    virtual ULONG STDMETHODCALLTYPE AddRef(void) {
+        return uatomic_fetch_add(&refcount, 1) + 1;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE Release(void) {
+        uint32_t new_ref = uatomic_fetch_sub(&refcount, 1) - 1;
+        if (new_ref == 0)
+            delete this;
+        return new_ref;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID *ppv) {
+        return E_NOINTERFACE;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE AllocateBuffer(uint32_t bufferSize,
+                                                     void **allocatedBuffer);
+    virtual HRESULT STDMETHODCALLTYPE ReleaseBuffer(void *buffer);
+
+    virtual HRESULT STDMETHODCALLTYPE Commit(void) {
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE Decommit(void) {
+        return S_OK;
+    }
+
+private:
+    uatomic_uint32_t refcount;
+
+    struct umem_mgr *umem_mgr;
+};
+
+/** @internal @This allocates a frame buffer for the card. The umem
+ * structure is stored just before the aligned buffer.
+ *
+ * @param bufferSize requested size of the buffer
+ * @param allocatedBuffer filled in with a pointer to the buffer
+ * @return S_OK, or E_OUTOFMEMORY
+ */
+HRESULT DeckLinkMemoryAllocator::AllocateBuffer(uint32_t bufferSize,
+                                                void **allocatedBuffer)
+{
+    struct umem umem;
+    if (unlikely(!umem_alloc(umem_mgr, &umem, bufferSize +
+                             sizeof(struct umem) + FRAME_BUFFER_ALIGN - 1)))
+        return E_OUTOFMEMORY;
+
+    uintptr_t buffer = (uintptr_t)umem_buffer(&umem) + sizeof(struct umem);
+    buffer = (buffer + FRAME_BUFFER_ALIGN - 1) &
+             ~(uintptr_t)(FRAME_BUFFER_ALIGN - 1);
+    memcpy((struct umem *)buffer - 1, &umem, sizeof(struct umem));
+    *allocatedBuffer = (void *)buffer;
+    return S_OK;
+}
+
+/** @internal @This releases a frame buffer allocated by @ref AllocateBuffer.
+ *
+ * @param buffer pointer to the buffer
+ * @return S_OK
+ */
+HRESULT DeckLinkMemoryAllocator::ReleaseBuffer(void *buffer)
+{
+    struct umem umem;
+    memcpy(&umem, (struct umem *)buffer - 1, sizeof(struct umem));
+    umem_free(&umem);
+    return S_OK;
+}
+
 /** @internal packet type */
 enum upipe_bmd_src_type {
     /** packet for pic subpipe */
@@ -270,6 +358,10 @@ struct upipe_bmd_src {
     IDeckLinkConfiguration *deckLinkConfiguration;
     /** handle to decklink delegate */
     DeckLinkCaptureDelegate *deckLinkCaptureDelegate;
+    /** umem manager for captured frames, or NULL for the driver's */
+    struct umem_mgr *umem_mgr;
+    /** handle to the frame allocator */
+    DeckLinkMemoryAllocator *deckLinkMemoryAllocator;
     /** pixel format */
     BMDPixelFormat pixel_format;
     /** yuv pixel format (UYVY or v210) */
@@ -660,6 +752,8 @@ static struct upipe *_upipe_bmd_src_alloc(struct upipe_mgr *mgr,
     upipe_bmd_src->deckLinkInput = NULL;
     upipe_bmd_src->deckLinkConfiguration = NULL;
     upipe_bmd_src->deckLinkCaptureDelegate = NULL;
+    upipe_bmd_src->umem_mgr = NULL;
+    upipe_bmd_src->deckLinkMemoryAllocator = NULL;
     upipe_bmd_src->progressive = false;
     upipe_bmd_src->timestamp_offset = 0;
     upipe_bmd_src->timestamp_highest = BMD_CLOCK_MIN;
@@ -1185,6 +1279,18 @@ static int upipe_bmd_src_set_uri(struct upipe *upipe, const char *uri)
         upipe_warn(upipe, "automatic input format detection not supported");
     }
 
+    /* allocate frames from our memory */
+    if (upipe_bmd_src->umem_mgr != NULL) {
+        DeckLinkMemoryAllocator *allocator =
+            new DeckLinkMemoryAllocator(upipe_bmd_src->umem_mgr);
+        if (deckLinkInput->SetVideoInputFrameMemoryAllocator(allocator) !=
+                S_OK) {
+            upipe_warn(upipe, "unable to set the frame allocator");
+            allocator->Release();
+        } else
+            upipe_bmd_src->deckLinkMemoryAllocator = allocator;
+    }
+
     /* configure input */
     if (deckLinkInput->EnableVideoInput(displayMode->GetDisplayMode(),
             upipe_bmd_src->pixel_format,
@@ -1227,6 +1333,23 @@ static int upipe_bmd_src_set_uri(struct upipe *upipe, const char *uri)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the umem manager allocating captured frames.
+ *
+ * @param upipe description structure of the pipe
+ * @param umem_mgr umem manager, or NULL to use the driver's allocator
+ * @return an error code
+ */
+static int upipe_bmd_src_set_umem_mgr_real(struct upipe *upipe,
+                                           struct umem_mgr *umem_mgr)
+{
+    struct upipe_bmd_src *upipe_bmd_src = upipe_bmd_src_from_upipe(upipe);
+    if (unlikely(upipe_bmd_src->uri != NULL))
+        return UBASE_ERR_BUSY;
+    umem_mgr_release(upipe_bmd_src->umem_mgr);
+    upipe_bmd_src->umem_mgr = umem_mgr_use(umem_mgr);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a blackmagic source pipe.
  *
  * @param upipe description structure of the pipe
@@ -1280,6 +1403,11 @@ static int _upipe_bmd_src_control(struct upipe *upipe,
                         upipe_bmd_src_from_upipe(upipe)));
             return UBASE_ERR_NONE;
         }
+        case UPIPE_BMD_SRC_SET_UMEM_MGR: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_BMD_SRC_SIGNATURE)
+            struct umem_mgr *umem_mgr = va_arg(args, struct umem_mgr *);
+            return upipe_bmd_src_set_umem_mgr_real(upipe, umem_mgr);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -1336,6 +1464,10 @@ static void upipe_bmd_src_free(struct upipe *upipe)
         upipe_bmd_src->deckLink->Release();
     upipe_bmd_src_work(upipe, NULL);
     uqueue_clean(&upipe_bmd_src->uqueue);
+    /* frames still referenced downstream keep the allocator alive */
+    if (upipe_bmd_src->deckLinkMemoryAllocator)
+        upipe_bmd_src->deckLinkMemoryAllocator->Release();
+    umem_mgr_release(upipe_bmd_src->umem_mgr);
 
     ubuf_mgr_release(upipe_bmd_src->pic_subpipe.ubuf_mgr);
     ubuf_mgr_release(upipe_bmd_src->sound_subpipe.ubuf_mgr);
@@ -45,6 +45,7 @@
 #include <dvbcsa/dvbcsa.h>
 
 #include "common.h"
+#include "upipe_dvbcsa_bs_pool.h"
 
 /** expected input flow format */
 #define EXPECTED_FLOW_DEF "block.mpegts."
@@ -53,6 +54,8 @@
 
 /** @hidden */
 static void upipe_dvbcsa_bs_dec_worker(struct upump *upump);
+/** @hidden */
+static void upipe_dvbcsa_bs_dec_processed(struct upump *upump);
 
 /** @This is the private structure of dvbcsa decryption pipe. */
 struct upipe_dvbcsa_bs_dec {
@@ -76,6 +79,8 @@ struct upipe_dvbcsa_bs_dec {
     struct upump_mgr *upump_mgr;
     /** upump */
     struct upump *upump;
+    /** watcher of the batches processed by the worker threads */
+    struct upump *upump_pool;
     /** list of retained urefs */
     struct uchain urefs;
     /** number of retained urefs */
@@ -86,14 +91,16 @@ struct upipe_dvbcsa_bs_dec {
     struct uchain blockers;
     /** dvbcsa key */
     dvbcsa_bs_key_t *key;
-    /** maximum number of packet per batch */
-    unsigned int batch_size;
-    /** batch items */
-    struct dvbcsa_bs_batch_s *batch;
-    /** mapped urefs */
-    struct uref **mapped;
-    /** current batch item */
-    unsigned current;
+    /** number of worker threads */
+    unsigned int threads;
+    /** pool of batches */
+    struct upipe_dvbcsa_bs_pool *pool;
+    /** batch being gathered, or NULL */
+    struct upipe_dvbcsa_bs_job *job;
+    /** number of packets to gather before submitting the batch */
+    unsigned int target;
+    /** number of urefs held since the last submitted batch */
+    unsigned int nb_held;
     /** common dvbcsa structure */
     struct upipe_dvbcsa_common common;
 };
@@ -117,6 +124,7 @@ UPIPE_HELPER_UCLOCK(upipe_dvbcsa_bs_dec, uclock, uclock_request,
                     upipe_dvbcsa_bs_dec_unregister_output_request);
 UPIPE_HELPER_UPUMP_MGR(upipe_dvbcsa_bs_dec, upump_mgr);
 UPIPE_HELPER_UPUMP(upipe_dvbcsa_bs_dec, upump, upump_mgr);
+UPIPE_HELPER_UPUMP(upipe_dvbcsa_bs_dec, upump_pool, upump_mgr);
 UPIPE_HELPER_INPUT(upipe_dvbcsa_bs_dec, urefs, nb_urefs, max_urefs, blockers,
                    NULL);
 
@@ -133,13 +141,17 @@ static void upipe_dvbcsa_bs_dec_free(struct upipe *upipe)
 
     upipe_throw_dead(upipe);
 
-    for (unsigned i = 0; i < upipe_dvbcsa_bs_dec->current; i++)
-        uref_block_unmap(upipe_dvbcsa_bs_dec->mapped[i], 0);
+    upipe_dvbcsa_bs_dec_clean_upump(upipe);
+    upipe_dvbcsa_bs_dec_clean_upump_pool(upipe);
+    struct upipe_dvbcsa_bs_job *job = upipe_dvbcsa_bs_dec->job;
+    if (job) {
+        for (unsigned i = 0; i < job->count; i++)
+            uref_block_unmap(job->mapped[i], 0);
+        upipe_dvbcsa_bs_pool_put(upipe_dvbcsa_bs_dec->pool, job);
+    }
+    upipe_dvbcsa_bs_pool_free(upipe_dvbcsa_bs_dec->pool);
     dvbcsa_bs_key_free(upipe_dvbcsa_bs_dec->key);
-    free(upipe_dvbcsa_bs_dec->mapped);
-    free(upipe_dvbcsa_bs_dec->batch);
     upipe_dvbcsa_common_clean(common);
-    upipe_dvbcsa_bs_dec_clean_upump(upipe);
     upipe_dvbcsa_bs_dec_clean_upump_mgr(upipe);
     upipe_dvbcsa_bs_dec_clean_uclock(upipe);
     upipe_dvbcsa_bs_dec_clean_input(upipe);
@@ -176,19 +188,20 @@ static struct upipe *upipe_dvbcsa_bs_dec_alloc(struct upipe_mgr *mgr,
     upipe_dvbcsa_bs_dec_init_uclock(upipe);
     upipe_dvbcsa_bs_dec_init_upump_mgr(upipe);
     upipe_dvbcsa_bs_dec_init_upump(upipe);
+    upipe_dvbcsa_bs_dec_init_upump_pool(upipe);
     upipe_dvbcsa_common_init(common);
     upipe_dvbcsa_bs_dec->key = NULL;
-    unsigned bs_size = dvbcsa_bs_batch_size();
-    upipe_dvbcsa_bs_dec->batch_size = bs_size;
-    upipe_dvbcsa_bs_dec->batch = malloc((bs_size + 1) *
-                                        sizeof (struct dvbcsa_bs_batch_s));
-    upipe_dvbcsa_bs_dec->mapped = malloc(bs_size * sizeof (struct uref *));
-    upipe_dvbcsa_bs_dec->current = 0;
+    upipe_dvbcsa_bs_dec->threads = 0;
+    upipe_dvbcsa_bs_dec->pool =
+        upipe_dvbcsa_bs_pool_alloc(dvbcsa_bs_decrypt, dvbcsa_bs_batch_size(),
+                                   0);
+    upipe_dvbcsa_bs_dec->job = NULL;
+    upipe_dvbcsa_bs_dec->target = 0;
+    upipe_dvbcsa_bs_dec->nb_held = 0;
 
     upipe_throw_ready(upipe);
 
-    if (unlikely(!upipe_dvbcsa_bs_dec->batch ||
-                 !upipe_dvbcsa_bs_dec->mapped)) {
+    if (unlikely(!upipe_dvbcsa_bs_dec->pool)) {
         upipe_err(upipe, "allocation failed");
         upipe_release(upipe);
         return NULL;
@@ -218,45 +231,125 @@ static int upipe_dvbcsa_bs_dec_set_flow_def_real(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
-/** @internal @This flushes the retained urefs.
+/** @internal @This holds an uref until the previous packets are processed.
  *
  * @param upipe description structure of the pipe
+ * @param uref uref structure
  */
-static void upipe_dvbcsa_bs_dec_flush(struct upipe *upipe,
-                                      struct upump **upump_p)
+static void upipe_dvbcsa_bs_dec_hold(struct upipe *upipe, struct uref *uref)
 {
     struct upipe_dvbcsa_bs_dec *upipe_dvbcsa_bs_dec =
         upipe_dvbcsa_bs_dec_from_upipe(upipe);
 
-    upipe_dvbcsa_bs_dec_set_upump(upipe, NULL);
+    upipe_dvbcsa_bs_dec_hold_input(upipe, uref);
+    upipe_dvbcsa_bs_dec->nb_held++;
+}
 
-    /* descramble remaining packets */
-    unsigned current = upipe_dvbcsa_bs_dec->current;
-    if (current) {
-        upipe_dvbcsa_bs_dec->current = 0;
-        upipe_dvbcsa_bs_dec->batch[current].data = NULL;
-        upipe_dvbcsa_bs_dec->batch[current].len = 0;
-        uint64_t before = uclock_now(upipe_dvbcsa_bs_dec->uclock);
-        dvbcsa_bs_decrypt(upipe_dvbcsa_bs_dec->key,
-                          upipe_dvbcsa_bs_dec->batch, 184);
-        uint64_t after = uclock_now(upipe_dvbcsa_bs_dec->uclock);
-        if ((after - before) > DVBCSA_LATENCY)
-            upipe_warn_va(upipe, "dvbcsa latency too high %"PRIu64 "ms",
-                          (after - before) / (UCLOCK_FREQ / 1000));
-        for (unsigned i = 0; i < current; i++)
-            uref_block_unmap(upipe_dvbcsa_bs_dec->mapped[i], 0);
+/** @internal @This outputs the retained urefs up to the last packet of a
+ * processed batch.
+ *
+ * @param upipe description structure of the pipe
+ * @param job processed batch
+ * @param upump_p reference to the pump that generated the buffer
+ */
+static void upipe_dvbcsa_bs_dec_output_job(struct upipe *upipe,
+                                           struct upipe_dvbcsa_bs_job *job,
+                                           struct upump **upump_p)
+{
+    struct upipe_dvbcsa_bs_dec *upipe_dvbcsa_bs_dec =
+        upipe_dvbcsa_bs_dec_from_upipe(upipe);
+    struct upipe_dvbcsa_bs_pool *pool = upipe_dvbcsa_bs_dec->pool;
+
+    if (job->duration > DVBCSA_LATENCY)
+        upipe_warn_va(upipe, "dvbcsa latency too high %"PRIu64 "ms",
+                      job->duration / (UCLOCK_FREQ / 1000));
+    for (unsigned i = 0; i < job->count; i++)
+        uref_block_unmap(job->mapped[i], 0);
+    unsigned int nb_urefs = job->nb_urefs;
+    upipe_dvbcsa_bs_pool_put(pool, job);
+
+    /* output the urefs held after the last batch as well */
+    if (!upipe_dvbcsa_bs_pool_pending(pool) && !upipe_dvbcsa_bs_dec->job) {
+        nb_urefs += upipe_dvbcsa_bs_dec->nb_held;
+        upipe_dvbcsa_bs_dec->nb_held = 0;
     }
 
-    /* output */
     struct uref *uref;
-    while ((uref = upipe_dvbcsa_bs_dec_pop_input(upipe)))
+    while (nb_urefs-- && (uref = upipe_dvbcsa_bs_dec_pop_input(upipe)))
         if (unlikely(ubase_check(uref_flow_get_def(uref, NULL))))
             /* handle flow format */
             upipe_dvbcsa_bs_dec_set_flow_def_real(upipe, uref);
         else
             upipe_dvbcsa_bs_dec_output(upipe, uref, upump_p);
 
-    /* no more buffered urefs */
+    /* no more buffered urefs for this batch */
+    upipe_release(upipe);
+}
+
+/** @internal @This outputs the processed batches, in order.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to the pump that generated the buffer
+ * @param wait true to wait for all the pending batches
+ */
+static void upipe_dvbcsa_bs_dec_collect(struct upipe *upipe,
+                                        struct upump **upump_p, bool wait)
+{
+    struct upipe_dvbcsa_bs_dec *upipe_dvbcsa_bs_dec =
+        upipe_dvbcsa_bs_dec_from_upipe(upipe);
+    struct upipe_dvbcsa_bs_job *job;
+
+    upipe_use(upipe);
+    while ((job = upipe_dvbcsa_bs_pool_pop(upipe_dvbcsa_bs_dec->pool, wait)))
+        upipe_dvbcsa_bs_dec_output_job(upipe, job, upump_p);
+    upipe_release(upipe);
+}
+
+/** @internal @This submits the batch being gathered.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to the pump that generated the buffer
+ */
+static void upipe_dvbcsa_bs_dec_submit(struct upipe *upipe,
+                                       struct upump **upump_p)
+{
+    struct upipe_dvbcsa_bs_dec *upipe_dvbcsa_bs_dec =
+        upipe_dvbcsa_bs_dec_from_upipe(upipe);
+    struct upipe_dvbcsa_bs_pool *pool = upipe_dvbcsa_bs_dec->pool;
+    struct upipe_dvbcsa_bs_job *job = upipe_dvbcsa_bs_dec->job;
+
+    upipe_dvbcsa_bs_dec_set_upump(upipe, NULL);
+    if (!job)
+        return;
+
+    upipe_use(upipe);
+    upipe_dvbcsa_bs_dec->job = NULL;
+    job->key = upipe_dvbcsa_bs_dec->key;
+    job->nb_urefs = upipe_dvbcsa_bs_dec->nb_held;
+    upipe_dvbcsa_bs_dec->nb_held = 0;
+    upipe_dvbcsa_bs_pool_submit(pool, job);
+
+    /* limit the number of batches in flight */
+    while (upipe_dvbcsa_bs_pool_pending(pool) >
+           2 * upipe_dvbcsa_bs_pool_threads(pool))
+        upipe_dvbcsa_bs_dec_output_job(upipe,
+            upipe_dvbcsa_bs_pool_pop(pool, true), upump_p);
+
+    upipe_dvbcsa_bs_dec_collect(upipe, upump_p, false);
+    upipe_release(upipe);
+}
+
+/** @internal @This flushes the retained urefs.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to the pump that generated the buffer
+ */
+static void upipe_dvbcsa_bs_dec_flush(struct upipe *upipe,
+                                      struct upump **upump_p)
+{
+    upipe_use(upipe);
+    upipe_dvbcsa_bs_dec_submit(upipe, upump_p);
+    upipe_dvbcsa_bs_dec_collect(upipe, upump_p, true);
     upipe_release(upipe);
 }
 
@@ -267,7 +360,21 @@ static void upipe_dvbcsa_bs_dec_flush(struct upipe *upipe,
 static void upipe_dvbcsa_bs_dec_worker(struct upump *upump)
 {
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
-    return upipe_dvbcsa_bs_dec_flush(upipe, &upump);
+    return upipe_dvbcsa_bs_dec_submit(upipe, &upump);
+}
+
+/** @internal @This is called when worker threads have processed batches.
+ *
+ * @param upump watcher
+ */
+static void upipe_dvbcsa_bs_dec_processed(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_dvbcsa_bs_dec *upipe_dvbcsa_bs_dec =
+        upipe_dvbcsa_bs_dec_from_upipe(upipe);
+
+    upipe_dvbcsa_bs_pool_ack(upipe_dvbcsa_bs_dec->pool);
+    return upipe_dvbcsa_bs_dec_collect(upipe, &upump, false);
 }
 
 /** @internal @This handles the input buffers.
@@ -291,7 +398,7 @@ static void upipe_dvbcsa_bs_dec_input(struct upipe *upipe,
         if (first)
             upipe_dvbcsa_bs_dec_set_flow_def_real(upipe, uref);
         else
-            upipe_dvbcsa_bs_dec_hold_input(upipe, uref);
+            upipe_dvbcsa_bs_dec_hold(upipe, uref);
         return;
     }
 
@@ -323,7 +430,7 @@ static void upipe_dvbcsa_bs_dec_input(struct upipe *upipe,
         if (first)
             upipe_dvbcsa_bs_dec_output(upipe, uref, upump_p);
         else
-            upipe_dvbcsa_bs_dec_hold_input(upipe, uref);
+            upipe_dvbcsa_bs_dec_hold(upipe, uref);
         return;
     }
 
@@ -363,25 +470,41 @@ static void upipe_dvbcsa_bs_dec_input(struct upipe *upipe,
         return;
     }
 
-    unsigned current = upipe_dvbcsa_bs_dec->current;
-    upipe_dvbcsa_bs_dec->batch[current].data = ts + ts_header_size;
-    upipe_dvbcsa_bs_dec->batch[current].len = size - ts_header_size;
-    upipe_dvbcsa_bs_dec->mapped[current] = uref;
-    upipe_dvbcsa_bs_dec->current++;
-    ts_set_scrambling(ts, 0);
-
-    /* hold uref */
-    upipe_dvbcsa_bs_dec_hold_input(upipe, uref);
-    if (unlikely(first)) {
+    struct upipe_dvbcsa_bs_pool *pool = upipe_dvbcsa_bs_dec->pool;
+    struct upipe_dvbcsa_bs_job *job = upipe_dvbcsa_bs_dec->job;
+    if (!job) {
+        job = upipe_dvbcsa_bs_pool_get(pool);
+        if (unlikely(!job)) {
+            uref_block_unmap(uref, 0);
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        upipe_dvbcsa_bs_dec->job = job;
+        upipe_dvbcsa_bs_dec->target =
+            upipe_dvbcsa_bs_pool_target(pool, common->latency);
         /* make sure to send all buffered urefs */
         upipe_use(upipe);
-        upipe_dvbcsa_bs_dec_wait_upump(upipe, common->latency,
-                                       upipe_dvbcsa_bs_dec_worker);
+        upipe_dvbcsa_bs_dec_wait_upump(upipe,
+            upipe_dvbcsa_bs_pool_wait(pool, common->latency),
+            upipe_dvbcsa_bs_dec_worker);
     }
+    upipe_dvbcsa_bs_pool_input(pool, upipe_dvbcsa_bs_dec->uclock ?
+                               uclock_now(upipe_dvbcsa_bs_dec->uclock) :
+                               UINT64_MAX);
+
+    job->batch[job->count].data = ts + ts_header_size;
+    job->batch[job->count].len = size - ts_header_size;
+    job->mapped[job->count] = uref;
+    job->count++;
+    ts_set_scrambling(ts, 0);
 
-    /* descramble if we have enough buffered scrambled TS packets */
-    if (upipe_dvbcsa_bs_dec->current >= upipe_dvbcsa_bs_dec->batch_size)
-        upipe_dvbcsa_bs_dec_flush(upipe, upump_p);
+    /* hold uref */
+    upipe_dvbcsa_bs_dec_hold(upipe, uref);
+
+    /* descramble if we have gathered enough scrambled TS packets */
+    if (job->count >= upipe_dvbcsa_bs_dec->target)
+        upipe_dvbcsa_bs_dec_submit(upipe, upump_p);
 }
 
 /** @internal @This allocates a new pump if needed.
@@ -401,6 +524,20 @@ static int upipe_dvbcsa_bs_dec_check(struct upipe *upipe, struct uref *flow_def)
     if (unlikely(!upipe_dvbcsa_bs_dec->upump_mgr))
         return UBASE_ERR_NONE;
 
+    if (upipe_dvbcsa_bs_pool_threads(upipe_dvbcsa_bs_dec->pool) &&
+        !upipe_dvbcsa_bs_dec->upump_pool) {
+        struct upump *upump =
+            upipe_dvbcsa_bs_pool_upump_alloc(upipe_dvbcsa_bs_dec->pool,
+                                             upipe_dvbcsa_bs_dec->upump_mgr,
+                                             upipe_dvbcsa_bs_dec_processed,
+                                             upipe, upipe->refcount);
+        if (unlikely(!upump)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+            return UBASE_ERR_UPUMP;
+        }
+        upump_start(upump);
+        upipe_dvbcsa_bs_dec_set_upump_pool(upipe, upump);
+    }
     return UBASE_ERR_NONE;
 }
 
@@ -431,6 +568,8 @@ static int upipe_dvbcsa_bs_dec_set_key(struct upipe *upipe, const char *key)
     struct upipe_dvbcsa_bs_dec *upipe_dvbcsa_bs_dec =
         upipe_dvbcsa_bs_dec_from_upipe(upipe);
 
+    /* process the pending packets with the previous key */
+    upipe_dvbcsa_bs_dec_flush(upipe, NULL);
     dvbcsa_bs_key_free(upipe_dvbcsa_bs_dec->key);
     upipe_dvbcsa_bs_dec->key = NULL;
 
@@ -448,6 +587,35 @@ static int upipe_dvbcsa_bs_dec_set_key(struct upipe *upipe, const char *key)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the number of worker threads.
+ *
+ * @param upipe description structure of the pipe
+ * @param threads number of worker threads, or 0
+ * @return an error code
+ */
+static int upipe_dvbcsa_bs_dec_set_threads(struct upipe *upipe,
+                                           unsigned int threads)
+{
+    struct upipe_dvbcsa_bs_dec *upipe_dvbcsa_bs_dec =
+        upipe_dvbcsa_bs_dec_from_upipe(upipe);
+
+    if (threads == upipe_dvbcsa_bs_dec->threads)
+        return UBASE_ERR_NONE;
+
+    struct upipe_dvbcsa_bs_pool *pool =
+        upipe_dvbcsa_bs_pool_alloc(dvbcsa_bs_decrypt, dvbcsa_bs_batch_size(),
+                                   threads);
+    UBASE_ALLOC_RETURN(pool);
+
+    upipe_dvbcsa_bs_dec_flush(upipe, NULL);
+    upipe_dvbcsa_bs_dec_set_upump_pool(upipe, NULL);
+    upipe_dvbcsa_bs_pool_free(upipe_dvbcsa_bs_dec->pool);
+    upipe_dvbcsa_bs_dec->pool = pool;
+    upipe_dvbcsa_bs_dec->threads = threads;
+    upipe_dbg_va(upipe, "using %u worker threads", threads);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This handles the pipe control commands.
  *
  * @param upipe description structure of the pipe
@@ -480,6 +648,11 @@ static int upipe_dvbcsa_bs_dec_control_real(struct upipe *upipe,
             const char *key = va_arg(args, const char *);
             return upipe_dvbcsa_bs_dec_set_key(upipe, key);
         }
+        case UPIPE_DVBCSA_SET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_DVBCSA_COMMON_SIGNATURE);
+            unsigned int threads = va_arg(args, unsigned int);
+            return upipe_dvbcsa_bs_dec_set_threads(upipe, threads);
+        }
         case UPIPE_DVBCSA_ADD_PID:
         case UPIPE_DVBCSA_DEL_PID:
         case UPIPE_DVBCSA_SET_MAX_LATENCY:
@@ -44,6 +44,7 @@
 #include <bitstream/mpeg/ts.h>
 
 #include "common.h"
+#include "upipe_dvbcsa_bs_pool.h"
 
 /** expected input flow format */
 #define EXPECTED_FLOW_DEF "block.mpegts."
@@ -52,6 +53,11 @@
 /** Approximation worst dvbcsa encrypt latency on normal hardware (20ms) */
 #define DVBCSA_LATENCY  (UCLOCK_FREQ / 50)
 
+/** @hidden */
+static void upipe_dvbcsa_bs_enc_worker(struct upump *upump);
+/** @hidden */
+static void upipe_dvbcsa_bs_enc_processed(struct upump *upump);
+
 /** @internal @This is the private structure of dvbcsa encryption pipe. */
 struct upipe_dvbcsa_bs_enc {
     /** public pipe structure */
@@ -82,16 +88,20 @@ struct upipe_dvbcsa_bs_enc {
     struct upump_mgr *upump_mgr;
     /** timer */
     struct upump *upump;
-    /** encryption batch size */
-    unsigned batch_size;
+    /** watcher of the batches processed by the worker threads */
+    struct upump *upump_pool;
     /** encryption key */
     dvbcsa_bs_key_t *key;
-    /** batch list */
-    struct dvbcsa_bs_batch_s *batch;
-    /** batch current item */
-    unsigned current;
-    /** mapped list */
-    struct uref **mapped;
+    /** number of worker threads */
+    unsigned int threads;
+    /** pool of batches */
+    struct upipe_dvbcsa_bs_pool *pool;
+    /** batch being gathered, or NULL */
+    struct upipe_dvbcsa_bs_job *job;
+    /** number of packets to gather before submitting the batch */
+    unsigned int target;
+    /** number of urefs held since the last submitted batch */
+    unsigned int nb_held;
     /** common dvbcsa structure */
     struct upipe_dvbcsa_common common;
 };
@@ -117,6 +127,7 @@ UPIPE_HELPER_UCLOCK(upipe_dvbcsa_bs_enc, uclock, uclock_request,
                     upipe_dvbcsa_bs_enc_unregister_output_request);
 UPIPE_HELPER_UPUMP_MGR(upipe_dvbcsa_bs_enc, upump_mgr);
 UPIPE_HELPER_UPUMP(upipe_dvbcsa_bs_enc, upump, upump_mgr);
+UPIPE_HELPER_UPUMP(upipe_dvbcsa_bs_enc, upump_pool, upump_mgr);
 
 /** @internal @This frees a dvbcsa encryption pipe.
  *
@@ -131,14 +142,19 @@ static void upipe_dvbcsa_bs_enc_free(struct upipe *upipe)
 
     upipe_throw_dead(upipe);
 
-    for (unsigned i = 0; i < upipe_dvbcsa_bs_enc->current; i++)
-        uref_block_unmap(upipe_dvbcsa_bs_enc->mapped[i], 0);
+    upipe_dvbcsa_bs_enc_clean_upump(upipe);
+    upipe_dvbcsa_bs_enc_clean_upump_pool(upipe);
+    struct upipe_dvbcsa_bs_job *job = upipe_dvbcsa_bs_enc->job;
+    if (job) {
+        for (unsigned i = 0; i < job->count; i++)
+            uref_block_unmap(job->mapped[i], 0);
+        upipe_dvbcsa_bs_pool_put(upipe_dvbcsa_bs_enc->pool, job);
+    }
+    upipe_dvbcsa_bs_pool_free(upipe_dvbcsa_bs_enc->pool);
     dvbcsa_bs_key_free(upipe_dvbcsa_bs_enc->key);
-    free(upipe_dvbcsa_bs_enc->mapped);
-    free(upipe_dvbcsa_bs_enc->batch);
     upipe_dvbcsa_common_clean(common);
-    upipe_dvbcsa_bs_enc_clean_upump(upipe);
     upipe_dvbcsa_bs_enc_clean_upump_mgr(upipe);
+    upipe_dvbcsa_bs_enc_clean_uclock(upipe);
     upipe_dvbcsa_bs_enc_clean_output(upipe);
     upipe_dvbcsa_bs_enc_clean_input(upipe);
     upipe_dvbcsa_bs_enc_clean_urefcount(upipe);
@@ -170,21 +186,23 @@ static struct upipe *upipe_dvbcsa_bs_enc_alloc(struct upipe_mgr *mgr,
     upipe_dvbcsa_bs_enc_init_urefcount(upipe);
     upipe_dvbcsa_bs_enc_init_input(upipe);
     upipe_dvbcsa_bs_enc_init_output(upipe);
+    upipe_dvbcsa_bs_enc_init_uclock(upipe);
     upipe_dvbcsa_bs_enc_init_upump_mgr(upipe);
     upipe_dvbcsa_bs_enc_init_upump(upipe);
+    upipe_dvbcsa_bs_enc_init_upump_pool(upipe);
     upipe_dvbcsa_common_init(common);
     upipe_dvbcsa_bs_enc->key = NULL;
-    unsigned bs_size = dvbcsa_bs_batch_size();
-    upipe_dvbcsa_bs_enc->batch_size = bs_size;
-    upipe_dvbcsa_bs_enc->batch = malloc((bs_size + 1) *
-                                        sizeof (struct dvbcsa_bs_batch_s));
-    upipe_dvbcsa_bs_enc->mapped = malloc(bs_size * sizeof (struct uref *));
-    upipe_dvbcsa_bs_enc->current = 0;
+    upipe_dvbcsa_bs_enc->threads = 0;
+    upipe_dvbcsa_bs_enc->pool =
+        upipe_dvbcsa_bs_pool_alloc(dvbcsa_bs_encrypt, dvbcsa_bs_batch_size(),
+                                   0);
+    upipe_dvbcsa_bs_enc->job = NULL;
+    upipe_dvbcsa_bs_enc->target = 0;
+    upipe_dvbcsa_bs_enc->nb_held = 0;
 
     upipe_throw_ready(upipe);
 
-    if (unlikely(!upipe_dvbcsa_bs_enc->batch ||
-                 !upipe_dvbcsa_bs_enc->mapped)) {
+    if (unlikely(!upipe_dvbcsa_bs_enc->pool)) {
         upipe_err(upipe, "allocation failed");
         upipe_release(upipe);
         return NULL;
@@ -213,59 +231,150 @@ static int upipe_dvbcsa_bs_enc_set_flow_def_real(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
-/** @internal @This flushes the retained urefs.
+/** @internal @This holds an uref until the previous packets are processed.
  *
  * @param upipe description structure of the pipe
+ * @param uref uref structure
  */
-static void upipe_dvbcsa_bs_enc_flush(struct upipe *upipe,
-                                      struct upump **upump_p)
+static void upipe_dvbcsa_bs_enc_hold(struct upipe *upipe, struct uref *uref)
 {
     struct upipe_dvbcsa_bs_enc *upipe_dvbcsa_bs_enc =
         upipe_dvbcsa_bs_enc_from_upipe(upipe);
 
-    upipe_dvbcsa_bs_enc_set_upump(upipe, NULL);
+    upipe_dvbcsa_bs_enc_hold_input(upipe, uref);
+    upipe_dvbcsa_bs_enc->nb_held++;
+}
 
-    /* scramble remaining packets */
-    unsigned current = upipe_dvbcsa_bs_enc->current;
-    if (upipe_dvbcsa_bs_enc->current) {
-        upipe_dvbcsa_bs_enc->current = 0;
-        upipe_dvbcsa_bs_enc->batch[current].data = NULL;
-        upipe_dvbcsa_bs_enc->batch[current].len = 0;
-
-        uint64_t before = uclock_now(upipe_dvbcsa_bs_enc->uclock);
-        dvbcsa_bs_encrypt(upipe_dvbcsa_bs_enc->key,
-                          upipe_dvbcsa_bs_enc->batch, 184);
-        uint64_t after = uclock_now(upipe_dvbcsa_bs_enc->uclock);
-        if ((after - before) > DVBCSA_LATENCY)
-            upipe_warn_va(upipe, "dvbcsa latency too high %"PRIu64 "ms",
-                          (after - before) / 1000);
-        for (unsigned i = 0; i < current; i++)
-            uref_block_unmap(upipe_dvbcsa_bs_enc->mapped[i], 0);
+/** @internal @This outputs the retained urefs up to the last packet of a
+ * processed batch.
+ *
+ * @param upipe description structure of the pipe
+ * @param job processed batch
+ * @param upump_p reference to the pump that generated the buffer
+ */
+static void upipe_dvbcsa_bs_enc_output_job(struct upipe *upipe,
+                                           struct upipe_dvbcsa_bs_job *job,
+                                           struct upump **upump_p)
+{
+    struct upipe_dvbcsa_bs_enc *upipe_dvbcsa_bs_enc =
+        upipe_dvbcsa_bs_enc_from_upipe(upipe);
+    struct upipe_dvbcsa_bs_pool *pool = upipe_dvbcsa_bs_enc->pool;
+
+    if (job->duration > DVBCSA_LATENCY)
+        upipe_warn_va(upipe, "dvbcsa latency too high %"PRIu64 "ms",
+                      job->duration / (UCLOCK_FREQ / 1000));
+    for (unsigned i = 0; i < job->count; i++)
+        uref_block_unmap(job->mapped[i], 0);
+    unsigned int nb_urefs = job->nb_urefs;
+    upipe_dvbcsa_bs_pool_put(pool, job);
+
+    /* output the urefs held after the last batch as well */
+    if (!upipe_dvbcsa_bs_pool_pending(pool) && !upipe_dvbcsa_bs_enc->job) {
+        nb_urefs += upipe_dvbcsa_bs_enc->nb_held;
+        upipe_dvbcsa_bs_enc->nb_held = 0;
     }
 
-    /* output */
     struct uref *uref;
-    while ((uref = upipe_dvbcsa_bs_enc_pop_input(upipe))) {
+    while (nb_urefs-- && (uref = upipe_dvbcsa_bs_enc_pop_input(upipe)))
         if (unlikely(ubase_check(uref_flow_get_def(uref, NULL))))
             /* handle flow format */
             upipe_dvbcsa_bs_enc_set_flow_def_real(upipe, uref);
         else
             upipe_dvbcsa_bs_enc_output(upipe, uref, upump_p);
-    }
 
-    /* all buffered urefs has been sent */
+    /* no more buffered urefs for this batch */
+    upipe_release(upipe);
+}
+
+/** @internal @This outputs the processed batches, in order.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to the pump that generated the buffer
+ * @param wait true to wait for all the pending batches
+ */
+static void upipe_dvbcsa_bs_enc_collect(struct upipe *upipe,
+                                        struct upump **upump_p, bool wait)
+{
+    struct upipe_dvbcsa_bs_enc *upipe_dvbcsa_bs_enc =
+        upipe_dvbcsa_bs_enc_from_upipe(upipe);
+    struct upipe_dvbcsa_bs_job *job;
+
+    upipe_use(upipe);
+    while ((job = upipe_dvbcsa_bs_pool_pop(upipe_dvbcsa_bs_enc->pool, wait)))
+        upipe_dvbcsa_bs_enc_output_job(upipe, job, upump_p);
+    upipe_release(upipe);
+}
+
+/** @internal @This submits the batch being gathered.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to the pump that generated the buffer
+ */
+static void upipe_dvbcsa_bs_enc_submit(struct upipe *upipe,
+                                       struct upump **upump_p)
+{
+    struct upipe_dvbcsa_bs_enc *upipe_dvbcsa_bs_enc =
+        upipe_dvbcsa_bs_enc_from_upipe(upipe);
+    struct upipe_dvbcsa_bs_pool *pool = upipe_dvbcsa_bs_enc->pool;
+    struct upipe_dvbcsa_bs_job *job = upipe_dvbcsa_bs_enc->job;
+
+    upipe_dvbcsa_bs_enc_set_upump(upipe, NULL);
+    if (!job)
+        return;
+
+    upipe_use(upipe);
+    upipe_dvbcsa_bs_enc->job = NULL;
+    job->key = upipe_dvbcsa_bs_enc->key;
+    job->nb_urefs = upipe_dvbcsa_bs_enc->nb_held;
+    upipe_dvbcsa_bs_enc->nb_held = 0;
+    upipe_dvbcsa_bs_pool_submit(pool, job);
+
+    /* limit the number of batches in flight */
+    while (upipe_dvbcsa_bs_pool_pending(pool) >
+           2 * upipe_dvbcsa_bs_pool_threads(pool))
+        upipe_dvbcsa_bs_enc_output_job(upipe,
+            upipe_dvbcsa_bs_pool_pop(pool, true), upump_p);
+
+    upipe_dvbcsa_bs_enc_collect(upipe, upump_p, false);
     upipe_release(upipe);
 }
 
-/** @internal @This is called when maximum latency is reached to flush all
- * retained urefs.
+/** @internal @This flushes the retained urefs.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to the pump that generated the buffer
+ */
+static void upipe_dvbcsa_bs_enc_flush(struct upipe *upipe,
+                                      struct upump **upump_p)
+{
+    upipe_use(upipe);
+    upipe_dvbcsa_bs_enc_submit(upipe, upump_p);
+    upipe_dvbcsa_bs_enc_collect(upipe, upump_p, true);
+    upipe_release(upipe);
+}
+
+/** @internal @This is called when the upump triggers.
  *
  * @param upump timer
  */
 static void upipe_dvbcsa_bs_enc_worker(struct upump *upump)
 {
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
-    return upipe_dvbcsa_bs_enc_flush(upipe, &upump);
+    return upipe_dvbcsa_bs_enc_submit(upipe, &upump);
+}
+
+/** @internal @This is called when worker threads have processed batches.
+ *
+ * @param upump watcher
+ */
+static void upipe_dvbcsa_bs_enc_processed(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_dvbcsa_bs_enc *upipe_dvbcsa_bs_enc =
+        upipe_dvbcsa_bs_enc_from_upipe(upipe);
+
+    upipe_dvbcsa_bs_pool_ack(upipe_dvbcsa_bs_enc->pool);
+    return upipe_dvbcsa_bs_enc_collect(upipe, &upump, false);
 }
 
 /** @internal @This handles input buffers.
@@ -290,7 +399,7 @@ static void upipe_dvbcsa_bs_enc_input(struct upipe *upipe,
         if (first)
             upipe_dvbcsa_bs_enc_set_flow_def_real(upipe, uref);
         else
-            upipe_dvbcsa_bs_enc_hold_input(upipe, uref);
+            upipe_dvbcsa_bs_enc_hold(upipe, uref);
         return;
     }
 
@@ -317,7 +426,7 @@ static void upipe_dvbcsa_bs_enc_input(struct upipe *upipe,
         if (first)
             upipe_dvbcsa_bs_enc_output(upipe, uref, upump_p);
         else
-            upipe_dvbcsa_bs_enc_hold_input(upipe, uref);
+            upipe_dvbcsa_bs_enc_hold(upipe, uref);
         return;
     }
 
@@ -363,25 +472,41 @@ static void upipe_dvbcsa_bs_enc_input(struct upipe *upipe,
         return;
     }
 
-    uint8_t current = upipe_dvbcsa_bs_enc->current;
-    ts_set_scrambling(ts, 0x2);
-    upipe_dvbcsa_bs_enc->batch[current].data = ts + ts_header_size;
-    upipe_dvbcsa_bs_enc->batch[current].len = size - ts_header_size;
-    upipe_dvbcsa_bs_enc->mapped[current] = uref;
-    upipe_dvbcsa_bs_enc->current++;
-
-    /* hold uref */
-    upipe_dvbcsa_bs_enc_hold_input(upipe, uref);
-    if (unlikely(first)) {
+    struct upipe_dvbcsa_bs_pool *pool = upipe_dvbcsa_bs_enc->pool;
+    struct upipe_dvbcsa_bs_job *job = upipe_dvbcsa_bs_enc->job;
+    if (!job) {
+        job = upipe_dvbcsa_bs_pool_get(pool);
+        if (unlikely(!job)) {
+            uref_block_unmap(uref, 0);
+            uref_free(uref);
+            UBASE_FATAL(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        upipe_dvbcsa_bs_enc->job = job;
+        upipe_dvbcsa_bs_enc->target =
+            upipe_dvbcsa_bs_pool_target(pool, common->latency);
         /* make sure to send all buffered urefs */
         upipe_use(upipe);
-        upipe_dvbcsa_bs_enc_wait_upump(upipe, common->latency,
-                                       upipe_dvbcsa_bs_enc_worker);
+        upipe_dvbcsa_bs_enc_wait_upump(upipe,
+            upipe_dvbcsa_bs_pool_wait(pool, common->latency),
+            upipe_dvbcsa_bs_enc_worker);
     }
+    upipe_dvbcsa_bs_pool_input(pool, upipe_dvbcsa_bs_enc->uclock ?
+                               uclock_now(upipe_dvbcsa_bs_enc->uclock) :
+                               UINT64_MAX);
+
+    ts_set_scrambling(ts, 0x2);
+    job->batch[job->count].data = ts + ts_header_size;
+    job->batch[job->count].len = size - ts_header_size;
+    job->mapped[job->count] = uref;
+    job->count++;
+
+    /* hold uref */
+    upipe_dvbcsa_bs_enc_hold(upipe, uref);
 
-    /* scramble if we have enough packets */
-    if (upipe_dvbcsa_bs_enc->current >= upipe_dvbcsa_bs_enc->batch_size)
-        upipe_dvbcsa_bs_enc_flush(upipe, upump_p);
+    /* scramble if we have gathered enough packets */
+    if (job->count >= upipe_dvbcsa_bs_enc->target)
+        upipe_dvbcsa_bs_enc_submit(upipe, upump_p);
 }
 
 /** @internal @This allocates a new pump if needed.
@@ -401,6 +526,20 @@ static int upipe_dvbcsa_bs_enc_check(struct upipe *upipe, struct uref *flow_def)
     if (unlikely(!upipe_dvbcsa_bs_enc->upump_mgr))
         return UBASE_ERR_NONE;
 
+    if (upipe_dvbcsa_bs_pool_threads(upipe_dvbcsa_bs_enc->pool) &&
+        !upipe_dvbcsa_bs_enc->upump_pool) {
+        struct upump *upump =
+            upipe_dvbcsa_bs_pool_upump_alloc(upipe_dvbcsa_bs_enc->pool,
+                                             upipe_dvbcsa_bs_enc->upump_mgr,
+                                             upipe_dvbcsa_bs_enc_processed,
+                                             upipe, upipe->refcount);
+        if (unlikely(!upump)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+            return UBASE_ERR_UPUMP;
+        }
+        upump_start(upump);
+        upipe_dvbcsa_bs_enc_set_upump_pool(upipe, upump);
+    }
     return UBASE_ERR_NONE;
 }
 
@@ -432,6 +571,8 @@ static int upipe_dvbcsa_bs_enc_set_key(struct upipe *upipe,
     struct upipe_dvbcsa_bs_enc *upipe_dvbcsa_bs_enc =
         upipe_dvbcsa_bs_enc_from_upipe(upipe);
 
+    /* process the pending packets with the previous key */
+    upipe_dvbcsa_bs_enc_flush(upipe, NULL);
     dvbcsa_bs_key_free(upipe_dvbcsa_bs_enc->key);
     upipe_dvbcsa_bs_enc->key = NULL;
     if (!key)
@@ -449,6 +590,35 @@ static int upipe_dvbcsa_bs_enc_set_key(struct upipe *upipe,
 
 }
 
+/** @internal @This sets the number of worker threads.
+ *
+ * @param upipe description structure of the pipe
+ * @param threads number of worker threads, or 0
+ * @return an error code
+ */
+static int upipe_dvbcsa_bs_enc_set_threads(struct upipe *upipe,
+                                           unsigned int threads)
+{
+    struct upipe_dvbcsa_bs_enc *upipe_dvbcsa_bs_enc =
+        upipe_dvbcsa_bs_enc_from_upipe(upipe);
+
+    if (threads == upipe_dvbcsa_bs_enc->threads)
+        return UBASE_ERR_NONE;
+
+    struct upipe_dvbcsa_bs_pool *pool =
+        upipe_dvbcsa_bs_pool_alloc(dvbcsa_bs_encrypt, dvbcsa_bs_batch_size(),
+                                   threads);
+    UBASE_ALLOC_RETURN(pool);
+
+    upipe_dvbcsa_bs_enc_flush(upipe, NULL);
+    upipe_dvbcsa_bs_enc_set_upump_pool(upipe, NULL);
+    upipe_dvbcsa_bs_pool_free(upipe_dvbcsa_bs_enc->pool);
+    upipe_dvbcsa_bs_enc->pool = pool;
+    upipe_dvbcsa_bs_enc->threads = threads;
+    upipe_dbg_va(upipe, "using %u worker threads", threads);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This handles the dvbcsa encryption pipe control commands.
  *
  * @param upipe description structure of the pipe
@@ -480,6 +650,11 @@ static int upipe_dvbcsa_bs_enc_control_real(struct upipe *upipe,
             const char *key = va_arg(args, const char *);
             return upipe_dvbcsa_bs_enc_set_key(upipe, key);
         }
+        case UPIPE_DVBCSA_SET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_DVBCSA_COMMON_SIGNATURE);
+            unsigned int threads = va_arg(args, unsigned int);
+            return upipe_dvbcsa_bs_enc_set_threads(upipe, threads);
+        }
 
         case UPIPE_DVBCSA_ADD_PID:
         case UPIPE_DVBCSA_DEL_PID:
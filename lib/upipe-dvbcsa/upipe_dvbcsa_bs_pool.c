@@ -0,0 +1,435 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short pool of threads running dvbcsa bitslice batches
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/ulist.h>
+#include <upipe/uclock.h>
+#include <upipe/uclock_std.h>
+#include <upipe/ueventfd.h>
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "upipe_dvbcsa_bs_pool.h"
+
+/** duration of the windows measuring the input rate (100 ms) */
+#define RATE_WINDOW (UCLOCK_FREQ / 10)
+
+/** @This is the private structure of a pool. */
+struct upipe_dvbcsa_bs_pool {
+    /** function processing a batch */
+    upipe_dvbcsa_bs_func func;
+    /** maximum number of packets per batch */
+    unsigned int batch_size;
+    /** clock measuring the processing time */
+    struct uclock *uclock;
+    /** list of submitted batches, in order */
+    struct uchain pending;
+    /** number of submitted batches */
+    unsigned int nb_pending;
+    /** list of unused batches */
+    struct uchain unused;
+    /** start of the current rate window */
+    uint64_t rate_date;
+    /** number of packets in the current rate window */
+    unsigned int rate_count;
+    /** mean interval between two packets, or 0 if unknown */
+    uint64_t interval;
+    /** mean processing time of a batch */
+    uint64_t cost;
+
+    /** number of worker threads */
+    unsigned int nb_threads;
+    /** worker threads */
+    pthread_t *threads;
+    /** mutex protecting the fields below */
+    pthread_mutex_t mutex;
+    /** condition signaled when a batch is queued or processed */
+    pthread_cond_t cond;
+    /** queue of batches waiting for a worker */
+    struct uchain queue;
+    /** true when the workers must exit */
+    bool stop;
+    /** event signaled to the pipe thread when a batch is processed */
+    struct ueventfd event;
+};
+
+/** @internal @This processes a batch.
+ *
+ * @param pool pointer to the pool
+ * @param job pointer to the batch
+ */
+static void upipe_dvbcsa_bs_pool_run(struct upipe_dvbcsa_bs_pool *pool,
+                                     struct upipe_dvbcsa_bs_job *job)
+{
+    uint64_t before = uclock_now(pool->uclock);
+    pool->func(job->key, job->batch, 184);
+    job->duration = uclock_now(pool->uclock) - before;
+}
+
+/** @internal @This is the main loop of a worker thread.
+ *
+ * @param arg pointer to the pool
+ * @return NULL
+ */
+static void *upipe_dvbcsa_bs_pool_worker(void *arg)
+{
+    struct upipe_dvbcsa_bs_pool *pool = arg;
+
+    pthread_mutex_lock(&pool->mutex);
+    for ( ; ; ) {
+        struct uchain *uchain;
+        while (!pool->stop && (uchain = ulist_pop(&pool->queue)) == NULL)
+            pthread_cond_wait(&pool->cond, &pool->mutex);
+        if (pool->stop)
+            break;
+
+        struct upipe_dvbcsa_bs_job *job =
+            upipe_dvbcsa_bs_job_from_uchain_queue(uchain);
+        pthread_mutex_unlock(&pool->mutex);
+        upipe_dvbcsa_bs_pool_run(pool, job);
+        pthread_mutex_lock(&pool->mutex);
+        job->done = true;
+        pthread_cond_broadcast(&pool->cond);
+        ueventfd_write(&pool->event);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+/** @internal @This frees a batch.
+ *
+ * @param job pointer to the batch
+ */
+static void upipe_dvbcsa_bs_job_free(struct upipe_dvbcsa_bs_job *job)
+{
+    free(job->batch);
+    free(job->mapped);
+    free(job);
+}
+
+/** @This allocates a pool.
+ *
+ * @param func function processing a batch
+ * @param batch_size maximum number of packets per batch
+ * @param nb_threads number of worker threads, or 0 to process the batches
+ * when they are submitted
+ * @return pointer to the pool, or NULL in case of error
+ */
+struct upipe_dvbcsa_bs_pool *
+    upipe_dvbcsa_bs_pool_alloc(upipe_dvbcsa_bs_func func,
+                               unsigned int batch_size,
+                               unsigned int nb_threads)
+{
+    struct upipe_dvbcsa_bs_pool *pool = malloc(sizeof (*pool));
+    if (unlikely(!pool))
+        return NULL;
+
+    pool->func = func;
+    pool->batch_size = batch_size;
+    pool->uclock = uclock_std_alloc(0);
+    ulist_init(&pool->pending);
+    pool->nb_pending = 0;
+    ulist_init(&pool->unused);
+    pool->rate_date = UINT64_MAX;
+    pool->rate_count = 0;
+    pool->interval = 0;
+    pool->cost = 0;
+    pool->nb_threads = 0;
+    pool->threads = NULL;
+    ulist_init(&pool->queue);
+    pool->stop = false;
+    if (unlikely(!pool->uclock)) {
+        free(pool);
+        return NULL;
+    }
+    if (!nb_threads)
+        return pool;
+
+    pool->threads = malloc(nb_threads * sizeof (pthread_t));
+    if (unlikely(!pool->threads ||
+                 !ueventfd_init(&pool->event, false))) {
+        free(pool->threads);
+        uclock_release(pool->uclock);
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+    for (unsigned int i = 0; i < nb_threads; i++) {
+        if (unlikely(pthread_create(&pool->threads[i], NULL,
+                                    upipe_dvbcsa_bs_pool_worker, pool))) {
+            upipe_dvbcsa_bs_pool_free(pool);
+            return NULL;
+        }
+        pool->nb_threads++;
+    }
+    return pool;
+}
+
+/** @This stops the worker threads and frees a pool. No batch may be
+ * pending.
+ *
+ * @param pool pointer to the pool
+ */
+void upipe_dvbcsa_bs_pool_free(struct upipe_dvbcsa_bs_pool *pool)
+{
+    if (!pool)
+        return;
+
+    assert(ulist_empty(&pool->pending));
+    if (pool->threads) {
+        pthread_mutex_lock(&pool->mutex);
+        pool->stop = true;
+        pthread_cond_broadcast(&pool->cond);
+        pthread_mutex_unlock(&pool->mutex);
+        for (unsigned int i = 0; i < pool->nb_threads; i++)
+            pthread_join(pool->threads[i], NULL);
+        free(pool->threads);
+        pthread_cond_destroy(&pool->cond);
+        pthread_mutex_destroy(&pool->mutex);
+        ueventfd_clean(&pool->event);
+    }
+
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&pool->unused)))
+        upipe_dvbcsa_bs_job_free(upipe_dvbcsa_bs_job_from_uchain(uchain));
+    uclock_release(pool->uclock);
+    free(pool);
+}
+
+/** @This returns the number of worker threads of a pool.
+ *
+ * @param pool pointer to the pool
+ * @return the number of worker threads
+ */
+unsigned int upipe_dvbcsa_bs_pool_threads(struct upipe_dvbcsa_bs_pool *pool)
+{
+    return pool->nb_threads;
+}
+
+/** @This returns the number of submitted batches not popped yet.
+ *
+ * @param pool pointer to the pool
+ * @return the number of pending batches
+ */
+unsigned int upipe_dvbcsa_bs_pool_pending(struct upipe_dvbcsa_bs_pool *pool)
+{
+    return pool->nb_pending;
+}
+
+/** @This returns an empty batch.
+ *
+ * @param pool pointer to the pool
+ * @return pointer to the batch, or NULL in case of allocation error
+ */
+struct upipe_dvbcsa_bs_job *
+    upipe_dvbcsa_bs_pool_get(struct upipe_dvbcsa_bs_pool *pool)
+{
+    struct upipe_dvbcsa_bs_job *job;
+    struct uchain *uchain = ulist_pop(&pool->unused);
+    if (uchain) {
+        job = upipe_dvbcsa_bs_job_from_uchain(uchain);
+    } else {
+        job = malloc(sizeof (*job));
+        if (unlikely(!job))
+            return NULL;
+        job->batch = malloc((pool->batch_size + 1) *
+                            sizeof (struct dvbcsa_bs_batch_s));
+        job->mapped = malloc(pool->batch_size * sizeof (struct uref *));
+        if (unlikely(!job->batch || !job->mapped)) {
+            upipe_dvbcsa_bs_job_free(job);
+            return NULL;
+        }
+    }
+
+    uchain_init(&job->uchain);
+    uchain_init(&job->uchain_queue);
+    job->key = NULL;
+    job->count = 0;
+    job->nb_urefs = 0;
+    job->duration = 0;
+    job->done = false;
+    return job;
+}
+
+/** @This gives a processed batch back to the pool.
+ *
+ * @param pool pointer to the pool
+ * @param job pointer to the batch
+ */
+void upipe_dvbcsa_bs_pool_put(struct upipe_dvbcsa_bs_pool *pool,
+                              struct upipe_dvbcsa_bs_job *job)
+{
+    ulist_add(&pool->unused, &job->uchain);
+}
+
+/** @This submits a batch.
+ *
+ * @param pool pointer to the pool
+ * @param job pointer to the batch
+ */
+void upipe_dvbcsa_bs_pool_submit(struct upipe_dvbcsa_bs_pool *pool,
+                                 struct upipe_dvbcsa_bs_job *job)
+{
+    job->batch[job->count].data = NULL;
+    job->batch[job->count].len = 0;
+    ulist_add(&pool->pending, &job->uchain);
+    pool->nb_pending++;
+
+    if (!pool->nb_threads) {
+        upipe_dvbcsa_bs_pool_run(pool, job);
+        job->done = true;
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    ulist_add(&pool->queue, &job->uchain_queue);
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+/** @This returns the oldest pending batch if it is processed.
+ *
+ * @param pool pointer to the pool
+ * @param wait true to wait for the oldest pending batch to be processed
+ * @return pointer to the batch, or NULL
+ */
+struct upipe_dvbcsa_bs_job *
+    upipe_dvbcsa_bs_pool_pop(struct upipe_dvbcsa_bs_pool *pool, bool wait)
+{
+    struct uchain *uchain = ulist_peek(&pool->pending);
+    if (!uchain)
+        return NULL;
+
+    struct upipe_dvbcsa_bs_job *job = upipe_dvbcsa_bs_job_from_uchain(uchain);
+    if (pool->nb_threads) {
+        pthread_mutex_lock(&pool->mutex);
+        while (wait && !job->done)
+            pthread_cond_wait(&pool->cond, &pool->mutex);
+        bool done = job->done;
+        pthread_mutex_unlock(&pool->mutex);
+        if (!done)
+            return NULL;
+    }
+
+    ulist_pop(&pool->pending);
+    pool->nb_pending--;
+    pool->cost = (pool->cost * 7 + job->duration) / 8;
+    return job;
+}
+
+/** @This records the arrival of a packet, to estimate the input rate.
+ *
+ * @param pool pointer to the pool
+ * @param date current system date, or UINT64_MAX if unknown
+ */
+void upipe_dvbcsa_bs_pool_input(struct upipe_dvbcsa_bs_pool *pool,
+                                uint64_t date)
+{
+    if (date == UINT64_MAX)
+        return;
+
+    if (pool->rate_date == UINT64_MAX || date < pool->rate_date) {
+        pool->rate_date = date;
+        pool->rate_count = 0;
+    }
+    pool->rate_count++;
+    if (date - pool->rate_date >= RATE_WINDOW) {
+        pool->interval = (date - pool->rate_date) / pool->rate_count;
+        pool->rate_date = date;
+        pool->rate_count = 0;
+    }
+}
+
+/** @This returns the time a batch may spend gathering packets so that its
+ * packets are output within the latency budget, given the measured
+ * processing time.
+ *
+ * @param pool pointer to the pool
+ * @param budget latency budget
+ * @return the time to wait before submitting an incomplete batch
+ */
+uint64_t upipe_dvbcsa_bs_pool_wait(struct upipe_dvbcsa_bs_pool *pool,
+                                   uint64_t budget)
+{
+    return budget > pool->cost ? budget - pool->cost : 0;
+}
+
+/** @This returns the number of packets to gather before submitting a batch.
+ * It is the number of packets expected within the gathering time, given
+ * the input rate, and at most the batch size.
+ *
+ * @param pool pointer to the pool
+ * @param budget latency budget
+ * @return the number of packets
+ */
+unsigned int upipe_dvbcsa_bs_pool_target(struct upipe_dvbcsa_bs_pool *pool,
+                                         uint64_t budget)
+{
+    if (!pool->interval)
+        return pool->batch_size;
+    uint64_t target = upipe_dvbcsa_bs_pool_wait(pool, budget) /
+                      pool->interval;
+    if (target < 1)
+        return 1;
+    if (target > pool->batch_size)
+        return pool->batch_size;
+    return target;
+}
+
+/** @This allocates a watcher triggering when a batch is processed by a
+ * worker thread. The callback must call @ref upipe_dvbcsa_bs_pool_ack.
+ *
+ * @param pool pointer to the pool
+ * @param upump_mgr management structure for this event loop
+ * @param cb function to call when the watcher triggers
+ * @param opaque pointer to the module's internal structure
+ * @param refcount pointer to urefcount structure to increment during callback,
+ * or NULL
+ * @return pointer to allocated watcher, or NULL if there is no worker thread
+ */
+struct upump *upipe_dvbcsa_bs_pool_upump_alloc(
+        struct upipe_dvbcsa_bs_pool *pool, struct upump_mgr *upump_mgr,
+        upump_cb cb, void *opaque, struct urefcount *refcount)
+{
+    if (!pool->nb_threads)
+        return NULL;
+    return ueventfd_upump_alloc(&pool->event, upump_mgr, cb, opaque,
+                                refcount);
+}
+
+/** @This acknowledges the notification of processed batches.
+ *
+ * @param pool pointer to the pool
+ */
+void upipe_dvbcsa_bs_pool_ack(struct upipe_dvbcsa_bs_pool *pool)
+{
+    if (pool->nb_threads)
+        ueventfd_read(&pool->event);
+}
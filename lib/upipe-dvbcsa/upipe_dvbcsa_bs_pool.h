@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short pool of threads running dvbcsa bitslice batches
+ *
+ * Batches are submitted by the pipe thread and processed by any free worker
+ * thread. They are returned to the pipe thread in submission order, so that
+ * the packets are output in the order they were received. Without worker
+ * threads, batches are processed when they are submitted.
+ */
+
+#ifndef _UPIPE_DVBCSA_UPIPE_DVBCSA_BS_POOL_H_
+/** @hidden */
+#define _UPIPE_DVBCSA_UPIPE_DVBCSA_BS_POOL_H_
+
+#include <upipe/ubase.h>
+#include <upipe/upump.h>
+
+#include <dvbcsa/dvbcsa.h>
+
+/** @This is the function processing a batch, dvbcsa_bs_decrypt or
+ * dvbcsa_bs_encrypt. */
+typedef void (*upipe_dvbcsa_bs_func)(const struct dvbcsa_bs_key_s *key,
+                                     const struct dvbcsa_bs_batch_s *pcks,
+                                     unsigned int maxlen);
+
+/** @This is a batch of packets. */
+struct upipe_dvbcsa_bs_job {
+    /** link into the lists of the pool */
+    struct uchain uchain;
+    /** link into the queue of the workers */
+    struct uchain uchain_queue;
+    /** key to use */
+    const dvbcsa_bs_key_t *key;
+    /** batch items, terminated by a NULL item when submitted */
+    struct dvbcsa_bs_batch_s *batch;
+    /** mapped urefs */
+    struct uref **mapped;
+    /** number of packets in the batch */
+    unsigned int count;
+    /** number of held urefs to output when the batch is processed */
+    unsigned int nb_urefs;
+    /** processing time */
+    uint64_t duration;
+    /** true when the batch is processed */
+    bool done;
+};
+
+/** @hidden */
+UBASE_FROM_TO(upipe_dvbcsa_bs_job, uchain, uchain, uchain);
+/** @hidden */
+UBASE_FROM_TO(upipe_dvbcsa_bs_job, uchain, uchain_queue, uchain_queue);
+
+/** @hidden */
+struct upipe_dvbcsa_bs_pool;
+
+/** @This allocates a pool.
+ *
+ * @param func function processing a batch
+ * @param batch_size maximum number of packets per batch
+ * @param nb_threads number of worker threads, or 0 to process the batches
+ * when they are submitted
+ * @return pointer to the pool, or NULL in case of error
+ */
+struct upipe_dvbcsa_bs_pool *
+    upipe_dvbcsa_bs_pool_alloc(upipe_dvbcsa_bs_func func,
+                               unsigned int batch_size,
+                               unsigned int nb_threads);
+
+/** @This stops the worker threads and frees a pool. No batch may be
+ * pending.
+ *
+ * @param pool pointer to the pool
+ */
+void upipe_dvbcsa_bs_pool_free(struct upipe_dvbcsa_bs_pool *pool);
+
+/** @This returns the number of worker threads of a pool.
+ *
+ * @param pool pointer to the pool
+ * @return the number of worker threads
+ */
+unsigned int upipe_dvbcsa_bs_pool_threads(struct upipe_dvbcsa_bs_pool *pool);
+
+/** @This returns the number of submitted batches not popped yet.
+ *
+ * @param pool pointer to the pool
+ * @return the number of pending batches
+ */
+unsigned int upipe_dvbcsa_bs_pool_pending(struct upipe_dvbcsa_bs_pool *pool);
+
+/** @This returns an empty batch.
+ *
+ * @param pool pointer to the pool
+ * @return pointer to the batch, or NULL in case of allocation error
+ */
+struct upipe_dvbcsa_bs_job *
+    upipe_dvbcsa_bs_pool_get(struct upipe_dvbcsa_bs_pool *pool);
+
+/** @This gives a processed batch back to the pool.
+ *
+ * @param pool pointer to the pool
+ * @param job pointer to the batch
+ */
+void upipe_dvbcsa_bs_pool_put(struct upipe_dvbcsa_bs_pool *pool,
+                              struct upipe_dvbcsa_bs_job *job);
+
+/** @This submits a batch.
+ *
+ * @param pool pointer to the pool
+ * @param job pointer to the batch
+ */
+void upipe_dvbcsa_bs_pool_submit(struct upipe_dvbcsa_bs_pool *pool,
+                                 struct upipe_dvbcsa_bs_job *job);
+
+/** @This returns the oldest pending batch if it is processed.
+ *
+ * @param pool pointer to the pool
+ * @param wait true to wait for the oldest pending batch to be processed
+ * @return pointer to the batch, or NULL
+ */
+struct upipe_dvbcsa_bs_job *
+    upipe_dvbcsa_bs_pool_pop(struct upipe_dvbcsa_bs_pool *pool, bool wait);
+
+/** @This records the arrival of a packet, to estimate the input rate.
+ *
+ * @param pool pointer to the pool
+ * @param date current system date, or UINT64_MAX if unknown
+ */
+void upipe_dvbcsa_bs_pool_input(struct upipe_dvbcsa_bs_pool *pool,
+                                uint64_t date);
+
+/** @This returns the time a batch may spend gathering packets so that its
+ * packets are output within the latency budget, given the measured
+ * processing time.
+ *
+ * @param pool pointer to the pool
+ * @param budget latency budget
+ * @return the time to wait before submitting an incomplete batch
+ */
+uint64_t upipe_dvbcsa_bs_pool_wait(struct upipe_dvbcsa_bs_pool *pool,
+                                   uint64_t budget);
+
+/** @This returns the number of packets to gather before submitting a batch.
+ * It is the number of packets expected within the gathering time, given
+ * the input rate, and at most the batch size.
+ *
+ * @param pool pointer to the pool
+ * @param budget latency budget
+ * @return the number of packets
+ */
+unsigned int upipe_dvbcsa_bs_pool_target(struct upipe_dvbcsa_bs_pool *pool,
+                                         uint64_t budget);
+
+/** @This allocates a watcher triggering when a batch is processed by a
+ * worker thread. The callback must call @ref upipe_dvbcsa_bs_pool_ack.
+ *
+ * @param pool pointer to the pool
+ * @param upump_mgr management structure for this event loop
+ * @param cb function to call when the watcher triggers
+ * @param opaque pointer to the module's internal structure
+ * @param refcount pointer to urefcount structure to increment during callback,
+ * or NULL
+ * @return pointer to allocated watcher, or NULL if there is no worker thread
+ */
+struct upump *upipe_dvbcsa_bs_pool_upump_alloc(
+        struct upipe_dvbcsa_bs_pool *pool, struct upump_mgr *upump_mgr,
+        upump_cb cb, void *opaque, struct urefcount *refcount);
+
+/** @This acknowledges the notification of processed batches.
+ *
+ * @param pool pointer to the pool
+ */
+void upipe_dvbcsa_bs_pool_ack(struct upipe_dvbcsa_bs_pool *pool);
+
+#endif
@@ -64,6 +64,13 @@
 #include <fcntl.h>
 #include <sys/poll.h>
 
+/** default number of driver buffers */
+#define TX_BUFFERS      500
+/** default size of a driver buffer, 6 timestamped packets */
+#define TX_BUFSIZE      (6 * (188 + 8))
+/** interval between two polls of the driver status */
+#define STATS_INTERVAL  UCLOCK_FREQ
+
 /** @hidden */
 static bool upipe_dveo_asi_sink_output(struct upipe *upipe, struct uref *uref,
                                struct upump **upump_p);
@@ -83,6 +90,13 @@ struct upipe_dveo_asi_sink {
 
     /** card index */
     int card_idx;
+    /** number of driver buffers */
+    unsigned int buffers;
+    /** size of a driver buffer */
+    unsigned int bufsize;
+
+    /** date of the last poll of the driver status */
+    uint64_t stats_date;
 
     /** temporary uref storage */
     struct uchain urefs;
@@ -201,6 +215,9 @@ static struct upipe *upipe_dveo_asi_sink_alloc(struct upipe_mgr *mgr,
     upipe_dveo_asi_sink_init_input(upipe);
     upipe_dveo_asi_sink->fd = -1;
     upipe_dveo_asi_sink->card_idx = 0;
+    upipe_dveo_asi_sink->buffers = TX_BUFFERS;
+    upipe_dveo_asi_sink->bufsize = TX_BUFSIZE;
+    upipe_dveo_asi_sink->stats_date = 0;
     upipe_dveo_asi_sink->first_timestamp = true;
     upipe_dveo_asi_sink->uclock.refcount = &upipe_dveo_asi_sink->urefcount;
     upipe_dveo_asi_sink->uclock.uclock_now = upipe_dveo_asi_sink_now;
@@ -440,7 +457,12 @@ static bool upipe_dveo_asi_sink_output(struct upipe *upipe, struct uref *uref,
     if (reset_first_timestamp)
         upipe_dveo_asi_sink->first_timestamp = true;
 
-    upipe_dveo_asi_sink_stats(upipe);
+    /* the status takes several ioctls, do not poll it for every packet */
+    if (cr_sys < upipe_dveo_asi_sink->stats_date ||
+        cr_sys >= upipe_dveo_asi_sink->stats_date + STATS_INTERVAL) {
+        upipe_dveo_asi_sink->stats_date = cr_sys;
+        upipe_dveo_asi_sink_stats(upipe);
+    }
 
     return true;
 }
@@ -564,14 +586,14 @@ static int upipe_dveo_asi_sink_open(struct upipe *upipe)
     }
 
     snprintf(sys, sizeof(sys), sys_fmt, upipe_dveo_asi_sink->card_idx, "bufsize");
-    snprintf(buf, sizeof(buf), "%u\n", 6*(188+8)); /* minimum is 1024 */
+    snprintf(buf, sizeof(buf), "%u\n", upipe_dveo_asi_sink->bufsize);
     if (util_write(sys, buf, sizeof(buf)) < 0) {
         upipe_err_va(upipe, "Couldn't set buffer size (%m)");
         return UBASE_ERR_EXTERNAL;
     }
 
     snprintf(sys, sizeof(sys), sys_fmt, upipe_dveo_asi_sink->card_idx, "buffers");
-    snprintf(buf, sizeof(buf), "%u\n", 500);
+    snprintf(buf, sizeof(buf), "%u\n", upipe_dveo_asi_sink->buffers);
     if (util_write(sys, buf, sizeof(buf)) < 0) {
         upipe_err_va(upipe, "Couldn't set # of buffers (%m)");
         return UBASE_ERR_EXTERNAL;
@@ -672,11 +694,22 @@ static int upipe_dveo_asi_sink_set_option(struct upipe *upipe,
     if (k == NULL || v == NULL)
         return UBASE_ERR_INVALID;
 
+    unsigned int value = strtoul(v, NULL, 10);
+    if (!strcmp(k, "buffers") && value < ASI_TX_BUFFERS_MIN)
+        return UBASE_ERR_INVALID;
+    /* the driver wants multiples of 8 */
+    if (!strcmp(k, "bufsize") && (value < ASI_TX_BUFSIZE_MIN || value % 8))
+        return UBASE_ERR_INVALID;
+
     if (unlikely(upipe_dveo_asi_sink->fd != -1))
         upipe_dveo_asi_sink_close(upipe);
 
     if (!strcmp(k, "card-idx"))
         upipe_dveo_asi_sink->card_idx = atoi(v);
+    else if (!strcmp(k, "buffers"))
+        upipe_dveo_asi_sink->buffers = value;
+    else if (!strcmp(k, "bufsize"))
+        upipe_dveo_asi_sink->bufsize = value;
 
     return upipe_dveo_asi_sink_open(upipe);
 
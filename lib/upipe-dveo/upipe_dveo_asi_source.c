@@ -50,6 +50,8 @@
 #include <upipe/upipe_helper_output_size.h>
 #include <upipe-dveo/upipe_dveo_asi_source.h>
 
+#include "asi_ioctl.h"
+
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -126,6 +128,10 @@ struct upipe_dveo_asi_src {
 
     /** card index **/
     int card_idx;
+    /** number of driver buffers */
+    unsigned int buffers;
+    /** size of a driver buffer, and of each read */
+    unsigned int bufsize;
 
     /** file descriptor */
     int fd;
@@ -206,6 +212,8 @@ static struct upipe *upipe_dveo_asi_src_alloc(struct upipe_mgr *mgr,
     upipe_dveo_asi_src_init_output_size(upipe, RX_DEFAULT_SIZE);
     upipe_dveo_asi_src->fd = -1;
     upipe_dveo_asi_src->card_idx = 0;
+    upipe_dveo_asi_src->buffers = BUFFERS;
+    upipe_dveo_asi_src->bufsize = CAPTURE_DEFAULT_SIZE;
     upipe_dveo_asi_src->last_ts = -1;
     upipe_throw_ready(upipe);
 
@@ -226,9 +234,10 @@ static void upipe_dveo_asi_src_worker(struct upump *upump)
     if (upipe_dveo_asi_src->uclock != NULL)
         systime = uclock_now(upipe_dveo_asi_src->uclock);
 
+    unsigned int bufsize = upipe_dveo_asi_src->bufsize;
     struct uref *uref = uref_block_alloc(upipe_dveo_asi_src->uref_mgr,
                                          upipe_dveo_asi_src->ubuf_mgr,
-                                         CAPTURE_DEFAULT_SIZE);
+                                         bufsize);
     if (unlikely(uref == NULL)) {
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return;
@@ -242,7 +251,7 @@ static void upipe_dveo_asi_src_worker(struct upump *upump)
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return;
     }
-    ssize_t ret = read(upipe_dveo_asi_src->fd, buffer, CAPTURE_DEFAULT_SIZE);
+    ssize_t ret = read(upipe_dveo_asi_src->fd, buffer, bufsize);
     uref_block_unmap(uref, 0);
 
     if (unlikely(ret == -1)) {
@@ -267,7 +276,7 @@ static void upipe_dveo_asi_src_worker(struct upump *upump)
         return;
     }
 
-    if (unlikely(ret != CAPTURE_DEFAULT_SIZE))
+    if (unlikely(ret != bufsize))
         uref_block_resize(uref, 0, ret);
 
     /* Latter condition can happen if buffer contains data from before
@@ -334,7 +343,7 @@ static int upipe_dveo_asi_src_check(struct upipe *upipe, struct uref *flow_forma
     if (upipe_dveo_asi_src->ubuf_mgr == NULL) {
         struct uref *flow_format =
             uref_block_flow_alloc_def(upipe_dveo_asi_src->uref_mgr, NULL);
-        uref_block_flow_set_size(flow_format, CAPTURE_DEFAULT_SIZE);
+        uref_block_flow_set_size(flow_format, upipe_dveo_asi_src->bufsize);
         if (unlikely(flow_format == NULL)) {
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             return UBASE_ERR_ALLOC;
@@ -388,14 +397,14 @@ static int upipe_dveo_asi_src_open(struct upipe *upipe)
     granularity = atoi(buf);
 
     snprintf(sys, sizeof(sys), sys_fmt, upipe_dveo_asi_src->card_idx, "buffers");
-    snprintf(buf, sizeof(buf), "%u", BUFFERS);
+    snprintf(buf, sizeof(buf), "%u", upipe_dveo_asi_src->buffers);
     if (util_write(sys, buf, sizeof(buf)) < 0) {
         upipe_err_va(upipe, "Couldn't set buffers");
         return UBASE_ERR_EXTERNAL;
     }
 
     snprintf(sys, sizeof(sys), sys_fmt, upipe_dveo_asi_src->card_idx, "bufsize");
-    snprintf(buf, sizeof(buf), "%u", CAPTURE_DEFAULT_SIZE);
+    snprintf(buf, sizeof(buf), "%u", upipe_dveo_asi_src->bufsize);
     if (util_write(sys, buf, sizeof(buf)) < 0) {
         upipe_err_va(upipe, "Couldn't set buffer size");
         return UBASE_ERR_EXTERNAL;
@@ -451,11 +460,24 @@ static int upipe_dveo_asi_src_set_option(struct upipe *upipe,
     struct upipe_dveo_asi_src *upipe_dveo_asi_src = upipe_dveo_asi_src_from_upipe(upipe);
     assert(k != NULL);
 
+    unsigned int value = v != NULL ? strtoul(v, NULL, 10) : 0;
+    if (!strcmp(k, "buffers") && value < ASI_RX_BUFFERS_MIN)
+        return UBASE_ERR_INVALID;
+    /* the driver wants multiples of 8, and the output is sliced in
+     * blocks of TS_PACKETS packets */
+    if (!strcmp(k, "bufsize") &&
+        (!value || value % 8 || value % (188 * TS_PACKETS)))
+        return UBASE_ERR_INVALID;
+
     if (unlikely(upipe_dveo_asi_src->fd != -1))
         upipe_dveo_asi_src_close(upipe);
 
     if (!strcmp(k, "card-idx"))
         upipe_dveo_asi_src->card_idx = atoi(v);
+    else if (!strcmp(k, "buffers"))
+        upipe_dveo_asi_src->buffers = value;
+    else if (!strcmp(k, "bufsize"))
+        upipe_dveo_asi_src->bufsize = value;
 
     upipe_dveo_asi_src_open(upipe);
 
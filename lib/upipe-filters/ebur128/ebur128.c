@@ -1,6 +1,7 @@
 /* See COPYING file for copyright and license details. */
 
 #include "ebur128.h"
+#include "ebur128_filter.h"
 
 #include <float.h>
 #include <limits.h>
@@ -426,9 +427,88 @@ static void ebur128_check_true_peak(ebur128_state* st, size_t frames) {
     st->d->v[ci][1] = fabs(st->d->v[ci][1]) < DBL_MIN ? 0.0 : st->d->v[ci][1];
 #endif
 
-#define EBUR128_FILTER(type, min_scale, max_scale)                             \
-static void ebur128_filter_##type(ebur128_state* st, const type* src,          \
-                                  size_t frames) {                             \
+/* Filters the channels whose filter states are distinct in parallel, and the
+ * others one at a time. */
+static void ebur128_filter_channels(ebur128_state* st, double* audio_data,
+                                    size_t frames) {
+  size_t c = 0, lane;
+  int ci;
+  unsigned int used = 0;
+  int parallel = 1;
+
+  for (c = 0; c < st->channels; ++c) {
+    ci = st->d->channel_map[c] - 1;
+    if (ci < 0) continue;
+    else if (ci > 4) ci = 0; /* dual mono */
+    if (used & (1U << ci)) parallel = 0;
+    used |= 1U << ci;
+  }
+
+  c = 0;
+  if (parallel) {
+    size_t lanes = 1;
+    ebur128_filter_func filter = NULL;
+    double v[5 * 4];
+#if defined(__i686__) || defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) {
+      lanes = 4;
+      filter = ebur128_filter_x4_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+      lanes = 2;
+      filter = ebur128_filter_x2_sse2;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    lanes = 2;
+    filter = ebur128_filter_x2_neon;
+#endif
+    while (filter != NULL) {
+      for (; c + lanes <= st->channels; c += lanes) {
+        for (lane = 0; lane < lanes; ++lane) {
+          size_t k;
+          ci = st->d->channel_map[c + lane] - 1;
+          if (ci > 4) ci = 0; /* dual mono */
+          for (k = 0; k < 5; ++k) {
+            v[k * lanes + lane] = ci < 0 ? 0.0 : st->d->v[ci][k];
+          }
+        }
+        filter(audio_data + c, st->channels, frames, st->d->a, st->d->b, v);
+        for (lane = 0; lane < lanes; ++lane) {
+          size_t k;
+          ci = st->d->channel_map[c + lane] - 1;
+          if (ci < 0) continue;
+          else if (ci > 4) ci = 0; /* dual mono */
+          for (k = 0; k < 5; ++k) {
+            st->d->v[ci][k] = v[k * lanes + lane];
+          }
+          FLUSH_MANUALLY
+        }
+      }
+#if defined(__i686__) || defined(__x86_64__)
+      /* remaining pairs of channels */
+      if (lanes == 4) {
+        lanes = 2;
+        filter = ebur128_filter_x2_sse2;
+        continue;
+      }
+#endif
+      filter = NULL;
+    }
+  }
+
+  for (; c < st->channels; ++c) {
+    ci = st->d->channel_map[c] - 1;
+    if (ci < 0) continue;
+    else if (ci > 4) ci = 0; /* dual mono */
+    ebur128_filter_c(audio_data + c, st->channels, frames,
+                     st->d->a, st->d->b, st->d->v[ci]);
+    FLUSH_MANUALLY
+  }
+}
+
+/* SAMPLE(c, i) is sample i of channel c of the source */
+#define EBUR128_FILTER(name, type, src_type, min_scale, max_scale, SAMPLE)    \
+static void ebur128_filter_##name(ebur128_state* st, src_type src,             \
+                                  size_t src_index, size_t frames) {           \
   static double scaling_factor = -((double) min_scale) > (double) max_scale ?  \
                                  -((double) min_scale) : (double) max_scale;   \
   double* audio_data = st->d->audio_data + st->d->audio_data_index;            \
@@ -440,10 +520,10 @@ static void ebur128_filter_##type(ebur128_state* st, const type* src,          \
     for (c = 0; c < st->channels; ++c) {                                       \
       double max = 0.0;                                                        \
       for (i = 0; i < frames; ++i) {                                           \
-        if (src[i * st->channels + c] > max) {                                 \
-          max =        src[i * st->channels + c];                              \
-        } else if (-src[i * st->channels + c] > max) {                         \
-          max = -1.0 * src[i * st->channels + c];                              \
+        if (SAMPLE(c, i) > max) {                                              \
+          max =        SAMPLE(c, i);                                           \
+        } else if (-SAMPLE(c, i) > max) {                                      \
+          max = -1.0 * SAMPLE(c, i);                                           \
         }                                                                      \
       }                                                                        \
       max /= scaling_factor;                                                   \
@@ -454,40 +534,37 @@ static void ebur128_filter_##type(ebur128_state* st, const type* src,          \
     for (c = 0; c < st->channels; ++c) {                                       \
       for (i = 0; i < frames; ++i) {                                           \
         st->d->resampler_buffer_input[i * st->channels + c] =                  \
-                      (float) (src[i * st->channels + c] / scaling_factor);    \
+                      (float) (SAMPLE(c, i) / scaling_factor);                 \
       }                                                                        \
     }                                                                          \
     ebur128_check_true_peak(st, frames);                                       \
   }                                                                            \
   for (c = 0; c < st->channels; ++c) {                                         \
-    int ci = st->d->channel_map[c] - 1;                                        \
-    if (ci < 0) continue;                                                      \
-    else if (ci > 4) ci = 0; /* dual mono */                                   \
+    if (st->d->channel_map[c] == EBUR128_UNUSED) continue;                     \
     for (i = 0; i < frames; ++i) {                                             \
-      st->d->v[ci][0] = (double) (src[i * st->channels + c] / scaling_factor)  \
-                   - st->d->a[1] * st->d->v[ci][1]                             \
-                   - st->d->a[2] * st->d->v[ci][2]                             \
-                   - st->d->a[3] * st->d->v[ci][3]                             \
-                   - st->d->a[4] * st->d->v[ci][4];                            \
       audio_data[i * st->channels + c] =                                       \
-                     st->d->b[0] * st->d->v[ci][0]                             \
-                   + st->d->b[1] * st->d->v[ci][1]                             \
-                   + st->d->b[2] * st->d->v[ci][2]                             \
-                   + st->d->b[3] * st->d->v[ci][3]                             \
-                   + st->d->b[4] * st->d->v[ci][4];                            \
-      st->d->v[ci][4] = st->d->v[ci][3];                                       \
-      st->d->v[ci][3] = st->d->v[ci][2];                                       \
-      st->d->v[ci][2] = st->d->v[ci][1];                                       \
-      st->d->v[ci][1] = st->d->v[ci][0];                                       \
+                     (double) (SAMPLE(c, i) / scaling_factor);                 \
     }                                                                          \
-    FLUSH_MANUALLY                                                             \
   }                                                                            \
+  ebur128_filter_channels(st, audio_data, frames);                             \
   TURN_OFF_FTZ                                                                 \
 }
-EBUR128_FILTER(short, SHRT_MIN, SHRT_MAX)
-EBUR128_FILTER(int, INT_MIN, INT_MAX)
-EBUR128_FILTER(float, -1.0f, 1.0f)
-EBUR128_FILTER(double, -1.0, 1.0)
+#define EBUR128_INTERLEAVED(c, i) src[(src_index + (i)) * st->channels + (c)]
+#define EBUR128_PLANAR(c, i) src[c][src_index + (i)]
+EBUR128_FILTER(short, short, const short*, SHRT_MIN, SHRT_MAX,
+               EBUR128_INTERLEAVED)
+EBUR128_FILTER(int, int, const int*, INT_MIN, INT_MAX, EBUR128_INTERLEAVED)
+EBUR128_FILTER(float, float, const float*, -1.0f, 1.0f, EBUR128_INTERLEAVED)
+EBUR128_FILTER(double, double, const double*, -1.0, 1.0, EBUR128_INTERLEAVED)
+EBUR128_FILTER(planar_short, short, const short**, SHRT_MIN, SHRT_MAX,
+               EBUR128_PLANAR)
+EBUR128_FILTER(planar_int, int, const int**, INT_MIN, INT_MAX, EBUR128_PLANAR)
+EBUR128_FILTER(planar_float, float, const float**, -1.0f, 1.0f,
+               EBUR128_PLANAR)
+EBUR128_FILTER(planar_double, double, const double**, -1.0, 1.0,
+               EBUR128_PLANAR)
+#undef EBUR128_INTERLEAVED
+#undef EBUR128_PLANAR
 
 static double ebur128_energy_to_loudness(double energy) {
   return 10 * (log(energy) / log(10.0)) - 0.691;
@@ -648,14 +725,14 @@ exit:
 
 
 static int ebur128_energy_shortterm(ebur128_state* st, double* out);
-#define EBUR128_ADD_FRAMES(type)                                               \
-int ebur128_add_frames_##type(ebur128_state* st,                               \
-                              const type* src, size_t frames) {                \
+#define EBUR128_ADD_FRAMES(name, src_type)                                     \
+int ebur128_add_frames_##name(ebur128_state* st,                               \
+                              src_type src, size_t frames) {                   \
   size_t src_index = 0;                                                        \
   while (frames > 0) {                                                         \
     if (frames >= st->d->needed_frames) {                                      \
-      ebur128_filter_##type(st, src + src_index, st->d->needed_frames);        \
-      src_index += st->d->needed_frames * st->channels;                        \
+      ebur128_filter_##name(st, src, src_index, st->d->needed_frames);         \
+      src_index += st->d->needed_frames;                                       \
       frames -= st->d->needed_frames;                                          \
       st->d->audio_data_index += st->d->needed_frames * st->channels;          \
       /* calculate the new gating block */                                     \
@@ -692,7 +769,7 @@ int ebur128_add_frames_##type(ebur128_state* st,                               \
         st->d->audio_data_index = 0;                                           \
       }                                                                        \
     } else {                                                                   \
-      ebur128_filter_##type(st, src + src_index, frames);                      \
+      ebur128_filter_##name(st, src, src_index, frames);                       \
       st->d->audio_data_index += frames * st->channels;                        \
       if ((st->mode & EBUR128_MODE_LRA) == EBUR128_MODE_LRA) {                 \
         st->d->short_term_frame_counter += frames;                             \
@@ -703,10 +780,14 @@ int ebur128_add_frames_##type(ebur128_state* st,                               \
   }                                                                            \
   return EBUR128_SUCCESS;                                                      \
 }
-EBUR128_ADD_FRAMES(short)
-EBUR128_ADD_FRAMES(int)
-EBUR128_ADD_FRAMES(float)
-EBUR128_ADD_FRAMES(double)
+EBUR128_ADD_FRAMES(short, const short*)
+EBUR128_ADD_FRAMES(int, const int*)
+EBUR128_ADD_FRAMES(float, const float*)
+EBUR128_ADD_FRAMES(double, const double*)
+EBUR128_ADD_FRAMES(planar_short, const short**)
+EBUR128_ADD_FRAMES(planar_int, const int**)
+EBUR128_ADD_FRAMES(planar_float, const float**)
+EBUR128_ADD_FRAMES(planar_double, const double**)
 
 static int ebur128_gated_loudness(ebur128_state** sts, size_t size,
                                   double* out) {
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short K-weighting filter kernels for the EBU R128 measurement
+ */
+
+#include "ebur128_filter.h"
+
+#if defined(__i686__) || defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+void ebur128_filter_c(double *data, size_t stride, size_t frames,
+                      const double *a, const double *b, double *v)
+{
+    for (size_t i = 0; i < frames; i++) {
+        v[0] = data[i * stride] - a[1] * v[1] - a[2] * v[2]
+                                - a[3] * v[3] - a[4] * v[4];
+        data[i * stride] = b[0] * v[0] + b[1] * v[1] + b[2] * v[2]
+                         + b[3] * v[3] + b[4] * v[4];
+        v[4] = v[3];
+        v[3] = v[2];
+        v[2] = v[1];
+        v[1] = v[0];
+    }
+}
+
+#if defined(__i686__) || defined(__x86_64__)
+__attribute__((target("sse2")))
+void ebur128_filter_x2_sse2(double *data, size_t stride, size_t frames,
+                            const double *a, const double *b, double *v)
+{
+    const __m128d a1 = _mm_set1_pd(a[1]), a2 = _mm_set1_pd(a[2]);
+    const __m128d a3 = _mm_set1_pd(a[3]), a4 = _mm_set1_pd(a[4]);
+    const __m128d b0 = _mm_set1_pd(b[0]), b1 = _mm_set1_pd(b[1]);
+    const __m128d b2 = _mm_set1_pd(b[2]), b3 = _mm_set1_pd(b[3]);
+    const __m128d b4 = _mm_set1_pd(b[4]);
+    __m128d v0 = _mm_loadu_pd(v), v1 = _mm_loadu_pd(v + 2);
+    __m128d v2 = _mm_loadu_pd(v + 4), v3 = _mm_loadu_pd(v + 6);
+    __m128d v4 = _mm_loadu_pd(v + 8);
+
+    for (size_t i = 0; i < frames; i++) {
+        __m128d x = _mm_loadu_pd(data + i * stride);
+        x = _mm_sub_pd(x, _mm_mul_pd(a1, v1));
+        x = _mm_sub_pd(x, _mm_mul_pd(a2, v2));
+        x = _mm_sub_pd(x, _mm_mul_pd(a3, v3));
+        v0 = _mm_sub_pd(x, _mm_mul_pd(a4, v4));
+        __m128d y = _mm_mul_pd(b0, v0);
+        y = _mm_add_pd(y, _mm_mul_pd(b1, v1));
+        y = _mm_add_pd(y, _mm_mul_pd(b2, v2));
+        y = _mm_add_pd(y, _mm_mul_pd(b3, v3));
+        y = _mm_add_pd(y, _mm_mul_pd(b4, v4));
+        _mm_storeu_pd(data + i * stride, y);
+        v4 = v3;
+        v3 = v2;
+        v2 = v1;
+        v1 = v0;
+    }
+
+    _mm_storeu_pd(v, v0);
+    _mm_storeu_pd(v + 2, v1);
+    _mm_storeu_pd(v + 4, v2);
+    _mm_storeu_pd(v + 6, v3);
+    _mm_storeu_pd(v + 8, v4);
+}
+
+__attribute__((target("avx2")))
+void ebur128_filter_x4_avx2(double *data, size_t stride, size_t frames,
+                            const double *a, const double *b, double *v)
+{
+    const __m256d a1 = _mm256_set1_pd(a[1]), a2 = _mm256_set1_pd(a[2]);
+    const __m256d a3 = _mm256_set1_pd(a[3]), a4 = _mm256_set1_pd(a[4]);
+    const __m256d b0 = _mm256_set1_pd(b[0]), b1 = _mm256_set1_pd(b[1]);
+    const __m256d b2 = _mm256_set1_pd(b[2]), b3 = _mm256_set1_pd(b[3]);
+    const __m256d b4 = _mm256_set1_pd(b[4]);
+    __m256d v0 = _mm256_loadu_pd(v), v1 = _mm256_loadu_pd(v + 4);
+    __m256d v2 = _mm256_loadu_pd(v + 8), v3 = _mm256_loadu_pd(v + 12);
+    __m256d v4 = _mm256_loadu_pd(v + 16);
+
+    for (size_t i = 0; i < frames; i++) {
+        __m256d x = _mm256_loadu_pd(data + i * stride);
+        x = _mm256_sub_pd(x, _mm256_mul_pd(a1, v1));
+        x = _mm256_sub_pd(x, _mm256_mul_pd(a2, v2));
+        x = _mm256_sub_pd(x, _mm256_mul_pd(a3, v3));
+        v0 = _mm256_sub_pd(x, _mm256_mul_pd(a4, v4));
+        __m256d y = _mm256_mul_pd(b0, v0);
+        y = _mm256_add_pd(y, _mm256_mul_pd(b1, v1));
+        y = _mm256_add_pd(y, _mm256_mul_pd(b2, v2));
+        y = _mm256_add_pd(y, _mm256_mul_pd(b3, v3));
+        y = _mm256_add_pd(y, _mm256_mul_pd(b4, v4));
+        _mm256_storeu_pd(data + i * stride, y);
+        v4 = v3;
+        v3 = v2;
+        v2 = v1;
+        v1 = v0;
+    }
+
+    _mm256_storeu_pd(v, v0);
+    _mm256_storeu_pd(v + 4, v1);
+    _mm256_storeu_pd(v + 8, v2);
+    _mm256_storeu_pd(v + 12, v3);
+    _mm256_storeu_pd(v + 16, v4);
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+void ebur128_filter_x2_neon(double *data, size_t stride, size_t frames,
+                            const double *a, const double *b, double *v)
+{
+    const float64x2_t a1 = vdupq_n_f64(a[1]), a2 = vdupq_n_f64(a[2]);
+    const float64x2_t a3 = vdupq_n_f64(a[3]), a4 = vdupq_n_f64(a[4]);
+    const float64x2_t b0 = vdupq_n_f64(b[0]), b1 = vdupq_n_f64(b[1]);
+    const float64x2_t b2 = vdupq_n_f64(b[2]), b3 = vdupq_n_f64(b[3]);
+    const float64x2_t b4 = vdupq_n_f64(b[4]);
+    float64x2_t v0 = vld1q_f64(v), v1 = vld1q_f64(v + 2);
+    float64x2_t v2 = vld1q_f64(v + 4), v3 = vld1q_f64(v + 6);
+    float64x2_t v4 = vld1q_f64(v + 8);
+
+    for (size_t i = 0; i < frames; i++) {
+        float64x2_t x = vld1q_f64(data + i * stride);
+        x = vsubq_f64(x, vmulq_f64(a1, v1));
+        x = vsubq_f64(x, vmulq_f64(a2, v2));
+        x = vsubq_f64(x, vmulq_f64(a3, v3));
+        v0 = vsubq_f64(x, vmulq_f64(a4, v4));
+        float64x2_t y = vmulq_f64(b0, v0);
+        y = vaddq_f64(y, vmulq_f64(b1, v1));
+        y = vaddq_f64(y, vmulq_f64(b2, v2));
+        y = vaddq_f64(y, vmulq_f64(b3, v3));
+        y = vaddq_f64(y, vmulq_f64(b4, v4));
+        vst1q_f64(data + i * stride, y);
+        v4 = v3;
+        v3 = v2;
+        v2 = v1;
+        v1 = v0;
+    }
+
+    vst1q_f64(v, v0);
+    vst1q_f64(v + 2, v1);
+    vst1q_f64(v + 4, v2);
+    vst1q_f64(v + 6, v3);
+    vst1q_f64(v + 8, v4);
+}
+#endif
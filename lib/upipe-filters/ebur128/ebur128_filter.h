@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short K-weighting filter kernels for the EBU R128 measurement
+ * The variants below filter 1, 2 or 4 adjacent channels of interleaved
+ * samples at once, in place. They are called by ebur128.c, and exported for
+ * checkasm.
+ *
+ * The filter state holds 5 values per channel; with several channels, the
+ * values of all channels for each index are stored contiguously. The vector
+ * variants perform the same operations in the same order as the C one.
+ */
+
+#ifndef EBUR128_FILTER_H_
+/** @hidden */
+#define EBUR128_FILTER_H_
+
+#include <stddef.h>
+
+/** @This filters samples of adjacent channels in place.
+ *
+ * @param data first sample of the first channel
+ * @param stride number of samples between two frames
+ * @param frames number of frames
+ * @param a denominator coefficients
+ * @param b numerator coefficients
+ * @param v filter state
+ */
+typedef void (*ebur128_filter_func)(double *data, size_t stride,
+                                    size_t frames, const double *a,
+                                    const double *b, double *v);
+
+/* one channel at a time */
+void ebur128_filter_c(double *data, size_t stride, size_t frames,
+                      const double *a, const double *b, double *v);
+
+#if defined(__i686__) || defined(__x86_64__)
+/* 2 channels at a time */
+void ebur128_filter_x2_sse2(double *data, size_t stride, size_t frames,
+                            const double *a, const double *b, double *v);
+/* 4 channels at a time */
+void ebur128_filter_x4_avx2(double *data, size_t stride, size_t frames,
+                            const double *a, const double *b, double *v);
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/* 2 channels at a time */
+void ebur128_filter_x2_neon(double *data, size_t stride, size_t frames,
+                            const double *a, const double *b, double *v);
+#endif
+
+#endif
@@ -100,6 +100,13 @@ struct upipe_audiobar {
     double peak[255];
     /* peak date */
     uint64_t peak_date[255];
+    /** first lit row of each bar in the last picture */
+    int hmax[255];
+
+    /** pictures with every bar off and lit, from which bars are copied */
+    struct ubuf *background[2];
+    /** last output picture */
+    struct ubuf *ubuf;
 
     /** temporary uref storage (used during urequest) */
     struct uchain urefs;
@@ -171,9 +178,13 @@ static struct upipe *upipe_audiobar_alloc(struct upipe_mgr *mgr,
     upipe_audiobar->hsize = upipe_audiobar->vsize =
         upipe_audiobar->sep_width = upipe_audiobar->pad_width = UINT64_MAX;
 
+    upipe_audiobar->background[0] = upipe_audiobar->background[1] = NULL;
+    upipe_audiobar->ubuf = NULL;
+
     for (int i = 0; i < 255; i++) {
         upipe_audiobar->peak[i] = 0.;
         upipe_audiobar->peak_date[i] = 0;
+        upipe_audiobar->hmax[i] = 0;
     }
 
     upipe_throw_ready(upipe);
@@ -229,7 +240,108 @@ static void copy_color(uint8_t **dst, size_t *strides,
            color[3], w / hsubs[3]); // a8
 }
 
-/** @internal @This handles data.
+/** @internal @This releases the cached pictures, when the format or the
+ * colors change.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_audiobar_flush_pictures(struct upipe *upipe)
+{
+    struct upipe_audiobar *upipe_audiobar = upipe_audiobar_from_upipe(upipe);
+    for (int i = 0; i < 2; i++) {
+        if (upipe_audiobar->background[i] != NULL)
+            ubuf_free(upipe_audiobar->background[i]);
+        upipe_audiobar->background[i] = NULL;
+    }
+    if (upipe_audiobar->ubuf != NULL)
+        ubuf_free(upipe_audiobar->ubuf);
+    upipe_audiobar->ubuf = NULL;
+}
+
+/** @internal @This draws the static picture of the meters, with every bar
+ * either off or lit.
+ *
+ * @param upipe description structure of the pipe
+ * @param lit true to light the bars
+ * @return pointer to the picture or NULL in case of error
+ */
+static struct ubuf *upipe_audiobar_draw_background(struct upipe *upipe,
+                                                   bool lit)
+{
+    struct upipe_audiobar *upipe_audiobar = upipe_audiobar_from_upipe(upipe);
+    struct ubuf *ubuf = ubuf_pic_alloc(upipe_audiobar->ubuf_mgr,
+                                       upipe_audiobar->hsize,
+                                       upipe_audiobar->vsize);
+    if (unlikely(ubuf == NULL))
+        return NULL;
+
+    uint8_t *dst[4];
+    size_t strides[4];
+    uint8_t hsubs[4];
+    uint8_t vsubs[4];
+    static const char *chroma[4] = { "y8", "u8", "v8", "a8" };
+    for (int i = 0; i < 4; i++) {
+        if (unlikely(!ubase_check(ubuf_pic_plane_write(ubuf, chroma[i],
+                            0, 0, -1, -1, &dst[i])) ||
+                     !ubase_check(ubuf_pic_plane_size(ubuf, chroma[i],
+                             &strides[i], &hsubs[i], &vsubs[i], NULL)))) {
+            for (int j = 0; j < i; j++)
+                ubuf_pic_plane_unmap(ubuf, chroma[j], 0, 0, -1, -1);
+            ubuf_free(ubuf);
+            return NULL;
+        }
+    }
+
+    uint8_t alpha = upipe_audiobar->alpha;
+    uint64_t h = upipe_audiobar->vsize;
+    const int hred = h - (iec_scale(-8.) * h);
+    const int hyellow = h - (iec_scale(-18.) * h);
+    uint8_t transparent[4] = { 0x10, 0x80, 0x80, 0 };
+    uint8_t black[4] = { 0x10, 0x80, 0x80, alpha };
+    uint8_t red[2][4] = { { 76, 85, 0xff, alpha }, { 37, 106, 191, alpha } };
+    uint8_t green[2][4] = { { 150, 44, 21, alpha }, { 74, 85, 74, alpha } };
+    uint8_t yellow[2][4] = { { 226, 1, 148, alpha }, { 112, 64, 138, alpha } };
+
+    for (uint8_t chan = 0; chan < upipe_audiobar->channels; chan++) {
+        for (int row = 0; row < h; row++) {
+            const uint8_t *color = row < hred ? red[!lit] :
+                                   row < hyellow ? yellow[!lit] :
+                                   green[!lit];
+
+            copy_color(dst, strides, hsubs, vsubs, color, row,
+                       chan * upipe_audiobar->chan_width,
+                       upipe_audiobar->chan_width);
+            if (chan && upipe_audiobar->sep_width)
+                copy_color(dst, strides, hsubs, vsubs, black, row,
+                           chan * upipe_audiobar->chan_width -
+                           upipe_audiobar->sep_width / 2,
+                           upipe_audiobar->sep_width);
+
+            if (chan == upipe_audiobar->channels - 1 &&
+                upipe_audiobar->pad_width)
+                copy_color(dst, strides, hsubs, vsubs, transparent, row,
+                           (chan + 1) * upipe_audiobar->chan_width,
+                           upipe_audiobar->pad_width);
+        }
+    }
+
+    /* dB marks */
+    for (int i = 1; i <= 6; i++) {
+        int row = h - (iec_scale(-10 * i) * h);
+        copy_color(dst, strides, hsubs, vsubs, black, row, 0,
+                   upipe_audiobar->hsize);
+    }
+
+    for (int i = 0; i < 4; i++)
+        ubuf_pic_plane_unmap(ubuf, chroma[i], 0, 0, -1, -1);
+    return ubuf;
+}
+
+/** @internal @This handles data. The bars, separations and dB marks are
+ * drawn once per format in a picture with every bar off and another with
+ * every bar lit. Each new picture is a copy of the previous one in which
+ * only the rows of the bars that changed are copied from either background,
+ * and the previous picture is output again when no bar changed.
  *
  * @param upipe description structure of the pipe
  * @param uref uref structure describing the picture
@@ -258,6 +370,7 @@ static bool upipe_audiobar_handle(struct upipe *upipe, struct uref *uref,
 
         upipe_audiobar->hsize = upipe_audiobar->vsize =
             upipe_audiobar->sep_width = upipe_audiobar->pad_width = UINT64_MAX;
+        upipe_audiobar_flush_pictures(upipe);
         upipe_audiobar_require_flow_format(upipe, uref);
         return true;
     }
@@ -268,42 +381,28 @@ static bool upipe_audiobar_handle(struct upipe *upipe, struct uref *uref,
     if (unlikely(upipe_audiobar->hsize == UINT64_MAX))
         return false;
 
-    struct ubuf *ubuf = ubuf_pic_alloc(upipe_audiobar->ubuf_mgr,
-                                       upipe_audiobar->hsize,
-                                       upipe_audiobar->vsize);
-    uref_attach_ubuf(uref, ubuf);
-
-    uint8_t *dst[4];
-    size_t strides[4];
-    uint8_t hsubs[4];
-    uint8_t vsubs[4];
-    static const char *chroma[4] = { "y8", "u8", "v8", "a8" };
-    for (int i = 0; i < 4; i++) {
-        if (unlikely(!ubase_check(uref_pic_plane_write(uref, chroma[i],
-                            0, 0, -1, -1, &dst[i])) ||
-                     !ubase_check(uref_pic_plane_size(uref, chroma[i],
-                             &strides[i], &hsubs[i], &vsubs[i], NULL)))) {
-             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-             uref_free(uref);
-             return true;
+    if (unlikely(upipe_audiobar->background[0] == NULL)) {
+        upipe_audiobar->background[0] =
+            upipe_audiobar_draw_background(upipe, false);
+        upipe_audiobar->background[1] =
+            upipe_audiobar_draw_background(upipe, true);
+        if (unlikely(upipe_audiobar->background[0] == NULL ||
+                     upipe_audiobar->background[1] == NULL)) {
+            upipe_audiobar_flush_pictures(upipe);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            uref_free(uref);
+            return true;
         }
     }
 
-    uint8_t alpha = upipe_audiobar->alpha;
     uint64_t h = upipe_audiobar->vsize;
-    const int hred = h - (iec_scale(-8.) * h);
-    const int hyellow = h - (iec_scale(-18.) * h);
-    uint8_t transparent[4] = { 0x10, 0x80, 0x80, 0 };
-    uint8_t black[4] = { 0x10, 0x80, 0x80, alpha };
-    uint8_t red[2][4] = { { 76, 85, 0xff, alpha }, { 37, 106, 191, alpha } };
-    uint8_t green[2][4] = { { 150, 44, 21, alpha }, { 74, 85, 74, alpha } };
-    uint8_t yellow[2][4] = { { 226, 1, 148, alpha }, { 112, 64, 138, alpha } };
-
     uint64_t pts = 0;
     if (unlikely(!ubase_check(uref_clock_get_pts_prog(uref, &pts)))) {
         upipe_warn(upipe, "unable to read pts");
     }
 
+    int hmax[255];
+    bool changed = upipe_audiobar->ubuf == NULL;
     for (uint8_t chan = 0; chan < upipe_audiobar->channels; chan++) {
         double amplitude = 0.;
         if (unlikely(!ubase_check(uref_amax_get_amplitude(uref, &amplitude,
@@ -325,40 +424,64 @@ static bool upipe_audiobar_handle(struct upipe *upipe, struct uref *uref,
 
         scale = iec_scale(scale);
 
-        const int hmax = h - scale * h;
-        for (int row = 0; row < h; row++) {
-            bool bright = row > hmax;
-
-            const uint8_t *color = row < hred ? red[!bright] :
-                                   row < hyellow ? yellow[!bright] :
-                                   green[!bright];
+        hmax[chan] = h - scale * h;
+        if (hmax[chan] != upipe_audiobar->hmax[chan])
+            changed = true;
+    }
 
-            copy_color(dst, strides, hsubs, vsubs, color, row,
-                       chan * upipe_audiobar->chan_width,
-                       upipe_audiobar->chan_width);
-            if (chan && upipe_audiobar->sep_width)
-                copy_color(dst, strides, hsubs, vsubs, black, row,
-                           chan * upipe_audiobar->chan_width -
-                           upipe_audiobar->sep_width / 2,
-                           upipe_audiobar->sep_width);
+    struct ubuf *ubuf;
+    if (!changed)
+        ubuf = ubuf_dup(upipe_audiobar->ubuf);
+    else
+        ubuf = ubuf_pic_copy(upipe_audiobar->ubuf_mgr,
+                             upipe_audiobar->ubuf != NULL ?
+                             upipe_audiobar->ubuf :
+                             upipe_audiobar->background[0], 0, 0, -1, -1);
+    if (unlikely(ubuf == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        uref_free(uref);
+        return true;
+    }
 
-            if (chan == upipe_audiobar->channels - 1 &&
-                upipe_audiobar->pad_width)
-                copy_color(dst, strides, hsubs, vsubs, transparent, row,
-                           (chan + 1) * upipe_audiobar->chan_width,
-                           upipe_audiobar->pad_width);
+    for (uint8_t chan = 0; changed && chan < upipe_audiobar->channels;
+         chan++) {
+        /* the background has every bar off */
+        int prev = upipe_audiobar->ubuf != NULL ?
+                   upipe_audiobar->hmax[chan] : h;
+        upipe_audiobar->hmax[chan] = hmax[chan];
+        if (hmax[chan] == prev)
+            continue;
+
+        /* rows below hmax are lit, so only rows between both are copied */
+        bool lit = hmax[chan] < prev;
+        int row = (lit ? hmax[chan] : prev) + 1;
+        int last = lit ? prev : hmax[chan];
+        if ((uint64_t)last >= h)
+            last = h - 1;
+        if (last < row)
+            continue;
+
+        if (unlikely(!ubase_check(ubuf_pic_blit(ubuf,
+                            upipe_audiobar->background[lit],
+                            chan * upipe_audiobar->chan_width, row,
+                            chan * upipe_audiobar->chan_width, row,
+                            upipe_audiobar->chan_width, last - row + 1,
+                            0xff, 0)))) {
+            ubuf_free(ubuf);
+            upipe_audiobar_flush_pictures(upipe);
+            upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
+            uref_free(uref);
+            return true;
         }
     }
 
-    /* dB marks */
-    for (int i = 1; i <= 6; i++) {
-        int row = h - (iec_scale(-10 * i) * h);
-        copy_color(dst, strides, hsubs, vsubs, black, row, 0,
-                   upipe_audiobar->hsize);
+    if (changed) {
+        if (upipe_audiobar->ubuf != NULL)
+            ubuf_free(upipe_audiobar->ubuf);
+        upipe_audiobar->ubuf = ubuf_dup(ubuf);
     }
 
-    for (int i = 0; i < 4; i++)
-        ubuf_pic_plane_unmap(ubuf, chroma[i], 0, 0, -1, -1);
+    uref_attach_ubuf(uref, ubuf);
     upipe_audiobar_output(upipe, uref, upump_p);
     return true;
 }
@@ -414,6 +537,7 @@ static int upipe_audiobar_check_ubuf_mgr(struct upipe *upipe,
         return UBASE_ERR_NONE;
 
     upipe_audiobar_store_flow_def(upipe, flow_format);
+    upipe_audiobar_flush_pictures(upipe);
     UBASE_RETURN(uref_pic_flow_get_hsize(flow_format, &upipe_audiobar->hsize))
     UBASE_RETURN(uref_pic_flow_get_vsize(flow_format, &upipe_audiobar->vsize))
     upipe_audiobar->chan_width =
@@ -491,6 +615,7 @@ static int _upipe_audiobar_set_alpha(struct upipe *upipe, uint8_t alpha)
 {
     struct upipe_audiobar *upipe_audiobar = upipe_audiobar_from_upipe(upipe);
     upipe_audiobar->alpha = alpha;
+    upipe_audiobar_flush_pictures(upipe);
     return UBASE_ERR_NONE;
 }
 
@@ -552,6 +677,7 @@ static void upipe_audiobar_free(struct upipe *upipe)
     upipe_throw_dead(upipe);
 
     struct upipe_audiobar *upipe_audiobar = upipe_audiobar_from_upipe(upipe);
+    upipe_audiobar_flush_pictures(upipe);
     uref_free(upipe_audiobar->flow_def_config);
     upipe_audiobar_clean_flow_format(upipe);
     upipe_audiobar_clean_ubuf_mgr(upipe);
@@ -98,6 +98,11 @@ struct upipe_agraph {
     uint64_t peak_date[255];
     /** previous values */
     double *prev[255];
+    /** number of consecutive values drawn at the same height */
+    uint64_t same[255];
+
+    /** last output picture */
+    struct ubuf *ubuf;
 
     /** temporary uref storage (used during urequest) */
     struct uchain urefs;
@@ -174,7 +179,9 @@ static struct upipe *upipe_agraph_alloc(struct upipe_mgr *mgr,
         upipe_agraph->peak[i] = 0.;
         upipe_agraph->peak_date[i] = 0;
         upipe_agraph->prev[i] = NULL;
+        upipe_agraph->same[i] = 0;
     }
+    upipe_agraph->ubuf = NULL;
 
     upipe_throw_ready(upipe);
     return upipe;
@@ -227,7 +234,95 @@ static void copy_color(uint8_t **dst, size_t *strides,
            color[2], w / hsubs[2]); // v8
 }
 
-/** @internal @This handles data.
+/** @internal @This draws a column of the graph of a channel.
+ *
+ * @param upipe description structure of the pipe
+ * @param dst array of destination chromas (planar YUV422)
+ * @param strides array of strides for each chroma
+ * @param hsubs array of hsubs of each chroma
+ * @param vsubs array of vsubs of each chroma
+ * @param chan channel number
+ * @param i index of the column in the channel history
+ */
+static void upipe_agraph_draw_column(struct upipe *upipe, uint8_t **dst,
+                                     size_t *strides, uint8_t *hsubs,
+                                     uint8_t *vsubs, uint8_t chan, uint64_t i)
+{
+    struct upipe_agraph *upipe_agraph = upipe_agraph_from_upipe(upipe);
+    uint64_t h = upipe_agraph->vsize;
+    const int hred = h - (iec_scale(-8.) * h);
+    const int hyellow = h - (iec_scale(-18.) * h);
+    uint8_t black[3] = { 0x10, 0x80, 0x80 };
+    uint8_t red[2][3] = { { 76, 85, 0xff }, { 37, 106, 191 } };
+    uint8_t green[2][3] = { { 150, 44, 21 }, { 74, 85, 74 } };
+    uint8_t yellow[2][3] = { { 226, 1, 148 }, { 112, 64, 138 } };
+    unsigned col = upipe_agraph->sep_width +
+                   chan * upipe_agraph->chan_width + 2 * i;
+
+    double scale = upipe_agraph->prev[chan][i];
+    const int hmax = h - scale * h;
+    bool bright = (i == upipe_agraph->chan_hist - 1);
+    for (int row = 0; row < h; row++) {
+        const uint8_t *color = row < hmax ? black :
+                               row < hred ? red[!bright] :
+                               row < hyellow ? yellow[!bright] :
+                               green[!bright];
+        copy_color(dst, strides, hsubs, vsubs, color, row, col, 2);
+    }
+
+    /* dB marks */
+    for (int m = 1; m <= 6; m++) {
+        int row = h - (iec_scale(-10 * m) * h);
+        copy_color(dst, strides, hsubs, vsubs, black, row, col, 2);
+    }
+}
+
+/** @internal @This draws the picture of an empty graph.
+ *
+ * @param upipe description structure of the pipe
+ * @return pointer to the picture or NULL in case of error
+ */
+static struct ubuf *upipe_agraph_draw_background(struct upipe *upipe)
+{
+    struct upipe_agraph *upipe_agraph = upipe_agraph_from_upipe(upipe);
+    struct ubuf *ubuf = ubuf_pic_alloc(upipe_agraph->ubuf_mgr,
+                                       upipe_agraph->hsize,
+                                       upipe_agraph->vsize);
+    if (unlikely(ubuf == NULL))
+        return NULL;
+
+    uint8_t *dst[4];
+    size_t strides[4];
+    uint8_t hsubs[4];
+    uint8_t vsubs[4];
+    static const char *chroma[3] = { "y8", "u8", "v8" };
+    for (int i = 0; i < 3; i++) {
+        if (unlikely(!ubase_check(ubuf_pic_plane_write(ubuf, chroma[i],
+                            0, 0, -1, -1, &dst[i])) ||
+                     !ubase_check(ubuf_pic_plane_size(ubuf, chroma[i],
+                             &strides[i], &hsubs[i], &vsubs[i], NULL)))) {
+            for (int j = 0; j < i; j++)
+                ubuf_pic_plane_unmap(ubuf, chroma[j], 0, 0, -1, -1);
+            ubuf_free(ubuf);
+            return NULL;
+        }
+    }
+
+    /* separations, padding, dB marks and empty values are all black */
+    uint8_t black[3] = { 0x10, 0x80, 0x80 };
+    for (int row = 0; row < upipe_agraph->vsize; row++)
+        copy_color(dst, strides, hsubs, vsubs, black, row, 0,
+                   upipe_agraph->hsize);
+
+    for (int i = 0; i < 3; i++)
+        ubuf_pic_plane_unmap(ubuf, chroma[i], 0, 0, -1, -1);
+    return ubuf;
+}
+
+/** @internal @This handles data. Each new picture is a copy of the previous
+ * one in which the history of each channel is scrolled by one column, so
+ * that only the last two columns are drawn. The previous picture is output
+ * again when the whole history is flat.
  *
  * @param upipe description structure of the pipe
  * @param uref uref structure describing the picture
@@ -265,41 +360,14 @@ static bool upipe_agraph_handle(struct upipe *upipe, struct uref *uref,
     if (unlikely(upipe_agraph->hsize == UINT64_MAX))
         return false;
 
-    struct ubuf *ubuf = ubuf_pic_alloc(upipe_agraph->ubuf_mgr,
-                                       upipe_agraph->hsize,
-                                       upipe_agraph->vsize);
-    uref_attach_ubuf(uref, ubuf);
-
-    uint8_t *dst[4];
-    size_t strides[4];
-    uint8_t hsubs[4];
-    uint8_t vsubs[4];
-    static const char *chroma[3] = { "y8", "u8", "v8" };
-    for (int i = 0; i < 3; i++) {
-        if (unlikely(!ubase_check(uref_pic_plane_write(uref, chroma[i],
-                            0, 0, -1, -1, &dst[i])) ||
-                     !ubase_check(uref_pic_plane_size(uref, chroma[i],
-                             &strides[i], &hsubs[i], &vsubs[i], NULL)))) {
-             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-             uref_free(uref);
-             return true;
-        }
-    }
-
     uint64_t h = upipe_agraph->vsize;
-    const int hred = h - (iec_scale(-8.) * h);
-    const int hyellow = h - (iec_scale(-18.) * h);
-    uint8_t transparent[3] = { 0x10, 0x80, 0x80 };
-    uint8_t black[3] = { 0x10, 0x80, 0x80 };
-    uint8_t red[2][3] = { { 76, 85, 0xff }, { 37, 106, 191 } };
-    uint8_t green[2][3] = { { 150, 44, 21 }, { 74, 85, 74 } };
-    uint8_t yellow[2][3] = { { 226, 1, 148 }, { 112, 64, 138 } };
-
+    uint64_t hist = upipe_agraph->chan_hist;
     uint64_t pts = 0;
     if (unlikely(!ubase_check(uref_clock_get_pts_prog(uref, &pts)))) {
         upipe_warn(upipe, "unable to read pts");
     }
 
+    bool changed = upipe_agraph->ubuf == NULL;
     for (uint8_t chan = 0; chan < upipe_agraph->channels; chan++) {
         double amplitude = 0.;
         if (unlikely(!ubase_check(uref_amax_get_amplitude(uref, &amplitude,
@@ -322,60 +390,97 @@ static bool upipe_agraph_handle(struct upipe *upipe, struct uref *uref,
         scale = iec_scale(scale);
 
         if (unlikely(upipe_agraph->prev[chan] == NULL)) {
-            upipe_agraph->prev[chan] =
-                malloc(upipe_agraph->chan_hist * sizeof(double));
+            upipe_agraph->prev[chan] = malloc(hist * sizeof(double));
             if (unlikely(upipe_agraph->prev[chan] == NULL)) {
                 upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
                 uref_free(uref);
                 return true;
             }
-            for (uint64_t i = 0; i < upipe_agraph->chan_hist - 1; i++)
+            for (uint64_t i = 0; i < hist; i++)
                 upipe_agraph->prev[chan][i] = 0.;
+            /* an empty history is drawn as the background */
+            upipe_agraph->same[chan] = hist;
         } else {
             memmove(&upipe_agraph->prev[chan][0], &upipe_agraph->prev[chan][1],
-                    (upipe_agraph->chan_hist - 1) * sizeof(double));
+                    (hist - 1) * sizeof(double));
         }
 
-        upipe_agraph->prev[chan][upipe_agraph->chan_hist - 1] = scale;
-
-        for (uint64_t i = 0; i < upipe_agraph->chan_hist; i++) {
-            scale = upipe_agraph->prev[chan][i];
-            const int hmax = h - scale * h;
-            for (int row = 0; row < h; row++) {
-                bool bright = (i == upipe_agraph->chan_hist - 1);
-
-                const uint8_t *color = row < hmax ? black :
-                                       row < hred ? red[!bright] :
-                                       row < hyellow ? yellow[!bright] :
-                                       green[!bright];
-
-                if (!i && upipe_agraph->sep_width)
-                    copy_color(dst, strides, hsubs, vsubs, black, row,
-                               chan * upipe_agraph->chan_width,
-                               upipe_agraph->sep_width);
-                copy_color(dst, strides, hsubs, vsubs, color, row,
-                           upipe_agraph->sep_width +
-                           chan * upipe_agraph->chan_width + 2 * i,
-                           2);
-
-                if (chan == upipe_agraph->channels - 1 &&
-                    upipe_agraph->pad_width)
-                    copy_color(dst, strides, hsubs, vsubs, transparent, row,
-                               (chan + 1) * upipe_agraph->chan_width,
-                               upipe_agraph->pad_width);
+        /* the picture only depends on the height of each value */
+        int hmax = h - scale * h;
+        int last = h - upipe_agraph->prev[chan][hist - 1] * h;
+        upipe_agraph->prev[chan][hist - 1] = scale;
+        if (hmax == last) {
+            if (upipe_agraph->same[chan] <= hist)
+                upipe_agraph->same[chan]++;
+        } else
+            upipe_agraph->same[chan] = 1;
+        if (upipe_agraph->same[chan] <= hist)
+            changed = true;
+    }
+
+    struct ubuf *ubuf;
+    if (!changed) {
+        ubuf = ubuf_dup(upipe_agraph->ubuf);
+    } else if (upipe_agraph->ubuf == NULL) {
+        ubuf = upipe_agraph_draw_background(upipe);
+    } else {
+        ubuf = ubuf_pic_copy(upipe_agraph->ubuf_mgr, upipe_agraph->ubuf,
+                             0, 0, -1, -1);
+        for (uint8_t chan = 0; ubuf != NULL && chan < upipe_agraph->channels;
+             chan++) {
+            if (hist < 2)
+                break;
+            unsigned col = upipe_agraph->sep_width +
+                           chan * upipe_agraph->chan_width;
+            if (unlikely(!ubase_check(ubuf_pic_blit(ubuf, upipe_agraph->ubuf,
+                                col, 0, col + 2, 0,
+                                2 * (hist - 1), h, 0xff, 0)))) {
+                ubuf_free(ubuf);
+                ubuf = NULL;
             }
         }
     }
+    if (unlikely(ubuf == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        uref_free(uref);
+        return true;
+    }
+    uref_attach_ubuf(uref, ubuf);
 
-    /* dB marks */
-    for (int i = 1; i <= 6; i++) {
-        int row = h - (iec_scale(-10 * i) * h);
-        copy_color(dst, strides, hsubs, vsubs, black, row, 0,
-                   upipe_agraph->hsize);
+    if (changed) {
+        uint8_t *dst[4];
+        size_t strides[4];
+        uint8_t hsubs[4];
+        uint8_t vsubs[4];
+        static const char *chroma[3] = { "y8", "u8", "v8" };
+        for (int i = 0; i < 3; i++) {
+            if (unlikely(!ubase_check(uref_pic_plane_write(uref, chroma[i],
+                                0, 0, -1, -1, &dst[i])) ||
+                         !ubase_check(uref_pic_plane_size(uref, chroma[i],
+                                 &strides[i], &hsubs[i], &vsubs[i], NULL)))) {
+                 upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                 uref_free(uref);
+                 return true;
+            }
+        }
+
+        /* the previous last value is dimmed, the new one is drawn bright */
+        for (uint8_t chan = 0; chan < upipe_agraph->channels; chan++) {
+            if (hist >= 2)
+                upipe_agraph_draw_column(upipe, dst, strides, hsubs, vsubs,
+                                         chan, hist - 2);
+            upipe_agraph_draw_column(upipe, dst, strides, hsubs, vsubs,
+                                     chan, hist - 1);
+        }
+
+        for (int i = 0; i < 3; i++)
+            ubuf_pic_plane_unmap(ubuf, chroma[i], 0, 0, -1, -1);
+
+        if (upipe_agraph->ubuf != NULL)
+            ubuf_free(upipe_agraph->ubuf);
+        upipe_agraph->ubuf = ubuf_dup(ubuf);
     }
 
-    for (int i = 0; i < 3; i++)
-        ubuf_pic_plane_unmap(ubuf, chroma[i], 0, 0, -1, -1);
     upipe_agraph_output(upipe, uref, upump_p);
     return true;
 }
@@ -455,6 +560,9 @@ static int upipe_agraph_check_ubuf_mgr(struct upipe *upipe,
         free(upipe_agraph->prev[i]);
         upipe_agraph->prev[i] = NULL;
     }
+    if (upipe_agraph->ubuf != NULL)
+        ubuf_free(upipe_agraph->ubuf);
+    upipe_agraph->ubuf = NULL;
 
     bool was_buffered = !upipe_agraph_check_input(upipe);
     upipe_agraph_output_input(upipe);
@@ -539,6 +647,8 @@ static void upipe_agraph_free(struct upipe *upipe)
     struct upipe_agraph *upipe_agraph = upipe_agraph_from_upipe(upipe);
     for (int i = 0; i < 255; i++)
         free(upipe_agraph->prev[i]);
+    if (upipe_agraph->ubuf != NULL)
+        ubuf_free(upipe_agraph->ubuf);
     uref_free(upipe_agraph->flow_def_config);
     upipe_agraph_clean_flow_format(upipe);
     upipe_agraph_clean_ubuf_mgr(upipe);
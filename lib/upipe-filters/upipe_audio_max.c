@@ -36,13 +36,16 @@
 #include <upipe/upipe_helper_output.h>
 #include <upipe-filters/upipe_audio_max.h>
 
+#include "upipe_audio_peak.h"
+
 #include <stdlib.h>
 #include <strings.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <math.h>
 
-typedef double (*upipe_amax_process)(struct upipe *, struct uref *,
-                                     const char *, size_t);
+typedef void (*upipe_amax_process)(struct upipe *, struct uref *,
+                                   const char *, size_t, double *, double *);
 
 /** @internal upipe_amax private structure */
 struct upipe_amax {
@@ -94,39 +97,85 @@ static struct upipe *upipe_amax_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
-#define UPIPE_AMAX_TEMPLATE(type, type_max)                                 \
+/** @internal @This computes the peak and the sum of squares of u8 samples.
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak_p filled in with the maximum value
+ * @param sum_p filled in with the sum of squares
+ */
+static void upipe_amax_peak_u8(const uint8_t *buf, size_t samples,
+                               uint32_t *peak_p, uint64_t *sum_p)
+{
+    uint32_t peak = 0;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < samples; i++) {
+        if (buf[i] > peak)
+            peak = buf[i];
+        sum += buf[i] * buf[i];
+    }
+    *peak_p = peak;
+    *sum_p = sum;
+}
+
+/** @internal @This computes the peak and the sum of squares of f64 samples.
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+static void upipe_amax_peak_f64(const double *buf, size_t samples,
+                                double *peak_p, double *sum_p)
+{
+    double peak = 0., sum = 0.;
+    for (size_t i = 0; i < samples; i++) {
+        double a = fabs(buf[i]);
+        if (a > peak)
+            peak = a;
+        sum += buf[i] * buf[i];
+    }
+    *peak_p = peak;
+    *sum_p = sum;
+}
+
+#define UPIPE_AMAX_TEMPLATE(type, type_max, peak_type, sum_type, kernel)    \
 /** @internal @This processes input of format type.                         \
  *                                                                          \
  * @param upipe description structure of the pipe                           \
  * @param uref uref structure                                               \
  * @param channel channel name                                              \
  * @param samples number of samples                                         \
+ * @param peak_p filled in with the normalized peak amplitude               \
+ * @param rms_p filled in with the normalized RMS amplitude                 \
  */                                                                         \
-static double upipe_amax_process_##type(struct upipe *upipe,                \
-        struct uref *uref, const char *channel, size_t samples)             \
+static void upipe_amax_process_##type(struct upipe *upipe,                  \
+        struct uref *uref, const char *channel, size_t samples,             \
+        double *peak_p, double *rms_p)                                      \
 {                                                                           \
     const type *buf = NULL;                                                 \
+    *peak_p = *rms_p = 0.;                                                  \
     if (unlikely(!ubase_check(uref_sound_plane_read_##type(uref,            \
             channel, 0, -1, &buf)))) {                                      \
         upipe_warn(upipe, "error mapping sound buffer");                    \
-        return 0.;                                                          \
-    }                                                                       \
-    type max = 0;                                                           \
-    for (size_t i = 0; i < samples; i++) {                                  \
-        type c = buf[i];                                                    \
-        if (c > max)                                                        \
-            max = c;                                                        \
-        else if (-c > max)                                                  \
-            max = -c;                                                       \
+        return;                                                             \
     }                                                                       \
+    peak_type peak;                                                         \
+    sum_type sum;                                                           \
+    kernel(buf, samples, &peak, &sum);                                      \
     uref_sound_plane_unmap(uref, channel, 0, -1);                           \
-    return (max * 1.0f) / type_max;                                         \
+    *peak_p = (peak * 1.0f) / type_max;                                     \
+    if (samples)                                                            \
+        *rms_p = sqrt((double)sum / samples) / type_max;                    \
 }
-UPIPE_AMAX_TEMPLATE(uint8_t, UINT8_MAX)
-UPIPE_AMAX_TEMPLATE(int16_t, INT16_MAX)
-UPIPE_AMAX_TEMPLATE(int32_t, INT32_MAX)
-UPIPE_AMAX_TEMPLATE(float, 1.)
-UPIPE_AMAX_TEMPLATE(double, 1.)
+UPIPE_AMAX_TEMPLATE(uint8_t, UINT8_MAX, uint32_t, uint64_t,
+                    upipe_amax_peak_u8)
+UPIPE_AMAX_TEMPLATE(int16_t, INT16_MAX, uint32_t, uint64_t,
+                    upipe_audio_peak_s16)
+UPIPE_AMAX_TEMPLATE(int32_t, INT32_MAX, uint32_t, double,
+                    upipe_audio_peak_s32)
+UPIPE_AMAX_TEMPLATE(float, 1., float, double, upipe_audio_peak_f32)
+UPIPE_AMAX_TEMPLATE(double, 1., double, double, upipe_amax_peak_f64)
 #undef UPIPE_AMAX_TEMPLATE
 
 /** @internal @This handles input.
@@ -154,8 +203,10 @@ static void upipe_amax_input(struct upipe *upipe, struct uref *uref,
     const char *channel = NULL;
     uint8_t j = 0;
     while (ubase_check(uref_sound_plane_iterate(uref, &channel)) && channel) {
-        double maxf = upipe_amax->process(upipe, uref, channel, samples);
-        uref_amax_set_amplitude(uref, maxf, j++);
+        double maxf, rms;
+        upipe_amax->process(upipe, uref, channel, samples, &maxf, &rms);
+        uref_amax_set_amplitude(uref, maxf, j);
+        uref_amax_set_rms(uref, rms, j++);
     }
 
     upipe_amax_output(upipe, uref, upump_p);
@@ -0,0 +1,529 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe peak and RMS kernels for audio meters
+ */
+
+#include "upipe_audio_peak.h"
+
+#include <math.h>
+
+#if defined(__i686__) || defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/* The vector variants keep the maximum and the minimum separately, so that
+ * INT16_MIN and INT32_MIN are handled without overflowing the absolute value,
+ * and process the remaining samples with the scalar loops below. */
+
+/** @internal @This processes s16 samples one at a time.
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak maximum absolute value so far
+ * @param sum sum of squares so far
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+static inline void upipe_audio_peak_s16_tail(const int16_t *buf,
+        size_t samples, uint32_t peak, uint64_t sum,
+        uint32_t *peak_p, uint64_t *sum_p)
+{
+    for (size_t i = 0; i < samples; i++) {
+        int32_t c = buf[i];
+        uint32_t a = c < 0 ? -c : c;
+        if (a > peak)
+            peak = a;
+        sum += (uint64_t)(c * c);
+    }
+    *peak_p = peak;
+    *sum_p = sum;
+}
+
+/** @internal @This processes s32 samples one at a time.
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak maximum absolute value so far
+ * @param sum sum of squares so far
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+static inline void upipe_audio_peak_s32_tail(const int32_t *buf,
+        size_t samples, uint32_t peak, double sum,
+        uint32_t *peak_p, double *sum_p)
+{
+    for (size_t i = 0; i < samples; i++) {
+        int64_t c = buf[i];
+        uint32_t a = c < 0 ? -c : c;
+        if (a > peak)
+            peak = a;
+        sum += (double)c * c;
+    }
+    *peak_p = peak;
+    *sum_p = sum;
+}
+
+/** @internal @This processes f32 samples one at a time.
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak maximum absolute value so far
+ * @param sum sum of squares so far
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+static inline void upipe_audio_peak_f32_tail(const float *buf,
+        size_t samples, float peak, double sum,
+        float *peak_p, double *sum_p)
+{
+    for (size_t i = 0; i < samples; i++) {
+        float a = fabsf(buf[i]);
+        if (a > peak)
+            peak = a;
+        sum += (double)buf[i] * buf[i];
+    }
+    *peak_p = peak;
+    *sum_p = sum;
+}
+
+/** @This computes the peak and the sum of squares of s16 samples, one at a
+ * time.
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+void upipe_audio_peak_s16_c(const int16_t *buf, size_t samples,
+                            uint32_t *peak_p, uint64_t *sum_p)
+{
+    upipe_audio_peak_s16_tail(buf, samples, 0, 0, peak_p, sum_p);
+}
+
+/** @This computes the peak and the sum of squares of s32 samples, one at a
+ * time.
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+void upipe_audio_peak_s32_c(const int32_t *buf, size_t samples,
+                            uint32_t *peak_p, double *sum_p)
+{
+    upipe_audio_peak_s32_tail(buf, samples, 0, 0., peak_p, sum_p);
+}
+
+/** @This computes the peak and the sum of squares of f32 samples, one at a
+ * time.
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+void upipe_audio_peak_f32_c(const float *buf, size_t samples,
+                            float *peak_p, double *sum_p)
+{
+    upipe_audio_peak_f32_tail(buf, samples, 0., 0., peak_p, sum_p);
+}
+
+#if defined(__i686__) || defined(__x86_64__)
+/** @This computes the peak and the sum of squares of s16 samples, 8 at a
+ * time (SSE2).
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+__attribute__((target("sse2")))
+void upipe_audio_peak_s16_sse2(const int16_t *buf, size_t samples,
+                               uint32_t *peak_p, uint64_t *sum_p)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i max = zero, min = zero, sum = zero;
+    size_t i;
+    for (i = 0; i + 8 <= samples; i += 8) {
+        __m128i c = _mm_loadu_si128((const __m128i *)(buf + i));
+        max = _mm_max_epi16(max, c);
+        min = _mm_min_epi16(min, c);
+        /* each pair of squares fits in an unsigned 32-bit integer */
+        __m128i sq = _mm_madd_epi16(c, c);
+        sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(sq, zero));
+        sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(sq, zero));
+    }
+
+    int16_t maxs[8], mins[8];
+    uint64_t sums[2];
+    _mm_storeu_si128((__m128i *)maxs, max);
+    _mm_storeu_si128((__m128i *)mins, min);
+    _mm_storeu_si128((__m128i *)sums, sum);
+    uint32_t peak = 0;
+    for (int j = 0; j < 8; j++) {
+        if (maxs[j] > (int32_t)peak)
+            peak = maxs[j];
+        if (-mins[j] > (int32_t)peak)
+            peak = -mins[j];
+    }
+    upipe_audio_peak_s16_tail(buf + i, samples - i, peak, sums[0] + sums[1],
+                              peak_p, sum_p);
+}
+
+/** @This computes the peak and the sum of squares of f32 samples, 4 at a
+ * time (SSE2).
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+__attribute__((target("sse2")))
+void upipe_audio_peak_f32_sse2(const float *buf, size_t samples,
+                               float *peak_p, double *sum_p)
+{
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 max = _mm_setzero_ps();
+    __m128d sum = _mm_setzero_pd();
+    size_t i;
+    for (i = 0; i + 4 <= samples; i += 4) {
+        __m128 c = _mm_loadu_ps(buf + i);
+        /* NaN samples are ignored, like in the scalar loop */
+        max = _mm_max_ps(_mm_and_ps(c, abs_mask), max);
+        __m128d lo = _mm_cvtps_pd(c);
+        __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(c, c));
+        sum = _mm_add_pd(sum, _mm_add_pd(_mm_mul_pd(lo, lo),
+                                         _mm_mul_pd(hi, hi)));
+    }
+
+    float maxs[4];
+    double sums[2];
+    _mm_storeu_ps(maxs, max);
+    _mm_storeu_pd(sums, sum);
+    float peak = 0.;
+    for (int j = 0; j < 4; j++)
+        if (maxs[j] > peak)
+            peak = maxs[j];
+    upipe_audio_peak_f32_tail(buf + i, samples - i, peak, sums[0] + sums[1],
+                              peak_p, sum_p);
+}
+
+/** @This computes the peak and the sum of squares of s16 samples, 16 at a
+ * time (AVX2).
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+__attribute__((target("avx2")))
+void upipe_audio_peak_s16_avx2(const int16_t *buf, size_t samples,
+                               uint32_t *peak_p, uint64_t *sum_p)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i max = zero, min = zero, sum = zero;
+    size_t i;
+    for (i = 0; i + 16 <= samples; i += 16) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(buf + i));
+        max = _mm256_max_epi16(max, c);
+        min = _mm256_min_epi16(min, c);
+        /* each pair of squares fits in an unsigned 32-bit integer */
+        __m256i sq = _mm256_madd_epi16(c, c);
+        sum = _mm256_add_epi64(sum, _mm256_unpacklo_epi32(sq, zero));
+        sum = _mm256_add_epi64(sum, _mm256_unpackhi_epi32(sq, zero));
+    }
+
+    int16_t maxs[16], mins[16];
+    uint64_t sums[4];
+    _mm256_storeu_si256((__m256i *)maxs, max);
+    _mm256_storeu_si256((__m256i *)mins, min);
+    _mm256_storeu_si256((__m256i *)sums, sum);
+    uint32_t peak = 0;
+    for (int j = 0; j < 16; j++) {
+        if (maxs[j] > (int32_t)peak)
+            peak = maxs[j];
+        if (-mins[j] > (int32_t)peak)
+            peak = -mins[j];
+    }
+    upipe_audio_peak_s16_tail(buf + i, samples - i, peak,
+                              sums[0] + sums[1] + sums[2] + sums[3],
+                              peak_p, sum_p);
+}
+
+/** @This computes the peak and the sum of squares of s32 samples, 8 at a
+ * time (AVX2).
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+__attribute__((target("avx2")))
+void upipe_audio_peak_s32_avx2(const int32_t *buf, size_t samples,
+                               uint32_t *peak_p, double *sum_p)
+{
+    __m256i max = _mm256_setzero_si256(), min = _mm256_setzero_si256();
+    __m256d sum = _mm256_setzero_pd();
+    size_t i;
+    for (i = 0; i + 8 <= samples; i += 8) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(buf + i));
+        max = _mm256_max_epi32(max, c);
+        min = _mm256_min_epi32(min, c);
+        __m256d lo = _mm256_cvtepi32_pd(_mm256_castsi256_si128(c));
+        __m256d hi = _mm256_cvtepi32_pd(_mm256_extracti128_si256(c, 1));
+        sum = _mm256_add_pd(sum, _mm256_add_pd(_mm256_mul_pd(lo, lo),
+                                               _mm256_mul_pd(hi, hi)));
+    }
+
+    int32_t maxs[8], mins[8];
+    double sums[4];
+    _mm256_storeu_si256((__m256i *)maxs, max);
+    _mm256_storeu_si256((__m256i *)mins, min);
+    _mm256_storeu_pd(sums, sum);
+    uint32_t peak = 0;
+    for (int j = 0; j < 8; j++) {
+        if ((uint32_t)maxs[j] > peak)
+            peak = maxs[j];
+        if ((uint32_t)-(int64_t)mins[j] > peak)
+            peak = -(int64_t)mins[j];
+    }
+    upipe_audio_peak_s32_tail(buf + i, samples - i, peak,
+                              (sums[0] + sums[1]) + (sums[2] + sums[3]),
+                              peak_p, sum_p);
+}
+
+/** @This computes the peak and the sum of squares of f32 samples, 8 at a
+ * time (AVX2).
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+__attribute__((target("avx2")))
+void upipe_audio_peak_f32_avx2(const float *buf, size_t samples,
+                               float *peak_p, double *sum_p)
+{
+    const __m256 abs_mask =
+        _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 max = _mm256_setzero_ps();
+    __m256d sum = _mm256_setzero_pd();
+    size_t i;
+    for (i = 0; i + 8 <= samples; i += 8) {
+        __m256 c = _mm256_loadu_ps(buf + i);
+        /* NaN samples are ignored, like in the scalar loop */
+        max = _mm256_max_ps(_mm256_and_ps(c, abs_mask), max);
+        __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(c));
+        __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(c, 1));
+        sum = _mm256_add_pd(sum, _mm256_add_pd(_mm256_mul_pd(lo, lo),
+                                               _mm256_mul_pd(hi, hi)));
+    }
+
+    float maxs[8];
+    double sums[4];
+    _mm256_storeu_ps(maxs, max);
+    _mm256_storeu_pd(sums, sum);
+    float peak = 0.;
+    for (int j = 0; j < 8; j++)
+        if (maxs[j] > peak)
+            peak = maxs[j];
+    upipe_audio_peak_f32_tail(buf + i, samples - i, peak,
+                              (sums[0] + sums[1]) + (sums[2] + sums[3]),
+                              peak_p, sum_p);
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/** @This computes the peak and the sum of squares of s16 samples, 8 at a
+ * time (NEON).
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+void upipe_audio_peak_s16_neon(const int16_t *buf, size_t samples,
+                               uint32_t *peak_p, uint64_t *sum_p)
+{
+    int16x8_t max = vdupq_n_s16(0), min = vdupq_n_s16(0);
+    int64x2_t sum = vdupq_n_s64(0);
+    size_t i;
+    for (i = 0; i + 8 <= samples; i += 8) {
+        int16x8_t c = vld1q_s16(buf + i);
+        max = vmaxq_s16(max, c);
+        min = vminq_s16(min, c);
+        int16x4_t lo = vget_low_s16(c);
+        sum = vpadalq_s32(sum, vmull_s16(lo, lo));
+        sum = vpadalq_s32(sum, vmull_high_s16(c, c));
+    }
+
+    uint32_t peak = vmaxvq_s16(max);
+    int32_t neg = -(int32_t)vminvq_s16(min);
+    if (neg > (int32_t)peak)
+        peak = neg;
+    upipe_audio_peak_s16_tail(buf + i, samples - i, peak, vaddvq_s64(sum),
+                              peak_p, sum_p);
+}
+
+/** @This computes the peak and the sum of squares of s32 samples, 4 at a
+ * time (NEON).
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+void upipe_audio_peak_s32_neon(const int32_t *buf, size_t samples,
+                               uint32_t *peak_p, double *sum_p)
+{
+    int32x4_t max = vdupq_n_s32(0), min = vdupq_n_s32(0);
+    float64x2_t sum = vdupq_n_f64(0.);
+    size_t i;
+    for (i = 0; i + 4 <= samples; i += 4) {
+        int32x4_t c = vld1q_s32(buf + i);
+        max = vmaxq_s32(max, c);
+        min = vminq_s32(min, c);
+        float64x2_t lo = vcvtq_f64_s64(vmovl_s32(vget_low_s32(c)));
+        float64x2_t hi = vcvtq_f64_s64(vmovl_high_s32(c));
+        sum = vaddq_f64(sum, vaddq_f64(vmulq_f64(lo, lo),
+                                       vmulq_f64(hi, hi)));
+    }
+
+    uint32_t peak = vmaxvq_s32(max);
+    uint32_t neg = -(int64_t)vminvq_s32(min);
+    if (neg > peak)
+        peak = neg;
+    upipe_audio_peak_s32_tail(buf + i, samples - i, peak, vaddvq_f64(sum),
+                              peak_p, sum_p);
+}
+
+/** @This computes the peak and the sum of squares of f32 samples, 4 at a
+ * time (NEON).
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+void upipe_audio_peak_f32_neon(const float *buf, size_t samples,
+                               float *peak_p, double *sum_p)
+{
+    float32x4_t max = vdupq_n_f32(0.);
+    float64x2_t sum = vdupq_n_f64(0.);
+    size_t i;
+    for (i = 0; i + 4 <= samples; i += 4) {
+        float32x4_t c = vld1q_f32(buf + i);
+        /* NaN samples are ignored, like in the scalar loop */
+        max = vmaxnmq_f32(max, vabsq_f32(c));
+        float64x2_t lo = vcvt_f64_f32(vget_low_f32(c));
+        float64x2_t hi = vcvt_high_f64_f32(c);
+        sum = vaddq_f64(sum, vaddq_f64(vmulq_f64(lo, lo),
+                                       vmulq_f64(hi, hi)));
+    }
+
+    upipe_audio_peak_f32_tail(buf + i, samples - i, vmaxnmvq_f32(max),
+                              vaddvq_f64(sum), peak_p, sum_p);
+}
+#endif
+
+/** @This computes the peak and the sum of squares of s16 samples, using the
+ * fastest variant supported by the CPU.
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+void upipe_audio_peak_s16(const int16_t *buf, size_t samples,
+                          uint32_t *peak_p, uint64_t *sum_p)
+{
+#if defined(__i686__) || defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) {
+        upipe_audio_peak_s16_avx2(buf, samples, peak_p, sum_p);
+        return;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        upipe_audio_peak_s16_sse2(buf, samples, peak_p, sum_p);
+        return;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    upipe_audio_peak_s16_neon(buf, samples, peak_p, sum_p);
+    return;
+#endif
+    upipe_audio_peak_s16_c(buf, samples, peak_p, sum_p);
+}
+
+/** @This computes the peak and the sum of squares of s32 samples, using the
+ * fastest variant supported by the CPU.
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+void upipe_audio_peak_s32(const int32_t *buf, size_t samples,
+                          uint32_t *peak_p, double *sum_p)
+{
+#if defined(__i686__) || defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) {
+        upipe_audio_peak_s32_avx2(buf, samples, peak_p, sum_p);
+        return;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    upipe_audio_peak_s32_neon(buf, samples, peak_p, sum_p);
+    return;
+#endif
+    upipe_audio_peak_s32_c(buf, samples, peak_p, sum_p);
+}
+
+/** @This computes the peak and the sum of squares of f32 samples, using the
+ * fastest variant supported by the CPU.
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param peak_p filled in with the maximum absolute value
+ * @param sum_p filled in with the sum of squares
+ */
+void upipe_audio_peak_f32(const float *buf, size_t samples,
+                          float *peak_p, double *sum_p)
+{
+#if defined(__i686__) || defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) {
+        upipe_audio_peak_f32_avx2(buf, samples, peak_p, sum_p);
+        return;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        upipe_audio_peak_f32_sse2(buf, samples, peak_p, sum_p);
+        return;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    upipe_audio_peak_f32_neon(buf, samples, peak_p, sum_p);
+    return;
+#endif
+    upipe_audio_peak_f32_c(buf, samples, peak_p, sum_p);
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe peak and RMS kernels for audio meters
+ * The variants below are called by the upipe_audio_peak_* functions, which
+ * pick the fastest one supported by the CPU. They are exported for checkasm.
+ *
+ * Each kernel returns the maximum absolute value of the samples, and the sum
+ * of their squares, from which the RMS value is derived.
+ */
+
+#ifndef _UPIPE_FILTERS_UPIPE_AUDIO_PEAK_H_
+/** @hidden */
+#define _UPIPE_FILTERS_UPIPE_AUDIO_PEAK_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** @This defines the kernels for a sample format.
+ *
+ * @param fmt name of the sample format
+ * @param type type of a sample
+ * @param peak_type type of the peak value
+ * @param sum_type type of the sum of squares
+ */
+#define UPIPE_AUDIO_PEAK_DECLARE(fmt, type, peak_type, sum_type)            \
+/** @This computes the peak and the sum of squares of fmt samples.          \
+ *                                                                          \
+ * @param buf samples                                                       \
+ * @param samples number of samples                                         \
+ * @param peak_p filled in with the maximum absolute value                  \
+ * @param sum_p filled in with the sum of squares                           \
+ */                                                                         \
+typedef void (*upipe_audio_peak_##fmt##_func)(const type *buf,              \
+        size_t samples, peak_type *peak_p, sum_type *sum_p);                \
+                                                                            \
+/** @This computes the peak and the sum of squares of fmt samples, using    \
+ * the fastest variant supported by the CPU.                                \
+ *                                                                          \
+ * @param buf samples                                                       \
+ * @param samples number of samples                                         \
+ * @param peak_p filled in with the maximum absolute value                  \
+ * @param sum_p filled in with the sum of squares                           \
+ */                                                                         \
+void upipe_audio_peak_##fmt(const type *buf, size_t samples,                \
+                            peak_type *peak_p, sum_type *sum_p);
+
+UPIPE_AUDIO_PEAK_DECLARE(s16, int16_t, uint32_t, uint64_t)
+UPIPE_AUDIO_PEAK_DECLARE(s32, int32_t, uint32_t, double)
+UPIPE_AUDIO_PEAK_DECLARE(f32, float, float, double)
+#undef UPIPE_AUDIO_PEAK_DECLARE
+
+/* one sample at a time */
+void upipe_audio_peak_s16_c(const int16_t *buf, size_t samples,
+                            uint32_t *peak_p, uint64_t *sum_p);
+void upipe_audio_peak_s32_c(const int32_t *buf, size_t samples,
+                            uint32_t *peak_p, double *sum_p);
+void upipe_audio_peak_f32_c(const float *buf, size_t samples,
+                            float *peak_p, double *sum_p);
+
+#if defined(__i686__) || defined(__x86_64__)
+/* 8 (s16) or 4 (f32) samples at a time */
+void upipe_audio_peak_s16_sse2(const int16_t *buf, size_t samples,
+                               uint32_t *peak_p, uint64_t *sum_p);
+void upipe_audio_peak_f32_sse2(const float *buf, size_t samples,
+                               float *peak_p, double *sum_p);
+
+/* 16 (s16) or 8 (s32, f32) samples at a time */
+void upipe_audio_peak_s16_avx2(const int16_t *buf, size_t samples,
+                               uint32_t *peak_p, uint64_t *sum_p);
+void upipe_audio_peak_s32_avx2(const int32_t *buf, size_t samples,
+                               uint32_t *peak_p, double *sum_p);
+void upipe_audio_peak_f32_avx2(const float *buf, size_t samples,
+                               float *peak_p, double *sum_p);
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/* 8 (s16) or 4 (s32, f32) samples at a time */
+void upipe_audio_peak_s16_neon(const int16_t *buf, size_t samples,
+                               uint32_t *peak_p, uint64_t *sum_p);
+void upipe_audio_peak_s32_neon(const int32_t *buf, size_t samples,
+                               uint32_t *peak_p, double *sum_p);
+void upipe_audio_peak_f32_neon(const float *buf, size_t samples,
+                               float *peak_p, double *sum_p);
+#endif
+
+#endif
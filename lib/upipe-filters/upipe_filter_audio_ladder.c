@@ -0,0 +1,650 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Bin pipe encoding a sound flow into several renditions
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/ulist.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uref.h>
+#include <upipe/uref_flow.h>
+#include <upipe/udict.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_inner.h>
+#include <upipe/upipe_helper_uprobe.h>
+#include <upipe/upipe_helper_bin_input.h>
+#include <upipe/upipe_helper_bin_output.h>
+#include <upipe/upipe_helper_subpipe.h>
+#include <upipe-modules/upipe_dup.h>
+#include <upipe-modules/upipe_worker_linear.h>
+#include <upipe-modules/upipe_worker_pool.h>
+#include <upipe-filters/upipe_filter_audio_ladder.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+
+/** @internal @This is the private context of a flad manager. */
+struct upipe_flad_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** pointer to dup manager */
+    struct upipe_mgr *dup_mgr;
+    /** pointer to convert manager */
+    struct upipe_mgr *convert_mgr;
+    /** pointer to encode manager */
+    struct upipe_mgr *encode_mgr;
+
+    /** pool of worker threads running the encoders */
+    struct upipe_work_pool workers;
+
+    /** public upipe_mgr structure */
+    struct upipe_mgr mgr;
+};
+
+UBASE_FROM_TO(upipe_flad_mgr, upipe_mgr, upipe_mgr, mgr)
+UBASE_FROM_TO(upipe_flad_mgr, urefcount, urefcount, urefcount)
+
+/** @internal @This is the private context of a conversion stage, shared by
+ * all the renditions requesting the same format. */
+struct upipe_flad_conv {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** target format */
+    struct uref *format;
+    /** number of renditions using this stage */
+    unsigned int users;
+
+    /** output of the input dup pipe */
+    struct upipe *input;
+    /** convert inner pipe */
+    struct upipe *convert;
+    /** dup pipe feeding the renditions */
+    struct upipe *dup;
+};
+
+UBASE_FROM_TO(upipe_flad_conv, uchain, uchain, uchain)
+
+/** @internal @This is the private context of a flad pipe. */
+struct upipe_flad {
+    /** real refcount management structure */
+    struct urefcount urefcount_real;
+    /** refcount management structure exported to the public structure */
+    struct urefcount urefcount;
+
+    /** probe for the inner pipes */
+    struct uprobe proxy_probe;
+
+    /** list of input bin requests */
+    struct uchain input_request_list;
+    /** first inner pipe of the bin (dup) */
+    struct upipe *dup;
+
+    /** list of conversion stages */
+    struct uchain convs;
+
+    /** list of renditions */
+    struct uchain outputs;
+    /** manager to create renditions */
+    struct upipe_mgr sub_mgr;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_flad, upipe, UPIPE_FLAD_SIGNATURE)
+UPIPE_HELPER_VOID(upipe_flad)
+UPIPE_HELPER_UREFCOUNT(upipe_flad, urefcount, upipe_flad_no_ref)
+UPIPE_HELPER_UPROBE(upipe_flad, urefcount_real, proxy_probe, NULL)
+UPIPE_HELPER_INNER(upipe_flad, dup)
+UPIPE_HELPER_BIN_INPUT(upipe_flad, dup, input_request_list)
+
+UBASE_FROM_TO(upipe_flad, urefcount, urefcount_real, urefcount_real)
+
+/** @hidden */
+static void upipe_flad_free(struct urefcount *urefcount_real);
+
+/** @internal @This is the private context of a rendition of a flad pipe. */
+struct upipe_flad_output {
+    /** real refcount management structure */
+    struct urefcount urefcount_real;
+    /** refcount management structure exported to the public structure */
+    struct urefcount urefcount;
+    /** structure for double-linked lists */
+    struct uchain uchain;
+
+    /** conversion stage */
+    struct upipe_flad_conv *conv;
+    /** output of the dup pipe of the conversion stage */
+    struct upipe *input;
+
+    /** probe for the last inner pipe */
+    struct uprobe last_inner_probe;
+    /** list of output bin requests */
+    struct uchain output_request_list;
+    /** last inner pipe of the bin (encoder or worker) */
+    struct upipe *last_inner;
+    /** output */
+    struct upipe *output;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_flad_output, upipe, UPIPE_FLAD_OUTPUT_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_flad_output, urefcount, upipe_flad_output_no_ref)
+UPIPE_HELPER_INNER(upipe_flad_output, last_inner)
+UPIPE_HELPER_UPROBE(upipe_flad_output, urefcount_real, last_inner_probe, NULL)
+UPIPE_HELPER_BIN_OUTPUT(upipe_flad_output, last_inner, output,
+                        output_request_list)
+
+UPIPE_HELPER_SUBPIPE(upipe_flad, upipe_flad_output, output, sub_mgr, outputs,
+                     uchain)
+
+UBASE_FROM_TO(upipe_flad_output, urefcount, urefcount_real, urefcount_real)
+
+/** @hidden */
+static void upipe_flad_output_free(struct urefcount *urefcount_real);
+
+/** @internal @This releases a conversion stage, and frees it when it is not
+ * used by any rendition anymore.
+ *
+ * @param conv description structure of the conversion stage
+ */
+static void upipe_flad_conv_release(struct upipe_flad_conv *conv)
+{
+    if (--conv->users)
+        return;
+
+    ulist_delete(upipe_flad_conv_to_uchain(conv));
+    upipe_release(conv->input);
+    upipe_release(conv->convert);
+    upipe_release(conv->dup);
+    uref_free(conv->format);
+    free(conv);
+}
+
+/** @internal @This returns the conversion stage to the given format,
+ * allocating it if it doesn't exist yet.
+ *
+ * @param upipe description structure of the pipe
+ * @param format target format
+ * @return pointer to the conversion stage, or NULL in case of error
+ */
+static struct upipe_flad_conv *upipe_flad_conv_use(struct upipe *upipe,
+                                                   struct uref *format)
+{
+    struct upipe_flad *upipe_flad = upipe_flad_from_upipe(upipe);
+    struct upipe_flad_mgr *flad_mgr =
+        upipe_flad_mgr_from_upipe_mgr(upipe->mgr);
+    struct uchain *uchain;
+
+    ulist_foreach (&upipe_flad->convs, uchain) {
+        struct upipe_flad_conv *conv = upipe_flad_conv_from_uchain(uchain);
+        if (format->udict != NULL &&
+            !udict_cmp(conv->format->udict, format->udict) &&
+            !udict_cmp(format->udict, conv->format->udict)) {
+            conv->users++;
+            return conv;
+        }
+    }
+
+    if (unlikely(format->udict == NULL || flad_mgr->convert_mgr == NULL ||
+                 upipe_flad->dup == NULL))
+        return NULL;
+
+    struct upipe_flad_conv *conv = malloc(sizeof(struct upipe_flad_conv));
+    if (unlikely(conv == NULL))
+        return NULL;
+    uchain_init(upipe_flad_conv_to_uchain(conv));
+    conv->users = 1;
+    conv->convert = NULL;
+    conv->dup = NULL;
+    conv->format = uref_dup(format);
+    conv->input = upipe_void_alloc_sub(upipe_flad->dup,
+            uprobe_pfx_alloc(uprobe_use(&upipe_flad->proxy_probe),
+                             UPROBE_LOG_VERBOSE, "conv input"));
+    if (unlikely(conv->format == NULL || conv->input == NULL))
+        goto upipe_flad_conv_use_err;
+
+    conv->convert = upipe_flow_alloc_output(conv->input,
+            flad_mgr->convert_mgr,
+            uprobe_pfx_alloc(uprobe_use(&upipe_flad->proxy_probe),
+                             UPROBE_LOG_VERBOSE, "convert"),
+            format);
+    if (unlikely(conv->convert == NULL))
+        goto upipe_flad_conv_use_err;
+
+    conv->dup = upipe_void_alloc_output(conv->convert, flad_mgr->dup_mgr,
+            uprobe_pfx_alloc(uprobe_use(&upipe_flad->proxy_probe),
+                             UPROBE_LOG_VERBOSE, "conv dup"));
+    if (unlikely(conv->dup == NULL))
+        goto upipe_flad_conv_use_err;
+
+    ulist_add(&upipe_flad->convs, upipe_flad_conv_to_uchain(conv));
+    return conv;
+
+upipe_flad_conv_use_err:
+    upipe_release(conv->input);
+    upipe_release(conv->convert);
+    uref_free(conv->format);
+    free(conv);
+    return NULL;
+}
+
+/** @internal @This allocates the encoder of a rendition, in a worker thread
+ * if the manager has workers.
+ *
+ * @param upipe description structure of the rendition
+ * @param flow_def flow definition of the encoder
+ * @return pointer to the encoder, or NULL in case of error
+ */
+static struct upipe *upipe_flad_output_alloc_encoder(struct upipe *upipe,
+                                                     struct uref *flow_def)
+{
+    struct upipe_flad_output *upipe_flad_output =
+        upipe_flad_output_from_upipe(upipe);
+    struct upipe_flad *upipe_flad = upipe_flad_from_sub_mgr(upipe->mgr);
+    struct upipe_flad_mgr *flad_mgr =
+        upipe_flad_mgr_from_upipe_mgr(upipe_flad_to_upipe(upipe_flad)->mgr);
+
+    if (unlikely(flad_mgr->encode_mgr == NULL))
+        return NULL;
+
+    struct upipe_mgr *worker_mgr = upipe_work_pool_next(&flad_mgr->workers);
+    if (worker_mgr == NULL)
+        return upipe_flow_alloc(flad_mgr->encode_mgr,
+                uprobe_pfx_alloc(
+                    uprobe_use(&upipe_flad_output->last_inner_probe),
+                    UPROBE_LOG_VERBOSE, "encode"),
+                flow_def);
+
+    struct upipe *remote = upipe_flow_alloc(flad_mgr->encode_mgr,
+            uprobe_pfx_alloc(uprobe_use(flad_mgr->workers.uprobe),
+                             UPROBE_LOG_VERBOSE, "encode"),
+            flow_def);
+    if (unlikely(remote == NULL))
+        return NULL;
+
+    return upipe_work_pool_alloc(worker_mgr,
+            uprobe_pfx_alloc(uprobe_use(&upipe_flad_output->last_inner_probe),
+                             UPROBE_LOG_VERBOSE, "encode worker"),
+            remote,
+            uprobe_pfx_alloc(uprobe_use(flad_mgr->workers.uprobe),
+                             UPROBE_LOG_VERBOSE, "encode worker"));
+}
+
+/** @internal @This allocates a rendition of a flad pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *_upipe_flad_output_alloc(struct upipe_mgr *mgr,
+                                              struct uprobe *uprobe,
+                                              uint32_t signature,
+                                              va_list args)
+{
+    if (signature != UPIPE_FLAD_OUTPUT_SIGNATURE) {
+        uprobe_release(uprobe);
+        return NULL;
+    }
+    struct uref *format = va_arg(args, struct uref *);
+    struct uref *flow_def = va_arg(args, struct uref *);
+    if (unlikely(format == NULL || flow_def == NULL)) {
+        uprobe_release(uprobe);
+        return NULL;
+    }
+
+    struct upipe_flad_output *upipe_flad_output =
+        malloc(sizeof(struct upipe_flad_output));
+    if (unlikely(upipe_flad_output == NULL)) {
+        uprobe_release(uprobe);
+        return NULL;
+    }
+    struct upipe *upipe = upipe_flad_output_to_upipe(upipe_flad_output);
+    upipe_init(upipe, mgr, uprobe);
+
+    upipe_flad_output_init_urefcount(upipe);
+    urefcount_init(upipe_flad_output_to_urefcount_real(upipe_flad_output),
+                   upipe_flad_output_free);
+    upipe_flad_output_init_last_inner_probe(upipe);
+    upipe_flad_output_init_bin_output(upipe);
+    upipe_flad_output_init_sub(upipe);
+    upipe_flad_output->conv = NULL;
+    upipe_flad_output->input = NULL;
+    upipe_throw_ready(upipe);
+
+    struct upipe_flad *upipe_flad = upipe_flad_from_sub_mgr(mgr);
+    upipe_flad_output->conv =
+        upipe_flad_conv_use(upipe_flad_to_upipe(upipe_flad), format);
+    if (unlikely(upipe_flad_output->conv == NULL)) {
+        upipe_err(upipe, "unable to allocate conversion stage");
+        upipe_release(upipe);
+        return NULL;
+    }
+
+    struct upipe *encoder = upipe_flad_output_alloc_encoder(upipe, flow_def);
+    if (unlikely(encoder == NULL)) {
+        upipe_err(upipe, "unable to allocate encoder");
+        upipe_release(upipe);
+        return NULL;
+    }
+    upipe_flad_output_store_bin_output(upipe, encoder);
+
+    upipe_flad_output->input =
+        upipe_void_alloc_sub(upipe_flad_output->conv->dup,
+            uprobe_pfx_alloc(uprobe_use(&upipe_flad_output->last_inner_probe),
+                             UPROBE_LOG_VERBOSE, "input"));
+    if (unlikely(upipe_flad_output->input == NULL ||
+                 !ubase_check(upipe_set_output(upipe_flad_output->input,
+                                               encoder)))) {
+        upipe_release(upipe);
+        return NULL;
+    }
+    return upipe;
+}
+
+/** @internal @This processes control commands on a rendition of a flad pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_flad_output_control(struct upipe *upipe,
+                                     int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(upipe_flad_output_control_super(upipe, command, args));
+    return upipe_flad_output_control_bin_output(upipe, command, args);
+}
+
+/** @This frees a rendition.
+ *
+ * @param urefcount_real pointer to urefcount_real structure
+ */
+static void upipe_flad_output_free(struct urefcount *urefcount_real)
+{
+    struct upipe_flad_output *upipe_flad_output =
+        upipe_flad_output_from_urefcount_real(urefcount_real);
+    struct upipe *upipe = upipe_flad_output_to_upipe(upipe_flad_output);
+
+    upipe_throw_dead(upipe);
+
+    upipe_flad_output_clean_last_inner_probe(upipe);
+    upipe_flad_output_clean_sub(upipe);
+    urefcount_clean(urefcount_real);
+    upipe_flad_output_clean_urefcount(upipe);
+    upipe_clean(upipe);
+    free(upipe_flad_output);
+}
+
+/** @This is called when there is no external reference to the rendition
+ * anymore.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_flad_output_no_ref(struct upipe *upipe)
+{
+    struct upipe_flad_output *upipe_flad_output =
+        upipe_flad_output_from_upipe(upipe);
+
+    upipe_release(upipe_flad_output->input);
+    upipe_flad_output->input = NULL;
+    upipe_flad_output_clean_bin_output(upipe);
+    if (upipe_flad_output->conv != NULL)
+        upipe_flad_conv_release(upipe_flad_output->conv);
+    upipe_flad_output->conv = NULL;
+    urefcount_release(upipe_flad_output_to_urefcount_real(upipe_flad_output));
+}
+
+/** @internal @This initializes the rendition manager of a flad pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_flad_init_sub_mgr(struct upipe *upipe)
+{
+    struct upipe_flad *upipe_flad = upipe_flad_from_upipe(upipe);
+    struct upipe_mgr *sub_mgr = &upipe_flad->sub_mgr;
+    sub_mgr->refcount = upipe_flad_to_urefcount_real(upipe_flad);
+    sub_mgr->signature = UPIPE_FLAD_OUTPUT_SIGNATURE;
+    sub_mgr->upipe_alloc = _upipe_flad_output_alloc;
+    sub_mgr->upipe_input = NULL;
+    sub_mgr->upipe_control = upipe_flad_output_control;
+    sub_mgr->upipe_mgr_control = NULL;
+}
+
+/** @internal @This allocates a flad pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_flad_alloc(struct upipe_mgr *mgr,
+                                      struct uprobe *uprobe,
+                                      uint32_t signature, va_list args)
+{
+    struct upipe_flad_mgr *flad_mgr = upipe_flad_mgr_from_upipe_mgr(mgr);
+    struct upipe *upipe = upipe_flad_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_flad *upipe_flad = upipe_flad_from_upipe(upipe);
+    upipe_flad_init_urefcount(upipe);
+    urefcount_init(upipe_flad_to_urefcount_real(upipe_flad), upipe_flad_free);
+    upipe_flad_init_proxy_probe(upipe);
+    upipe_flad_init_bin_input(upipe);
+    upipe_flad_init_sub_mgr(upipe);
+    upipe_flad_init_sub_outputs(upipe);
+    ulist_init(&upipe_flad->convs);
+    upipe_throw_ready(upipe);
+
+    struct upipe *dup = NULL;
+    if (flad_mgr->dup_mgr != NULL)
+        dup = upipe_void_alloc(flad_mgr->dup_mgr,
+                uprobe_pfx_alloc(uprobe_use(&upipe_flad->proxy_probe),
+                                 UPROBE_LOG_VERBOSE, "dup"));
+    if (unlikely(dup == NULL)) {
+        upipe_err(upipe, "unable to allocate dup");
+        upipe_release(upipe);
+        return NULL;
+    }
+    upipe_flad_store_bin_input(upipe, dup);
+    return upipe;
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_flad_set_flow_def(struct upipe *upipe, struct uref *flow_def)
+{
+    struct upipe_flad *upipe_flad = upipe_flad_from_upipe(upipe);
+    const char *def;
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_get_def(flow_def, &def))
+    if (unlikely(ubase_ncmp(def, "sound.")))
+        return UBASE_ERR_INVALID;
+    if (unlikely(upipe_flad->dup == NULL))
+        return UBASE_ERR_INVALID;
+    return upipe_set_flow_def(upipe_flad->dup, flow_def);
+}
+
+/** @internal @This processes control commands on a flad pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_flad_control(struct upipe *upipe, int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(upipe_flad_control_outputs(upipe, command, args));
+
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_flad_set_flow_def(upipe, flow_def);
+        }
+        default:
+            return upipe_flad_control_bin_input(upipe, command, args);
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param urefcount_real pointer to urefcount_real structure
+ */
+static void upipe_flad_free(struct urefcount *urefcount_real)
+{
+    struct upipe_flad *upipe_flad =
+        upipe_flad_from_urefcount_real(urefcount_real);
+    struct upipe *upipe = upipe_flad_to_upipe(upipe_flad);
+
+    upipe_throw_dead(upipe);
+
+    upipe_flad_clean_sub_outputs(upipe);
+    upipe_flad_clean_proxy_probe(upipe);
+    urefcount_clean(urefcount_real);
+    upipe_flad_clean_urefcount(upipe);
+    upipe_flad_free_void(upipe);
+}
+
+/** @This is called when there is no external reference to the pipe anymore.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_flad_no_ref(struct upipe *upipe)
+{
+    struct upipe_flad *upipe_flad = upipe_flad_from_upipe(upipe);
+    upipe_flad_clean_bin_input(upipe);
+    upipe_flad_throw_sub_outputs(upipe, UPROBE_SOURCE_END);
+    urefcount_release(upipe_flad_to_urefcount_real(upipe_flad));
+}
+
+/** @This frees a upipe manager.
+ *
+ * @param urefcount pointer to urefcount structure
+ */
+static void upipe_flad_mgr_free(struct urefcount *urefcount)
+{
+    struct upipe_flad_mgr *flad_mgr = upipe_flad_mgr_from_urefcount(urefcount);
+    upipe_mgr_release(flad_mgr->dup_mgr);
+    upipe_mgr_release(flad_mgr->convert_mgr);
+    upipe_mgr_release(flad_mgr->encode_mgr);
+    upipe_work_pool_clean(&flad_mgr->workers);
+
+    urefcount_clean(urefcount);
+    free(flad_mgr);
+}
+
+/** @This processes control commands on a flad manager.
+ *
+ * @param mgr pointer to manager
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_flad_mgr_control(struct upipe_mgr *mgr,
+                                  int command, va_list args)
+{
+    struct upipe_flad_mgr *flad_mgr = upipe_flad_mgr_from_upipe_mgr(mgr);
+
+    switch (command) {
+#define GET_SET_MGR(name, NAME)                                             \
+        case UPIPE_FLAD_MGR_GET_##NAME##_MGR: {                             \
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FLAD_SIGNATURE)               \
+            struct upipe_mgr **p = va_arg(args, struct upipe_mgr **);       \
+            *p = flad_mgr->name##_mgr;                                      \
+            return UBASE_ERR_NONE;                                          \
+        }                                                                   \
+        case UPIPE_FLAD_MGR_SET_##NAME##_MGR: {                             \
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FLAD_SIGNATURE)               \
+            if (!urefcount_single(&flad_mgr->urefcount))                    \
+                return UBASE_ERR_BUSY;                                      \
+            struct upipe_mgr *m = va_arg(args, struct upipe_mgr *);         \
+            upipe_mgr_release(flad_mgr->name##_mgr);                        \
+            flad_mgr->name##_mgr = upipe_mgr_use(m);                        \
+            return UBASE_ERR_NONE;                                          \
+        }
+
+        GET_SET_MGR(dup, DUP)
+        GET_SET_MGR(convert, CONVERT)
+        GET_SET_MGR(encode, ENCODE)
+#undef GET_SET_MGR
+
+        case UPIPE_FLAD_MGR_GET_WORKERS:
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FLAD_SIGNATURE)
+            return upipe_work_pool_get_workers_va(&flad_mgr->workers, args);
+        case UPIPE_FLAD_MGR_SET_WORKERS:
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FLAD_SIGNATURE)
+            if (!urefcount_single(&flad_mgr->urefcount))
+                return UBASE_ERR_BUSY;
+            return upipe_work_pool_set_workers_va(&flad_mgr->workers, args);
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This returns the management structure for all flad pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_flad_mgr_alloc(void)
+{
+    struct upipe_flad_mgr *flad_mgr = malloc(sizeof(struct upipe_flad_mgr));
+    if (unlikely(flad_mgr == NULL))
+        return NULL;
+
+    memset(flad_mgr, 0, sizeof(*flad_mgr));
+    flad_mgr->dup_mgr = upipe_dup_mgr_alloc();
+    flad_mgr->convert_mgr = NULL;
+    flad_mgr->encode_mgr = NULL;
+    upipe_work_pool_init(&flad_mgr->workers);
+
+    urefcount_init(upipe_flad_mgr_to_urefcount(flad_mgr),
+                   upipe_flad_mgr_free);
+    flad_mgr->mgr.refcount = upipe_flad_mgr_to_urefcount(flad_mgr);
+    flad_mgr->mgr.signature = UPIPE_FLAD_SIGNATURE;
+    flad_mgr->mgr.upipe_alloc = upipe_flad_alloc;
+    flad_mgr->mgr.upipe_input = upipe_flad_bin_input;
+    flad_mgr->mgr.upipe_control = upipe_flad_control;
+    flad_mgr->mgr.upipe_mgr_control = upipe_flad_mgr_control;
+    return upipe_flad_mgr_to_upipe_mgr(flad_mgr);
+}
@@ -46,6 +46,8 @@
 #include <upipe/upipe_helper_input.h>
 #include <upipe-filters/upipe_filter_blend.h>
 
+#include "upipe_filter_merge.h"
+
 #include <stdlib.h>
 #include <strings.h>
 #include <stdint.h>
@@ -88,6 +90,11 @@ struct upipe_filter_blend {
     /** list of blockers (used during udeal) */
     struct uchain blockers;
 
+    /** merging of 8-bit lines */
+    upipe_filter_merge_func merge8bit;
+    /** merging of 16-bit lines */
+    upipe_filter_merge_func merge16bit;
+
     /** public structure */
     struct upipe upipe;
 };
@@ -119,6 +126,24 @@ static struct upipe *upipe_filter_blend_alloc(struct upipe_mgr *mgr,
     if (unlikely(upipe == NULL))
         return NULL;
 
+    struct upipe_filter_blend *upipe_filter_blend =
+        upipe_filter_blend_from_upipe(upipe);
+    upipe_filter_blend->merge8bit = upipe_filter_merge8bit_c;
+    upipe_filter_blend->merge16bit = upipe_filter_merge16bit_c;
+#if defined(__i686__) || defined(__x86_64__)
+    if (__builtin_cpu_supports("sse2")) {
+        upipe_filter_blend->merge8bit = upipe_filter_merge8bit_sse2;
+        upipe_filter_blend->merge16bit = upipe_filter_merge16bit_sse2;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        upipe_filter_blend->merge8bit = upipe_filter_merge8bit_avx2;
+        upipe_filter_blend->merge16bit = upipe_filter_merge16bit_avx2;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    upipe_filter_blend->merge8bit = upipe_filter_merge8bit_neon;
+    upipe_filter_blend->merge16bit = upipe_filter_merge16bit_neon;
+#endif
+
     upipe_filter_blend_init_urefcount(upipe);
     upipe_filter_blend_init_ubuf_mgr(upipe);
     upipe_filter_blend_init_output(upipe);
@@ -127,47 +152,6 @@ static struct upipe *upipe_filter_blend_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
-/** @internal @This computes the per-pixel mean of two lines
- * Code from VLC.
- * - modules/video_filter/deinterlace/merge.c
- *
- * @param _dest dest line
- * @param _s1 first source line
- * @param _s2 second source line
- * @param bytes length in bytes
- */
-static void upipe_filter_merge16bit( void *_dest, const void *_s1,
-                       const void *_s2, size_t bytes )
-{
-    uint16_t *dest = _dest;
-    const uint16_t *s1 = _s1;
-    const uint16_t *s2 = _s2;
-
-    bytes /= 2;
-    for( ; bytes > 0; bytes-- )
-        *dest++ = ( *s1++ + *s2++ ) >> 1;
-}
-
-/** @internal @This computes the per-pixel mean of two lines
- * Code from VLC.
- * - modules/video_filter/deinterlace/merge.c
- *
- * @param _dest dest line
- * @param _s1 first source line
- * @param _s2 second source line
- * @param bytes length in bytes
- */
-static void upipe_filter_merge8bit( void *_dest, const void *_s1,
-                       const void *_s2, size_t bytes )
-{
-    uint8_t *dest = _dest;
-    const uint8_t *s1 = _s1;
-    const uint8_t *s2 = _s2;
-
-    for( ; bytes > 0; bytes-- )
-        *dest++ = ( *s1++ + *s2++ ) >> 1;
-}
-
 /** @internal @This processes a picture plane
  * Adapted from VLC.
  * - modules/video_filter/deinterlace/algo_basic.c
@@ -177,10 +161,12 @@ static void upipe_filter_merge8bit( void *_dest, const void *_s1,
  * @param stride_in stride length of input buffer
  * @param stride_out stride length of output buffer
  * @param height picture height
+ * @param merge function merging two lines
  */
 static void upipe_filter_blend_plane(const uint8_t *in, uint8_t *out,
                                      size_t stride_in, size_t stride_out,
-                                     size_t height, uint8_t macropixel_size)
+                                     size_t height,
+                                     upipe_filter_merge_func merge)
 {
     uint8_t *out_end = out + stride_out * height;
 
@@ -190,12 +176,8 @@ static void upipe_filter_blend_plane(const uint8_t *in, uint8_t *out,
 
     // Compute mean value for remaining lines
     while (out < out_end) {
-        if (macropixel_size == 2)
-            upipe_filter_merge16bit(out, in, in+stride_in,
-                    (stride_in < stride_out) ? stride_in : stride_out);
-        else
-            upipe_filter_merge8bit(out, in, in+stride_in,
-                    (stride_in < stride_out) ? stride_in : stride_out);
+        merge(out, in, in+stride_in,
+              (stride_in < stride_out) ? stride_in : stride_out);
 
         out += stride_out;
         in += stride_in;
@@ -258,7 +240,9 @@ static bool upipe_filter_blend_handle(struct upipe *upipe, struct uref *uref,
         ubuf_pic_plane_write(ubuf_deint, chroma, 0, 0, -1, -1, &out);
 
         // process plane
-        upipe_filter_blend_plane(in, out, stride_in, stride_out, (size_t) height/vsub, macropixel_size);
+        upipe_filter_blend_plane(in, out, stride_in, stride_out,
+                (size_t) height/vsub, macropixel_size == 2 ?
+                upipe_filter_blend->merge16bit : upipe_filter_blend->merge8bit);
 
         // unmap all
         uref_pic_plane_unmap(uref, chroma, 0, 0, -1, -1);
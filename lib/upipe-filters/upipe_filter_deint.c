@@ -0,0 +1,710 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe deinterlacing filter
+ *
+ * The kept field of each picture is copied, and the lines of the other
+ * field are interpolated. The bob mode interpolates spatially from the
+ * lines above and below. The temporal modes follow the yadif algorithm:
+ * the spatial prediction is bounded by a temporal prediction from the
+ * previous and next pictures, which are held by reference, so that
+ * static areas keep their full vertical resolution.
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uref.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_pic.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_pic.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_ubuf_mgr.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe/upipe_helper_input.h>
+#include <upipe-filters/upipe_filter_deint.h>
+
+#include "upipe_filter_merge.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/** @hidden */
+static bool upipe_filter_deint_handle(struct upipe *upipe, struct uref *uref,
+                                      struct upump **upump_p);
+/** @hidden */
+static int upipe_filter_deint_check(struct upipe *upipe,
+                                    struct uref *flow_format);
+
+/** @internal upipe_filter_deint private structure */
+struct upipe_filter_deint {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** ubuf manager */
+    struct ubuf_mgr *ubuf_mgr;
+    /** flow format packet */
+    struct uref *flow_format;
+    /** ubuf manager request */
+    struct urequest ubuf_mgr_request;
+
+    /** output pipe */
+    struct upipe *output;
+    /** flow_definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** temporary uref storage (used during urequest) */
+    struct uchain urefs;
+    /** nb urefs in storage */
+    unsigned int nb_urefs;
+    /** max urefs in storage */
+    unsigned int max_urefs;
+    /** list of blockers (used during udeal) */
+    struct uchain blockers;
+
+    /** deinterlacing mode */
+    enum upipe_filter_deint_mode mode;
+    /** previous picture */
+    struct uref *prev;
+    /** current picture, waiting for the next one */
+    struct uref *cur;
+
+    /** merging of 8-bit lines */
+    upipe_filter_merge_func merge8bit;
+    /** merging of 16-bit lines */
+    upipe_filter_merge_func merge16bit;
+
+    /** public structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_filter_deint, upipe, UPIPE_FILTER_DEINT_SIGNATURE);
+UPIPE_HELPER_UREFCOUNT(upipe_filter_deint, urefcount, upipe_filter_deint_free)
+UPIPE_HELPER_VOID(upipe_filter_deint)
+UPIPE_HELPER_OUTPUT(upipe_filter_deint, output, flow_def, output_state, request_list)
+UPIPE_HELPER_UBUF_MGR(upipe_filter_deint, ubuf_mgr, flow_format,
+                      ubuf_mgr_request, upipe_filter_deint_check,
+                      upipe_filter_deint_register_output_request,
+                      upipe_filter_deint_unregister_output_request)
+UPIPE_HELPER_INPUT(upipe_filter_deint, urefs, nb_urefs, max_urefs, blockers, upipe_filter_deint_handle)
+
+/** @internal @This allocates a deint pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_filter_deint_alloc(struct upipe_mgr *mgr,
+                                              struct uprobe *uprobe,
+                                              uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_filter_deint_alloc_void(mgr, uprobe, signature,
+                                                        args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_filter_deint *upipe_filter_deint =
+        upipe_filter_deint_from_upipe(upipe);
+    upipe_filter_deint->mode = UPIPE_FILTER_DEINT_YADIF;
+    upipe_filter_deint->prev = NULL;
+    upipe_filter_deint->cur = NULL;
+    upipe_filter_deint->merge8bit = upipe_filter_merge8bit_c;
+    upipe_filter_deint->merge16bit = upipe_filter_merge16bit_c;
+#if defined(__i686__) || defined(__x86_64__)
+    if (__builtin_cpu_supports("sse2")) {
+        upipe_filter_deint->merge8bit = upipe_filter_merge8bit_sse2;
+        upipe_filter_deint->merge16bit = upipe_filter_merge16bit_sse2;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        upipe_filter_deint->merge8bit = upipe_filter_merge8bit_avx2;
+        upipe_filter_deint->merge16bit = upipe_filter_merge16bit_avx2;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    upipe_filter_deint->merge8bit = upipe_filter_merge8bit_neon;
+    upipe_filter_deint->merge16bit = upipe_filter_merge16bit_neon;
+#endif
+
+    upipe_filter_deint_init_urefcount(upipe);
+    upipe_filter_deint_init_ubuf_mgr(upipe);
+    upipe_filter_deint_init_output(upipe);
+    upipe_filter_deint_init_input(upipe);
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This returns the greatest of three integers. */
+static inline int upipe_filter_deint_max3(int a, int b, int c)
+{
+    int m = a > b ? a : b;
+    return m > c ? m : c;
+}
+
+/** @internal @This returns the smallest of three integers. */
+static inline int upipe_filter_deint_min3(int a, int b, int c)
+{
+    int m = a < b ? a : b;
+    return m < c ? m : c;
+}
+
+/** @hidden */
+#define UPIPE_FILTER_DEINT_TEMPLATE(bits)                                   \
+/** @internal @This interpolates a missing line of bits-bit samples.        \
+ *                                                                          \
+ * All the pointers point to the interpolated line, and the offsets give    \
+ * the position of the neighbor lines, in samples.                          \
+ *                                                                          \
+ * @param dst output line                                                   \
+ * @param prev line of the previous picture                                 \
+ * @param cur line of the current picture                                   \
+ * @param next line of the next picture                                     \
+ * @param prev2 line of the first temporal neighbor of the missing field    \
+ * @param next2 line of the second temporal neighbor of the missing field   \
+ * @param up offset of the line above                                       \
+ * @param down offset of the line below                                     \
+ * @param up2 offset of the second line above                               \
+ * @param down2 offset of the second line below                             \
+ * @param width number of samples                                           \
+ * @param directional true to search the edge direction                     \
+ * @param check true to widen the temporal bound on vertical detail         \
+ */                                                                         \
+static void upipe_filter_deint_line##bits(uint##bits##_t *restrict dst,     \
+        const uint##bits##_t *prev, const uint##bits##_t *cur,              \
+        const uint##bits##_t *next, const uint##bits##_t *prev2,            \
+        const uint##bits##_t *next2, ptrdiff_t up, ptrdiff_t down,          \
+        ptrdiff_t up2, ptrdiff_t down2, size_t width,                       \
+        bool directional, bool check)                                       \
+{                                                                           \
+    for (size_t x = 0; x < width; x++) {                                    \
+        int c = cur[up + x], e = cur[down + x];                             \
+        int d = (prev2[x] + next2[x]) >> 1;                                 \
+        int diff0 = abs(prev2[x] - next2[x]);                               \
+        int diff1 = (abs(prev[up + x] - c) + abs(prev[down + x] - e)) >> 1; \
+        int diff2 = (abs(next[up + x] - c) + abs(next[down + x] - e)) >> 1; \
+        int diff = upipe_filter_deint_max3(diff0 >> 1, diff1, diff2);       \
+        int pred = (c + e) >> 1;                                            \
+                                                                            \
+        if (directional && x >= 3 && x + 3 < width) {                       \
+            const uint##bits##_t *a = cur + up + x;                         \
+            const uint##bits##_t *b = cur + down + x;                       \
+            int score = abs(a[-1] - b[-1]) + abs(c - e) +                   \
+                        abs(a[1] - b[1]) - 1;                               \
+            for (int j = -1; j >= -2; j--) {                                \
+                int s = abs(a[j - 1] - b[-j - 1]) + abs(a[j] - b[-j]) +     \
+                        abs(a[j + 1] - b[-j + 1]);                          \
+                if (s >= score)                                             \
+                    break;                                                  \
+                score = s;                                                  \
+                pred = (a[j] + b[-j]) >> 1;                                 \
+            }                                                               \
+            for (int j = 1; j <= 2; j++) {                                  \
+                int s = abs(a[j - 1] - b[-j - 1]) + abs(a[j] - b[-j]) +     \
+                        abs(a[j + 1] - b[-j + 1]);                          \
+                if (s >= score)                                             \
+                    break;                                                  \
+                score = s;                                                  \
+                pred = (a[j] + b[-j]) >> 1;                                 \
+            }                                                               \
+        }                                                                   \
+                                                                            \
+        if (check) {                                                        \
+            int b = (prev2[up2 + x] + next2[up2 + x]) >> 1;                 \
+            int f = (prev2[down2 + x] + next2[down2 + x]) >> 1;             \
+            int max = upipe_filter_deint_max3(d - e, d - c,                 \
+                                              b - c < f - e ? b - c : f - e); \
+            int min = upipe_filter_deint_min3(d - e, d - c,                 \
+                                              b - c > f - e ? b - c : f - e); \
+            diff = upipe_filter_deint_max3(diff, min, -max);                \
+        }                                                                   \
+                                                                            \
+        if (pred > d + diff)                                                \
+            pred = d + diff;                                                \
+        else if (pred < d - diff)                                           \
+            pred = d - diff;                                                \
+        dst[x] = pred;                                                      \
+    }                                                                       \
+}
+
+UPIPE_FILTER_DEINT_TEMPLATE(8)
+UPIPE_FILTER_DEINT_TEMPLATE(16)
+#undef UPIPE_FILTER_DEINT_TEMPLATE
+
+/** @internal @This deinterlaces a picture.
+ *
+ * @param upipe description structure of the pipe
+ * @param prev previous picture, or the current one
+ * @param cur picture to deinterlace
+ * @param next next picture, or the current one
+ * @return deinterlaced ubuf, or NULL in case of error
+ */
+static struct ubuf *upipe_filter_deint_frame(struct upipe *upipe,
+                                             struct uref *prev,
+                                             struct uref *cur,
+                                             struct uref *next)
+{
+    struct upipe_filter_deint *upipe_filter_deint =
+        upipe_filter_deint_from_upipe(upipe);
+    size_t hsize, vsize;
+    uint8_t macropixel;
+    if (unlikely(!ubase_check(uref_pic_size(cur, &hsize, &vsize,
+                                            &macropixel))))
+        return NULL;
+
+    bool temporal = upipe_filter_deint->mode != UPIPE_FILTER_DEINT_BOB;
+    size_t prev_hsize, prev_vsize, next_hsize, next_vsize;
+    if (temporal &&
+        (!ubase_check(uref_pic_size(prev, &prev_hsize, &prev_vsize, NULL)) ||
+         !ubase_check(uref_pic_size(next, &next_hsize, &next_vsize, NULL)) ||
+         prev_hsize != hsize || prev_vsize != vsize ||
+         next_hsize != hsize || next_vsize != vsize))
+        temporal = false;
+
+    struct ubuf *ubuf = ubuf_pic_alloc(upipe_filter_deint->ubuf_mgr,
+                                       hsize, vsize);
+    if (unlikely(ubuf == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
+
+    /* the lines of the second field are interpolated; their temporal
+     * neighbors are the pictures surrounding the instant of that field */
+    bool tff = ubase_check(uref_pic_get_tff(cur));
+    size_t parity = tff ? 1 : 0;
+    struct uref *prev2 = tff ? cur : prev;
+    struct uref *next2 = tff ? next : cur;
+
+    const char *chroma = NULL;
+    while (ubase_check(uref_pic_plane_iterate(cur, &chroma)) && chroma) {
+        size_t stride, out_stride, prev_stride = 0, next_stride = 0;
+        uint8_t hsub, vsub, macropixel_size;
+        if (unlikely(!ubase_check(uref_pic_plane_size(cur, chroma, &stride,
+                            &hsub, &vsub, &macropixel_size)) ||
+                     !ubase_check(ubuf_pic_plane_size(ubuf, chroma,
+                            &out_stride, NULL, NULL, NULL)))) {
+            upipe_warn_va(upipe, "unable to read chroma %s", chroma);
+            ubuf_free(ubuf);
+            return NULL;
+        }
+        bool plane_temporal = temporal &&
+            ubase_check(uref_pic_plane_size(prev, chroma, &prev_stride,
+                                            NULL, NULL, NULL)) &&
+            ubase_check(uref_pic_plane_size(next, chroma, &next_stride,
+                                            NULL, NULL, NULL)) &&
+            prev_stride == stride && next_stride == stride;
+
+        const uint8_t *in, *in_prev = NULL, *in_next = NULL;
+        uint8_t *out;
+        if (unlikely(!ubase_check(uref_pic_plane_read(cur, chroma,
+                                        0, 0, -1, -1, &in)))) {
+            ubuf_free(ubuf);
+            return NULL;
+        }
+        if (unlikely(!ubase_check(ubuf_pic_plane_write(ubuf, chroma,
+                                        0, 0, -1, -1, &out)))) {
+            uref_pic_plane_unmap(cur, chroma, 0, 0, -1, -1);
+            ubuf_free(ubuf);
+            return NULL;
+        }
+        if (plane_temporal) {
+            if (!ubase_check(uref_pic_plane_read(prev, chroma,
+                                    0, 0, -1, -1, &in_prev)))
+                plane_temporal = false;
+            else if (!ubase_check(uref_pic_plane_read(next, chroma,
+                                    0, 0, -1, -1, &in_next))) {
+                uref_pic_plane_unmap(prev, chroma, 0, 0, -1, -1);
+                plane_temporal = false;
+            }
+        }
+
+        size_t bytes = hsize / hsub / macropixel * macropixel_size;
+        size_t height = vsize / vsub;
+        size_t sample_size = macropixel_size == 2 ? 2 : 1;
+        bool check = upipe_filter_deint->mode == UPIPE_FILTER_DEINT_YADIF;
+        bool directional = check && macropixel == 1 && macropixel_size <= 2;
+        const uint8_t *in_prev2 = prev2 == cur ? in : in_prev;
+        const uint8_t *in_next2 = next2 == cur ? in : in_next;
+
+        for (size_t y = 0; y < height; y++) {
+            const uint8_t *line = in + y * stride;
+            uint8_t *dst = out + y * out_stride;
+            if ((y & 1) != parity || height < 2) {
+                memcpy(dst, line, bytes);
+                continue;
+            }
+
+            /* mirror the missing neighbors at the picture edges */
+            ptrdiff_t up = y > 0 ? -(ptrdiff_t)stride : (ptrdiff_t)stride;
+            ptrdiff_t down = y + 1 < height ? (ptrdiff_t)stride :
+                                              -(ptrdiff_t)stride;
+            if (!plane_temporal) {
+                (sample_size == 2 ? upipe_filter_deint->merge16bit :
+                 upipe_filter_deint->merge8bit)(dst, line + up, line + down,
+                                                bytes);
+                continue;
+            }
+
+            ptrdiff_t up2 = y >= 2 ? -2 * (ptrdiff_t)stride : 0;
+            ptrdiff_t down2 = y + 2 < height ? 2 * (ptrdiff_t)stride : 0;
+            size_t offset = y * stride;
+            if (sample_size == 2)
+                upipe_filter_deint_line16((uint16_t *)dst,
+                        (const uint16_t *)(in_prev + offset),
+                        (const uint16_t *)line,
+                        (const uint16_t *)(in_next + offset),
+                        (const uint16_t *)(in_prev2 + offset),
+                        (const uint16_t *)(in_next2 + offset),
+                        up / 2, down / 2, up2 / 2, down2 / 2, bytes / 2,
+                        directional, check);
+            else
+                upipe_filter_deint_line8(dst, in_prev + offset, line,
+                        in_next + offset, in_prev2 + offset,
+                        in_next2 + offset, up, down, up2, down2, bytes,
+                        directional, check);
+        }
+
+        if (plane_temporal) {
+            uref_pic_plane_unmap(prev, chroma, 0, 0, -1, -1);
+            uref_pic_plane_unmap(next, chroma, 0, 0, -1, -1);
+        }
+        uref_pic_plane_unmap(cur, chroma, 0, 0, -1, -1);
+        ubuf_pic_plane_unmap(ubuf, chroma, 0, 0, -1, -1);
+    }
+    return ubuf;
+}
+
+/** @internal @This outputs a deinterlaced picture.
+ *
+ * @param upipe description structure of the pipe
+ * @param prev previous picture, or the current one
+ * @param cur picture to deinterlace, which is not released
+ * @param next next picture, or the current one
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_filter_deint_output_frame(struct upipe *upipe,
+                                            struct uref *prev,
+                                            struct uref *cur,
+                                            struct uref *next,
+                                            struct upump **upump_p)
+{
+    struct uref *uref = uref_dup(cur);
+    if (unlikely(uref == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+
+    if (!ubase_check(uref_pic_get_progressive(cur))) {
+        struct ubuf *ubuf = upipe_filter_deint_frame(upipe, prev, cur, next);
+        if (unlikely(ubuf == NULL)) {
+            uref_free(uref);
+            return;
+        }
+        uref_attach_ubuf(uref, ubuf);
+        uref_pic_set_progressive(uref);
+        uref_pic_delete_tff(uref);
+    }
+
+    upipe_filter_deint_output(upipe, uref, upump_p);
+}
+
+/** @internal @This outputs the held picture and releases the history.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_filter_deint_flush(struct upipe *upipe,
+                                     struct upump **upump_p)
+{
+    struct upipe_filter_deint *upipe_filter_deint =
+        upipe_filter_deint_from_upipe(upipe);
+    struct uref *cur = upipe_filter_deint->cur;
+    struct uref *prev = upipe_filter_deint->prev;
+    if (cur != NULL && upipe_filter_deint->flow_def != NULL)
+        upipe_filter_deint_output_frame(upipe, prev != NULL ? prev : cur,
+                                        cur, cur, upump_p);
+    if (prev != NULL)
+        uref_free(prev);
+    if (cur != NULL)
+        uref_free(cur);
+    upipe_filter_deint->prev = NULL;
+    upipe_filter_deint->cur = NULL;
+}
+
+/** @internal @This handles input.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to upump structure
+ * @return false if the input must be held
+ */
+static bool upipe_filter_deint_handle(struct upipe *upipe, struct uref *uref,
+                                      struct upump **upump_p)
+{
+    struct upipe_filter_deint *upipe_filter_deint =
+        upipe_filter_deint_from_upipe(upipe);
+    const char *def;
+    if (unlikely(ubase_check(uref_flow_get_def(uref, &def)))) {
+        upipe_filter_deint_flush(upipe, upump_p);
+        upipe_filter_deint_store_flow_def(upipe, NULL);
+        upipe_filter_deint_require_ubuf_mgr(upipe, uref);
+        return true;
+    }
+
+    if (upipe_filter_deint->flow_def == NULL)
+        return false;
+
+    if (upipe_filter_deint->mode == UPIPE_FILTER_DEINT_BOB) {
+        upipe_filter_deint_output_frame(upipe, uref, uref, uref, upump_p);
+        uref_free(uref);
+        return true;
+    }
+
+    /* the temporal modes output the previous picture */
+    struct uref *cur = upipe_filter_deint->cur;
+    if (cur != NULL) {
+        struct uref *prev = upipe_filter_deint->prev;
+        upipe_filter_deint_output_frame(upipe, prev != NULL ? prev : cur,
+                                        cur, uref, upump_p);
+        if (prev != NULL)
+            uref_free(prev);
+        upipe_filter_deint->prev = cur;
+    }
+    upipe_filter_deint->cur = uref;
+    return true;
+}
+
+/** @internal @This inputs data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_filter_deint_input(struct upipe *upipe, struct uref *uref,
+                                     struct upump **upump_p)
+{
+    if (!upipe_filter_deint_check_input(upipe)) {
+        upipe_filter_deint_hold_input(upipe, uref);
+        upipe_filter_deint_block_input(upipe, upump_p);
+    } else if (!upipe_filter_deint_handle(upipe, uref, upump_p)) {
+        upipe_filter_deint_hold_input(upipe, uref);
+        upipe_filter_deint_block_input(upipe, upump_p);
+        /* Increment upipe refcount to avoid disappearing before all packets
+         * have been sent. */
+        upipe_use(upipe);
+    }
+}
+
+/** @internal @This checks if the input may start.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_filter_deint_check(struct upipe *upipe,
+                                    struct uref *flow_format)
+{
+    struct upipe_filter_deint *upipe_filter_deint =
+        upipe_filter_deint_from_upipe(upipe);
+    if (flow_format != NULL)
+        upipe_filter_deint_store_flow_def(upipe, flow_format);
+
+    if (upipe_filter_deint->flow_def == NULL)
+        return UBASE_ERR_NONE;
+
+    bool was_buffered = !upipe_filter_deint_check_input(upipe);
+    upipe_filter_deint_output_input(upipe);
+    upipe_filter_deint_unblock_input(upipe);
+    if (was_buffered && upipe_filter_deint_check_input(upipe)) {
+        /* All packets have been output, release again the pipe that has been
+         * used in @ref upipe_filter_deint_input. */
+        upipe_release(upipe);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_filter_deint_set_flow_def(struct upipe *upipe,
+                                           struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, UREF_PIC_FLOW_DEF))
+    struct uref *flow_def_dup;
+    if (unlikely((flow_def_dup = uref_dup(flow_def)) == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
+    UBASE_RETURN(uref_pic_set_progressive(flow_def_dup))
+    uref_pic_delete_tff(flow_def_dup);
+    upipe_input(upipe, flow_def_dup, NULL);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the deinterlacing mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param mode deinterlacing mode
+ * @return an error code
+ */
+static int _upipe_filter_deint_set_mode(struct upipe *upipe, int mode)
+{
+    struct upipe_filter_deint *upipe_filter_deint =
+        upipe_filter_deint_from_upipe(upipe);
+    switch (mode) {
+        case UPIPE_FILTER_DEINT_BOB:
+            /* output the picture held by the temporal modes */
+            upipe_filter_deint_flush(upipe, NULL);
+            /* fallthrough */
+        case UPIPE_FILTER_DEINT_MOTION_ADAPTIVE:
+        case UPIPE_FILTER_DEINT_YADIF:
+            upipe_filter_deint->mode = mode;
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_INVALID;
+    }
+}
+
+/** @internal @This processes control commands on the pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_filter_deint_control(struct upipe *upipe,
+                                      int command, va_list args)
+{
+    struct upipe_filter_deint *upipe_filter_deint =
+        upipe_filter_deint_from_upipe(upipe);
+
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_UBUF_MGR ||
+                request->type == UREQUEST_FLOW_FORMAT)
+                return upipe_throw_provide_request(upipe, request);
+            return upipe_filter_deint_alloc_output_proxy(upipe, request);
+        }
+        case UPIPE_UNREGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_UBUF_MGR ||
+                request->type == UREQUEST_FLOW_FORMAT)
+                return UBASE_ERR_NONE;
+            return upipe_filter_deint_free_output_proxy(upipe, request);
+        }
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_filter_deint_set_flow_def(upipe, flow_def);
+        }
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_filter_deint_control_output(upipe, command, args);
+        case UPIPE_SET_OPTION: {
+            const char *option = va_arg(args, const char *);
+            const char *value = va_arg(args, const char *);
+            if (strcmp(option, "mode"))
+                return UBASE_ERR_INVALID;
+            if (!strcmp(value, "bob"))
+                return _upipe_filter_deint_set_mode(upipe,
+                        UPIPE_FILTER_DEINT_BOB);
+            if (!strcmp(value, "motion"))
+                return _upipe_filter_deint_set_mode(upipe,
+                        UPIPE_FILTER_DEINT_MOTION_ADAPTIVE);
+            if (!strcmp(value, "yadif"))
+                return _upipe_filter_deint_set_mode(upipe,
+                        UPIPE_FILTER_DEINT_YADIF);
+            return UBASE_ERR_INVALID;
+        }
+
+        case UPIPE_FILTER_DEINT_GET_MODE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FILTER_DEINT_SIGNATURE)
+            int *mode_p = va_arg(args, int *);
+            *mode_p = upipe_filter_deint->mode;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_FILTER_DEINT_SET_MODE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FILTER_DEINT_SIGNATURE)
+            int mode = va_arg(args, int);
+            return _upipe_filter_deint_set_mode(upipe, mode);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_filter_deint_free(struct upipe *upipe)
+{
+    struct upipe_filter_deint *upipe_filter_deint =
+        upipe_filter_deint_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    if (upipe_filter_deint->prev != NULL)
+        uref_free(upipe_filter_deint->prev);
+    if (upipe_filter_deint->cur != NULL)
+        uref_free(upipe_filter_deint->cur);
+    upipe_filter_deint_clean_input(upipe);
+    upipe_filter_deint_clean_ubuf_mgr(upipe);
+    upipe_filter_deint_clean_output(upipe);
+    upipe_filter_deint_clean_urefcount(upipe);
+    upipe_filter_deint_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_filter_deint_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_FILTER_DEINT_SIGNATURE,
+
+    .upipe_alloc = upipe_filter_deint_alloc,
+    .upipe_input = upipe_filter_deint_input,
+    .upipe_control = upipe_filter_deint_control
+};
+
+/** @This returns the management structure for deint pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_filter_deint_mgr_alloc(void)
+{
+    return &upipe_filter_deint_mgr;
+}
@@ -147,7 +147,19 @@ static void upipe_filter_ebur128_input(struct upipe *upipe, struct uref *uref,
 
     void *buf = NULL;
     const char *channel = NULL;
-    if (upipe_filter_ebur128->planes == 1) {
+    uint8_t planes = upipe_filter_ebur128->planes;
+    /* one plane per channel is measured in place */
+    bool planar = planes > 1 && planes == upipe_filter_ebur128->channels;
+    const void *buffers[planes];
+    if (planar) {
+        if (unlikely(!ubase_check(uref_sound_read_void(uref, 0, -1,
+                                                       buffers, planes)))) {
+            upipe_warn(upipe, "error mapping sound buffer");
+            uref_free(uref);
+            return;
+        }
+
+    } else if (planes == 1) {
         if (ubase_check(uref_sound_plane_iterate(uref, &channel)) && channel) {
             if (unlikely(!ubase_check(uref_sound_plane_read_void(uref,
                     channel, 0, -1, (const void **)&buf)))) {
@@ -176,34 +188,69 @@ static void upipe_filter_ebur128_input(struct upipe *upipe, struct uref *uref,
     if (unlikely((uintptr_t)buf & 1))
         upipe_warn(upipe, "unaligned buffer");
 
-    switch (upipe_filter_ebur128->fmt) {
-        case UPIPE_FILTER_EBUR128_SHORT:
-            ebur128_add_frames_short(upipe_filter_ebur128->st, (short *)buf,
-                                     samples);
-            break;
-
-        case UPIPE_FILTER_EBUR128_INT:
-            ebur128_add_frames_int(upipe_filter_ebur128->st, (int *)buf,
-                                   samples);
-            break;
-
-        case UPIPE_FILTER_EBUR128_FLOAT:
-            ebur128_add_frames_float(upipe_filter_ebur128->st, (float *)buf,
-                                     samples);
-            break;
-
-        case UPIPE_FILTER_EBUR128_DOUBLE:
-            ebur128_add_frames_double(upipe_filter_ebur128->st, (double *)buf,
-                                      samples);
-            break;
+    if (planar) {
+        switch (upipe_filter_ebur128->fmt) {
+            case UPIPE_FILTER_EBUR128_SHORT:
+                ebur128_add_frames_planar_short(upipe_filter_ebur128->st,
+                                                (const short **)buffers,
+                                                samples);
+                break;
+
+            case UPIPE_FILTER_EBUR128_INT:
+                ebur128_add_frames_planar_int(upipe_filter_ebur128->st,
+                                              (const int **)buffers, samples);
+                break;
+
+            case UPIPE_FILTER_EBUR128_FLOAT:
+                ebur128_add_frames_planar_float(upipe_filter_ebur128->st,
+                                                (const float **)buffers,
+                                                samples);
+                break;
+
+            case UPIPE_FILTER_EBUR128_DOUBLE:
+                ebur128_add_frames_planar_double(upipe_filter_ebur128->st,
+                                                 (const double **)buffers,
+                                                 samples);
+                break;
+
+            default:
+                upipe_warn_va(upipe, "unknown sample format %d",
+                              upipe_filter_ebur128->fmt);
+                break;
+        }
 
-        default:
-            upipe_warn_va(upipe, "unknown sample format %d",
-                          upipe_filter_ebur128->fmt);
-            break;
+    } else {
+        switch (upipe_filter_ebur128->fmt) {
+            case UPIPE_FILTER_EBUR128_SHORT:
+                ebur128_add_frames_short(upipe_filter_ebur128->st, (short *)buf,
+                                         samples);
+                break;
+
+            case UPIPE_FILTER_EBUR128_INT:
+                ebur128_add_frames_int(upipe_filter_ebur128->st, (int *)buf,
+                                       samples);
+                break;
+
+            case UPIPE_FILTER_EBUR128_FLOAT:
+                ebur128_add_frames_float(upipe_filter_ebur128->st, (float *)buf,
+                                         samples);
+                break;
+
+            case UPIPE_FILTER_EBUR128_DOUBLE:
+                ebur128_add_frames_double(upipe_filter_ebur128->st,
+                                          (double *)buf, samples);
+                break;
+
+            default:
+                upipe_warn_va(upipe, "unknown sample format %d",
+                              upipe_filter_ebur128->fmt);
+                break;
+        }
     }
 
-    if (upipe_filter_ebur128->planes == 1)
+    if (planar)
+        uref_sound_unmap(uref, 0, -1, planes);
+    else if (planes == 1)
         uref_sound_plane_unmap(uref, channel, 0, -1);
     else
         free(buf);
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2011 VLC authors and VideoLAN
+ * Copyright (C) 2013-2026 OpenHeadend S.A.R.L.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe line merging kernels for the blend deinterlace filter
+ *
+ * Adapted from VLC video_filter (blend deinterlace) :
+ * - modules/video_filter/deinterlace/merge.c
+ */
+
+#include "upipe_filter_merge.h"
+
+#include <stdint.h>
+
+#if defined(__i686__) || defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/** @This computes the per-pixel mean of two lines of 16-bit samples.
+ *
+ * @param _dest dest line
+ * @param _s1 first source line
+ * @param _s2 second source line
+ * @param bytes length in bytes
+ */
+void upipe_filter_merge16bit_c(void *_dest, const void *_s1,
+                               const void *_s2, size_t bytes)
+{
+    uint16_t *dest = _dest;
+    const uint16_t *s1 = _s1;
+    const uint16_t *s2 = _s2;
+
+    bytes /= 2;
+    for( ; bytes > 0; bytes-- )
+        *dest++ = ( *s1++ + *s2++ ) >> 1;
+}
+
+/** @This computes the per-pixel mean of two lines of 8-bit samples.
+ *
+ * @param _dest dest line
+ * @param _s1 first source line
+ * @param _s2 second source line
+ * @param bytes length in bytes
+ */
+void upipe_filter_merge8bit_c(void *_dest, const void *_s1,
+                              const void *_s2, size_t bytes)
+{
+    uint8_t *dest = _dest;
+    const uint8_t *s1 = _s1;
+    const uint8_t *s2 = _s2;
+
+    for( ; bytes > 0; bytes-- )
+        *dest++ = ( *s1++ + *s2++ ) >> 1;
+}
+
+/* The averaging instructions round up, so the vector variants subtract the
+ * carry of the lowest bit, and leave the remaining samples to the C
+ * versions. */
+
+#if defined(__i686__) || defined(__x86_64__)
+/** @This defines an x86 merging kernel.
+ *
+ * @param bits sample size
+ * @param isa instruction set
+ * @param T vector type
+ * @param prefix intrinsics prefix
+ * @param suffix intrinsics suffix for integer vectors
+ */
+#define UPIPE_FILTER_MERGE_X86(bits, isa, T, prefix, suffix)                \
+__attribute__((target(#isa)))                                               \
+void upipe_filter_merge##bits##bit_##isa(void *_dest, const void *_s1,      \
+                                         const void *_s2, size_t bytes)     \
+{                                                                           \
+    uint8_t *dest = _dest;                                                  \
+    const uint8_t *s1 = _s1;                                                \
+    const uint8_t *s2 = _s2;                                                \
+    const T one = prefix##_set1_epi##bits(1);                               \
+    size_t i;                                                               \
+    for (i = 0; i + sizeof(T) <= bytes; i += sizeof(T)) {                   \
+        T a = prefix##_loadu_##suffix((const T *)(s1 + i));                 \
+        T b = prefix##_loadu_##suffix((const T *)(s2 + i));                 \
+        T carry = prefix##_and_##suffix(prefix##_xor_##suffix(a, b), one);  \
+        prefix##_storeu_##suffix((T *)(dest + i),                           \
+            prefix##_sub_epi##bits(prefix##_avg_epu##bits(a, b), carry));   \
+    }                                                                       \
+    upipe_filter_merge##bits##bit_c(dest + i, s1 + i, s2 + i, bytes - i);   \
+}
+
+UPIPE_FILTER_MERGE_X86(8, sse2, __m128i, _mm, si128)
+UPIPE_FILTER_MERGE_X86(16, sse2, __m128i, _mm, si128)
+UPIPE_FILTER_MERGE_X86(8, avx2, __m256i, _mm256, si256)
+UPIPE_FILTER_MERGE_X86(16, avx2, __m256i, _mm256, si256)
+#undef UPIPE_FILTER_MERGE_X86
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+void upipe_filter_merge8bit_neon(void *_dest, const void *_s1,
+                                 const void *_s2, size_t bytes)
+{
+    uint8_t *dest = _dest;
+    const uint8_t *s1 = _s1;
+    const uint8_t *s2 = _s2;
+    size_t i;
+    for (i = 0; i + 16 <= bytes; i += 16)
+        vst1q_u8(dest + i, vhaddq_u8(vld1q_u8(s1 + i), vld1q_u8(s2 + i)));
+    upipe_filter_merge8bit_c(dest + i, s1 + i, s2 + i, bytes - i);
+}
+
+void upipe_filter_merge16bit_neon(void *_dest, const void *_s1,
+                                  const void *_s2, size_t bytes)
+{
+    uint16_t *dest = _dest;
+    const uint16_t *s1 = _s1;
+    const uint16_t *s2 = _s2;
+    size_t i;
+    bytes /= 2;
+    for (i = 0; i + 8 <= bytes; i += 8)
+        vst1q_u16(dest + i, vhaddq_u16(vld1q_u16(s1 + i), vld1q_u16(s2 + i)));
+    upipe_filter_merge16bit_c(dest + i, s1 + i, s2 + i, (bytes - i) * 2);
+}
+#endif
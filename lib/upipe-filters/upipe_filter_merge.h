@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2011 VLC authors and VideoLAN
+ * Copyright (C) 2013-2026 OpenHeadend S.A.R.L.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe line merging kernels for the blend deinterlace filter
+ * The variants below compute the per-sample mean of two lines, rounded down.
+ * They are selected by the filter when it is allocated, and exported for
+ * checkasm.
+ */
+
+#ifndef _UPIPE_FILTERS_UPIPE_FILTER_MERGE_H_
+/** @hidden */
+#define _UPIPE_FILTERS_UPIPE_FILTER_MERGE_H_
+
+#include <stddef.h>
+
+/** @This computes the per-sample mean of two lines.
+ *
+ * @param dest dest line
+ * @param s1 first source line
+ * @param s2 second source line
+ * @param bytes length in bytes
+ */
+typedef void (*upipe_filter_merge_func)(void *dest, const void *s1,
+                                        const void *s2, size_t bytes);
+
+/* one sample at a time */
+void upipe_filter_merge8bit_c(void *dest, const void *s1, const void *s2,
+                              size_t bytes);
+void upipe_filter_merge16bit_c(void *dest, const void *s1, const void *s2,
+                               size_t bytes);
+
+#if defined(__i686__) || defined(__x86_64__)
+/* 16 or 32 octets at a time */
+void upipe_filter_merge8bit_sse2(void *dest, const void *s1, const void *s2,
+                                 size_t bytes);
+void upipe_filter_merge16bit_sse2(void *dest, const void *s1, const void *s2,
+                                  size_t bytes);
+void upipe_filter_merge8bit_avx2(void *dest, const void *s1, const void *s2,
+                                 size_t bytes);
+void upipe_filter_merge16bit_avx2(void *dest, const void *s1, const void *s2,
+                                  size_t bytes);
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/* 16 octets at a time */
+void upipe_filter_merge8bit_neon(void *dest, const void *s1, const void *s2,
+                                 size_t bytes);
+void upipe_filter_merge16bit_neon(void *dest, const void *s1, const void *s2,
+                                  size_t bytes);
+#endif
+
+#endif
@@ -795,6 +795,15 @@ static void upipe_vanc_process_line(struct upipe *upipe, struct uref *uref,
                                     const uint16_t *r, size_t hsize)
 {
     while (hsize > S291_HEADER_SIZE + S291_FOOTER_SIZE) {
+        /* Most of the line is blanking, so look at the last word of the
+         * flag first: unless it may still be part of a flag, no flag can
+         * start on the two previous words. */
+        if (r[2] != S291_ADF3 && r[2] != S291_ADF2) {
+            unsigned int skip = r[2] == S291_ADF1 ? 2 : 3;
+            r += skip;
+            hsize -= skip;
+            continue;
+        }
         if (r[0] != S291_ADF1 || r[1] != S291_ADF2 || r[2] != S291_ADF3) {
             r++;
             hsize--;
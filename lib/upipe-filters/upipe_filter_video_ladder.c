@@ -0,0 +1,643 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Bin pipe encoding a picture flow into several renditions
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/ulist.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uref.h>
+#include <upipe/uref_flow.h>
+#include <upipe/udict.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_inner.h>
+#include <upipe/upipe_helper_uprobe.h>
+#include <upipe/upipe_helper_bin_input.h>
+#include <upipe/upipe_helper_bin_output.h>
+#include <upipe/upipe_helper_subpipe.h>
+#include <upipe-modules/upipe_dup.h>
+#include <upipe-modules/upipe_worker_pool.h>
+#include <upipe-filters/upipe_filter_video_ladder.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+
+/** @internal @This is the private context of a fvlad manager. */
+struct upipe_fvlad_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** pointer to dup manager */
+    struct upipe_mgr *dup_mgr;
+    /** pointer to scale manager */
+    struct upipe_mgr *scale_mgr;
+
+    /** pool of worker threads running the encoders */
+    struct upipe_work_pool workers;
+
+    /** public upipe_mgr structure */
+    struct upipe_mgr mgr;
+};
+
+UBASE_FROM_TO(upipe_fvlad_mgr, upipe_mgr, upipe_mgr, mgr)
+UBASE_FROM_TO(upipe_fvlad_mgr, urefcount, urefcount, urefcount)
+
+/** @internal @This is the private context of a scaling stage, shared by all
+ * the renditions requesting the same format. */
+struct upipe_fvlad_scaler {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** target format */
+    struct uref *format;
+    /** number of renditions using this stage */
+    unsigned int users;
+
+    /** output of the input dup pipe */
+    struct upipe *input;
+    /** scale inner pipe */
+    struct upipe *scale;
+    /** dup pipe feeding the renditions */
+    struct upipe *dup;
+};
+
+UBASE_FROM_TO(upipe_fvlad_scaler, uchain, uchain, uchain)
+
+/** @internal @This is the private context of a fvlad pipe. */
+struct upipe_fvlad {
+    /** real refcount management structure */
+    struct urefcount urefcount_real;
+    /** refcount management structure exported to the public structure */
+    struct urefcount urefcount;
+
+    /** probe for the inner pipes */
+    struct uprobe proxy_probe;
+
+    /** list of input bin requests */
+    struct uchain input_request_list;
+    /** first inner pipe of the bin (dup) */
+    struct upipe *dup;
+
+    /** list of scaling stages */
+    struct uchain scalers;
+
+    /** list of renditions */
+    struct uchain outputs;
+    /** manager to create renditions */
+    struct upipe_mgr sub_mgr;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_fvlad, upipe, UPIPE_FVLAD_SIGNATURE)
+UPIPE_HELPER_VOID(upipe_fvlad)
+UPIPE_HELPER_UREFCOUNT(upipe_fvlad, urefcount, upipe_fvlad_no_ref)
+UPIPE_HELPER_UPROBE(upipe_fvlad, urefcount_real, proxy_probe, NULL)
+UPIPE_HELPER_INNER(upipe_fvlad, dup)
+UPIPE_HELPER_BIN_INPUT(upipe_fvlad, dup, input_request_list)
+
+UBASE_FROM_TO(upipe_fvlad, urefcount, urefcount_real, urefcount_real)
+
+/** @hidden */
+static void upipe_fvlad_free(struct urefcount *urefcount_real);
+
+/** @internal @This is the private context of a rendition of a fvlad pipe. */
+struct upipe_fvlad_output {
+    /** real refcount management structure */
+    struct urefcount urefcount_real;
+    /** refcount management structure exported to the public structure */
+    struct urefcount urefcount;
+    /** structure for double-linked lists */
+    struct uchain uchain;
+
+    /** scaling stage, or NULL if the input pictures are encoded as is */
+    struct upipe_fvlad_scaler *scaler;
+    /** output of the dup pipe feeding the encoder */
+    struct upipe *input;
+
+    /** probe for the last inner pipe */
+    struct uprobe last_inner_probe;
+    /** list of output bin requests */
+    struct uchain output_request_list;
+    /** last inner pipe of the bin (encoder or worker) */
+    struct upipe *last_inner;
+    /** output */
+    struct upipe *output;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_fvlad_output, upipe, UPIPE_FVLAD_OUTPUT_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_fvlad_output, urefcount, upipe_fvlad_output_no_ref)
+UPIPE_HELPER_INNER(upipe_fvlad_output, last_inner)
+UPIPE_HELPER_UPROBE(upipe_fvlad_output, urefcount_real, last_inner_probe, NULL)
+UPIPE_HELPER_BIN_OUTPUT(upipe_fvlad_output, last_inner, output,
+                        output_request_list)
+
+UPIPE_HELPER_SUBPIPE(upipe_fvlad, upipe_fvlad_output, output, sub_mgr, outputs,
+                     uchain)
+
+UBASE_FROM_TO(upipe_fvlad_output, urefcount, urefcount_real, urefcount_real)
+
+/** @hidden */
+static void upipe_fvlad_output_free(struct urefcount *urefcount_real);
+
+/** @internal @This releases a scaling stage, and frees it when it is not used
+ * by any rendition anymore.
+ *
+ * @param scaler description structure of the scaling stage
+ */
+static void upipe_fvlad_scaler_release(struct upipe_fvlad_scaler *scaler)
+{
+    if (--scaler->users)
+        return;
+
+    ulist_delete(upipe_fvlad_scaler_to_uchain(scaler));
+    upipe_release(scaler->input);
+    upipe_release(scaler->scale);
+    upipe_release(scaler->dup);
+    uref_free(scaler->format);
+    free(scaler);
+}
+
+/** @internal @This returns the scaling stage to the given format, allocating
+ * it if it doesn't exist yet.
+ *
+ * @param upipe description structure of the pipe
+ * @param format target format
+ * @return pointer to the scaling stage, or NULL in case of error
+ */
+static struct upipe_fvlad_scaler *upipe_fvlad_scaler_use(struct upipe *upipe,
+                                                         struct uref *format)
+{
+    struct upipe_fvlad *upipe_fvlad = upipe_fvlad_from_upipe(upipe);
+    struct upipe_fvlad_mgr *fvlad_mgr =
+        upipe_fvlad_mgr_from_upipe_mgr(upipe->mgr);
+    struct uchain *uchain;
+
+    ulist_foreach (&upipe_fvlad->scalers, uchain) {
+        struct upipe_fvlad_scaler *scaler =
+            upipe_fvlad_scaler_from_uchain(uchain);
+        if (format->udict != NULL &&
+            !udict_cmp(scaler->format->udict, format->udict) &&
+            !udict_cmp(format->udict, scaler->format->udict)) {
+            scaler->users++;
+            return scaler;
+        }
+    }
+
+    if (unlikely(format->udict == NULL || fvlad_mgr->scale_mgr == NULL ||
+                 upipe_fvlad->dup == NULL))
+        return NULL;
+
+    struct upipe_fvlad_scaler *scaler =
+        malloc(sizeof(struct upipe_fvlad_scaler));
+    if (unlikely(scaler == NULL))
+        return NULL;
+    uchain_init(upipe_fvlad_scaler_to_uchain(scaler));
+    scaler->users = 1;
+    scaler->scale = NULL;
+    scaler->dup = NULL;
+    scaler->format = uref_dup(format);
+    scaler->input = upipe_void_alloc_sub(upipe_fvlad->dup,
+            uprobe_pfx_alloc(uprobe_use(&upipe_fvlad->proxy_probe),
+                             UPROBE_LOG_VERBOSE, "scale input"));
+    if (unlikely(scaler->format == NULL || scaler->input == NULL))
+        goto upipe_fvlad_scaler_use_err;
+
+    scaler->scale = upipe_flow_alloc_output(scaler->input,
+            fvlad_mgr->scale_mgr,
+            uprobe_pfx_alloc(uprobe_use(&upipe_fvlad->proxy_probe),
+                             UPROBE_LOG_VERBOSE, "scale"),
+            format);
+    if (unlikely(scaler->scale == NULL))
+        goto upipe_fvlad_scaler_use_err;
+
+    scaler->dup = upipe_void_alloc_output(scaler->scale, fvlad_mgr->dup_mgr,
+            uprobe_pfx_alloc(uprobe_use(&upipe_fvlad->proxy_probe),
+                             UPROBE_LOG_VERBOSE, "scale dup"));
+    if (unlikely(scaler->dup == NULL))
+        goto upipe_fvlad_scaler_use_err;
+
+    ulist_add(&upipe_fvlad->scalers, upipe_fvlad_scaler_to_uchain(scaler));
+    return scaler;
+
+upipe_fvlad_scaler_use_err:
+    upipe_release(scaler->input);
+    upipe_release(scaler->scale);
+    uref_free(scaler->format);
+    free(scaler);
+    return NULL;
+}
+
+/** @internal @This places the encoder of a rendition in a worker thread if
+ * the manager has workers.
+ *
+ * @param upipe description structure of the rendition
+ * @param encoder encoder pipe (belongs to the callee)
+ * @return pointer to the encoder or its worker, or NULL in case of error
+ */
+static struct upipe *upipe_fvlad_output_place_encoder(struct upipe *upipe,
+                                                      struct upipe *encoder)
+{
+    struct upipe_fvlad_output *upipe_fvlad_output =
+        upipe_fvlad_output_from_upipe(upipe);
+    struct upipe_fvlad *upipe_fvlad = upipe_fvlad_from_sub_mgr(upipe->mgr);
+    struct upipe_fvlad_mgr *fvlad_mgr =
+        upipe_fvlad_mgr_from_upipe_mgr(upipe_fvlad_to_upipe(upipe_fvlad)->mgr);
+
+    struct upipe_mgr *worker_mgr = upipe_work_pool_next(&fvlad_mgr->workers);
+    if (worker_mgr == NULL)
+        return encoder;
+
+    return upipe_work_pool_alloc(worker_mgr,
+            uprobe_pfx_alloc(uprobe_use(&upipe_fvlad_output->last_inner_probe),
+                             UPROBE_LOG_VERBOSE, "encode worker"),
+            encoder,
+            uprobe_pfx_alloc(uprobe_use(fvlad_mgr->workers.uprobe),
+                             UPROBE_LOG_VERBOSE, "encode worker"));
+}
+
+/** @internal @This allocates a rendition of a fvlad pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *_upipe_fvlad_output_alloc(struct upipe_mgr *mgr,
+                                               struct uprobe *uprobe,
+                                               uint32_t signature,
+                                               va_list args)
+{
+    if (signature != UPIPE_FVLAD_OUTPUT_SIGNATURE) {
+        uprobe_release(uprobe);
+        return NULL;
+    }
+    struct uref *format = va_arg(args, struct uref *);
+    struct upipe *encoder = va_arg(args, struct upipe *);
+    if (unlikely(encoder == NULL)) {
+        uprobe_release(uprobe);
+        return NULL;
+    }
+
+    struct upipe_fvlad_output *upipe_fvlad_output =
+        malloc(sizeof(struct upipe_fvlad_output));
+    if (unlikely(upipe_fvlad_output == NULL)) {
+        upipe_release(encoder);
+        uprobe_release(uprobe);
+        return NULL;
+    }
+    struct upipe *upipe = upipe_fvlad_output_to_upipe(upipe_fvlad_output);
+    upipe_init(upipe, mgr, uprobe);
+
+    upipe_fvlad_output_init_urefcount(upipe);
+    urefcount_init(upipe_fvlad_output_to_urefcount_real(upipe_fvlad_output),
+                   upipe_fvlad_output_free);
+    upipe_fvlad_output_init_last_inner_probe(upipe);
+    upipe_fvlad_output_init_bin_output(upipe);
+    upipe_fvlad_output_init_sub(upipe);
+    upipe_fvlad_output->scaler = NULL;
+    upipe_fvlad_output->input = NULL;
+    upipe_throw_ready(upipe);
+
+    struct upipe_fvlad *upipe_fvlad = upipe_fvlad_from_sub_mgr(mgr);
+    struct upipe *dup = upipe_fvlad->dup;
+    if (format != NULL) {
+        upipe_fvlad_output->scaler =
+            upipe_fvlad_scaler_use(upipe_fvlad_to_upipe(upipe_fvlad), format);
+        if (unlikely(upipe_fvlad_output->scaler == NULL)) {
+            upipe_err(upipe, "unable to allocate scaling stage");
+            upipe_release(encoder);
+            upipe_release(upipe);
+            return NULL;
+        }
+        dup = upipe_fvlad_output->scaler->dup;
+    }
+
+    encoder = upipe_fvlad_output_place_encoder(upipe, encoder);
+    if (unlikely(encoder == NULL)) {
+        upipe_err(upipe, "unable to allocate encode worker");
+        upipe_release(upipe);
+        return NULL;
+    }
+    upipe_fvlad_output_store_bin_output(upipe, encoder);
+
+    if (unlikely(dup == NULL ||
+                 (upipe_fvlad_output->input = upipe_void_alloc_sub(dup,
+                    uprobe_pfx_alloc(
+                        uprobe_use(&upipe_fvlad_output->last_inner_probe),
+                        UPROBE_LOG_VERBOSE, "input"))) == NULL ||
+                 !ubase_check(upipe_set_output(upipe_fvlad_output->input,
+                                               encoder)))) {
+        upipe_release(upipe);
+        return NULL;
+    }
+    return upipe;
+}
+
+/** @internal @This processes control commands on a rendition of a fvlad
+ * pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_fvlad_output_control(struct upipe *upipe,
+                                      int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(upipe_fvlad_output_control_super(upipe, command, args));
+    return upipe_fvlad_output_control_bin_output(upipe, command, args);
+}
+
+/** @This frees a rendition.
+ *
+ * @param urefcount_real pointer to urefcount_real structure
+ */
+static void upipe_fvlad_output_free(struct urefcount *urefcount_real)
+{
+    struct upipe_fvlad_output *upipe_fvlad_output =
+        upipe_fvlad_output_from_urefcount_real(urefcount_real);
+    struct upipe *upipe = upipe_fvlad_output_to_upipe(upipe_fvlad_output);
+
+    upipe_throw_dead(upipe);
+
+    upipe_fvlad_output_clean_last_inner_probe(upipe);
+    upipe_fvlad_output_clean_sub(upipe);
+    urefcount_clean(urefcount_real);
+    upipe_fvlad_output_clean_urefcount(upipe);
+    upipe_clean(upipe);
+    free(upipe_fvlad_output);
+}
+
+/** @This is called when there is no external reference to the rendition
+ * anymore.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fvlad_output_no_ref(struct upipe *upipe)
+{
+    struct upipe_fvlad_output *upipe_fvlad_output =
+        upipe_fvlad_output_from_upipe(upipe);
+
+    upipe_release(upipe_fvlad_output->input);
+    upipe_fvlad_output->input = NULL;
+    upipe_fvlad_output_clean_bin_output(upipe);
+    if (upipe_fvlad_output->scaler != NULL)
+        upipe_fvlad_scaler_release(upipe_fvlad_output->scaler);
+    upipe_fvlad_output->scaler = NULL;
+    urefcount_release(upipe_fvlad_output_to_urefcount_real(upipe_fvlad_output));
+}
+
+/** @internal @This initializes the rendition manager of a fvlad pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fvlad_init_sub_mgr(struct upipe *upipe)
+{
+    struct upipe_fvlad *upipe_fvlad = upipe_fvlad_from_upipe(upipe);
+    struct upipe_mgr *sub_mgr = &upipe_fvlad->sub_mgr;
+    sub_mgr->refcount = upipe_fvlad_to_urefcount_real(upipe_fvlad);
+    sub_mgr->signature = UPIPE_FVLAD_OUTPUT_SIGNATURE;
+    sub_mgr->upipe_alloc = _upipe_fvlad_output_alloc;
+    sub_mgr->upipe_input = NULL;
+    sub_mgr->upipe_control = upipe_fvlad_output_control;
+    sub_mgr->upipe_mgr_control = NULL;
+}
+
+/** @internal @This allocates a fvlad pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_fvlad_alloc(struct upipe_mgr *mgr,
+                                       struct uprobe *uprobe,
+                                       uint32_t signature, va_list args)
+{
+    struct upipe_fvlad_mgr *fvlad_mgr = upipe_fvlad_mgr_from_upipe_mgr(mgr);
+    struct upipe *upipe = upipe_fvlad_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_fvlad *upipe_fvlad = upipe_fvlad_from_upipe(upipe);
+    upipe_fvlad_init_urefcount(upipe);
+    urefcount_init(upipe_fvlad_to_urefcount_real(upipe_fvlad),
+                   upipe_fvlad_free);
+    upipe_fvlad_init_proxy_probe(upipe);
+    upipe_fvlad_init_bin_input(upipe);
+    upipe_fvlad_init_sub_mgr(upipe);
+    upipe_fvlad_init_sub_outputs(upipe);
+    ulist_init(&upipe_fvlad->scalers);
+    upipe_throw_ready(upipe);
+
+    struct upipe *dup = NULL;
+    if (fvlad_mgr->dup_mgr != NULL)
+        dup = upipe_void_alloc(fvlad_mgr->dup_mgr,
+                uprobe_pfx_alloc(uprobe_use(&upipe_fvlad->proxy_probe),
+                                 UPROBE_LOG_VERBOSE, "dup"));
+    if (unlikely(dup == NULL)) {
+        upipe_err(upipe, "unable to allocate dup");
+        upipe_release(upipe);
+        return NULL;
+    }
+    upipe_fvlad_store_bin_input(upipe, dup);
+    return upipe;
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_fvlad_set_flow_def(struct upipe *upipe, struct uref *flow_def)
+{
+    struct upipe_fvlad *upipe_fvlad = upipe_fvlad_from_upipe(upipe);
+    const char *def;
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_get_def(flow_def, &def))
+    if (unlikely(ubase_ncmp(def, "pic.")))
+        return UBASE_ERR_INVALID;
+    if (unlikely(upipe_fvlad->dup == NULL))
+        return UBASE_ERR_INVALID;
+    return upipe_set_flow_def(upipe_fvlad->dup, flow_def);
+}
+
+/** @internal @This processes control commands on a fvlad pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_fvlad_control(struct upipe *upipe, int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(upipe_fvlad_control_outputs(upipe, command, args));
+
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_fvlad_set_flow_def(upipe, flow_def);
+        }
+        default:
+            return upipe_fvlad_control_bin_input(upipe, command, args);
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param urefcount_real pointer to urefcount_real structure
+ */
+static void upipe_fvlad_free(struct urefcount *urefcount_real)
+{
+    struct upipe_fvlad *upipe_fvlad =
+        upipe_fvlad_from_urefcount_real(urefcount_real);
+    struct upipe *upipe = upipe_fvlad_to_upipe(upipe_fvlad);
+
+    upipe_throw_dead(upipe);
+
+    upipe_fvlad_clean_sub_outputs(upipe);
+    upipe_fvlad_clean_proxy_probe(upipe);
+    urefcount_clean(urefcount_real);
+    upipe_fvlad_clean_urefcount(upipe);
+    upipe_fvlad_free_void(upipe);
+}
+
+/** @This is called when there is no external reference to the pipe anymore.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fvlad_no_ref(struct upipe *upipe)
+{
+    struct upipe_fvlad *upipe_fvlad = upipe_fvlad_from_upipe(upipe);
+    upipe_fvlad_clean_bin_input(upipe);
+    upipe_fvlad_throw_sub_outputs(upipe, UPROBE_SOURCE_END);
+    urefcount_release(upipe_fvlad_to_urefcount_real(upipe_fvlad));
+}
+
+/** @This frees a upipe manager.
+ *
+ * @param urefcount pointer to urefcount structure
+ */
+static void upipe_fvlad_mgr_free(struct urefcount *urefcount)
+{
+    struct upipe_fvlad_mgr *fvlad_mgr =
+        upipe_fvlad_mgr_from_urefcount(urefcount);
+    upipe_mgr_release(fvlad_mgr->dup_mgr);
+    upipe_mgr_release(fvlad_mgr->scale_mgr);
+    upipe_work_pool_clean(&fvlad_mgr->workers);
+
+    urefcount_clean(urefcount);
+    free(fvlad_mgr);
+}
+
+/** @This processes control commands on a fvlad manager.
+ *
+ * @param mgr pointer to manager
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_fvlad_mgr_control(struct upipe_mgr *mgr,
+                                   int command, va_list args)
+{
+    struct upipe_fvlad_mgr *fvlad_mgr = upipe_fvlad_mgr_from_upipe_mgr(mgr);
+
+    switch (command) {
+#define GET_SET_MGR(name, NAME)                                             \
+        case UPIPE_FVLAD_MGR_GET_##NAME##_MGR: {                            \
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FVLAD_SIGNATURE)              \
+            struct upipe_mgr **p = va_arg(args, struct upipe_mgr **);       \
+            *p = fvlad_mgr->name##_mgr;                                     \
+            return UBASE_ERR_NONE;                                          \
+        }                                                                   \
+        case UPIPE_FVLAD_MGR_SET_##NAME##_MGR: {                            \
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FVLAD_SIGNATURE)              \
+            if (!urefcount_single(&fvlad_mgr->urefcount))                   \
+                return UBASE_ERR_BUSY;                                      \
+            struct upipe_mgr *m = va_arg(args, struct upipe_mgr *);         \
+            upipe_mgr_release(fvlad_mgr->name##_mgr);                       \
+            fvlad_mgr->name##_mgr = upipe_mgr_use(m);                       \
+            return UBASE_ERR_NONE;                                          \
+        }
+
+        GET_SET_MGR(dup, DUP)
+        GET_SET_MGR(scale, SCALE)
+#undef GET_SET_MGR
+
+        case UPIPE_FVLAD_MGR_GET_WORKERS:
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FVLAD_SIGNATURE)
+            return upipe_work_pool_get_workers_va(&fvlad_mgr->workers, args);
+        case UPIPE_FVLAD_MGR_SET_WORKERS:
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FVLAD_SIGNATURE)
+            if (!urefcount_single(&fvlad_mgr->urefcount))
+                return UBASE_ERR_BUSY;
+            return upipe_work_pool_set_workers_va(&fvlad_mgr->workers, args);
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This returns the management structure for all fvlad pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_fvlad_mgr_alloc(void)
+{
+    struct upipe_fvlad_mgr *fvlad_mgr =
+        malloc(sizeof(struct upipe_fvlad_mgr));
+    if (unlikely(fvlad_mgr == NULL))
+        return NULL;
+
+    memset(fvlad_mgr, 0, sizeof(*fvlad_mgr));
+    fvlad_mgr->dup_mgr = upipe_dup_mgr_alloc();
+    fvlad_mgr->scale_mgr = NULL;
+    upipe_work_pool_init(&fvlad_mgr->workers);
+
+    urefcount_init(upipe_fvlad_mgr_to_urefcount(fvlad_mgr),
+                   upipe_fvlad_mgr_free);
+    fvlad_mgr->mgr.refcount = upipe_fvlad_mgr_to_urefcount(fvlad_mgr);
+    fvlad_mgr->mgr.signature = UPIPE_FVLAD_SIGNATURE;
+    fvlad_mgr->mgr.upipe_alloc = upipe_fvlad_alloc;
+    fvlad_mgr->mgr.upipe_input = upipe_fvlad_bin_input;
+    fvlad_mgr->mgr.upipe_control = upipe_fvlad_control;
+    fvlad_mgr->mgr.upipe_mgr_control = upipe_fvlad_mgr_control;
+    return upipe_fvlad_mgr_to_upipe_mgr(fvlad_mgr);
+}
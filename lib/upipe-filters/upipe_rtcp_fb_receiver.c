@@ -31,7 +31,7 @@
 #include <upipe/uref_block.h>
 #include <upipe/uref_block_flow.h>
 #include <upipe/uref_flow.h>
-#include <upipe/upipe.h>
+#include <upipe/uref_ring.h>
 #include <upipe/upipe_helper_upipe.h>
 #include <upipe/upipe_helper_subpipe.h>
 #include <upipe/upipe_helper_urefcount.h>
@@ -40,7 +40,6 @@
 #include <upipe/upipe_helper_input.h>
 #include <upipe/upipe_helper_uref_mgr.h>
 #include <upipe/upipe_helper_ubuf_mgr.h>
-#include <upipe/upipe_helper_upump_mgr.h>
 #include <upipe/upipe_helper_uclock.h>
 #include <upipe-filters/upipe_rtcp_fb_receiver.h>
 
@@ -67,6 +66,14 @@
 
 #define EXPECTED_FLOW_DEF "block."
 
+/** size of the retransmission buffer, in packets */
+#define RTCPFB_RING_SIZE UREF_RING_MAX_SIZE
+/** maximum number of retransmissions waiting for credit, per receiver */
+#define RTCPFB_PENDING_SIZE 1024
+/** duration of the retransmissions allowed in a burst at the maximum
+ * bitrate */
+#define RTCPFB_BURST (UCLOCK_FREQ / 10)
+
 /** upipe_rtcpfb structure */
 struct upipe_rtcpfb {
     /** real refcount management structure */
@@ -85,19 +92,14 @@ struct upipe_rtcpfb {
 
     struct upipe_mgr sub_mgr;
 
-    struct upump_mgr *upump_mgr;
-    struct upump *upump_timer;
     struct uclock *uclock;
     struct urequest uclock_request;
-    struct uchain queue;
-    unsigned last_seq;
+    /** retransmission buffer, indexed by sequence number */
+    struct uref_ring ring;
 
     /** list of input subpipes */
     struct uchain inputs;
 
-    /** expected sequence number */
-    int expected_seqnum;
-
     /** output pipe */
     struct upipe *output;
     /** input flow definition packet */
@@ -131,7 +133,6 @@ UPIPE_HELPER_UBUF_MGR(upipe_rtcpfb, ubuf_mgr, flow_def, ubuf_mgr_request,
                       upipe_rtcpfb_register_output_request,
                       upipe_rtcpfb_unregister_output_request)
 UBASE_FROM_TO(upipe_rtcpfb, urefcount, urefcount_real, urefcount_real)
-UPIPE_HELPER_UPUMP_MGR(upipe_rtcpfb, upump_mgr)
 UPIPE_HELPER_UCLOCK(upipe_rtcpfb, uclock, uclock_request, NULL, upipe_throw_provide_request, NULL)
 
 struct upipe_rtcpfb_input {
@@ -140,6 +141,8 @@ struct upipe_rtcpfb_input {
     /** structure for double-linked lists */
     struct uchain uchain;
 
+    /** input flow definition packet */
+    struct uref *flow_def_input;
     /** pipe acting as output */
     struct upipe *output;
     /** flow definition packet */
@@ -149,6 +152,19 @@ struct upipe_rtcpfb_input {
     /** list of output requests */
     struct uchain request_list;
 
+    /** maximum retransmission bitrate, or 0 */
+    uint64_t max_rate;
+    /** retransmission credit, in bits */
+    int64_t credit;
+    /** date of the last credit update */
+    uint64_t credit_date;
+    /** retransmissions waiting for credit */
+    uint16_t pending[RTCPFB_PENDING_SIZE];
+    /** index of the first pending retransmission */
+    unsigned int pending_first;
+    /** number of pending retransmissions */
+    unsigned int pending_count;
+
     /** public upipe structure */
     struct upipe upipe;
 
@@ -159,6 +175,7 @@ struct upipe_rtcpfb_input {
 };
 
 static void upipe_rtcpfb_lost_sub(struct upipe *upipe, uint16_t seq, uint16_t mask);
+static void upipe_rtcpfb_input_schedule(struct upipe *upipe);
 
 /** @internal @This handles NACK RTCP messages.
  *
@@ -211,6 +228,7 @@ static inline void upipe_rtcpfb_input_sub(struct upipe *upipe, struct uref *uref
         upipe_verbose_va(upipe, "Received NACK: %hu (0x%hx)", id, mask);
         upipe_rtcpfb_lost_sub(upipe, id, mask);
     }
+    upipe_rtcpfb_input_schedule(upipe);
 
 end:
     uref_block_peek_unmap(uref, 0, NULL, rtp);
@@ -219,6 +237,8 @@ end:
 
 UPIPE_HELPER_UPIPE(upipe_rtcpfb_input, upipe, UPIPE_RTCPFB_INPUT_SIGNATURE)
 UPIPE_HELPER_UREFCOUNT(upipe_rtcpfb_input, urefcount, upipe_rtcpfb_input_free)
+UPIPE_HELPER_OUTPUT(upipe_rtcpfb_input, output, flow_def, output_state,
+                    request_list)
 UPIPE_HELPER_INPUT(upipe_rtcpfb_input, urefs, nb_urefs, max_urefs, blockers, NULL)
 UPIPE_HELPER_SUBPIPE(upipe_rtcpfb, upipe_rtcpfb_input, output, sub_mgr, inputs,
                      uchain)
@@ -235,26 +255,30 @@ static int ctz(unsigned int x)
 #endif
 }
 
-/** @internal @This retransmits a list of packets described by a single FCI.
- * TODO: handle a list of FCIs.
+/** @internal @This queues the retransmission of a list of packets described
+ * by a single FCI.
+ *
+ * @param upipe description structure of the subpipe
+ * @param seq sequence number of the first lost packet
+ * @param mask bitmask of the following lost packets
  */
 static void upipe_rtcpfb_lost_sub(struct upipe *upipe, uint16_t seq, uint16_t mask)
 {
-    struct upipe *upipe_super = NULL;
-    upipe_rtcpfb_input_get_super(upipe, &upipe_super);
-    struct upipe_rtcpfb *upipe_rtcpfb = upipe_rtcpfb_from_upipe(upipe_super);
-
-    struct uchain *uchain;
-    ulist_foreach(&upipe_rtcpfb->queue, uchain) {
-        struct uref *uref = uref_from_uchain(uchain);
-        uint64_t uref_seqnum = 0;
-        uref_attr_get_priv(uref, &uref_seqnum);
-
-        if (seq != uref_seqnum)
-            continue;
+    struct upipe_rtcpfb_input *upipe_rtcpfb_input =
+        upipe_rtcpfb_input_from_upipe(upipe);
 
-        upipe_warn_va(upipe, "Retransmit %hu", seq);
-        upipe_rtcpfb_output(upipe_super, uref_dup(uref), NULL);
+    for ( ; ; ) {
+        if (upipe_rtcpfb_input->pending_count == RTCPFB_PENDING_SIZE) {
+            upipe_warn_va(upipe, "Drop retransmission of %hu",
+                upipe_rtcpfb_input->pending[upipe_rtcpfb_input->pending_first]);
+            upipe_rtcpfb_input->pending_first =
+                (upipe_rtcpfb_input->pending_first + 1) % RTCPFB_PENDING_SIZE;
+            upipe_rtcpfb_input->pending_count--;
+        }
+        upipe_rtcpfb_input->pending[(upipe_rtcpfb_input->pending_first +
+                                     upipe_rtcpfb_input->pending_count) %
+                                    RTCPFB_PENDING_SIZE] = seq;
+        upipe_rtcpfb_input->pending_count++;
 
         if (!mask)
             return;
@@ -263,8 +287,83 @@ static void upipe_rtcpfb_lost_sub(struct upipe *upipe, uint16_t seq, uint16_t ma
         mask >>= zeros + 1;
         seq += zeros + 1;
     }
+}
+
+/** @internal @This updates the retransmission credit of a subpipe.
+ *
+ * @param upipe description structure of the subpipe
+ * @param now current date
+ */
+static void upipe_rtcpfb_input_refill(struct upipe *upipe, uint64_t now)
+{
+    struct upipe_rtcpfb_input *upipe_rtcpfb_input =
+        upipe_rtcpfb_input_from_upipe(upipe);
+    int64_t max_credit =
+        upipe_rtcpfb_input->max_rate * RTCPFB_BURST / UCLOCK_FREQ;
+
+    if (upipe_rtcpfb_input->credit_date == UINT64_MAX ||
+        now - upipe_rtcpfb_input->credit_date >= RTCPFB_BURST)
+        upipe_rtcpfb_input->credit = max_credit;
+    else {
+        upipe_rtcpfb_input->credit += (now - upipe_rtcpfb_input->credit_date) *
+            upipe_rtcpfb_input->max_rate / UCLOCK_FREQ;
+        if (upipe_rtcpfb_input->credit > max_credit)
+            upipe_rtcpfb_input->credit = max_credit;
+    }
+    upipe_rtcpfb_input->credit_date = now;
+}
+
+/** @internal @This retransmits the pending packets of a subpipe, as long as
+ * its credit allows it. The packets which are no longer in the
+ * retransmission buffer are dropped.
+ *
+ * @param upipe description structure of the subpipe
+ */
+static void upipe_rtcpfb_input_schedule(struct upipe *upipe)
+{
+    struct upipe_rtcpfb_input *upipe_rtcpfb_input =
+        upipe_rtcpfb_input_from_upipe(upipe);
+    struct upipe *upipe_super = NULL;
+    upipe_rtcpfb_input_get_super(upipe, &upipe_super);
+    struct upipe_rtcpfb *upipe_rtcpfb = upipe_rtcpfb_from_upipe(upipe_super);
+
+    bool limited = upipe_rtcpfb_input->max_rate && upipe_rtcpfb->uclock;
+    if (limited)
+        upipe_rtcpfb_input_refill(upipe, uclock_now(upipe_rtcpfb->uclock));
+
+    while (upipe_rtcpfb_input->pending_count) {
+        uint16_t seq =
+            upipe_rtcpfb_input->pending[upipe_rtcpfb_input->pending_first];
+        struct uref *uref = uref_ring_get(&upipe_rtcpfb->ring, seq);
+        if (uref != NULL && limited) {
+            if (upipe_rtcpfb_input->credit <= 0)
+                return;
+            size_t size = 0;
+            uref_block_size(uref, &size);
+            upipe_rtcpfb_input->credit -= size * 8;
+        }
+
+        upipe_rtcpfb_input->pending_first =
+            (upipe_rtcpfb_input->pending_first + 1) % RTCPFB_PENDING_SIZE;
+        upipe_rtcpfb_input->pending_count--;
 
-    upipe_warn_va(upipe, "Couldn't find seq %hu", seq);
+        if (uref == NULL) {
+            upipe_warn_va(upipe, "Couldn't find seq %hu", seq);
+            continue;
+        }
+
+        uref = uref_dup(uref);
+        if (unlikely(uref == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+
+        upipe_verbose_va(upipe, "Retransmit %hu", seq);
+        if (upipe_rtcpfb_input->output != NULL)
+            upipe_rtcpfb_input_output(upipe, uref, NULL);
+        else
+            upipe_rtcpfb_output(upipe_super, uref, NULL);
+    }
 }
 
 /** @This is called when there is no external reference to the pipe anymore.
@@ -300,15 +399,30 @@ static struct upipe *upipe_rtcpfb_input_alloc(struct upipe_mgr *mgr,
     if (unlikely(upipe_rtcpfb_input == NULL))
         return NULL;
 
-    upipe_rtcpfb_input->flow_def = NULL;
+    upipe_rtcpfb_input->flow_def_input = NULL;
+    upipe_rtcpfb_input->max_rate = 0;
+    upipe_rtcpfb_input->credit = 0;
+    upipe_rtcpfb_input->credit_date = UINT64_MAX;
+    upipe_rtcpfb_input->pending_first = 0;
+    upipe_rtcpfb_input->pending_count = 0;
 
     struct upipe *upipe = upipe_rtcpfb_input_to_upipe(upipe_rtcpfb_input);
     upipe_init(upipe, mgr, uprobe);
     upipe_rtcpfb_input_init_urefcount(upipe);
+    upipe_rtcpfb_input_init_output(upipe);
     upipe_rtcpfb_input_init_input(upipe);
     upipe_rtcpfb_input_init_sub(upipe);
 
     upipe_throw_ready(upipe);
+
+    if (upipe_rtcpfb->flow_def_input != NULL) {
+        struct uref *flow_def = uref_dup(upipe_rtcpfb->flow_def_input);
+        if (unlikely(flow_def == NULL)) {
+            upipe_release(upipe);
+            return NULL;
+        }
+        upipe_rtcpfb_input_store_flow_def(upipe, flow_def);
+    }
     return upipe;
 }
 
@@ -322,7 +436,9 @@ static void upipe_rtcpfb_input_free(struct upipe *upipe)
         upipe_rtcpfb_input_from_upipe(upipe);
     upipe_throw_dead(upipe);
 
+    uref_free(upipe_rtcpfb_input->flow_def_input);
     upipe_rtcpfb_input_clean_input(upipe);
+    upipe_rtcpfb_input_clean_output(upipe);
     upipe_rtcpfb_input_clean_sub(upipe);
     upipe_rtcpfb_input_clean_urefcount(upipe);
     upipe_clean(upipe);
@@ -370,8 +486,8 @@ static int upipe_rtcpfb_input_set_flow_def(struct upipe *upipe, struct uref *flo
         return UBASE_ERR_ALLOC;
 
     struct upipe_rtcpfb_input *upipe_rtcpfb_input = upipe_rtcpfb_input_from_upipe(upipe);
-    uref_free(upipe_rtcpfb_input->flow_def);
-    upipe_rtcpfb_input->flow_def = flow_def_dup;
+    uref_free(upipe_rtcpfb_input->flow_def_input);
+    upipe_rtcpfb_input->flow_def_input = flow_def_dup;
     return UBASE_ERR_NONE;
 }
 
@@ -386,6 +502,9 @@ static int upipe_rtcpfb_input_set_flow_def(struct upipe *upipe, struct uref *flo
 static int upipe_rtcpfb_input_control(struct upipe *upipe,
                                     int command, va_list args)
 {
+    UBASE_HANDLED_RETURN(
+        upipe_rtcpfb_input_control_output(upipe, command, args));
+
     switch (command) {
         case UPIPE_SET_FLOW_DEF: {
             struct uref *flow_def = va_arg(args, struct uref *);
@@ -395,6 +514,22 @@ static int upipe_rtcpfb_input_control(struct upipe *upipe,
             struct upipe **p = va_arg(args, struct upipe **);
             return upipe_rtcpfb_input_get_super(upipe, p);
         }
+        case UPIPE_RTCPFB_INPUT_SET_MAX_RATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTCPFB_INPUT_SIGNATURE)
+            struct upipe_rtcpfb_input *upipe_rtcpfb_input =
+                upipe_rtcpfb_input_from_upipe(upipe);
+            upipe_rtcpfb_input->max_rate = va_arg(args, uint64_t);
+            upipe_rtcpfb_input->credit_date = UINT64_MAX;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_RTCPFB_INPUT_GET_MAX_RATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTCPFB_INPUT_SIGNATURE)
+            struct upipe_rtcpfb_input *upipe_rtcpfb_input =
+                upipe_rtcpfb_input_from_upipe(upipe);
+            uint64_t *p = va_arg(args, uint64_t *);
+            *p = upipe_rtcpfb_input->max_rate;
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -418,39 +553,6 @@ static void upipe_rtcpfb_init_sub_mgr(struct upipe *upipe)
 
 static void upipe_rtcpfb_free(struct urefcount *urefcount_real);
 
-/** @internal this timer removes from the queue packets that are too
- * early to be recovered by receiver.
- */
-static void upipe_rtcpfb_timer(struct upump *upump)
-{
-    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
-    struct upipe_rtcpfb *upipe_rtcpfb = upipe_rtcpfb_from_upipe(upipe);
-
-    uint64_t now = uclock_now(upipe_rtcpfb->uclock);
-
-    struct uchain *uchain, *uchain_tmp;
-    ulist_delete_foreach(&upipe_rtcpfb->queue, uchain, uchain_tmp) {
-        struct uref *uref = uref_from_uchain(uchain);
-
-        uint64_t seqnum = 0;
-        uref_attr_get_priv(uref, &seqnum);
-
-        uint64_t cr_sys = 0;
-        if (unlikely(!ubase_check(uref_clock_get_cr_sys(uref, &cr_sys))))
-            upipe_warn(upipe, "Couldn't read cr_sys");
-
-        if (now - cr_sys < upipe_rtcpfb->latency * UCLOCK_FREQ / 1000)
-            return;
-
-        upipe_verbose_va(upipe, "Delete seq %" PRIu64 " after %"PRIu64" clocks",
-                seqnum, now - cr_sys);
-
-        ulist_delete(uchain);
-        uref_free(uref);
-    }
-}
-
-
 /** @internal @This allocates a rtcpfb pipe.
  *
  * @param mgr common management structure
@@ -468,33 +570,59 @@ static struct upipe *upipe_rtcpfb_alloc(struct upipe_mgr *mgr,
         return NULL;
 
     struct upipe_rtcpfb *upipe_rtcpfb = upipe_rtcpfb_from_upipe(upipe);
+    if (unlikely(!ubase_check(uref_ring_init(&upipe_rtcpfb->ring,
+                                             RTCPFB_RING_SIZE)))) {
+        upipe_rtcpfb_free_void(upipe);
+        return NULL;
+    }
+
     upipe_rtcpfb_init_urefcount(upipe);
     urefcount_init(upipe_rtcpfb_to_urefcount_real(upipe_rtcpfb), upipe_rtcpfb_free);
-    upipe_rtcpfb_init_upump_mgr(upipe);
-    upipe_rtcpfb_check_upump_mgr(upipe);
     upipe_rtcpfb_init_uclock(upipe);
-    ulist_init(&upipe_rtcpfb->queue);
     upipe_rtcpfb_init_output(upipe);
     upipe_rtcpfb_init_sub_mgr(upipe);
     upipe_rtcpfb_init_sub_outputs(upipe);
-    upipe_rtcpfb->expected_seqnum = -1;
     upipe_rtcpfb->flow_def_input = NULL;
     upipe_rtcpfb_init_ubuf_mgr(upipe);
     upipe_rtcpfb_init_uref_mgr(upipe);
-    upipe_rtcpfb->last_seq = UINT_MAX;
     upipe_rtcpfb_require_uclock(upipe);
     upipe_rtcpfb->latency = 1000; /* 1 sec */
 
-    /* This timer does not need to run frequently */
-    upipe_rtcpfb->upump_timer = upump_alloc_timer(upipe_rtcpfb->upump_mgr,
-            upipe_rtcpfb_timer, upipe, upipe->refcount,
-            UCLOCK_FREQ, UCLOCK_FREQ);
-    upump_start(upipe_rtcpfb->upump_timer);
-
     upipe_throw_ready(upipe);
     return upipe;
 }
 
+/** @internal @This removes from the retransmission buffer the packets which
+ * are too old to be recovered by receivers, and those which would prevent a
+ * new packet from being buffered.
+ *
+ * @param upipe description structure of the pipe
+ * @param seqnum sequence number of the new packet
+ * @param cr_sys date of the new packet, or UINT64_MAX
+ */
+static void upipe_rtcpfb_expire(struct upipe *upipe, uint16_t seqnum,
+                                uint64_t cr_sys)
+{
+    struct upipe_rtcpfb *upipe_rtcpfb = upipe_rtcpfb_from_upipe(upipe);
+    uint64_t latency = upipe_rtcpfb->latency * UCLOCK_FREQ / 1000;
+    struct uref *uref;
+    uint16_t first;
+
+    while ((uref = uref_ring_peek(&upipe_rtcpfb->ring, &first)) != NULL) {
+        if (uref_ring_fits(&upipe_rtcpfb->ring, seqnum) &&
+            uref_ring_get(&upipe_rtcpfb->ring, seqnum) == NULL) {
+            uint64_t first_cr_sys;
+            if (cr_sys == UINT64_MAX ||
+                !ubase_check(uref_clock_get_cr_sys(uref, &first_cr_sys)) ||
+                cr_sys < first_cr_sys + latency)
+                return;
+        }
+
+        upipe_verbose_va(upipe, "Delete seq %hu", first);
+        uref_free(uref_ring_pop(&upipe_rtcpfb->ring, NULL));
+    }
+}
+
 /** @internal @This handles data.
  *
  * @param upipe description structure of the pipe
@@ -521,17 +649,37 @@ static inline void upipe_rtcpfb_input(struct upipe *upipe, struct uref *uref,
 #endif
     uref_block_peek_unmap(uref, 0, rtp_buffer, rtp_header);
 
-    uref_attr_set_priv(uref, seqnum);
+    uint64_t cr_sys = UINT64_MAX;
+    if (unlikely(!ubase_check(uref_clock_get_cr_sys(uref, &cr_sys))))
+        upipe_warn(upipe, "Couldn't read cr_sys");
+    upipe_rtcpfb_expire(upipe, seqnum, cr_sys);
 
     /* Output packet immediately */
-    upipe_rtcpfb_output(upipe, uref_dup(uref), NULL); // FIXME : upump?
+    struct uref *output = uref_dup(uref);
+    if (unlikely(output == NULL)) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    upipe_rtcpfb_output(upipe, output, upump_p);
 
     upipe_verbose_va(upipe, "Output & buffer %hu", seqnum);
 
-    /* Buffer packet in case retransmission is needed */
-    ulist_add(&upipe_rtcpfb->queue, uref_to_uchain(uref));
+    /* Buffer packet in case retransmission is needed, the buffers are
+     * shared by all receivers */
+    if (unlikely(!ubase_check(uref_ring_insert(&upipe_rtcpfb->ring, seqnum,
+                                               uref))))
+        uref_free(uref);
 
-    upipe_rtcpfb->last_seq = seqnum;
+    /* Credits may have been replenished since the last packet */
+    struct uchain *uchain;
+    ulist_foreach(&upipe_rtcpfb->inputs, uchain) {
+        struct upipe_rtcpfb_input *upipe_rtcpfb_input =
+            upipe_rtcpfb_input_from_uchain(uchain);
+        if (upipe_rtcpfb_input->pending_count)
+            upipe_rtcpfb_input_schedule(
+                upipe_rtcpfb_input_to_upipe(upipe_rtcpfb_input));
+    }
 }
 
 /** @internal @This sets the input flow definition.
@@ -551,7 +699,20 @@ static int upipe_rtcpfb_set_flow_def(struct upipe *upipe, struct uref *flow_def)
     struct upipe_rtcpfb *upipe_rtcpfb = upipe_rtcpfb_from_upipe(upipe);
     uref_free(upipe_rtcpfb->flow_def_input);
     upipe_rtcpfb->flow_def_input = flow_def_dup;
-    upipe_rtcpfb_store_flow_def(upipe, flow_def);
+
+    if (unlikely((flow_def_dup = uref_dup(flow_def)) == NULL))
+        return UBASE_ERR_ALLOC;
+    upipe_rtcpfb_store_flow_def(upipe, flow_def_dup);
+
+    struct uchain *uchain;
+    ulist_foreach(&upipe_rtcpfb->inputs, uchain) {
+        struct upipe_rtcpfb_input *upipe_rtcpfb_input =
+            upipe_rtcpfb_input_from_uchain(uchain);
+        if (unlikely((flow_def_dup = uref_dup(flow_def)) == NULL))
+            return UBASE_ERR_ALLOC;
+        upipe_rtcpfb_input_store_flow_def(
+            upipe_rtcpfb_input_to_upipe(upipe_rtcpfb_input), flow_def_dup);
+    }
 
     return UBASE_ERR_NONE;
 }
@@ -633,17 +794,9 @@ static void upipe_rtcpfb_free(struct urefcount *urefcount_real)
     upipe_rtcpfb_clean_urefcount(upipe);
     upipe_rtcpfb_clean_ubuf_mgr(upipe);
     upipe_rtcpfb_clean_uref_mgr(upipe);
-    upump_stop(upipe_rtcpfb->upump_timer);
-    upump_free(upipe_rtcpfb->upump_timer);
-    upipe_rtcpfb_clean_upump_mgr(upipe);
     upipe_rtcpfb_clean_uclock(upipe);
-
-    struct uchain *uchain, *uchain_tmp;
-    ulist_delete_foreach(&upipe_rtcpfb->queue, uchain, uchain_tmp) {
-        struct uref *uref = uref_from_uchain(uchain);
-        ulist_delete(uchain);
-        uref_free(uref);
-    }
+    upipe_rtcpfb_clean_sub_outputs(upipe);
+    uref_ring_clean(&upipe_rtcpfb->ring);
 
     upipe_rtcpfb_free_void(upipe);
 }
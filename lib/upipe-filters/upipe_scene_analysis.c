@@ -0,0 +1,458 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe scene analysis filter
+ *
+ * The luma plane of each picture is reduced to a proxy of at most
+ * 64x36 block averages, computed on every other line and column. The
+ * spatial activity of the proxy is compared to its difference with the
+ * previous proxy to detect scene cuts, in the manner of the scenecut
+ * option of x264, and keyframes are placed on scene cuts within the
+ * configured keyframe intervals. A quantizer offset hint is derived from
+ * the ratio between the temporal complexity of the picture and its recent
+ * average.
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uref.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_pic.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe-filters/upipe_scene_analysis.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+/** maximum width of the proxy */
+#define PROXY_WIDTH 64
+/** maximum height of the proxy */
+#define PROXY_HEIGHT 36
+/** fixed-point scale of the complexities */
+#define COMPLEXITY_SCALE 16
+/** minimum mean temporal difference of a scene cut, in luma steps */
+#define MIN_CUT_DIFFERENCE 4
+/** default minimum keyframe interval */
+#define DEFAULT_MIN_KEYINT 25
+/** default maximum keyframe interval */
+#define DEFAULT_MAX_KEYINT 250
+/** default scene cut threshold */
+#define DEFAULT_THRESHOLD 40
+/** maximum absolute quantizer offset hint */
+#define MAX_QP_OFFSET 6
+
+/** @internal @This is the private context of a scene analysis pipe. */
+struct upipe_scene_analysis {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** output pipe */
+    struct upipe *output;
+    /** output flow */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** minimum keyframe interval */
+    unsigned int min_keyint;
+    /** maximum keyframe interval */
+    unsigned int max_keyint;
+    /** scene cut threshold */
+    unsigned int threshold;
+
+    /** width of the proxy */
+    size_t proxy_width;
+    /** height of the proxy */
+    size_t proxy_height;
+    /** true if the previous proxy is valid */
+    bool has_prev;
+    /** proxy of the current picture */
+    uint8_t *proxy;
+    /** proxy of the previous picture */
+    uint8_t *prev;
+    /** number of pictures since the last keyframe */
+    unsigned int since_key;
+    /** running average of the temporal complexity */
+    uint64_t avg_complexity;
+    /** buffers of the proxies */
+    uint8_t proxies[2][PROXY_WIDTH * PROXY_HEIGHT];
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_scene_analysis, upipe, UPIPE_SCENE_ANALYSIS_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_scene_analysis, urefcount,
+                       upipe_scene_analysis_free)
+UPIPE_HELPER_VOID(upipe_scene_analysis)
+UPIPE_HELPER_OUTPUT(upipe_scene_analysis, output, flow_def, output_state,
+                    request_list)
+
+/** @internal @This allocates a scene analysis pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_scene_analysis_alloc(struct upipe_mgr *mgr,
+                                                struct uprobe *uprobe,
+                                                uint32_t signature,
+                                                va_list args)
+{
+    struct upipe *upipe =
+        upipe_scene_analysis_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_scene_analysis *upipe_scene_analysis =
+        upipe_scene_analysis_from_upipe(upipe);
+    upipe_scene_analysis_init_urefcount(upipe);
+    upipe_scene_analysis_init_output(upipe);
+    upipe_scene_analysis->min_keyint = DEFAULT_MIN_KEYINT;
+    upipe_scene_analysis->max_keyint = DEFAULT_MAX_KEYINT;
+    upipe_scene_analysis->threshold = DEFAULT_THRESHOLD;
+    upipe_scene_analysis->proxy_width = 0;
+    upipe_scene_analysis->proxy_height = 0;
+    upipe_scene_analysis->has_prev = false;
+    upipe_scene_analysis->proxy = upipe_scene_analysis->proxies[0];
+    upipe_scene_analysis->prev = upipe_scene_analysis->proxies[1];
+    upipe_scene_analysis->since_key = 0;
+    upipe_scene_analysis->avg_complexity = 0;
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This computes the proxy of a luma plane.
+ *
+ * @param upipe description structure of the pipe
+ * @param buffer luma plane
+ * @param stride stride of the luma plane
+ * @param hsize width of the luma plane
+ * @param vsize height of the luma plane
+ */
+static void upipe_scene_analysis_proxy(struct upipe *upipe,
+                                       const uint8_t *buffer, size_t stride,
+                                       size_t hsize, size_t vsize)
+{
+    struct upipe_scene_analysis *upipe_scene_analysis =
+        upipe_scene_analysis_from_upipe(upipe);
+    size_t block_width = (hsize + PROXY_WIDTH - 1) / PROXY_WIDTH;
+    size_t block_height = (vsize + PROXY_HEIGHT - 1) / PROXY_HEIGHT;
+    size_t width = hsize / block_width;
+    size_t height = vsize / block_height;
+    size_t step_x = block_width > 1 ? 2 : 1;
+    size_t step_y = block_height > 1 ? 2 : 1;
+
+    if (width != upipe_scene_analysis->proxy_width ||
+        height != upipe_scene_analysis->proxy_height) {
+        upipe_scene_analysis->proxy_width = width;
+        upipe_scene_analysis->proxy_height = height;
+        upipe_scene_analysis->has_prev = false;
+    }
+
+    uint8_t *proxy = upipe_scene_analysis->proxy;
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            const uint8_t *block = buffer + y * block_height * stride +
+                                   x * block_width;
+            unsigned int sum = 0, count = 0;
+            for (size_t j = 0; j < block_height; j += step_y) {
+                for (size_t i = 0; i < block_width; i += step_x)
+                    sum += block[i];
+                block += step_y * stride;
+                count += (block_width + step_x - 1) / step_x;
+            }
+            proxy[y * width + x] = (sum + count / 2) / count;
+        }
+    }
+}
+
+/** @internal @This returns the mean spatial activity of the current proxy.
+ *
+ * @param upipe description structure of the pipe
+ * @return mean of the horizontal and vertical absolute differences, in
+ * 1/COMPLEXITY_SCALE of luma step
+ */
+static uint64_t upipe_scene_analysis_intra(struct upipe *upipe)
+{
+    struct upipe_scene_analysis *upipe_scene_analysis =
+        upipe_scene_analysis_from_upipe(upipe);
+    size_t width = upipe_scene_analysis->proxy_width;
+    size_t height = upipe_scene_analysis->proxy_height;
+    const uint8_t *proxy = upipe_scene_analysis->proxy;
+    uint64_t sum = 0, count = 0;
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            int v = proxy[y * width + x];
+            if (x) {
+                sum += abs(v - proxy[y * width + x - 1]);
+                count++;
+            }
+            if (y) {
+                sum += abs(v - proxy[(y - 1) * width + x]);
+                count++;
+            }
+        }
+    }
+    return count ? sum * COMPLEXITY_SCALE / count : 0;
+}
+
+/** @internal @This returns the mean temporal difference between the current
+ * and previous proxies.
+ *
+ * @param upipe description structure of the pipe
+ * @return mean absolute difference, in 1/COMPLEXITY_SCALE of luma step
+ */
+static uint64_t upipe_scene_analysis_inter(struct upipe *upipe)
+{
+    struct upipe_scene_analysis *upipe_scene_analysis =
+        upipe_scene_analysis_from_upipe(upipe);
+    size_t size = upipe_scene_analysis->proxy_width *
+                  upipe_scene_analysis->proxy_height;
+    const uint8_t *proxy = upipe_scene_analysis->proxy;
+    const uint8_t *prev = upipe_scene_analysis->prev;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < size; i++)
+        sum += abs(proxy[i] - prev[i]);
+    return size ? sum * COMPLEXITY_SCALE / size : 0;
+}
+
+/** @internal @This analyses a picture and attaches the decisions.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_scene_analysis_input(struct upipe *upipe, struct uref *uref,
+                                       struct upump **upump_p)
+{
+    struct upipe_scene_analysis *upipe_scene_analysis =
+        upipe_scene_analysis_from_upipe(upipe);
+    size_t hsize, vsize, stride;
+    const uint8_t *buffer;
+    if (unlikely(!ubase_check(uref_pic_size(uref, &hsize, &vsize, NULL)) ||
+                 !ubase_check(uref_pic_plane_size(uref, "y8", &stride,
+                                                  NULL, NULL, NULL)) ||
+                 !ubase_check(uref_pic_plane_read(uref, "y8", 0, 0, -1, -1,
+                                                  &buffer)))) {
+        upipe_warn(upipe, "invalid picture received");
+        uref_free(uref);
+        return;
+    }
+    if (unlikely(!hsize || !vsize)) {
+        uref_pic_plane_unmap(uref, "y8", 0, 0, -1, -1);
+        upipe_warn(upipe, "empty picture received");
+        uref_free(uref);
+        return;
+    }
+    upipe_scene_analysis_proxy(upipe, buffer, stride, hsize, vsize);
+    uref_pic_plane_unmap(uref, "y8", 0, 0, -1, -1);
+
+    bool key = !upipe_scene_analysis->has_prev ||
+          ++upipe_scene_analysis->since_key >= upipe_scene_analysis->max_keyint;
+    if (upipe_scene_analysis->has_prev) {
+        uint64_t intra = upipe_scene_analysis_intra(upipe);
+        uint64_t inter = upipe_scene_analysis_inter(upipe);
+        unsigned int threshold = upipe_scene_analysis->threshold;
+        bool cut = threshold &&
+            inter >= MIN_CUT_DIFFERENCE * COMPLEXITY_SCALE &&
+            inter * 100 > intra * (100 - threshold);
+        if (cut) {
+            upipe_verbose_va(upipe, "scene cut (intra %"PRIu64
+                             ", inter %"PRIu64")", intra, inter);
+            UBASE_FATAL(upipe, uref_scene_set_cut(uref))
+            if (upipe_scene_analysis->since_key >=
+                upipe_scene_analysis->min_keyint)
+                key = true;
+        }
+        UBASE_FATAL(upipe, uref_scene_set_complexity(uref, inter))
+
+        uint64_t avg = upipe_scene_analysis->avg_complexity;
+        if (!cut) {
+            double ratio = (double)(inter + COMPLEXITY_SCALE) /
+                           (avg + COMPLEXITY_SCALE);
+            long qp_offset = lrint(3. * log2(ratio));
+            if (qp_offset > MAX_QP_OFFSET)
+                qp_offset = MAX_QP_OFFSET;
+            else if (qp_offset < -MAX_QP_OFFSET)
+                qp_offset = -MAX_QP_OFFSET;
+            if (qp_offset)
+                UBASE_FATAL(upipe, uref_scene_set_qp_offset(uref, qp_offset))
+            upipe_scene_analysis->avg_complexity = (avg * 7 + inter) / 8;
+        }
+    }
+    if (key) {
+        UBASE_FATAL(upipe, uref_scene_set_key(uref))
+        upipe_scene_analysis->since_key = 0;
+    }
+
+    uint8_t *prev = upipe_scene_analysis->prev;
+    upipe_scene_analysis->prev = upipe_scene_analysis->proxy;
+    upipe_scene_analysis->proxy = prev;
+    upipe_scene_analysis->has_prev = true;
+
+    upipe_scene_analysis_output(upipe, uref, upump_p);
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_scene_analysis_set_flow_def(struct upipe *upipe,
+                                             struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, UREF_PIC_FLOW_DEF))
+    uint8_t plane;
+    UBASE_RETURN(uref_pic_flow_find_chroma(flow_def, "y8", &plane))
+
+    struct uref *flow_def_dup;
+    if (unlikely((flow_def_dup = uref_dup(flow_def)) == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_scene_analysis_store_flow_def(upipe, flow_def_dup);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the keyframe intervals.
+ *
+ * @param upipe description structure of the pipe
+ * @param min minimum number of pictures between two keyframes
+ * @param max maximum number of pictures between two keyframes
+ * @return an error code
+ */
+static int _upipe_scene_analysis_set_keyint(struct upipe *upipe,
+                                            unsigned int min,
+                                            unsigned int max)
+{
+    struct upipe_scene_analysis *upipe_scene_analysis =
+        upipe_scene_analysis_from_upipe(upipe);
+    if (!max || min > max)
+        return UBASE_ERR_INVALID;
+    upipe_scene_analysis->min_keyint = min;
+    upipe_scene_analysis->max_keyint = max;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a scene analysis pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_scene_analysis_control(struct upipe *upipe,
+                                        int command, va_list args)
+{
+    struct upipe_scene_analysis *upipe_scene_analysis =
+        upipe_scene_analysis_from_upipe(upipe);
+
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST:
+        case UPIPE_UNREGISTER_REQUEST:
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_scene_analysis_control_output(upipe, command, args);
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_scene_analysis_set_flow_def(upipe, flow_def);
+        }
+        case UPIPE_SCENE_ANALYSIS_GET_KEYINT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SCENE_ANALYSIS_SIGNATURE)
+            unsigned int *min_p = va_arg(args, unsigned int *);
+            unsigned int *max_p = va_arg(args, unsigned int *);
+            if (min_p != NULL)
+                *min_p = upipe_scene_analysis->min_keyint;
+            if (max_p != NULL)
+                *max_p = upipe_scene_analysis->max_keyint;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SCENE_ANALYSIS_SET_KEYINT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SCENE_ANALYSIS_SIGNATURE)
+            unsigned int min = va_arg(args, unsigned int);
+            unsigned int max = va_arg(args, unsigned int);
+            return _upipe_scene_analysis_set_keyint(upipe, min, max);
+        }
+        case UPIPE_SCENE_ANALYSIS_SET_THRESHOLD: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SCENE_ANALYSIS_SIGNATURE)
+            unsigned int threshold = va_arg(args, unsigned int);
+            if (threshold > 100)
+                return UBASE_ERR_INVALID;
+            upipe_scene_analysis->threshold = threshold;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This frees a scene analysis pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_scene_analysis_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    upipe_scene_analysis_clean_output(upipe);
+    upipe_scene_analysis_clean_urefcount(upipe);
+    upipe_scene_analysis_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_scene_analysis_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_SCENE_ANALYSIS_SIGNATURE,
+
+    .upipe_alloc = upipe_scene_analysis_alloc,
+    .upipe_input = upipe_scene_analysis_input,
+    .upipe_control = upipe_scene_analysis_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for scene analysis pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_scene_analysis_mgr_alloc(void)
+{
+    return &upipe_scene_analysis_mgr;
+}
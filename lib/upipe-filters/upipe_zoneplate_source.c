@@ -40,6 +40,9 @@
 
 #include "zoneplate/videotestsrc.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 /** @internal @This is the private structure of a zoneplate source pipe. */
 struct upipe_zp {
     /* UPIPE_HELPER_UPIPE */
@@ -75,6 +78,13 @@ struct upipe_zp {
 
     int frame_counter;
     uint64_t pts, interval;
+
+    /** rendered zoneplate lines, indexed by phase */
+    void *lines;
+    /** width of the rendered lines */
+    size_t lines_width;
+    /** true if the rendered lines hold 10-bit samples */
+    bool lines_10bit;
 };
 
 /** @hidden */
@@ -114,6 +124,7 @@ static void upipe_zp_free(struct upipe *upipe)
     upipe_zp_clean_output(upipe);
     upipe_zp_clean_upump_mgr(upipe);
     upipe_zp_clean_upump(upipe);
+    free(upipe_zp->lines);
 
     upipe_zp_free_flow(upipe);
 }
@@ -161,33 +172,63 @@ static struct upipe *upipe_zp_alloc(struct upipe_mgr *mgr,
     upipe_zp_store_flow_def(upipe, flow_def);
 
     upipe_zp->pts = UINT64_MAX;
+    upipe_zp->lines = NULL;
+    upipe_zp->lines_width = 0;
+    upipe_zp->lines_10bit = false;
 
     upipe_throw_ready(upipe);
     return upipe;
 }
 
+/** @internal @This renders the 256 possible zoneplate lines.
+ *
+ * @param upipe description structure of the pipe
+ * @param width width of the lines
+ * @param is_10bit true to render 10-bit samples
+ * @return an error code
+ */
+static int upipe_zp_render_lines(struct upipe *upipe, size_t width,
+                                 bool is_10bit)
+{
+    struct upipe_zp *upipe_zp = upipe_zp_from_upipe(upipe);
+    if (upipe_zp->lines != NULL && upipe_zp->lines_width == width &&
+        upipe_zp->lines_10bit == is_10bit)
+        return UBASE_ERR_NONE;
+
+    free(upipe_zp->lines);
+    upipe_zp->lines = malloc(256 * width * (is_10bit ? 2 : 1));
+    UBASE_ALLOC_RETURN(upipe_zp->lines);
+    upipe_zp->lines_width = width;
+    upipe_zp->lines_10bit = is_10bit;
+    if (is_10bit)
+        gst_video_test_src_zoneplate_lines_10bit(upipe_zp->lines, width);
+    else
+        gst_video_test_src_zoneplate_lines_8bit(upipe_zp->lines, width);
+    return UBASE_ERR_NONE;
+}
+
 static int draw_zoneplate(struct upipe *upipe, struct uref *uref, int frame)
 {
+    struct upipe_zp *upipe_zp = upipe_zp_from_upipe(upipe);
     const char *chroma = NULL;
     while (ubase_check(uref_pic_plane_iterate(uref, &chroma)) &&
             chroma != NULL) {
-        if (!strncmp(chroma, "y8", 2)) {
-            uint8_t *buf;
-            size_t stride, width, height;
-            UBASE_RETURN(uref_pic_size(uref, &width, &height, NULL));
-            UBASE_RETURN(uref_pic_plane_size(uref, chroma, &stride, NULL, NULL, NULL));
-            UBASE_RETURN(uref_pic_plane_write(uref, chroma, 0, 0, -1, -1, &buf));
-            gst_video_test_src_zoneplate_8bit(buf, width, height, stride, frame);
-            UBASE_RETURN(uref_pic_plane_unmap(uref, chroma, 0, 0, -1, -1));
-        }
-
-        else if (!strncmp(chroma, "y10", 3)) {
+        bool is_8bit = !strncmp(chroma, "y8", 2);
+        bool is_10bit = !strncmp(chroma, "y10", 3);
+        if (is_8bit || is_10bit) {
+            /* pictures are assembled from the cached lines */
             uint8_t *buf;
             size_t stride, width, height;
             UBASE_RETURN(uref_pic_size(uref, &width, &height, NULL));
             UBASE_RETURN(uref_pic_plane_size(uref, chroma, &stride, NULL, NULL, NULL));
+            UBASE_RETURN(upipe_zp_render_lines(upipe, width, is_10bit));
             UBASE_RETURN(uref_pic_plane_write(uref, chroma, 0, 0, -1, -1, &buf));
-            gst_video_test_src_zoneplate_10bit((uint16_t*)buf, width, height, stride, frame);
+            size_t line_size = width * (is_10bit ? 2 : 1);
+            const uint8_t *lines = upipe_zp->lines;
+            for (size_t j = 0; j < height; j++) {
+                int line = gst_video_test_src_zoneplate_line(j, height, frame);
+                memcpy(buf + j * stride, lines + line * line_size, line_size);
+            }
             UBASE_RETURN(uref_pic_plane_unmap(uref, chroma, 0, 0, -1, -1));
         }
 
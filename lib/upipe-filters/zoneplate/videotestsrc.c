@@ -235,3 +235,55 @@ gst_video_test_src_zoneplate_10bit (uint16_t *data,
     }
   }
 }
+
+/* Without cross terms, the phase of a pixel is the sum of a term in x and
+ * of a term in y and t. A line then only depends on the latter modulo 256,
+ * so the 256 possible lines are rendered once and pictures are assembled
+ * by copying lines. */
+#if V_POINTER_KXT != 0 || V_POINTER_KYT != 0 || V_POINTER_KXY != 0
+#error zoneplate lines are not separable
+#endif
+
+static int
+gst_video_test_src_zoneplate_x_phase (int i, int w)
+{
+  int x = i - (w / 2) - V_POINTER_XOFFSET;
+  int scale_kx2 = 0xffff / w;
+
+  return V_POINTER_KX * (i + 1) + ((V_POINTER_KX2 * x * x * scale_kx2) >> 16);
+}
+
+int
+gst_video_test_src_zoneplate_line (int j, int h, int t)
+{
+  int y = j - (h / 2) - V_POINTER_YOFFSET;
+
+  return (V_POINTER_K0 + V_POINTER_KY * (j + 1) + V_POINTER_KT * t
+      + (V_POINTER_KY2 * y * y) / h + ((V_POINTER_KT2 * t * t) >> 1)) & 0xff;
+}
+
+void
+gst_video_test_src_zoneplate_lines_8bit (uint8_t *lines, int w)
+{
+  int i;
+  int p;
+
+  for (i = 0; i < w; i++) {
+    int phase = gst_video_test_src_zoneplate_x_phase (i, w);
+    for (p = 0; p < 256; p++)
+      lines[p * w + i] = sine_table[(phase + p) & 0xff];
+  }
+}
+
+void
+gst_video_test_src_zoneplate_lines_10bit (uint16_t *lines, int w)
+{
+  int i;
+  int p;
+
+  for (i = 0; i < w; i++) {
+    int phase = gst_video_test_src_zoneplate_x_phase (i, w);
+    for (p = 0; p < 256; p++)
+      lines[p * w + i] = sine_table[(phase + p) & 0xff] << 2;
+  }
+}
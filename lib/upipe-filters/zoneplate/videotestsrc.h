@@ -5,3 +5,14 @@ gst_video_test_src_zoneplate_8bit (uint8_t *data,
 void
 gst_video_test_src_zoneplate_10bit (uint16_t *data,
         int w, int h, size_t stride, int t);
+
+/* returns the index of line j of picture t in the rendered lines */
+int
+gst_video_test_src_zoneplate_line (int j, int h, int t);
+
+/* renders the 256 possible lines of width w */
+void
+gst_video_test_src_zoneplate_lines_8bit (uint8_t *lines, int w);
+
+void
+gst_video_test_src_zoneplate_lines_10bit (uint16_t *lines, int w);
@@ -159,92 +159,81 @@ static struct upipe *upipe_autof_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
-/** @internal @This allocates the framer.
+/** @internal @This selects the framer manager for a flow definition.
  *
  * @param upipe description structure of the pipe
  * @param def flow definition string
- * @return pointer to framer
+ * @param name_p filled with the name of the framer
+ * @return pointer to framer manager
  */
-static struct upipe *upipe_autof_alloc_framer(struct upipe *upipe,
-                                              const char *def)
+static struct upipe_mgr *upipe_autof_select_framer(struct upipe *upipe,
+                                                   const char *def,
+                                                   const char **name_p)
 {
     struct upipe_autof_mgr *autof_mgr =
         upipe_autof_mgr_from_upipe_mgr(upipe->mgr);
-    struct upipe_autof *autof = upipe_autof_from_upipe(upipe);
 
     if ((!ubase_ncmp(def, "block.mp2.") ||
          !ubase_ncmp(def, "block.mp3.") ||
          !ubase_ncmp(def, "block.aac.") ||
          !ubase_ncmp(def, "block.aac_latm.")) &&
-        autof_mgr->mpgaf_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->mpgaf_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "mpgaf"));
+        autof_mgr->mpgaf_mgr != NULL) {
+        *name_p = "mpgaf";
+        return autof_mgr->mpgaf_mgr;
+    }
 
     if ((!ubase_ncmp(def, "block.ac3.") ||
          !ubase_ncmp(def, "block.eac3.")) &&
-        autof_mgr->a52f_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->a52f_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "a52f"));
+        autof_mgr->a52f_mgr != NULL) {
+        *name_p = "a52f";
+        return autof_mgr->a52f_mgr;
+    }
 
     if ((!ubase_ncmp(def, "block.mpeg2video.") ||
          !ubase_ncmp(def, "block.mpeg1video.")) &&
-        autof_mgr->mpgvf_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->mpgvf_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "mpgvf"));
+        autof_mgr->mpgvf_mgr != NULL) {
+        *name_p = "mpgvf";
+        return autof_mgr->mpgvf_mgr;
+    }
 
     if (!ubase_ncmp(def, "block.h264.") &&
-        autof_mgr->h264f_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->h264f_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "h264f"));
+        autof_mgr->h264f_mgr != NULL) {
+        *name_p = "h264f";
+        return autof_mgr->h264f_mgr;
+    }
 
     if (!ubase_ncmp(def, "block.hevc.") &&
-        autof_mgr->h265f_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->h265f_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "h265f"));
+        autof_mgr->h265f_mgr != NULL) {
+        *name_p = "h265f";
+        return autof_mgr->h265f_mgr;
+    }
 
     if (!ubase_ncmp(def, "block.dvb_teletext.") &&
-        autof_mgr->telxf_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->telxf_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "telxf"));
+        autof_mgr->telxf_mgr != NULL) {
+        *name_p = "telxf";
+        return autof_mgr->telxf_mgr;
+    }
 
     if (!ubase_ncmp(def, "block.dvb_subtitle.") &&
-        autof_mgr->dvbsubf_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->dvbsubf_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "dvbsubf"));
+        autof_mgr->dvbsubf_mgr != NULL) {
+        *name_p = "dvbsubf";
+        return autof_mgr->dvbsubf_mgr;
+    }
 
     if (!ubase_ncmp(def, "block.opus.") &&
-        autof_mgr->opusf_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->opusf_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "opusf"));
+        autof_mgr->opusf_mgr != NULL) {
+        *name_p = "opusf";
+        return autof_mgr->opusf_mgr;
+    }
 
     if (!ubase_ncmp(def, "block.s302m.") &&
-        autof_mgr->s302f_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->s302f_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "s302f"));
-
-    upipe_warn_va(upipe, "unframed inner flow definition: %s", def);
-    return upipe_void_alloc(autof_mgr->idem_mgr,
-            uprobe_pfx_alloc(
-                uprobe_use(&autof->last_inner_probe),
-                UPROBE_LOG_VERBOSE, "idem"));
+        autof_mgr->s302f_mgr != NULL) {
+        *name_p = "s302f";
+        return autof_mgr->s302f_mgr;
+    }
+
+    *name_p = "idem";
+    return autof_mgr->idem_mgr;
 }
 
 /** @internal @This sets the input flow definition.
@@ -269,6 +258,22 @@ static int upipe_autof_set_flow_def(struct upipe *upipe, struct uref *flow_def)
         return upipe_set_flow_def(upipe_autof->first_inner, flow_def);
     }
 
+    const char *name;
+    struct upipe_mgr *framer_mgr =
+        upipe_autof_select_framer(upipe, def, &name);
+
+    /* the framer already in place parses the new flow, let it handle the
+     * flow definition change in band instead of respawning it */
+    if (upipe_autof->first_inner != NULL &&
+        upipe_autof->first_inner->mgr == framer_mgr &&
+        ubase_check(upipe_set_flow_def(upipe_autof->first_inner,
+                                       flow_def))) {
+        upipe_dbg_va(upipe, "reusing framer %s for %s", name, def);
+        uref_free(upipe_autof->flow_def);
+        upipe_autof->flow_def = uref_dup(flow_def);
+        return UBASE_ERR_NONE;
+    }
+
     if (upipe_autof->flow_def != NULL)
         upipe_dbg_va(upipe, "respawning framer %s", def);
     uref_free(upipe_autof->flow_def);
@@ -276,7 +281,13 @@ static int upipe_autof_set_flow_def(struct upipe *upipe, struct uref *flow_def)
     upipe_autof_store_bin_input(upipe, NULL);
     upipe_autof_store_bin_output(upipe, NULL);
 
-    struct upipe *inner = upipe_autof_alloc_framer(upipe, def);
+    struct upipe_autof_mgr *autof_mgr =
+        upipe_autof_mgr_from_upipe_mgr(upipe->mgr);
+    if (framer_mgr == autof_mgr->idem_mgr)
+        upipe_warn_va(upipe, "unframed inner flow definition: %s", def);
+    struct upipe *inner = upipe_void_alloc(framer_mgr,
+            uprobe_pfx_alloc(uprobe_use(&upipe_autof->last_inner_probe),
+                             UPROBE_LOG_VERBOSE, name));
     if (unlikely(inner == NULL)) {
         upipe_err_va(upipe, "couldn't allocate framer");
         return UBASE_ERR_ALLOC;
@@ -26,28 +26,56 @@
 
 #include <stdint.h>
 
+#include <upipe/ubase.h>
 #include <upipe-framers/upipe_framers_common.h>
 
-/** @This scans for an MPEG-style 3-octet start code in a linear buffer.
+#include "upipe_framers_scan.h"
+
+#if defined(__i686__) || defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/* Code from libav/libavcodec/mpegvideo.c, published under LGPL 2.1+ */
+/** @internal @This feeds the first octets of a buffer to the state, to find
+ * start codes spanning several buffers.
  *
- * @param p linear buffer
+ * @param p_p pointer to the linear buffer, advanced by up to 3 octets
  * @param end end of linear buffer
  * @param state state of the algorithm
- * @return pointer to start code, or end if not found
+ * @return true if a start code was found or the buffer is exhausted
  */
-/* Code from libav/libavcodec/mpegvideo.c, published under LGPL 2.1+ */
-const uint8_t *upipe_framers_mpeg_scan(const uint8_t *restrict p,
-                                       const uint8_t *end,
-                                       uint32_t *restrict state)
+static inline bool
+    upipe_framers_mpeg_scan_head(const uint8_t *restrict *p_p,
+                                 const uint8_t *end, uint32_t *restrict state)
 {
+    const uint8_t *p = *p_p;
     int i;
     for (i = 0; i < 3; i++) {
         uint32_t tmp = *state << 8;
         *state = tmp + *(p++);
-        if (tmp == 0x100 || p == end)
-            return p;
+        if (tmp == 0x100 || p == end) {
+            *p_p = p;
+            return true;
+        }
     }
+    *p_p = p;
+    return false;
+}
 
+/** @internal @This scans the rest of a buffer, once at least 3 octets have
+ * been fed to the state.
+ *
+ * @param p linear buffer, preceded by at least 3 octets already scanned
+ * @param end end of linear buffer
+ * @param state state of the algorithm
+ * @return pointer to start code, or end if not found
+ */
+static inline const uint8_t *
+    upipe_framers_mpeg_scan_tail(const uint8_t *restrict p,
+                                 const uint8_t *end, uint32_t *restrict state)
+{
     while (p < end) {
         if      (p[-1] > 1      ) p += 3;
         else if (p[-2]          ) p += 2;
@@ -65,3 +93,154 @@ const uint8_t *upipe_framers_mpeg_scan(const uint8_t *restrict p,
     return p;
 }
 /* End code */
+
+/** @This scans for an MPEG-style 3-octet start code in a linear buffer, one
+ * candidate position at a time.
+ *
+ * @param p linear buffer
+ * @param end end of linear buffer
+ * @param state state of the algorithm
+ * @return pointer to start code, or end if not found
+ */
+const uint8_t *upipe_framers_mpeg_scan_c(const uint8_t *restrict p,
+                                         const uint8_t *end,
+                                         uint32_t *restrict state)
+{
+    if (upipe_framers_mpeg_scan_head(&p, end, state))
+        return p;
+    return upipe_framers_mpeg_scan_tail(p, end, state);
+}
+
+/* In the vector loops, p points past a candidate 00 00 01 ending at p - 1,
+ * like in the scalar loop. Each iteration tests the candidates ending at
+ * p - 1 to p + n - 2, and stops on the first match so that the scalar loop
+ * picks it up immediately. */
+
+#if defined(__i686__) || defined(__x86_64__)
+/** @This scans for an MPEG-style 3-octet start code in a linear buffer, 16
+ * candidate positions at a time (SSE2).
+ *
+ * @param p linear buffer
+ * @param end end of linear buffer
+ * @param state state of the algorithm
+ * @return pointer to start code, or end if not found
+ */
+__attribute__((target("sse2")))
+const uint8_t *upipe_framers_mpeg_scan_sse2(const uint8_t *restrict p,
+                                            const uint8_t *end,
+                                            uint32_t *restrict state)
+{
+    if (upipe_framers_mpeg_scan_head(&p, end, state))
+        return p;
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    while (p + 15 <= end) {
+        const uint8_t *base = p - 3;
+        __m128i b0 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)base),
+                                    zero);
+        __m128i b1 = _mm_cmpeq_epi8(
+                _mm_loadu_si128((const __m128i *)(base + 1)), zero);
+        __m128i b2 = _mm_cmpeq_epi8(
+                _mm_loadu_si128((const __m128i *)(base + 2)), one);
+        uint32_t mask = _mm_movemask_epi8(
+                _mm_and_si128(_mm_and_si128(b0, b1), b2));
+        if (mask) {
+            p += __builtin_ctz(mask);
+            break;
+        }
+        p += 16;
+    }
+    return upipe_framers_mpeg_scan_tail(p, end, state);
+}
+
+/** @This scans for an MPEG-style 3-octet start code in a linear buffer, 32
+ * candidate positions at a time (AVX2).
+ *
+ * @param p linear buffer
+ * @param end end of linear buffer
+ * @param state state of the algorithm
+ * @return pointer to start code, or end if not found
+ */
+__attribute__((target("avx2")))
+const uint8_t *upipe_framers_mpeg_scan_avx2(const uint8_t *restrict p,
+                                            const uint8_t *end,
+                                            uint32_t *restrict state)
+{
+    if (upipe_framers_mpeg_scan_head(&p, end, state))
+        return p;
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    while (p + 31 <= end) {
+        const uint8_t *base = p - 3;
+        __m256i b0 = _mm256_cmpeq_epi8(
+                _mm256_loadu_si256((const __m256i *)base), zero);
+        __m256i b1 = _mm256_cmpeq_epi8(
+                _mm256_loadu_si256((const __m256i *)(base + 1)), zero);
+        __m256i b2 = _mm256_cmpeq_epi8(
+                _mm256_loadu_si256((const __m256i *)(base + 2)), one);
+        uint32_t mask = _mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_and_si256(b0, b1), b2));
+        if (mask) {
+            p += __builtin_ctz(mask);
+            break;
+        }
+        p += 32;
+    }
+    return upipe_framers_mpeg_scan_tail(p, end, state);
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/** @This scans for an MPEG-style 3-octet start code in a linear buffer, 16
+ * candidate positions at a time (NEON).
+ *
+ * @param p linear buffer
+ * @param end end of linear buffer
+ * @param state state of the algorithm
+ * @return pointer to start code, or end if not found
+ */
+const uint8_t *upipe_framers_mpeg_scan_neon(const uint8_t *restrict p,
+                                            const uint8_t *end,
+                                            uint32_t *restrict state)
+{
+    if (upipe_framers_mpeg_scan_head(&p, end, state))
+        return p;
+
+    const uint8x16_t one = vdupq_n_u8(1);
+    while (p + 15 <= end) {
+        const uint8_t *base = p - 3;
+        uint8x16_t match = vandq_u8(vceqzq_u8(vld1q_u8(base)),
+                                    vceqzq_u8(vld1q_u8(base + 1)));
+        match = vandq_u8(match, vceqq_u8(vld1q_u8(base + 2), one));
+        if (vmaxvq_u8(match))
+            /* the scalar loop below finds the exact position */
+            break;
+        p += 16;
+    }
+    return upipe_framers_mpeg_scan_tail(p, end, state);
+}
+#endif
+
+/** @This scans for an MPEG-style 3-octet start code in a linear buffer.
+ *
+ * @param p linear buffer
+ * @param end end of linear buffer
+ * @param state state of the algorithm
+ * @return pointer to start code, or end if not found
+ */
+const uint8_t *upipe_framers_mpeg_scan(const uint8_t *restrict p,
+                                       const uint8_t *end,
+                                       uint32_t *restrict state)
+{
+#if defined(__i686__) || defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2"))
+        return upipe_framers_mpeg_scan_avx2(p, end, state);
+    if (__builtin_cpu_supports("sse2"))
+        return upipe_framers_mpeg_scan_sse2(p, end, state);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    return upipe_framers_mpeg_scan_neon(p, end, state);
+#endif
+    return upipe_framers_mpeg_scan_c(p, end, state);
+}
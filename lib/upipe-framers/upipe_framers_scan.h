@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe start code scanners for framers
+ * The variants below are called by @ref upipe_framers_mpeg_scan, which picks
+ * the fastest one supported by the CPU. They are exported for checkasm.
+ */
+
+#ifndef _UPIPE_FRAMERS_UPIPE_FRAMERS_SCAN_H_
+/** @hidden */
+#define _UPIPE_FRAMERS_UPIPE_FRAMERS_SCAN_H_
+
+#include <stdint.h>
+
+/** @This scans for an MPEG-style 3-octet start code in a linear buffer, one
+ * candidate position at a time.
+ *
+ * @param p linear buffer
+ * @param end end of linear buffer
+ * @param state state of the algorithm
+ * @return pointer to start code, or end if not found
+ */
+const uint8_t *upipe_framers_mpeg_scan_c(const uint8_t *restrict p,
+                                         const uint8_t *end,
+                                         uint32_t *restrict state);
+
+#if defined(__i686__) || defined(__x86_64__)
+/** @This scans for an MPEG-style 3-octet start code in a linear buffer, 16
+ * candidate positions at a time (SSE2).
+ *
+ * @param p linear buffer
+ * @param end end of linear buffer
+ * @param state state of the algorithm
+ * @return pointer to start code, or end if not found
+ */
+const uint8_t *upipe_framers_mpeg_scan_sse2(const uint8_t *restrict p,
+                                            const uint8_t *end,
+                                            uint32_t *restrict state);
+
+/** @This scans for an MPEG-style 3-octet start code in a linear buffer, 32
+ * candidate positions at a time (AVX2).
+ *
+ * @param p linear buffer
+ * @param end end of linear buffer
+ * @param state state of the algorithm
+ * @return pointer to start code, or end if not found
+ */
+const uint8_t *upipe_framers_mpeg_scan_avx2(const uint8_t *restrict p,
+                                            const uint8_t *end,
+                                            uint32_t *restrict state);
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/** @This scans for an MPEG-style 3-octet start code in a linear buffer, 16
+ * candidate positions at a time (NEON).
+ *
+ * @param p linear buffer
+ * @param end end of linear buffer
+ * @param state state of the algorithm
+ * @return pointer to start code, or end if not found
+ */
+const uint8_t *upipe_framers_mpeg_scan_neon(const uint8_t *restrict p,
+                                            const uint8_t *end,
+                                            uint32_t *restrict state);
+#endif
+
+#endif
@@ -240,6 +240,8 @@ struct upipe_h264f {
     /** true if we have thrown the sync_acquired event (that means we found a
      * NAL start) */
     bool acquired;
+    /** parsing depth */
+    enum upipe_h26xf_depth depth;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -333,6 +335,7 @@ static struct upipe *upipe_h264f_alloc(struct upipe_mgr *mgr,
     upipe_h264f->last_picture_number = 0;
     upipe_h264f->last_frame_num = -1;
     upipe_h264f->max_dec_frame_buffering = UINT32_MAX;
+    upipe_h264f->depth = UPIPE_H26XF_DEPTH_FULL;
     upipe_h264f->pic_struct = -1;
     upipe_h264f->dpb_output_delay = UINT64_MAX;
     upipe_h264f->duration = 0;
@@ -1492,6 +1495,7 @@ static int upipe_h264f_handle_nal(struct upipe *upipe, struct ubuf *ubuf,
                                   size_t offset, size_t size, bool *au_slice_p,
                                   uint8_t *nal_p)
 {
+    struct upipe_h264f *upipe_h264f = upipe_h264f_from_upipe(upipe);
     uint8_t nal;
     if (unlikely(!ubase_check(ubuf_block_extract(ubuf, offset, 1, &nal))))
         return UBASE_ERR_INVALID;
@@ -1501,6 +1505,8 @@ static int upipe_h264f_handle_nal(struct upipe *upipe, struct ubuf *ubuf,
     upipe_verbose_va(upipe, "handling NAL %"PRIu8, h264nalst_get_type(nal));
     switch (h264nalst_get_type(nal)) {
         case H264NAL_TYPE_SEI:
+            if (upipe_h264f->depth == UPIPE_H26XF_DEPTH_BOUNDARIES)
+                break;
             return upipe_h264f_handle_sei(upipe, ubuf, offset, size);
         case H264NAL_TYPE_SPS:
             return upipe_h264f_handle_sps(upipe, ubuf, offset, size);
@@ -1831,13 +1837,15 @@ static void upipe_h264f_build_flow_def(struct upipe *upipe)
 static int upipe_h264f_prepare_au(struct upipe *upipe, struct uref *uref)
 {
     struct upipe_h264f *upipe_h264f = upipe_h264f_from_upipe(upipe);
+    bool full = upipe_h264f->depth == UPIPE_H26XF_DEPTH_FULL;
     uint64_t picture_number = upipe_h264f->last_picture_number +
         (upipe_h264f->frame_num - upipe_h264f->last_frame_num);
     if (upipe_h264f->frame_num > upipe_h264f->last_frame_num) {
         upipe_h264f->last_frame_num = upipe_h264f->frame_num;
         upipe_h264f->last_picture_number = picture_number;
     }
-    UBASE_RETURN(uref_pic_set_number(uref, picture_number))
+    if (full)
+        UBASE_RETURN(uref_pic_set_number(uref, picture_number))
 
     uint64_t duration = upipe_h264f->duration;
     if (upipe_h264f->pic_struct == -1) {
@@ -1863,35 +1871,46 @@ static int upipe_h264f_prepare_au(struct upipe *upipe, struct uref *uref)
 
     switch (upipe_h264f->pic_struct) {
         case H264SEI_STRUCT_FRAME:
-            UBASE_RETURN(uref_pic_set_progressive(uref))
+            if (full)
+                UBASE_RETURN(uref_pic_set_progressive(uref))
             duration *= 2;
             break;
         case H264SEI_STRUCT_TOP:
-            UBASE_RETURN(uref_pic_set_tf(uref))
+            if (full)
+                UBASE_RETURN(uref_pic_set_tf(uref))
             break;
         case H264SEI_STRUCT_BOT:
-            UBASE_RETURN(uref_pic_set_bf(uref))
+            if (full)
+                UBASE_RETURN(uref_pic_set_bf(uref))
             break;
         case H264SEI_STRUCT_TOP_BOT:
-            UBASE_RETURN(uref_pic_set_tf(uref))
-            UBASE_RETURN(uref_pic_set_bf(uref))
-            UBASE_RETURN(uref_pic_set_tff(uref))
+            if (full) {
+                UBASE_RETURN(uref_pic_set_tf(uref))
+                UBASE_RETURN(uref_pic_set_bf(uref))
+                UBASE_RETURN(uref_pic_set_tff(uref))
+            }
             duration *= 2;
             break;
         case H264SEI_STRUCT_BOT_TOP:
-            UBASE_RETURN(uref_pic_set_tf(uref))
-            UBASE_RETURN(uref_pic_set_bf(uref))
+            if (full) {
+                UBASE_RETURN(uref_pic_set_tf(uref))
+                UBASE_RETURN(uref_pic_set_bf(uref))
+            }
             duration *= 2;
             break;
         case H264SEI_STRUCT_TOP_BOT_TOP:
-            UBASE_RETURN(uref_pic_set_tf(uref))
-            UBASE_RETURN(uref_pic_set_bf(uref))
-            UBASE_RETURN(uref_pic_set_tff(uref))
+            if (full) {
+                UBASE_RETURN(uref_pic_set_tf(uref))
+                UBASE_RETURN(uref_pic_set_bf(uref))
+                UBASE_RETURN(uref_pic_set_tff(uref))
+            }
             duration *= 3;
             break;
         case H264SEI_STRUCT_BOT_TOP_BOT:
-            UBASE_RETURN(uref_pic_set_tf(uref))
-            UBASE_RETURN(uref_pic_set_bf(uref))
+            if (full) {
+                UBASE_RETURN(uref_pic_set_tf(uref))
+                UBASE_RETURN(uref_pic_set_bf(uref))
+            }
             duration *= 3;
             break;
         case H264SEI_STRUCT_DOUBLE:
@@ -1909,7 +1928,8 @@ static int upipe_h264f_prepare_au(struct upipe *upipe, struct uref *uref)
         UBASE_RETURN(uref_clock_set_duration(uref, duration))
     }
 
-    UBASE_RETURN(uref_h264_set_type(uref, upipe_h264f->slice_type % 5))
+    if (full)
+        UBASE_RETURN(uref_h264_set_type(uref, upipe_h264f->slice_type % 5))
     switch (upipe_h264f->slice_type % 5) {
         case H264SLI_TYPE_I:
             upipe_h264f->iframe_rap = upipe_h264f->pps_rap;
@@ -2813,6 +2833,27 @@ static int upipe_h264f_check_ubuf_mgr(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the parsing depth.
+ *
+ * @param upipe description structure of the pipe
+ * @param depth parsing depth
+ * @return an error code
+ */
+static int _upipe_h264f_set_depth(struct upipe *upipe,
+                                  enum upipe_h26xf_depth depth)
+{
+    struct upipe_h264f *upipe_h264f = upipe_h264f_from_upipe(upipe);
+    switch (depth) {
+        case UPIPE_H26XF_DEPTH_FULL:
+        case UPIPE_H26XF_DEPTH_TIMING:
+        case UPIPE_H26XF_DEPTH_BOUNDARIES:
+            upipe_h264f->depth = depth;
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_INVALID;
+    }
+}
+
 /** @internal @This sets the input flow definition.
  *
  * @param upipe description structure of the pipe
@@ -2863,6 +2904,18 @@ static int upipe_h264f_control(struct upipe *upipe, int command, va_list args)
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_h264f_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_H264F_GET_DEPTH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_H264F_SIGNATURE)
+            enum upipe_h26xf_depth *depth_p =
+                va_arg(args, enum upipe_h26xf_depth *);
+            *depth_p = upipe_h264f_from_upipe(upipe)->depth;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_H264F_SET_DEPTH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_H264F_SIGNATURE)
+            enum upipe_h26xf_depth depth = va_arg(args, enum upipe_h26xf_depth);
+            return _upipe_h264f_set_depth(upipe, depth);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
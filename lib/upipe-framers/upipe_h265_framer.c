@@ -220,6 +220,8 @@ struct upipe_h265f {
     /** true if we have thrown the sync_acquired event (that means we found a
      * NAL start) */
     bool acquired;
+    /** parsing depth */
+    enum upipe_h26xf_depth depth;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -318,6 +320,7 @@ static struct upipe *upipe_h265f_alloc(struct upipe_mgr *mgr,
     upipe_h265f->general_progressive = 0;
     upipe_h265f->general_interlaced = 0;
     upipe_h265f->constraint_indicator = 0;
+    upipe_h265f->depth = UPIPE_H26XF_DEPTH_FULL;
     upipe_h265f->pic_struct = -1;
     upipe_h265f->duration = 0;
     upipe_h265f->got_discontinuity = false;
@@ -1554,6 +1557,7 @@ static int upipe_h265f_handle_nal(struct upipe *upipe, struct ubuf *ubuf,
                                   size_t offset, size_t size, bool *au_slice_p,
                                   uint8_t *nal_p)
 {
+    struct upipe_h265f *upipe_h265f = upipe_h265f_from_upipe(upipe);
     uint8_t nal;
     if (unlikely(!ubase_check(ubuf_block_extract(ubuf, offset, 1, &nal))))
         return UBASE_ERR_INVALID;
@@ -1567,6 +1571,8 @@ static int upipe_h265f_handle_nal(struct upipe *upipe, struct ubuf *ubuf,
 
     switch (h265nalst_get_type(nal)) {
         case H265NAL_TYPE_PREF_SEI:
+            if (upipe_h265f->depth == UPIPE_H26XF_DEPTH_BOUNDARIES)
+                break;
             return upipe_h265f_handle_sei(upipe, ubuf, offset, size);
             break;
         case H265NAL_TYPE_VPS:
@@ -1931,45 +1937,57 @@ static void upipe_h265f_build_flow_def(struct upipe *upipe)
 static int upipe_h265f_prepare_au(struct upipe *upipe, struct uref *uref)
 {
     struct upipe_h265f *upipe_h265f = upipe_h265f_from_upipe(upipe);
+    bool full = upipe_h265f->depth == UPIPE_H26XF_DEPTH_FULL;
     uint64_t duration = upipe_h265f->duration;
     if (upipe_h265f->pic_struct == -1)
         upipe_h265f->pic_struct = H265SEI_STRUCT_FRAME;
 
     switch (upipe_h265f->pic_struct) {
         case H265SEI_STRUCT_FRAME:
-            UBASE_FATAL(upipe, uref_pic_set_progressive(uref))
+            if (full)
+                UBASE_FATAL(upipe, uref_pic_set_progressive(uref))
             duration *= 2;
             break;
         case H265SEI_STRUCT_TOP:
         case H265SEI_STRUCT_TOP_PREV_BOT:
         case H265SEI_STRUCT_TOP_NEXT_BOT:
-            UBASE_FATAL(upipe, uref_pic_set_tf(uref))
+            if (full)
+                UBASE_FATAL(upipe, uref_pic_set_tf(uref))
             break;
         case H265SEI_STRUCT_BOT:
         case H265SEI_STRUCT_BOT_PREV_TOP:
         case H265SEI_STRUCT_BOT_NEXT_TOP:
-            UBASE_FATAL(upipe, uref_pic_set_bf(uref))
+            if (full)
+                UBASE_FATAL(upipe, uref_pic_set_bf(uref))
             break;
         case H265SEI_STRUCT_TOP_BOT:
-            UBASE_FATAL(upipe, uref_pic_set_tf(uref))
-            UBASE_FATAL(upipe, uref_pic_set_bf(uref))
-            UBASE_FATAL(upipe, uref_pic_set_tff(uref))
+            if (full) {
+                UBASE_FATAL(upipe, uref_pic_set_tf(uref))
+                UBASE_FATAL(upipe, uref_pic_set_bf(uref))
+                UBASE_FATAL(upipe, uref_pic_set_tff(uref))
+            }
             duration *= 2;
             break;
         case H265SEI_STRUCT_BOT_TOP:
-            UBASE_FATAL(upipe, uref_pic_set_tf(uref))
-            UBASE_FATAL(upipe, uref_pic_set_bf(uref))
+            if (full) {
+                UBASE_FATAL(upipe, uref_pic_set_tf(uref))
+                UBASE_FATAL(upipe, uref_pic_set_bf(uref))
+            }
             duration *= 2;
             break;
         case H265SEI_STRUCT_TOP_BOT_TOP:
-            UBASE_FATAL(upipe, uref_pic_set_tf(uref))
-            UBASE_FATAL(upipe, uref_pic_set_bf(uref))
-            UBASE_FATAL(upipe, uref_pic_set_tff(uref))
+            if (full) {
+                UBASE_FATAL(upipe, uref_pic_set_tf(uref))
+                UBASE_FATAL(upipe, uref_pic_set_bf(uref))
+                UBASE_FATAL(upipe, uref_pic_set_tff(uref))
+            }
             duration *= 3;
             break;
         case H265SEI_STRUCT_BOT_TOP_BOT:
-            UBASE_FATAL(upipe, uref_pic_set_tf(uref))
-            UBASE_FATAL(upipe, uref_pic_set_bf(uref))
+            if (full) {
+                UBASE_FATAL(upipe, uref_pic_set_tf(uref))
+                UBASE_FATAL(upipe, uref_pic_set_bf(uref))
+            }
             duration *= 3;
             break;
         case H265SEI_STRUCT_DOUBLE:
@@ -1986,7 +2004,8 @@ static int upipe_h265f_prepare_au(struct upipe *upipe, struct uref *uref)
     if (duration)
         UBASE_FATAL(upipe, uref_clock_set_duration(uref, duration))
 
-    UBASE_FATAL(upipe, uref_h265_set_type(uref, upipe_h265f->slice_type))
+    if (full)
+        UBASE_FATAL(upipe, uref_h265_set_type(uref, upipe_h265f->slice_type))
     switch (upipe_h265f->slice_type) {
         case H265SLI_TYPE_I:
             upipe_h265f->iframe_rap = upipe_h265f->pps_rap;
@@ -2800,6 +2819,27 @@ static int upipe_h265f_check_ubuf_mgr(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the parsing depth.
+ *
+ * @param upipe description structure of the pipe
+ * @param depth parsing depth
+ * @return an error code
+ */
+static int _upipe_h265f_set_depth(struct upipe *upipe,
+                                  enum upipe_h26xf_depth depth)
+{
+    struct upipe_h265f *upipe_h265f = upipe_h265f_from_upipe(upipe);
+    switch (depth) {
+        case UPIPE_H26XF_DEPTH_FULL:
+        case UPIPE_H26XF_DEPTH_TIMING:
+        case UPIPE_H26XF_DEPTH_BOUNDARIES:
+            upipe_h265f->depth = depth;
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_INVALID;
+    }
+}
+
 /** @internal @This sets the input flow definition.
  *
  * @param upipe description structure of the pipe
@@ -2850,6 +2890,18 @@ static int upipe_h265f_control(struct upipe *upipe, int command, va_list args)
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_h265f_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_H265F_GET_DEPTH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_H265F_SIGNATURE)
+            enum upipe_h26xf_depth *depth_p =
+                va_arg(args, enum upipe_h26xf_depth *);
+            *depth_p = upipe_h265f_from_upipe(upipe)->depth;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_H265F_SET_DEPTH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_H265F_SIGNATURE)
+            enum upipe_h26xf_depth depth = va_arg(args, enum upipe_h26xf_depth);
+            return _upipe_h265f_set_depth(upipe, depth);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
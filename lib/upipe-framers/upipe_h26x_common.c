@@ -74,15 +74,7 @@ void upipe_h26xf_stream_init(struct upipe_h26xf_stream *f)
  */
 int upipe_h26xf_stream_get(struct ubuf_block_stream *s, uint8_t *octet_p)
 {
-    UBASE_RETURN(ubuf_block_stream_get(s, octet_p))
-    struct upipe_h26xf_stream *f =
-        container_of(s, struct upipe_h26xf_stream, s);
-    f->zeros <<= 1;
-    if (unlikely(!*octet_p))
-        f->zeros |= 1;
-    else if (unlikely(*octet_p == 3 && (f->zeros & 6) == 6)) /* escape word */
-        return upipe_h26xf_stream_get(s, octet_p);
-    return UBASE_ERR_NONE;
+    return upipe_h26xf_stream_next(s, octet_p);
 }
 
 /** @This reads an unsigned exp-golomb code from a stream.
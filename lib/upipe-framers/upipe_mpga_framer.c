@@ -1392,6 +1392,19 @@ static struct ubuf *upipe_mpgaf_extract_latm(struct upipe *upipe,
     }
     uref_size -= (upipe_mpgaf->latm_header_size + 7) / 8;
 
+    if (!(upipe_mpgaf->latm_header_size % 8)) {
+        /* octet-aligned payload: slice it instead of copying */
+        struct ubuf *ubuf = ubuf_dup(uref->ubuf);
+        if (unlikely(ubuf == NULL ||
+                     !ubase_check(ubuf_block_resize(ubuf,
+                             upipe_mpgaf->latm_header_size / 8, uref_size)))) {
+            ubuf_free(ubuf);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return NULL;
+        }
+        return ubuf;
+    }
+
     struct ubuf *ubuf = ubuf_block_alloc(upipe_mpgaf->ubuf_mgr, uref_size);
     uint8_t *p;
     int size = uref_size;
@@ -1411,12 +1424,8 @@ static struct ubuf *upipe_mpgaf_extract_latm(struct upipe *upipe,
         return NULL;
     }
 
-    while (uref_size > 0) {
-        ubuf_block_stream_fill_bits(&s, 8);
-        *p++ = ubuf_block_stream_show_bits(&s, 8);
-        ubuf_block_stream_skip_bits(&s, 8);
-        uref_size--;
-    }
+    if (unlikely(!ubase_check(ubuf_block_stream_read(&s, uref_size, p))))
+        upipe_warn(upipe, "truncated LATM payload");
 
     ubuf_block_stream_clean(&s);
     ubuf_block_unmap(ubuf, 0);
@@ -1441,10 +1450,41 @@ static int upipe_mpgaf_decaps_frame(struct upipe *upipe, struct uref *uref)
 
     struct ubuf *ubuf = upipe_mpgaf_extract_latm(upipe, uref);
 
-    if (unlikely(ubuf == NULL)) {
-        uref_free(uref);
+    if (unlikely(ubuf == NULL))
         return UBASE_ERR_INVALID;
-    }
+    uref_attach_ubuf(uref, ubuf);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This converts a frame between LOAS and LATM encapsulations.
+ * The AudioMuxElement is kept as is, so only the LOAS sync header has to be
+ * prepended or removed.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref pointer to uref
+ * @return an error code
+ */
+static int upipe_mpgaf_rewrap_latm(struct upipe *upipe, struct uref *uref)
+{
+    struct upipe_mpgaf *upipe_mpgaf = upipe_mpgaf_from_upipe(upipe);
+    if (upipe_mpgaf->encaps_input == UREF_MPGA_ENCAPS_LOAS)
+        return uref_block_resize(uref, LOAS_HEADER_SIZE, -1);
+
+    size_t size = 0;
+    uref_block_size(uref, &size);
+    if (size > 0x1fff)
+        upipe_warn_va(upipe, "LATM packet too large (%zu)", size);
+
+    uint8_t buffer[LOAS_HEADER_SIZE];
+    loas_set_sync(buffer);
+    loas_set_length(buffer, size);
+
+    struct ubuf *ubuf = ubuf_block_alloc_from_opaque(upipe_mpgaf->ubuf_mgr,
+            buffer, LOAS_HEADER_SIZE);
+    if (unlikely(ubuf == NULL))
+        return UBASE_ERR_ALLOC;
+
+    ubuf_block_append(ubuf, uref_detach_ubuf(uref));
     uref_attach_ubuf(uref, ubuf);
     return UBASE_ERR_NONE;
 }
@@ -1465,6 +1505,17 @@ static void upipe_mpgaf_output_frame(struct upipe *upipe, struct uref *uref,
         return;
     }
 
+    if ((upipe_mpgaf->encaps_input == UREF_MPGA_ENCAPS_LOAS ||
+         upipe_mpgaf->encaps_input == UREF_MPGA_ENCAPS_LATM) &&
+        (upipe_mpgaf->encaps_output == UREF_MPGA_ENCAPS_LOAS ||
+         upipe_mpgaf->encaps_output == UREF_MPGA_ENCAPS_LATM)) {
+        if (!ubase_check(upipe_mpgaf_rewrap_latm(upipe, uref)))
+            uref_free(uref);
+        else
+            upipe_mpgaf_output(upipe, uref, upump_p);
+        return;
+    }
+
     if (!ubase_check(upipe_mpgaf_decaps_frame(upipe, uref))) {
         uref_free(uref);
         return;
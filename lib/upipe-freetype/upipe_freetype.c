@@ -28,6 +28,7 @@
  */
 
 #include <upipe/ubase.h>
+#include <upipe/ulist.h>
 #include <upipe/uprobe.h>
 #include <upipe/uref.h>
 #include <upipe/uref_clock.h>
@@ -44,9 +45,42 @@
 #include <upipe/upipe_helper_flow.h>
 #include <upipe-freetype/upipe_freetype.h>
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+/** number of buckets of the glyph cache */
+#define GLYPH_BUCKETS 256
+/** maximum number of cached glyphs */
+#define MAX_GLYPHS 4096
+/** initial size of the glyph atlas */
+#define ATLAS_SIZE 65536
+
+/** @internal @This is a rendered glyph in the cache. */
+struct upipe_freetype_glyph {
+    /** structure for the bucket list */
+    struct uchain uchain;
+
+    /** character code */
+    FT_ULong code;
+    /** sub-pixel pen position, in 26.6 */
+    FT_Vector phase;
+    /** bitmap position relative to the pen, in pixels */
+    FT_Int left;
+    FT_Int top;
+    /** bitmap dimensions */
+    unsigned int width;
+    unsigned int rows;
+    /** pen advance, in 26.6 */
+    FT_Vector advance;
+    /** bitmap offset in the atlas */
+    size_t offset;
+};
+
+UBASE_FROM_TO(upipe_freetype_glyph, uchain, uchain, uchain)
+
 /** upipe_freetype structure */
 struct upipe_freetype {
     /** refcount management structure exported to the public structure */
@@ -79,6 +113,22 @@ struct upipe_freetype {
     /** font handle */
     FT_Face face;
 
+    /** glyph cache buckets */
+    struct uchain glyphs[GLYPH_BUCKETS];
+    /** number of cached glyphs */
+    unsigned int nb_glyphs;
+    /** glyph bitmaps */
+    uint8_t *atlas;
+    /** allocated size of the atlas */
+    size_t atlas_size;
+    /** used size of the atlas */
+    size_t atlas_used;
+
+    /** last rendered text */
+    char *text;
+    /** picture of the last rendered text */
+    struct ubuf *ubuf;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -100,6 +150,101 @@ static int upipe_freetype_check(struct upipe *upipe, struct uref *uref)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This flushes the glyph cache and the last rendered text.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_freetype_flush(struct upipe *upipe)
+{
+    struct upipe_freetype *upipe_freetype = upipe_freetype_from_upipe(upipe);
+
+    for (unsigned int i = 0; i < GLYPH_BUCKETS; i++) {
+        struct uchain *uchain, *uchain_tmp;
+        ulist_delete_foreach(&upipe_freetype->glyphs[i], uchain, uchain_tmp) {
+            ulist_delete(uchain);
+            free(upipe_freetype_glyph_from_uchain(uchain));
+        }
+    }
+    upipe_freetype->nb_glyphs = 0;
+    upipe_freetype->atlas_used = 0;
+
+    free(upipe_freetype->text);
+    upipe_freetype->text = NULL;
+    if (upipe_freetype->ubuf != NULL)
+        ubuf_free(upipe_freetype->ubuf);
+    upipe_freetype->ubuf = NULL;
+}
+
+/** @internal @This returns a rendered glyph from the cache, rendering it
+ * if needed.
+ *
+ * @param upipe description structure of the pipe
+ * @param code character code
+ * @param phase sub-pixel pen position, in 26.6
+ * @return pointer to the glyph, or NULL if it cannot be rendered
+ */
+static const struct upipe_freetype_glyph *
+    upipe_freetype_glyph(struct upipe *upipe, FT_ULong code,
+                         FT_Vector *phase)
+{
+    struct upipe_freetype *upipe_freetype = upipe_freetype_from_upipe(upipe);
+    struct uchain *bucket = &upipe_freetype->glyphs[
+        (code + phase->x * 31 + phase->y * 961) % GLYPH_BUCKETS];
+
+    struct uchain *uchain;
+    ulist_foreach(bucket, uchain) {
+        struct upipe_freetype_glyph *glyph =
+            upipe_freetype_glyph_from_uchain(uchain);
+        if (glyph->code == code && glyph->phase.x == phase->x &&
+            glyph->phase.y == phase->y)
+            return glyph;
+    }
+
+    FT_Set_Transform(upipe_freetype->face, NULL, phase);
+    if (FT_Load_Char(upipe_freetype->face, code, FT_LOAD_RENDER))
+        return NULL;
+
+    if (upipe_freetype->nb_glyphs >= MAX_GLYPHS) {
+        upipe_dbg(upipe, "flushing glyph cache");
+        upipe_freetype_flush(upipe);
+    }
+
+    FT_GlyphSlot slot = upipe_freetype->face->glyph;
+    FT_Bitmap *bitmap = &slot->bitmap;
+    size_t size = (size_t)bitmap->width * bitmap->rows;
+    if (upipe_freetype->atlas_used + size > upipe_freetype->atlas_size) {
+        size_t atlas_size = upipe_freetype->atlas_size ?
+                            upipe_freetype->atlas_size : ATLAS_SIZE;
+        while (upipe_freetype->atlas_used + size > atlas_size)
+            atlas_size *= 2;
+        uint8_t *atlas = realloc(upipe_freetype->atlas, atlas_size);
+        if (unlikely(atlas == NULL))
+            return NULL;
+        upipe_freetype->atlas = atlas;
+        upipe_freetype->atlas_size = atlas_size;
+    }
+
+    struct upipe_freetype_glyph *glyph = malloc(sizeof(*glyph));
+    if (unlikely(glyph == NULL))
+        return NULL;
+    glyph->code = code;
+    glyph->phase = *phase;
+    glyph->left = slot->bitmap_left;
+    glyph->top = slot->bitmap_top;
+    glyph->width = bitmap->width;
+    glyph->rows = bitmap->rows;
+    glyph->advance = slot->advance;
+    glyph->offset = upipe_freetype->atlas_used;
+    for (unsigned int j = 0; j < bitmap->rows; j++)
+        memcpy(upipe_freetype->atlas + glyph->offset + j * bitmap->width,
+               bitmap->buffer + j * bitmap->pitch, bitmap->width);
+    upipe_freetype->atlas_used += size;
+
+    ulist_add(bucket, upipe_freetype_glyph_to_uchain(glyph));
+    upipe_freetype->nb_glyphs++;
+    return glyph;
+}
+
 /** @internal @This frees all resources allocated.
  *
  * @param upipe description structure of the pipe
@@ -110,6 +255,9 @@ static void upipe_freetype_free(struct upipe *upipe)
 
     upipe_throw_dead(upipe);
 
+    upipe_freetype_flush(upipe);
+    free(upipe_freetype->atlas);
+
     if (upipe_freetype->face)
         FT_Done_Face(upipe_freetype->face);
 
@@ -151,6 +299,14 @@ static struct upipe *upipe_freetype_alloc(struct upipe_mgr *mgr,
     }
 
     upipe_freetype->face = NULL;
+    for (unsigned int i = 0; i < GLYPH_BUCKETS; i++)
+        ulist_init(&upipe_freetype->glyphs[i]);
+    upipe_freetype->nb_glyphs = 0;
+    upipe_freetype->atlas = NULL;
+    upipe_freetype->atlas_size = 0;
+    upipe_freetype->atlas_used = 0;
+    upipe_freetype->text = NULL;
+    upipe_freetype->ubuf = NULL;
 
     upipe_freetype_init_urefcount(upipe);
     upipe_freetype_init_output(upipe);
@@ -197,6 +353,26 @@ static void upipe_freetype_input(struct upipe *upipe, struct uref *uref, struct
         upipe_freetype_store_flow_def(upipe, flow_def);
     }
 
+    const char *text;
+    int r = uref_attr_get_string(uref, &text, UDICT_TYPE_STRING, "text");
+    if (!ubase_check(r)) {
+        uref_dump(uref, upipe->uprobe);
+        text = "fail";
+    }
+
+    if (upipe_freetype->ubuf != NULL && !strcmp(upipe_freetype->text, text)) {
+        /* the text did not change, reuse the picture */
+        struct ubuf *ubuf = ubuf_dup(upipe_freetype->ubuf);
+        if (unlikely(ubuf == NULL)) {
+            upipe_err(upipe, "Could not duplicate pic");
+            uref_free(uref);
+            return;
+        }
+        uref_attach_ubuf(uref, ubuf);
+        upipe_freetype_output(upipe, uref, upump_p);
+        return;
+    }
+
     struct ubuf *ubuf = ubuf_pic_alloc(upipe_freetype->ubuf_mgr, h, v);
     if (!ubuf) {
         upipe_err(upipe, "Could not allocate pic");
@@ -236,30 +412,26 @@ static void upipe_freetype_input(struct upipe *upipe, struct uref *uref, struct
     pen.x = 0;
     pen.y = v*8;
 
-    FT_GlyphSlot slot = upipe_freetype->face->glyph;
-    const char *text;
-    int r = uref_attr_get_string(uref, &text, UDICT_TYPE_STRING, "text");
-    if (!ubase_check(r)) {
-        uref_dump(uref, upipe->uprobe);
-        text = "fail";
-    }
     for (int i = 0; i < strlen(text); i++) {
-        FT_Set_Transform(upipe_freetype->face, NULL, &pen);
-
-        /* load glyph image into the slot(erase previous one) */
-        if (FT_Load_Char(upipe_freetype->face, text[i], FT_LOAD_RENDER))
+        /* glyphs are cached for the sub-pixel part of the pen position */
+        FT_Vector phase;
+        phase.x = pen.x & 63;
+        phase.y = pen.y & 63;
+        const struct upipe_freetype_glyph *glyph =
+            upipe_freetype_glyph(upipe, text[i], &phase);
+        if (glyph == NULL)
             continue;                 /* ignore errors */
 
         /* now, draw to our target surface(convert position) */
-        FT_Bitmap *bitmap = &slot->bitmap;
-        FT_Int x = slot->bitmap_left;
-        FT_Int y = v - slot->bitmap_top;
-        FT_Int x_max = x + bitmap->width;
+        const uint8_t *bitmap = upipe_freetype->atlas + glyph->offset;
+        FT_Int x = glyph->left + (pen.x >> 6);
+        FT_Int y = v - (glyph->top + (pen.y >> 6));
+        FT_Int x_max = x + glyph->width;
         if (x_max > h) {
             upipe_err_va(upipe, "clipping x, %"PRIu64" < %d", h, x_max);
             x_max = h;
         }
-        FT_Int y_max = y + bitmap->rows;
+        FT_Int y_max = y + glyph->rows;
         if (y_max > v) {
             upipe_err_va(upipe, "clipping y, %"PRIu64" < %d", v, y_max);
             y_max = v;
@@ -267,13 +439,13 @@ static void upipe_freetype_input(struct upipe *upipe, struct uref *uref, struct
 
         for (FT_Int i = (x < 0 ? 0 : x); i < x_max; i++)
             for (FT_Int j = (y < 0 ? 0 : y); j < y_max; j++) {
-                dst[j*stride_y + i] |= bitmap->buffer[(j - y) * bitmap->width + (i - x)];
-                dsta[j*stride_a + i] |= bitmap->buffer[(j - y) * bitmap->width + (i - x)];
+                dst[j*stride_y + i] |= bitmap[(j - y) * glyph->width + (i - x)];
+                dsta[j*stride_a + i] |= bitmap[(j - y) * glyph->width + (i - x)];
             }
 
         /* increment pen position */
-        pen.x += slot->advance.x;
-        pen.y += slot->advance.y;
+        pen.x += glyph->advance.x;
+        pen.y += glyph->advance.y;
     }
 
     unsigned text_w = pen.x / 64;
@@ -289,6 +461,13 @@ static void upipe_freetype_input(struct upipe *upipe, struct uref *uref, struct
     ubuf_pic_plane_unmap(ubuf, "y8", 0, 0, -1, -1);
     ubuf_pic_plane_unmap(ubuf, "a8", 0, 0, -1, -1);
 
+    /* keep the picture for the next identical text */
+    free(upipe_freetype->text);
+    if (upipe_freetype->ubuf != NULL)
+        ubuf_free(upipe_freetype->ubuf);
+    upipe_freetype->text = strdup(text);
+    upipe_freetype->ubuf = upipe_freetype->text != NULL ? ubuf_dup(ubuf) : NULL;
+
     uref_attach_ubuf(uref, ubuf);
 
     upipe_freetype_output(upipe, uref, upump_p);
@@ -313,6 +492,7 @@ static int upipe_freetype_set_option(struct upipe *upipe,
         FT_Done_Face(upipe_freetype->face);
 
     upipe_freetype->face = NULL;
+    upipe_freetype_flush(upipe);
 
     uint64_t v;
     UBASE_RETURN(uref_pic_flow_get_vsize(upipe_freetype->flow_output, &v));
@@ -29,7 +29,12 @@
 
 #include <upipe/uref_pic.h>
 #include <upipe-gl/upipe_gl_sink_common.h>
+
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
 #include <GL/gl.h>
+#include <GL/glext.h>
 
 /** @This loads a uref picture into the specified texture
  * @param uref uref structure describing the picture
@@ -55,3 +60,111 @@ bool upipe_gl_texture_load_uref(struct uref *uref, GLuint texture)
 
     return true;
 }
+
+/** @This initializes the state of asynchronous texture uploads.
+ *
+ * @param upload state of asynchronous texture uploads
+ */
+void upipe_gl_texture_upload_init(struct upipe_gl_texture_upload *upload)
+{
+    memset(upload->buffers, 0, sizeof(upload->buffers));
+    upload->index = 0;
+    upload->fallback = false;
+    upload->width = upload->height = 0;
+    upload->rgb565 = false;
+}
+
+/** @This releases the pixel buffer objects. The GL context must be current.
+ *
+ * @param upload state of asynchronous texture uploads
+ */
+void upipe_gl_texture_upload_clean(struct upipe_gl_texture_upload *upload)
+{
+    if (upload->buffers[0])
+        glDeleteBuffers(UPIPE_GL_TEXTURE_UPLOAD_BUFFERS, upload->buffers);
+    upipe_gl_texture_upload_init(upload);
+}
+
+/** @This loads a uref picture into the specified texture through a ring of
+ * pixel buffer objects, so that the transfer to the GPU happens while the
+ * next picture is being prepared. It falls back to
+ * @ref upipe_gl_texture_load_uref if pixel buffer objects are unavailable.
+ *
+ * @param upload state of asynchronous texture uploads
+ * @param uref uref structure describing the picture
+ * @param texture GL texture
+ * @return false in case of error
+ */
+bool upipe_gl_texture_upload_uref(struct upipe_gl_texture_upload *upload,
+                                  struct uref *uref, unsigned int texture)
+{
+    if (upload->fallback)
+        return upipe_gl_texture_load_uref(uref, texture);
+
+    if (!upload->buffers[0]) {
+        glGetError();
+        glGenBuffers(UPIPE_GL_TEXTURE_UPLOAD_BUFFERS, upload->buffers);
+        if (glGetError() != GL_NO_ERROR || !upload->buffers[0]) {
+            upload->fallback = true;
+            return upipe_gl_texture_load_uref(uref, texture);
+        }
+    }
+
+    const char *chroma = "r8g8b8";
+    size_t pixel_size = 3;
+    bool rgb565 = false;
+    size_t width, height, stride;
+    const uint8_t *data = NULL;
+    if (!ubase_check(uref_pic_size(uref, &width, &height, NULL)))
+        return false;
+    if (!ubase_check(uref_pic_plane_read(uref, chroma, 0, 0, -1, -1, &data))) {
+        chroma = "r5g6b5";
+        pixel_size = 2;
+        rgb565 = true;
+        if (!ubase_check(uref_pic_plane_read(uref, chroma, 0, 0, -1, -1,
+                                             &data)))
+            return false;
+    }
+    if (!ubase_check(uref_pic_plane_size(uref, chroma, &stride,
+                                         NULL, NULL, NULL))) {
+        uref_pic_plane_unmap(uref, chroma, 0, 0, -1, -1);
+        return false;
+    }
+
+    /* orphan the storage of the next buffer of the ring, so that mapping
+     * never waits for the transfer of a previous picture */
+    size_t line_size = width * pixel_size;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload->buffers[upload->index]);
+    upload->index = (upload->index + 1) % UPIPE_GL_TEXTURE_UPLOAD_BUFFERS;
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, line_size * height, NULL,
+                 GL_STREAM_DRAW);
+    uint8_t *buffer = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+    if (buffer == NULL) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        uref_pic_plane_unmap(uref, chroma, 0, 0, -1, -1);
+        return false;
+    }
+    if (stride == line_size)
+        memcpy(buffer, data, line_size * height);
+    else
+        for (size_t i = 0; i < height; i++)
+            memcpy(buffer + i * line_size, data + i * stride, line_size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    uref_pic_plane_unmap(uref, chroma, 0, 0, -1, -1);
+
+    /* the transfer from the buffer to the texture is asynchronous */
+    GLenum type = rgb565 ? GL_UNSIGNED_SHORT_5_6_5 : GL_UNSIGNED_BYTE;
+    glBindTexture(GL_TEXTURE_2D, texture);
+    if (width != upload->width || height != upload->height ||
+        rgb565 != upload->rgb565) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB,
+                     type, NULL);
+        upload->width = width;
+        upload->height = height;
+        upload->rgb565 = rgb565;
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB, type,
+                    NULL);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return true;
+}
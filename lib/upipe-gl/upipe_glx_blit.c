@@ -0,0 +1,1129 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe GLX (OpenGL/X11) blit module
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/ulist.h>
+#include <upipe/uprobe.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_pic.h>
+#include <upipe/uref.h>
+#include <upipe/uref_pic.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe/upipe_helper_subpipe.h>
+#include <upipe-gl/upipe_glx_blit.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <assert.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GL/glx.h>
+
+/** number of planes of the supported pictures */
+#define PLANES 3
+/** timeout waiting for the GPU, in nanoseconds */
+#define FENCE_TIMEOUT UINT64_C(1000000000)
+
+/** chromas of the supported pictures */
+static const char *upipe_glx_blit_chromas[PLANES] = { "y8", "u8", "v8" };
+
+/** vertex shader */
+static const char *upipe_glx_blit_vertex =
+    "#version 120\n"
+    "varying vec2 coord;\n"
+    "void main() {\n"
+    "    coord = gl_MultiTexCoord0.xy;\n"
+    "    gl_Position = gl_Vertex;\n"
+    "}\n";
+
+/** fragment shader, sampling a single plane */
+static const char *upipe_glx_blit_fragment =
+    "#version 120\n"
+    "uniform sampler2D plane;\n"
+    "varying vec2 coord;\n"
+    "void main() {\n"
+    "    gl_FragColor = vec4(texture2D(plane, coord).r);\n"
+    "}\n";
+
+/** @internal @This is a double-buffered pixel buffer object, used to
+ * transfer pictures without blocking on the GPU. */
+struct upipe_glx_blit_pbo {
+    /** buffer object, or 0 */
+    GLuint buffer;
+    /** GL_PIXEL_UNPACK_BUFFER or GL_PIXEL_PACK_BUFFER */
+    GLenum target;
+    /** size of each half of the buffer */
+    size_t size;
+    /** persistent mapping of the buffer, or NULL */
+    uint8_t *map;
+    /** fences protecting each half of the buffer */
+    GLsync fences[2];
+    /** last used half */
+    unsigned int index;
+};
+
+/** @internal @This is the set of plane textures of a picture. */
+struct upipe_glx_blit_tex {
+    /** plane textures */
+    GLuint textures[PLANES];
+    /** horizontal size of the picture */
+    size_t hsize;
+    /** vertical size of the picture */
+    size_t vsize;
+};
+
+/** @internal @This is the private context of a glx blit pipe. */
+struct upipe_glx_blit {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** output pipe */
+    struct upipe *output;
+    /** output flow_definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** list of input subpipes */
+    struct uchain subs;
+    /** manager to create input subpipes */
+    struct upipe_mgr sub_mgr;
+
+    /** X display */
+    Display *display;
+    /** offscreen drawable */
+    GLXPbuffer pbuffer;
+    /** GLX context */
+    GLXContext context;
+    /** true if buffers may be mapped persistently */
+    bool persistent;
+    /** shader program */
+    GLuint program;
+    /** framebuffer object */
+    GLuint fbo;
+
+    /** horizontal size of the output picture */
+    uint64_t hsize;
+    /** vertical size of the output picture */
+    uint64_t vsize;
+    /** background textures */
+    struct upipe_glx_blit_tex background;
+    /** background upload buffer */
+    struct upipe_glx_blit_pbo upload;
+    /** composed textures */
+    struct upipe_glx_blit_tex composite;
+    /** read back buffer */
+    struct upipe_glx_blit_pbo readback;
+    /** picture being read back */
+    struct uref *pending;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_glx_blit, upipe, UPIPE_GLX_BLIT_SIGNATURE);
+UPIPE_HELPER_UREFCOUNT(upipe_glx_blit, urefcount, upipe_glx_blit_free)
+UPIPE_HELPER_VOID(upipe_glx_blit)
+UPIPE_HELPER_OUTPUT(upipe_glx_blit, output, flow_def, output_state,
+                    request_list)
+
+/** @internal @This is the private context of an input of a glx blit pipe. */
+struct upipe_glx_blit_sub {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** structure for double-linked lists */
+    struct uchain uchain;
+
+    /** configured offset from the left border */
+    uint64_t loffset;
+    /** configured offset from the right border */
+    uint64_t roffset;
+    /** configured offset from the top border */
+    uint64_t toffset;
+    /** configured offset from the bottom border */
+    uint64_t boffset;
+
+    /** last received uref */
+    struct uref *uref;
+    /** true if the last received uref was not uploaded */
+    bool dirty;
+    /** uploaded textures */
+    struct upipe_glx_blit_tex tex;
+    /** upload buffer */
+    struct upipe_glx_blit_pbo upload;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_glx_blit_sub, upipe, UPIPE_GLX_BLIT_SUB_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_glx_blit_sub, urefcount, upipe_glx_blit_sub_free)
+UPIPE_HELPER_VOID(upipe_glx_blit_sub)
+
+UPIPE_HELPER_SUBPIPE(upipe_glx_blit, upipe_glx_blit_sub, sub, sub_mgr, subs,
+                     uchain)
+
+/*
+ * GL helpers
+ */
+
+/** @internal @This makes the GL context of the pipe current.
+ *
+ * @param upipe_glx_blit private context of the glx blit pipe
+ * @return false if there is no GL context
+ */
+static bool upipe_glx_blit_make_current(struct upipe_glx_blit *upipe_glx_blit)
+{
+    if (upipe_glx_blit->context == NULL)
+        return false;
+    if (glXGetCurrentContext() != upipe_glx_blit->context)
+        glXMakeContextCurrent(upipe_glx_blit->display, upipe_glx_blit->pbuffer,
+                              upipe_glx_blit->pbuffer,
+                              upipe_glx_blit->context);
+    return true;
+}
+
+/** @internal @This initializes a pixel buffer object.
+ *
+ * @param pbo pixel buffer object
+ * @param target GL_PIXEL_UNPACK_BUFFER or GL_PIXEL_PACK_BUFFER
+ */
+static void upipe_glx_blit_pbo_init(struct upipe_glx_blit_pbo *pbo,
+                                    GLenum target)
+{
+    pbo->buffer = 0;
+    pbo->target = target;
+    pbo->size = 0;
+    pbo->map = NULL;
+    pbo->fences[0] = pbo->fences[1] = NULL;
+    pbo->index = 0;
+}
+
+/** @internal @This releases a pixel buffer object. The GL context must be
+ * current.
+ *
+ * @param pbo pixel buffer object
+ */
+static void upipe_glx_blit_pbo_clean(struct upipe_glx_blit_pbo *pbo)
+{
+    for (unsigned int i = 0; i < 2; i++) {
+        if (pbo->fences[i] != NULL)
+            glDeleteSync(pbo->fences[i]);
+        pbo->fences[i] = NULL;
+    }
+    if (pbo->buffer) {
+        if (pbo->map != NULL) {
+            glBindBuffer(pbo->target, pbo->buffer);
+            glUnmapBuffer(pbo->target);
+            glBindBuffer(pbo->target, 0);
+        }
+        glDeleteBuffers(1, &pbo->buffer);
+    }
+    pbo->buffer = 0;
+    pbo->size = 0;
+    pbo->map = NULL;
+}
+
+/** @internal @This makes sure both halves of a pixel buffer object can hold
+ * the given size, and binds it.
+ *
+ * @param upipe_glx_blit private context of the glx blit pipe
+ * @param pbo pixel buffer object
+ * @param size wanted size
+ * @return an error code
+ */
+static int upipe_glx_blit_pbo_reserve(struct upipe_glx_blit *upipe_glx_blit,
+                                      struct upipe_glx_blit_pbo *pbo,
+                                      size_t size)
+{
+    if (pbo->buffer && size <= pbo->size) {
+        glBindBuffer(pbo->target, pbo->buffer);
+        return UBASE_ERR_NONE;
+    }
+
+    upipe_glx_blit_pbo_clean(pbo);
+    glGenBuffers(1, &pbo->buffer);
+    glBindBuffer(pbo->target, pbo->buffer);
+    if (upipe_glx_blit->persistent) {
+        GLbitfield flags = GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT |
+            (pbo->target == GL_PIXEL_PACK_BUFFER ? GL_MAP_READ_BIT :
+                                                   GL_MAP_WRITE_BIT);
+        glBufferStorage(pbo->target, 2 * size, NULL, flags);
+        pbo->map = glMapBufferRange(pbo->target, 0, 2 * size, flags);
+    } else
+        glBufferData(pbo->target, 2 * size, NULL,
+                     pbo->target == GL_PIXEL_PACK_BUFFER ? GL_STREAM_READ :
+                                                           GL_STREAM_DRAW);
+    if (glGetError() != GL_NO_ERROR ||
+        (upipe_glx_blit->persistent && pbo->map == NULL)) {
+        upipe_glx_blit_pbo_clean(pbo);
+        glBindBuffer(pbo->target, 0);
+        return UBASE_ERR_ALLOC;
+    }
+    pbo->size = size;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This waits until the GPU is done with a half of a pixel
+ * buffer object.
+ *
+ * @param pbo pixel buffer object
+ * @param index half of the buffer
+ */
+static void upipe_glx_blit_pbo_wait(struct upipe_glx_blit_pbo *pbo,
+                                    unsigned int index)
+{
+    if (pbo->fences[index] == NULL)
+        return;
+    glClientWaitSync(pbo->fences[index], GL_SYNC_FLUSH_COMMANDS_BIT,
+                     FENCE_TIMEOUT);
+    glDeleteSync(pbo->fences[index]);
+    pbo->fences[index] = NULL;
+}
+
+/** @internal @This maps a half of a bound pixel buffer object.
+ *
+ * @param pbo pixel buffer object
+ * @param index half of the buffer
+ * @return pointer to the mapped half, or NULL
+ */
+static uint8_t *upipe_glx_blit_pbo_map(struct upipe_glx_blit_pbo *pbo,
+                                       unsigned int index)
+{
+    upipe_glx_blit_pbo_wait(pbo, index);
+    if (pbo->map != NULL)
+        return pbo->map + index * pbo->size;
+    GLbitfield access = pbo->target == GL_PIXEL_PACK_BUFFER ?
+        GL_MAP_READ_BIT :
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+        GL_MAP_UNSYNCHRONIZED_BIT;
+    return glMapBufferRange(pbo->target, index * pbo->size, pbo->size,
+                            access);
+}
+
+/** @internal @This unmaps a bound pixel buffer object.
+ *
+ * @param pbo pixel buffer object
+ */
+static void upipe_glx_blit_pbo_unmap(struct upipe_glx_blit_pbo *pbo)
+{
+    if (pbo->map == NULL)
+        glUnmapBuffer(pbo->target);
+}
+
+/** @internal @This protects a half of a pixel buffer object until the
+ * GPU is done with the pending commands.
+ *
+ * @param pbo pixel buffer object
+ * @param index half of the buffer
+ */
+static void upipe_glx_blit_pbo_fence(struct upipe_glx_blit_pbo *pbo,
+                                     unsigned int index)
+{
+    pbo->fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/** @internal @This initializes a set of plane textures.
+ *
+ * @param tex set of plane textures
+ */
+static void upipe_glx_blit_tex_init(struct upipe_glx_blit_tex *tex)
+{
+    for (unsigned int i = 0; i < PLANES; i++)
+        tex->textures[i] = 0;
+    tex->hsize = tex->vsize = 0;
+}
+
+/** @internal @This releases a set of plane textures. The GL context must
+ * be current.
+ *
+ * @param tex set of plane textures
+ */
+static void upipe_glx_blit_tex_clean(struct upipe_glx_blit_tex *tex)
+{
+    if (tex->textures[0])
+        glDeleteTextures(PLANES, tex->textures);
+    upipe_glx_blit_tex_init(tex);
+}
+
+/** @internal @This allocates the plane textures of a 4:2:0 picture, if
+ * their size changed.
+ *
+ * @param tex set of plane textures
+ * @param hsize horizontal size of the picture
+ * @param vsize vertical size of the picture
+ */
+static void upipe_glx_blit_tex_reserve(struct upipe_glx_blit_tex *tex,
+                                       size_t hsize, size_t vsize)
+{
+    if (tex->textures[0] && tex->hsize == hsize && tex->vsize == vsize)
+        return;
+
+    upipe_glx_blit_tex_clean(tex);
+    glGenTextures(PLANES, tex->textures);
+    for (unsigned int i = 0; i < PLANES; i++) {
+        glBindTexture(GL_TEXTURE_2D, tex->textures[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, i ? hsize / 2 : hsize,
+                     i ? vsize / 2 : vsize, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    tex->hsize = hsize;
+    tex->vsize = vsize;
+}
+
+/** @internal @This uploads a picture to a set of plane textures, through a
+ * pixel buffer object.
+ *
+ * @param upipe description structure of the pipe
+ * @param tex set of plane textures
+ * @param pbo upload buffer
+ * @param uref picture to upload
+ * @return an error code
+ */
+static int upipe_glx_blit_upload(struct upipe *upipe,
+                                 struct upipe_glx_blit_tex *tex,
+                                 struct upipe_glx_blit_pbo *pbo,
+                                 struct uref *uref)
+{
+    struct upipe_glx_blit *upipe_glx_blit = upipe_glx_blit_from_upipe(upipe);
+    size_t hsize, vsize;
+    UBASE_RETURN(uref_pic_size(uref, &hsize, &vsize, NULL))
+    hsize &= ~(size_t)1;
+    vsize &= ~(size_t)1;
+    if (!hsize || !vsize)
+        return UBASE_ERR_INVALID;
+
+    UBASE_RETURN(upipe_glx_blit_pbo_reserve(upipe_glx_blit, pbo,
+                                            hsize * vsize * 3 / 2))
+    pbo->index ^= 1;
+    uint8_t *buffer = upipe_glx_blit_pbo_map(pbo, pbo->index);
+    if (unlikely(buffer == NULL)) {
+        glBindBuffer(pbo->target, 0);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    int err = UBASE_ERR_NONE;
+    size_t offset = 0;
+    for (unsigned int i = 0; i < PLANES && ubase_check(err); i++) {
+        const char *chroma = upipe_glx_blit_chromas[i];
+        size_t width = i ? hsize / 2 : hsize;
+        size_t height = i ? vsize / 2 : vsize;
+        size_t stride;
+        const uint8_t *plane;
+        err = uref_pic_plane_size(uref, chroma, &stride, NULL, NULL, NULL);
+        if (ubase_check(err))
+            err = uref_pic_plane_read(uref, chroma, 0, 0, -1, -1, &plane);
+        if (!ubase_check(err))
+            break;
+        for (size_t j = 0; j < height; j++)
+            memcpy(buffer + offset + j * width, plane + j * stride, width);
+        uref_pic_plane_unmap(uref, chroma, 0, 0, -1, -1);
+        offset += width * height;
+    }
+    upipe_glx_blit_pbo_unmap(pbo);
+
+    if (ubase_check(err)) {
+        upipe_glx_blit_tex_reserve(tex, hsize, vsize);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        offset = pbo->index * pbo->size;
+        for (unsigned int i = 0; i < PLANES; i++) {
+            size_t width = i ? hsize / 2 : hsize;
+            size_t height = i ? vsize / 2 : vsize;
+            glBindTexture(GL_TEXTURE_2D, tex->textures[i]);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+                            GL_RED, GL_UNSIGNED_BYTE,
+                            (const void *)(uintptr_t)offset);
+            offset += width * height;
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        upipe_glx_blit_pbo_fence(pbo, pbo->index);
+    }
+    glBindBuffer(pbo->target, 0);
+    return err;
+}
+
+/** @internal @This draws a texture on a rectangle of the bound
+ * framebuffer.
+ *
+ * @param texture texture to draw
+ * @param x0 left border, in normalized device coordinates
+ * @param y0 top border, in normalized device coordinates
+ * @param x1 right border, in normalized device coordinates
+ * @param y1 bottom border, in normalized device coordinates
+ */
+static void upipe_glx_blit_draw(GLuint texture, float x0, float y0,
+                                float x1, float y1)
+{
+    /* picture lines are stored bottom-up, so that the read back picture
+     * is not flipped */
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0., 0.);
+    glVertex2f(x0, y0);
+    glTexCoord2f(1., 0.);
+    glVertex2f(x1, y0);
+    glTexCoord2f(1., 1.);
+    glVertex2f(x1, y1);
+    glTexCoord2f(0., 1.);
+    glVertex2f(x0, y1);
+    glEnd();
+}
+
+/*
+ * sub pipes
+ */
+
+/** @internal @This allocates an input subpipe of a glx blit pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_glx_blit_sub_alloc(struct upipe_mgr *mgr,
+                                              struct uprobe *uprobe,
+                                              uint32_t signature,
+                                              va_list args)
+{
+    struct upipe *upipe =
+        upipe_glx_blit_sub_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_glx_blit_sub *sub = upipe_glx_blit_sub_from_upipe(upipe);
+    upipe_glx_blit_sub_init_urefcount(upipe);
+    upipe_glx_blit_sub_init_sub(upipe);
+    sub->loffset = sub->roffset = sub->toffset = sub->boffset = 0;
+    sub->uref = NULL;
+    sub->dirty = false;
+    upipe_glx_blit_tex_init(&sub->tex);
+    upipe_glx_blit_pbo_init(&sub->upload, GL_PIXEL_UNPACK_BUFFER);
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This receives a picture to blit.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_glx_blit_sub_input(struct upipe *upipe, struct uref *uref,
+                                     struct upump **upump_p)
+{
+    struct upipe_glx_blit_sub *sub = upipe_glx_blit_sub_from_upipe(upipe);
+    if (unlikely(uref->ubuf == NULL)) {
+        upipe_warn(upipe, "invalid uref received");
+        uref_free(uref);
+        return;
+    }
+
+    /* the upload is deferred to the next output picture */
+    uref_free(sub->uref);
+    sub->uref = uref;
+    sub->dirty = true;
+}
+
+/** @internal @This checks that a flow definition describes planar 8-bit
+ * 4:2:0 pictures.
+ *
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_glx_blit_check_flow_def(struct uref *flow_def)
+{
+    UBASE_RETURN(uref_flow_match_def(flow_def, UREF_PIC_FLOW_DEF))
+    UBASE_RETURN(uref_pic_flow_check_chroma(flow_def, 1, 1, 1, "y8"))
+    UBASE_RETURN(uref_pic_flow_check_chroma(flow_def, 2, 2, 1, "u8"))
+    return uref_pic_flow_check_chroma(flow_def, 2, 2, 1, "v8");
+}
+
+/** @internal @This processes control commands on a subpipe of a glx blit
+ * pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_glx_blit_sub_control(struct upipe *upipe,
+                                      int command, va_list args)
+{
+    struct upipe_glx_blit_sub *sub = upipe_glx_blit_sub_from_upipe(upipe);
+    UBASE_HANDLED_RETURN(upipe_glx_blit_sub_control_super(upipe, command,
+                                                          args));
+
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, request);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_glx_blit_check_flow_def(flow_def);
+        }
+
+        case UPIPE_GLX_BLIT_SUB_GET_RECT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_GLX_BLIT_SUB_SIGNATURE);
+            *va_arg(args, uint64_t *) = sub->loffset;
+            *va_arg(args, uint64_t *) = sub->roffset;
+            *va_arg(args, uint64_t *) = sub->toffset;
+            *va_arg(args, uint64_t *) = sub->boffset;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_GLX_BLIT_SUB_SET_RECT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_GLX_BLIT_SUB_SIGNATURE);
+            sub->loffset = va_arg(args, uint64_t);
+            sub->roffset = va_arg(args, uint64_t);
+            sub->toffset = va_arg(args, uint64_t);
+            sub->boffset = va_arg(args, uint64_t);
+            return UBASE_ERR_NONE;
+        }
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees an input subpipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_glx_blit_sub_free(struct upipe *upipe)
+{
+    struct upipe_glx_blit_sub *sub = upipe_glx_blit_sub_from_upipe(upipe);
+    struct upipe_glx_blit *upipe_glx_blit =
+        upipe_glx_blit_from_sub_mgr(upipe->mgr);
+    upipe_throw_dead(upipe);
+
+    if (upipe_glx_blit_make_current(upipe_glx_blit)) {
+        upipe_glx_blit_tex_clean(&sub->tex);
+        upipe_glx_blit_pbo_clean(&sub->upload);
+    }
+    uref_free(sub->uref);
+    upipe_glx_blit_sub_clean_sub(upipe);
+    upipe_glx_blit_sub_clean_urefcount(upipe);
+    upipe_glx_blit_sub_free_void(upipe);
+}
+
+/** @internal @This initializes the input manager for a glx blit pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_glx_blit_init_sub_mgr(struct upipe *upipe)
+{
+    struct upipe_glx_blit *upipe_glx_blit = upipe_glx_blit_from_upipe(upipe);
+    struct upipe_mgr *sub_mgr = &upipe_glx_blit->sub_mgr;
+    sub_mgr->refcount = upipe_glx_blit_to_urefcount(upipe_glx_blit);
+    sub_mgr->signature = UPIPE_GLX_BLIT_SUB_SIGNATURE;
+    sub_mgr->upipe_alloc = upipe_glx_blit_sub_alloc;
+    sub_mgr->upipe_input = upipe_glx_blit_sub_input;
+    sub_mgr->upipe_control = upipe_glx_blit_sub_control;
+    sub_mgr->upipe_mgr_control = NULL;
+}
+
+/*
+ * super pipe
+ */
+
+/** @internal @This allocates a glx blit pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_glx_blit_alloc(struct upipe_mgr *mgr,
+                                          struct uprobe *uprobe,
+                                          uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_glx_blit_alloc_void(mgr, uprobe, signature,
+                                                    args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_glx_blit *upipe_glx_blit = upipe_glx_blit_from_upipe(upipe);
+    upipe_glx_blit_init_urefcount(upipe);
+    upipe_glx_blit_init_output(upipe);
+    upipe_glx_blit_init_sub_mgr(upipe);
+    upipe_glx_blit_init_sub_subs(upipe);
+    upipe_glx_blit->display = NULL;
+    upipe_glx_blit->pbuffer = None;
+    upipe_glx_blit->context = NULL;
+    upipe_glx_blit->persistent = false;
+    upipe_glx_blit->program = 0;
+    upipe_glx_blit->fbo = 0;
+    upipe_glx_blit->hsize = upipe_glx_blit->vsize = 0;
+    upipe_glx_blit_tex_init(&upipe_glx_blit->background);
+    upipe_glx_blit_pbo_init(&upipe_glx_blit->upload, GL_PIXEL_UNPACK_BUFFER);
+    upipe_glx_blit_tex_init(&upipe_glx_blit->composite);
+    upipe_glx_blit_pbo_init(&upipe_glx_blit->readback, GL_PIXEL_PACK_BUFFER);
+    upipe_glx_blit->pending = NULL;
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This compiles a shader.
+ *
+ * @param upipe description structure of the pipe
+ * @param type type of shader
+ * @param source source of the shader
+ * @return shader, or 0 in case of error
+ */
+static GLuint upipe_glx_blit_compile(struct upipe *upipe, GLenum type,
+                                     const char *source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    GLint status;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (!status) {
+        char log[256];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        upipe_err_va(upipe, "could not compile shader: %s", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+/** @internal @This creates the offscreen GL context and the shader program.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_glx_blit_init_gl(struct upipe *upipe)
+{
+    struct upipe_glx_blit *upipe_glx_blit = upipe_glx_blit_from_upipe(upipe);
+    if (upipe_glx_blit->context != NULL)
+        return UBASE_ERR_NONE;
+
+    Display *display = XOpenDisplay(NULL);
+    if (unlikely(display == NULL)) {
+        upipe_err(upipe, "could not open X display");
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    static const int config_attribs[] = {
+        GLX_DRAWABLE_TYPE, GLX_PBUFFER_BIT,
+        GLX_RENDER_TYPE, GLX_RGBA_BIT,
+        None
+    };
+    static const int pbuffer_attribs[] = {
+        GLX_PBUFFER_WIDTH, 1,
+        GLX_PBUFFER_HEIGHT, 1,
+        None
+    };
+    int nb_configs = 0;
+    GLXFBConfig *configs = glXChooseFBConfig(display, DefaultScreen(display),
+                                             config_attribs, &nb_configs);
+    if (unlikely(configs == NULL || !nb_configs)) {
+        upipe_err(upipe, "no offscreen GLX configuration");
+        if (configs != NULL)
+            XFree(configs);
+        XCloseDisplay(display);
+        return UBASE_ERR_EXTERNAL;
+    }
+    GLXPbuffer pbuffer = glXCreatePbuffer(display, configs[0],
+                                          pbuffer_attribs);
+    GLXContext context = glXCreateNewContext(display, configs[0],
+                                             GLX_RGBA_TYPE, NULL, True);
+    XFree(configs);
+    if (unlikely(context == NULL ||
+                 !glXMakeContextCurrent(display, pbuffer, pbuffer, context))) {
+        upipe_err(upipe, "could not create GLX context");
+        if (context != NULL)
+            glXDestroyContext(display, context);
+        glXDestroyPbuffer(display, pbuffer);
+        XCloseDisplay(display);
+        return UBASE_ERR_EXTERNAL;
+    }
+    upipe_glx_blit->display = display;
+    upipe_glx_blit->pbuffer = pbuffer;
+    upipe_glx_blit->context = context;
+
+    const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+    upipe_glx_blit->persistent = extensions != NULL &&
+        strstr(extensions, "GL_ARB_buffer_storage") != NULL;
+    upipe_dbg_va(upipe, "using %s on %s%s",
+                 (const char *)glGetString(GL_VERSION),
+                 (const char *)glGetString(GL_RENDERER),
+                 upipe_glx_blit->persistent ? " with persistent buffers" : "");
+
+    GLuint vertex = upipe_glx_blit_compile(upipe, GL_VERTEX_SHADER,
+                                           upipe_glx_blit_vertex);
+    GLuint fragment = upipe_glx_blit_compile(upipe, GL_FRAGMENT_SHADER,
+                                             upipe_glx_blit_fragment);
+    if (unlikely(!vertex || !fragment)) {
+        if (vertex)
+            glDeleteShader(vertex);
+        if (fragment)
+            glDeleteShader(fragment);
+        return UBASE_ERR_EXTERNAL;
+    }
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (unlikely(!status)) {
+        upipe_err(upipe, "could not link shader program");
+        glDeleteProgram(program);
+        return UBASE_ERR_EXTERNAL;
+    }
+    upipe_glx_blit->program = program;
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "plane"), 0);
+
+    glGenFramebuffers(1, &upipe_glx_blit->fbo);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glEnable(GL_TEXTURE_2D);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This releases the GL resources of the pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_glx_blit_clean_gl(struct upipe *upipe)
+{
+    struct upipe_glx_blit *upipe_glx_blit = upipe_glx_blit_from_upipe(upipe);
+    if (!upipe_glx_blit_make_current(upipe_glx_blit))
+        return;
+
+    upipe_glx_blit_tex_clean(&upipe_glx_blit->background);
+    upipe_glx_blit_pbo_clean(&upipe_glx_blit->upload);
+    upipe_glx_blit_tex_clean(&upipe_glx_blit->composite);
+    upipe_glx_blit_pbo_clean(&upipe_glx_blit->readback);
+    if (upipe_glx_blit->fbo)
+        glDeleteFramebuffers(1, &upipe_glx_blit->fbo);
+    if (upipe_glx_blit->program)
+        glDeleteProgram(upipe_glx_blit->program);
+
+    glXMakeContextCurrent(upipe_glx_blit->display, None, None, NULL);
+    glXDestroyContext(upipe_glx_blit->display, upipe_glx_blit->context);
+    glXDestroyPbuffer(upipe_glx_blit->display, upipe_glx_blit->pbuffer);
+    XCloseDisplay(upipe_glx_blit->display);
+    upipe_glx_blit->context = NULL;
+    upipe_glx_blit->display = NULL;
+}
+
+/** @internal @This composes the background and the subpictures, and starts
+ * reading the composed picture back.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_glx_blit_compose(struct upipe *upipe)
+{
+    struct upipe_glx_blit *upipe_glx_blit = upipe_glx_blit_from_upipe(upipe);
+    float hsize = upipe_glx_blit->hsize;
+    float vsize = upipe_glx_blit->vsize;
+
+    UBASE_RETURN(upipe_glx_blit_pbo_reserve(upipe_glx_blit,
+        &upipe_glx_blit->readback,
+        upipe_glx_blit->hsize * upipe_glx_blit->vsize * 3 / 2))
+    struct upipe_glx_blit_pbo *pbo = &upipe_glx_blit->readback;
+    pbo->index ^= 1;
+    upipe_glx_blit_pbo_wait(pbo, pbo->index);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, upipe_glx_blit->fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    size_t offset = pbo->index * pbo->size;
+    for (unsigned int i = 0; i < PLANES; i++) {
+        size_t width = i ? upipe_glx_blit->hsize / 2 : upipe_glx_blit->hsize;
+        size_t height = i ? upipe_glx_blit->vsize / 2 : upipe_glx_blit->vsize;
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                               GL_TEXTURE_2D,
+                               upipe_glx_blit->composite.textures[i], 0);
+        glViewport(0, 0, width, height);
+
+        upipe_glx_blit_draw(upipe_glx_blit->background.textures[i],
+                            -1., -1., 1., 1.);
+
+        struct uchain *uchain;
+        ulist_foreach (&upipe_glx_blit->subs, uchain) {
+            struct upipe_glx_blit_sub *sub =
+                upipe_glx_blit_sub_from_uchain(uchain);
+            if (!sub->tex.textures[0] ||
+                sub->loffset + sub->roffset >= upipe_glx_blit->hsize ||
+                sub->toffset + sub->boffset >= upipe_glx_blit->vsize)
+                continue;
+            upipe_glx_blit_draw(sub->tex.textures[i],
+                                -1. + 2. * sub->loffset / hsize,
+                                -1. + 2. * sub->toffset / vsize,
+                                1. - 2. * sub->roffset / hsize,
+                                1. - 2. * sub->boffset / vsize);
+        }
+
+        glReadPixels(0, 0, width, height, GL_RED, GL_UNSIGNED_BYTE,
+                     (void *)(uintptr_t)offset);
+        offset += width * height;
+    }
+    upipe_glx_blit_pbo_fence(pbo, pbo->index);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindBuffer(pbo->target, 0);
+    /* start the transfers without waiting for them */
+    glFlush();
+
+    return glGetError() == GL_NO_ERROR ? UBASE_ERR_NONE : UBASE_ERR_EXTERNAL;
+}
+
+/** @internal @This outputs the picture previously composed, once it has
+ * been read back.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_glx_blit_output_pending(struct upipe *upipe,
+                                          struct upump **upump_p)
+{
+    struct upipe_glx_blit *upipe_glx_blit = upipe_glx_blit_from_upipe(upipe);
+    struct uref *uref = upipe_glx_blit->pending;
+    upipe_glx_blit->pending = NULL;
+    if (uref == NULL)
+        return;
+
+    /* the input picture is written over, unless it is shared */
+    uint8_t *dst;
+    if (ubase_check(uref_pic_plane_write(uref, "y8", 0, 0, -1, -1, &dst)))
+        uref_pic_plane_unmap(uref, "y8", 0, 0, -1, -1);
+    else {
+        struct ubuf *ubuf = ubuf_pic_alloc(uref->ubuf->mgr,
+                                           upipe_glx_blit->hsize,
+                                           upipe_glx_blit->vsize);
+        if (unlikely(ubuf == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            uref_free(uref);
+            return;
+        }
+        uref_attach_ubuf(uref, ubuf);
+    }
+
+    struct upipe_glx_blit_pbo *pbo = &upipe_glx_blit->readback;
+    glBindBuffer(pbo->target, pbo->buffer);
+    const uint8_t *buffer = upipe_glx_blit_pbo_map(pbo, pbo->index ^ 1);
+    if (unlikely(buffer == NULL)) {
+        glBindBuffer(pbo->target, 0);
+        upipe_warn(upipe, "unable to map composed picture");
+        uref_free(uref);
+        return;
+    }
+
+    size_t offset = 0;
+    for (unsigned int i = 0; i < PLANES; i++) {
+        const char *chroma = upipe_glx_blit_chromas[i];
+        size_t width = i ? upipe_glx_blit->hsize / 2 : upipe_glx_blit->hsize;
+        size_t height = i ? upipe_glx_blit->vsize / 2 : upipe_glx_blit->vsize;
+        size_t stride;
+        if (ubase_check(uref_pic_plane_size(uref, chroma, &stride,
+                                            NULL, NULL, NULL)) &&
+            ubase_check(uref_pic_plane_write(uref, chroma, 0, 0, -1, -1,
+                                             &dst))) {
+            for (size_t j = 0; j < height; j++)
+                memcpy(dst + j * stride, buffer + offset + j * width, width);
+            uref_pic_plane_unmap(uref, chroma, 0, 0, -1, -1);
+        }
+        offset += width * height;
+    }
+    upipe_glx_blit_pbo_unmap(pbo);
+    glBindBuffer(pbo->target, 0);
+
+    upipe_glx_blit_output(upipe, uref, upump_p);
+}
+
+/** @internal @This receives a background picture, composes the subpictures
+ * onto it, and outputs the previous composed picture.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_glx_blit_input(struct upipe *upipe, struct uref *uref,
+                                 struct upump **upump_p)
+{
+    struct upipe_glx_blit *upipe_glx_blit = upipe_glx_blit_from_upipe(upipe);
+    size_t hsize, vsize;
+    if (unlikely(uref->ubuf == NULL || !upipe_glx_blit->hsize ||
+                 !upipe_glx_blit_make_current(upipe_glx_blit) ||
+                 !ubase_check(uref_pic_size(uref, &hsize, &vsize, NULL)) ||
+                 hsize != upipe_glx_blit->hsize ||
+                 vsize != upipe_glx_blit->vsize)) {
+        upipe_warn(upipe, "invalid uref received");
+        uref_free(uref);
+        return;
+    }
+
+    /* upload the subpictures that changed */
+    struct uchain *uchain;
+    ulist_foreach (&upipe_glx_blit->subs, uchain) {
+        struct upipe_glx_blit_sub *sub = upipe_glx_blit_sub_from_uchain(uchain);
+        if (!sub->dirty)
+            continue;
+        sub->dirty = false;
+        if (!ubase_check(upipe_glx_blit_upload(upipe, &sub->tex,
+                                               &sub->upload, sub->uref)))
+            upipe_warn(upipe_glx_blit_sub_to_upipe(sub),
+                       "unable to upload picture");
+    }
+
+    int err = upipe_glx_blit_upload(upipe, &upipe_glx_blit->background,
+                                    &upipe_glx_blit->upload, uref);
+    if (ubase_check(err))
+        err = upipe_glx_blit_compose(upipe);
+    if (unlikely(!ubase_check(err))) {
+        upipe_warn(upipe, "unable to compose picture");
+        uref_free(uref);
+        return;
+    }
+
+    upipe_glx_blit_output_pending(upipe, upump_p);
+    upipe_glx_blit->pending = uref;
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_glx_blit_set_flow_def(struct upipe *upipe,
+                                       struct uref *flow_def)
+{
+    struct upipe_glx_blit *upipe_glx_blit = upipe_glx_blit_from_upipe(upipe);
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(upipe_glx_blit_check_flow_def(flow_def))
+    uint64_t hsize, vsize;
+    UBASE_RETURN(uref_pic_flow_get_hsize(flow_def, &hsize))
+    UBASE_RETURN(uref_pic_flow_get_vsize(flow_def, &vsize))
+    if (!hsize || !vsize || hsize % 2 || vsize % 2)
+        return UBASE_ERR_INVALID;
+
+    UBASE_RETURN(upipe_glx_blit_init_gl(upipe))
+    upipe_glx_blit_make_current(upipe_glx_blit);
+    uref_free(upipe_glx_blit->pending);
+    upipe_glx_blit->pending = NULL;
+    upipe_glx_blit_tex_reserve(&upipe_glx_blit->composite, hsize, vsize);
+    upipe_glx_blit->hsize = hsize;
+    upipe_glx_blit->vsize = vsize;
+
+    flow_def = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def)
+    upipe_glx_blit_store_flow_def(upipe, flow_def);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a glx blit pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_glx_blit_control(struct upipe *upipe, int command,
+                                  va_list args)
+{
+    UBASE_HANDLED_RETURN(upipe_glx_blit_control_output(upipe, command, args));
+    UBASE_HANDLED_RETURN(upipe_glx_blit_control_subs(upipe, command, args));
+
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_glx_blit_set_flow_def(upipe, flow_def);
+        }
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_glx_blit_free(struct upipe *upipe)
+{
+    struct upipe_glx_blit *upipe_glx_blit = upipe_glx_blit_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    uref_free(upipe_glx_blit->pending);
+    upipe_glx_blit_clean_gl(upipe);
+    upipe_glx_blit_clean_sub_subs(upipe);
+    upipe_glx_blit_clean_output(upipe);
+    upipe_glx_blit_clean_urefcount(upipe);
+    upipe_glx_blit_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_glx_blit_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_GLX_BLIT_SIGNATURE,
+
+    .upipe_alloc = upipe_glx_blit_alloc,
+    .upipe_input = upipe_glx_blit_input,
+    .upipe_control = upipe_glx_blit_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for glx blit pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_glx_blit_mgr_alloc(void)
+{
+    return &upipe_glx_blit_mgr;
+}
@@ -103,6 +103,8 @@ struct upipe_glx_sink {
     GLXContext glxContext;
     /** doublebuffer available */
     bool doublebuffered;
+    /** true if buffer swaps wait for the vertical retrace */
+    bool vsync;
     /** X event mask */
     long eventmask;
 
@@ -140,6 +142,44 @@ static inline void upipe_glx_sink_flush(struct upipe *upipe)
     }
 }
 
+/** @internal @This sets whether buffer swaps wait for the vertical
+ * retrace. In live mode pictures are already paced by the uclock, so waiting
+ * would only stall the event loop.
+ *
+ * @param upipe description structure of the pipe
+ * @param vsync true to wait for the vertical retrace
+ */
+static void upipe_glx_sink_set_vsync(struct upipe *upipe, bool vsync)
+{
+    struct upipe_glx_sink *upipe_glx_sink = upipe_glx_sink_from_upipe(upipe);
+    if (upipe_glx_sink->vsync == vsync || !upipe_glx_sink->doublebuffered)
+        return;
+    upipe_glx_sink->vsync = vsync;
+
+    const char *extensions =
+        glXQueryExtensionsString(upipe_glx_sink->display,
+                                 DefaultScreen(upipe_glx_sink->display));
+    if (extensions != NULL && strstr(extensions, "GLX_EXT_swap_control")) {
+        void (*swap_interval)(Display *, GLXDrawable, int) =
+            (void (*)(Display *, GLXDrawable, int))
+            glXGetProcAddress((const GLubyte *)"glXSwapIntervalEXT");
+        if (swap_interval != NULL) {
+            swap_interval(upipe_glx_sink->display, upipe_glx_sink->window,
+                          vsync ? 1 : 0);
+            return;
+        }
+    }
+    if (extensions != NULL && strstr(extensions, "GLX_MESA_swap_control")) {
+        int (*swap_interval)(unsigned int) = (int (*)(unsigned int))
+            glXGetProcAddress((const GLubyte *)"glXSwapIntervalMESA");
+        if (swap_interval != NULL) {
+            swap_interval(vsync ? 1 : 0);
+            return;
+        }
+    }
+    upipe_dbg(upipe, "unable to change the swap interval");
+}
+
 /** @internal @This handles keystrokes.
  *
  * @param upipe description structure of the pipe
@@ -320,6 +360,7 @@ static int upipe_glx_sink_init_glx(struct upipe *upipe, int x, int y, int width,
     upipe_glx_sink->display = display;
     upipe_glx_sink->window = window;
     upipe_glx_sink->glxContext = glxContext;
+    upipe_glx_sink->vsync = true;
 
     // Now init GL context
     upipe_throw(upipe, UPROBE_GL_SINK_INIT,
@@ -381,6 +422,7 @@ static struct upipe *upipe_glx_sink_alloc(struct upipe_mgr *mgr,
 
     upipe_glx_sink->display = NULL;
     upipe_glx_sink->visual = NULL;
+    upipe_glx_sink->vsync = true;
     upipe_glx_sink->counter = 0;
     upipe_glx_sink->theta = 0;
 
@@ -434,6 +476,7 @@ static bool upipe_glx_sink_output(struct upipe *upipe, struct uref *uref,
 
     glXMakeCurrent(upipe_glx_sink->display, upipe_glx_sink->window,
                    upipe_glx_sink->glxContext);
+    upipe_glx_sink_set_vsync(upipe, upipe_glx_sink->uclock == NULL);
     upipe_gl_sink_throw_render(upipe, uref);
     upipe_glx_sink_flush(upipe);
     uref_free(uref);
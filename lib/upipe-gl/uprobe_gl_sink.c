@@ -52,6 +52,8 @@
 struct uprobe_gl_sink {
     /** texture */
     GLuint texture;
+    /** asynchronous texture uploads */
+    struct upipe_gl_texture_upload upload;
     /** SAR */
     struct urational sar;
 
@@ -112,7 +114,8 @@ static int uprobe_gl_sink_render(struct uprobe *uprobe,
 
     /* load image to texture */
 
-    if (!upipe_gl_texture_load_uref(uref, uprobe_gl_sink->texture)) {
+    if (!upipe_gl_texture_upload_uref(&uprobe_gl_sink->upload, uref,
+                                      uprobe_gl_sink->texture)) {
         upipe_err(upipe, "Could not map picture plane");
         return UBASE_ERR_EXTERNAL;
     }
@@ -237,6 +240,7 @@ uprobe_gl_sink_init(struct uprobe_gl_sink *uprobe_gl_sink,
     struct uprobe *uprobe = uprobe_gl_sink_to_uprobe(uprobe_gl_sink);
 
     uprobe_gl_sink->sar.num = uprobe_gl_sink->sar.den = 1;
+    upipe_gl_texture_upload_init(&uprobe_gl_sink->upload);
 
     uprobe_init(uprobe, uprobe_gl_sink_throw, next);
     return uprobe;
@@ -248,6 +252,7 @@ uprobe_gl_sink_init(struct uprobe_gl_sink *uprobe_gl_sink,
  */
 static void uprobe_gl_sink_clean(struct uprobe_gl_sink *uprobe_gl_sink)
 {
+    upipe_gl_texture_upload_clean(&uprobe_gl_sink->upload);
     glDeleteTextures(1, &uprobe_gl_sink->texture);
     struct uprobe *uprobe = &uprobe_gl_sink->uprobe;
     uprobe_clean(uprobe);
@@ -21,6 +21,12 @@
 #include <stdint.h>
 #include "sdidec.h"
 
+#if defined(__i686__) || defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 void upipe_sdi_to_uyvy_c(const uint8_t *src, uint16_t *y, int64_t pixels)
 {
     pixels *= 2; /* change to number of samples */
@@ -36,3 +42,209 @@ void upipe_sdi_to_uyvy_c(const uint8_t *src, uint16_t *y, int64_t pixels)
         y[i+3] = ((d & 0x03) << 8) | e;                 //4455555555
     }
 }
+
+void upipe_sdi_to_planar10_c(const uint8_t *src, uint16_t *y, uint16_t *u,
+                             uint16_t *v, int64_t pixels)
+{
+    for (int64_t i = 0; i < pixels; i += 2) {
+        uint8_t a = *src++;
+        uint8_t b = *src++;
+        uint8_t c = *src++;
+        uint8_t d = *src++;
+        uint8_t e = *src++;
+        *u++ = (a << 2)          | ((b >> 6) & 0x03);
+        *y++ = ((b & 0x3f) << 4) | ((c >> 4) & 0x0f);
+        *v++ = ((c & 0x0f) << 6) | ((d >> 2) & 0x3f);
+        *y++ = ((d & 0x03) << 8) | e;
+    }
+}
+
+/* The vector variants below leave the remaining pixels to the C version, so
+ * that they don't read past the given number of pixels. */
+
+#if defined(__i686__) || defined(__x86_64__)
+/* 10 octets of 2 groups of 4 samples in each 128-bit lane */
+static const uint16_t sdidec_avx512_perm[32] = {
+     0,  1,  2,  3,  4,  0,  0,  0,  5,  6,  7,  8,  9,  0,  0,  0,
+    10, 11, 12, 13, 14,  0,  0,  0, 15, 16, 17, 18, 19,  0,  0,  0,
+};
+/* big endian 16-bit words holding each sample */
+static const int8_t sdidec_avx512_shuf[16] = {
+    1, 0, 2, 1, 3, 2, 4, 3, 6, 5, 7, 6, 8, 7, 9, 8,
+};
+
+__attribute__((target("avx512f,avx512bw,avx512vl")))
+void upipe_sdi_to_uyvy_avx512(const uint8_t *src, uint16_t *y, int64_t pixels)
+{
+    const __m512i perm = _mm512_loadu_si512(sdidec_avx512_perm);
+    const __m512i shuf = _mm512_broadcast_i32x4(
+            _mm_loadu_si128((const __m128i *)sdidec_avx512_shuf));
+    const __m512i shift = _mm512_set1_epi64(0x0000000200040006);
+    const __m512i mask = _mm512_set1_epi16(0x3ff);
+    int64_t i;
+    for (i = 0; i + 16 <= pixels; i += 16) {
+        __m512i s = _mm512_maskz_loadu_epi16(0xfffff, src);
+        s = _mm512_shuffle_epi8(_mm512_permutexvar_epi16(perm, s), shuf);
+        s = _mm512_and_si512(_mm512_srlv_epi16(s, shift), mask);
+        _mm512_storeu_si512(y, s);
+        src += 40;
+        y += 32;
+    }
+    upipe_sdi_to_uyvy_c(src, y, pixels - i);
+}
+
+/* the 16-bit words of 4 samples, shifted left so that each sample ends
+ * in the 10 most significant bits */
+static const int16_t sdidec_planar_mul[8] = { 1, 4, 16, 64, 1, 4, 16, 64 };
+/* u0 y0 v0 y1 u1 y2 v1 y3 to y0 y1 y2 y3 u0 u1 v0 v1 */
+static const int8_t sdidec_planar_deint[16] = {
+    2, 3, 6, 7, 10, 11, 14, 15, 0, 1, 8, 9, 4, 5, 12, 13,
+};
+
+__attribute__((target("ssse3")))
+void upipe_sdi_to_planar10_ssse3(const uint8_t *src, uint16_t *y, uint16_t *u,
+                                 uint16_t *v, int64_t pixels)
+{
+    const __m128i shuf = _mm_loadu_si128((const __m128i *)sdidec_avx512_shuf);
+    const __m128i mul = _mm_loadu_si128((const __m128i *)sdidec_planar_mul);
+    const __m128i deint = _mm_loadu_si128((const __m128i *)sdidec_planar_deint);
+    int64_t i;
+    /* each load reads 16 octets to use 10, so keep 6 octets of margin */
+    for (i = 0; i + 12 <= pixels; i += 8) {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)src),
+                                     shuf);
+        __m128i b = _mm_shuffle_epi8(
+                _mm_loadu_si128((const __m128i *)(src + 10)), shuf);
+        a = _mm_shuffle_epi8(_mm_srli_epi16(_mm_mullo_epi16(a, mul), 6), deint);
+        b = _mm_shuffle_epi8(_mm_srli_epi16(_mm_mullo_epi16(b, mul), 6), deint);
+        _mm_storeu_si128((__m128i *)y, _mm_unpacklo_epi64(a, b));
+        __m128i c = _mm_shuffle_epi32(_mm_unpackhi_epi64(a, b),
+                                      _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storel_epi64((__m128i *)u, c);
+        _mm_storel_epi64((__m128i *)v, _mm_srli_si128(c, 8));
+        src += 20;
+        y += 8;
+        u += 4;
+        v += 4;
+    }
+    upipe_sdi_to_planar10_c(src, y, u, v, pixels - i);
+}
+
+__attribute__((target("avx2")))
+void upipe_sdi_to_planar10_avx2(const uint8_t *src, uint16_t *y, uint16_t *u,
+                                uint16_t *v, int64_t pixels)
+{
+    const __m256i shuf = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128((const __m128i *)sdidec_avx512_shuf));
+    const __m256i mul = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128((const __m128i *)sdidec_planar_mul));
+    const __m256i deint = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128((const __m128i *)sdidec_planar_deint));
+    int64_t i;
+    for (i = 0; i + 20 <= pixels; i += 16) {
+        __m256i a = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                    _mm_loadu_si128((const __m128i *)src)),
+                _mm_loadu_si128((const __m128i *)(src + 20)), 1);
+        __m256i b = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                    _mm_loadu_si128((const __m128i *)(src + 10))),
+                _mm_loadu_si128((const __m128i *)(src + 30)), 1);
+        a = _mm256_shuffle_epi8(a, shuf);
+        b = _mm256_shuffle_epi8(b, shuf);
+        a = _mm256_srli_epi16(_mm256_mullo_epi16(a, mul), 6);
+        b = _mm256_srli_epi16(_mm256_mullo_epi16(b, mul), 6);
+        a = _mm256_shuffle_epi8(a, deint);
+        b = _mm256_shuffle_epi8(b, deint);
+        _mm256_storeu_si256((__m256i *)y, _mm256_unpacklo_epi64(a, b));
+        __m256i c = _mm256_shuffle_epi32(_mm256_unpackhi_epi64(a, b),
+                                         _MM_SHUFFLE(3, 1, 2, 0));
+        c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128((__m128i *)u, _mm256_castsi256_si128(c));
+        _mm_storeu_si128((__m128i *)v, _mm256_extracti128_si256(c, 1));
+        src += 40;
+        y += 16;
+        u += 8;
+        v += 8;
+    }
+    upipe_sdi_to_planar10_c(src, y, u, v, pixels - i);
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/* octets 0 to 4 of 8 groups of 4 samples */
+static const uint8_t sdidec_neon_tbl[40] = {
+    0,  5, 10, 15, 20, 25, 30, 35,  1,  6, 11, 16, 21, 26, 31, 36,
+    2,  7, 12, 17, 22, 27, 32, 37,  3,  8, 13, 18, 23, 28, 33, 38,
+    4,  9, 14, 19, 24, 29, 34, 39,
+};
+
+void upipe_sdi_to_uyvy_neon(const uint8_t *src, uint16_t *y, int64_t pixels)
+{
+    const uint8x16_t t0 = vld1q_u8(sdidec_neon_tbl);
+    const uint8x16_t t1 = vld1q_u8(sdidec_neon_tbl + 16);
+    const uint8x8_t t2 = vld1_u8(sdidec_neon_tbl + 32);
+    const uint16x8_t mask = vdupq_n_u16(0x3ff);
+    int64_t i;
+    for (i = 0; i + 16 <= pixels; i += 16) {
+        uint8x16x3_t s = { { vld1q_u8(src), vld1q_u8(src + 16),
+                             vcombine_u8(vld1_u8(src + 32), vdup_n_u8(0)) } };
+        uint8x16_t ab = vqtbl3q_u8(s, t0);
+        uint8x16_t cd = vqtbl3q_u8(s, t1);
+        uint8x8_t e = vqtbl3_u8(s, t2);
+        uint16x8_t wab = vorrq_u16(vshll_n_u8(vget_low_u8(ab), 8),
+                                   vmovl_u8(vget_high_u8(ab)));
+        uint16x8_t wbc = vorrq_u16(vshll_n_u8(vget_high_u8(ab), 8),
+                                   vmovl_u8(vget_low_u8(cd)));
+        uint16x8_t wcd = vorrq_u16(vshll_n_u8(vget_low_u8(cd), 8),
+                                   vmovl_u8(vget_high_u8(cd)));
+        uint16x8_t wde = vorrq_u16(vshll_n_u8(vget_high_u8(cd), 8),
+                                   vmovl_u8(e));
+        uint16x8x4_t out = { {
+            vshrq_n_u16(wab, 6),
+            vandq_u16(vshrq_n_u16(wbc, 4), mask),
+            vandq_u16(vshrq_n_u16(wcd, 2), mask),
+            vandq_u16(wde, mask),
+        } };
+        vst4q_u16(y, out);
+        src += 40;
+        y += 32;
+    }
+    upipe_sdi_to_uyvy_c(src, y, pixels - i);
+}
+
+void upipe_sdi_to_planar10_neon(const uint8_t *src, uint16_t *y, uint16_t *u,
+                                uint16_t *v, int64_t pixels)
+{
+    const uint8x16_t t0 = vld1q_u8(sdidec_neon_tbl);
+    const uint8x16_t t1 = vld1q_u8(sdidec_neon_tbl + 16);
+    const uint8x8_t t2 = vld1_u8(sdidec_neon_tbl + 32);
+    const uint16x8_t mask = vdupq_n_u16(0x3ff);
+    int64_t i;
+    for (i = 0; i + 16 <= pixels; i += 16) {
+        uint8x16x3_t s = { { vld1q_u8(src), vld1q_u8(src + 16),
+                             vcombine_u8(vld1_u8(src + 32), vdup_n_u8(0)) } };
+        uint8x16_t ab = vqtbl3q_u8(s, t0);
+        uint8x16_t cd = vqtbl3q_u8(s, t1);
+        uint8x8_t e = vqtbl3_u8(s, t2);
+        uint16x8_t wab = vorrq_u16(vshll_n_u8(vget_low_u8(ab), 8),
+                                   vmovl_u8(vget_high_u8(ab)));
+        uint16x8_t wbc = vorrq_u16(vshll_n_u8(vget_high_u8(ab), 8),
+                                   vmovl_u8(vget_low_u8(cd)));
+        uint16x8_t wcd = vorrq_u16(vshll_n_u8(vget_low_u8(cd), 8),
+                                   vmovl_u8(vget_high_u8(cd)));
+        uint16x8_t wde = vorrq_u16(vshll_n_u8(vget_high_u8(cd), 8),
+                                   vmovl_u8(e));
+        vst1q_u16(u, vshrq_n_u16(wab, 6));
+        vst1q_u16(v, vandq_u16(vshrq_n_u16(wcd, 2), mask));
+        uint16x8x2_t luma = { {
+            vandq_u16(vshrq_n_u16(wbc, 4), mask),
+            vandq_u16(wde, mask),
+        } };
+        vst2q_u16(y, luma);
+        src += 40;
+        y += 16;
+        u += 8;
+        v += 8;
+    }
+    upipe_sdi_to_planar10_c(src, y, u, v, pixels - i);
+}
+#endif
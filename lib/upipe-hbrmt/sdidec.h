@@ -1,3 +1,23 @@
 void upipe_sdi_to_uyvy_c(const uint8_t *src, uint16_t *y, int64_t pixels);
 void upipe_sdi_to_uyvy_ssse3(const uint8_t *src, uint16_t *y, int64_t pixels);
 void upipe_sdi_to_uyvy_avx2 (const uint8_t *src, uint16_t *y, int64_t pixels);
+
+void upipe_sdi_to_planar10_c(const uint8_t *src, uint16_t *y, uint16_t *u,
+                             uint16_t *v, int64_t pixels);
+
+#if defined(__i686__) || defined(__x86_64__)
+/* process 16 pixels per iteration, requires AVX-512 BW and VL */
+void upipe_sdi_to_uyvy_avx512(const uint8_t *src, uint16_t *y, int64_t pixels);
+/* process 8 and 16 pixels per iteration, into separate 16-bit planes */
+void upipe_sdi_to_planar10_ssse3(const uint8_t *src, uint16_t *y, uint16_t *u,
+                                 uint16_t *v, int64_t pixels);
+void upipe_sdi_to_planar10_avx2(const uint8_t *src, uint16_t *y, uint16_t *u,
+                                uint16_t *v, int64_t pixels);
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/* process 16 pixels per iteration */
+void upipe_sdi_to_uyvy_neon(const uint8_t *src, uint16_t *y, int64_t pixels);
+void upipe_sdi_to_planar10_neon(const uint8_t *src, uint16_t *y, uint16_t *u,
+                                uint16_t *v, int64_t pixels);
+#endif
@@ -24,6 +24,12 @@
 
 #include "sdienc.h"
 
+#if defined(__i686__) || defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 void upipe_uyvy_to_sdi_c(uint8_t *dst, const uint8_t *y, int64_t pixels)
 {
     struct ubits s;
@@ -40,3 +46,246 @@ void upipe_uyvy_to_sdi_c(uint8_t *dst, const uint8_t *y, int64_t pixels)
         // check buffer end?
     }
 }
+
+void upipe_v210_to_sdi_c(uint8_t *dst, const uint8_t *src, int64_t pixels)
+{
+    struct ubits s;
+    int64_t size = pixels * 2; /* change to number of samples */
+    ubits_init(&s, dst, size * 10 / 8);
+
+    /* v210 words hold 3 samples in UYVY order, from the least significant
+     * bits */
+    for (int64_t i = 0; i < size; i += 3) {
+        uint32_t w = src[0] | (src[1] << 8) | (src[2] << 16) |
+                     ((uint32_t)src[3] << 24);
+        src += 4;
+        for (int j = 0; j < 3 && i + j < size; j++)
+            ubits_put(&s, 10, (w >> (10 * j)) & 0x3ff);
+    }
+
+    uint8_t *end;
+    ubits_clean(&s, &end);
+}
+
+void upipe_planar10_to_sdi_c(uint8_t *dst, const uint16_t *y,
+                             const uint16_t *u, const uint16_t *v,
+                             int64_t pixels)
+{
+    for (int64_t i = 0; i < pixels; i += 2) {
+        uint16_t s0 = *u++ & 0x3ff;
+        uint16_t s1 = *y++ & 0x3ff;
+        uint16_t s2 = *v++ & 0x3ff;
+        uint16_t s3 = *y++ & 0x3ff;
+        *dst++ = s0 >> 2;
+        *dst++ = (s0 << 6) | (s1 >> 4);
+        *dst++ = (s1 << 4) | (s2 >> 6);
+        *dst++ = (s2 << 2) | (s3 >> 8);
+        *dst++ = s3;
+    }
+}
+
+/* The vector variants below leave the remaining pixels to the C version, so
+ * that they neither read nor write past the given number of pixels. */
+
+#if defined(__i686__) || defined(__x86_64__)
+/* 40-bit groups of 4 samples, most significant octet first */
+static const int8_t sdienc_avx512_shuf[64] = {
+    4, 3, 2, 1, 0, 12, 11, 10, 9, 8, -1, -1, -1, -1, -1, -1,
+    4, 3, 2, 1, 0, 12, 11, 10, 9, 8, -1, -1, -1, -1, -1, -1,
+    4, 3, 2, 1, 0, 12, 11, 10, 9, 8, -1, -1, -1, -1, -1, -1,
+    4, 3, 2, 1, 0, 12, 11, 10, 9, 8, -1, -1, -1, -1, -1, -1,
+};
+static const uint16_t sdienc_avx512_perm[32] = {
+     0,  1,  2,  3,  4,  8,  9, 10, 11, 12, 16, 17, 18, 19, 20, 24,
+    25, 26, 27, 28,
+};
+
+__attribute__((target("avx512f,avx512bw,avx512vl")))
+void upipe_uyvy_to_sdi_avx512(uint8_t *dst, const uint8_t *y, int64_t pixels)
+{
+    const uint16_t *src = (const uint16_t *)y;
+    const __m512i mul = _mm512_set1_epi32(0x00010400);
+    const __m512i shift = _mm512_set1_epi64(1 << 20);
+    const __m512i shuf = _mm512_loadu_si512(sdienc_avx512_shuf);
+    const __m512i perm = _mm512_loadu_si512(sdienc_avx512_perm);
+    int64_t i;
+    for (i = 0; i + 16 <= pixels; i += 16) {
+        /* s0 << 10 | s1, s2 << 10 | s3 */
+        __m512i p = _mm512_madd_epi16(_mm512_loadu_si512(src + 2 * i), mul);
+        /* s0 << 30 | s1 << 20 | s2 << 10 | s3 */
+        __m512i v = _mm512_or_si512(_mm512_mul_epu32(p, shift),
+                                    _mm512_srli_epi64(p, 32));
+        v = _mm512_permutexvar_epi16(perm, _mm512_shuffle_epi8(v, shuf));
+        _mm512_mask_storeu_epi8(dst, 0xffffffffffULL, v);
+        dst += 40;
+    }
+    upipe_uyvy_to_sdi_c(dst, (const uint8_t *)(src + 2 * i), pixels - i);
+}
+
+/* 120-bit groups of 12 samples, most significant octet first */
+static const int8_t sdienc_v210_shuf[32] = {
+    7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, -1,
+    7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, -1,
+};
+
+/* In each 32-bit word, c0 | c1 << 10 | c2 << 20 is reordered as
+ * c0 << 20 | c1 << 10 | c2, then the two words of each 64-bit lane are merged
+ * into 60 bits, and in each 128-bit lane the first 60 bits are put on top of
+ * the second 60 bits, leaving 8 unused bits at the bottom. */
+
+__attribute__((target("avx2")))
+void upipe_v210_to_sdi_avx2(uint8_t *dst, const uint8_t *src, int64_t pixels)
+{
+    const __m256i m = _mm256_set1_epi32(0x3ff);
+    const __m256i m1 = _mm256_set1_epi32(0xffc00);
+    const __m256i shift = _mm256_set1_epi64x(1 << 30);
+    const __m256i shuf = _mm256_loadu_si256((const __m256i *)sdienc_v210_shuf);
+    int64_t i;
+    /* the second half is stored on 16 octets, so stop 2 pixels before the
+     * end to let the C version overwrite the last one */
+    for (i = 0; i + 14 <= pixels; i += 12) {
+        __m256i w = _mm256_loadu_si256((const __m256i *)src);
+        __m256i r = _mm256_or_si256(
+                _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(w, m), 20),
+                                _mm256_and_si256(w, m1)),
+                _mm256_and_si256(_mm256_srli_epi32(w, 20), m));
+        __m256i v = _mm256_or_si256(_mm256_mul_epu32(r, shift),
+                                    _mm256_srli_epi64(r, 32));
+        __m256i sw = _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+        __m256i hi = _mm256_or_si256(_mm256_slli_epi64(v, 4),
+                                     _mm256_srli_epi64(sw, 56));
+        v = _mm256_blend_epi32(hi, _mm256_slli_epi64(v, 8), 0xcc);
+        v = _mm256_shuffle_epi8(v, shuf);
+        _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(v));
+        _mm_storeu_si128((__m128i *)(dst + 15), _mm256_extracti128_si256(v, 1));
+        src += 32;
+        dst += 30;
+    }
+    upipe_v210_to_sdi_c(dst, src, pixels - i);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl")))
+void upipe_v210_to_sdi_avx512(uint8_t *dst, const uint8_t *src, int64_t pixels)
+{
+    const __m512i m = _mm512_set1_epi32(0x3ff);
+    const __m512i m1 = _mm512_set1_epi32(0xffc00);
+    const __m512i shift = _mm512_set1_epi64(1 << 30);
+    const __m512i shuf = _mm512_broadcast_i64x4(
+            _mm256_loadu_si256((const __m256i *)sdienc_v210_shuf));
+    int64_t i;
+    for (i = 0; i + 24 <= pixels; i += 24) {
+        __m512i w = _mm512_loadu_si512(src);
+        __m512i r = _mm512_or_si512(
+                _mm512_or_si512(_mm512_slli_epi32(_mm512_and_si512(w, m), 20),
+                                _mm512_and_si512(w, m1)),
+                _mm512_and_si512(_mm512_srli_epi32(w, 20), m));
+        __m512i v = _mm512_or_si512(_mm512_mul_epu32(r, shift),
+                                    _mm512_srli_epi64(r, 32));
+        __m512i sw = _mm512_shuffle_epi32(v, _MM_PERM_BADC);
+        __m512i hi = _mm512_or_si512(_mm512_slli_epi64(v, 4),
+                                     _mm512_srli_epi64(sw, 56));
+        v = _mm512_mask_blend_epi64(0xaa, hi, _mm512_slli_epi64(v, 8));
+        v = _mm512_shuffle_epi8(v, shuf);
+        _mm_mask_storeu_epi8(dst, 0x7fff, _mm512_castsi512_si128(v));
+        _mm_mask_storeu_epi8(dst + 15, 0x7fff, _mm512_extracti32x4_epi32(v, 1));
+        _mm_mask_storeu_epi8(dst + 30, 0x7fff, _mm512_extracti32x4_epi32(v, 2));
+        _mm_mask_storeu_epi8(dst + 45, 0x7fff, _mm512_extracti32x4_epi32(v, 3));
+        src += 64;
+        dst += 60;
+    }
+    upipe_v210_to_sdi_c(dst, src, pixels - i);
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/* octet k of 8 groups of 4 samples is octet k % 5 of group k / 5 */
+static const uint8_t sdienc_neon_tbl[40] = {
+    0,  8, 16, 24, 32,  1,  9, 17, 25, 33,  2, 10, 18, 26, 34,  3,
+   11, 19, 27, 35,  4, 12, 20, 28, 36,  5, 13, 21, 29, 37,  6, 14,
+   22, 30, 38,  7, 15, 23, 31, 39,
+};
+
+void upipe_uyvy_to_sdi_neon(uint8_t *dst, const uint8_t *y, int64_t pixels)
+{
+    const uint16_t *src = (const uint16_t *)y;
+    const uint8x16_t t0 = vld1q_u8(sdienc_neon_tbl);
+    const uint8x16_t t1 = vld1q_u8(sdienc_neon_tbl + 16);
+    const uint8x8_t t2 = vld1_u8(sdienc_neon_tbl + 32);
+    int64_t i;
+    for (i = 0; i + 16 <= pixels; i += 16) {
+        uint16x8x4_t s = vld4q_u16(src + 2 * i);
+        /* the narrowing drops the bits of the previous sample */
+        uint8x8_t b0 = vmovn_u16(vshrq_n_u16(s.val[0], 2));
+        uint8x8_t b1 = vmovn_u16(vorrq_u16(vshlq_n_u16(s.val[0], 6),
+                                           vshrq_n_u16(s.val[1], 4)));
+        uint8x8_t b2 = vmovn_u16(vorrq_u16(vshlq_n_u16(s.val[1], 4),
+                                           vshrq_n_u16(s.val[2], 6)));
+        uint8x8_t b3 = vmovn_u16(vorrq_u16(vshlq_n_u16(s.val[2], 2),
+                                           vshrq_n_u16(s.val[3], 8)));
+        uint8x8_t b4 = vmovn_u16(s.val[3]);
+        uint8x16x3_t b = { { vcombine_u8(b0, b1), vcombine_u8(b2, b3),
+                             vcombine_u8(b4, b4) } };
+        vst1q_u8(dst, vqtbl3q_u8(b, t0));
+        vst1q_u8(dst + 16, vqtbl3q_u8(b, t1));
+        vst1_u8(dst + 32, vqtbl3_u8(b, t2));
+        dst += 40;
+    }
+    upipe_uyvy_to_sdi_c(dst, (const uint8_t *)(src + 2 * i), pixels - i);
+}
+
+/* octets of 4 groups of 12 samples, each stored as 60 then 56 bits from the
+ * most significant octet of a 128-bit lane */
+static const uint8_t sdienc_neon_v210_tbl[60] = {
+    7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10,  9, 23,
+    6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10,  9, 23, 22,
+    5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10,  9, 23, 22, 21,
+    4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10,  9,
+};
+
+/** @internal @This reorders the samples of 4 v210 words into a 120-bit big
+ * endian group, in the same layout as the x86 versions.
+ *
+ * @param w 4 v210 words
+ * @return 128-bit lane
+ */
+static inline uint8x16_t sdienc_v210_neon(uint32x4_t w)
+{
+    const uint32x4_t m = vdupq_n_u32(0x3ff);
+    uint32x4_t r = vorrq_u32(vorrq_u32(vshlq_n_u32(vandq_u32(w, m), 20),
+                                       vandq_u32(w, vdupq_n_u32(0xffc00))),
+                             vandq_u32(vshrq_n_u32(w, 20), m));
+    uint64x2_t r64 = vreinterpretq_u64_u32(r);
+    uint64x2_t v = vorrq_u64(vshrq_n_u64(vshlq_n_u64(r64, 32), 2),
+                             vshrq_n_u64(r64, 32));
+    uint64x2_t hi = vorrq_u64(vshlq_n_u64(v, 4),
+                              vshrq_n_u64(vextq_u64(v, v, 1), 56));
+    return vreinterpretq_u8_u64(vcombine_u64(vget_low_u64(hi),
+                                             vget_high_u64(vshlq_n_u64(v, 8))));
+}
+
+void upipe_v210_to_sdi_neon(uint8_t *dst, const uint8_t *src, int64_t pixels)
+{
+    const uint8x16_t t0 = vld1q_u8(sdienc_neon_v210_tbl);
+    const uint8x16_t t1 = vld1q_u8(sdienc_neon_v210_tbl + 16);
+    const uint8x16_t t2 = vld1q_u8(sdienc_neon_v210_tbl + 32);
+    const uint8x16_t t3 = vcombine_u8(vld1_u8(sdienc_neon_v210_tbl + 48),
+                                      vld1_u8(sdienc_neon_v210_tbl + 52));
+    int64_t i;
+    for (i = 0; i + 24 <= pixels; i += 24) {
+        const uint32_t *w = (const uint32_t *)src;
+        uint8x16_t r0 = sdienc_v210_neon(vld1q_u32(w));
+        uint8x16_t r1 = sdienc_v210_neon(vld1q_u32(w + 4));
+        uint8x16_t r2 = sdienc_v210_neon(vld1q_u32(w + 8));
+        uint8x16_t r3 = sdienc_v210_neon(vld1q_u32(w + 12));
+        vst1q_u8(dst, vqtbl2q_u8((uint8x16x2_t){ { r0, r1 } }, t0));
+        vst1q_u8(dst + 16, vqtbl2q_u8((uint8x16x2_t){ { r1, r2 } }, t1));
+        vst1q_u8(dst + 32, vqtbl2q_u8((uint8x16x2_t){ { r2, r3 } }, t2));
+        uint8x16_t o3 = vqtbl1q_u8(r3, t3);
+        vst1_u8(dst + 48, vget_low_u8(o3));
+        vst1q_lane_u32((uint32_t *)(dst + 56), vreinterpretq_u32_u8(o3), 3);
+        src += 64;
+        dst += 60;
+    }
+    upipe_v210_to_sdi_c(dst, src, pixels - i);
+}
+#endif
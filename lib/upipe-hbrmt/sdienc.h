@@ -2,3 +2,22 @@ void upipe_uyvy_to_sdi_c(uint8_t *dst, const uint8_t *y, int64_t pixels);
 void upipe_uyvy_to_sdi_ssse3(uint8_t *dst, const uint8_t *y, int64_t pixels);
 void upipe_uyvy_to_sdi_avx  (uint8_t *dst, const uint8_t *y, int64_t pixels);
 void upipe_uyvy_to_sdi_avx2 (uint8_t *dst, const uint8_t *y, int64_t pixels);
+
+void upipe_v210_to_sdi_c(uint8_t *dst, const uint8_t *src, int64_t pixels);
+void upipe_planar10_to_sdi_c(uint8_t *dst, const uint16_t *y,
+                             const uint16_t *u, const uint16_t *v,
+                             int64_t pixels);
+
+#if defined(__i686__) || defined(__x86_64__)
+/* process 16 pixels per iteration, requires AVX-512 BW and VL */
+void upipe_uyvy_to_sdi_avx512(uint8_t *dst, const uint8_t *y, int64_t pixels);
+/* process 12 or 24 pixels of v210 per iteration */
+void upipe_v210_to_sdi_avx2(uint8_t *dst, const uint8_t *src, int64_t pixels);
+void upipe_v210_to_sdi_avx512(uint8_t *dst, const uint8_t *src, int64_t pixels);
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/* process 16 pixels, or 24 pixels of v210, per iteration */
+void upipe_uyvy_to_sdi_neon(uint8_t *dst, const uint8_t *y, int64_t pixels);
+void upipe_v210_to_sdi_neon(uint8_t *dst, const uint8_t *src, int64_t pixels);
+#endif
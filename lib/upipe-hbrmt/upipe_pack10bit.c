@@ -34,6 +34,8 @@
 #include <upipe/uref_dump.h>
 #include <upipe/ubuf_block.h>
 #include <upipe/uref_block.h>
+#include <upipe/uref_pic.h>
+#include <upipe/uref_pic_flow.h>
 #include <upipe/upipe_helper_upipe.h>
 #include <upipe/upipe_helper_urefcount.h>
 #include <upipe/upipe_helper_void.h>
@@ -47,6 +49,9 @@
 
 #define UBUF_ALIGN 32 /* 256-bits simd (avx2) */
 
+/** v210 chroma */
+#define V210_CHROMA "u10y10v10y10u10y10v10y10u10y10v10y10"
+
 /** upipe_pack10bit structure with pack10bit parameters */
 struct upipe_pack10bit {
     /** refcount management structure */
@@ -79,6 +84,8 @@ struct upipe_pack10bit {
 
     /** packing */
     void (*pack)(uint8_t *dst, const uint8_t *y, int64_t pixels);
+    /** packing from v210 pictures */
+    void (*pack_v210)(uint8_t *dst, const uint8_t *src, int64_t pixels);
 
     /** public upipe structure */
     struct upipe upipe;
@@ -100,6 +107,64 @@ UPIPE_HELPER_UBUF_MGR(upipe_pack10bit, ubuf_mgr, flow_format, ubuf_mgr_request,
                       upipe_pack10bit_unregister_output_request)
 UPIPE_HELPER_INPUT(upipe_pack10bit, urefs, nb_urefs, max_urefs, blockers, upipe_pack10bit_handle)
 
+/** @internal @This packs a v210 picture, line by line, without unpacking
+ * it to 16-bit samples first.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure describing the picture
+ * @param hsize horizontal size of the picture
+ * @param vsize vertical size of the picture
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_pack10bit_handle_v210(struct upipe *upipe, struct uref *uref,
+                                        size_t hsize, size_t vsize,
+                                        struct upump **upump_p)
+{
+    struct upipe_pack10bit *upipe_pack10bit = upipe_pack10bit_from_upipe(upipe);
+    size_t stride;
+    const uint8_t *src = NULL;
+    if (unlikely(hsize % 2 ||
+                 !ubase_check(uref_pic_plane_size(uref, V210_CHROMA, &stride,
+                                                  NULL, NULL, NULL)) ||
+                 !ubase_check(uref_pic_plane_read(uref, V210_CHROMA, 0, 0,
+                                                  -1, -1, &src)))) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
+        return;
+    }
+
+    /* 2 samples of 10 bits per pixel */
+    size_t line_size = hsize * 5 / 2;
+    struct ubuf *ubuf_dst = ubuf_block_alloc(upipe_pack10bit->ubuf_mgr,
+                                             line_size * vsize);
+    if (!ubuf_dst) {
+        uref_pic_plane_unmap(uref, V210_CHROMA, 0, 0, -1, -1);
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+
+    uint8_t *buffer = NULL;
+    int ubuf_size = -1;
+    if (!ubase_check(ubuf_block_write(ubuf_dst, 0, &ubuf_size, &buffer))) {
+        uref_pic_plane_unmap(uref, V210_CHROMA, 0, 0, -1, -1);
+        uref_free(uref);
+        ubuf_free(ubuf_dst);
+        upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
+        return;
+    }
+
+    for (size_t i = 0; i < vsize; i++)
+        upipe_pack10bit->pack_v210(buffer + i * line_size, src + i * stride,
+                                   hsize);
+
+    uref_pic_plane_unmap(uref, V210_CHROMA, 0, 0, -1, -1);
+    ubuf_block_unmap(ubuf_dst, 0);
+    uref_attach_ubuf(uref, ubuf_dst);
+
+    upipe_pack10bit_output(upipe, uref, upump_p);
+}
+
 /** @internal @This handles data.
  *
  * @param upipe description structure of the pipe
@@ -121,6 +186,12 @@ static bool upipe_pack10bit_handle(struct upipe *upipe, struct uref *uref,
     if (upipe_pack10bit->flow_def == NULL)
         return false;
 
+    size_t hsize, vsize;
+    if (ubase_check(uref_pic_size(uref, &hsize, &vsize, NULL))) {
+        upipe_pack10bit_handle_v210(upipe, uref, hsize, vsize, upump_p);
+        return true;
+    }
+
     const uint8_t *src = NULL;
     int buf_size = -1;
     if (unlikely(!ubase_check(uref_block_read(uref, 0, &buf_size, &src)))) {
@@ -239,7 +310,8 @@ static int upipe_pack10bit_amend_ubuf_mgr(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
-/** @internal @This sets the input flow definition.
+/** @internal @This sets the input flow definition. The input is either
+ * blocks of 16-bit samples, or v210 pictures.
  *
  * @param upipe description structure of the pipe
  * @param flow_def flow definition packet
@@ -250,18 +322,28 @@ static int upipe_pack10bit_set_flow_def(struct upipe *upipe, struct uref *flow_d
     if (flow_def == NULL)
         return UBASE_ERR_INVALID;
 
-    UBASE_RETURN(uref_flow_match_def(flow_def, "block."))
-
-    uint64_t align;
-    UBASE_RETURN(uref_block_flow_get_align(flow_def, &align))
-    if (!align || align % UBUF_ALIGN)
-        return UBASE_ERR_INVALID;
+    if (ubase_check(uref_flow_match_def(flow_def, UREF_PIC_FLOW_DEF))) {
+        UBASE_RETURN(uref_pic_flow_check_chroma(flow_def, 1, 1, 16,
+                                                V210_CHROMA))
+        uint64_t hsize;
+        if (ubase_check(uref_pic_flow_get_hsize(flow_def, &hsize)) &&
+            hsize % 2)
+            return UBASE_ERR_INVALID;
+    } else {
+        UBASE_RETURN(uref_flow_match_def(flow_def, "block."))
+
+        uint64_t align;
+        UBASE_RETURN(uref_block_flow_get_align(flow_def, &align))
+        if (!align || align % UBUF_ALIGN)
+            return UBASE_ERR_INVALID;
+    }
 
     struct uref *flow_def_dup = uref_dup(flow_def);
 
     if (flow_def_dup == NULL)
         return UBASE_ERR_ALLOC;
 
+    uref_pic_flow_clear_format(flow_def_dup);
     uref_flow_set_def(flow_def_dup, "block.");
     uref_block_flow_set_align(flow_def_dup, UBUF_ALIGN);
     /* avx2 worst case, writes a full xmm register at offset + 10 */
@@ -346,6 +428,21 @@ static struct upipe *upipe_pack10bit_alloc(struct upipe_mgr *mgr,
 #endif
 #endif
 
+    upipe_pack10bit->pack_v210 = upipe_v210_to_sdi_c;
+#if defined(__i686__) || defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2"))
+        upipe_pack10bit->pack_v210 = upipe_v210_to_sdi_avx2;
+
+    if (__builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512vl")) {
+        upipe_pack10bit->pack = upipe_uyvy_to_sdi_avx512;
+        upipe_pack10bit->pack_v210 = upipe_v210_to_sdi_avx512;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    upipe_pack10bit->pack = upipe_uyvy_to_sdi_neon;
+    upipe_pack10bit->pack_v210 = upipe_v210_to_sdi_neon;
+#endif
+
     upipe_pack10bit_init_urefcount(upipe);
     upipe_pack10bit_init_ubuf_mgr(upipe);
     upipe_pack10bit_init_output(upipe);
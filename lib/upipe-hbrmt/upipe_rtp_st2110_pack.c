@@ -0,0 +1,493 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module splitting 4:2:2 10-bit pictures into SMPTE ST 2110-20
+ * RTP packets
+ */
+
+#include <config.h>
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uclock.h>
+#include <upipe/uref.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_pic.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe/upipe_helper_ubuf_mgr.h>
+#include <upipe/upipe_helper_input.h>
+
+#include <upipe-hbrmt/upipe_rtp_st2110_pack.h>
+
+#include "sdienc.h"
+
+#include <string.h>
+
+#include <bitstream/ietf/rtp.h>
+
+/** RTP clock rate of video */
+#define RTP_CLOCKRATE 90000
+/** dynamic RTP payload type */
+#define RTP_TYPE 96
+/** maximum size of a packet */
+#define MTU 1440
+/** size of the extended sequence number */
+#define ST2110_SEQNUM_SIZE 2
+/** size of a sample row data header */
+#define ST2110_SRD_SIZE 6
+/** size of a 4:2:2 10-bit pixel group of 2 pixels */
+#define PGROUP_SIZE 5
+/** maximum number of pixels in a packet */
+#define MAX_PIXELS ((MTU - RTP_HEADER_SIZE - ST2110_SEQNUM_SIZE - \
+                     ST2110_SRD_SIZE) / PGROUP_SIZE * 2)
+
+/** @internal @This is the private context of a rtp_st2110_pack pipe. */
+struct upipe_rtp_st2110_pack {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** output flow definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** ubuf manager */
+    struct ubuf_mgr *ubuf_mgr;
+    /** flow format packet */
+    struct uref *flow_format;
+    /** ubuf manager request */
+    struct urequest ubuf_mgr_request;
+
+    /** temporary uref storage (used during urequest) */
+    struct uchain urefs;
+    /** nb urefs in storage */
+    unsigned int nb_urefs;
+    /** max urefs in storage */
+    unsigned int max_urefs;
+    /** list of blockers (used during urequest) */
+    struct uchain blockers;
+
+    /** extended sequence number of the next packet */
+    uint32_t seqnum;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+/** chroma of the planes, in the order of the samples */
+static const char *upipe_rtp_st2110_pack_chroma[3] = {
+    "y10l", "u10l", "v10l"
+};
+
+/** @hidden */
+static int upipe_rtp_st2110_pack_check(struct upipe *upipe,
+                                       struct uref *flow_format);
+/** @hidden */
+static bool upipe_rtp_st2110_pack_handle(struct upipe *upipe,
+                                         struct uref *uref,
+                                         struct upump **upump_p);
+
+UPIPE_HELPER_UPIPE(upipe_rtp_st2110_pack, upipe,
+                   UPIPE_RTP_ST2110_PACK_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_rtp_st2110_pack, urefcount,
+                       upipe_rtp_st2110_pack_free)
+UPIPE_HELPER_VOID(upipe_rtp_st2110_pack)
+UPIPE_HELPER_OUTPUT(upipe_rtp_st2110_pack, output, flow_def, output_state,
+                    request_list)
+UPIPE_HELPER_UBUF_MGR(upipe_rtp_st2110_pack, ubuf_mgr, flow_format,
+                      ubuf_mgr_request, upipe_rtp_st2110_pack_check,
+                      upipe_rtp_st2110_pack_register_output_request,
+                      upipe_rtp_st2110_pack_unregister_output_request)
+UPIPE_HELPER_INPUT(upipe_rtp_st2110_pack, urefs, nb_urefs, max_urefs,
+                   blockers, upipe_rtp_st2110_pack_handle)
+
+/** @internal @This receives a provided ubuf manager.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_rtp_st2110_pack_check(struct upipe *upipe,
+                                       struct uref *flow_format)
+{
+    if (flow_format != NULL)
+        upipe_rtp_st2110_pack_store_flow_def(upipe, flow_format);
+
+    bool was_buffered = !upipe_rtp_st2110_pack_check_input(upipe);
+    upipe_rtp_st2110_pack_output_input(upipe);
+    upipe_rtp_st2110_pack_unblock_input(upipe);
+    if (was_buffered && upipe_rtp_st2110_pack_check_input(upipe)) {
+        /* All packets have been output, release again the pipe that has been
+         * used in @ref upipe_rtp_st2110_pack_input. */
+        upipe_release(upipe);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This outputs a packet carrying a segment of a line.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref picture, whose attributes are copied
+ * @param planes mapped planes of the picture
+ * @param strides strides of the planes
+ * @param line line of the picture
+ * @param row row number in the field
+ * @param field true for the second field
+ * @param offset first pixel of the segment
+ * @param pixels number of pixels of the segment
+ * @param timestamp RTP timestamp
+ * @param marker true for the last packet of the field
+ * @param upump_p reference to pump that generated the buffer
+ * @return an error code
+ */
+static int upipe_rtp_st2110_pack_segment(struct upipe *upipe,
+                                         struct uref *uref,
+                                         const uint8_t *planes[3],
+                                         const size_t strides[3],
+                                         uint64_t line, uint64_t row,
+                                         bool field, uint64_t offset,
+                                         uint64_t pixels, uint32_t timestamp,
+                                         bool marker, struct upump **upump_p)
+{
+    struct upipe_rtp_st2110_pack *upipe_rtp_st2110_pack =
+        upipe_rtp_st2110_pack_from_upipe(upipe);
+    size_t length = pixels / 2 * PGROUP_SIZE;
+    struct ubuf *ubuf = ubuf_block_alloc(upipe_rtp_st2110_pack->ubuf_mgr,
+            RTP_HEADER_SIZE + ST2110_SEQNUM_SIZE + ST2110_SRD_SIZE + length);
+    UBASE_ALLOC_RETURN(ubuf);
+
+    uint8_t *buffer;
+    int size = -1;
+    if (unlikely(!ubase_check(ubuf_block_write(ubuf, 0, &size, &buffer)))) {
+        ubuf_free(ubuf);
+        return UBASE_ERR_ALLOC;
+    }
+
+    uint32_t seqnum = upipe_rtp_st2110_pack->seqnum++;
+    memset(buffer, 0, RTP_HEADER_SIZE);
+    rtp_set_hdr(buffer);
+    rtp_set_type(buffer, RTP_TYPE);
+    if (marker)
+        rtp_set_marker(buffer);
+    rtp_set_seqnum(buffer, seqnum & UINT16_MAX);
+    rtp_set_timestamp(buffer, timestamp);
+
+    uint8_t *payload = buffer + RTP_HEADER_SIZE;
+    *payload++ = seqnum >> 24;
+    *payload++ = (seqnum >> 16) & 0xff;
+    *payload++ = length >> 8;
+    *payload++ = length & 0xff;
+    *payload++ = (field ? 0x80 : 0) | ((row >> 8) & 0x7f);
+    *payload++ = row & 0xff;
+    *payload++ = (offset >> 8) & 0x7f;
+    *payload++ = offset & 0xff;
+
+    const uint16_t *y = (const uint16_t *)(planes[0] + line * strides[0]);
+    const uint16_t *u = (const uint16_t *)(planes[1] + line * strides[1]);
+    const uint16_t *v = (const uint16_t *)(planes[2] + line * strides[2]);
+    upipe_planar10_to_sdi_c(payload, y + offset, u + offset / 2,
+                            v + offset / 2, pixels);
+    ubuf_block_unmap(ubuf, 0);
+
+    struct uref *packet = uref_fork(uref, ubuf);
+    if (unlikely(packet == NULL)) {
+        ubuf_free(ubuf);
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_rtp_st2110_pack_output(upipe, packet, upump_p);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This splits a picture into packets.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure describing the picture
+ * @param upump_p reference to pump that generated the buffer
+ * @return false if the input must be blocked
+ */
+static bool upipe_rtp_st2110_pack_handle(struct upipe *upipe,
+                                         struct uref *uref,
+                                         struct upump **upump_p)
+{
+    struct upipe_rtp_st2110_pack *upipe_rtp_st2110_pack =
+        upipe_rtp_st2110_pack_from_upipe(upipe);
+    if (upipe_rtp_st2110_pack->ubuf_mgr == NULL)
+        return false;
+
+    size_t hsize, vsize;
+    if (unlikely(!ubase_check(uref_pic_size(uref, &hsize, &vsize, NULL)) ||
+                 hsize % 2)) {
+        upipe_warn(upipe, "invalid picture received");
+        uref_free(uref);
+        return true;
+    }
+
+    const uint8_t *planes[3];
+    size_t strides[3];
+    for (int i = 0; i < 3; i++) {
+        const char *chroma = upipe_rtp_st2110_pack_chroma[i];
+        if (unlikely(!ubase_check(uref_pic_plane_size(uref, chroma,
+                            &strides[i], NULL, NULL, NULL)) ||
+                     !ubase_check(uref_pic_plane_read(uref, chroma,
+                            0, 0, -1, -1, &planes[i])))) {
+            for (int j = 0; j < i; j++)
+                uref_pic_plane_unmap(uref, upipe_rtp_st2110_pack_chroma[j],
+                                     0, 0, -1, -1);
+            upipe_warn(upipe, "invalid picture received");
+            uref_free(uref);
+            return true;
+        }
+    }
+
+    /* timestamp (synced to program pts, fallback to system pts) */
+    uint64_t pts = 0;
+    if (unlikely(!ubase_check(uref_clock_get_pts_prog(uref, &pts))))
+        uref_clock_get_pts_sys(uref, &pts);
+    uint64_t duration = 0;
+    uref_clock_get_duration(uref, &duration);
+
+    /* interlaced pictures are sent as two fields */
+    bool progressive = ubase_check(uref_pic_get_progressive(uref));
+    unsigned int fields = progressive ? 1 : 2;
+    for (unsigned int field = 0; field < fields; field++) {
+        uint32_t timestamp = (pts + field * duration / 2) * RTP_CLOCKRATE /
+                             UCLOCK_FREQ;
+        uint64_t rows = progressive ? vsize : (vsize - field + 1) / 2;
+        for (uint64_t row = 0; row < rows; row++) {
+            uint64_t line = progressive ? row : 2 * row + field;
+            for (uint64_t offset = 0; offset < hsize; offset += MAX_PIXELS) {
+                uint64_t pixels = hsize - offset;
+                if (pixels > MAX_PIXELS)
+                    pixels = MAX_PIXELS;
+                bool marker = row == rows - 1 && offset + pixels == hsize;
+                int err = upipe_rtp_st2110_pack_segment(upipe, uref,
+                        planes, strides, line, row, field, offset, pixels,
+                        timestamp, marker, upump_p);
+                if (unlikely(!ubase_check(err))) {
+                    upipe_throw_fatal(upipe, err);
+                    goto end;
+                }
+            }
+        }
+    }
+
+end:
+    for (int i = 0; i < 3; i++)
+        uref_pic_plane_unmap(uref, upipe_rtp_st2110_pack_chroma[i],
+                             0, 0, -1, -1);
+    uref_free(uref);
+    return true;
+}
+
+/** @internal @This receives incoming pictures.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure describing the picture
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtp_st2110_pack_input(struct upipe *upipe, struct uref *uref,
+                                        struct upump **upump_p)
+{
+    if (!upipe_rtp_st2110_pack_check_input(upipe)) {
+        upipe_rtp_st2110_pack_hold_input(upipe, uref);
+        upipe_rtp_st2110_pack_block_input(upipe, upump_p);
+    } else if (!upipe_rtp_st2110_pack_handle(upipe, uref, upump_p)) {
+        upipe_rtp_st2110_pack_hold_input(upipe, uref);
+        upipe_rtp_st2110_pack_block_input(upipe, upump_p);
+        /* Increment upipe refcount to avoid disappearing before all packets
+         * have been sent. */
+        upipe_use(upipe);
+    }
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_rtp_st2110_pack_set_flow_def(struct upipe *upipe,
+                                              struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, "pic."))
+    if (unlikely(!ubase_check(uref_pic_flow_check_chroma(flow_def, 1, 1, 2,
+                                                         "y10l")) ||
+                 !ubase_check(uref_pic_flow_check_chroma(flow_def, 2, 1, 2,
+                                                         "u10l")) ||
+                 !ubase_check(uref_pic_flow_check_chroma(flow_def, 2, 1, 2,
+                                                         "v10l"))))
+        return UBASE_ERR_INVALID;
+
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup);
+    uref_pic_flow_clear_format(flow_def_dup);
+    if (unlikely(!ubase_check(uref_flow_set_def(flow_def_dup,
+                                                "block.rtp.raw.pic.")))) {
+        uref_free(flow_def_dup);
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_rtp_st2110_pack_require_ubuf_mgr(upipe, flow_def_dup);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This provides a flow format suggestion.
+ *
+ * @param upipe description structure of the pipe
+ * @param request description structure of the request
+ * @return an error code
+ */
+static int upipe_rtp_st2110_pack_provide_flow_format(struct upipe *upipe,
+                                                     struct urequest *request)
+{
+    struct uref *flow_format = uref_dup(request->uref);
+    UBASE_ALLOC_RETURN(flow_format);
+
+    uref_pic_flow_clear_format(flow_format);
+    uref_pic_flow_set_macropixel(flow_format, 1);
+    uref_pic_flow_add_plane(flow_format, 1, 1, 2, "y10l");
+    uref_pic_flow_add_plane(flow_format, 2, 1, 2, "u10l");
+    uref_pic_flow_add_plane(flow_format, 2, 1, 2, "v10l");
+    return urequest_provide_flow_format(request, flow_format);
+}
+
+/** @internal @This processes control commands.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_rtp_st2110_pack_control(struct upipe *upipe, int command,
+                                         va_list args)
+{
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_FLOW_FORMAT)
+                return upipe_rtp_st2110_pack_provide_flow_format(upipe,
+                                                                 request);
+            if (request->type == UREQUEST_UBUF_MGR)
+                return upipe_throw_provide_request(upipe, request);
+            return upipe_rtp_st2110_pack_alloc_output_proxy(upipe, request);
+        }
+        case UPIPE_UNREGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_FLOW_FORMAT ||
+                request->type == UREQUEST_UBUF_MGR)
+                return UBASE_ERR_NONE;
+            return upipe_rtp_st2110_pack_free_output_proxy(upipe, request);
+        }
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_rtp_st2110_pack_set_flow_def(upipe, flow_def);
+        }
+
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+        case UPIPE_GET_FLOW_DEF:
+            return upipe_rtp_st2110_pack_control_output(upipe, command, args);
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This allocates a rtp_st2110_pack pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_rtp_st2110_pack_alloc(struct upipe_mgr *mgr,
+                                                 struct uprobe *uprobe,
+                                                 uint32_t signature,
+                                                 va_list args)
+{
+    struct upipe *upipe = upipe_rtp_st2110_pack_alloc_void(mgr, uprobe,
+                                                           signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_rtp_st2110_pack *upipe_rtp_st2110_pack =
+        upipe_rtp_st2110_pack_from_upipe(upipe);
+    upipe_rtp_st2110_pack_init_urefcount(upipe);
+    upipe_rtp_st2110_pack_init_ubuf_mgr(upipe);
+    upipe_rtp_st2110_pack_init_output(upipe);
+    upipe_rtp_st2110_pack_init_input(upipe);
+    upipe_rtp_st2110_pack->seqnum = 0;
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This frees all resources allocated.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_rtp_st2110_pack_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    upipe_rtp_st2110_pack_clean_input(upipe);
+    upipe_rtp_st2110_pack_clean_output(upipe);
+    upipe_rtp_st2110_pack_clean_ubuf_mgr(upipe);
+    upipe_rtp_st2110_pack_clean_urefcount(upipe);
+    upipe_rtp_st2110_pack_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_rtp_st2110_pack_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_RTP_ST2110_PACK_SIGNATURE,
+
+    .upipe_alloc = upipe_rtp_st2110_pack_alloc,
+    .upipe_input = upipe_rtp_st2110_pack_input,
+    .upipe_control = upipe_rtp_st2110_pack_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for rtp_st2110_pack pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_rtp_st2110_pack_mgr_alloc(void)
+{
+    return &upipe_rtp_st2110_pack_mgr;
+}
@@ -0,0 +1,589 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module reassembling SMPTE ST 2110-20 RTP packets into
+ * 4:2:2 10-bit pictures
+ */
+
+#include <config.h>
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uclock.h>
+#include <upipe/uref.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_pic.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_pic.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_flow.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe/upipe_helper_ubuf_mgr.h>
+
+#include <upipe-hbrmt/upipe_rtp_st2110_unpack.h>
+
+#include "sdidec.h"
+
+#include <bitstream/ietf/rtp.h>
+
+/** RTP clock rate of video */
+#define RTP_CLOCKRATE 90000
+/** size of the extended sequence number */
+#define ST2110_SEQNUM_SIZE 2
+/** size of a sample row data header */
+#define ST2110_SRD_SIZE 6
+/** size of a 4:2:2 10-bit pixel group of 2 pixels */
+#define PGROUP_SIZE 5
+
+/** @internal @This is the private context of a rtp_st2110_unpack pipe. */
+struct upipe_rtp_st2110_unpack {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** output flow definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** ubuf manager */
+    struct ubuf_mgr *ubuf_mgr;
+    /** flow format packet */
+    struct uref *flow_format;
+    /** ubuf manager request */
+    struct urequest ubuf_mgr_request;
+
+    /** horizontal size */
+    uint64_t hsize;
+    /** vertical size */
+    uint64_t vsize;
+    /** true for progressive pictures */
+    bool progressive;
+
+    /** picture being received, or NULL */
+    struct uref *uref;
+    /** RTP timestamp of the first field of the picture */
+    uint32_t timestamp;
+    /** mapped planes of the picture */
+    uint8_t *planes[3];
+    /** strides of the planes */
+    size_t strides[3];
+    /** number of pixels received */
+    uint64_t pixels;
+
+    /** expected extended sequence number */
+    uint32_t expected_seqnum;
+    /** true if no packet was received yet */
+    bool first;
+    /** number of lost packets */
+    uint64_t lost;
+
+    /** unpacking */
+    void (*unpack)(const uint8_t *src, uint16_t *y, uint16_t *u, uint16_t *v,
+                   int64_t pixels);
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+/** chroma of the planes, in the order of the samples */
+static const char *upipe_rtp_st2110_unpack_chroma[3] = {
+    "y10l", "u10l", "v10l"
+};
+
+/** @hidden */
+static int upipe_rtp_st2110_unpack_check(struct upipe *upipe,
+                                         struct uref *flow_format);
+
+UPIPE_HELPER_UPIPE(upipe_rtp_st2110_unpack, upipe,
+                   UPIPE_RTP_ST2110_UNPACK_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_rtp_st2110_unpack, urefcount,
+                       upipe_rtp_st2110_unpack_free)
+UPIPE_HELPER_FLOW(upipe_rtp_st2110_unpack, "pic.")
+UPIPE_HELPER_OUTPUT(upipe_rtp_st2110_unpack, output, flow_def, output_state,
+                    request_list)
+UPIPE_HELPER_UBUF_MGR(upipe_rtp_st2110_unpack, ubuf_mgr, flow_format,
+                      ubuf_mgr_request, upipe_rtp_st2110_unpack_check,
+                      upipe_rtp_st2110_unpack_register_output_request,
+                      upipe_rtp_st2110_unpack_unregister_output_request)
+
+/** @internal @This receives the flow format.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_rtp_st2110_unpack_check(struct upipe *upipe,
+                                         struct uref *flow_format)
+{
+    if (flow_format != NULL)
+        upipe_rtp_st2110_unpack_store_flow_def(upipe, flow_format);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This releases the picture being received, without outputting
+ * it.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_rtp_st2110_unpack_discard(struct upipe *upipe)
+{
+    struct upipe_rtp_st2110_unpack *upipe_rtp_st2110_unpack =
+        upipe_rtp_st2110_unpack_from_upipe(upipe);
+    struct uref *uref = upipe_rtp_st2110_unpack->uref;
+    if (uref == NULL)
+        return;
+    for (int i = 0; i < 3; i++)
+        uref_pic_plane_unmap(uref, upipe_rtp_st2110_unpack_chroma[i],
+                             0, 0, -1, -1);
+    uref_free(uref);
+    upipe_rtp_st2110_unpack->uref = NULL;
+}
+
+/** @internal @This outputs the picture being received.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtp_st2110_unpack_output_pic(struct upipe *upipe,
+                                               struct upump **upump_p)
+{
+    struct upipe_rtp_st2110_unpack *upipe_rtp_st2110_unpack =
+        upipe_rtp_st2110_unpack_from_upipe(upipe);
+    struct uref *uref = upipe_rtp_st2110_unpack->uref;
+    if (uref == NULL)
+        return;
+    for (int i = 0; i < 3; i++)
+        uref_pic_plane_unmap(uref, upipe_rtp_st2110_unpack_chroma[i],
+                             0, 0, -1, -1);
+    upipe_rtp_st2110_unpack->uref = NULL;
+
+    uint64_t total = upipe_rtp_st2110_unpack->hsize *
+                     upipe_rtp_st2110_unpack->vsize;
+    if (unlikely(upipe_rtp_st2110_unpack->pixels < total))
+        upipe_warn_va(upipe, "incomplete picture (%"PRIu64"/%"PRIu64" pixels)",
+                      upipe_rtp_st2110_unpack->pixels, total);
+
+    upipe_throw_clock_ts(upipe, uref);
+    upipe_rtp_st2110_unpack_output(upipe, uref, upump_p);
+}
+
+/** @internal @This starts a new picture.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref first packet of the picture, whose attributes are copied
+ * @param timestamp RTP timestamp
+ * @return an error code
+ */
+static int upipe_rtp_st2110_unpack_start(struct upipe *upipe,
+                                         struct uref *uref,
+                                         uint32_t timestamp)
+{
+    struct upipe_rtp_st2110_unpack *upipe_rtp_st2110_unpack =
+        upipe_rtp_st2110_unpack_from_upipe(upipe);
+    struct ubuf *ubuf = ubuf_pic_alloc(upipe_rtp_st2110_unpack->ubuf_mgr,
+                                       upipe_rtp_st2110_unpack->hsize,
+                                       upipe_rtp_st2110_unpack->vsize);
+    UBASE_ALLOC_RETURN(ubuf);
+
+    for (int i = 0; i < 3; i++) {
+        const char *chroma = upipe_rtp_st2110_unpack_chroma[i];
+        if (unlikely(!ubase_check(ubuf_pic_plane_size(ubuf, chroma,
+                            &upipe_rtp_st2110_unpack->strides[i],
+                            NULL, NULL, NULL)) ||
+                     !ubase_check(ubuf_pic_plane_write(ubuf, chroma,
+                            0, 0, -1, -1,
+                            &upipe_rtp_st2110_unpack->planes[i])))) {
+            for (int j = 0; j < i; j++)
+                ubuf_pic_plane_unmap(ubuf, upipe_rtp_st2110_unpack_chroma[j],
+                                     0, 0, -1, -1);
+            ubuf_free(ubuf);
+            return UBASE_ERR_INVALID;
+        }
+    }
+
+    struct uref *pic = uref_fork(uref, ubuf);
+    if (unlikely(pic == NULL)) {
+        for (int i = 0; i < 3; i++)
+            ubuf_pic_plane_unmap(ubuf, upipe_rtp_st2110_unpack_chroma[i],
+                                 0, 0, -1, -1);
+        ubuf_free(ubuf);
+        return UBASE_ERR_ALLOC;
+    }
+
+    uref_clock_set_pts_orig(pic,
+            (uint64_t)timestamp * UCLOCK_FREQ / RTP_CLOCKRATE);
+    uref_clock_set_dts_pts_delay(pic, 0);
+    if (upipe_rtp_st2110_unpack->progressive)
+        uref_pic_set_progressive(pic);
+    else
+        uref_pic_set_tff(pic);
+    uref_pic_set_tf(pic);
+    uref_pic_set_bf(pic);
+
+    upipe_rtp_st2110_unpack->uref = pic;
+    upipe_rtp_st2110_unpack->timestamp = timestamp;
+    upipe_rtp_st2110_unpack->pixels = 0;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This unpacks the segments of a packet into the picture.
+ *
+ * @param upipe description structure of the pipe
+ * @param payload payload, after the extended sequence number
+ * @param size size of the payload
+ * @param field_p filled in with the field of the last segment
+ * @return false if the payload is invalid
+ */
+static bool upipe_rtp_st2110_unpack_segments(struct upipe *upipe,
+                                             const uint8_t *payload,
+                                             size_t size, bool *field_p)
+{
+    struct upipe_rtp_st2110_unpack *upipe_rtp_st2110_unpack =
+        upipe_rtp_st2110_unpack_from_upipe(upipe);
+    const uint8_t *srd = payload;
+    const uint8_t *headers_end;
+    const uint8_t *data;
+    bool more;
+
+    /* the data of the segments follows all the headers */
+    do {
+        if (unlikely(srd + ST2110_SRD_SIZE > payload + size))
+            return false;
+        more = srd[4] & 0x80;
+        srd += ST2110_SRD_SIZE;
+    } while (more);
+    headers_end = data = srd;
+
+    for (srd = payload; srd < headers_end; srd += ST2110_SRD_SIZE) {
+        size_t length = (srd[0] << 8) | srd[1];
+        bool field = srd[2] & 0x80;
+        uint64_t row = ((srd[2] & 0x7f) << 8) | srd[3];
+        uint64_t offset = ((srd[4] & 0x7f) << 8) | srd[5];
+        uint64_t pixels = length / PGROUP_SIZE * 2;
+        *field_p = field;
+
+        uint64_t line = row;
+        if (!upipe_rtp_st2110_unpack->progressive)
+            line = 2 * row + field;
+        if (unlikely(data + length > payload + size ||
+                     length % PGROUP_SIZE || offset % 2 ||
+                     line >= upipe_rtp_st2110_unpack->vsize ||
+                     offset + pixels > upipe_rtp_st2110_unpack->hsize))
+            return false;
+
+        uint16_t *y = (uint16_t *)(upipe_rtp_st2110_unpack->planes[0] +
+                                   line * upipe_rtp_st2110_unpack->strides[0]);
+        uint16_t *u = (uint16_t *)(upipe_rtp_st2110_unpack->planes[1] +
+                                   line * upipe_rtp_st2110_unpack->strides[1]);
+        uint16_t *v = (uint16_t *)(upipe_rtp_st2110_unpack->planes[2] +
+                                   line * upipe_rtp_st2110_unpack->strides[2]);
+        upipe_rtp_st2110_unpack->unpack(data, y + offset, u + offset / 2,
+                                        v + offset / 2, pixels);
+        upipe_rtp_st2110_unpack->pixels += pixels;
+        data += length;
+    }
+    return true;
+}
+
+/** @internal @This receives RTP packets.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtp_st2110_unpack_input(struct upipe *upipe,
+                                          struct uref *uref,
+                                          struct upump **upump_p)
+{
+    struct upipe_rtp_st2110_unpack *upipe_rtp_st2110_unpack =
+        upipe_rtp_st2110_unpack_from_upipe(upipe);
+    if (unlikely(upipe_rtp_st2110_unpack->ubuf_mgr == NULL)) {
+        upipe_warn(upipe, "no ubuf manager, dropping packet");
+        uref_free(uref);
+        return;
+    }
+
+    size_t size;
+    const uint8_t *buffer;
+    int read_size = -1;
+    if (unlikely(!ubase_check(uref_block_size(uref, &size)) ||
+                 size < RTP_HEADER_SIZE + ST2110_SEQNUM_SIZE ||
+                 !ubase_check(uref_block_read(uref, 0, &read_size,
+                                              &buffer)))) {
+        upipe_warn(upipe, "invalid buffer received");
+        uref_free(uref);
+        return;
+    }
+    if (unlikely(read_size < size)) {
+        /* packets from udpsrc and xdpsrc are contiguous */
+        upipe_warn(upipe, "segmented packet received");
+        uref_block_unmap(uref, 0);
+        uref_free(uref);
+        return;
+    }
+
+    size_t offset = RTP_HEADER_SIZE + 4 * rtp_get_cc(buffer);
+    if (rtp_check_extension(buffer)) {
+        if (offset + RTP_EXTENSION_SIZE <= size)
+            offset += 4 * (1 + rtpx_get_length(buffer + offset));
+        else
+            offset = SIZE_MAX;
+    }
+    if (rtp_check_padding(buffer))
+        size -= buffer[size - 1];
+    if (unlikely(!rtp_check_hdr(buffer) ||
+                 offset > size - ST2110_SEQNUM_SIZE)) {
+        upipe_warn(upipe, "invalid RTP header");
+        uref_block_unmap(uref, 0);
+        uref_free(uref);
+        return;
+    }
+
+    const uint8_t *payload = buffer + offset;
+    uint32_t seqnum = ((payload[0] << 24) | (payload[1] << 16)) |
+                      rtp_get_seqnum(buffer);
+    if (upipe_rtp_st2110_unpack->first) {
+        upipe_rtp_st2110_unpack->first = false;
+        upipe_rtp_st2110_unpack->expected_seqnum = seqnum;
+    }
+    uint32_t gap = seqnum - upipe_rtp_st2110_unpack->expected_seqnum;
+    if (likely(gap < UINT32_C(0x80000000))) {
+        if (unlikely(gap)) {
+            upipe_dbg_va(upipe, "potentially lost %"PRIu32" RTP packets", gap);
+            upipe_rtp_st2110_unpack->lost += gap;
+        }
+        upipe_rtp_st2110_unpack->expected_seqnum = seqnum + 1;
+    } else if (upipe_rtp_st2110_unpack->lost) {
+        /* reordered packet previously counted as lost */
+        upipe_rtp_st2110_unpack->lost--;
+    }
+
+    /* a packet of the second field may have the timestamp of that field */
+    uint32_t timestamp = rtp_get_timestamp(buffer);
+    payload += ST2110_SEQNUM_SIZE;
+    bool second_field = !upipe_rtp_st2110_unpack->progressive &&
+                        ST2110_SRD_SIZE <= buffer + size - payload &&
+                        (payload[2] & 0x80);
+    if (upipe_rtp_st2110_unpack->uref != NULL && !second_field &&
+        timestamp != upipe_rtp_st2110_unpack->timestamp)
+        upipe_rtp_st2110_unpack_output_pic(upipe, upump_p);
+
+    if (upipe_rtp_st2110_unpack->uref == NULL) {
+        int err = upipe_rtp_st2110_unpack_start(upipe, uref, timestamp);
+        if (unlikely(!ubase_check(err))) {
+            uref_block_unmap(uref, 0);
+            uref_free(uref);
+            upipe_throw_fatal(upipe, err);
+            return;
+        }
+    }
+
+    bool field = false;
+    if (unlikely(!upipe_rtp_st2110_unpack_segments(upipe, payload,
+                                                   buffer + size - payload,
+                                                   &field)))
+        upipe_warn(upipe, "invalid payload");
+
+    bool marker = rtp_check_marker(buffer);
+    uref_block_unmap(uref, 0);
+    uref_free(uref);
+
+    if (marker && (upipe_rtp_st2110_unpack->progressive || field))
+        upipe_rtp_st2110_unpack_output_pic(upipe, upump_p);
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_rtp_st2110_unpack_set_flow_def(struct upipe *upipe,
+                                                struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, "block."))
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_rtp_st2110_unpack_control(struct upipe *upipe, int command,
+                                           va_list args)
+{
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_FLOW_FORMAT ||
+                request->type == UREQUEST_UBUF_MGR)
+                return upipe_throw_provide_request(upipe, request);
+            return upipe_rtp_st2110_unpack_alloc_output_proxy(upipe, request);
+        }
+        case UPIPE_UNREGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_FLOW_FORMAT ||
+                request->type == UREQUEST_UBUF_MGR)
+                return UBASE_ERR_NONE;
+            return upipe_rtp_st2110_unpack_free_output_proxy(upipe, request);
+        }
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_rtp_st2110_unpack_set_flow_def(upipe, flow_def);
+        }
+        case UPIPE_FLUSH:
+            upipe_rtp_st2110_unpack_discard(upipe);
+            return UBASE_ERR_NONE;
+
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+        case UPIPE_GET_FLOW_DEF:
+            return upipe_rtp_st2110_unpack_control_output(upipe, command,
+                                                          args);
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This allocates a rtp_st2110_unpack pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_rtp_st2110_unpack_alloc(struct upipe_mgr *mgr,
+                                                   struct uprobe *uprobe,
+                                                   uint32_t signature,
+                                                   va_list args)
+{
+    struct uref *flow_def;
+    struct upipe *upipe = upipe_rtp_st2110_unpack_alloc_flow(mgr, uprobe,
+            signature, args, &flow_def);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_rtp_st2110_unpack *upipe_rtp_st2110_unpack =
+        upipe_rtp_st2110_unpack_from_upipe(upipe);
+    upipe_rtp_st2110_unpack_init_urefcount(upipe);
+    upipe_rtp_st2110_unpack_init_output(upipe);
+    upipe_rtp_st2110_unpack_init_ubuf_mgr(upipe);
+    upipe_rtp_st2110_unpack->uref = NULL;
+    upipe_rtp_st2110_unpack->first = true;
+    upipe_rtp_st2110_unpack->expected_seqnum = 0;
+    upipe_rtp_st2110_unpack->lost = 0;
+
+    upipe_rtp_st2110_unpack->unpack = upipe_sdi_to_planar10_c;
+#if defined(__i686__) || defined(__x86_64__)
+    if (__builtin_cpu_supports("ssse3"))
+        upipe_rtp_st2110_unpack->unpack = upipe_sdi_to_planar10_ssse3;
+    if (__builtin_cpu_supports("avx2"))
+        upipe_rtp_st2110_unpack->unpack = upipe_sdi_to_planar10_avx2;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    upipe_rtp_st2110_unpack->unpack = upipe_sdi_to_planar10_neon;
+#endif
+
+    upipe_throw_ready(upipe);
+
+    if (unlikely(!ubase_check(uref_pic_flow_get_hsize(flow_def,
+                        &upipe_rtp_st2110_unpack->hsize)) ||
+                 !ubase_check(uref_pic_flow_get_vsize(flow_def,
+                        &upipe_rtp_st2110_unpack->vsize)) ||
+                 upipe_rtp_st2110_unpack->hsize % 2 ||
+                 !upipe_rtp_st2110_unpack->vsize)) {
+        upipe_err(upipe, "invalid picture size");
+        uref_free(flow_def);
+        upipe_release(upipe);
+        return NULL;
+    }
+    upipe_rtp_st2110_unpack->progressive =
+        ubase_check(uref_pic_get_progressive(flow_def));
+
+    uref_pic_flow_clear_format(flow_def);
+    if (unlikely(!ubase_check(uref_flow_set_def(flow_def, "pic.")) ||
+                 !ubase_check(uref_pic_flow_set_macropixel(flow_def, 1)) ||
+                 !ubase_check(uref_pic_flow_add_plane(flow_def, 1, 1, 2,
+                                                      "y10l")) ||
+                 !ubase_check(uref_pic_flow_add_plane(flow_def, 2, 1, 2,
+                                                      "u10l")) ||
+                 !ubase_check(uref_pic_flow_add_plane(flow_def, 2, 1, 2,
+                                                      "v10l")) ||
+                 !ubase_check(uref_pic_flow_set_align(flow_def, 32)))) {
+        uref_free(flow_def);
+        upipe_release(upipe);
+        return NULL;
+    }
+    upipe_rtp_st2110_unpack_require_ubuf_mgr(upipe, flow_def);
+    return upipe;
+}
+
+/** @internal @This frees all resources allocated.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_rtp_st2110_unpack_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    upipe_rtp_st2110_unpack_discard(upipe);
+    upipe_rtp_st2110_unpack_clean_ubuf_mgr(upipe);
+    upipe_rtp_st2110_unpack_clean_output(upipe);
+    upipe_rtp_st2110_unpack_clean_urefcount(upipe);
+    upipe_rtp_st2110_unpack_free_flow(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_rtp_st2110_unpack_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_RTP_ST2110_UNPACK_SIGNATURE,
+
+    .upipe_alloc = upipe_rtp_st2110_unpack_alloc,
+    .upipe_input = upipe_rtp_st2110_unpack_input,
+    .upipe_control = upipe_rtp_st2110_unpack_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for rtp_st2110_unpack pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_rtp_st2110_unpack_mgr_alloc(void)
+{
+    return &upipe_rtp_st2110_unpack_mgr;
+}
@@ -343,6 +343,14 @@ static struct upipe *upipe_unpack10bit_alloc(struct upipe_mgr *mgr,
 #endif
 #endif
 
+#if defined(__i686__) || defined(__x86_64__)
+    if (__builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512vl"))
+        upipe_unpack10bit->unpack = upipe_sdi_to_uyvy_avx512;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    upipe_unpack10bit->unpack = upipe_sdi_to_uyvy_neon;
+#endif
+
     upipe_unpack10bit_init_urefcount(upipe);
     upipe_unpack10bit_init_ubuf_mgr(upipe);
     upipe_unpack10bit_init_output(upipe);
@@ -23,6 +23,7 @@
 
 #include <upipe-hls/upipe_hls_master.h>
 #include <upipe-hls/upipe_hls_variant.h>
+#include <upipe-hls/upipe_hls_playlist.h>
 
 #include <upipe-hls/uref_hls.h>
 
@@ -44,6 +45,8 @@
 #include <upipe/uprobe_prefix.h>
 
 #define EXPECTED_FLOW_DEF       "block.m3u.master."
+/** percentage of the throughput estimate a higher variant may use */
+#define ADAPTIVE_UP_RATIO       80
 
 /** @internal @This is the private context of a sub master pipe. */
 struct upipe_hls_master_sub {
@@ -65,8 +68,17 @@ struct upipe_hls_master_sub {
     struct upipe *output;
     /** flow definition */
     struct uref *flow_def;
+    /** switch variants on the throughput estimates */
+    bool adaptive;
+    /** last throughput estimate */
+    uint64_t bandwidth;
 };
 
+/** @hidden */
+static int upipe_hls_master_sub_catch(struct uprobe *uprobe,
+                                      struct upipe *inner,
+                                      int event, va_list args);
+
 UPIPE_HELPER_UPIPE(upipe_hls_master_sub, upipe, UPIPE_HLS_MASTER_SUB_SIGNATURE);
 UPIPE_HELPER_UREFCOUNT(upipe_hls_master_sub, urefcount,
                        upipe_hls_master_sub_no_ref);
@@ -74,7 +86,7 @@ UPIPE_HELPER_UREFCOUNT_REAL(upipe_hls_master_sub, urefcount_real,
                             upipe_hls_master_sub_free);
 UPIPE_HELPER_FLOW(upipe_hls_master_sub, NULL);
 UPIPE_HELPER_UPROBE(upipe_hls_master_sub, urefcount_real,
-                    last_inner_probe, NULL);
+                    last_inner_probe, upipe_hls_master_sub_catch);
 UPIPE_HELPER_INNER(upipe_hls_master_sub, last_inner);
 UPIPE_HELPER_BIN_OUTPUT(upipe_hls_master_sub, last_inner, output, requests);
 
@@ -139,6 +151,8 @@ static struct upipe *upipe_hls_master_sub_alloc(struct upipe_mgr *mgr,
     struct upipe_hls_master_sub *upipe_hls_master_sub =
         upipe_hls_master_sub_from_upipe(upipe);
     upipe_hls_master_sub->flow_def = flow_def;
+    upipe_hls_master_sub->adaptive = false;
+    upipe_hls_master_sub->bandwidth = 0;
 
     upipe_throw_ready(upipe);
 
@@ -188,6 +202,125 @@ static void upipe_hls_master_sub_no_ref(struct upipe *upipe)
     upipe_hls_master_sub_release_urefcount_real(upipe);
 }
 
+/** @internal @This switches the sub pipe to another variant.
+ *
+ * @param upipe description structure of the pipe
+ * @param variant the variant to play
+ * @return an error code
+ */
+static int _upipe_hls_master_sub_switch(struct upipe *upipe,
+                                        struct uref *variant)
+{
+    struct upipe_hls_master_sub *upipe_hls_master_sub =
+        upipe_hls_master_sub_from_upipe(upipe);
+    uint64_t id, current;
+
+    if (unlikely(variant == NULL) ||
+        unlikely(!ubase_check(uref_flow_get_id(variant, &id))))
+        return UBASE_ERR_INVALID;
+    if (ubase_check(uref_flow_get_id(upipe_hls_master_sub->flow_def,
+                                     &current)) && current == id)
+        return UBASE_ERR_NONE;
+    if (unlikely(upipe_hls_master_sub->last_inner == NULL))
+        return UBASE_ERR_INVALID;
+
+    struct uref *flow_def = uref_dup(variant);
+    UBASE_ALLOC_RETURN(flow_def);
+    int ret = upipe_hls_variant_play(upipe_hls_master_sub->last_inner,
+                                     flow_def);
+    if (unlikely(!ubase_check(ret))) {
+        uref_free(flow_def);
+        return ret;
+    }
+    uref_free(upipe_hls_master_sub->flow_def);
+    upipe_hls_master_sub->flow_def = flow_def;
+    upipe_notice_va(upipe, "switched to variant %"PRIu64, id);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This selects the variant sustained by a throughput estimate.
+ * The current variant is kept as long as the estimate covers its bandwidth,
+ * and a higher variant must fit in a share of the estimate. The lowest
+ * variant is selected when none fits.
+ *
+ * @param upipe description structure of the pipe
+ * @param bandwidth throughput estimate in bits per second
+ * @return the selected variant or NULL
+ */
+static struct uref *upipe_hls_master_sub_select(struct upipe *upipe,
+                                                uint64_t bandwidth)
+{
+    struct upipe_hls_master_sub *upipe_hls_master_sub =
+        upipe_hls_master_sub_from_upipe(upipe);
+    struct upipe_hls_master *upipe_hls_master =
+        upipe_hls_master_from_sub_mgr(upipe->mgr);
+    uint64_t current = 0;
+    uref_m3u_master_get_bandwidth(upipe_hls_master_sub->flow_def, &current);
+
+    struct uref *selected = NULL, *lowest = NULL;
+    uint64_t selected_bandwidth = 0, lowest_bandwidth = UINT64_MAX;
+    struct uchain *uchain;
+    ulist_foreach(&upipe_hls_master->items, uchain) {
+        struct uref *variant = uref_from_uchain(uchain);
+        uint64_t variant_bandwidth;
+        if (!ubase_check(uref_m3u_master_get_bandwidth(variant,
+                                                       &variant_bandwidth)))
+            continue;
+
+        if (variant_bandwidth < lowest_bandwidth) {
+            lowest = variant;
+            lowest_bandwidth = variant_bandwidth;
+        }
+
+        bool fits = variant_bandwidth <= current ?
+            variant_bandwidth <= bandwidth :
+            variant_bandwidth / ADAPTIVE_UP_RATIO <= bandwidth / 100;
+        if (fits && (selected == NULL ||
+                     variant_bandwidth > selected_bandwidth)) {
+            selected = variant;
+            selected_bandwidth = variant_bandwidth;
+        }
+    }
+    return selected != NULL ? selected : lowest;
+}
+
+/** @internal @This catches the events of the variant inner pipe, and
+ * switches variant on the throughput estimates when adaptive.
+ *
+ * @param uprobe structure used to raise events
+ * @param inner pointer to inner pipe
+ * @param event event thrown
+ * @param args optional arguments
+ * @return an error code
+ */
+static int upipe_hls_master_sub_catch(struct uprobe *uprobe,
+                                      struct upipe *inner,
+                                      int event, va_list args)
+{
+    struct upipe_hls_master_sub *upipe_hls_master_sub =
+        upipe_hls_master_sub_from_last_inner_probe(uprobe);
+    struct upipe *upipe = upipe_hls_master_sub_to_upipe(upipe_hls_master_sub);
+
+    if (event == UPROBE_HLS_PLAYLIST_BANDWIDTH &&
+        ubase_get_signature(args) == UPIPE_HLS_PLAYLIST_SIGNATURE) {
+        va_list args_copy;
+        va_copy(args_copy, args);
+        va_arg(args_copy, uint32_t);
+        uint64_t bandwidth = va_arg(args_copy, uint64_t);
+        va_end(args_copy);
+
+        upipe_hls_master_sub->bandwidth = bandwidth;
+        if (upipe_hls_master_sub->adaptive) {
+            struct uref *variant =
+                upipe_hls_master_sub_select(upipe, bandwidth);
+            if (variant != NULL &&
+                !ubase_check(_upipe_hls_master_sub_switch(upipe, variant)))
+                upipe_warn(upipe, "fail to switch variant");
+        }
+    }
+    return upipe_throw_proxy(upipe, inner, event, args);
+}
+
 /** @internal @This dispatches commands to the pipe.
  *
  * @param upipe description structure of the pipe
@@ -199,8 +332,36 @@ static int upipe_hls_master_sub_control(struct upipe *upipe,
                                         int command,
                                         va_list args)
 {
+    struct upipe_hls_master_sub *upipe_hls_master_sub =
+        upipe_hls_master_sub_from_upipe(upipe);
+
     UBASE_HANDLED_RETURN(
         upipe_hls_master_sub_control_super(upipe, command, args));
+
+    /* the other local commands are for the variant pipe */
+    if (command >= UPIPE_CONTROL_LOCAL &&
+        ubase_get_signature(args) == UPIPE_HLS_MASTER_SUB_SIGNATURE) {
+        switch (command) {
+            case UPIPE_HLS_MASTER_SUB_SWITCH: {
+                UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_MASTER_SUB_SIGNATURE);
+                struct uref *variant = va_arg(args, struct uref *);
+                return _upipe_hls_master_sub_switch(upipe, variant);
+            }
+            case UPIPE_HLS_MASTER_SUB_SET_ADAPTIVE: {
+                UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_MASTER_SUB_SIGNATURE);
+                upipe_hls_master_sub->adaptive = !!va_arg(args, int);
+                return UBASE_ERR_NONE;
+            }
+            case UPIPE_HLS_MASTER_SUB_GET_BANDWIDTH: {
+                UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_MASTER_SUB_SIGNATURE);
+                uint64_t *bandwidth_p = va_arg(args, uint64_t *);
+                if (bandwidth_p != NULL)
+                    *bandwidth_p = upipe_hls_master_sub->bandwidth;
+                return UBASE_ERR_NONE;
+            }
+        }
+        return UBASE_ERR_UNHANDLED;
+    }
     return upipe_hls_master_sub_control_bin_output(upipe, command, args);
 }
 
@@ -217,6 +378,8 @@ static void upipe_hls_master_init_sub_mgr(struct upipe *upipe)
     upipe_hls_master->sub_mgr.signature = UPIPE_HLS_MASTER_SUB_SIGNATURE;
     upipe_hls_master->sub_mgr.upipe_alloc = upipe_hls_master_sub_alloc;
     upipe_hls_master->sub_mgr.upipe_control = upipe_hls_master_sub_control;
+    upipe_hls_master->sub_mgr.upipe_command_str =
+        upipe_hls_master_sub_command_str;
 }
 
 /** @internal @This allocates a master pipe.
@@ -30,6 +30,7 @@
 #include <upipe-modules/uref_aes_flow.h>
 #include <upipe-modules/upipe_probe_uref.h>
 #include <upipe-modules/upipe_setflowdef.h>
+#include <upipe-modules/upipe_http_source.h>
 
 #include <upipe/upipe_helper_inner.h>
 #include <upipe/upipe_helper_uprobe.h>
@@ -63,6 +64,12 @@
 
 /** @showvalue */
 #define EXPECTED_FLOW_DEF "block.m3u.playlist."
+/** downloads smaller than this are mostly latency and are not measured */
+#define BANDWIDTH_MIN_SIZE      (16 * 1024)
+/** weight of a new sample in the fast average, as a power of 2 */
+#define BANDWIDTH_FAST_SHIFT    1
+/** weight of a new sample in the slow average, as a power of 2 */
+#define BANDWIDTH_SLOW_SHIFT    3
 
 static int upipe_hls_playlist_throw_need_reload(struct upipe *upipe)
 {
@@ -85,6 +92,14 @@ static int upipe_hls_playlist_throw_item_end(struct upipe *upipe)
                        UPIPE_HLS_PLAYLIST_SIGNATURE);
 }
 
+static int upipe_hls_playlist_throw_bandwidth(struct upipe *upipe,
+                                              uint64_t bandwidth)
+{
+    upipe_verbose_va(upipe, "throw bandwidth %"PRIu64" bit/s", bandwidth);
+    return upipe_throw(upipe, UPROBE_HLS_PLAYLIST_BANDWIDTH,
+                       UPIPE_HLS_PLAYLIST_SIGNATURE, bandwidth);
+}
+
 /** @internal @This is the private context of a m3u playlist pipe. */
 struct upipe_hls_playlist {
     /** for urefcount helper */
@@ -99,6 +114,8 @@ struct upipe_hls_playlist {
     struct uref *flow_def;
     /** playlist */
     struct uchain items;
+    /** number of complete segments in the playlist */
+    uint64_t nb_segments;
     /** source manager */
     struct upipe_mgr *source_mgr;
     /** request list */
@@ -121,6 +138,8 @@ struct upipe_hls_playlist {
     struct uprobe probe_key_src;
     /** key probe */
     struct uprobe probe_key;
+    /** probe for prefetch sources and sinks */
+    struct uprobe probe_prefetch;
 
     /** upump manager */
     struct upump_mgr *upump_mgr;
@@ -129,6 +148,12 @@ struct upipe_hls_playlist {
 
     /** current index in the playlist */
     uint64_t index;
+    /** the current item is played by partial segments */
+    bool parts;
+    /** index of the partial segment to play in the current item */
+    uint64_t part;
+    /** waiting for the next partial segment to be listed */
+    bool waiting;
     /** reloading */
     bool reloading;
     /** output size for src */
@@ -144,14 +169,47 @@ struct upipe_hls_playlist {
     bool attach_uclock;
     /** is currently playing */
     bool playing;
+    /** number of items to prefetch */
+    unsigned int prefetch;
+    /** list of prefetched items */
+    struct uchain prefetches;
+    /** fast moving average of the throughput in bits per second */
+    uint64_t bandwidth_fast;
+    /** slow moving average of the throughput in bits per second */
+    uint64_t bandwidth_slow;
+};
+
+/** @internal @This is the context of an item downloaded ahead of the
+ * playing one. */
+struct upipe_hls_playlist_prefetch {
+    /** for the prefetched items list */
+    struct uchain uchain;
+    /** media sequence of the item */
+    uint64_t index;
+    /** source pipe */
+    struct upipe *src;
+    /** probe uref pipe retaining the source output */
+    struct upipe *sink;
+    /** flow definition of the source output */
+    struct uref *flow_def;
+    /** retained urefs */
+    struct uchain urefs;
+    /** the source has reached the end of the item */
+    bool end;
+    /** the source has failed */
+    bool failed;
 };
 
+UBASE_FROM_TO(upipe_hls_playlist_prefetch, uchain, uchain, uchain);
+
 static int probe_key_src(struct uprobe *uprobe, struct upipe *inner,
                          int event, va_list args);
 static int probe_key(struct uprobe *uprobe, struct upipe *inner,
                      int event, va_list args);
 static int probe_src(struct uprobe *uprobe, struct upipe *inner,
                      int event, va_list args);
+static int probe_prefetch(struct uprobe *uprobe, struct upipe *inner,
+                          int event, va_list args);
 
 UPIPE_HELPER_UPIPE(upipe_hls_playlist, upipe, UPIPE_HLS_PLAYLIST_SIGNATURE);
 UPIPE_HELPER_UREFCOUNT(upipe_hls_playlist, urefcount, upipe_hls_playlist_no_ref);
@@ -165,11 +223,73 @@ UPIPE_HELPER_UPROBE(upipe_hls_playlist, urefcount_real,
                     probe_key_src, probe_key_src);
 UPIPE_HELPER_UPROBE(upipe_hls_playlist, urefcount_real, probe_key, probe_key);
 UPIPE_HELPER_UPROBE(upipe_hls_playlist, urefcount_real, probe_src, probe_src);
+UPIPE_HELPER_UPROBE(upipe_hls_playlist, urefcount_real,
+                    probe_prefetch, probe_prefetch);
 UPIPE_HELPER_UPROBE(upipe_hls_playlist, urefcount_real, probe_setflowdef, NULL);
 UPIPE_HELPER_BIN_OUTPUT(upipe_hls_playlist, setflowdef, output, requests);
 UPIPE_HELPER_UPUMP_MGR(upipe_hls_playlist, upump_mgr);
 UPIPE_HELPER_UPUMP(upipe_hls_playlist, upump, upump_mgr);
 
+/** @internal @This gets the estimated throughput.
+ *
+ * @param upipe description structure of the pipe
+ * @param bandwidth_p filled with the estimate in bits per second
+ * @return an error code
+ */
+static int _upipe_hls_playlist_get_bandwidth(struct upipe *upipe,
+                                             uint64_t *bandwidth_p)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+    if (likely(bandwidth_p != NULL))
+        *bandwidth_p = upipe_hls_playlist->bandwidth_fast <
+                       upipe_hls_playlist->bandwidth_slow ?
+                       upipe_hls_playlist->bandwidth_fast :
+                       upipe_hls_playlist->bandwidth_slow;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This updates the throughput estimate with the download of an
+ * item.
+ *
+ * @param upipe description structure of the pipe
+ * @param event event thrown by the source pipe
+ * @param args optional arguments of the event
+ * @return an error code
+ */
+static int upipe_hls_playlist_measure(struct upipe *upipe,
+                                      int event, va_list args)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+
+    UBASE_SIGNATURE_CHECK(args, UPIPE_HTTP_SRC_SIGNATURE);
+    uint64_t size = va_arg(args, uint64_t);
+    uint64_t duration = va_arg(args, uint64_t);
+    if (size < BANDWIDTH_MIN_SIZE || !duration)
+        return UBASE_ERR_NONE;
+
+    uint64_t sample = size * 8 * UCLOCK_FREQ / duration;
+    upipe_dbg_va(upipe, "downloaded %"PRIu64" octets at %"PRIu64" kbit/s",
+                 size, sample / 1000);
+    if (!upipe_hls_playlist->bandwidth_slow) {
+        upipe_hls_playlist->bandwidth_fast = sample;
+        upipe_hls_playlist->bandwidth_slow = sample;
+    }
+    else {
+        upipe_hls_playlist->bandwidth_fast +=
+            (sample >> BANDWIDTH_FAST_SHIFT) -
+            (upipe_hls_playlist->bandwidth_fast >> BANDWIDTH_FAST_SHIFT);
+        upipe_hls_playlist->bandwidth_slow +=
+            (sample >> BANDWIDTH_SLOW_SHIFT) -
+            (upipe_hls_playlist->bandwidth_slow >> BANDWIDTH_SLOW_SHIFT);
+    }
+
+    uint64_t bandwidth;
+    _upipe_hls_playlist_get_bandwidth(upipe, &bandwidth);
+    return upipe_hls_playlist_throw_bandwidth(upipe, bandwidth);
+}
+
 /** @internal @This catches the inner key source pipe event.
  *
  * @param uprobe structure used to raise events
@@ -262,6 +382,104 @@ static int probe_src(struct uprobe *uprobe, struct upipe *inner,
         upipe_hls_playlist->playing = false;
         return upipe_hls_playlist_throw_item_end(upipe);
     }
+    if (event >= UPROBE_LOCAL &&
+        ubase_get_signature(args) == UPIPE_HTTP_SRC_SIGNATURE &&
+        event == UPROBE_HTTP_SRC_DOWNLOADED)
+        return upipe_hls_playlist_measure(upipe, event, args);
+    return upipe_throw_proxy(upipe, inner, event, args);
+}
+
+/** @internal @This finds the prefetched item using an inner pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param inner source or sink pipe of the prefetched item
+ * @return a pointer to the prefetched item or NULL
+ */
+static struct upipe_hls_playlist_prefetch *
+upipe_hls_playlist_find_prefetch(struct upipe *upipe, struct upipe *inner)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+    struct uchain *uchain;
+    ulist_foreach(&upipe_hls_playlist->prefetches, uchain) {
+        struct upipe_hls_playlist_prefetch *prefetch =
+            upipe_hls_playlist_prefetch_from_uchain(uchain);
+        if (inner != NULL &&
+            (prefetch->src == inner || prefetch->sink == inner))
+            return prefetch;
+    }
+    return NULL;
+}
+
+/** @internal @This catches the events of the prefetch sources and sinks.
+ *
+ * @param uprobe structure used to raise events
+ * @param inner the inner pipe
+ * @param event event thrown
+ * @param args optional arguments
+ * @return an error code
+ */
+static int probe_prefetch(struct uprobe *uprobe, struct upipe *inner,
+                          int event, va_list args)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_probe_prefetch(uprobe);
+    struct upipe *upipe = upipe_hls_playlist_to_upipe(upipe_hls_playlist);
+
+    /* the prefetched item is now playing */
+    if (inner != NULL && inner == upipe_hls_playlist->src)
+        return probe_src(&upipe_hls_playlist->probe_src, inner, event, args);
+
+    struct upipe_hls_playlist_prefetch *prefetch =
+        upipe_hls_playlist_find_prefetch(upipe, inner);
+    if (prefetch == NULL)
+        return upipe_throw_proxy(upipe, inner, event, args);
+
+    switch (event) {
+    case UPROBE_PROBE_UREF: {
+        if (inner != prefetch->sink)
+            break;
+        UBASE_SIGNATURE_CHECK(args, UPIPE_PROBE_UREF_SIGNATURE);
+        struct uref *uref = va_arg(args, struct uref *);
+        va_arg(args, struct upump **);
+        bool *drop = va_arg(args, bool *);
+        *drop = true;
+
+        struct uref *dup = uref_dup(uref);
+        UBASE_ALLOC_RETURN(dup);
+        ulist_add(&prefetch->urefs, uref_to_uchain(dup));
+        return UBASE_ERR_NONE;
+    }
+    case UPROBE_NEW_FLOW_DEF: {
+        if (inner != prefetch->sink)
+            break;
+        struct uref *flow_def = va_arg(args, struct uref *);
+        uref_free(prefetch->flow_def);
+        prefetch->flow_def = uref_dup(flow_def);
+        UBASE_ALLOC_RETURN(prefetch->flow_def);
+        return UBASE_ERR_NONE;
+    }
+    case UPROBE_NEED_OUTPUT:
+        if (inner != prefetch->sink)
+            break;
+        return UBASE_ERR_INVALID;
+    case UPROBE_SOURCE_END:
+        upipe_dbg_va(upipe, "item sequence %"PRIu64" prefetched",
+                     prefetch->index);
+        prefetch->end = true;
+        return UBASE_ERR_NONE;
+    case UPROBE_HTTP_SRC_DOWNLOADED:
+        if (inner != prefetch->src ||
+            ubase_get_signature(args) != UPIPE_HTTP_SRC_SIGNATURE)
+            break;
+        return upipe_hls_playlist_measure(upipe, event, args);
+    case UPROBE_FATAL:
+    case UPROBE_ERROR:
+        upipe_warn_va(upipe, "prefetch of item sequence %"PRIu64" failed",
+                      prefetch->index);
+        prefetch->failed = true;
+        return UBASE_ERR_NONE;
+    }
     return upipe_throw_proxy(upipe, inner, event, args);
 }
 
@@ -289,6 +507,7 @@ static struct upipe *upipe_hls_playlist_alloc(struct upipe_mgr *mgr,
     upipe_hls_playlist_init_probe_key_src(upipe);
     upipe_hls_playlist_init_probe_key(upipe);
     upipe_hls_playlist_init_probe_setflowdef(upipe);
+    upipe_hls_playlist_init_probe_prefetch(upipe);
     upipe_hls_playlist_init_src(upipe);
     upipe_hls_playlist_init_upipe_key(upipe);
     upipe_hls_playlist_init_bin_output(upipe);
@@ -298,10 +517,14 @@ static struct upipe *upipe_hls_playlist_alloc(struct upipe_mgr *mgr,
     struct upipe_hls_playlist *upipe_hls_playlist =
         upipe_hls_playlist_from_upipe(upipe);
     ulist_init(&upipe_hls_playlist->items);
+    upipe_hls_playlist->nb_segments = 0;
     upipe_hls_playlist->input_flow_def = NULL;
     upipe_hls_playlist->flow_def = NULL;
     upipe_hls_playlist->source_mgr = NULL;
     upipe_hls_playlist->index = (uint64_t)-1;
+    upipe_hls_playlist->parts = false;
+    upipe_hls_playlist->part = 0;
+    upipe_hls_playlist->waiting = false;
     upipe_hls_playlist->reloading = false;
     upipe_hls_playlist->output_size = 0;
     upipe_hls_playlist->item = NULL;
@@ -309,6 +532,10 @@ static struct upipe *upipe_hls_playlist_alloc(struct upipe_mgr *mgr,
     upipe_hls_playlist->key.method = NULL;
     upipe_hls_playlist->attach_uclock = false;
     upipe_hls_playlist->playing = false;
+    upipe_hls_playlist->prefetch = 0;
+    ulist_init(&upipe_hls_playlist->prefetches);
+    upipe_hls_playlist->bandwidth_fast = 0;
+    upipe_hls_playlist->bandwidth_slow = 0;
 
     upipe_throw_ready(upipe);
 
@@ -348,6 +575,40 @@ static void upipe_hls_playlist_flush(struct upipe *upipe)
     struct uchain *uchain;
     while ((uchain = ulist_pop(&upipe_hls_playlist->items)) != NULL)
         uref_free(uref_from_uchain(uchain));
+    upipe_hls_playlist->nb_segments = 0;
+}
+
+/** @internal @This frees a prefetched item. The item must have been
+ * removed from the list of prefetched items.
+ *
+ * @param upipe description structure of the pipe
+ * @param prefetch prefetched item to free
+ */
+static void upipe_hls_playlist_free_prefetch(
+    struct upipe *upipe,
+    struct upipe_hls_playlist_prefetch *prefetch)
+{
+    upipe_release(prefetch->sink);
+    upipe_release(prefetch->src);
+    uref_free(prefetch->flow_def);
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&prefetch->urefs)) != NULL)
+        uref_free(uref_from_uchain(uchain));
+    free(prefetch);
+}
+
+/** @internal @This frees all the prefetched items.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_hls_playlist_flush_prefetches(struct upipe *upipe)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&upipe_hls_playlist->prefetches)) != NULL)
+        upipe_hls_playlist_free_prefetch(
+            upipe, upipe_hls_playlist_prefetch_from_uchain(uchain));
 }
 
 /** @internal @This frees the pipe.
@@ -373,6 +634,7 @@ static void upipe_hls_playlist_free(struct upipe *upipe)
     upipe_hls_playlist_clean_probe_key(upipe);
     upipe_hls_playlist_clean_probe_key_src(upipe);
     upipe_hls_playlist_clean_probe_setflowdef(upipe);
+    upipe_hls_playlist_clean_probe_prefetch(upipe);
     upipe_hls_playlist_clean_urefcount(upipe);
     upipe_hls_playlist_clean_urefcount_real(upipe);
     upipe_hls_playlist_free_void(upipe);
@@ -388,12 +650,33 @@ static void upipe_hls_playlist_no_ref(struct upipe *upipe)
         upipe_hls_playlist_from_upipe(upipe);
 
     upipe_hls_playlist_clean_upipe_key(upipe);
+    upipe_hls_playlist_flush_prefetches(upipe);
     upipe_hls_playlist_clean_setflowdef(upipe);
     upipe_hls_playlist_clean_src(upipe);
     upipe_mgr_release(upipe_hls_playlist->source_mgr);
     upipe_hls_playlist_release_urefcount_real(upipe);
 }
 
+/** @internal @This applies the playlist settings to a source pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param src the source pipe to configure
+ * @return an error code
+ */
+static int upipe_hls_playlist_setup_src(struct upipe *upipe,
+                                        struct upipe *src)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+
+    if (upipe_hls_playlist->attach_uclock)
+        UBASE_RETURN(upipe_attach_uclock(src));
+    if (upipe_hls_playlist->output_size)
+        UBASE_RETURN(upipe_set_output_size(src,
+                                           upipe_hls_playlist->output_size));
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This sets the inner source pipe of the playlist.
  *
  * @param upipe description structure of the pipe
@@ -403,24 +686,11 @@ static void upipe_hls_playlist_no_ref(struct upipe *upipe)
 static int upipe_hls_playlist_set_src(struct upipe *upipe,
                                       struct upipe *src)
 {
-    struct upipe_hls_playlist *upipe_hls_playlist =
-        upipe_hls_playlist_from_upipe(upipe);
-    int ret;
-
     if (src) {
-        if (upipe_hls_playlist->attach_uclock) {
-            ret = upipe_attach_uclock(src);
-            if (unlikely(!ubase_check(ret))) {
-                upipe_release(src);
-                return ret;
-            }
-        }
-        if (upipe_hls_playlist->output_size) {
-            ret = upipe_set_output_size(src, upipe_hls_playlist->output_size);
-            if (unlikely(!ubase_check(ret))) {
-                upipe_release(src);
-                return ret;
-            }
+        int ret = upipe_hls_playlist_setup_src(upipe, src);
+        if (unlikely(!ubase_check(ret))) {
+            upipe_release(src);
+            return ret;
         }
     }
     upipe_hls_playlist_store_src(upipe, src);
@@ -565,29 +835,17 @@ static int upipe_hls_playlist_update_flow_def(struct upipe *upipe)
                                      upipe_hls_playlist->flow_def);
 }
 
-/** @internal @This plays an URI.
+/** @internal @This sets the inner setflowdef dict for the current item.
  *
  * @param upipe description structure of the pipe
- * @param item item to play
- * @param uuri the URI of the item to play
  * @return an error code
  */
-static int upipe_hls_playlist_play_uri(struct upipe *upipe,
-                                       struct uref *item,
-                                       struct uuri *uuri)
+static int upipe_hls_playlist_prepare_flow_def(struct upipe *upipe)
 {
     struct upipe_hls_playlist *upipe_hls_playlist =
         upipe_hls_playlist_from_upipe(upipe);
     struct uref *input_flow_def = upipe_hls_playlist->input_flow_def;
 
-    size_t len;
-    UBASE_RETURN(uuri_len(uuri, &len));
-    char uri[len + 1];
-    UBASE_RETURN(uuri_to_buffer(uuri, uri, sizeof (uri)));
-
-    upipe_notice_va(upipe, "play next item sequence %"PRIu64" %s",
-                    upipe_hls_playlist->index, uri);
-
     struct uref *flow_def = upipe_hls_playlist->flow_def;
     if (ubase_check(uref_flow_match_def(flow_def, "block.aes."))) {
         const uint8_t *iv;
@@ -604,7 +862,47 @@ static int upipe_hls_playlist_play_uri(struct upipe *upipe,
             UBASE_RETURN(uref_aes_set_iv(flow_def, iv_buf, sizeof(iv_buf)));
         }
     }
-    UBASE_RETURN(upipe_hls_playlist_update_flow_def(upipe));
+    return upipe_hls_playlist_update_flow_def(upipe);
+}
+
+/** @internal @This starts a source pipe on an item.
+ *
+ * @param src source pipe
+ * @param item item to download
+ * @param uri the URI of the item
+ * @return an error code
+ */
+static int upipe_hls_playlist_start_src(struct upipe *src,
+                                        struct uref *item,
+                                        const char *uri)
+{
+    UBASE_RETURN(upipe_set_uri(src, uri));
+
+    uint64_t range_off = 0;
+    uref_m3u_playlist_get_byte_range_off(item, &range_off);
+    uint64_t range_len = (uint64_t)-1;
+    uref_m3u_playlist_get_byte_range_len(item, &range_len);
+    return upipe_src_set_range(src, range_off, range_len);
+}
+
+/** @internal @This plays an URI.
+ *
+ * @param upipe description structure of the pipe
+ * @param item item to play
+ * @param uri the URI of the item to play
+ * @return an error code
+ */
+static int upipe_hls_playlist_play_uri(struct upipe *upipe,
+                                       struct uref *item,
+                                       const char *uri)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+
+    upipe_notice_va(upipe, "play next item sequence %"PRIu64" %s",
+                    upipe_hls_playlist->index, uri);
+
+    UBASE_RETURN(upipe_hls_playlist_prepare_flow_def(upipe));
 
     UBASE_RETURN(upipe_hls_playlist_check_source_mgr(upipe));
     struct upipe *inner = upipe_void_alloc(
@@ -615,27 +913,22 @@ static int upipe_hls_playlist_play_uri(struct upipe *upipe,
     UBASE_ALLOC_RETURN(inner);
     UBASE_RETURN(upipe_hls_playlist_set_src(upipe, inner));
     UBASE_RETURN(upipe_set_output(inner, upipe_hls_playlist->setflowdef));
-
-    UBASE_RETURN(upipe_set_uri(inner, uri));
-
-    uint64_t range_off = 0;
-    uref_m3u_playlist_get_byte_range_off(item, &range_off);
-    uint64_t range_len = (uint64_t)-1;
-    uref_m3u_playlist_get_byte_range_len(item, &range_len);
-    UBASE_RETURN(upipe_src_set_range(inner, range_off, range_len));
+    UBASE_RETURN(upipe_hls_playlist_start_src(inner, item, uri));
     upipe_notice(upipe, "playing");
     upipe_hls_playlist->playing = true;
     return UBASE_ERR_NONE;
 }
 
-/** @internal @This plays an item.
+/** @internal @This resolves the URI of an item.
  *
  * @param upipe description structure of the pipe
- * @param item item to play
+ * @param item playlist item
+ * @param uri_p filled with an allocated string to free by the caller
  * @return an error code
  */
-static int upipe_hls_playlist_play_item(struct upipe *upipe,
-                                        struct uref *item)
+static int upipe_hls_playlist_item_uri(struct upipe *upipe,
+                                       struct uref *item,
+                                       char **uri_p)
 {
     struct upipe_hls_playlist *upipe_hls_playlist =
         upipe_hls_playlist_from_upipe(upipe);
@@ -645,17 +938,13 @@ static int upipe_hls_playlist_play_item(struct upipe *upipe,
     if (unlikely(input_flow_def == NULL) || unlikely(item == NULL))
         return UBASE_ERR_INVALID;
 
-    upipe_verbose_va(upipe, "play item sequence %"PRIu64,
-                     upipe_hls_playlist->index);
-    uref_dump(item, upipe->uprobe);
-
     const char *m3u_uri;
     UBASE_RETURN(uref_m3u_get_uri(item, &m3u_uri));
 
     struct uuri uuri;
     if (ubase_check(uuri_from_str(&uuri, m3u_uri)))
-        /* this is a valid URI, we can directly play it */
-        return upipe_hls_playlist_play_uri(upipe, item, &uuri);
+        /* this is a valid URI, we can directly use it */
+        return uuri_to_str(&uuri, uri_p);
 
     UBASE_RETURN(uref_uri_get(input_flow_def, &uuri));
     uuri.query = ustring_null();
@@ -663,7 +952,7 @@ static int upipe_hls_playlist_play_item(struct upipe *upipe,
     if (strlen(m3u_uri) && *m3u_uri == '/') {
         /* use the item absolute path with the input scheme */
         uuri.path = ustring_from_str(m3u_uri);
-        return upipe_hls_playlist_play_uri(upipe, item, &uuri);
+        return uuri_to_str(&uuri, uri_p);
     }
 
     /* use the item relative path with the input path as root path */
@@ -675,7 +964,153 @@ static int upipe_hls_playlist_play_item(struct upipe *upipe,
     if (ret < 0 || (unsigned)ret >= sizeof (new_path))
         return UBASE_ERR_NOSPC;
     uuri.path = ustring_from_str(new_path);
-    return upipe_hls_playlist_play_uri(upipe, item, &uuri);
+    return uuri_to_str(&uuri, uri_p);
+}
+
+/** @internal @This plays an item.
+ *
+ * @param upipe description structure of the pipe
+ * @param item item to play
+ * @return an error code
+ */
+static int upipe_hls_playlist_play_item(struct upipe *upipe,
+                                        struct uref *item)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+
+    char *uri;
+    UBASE_RETURN(upipe_hls_playlist_item_uri(upipe, item, &uri));
+
+    upipe_verbose_va(upipe, "play item sequence %"PRIu64,
+                     upipe_hls_playlist->index);
+    uref_dump(item, upipe->uprobe);
+
+    int ret = upipe_hls_playlist_play_uri(upipe, item, uri);
+    free(uri);
+    return ret;
+}
+
+/** @internal @This plays a prefetched item. The retained urefs are
+ * output at once and the source, if it has not finished, becomes the
+ * inner source pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param prefetch prefetched item to play
+ * @param end_p filled with true if the item was completely prefetched
+ * @return an error code
+ */
+static int upipe_hls_playlist_play_prefetch(
+    struct upipe *upipe,
+    struct upipe_hls_playlist_prefetch *prefetch,
+    bool *end_p)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+    struct upipe *setflowdef = upipe_hls_playlist->setflowdef;
+
+    upipe_notice_va(upipe, "play prefetched item sequence %"PRIu64"%s",
+                    prefetch->index, prefetch->end ? "" : " (partial)");
+
+    ulist_delete(&prefetch->uchain);
+    int ret = upipe_hls_playlist_prepare_flow_def(upipe);
+    if (unlikely(!ubase_check(ret))) {
+        upipe_hls_playlist_free_prefetch(upipe, prefetch);
+        return ret;
+    }
+
+    if (prefetch->flow_def != NULL)
+        upipe_set_flow_def(setflowdef, prefetch->flow_def);
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&prefetch->urefs)) != NULL)
+        upipe_input(setflowdef, uref_from_uchain(uchain), NULL);
+
+    *end_p = prefetch->end;
+    if (prefetch->end)
+        upipe_hls_playlist_store_src(upipe, NULL);
+    else {
+        upipe_hls_playlist_store_src(upipe, prefetch->src);
+        prefetch->src = NULL;
+        ret = upipe_set_output(upipe_hls_playlist->src, setflowdef);
+    }
+    upipe_hls_playlist_free_prefetch(upipe, prefetch);
+    upipe_hls_playlist->playing = ubase_check(ret) && !*end_p;
+    return ret;
+}
+
+/** @internal @This starts the download of an item ahead of the playing
+ * one.
+ *
+ * @param upipe description structure of the pipe
+ * @param index media sequence of the item
+ * @param item item to download
+ * @return an error code
+ */
+static int upipe_hls_playlist_prefetch_item(struct upipe *upipe,
+                                            uint64_t index,
+                                            struct uref *item)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+
+    UBASE_RETURN(upipe_hls_playlist_check_source_mgr(upipe));
+    struct upipe_mgr *upipe_probe_uref_mgr = upipe_probe_uref_mgr_alloc();
+    UBASE_ALLOC_RETURN(upipe_probe_uref_mgr);
+
+    char *uri;
+    int ret = upipe_hls_playlist_item_uri(upipe, item, &uri);
+    if (unlikely(!ubase_check(ret))) {
+        upipe_mgr_release(upipe_probe_uref_mgr);
+        return ret;
+    }
+
+    struct upipe_hls_playlist_prefetch *prefetch = malloc(sizeof (*prefetch));
+    if (unlikely(prefetch == NULL)) {
+        upipe_mgr_release(upipe_probe_uref_mgr);
+        free(uri);
+        return UBASE_ERR_ALLOC;
+    }
+    uchain_init(&prefetch->uchain);
+    prefetch->index = index;
+    prefetch->src = NULL;
+    prefetch->sink = NULL;
+    prefetch->flow_def = NULL;
+    ulist_init(&prefetch->urefs);
+    prefetch->end = false;
+    prefetch->failed = false;
+    ulist_add(&upipe_hls_playlist->prefetches, &prefetch->uchain);
+
+    upipe_dbg_va(upipe, "prefetch item sequence %"PRIu64" %s", index, uri);
+
+    prefetch->src = upipe_void_alloc(
+        upipe_hls_playlist->source_mgr,
+        uprobe_pfx_alloc_va(
+            uprobe_use(&upipe_hls_playlist->probe_prefetch),
+            UPROBE_LOG_VERBOSE, "prefetch %"PRIu64, index));
+    if (unlikely(prefetch->src == NULL))
+        ret = UBASE_ERR_ALLOC;
+    else
+        ret = upipe_hls_playlist_setup_src(upipe, prefetch->src);
+
+    if (ubase_check(ret)) {
+        prefetch->sink = upipe_void_alloc_output(
+            prefetch->src, upipe_probe_uref_mgr,
+            uprobe_pfx_alloc_va(
+                uprobe_use(&upipe_hls_playlist->probe_prefetch),
+                UPROBE_LOG_VERBOSE, "prefetch %"PRIu64" sink", index));
+        if (unlikely(prefetch->sink == NULL))
+            ret = UBASE_ERR_ALLOC;
+    }
+    upipe_mgr_release(upipe_probe_uref_mgr);
+
+    if (ubase_check(ret))
+        ret = upipe_hls_playlist_start_src(prefetch->src, item, uri);
+    free(uri);
+
+    if (unlikely(!ubase_check(ret)))
+        /* the item will be downloaded when played */
+        prefetch->failed = true;
+    return ret;
 }
 
 /** @internal @This gets a media sequence by its sequence number.
@@ -703,16 +1138,136 @@ static int upipe_hls_playlist_get_item_at(struct upipe *upipe,
     struct uchain *uchain;
     ulist_foreach(&upipe_hls_playlist->items, uchain) {
         struct uref *uref = uref_from_uchain(uchain);
+        if (ubase_check(uref_m3u_playlist_get_part(uref)))
+            continue;
 
         if (index-- == 0) {
             *item_p = uref;
             return UBASE_ERR_NONE;
         }
     }
-    upipe_notice(upipe, "nothing to play");
     return UBASE_ERR_INVALID;
 }
 
+/** @internal @This gets a partial segment by its sequence number and its
+ * index in the segment. The partial segments of a segment are listed
+ * before it, and the ones of the segment being produced are listed after
+ * the last complete segment. A preload hint counts as the next partial
+ * segment.
+ *
+ * @param upipe description structure of the pipe
+ * @param index the sequence number
+ * @param part the index of the partial segment
+ * @param item_p pointer filled with the partial segment
+ * @return an error code
+ */
+static int upipe_hls_playlist_get_part_at(struct upipe *upipe,
+                                          uint64_t index, uint64_t part,
+                                          struct uref **item_p)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+    struct uref *input_flow_def = upipe_hls_playlist->input_flow_def;
+
+    uint64_t seq = 0;
+    uref_m3u_playlist_flow_get_media_sequence(input_flow_def, &seq);
+    uint64_t nb = 0;
+
+    struct uchain *uchain;
+    ulist_foreach(&upipe_hls_playlist->items, uchain) {
+        struct uref *uref = uref_from_uchain(uchain);
+        if (!ubase_check(uref_m3u_playlist_get_part(uref))) {
+            seq++;
+            nb = 0;
+        }
+        else if (seq == index && nb++ == part) {
+            *item_p = uref;
+            return UBASE_ERR_NONE;
+        }
+    }
+    return UBASE_ERR_INVALID;
+}
+
+/** @internal @This returns the number of complete segments in the
+ * playlist.
+ *
+ * @param upipe description structure of the pipe
+ * @return the number of segments, partial segments excluded
+ */
+static uint64_t upipe_hls_playlist_nb_items(struct upipe *upipe)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+    return upipe_hls_playlist->nb_segments;
+}
+
+/** @internal @This gets a prefetched item by its sequence number.
+ *
+ * @param upipe description structure of the pipe
+ * @param index the sequence number
+ * @return a pointer to the prefetched item or NULL
+ */
+static struct upipe_hls_playlist_prefetch *
+upipe_hls_playlist_prefetch_at(struct upipe *upipe, uint64_t index)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+    struct uchain *uchain;
+    ulist_foreach(&upipe_hls_playlist->prefetches, uchain) {
+        struct upipe_hls_playlist_prefetch *prefetch =
+            upipe_hls_playlist_prefetch_from_uchain(uchain);
+        if (prefetch->index == index)
+            return prefetch;
+    }
+    return NULL;
+}
+
+/** @internal @This releases the prefetched items outside of the prefetch
+ * window and starts the download of the missing ones.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_hls_playlist_refill(struct upipe *upipe)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+    struct uref *input_flow_def = upipe_hls_playlist->input_flow_def;
+    uint64_t index = upipe_hls_playlist->index;
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach(&upipe_hls_playlist->prefetches, uchain, uchain_tmp) {
+        struct upipe_hls_playlist_prefetch *prefetch =
+            upipe_hls_playlist_prefetch_from_uchain(uchain);
+        if (index == (uint64_t)-1 || prefetch->index <= index ||
+            prefetch->index - index > upipe_hls_playlist->prefetch) {
+            upipe_dbg_va(upipe, "drop prefetched item sequence %"PRIu64,
+                         prefetch->index);
+            ulist_delete(uchain);
+            upipe_hls_playlist_free_prefetch(upipe, prefetch);
+        }
+    }
+
+    if (index == (uint64_t)-1 || input_flow_def == NULL)
+        return;
+
+    uint64_t media_sequence = 0;
+    uref_m3u_playlist_flow_get_media_sequence(input_flow_def, &media_sequence);
+    uint64_t last = media_sequence + upipe_hls_playlist_nb_items(upipe);
+    for (uint64_t i = index + 1;
+         i <= index + upipe_hls_playlist->prefetch && i < last; i++) {
+        if (upipe_hls_playlist_prefetch_at(upipe, i) != NULL)
+            continue;
+
+        struct uref *item = NULL;
+        if (!ubase_check(upipe_hls_playlist_get_item_at(upipe, i, &item)) ||
+            !ubase_check(upipe_hls_playlist_prefetch_item(upipe, i, item))) {
+            upipe_warn_va(upipe, "unable to prefetch item sequence %"PRIu64,
+                          i);
+            break;
+        }
+    }
+}
+
 /** @internal @This plays the next item in the playlist.
  *
  * @param upipe description structure of the pipe
@@ -736,6 +1291,7 @@ static int _upipe_hls_playlist_play(struct upipe *upipe)
     uref_m3u_playlist_flow_get_media_sequence(
         input_flow_def, &media_sequence);
 
+    upipe_hls_playlist->waiting = false;
     if (upipe_hls_playlist->index == (uint64_t)-1)
         upipe_hls_playlist->index = media_sequence;
     else if (media_sequence > upipe_hls_playlist->index) {
@@ -744,11 +1300,53 @@ static int _upipe_hls_playlist_play(struct upipe *upipe)
                       upipe_hls_playlist->index,
                       media_sequence);
         upipe_hls_playlist->index = media_sequence;
+        upipe_hls_playlist->parts = false;
+        upipe_hls_playlist->part = 0;
     }
 
+    /* a complete segment is played at once, unless some of its partial
+     * segments were already played */
     struct uref *item = NULL;
-    UBASE_RETURN(upipe_hls_playlist_get_item_at(
-            upipe, upipe_hls_playlist->index, &item));
+    while (upipe_hls_playlist->parts ||
+           !ubase_check(upipe_hls_playlist_get_item_at(
+                   upipe, upipe_hls_playlist->index, &item))) {
+        if (ubase_check(upipe_hls_playlist_get_part_at(
+                    upipe, upipe_hls_playlist->index,
+                    upipe_hls_playlist->part, &item))) {
+            upipe_hls_playlist->parts = true;
+            break;
+        }
+
+        if (upipe_hls_playlist->parts &&
+            ubase_check(upipe_hls_playlist_get_item_at(
+                    upipe, upipe_hls_playlist->index, &item))) {
+            /* all the partial segments of this segment were played */
+            upipe_hls_playlist->index++;
+            upipe_hls_playlist->parts = false;
+            upipe_hls_playlist->part = 0;
+            continue;
+        }
+
+        uint64_t part_target;
+        if (ubase_check(uref_m3u_playlist_flow_get_part_target(
+                    input_flow_def, &part_target)) &&
+            !ubase_check(uref_m3u_playlist_flow_get_endlist(input_flow_def))) {
+            /* low latency live playlist, play on next reload */
+            upipe_dbg_va(upipe, "waiting for sequence %"PRIu64" part %"PRIu64,
+                         upipe_hls_playlist->index, upipe_hls_playlist->part);
+            upipe_hls_playlist->waiting = true;
+            return UBASE_ERR_NONE;
+        }
+        if (upipe_hls_playlist->reloading) {
+            /* the playlist is being loaded, play at its end */
+            upipe_dbg_va(upipe, "waiting for sequence %"PRIu64,
+                         upipe_hls_playlist->index);
+            upipe_hls_playlist->waiting = true;
+            return UBASE_ERR_NONE;
+        }
+        upipe_notice(upipe, "nothing to play");
+        return UBASE_ERR_INVALID;
+    }
 
     const char *method;
     if (ubase_check(uref_m3u_playlist_key_get_method(item, &method))) {
@@ -765,7 +1363,33 @@ static int _upipe_hls_playlist_play(struct upipe *upipe)
             return upipe_hls_playlist_get_key(upipe, method, key_uri);
     }
 
-    return upipe_hls_playlist_play_item(upipe, item);
+    struct upipe_hls_playlist_prefetch *prefetch =
+        upipe_hls_playlist->parts ? NULL :
+        upipe_hls_playlist_prefetch_at(upipe, upipe_hls_playlist->index);
+    bool end = false;
+    int ret;
+    if (upipe_hls_playlist->parts)
+        upipe_dbg_va(upipe, "play sequence %"PRIu64" part %"PRIu64"%s",
+                     upipe_hls_playlist->index, upipe_hls_playlist->part,
+                     ubase_check(uref_m3u_playlist_get_preload_hint(item)) ?
+                     " (preload hint)" : "");
+    if (prefetch != NULL && !prefetch->failed)
+        ret = upipe_hls_playlist_play_prefetch(upipe, prefetch, &end);
+    else {
+        if (prefetch != NULL) {
+            ulist_delete(&prefetch->uchain);
+            upipe_hls_playlist_free_prefetch(upipe, prefetch);
+        }
+        ret = upipe_hls_playlist_play_item(upipe, item);
+    }
+    UBASE_RETURN(ret);
+
+    upipe_hls_playlist_refill(upipe);
+    if (end) {
+        upipe_notice(upipe, "stopped");
+        return upipe_hls_playlist_throw_item_end(upipe);
+    }
+    return UBASE_ERR_NONE;
 }
 
 /** @internal @This goes to the next element in the playlist.
@@ -789,6 +1413,17 @@ static int _upipe_hls_playlist_next(struct upipe *upipe)
                 input_flow_def, &media_sequence)))
         media_sequence = 0;
 
+    if (upipe_hls_playlist->index != (uint64_t)-1 &&
+        upipe_hls_playlist->parts &&
+        media_sequence <= upipe_hls_playlist->index) {
+        upipe_hls_playlist->part++;
+        upipe_dbg_va(upipe, "next part %"PRIu64" of item %"PRIu64,
+                     upipe_hls_playlist->part, upipe_hls_playlist->index);
+        return UBASE_ERR_NONE;
+    }
+
+    upipe_hls_playlist->parts = false;
+    upipe_hls_playlist->part = 0;
     if (upipe_hls_playlist->index == (uint64_t)-1)
         upipe_hls_playlist->index = media_sequence;
     else if (media_sequence > upipe_hls_playlist->index + 1) {
@@ -823,10 +1458,19 @@ static void upipe_hls_playlist_input(struct upipe *upipe,
         upipe_hls_playlist->reloading = true;
     }
 
+    if (!ubase_check(uref_m3u_playlist_get_part(uref)))
+        upipe_hls_playlist->nb_segments++;
     ulist_add(&upipe_hls_playlist->items, uref_to_uchain(uref));
     if (ubase_check(uref_block_get_end(uref))) {
         upipe_dbg(upipe, "playlist end");
         upipe_hls_playlist->reloading = false;
+        if (upipe_hls_playlist->playing)
+            upipe_hls_playlist_refill(upipe);
+        if (upipe_hls_playlist->waiting) {
+            int ret = _upipe_hls_playlist_play(upipe);
+            if (unlikely(!ubase_check(ret)))
+                upipe_throw_error(upipe, ret);
+        }
         upipe_hls_playlist_throw_reloaded(upipe);
     }
 }
@@ -846,6 +1490,95 @@ static void upipe_hls_playlist_store_input_flow_def(struct upipe *upipe,
     upipe_hls_playlist->input_flow_def = flow_def;
 }
 
+/** @internal @This applies an incremental update announced by a new input
+ * flow definition. The items of the segments which left the playlist are
+ * released, as well as the items from the update sequence number on,
+ * which are output again; the other items are kept as is.
+ *
+ * @param upipe description structure of the pipe
+ * @param input_flow_def new input flow definition
+ * @param update first sequence number of the update
+ * @return an error code
+ */
+static int upipe_hls_playlist_update(struct upipe *upipe,
+                                     struct uref *input_flow_def,
+                                     uint64_t update)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+
+    uint64_t seq, media_sequence = 0;
+    if (unlikely(upipe_hls_playlist->input_flow_def == NULL))
+        return UBASE_ERR_INVALID;
+    if (!ubase_check(uref_m3u_playlist_flow_get_media_sequence(
+                upipe_hls_playlist->input_flow_def, &seq)))
+        seq = 0;
+    uref_m3u_playlist_flow_get_media_sequence(input_flow_def,
+                                              &media_sequence);
+    if (unlikely(media_sequence < seq || update < media_sequence ||
+                 update > seq + upipe_hls_playlist->nb_segments))
+        return UBASE_ERR_INVALID;
+
+    /* segments gone from the playlist, with their partial segments */
+    struct uchain *uchain;
+    while (seq < media_sequence &&
+           (uchain = ulist_pop(&upipe_hls_playlist->items)) != NULL) {
+        struct uref *item = uref_from_uchain(uchain);
+        if (!ubase_check(uref_m3u_playlist_get_part(item))) {
+            seq++;
+            upipe_hls_playlist->nb_segments--;
+        }
+        uref_free(item);
+    }
+
+    /* segments output again, starting from the end */
+    seq += upipe_hls_playlist->nb_segments;
+    while (!ulist_empty(&upipe_hls_playlist->items)) {
+        uchain = upipe_hls_playlist->items.prev;
+        struct uref *item = uref_from_uchain(uchain);
+        bool part = ubase_check(uref_m3u_playlist_get_part(item));
+        if (!part && seq-- <= update)
+            break;
+        ulist_delete(uchain);
+        uref_free(item);
+        if (!part)
+            upipe_hls_playlist->nb_segments--;
+    }
+
+    upipe_verbose_va(upipe, "update from %"PRIu64", %"PRIu64" segments kept",
+                     update, upipe_hls_playlist->nb_segments);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This compares two optional strings.
+ *
+ * @param a first string or NULL
+ * @param b second string or NULL
+ * @return true if both strings are equal or both are NULL
+ */
+static inline bool upipe_hls_playlist_same_str(const char *a, const char *b)
+{
+    return a == b || (a != NULL && b != NULL && !strcmp(a, b));
+}
+
+/** @internal @This compares the uri of two playlist flow definitions.
+ *
+ * @param a first flow definition
+ * @param b second flow definition
+ * @return true if both playlists were loaded from the same uri
+ */
+static bool upipe_hls_playlist_same_uri(struct uref *a, struct uref *b)
+{
+    const char *a_host = NULL, *b_host = NULL;
+    const char *a_path = NULL, *b_path = NULL;
+    uref_uri_get_host(a, &a_host);
+    uref_uri_get_host(b, &b_host);
+    uref_uri_get_path(a, &a_path);
+    uref_uri_get_path(b, &b_path);
+    return upipe_hls_playlist_same_str(a_host, b_host) &&
+           upipe_hls_playlist_same_str(a_path, b_path);
+}
+
 static void upipe_hls_playlist_need_reload_cb(struct upump *upump)
 {
         struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
@@ -877,6 +1610,7 @@ static int upipe_hls_playlist_set_flow_def(struct upipe *upipe,
     struct uref *flow_def = upipe_hls_playlist->flow_def;
     UBASE_RETURN(uref_m3u_master_copy(flow_def, input_flow_def));
     UBASE_RETURN(uref_m3u_playlist_flow_copy(flow_def, input_flow_def));
+    uref_m3u_playlist_flow_delete_update(flow_def);
 
     struct uref *flow_def_dup = uref_dup(input_flow_def);
     if (unlikely(flow_def_dup == NULL)) {
@@ -884,6 +1618,15 @@ static int upipe_hls_playlist_set_flow_def(struct upipe *upipe,
         return UBASE_ERR_ALLOC;
     }
 
+    if (upipe_hls_playlist->input_flow_def != NULL &&
+        !upipe_hls_playlist_same_uri(upipe_hls_playlist->input_flow_def,
+                                     flow_def_dup)) {
+        /* switched to another variant, the items downloaded ahead belong
+         * to the previous one */
+        upipe_dbg(upipe, "playlist uri changed");
+        upipe_hls_playlist_flush_prefetches(upipe);
+    }
+
     const char *type;
     if (!ubase_check(uref_m3u_playlist_flow_get_type(flow_def_dup, &type)) ||
         (strcasecmp(type, "VOD") && strcasecmp(type, "EVENT")) ||
@@ -901,7 +1644,17 @@ static int upipe_hls_playlist_set_flow_def(struct upipe *upipe,
             media_sequence = 0;
 
         uint64_t target_duration;
-        if (ubase_check(uref_m3u_playlist_flow_get_target_duration(
+        uint64_t part_target;
+        if (ubase_check(uref_m3u_playlist_flow_get_part_target(
+                    flow_def_dup, &part_target))) {
+            /* low latency playlist, updated with each partial segment */
+            upipe_dbg_va(upipe, "wait %"PRIu64"ms before reloading",
+                         part_target * 1000 / UCLOCK_FREQ);
+            upipe_hls_playlist_wait_upump(
+                upipe, part_target,
+                upipe_hls_playlist_need_reload_cb);
+        }
+        else if (ubase_check(uref_m3u_playlist_flow_get_target_duration(
                     flow_def_dup, &target_duration))) {
             if (old_media_sequence == media_sequence) {
                 upipe_dbg(upipe, "playlist media sequence has not changed");
@@ -919,6 +1672,17 @@ static int upipe_hls_playlist_set_flow_def(struct upipe *upipe,
             upipe_hls_playlist_set_upump(upipe, NULL);
         }
     }
+    uint64_t update;
+    if (ubase_check(uref_m3u_playlist_flow_get_update(flow_def_dup,
+                                                      &update))) {
+        if (likely(ubase_check(upipe_hls_playlist_update(upipe, flow_def_dup,
+                                                         update))))
+            /* keep the items until the end of the update */
+            upipe_hls_playlist->reloading = true;
+        else
+            upipe_warn_va(upipe, "cannot apply update from %"PRIu64,
+                          update);
+    }
     upipe_hls_playlist_store_input_flow_def(upipe, flow_def_dup);
     return UBASE_ERR_NONE;
 }
@@ -950,6 +1714,10 @@ static int _upipe_hls_playlist_set_index(struct upipe *upipe,
 {
     struct upipe_hls_playlist *upipe_hls_playlist =
         upipe_hls_playlist_from_upipe(upipe);
+    if (index != upipe_hls_playlist->index) {
+        upipe_hls_playlist->parts = false;
+        upipe_hls_playlist->part = 0;
+    }
     upipe_hls_playlist->index = index;
     return UBASE_ERR_NONE;
 }
@@ -988,6 +1756,8 @@ static int _upipe_hls_playlist_seek(struct upipe *upipe,
     struct uchain *uchain;
     ulist_foreach(&upipe_hls_playlist->items, uchain) {
         struct uref *item = uref_from_uchain(uchain);
+        if (ubase_check(uref_m3u_playlist_get_part(item)))
+            continue;
         uint64_t seq_duration;
         UBASE_RETURN(uref_m3u_playlist_get_seq_duration(item, &seq_duration));
         if (at < seq_duration) {
@@ -1002,6 +1772,39 @@ static int _upipe_hls_playlist_seek(struct upipe *upipe,
     return UBASE_ERR_INVALID;
 }
 
+/** @internal @This gets the number of prefetched items.
+ *
+ * @param upipe description structure of the pipe
+ * @param prefetch_p filled with the number of prefetched items
+ * @return an error code
+ */
+static int _upipe_hls_playlist_get_prefetch(struct upipe *upipe,
+                                            unsigned int *prefetch_p)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+    if (likely(prefetch_p != NULL))
+        *prefetch_p = upipe_hls_playlist->prefetch;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the number of prefetched items.
+ *
+ * @param upipe description structure of the pipe
+ * @param prefetch number of items to prefetch
+ * @return an error code
+ */
+static int _upipe_hls_playlist_set_prefetch(struct upipe *upipe,
+                                            unsigned int prefetch)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+    upipe_hls_playlist->prefetch = prefetch;
+    if (upipe_hls_playlist->playing)
+        upipe_hls_playlist_refill(upipe);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This sets the inner pipe output size.
  *
  * @param upipe description structure of the pipe
@@ -1014,6 +1817,13 @@ static int upipe_hls_playlist_set_output_size(struct upipe *upipe,
     struct upipe_hls_playlist *upipe_hls_playlist =
         upipe_hls_playlist_from_upipe(upipe);
     upipe_hls_playlist->output_size = output_size;
+    struct uchain *uchain;
+    ulist_foreach(&upipe_hls_playlist->prefetches, uchain) {
+        struct upipe_hls_playlist_prefetch *prefetch =
+            upipe_hls_playlist_prefetch_from_uchain(uchain);
+        if (prefetch->src != NULL)
+            upipe_set_output_size(prefetch->src, output_size);
+    }
     if (likely(upipe_hls_playlist->src != NULL))
         return upipe_set_output_size(upipe_hls_playlist->src, output_size);
     return UBASE_ERR_NONE;
@@ -1029,6 +1839,13 @@ static int upipe_hls_playlist_attach_uclock(struct upipe *upipe)
     struct upipe_hls_playlist *upipe_hls_playlist =
         upipe_hls_playlist_from_upipe(upipe);
     upipe_hls_playlist->attach_uclock = true;
+    struct uchain *uchain;
+    ulist_foreach(&upipe_hls_playlist->prefetches, uchain) {
+        struct upipe_hls_playlist_prefetch *prefetch =
+            upipe_hls_playlist_prefetch_from_uchain(uchain);
+        if (prefetch->src != NULL)
+            upipe_attach_uclock(prefetch->src);
+    }
     if (upipe_hls_playlist->src != NULL)
         return upipe_attach_uclock(upipe_hls_playlist->src);
     return UBASE_ERR_NONE;
@@ -1101,6 +1918,22 @@ static int upipe_hls_playlist_control_internal(struct upipe *upipe,
         return _upipe_hls_playlist_seek(upipe, at, offset_p);
     }
 
+    case UPIPE_HLS_PLAYLIST_GET_PREFETCH: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_PLAYLIST_SIGNATURE);
+        unsigned int *prefetch_p = va_arg(args, unsigned int *);
+        return _upipe_hls_playlist_get_prefetch(upipe, prefetch_p);
+    }
+    case UPIPE_HLS_PLAYLIST_SET_PREFETCH: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_PLAYLIST_SIGNATURE);
+        unsigned int prefetch = va_arg(args, unsigned int);
+        return _upipe_hls_playlist_set_prefetch(upipe, prefetch);
+    }
+    case UPIPE_HLS_PLAYLIST_GET_BANDWIDTH: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_PLAYLIST_SIGNATURE);
+        uint64_t *bandwidth_p = va_arg(args, uint64_t *);
+        return _upipe_hls_playlist_get_bandwidth(upipe, bandwidth_p);
+    }
+
     default:
         return upipe_hls_playlist_control_bin_output(upipe, command, args);
     }
@@ -45,6 +45,7 @@
 #include <upipe/uref_m3u.h>
 #include <upipe/uref_uri.h>
 #include <upipe/uref_dump.h>
+#include <upipe/uref_flow.h>
 
 #include <libgen.h>
 
@@ -93,6 +94,10 @@ struct upipe_hls_variant_sub {
     struct upipe *output;
 };
 
+/** @hidden */
+static int probe_last_inner(struct uprobe *uprobe, struct upipe *inner,
+                            int event, va_list args);
+
 UPIPE_HELPER_UPIPE(upipe_hls_variant_sub, upipe,
                    UPIPE_HLS_VARIANT_SUB_SIGNATURE);
 UPIPE_HELPER_UREFCOUNT(upipe_hls_variant_sub, urefcount,
@@ -102,7 +107,7 @@ UPIPE_HELPER_UREFCOUNT_REAL(upipe_hls_variant_sub, urefcount_real,
 UPIPE_HELPER_FLOW(upipe_hls_variant_sub, NULL);
 UPIPE_HELPER_INNER(upipe_hls_variant_sub, last_inner);
 UPIPE_HELPER_UPROBE(upipe_hls_variant_sub, urefcount_real,
-                    probe_last_inner, NULL);
+                    probe_last_inner, probe_last_inner);
 UPIPE_HELPER_BIN_OUTPUT(upipe_hls_variant_sub, last_inner, output, requests);
 
 struct upipe_hls_variant {
@@ -138,6 +143,40 @@ UPIPE_HELPER_SUBPIPE(upipe_hls_variant, upipe_hls_variant_sub,
 UPIPE_HELPER_UPUMP_MGR(upipe_hls_variant, upump_mgr);
 UPIPE_HELPER_UPUMP(upipe_hls_variant, upump, upump_mgr);
 
+/** @internal @This catches the events of the rendition inner pipe. The
+ * throughput estimates of the playlists are also thrown by the variant
+ * pipe, for the pipe deciding of the variant to play.
+ *
+ * @param uprobe structure used to raise events
+ * @param inner pointer to the inner pipe
+ * @param event event thrown by the inner pipe
+ * @param args optional arguments
+ * @return an error code
+ */
+static int probe_last_inner(struct uprobe *uprobe, struct upipe *inner,
+                            int event, va_list args)
+{
+    struct upipe_hls_variant_sub *upipe_hls_variant_sub =
+        upipe_hls_variant_sub_from_probe_last_inner(uprobe);
+    struct upipe *upipe = upipe_hls_variant_sub_to_upipe(upipe_hls_variant_sub);
+
+    if (event == UPROBE_HLS_PLAYLIST_BANDWIDTH &&
+        ubase_get_signature(args) == UPIPE_HLS_PLAYLIST_SIGNATURE) {
+        va_list args_copy;
+        va_copy(args_copy, args);
+        va_arg(args_copy, uint32_t);
+        uint64_t bandwidth = va_arg(args_copy, uint64_t);
+        va_end(args_copy);
+
+        struct upipe_hls_variant *upipe_hls_variant =
+            upipe_hls_variant_from_sub_mgr(upipe->mgr);
+        upipe_throw(upipe_hls_variant_to_upipe(upipe_hls_variant),
+                    UPROBE_HLS_PLAYLIST_BANDWIDTH,
+                    UPIPE_HLS_PLAYLIST_SIGNATURE, bandwidth);
+    }
+    return upipe_throw_proxy(upipe, inner, event, args);
+}
+
 /** @internal @This allocates a hls sub variant pipe.
  *
  * @param mgr management structure for this pipe type
@@ -465,6 +504,131 @@ static int upipe_hls_variant_split_iterate(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This finds the uri of a rendition in a variant.
+ *
+ * @param variant the variant
+ * @param rendition flow definition of the rendition
+ * @param uri_p filled with the uri of the rendition in the variant
+ * @return an error code
+ */
+static int upipe_hls_variant_rendition_uri(struct uref *variant,
+                                           struct uref *rendition,
+                                           const char **uri_p)
+{
+    if (ubase_check(uref_flow_match_def(rendition, "void.")))
+        return uref_m3u_get_uri(variant, uri_p);
+
+    const char *type, *name;
+    UBASE_RETURN(uref_hls_get_type(rendition, &type));
+    UBASE_RETURN(uref_hls_get_name(rendition, &name));
+
+    uint8_t renditions = 0;
+    uref_hls_get_renditions(variant, &renditions);
+    for (uint8_t i = 0; i < renditions; i++) {
+        const char *rend_type, *rend_name;
+        if (ubase_check(uref_hls_rendition_get_type(variant, &rend_type, i)) &&
+            ubase_check(uref_hls_rendition_get_name(variant, &rend_name, i)) &&
+            !strcmp(type, rend_type) && !strcmp(name, rend_name))
+            return uref_hls_rendition_get_uri(variant, uri_p, i);
+    }
+    return UBASE_ERR_INVALID;
+}
+
+/** @internal @This switches a sub variant pipe to the rendition of the
+ * playing variant.
+ *
+ * @param upipe description structure of the sub pipe
+ * @return an error code
+ */
+static int upipe_hls_variant_sub_switch(struct upipe *upipe)
+{
+    struct upipe_hls_variant_sub *upipe_hls_variant_sub =
+        upipe_hls_variant_sub_from_upipe(upipe);
+    struct upipe_hls_variant *upipe_hls_variant =
+        upipe_hls_variant_from_sub_mgr(upipe->mgr);
+    struct uref *flow_def = upipe_hls_variant_sub->flow_def;
+
+    if (unlikely(upipe_hls_variant_sub->last_inner == NULL))
+        return UBASE_ERR_INVALID;
+
+    const char *item_uri;
+    int ret = upipe_hls_variant_rendition_uri(upipe_hls_variant->flow_def,
+                                              flow_def, &item_uri);
+    if (unlikely(!ubase_check(ret))) {
+        upipe_warn(upipe, "no such rendition in the variant, keep it");
+        return UBASE_ERR_NONE;
+    }
+
+    const char *current_uri;
+    if (ubase_check(uref_hls_get_uri(flow_def, &current_uri)) &&
+        !strcmp(current_uri, item_uri))
+        return UBASE_ERR_NONE;
+
+    char *uri = NULL;
+    if (unlikely(!ubase_check(upipe_hls_variant_make_uri(
+                    upipe_hls_variant->flow_def, item_uri, &uri))) || !uri) {
+        upipe_warn_va(upipe, "fail to make uri with %s", item_uri);
+        return UBASE_ERR_INVALID;
+    }
+
+    if (ubase_check(uref_flow_match_def(flow_def, "void.")))
+        ret = upipe_hls_void_switch_uri(upipe_hls_variant_sub->last_inner,
+                                        uri);
+    else if (ubase_check(uref_flow_match_def(flow_def, "sound.")))
+        ret = upipe_hls_audio_switch_uri(upipe_hls_variant_sub->last_inner,
+                                         uri);
+    else
+        ret = UBASE_ERR_UNHANDLED;
+    if (unlikely(!ubase_check(ret)))
+        upipe_warn_va(upipe, "fail to switch to %s", uri);
+    free(uri);
+    UBASE_RETURN(ret);
+    return uref_hls_set_uri(flow_def, item_uri);
+}
+
+/** @internal @This switches to another variant. The sub pipes are kept and
+ * switch to the renditions of the new variant at the end of their current
+ * item.
+ *
+ * @param upipe description structure of the pipe
+ * @param variant the new variant
+ * @return an error code
+ */
+static int _upipe_hls_variant_play(struct upipe *upipe, struct uref *variant)
+{
+    struct upipe_hls_variant *upipe_hls_variant =
+        upipe_hls_variant_from_upipe(upipe);
+
+    if (unlikely(variant == NULL))
+        return UBASE_ERR_INVALID;
+
+    struct uref *flow_def = uref_dup(variant);
+    UBASE_ALLOC_RETURN(flow_def);
+    uref_free(upipe_hls_variant->flow_def);
+    upipe_hls_variant->flow_def = flow_def;
+
+    /* renditions allocated later use the new variant */
+    struct uchain *uchain;
+    ulist_foreach(&upipe_hls_variant->renditions, uchain) {
+        struct uref *rend = uref_from_uchain(uchain);
+        const char *uri;
+        if (ubase_check(upipe_hls_variant_rendition_uri(flow_def, rend,
+                                                        &uri)))
+            uref_hls_set_uri(rend, uri);
+    }
+
+    int ret = UBASE_ERR_NONE;
+    ulist_foreach(&upipe_hls_variant->subs, uchain) {
+        struct upipe_hls_variant_sub *sub =
+            upipe_hls_variant_sub_from_uchain(uchain);
+        int err = upipe_hls_variant_sub_switch(
+            upipe_hls_variant_sub_to_upipe(sub));
+        if (unlikely(!ubase_check(err)))
+            ret = err;
+    }
+    return ret;
+}
+
 /** @internal @This dispatches the controls.
  *
  * @param upipe description structure of the pipe
@@ -487,6 +651,12 @@ static int _upipe_hls_variant_control(struct upipe *upipe,
         struct uref **uref_p = va_arg(args, struct uref **);
         return upipe_hls_variant_split_iterate(upipe, uref_p);
     }
+
+    case UPIPE_HLS_VARIANT_PLAY: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_VARIANT_SIGNATURE);
+        struct uref *variant = va_arg(args, struct uref *);
+        return _upipe_hls_variant_play(upipe, variant);
+    }
     }
 
     return UBASE_ERR_UNHANDLED;
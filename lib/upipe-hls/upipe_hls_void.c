@@ -468,6 +468,8 @@ static int probe_src(struct uprobe *uprobe, struct upipe *inner,
                              UPROBE_LOG_VERBOSE, "m3u"));
         upipe_mgr_release(upipe_m3u_reader_mgr);
         UBASE_ALLOC_RETURN(upipe_output);
+        /* the playlist pipe keeps the known items across reloads */
+        upipe_m3u_reader_set_incremental(upipe_output, true);
 
         /* playlist pipe
         */
@@ -618,6 +620,35 @@ static int upipe_hls_void_set_uri(struct upipe *upipe, const char *uri)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This switches to another playlist uri, keeping the inner
+ * pipes after the source.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri the new playlist uri
+ * @return an error code
+ */
+static int _upipe_hls_void_switch_uri(struct upipe *upipe, const char *uri)
+{
+    struct upipe_hls_void *upipe_hls_void = upipe_hls_void_from_upipe(upipe);
+
+    struct upipe *reader;
+    if (unlikely(uri == NULL) || upipe_hls_void->src == NULL ||
+        !ubase_check(upipe_get_output(upipe_hls_void->src, &reader)) ||
+        reader == NULL)
+        /* not started yet */
+        return upipe_hls_void_set_uri(upipe, uri);
+
+    upipe_notice_va(upipe, "switching to %s", uri);
+    char *new_uri = strdup(uri);
+    UBASE_ALLOC_RETURN(new_uri);
+    free(upipe_hls_void->uri);
+    upipe_hls_void->uri = new_uri;
+
+    /* forget the previous playlist, the new one is output entirely */
+    UBASE_RETURN(upipe_m3u_reader_set_incremental(reader, true));
+    return upipe_hls_void_reload(upipe);
+}
+
 /** @internal @This attaches an uclock.
  *
  * @param upipe description structure of the pipe
@@ -676,6 +707,15 @@ static int upipe_hls_void_control(struct upipe *upipe,
         switch (ubase_get_signature(args)) {
         case UPIPE_HLS_PLAYLIST_SIGNATURE:
             return upipe_hls_void_control_playlist(upipe, command, args);
+        case UPIPE_HLS_VOID_SIGNATURE:
+            switch (command) {
+            case UPIPE_HLS_VOID_SWITCH_URI: {
+                UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_VOID_SIGNATURE);
+                const char *uri = va_arg(args, const char *);
+                return _upipe_hls_void_switch_uri(upipe, uri);
+            }
+            }
+            break;
         }
     }
 
@@ -686,6 +726,7 @@ static int upipe_hls_void_control(struct upipe *upipe,
 static struct upipe_mgr upipe_hls_void_mgr = {
     .refcount = NULL,
     .signature = UPIPE_HLS_VOID_SIGNATURE,
+    .upipe_command_str = upipe_hls_void_command_str,
     .upipe_alloc = upipe_hls_void_alloc,
     .upipe_control = upipe_hls_void_control,
 };
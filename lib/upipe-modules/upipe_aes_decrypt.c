@@ -35,8 +35,28 @@
 #include <upipe/uref_block.h>
 #include <upipe/urefcount.h>
 
+#include <string.h>
+
+#if defined(__i686__) || defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#ifdef __linux__
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
 #define EXPECTED_FLOW_DEF       "block.aes."
 
+struct upipe_aes_decrypt;
+
+/** @internal @This is the signature of a function decrypting AES-128-CBC
+ * blocks, possibly in place, and updating the initialization vector. */
+typedef void (*upipe_aes_decrypt_cbc)(struct upipe_aes_decrypt *ctx,
+                                      const uint8_t *src, uint8_t *dst,
+                                      size_t blocks);
+
 /** @internal @This is the private context of an aes pipe. */
 struct upipe_aes_decrypt {
     /** pipe public structure */
@@ -78,8 +98,13 @@ struct upipe_aes_decrypt {
     bool restart;
     /** store round keys */
     uint8_t round_keys[11][4][4];
+    /** store round keys of the equivalent inverse cipher, in the order
+     * they are used */
+    uint8_t dec_keys[11][16];
     /** store initialization vector */
     uint8_t iv[16];
+    /** CBC decryption function */
+    upipe_aes_decrypt_cbc cbc;
 };
 
 static int upipe_aes_decrypt_check(struct upipe *upipe, struct uref *uref);
@@ -383,6 +408,163 @@ static inline void aes_cbc_decrypt(uint8_t buffer[16],
     aes_xor_iv((uint8_t (*)[])buffer, iv);
 }
 
+/** @internal @This generates the round keys of the equivalent inverse
+ * cipher, as used by the AES-NI and ARMv8 instructions.
+ *
+ * @param round_keys the generated round keys
+ * @param dec_keys the generated decryption round keys
+ */
+static void aes_dec_key_expansion(uint8_t round_keys[11][4][4],
+                                  uint8_t dec_keys[11][16])
+{
+    memcpy(dec_keys[0], round_keys[10], sizeof (dec_keys[0]));
+    for (unsigned i = 1; i < 10; i++) {
+        uint8_t state[4][4];
+        memcpy(state, round_keys[10 - i], sizeof (state));
+        aes_inv_mix_columns(state);
+        memcpy(dec_keys[i], state, sizeof (dec_keys[i]));
+    }
+    memcpy(dec_keys[10], round_keys[0], sizeof (dec_keys[10]));
+}
+
+/** @internal @This decrypts AES-128-CBC blocks.
+ *
+ * @param ctx private context of the pipe
+ * @param src blocks to decrypt
+ * @param dst decrypted blocks, may be equal to src
+ * @param blocks number of blocks
+ */
+static void upipe_aes_decrypt_cbc_c(struct upipe_aes_decrypt *ctx,
+                                    const uint8_t *src, uint8_t *dst,
+                                    size_t blocks)
+{
+    for ( ; blocks; blocks--, src += 16, dst += 16) {
+        uint8_t cipher[16];
+        memcpy(cipher, src, sizeof (cipher));
+        memmove(dst, src, 16);
+        aes_cbc_decrypt(dst, ctx->round_keys, ctx->iv);
+        memcpy(ctx->iv, cipher, sizeof (ctx->iv));
+    }
+}
+
+#if defined(__i686__) || defined(__x86_64__)
+/** @internal @This decrypts AES-128-CBC blocks with AES-NI. The blocks are
+ * independent in CBC decryption, so eight of them are interleaved to hide
+ * the latency of the instructions.
+ *
+ * @param ctx private context of the pipe
+ * @param src blocks to decrypt
+ * @param dst decrypted blocks, may be equal to src
+ * @param blocks number of blocks
+ */
+__attribute__((target("aes,sse2")))
+static void upipe_aes_decrypt_cbc_aesni(struct upipe_aes_decrypt *ctx,
+                                        const uint8_t *src, uint8_t *dst,
+                                        size_t blocks)
+{
+    __m128i k[11];
+    for (unsigned r = 0; r < 11; r++)
+        k[r] = _mm_loadu_si128((const __m128i *)ctx->dec_keys[r]);
+    __m128i iv = _mm_loadu_si128((const __m128i *)ctx->iv);
+
+    for ( ; blocks >= 8; blocks -= 8, src += 128, dst += 128) {
+        __m128i c[8], x[8];
+        for (unsigned j = 0; j < 8; j++) {
+            c[j] = _mm_loadu_si128((const __m128i *)(src + 16 * j));
+            x[j] = _mm_xor_si128(c[j], k[0]);
+        }
+        for (unsigned r = 1; r < 10; r++)
+            for (unsigned j = 0; j < 8; j++)
+                x[j] = _mm_aesdec_si128(x[j], k[r]);
+        for (unsigned j = 0; j < 8; j++) {
+            x[j] = _mm_aesdeclast_si128(x[j], k[10]);
+            x[j] = _mm_xor_si128(x[j], j ? c[j - 1] : iv);
+            _mm_storeu_si128((__m128i *)(dst + 16 * j), x[j]);
+        }
+        iv = c[7];
+    }
+
+    for ( ; blocks; blocks--, src += 16, dst += 16) {
+        __m128i c = _mm_loadu_si128((const __m128i *)src);
+        __m128i x = _mm_xor_si128(c, k[0]);
+        for (unsigned r = 1; r < 10; r++)
+            x = _mm_aesdec_si128(x, k[r]);
+        x = _mm_aesdeclast_si128(x, k[10]);
+        _mm_storeu_si128((__m128i *)dst, _mm_xor_si128(x, iv));
+        iv = c;
+    }
+    _mm_storeu_si128((__m128i *)ctx->iv, iv);
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+/** @internal @This decrypts AES-128-CBC blocks with the ARMv8 cryptographic
+ * extension. The blocks are independent in CBC decryption, so eight of them
+ * are interleaved to hide the latency of the instructions.
+ *
+ * @param ctx private context of the pipe
+ * @param src blocks to decrypt
+ * @param dst decrypted blocks, may be equal to src
+ * @param blocks number of blocks
+ */
+__attribute__((target("+crypto")))
+static void upipe_aes_decrypt_cbc_armv8(struct upipe_aes_decrypt *ctx,
+                                        const uint8_t *src, uint8_t *dst,
+                                        size_t blocks)
+{
+    uint8x16_t k[11];
+    for (unsigned r = 0; r < 11; r++)
+        k[r] = vld1q_u8(ctx->dec_keys[r]);
+    uint8x16_t iv = vld1q_u8(ctx->iv);
+
+    for ( ; blocks >= 8; blocks -= 8, src += 128, dst += 128) {
+        uint8x16_t c[8], x[8];
+        for (unsigned j = 0; j < 8; j++)
+            x[j] = c[j] = vld1q_u8(src + 16 * j);
+        for (unsigned r = 0; r < 9; r++)
+            for (unsigned j = 0; j < 8; j++)
+                x[j] = vaesimcq_u8(vaesdq_u8(x[j], k[r]));
+        for (unsigned j = 0; j < 8; j++) {
+            x[j] = veorq_u8(vaesdq_u8(x[j], k[9]), k[10]);
+            x[j] = veorq_u8(x[j], j ? c[j - 1] : iv);
+            vst1q_u8(dst + 16 * j, x[j]);
+        }
+        iv = c[7];
+    }
+
+    for ( ; blocks; blocks--, src += 16, dst += 16) {
+        uint8x16_t c = vld1q_u8(src);
+        uint8x16_t x = c;
+        for (unsigned r = 0; r < 9; r++)
+            x = vaesimcq_u8(vaesdq_u8(x, k[r]));
+        x = veorq_u8(vaesdq_u8(x, k[9]), k[10]);
+        vst1q_u8(dst, veorq_u8(x, iv));
+        iv = c;
+    }
+    vst1q_u8(ctx->iv, iv);
+}
+#endif
+
+/** @internal @This returns the fastest CBC decryption function supported by
+ * the CPU.
+ *
+ * @return a CBC decryption function
+ */
+static upipe_aes_decrypt_cbc upipe_aes_decrypt_cbc_get(void)
+{
+#if defined(__i686__) || defined(__x86_64__)
+    if (__builtin_cpu_supports("aes") && __builtin_cpu_supports("sse2"))
+        return upipe_aes_decrypt_cbc_aesni;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#if defined(__linux__) && defined(HWCAP_AES)
+    if (getauxval(AT_HWCAP) & HWCAP_AES)
+        return upipe_aes_decrypt_cbc_armv8;
+#elif defined(__ARM_FEATURE_CRYPTO)
+    return upipe_aes_decrypt_cbc_armv8;
+#endif
+#endif
+    return upipe_aes_decrypt_cbc_c;
+}
+
 /** @internal @This allocates an aes decryption pipe.
  *
  * @param mgr reference to the aes decryption pipe manager.
@@ -411,6 +593,7 @@ static struct upipe *upipe_aes_decrypt_alloc(struct upipe_mgr *mgr,
     upipe_aes_decrypt_init_uref_stream(upipe);
     upipe_aes_decrypt->input_flow_def = NULL;
     upipe_aes_decrypt->restart = true;
+    upipe_aes_decrypt->cbc = upipe_aes_decrypt_cbc_get();
 
     upipe_throw_ready(upipe);
 
@@ -456,7 +639,7 @@ static int upipe_aes_decrypt_restart(struct upipe *upipe)
     }
     if (unlikely(key_size != 16)) {
         upipe_warn(upipe, "invalid aes key");
-        return ret;
+        return UBASE_ERR_INVALID;
     }
 
     const uint8_t *iv;
@@ -468,14 +651,111 @@ static int upipe_aes_decrypt_restart(struct upipe *upipe)
     }
     if (unlikely(iv_size != 16)) {
         upipe_warn(upipe, "invalid aes initialization vector");
-        return ret;
+        return UBASE_ERR_INVALID;
     }
 
     aes_key_expansion(key, upipe_aes_decrypt->round_keys);
+    aes_dec_key_expansion(upipe_aes_decrypt->round_keys,
+                          upipe_aes_decrypt->dec_keys);
+    memcpy(upipe_aes_decrypt->iv, iv, sizeof (upipe_aes_decrypt->iv));
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This writes a buffer to a possibly segmented uref.
+ *
+ * @param uref uref to write to
+ * @param offset offset in the uref
+ * @param buffer buffer to write
+ * @param size size of the buffer
+ * @return an error code
+ */
+static int upipe_aes_decrypt_scatter(struct uref *uref, int offset,
+                                     const uint8_t *buffer, int size)
+{
+    while (size > 0) {
+        int wsize = size;
+        uint8_t *wbuf;
+        UBASE_RETURN(uref_block_write(uref, offset, &wsize, &wbuf));
+        memcpy(wbuf, buffer, wsize);
+        uref_block_unmap(uref, offset);
+        offset += wsize;
+        buffer += wsize;
+        size -= wsize;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This checks if all the segments of a uref may be written.
+ *
+ * @param uref uref to check
+ * @param size size of the uref
+ * @return true if the uref may be decrypted in place
+ */
+static bool upipe_aes_decrypt_writable(struct uref *uref, size_t size)
+{
+    for (size_t offset = 0; offset < size; ) {
+        int wsize = -1;
+        uint8_t *wbuf;
+        if (unlikely(!ubase_check(uref_block_write(uref, offset,
+                                                   &wsize, &wbuf))))
+            return false;
+        uref_block_unmap(uref, offset);
+        offset += wsize;
+    }
+    return true;
+}
+
+/** @internal @This decrypts the blocks of a possibly segmented uref, in
+ * place or to a contiguous output buffer.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref carrying the blocks
+ * @param size size of the uref, multiple of 16
+ * @param out output buffer, or NULL to decrypt in place
+ * @return an error code
+ */
+static int upipe_aes_decrypt_blocks(struct upipe *upipe, struct uref *uref,
+                                    size_t size, uint8_t *out)
+{
+    struct upipe_aes_decrypt *upipe_aes_decrypt =
+        upipe_aes_decrypt_from_upipe(upipe);
+
+    for (size_t offset = 0; offset < size; ) {
+        int chunk = -1;
+        const uint8_t *src;
+        uint8_t *dst;
+        if (out) {
+            UBASE_RETURN(uref_block_read(uref, offset, &chunk, &src));
+            dst = out + offset;
+        } else {
+            UBASE_RETURN(uref_block_write(uref, offset, &chunk, &dst));
+            src = dst;
+        }
+        size_t blocks = ((size_t)chunk < size - offset ?
+                         (size_t)chunk : size - offset) / 16;
+        upipe_aes_decrypt->cbc(upipe_aes_decrypt, src, dst, blocks);
+        uref_block_unmap(uref, offset);
+        offset += blocks * 16;
+
+        if (offset < size && chunk % 16) {
+            /* the next block spans two segments */
+            uint8_t block[16];
+            UBASE_RETURN(uref_block_extract(uref, offset, 16, block));
+            upipe_aes_decrypt->cbc(upipe_aes_decrypt, block,
+                                   out ? out + offset : block, 1);
+            if (!out)
+                UBASE_RETURN(upipe_aes_decrypt_scatter(uref, offset,
+                                                       block, 16));
+            offset += 16;
+        }
+    }
     return UBASE_ERR_NONE;
 }
 
 /** @internal @This outputs the decrypted blocks.
+ *
+ * The received blocks are decrypted at once, in place if the buffers are
+ * not shared, otherwise into a new buffer allocated from the ubuf manager.
  *
  * @param upipe description structure of the pipe
  * @param upump_p reference to the pump that generated the buffer
@@ -496,48 +776,54 @@ static void upipe_aes_decrypt_worker(struct upipe *upipe,
 
     size_t block_size;
     ubase_assert(uref_block_size(upipe_aes_decrypt->next_uref, &block_size));
-    for (size_t size = block_size; size >= 16; size -= 16) {
-        int ret;
-
-        struct uref *uref = upipe_aes_decrypt_extract_uref_stream(upipe, 16);
-        if (unlikely(!uref)) {
-            upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
-            return;
-        }
+    size_t size = block_size & ~(size_t)15;
+    if (!size)
+        return;
+
+    struct uref *uref = upipe_aes_decrypt_extract_uref_stream(upipe, size);
+    if (unlikely(!uref)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
 
-        uint8_t iv[16];
-        ret = uref_block_extract(uref, 0, 16, iv);
-        if (unlikely(!ubase_check(ret))) {
+    if (upipe_aes_decrypt_writable(uref, size)) {
+        if (unlikely(!ubase_check(upipe_aes_decrypt_blocks(upipe, uref, size,
+                                                           NULL)))) {
             uref_free(uref);
             upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
             return;
         }
+        upipe_aes_decrypt_output(upipe, uref, upump_p);
+        return;
+    }
 
-        struct ubuf *ubuf =
-            ubuf_block_alloc(upipe_aes_decrypt->ubuf_mgr, 16);
-        if (unlikely(!ubuf)) {
-            uref_free(uref);
-            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-            return;
-        }
-        uref_attach_ubuf(uref, ubuf);
+    struct ubuf *ubuf = ubuf_block_alloc(upipe_aes_decrypt->ubuf_mgr, size);
+    if (unlikely(!ubuf)) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
 
-        int wsize = 16;
-        uint8_t *wbuf;
-        ret = uref_block_write(uref, 0, &wsize, &wbuf);
-        if (unlikely(!ubase_check(ret)) || wsize != 16) {
-            uref_free(uref);
-            upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
-            return;
-        }
-        memcpy(wbuf, iv, wsize);
-        aes_cbc_decrypt(wbuf,
-                        upipe_aes_decrypt->round_keys,
-                        upipe_aes_decrypt->iv);
-        ubase_assert(uref_block_unmap(uref, 0));
-        memcpy(upipe_aes_decrypt->iv, iv, sizeof (upipe_aes_decrypt->iv));
-        upipe_aes_decrypt_output(upipe, uref, upump_p);
+    int wsize = size;
+    uint8_t *wbuf;
+    if (unlikely(!ubase_check(ubuf_block_write(ubuf, 0, &wsize, &wbuf)))) {
+        ubuf_free(ubuf);
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
+        return;
+    }
+    if (unlikely((size_t)wsize != size ||
+                 !ubase_check(upipe_aes_decrypt_blocks(upipe, uref, size,
+                                                       wbuf)))) {
+        ubuf_block_unmap(ubuf, 0);
+        ubuf_free(ubuf);
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
+        return;
     }
+    ubuf_block_unmap(ubuf, 0);
+    uref_attach_ubuf(uref, ubuf);
+    upipe_aes_decrypt_output(upipe, uref, upump_p);
 }
 
 /** @internal @This outputs the last block.
@@ -702,7 +988,7 @@ static int upipe_aes_decrypt_control(struct upipe *upipe,
     case UPIPE_GET_OUTPUT:
     case UPIPE_SET_OUTPUT:
     case UPIPE_GET_FLOW_DEF:
-        return upipe_aes_decrypt_control(upipe, command, args);
+        return upipe_aes_decrypt_control_output(upipe, command, args);
     case UPIPE_SET_FLOW_DEF: {
         struct uref *flow_def = va_arg(args, struct uref *);
         return upipe_aes_decrypt_set_flow_def(upipe, flow_def);
@@ -42,6 +42,8 @@
 #include <upipe/upipe_helper_void.h>
 #include <upipe/upipe_helper_output.h>
 #include <upipe/upipe_helper_output_size.h>
+#include <upipe/upipe_helper_upump_mgr.h>
+#include <upipe/upipe_helper_upump.h>
 #include <upipe-modules/upipe_aggregate.h>
 
 #include <stdlib.h>
@@ -80,6 +82,17 @@ struct upipe_agg {
     /** current stored size */
     size_t size;
 
+    /** upump manager */
+    struct upump_mgr *upump_mgr;
+    /** timer flushing a partial aggregation */
+    struct upump *upump;
+    /** maximum delay of a partial aggregation, or 0 */
+    uint64_t max_delay;
+    /** latency of the input flow */
+    uint64_t input_latency;
+    /** octetrate of the input flow */
+    uint64_t input_octetrate;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -89,6 +102,8 @@ UPIPE_HELPER_UREFCOUNT(upipe_agg, urefcount, upipe_agg_free)
 UPIPE_HELPER_VOID(upipe_agg)
 UPIPE_HELPER_OUTPUT(upipe_agg, output, flow_def, output_state, request_list)
 UPIPE_HELPER_OUTPUT_SIZE(upipe_agg, output_size)
+UPIPE_HELPER_UPUMP_MGR(upipe_agg, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_agg, upump, upump_mgr)
 
 /** @internal @This allocates a agg pipe.
  *
@@ -110,6 +125,11 @@ static struct upipe *upipe_agg_alloc(struct upipe_mgr *mgr,
     upipe_agg_init_urefcount(upipe);
     upipe_agg_init_output(upipe);
     upipe_agg_init_output_size(upipe, DEFAULT_MTU);
+    upipe_agg_init_upump_mgr(upipe);
+    upipe_agg_init_upump(upipe);
+    upipe_agg->max_delay = 0;
+    upipe_agg->input_latency = 0;
+    upipe_agg->input_octetrate = 0;
     upipe_agg->input_size = 0;
     upipe_agg->size = 0;
     upipe_agg->aggregated = NULL;
@@ -117,6 +137,34 @@ static struct upipe *upipe_agg_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
+/** @internal @This outputs the current aggregation.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_agg_flush(struct upipe *upipe, struct upump **upump_p)
+{
+    struct upipe_agg *upipe_agg = upipe_agg_from_upipe(upipe);
+    struct uref *aggregated = upipe_agg->aggregated;
+
+    upipe_agg_set_upump(upipe, NULL);
+    upipe_agg->aggregated = NULL;
+    upipe_agg->size = 0;
+    if (aggregated != NULL)
+        upipe_agg_output(upipe, aggregated, upump_p);
+}
+
+/** @internal @This is called when a partial aggregation has waited for
+ * too long.
+ *
+ * @param upump description structure of the timer
+ */
+static void upipe_agg_timeout(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    upipe_agg_flush(upipe, NULL);
+}
+
 /** @internal @This receives data.
  *
  * @param upipe description structure of the pipe
@@ -141,15 +189,19 @@ static void upipe_agg_input(struct upipe *upipe, struct uref *uref,
     }
 
     /* flush if incoming packet makes aggregated overflow */
-    if (upipe_agg->size + size > output_size) {
-        upipe_agg_output(upipe, upipe_agg->aggregated, upump_p);
-        upipe_agg->aggregated = NULL;
-    }
+    if (upipe_agg->size + size > output_size)
+        upipe_agg_flush(upipe, upump_p);
 
     /* keep or attach incoming packet */
     if (unlikely(!upipe_agg->aggregated)) {
         upipe_agg->aggregated = uref;
         upipe_agg->size = size;
+        if (upipe_agg->max_delay) {
+            upipe_agg_check_upump_mgr(upipe);
+            if (upipe_agg->upump_mgr != NULL)
+                upipe_agg_wait_upump(upipe, upipe_agg->max_delay,
+                                     upipe_agg_timeout);
+        }
     } else {
         struct ubuf *append = uref_detach_ubuf(uref);
         uref_free(uref);
@@ -165,11 +217,29 @@ static void upipe_agg_input(struct upipe *upipe, struct uref *uref,
     /* anticipate next packet size and flush now if necessary */
     if (upipe_agg->input_size)
         size = upipe_agg->input_size;
-    if (unlikely(upipe_agg->size + size > output_size)) {
-        upipe_agg_output(upipe, upipe_agg->aggregated, upump_p);
-        upipe_agg->aggregated = NULL;
-        upipe_agg->size = 0;
-    }
+    if (unlikely(upipe_agg->size + size > output_size))
+        upipe_agg_flush(upipe, upump_p);
+}
+
+/** @internal @This builds the output flow definition latency.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def output flow definition
+ * @return an error code
+ */
+static int upipe_agg_set_latency(struct upipe *upipe, struct uref *flow_def)
+{
+    struct upipe_agg *upipe_agg = upipe_agg_from_upipe(upipe);
+    uint64_t delay = 0;
+
+    if (upipe_agg->input_octetrate)
+        delay = (uint64_t)upipe_agg->output_size * UCLOCK_FREQ /
+                upipe_agg->input_octetrate;
+    if (upipe_agg->max_delay && (!delay || delay > upipe_agg->max_delay))
+        delay = upipe_agg->max_delay;
+    if (!delay)
+        return UBASE_ERR_NONE;
+    return uref_clock_set_latency(flow_def, upipe_agg->input_latency + delay);
 }
 
 /** @internal @This sets the input flow definition.
@@ -189,19 +259,48 @@ static int upipe_agg_set_flow_def(struct upipe *upipe, struct uref *flow_def)
     uref_block_flow_get_size(flow_def, &size);
     upipe_agg->input_size = size;
 
-    uint64_t octetrate = 0;
-    uref_block_flow_get_octetrate(flow_def, &octetrate);
-    uint64_t latency = 0;
-    uref_clock_get_latency(flow_def, &latency);
+    upipe_agg->input_octetrate = 0;
+    uref_block_flow_get_octetrate(flow_def, &upipe_agg->input_octetrate);
+    upipe_agg->input_latency = 0;
+    uref_clock_get_latency(flow_def, &upipe_agg->input_latency);
 
     struct uref *flow_def_dup;
     if ((flow_def_dup = uref_dup(flow_def)) == NULL)
         return UBASE_ERR_ALLOC;
     UBASE_RETURN(uref_block_flow_set_size(flow_def_dup, upipe_agg->output_size))
+    UBASE_RETURN(upipe_agg_set_latency(upipe, flow_def_dup))
+    upipe_agg_store_flow_def(upipe, flow_def_dup);
+    return UBASE_ERR_NONE;
+}
 
-    if (octetrate) {
-        UBASE_RETURN(uref_clock_set_latency(flow_def_dup, latency +
-                    (uint64_t)upipe_agg->output_size * UCLOCK_FREQ / octetrate))
+/** @internal @This sets the maximum delay of a partial aggregation.
+ *
+ * @param upipe description structure of the pipe
+ * @param max_delay maximum delay in @ref #UCLOCK_FREQ units, or 0
+ * @return an error code
+ */
+static int _upipe_agg_set_max_delay(struct upipe *upipe,
+                                    uint64_t max_delay)
+{
+    struct upipe_agg *upipe_agg = upipe_agg_from_upipe(upipe);
+
+    upipe_agg->max_delay = max_delay;
+    upipe_agg_set_upump(upipe, NULL);
+    if (max_delay && upipe_agg->aggregated != NULL) {
+        upipe_agg_check_upump_mgr(upipe);
+        if (upipe_agg->upump_mgr != NULL)
+            upipe_agg_wait_upump(upipe, max_delay, upipe_agg_timeout);
+    }
+
+    if (upipe_agg->flow_def == NULL)
+        return UBASE_ERR_NONE;
+    struct uref *flow_def_dup = uref_dup(upipe_agg->flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup);
+    uref_clock_delete_latency(flow_def_dup);
+    int ret = upipe_agg_set_latency(upipe, flow_def_dup);
+    if (unlikely(!ubase_check(ret))) {
+        uref_free(flow_def_dup);
+        return ret;
     }
     upipe_agg_store_flow_def(upipe, flow_def_dup);
     return UBASE_ERR_NONE;
@@ -219,10 +318,24 @@ static int upipe_agg_control(struct upipe *upipe, int command, va_list args)
     UBASE_HANDLED_RETURN(upipe_agg_control_output(upipe, command, args));
     UBASE_HANDLED_RETURN(upipe_agg_control_output_size(upipe, command, args));
     switch (command) {
+        case UPIPE_ATTACH_UPUMP_MGR:
+            upipe_agg_set_upump(upipe, NULL);
+            return upipe_agg_attach_upump_mgr(upipe);
         case UPIPE_SET_FLOW_DEF: {
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_agg_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_AGG_SET_MAX_DELAY: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AGG_SIGNATURE)
+            uint64_t max_delay = va_arg(args, uint64_t);
+            return _upipe_agg_set_max_delay(upipe, max_delay);
+        }
+        case UPIPE_AGG_GET_MAX_DELAY: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AGG_SIGNATURE)
+            uint64_t *max_delay_p = va_arg(args, uint64_t *);
+            *max_delay_p = upipe_agg_from_upipe(upipe)->max_delay;
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -240,6 +353,8 @@ static void upipe_agg_free(struct upipe *upipe)
         upipe_agg_output(upipe, upipe_agg->aggregated, NULL);
     }
     upipe_throw_dead(upipe);
+    upipe_agg_clean_upump(upipe);
+    upipe_agg_clean_upump_mgr(upipe);
     upipe_agg_clean_output(upipe);
     upipe_agg_clean_output_size(upipe);
     upipe_agg_clean_urefcount(upipe);
@@ -251,6 +366,7 @@ static struct upipe_mgr upipe_agg_mgr = {
     .refcount = NULL,
     .signature = UPIPE_AGG_SIGNATURE,
 
+    .upipe_command_str = upipe_agg_command_str,
     .upipe_alloc = upipe_agg_alloc,
     .upipe_input = upipe_agg_input,
     .upipe_control = upipe_agg_control,
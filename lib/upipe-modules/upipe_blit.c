@@ -51,6 +51,18 @@
 /** we only accept pictures */
 #define EXPECTED_FLOW_DEF "pic."
 
+/** @internal @This describes a rectangle of the output picture. */
+struct upipe_blit_rect {
+    /** horizontal offset */
+    uint64_t hoffset;
+    /** vertical offset */
+    uint64_t voffset;
+    /** horizontal size, or 0 for an empty rectangle */
+    uint64_t hsize;
+    /** vertical size */
+    uint64_t vsize;
+};
+
 /** @internal @This is the private context of a blit pipe */
 struct upipe_blit {
     /** refcount management structure */
@@ -85,6 +97,8 @@ struct upipe_blit {
 
     /** last received uref */
     struct uref *uref;
+    /** last composed picture, or NULL if it must be composed again */
+    struct ubuf *composite;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -96,6 +110,7 @@ UPIPE_HELPER_VOID(upipe_blit)
 UPIPE_HELPER_OUTPUT(upipe_blit, output, flow_def, output_state, request_list)
 
 static void upipe_blit_sort(struct upipe *upipe);
+static void upipe_blit_invalidate(struct upipe *upipe);
 
 /** @internal @This is the private context of an input of a blit pipe. */
 struct upipe_blit_sub {
@@ -140,6 +155,11 @@ struct upipe_blit_sub {
     /** computed vertical position */
     uint64_t vposition;
 
+    /** true if the subpicture changed since it was last composed */
+    bool dirty;
+    /** rectangle covered by the subpicture in the composed picture */
+    struct upipe_blit_rect composed;
+
     /** flow format urequests */
     struct uchain flow_format_requests;
 
@@ -180,6 +200,8 @@ static struct upipe *upipe_blit_sub_alloc(struct upipe_mgr *mgr,
     sub->loffset_r = sub->roffset_r = sub->toffset_r = sub->boffset_r = 0;
     sub->ubuf = NULL;
     sub->hsize = sub->vsize = sub->hposition = sub->vposition = UINT64_MAX;
+    sub->dirty = false;
+    sub->composed.hsize = sub->composed.vsize = 0;
     ulist_init(&sub->flow_format_requests);
 
     upipe_throw_ready(upipe);
@@ -189,19 +211,80 @@ static struct upipe *upipe_blit_sub_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
-/** @internal @This blits the subpicture into the input uref.
+/** @internal @This returns the rectangle currently covered by the
+ * subpicture.
+ *
+ * @param upipe description structure of the pipe
+ * @param rect filled in with the rectangle, empty if there is no subpicture
+ */
+static void upipe_blit_sub_rect(struct upipe *upipe,
+                                struct upipe_blit_rect *rect)
+{
+    struct upipe_blit_sub *sub = upipe_blit_sub_from_upipe(upipe);
+    if (sub->ubuf == NULL) {
+        rect->hsize = rect->vsize = 0;
+        return;
+    }
+    rect->hoffset = sub->hposition;
+    rect->voffset = sub->vposition;
+    rect->hsize = sub->hsize;
+    rect->vsize = sub->vsize;
+}
+
+/** @internal @This computes the intersection of two rectangles.
+ *
+ * @param a first rectangle
+ * @param b second rectangle
+ * @param rect filled in with the intersection
+ * @return false if the intersection is empty
+ */
+static bool upipe_blit_rect_intersect(const struct upipe_blit_rect *a,
+                                      const struct upipe_blit_rect *b,
+                                      struct upipe_blit_rect *rect)
+{
+    if (!a->hsize || !a->vsize || !b->hsize || !b->vsize)
+        return false;
+    uint64_t hend = a->hoffset + a->hsize;
+    if (b->hoffset + b->hsize < hend)
+        hend = b->hoffset + b->hsize;
+    uint64_t vend = a->voffset + a->vsize;
+    if (b->voffset + b->vsize < vend)
+        vend = b->voffset + b->vsize;
+    rect->hoffset = a->hoffset > b->hoffset ? a->hoffset : b->hoffset;
+    rect->voffset = a->voffset > b->voffset ? a->voffset : b->voffset;
+    if (hend <= rect->hoffset || vend <= rect->voffset)
+        return false;
+    rect->hsize = hend - rect->hoffset;
+    rect->vsize = vend - rect->voffset;
+    return true;
+}
+
+/** @internal @This blits part of the subpicture into a picture.
 *
 * @param upipe description structure of the pipe
-* @param uref uref structure
+* @param ubuf picture to blit into
+* @param rect part of the output picture to blit, or NULL for the whole
+* subpicture
 */
-static void upipe_blit_sub_work(struct upipe *upipe, struct uref *uref)
+static void upipe_blit_sub_work(struct upipe *upipe, struct ubuf *ubuf,
+                                const struct upipe_blit_rect *rect)
 {
     struct upipe_blit_sub *sub = upipe_blit_sub_from_upipe(upipe);
     if (unlikely(sub->ubuf == NULL))
         return;
 
-    int err = uref_pic_blit(uref, sub->ubuf, sub->hposition, sub->vposition,
-                            0, 0, sub->hsize, sub->vsize, sub->alpha,
+    struct upipe_blit_rect sub_rect, blit_rect;
+    upipe_blit_sub_rect(upipe, &sub_rect);
+    if (rect == NULL)
+        blit_rect = sub_rect;
+    else if (!upipe_blit_rect_intersect(&sub_rect, rect, &blit_rect))
+        return;
+
+    int err = ubuf_pic_blit(ubuf, sub->ubuf,
+                            blit_rect.hoffset, blit_rect.voffset,
+                            blit_rect.hoffset - sub_rect.hoffset,
+                            blit_rect.voffset - sub_rect.voffset,
+                            blit_rect.hsize, blit_rect.vsize, sub->alpha,
                             sub->alpha_threshold);
     if (unlikely(!ubase_check(err))) {
         upipe_warn(upipe, "unable to blit picture");
@@ -209,6 +292,36 @@ static void upipe_blit_sub_work(struct upipe *upipe, struct uref *uref)
     }
 }
 
+/** @internal @This checks whether two pictures share the same buffers, as
+ * is the case for the references of a persistent subpicture.
+ *
+ * @param a first picture
+ * @param b second picture
+ * @return true if all the planes of both pictures are the same memory
+ */
+static bool upipe_blit_same_buffers(struct ubuf *a, struct ubuf *b)
+{
+    if (a == NULL || b == NULL)
+        return false;
+
+    const char *chroma = NULL;
+    while (ubase_check(ubuf_pic_plane_iterate(a, &chroma)) &&
+           chroma != NULL) {
+        const uint8_t *a_buf, *b_buf;
+        if (!ubase_check(ubuf_pic_plane_read(a, chroma, 0, 0, -1, -1,
+                                             &a_buf)))
+            return false;
+        ubuf_pic_plane_unmap(a, chroma, 0, 0, -1, -1);
+        if (!ubase_check(ubuf_pic_plane_read(b, chroma, 0, 0, -1, -1,
+                                             &b_buf)))
+            return false;
+        ubuf_pic_plane_unmap(b, chroma, 0, 0, -1, -1);
+        if (a_buf != b_buf)
+            return false;
+    }
+    return true;
+}
+
 /** @internal @This receives data.
 *
 * @param upipe description structure of the pipe
@@ -242,9 +355,13 @@ static void upipe_blit_sub_input(struct upipe *upipe, struct uref *uref,
         return;
     }
 
-    ubuf_free(sub->ubuf);
-    sub->ubuf = uref_detach_ubuf(uref);
+    struct ubuf *ubuf = uref_detach_ubuf(uref);
     uref_free(uref);
+    /* a subpicture repeated by reference needs not be composed again */
+    if (!upipe_blit_same_buffers(sub->ubuf, ubuf))
+        sub->dirty = true;
+    ubuf_free(sub->ubuf);
+    sub->ubuf = ubuf;
 }
 
 /** @internal @This provides a flow format suggestion.
@@ -478,6 +595,7 @@ static int upipe_blit_sub_set_flow_def(struct upipe *upipe,
 
     ubuf_free(sub->ubuf);
     sub->ubuf = NULL;
+    sub->dirty = true;
 
     return UBASE_ERR_NONE;
 }
@@ -548,6 +666,8 @@ static int _upipe_blit_sub_get_alpha(struct upipe *upipe, uint8_t *alpha_p)
 static int _upipe_blit_sub_set_alpha(struct upipe *upipe, uint8_t alpha)
 {
     struct upipe_blit_sub *sub = upipe_blit_sub_from_upipe(upipe);
+    if (sub->alpha != alpha)
+        sub->dirty = true;
     sub->alpha = alpha;
     return UBASE_ERR_NONE;
 }
@@ -577,6 +697,8 @@ static int _upipe_blit_sub_set_alpha_threshold(struct upipe *upipe,
         uint8_t threshold)
 {
     struct upipe_blit_sub *sub = upipe_blit_sub_from_upipe(upipe);
+    if (sub->alpha_threshold != threshold)
+        sub->dirty = true;
     sub->alpha_threshold = threshold;
     return UBASE_ERR_NONE;
 }
@@ -603,9 +725,11 @@ static int _upipe_blit_sub_get_z_index(struct upipe *upipe, int *z_index_p)
 static int _upipe_blit_sub_set_z_index(struct upipe *upipe, int z_index)
 {
     struct upipe_blit_sub *sub = upipe_blit_sub_from_upipe(upipe);
+    struct upipe_blit *upipe_blit = upipe_blit_from_sub_mgr(upipe->mgr);
+    if (sub->z_index != z_index && sub->composed.hsize)
+        upipe_blit_invalidate(upipe_blit_to_upipe(upipe_blit));
     sub->z_index = z_index;
 
-    struct upipe_blit *upipe_blit = upipe_blit_from_sub_mgr(upipe->mgr);
     upipe_blit_sort(upipe_blit_to_upipe(upipe_blit));
     return UBASE_ERR_NONE;
 }
@@ -727,6 +851,10 @@ static void upipe_blit_sub_free(struct upipe *upipe)
 {
     struct upipe_blit_sub *sub = upipe_blit_sub_from_upipe(upipe);
     upipe_throw_dead(upipe);
+    if (sub->composed.hsize) {
+        struct upipe_blit *upipe_blit = upipe_blit_from_sub_mgr(upipe->mgr);
+        upipe_blit_invalidate(upipe_blit_to_upipe(upipe_blit));
+    }
     ubuf_free(sub->ubuf);
     upipe_blit_sub_clean_sub(upipe);
     upipe_blit_sub_clean_urefcount(upipe);
@@ -773,6 +901,7 @@ static struct upipe *upipe_blit_alloc(struct upipe_mgr *mgr,
     upipe_blit_init_sub_subs(upipe);
     upipe_blit->hsize = upipe_blit->vsize = UINT64_MAX;
     upipe_blit->uref = NULL;
+    upipe_blit->composite = NULL;
 
     upipe_throw_ready(upipe);
     return upipe;
@@ -789,6 +918,18 @@ static void upipe_blit_sort(struct upipe *upipe)
     ulist_sort(&upipe_blit->subs, upipe_blit_sub_compare);
 }
 
+/** @internal @This discards the composed picture, so that the next picture
+ * is composed entirely.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_blit_invalidate(struct upipe *upipe)
+{
+    struct upipe_blit *upipe_blit = upipe_blit_from_upipe(upipe);
+    ubuf_free(upipe_blit->composite);
+    upipe_blit->composite = NULL;
+}
+
 /** @internal @This receives incoming uref.
  *
  * @param upipe description structure of the pipe
@@ -808,6 +949,7 @@ static void upipe_blit_input(struct upipe *upipe, struct uref *uref,
 
     uref_free(upipe_blit->uref);
     upipe_blit->uref = uref;
+    upipe_blit_invalidate(upipe);
 }
 
 /** @internal @This sets the input flow definition.
@@ -856,6 +998,7 @@ static int upipe_blit_set_flow_def(struct upipe *upipe, struct uref *flow_def)
     upipe_blit->hsize = hsize;
     upipe_blit->vsize = vsize;
     upipe_blit->sar = sar;
+    upipe_blit_invalidate(upipe);
 
     struct uchain *uchain;
     ulist_foreach (&upipe_blit->subs, uchain) {
@@ -865,7 +1008,68 @@ static int upipe_blit_set_flow_def(struct upipe *upipe, struct uref *flow_def)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This checks if the planes of a picture can be written.
+ *
+ * @param ubuf picture buffer
+ * @return true if all planes can be written
+ */
+static bool upipe_blit_writable(struct ubuf *ubuf)
+{
+    const char *chroma = NULL;
+    while (ubase_check(ubuf_pic_plane_iterate(ubuf, &chroma)) &&
+           chroma != NULL) {
+        if (!ubase_check(ubuf_pic_plane_write(ubuf, chroma, 0, 0, -1, -1,
+                                              NULL)) ||
+            !ubase_check(ubuf_pic_plane_unmap(ubuf, chroma, 0, 0, -1, -1)))
+            return false;
+    }
+    return true;
+}
+
+/** @internal @This composes again a rectangle of the composed picture, from
+ * the background and the subpictures covering it.
+ *
+ * @param upipe description structure of the pipe
+ * @param rect rectangle to compose
+ */
+static void upipe_blit_recompose(struct upipe *upipe,
+                                 const struct upipe_blit_rect *rect)
+{
+    struct upipe_blit *upipe_blit = upipe_blit_from_upipe(upipe);
+    struct ubuf *background = upipe_blit->uref->ubuf;
+    size_t hsize, vsize;
+    if (unlikely(!ubase_check(ubuf_pic_size(background, &hsize, &vsize,
+                                            NULL))))
+        return;
+
+    struct upipe_blit_rect frame = { 0, 0, hsize, vsize };
+    struct upipe_blit_rect damage;
+    if (!upipe_blit_rect_intersect(&frame, rect, &damage))
+        return;
+
+    int err = ubuf_pic_blit(upipe_blit->composite, background,
+                            damage.hoffset, damage.voffset,
+                            damage.hoffset, damage.voffset,
+                            damage.hsize, damage.vsize, 0xff, 0);
+    if (unlikely(!ubase_check(err))) {
+        upipe_warn(upipe, "unable to restore background");
+        upipe_throw_error(upipe, err);
+        return;
+    }
+
+    struct uchain *uchain;
+    ulist_foreach (&upipe_blit->subs, uchain) {
+        struct upipe_blit_sub *sub = upipe_blit_sub_from_uchain(uchain);
+        upipe_blit_sub_work(upipe_blit_sub_to_upipe(sub),
+                            upipe_blit->composite, &damage);
+    }
+}
+
 /** @internal @This prepares the next picture to output.
+ *
+ * The composed picture is kept between calls. As long as the background is
+ * the same, only the rectangles of the subpictures that changed are composed
+ * again, and the picture is only copied if it is still in use downstream.
  *
  * @param upipe description structure of the pipe
  * @param upump_p reference to pump that generated the buffer
@@ -877,6 +1081,8 @@ static int _upipe_blit_prepare(struct upipe *upipe, struct upump **upump_p)
     if (unlikely(upipe_blit->uref == NULL))
         return UBASE_ERR_INVALID;
     struct uref *uref = uref_dup(upipe_blit->uref);
+    if (unlikely(uref == NULL))
+        return UBASE_ERR_ALLOC;
 
     struct uchain *uchain;
     bool subpic = false;
@@ -890,38 +1096,61 @@ static int _upipe_blit_prepare(struct upipe *upipe, struct upump **upump_p)
 
     /* Avoid copying the picture if there is nothing to blit */
     if (!subpic) {
+        upipe_blit_invalidate(upipe);
         upipe_blit_output(upipe, uref, upump_p);
         return UBASE_ERR_NONE;
     }
 
-    /* Check if we can write on the planes */
-    bool writable = true;
-    const char *chroma = NULL;
-    while (ubase_check(uref_pic_plane_iterate(uref, &chroma)) &&
-           chroma != NULL) {
-        if (!ubase_check(uref_pic_plane_write(uref, chroma, 0, 0, -1, -1,
-                                              NULL)) ||
-            !ubase_check(uref_pic_plane_unmap(uref, chroma, 0, 0, -1, -1))) {
-            writable = false;
-            break;
+    if (upipe_blit->composite == NULL) {
+        /* Compose the whole picture, keeping the background intact */
+        upipe_blit->composite = ubuf_pic_copy(uref->ubuf->mgr, uref->ubuf,
+                                              0, 0, -1, -1);
+        if (unlikely(upipe_blit->composite == NULL)) {
+            uref_free(uref);
+            return UBASE_ERR_ALLOC;
         }
-    }
 
-    if (!writable) {
-        struct ubuf *ubuf = ubuf_pic_copy(uref->ubuf->mgr, uref->ubuf,
-                                          0, 0, -1, -1);
-        if (unlikely(ubuf == NULL)) {
-            uref_free(uref);
-            return UBASE_ERR_ALLOC;;
+        ulist_foreach (&upipe_blit->subs, uchain) {
+            struct upipe_blit_sub *sub = upipe_blit_sub_from_uchain(uchain);
+            struct upipe *upipe_sub = upipe_blit_sub_to_upipe(sub);
+            upipe_blit_sub_work(upipe_sub, upipe_blit->composite, NULL);
+            upipe_blit_sub_rect(upipe_sub, &sub->composed);
+            sub->dirty = false;
         }
-        uref_attach_ubuf(uref, ubuf);
-    }
+    } else {
+        /* Only compose again the rectangles that changed */
+        ulist_foreach (&upipe_blit->subs, uchain) {
+            struct upipe_blit_sub *sub = upipe_blit_sub_from_uchain(uchain);
+            if (!sub->dirty)
+                continue;
+
+            if (!upipe_blit_writable(upipe_blit->composite)) {
+                struct ubuf *ubuf = ubuf_pic_copy(upipe_blit->composite->mgr,
+                                                  upipe_blit->composite,
+                                                  0, 0, -1, -1);
+                if (unlikely(ubuf == NULL)) {
+                    uref_free(uref);
+                    return UBASE_ERR_ALLOC;
+                }
+                ubuf_free(upipe_blit->composite);
+                upipe_blit->composite = ubuf;
+            }
 
-    ulist_foreach (&upipe_blit->subs, uchain) {
-        struct upipe_blit_sub *sub = upipe_blit_sub_from_uchain(uchain);
-        upipe_blit_sub_work(upipe_blit_sub_to_upipe(sub), uref);
+            struct upipe_blit_rect rect;
+            upipe_blit_sub_rect(upipe_blit_sub_to_upipe(sub), &rect);
+            upipe_blit_recompose(upipe, &sub->composed);
+            upipe_blit_recompose(upipe, &rect);
+            sub->composed = rect;
+            sub->dirty = false;
+        }
     }
 
+    struct ubuf *ubuf = ubuf_dup(upipe_blit->composite);
+    if (unlikely(ubuf == NULL)) {
+        uref_free(uref);
+        return UBASE_ERR_ALLOC;
+    }
+    uref_attach_ubuf(uref, ubuf);
     upipe_blit_output(upipe, uref, upump_p);
     return UBASE_ERR_NONE;
 }
@@ -965,6 +1194,7 @@ static void upipe_blit_free(struct upipe *upipe)
 
     struct upipe_blit *upipe_blit = upipe_blit_from_upipe(upipe);
     uref_free(upipe_blit->uref);
+    ubuf_free(upipe_blit->composite);
     upipe_blit_clean_sub_subs(upipe);
     upipe_blit_clean_output(upipe);
     upipe_blit_clean_urefcount(upipe);
@@ -47,6 +47,8 @@
 #include <upipe/upipe_helper_ubuf_mgr.h>
 #include <upipe-modules/upipe_block_to_sound.h>
 
+#include "upipe_pcm_convert.h"
+
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -89,6 +91,11 @@ struct upipe_block_to_sound {
     /**  data to set flow_def and ubuf */
     uint8_t sample_size;
     uint8_t planes;
+
+    /** size of an input sample, in octets */
+    uint8_t in_size;
+    /** conversion of input samples to s32 */
+    upipe_pcm_to_s32_func convert;
 };
 
 UPIPE_HELPER_UPIPE(upipe_block_to_sound, upipe, UPIPE_BLOCK_TO_SOUND_SIGNATURE);
@@ -101,6 +108,18 @@ UPIPE_HELPER_UBUF_MGR(upipe_block_to_sound, ubuf_mgr, flow_format, ubuf_mgr_requ
                       upipe_block_to_sound_unregister_output_request)
 
 
+/** @internal @This copies native s32 samples.
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+static void upipe_block_to_sound_copy(int32_t *dst, const uint8_t *src,
+                                      size_t samples)
+{
+    memcpy(dst, src, samples * sizeof (int32_t));
+}
+
 /** @internal @This allocates a block_to_sound pipe.
  *
  * @param mgr common management structure
@@ -138,6 +157,8 @@ static struct upipe *upipe_block_to_sound_alloc(struct upipe_mgr *mgr,
     }
 
     upipe_block_to_sound->flow_def_config = flow_def;
+    upipe_block_to_sound->in_size = 4;
+    upipe_block_to_sound->convert = upipe_block_to_sound_copy;
 
     upipe_block_to_sound_init_urefcount(upipe);
     upipe_block_to_sound_init_output(upipe);
@@ -163,13 +184,16 @@ static void upipe_block_to_sound_input(struct upipe *upipe, struct uref *uref, s
     size_t block_size = 0;
     uref_block_size(uref, &block_size);
 
+    /* size of the input samples of all channels */
+    size_t in_frame = upipe_block_to_sound->in_size *
+                      (upipe_block_to_sound->sample_size / 4);
+
     /* drop incomplete samples */
-    if ((block_size % upipe_block_to_sound->sample_size) != 0) {
+    if ((block_size % in_frame) != 0) {
         upipe_warn(upipe, "Incomplete samples detected");
     }
 
-    int samples = block_size / upipe_block_to_sound->sample_size;
-    block_size = samples * upipe_block_to_sound->sample_size;
+    int samples = block_size / in_frame;
 
     /* alloc sound ubuf */
     struct ubuf *ubuf_block_to_sound = ubuf_sound_alloc(upipe_block_to_sound->ubuf_mgr,
@@ -194,23 +218,43 @@ static void upipe_block_to_sound_input(struct upipe *upipe, struct uref *uref, s
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return;
     }
-    /* map block ubuf for reading */
-    const uint8_t *r;
-    int end = -1;
-    if (unlikely(!ubase_check(uref_block_read(uref, 0, &end, &r)))) {
-        upipe_err(upipe, "could not read uref, dropping samples");
-        ubuf_sound_unmap(ubuf_block_to_sound, 0, -1, upipe_block_to_sound->planes);
-        ubuf_block_unmap(uref->ubuf, 0);
-        ubuf_free(ubuf_block_to_sound);
-        uref_free(uref);
-        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        return;
+
+    /* convert block to sound, segment by segment */
+    size_t in_size = upipe_block_to_sound->in_size;
+    size_t remaining = samples * (upipe_block_to_sound->sample_size / 4);
+    int offset = 0;
+    while (remaining) {
+        const uint8_t *r;
+        int size = -1;
+        if (unlikely(!ubase_check(uref_block_read(uref, offset, &size, &r)))) {
+            upipe_err(upipe, "could not read uref, dropping samples");
+            ubuf_sound_unmap(ubuf_block_to_sound, 0, -1, upipe_block_to_sound->planes);
+            ubuf_free(ubuf_block_to_sound);
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        size_t n = size / in_size;
+        if (n > remaining)
+            n = remaining;
+        upipe_block_to_sound->convert(w, r, n);
+        uref_block_unmap(uref, offset);
+        offset += n * in_size;
+        w += n;
+        remaining -= n;
+
+        if (remaining && n * in_size < size) {
+            /* sample straddling two segments */
+            uint8_t straddle[4];
+            uref_block_extract(uref, offset, in_size, straddle);
+            upipe_block_to_sound->convert(w, straddle, 1);
+            offset += in_size;
+            w++;
+            remaining--;
+        }
     }
-    /* copy block to sound */
-    memcpy(w, r, block_size);
     /* unmap ubufs */
     ubuf_sound_unmap(ubuf_block_to_sound, 0, -1, upipe_block_to_sound->planes);
-    ubuf_block_unmap(uref->ubuf, 0);
     /* attach sound ubuf to uref */
     uref_attach_ubuf(uref, ubuf_block_to_sound);
     /* output pipe */
@@ -237,6 +281,21 @@ static int upipe_block_to_sound_set_flow_def(struct upipe *upipe,
         return UBASE_ERR_INVALID;
     }
 
+    /* big-endian PCM input is converted, anything else is native s32 */
+    if (ubase_check(uref_flow_match_def(flow_def, "block.s16be."))) {
+        upipe_block_to_sound->in_size = 2;
+        upipe_block_to_sound->convert = upipe_pcm_s16be_to_s32;
+    } else if (ubase_check(uref_flow_match_def(flow_def, "block.s24be."))) {
+        upipe_block_to_sound->in_size = 3;
+        upipe_block_to_sound->convert = upipe_pcm_s24be_to_s32;
+    } else if (ubase_check(uref_flow_match_def(flow_def, "block.s32be."))) {
+        upipe_block_to_sound->in_size = 4;
+        upipe_block_to_sound->convert = upipe_pcm_s32be_to_s32;
+    } else {
+        upipe_block_to_sound->in_size = 4;
+        upipe_block_to_sound->convert = upipe_block_to_sound_copy;
+    }
+
     flow_def = uref_dup(upipe_block_to_sound->flow_def_config);
     if (unlikely(flow_def == NULL)) {
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
@@ -251,6 +251,7 @@ static void upipe_buffer_worker(struct upump *upump)
     ubase_assert(uref_block_size(uref, &block_size));
     assert(upipe_buffer->size >= block_size);
     upipe_buffer->size -= block_size;
+    upipe_stats_unhold(upipe, uref);
     upipe_buffer_update(upipe);
 
     upipe_buffer_output(upipe, uref, &upipe_buffer->upump);
@@ -333,6 +334,7 @@ static bool upipe_buffer_process(struct upipe *upipe,
 
     upipe_buffer->size += block_size;
     ulist_add(&upipe_buffer->buffered, uref_to_uchain(uref));
+    upipe_stats_hold(upipe, uref);
     upipe_buffer_update(upipe);
     return true;
 }
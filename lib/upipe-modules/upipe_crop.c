@@ -156,8 +156,25 @@ static void upipe_crop_input(struct upipe *upipe, struct uref *uref,
         return;
     }
 
-    UBASE_ERROR(upipe, uref_pic_resize(uref, crop->hskip, crop->vskip,
-                                       crop->out_hsize, crop->out_vsize))
+    if (crop->hskip || crop->vskip ||
+        crop->out_hsize != hsize || crop->out_vsize != vsize) {
+        /* crop is a view on the shared buffer, and only falls back to a
+         * copy if the ubuf manager cannot resize it */
+        int err = uref_pic_resize(uref, crop->hskip, crop->vskip,
+                                  crop->out_hsize, crop->out_vsize);
+        if (unlikely(!ubase_check(err))) {
+            upipe_verbose(upipe, "copying subpicture");
+            err = uref_pic_replace(uref, uref->ubuf->mgr,
+                                   crop->hskip, crop->vskip,
+                                   crop->out_hsize, crop->out_vsize);
+        }
+        if (unlikely(!ubase_check(err))) {
+            upipe_warn(upipe, "unable to crop picture");
+            upipe_throw_error(upipe, err);
+            uref_free(uref);
+            return;
+        }
+    }
 
     upipe_crop_output(upipe, uref, upump_p);
 }
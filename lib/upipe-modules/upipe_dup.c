@@ -235,16 +235,18 @@ static void upipe_dup_input(struct upipe *upipe, struct uref *uref,
                             struct upump **upump_p)
 {
     struct upipe_dup *upipe_dup = upipe_dup_from_upipe(upipe);
-    struct upipe *output = upipe_dup->output;
+    struct upipe *main_output = upipe_dup->output;
     struct uchain *uchain;
     ulist_foreach (&upipe_dup->outputs, uchain) {
         struct upipe_dup_output *upipe_dup_output =
             upipe_dup_output_from_uchain(uchain);
         struct upipe *output = upipe_dup_output_to_upipe(upipe_dup_output);
-        if (ulist_is_last(&upipe_dup->outputs, uchain) && !output) {
+        if (ulist_is_last(&upipe_dup->outputs, uchain) && !main_output) {
+            /* the last output takes over the original uref */
             upipe_dup_output_output(output, uref, upump_p);
             uref = NULL;
         } else {
+            /* buffers and attributes are shared copy-on-write */
             struct uref *new_uref = uref_dup(uref);
             if (unlikely(new_uref == NULL)) {
                 uref_free(uref);
@@ -255,7 +257,7 @@ static void upipe_dup_input(struct upipe *upipe, struct uref *uref,
         }
     }
 
-    if (output)
+    if (main_output)
         upipe_dup_output(upipe, uref, upump_p);
     else if (uref != NULL)
         uref_free(uref);
@@ -29,6 +29,8 @@
  * @short Upipe sink module for files
  */
 
+#include <config.h>
+
 #include <upipe/ubase.h>
 #include <upipe/ulist.h>
 #include <upipe/uprobe.h>
@@ -48,6 +50,7 @@
 #include <upipe/upipe_helper_input.h>
 #include <upipe/upipe_helper_uclock.h>
 #include <upipe-modules/upipe_file_sink.h>
+#include <upump-uring/upump_uring.h>
 
 #include <stdlib.h>
 #include <stdbool.h>
@@ -59,6 +62,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <errno.h>
 #include <assert.h>
 
@@ -69,6 +73,8 @@
 /** @hidden */
 static void upipe_fsink_watcher(struct upump *upump);
 /** @hidden */
+static void upipe_fsink_io_worker(struct upump *upump);
+/** @hidden */
 static bool upipe_fsink_output(struct upipe *upipe, struct uref *uref,
                                struct upump **upump_p);
 
@@ -83,6 +89,12 @@ struct upipe_fsink {
     struct upump *upump;
     /** sync watcher */
     struct upump *upump_sync;
+    /** asynchronous write pump, with an io_uring event loop */
+    struct upump *upump_io;
+    /** uref being written asynchronously */
+    struct uref *io_uref;
+    /** offset in the file of the next asynchronous write */
+    uint64_t io_offset;
 
     /** uclock structure, if not NULL we are in live mode */
     struct uclock *uclock;
@@ -97,6 +109,22 @@ struct upipe_fsink {
     char *path;
     /** sync period */
     uint64_t sync_period;
+    /** direct I/O chunk size, or 0 */
+    unsigned int direct_size;
+    /** number of octets to preallocate when opening a file */
+    uint64_t prealloc;
+    /** aligned buffer accumulating data in direct I/O mode */
+    uint8_t *direct_buf;
+    /** number of octets in the direct I/O buffer */
+    size_t direct_len;
+    /** current offset in the file in direct I/O mode */
+    uint64_t direct_offset;
+    /** true if O_DIRECT is set on the file descriptor */
+    bool direct;
+    /** true if the file system doesn't support O_DIRECT */
+    bool direct_unsupported;
+    /** true if the file descriptor is a regular file */
+    bool regular_file;
 
     /** temporary uref storage */
     struct uchain urefs;
@@ -117,6 +145,7 @@ UPIPE_HELPER_VOID(upipe_fsink)
 UPIPE_HELPER_UPUMP_MGR(upipe_fsink, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_fsink, upump, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_fsink, upump_sync, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_fsink, upump_io, upump_mgr)
 UPIPE_HELPER_INPUT(upipe_fsink, urefs, nb_urefs, max_urefs, blockers, upipe_fsink_output)
 UPIPE_HELPER_UCLOCK(upipe_fsink, uclock, uclock_request, NULL, upipe_throw_provide_request, NULL)
 
@@ -141,12 +170,23 @@ static struct upipe *upipe_fsink_alloc(struct upipe_mgr *mgr,
     upipe_fsink_init_upump_mgr(upipe);
     upipe_fsink_init_upump(upipe);
     upipe_fsink_init_upump_sync(upipe);
+    upipe_fsink_init_upump_io(upipe);
     upipe_fsink_init_input(upipe);
     upipe_fsink_init_uclock(upipe);
     upipe_fsink->latency = 0;
     upipe_fsink->fd = -1;
     upipe_fsink->path = NULL;
     upipe_fsink->sync_period = 0;
+    upipe_fsink->direct_size = 0;
+    upipe_fsink->prealloc = 0;
+    upipe_fsink->direct_buf = NULL;
+    upipe_fsink->direct_len = 0;
+    upipe_fsink->direct_offset = 0;
+    upipe_fsink->direct = false;
+    upipe_fsink->direct_unsupported = false;
+    upipe_fsink->regular_file = false;
+    upipe_fsink->io_uref = NULL;
+    upipe_fsink->io_offset = 0;
     upipe_throw_ready(upipe);
     return upipe;
 }
@@ -174,6 +214,294 @@ static void upipe_fsink_poll(struct upipe *upipe)
     }
 }
 
+/** @internal @This sets or clears O_DIRECT on the file descriptor.
+ *
+ * @param upipe description structure of the pipe
+ * @param direct true to set O_DIRECT
+ * @return false if O_DIRECT is not supported
+ */
+static bool upipe_fsink_set_odirect(struct upipe *upipe, bool direct)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (upipe_fsink->direct == direct)
+        return true;
+    if (direct && upipe_fsink->direct_unsupported)
+        return false;
+
+#ifdef O_DIRECT
+    int flags = fcntl(upipe_fsink->fd, F_GETFL);
+    if (likely(flags != -1) &&
+        likely(fcntl(upipe_fsink->fd, F_SETFL,
+                     direct ? flags | O_DIRECT : flags & ~O_DIRECT) != -1)) {
+        upipe_fsink->direct = direct;
+        return true;
+    }
+#endif
+    if (direct) {
+        upipe_warn_va(upipe, "direct I/O not supported on %s",
+                      upipe_fsink->path);
+        upipe_fsink->direct_unsupported = true;
+    }
+    return false;
+}
+
+/** @internal @This writes the content of the direct I/O buffer. Unless
+ * final is true, only writes aligned chunks and keeps the remainder in the
+ * buffer.
+ *
+ * @param upipe description structure of the pipe
+ * @param final true to write all the buffered data
+ * @return false in case of write error, with errno set
+ */
+static bool upipe_fsink_direct_write(struct upipe *upipe, bool final)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    while (upipe_fsink->direct_len) {
+        size_t size = upipe_fsink->direct_len;
+        size_t head = upipe_fsink->direct_offset % UPIPE_FSINK_DIRECT_ALIGN;
+        if (final || head) {
+            /* unaligned part, written through the page cache */
+            upipe_fsink_set_odirect(upipe, false);
+            if (!final && size > UPIPE_FSINK_DIRECT_ALIGN - head)
+                size = UPIPE_FSINK_DIRECT_ALIGN - head;
+        } else {
+            size -= size % UPIPE_FSINK_DIRECT_ALIGN;
+            if (!size)
+                break;
+            upipe_fsink_set_odirect(upipe, true);
+        }
+
+        ssize_t ret = write(upipe_fsink->fd, upipe_fsink->direct_buf, size);
+        if (unlikely(ret == -1)) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        /* keep the beginning of the buffer aligned in memory */
+        memmove(upipe_fsink->direct_buf, upipe_fsink->direct_buf + ret,
+                upipe_fsink->direct_len - ret);
+        upipe_fsink->direct_len -= ret;
+        upipe_fsink->direct_offset += ret;
+    }
+    return true;
+}
+
+/** @internal @This prepares a newly opened file for direct I/O and
+ * preallocation.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fsink_direct_open(struct upipe *upipe)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    upipe_fsink->direct = false;
+    upipe_fsink->direct_unsupported = false;
+    upipe_fsink->direct_len = 0;
+    if (!upipe_fsink->direct_size && !upipe_fsink->prealloc)
+        return;
+
+    off_t offset = lseek(upipe_fsink->fd, 0, SEEK_CUR);
+    if (unlikely(offset == (off_t)-1))
+        return;
+    upipe_fsink->direct_offset = offset;
+
+    if (upipe_fsink->prealloc) {
+#ifdef FALLOC_FL_KEEP_SIZE
+        if (unlikely(fallocate(upipe_fsink->fd, FALLOC_FL_KEEP_SIZE, offset,
+                               upipe_fsink->prealloc) == -1))
+            upipe_warn_va(upipe, "can't preallocate %s (%m)",
+                          upipe_fsink->path);
+#else
+        upipe_warn(upipe, "preallocation is not supported");
+#endif
+    }
+
+    if (upipe_fsink->direct_size && upipe_fsink->direct_buf == NULL) {
+        void *buffer;
+        if (unlikely(posix_memalign(&buffer, UPIPE_FSINK_DIRECT_ALIGN,
+                                    upipe_fsink->direct_size))) {
+            upipe_warn(upipe, "can't allocate direct I/O buffer");
+            return;
+        }
+        upipe_fsink->direct_buf = buffer;
+    }
+}
+
+/** @internal @This writes the data remaining in the direct I/O buffer,
+ * before closing the file.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fsink_direct_close(struct upipe *upipe)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (upipe_fsink->direct_buf != NULL && upipe_fsink->fd != -1 &&
+        unlikely(!upipe_fsink_direct_write(upipe, true)))
+        upipe_warn_va(upipe, "write error to %s (%m)", upipe_fsink->path);
+    upipe_fsink->direct_len = 0;
+}
+
+/** @internal @This copies data to the direct I/O buffer, and writes it by
+ * chunks.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @return false in case of write error, with errno set
+ */
+static bool upipe_fsink_output_direct(struct upipe *upipe, struct uref *uref)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    size_t uref_size;
+    if (unlikely(!ubase_check(uref_block_size(uref, &uref_size)))) {
+        upipe_warn(upipe, "cannot read ubuf buffer");
+        return true;
+    }
+
+    size_t offset = 0;
+    while (offset < uref_size) {
+        size_t size = upipe_fsink->direct_size - upipe_fsink->direct_len;
+        if (size > uref_size - offset)
+            size = uref_size - offset;
+        if (unlikely(!ubase_check(uref_block_extract(uref, offset, size,
+                        upipe_fsink->direct_buf + upipe_fsink->direct_len)))) {
+            upipe_warn(upipe, "cannot read ubuf buffer");
+            return true;
+        }
+        upipe_fsink->direct_len += size;
+        offset += size;
+        if (upipe_fsink->direct_len == upipe_fsink->direct_size &&
+            unlikely(!upipe_fsink_direct_write(upipe, false)))
+            return false;
+    }
+    return true;
+}
+
+/** @internal @This checks whether a newly opened file is a regular file,
+ * which can be written asynchronously.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fsink_check_regular(struct upipe *upipe)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    struct stat st;
+    upipe_fsink->regular_file = fstat(upipe_fsink->fd, &st) != -1 &&
+                                S_ISREG(st.st_mode);
+}
+
+/** @internal @This allocates the asynchronous write pump if the file is a
+ * regular file and the event loop supports io_uring.
+ *
+ * @param upipe description structure of the pipe
+ * @return false if data must be written synchronously
+ */
+static bool upipe_fsink_check_io(struct upipe *upipe)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (upipe_fsink->upump_io != NULL)
+        return true;
+    if (!upipe_fsink->regular_file ||
+        !ubase_check(upipe_fsink_check_upump_mgr(upipe)))
+        return false;
+
+    off_t offset = lseek(upipe_fsink->fd, 0, SEEK_CUR);
+    if (unlikely(offset == (off_t)-1))
+        return false;
+    struct upump *upump = upump_uring_alloc_fd_io(upipe_fsink->upump_mgr,
+            upipe_fsink_io_worker, upipe, upipe->refcount, upipe_fsink->fd);
+    if (upump == NULL) {
+        /* don't try again until the next file */
+        upipe_fsink->regular_file = false;
+        return false;
+    }
+    upipe_fsink->io_offset = offset;
+    upipe_fsink_set_upump_io(upipe, upump);
+    upump_start(upump);
+    return true;
+}
+
+/** @internal @This submits an asynchronous write of the first segment of
+ * the given uref, at the current offset.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure, belonging to the callee
+ */
+static void upipe_fsink_submit(struct upipe *upipe, struct uref *uref)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    size_t uref_size;
+    if (unlikely(!ubase_check(uref_block_size(uref, &uref_size)) ||
+                 !uref_size)) {
+        uref_free(uref);
+        return;
+    }
+
+    const uint8_t *buffer;
+    int size = -1;
+    if (unlikely(!ubase_check(uref_block_read(uref, 0, &size, &buffer)))) {
+        uref_free(uref);
+        upipe_warn(upipe, "cannot read ubuf buffer");
+        return;
+    }
+    if (unlikely(!ubase_check(upump_uring_submit_write(upipe_fsink->upump_io,
+                        buffer, size, upipe_fsink->io_offset, -1)))) {
+        uref_block_unmap(uref, 0);
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+        return;
+    }
+    upipe_fsink->io_uref = uref;
+}
+
+/** @internal @This stops asynchronous writes, before closing the file or
+ * changing the event loop. The data in flight is written again
+ * synchronously, as the write may have been cancelled.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fsink_io_stop(struct upipe *upipe)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (upipe_fsink->upump_io == NULL)
+        return;
+    /* freeing the pump waits for the write in flight */
+    upipe_fsink_set_upump_io(upipe, NULL);
+
+    struct uref *uref = upipe_fsink->io_uref;
+    upipe_fsink->io_uref = NULL;
+    if (uref != NULL) {
+        uref_block_unmap(uref, 0);
+        for ( ; ; ) {
+            int iovec_count = uref_block_iovec_count(uref, 0, -1);
+            if (unlikely(iovec_count <= 0))
+                break;
+            struct iovec iovecs[iovec_count];
+            if (unlikely(!ubase_check(uref_block_iovec_read(uref, 0, -1,
+                                                            iovecs))))
+                break;
+            ssize_t ret = pwritev(upipe_fsink->fd, iovecs, iovec_count,
+                                  upipe_fsink->io_offset);
+            uref_block_iovec_unmap(uref, 0, -1, iovecs);
+            if (unlikely(ret == -1)) {
+                if (errno == EINTR)
+                    continue;
+                upipe_warn_va(upipe, "write error to %s (%m)",
+                              upipe_fsink->path);
+                break;
+            }
+            upipe_fsink->io_offset += ret;
+            size_t uref_size;
+            if (!ubase_check(uref_block_size(uref, &uref_size)) ||
+                uref_size <= ret)
+                break;
+            uref_block_resize(uref, ret, -1);
+        }
+        uref_free(uref);
+    }
+    /* asynchronous writes don't move the file position */
+    lseek(upipe_fsink->fd, upipe_fsink->io_offset, SEEK_SET);
+}
+
 /** @internal @This outputs data to the file sink.
  *
  * @param upipe description structure of the pipe
@@ -201,6 +529,10 @@ static bool upipe_fsink_output(struct upipe *upipe, struct uref *uref,
         return true;
     }
 
+    if (upipe_fsink->io_uref != NULL)
+        /* wait for the completion of the asynchronous write */
+        return false;
+
     if (likely(upipe_fsink->uclock == NULL))
         goto write_buffer;
 
@@ -218,6 +550,23 @@ static bool upipe_fsink_output(struct upipe *upipe, struct uref *uref,
     }
 
 write_buffer:
+    if (upipe_fsink->direct_buf != NULL) {
+        bool ret = upipe_fsink_output_direct(upipe, uref);
+        uref_free(uref);
+        if (likely(ret))
+            return true;
+        upipe_warn_va(upipe, "write error to %s (%m)", upipe_fsink->path);
+        upipe_fsink_set_upump(upipe, NULL);
+        upipe_fsink_set_upump_sync(upipe, NULL);
+        upipe_throw_sink_end(upipe);
+        return true;
+    }
+
+    if (upipe_fsink_check_io(upipe)) {
+        upipe_fsink_submit(upipe, uref);
+        return true;
+    }
+
     for ( ; ; ) {
         int iovec_count = uref_block_iovec_count(uref, 0, -1);
         if (unlikely(iovec_count == -1)) {
@@ -297,6 +646,53 @@ static void upipe_fsink_watcher(struct upump *upump)
     }
 }
 
+/** @internal @This is called when an asynchronous write completes.
+ * Write the remainder of the uref, or unqueue the queued buffers.
+ *
+ * @param upump description structure of the I/O pump
+ */
+static void upipe_fsink_io_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    struct uref *uref = upipe_fsink->io_uref;
+    upipe_fsink->io_uref = NULL;
+    uref_block_unmap(uref, 0);
+
+    ssize_t ret = -EIO;
+    upump_uring_get_result(upump, &ret);
+    if (unlikely(ret < 0)) {
+        uref_free(uref);
+        errno = -ret;
+        upipe_warn_va(upipe, "write error to %s (%m)", upipe_fsink->path);
+        upipe_fsink_set_upump(upipe, NULL);
+        upipe_fsink_set_upump_sync(upipe, NULL);
+        upipe_throw_sink_end(upipe);
+    } else {
+        upipe_fsink->io_offset += ret;
+        size_t uref_size;
+        if (ubase_check(uref_block_size(uref, &uref_size)) &&
+            uref_size > ret) {
+            /* short write */
+            uref_block_resize(uref, ret, -1);
+            upipe_fsink_submit(upipe, uref);
+            if (upipe_fsink->io_uref != NULL)
+                return;
+        } else
+            uref_free(uref);
+    }
+
+    if (upipe_fsink_check_input(upipe))
+        return;
+    upipe_fsink_output_input(upipe);
+    upipe_fsink_unblock_input(upipe);
+    if (upipe_fsink_check_input(upipe)) {
+        /* All packets have been output, release again the pipe that has been
+         * used in @ref upipe_fsink_input. */
+        upipe_release(upipe);
+    }
+}
+
 /** @internal @This is called when the file descriptor needs to be sync'ed.
  *
  * @param upump description structure of the timer
@@ -397,6 +793,8 @@ static int _upipe_fsink_set_path(struct upipe *upipe, const char *path,
     if (unlikely(upipe_fsink->fd != -1)) {
         if (likely(upipe_fsink->path != NULL))
             upipe_notice_va(upipe, "closing file %s", upipe_fsink->path);
+        upipe_fsink_io_stop(upipe);
+        upipe_fsink_direct_close(upipe);
         ubase_clean_fd(&upipe_fsink->fd);
     }
     ubase_clean_str(&upipe_fsink->path);
@@ -452,6 +850,8 @@ static int _upipe_fsink_set_path(struct upipe *upipe, const char *path,
             break;
     }
 
+    upipe_fsink_check_regular(upipe);
+
     upipe_fsink->path = strdup(path);
     if (unlikely(upipe_fsink->path == NULL)) {
         ubase_clean_fd(&upipe_fsink->fd);
@@ -461,6 +861,7 @@ static int _upipe_fsink_set_path(struct upipe *upipe, const char *path,
     if (!upipe_fsink_check_input(upipe))
         /* Use again the pipe that we previously released. */
         upipe_use(upipe);
+    upipe_fsink_direct_open(upipe);
     upipe_notice_va(upipe, "opening file %s in %s mode",
                     upipe_fsink->path, mode_desc);
     return UBASE_ERR_NONE;
@@ -481,6 +882,8 @@ static int _upipe_fsink_set_fd(struct upipe *upipe, int fd,
     if (unlikely(upipe_fsink->fd != -1)) {
         if (likely(upipe_fsink->path != NULL))
             upipe_notice_va(upipe, "closing file %s", upipe_fsink->path);
+        upipe_fsink_io_stop(upipe);
+        upipe_fsink_direct_close(upipe);
         ubase_clean_fd(&upipe_fsink->fd);
     }
     ubase_clean_str(&upipe_fsink->path);
@@ -526,9 +929,12 @@ static int _upipe_fsink_set_fd(struct upipe *upipe, int fd,
             break;
     }
 
+    upipe_fsink_check_regular(upipe);
+
     if (!upipe_fsink_check_input(upipe))
         /* Use again the pipe that we previously released. */
         upipe_use(upipe);
+    upipe_fsink_direct_open(upipe);
     upipe_notice_va(upipe, "opening file %s in %s mode",
                     upipe_fsink->path, mode_desc);
     return UBASE_ERR_NONE;
@@ -575,6 +981,30 @@ static int _upipe_fsink_get_sync_period(struct upipe *upipe, uint64_t *p)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the direct I/O chunk size.
+ *
+ * @param upipe description structure of the pipe
+ * @param direct_size size of chunks, or 0
+ * @return an error code
+ */
+static int _upipe_fsink_set_direct(struct upipe *upipe,
+                                   unsigned int direct_size)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (unlikely(direct_size % UPIPE_FSINK_DIRECT_ALIGN)) {
+        upipe_err_va(upipe, "invalid direct I/O chunk size %u", direct_size);
+        return UBASE_ERR_INVALID;
+    }
+    /* the current file is written through the page cache from now on */
+    upipe_fsink_direct_close(upipe);
+    if (upipe_fsink->fd != -1)
+        upipe_fsink_set_odirect(upipe, false);
+    free(upipe_fsink->direct_buf);
+    upipe_fsink->direct_buf = NULL;
+    upipe_fsink->direct_size = direct_size;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a file sink pipe.
  *
  * @param upipe description structure of the pipe
@@ -592,6 +1022,7 @@ static int  _upipe_fsink_control(struct upipe *upipe, int command, va_list args)
         case UPIPE_ATTACH_UPUMP_MGR:
             upipe_fsink_set_upump(upipe, NULL);
             upipe_fsink_set_upump_sync(upipe, NULL);
+            upipe_fsink_io_stop(upipe);
             return upipe_fsink_attach_upump_mgr(upipe);
         case UPIPE_ATTACH_UCLOCK:
             upipe_fsink_set_upump(upipe, NULL);
@@ -614,6 +1045,17 @@ static int  _upipe_fsink_control(struct upipe *upipe, int command, va_list args)
             return upipe_fsink_set_max_length(upipe, max_length);
         }
 
+        case UPIPE_GET_URI: {
+            const char **uri_p = va_arg(args, const char **);
+            return _upipe_fsink_get_path(upipe, uri_p);
+        }
+        case UPIPE_SET_URI: {
+            /* used by pipes writing through a generic sink manager */
+            const char *uri = va_arg(args, const char *);
+            if (uri != NULL && !strncmp(uri, "file://", strlen("file://")))
+                uri += strlen("file://");
+            return _upipe_fsink_set_path(upipe, uri, UPIPE_FSINK_OVERWRITE);
+        }
         case UPIPE_FSINK_GET_PATH: {
             UBASE_SIGNATURE_CHECK(args, UPIPE_FSINK_SIGNATURE)
             const char **path_p = va_arg(args, const char **);
@@ -646,6 +1088,22 @@ static int  _upipe_fsink_control(struct upipe *upipe, int command, va_list args)
             uint64_t *p = va_arg(args, uint64_t *);
             return _upipe_fsink_get_sync_period(upipe, p);
         }
+        case UPIPE_FSINK_SET_DIRECT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSINK_SIGNATURE)
+            unsigned int direct_size = va_arg(args, unsigned int);
+            return _upipe_fsink_set_direct(upipe, direct_size);
+        }
+        case UPIPE_FSINK_GET_DIRECT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSINK_SIGNATURE)
+            unsigned int *p = va_arg(args, unsigned int *);
+            *p = upipe_fsink_from_upipe(upipe)->direct_size;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_FSINK_SET_PREALLOCATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSINK_SIGNATURE)
+            upipe_fsink_from_upipe(upipe)->prealloc = va_arg(args, uint64_t);
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -663,10 +1121,11 @@ static int upipe_fsink_control(struct upipe *upipe, int command, va_list args)
 {
     UBASE_RETURN(_upipe_fsink_control(upipe, command, args));
 
-    if (unlikely(!upipe_fsink_check_input(upipe)))
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (unlikely(!upipe_fsink_check_input(upipe)) &&
+        upipe_fsink->io_uref == NULL)
         upipe_fsink_poll(upipe);
 
-    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
     if (upipe_fsink->sync_period && upipe_fsink->fd != -1) {
         if (unlikely(!ubase_check(upipe_fsink_check_upump_mgr(upipe)))) {
             upipe_err_va(upipe, "can't get upump_mgr");
@@ -696,17 +1155,21 @@ static void upipe_fsink_free(struct upipe *upipe)
 {
     struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
     if (likely(upipe_fsink->fd != -1)) {
+        upipe_fsink_io_stop(upipe);
         if (likely(upipe_fsink->path != NULL)) {
             upipe_notice_va(upipe, "closing file %s", upipe_fsink->path);
+            upipe_fsink_direct_close(upipe);
             close(upipe_fsink->fd);
         }
     }
     upipe_throw_dead(upipe);
 
+    free(upipe_fsink->direct_buf);
     free(upipe_fsink->path);
     upipe_fsink_clean_uclock(upipe);
     upipe_fsink_clean_upump(upipe);
     upipe_fsink_clean_upump_sync(upipe);
+    upipe_fsink_clean_upump_io(upipe);
     upipe_fsink_clean_upump_mgr(upipe);
     upipe_fsink_clean_input(upipe);
     upipe_fsink_clean_urefcount(upipe);
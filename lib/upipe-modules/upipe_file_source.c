@@ -39,6 +39,9 @@
 #include <upipe/uref_clock.h>
 #include <upipe/upump.h>
 #include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/umem_mmap.h>
 #include <upipe/upipe.h>
 #include <upipe/upipe_helper_upipe.h>
 #include <upipe/upipe_helper_urefcount.h>
@@ -51,10 +54,12 @@
 #include <upipe/upipe_helper_uclock.h>
 #include <upipe/upipe_helper_output_size.h>
 #include <upipe-modules/upipe_file_source.h>
+#include <upump-uring/upump_uring.h>
 
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <string.h>
 #include <unistd.h>
@@ -110,6 +115,8 @@ struct upipe_fsrc {
     struct upump_mgr *upump_mgr;
     /** read watcher */
     struct upump *upump;
+    /** buffer of the asynchronous read in flight, or NULL */
+    struct uref *io_uref;
     /** read size */
     unsigned int output_size;
 
@@ -123,6 +130,15 @@ struct upipe_fsrc {
     /** length to read */
     uint64_t length;
 
+    /** size of the mapping window, or 0 to use read() */
+    unsigned int mmap_size;
+    /** current mapping window, or NULL */
+    struct ubuf *map;
+    /** offset of the mapping window in the file */
+    uint64_t map_offset;
+    /** reading position, when a window is mapped */
+    uint64_t map_position;
+
     /** public upipe structure */
     struct upipe upipe;
     /** guard for upump */
@@ -174,9 +190,12 @@ static struct upipe *upipe_fsrc_alloc(struct upipe_mgr *mgr,
     upipe_fsrc_init_upump(upipe);
     upipe_fsrc_init_uclock(upipe);
     upipe_fsrc_init_output_size(upipe, UBUF_DEFAULT_SIZE);
+    upipe_fsrc->io_uref = NULL;
     upipe_fsrc->uri = NULL;
     upipe_fsrc->fd = -1;
     upipe_fsrc->length = (uint64_t)-1;
+    upipe_fsrc->mmap_size = 0;
+    upipe_fsrc->map = NULL;
     upipe_fsrc->safe = false;
     upipe_throw_ready(upipe);
     return upipe;
@@ -188,6 +207,12 @@ static void upipe_fsrc_set_upump_safe(struct upipe *upipe,
     struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
     upipe_fsrc->safe = false;
     upipe_fsrc_set_upump(upipe, upump);
+    /* freeing the pump waits for the asynchronous read in flight */
+    if (upipe_fsrc->io_uref != NULL) {
+        uref_block_unmap(upipe_fsrc->io_uref, 0);
+        uref_free(upipe_fsrc->io_uref);
+        upipe_fsrc->io_uref = NULL;
+    }
 }
 
 /** @internal @This returns the path of the currently opened file.
@@ -205,36 +230,64 @@ static int upipe_fsrc_get_uri(struct upipe *upipe, const char **path_p)
     return uref_uri_get_path(upipe_fsrc->uri, path_p);
 }
 
-/** @internal @This reads data from the source and outputs it.
- * It is called either when the idler triggers (permanent storage mode) or
- * when data is available on the file descriptor (live stream mode).
+/** @internal @This releases the current mapping window, and restores the
+ * reading position of the file descriptor.
  *
- * @param upump description structure of the read watcher
+ * @param upipe description structure of the pipe
  */
-static void upipe_fsrc_worker(struct upump *upump)
+static void upipe_fsrc_unmap(struct upipe *upipe)
 {
-    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
-    uint64_t systime = 0; /* to keep gcc quiet */
-    if (upipe_fsrc->uclock != NULL)
-        systime = uclock_now(upipe_fsrc->uclock);
-
-    if (!upipe_fsrc->length) {
-        const char *path;
-        if (ubase_check(upipe_fsrc_get_uri(upipe, &path)))
-            path = "(none)";
-        upipe_notice_va(upipe, "end of range %s", path);
-        upipe_fsrc_set_upump_safe(upipe, NULL);
-        ubase_clean_fd(&upipe_fsrc->fd);
-        upipe_throw_source_end(upipe);
+    if (upipe_fsrc->map == NULL)
         return;
-    }
+    if (upipe_fsrc->fd != -1)
+        lseek(upipe_fsrc->fd, upipe_fsrc->map_position, SEEK_SET);
+    ubuf_free(upipe_fsrc->map);
+    upipe_fsrc->map = NULL;
+}
+
+/** @internal @This checks the remaining length, and ends the source if the
+ * end of the range is reached.
+ *
+ * @param upipe description structure of the pipe
+ * @return false if there is nothing to read
+ */
+static bool upipe_fsrc_check_length(struct upipe *upipe)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    if (upipe_fsrc->length)
+        return true;
+
+    const char *path;
+    if (ubase_check(upipe_fsrc_get_uri(upipe, &path)))
+        path = "(none)";
+    upipe_notice_va(upipe, "end of range %s", path);
+    upipe_fsrc_set_upump_safe(upipe, NULL);
+    upipe_fsrc_unmap(upipe);
+    ubase_clean_fd(&upipe_fsrc->fd);
+    upipe_throw_source_end(upipe);
+    return false;
+}
+
+/** @internal @This allocates a buffer to read into, after checking the
+ * remaining length.
+ *
+ * @param upipe description structure of the pipe
+ * @param buffer_p filled in with a pointer to the mapped buffer
+ * @return pointer to a mapped uref, or NULL if there is nothing to read
+ */
+static struct uref *upipe_fsrc_alloc_buffer(struct upipe *upipe,
+                                            uint8_t **buffer_p)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    if (!upipe_fsrc_check_length(upipe))
+        return NULL;
 
     if (upipe_fsrc->length != (uint64_t)-1 &&
         upipe_fsrc->length < upipe_fsrc->output_size &&
         unlikely(upipe_fsrc_set_output_size(upipe, upipe_fsrc->length))) {
             upipe_err(upipe, "fail to set output size");
-            return;
+            return NULL;
     }
 
     struct uref *uref = uref_block_alloc(upipe_fsrc->uref_mgr,
@@ -242,22 +295,31 @@ static void upipe_fsrc_worker(struct upump *upump)
                                          upipe_fsrc->output_size);
     if (unlikely(uref == NULL)) {
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        return;
+        return NULL;
     }
 
-    uint8_t *buffer;
     int output_size = -1;
     if (unlikely(!ubase_check(uref_block_write(uref, 0, &output_size,
-                                               &buffer)))) {
+                                               buffer_p)))) {
         uref_free(uref);
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        return;
+        return NULL;
     }
     assert(output_size == upipe_fsrc->output_size);
+    return uref;
+}
 
-    ssize_t ret = read(upipe_fsrc->fd, buffer, upipe_fsrc->output_size);
-    uref_block_unmap(uref, 0);
-
+/** @internal @This outputs data read from the source.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref unmapped uref containing the data
+ * @param ret return value of the read, -1 with errno set in case of error
+ * @param systime date of the read
+ */
+static void upipe_fsrc_output_read(struct upipe *upipe, struct uref *uref,
+                                   ssize_t ret, uint64_t systime)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
     if (unlikely(ret == -1)) {
         uref_free(uref);
         switch (errno) {
@@ -302,6 +364,185 @@ static void upipe_fsrc_worker(struct upump *upump)
     }
 }
 
+/** @internal @This maps the window containing the reading position.
+ * In case of failure, the mapping mode is disabled.
+ *
+ * @param upipe description structure of the pipe
+ * @return false if the window couldn't be mapped, or the end of file is
+ * reached
+ */
+static bool upipe_fsrc_map(struct upipe *upipe)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    upipe_fsrc_unmap(upipe);
+
+    off_t position = lseek(upipe_fsrc->fd, 0, SEEK_CUR);
+    struct stat st;
+    if (unlikely(position == (off_t)-1 || fstat(upipe_fsrc->fd, &st) == -1)) {
+        upipe_warn(upipe, "can't get file position, reverting to read");
+        upipe_fsrc->mmap_size = 0;
+        return false;
+    }
+    if (position >= st.st_size)
+        /* let read() handle the end of file */
+        return false;
+
+    uint64_t offset = position & ~((uint64_t)umem_mmap_page_size() - 1);
+    uint64_t size = st.st_size - offset;
+    if (size > upipe_fsrc->mmap_size)
+        size = upipe_fsrc->mmap_size;
+
+    struct umem umem;
+    if (unlikely(!umem_mmap_file(&umem, upipe_fsrc->fd, offset, size))) {
+        upipe_warn(upipe, "can't map file (%m), reverting to read");
+        upipe_fsrc->mmap_size = 0;
+        return false;
+    }
+
+    struct ubuf *ubuf = ubuf_block_mem_alloc_from_umem(upipe_fsrc->ubuf_mgr,
+                                                       &umem);
+    if (unlikely(ubuf == NULL)) {
+        umem_free(&umem);
+        upipe_warn(upipe, "ubuf manager doesn't support mappings, "
+                   "reverting to read");
+        upipe_fsrc->mmap_size = 0;
+        return false;
+    }
+
+    upipe_fsrc->map = ubuf;
+    upipe_fsrc->map_offset = offset;
+    upipe_fsrc->map_position = position;
+    return true;
+}
+
+/** @internal @This outputs a buffer pointing to the mapping window, mapping
+ * the next window if needed.
+ *
+ * @param upipe description structure of the pipe
+ * @param systime date of the read
+ * @return false if the data must be read with read()
+ */
+static bool upipe_fsrc_output_mmap(struct upipe *upipe, uint64_t systime)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    size_t map_size = 0;
+    if (upipe_fsrc->map != NULL)
+        ubuf_block_size(upipe_fsrc->map, &map_size);
+    if ((upipe_fsrc->map == NULL ||
+         upipe_fsrc->map_position >= upipe_fsrc->map_offset + map_size) &&
+        !upipe_fsrc_map(upipe))
+        return false;
+    ubuf_block_size(upipe_fsrc->map, &map_size);
+
+    size_t offset = upipe_fsrc->map_position - upipe_fsrc->map_offset;
+    uint64_t size = map_size - offset;
+    if (size > upipe_fsrc->output_size)
+        size = upipe_fsrc->output_size;
+    if (size > upipe_fsrc->length)
+        size = upipe_fsrc->length;
+
+    struct uref *uref = uref_alloc(upipe_fsrc->uref_mgr);
+    struct ubuf *ubuf = ubuf_dup(upipe_fsrc->map);
+    if (unlikely(uref == NULL || ubuf == NULL ||
+                 !ubase_check(ubuf_block_resize(ubuf, offset, size)))) {
+        uref_free(uref);
+        if (ubuf != NULL)
+            ubuf_free(ubuf);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return true;
+    }
+    uref_attach_ubuf(uref, ubuf);
+    upipe_fsrc->map_position += size;
+    upipe_fsrc_output_read(upipe, uref, size, systime);
+    return true;
+}
+
+/** @internal @This reads data from the source and outputs it.
+ * It is called either when the idler triggers (permanent storage mode) or
+ * when data is available on the file descriptor (live stream mode).
+ *
+ * @param upump description structure of the read watcher
+ */
+static void upipe_fsrc_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    uint64_t systime = 0; /* to keep gcc quiet */
+    if (upipe_fsrc->uclock != NULL)
+        systime = uclock_now(upipe_fsrc->uclock);
+
+    if (upipe_fsrc->mmap_size && upipe_fsrc->regular_file &&
+        (!upipe_fsrc_check_length(upipe) ||
+         upipe_fsrc_output_mmap(upipe, systime)))
+        return;
+
+    uint8_t *buffer;
+    struct uref *uref = upipe_fsrc_alloc_buffer(upipe, &buffer);
+    if (unlikely(uref == NULL))
+        return;
+
+    ssize_t ret = read(upipe_fsrc->fd, buffer, upipe_fsrc->output_size);
+    uref_block_unmap(uref, 0);
+    upipe_fsrc_output_read(upipe, uref, ret, systime);
+}
+
+/** @internal @This submits an asynchronous read from the current position,
+ * in permanent storage mode with an io_uring event loop.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fsrc_submit(struct upipe *upipe)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    uint8_t *buffer;
+    struct uref *uref = upipe_fsrc_alloc_buffer(upipe, &buffer);
+    if (unlikely(uref == NULL))
+        return;
+
+    if (unlikely(!ubase_check(upump_uring_submit_read(upipe_fsrc->upump,
+                        buffer, upipe_fsrc->output_size, UINT64_MAX, -1)))) {
+        uref_block_unmap(uref, 0);
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+        return;
+    }
+    upipe_fsrc->io_uref = uref;
+}
+
+/** @internal @This outputs the data of a completed asynchronous read and
+ * submits the next one.
+ *
+ * @param upump description structure of the I/O pump
+ */
+static void upipe_fsrc_io_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    uint64_t systime = 0; /* to keep gcc quiet */
+    if (upipe_fsrc->uclock != NULL)
+        systime = uclock_now(upipe_fsrc->uclock);
+
+    struct uref *uref = upipe_fsrc->io_uref;
+    upipe_fsrc->io_uref = NULL;
+    ssize_t ret = -1;
+    errno = EIO;
+    if (ubase_check(upump_uring_get_result(upump, &ret)) && ret < 0) {
+        errno = -ret;
+        ret = -1;
+    }
+    uref_block_unmap(uref, 0);
+    upipe_fsrc_output_read(upipe, uref, ret, systime);
+
+    if (upipe_fsrc->upump != upump || upipe_fsrc->io_uref != NULL)
+        return;
+    if (upipe_fsrc->mmap_size) {
+        /* the mapping mode was enabled during the read */
+        upipe_fsrc_set_upump_safe(upipe, NULL);
+        upipe_fsrc_check(upipe, NULL);
+    } else
+        upipe_fsrc_submit(upipe);
+}
+
 /** @internal @This builds the flow definition.
  *
  * @param upipe description structure of the pipe
@@ -362,11 +603,22 @@ static int upipe_fsrc_check(struct upipe *upipe, struct uref *flow_format)
 
     if (upipe_fsrc->fd != -1 && upipe_fsrc->upump == NULL) {
         struct upump *upump;
-        if (upipe_fsrc->regular_file)
+        if (upipe_fsrc->regular_file) {
+            /* use asynchronous reads if the event loop supports them */
+            upump = upipe_fsrc->mmap_size ? NULL :
+                upump_uring_alloc_fd_io(upipe_fsrc->upump_mgr,
+                                        upipe_fsrc_io_worker, upipe,
+                                        upipe->refcount, upipe_fsrc->fd);
+            if (upump != NULL) {
+                upipe_fsrc_set_upump_safe(upipe, upump);
+                upump_start(upump);
+                upipe_fsrc_submit(upipe);
+                return UBASE_ERR_NONE;
+            }
             upump = upump_alloc_idler(upipe_fsrc->upump_mgr,
                                       upipe_fsrc_worker, upipe,
                                       upipe->refcount);
-        else
+        } else
             upump = upump_alloc_fd_read(upipe_fsrc->upump_mgr,
                                         upipe_fsrc_worker, upipe,
                                         upipe->refcount, upipe_fsrc->fd);
@@ -420,6 +672,7 @@ static int upipe_fsrc_open(struct upipe *upipe)
 static void upipe_fsrc_close(struct upipe *upipe)
 {
     struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    upipe_fsrc_unmap(upipe);
 
     if (unlikely(upipe_fsrc->fd != -1)) {
         const char *path;
@@ -514,6 +767,10 @@ static int _upipe_fsrc_get_position(struct upipe *upipe,
     assert(position_p != NULL);
     if (unlikely(upipe_fsrc->fd == -1))
         return UBASE_ERR_UNHANDLED;
+    if (upipe_fsrc->map != NULL) {
+        *position_p = upipe_fsrc->map_position;
+        return UBASE_ERR_NONE;
+    }
     off_t position = lseek(upipe_fsrc->fd, 0, SEEK_CUR);
     if (unlikely(position == (off_t)-1))
         return UBASE_ERR_EXTERNAL;
@@ -532,6 +789,10 @@ static int _upipe_fsrc_set_position(struct upipe *upipe, uint64_t position)
     struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
     if (unlikely(upipe_fsrc->fd == -1))
         return UBASE_ERR_UNHANDLED;
+    /* drop the asynchronous read in flight, it is restarted by check */
+    if (upipe_fsrc->io_uref != NULL)
+        upipe_fsrc_set_upump_safe(upipe, NULL);
+    upipe_fsrc_unmap(upipe);
     return lseek(upipe_fsrc->fd, position, SEEK_SET) != (off_t)-1 ?
         UBASE_ERR_NONE : UBASE_ERR_EXTERNAL;
 }
@@ -588,6 +849,30 @@ static int _upipe_fsrc_get_range(struct upipe *upipe,
     return _upipe_fsrc_get_length(upipe, length_p);
 }
 
+/** @internal @This sets the size of the mapping window.
+ *
+ * @param upipe description structure of the pipe
+ * @param window_size size of the mapping window, or 0 to disable mapping
+ * @return an error code
+ */
+static int _upipe_fsrc_set_mmap(struct upipe *upipe, unsigned int window_size)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    size_t page_size = umem_mmap_page_size();
+    if (window_size % page_size) {
+        if (unlikely(window_size > UINT_MAX - page_size))
+            return UBASE_ERR_INVALID;
+        window_size += page_size - window_size % page_size;
+    }
+
+    upipe_fsrc_unmap(upipe);
+    upipe_fsrc->mmap_size = window_size;
+    /* the pump is reallocated by check, unless a read is in flight */
+    if (upipe_fsrc->io_uref == NULL)
+        upipe_fsrc_set_upump_safe(upipe, NULL);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a file source pipe.
  *
  * @param upipe description structure of the pipe
@@ -651,6 +936,18 @@ static int _upipe_fsrc_control(struct upipe *upipe, int command, va_list args)
             return _upipe_fsrc_get_range(upipe, offset_p, length_p);
         }
 
+        case UPIPE_FSRC_SET_MMAP: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSRC_SIGNATURE)
+            unsigned int window_size = va_arg(args, unsigned int);
+            return _upipe_fsrc_set_mmap(upipe, window_size);
+        }
+        case UPIPE_FSRC_GET_MMAP: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSRC_SIGNATURE)
+            unsigned int *window_size_p = va_arg(args, unsigned int *);
+            *window_size_p = upipe_fsrc_from_upipe(upipe)->mmap_size;
+            return UBASE_ERR_NONE;
+        }
+
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -0,0 +1,655 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module converting the frame rate of a picture flow
+ *
+ * Output pictures are laid on a regular grid at the requested frame rate,
+ * and computed from the two input pictures surrounding each output date.
+ * In repeat mode the nearest input picture is output; in blend mode the two
+ * pictures are mixed according to the output phase. Whenever the output
+ * picture is an exact copy of an input picture, the ubuf is shared by
+ * reference instead of being copied.
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uclock.h>
+#include <upipe/uprobe.h>
+#include <upipe/uref.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_pic.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_pic.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_ubuf_mgr.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe/upipe_helper_input.h>
+#include <upipe-modules/upipe_framerate_conv.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/** number of bits of the blending weight */
+#define WEIGHT_BITS 8
+/** blending weight of the second picture for a phase of one */
+#define WEIGHT_ONE (1 << WEIGHT_BITS)
+
+/** @hidden */
+static bool upipe_framerate_conv_handle(struct upipe *upipe, struct uref *uref,
+                                        struct upump **upump_p);
+/** @hidden */
+static int upipe_framerate_conv_check(struct upipe *upipe,
+                                      struct uref *flow_format);
+
+/** @internal @This is the private context of a framerate_conv pipe. */
+struct upipe_framerate_conv {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** ubuf manager */
+    struct ubuf_mgr *ubuf_mgr;
+    /** flow format packet */
+    struct uref *flow_format;
+    /** ubuf manager request */
+    struct urequest ubuf_mgr_request;
+
+    /** output pipe */
+    struct upipe *output;
+    /** output flow definition */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** temporary uref storage (used during urequest) */
+    struct uchain urefs;
+    /** nb urefs in storage */
+    unsigned int nb_urefs;
+    /** max urefs in storage */
+    unsigned int max_urefs;
+    /** list of blockers (used during udeal) */
+    struct uchain blockers;
+
+    /** conversion mode */
+    enum upipe_framerate_conv_mode mode;
+    /** requested output frame rate, or 0/0 to keep the input rate */
+    struct urational fps;
+    /** input frame rate */
+    struct urational in_fps;
+    /** true if the input pictures may be blended */
+    bool blendable;
+
+    /** previous input picture */
+    struct uref *prev;
+    /** number of input pictures received since the flow definition */
+    uint64_t in_count;
+    /** number of pictures output since the flow definition */
+    uint64_t out_count;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_framerate_conv, upipe, UPIPE_FRAMERATE_CONV_SIGNATURE);
+UPIPE_HELPER_UREFCOUNT(upipe_framerate_conv, urefcount,
+                       upipe_framerate_conv_free)
+UPIPE_HELPER_VOID(upipe_framerate_conv)
+UPIPE_HELPER_OUTPUT(upipe_framerate_conv, output, flow_def, output_state,
+                    request_list)
+UPIPE_HELPER_UBUF_MGR(upipe_framerate_conv, ubuf_mgr, flow_format,
+                      ubuf_mgr_request, upipe_framerate_conv_check,
+                      upipe_framerate_conv_register_output_request,
+                      upipe_framerate_conv_unregister_output_request)
+UPIPE_HELPER_INPUT(upipe_framerate_conv, urefs, nb_urefs, max_urefs, blockers,
+                   upipe_framerate_conv_handle)
+
+/** @internal @This allocates a framerate_conv pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_framerate_conv_alloc(struct upipe_mgr *mgr,
+                                                struct uprobe *uprobe,
+                                                uint32_t signature,
+                                                va_list args)
+{
+    struct upipe *upipe = upipe_framerate_conv_alloc_void(mgr, uprobe,
+                                                          signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_framerate_conv *upipe_framerate_conv =
+        upipe_framerate_conv_from_upipe(upipe);
+    upipe_framerate_conv->mode = UPIPE_FRAMERATE_CONV_REPEAT;
+    upipe_framerate_conv->fps.num = upipe_framerate_conv->fps.den = 0;
+    upipe_framerate_conv->in_fps.num = upipe_framerate_conv->in_fps.den = 0;
+    upipe_framerate_conv->blendable = false;
+    upipe_framerate_conv->prev = NULL;
+    upipe_framerate_conv->in_count = 0;
+    upipe_framerate_conv->out_count = 0;
+
+    upipe_framerate_conv_init_urefcount(upipe);
+    upipe_framerate_conv_init_ubuf_mgr(upipe);
+    upipe_framerate_conv_init_output(upipe);
+    upipe_framerate_conv_init_input(upipe);
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This blends two lines of 8-bit samples.
+ *
+ * The loop is kept free of dependencies so that the compiler vectorizes it.
+ *
+ * @param out output line
+ * @param a first input line
+ * @param b second input line
+ * @param w weight of the second line, out of WEIGHT_ONE
+ * @param n number of samples
+ */
+static void upipe_framerate_conv_blend8(uint8_t *restrict out,
+                                        const uint8_t *restrict a,
+                                        const uint8_t *restrict b,
+                                        unsigned w, size_t n)
+{
+    const unsigned wa = WEIGHT_ONE - w;
+    for (size_t i = 0; i < n; i++)
+        out[i] = (a[i] * wa + b[i] * w + WEIGHT_ONE / 2) >> WEIGHT_BITS;
+}
+
+/** @internal @This blends two lines of 16-bit samples.
+ *
+ * @param out output line
+ * @param a first input line
+ * @param b second input line
+ * @param w weight of the second line, out of WEIGHT_ONE
+ * @param n number of samples
+ */
+static void upipe_framerate_conv_blend16(uint16_t *restrict out,
+                                         const uint16_t *restrict a,
+                                         const uint16_t *restrict b,
+                                         unsigned w, size_t n)
+{
+    const uint32_t wa = WEIGHT_ONE - w;
+    for (size_t i = 0; i < n; i++)
+        out[i] = (a[i] * wa + b[i] * w + WEIGHT_ONE / 2) >> WEIGHT_BITS;
+}
+
+/** @internal @This allocates a picture blending two input pictures.
+ *
+ * @param upipe description structure of the pipe
+ * @param a first input picture
+ * @param b second input picture
+ * @param w weight of the second picture, out of WEIGHT_ONE
+ * @return blended ubuf, or NULL in case of error
+ */
+static struct ubuf *upipe_framerate_conv_blend(struct upipe *upipe,
+                                               struct uref *a, struct uref *b,
+                                               unsigned w)
+{
+    struct upipe_framerate_conv *upipe_framerate_conv =
+        upipe_framerate_conv_from_upipe(upipe);
+    size_t hsize, vsize, b_hsize, b_vsize;
+    if (unlikely(!ubase_check(uref_pic_size(a, &hsize, &vsize, NULL)) ||
+                 !ubase_check(uref_pic_size(b, &b_hsize, &b_vsize, NULL)) ||
+                 hsize != b_hsize || vsize != b_vsize))
+        return NULL;
+
+    struct ubuf *ubuf = ubuf_pic_alloc(upipe_framerate_conv->ubuf_mgr,
+                                       hsize, vsize);
+    if (unlikely(ubuf == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
+
+    const char *chroma = NULL;
+    while (ubase_check(uref_pic_plane_iterate(a, &chroma)) && chroma) {
+        size_t a_stride, b_stride, out_stride;
+        uint8_t hsub, vsub, macropixel_size;
+        const uint8_t *a_buf, *b_buf;
+        uint8_t *out_buf;
+        if (unlikely(!ubase_check(uref_pic_plane_size(a, chroma, &a_stride,
+                            &hsub, &vsub, &macropixel_size)) ||
+                     !ubase_check(uref_pic_plane_size(b, chroma, &b_stride,
+                            NULL, NULL, NULL)) ||
+                     !ubase_check(ubuf_pic_plane_size(ubuf, chroma,
+                            &out_stride, NULL, NULL, NULL)))) {
+            upipe_warn_va(upipe, "unable to blend chroma %s", chroma);
+            ubuf_free(ubuf);
+            return NULL;
+        }
+        if (unlikely(!ubase_check(uref_pic_plane_read(a, chroma, 0, 0, -1, -1,
+                                                      &a_buf)))) {
+            ubuf_free(ubuf);
+            return NULL;
+        }
+        if (unlikely(!ubase_check(uref_pic_plane_read(b, chroma, 0, 0, -1, -1,
+                                                      &b_buf)))) {
+            uref_pic_plane_unmap(a, chroma, 0, 0, -1, -1);
+            ubuf_free(ubuf);
+            return NULL;
+        }
+        if (unlikely(!ubase_check(ubuf_pic_plane_write(ubuf, chroma,
+                            0, 0, -1, -1, &out_buf)))) {
+            uref_pic_plane_unmap(a, chroma, 0, 0, -1, -1);
+            uref_pic_plane_unmap(b, chroma, 0, 0, -1, -1);
+            ubuf_free(ubuf);
+            return NULL;
+        }
+
+        size_t width = hsize / hsub * macropixel_size;
+        for (size_t y = 0; y < vsize / vsub; y++) {
+            if (macropixel_size == 2)
+                upipe_framerate_conv_blend16((uint16_t *)out_buf,
+                        (const uint16_t *)a_buf, (const uint16_t *)b_buf,
+                        w, width / 2);
+            else
+                upipe_framerate_conv_blend8(out_buf, a_buf, b_buf, w, width);
+            a_buf += a_stride;
+            b_buf += b_stride;
+            out_buf += out_stride;
+        }
+
+        uref_pic_plane_unmap(a, chroma, 0, 0, -1, -1);
+        uref_pic_plane_unmap(b, chroma, 0, 0, -1, -1);
+        ubuf_pic_plane_unmap(ubuf, chroma, 0, 0, -1, -1);
+    }
+    return ubuf;
+}
+
+/** @internal @This outputs the pictures falling between the previous and the
+ * given input picture.
+ *
+ * Dates are expressed in units of 1 / (in_fps.num * fps.num) second, so that
+ * input picture i is at i * in_fps.den * fps.num and output picture n is at
+ * n * fps.den * in_fps.num, without any rounding.
+ *
+ * @param upipe description structure of the pipe
+ * @param next input picture following the previous one
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_framerate_conv_work(struct upipe *upipe, struct uref *next,
+                                      struct upump **upump_p)
+{
+    struct upipe_framerate_conv *upipe_framerate_conv =
+        upipe_framerate_conv_from_upipe(upipe);
+    struct urational in_fps = upipe_framerate_conv->in_fps;
+    struct urational fps = upipe_framerate_conv->fps;
+    struct uref *prev = upipe_framerate_conv->prev;
+    uint64_t in_step = in_fps.den * fps.num;
+    uint64_t out_step = fps.den * in_fps.num;
+    uint64_t start = (upipe_framerate_conv->in_count - 1) * in_step;
+    uint64_t end = start + in_step;
+
+    for ( ; ; ) {
+        uint64_t date = upipe_framerate_conv->out_count * out_step;
+        if (date >= end)
+            break;
+        uint64_t phase = date - start;
+        upipe_framerate_conv->out_count++;
+
+        unsigned w = (phase * WEIGHT_ONE + in_step / 2) / in_step;
+        if (upipe_framerate_conv->mode != UPIPE_FRAMERATE_CONV_BLEND ||
+            !upipe_framerate_conv->blendable)
+            w = w <= WEIGHT_ONE / 2 ? 0 : WEIGHT_ONE;
+
+        struct ubuf *ubuf = NULL;
+        if (w != 0 && w != WEIGHT_ONE) {
+            ubuf = upipe_framerate_conv_blend(upipe, prev, next, w);
+            if (unlikely(ubuf == NULL))
+                /* fall back to the nearest picture */
+                w = w <= WEIGHT_ONE / 2 ? 0 : WEIGHT_ONE;
+        }
+
+        /* exact repetitions share the input picture */
+        bool from_next = w == WEIGHT_ONE;
+        struct uref *uref = uref_dup(from_next ? next : prev);
+        if (unlikely(uref == NULL)) {
+            if (ubuf != NULL)
+                ubuf_free(ubuf);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            continue;
+        }
+        if (ubuf != NULL)
+            uref_attach_ubuf(uref, ubuf);
+
+        /* rebase the dates of the source picture on the output grid */
+        int64_t delay = from_next ?
+            -(int64_t)((end - date) * UCLOCK_FREQ / (in_fps.num * fps.num)) :
+            (int64_t)(phase * UCLOCK_FREQ / (in_fps.num * fps.num));
+        uref_clock_add_date_sys(uref, delay);
+        uref_clock_add_date_prog(uref, delay);
+        uref_clock_add_date_orig(uref, delay);
+        uref_clock_set_duration(uref, UCLOCK_FREQ * fps.den / fps.num);
+        upipe_framerate_conv_output(upipe, uref, upump_p);
+    }
+}
+
+/** @internal @This handles input pictures.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ * @return false if the input must be blocked
+ */
+static bool upipe_framerate_conv_handle(struct upipe *upipe, struct uref *uref,
+                                        struct upump **upump_p)
+{
+    struct upipe_framerate_conv *upipe_framerate_conv =
+        upipe_framerate_conv_from_upipe(upipe);
+    const char *def;
+    if (unlikely(ubase_check(uref_flow_get_def(uref, &def)))) {
+        upipe_framerate_conv_store_flow_def(upipe, NULL);
+        upipe_framerate_conv_require_ubuf_mgr(upipe, uref);
+        return true;
+    }
+
+    if (upipe_framerate_conv->flow_def == NULL)
+        return false;
+
+    if (!upipe_framerate_conv->fps.num) {
+        upipe_framerate_conv_output(upipe, uref, upump_p);
+        return true;
+    }
+
+    if (upipe_framerate_conv->prev != NULL) {
+        upipe_framerate_conv_work(upipe, uref, upump_p);
+        uref_free(upipe_framerate_conv->prev);
+    }
+    upipe_framerate_conv->prev = uref;
+    upipe_framerate_conv->in_count++;
+    return true;
+}
+
+/** @internal @This inputs data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_framerate_conv_input(struct upipe *upipe, struct uref *uref,
+                                       struct upump **upump_p)
+{
+    if (!upipe_framerate_conv_check_input(upipe)) {
+        upipe_framerate_conv_hold_input(upipe, uref);
+        upipe_framerate_conv_block_input(upipe, upump_p);
+    } else if (!upipe_framerate_conv_handle(upipe, uref, upump_p)) {
+        upipe_framerate_conv_hold_input(upipe, uref);
+        upipe_framerate_conv_block_input(upipe, upump_p);
+        /* Increment upipe refcount to avoid disappearing before all packets
+         * have been sent. */
+        upipe_use(upipe);
+    }
+}
+
+/** @internal @This receives a provided ubuf manager.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_framerate_conv_check(struct upipe *upipe,
+                                      struct uref *flow_format)
+{
+    struct upipe_framerate_conv *upipe_framerate_conv =
+        upipe_framerate_conv_from_upipe(upipe);
+    if (flow_format != NULL)
+        upipe_framerate_conv_store_flow_def(upipe, flow_format);
+
+    if (upipe_framerate_conv->flow_def == NULL)
+        return UBASE_ERR_NONE;
+
+    bool was_buffered = !upipe_framerate_conv_check_input(upipe);
+    upipe_framerate_conv_output_input(upipe);
+    upipe_framerate_conv_unblock_input(upipe);
+    if (was_buffered && upipe_framerate_conv_check_input(upipe)) {
+        /* All packets have been output, release again the pipe that has been
+         * used in @ref upipe_framerate_conv_input. */
+        upipe_release(upipe);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_framerate_conv_set_flow_def(struct upipe *upipe,
+                                             struct uref *flow_def)
+{
+    struct upipe_framerate_conv *upipe_framerate_conv =
+        upipe_framerate_conv_from_upipe(upipe);
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, UREF_PIC_FLOW_DEF))
+
+    struct urational in_fps = { 0, 0 };
+    if (upipe_framerate_conv->fps.num &&
+        (!ubase_check(uref_pic_flow_get_fps(flow_def, &in_fps)) ||
+         in_fps.num <= 0 || !in_fps.den)) {
+        upipe_err(upipe, "input frame rate is required");
+        return UBASE_ERR_INVALID;
+    }
+
+    /* only planar flows of 8 or 16-bit samples are blended */
+    uint8_t macropixel = 0, planes = 0;
+    uref_pic_flow_get_macropixel(flow_def, &macropixel);
+    uref_pic_flow_get_planes(flow_def, &planes);
+    bool blendable = macropixel == 1;
+    for (uint8_t plane = 0; blendable && plane < planes; plane++) {
+        uint8_t macropixel_size;
+        blendable = ubase_check(uref_pic_flow_get_macropixel_size(flow_def,
+                        &macropixel_size, plane)) &&
+                    (macropixel_size == 1 || macropixel_size == 2);
+    }
+    if (upipe_framerate_conv->mode == UPIPE_FRAMERATE_CONV_BLEND &&
+        !blendable)
+        upipe_warn(upipe, "picture format cannot be blended, repeating");
+
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup)
+    if (upipe_framerate_conv->fps.num)
+        UBASE_RETURN(uref_pic_flow_set_fps(flow_def_dup,
+                                           upipe_framerate_conv->fps))
+
+    if (upipe_framerate_conv->prev != NULL) {
+        uref_free(upipe_framerate_conv->prev);
+        upipe_framerate_conv->prev = NULL;
+    }
+    upipe_framerate_conv->in_fps = in_fps;
+    upipe_framerate_conv->blendable = blendable;
+    upipe_framerate_conv->in_count = 0;
+    upipe_framerate_conv->out_count = 0;
+
+    upipe_input(upipe, flow_def_dup, NULL);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the output frame rate.
+ *
+ * @param upipe description structure of the pipe
+ * @param fps output frame rate
+ * @return an error code
+ */
+static int _upipe_framerate_conv_set_fps(struct upipe *upipe,
+                                         struct urational fps)
+{
+    struct upipe_framerate_conv *upipe_framerate_conv =
+        upipe_framerate_conv_from_upipe(upipe);
+    if (fps.num <= 0 || !fps.den)
+        return UBASE_ERR_INVALID;
+    /* the rate is taken into account at the next flow definition */
+    if (upipe_framerate_conv->flow_def != NULL)
+        return UBASE_ERR_BUSY;
+    urational_simplify(&fps);
+    upipe_framerate_conv->fps = fps;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the conversion mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param mode conversion mode
+ * @return an error code
+ */
+static int _upipe_framerate_conv_set_mode(struct upipe *upipe, int mode)
+{
+    struct upipe_framerate_conv *upipe_framerate_conv =
+        upipe_framerate_conv_from_upipe(upipe);
+    switch (mode) {
+        case UPIPE_FRAMERATE_CONV_REPEAT:
+        case UPIPE_FRAMERATE_CONV_BLEND:
+            upipe_framerate_conv->mode = mode;
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_INVALID;
+    }
+}
+
+/** @internal @This processes control commands on the pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_framerate_conv_control(struct upipe *upipe,
+                                        int command, va_list args)
+{
+    struct upipe_framerate_conv *upipe_framerate_conv =
+        upipe_framerate_conv_from_upipe(upipe);
+
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_UBUF_MGR ||
+                request->type == UREQUEST_FLOW_FORMAT)
+                return upipe_throw_provide_request(upipe, request);
+            return upipe_framerate_conv_alloc_output_proxy(upipe, request);
+        }
+        case UPIPE_UNREGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_UBUF_MGR ||
+                request->type == UREQUEST_FLOW_FORMAT)
+                return UBASE_ERR_NONE;
+            return upipe_framerate_conv_free_output_proxy(upipe, request);
+        }
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_framerate_conv_set_flow_def(upipe, flow_def);
+        }
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_framerate_conv_control_output(upipe, command, args);
+        case UPIPE_SET_OPTION: {
+            const char *option = va_arg(args, const char *);
+            const char *value = va_arg(args, const char *);
+            if (strcmp(option, "mode"))
+                return UBASE_ERR_INVALID;
+            if (!strcmp(value, "repeat"))
+                return _upipe_framerate_conv_set_mode(upipe,
+                        UPIPE_FRAMERATE_CONV_REPEAT);
+            if (!strcmp(value, "blend"))
+                return _upipe_framerate_conv_set_mode(upipe,
+                        UPIPE_FRAMERATE_CONV_BLEND);
+            return UBASE_ERR_INVALID;
+        }
+
+        case UPIPE_FRAMERATE_CONV_GET_FPS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FRAMERATE_CONV_SIGNATURE)
+            struct urational *fps_p = va_arg(args, struct urational *);
+            *fps_p = upipe_framerate_conv->fps;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_FRAMERATE_CONV_SET_FPS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FRAMERATE_CONV_SIGNATURE)
+            struct urational fps = va_arg(args, struct urational);
+            return _upipe_framerate_conv_set_fps(upipe, fps);
+        }
+        case UPIPE_FRAMERATE_CONV_GET_MODE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FRAMERATE_CONV_SIGNATURE)
+            int *mode_p = va_arg(args, int *);
+            *mode_p = upipe_framerate_conv->mode;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_FRAMERATE_CONV_SET_MODE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FRAMERATE_CONV_SIGNATURE)
+            int mode = va_arg(args, int);
+            return _upipe_framerate_conv_set_mode(upipe, mode);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_framerate_conv_free(struct upipe *upipe)
+{
+    struct upipe_framerate_conv *upipe_framerate_conv =
+        upipe_framerate_conv_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    if (upipe_framerate_conv->prev != NULL)
+        uref_free(upipe_framerate_conv->prev);
+    upipe_framerate_conv_clean_input(upipe);
+    upipe_framerate_conv_clean_ubuf_mgr(upipe);
+    upipe_framerate_conv_clean_output(upipe);
+    upipe_framerate_conv_clean_urefcount(upipe);
+    upipe_framerate_conv_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_framerate_conv_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_FRAMERATE_CONV_SIGNATURE,
+
+    .upipe_alloc = upipe_framerate_conv_alloc,
+    .upipe_input = upipe_framerate_conv_input,
+    .upipe_control = upipe_framerate_conv_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for framerate_conv pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_framerate_conv_mgr_alloc(void)
+{
+    return &upipe_framerate_conv_mgr;
+}
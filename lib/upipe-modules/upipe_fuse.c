@@ -0,0 +1,419 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module applying a chain of per-uref stages in one pass
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/ulist.h>
+#include <upipe/uprobe.h>
+#include <upipe/udict.h>
+#include <upipe/uref.h>
+#include <upipe/uref_attr.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe-modules/upipe_fuse.h>
+#include <upipe-modules/upipe_probe_uref.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+/** @internal @This is the type of a per-uref stage. */
+enum upipe_fuse_stage_type {
+    /** sets attributes into urefs */
+    UPIPE_FUSE_STAGE_SETATTR,
+    /** throws UPROBE_PROBE_UREF */
+    UPIPE_FUSE_STAGE_PROBE,
+    /** calls a user callback */
+    UPIPE_FUSE_STAGE_CALLBACK
+};
+
+/** @internal @This is a per-uref stage. */
+struct upipe_fuse_stage {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** type of stage */
+    enum upipe_fuse_stage_type type;
+    /** dictionary to set, for setattr stages */
+    struct uref *dict;
+    /** callback, for callback stages */
+    upipe_fuse_cb cb;
+    /** opaque passed to the callback */
+    void *opaque;
+};
+
+UBASE_FROM_TO(upipe_fuse_stage, uchain, uchain, uchain)
+
+/** @internal @This is the private context of a fuse pipe. */
+struct upipe_fuse {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** input flow definition packet */
+    struct uref *flow_def_input;
+    /** output flow definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** list of per-uref stages */
+    struct uchain stages;
+    /** merged dictionary of all setflowdef stages */
+    struct uref *flow_dict;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_fuse, upipe, UPIPE_FUSE_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_fuse, urefcount, upipe_fuse_free)
+UPIPE_HELPER_VOID(upipe_fuse)
+UPIPE_HELPER_OUTPUT(upipe_fuse, output, flow_def, output_state, request_list)
+
+/** @internal @This allocates a fuse pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_fuse_alloc(struct upipe_mgr *mgr,
+                                      struct uprobe *uprobe,
+                                      uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_fuse_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_fuse *upipe_fuse = upipe_fuse_from_upipe(upipe);
+    upipe_fuse_init_urefcount(upipe);
+    upipe_fuse_init_output(upipe);
+    upipe_fuse->flow_def_input = NULL;
+    ulist_init(&upipe_fuse->stages);
+    upipe_fuse->flow_dict = NULL;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This receives data and runs it through all stages.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_fuse_input(struct upipe *upipe, struct uref *uref,
+                             struct upump **upump_p)
+{
+    struct upipe_fuse *upipe_fuse = upipe_fuse_from_upipe(upipe);
+    struct uchain *uchain;
+    ulist_foreach (&upipe_fuse->stages, uchain) {
+        struct upipe_fuse_stage *stage = upipe_fuse_stage_from_uchain(uchain);
+        switch (stage->type) {
+            case UPIPE_FUSE_STAGE_SETATTR:
+                if (unlikely(!ubase_check(uref_attr_import(uref,
+                                                           stage->dict)))) {
+                    uref_free(uref);
+                    upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                    return;
+                }
+                break;
+
+            case UPIPE_FUSE_STAGE_PROBE: {
+                bool drop = false;
+                upipe_throw(upipe, UPROBE_PROBE_UREF,
+                            UPIPE_PROBE_UREF_SIGNATURE, uref, upump_p, &drop);
+                if (drop) {
+                    uref_free(uref);
+                    return;
+                }
+                break;
+            }
+
+            case UPIPE_FUSE_STAGE_CALLBACK:
+                if (!stage->cb(stage->opaque, upipe, uref, upump_p)) {
+                    uref_free(uref);
+                    return;
+                }
+                break;
+        }
+    }
+    upipe_fuse_output(upipe, uref, upump_p);
+}
+
+/** @internal @This builds the output flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_fuse_build_flow_def(struct upipe *upipe)
+{
+    struct upipe_fuse *upipe_fuse = upipe_fuse_from_upipe(upipe);
+    if (upipe_fuse->flow_def_input == NULL)
+        return UBASE_ERR_NONE;
+
+    struct uref *flow_def = uref_dup(upipe_fuse->flow_def_input);
+    UBASE_ALLOC_RETURN(flow_def);
+    if (upipe_fuse->flow_dict != NULL &&
+        unlikely(!ubase_check(uref_attr_import(flow_def,
+                                               upipe_fuse->flow_dict)))) {
+        uref_free(flow_def);
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_fuse_store_flow_def(upipe, flow_def);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_fuse_set_flow_def(struct upipe *upipe, struct uref *flow_def)
+{
+    struct upipe_fuse *upipe_fuse = upipe_fuse_from_upipe(upipe);
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup);
+    uref_free(upipe_fuse->flow_def_input);
+    upipe_fuse->flow_def_input = flow_def_dup;
+    return upipe_fuse_build_flow_def(upipe);
+}
+
+/** @internal @This allocates a stage and appends it to the chain.
+ *
+ * @param upipe description structure of the pipe
+ * @param type type of stage
+ * @return pointer to the stage, or NULL in case of allocation error
+ */
+static struct upipe_fuse_stage *upipe_fuse_append(struct upipe *upipe,
+        enum upipe_fuse_stage_type type)
+{
+    struct upipe_fuse *upipe_fuse = upipe_fuse_from_upipe(upipe);
+    struct upipe_fuse_stage *stage = malloc(sizeof (*stage));
+    if (unlikely(stage == NULL))
+        return NULL;
+    uchain_init(&stage->uchain);
+    stage->type = type;
+    stage->dict = NULL;
+    stage->cb = NULL;
+    stage->opaque = NULL;
+    ulist_add(&upipe_fuse->stages, upipe_fuse_stage_to_uchain(stage));
+    return stage;
+}
+
+/** @internal @This appends a setattr stage. Consecutive setattr stages are
+ * merged into a single dictionary.
+ *
+ * @param upipe description structure of the pipe
+ * @param dict dictionary to set
+ * @return an error code
+ */
+static int _upipe_fuse_add_setattr(struct upipe *upipe, struct uref *dict)
+{
+    struct upipe_fuse *upipe_fuse = upipe_fuse_from_upipe(upipe);
+    if (dict == NULL)
+        return UBASE_ERR_INVALID;
+
+    if (!ulist_empty(&upipe_fuse->stages)) {
+        struct upipe_fuse_stage *stage =
+            upipe_fuse_stage_from_uchain(upipe_fuse->stages.prev);
+        if (stage->type == UPIPE_FUSE_STAGE_SETATTR)
+            return uref_attr_import(stage->dict, dict);
+    }
+
+    struct uref *dict_dup = uref_dup(dict);
+    UBASE_ALLOC_RETURN(dict_dup);
+    struct upipe_fuse_stage *stage =
+        upipe_fuse_append(upipe, UPIPE_FUSE_STAGE_SETATTR);
+    if (unlikely(stage == NULL)) {
+        uref_free(dict_dup);
+        return UBASE_ERR_ALLOC;
+    }
+    stage->dict = dict_dup;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This appends a setflowdef stage. All setflowdef stages are
+ * merged and applied to the flow definition only.
+ *
+ * @param upipe description structure of the pipe
+ * @param dict dictionary to set
+ * @return an error code
+ */
+static int _upipe_fuse_add_setflowdef(struct upipe *upipe, struct uref *dict)
+{
+    struct upipe_fuse *upipe_fuse = upipe_fuse_from_upipe(upipe);
+    if (dict == NULL)
+        return UBASE_ERR_INVALID;
+
+    if (upipe_fuse->flow_dict == NULL) {
+        upipe_fuse->flow_dict = uref_dup(dict);
+        UBASE_ALLOC_RETURN(upipe_fuse->flow_dict);
+    } else {
+        UBASE_RETURN(uref_attr_import(upipe_fuse->flow_dict, dict))
+    }
+    return upipe_fuse_build_flow_def(upipe);
+}
+
+/** @internal @This appends a callback stage.
+ *
+ * @param upipe description structure of the pipe
+ * @param cb function called for each uref
+ * @param opaque opaque passed to the callback
+ * @return an error code
+ */
+static int _upipe_fuse_add_callback(struct upipe *upipe, upipe_fuse_cb cb,
+                                    void *opaque)
+{
+    if (cb == NULL)
+        return UBASE_ERR_INVALID;
+    struct upipe_fuse_stage *stage =
+        upipe_fuse_append(upipe, UPIPE_FUSE_STAGE_CALLBACK);
+    UBASE_ALLOC_RETURN(stage);
+    stage->cb = cb;
+    stage->opaque = opaque;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This removes all stages.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int _upipe_fuse_clear(struct upipe *upipe)
+{
+    struct upipe_fuse *upipe_fuse = upipe_fuse_from_upipe(upipe);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&upipe_fuse->stages, uchain, uchain_tmp) {
+        struct upipe_fuse_stage *stage = upipe_fuse_stage_from_uchain(uchain);
+        ulist_delete(uchain);
+        uref_free(stage->dict);
+        free(stage);
+    }
+    uref_free(upipe_fuse->flow_dict);
+    upipe_fuse->flow_dict = NULL;
+    return upipe_fuse_build_flow_def(upipe);
+}
+
+/** @internal @This processes control commands on a fuse pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_fuse_control(struct upipe *upipe, int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(upipe_fuse_control_output(upipe, command, args));
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_fuse_set_flow_def(upipe, flow_def);
+        }
+
+        case UPIPE_FUSE_ADD_SETATTR: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FUSE_SIGNATURE)
+            struct uref *dict = va_arg(args, struct uref *);
+            return _upipe_fuse_add_setattr(upipe, dict);
+        }
+        case UPIPE_FUSE_ADD_SETFLOWDEF: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FUSE_SIGNATURE)
+            struct uref *dict = va_arg(args, struct uref *);
+            return _upipe_fuse_add_setflowdef(upipe, dict);
+        }
+        case UPIPE_FUSE_ADD_PROBE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FUSE_SIGNATURE)
+            struct upipe_fuse_stage *stage =
+                upipe_fuse_append(upipe, UPIPE_FUSE_STAGE_PROBE);
+            UBASE_ALLOC_RETURN(stage);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_FUSE_ADD_CALLBACK: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FUSE_SIGNATURE)
+            upipe_fuse_cb cb = va_arg(args, upipe_fuse_cb);
+            void *opaque = va_arg(args, void *);
+            return _upipe_fuse_add_callback(upipe, cb, opaque);
+        }
+        case UPIPE_FUSE_CLEAR: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FUSE_SIGNATURE)
+            return _upipe_fuse_clear(upipe);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fuse_free(struct upipe *upipe)
+{
+    struct upipe_fuse *upipe_fuse = upipe_fuse_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&upipe_fuse->stages, uchain, uchain_tmp) {
+        struct upipe_fuse_stage *stage = upipe_fuse_stage_from_uchain(uchain);
+        ulist_delete(uchain);
+        uref_free(stage->dict);
+        free(stage);
+    }
+    uref_free(upipe_fuse->flow_dict);
+    uref_free(upipe_fuse->flow_def_input);
+    upipe_fuse_clean_output(upipe);
+    upipe_fuse_clean_urefcount(upipe);
+    upipe_fuse_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_fuse_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_FUSE_SIGNATURE,
+
+    .upipe_alloc = upipe_fuse_alloc,
+    .upipe_input = upipe_fuse_input,
+    .upipe_control = upipe_fuse_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all fuse pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_fuse_mgr_alloc(void)
+{
+    return &upipe_fuse_mgr;
+}
@@ -0,0 +1,513 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module caching the stream since the last random access point
+ * and replaying it to each new output
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/ulist.h>
+#include <upipe/uprobe.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_flow.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_urefcount_real.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe/upipe_helper_subpipe.h>
+#include <upipe-modules/upipe_gop_cache.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+
+/** default maximum size of the cache */
+#define DEFAULT_MAX_SIZE (8 * 1024 * 1024)
+
+/** @internal @This is the private context of a gop cache pipe. */
+struct upipe_gop_cache {
+    /** real refcount management structure */
+    struct urefcount urefcount_real;
+    /** refcount management structure exported to the public structure */
+    struct urefcount urefcount;
+
+    /** list of output subpipes */
+    struct uchain outputs;
+    /** flow definition packet */
+    struct uref *flow_def;
+
+    /** urefs since the last random access point */
+    struct uchain cache;
+    /** size of the cached urefs */
+    uint64_t cache_size;
+    /** maximum size of the cached urefs */
+    uint64_t max_size;
+    /** true if the cache starts with a random access point */
+    bool caching;
+
+    /** manager to create output subpipes */
+    struct upipe_mgr sub_mgr;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_gop_cache, upipe, UPIPE_GOP_CACHE_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_gop_cache, urefcount, upipe_gop_cache_no_input)
+UPIPE_HELPER_UREFCOUNT_REAL(upipe_gop_cache, urefcount_real,
+                            upipe_gop_cache_free)
+UPIPE_HELPER_VOID(upipe_gop_cache)
+
+/** @internal @This is the private context of an output of a gop cache
+ * pipe. */
+struct upipe_gop_cache_output {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** structure for double-linked lists */
+    struct uchain uchain;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** flow definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** true if the cache was replayed to the output */
+    bool joined;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_gop_cache_output, upipe,
+                   UPIPE_GOP_CACHE_OUTPUT_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_gop_cache_output, urefcount,
+                       upipe_gop_cache_output_free)
+UPIPE_HELPER_VOID(upipe_gop_cache_output);
+UPIPE_HELPER_OUTPUT(upipe_gop_cache_output, output, flow_def, output_state,
+                    request_list)
+
+UPIPE_HELPER_SUBPIPE(upipe_gop_cache, upipe_gop_cache_output, output, sub_mgr,
+                     outputs, uchain)
+
+/** @internal @This allocates an output subpipe of a gop cache pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_gop_cache_output_alloc(struct upipe_mgr *mgr,
+                                                  struct uprobe *uprobe,
+                                                  uint32_t signature,
+                                                  va_list args)
+{
+    if (mgr->signature != UPIPE_GOP_CACHE_OUTPUT_SIGNATURE)
+        return NULL;
+
+    struct upipe *upipe =
+        upipe_gop_cache_output_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(!upipe))
+        return NULL;
+
+    struct upipe_gop_cache_output *upipe_gop_cache_output =
+        upipe_gop_cache_output_from_upipe(upipe);
+    upipe_gop_cache_output_init_urefcount(upipe);
+    upipe_gop_cache_output_init_output(upipe);
+    upipe_gop_cache_output_init_sub(upipe);
+    upipe_gop_cache_output->joined = false;
+
+    upipe_throw_ready(upipe);
+
+    struct upipe_gop_cache *upipe_gop_cache =
+        upipe_gop_cache_from_sub_mgr(mgr);
+    struct uref *flow_def_dup = NULL;
+    if (upipe_gop_cache->flow_def != NULL &&
+        (flow_def_dup = uref_dup(upipe_gop_cache->flow_def)) == NULL) {
+        upipe_release(upipe);
+        return NULL;
+    }
+
+    upipe_gop_cache_output_store_flow_def(upipe, flow_def_dup);
+
+    return upipe;
+}
+
+/** @internal @This processes control commands on an output subpipe of a gop
+ * cache pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_gop_cache_output_control(struct upipe *upipe,
+                                          int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(
+        upipe_gop_cache_output_control_super(upipe, command, args));
+    switch (command) {
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_gop_cache_output_control_output(upipe, command, args);
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_gop_cache_output_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+
+    upipe_gop_cache_output_clean_output(upipe);
+    upipe_gop_cache_output_clean_sub(upipe);
+    upipe_gop_cache_output_clean_urefcount(upipe);
+    upipe_gop_cache_output_free_void(upipe);
+}
+
+/** @internal @This initializes the output manager for a gop cache pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_gop_cache_init_sub_mgr(struct upipe *upipe)
+{
+    struct upipe_gop_cache *upipe_gop_cache = upipe_gop_cache_from_upipe(upipe);
+    struct upipe_mgr *sub_mgr = &upipe_gop_cache->sub_mgr;
+    sub_mgr->refcount = upipe_gop_cache_to_urefcount_real(upipe_gop_cache);
+    sub_mgr->signature = UPIPE_GOP_CACHE_OUTPUT_SIGNATURE;
+    sub_mgr->upipe_alloc = upipe_gop_cache_output_alloc;
+    sub_mgr->upipe_input = NULL;
+    sub_mgr->upipe_control = upipe_gop_cache_output_control;
+    sub_mgr->upipe_mgr_control = NULL;
+}
+
+/** @internal @This allocates a gop cache pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_gop_cache_alloc(struct upipe_mgr *mgr,
+                                           struct uprobe *uprobe,
+                                           uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_gop_cache_alloc_void(mgr, uprobe, signature,
+                                                     args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_gop_cache *upipe_gop_cache = upipe_gop_cache_from_upipe(upipe);
+    upipe_gop_cache_init_urefcount(upipe);
+    upipe_gop_cache_init_urefcount_real(upipe);
+    upipe_gop_cache_init_sub_mgr(upipe);
+    upipe_gop_cache_init_sub_outputs(upipe);
+    upipe_gop_cache->flow_def = NULL;
+    ulist_init(&upipe_gop_cache->cache);
+    upipe_gop_cache->cache_size = 0;
+    upipe_gop_cache->max_size = DEFAULT_MAX_SIZE;
+    upipe_gop_cache->caching = false;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This empties the cache.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_gop_cache_flush(struct upipe *upipe)
+{
+    struct upipe_gop_cache *upipe_gop_cache = upipe_gop_cache_from_upipe(upipe);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&upipe_gop_cache->cache, uchain, uchain_tmp) {
+        ulist_delete(uchain);
+        uref_free(uref_from_uchain(uchain));
+    }
+    upipe_gop_cache->cache_size = 0;
+    upipe_gop_cache->caching = false;
+}
+
+/** @internal @This adds a uref to the cache.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ */
+static void upipe_gop_cache_append(struct upipe *upipe, struct uref *uref)
+{
+    struct upipe_gop_cache *upipe_gop_cache = upipe_gop_cache_from_upipe(upipe);
+    if (ubase_check(uref_flow_get_random(uref))) {
+        upipe_gop_cache_flush(upipe);
+        upipe_gop_cache->caching = true;
+    }
+    if (!upipe_gop_cache->caching)
+        return;
+
+    size_t size = 0;
+    uref_block_size(uref, &size);
+    if (upipe_gop_cache->cache_size + size > upipe_gop_cache->max_size) {
+        upipe_warn_va(upipe, "random access points are more than %"PRIu64
+                      " octets apart, disabling cache",
+                      upipe_gop_cache->max_size);
+        upipe_gop_cache_flush(upipe);
+        return;
+    }
+
+    struct uref *cached = uref_dup(uref);
+    if (unlikely(cached == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        upipe_gop_cache_flush(upipe);
+        return;
+    }
+    ulist_add(&upipe_gop_cache->cache, uref_to_uchain(cached));
+    upipe_gop_cache->cache_size += size;
+}
+
+/** @internal @This sends the cache to an output which has just joined.
+ *
+ * @param upipe description structure of the pipe
+ * @param output description structure of the output subpipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_gop_cache_replay(struct upipe *upipe, struct upipe *output,
+                                   struct upump **upump_p)
+{
+    struct upipe_gop_cache *upipe_gop_cache = upipe_gop_cache_from_upipe(upipe);
+    struct upipe_gop_cache_output *upipe_gop_cache_output =
+        upipe_gop_cache_output_from_upipe(output);
+    upipe_gop_cache_output->joined = true;
+    if (ulist_empty(&upipe_gop_cache->cache))
+        return;
+
+    upipe_dbg_va(output, "replaying %"PRIu64" octets",
+                 upipe_gop_cache->cache_size);
+    struct uchain *uchain;
+    ulist_foreach (&upipe_gop_cache->cache, uchain) {
+        struct uref *uref = uref_dup(uref_from_uchain(uchain));
+        if (unlikely(uref == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        upipe_gop_cache_output_output(output, uref, upump_p);
+    }
+}
+
+/** @internal @This receives data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_gop_cache_input(struct upipe *upipe, struct uref *uref,
+                                  struct upump **upump_p)
+{
+    struct upipe_gop_cache *upipe_gop_cache = upipe_gop_cache_from_upipe(upipe);
+
+    /* a random access point is a better start than the cache */
+    if (ubase_check(uref_flow_get_random(uref)))
+        upipe_gop_cache_flush(upipe);
+
+    struct uchain *uchain;
+    ulist_foreach (&upipe_gop_cache->outputs, uchain) {
+        struct upipe_gop_cache_output *upipe_gop_cache_output =
+            upipe_gop_cache_output_from_uchain(uchain);
+        struct upipe *output =
+            upipe_gop_cache_output_to_upipe(upipe_gop_cache_output);
+        if (!upipe_gop_cache_output->joined)
+            upipe_gop_cache_replay(upipe, output, upump_p);
+    }
+
+    upipe_gop_cache_append(upipe, uref);
+
+    ulist_foreach (&upipe_gop_cache->outputs, uchain) {
+        struct upipe_gop_cache_output *upipe_gop_cache_output =
+            upipe_gop_cache_output_from_uchain(uchain);
+        struct upipe *output =
+            upipe_gop_cache_output_to_upipe(upipe_gop_cache_output);
+        if (ulist_is_last(&upipe_gop_cache->outputs, uchain)) {
+            upipe_gop_cache_output_output(output, uref, upump_p);
+            return;
+        }
+
+        struct uref *new_uref = uref_dup(uref);
+        if (unlikely(new_uref == NULL)) {
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        upipe_gop_cache_output_output(output, new_uref, upump_p);
+    }
+    uref_free(uref);
+}
+
+/** @internal @This changes the flow definition on all outputs.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def new flow definition
+ * @return an error code
+ */
+static int upipe_gop_cache_set_flow_def(struct upipe *upipe,
+                                        struct uref *flow_def)
+{
+    struct upipe_gop_cache *upipe_gop_cache = upipe_gop_cache_from_upipe(upipe);
+
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, "block."))
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup);
+    uref_free(upipe_gop_cache->flow_def);
+    upipe_gop_cache->flow_def = flow_def_dup;
+    /* the cached stream may not be decodable with the new flow */
+    upipe_gop_cache_flush(upipe);
+
+    struct uchain *uchain;
+    ulist_foreach (&upipe_gop_cache->outputs, uchain) {
+        struct upipe_gop_cache_output *upipe_gop_cache_output =
+            upipe_gop_cache_output_from_uchain(uchain);
+        flow_def_dup = uref_dup(flow_def);
+        if (unlikely(flow_def_dup == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return UBASE_ERR_ALLOC;
+        }
+        upipe_gop_cache_output_store_flow_def(
+                upipe_gop_cache_output_to_upipe(upipe_gop_cache_output),
+                flow_def_dup);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a gop cache pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_gop_cache_control(struct upipe *upipe, int command,
+                                   va_list args)
+{
+    struct upipe_gop_cache *upipe_gop_cache = upipe_gop_cache_from_upipe(upipe);
+
+    UBASE_HANDLED_RETURN(upipe_gop_cache_control_outputs(upipe, command, args));
+
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *uref = va_arg(args, struct uref *);
+            return upipe_gop_cache_set_flow_def(upipe, uref);
+        }
+        case UPIPE_GET_FLOW_DEF: {
+            struct uref **p = va_arg(args, struct uref **);
+            *p = upipe_gop_cache->flow_def;
+            return *p != NULL ? UBASE_ERR_NONE : UBASE_ERR_INVALID;
+        }
+
+        case UPIPE_GOP_CACHE_SET_MAX_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_GOP_CACHE_SIGNATURE)
+            upipe_gop_cache->max_size = va_arg(args, uint64_t);
+            if (upipe_gop_cache->cache_size > upipe_gop_cache->max_size)
+                upipe_gop_cache_flush(upipe);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_GOP_CACHE_GET_MAX_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_GOP_CACHE_SIGNATURE)
+            uint64_t *max_size_p = va_arg(args, uint64_t *);
+            *max_size_p = upipe_gop_cache->max_size;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_GOP_CACHE_GET_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_GOP_CACHE_SIGNATURE)
+            uint64_t *size_p = va_arg(args, uint64_t *);
+            *size_p = upipe_gop_cache->cache_size;
+            return UBASE_ERR_NONE;
+        }
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_gop_cache_free(struct upipe *upipe)
+{
+    struct upipe_gop_cache *upipe_gop_cache = upipe_gop_cache_from_upipe(upipe);
+
+    upipe_throw_dead(upipe);
+
+    upipe_gop_cache_flush(upipe);
+    uref_free(upipe_gop_cache->flow_def);
+    upipe_gop_cache_clean_sub_outputs(upipe);
+    upipe_gop_cache_clean_urefcount_real(upipe);
+    upipe_gop_cache_clean_urefcount(upipe);
+    upipe_gop_cache_free_void(upipe);
+}
+
+/** @This is called when there is no external reference to the pipe anymore.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_gop_cache_no_input(struct upipe *upipe)
+{
+    struct upipe_gop_cache *upipe_gop_cache = upipe_gop_cache_from_upipe(upipe);
+    upipe_gop_cache_throw_sub_outputs(upipe, UPROBE_SOURCE_END);
+    urefcount_release(upipe_gop_cache_to_urefcount_real(upipe_gop_cache));
+}
+
+/** gop cache module manager static descriptor */
+static struct upipe_mgr upipe_gop_cache_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_GOP_CACHE_SIGNATURE,
+
+    .upipe_alloc = upipe_gop_cache_alloc,
+    .upipe_input = upipe_gop_cache_input,
+    .upipe_control = upipe_gop_cache_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all gop cache pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_gop_cache_mgr_alloc(void)
+{
+    return &upipe_gop_cache_mgr;
+}
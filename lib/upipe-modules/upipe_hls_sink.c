@@ -0,0 +1,555 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short Upipe sink module - HLS packager
+ *
+ * A packager sink is fed by the mux of one rendition. Segments are cut on
+ * the random access points flagged by the mux, and the urefs of a segment
+ * are handed over as is to a writer pipe, so that the segment data is not
+ * copied. The playlist is written through another writer pipe which stays
+ * open, and only the lines describing the new segment are sent, so that
+ * the playlist is not rewritten on each segment.
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uclock.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_flow.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_uref_mgr.h>
+#include <upipe/upipe_helper_ubuf_mgr.h>
+#include <upipe-modules/upipe_hls_sink.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#define EXPECTED_FLOW_DEF "block."
+/** flow definition of the playlist */
+#define PLAYLIST_FLOW_DEF "m3u.playlist."
+/** suffix of segment URIs */
+#define SEGMENT_SUFFIX ".ts"
+/** maximum size of a playlist update */
+#define MAX_PLAYLIST_LINES 512
+
+/** @internal @This is the private context of a hls sink pipe. */
+struct upipe_hls_sink {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** uref manager */
+    struct uref_mgr *uref_mgr;
+    /** uref manager request */
+    struct urequest uref_mgr_request;
+    /** ubuf manager for the playlist lines */
+    struct ubuf_mgr *ubuf_mgr;
+    /** flow format packet */
+    struct uref *flow_format;
+    /** ubuf manager request */
+    struct urequest ubuf_mgr_request;
+
+    /** input flow definition */
+    struct uref *flow_def;
+    /** manager of the writer pipes */
+    struct upipe_mgr *writer_mgr;
+    /** minimum duration of a segment */
+    uint64_t duration;
+
+    /** playlist URI */
+    char *uri;
+    /** playlist URI without its extension, used to build segment URIs */
+    char *prefix;
+    /** playlist writer, opened with the first complete segment */
+    struct upipe *playlist;
+    /** advertised target duration, in seconds */
+    uint64_t target;
+
+    /** writer of the current segment, or NULL before the first RAP */
+    struct upipe *segment;
+    /** index of the current segment */
+    uint64_t index;
+    /** date of the first uref of the current segment */
+    uint64_t segment_start;
+    /** date of the last uref of the current segment */
+    uint64_t segment_last;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+/** @hidden */
+static int upipe_hls_sink_check(struct upipe *upipe, struct uref *flow_format);
+
+UPIPE_HELPER_UPIPE(upipe_hls_sink, upipe, UPIPE_HLS_SINK_SIGNATURE);
+UPIPE_HELPER_UREFCOUNT(upipe_hls_sink, urefcount, upipe_hls_sink_free)
+UPIPE_HELPER_VOID(upipe_hls_sink)
+UPIPE_HELPER_UREF_MGR(upipe_hls_sink, uref_mgr, uref_mgr_request,
+                      upipe_hls_sink_check,
+                      upipe_throw_provide_request, NULL)
+UPIPE_HELPER_UBUF_MGR(upipe_hls_sink, ubuf_mgr, flow_format, ubuf_mgr_request,
+                      upipe_hls_sink_check,
+                      upipe_throw_provide_request, NULL)
+
+/** @internal @This allocates a hls sink pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_hls_sink_alloc(struct upipe_mgr *mgr,
+                                          struct uprobe *uprobe,
+                                          uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_hls_sink_alloc_void(mgr, uprobe, signature,
+                                                    args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    upipe_hls_sink_init_urefcount(upipe);
+    upipe_hls_sink_init_uref_mgr(upipe);
+    upipe_hls_sink_init_ubuf_mgr(upipe);
+    upipe_hls_sink->flow_def = NULL;
+    upipe_hls_sink->writer_mgr = NULL;
+    upipe_hls_sink->duration = UPIPE_HLS_SINK_DEF_DURATION;
+    upipe_hls_sink->uri = NULL;
+    upipe_hls_sink->prefix = NULL;
+    upipe_hls_sink->playlist = NULL;
+    upipe_hls_sink->target = 0;
+    upipe_hls_sink->segment = NULL;
+    upipe_hls_sink->index = 0;
+    upipe_hls_sink->segment_start = UINT64_MAX;
+    upipe_hls_sink->segment_last = UINT64_MAX;
+    upipe_throw_ready(upipe);
+    upipe_hls_sink_require_uref_mgr(upipe);
+    return upipe;
+}
+
+/** @internal @This is called when a manager is received.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_hls_sink_check(struct upipe *upipe, struct uref *flow_format)
+{
+    if (flow_format != NULL)
+        uref_free(flow_format);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This allocates a writer pipe and opens the given URI.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition of the writer
+ * @param uri URI to open
+ * @param name name of the writer in the logs
+ * @return pointer to the writer, or NULL in case of error
+ */
+static struct upipe *upipe_hls_sink_writer_alloc(struct upipe *upipe,
+                                                 struct uref *flow_def,
+                                                 const char *uri,
+                                                 const char *name)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    struct upipe *writer = upipe_void_alloc(upipe_hls_sink->writer_mgr,
+            uprobe_pfx_alloc(uprobe_use(upipe->uprobe),
+                             UPROBE_LOG_VERBOSE, name));
+    if (unlikely(writer == NULL)) {
+        upipe_err_va(upipe, "unable to allocate %s writer", name);
+        return NULL;
+    }
+    if (unlikely(!ubase_check(upipe_set_flow_def(writer, flow_def)) ||
+                 !ubase_check(upipe_set_uri(writer, uri)))) {
+        upipe_err_va(upipe, "unable to open %s", uri);
+        upipe_release(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+/** @internal @This sends lines to the playlist writer.
+ *
+ * @param upipe description structure of the pipe
+ * @param format printf-style format of the lines, followed by arguments
+ * @return an error code
+ */
+UBASE_FMT_PRINTF(2, 3)
+static int upipe_hls_sink_write_playlist(struct upipe *upipe,
+                                         const char *format, ...)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    char lines[MAX_PLAYLIST_LINES];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(lines, sizeof (lines), format, args);
+    va_end(args);
+    if (unlikely(len < 0 || len >= sizeof (lines)))
+        return UBASE_ERR_INVALID;
+
+    struct uref *uref = uref_block_alloc(upipe_hls_sink->uref_mgr,
+                                         upipe_hls_sink->ubuf_mgr, len);
+    if (unlikely(uref == NULL))
+        return UBASE_ERR_ALLOC;
+    uint8_t *buffer;
+    int size = -1;
+    if (unlikely(!ubase_check(uref_block_write(uref, 0, &size, &buffer)))) {
+        uref_free(uref);
+        return UBASE_ERR_ALLOC;
+    }
+    memcpy(buffer, lines, len);
+    uref_block_unmap(uref, 0);
+    upipe_input(upipe_hls_sink->playlist, uref, NULL);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This opens the playlist and writes its header. The target
+ * duration must be known at that point, since the header is never
+ * rewritten; it is derived from the first segment.
+ *
+ * @param upipe description structure of the pipe
+ * @param duration duration of the first segment
+ * @return an error code
+ */
+static int upipe_hls_sink_open_playlist(struct upipe *upipe,
+                                        uint64_t duration)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    if (unlikely(upipe_hls_sink->uref_mgr == NULL ||
+                 upipe_hls_sink->ubuf_mgr == NULL)) {
+        upipe_err(upipe, "no manager to write the playlist");
+        return UBASE_ERR_INVALID;
+    }
+
+    struct uref *flow_def =
+        uref_block_flow_alloc_def(upipe_hls_sink->uref_mgr,
+                                  PLAYLIST_FLOW_DEF);
+    if (unlikely(flow_def == NULL))
+        return UBASE_ERR_ALLOC;
+    upipe_hls_sink->playlist =
+        upipe_hls_sink_writer_alloc(upipe, flow_def, upipe_hls_sink->uri,
+                                    "playlist");
+    uref_free(flow_def);
+    if (unlikely(upipe_hls_sink->playlist == NULL))
+        return UBASE_ERR_EXTERNAL;
+
+    if (duration < upipe_hls_sink->duration)
+        duration = upipe_hls_sink->duration;
+    upipe_hls_sink->target = (duration + UCLOCK_FREQ - 1) / UCLOCK_FREQ;
+    return upipe_hls_sink_write_playlist(upipe,
+            "#EXTM3U\n"
+            "#EXT-X-VERSION:3\n"
+            "#EXT-X-TARGETDURATION:%"PRIu64"\n"
+            "#EXT-X-MEDIA-SEQUENCE:0\n"
+            "#EXT-X-PLAYLIST-TYPE:EVENT\n",
+            upipe_hls_sink->target);
+}
+
+/** @internal @This closes the current segment and appends it to the
+ * playlist.
+ *
+ * @param upipe description structure of the pipe
+ * @param end date of the end of the segment
+ */
+static void upipe_hls_sink_close_segment(struct upipe *upipe, uint64_t end)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    if (upipe_hls_sink->segment == NULL)
+        return;
+
+    upipe_release(upipe_hls_sink->segment);
+    upipe_hls_sink->segment = NULL;
+    uint64_t duration = end - upipe_hls_sink->segment_start;
+    uint64_t index = upipe_hls_sink->index++;
+
+    if (upipe_hls_sink->playlist == NULL &&
+        !ubase_check(upipe_hls_sink_open_playlist(upipe, duration)))
+        return;
+    if (duration > upipe_hls_sink->target * UCLOCK_FREQ + UCLOCK_FREQ / 2)
+        upipe_warn_va(upipe, "segment %"PRIu64" exceeds the target duration",
+                      index);
+
+    const char *name = strrchr(upipe_hls_sink->prefix, '/');
+    name = name != NULL ? name + 1 : upipe_hls_sink->prefix;
+    upipe_hls_sink_write_playlist(upipe, "#EXTINF:%"PRIu64".%03"PRIu64",\n"
+                                  "%s%"PRIu64 SEGMENT_SUFFIX "\n",
+                                  duration / UCLOCK_FREQ,
+                                  (duration % UCLOCK_FREQ) * 1000 / UCLOCK_FREQ,
+                                  name, index);
+}
+
+/** @internal @This opens a new segment.
+ *
+ * @param upipe description structure of the pipe
+ * @param start date of the first uref of the segment
+ */
+static void upipe_hls_sink_open_segment(struct upipe *upipe, uint64_t start)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    size_t len = strlen(upipe_hls_sink->prefix) + 21 + strlen(SEGMENT_SUFFIX);
+    char uri[len + 1];
+    snprintf(uri, sizeof (uri), "%s%"PRIu64 SEGMENT_SUFFIX,
+             upipe_hls_sink->prefix, upipe_hls_sink->index);
+    upipe_hls_sink->segment =
+        upipe_hls_sink_writer_alloc(upipe, upipe_hls_sink->flow_def, uri,
+                                    "segment");
+    upipe_hls_sink->segment_start = start;
+    upipe_hls_sink->segment_last = start;
+}
+
+/** @internal @This closes the last segment and the playlist.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_hls_sink_end(struct upipe *upipe)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    upipe_hls_sink_close_segment(upipe, upipe_hls_sink->segment_last);
+    if (upipe_hls_sink->playlist != NULL) {
+        upipe_hls_sink_write_playlist(upipe, "#EXT-X-ENDLIST\n");
+        upipe_release(upipe_hls_sink->playlist);
+        upipe_hls_sink->playlist = NULL;
+    }
+    upipe_hls_sink->target = 0;
+    upipe_hls_sink->index = 0;
+    upipe_hls_sink->segment_start = UINT64_MAX;
+    upipe_hls_sink->segment_last = UINT64_MAX;
+}
+
+/** @internal @This handles data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_hls_sink_input(struct upipe *upipe, struct uref *uref,
+                                 struct upump **upump_p)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    if (unlikely(upipe_hls_sink->uri == NULL ||
+                 upipe_hls_sink->writer_mgr == NULL ||
+                 upipe_hls_sink->flow_def == NULL)) {
+        upipe_warn(upipe, "received a buffer before opening a playlist");
+        uref_free(uref);
+        return;
+    }
+
+    uint64_t cr_sys;
+    if (unlikely(!ubase_check(uref_clock_get_cr_sys(uref, &cr_sys)))) {
+        upipe_warn(upipe, "uref has no cr_sys, dropping");
+        uref_free(uref);
+        return;
+    }
+
+    if (ubase_check(uref_flow_get_random(uref)) &&
+        (upipe_hls_sink->segment == NULL ||
+         cr_sys >= upipe_hls_sink->segment_start + upipe_hls_sink->duration)) {
+        upipe_hls_sink_close_segment(upipe, cr_sys);
+        upipe_hls_sink_open_segment(upipe, cr_sys);
+    }
+
+    if (unlikely(upipe_hls_sink->segment == NULL)) {
+        /* segments must start on a random access point */
+        uref_free(uref);
+        return;
+    }
+    upipe_hls_sink->segment_last = cr_sys;
+    upipe_input(upipe_hls_sink->segment, uref, upump_p);
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_hls_sink_set_flow_def(struct upipe *upipe,
+                                       struct uref *flow_def)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, EXPECTED_FLOW_DEF))
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup)
+    uref_free(upipe_hls_sink->flow_def);
+    upipe_hls_sink->flow_def = flow_def_dup;
+    if (upipe_hls_sink->segment != NULL)
+        upipe_set_flow_def(upipe_hls_sink->segment, flow_def);
+
+    if (upipe_hls_sink->ubuf_mgr == NULL &&
+        (flow_def_dup = uref_dup(flow_def)) != NULL)
+        upipe_hls_sink_require_ubuf_mgr(upipe, flow_def_dup);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the playlist URI. The current playlist, if any,
+ * is ended first.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri playlist URI, or NULL
+ * @return an error code
+ */
+static int upipe_hls_sink_set_uri(struct upipe *upipe, const char *uri)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    upipe_hls_sink_end(upipe);
+    ubase_clean_str(&upipe_hls_sink->uri);
+    ubase_clean_str(&upipe_hls_sink->prefix);
+    if (uri == NULL)
+        return UBASE_ERR_NONE;
+
+    upipe_hls_sink->uri = strdup(uri);
+    upipe_hls_sink->prefix = strdup(uri);
+    if (unlikely(upipe_hls_sink->uri == NULL ||
+                 upipe_hls_sink->prefix == NULL)) {
+        ubase_clean_str(&upipe_hls_sink->uri);
+        ubase_clean_str(&upipe_hls_sink->prefix);
+        return UBASE_ERR_ALLOC;
+    }
+    char *ext = strrchr(upipe_hls_sink->prefix, '.');
+    if (ext != NULL && strchr(ext, '/') == NULL)
+        *ext = '\0';
+    upipe_notice_va(upipe, "writing playlist %s", uri);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_hls_sink_control(struct upipe *upipe, int command,
+                                  va_list args)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST:
+        case UPIPE_UNREGISTER_REQUEST:
+            return upipe_control_provide_request(upipe, command, args);
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_hls_sink_set_flow_def(upipe, flow_def);
+        }
+        case UPIPE_GET_URI: {
+            const char **uri_p = va_arg(args, const char **);
+            *uri_p = upipe_hls_sink->uri;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SET_URI: {
+            const char *uri = va_arg(args, const char *);
+            return upipe_hls_sink_set_uri(upipe, uri);
+        }
+        case UPIPE_HLS_SINK_SET_WRITER_MGR: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_SINK_SIGNATURE)
+            struct upipe_mgr *writer_mgr = va_arg(args, struct upipe_mgr *);
+            upipe_mgr_release(upipe_hls_sink->writer_mgr);
+            upipe_hls_sink->writer_mgr = upipe_mgr_use(writer_mgr);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_HLS_SINK_GET_WRITER_MGR: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_SINK_SIGNATURE)
+            struct upipe_mgr **writer_mgr_p =
+                va_arg(args, struct upipe_mgr **);
+            *writer_mgr_p = upipe_hls_sink->writer_mgr;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_HLS_SINK_SET_DURATION: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_SINK_SIGNATURE)
+            uint64_t duration = va_arg(args, uint64_t);
+            if (unlikely(!duration))
+                return UBASE_ERR_INVALID;
+            upipe_hls_sink->duration = duration;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_HLS_SINK_GET_DURATION: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_SINK_SIGNATURE)
+            uint64_t *duration_p = va_arg(args, uint64_t *);
+            *duration_p = upipe_hls_sink->duration;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This frees all resources allocated.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_hls_sink_free(struct upipe *upipe)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    upipe_hls_sink_end(upipe);
+    upipe_throw_dead(upipe);
+
+    free(upipe_hls_sink->uri);
+    free(upipe_hls_sink->prefix);
+    upipe_mgr_release(upipe_hls_sink->writer_mgr);
+    uref_free(upipe_hls_sink->flow_def);
+    upipe_hls_sink_clean_ubuf_mgr(upipe);
+    upipe_hls_sink_clean_uref_mgr(upipe);
+    upipe_hls_sink_clean_urefcount(upipe);
+    upipe_hls_sink_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_hls_sink_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_HLS_SINK_SIGNATURE,
+
+    .upipe_alloc = upipe_hls_sink_alloc,
+    .upipe_input = upipe_hls_sink_input,
+    .upipe_control = upipe_hls_sink_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for hls sink pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_hls_sink_mgr_alloc(void)
+{
+    return &upipe_hls_sink_mgr;
+}
@@ -41,6 +41,8 @@
 #include <upipe/upipe_helper_output.h>
 #include <upipe-modules/upipe_htons.h>
 
+#include "upipe_pcm_convert.h"
+
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -125,11 +127,7 @@ static void upipe_htons_input(struct upipe *upipe, struct uref *uref,
             return;
         }
 
-        for (int i = 0; i < bufsize - 1; i += 2) {
-            uint8_t t = buf[i];
-            buf[i] = buf[i + 1];
-            buf[i + 1] = t;
-        }
+        upipe_pcm_bswap16(buf, buf, bufsize / 2);
 
         uref_block_unmap(uref, offset);
         offset += bufsize;
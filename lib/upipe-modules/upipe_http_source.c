@@ -27,6 +27,8 @@
  * @short Upipe source module for http GET requests
  */
 
+#include <config.h>
+
 #include <stdio.h>
 #include <upipe/ubase.h>
 #include <upipe/ucookie.h>
@@ -58,6 +60,7 @@
 #include <stdint.h>
 #include <stdarg.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -68,6 +71,11 @@
 #include <errno.h>
 #include <assert.h>
 
+#ifdef HAVE_OPENSSL_SSL_H
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#endif
+
 #include "http-parser/http_parser.h"
 
 /** default size of buffers when unspecified */
@@ -76,6 +84,10 @@
 #define MAX_URL_SIZE            2048
 #define HTTP_VERSION            "HTTP/1.1"
 #define USER_AGENT              "upipe_http_src"
+/** default maximum number of idle connections kept by the manager */
+#define DEFAULT_KEEP_ALIVE      4
+/** maximum number of TLS sessions kept for resumption */
+#define MAX_TLS_SESSIONS        16
 
 struct http_range {
     uint64_t offset;
@@ -95,6 +107,18 @@ UBASE_FROM_TO(upipe_http_src_cookie, uchain, uchain, uchain)
 
 /** @hidden */
 static int upipe_http_src_check(struct upipe *upipe, struct uref *flow_format);
+struct ssl_st;
+
+/** @hidden */
+static int upipe_http_src_mgr_pop_conn(struct upipe_mgr *mgr,
+                                       const char *key,
+                                       struct ssl_st **ssl_p);
+/** @hidden */
+static void upipe_http_src_mgr_push_conn(struct upipe_mgr *mgr,
+                                         const char *key, int fd,
+                                         struct ssl_st *ssl);
+/** @hidden */
+static void upipe_http_src_tls_free(struct ssl_st *ssl);
 
 struct header {
     const char *value;
@@ -146,6 +170,14 @@ struct upipe_http_src {
 
     /** socket descriptor */
     int fd;
+    /** host and port of the connection */
+    char *conn_key;
+    /** the connection may be reused after the response */
+    bool keep_alive;
+    /** TLS connection, or NULL for plain http */
+    struct ssl_st *ssl;
+    /** the TLS handshake is in progress */
+    bool handshake;
     /** a request is pending */
     bool request_pending;
     /** http url */
@@ -161,6 +193,10 @@ struct upipe_http_src {
     /** range */
     struct http_range range;
     uint64_t position;
+    /** date the request was sent, or UINT64_MAX */
+    uint64_t request_date;
+    /** size of the response body received so far */
+    uint64_t received;
 
     /** http parser*/
     http_parser parser;
@@ -232,10 +268,16 @@ static struct upipe *upipe_http_src_alloc(struct upipe_mgr *mgr,
 
     struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
     upipe_http_src->fd = -1;
+    upipe_http_src->conn_key = NULL;
+    upipe_http_src->keep_alive = false;
+    upipe_http_src->ssl = NULL;
+    upipe_http_src->handshake = false;
     upipe_http_src->request_pending = false;
     upipe_http_src->url = NULL;
     upipe_http_src->range = HTTP_RANGE(0, -1);
     upipe_http_src->position = 0;
+    upipe_http_src->request_date = UINT64_MAX;
+    upipe_http_src->received = 0;
     upipe_http_src->location = NULL;
     upipe_http_src->header_field = HEADER(NULL, 0);
     upipe_http_src->proxy = NULL;
@@ -276,11 +318,25 @@ static void upipe_http_src_close(struct upipe *upipe)
 
     if (likely(upipe_http_src->url != NULL))
         upipe_notice_va(upipe, "closing %s", upipe_http_src->url);
-    ubase_clean_fd(&upipe_http_src->fd);
-    ubase_clean_str(&upipe_http_src->url);
     upipe_http_src_set_upump(upipe, NULL);
     upipe_http_src->request_pending = false;
+    upipe_http_src->request_date = UINT64_MAX;
     upipe_http_src_set_upump_write(upipe, NULL);
+    if (upipe_http_src->keep_alive && upipe_http_src->fd != -1 &&
+        !upipe_http_src->handshake) {
+        /* give the connection back to the manager */
+        upipe_http_src_mgr_push_conn(upipe->mgr, upipe_http_src->conn_key,
+                                     upipe_http_src->fd, upipe_http_src->ssl);
+        upipe_http_src->fd = -1;
+        upipe_http_src->ssl = NULL;
+    }
+    upipe_http_src->keep_alive = false;
+    upipe_http_src_tls_free(upipe_http_src->ssl);
+    upipe_http_src->ssl = NULL;
+    upipe_http_src->handshake = false;
+    ubase_clean_fd(&upipe_http_src->fd);
+    ubase_clean_str(&upipe_http_src->conn_key);
+    ubase_clean_str(&upipe_http_src->url);
     if (flow_def)
         uref_http_delete_content_type(flow_def);
 }
@@ -299,6 +355,7 @@ static void upipe_http_src_free(struct upipe *upipe)
 
     free(upipe_http_src->proxy);
     free(upipe_http_src->url);
+    free(upipe_http_src->conn_key);
     free(upipe_http_src->location);
     upipe_http_src_clean_output_size(upipe);
     upipe_http_src_clean_uclock(upipe);
@@ -429,6 +486,7 @@ static int upipe_http_src_output_data(struct upipe *upipe,
     if (len == 0)
         uref_block_set_end(uref);
     upipe_http_src->position += len;
+    upipe_http_src->received += len;
     upipe_http_src_output(upipe, uref, &upipe_http_src->upump);
 
     /* everything's fine, return 0 to http_parser */
@@ -451,12 +509,24 @@ static int upipe_http_src_message_complete(http_parser *parser)
 
     upipe_dbg_va(upipe, "message complete %i", status_code);
 
+    /* the whole response was read, the connection may serve another
+     * request */
+    upipe_http_src->keep_alive = http_should_keep_alive(parser);
+
     switch (status_code) {
     /* success */
     case 200:
     /* partial content */
     case 206:
         upipe_http_src_output_data(upipe, NULL, 0);
+        if (upipe_http_src->uclock != NULL &&
+            upipe_http_src->request_date != UINT64_MAX) {
+            uint64_t now = uclock_now(upipe_http_src->uclock);
+            if (now > upipe_http_src->request_date)
+                upipe_http_src_throw_downloaded(
+                    upipe, upipe_http_src->received,
+                    now - upipe_http_src->request_date);
+        }
         break;
     }
     upipe_http_src_close(upipe);
@@ -502,6 +572,300 @@ static int upipe_http_src_body_cb(http_parser *parser, const char *at, size_t le
     return 0;
 }
 
+#ifdef HAVE_OPENSSL_SSL_H
+/** @hidden */
+static SSL_CTX *upipe_http_src_mgr_get_ssl_ctx(struct upipe_mgr *mgr);
+/** @hidden */
+static SSL_SESSION *upipe_http_src_mgr_get_session(struct upipe_mgr *mgr,
+                                                   const char *key);
+
+/** @internal @This prints the pending TLS errors.
+ *
+ * @param upipe description structure of the pipe
+ * @param what operation which failed
+ */
+static void upipe_http_src_tls_err(struct upipe *upipe, const char *what)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    long verify = SSL_get_verify_result(upipe_http_src->ssl);
+    if (verify != X509_V_OK)
+        upipe_err_va(upipe, "%s: certificate verification failed (%s)",
+                     what, X509_verify_cert_error_string(verify));
+
+    unsigned long err;
+    while ((err = ERR_get_error()) != 0) {
+        char buf[256];
+        ERR_error_string_n(err, buf, sizeof (buf));
+        upipe_err_va(upipe, "%s: %s", what, buf);
+    }
+}
+
+/** @internal @This starts a TLS connection on the socket. The handshake
+ * is then run by the read and write watchers.
+ *
+ * @param upipe description structure of the pipe
+ * @param host host name of the server, for SNI and certificate checking
+ * @return an error code
+ */
+static int upipe_http_src_tls_open(struct upipe *upipe, const char *host)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+
+    SSL_CTX *ctx = upipe_http_src_mgr_get_ssl_ctx(upipe->mgr);
+    if (unlikely(ctx == NULL)) {
+        upipe_err(upipe, "unable to create TLS context");
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    /* TLS records may be partially received, so never block in SSL_read */
+    int flags = fcntl(upipe_http_src->fd, F_GETFL);
+    if (unlikely(flags == -1 ||
+                 fcntl(upipe_http_src->fd, F_SETFL, flags | O_NONBLOCK))) {
+        upipe_err_va(upipe, "unable to set non-blocking mode (%s)",
+                     strerror(errno));
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    SSL *ssl = SSL_new(ctx);
+    UBASE_ALLOC_RETURN(ssl);
+    if (unlikely(!SSL_set_fd(ssl, upipe_http_src->fd) ||
+                 !SSL_set_tlsext_host_name(ssl, host) ||
+                 !SSL_set1_host(ssl, host))) {
+        SSL_free(ssl);
+        upipe_err(upipe, "unable to set up TLS connection");
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    SSL_SESSION *session =
+        upipe_http_src_mgr_get_session(upipe->mgr, upipe_http_src->conn_key);
+    if (session != NULL)
+        SSL_set_session(ssl, session);
+    SSL_set_app_data(ssl, upipe);
+    SSL_set_connect_state(ssl);
+
+    upipe_http_src->ssl = ssl;
+    upipe_http_src->handshake = true;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This runs the TLS handshake.
+ *
+ * @param upipe description structure of the pipe
+ * @param want_read_p filled with true if the handshake waits for data to
+ * read, or false if it waits for the socket to be writable
+ * @return UBASE_ERR_BUSY if the handshake is not finished, or an error code
+ */
+static int upipe_http_src_tls_handshake(struct upipe *upipe,
+                                        bool *want_read_p)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    SSL *ssl = upipe_http_src->ssl;
+
+    ERR_clear_error();
+    int ret = SSL_do_handshake(ssl);
+    if (ret == 1) {
+        upipe_http_src->handshake = false;
+        upipe_dbg_va(upipe, "%s connection established%s", SSL_get_version(ssl),
+                     SSL_session_reused(ssl) ? " (resumed)" : "");
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+        if (BIO_get_ktls_recv(SSL_get_rbio(ssl)))
+            upipe_dbg(upipe, "using kernel TLS for reception");
+#endif
+        return UBASE_ERR_NONE;
+    }
+
+    switch (SSL_get_error(ssl, ret)) {
+        case SSL_ERROR_WANT_READ:
+            *want_read_p = true;
+            return UBASE_ERR_BUSY;
+        case SSL_ERROR_WANT_WRITE:
+            *want_read_p = false;
+            return UBASE_ERR_BUSY;
+        default:
+            break;
+    }
+    upipe_http_src_tls_err(upipe, "TLS handshake");
+    return UBASE_ERR_EXTERNAL;
+}
+
+/** @internal @This converts a failed TLS read or write to errno.
+ *
+ * @param ssl TLS connection
+ * @param ret return value of the failed operation
+ * @return 0 on end of stream or -1 with errno set
+ */
+static ssize_t upipe_http_src_tls_errno(SSL *ssl, int ret)
+{
+    switch (SSL_get_error(ssl, ret)) {
+        case SSL_ERROR_WANT_READ:
+        case SSL_ERROR_WANT_WRITE:
+            errno = EAGAIN;
+            return -1;
+        case SSL_ERROR_ZERO_RETURN:
+            return 0;
+        case SSL_ERROR_SYSCALL:
+            if (errno == 0)
+                return 0;
+            return -1;
+        default:
+            errno = EPROTO;
+            return -1;
+    }
+}
+
+/** @internal @This receives data from the TLS connection. With kernel
+ * TLS, the data is decrypted by the kernel straight into the buffer.
+ *
+ * @param upipe description structure of the pipe
+ * @param buffer buffer to fill
+ * @param size size of the buffer
+ * @return the number of octets received, 0 on end of stream or -1 with
+ * errno set
+ */
+static ssize_t upipe_http_src_tls_recv(struct upipe *upipe,
+                                       void *buffer, size_t size)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    ERR_clear_error();
+    errno = 0;
+    int ret = SSL_read(upipe_http_src->ssl, buffer, size);
+    if (ret > 0)
+        return ret;
+    return upipe_http_src_tls_errno(upipe_http_src->ssl, ret);
+}
+
+/** @internal @This sends data on the TLS connection.
+ *
+ * @param upipe description structure of the pipe
+ * @param buffer data to send
+ * @param size size of the data
+ * @return the number of octets sent or -1 with errno set
+ */
+static ssize_t upipe_http_src_tls_send(struct upipe *upipe,
+                                       const void *buffer, size_t size)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    ERR_clear_error();
+    errno = 0;
+    int ret = SSL_write(upipe_http_src->ssl, buffer, size);
+    if (ret > 0)
+        return ret;
+    ret = upipe_http_src_tls_errno(upipe_http_src->ssl, ret);
+    if (ret == 0)
+        errno = EPIPE;
+    return -1;
+}
+
+/** @internal @This checks if decrypted data is waiting to be read.
+ *
+ * @param upipe description structure of the pipe
+ * @return true if data is buffered in the TLS connection
+ */
+static bool upipe_http_src_tls_pending(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    return upipe_http_src->ssl != NULL && !upipe_http_src->handshake &&
+           SSL_pending(upipe_http_src->ssl) > 0;
+}
+
+/** @internal @This closes and frees a TLS connection. The socket is not
+ * closed.
+ *
+ * @param ssl TLS connection, may be NULL
+ */
+static void upipe_http_src_tls_free(SSL *ssl)
+{
+    if (ssl == NULL)
+        return;
+    /* best effort, the socket is not blocking */
+    if (SSL_is_init_finished(ssl))
+        SSL_shutdown(ssl);
+    SSL_free(ssl);
+}
+#else
+static int upipe_http_src_tls_open(struct upipe *upipe, const char *host)
+{
+    upipe_err(upipe, "https is not supported, rebuild with openssl");
+    return UBASE_ERR_UNHANDLED;
+}
+
+static int upipe_http_src_tls_handshake(struct upipe *upipe,
+                                        bool *want_read_p)
+{
+    return UBASE_ERR_UNHANDLED;
+}
+
+static ssize_t upipe_http_src_tls_recv(struct upipe *upipe,
+                                       void *buffer, size_t size)
+{
+    errno = EBADF;
+    return -1;
+}
+
+static ssize_t upipe_http_src_tls_send(struct upipe *upipe,
+                                       const void *buffer, size_t size)
+{
+    errno = EBADF;
+    return -1;
+}
+
+static bool upipe_http_src_tls_pending(struct upipe *upipe)
+{
+    return false;
+}
+
+static void upipe_http_src_tls_free(struct ssl_st *ssl)
+{
+}
+#endif
+
+/** @internal @This receives data from the server.
+ *
+ * @param upipe description structure of the pipe
+ * @param buffer buffer to fill
+ * @param size size of the buffer
+ * @return the number of octets received, 0 on end of stream or -1 with
+ * errno set
+ */
+static ssize_t upipe_http_src_recv(struct upipe *upipe,
+                                   void *buffer, size_t size)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    if (upipe_http_src->ssl != NULL)
+        return upipe_http_src_tls_recv(upipe, buffer, size);
+    return recv(upipe_http_src->fd, buffer, size, 0);
+}
+
+/** @internal @This sends data to the server.
+ *
+ * @param upipe description structure of the pipe
+ * @param buffer data to send
+ * @param size size of the data
+ * @return the number of octets sent or -1 with errno set
+ */
+static ssize_t upipe_http_src_send(struct upipe *upipe,
+                                   const void *buffer, size_t size)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    if (upipe_http_src->ssl != NULL)
+        return upipe_http_src_tls_send(upipe, buffer, size);
+    return send(upipe_http_src->fd, buffer, size, 0);
+}
+
+/** @internal @This stops the watchers and throws an end of source event
+ * when the connection failed.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_http_src_abort(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    upipe_http_src->keep_alive = false;
+    upipe_http_src_set_upump_write(upipe, NULL);
+    upipe_http_src_set_upump(upipe, NULL);
+    upipe_throw_source_end(upipe);
+}
+
 /** @internal @This parses and outputs data.
  *
  * @param upipe description structure of the pipe
@@ -533,15 +897,13 @@ static void upipe_http_src_process(struct upipe *upipe,
     uref_free(uref);
 }
 
-/** @internal @This reads data from the source and outputs it.
- * It is called either when the idler triggers (permanent storage mode) or
- * when data is available on the http descriptor (live stream mode).
+/** @internal @This reads a block from the connection and processes it.
  *
- * @param upump description structure of the read watcher
+ * @param upipe description structure of the pipe
+ * @return true if a block was processed
  */
-static void upipe_http_src_worker(struct upump *upump)
+static bool upipe_http_src_read(struct upipe *upipe)
 {
-    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
 
     struct uref *uref = uref_block_alloc(upipe_http_src->uref_mgr,
@@ -549,7 +911,7 @@ static void upipe_http_src_worker(struct upump *upump)
                                          upipe_http_src->output_size);
     if (unlikely(uref == NULL)) {
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        return;
+        return false;
     }
 
     uint8_t *buffer;
@@ -558,12 +920,12 @@ static void upipe_http_src_worker(struct upump *upump)
                     uref, 0, &output_size, &buffer)))) {
         uref_free(uref);
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        return;
+        return false;
     }
     assert(output_size == upipe_http_src->output_size);
 
-    ssize_t len = recv(upipe_http_src->fd, buffer,
-                       upipe_http_src->output_size, 0);
+    ssize_t len = upipe_http_src_recv(upipe, buffer,
+                                      upipe_http_src->output_size);
     uref_block_unmap(uref, 0);
 
     if (unlikely(len == -1)) {
@@ -576,7 +938,7 @@ static void upipe_http_src_worker(struct upump *upump)
             case EWOULDBLOCK:
 #endif
                 /* not an issue, try again later */
-                return;
+                return false;
 
             default:
                 break;
@@ -586,6 +948,7 @@ static void upipe_http_src_worker(struct upump *upump)
         upipe_http_src_output_data(upipe, NULL, 0);
         upipe_http_src_set_upump(upipe, NULL);
         upipe_throw_source_end(upipe);
+        return false;
     }
     else if (unlikely(len == 0)) {
         upipe_dbg(upipe, "connection closed");
@@ -593,12 +956,43 @@ static void upipe_http_src_worker(struct upump *upump)
         upipe_http_src_output_data(upipe, NULL, 0);
         upipe_http_src_set_upump(upipe, NULL);
         upipe_throw_source_end(upipe);
+        return false;
     }
-    else {
-        if (unlikely(len != upipe_http_src->output_size))
-            uref_block_resize(uref, 0, len);
-        upipe_http_src_process(upipe, uref);
+
+    if (unlikely(len != upipe_http_src->output_size))
+        uref_block_resize(uref, 0, len);
+    upipe_http_src_process(upipe, uref);
+    return true;
+}
+
+/** @internal @This reads data from the source and outputs it.
+ * It is called either when the idler triggers (permanent storage mode) or
+ * when data is available on the http descriptor (live stream mode).
+ *
+ * @param upump description structure of the read watcher
+ */
+static void upipe_http_src_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+
+    if (upipe_http_src->handshake) {
+        bool want_read = true;
+        int ret = upipe_http_src_tls_handshake(upipe, &want_read);
+        if (ret == UBASE_ERR_BUSY && want_read)
+            return;
+        if (unlikely(ret != UBASE_ERR_BUSY && !ubase_check(ret))) {
+            upipe_http_src_abort(upipe);
+            return;
+        }
+        /* the handshake needs to write, or the request may be sent */
+        if (upipe_http_src->upump_write != NULL)
+            upump_start(upipe_http_src->upump_write);
+        return;
     }
+
+    /* a TLS record may hold more than one block */
+    while (upipe_http_src_read(upipe) && upipe_http_src_tls_pending(upipe));
 }
 
 UBASE_FMT_PRINTF(3, 4)
@@ -734,8 +1128,8 @@ static int upipe_http_src_send_request(struct upipe *upipe)
         return UBASE_ERR_ALLOC;
     }
 
-    ret = send(upipe_http_src->fd, req_buffer,
-               sizeof (req_buffer) - req_len, 0);
+    ret = upipe_http_src_send(upipe, req_buffer,
+                              sizeof (req_buffer) - req_len);
     if (ret < 0) {
         switch(errno) {
             case EINTR:
@@ -763,11 +1157,29 @@ static void upipe_http_src_worker_write(struct upump *upump)
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
 
+    if (upipe_http_src->handshake) {
+        bool want_read = false;
+        int ret = upipe_http_src_tls_handshake(upipe, &want_read);
+        if (ret == UBASE_ERR_BUSY) {
+            /* restarted by the read watcher */
+            if (want_read)
+                upump_stop(upump);
+            return;
+        }
+        if (unlikely(!ubase_check(ret))) {
+            upipe_http_src_abort(upipe);
+            return;
+        }
+    }
+
     if (unlikely(!ubase_check(upipe_http_src_send_request(upipe)))) {
         upipe_err(upipe, "fail to send request");
     }
     else {
         upipe_http_src->request_pending = false;
+        upipe_http_src->received = 0;
+        upipe_http_src->request_date = upipe_http_src->uclock != NULL ?
+            uclock_now(upipe_http_src->uclock) : UINT64_MAX;
         upipe_http_src_set_upump_write(upipe, NULL);
     }
 }
@@ -863,25 +1275,43 @@ static int upipe_http_src_get_uri(struct upipe *upipe, const char **url_p)
     return UBASE_ERR_NONE;
 }
 
-/** @internal @This asks to open the given http (real code here).
+/** @internal @This connects to a server, or reuses an idle connection to
+ * the same server kept by the manager.
  *
  * @param upipe description structure of the pipe
- * @param url relative or absolute url of the http
+ * @param host host name of the server
+ * @param service port or scheme of the server
+ * @param tls true to wrap the connection in TLS
  * @return an error code
  */
-static int upipe_http_src_open_url(struct upipe *upipe)
+static int upipe_http_src_connect(struct upipe *upipe,
+                                  const char *host, const char *service,
+                                  bool tls)
 {
     struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
-    struct uref *flow_def = upipe_http_src->flow_def;
     struct addrinfo *info = NULL, *res;
     struct addrinfo hints;
     int ret, fd = -1;
 
-    if (unlikely(flow_def == NULL))
-        return UBASE_ERR_INVALID;
-
-    /* init parser */
-    http_parser_init(&upipe_http_src->parser, HTTP_RESPONSE);
+    const char *prefix = tls ? "https://" : "";
+    char key[strlen(prefix) + strlen(host) + 1 + strlen(service) + 1];
+    snprintf(key, sizeof (key), "%s%s:%s", prefix, host, service);
+    ubase_clean_str(&upipe_http_src->conn_key);
+    upipe_http_src->conn_key = strdup(key);
+    UBASE_ALLOC_RETURN(upipe_http_src->conn_key);
+
+    struct ssl_st *ssl = NULL;
+    fd = upipe_http_src_mgr_pop_conn(upipe->mgr, key, &ssl);
+    if (fd >= 0) {
+        upipe_dbg_va(upipe, "reusing connection to %s", key);
+        upipe_http_src->fd = fd;
+        upipe_http_src->ssl = ssl;
+#ifdef HAVE_OPENSSL_SSL_H
+        if (ssl != NULL)
+            SSL_set_app_data(ssl, upipe);
+#endif
+        return UBASE_ERR_NONE;
+    }
 
     /* get socket information */
     memset(&hints, 0, sizeof(struct addrinfo));
@@ -889,36 +1319,9 @@ static int upipe_http_src_open_url(struct upipe *upipe)
     hints.ai_socktype = SOCK_STREAM;
     hints.ai_protocol = 0;
 
-    if (upipe_http_src->proxy) {
-        struct uuri uuri;
-        ret = uuri_from_str(&uuri, upipe_http_src->proxy);
-        if (!ubase_check(ret)) {
-            upipe_err_va(upipe, "invalid http_proxy %s",
-                         upipe_http_src->proxy);
-            return UBASE_ERR_INVALID;
-        }
-        char host[uuri.authority.host.len + 1];
-        ustring_cpy(uuri.authority.host, host, sizeof (host));
-        char service[uuri.authority.port.len + 1];
-        ustring_cpy(uuri.authority.port, service, sizeof (service));
-
-        upipe_verbose_va(upipe, "getaddrinfo to %s%s%s",
-                         host, strlen(service) ? ":" : "",
-                         service);
-        ret = getaddrinfo(host, service, &hints, &info);
-    }
-    else {
-        const char *host;
-        UBASE_RETURN(uref_uri_get_host(flow_def, &host));
-
-        const char *service;
-        if (!ubase_check(uref_uri_get_port(flow_def, &service)))
-            UBASE_RETURN(uref_uri_get_scheme(flow_def, &service));
-
-        upipe_verbose_va(upipe, "getaddrinfo to %s", host);
-        ret = getaddrinfo(host, service, &hints, &info);
-    }
-
+    upipe_verbose_va(upipe, "getaddrinfo to %s%s%s",
+                     host, strlen(service) ? ":" : "", service);
+    ret = getaddrinfo(host, service, &hints, &info);
     if (unlikely(ret)) {
         upipe_err_va(upipe, "getaddrinfo: %s", gai_strerror(ret));
         return UBASE_ERR_EXTERNAL;
@@ -942,9 +1345,67 @@ static int upipe_http_src_open_url(struct upipe *upipe)
     }
 
     upipe_http_src->fd = fd;
+    if (tls) {
+        ret = upipe_http_src_tls_open(upipe, host);
+        if (unlikely(!ubase_check(ret))) {
+            ubase_clean_fd(&upipe_http_src->fd);
+            return ret;
+        }
+    }
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This asks to open the given http (real code here).
+ *
+ * @param upipe description structure of the pipe
+ * @param url relative or absolute url of the http
+ * @return an error code
+ */
+static int upipe_http_src_open_url(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct uref *flow_def = upipe_http_src->flow_def;
+    int ret;
+
+    if (unlikely(flow_def == NULL))
+        return UBASE_ERR_INVALID;
+
+    /* init parser */
+    http_parser_init(&upipe_http_src->parser, HTTP_RESPONSE);
+
+    const char *scheme;
+    bool tls = ubase_check(uref_uri_get_scheme(flow_def, &scheme)) &&
+               !strcasecmp(scheme, "https");
+
+    if (upipe_http_src->proxy) {
+        if (tls) {
+            upipe_err(upipe, "https through a proxy is not supported");
+            return UBASE_ERR_UNHANDLED;
+        }
+        struct uuri uuri;
+        ret = uuri_from_str(&uuri, upipe_http_src->proxy);
+        if (!ubase_check(ret)) {
+            upipe_err_va(upipe, "invalid http_proxy %s",
+                         upipe_http_src->proxy);
+            return UBASE_ERR_INVALID;
+        }
+        char host[uuri.authority.host.len + 1];
+        ustring_cpy(uuri.authority.host, host, sizeof (host));
+        char service[uuri.authority.port.len + 1];
+        ustring_cpy(uuri.authority.port, service, sizeof (service));
+        return upipe_http_src_connect(upipe, host, service, false);
+    }
+
+    const char *host;
+    UBASE_RETURN(uref_uri_get_host(flow_def, &host));
+
+    const char *service;
+    if (!ubase_check(uref_uri_get_port(flow_def, &service)))
+        UBASE_RETURN(uref_uri_get_scheme(flow_def, &service));
+
+    return upipe_http_src_connect(upipe, host, service, tls);
+}
+
 /** @internal @This asks to open the given http.
  *
  * @param upipe description structure of the pipe
@@ -1128,11 +1589,273 @@ struct upipe_http_src_mgr {
     struct uchain cookies;
     /** proxy url */
     char *proxy;
+    /** list of idle connections */
+    struct uchain conns;
+    /** number of idle connections */
+    unsigned int nb_conns;
+    /** maximum number of idle connections */
+    unsigned int max_conns;
+    /** TLS context, allocated on first use */
+    struct ssl_ctx_st *ssl_ctx;
+    /** list of TLS sessions to resume */
+    struct uchain sessions;
+    /** number of TLS sessions */
+    unsigned int nb_sessions;
 };
 
 UBASE_FROM_TO(upipe_http_src_mgr, upipe_mgr, upipe_mgr, upipe_mgr)
 UBASE_FROM_TO(upipe_http_src_mgr, urefcount, urefcount, urefcount);
 
+/** @internal @This is an idle connection kept for reuse. */
+struct upipe_http_src_conn {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** socket descriptor */
+    int fd;
+    /** TLS connection, or NULL */
+    struct ssl_st *ssl;
+    /** host and port of the server */
+    char *key;
+};
+
+UBASE_FROM_TO(upipe_http_src_conn, uchain, uchain, uchain)
+
+#ifdef HAVE_OPENSSL_SSL_H
+/** @internal @This is a TLS session kept for resumption. */
+struct upipe_http_src_session {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** host and port of the server */
+    char *key;
+    /** TLS session */
+    SSL_SESSION *session;
+};
+
+UBASE_FROM_TO(upipe_http_src_session, uchain, uchain, uchain)
+
+/** @internal @This frees a TLS session.
+ *
+ * @param upipe_http_src_mgr pointer to the manager
+ * @param session TLS session
+ */
+static void upipe_http_src_mgr_free_session(
+    struct upipe_http_src_mgr *upipe_http_src_mgr,
+    struct upipe_http_src_session *session)
+{
+    ulist_delete(upipe_http_src_session_to_uchain(session));
+    upipe_http_src_mgr->nb_sessions--;
+    SSL_SESSION_free(session->session);
+    free(session->key);
+    free(session);
+}
+
+/** @internal @This returns the TLS session to resume for a server.
+ *
+ * @param mgr pointer to upipe manager
+ * @param key host and port of the server
+ * @return a TLS session, or NULL
+ */
+static SSL_SESSION *upipe_http_src_mgr_get_session(struct upipe_mgr *mgr,
+                                                   const char *key)
+{
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(mgr);
+
+    struct uchain *uchain;
+    ulist_foreach(&upipe_http_src_mgr->sessions, uchain) {
+        struct upipe_http_src_session *session =
+            upipe_http_src_session_from_uchain(uchain);
+        if (!strcmp(session->key, key))
+            return session->session;
+    }
+    return NULL;
+}
+
+/** @internal @This is called by OpenSSL when the server sends a new session
+ * (or session ticket), and keeps it to resume the next connection to the
+ * same server.
+ *
+ * @param ssl TLS connection
+ * @param new_session new session
+ * @return 1 if the session was kept, 0 otherwise
+ */
+static int upipe_http_src_mgr_new_session(SSL *ssl, SSL_SESSION *new_session)
+{
+    struct upipe *upipe = SSL_get_app_data(ssl);
+    if (upipe == NULL)
+        return 0;
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(upipe->mgr);
+    if (upipe_http_src->conn_key == NULL)
+        return 0;
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach(&upipe_http_src_mgr->sessions, uchain, uchain_tmp) {
+        struct upipe_http_src_session *session =
+            upipe_http_src_session_from_uchain(uchain);
+        if (!strcmp(session->key, upipe_http_src->conn_key))
+            upipe_http_src_mgr_free_session(upipe_http_src_mgr, session);
+    }
+
+    struct upipe_http_src_session *session = malloc(sizeof (*session));
+    if (unlikely(session == NULL))
+        return 0;
+    session->key = strdup(upipe_http_src->conn_key);
+    if (unlikely(session->key == NULL)) {
+        free(session);
+        return 0;
+    }
+    session->session = new_session;
+
+    if (upipe_http_src_mgr->nb_sessions >= MAX_TLS_SESSIONS) {
+        uchain = ulist_peek(&upipe_http_src_mgr->sessions);
+        upipe_http_src_mgr_free_session(upipe_http_src_mgr,
+            upipe_http_src_session_from_uchain(uchain));
+    }
+    ulist_add(&upipe_http_src_mgr->sessions,
+              upipe_http_src_session_to_uchain(session));
+    upipe_http_src_mgr->nb_sessions++;
+    return 1;
+}
+
+/** @internal @This returns the TLS context of the manager, and allocates
+ * it if needed.
+ *
+ * @param mgr pointer to upipe manager
+ * @return a TLS context, or NULL
+ */
+static SSL_CTX *upipe_http_src_mgr_get_ssl_ctx(struct upipe_mgr *mgr)
+{
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(mgr);
+    if (upipe_http_src_mgr->ssl_ctx != NULL)
+        return upipe_http_src_mgr->ssl_ctx;
+
+    SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+    if (unlikely(ctx == NULL))
+        return NULL;
+    if (unlikely(!SSL_CTX_set_default_verify_paths(ctx))) {
+        SSL_CTX_free(ctx);
+        return NULL;
+    }
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, NULL);
+    /* a failed write is retried from the same buffer, not the same address */
+    SSL_CTX_set_mode(ctx, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT |
+                                        SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, upipe_http_src_mgr_new_session);
+#ifdef SSL_OP_ENABLE_KTLS
+    /* let the kernel decrypt when the cipher allows it */
+    SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#endif
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+    SSL_CTX_set_options(ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+#endif
+    upipe_http_src_mgr->ssl_ctx = ctx;
+    return ctx;
+}
+#endif
+
+/** @internal @This closes and frees an idle connection.
+ *
+ * @param upipe_http_src_mgr pointer to the manager
+ * @param conn idle connection
+ */
+static void upipe_http_src_mgr_free_conn(
+    struct upipe_http_src_mgr *upipe_http_src_mgr,
+    struct upipe_http_src_conn *conn)
+{
+    ulist_delete(upipe_http_src_conn_to_uchain(conn));
+    upipe_http_src_mgr->nb_conns--;
+    upipe_http_src_tls_free(conn->ssl);
+    ubase_clean_fd(&conn->fd);
+    free(conn->key);
+    free(conn);
+}
+
+/** @internal @This returns an idle connection to a server, if there is one
+ * which was not closed by the server in the meantime.
+ *
+ * @param mgr pointer to upipe manager
+ * @param key host and port of the server
+ * @param ssl_p filled in with the TLS connection, or NULL
+ * @return a socket descriptor, or -1
+ */
+static int upipe_http_src_mgr_pop_conn(struct upipe_mgr *mgr,
+                                       const char *key,
+                                       struct ssl_st **ssl_p)
+{
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(mgr);
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach(&upipe_http_src_mgr->conns, uchain, uchain_tmp) {
+        struct upipe_http_src_conn *conn =
+            upipe_http_src_conn_from_uchain(uchain);
+        if (strcmp(conn->key, key))
+            continue;
+
+        /* an idle connection must have nothing to read, otherwise it was
+         * closed or is out of sync */
+        char c;
+        if (recv(conn->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) == -1 &&
+            (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            int fd = conn->fd;
+            *ssl_p = conn->ssl;
+            conn->fd = -1;
+            conn->ssl = NULL;
+            upipe_http_src_mgr_free_conn(upipe_http_src_mgr, conn);
+            return fd;
+        }
+        upipe_http_src_mgr_free_conn(upipe_http_src_mgr, conn);
+    }
+    return -1;
+}
+
+/** @internal @This keeps an idle connection for reuse, or closes it if
+ * keep-alive is disabled. The oldest idle connection is closed if there
+ * are too many.
+ *
+ * @param mgr pointer to upipe manager
+ * @param key host and port of the server
+ * @param fd socket descriptor
+ * @param ssl TLS connection, or NULL
+ */
+static void upipe_http_src_mgr_push_conn(struct upipe_mgr *mgr,
+                                         const char *key, int fd,
+                                         struct ssl_st *ssl)
+{
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(mgr);
+
+    struct upipe_http_src_conn *conn = NULL;
+    if (upipe_http_src_mgr->max_conns && key != NULL)
+        conn = malloc(sizeof (*conn));
+    if (conn != NULL)
+        conn->key = strdup(key);
+    if (conn == NULL || conn->key == NULL) {
+        free(conn);
+        upipe_http_src_tls_free(ssl);
+        close(fd);
+        return;
+    }
+    conn->fd = fd;
+    conn->ssl = ssl;
+#ifdef HAVE_OPENSSL_SSL_H
+    if (ssl != NULL)
+        SSL_set_app_data(ssl, NULL);
+#endif
+
+    if (upipe_http_src_mgr->nb_conns >= upipe_http_src_mgr->max_conns) {
+        struct uchain *uchain = ulist_peek(&upipe_http_src_mgr->conns);
+        upipe_http_src_mgr_free_conn(upipe_http_src_mgr,
+                                     upipe_http_src_conn_from_uchain(uchain));
+    }
+    ulist_add(&upipe_http_src_mgr->conns, upipe_http_src_conn_to_uchain(conn));
+    upipe_http_src_mgr->nb_conns++;
+}
+
 static int _upipe_http_src_mgr_set_cookie(struct upipe_mgr *upipe_mgr,
                                           const char *cookie_string)
 {
@@ -1268,6 +1991,28 @@ static int upipe_http_src_mgr_control(struct upipe_mgr *upipe_mgr,
         const char *proxy = va_arg(args, const char *);
         return _upipe_http_src_mgr_set_proxy(upipe_mgr, proxy);
     }
+
+    case UPIPE_HTTP_SRC_MGR_GET_KEEP_ALIVE: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_HTTP_SRC_SIGNATURE)
+        unsigned int *max_idle_p = va_arg(args, unsigned int *);
+        struct upipe_http_src_mgr *upipe_http_src_mgr =
+            upipe_http_src_mgr_from_upipe_mgr(upipe_mgr);
+        *max_idle_p = upipe_http_src_mgr->max_conns;
+        return UBASE_ERR_NONE;
+    }
+    case UPIPE_HTTP_SRC_MGR_SET_KEEP_ALIVE: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_HTTP_SRC_SIGNATURE)
+        unsigned int max_idle = va_arg(args, unsigned int);
+        struct upipe_http_src_mgr *upipe_http_src_mgr =
+            upipe_http_src_mgr_from_upipe_mgr(upipe_mgr);
+        upipe_http_src_mgr->max_conns = max_idle;
+        while (upipe_http_src_mgr->nb_conns > max_idle) {
+            struct uchain *uchain = ulist_peek(&upipe_http_src_mgr->conns);
+            upipe_http_src_mgr_free_conn(upipe_http_src_mgr,
+                upipe_http_src_conn_from_uchain(uchain));
+        }
+        return UBASE_ERR_NONE;
+    }
     }
     return UBASE_ERR_UNHANDLED;
 }
@@ -1285,6 +2030,17 @@ static void upipe_http_src_mgr_free(struct urefcount *urefcount)
         free(cookie->value);
         free(cookie);
     }
+    ulist_delete_foreach(&upipe_http_src_mgr->conns, uchain, uchain_tmp) {
+        upipe_http_src_mgr_free_conn(upipe_http_src_mgr,
+                                     upipe_http_src_conn_from_uchain(uchain));
+    }
+#ifdef HAVE_OPENSSL_SSL_H
+    ulist_delete_foreach(&upipe_http_src_mgr->sessions, uchain, uchain_tmp) {
+        upipe_http_src_mgr_free_session(upipe_http_src_mgr,
+            upipe_http_src_session_from_uchain(uchain));
+    }
+    SSL_CTX_free(upipe_http_src_mgr->ssl_ctx);
+#endif
     free(upipe_http_src_mgr->proxy);
     urefcount_clean(urefcount);
     free(upipe_http_src_mgr);
@@ -1318,6 +2074,12 @@ struct upipe_mgr *upipe_http_src_mgr_alloc(void)
     upipe_mgr->refcount = urefcount;
     ulist_init(&upipe_http_src_mgr->cookies);
     upipe_http_src_mgr->proxy = NULL;
+    ulist_init(&upipe_http_src_mgr->conns);
+    upipe_http_src_mgr->nb_conns = 0;
+    upipe_http_src_mgr->max_conns = DEFAULT_KEEP_ALIVE;
+    upipe_http_src_mgr->ssl_ctx = NULL;
+    ulist_init(&upipe_http_src_mgr->sessions);
+    upipe_http_src_mgr->nb_sessions = 0;
 
     return upipe_http_src_mgr_to_upipe_mgr(upipe_http_src_mgr);
 }
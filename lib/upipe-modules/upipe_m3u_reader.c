@@ -155,6 +155,20 @@ struct upipe_m3u_reader {
     /** list of items */
     struct uchain items;
 
+    /** output incremental updates of media playlists */
+    bool incremental;
+    /** media sequence of the previous load */
+    uint64_t last_media_sequence;
+    /** sequence number of the last segment of the previous load, or
+     * UINT64_MAX */
+    uint64_t last_seq;
+    /** number of segments of the current load */
+    uint64_t nb_segments;
+    /** number of known segments to skip in the current load */
+    uint64_t skip;
+    /** the segments to skip have been computed for the current load */
+    bool skip_checked;
+
     /** public upipe structure */
     struct upipe upipe;
 
@@ -200,6 +214,12 @@ static struct upipe *upipe_m3u_reader_alloc(struct upipe_mgr *mgr,
     upipe_m3u_reader->item = NULL;
     upipe_m3u_reader->key = NULL;
     upipe_m3u_reader->restart = false;
+    upipe_m3u_reader->incremental = false;
+    upipe_m3u_reader->last_media_sequence = 0;
+    upipe_m3u_reader->last_seq = UINT64_MAX;
+    upipe_m3u_reader->nb_segments = 0;
+    upipe_m3u_reader->skip = 0;
+    upipe_m3u_reader->skip_checked = false;
     upipe_throw_ready(upipe);
 
     return upipe;
@@ -217,6 +237,9 @@ static void upipe_m3u_reader_flush(struct upipe *upipe)
     uref_free(upipe_m3u_reader->current_flow_def);
     uref_free(upipe_m3u_reader->item);
     upipe_m3u_reader->item = NULL;
+    upipe_m3u_reader->nb_segments = 0;
+    upipe_m3u_reader->skip = 0;
+    upipe_m3u_reader->skip_checked = false;
 
     struct uchain *uchain;
     while ((uchain = ulist_pop(&upipe_m3u_reader->items)) != NULL)
@@ -585,6 +608,232 @@ static int upipe_m3u_reader_process_byte_range(struct upipe *upipe,
     return uref_m3u_playlist_set_byte_range_len(item, byte_range_len);
 }
 
+/** @internal @This checks and parses a "#EXT-X-PART-INF" tag.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def the current flow definition
+ * @param line the trailing characters of the line
+ * @return an error code
+ */
+static int upipe_m3u_reader_ext_x_part_inf(struct upipe *upipe,
+                                           struct uref *flow_def,
+                                           const char *line)
+{
+    const char *def;
+    UBASE_RETURN(uref_flow_get_def(flow_def, &def));
+    if (strcmp(def, M3U_FLOW_DEF) && strcmp(def, PLAYLIST_FLOW_DEF))
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_set_def(flow_def, PLAYLIST_FLOW_DEF));
+
+    const char *iterator = line;
+    struct ustring name, value;
+    while (ubase_check(attribute_iterate(&iterator, &name, &value)) &&
+           iterator != NULL) {
+        char value_str[value.len + 1];
+        ustring_cpy(value, value_str, sizeof (value_str));
+
+        if (!ustring_cmp_str(name, "PART-TARGET")) {
+            const char *endptr;
+            uint64_t duration;
+            UBASE_RETURN(duration_to_uclock(value_str, &endptr, &duration));
+            if (endptr == value_str || strlen(endptr)) {
+                upipe_warn_va(upipe, "invalid part target %s", value_str);
+                return UBASE_ERR_INVALID;
+            }
+            upipe_dbg_va(upipe, "part target: %"PRIu64, duration);
+            UBASE_RETURN(uref_m3u_playlist_flow_set_part_target(flow_def,
+                                                                duration));
+        }
+        else {
+            upipe_warn_va(upipe, "ignoring attribute %.*s (%.*s)",
+                          (int)name.len, name.at, (int)value.len, value.at);
+        }
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the previous partial segment in the playlist.
+ *
+ * @param upipe description structure of the pipe
+ * @return the previous partial segment or NULL
+ */
+static struct uref *upipe_m3u_reader_last_part(struct upipe *upipe)
+{
+    struct upipe_m3u_reader *upipe_m3u_reader =
+        upipe_m3u_reader_from_upipe(upipe);
+
+    for (struct uchain *uchain = upipe_m3u_reader->items.prev;
+         uchain != &upipe_m3u_reader->items; uchain = uchain->prev) {
+        struct uref *item = uref_from_uchain(uchain);
+        if (ubase_check(uref_m3u_playlist_get_part(item)))
+            return item;
+    }
+    return NULL;
+}
+
+/** @internal @This checks and parses a "#EXT-X-PART" or a
+ * "#EXT-X-PRELOAD-HINT" tag. Partial segments are output as items flagged
+ * as part, before the segment they belong to.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def the current flow definition
+ * @param line the trailing characters of the line
+ * @param hint true for a preload hint
+ * @return an error code
+ */
+static int upipe_m3u_reader_add_part(struct upipe *upipe,
+                                     struct uref *flow_def,
+                                     const char *line, bool hint)
+{
+    struct upipe_m3u_reader *upipe_m3u_reader =
+        upipe_m3u_reader_from_upipe(upipe);
+
+    const char *def;
+    UBASE_RETURN(uref_flow_get_def(flow_def, &def));
+    if (strcmp(def, M3U_FLOW_DEF) && strcmp(def, PLAYLIST_FLOW_DEF))
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_set_def(flow_def, PLAYLIST_FLOW_DEF));
+
+    struct uref *item = uref_sibling_alloc_control(flow_def);
+    if (unlikely(item == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
+
+    bool has_uri = false, has_range = false, has_off = false;
+    uint64_t range_len = 0;
+    int ret = UBASE_ERR_NONE;
+    const char *iterator = line;
+    struct ustring name, value;
+    while (ubase_check(ret) &&
+           ubase_check(attribute_iterate(&iterator, &name, &value)) &&
+           iterator != NULL) {
+        char value_str[value.len + 1];
+        ustring_cpy(value, value_str, sizeof (value_str));
+
+        if (!ustring_cmp_str(name, "URI")) {
+            ret = uref_m3u_set_uri(item, value_str);
+            has_uri = true;
+        }
+        else if (!hint && !ustring_cmp_str(name, "DURATION")) {
+            const char *endptr;
+            uint64_t duration;
+            ret = duration_to_uclock(value_str, &endptr, &duration);
+            if (ubase_check(ret) && (endptr == value_str || strlen(endptr)))
+                ret = UBASE_ERR_INVALID;
+            if (ubase_check(ret))
+                ret = uref_m3u_playlist_set_seq_duration(item, duration);
+        }
+        else if (!hint && !ustring_cmp_str(name, "INDEPENDENT")) {
+            if (!strcmp(value_str, "YES"))
+                ret = uref_m3u_playlist_set_independent(item);
+        }
+        else if (!hint && !ustring_cmp_str(name, "BYTERANGE")) {
+            char *endptr;
+            range_len = strtoull(value_str, &endptr, 10);
+            has_range = endptr != value_str;
+            if (has_range && *endptr == '@') {
+                const char *off_str = endptr + 1;
+                uint64_t range_off = strtoull(off_str, &endptr, 10);
+                has_off = endptr != off_str;
+                if (has_off)
+                    ret = uref_m3u_playlist_set_byte_range_off(item,
+                                                               range_off);
+            }
+            if (!has_range || *endptr != '\0')
+                ret = UBASE_ERR_INVALID;
+        }
+        else if (hint && !ustring_cmp_str(name, "TYPE")) {
+            if (strcmp(value_str, "PART")) {
+                upipe_verbose_va(upipe, "ignoring %s preload hint",
+                                 value_str);
+                uref_free(item);
+                return UBASE_ERR_NONE;
+            }
+        }
+        else if (hint && !ustring_cmp_str(name, "BYTERANGE-START")) {
+            ret = uref_m3u_playlist_set_byte_range_off(
+                item, strtoull(value_str, NULL, 10));
+        }
+        else if (hint && !ustring_cmp_str(name, "BYTERANGE-LENGTH")) {
+            ret = uref_m3u_playlist_set_byte_range_len(
+                item, strtoull(value_str, NULL, 10));
+        }
+        else {
+            upipe_verbose_va(upipe, "ignoring attribute %.*s (%.*s)",
+                             (int)name.len, name.at,
+                             (int)value.len, value.at);
+        }
+    }
+
+    if (ubase_check(ret) && !has_uri)
+        ret = UBASE_ERR_INVALID;
+    if (ubase_check(ret) && has_range) {
+        if (!has_off) {
+            /* the range follows the previous part of the same resource */
+            struct uref *last = upipe_m3u_reader_last_part(upipe);
+            const char *uri, *last_uri;
+            uint64_t last_off, last_len;
+            if (last == NULL ||
+                !ubase_check(uref_m3u_get_uri(last, &last_uri)) ||
+                !ubase_check(uref_m3u_get_uri(item, &uri)) ||
+                strcmp(uri, last_uri) ||
+                !ubase_check(uref_m3u_playlist_get_byte_range_off(
+                        last, &last_off)) ||
+                !ubase_check(uref_m3u_playlist_get_byte_range_len(
+                        last, &last_len)))
+                last_off = last_len = 0;
+            ret = uref_m3u_playlist_set_byte_range_off(item,
+                                                       last_off + last_len);
+        }
+        if (ubase_check(ret))
+            ret = uref_m3u_playlist_set_byte_range_len(item, range_len);
+    }
+    if (ubase_check(ret))
+        ret = uref_m3u_playlist_set_part(item);
+    if (ubase_check(ret) && hint)
+        ret = uref_m3u_playlist_set_preload_hint(item);
+    if (ubase_check(ret) && upipe_m3u_reader->key)
+        ret = uref_m3u_playlist_key_copy(item, upipe_m3u_reader->key);
+    if (unlikely(!ubase_check(ret))) {
+        upipe_warn_va(upipe, "invalid %s %s",
+                      hint ? "preload hint" : "part", line);
+        uref_free(item);
+        return ret;
+    }
+
+    ulist_add(&upipe_m3u_reader->items, uref_to_uchain(item));
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This checks and parses a "#EXT-X-PART" tag.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def the current flow definition
+ * @param line the trailing characters of the line
+ * @return an error code
+ */
+static int upipe_m3u_reader_ext_x_part(struct upipe *upipe,
+                                       struct uref *flow_def,
+                                       const char *line)
+{
+    return upipe_m3u_reader_add_part(upipe, flow_def, line, false);
+}
+
+/** @internal @This checks and parses a "#EXT-X-PRELOAD-HINT" tag.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def the current flow definition
+ * @param line the trailing characters of the line
+ * @return an error code
+ */
+static int upipe_m3u_reader_ext_x_preload_hint(struct upipe *upipe,
+                                               struct uref *flow_def,
+                                               const char *line)
+{
+    return upipe_m3u_reader_add_part(upipe, flow_def, line, true);
+}
+
 static int upipe_m3u_reader_process_media(struct upipe *upipe,
                                           struct uref *flow_def,
                                           const char *line)
@@ -772,6 +1021,39 @@ static int upipe_m3u_reader_key(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This checks whether the current line describes a segment
+ * that was already output by the previous load. The number of segments to
+ * skip is computed on the first segment line, once the media sequence is
+ * known; the last segment of the previous load is output again, so that
+ * the partial segments following it can be updated.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def the current flow definition
+ * @return true if the line must be skipped
+ */
+static bool upipe_m3u_reader_skip(struct upipe *upipe, struct uref *flow_def)
+{
+    struct upipe_m3u_reader *upipe_m3u_reader =
+        upipe_m3u_reader_from_upipe(upipe);
+
+    if (unlikely(!upipe_m3u_reader->skip_checked)) {
+        upipe_m3u_reader->skip_checked = true;
+        uint64_t media_sequence = 0;
+        uref_m3u_playlist_flow_get_media_sequence(flow_def, &media_sequence);
+        uint64_t last_seq = upipe_m3u_reader->last_seq;
+        if (upipe_m3u_reader->incremental && last_seq != UINT64_MAX &&
+            media_sequence >= upipe_m3u_reader->last_media_sequence &&
+            media_sequence <= last_seq &&
+            ubase_check(uref_m3u_playlist_flow_set_update(flow_def,
+                                                          last_seq))) {
+            upipe_m3u_reader->skip = last_seq - media_sequence;
+            upipe_verbose_va(upipe, "skipping %"PRIu64" known segments",
+                             upipe_m3u_reader->skip);
+        }
+    }
+    return upipe_m3u_reader->nb_segments < upipe_m3u_reader->skip;
+}
+
 /** @internal @This checks an URI.
  *
  * @param upipe description structure of the pipe
@@ -786,14 +1068,20 @@ static int upipe_m3u_reader_process_uri(struct upipe *upipe,
     struct upipe_m3u_reader *upipe_m3u_reader =
         upipe_m3u_reader_from_upipe(upipe);
 
-    upipe_verbose_va(upipe, "uri %s", uri);
     UBASE_RETURN(uref_flow_match_def(flow_def, M3U_FLOW_DEF));
+    if (upipe_m3u_reader_skip(upipe, flow_def)) {
+        upipe_m3u_reader->nb_segments++;
+        return UBASE_ERR_NONE;
+    }
+
+    upipe_verbose_va(upipe, "uri %s", uri);
     struct uref *item;
     UBASE_RETURN(upipe_m3u_reader_get_item(upipe, flow_def, &item));
     UBASE_RETURN(uref_m3u_set_uri(item, uri));
     if (upipe_m3u_reader->key)
         UBASE_RETURN(uref_m3u_playlist_key_copy(item, upipe_m3u_reader->key));
     upipe_m3u_reader->item = NULL;
+    upipe_m3u_reader->nb_segments++;
     ulist_add(&upipe_m3u_reader->items, uref_to_uchain(item));
     return UBASE_ERR_NONE;
 }
@@ -809,21 +1097,30 @@ static int upipe_m3u_reader_process_line(struct upipe *upipe,
                                          struct uref *flow_def,
                                          struct uref *uref)
 {
+    /* segment tags are ignored for the segments already output, the
+     * other tags are always processed */
     static const struct {
         const char *pfx;
         int (*cb)(struct upipe *, struct uref *, const char *);
+        bool segment;
     } ext_cb[] = {
-        { "#EXTM3U", upipe_m3u_reader_process_m3u },
-        { "#EXT-X-VERSION:", upipe_m3u_reader_process_version },
-        { "#EXT-X-TARGETDURATION:", upipe_m3u_reader_process_target_duration },
-        { "#EXT-X-PLAYLIST-TYPE:", upipe_m3u_reader_process_playlist_type },
-        { "#EXTINF:", upipe_m3u_reader_process_extinf },
-        { "#EXT-X-BYTERANGE:", upipe_m3u_reader_process_byte_range },
-        { "#EXT-X-MEDIA:", upipe_m3u_reader_process_media },
-        { "#EXT-X-STREAM-INF:", upipe_m3u_reader_ext_x_stream_inf },
-        { "#EXT-X-MEDIA-SEQUENCE:", upipe_m3u_reader_ext_x_media_sequence },
-        { "#EXT-X-ENDLIST", upipe_m3u_reader_ext_x_endlist },
-        { "#EXT-X-KEY:", upipe_m3u_reader_key },
+        { "#EXTM3U", upipe_m3u_reader_process_m3u, false },
+        { "#EXT-X-VERSION:", upipe_m3u_reader_process_version, false },
+        { "#EXT-X-TARGETDURATION:", upipe_m3u_reader_process_target_duration,
+          false },
+        { "#EXT-X-PLAYLIST-TYPE:", upipe_m3u_reader_process_playlist_type,
+          false },
+        { "#EXTINF:", upipe_m3u_reader_process_extinf, true },
+        { "#EXT-X-BYTERANGE:", upipe_m3u_reader_process_byte_range, true },
+        { "#EXT-X-MEDIA:", upipe_m3u_reader_process_media, false },
+        { "#EXT-X-STREAM-INF:", upipe_m3u_reader_ext_x_stream_inf, false },
+        { "#EXT-X-MEDIA-SEQUENCE:", upipe_m3u_reader_ext_x_media_sequence,
+          false },
+        { "#EXT-X-ENDLIST", upipe_m3u_reader_ext_x_endlist, false },
+        { "#EXT-X-KEY:", upipe_m3u_reader_key, false },
+        { "#EXT-X-PART-INF:", upipe_m3u_reader_ext_x_part_inf, false },
+        { "#EXT-X-PART:", upipe_m3u_reader_ext_x_part, true },
+        { "#EXT-X-PRELOAD-HINT:", upipe_m3u_reader_ext_x_preload_hint, true },
     };
 
     size_t block_size;
@@ -849,6 +1146,8 @@ static int upipe_m3u_reader_process_line(struct upipe *upipe,
             if (strncmp(line, ext_cb[i].pfx, strlen(ext_cb[i].pfx)))
                 continue;
 
+            if (ext_cb[i].segment && upipe_m3u_reader_skip(upipe, flow_def))
+                return UBASE_ERR_NONE;
             return ext_cb[i].cb(upipe, flow_def,
                                 line + strlen(ext_cb[i].pfx));
         }
@@ -916,6 +1215,18 @@ static void upipe_m3u_reader_output_all(struct upipe *upipe,
         return;
     }
 
+    /* remember the last segment for the next incremental update */
+    uint64_t media_sequence = 0;
+    uref_m3u_playlist_flow_get_media_sequence(flow_def, &media_sequence);
+    if (ubase_check(uref_flow_match_def(flow_def, PLAYLIST_FLOW_DEF)) &&
+        upipe_m3u_reader->nb_segments) {
+        upipe_m3u_reader->last_media_sequence = media_sequence;
+        upipe_m3u_reader->last_seq =
+            media_sequence + upipe_m3u_reader->nb_segments - 1;
+    }
+    else
+        upipe_m3u_reader->last_seq = UINT64_MAX;
+
     /* force new flow def */
     upipe_m3u_reader_store_flow_def(upipe, NULL);
     /* set output flow def */
@@ -1014,6 +1325,14 @@ static int upipe_m3u_reader_control(struct upipe *upipe,
         struct uref *p = va_arg(args, struct uref *);
         return upipe_m3u_reader_set_flow_def(upipe, p);
     }
+    case UPIPE_M3U_READER_SET_INCREMENTAL: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_M3U_READER_SIGNATURE)
+        struct upipe_m3u_reader *upipe_m3u_reader =
+            upipe_m3u_reader_from_upipe(upipe);
+        upipe_m3u_reader->incremental = va_arg(args, int) != 0;
+        upipe_m3u_reader->last_seq = UINT64_MAX;
+        return UBASE_ERR_NONE;
+    }
 
     default:
         return UBASE_ERR_UNHANDLED;
@@ -0,0 +1,700 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short Upipe metrics exporter in Prometheus/OpenMetrics text format
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/ulist.h>
+#include <upipe/uclock.h>
+#include <upipe/umem.h>
+#include <upipe/upump.h>
+#include <upipe/upipe.h>
+#include <upipe-modules/upipe_metrics.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+/** maximum size of an HTTP request */
+#define UPIPE_METRICS_REQUEST_SIZE 2048
+/** backlog of the listening socket */
+#define UPIPE_METRICS_BACKLOG 8
+/** percentile of the input latency exported */
+#define UPIPE_METRICS_PERCENTILE 99
+
+/** @This is a registered object. */
+struct upipe_metrics_item {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** label value */
+    char *name;
+    /** registered pipe, or NULL */
+    struct upipe *upipe;
+    /** registered umem manager, or NULL */
+    struct umem_mgr *umem_mgr;
+    /** registered collector, or NULL */
+    upipe_metrics_collector collector;
+    /** opaque of the collector */
+    void *opaque;
+};
+
+UBASE_FROM_TO(upipe_metrics_item, uchain, uchain, uchain)
+
+/** @This is an HTTP client connection. */
+struct upipe_metrics_client {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** pointer to exporter */
+    struct upipe_metrics *metrics;
+    /** socket */
+    int fd;
+    /** read watcher */
+    struct upump *upump;
+    /** received request */
+    char request[UPIPE_METRICS_REQUEST_SIZE];
+    /** size of the received request */
+    size_t size;
+};
+
+UBASE_FROM_TO(upipe_metrics_client, uchain, uchain, uchain)
+
+/** @This is the private context of a metrics exporter. */
+struct upipe_metrics {
+    /** management structure of the event loop */
+    struct upump_mgr *upump_mgr;
+    /** clock used to measure the loop lag */
+    struct uclock *uclock;
+    /** period of the loop lag measurement */
+    uint64_t period;
+    /** loop lag timer */
+    struct upump *timer;
+    /** date of the last loop lag measurement */
+    uint64_t last_tick;
+    /** last loop lag */
+    uint64_t lag;
+    /** maximum loop lag */
+    uint64_t max_lag;
+
+    /** listening socket */
+    int fd;
+    /** accept watcher */
+    struct upump *upump;
+    /** list of client connections */
+    struct uchain clients;
+
+    /** list of registered objects */
+    struct uchain items;
+};
+
+/** @internal @This measures the lag of the event loop.
+ *
+ * @param upump description structure of the timer
+ */
+static void upipe_metrics_timer(struct upump *upump)
+{
+    struct upipe_metrics *metrics =
+        upump_get_opaque(upump, struct upipe_metrics *);
+    uint64_t now = uclock_now(metrics->uclock);
+    uint64_t expected = metrics->last_tick + metrics->period;
+    metrics->lag = now > expected ? now - expected : 0;
+    if (metrics->lag > metrics->max_lag)
+        metrics->max_lag = metrics->lag;
+    metrics->last_tick = now;
+}
+
+/** @internal @This prints a label value, escaping special characters.
+ *
+ * @param file file pointer to write to
+ * @param name label value
+ */
+static void upipe_metrics_print_label(FILE *file, const char *name)
+{
+    for (const char *p = name; *p; p++) {
+        if (*p == '"' || *p == '\\')
+            fprintf(file, "\\%c", *p);
+        else if (*p == '\n')
+            fprintf(file, "\\n");
+        else
+            fputc(*p, file);
+    }
+}
+
+/** @internal @This prints a family of pipe metrics.
+ *
+ * @param metrics pointer to exporter
+ * @param file file pointer to write to
+ * @param family name of the family
+ * @param type type of the family
+ * @param help description of the family
+ * @param offset offset of the uint64_t counter in struct upipe_stats, -1
+ * for the percentile of the input latency, or -2 for the percentile of the
+ * ingress latency
+ * @param scale divider applied to the counter
+ */
+static void upipe_metrics_print_pipes(struct upipe_metrics *metrics,
+                                      FILE *file, const char *family,
+                                      const char *type, const char *help,
+                                      int offset, double scale)
+{
+    fprintf(file, "# TYPE %s %s\n# HELP %s %s\n", family, type, family, help);
+
+    struct uchain *uchain;
+    ulist_foreach (&metrics->items, uchain) {
+        struct upipe_metrics_item *item =
+            upipe_metrics_item_from_uchain(uchain);
+        struct upipe_stats *stats;
+        if (item->upipe == NULL ||
+            (stats = item->upipe->stats) == NULL)
+            continue;
+
+        uint64_t value;
+        if (offset == -1)
+            value = upipe_stats_latency_percentile(stats,
+                    UPIPE_METRICS_PERCENTILE);
+        else if (offset < 0)
+            value = upipe_stats_trace_percentile(stats,
+                    UPIPE_METRICS_PERCENTILE);
+        else
+            value = *(const uint64_t *)((const uint8_t *)stats + offset);
+
+        fprintf(file, "%s%s{pipe=\"", family,
+                !strcmp(type, "counter") ? "_total" : "");
+        upipe_metrics_print_label(file, item->name);
+        if (scale != 1)
+            fprintf(file, "\"} %.9f\n", value / scale);
+        else
+            fprintf(file, "\"} %"PRIu64"\n", value);
+    }
+}
+
+/** @internal @This prints the ingress latency histograms of the pipes which
+ * received traced urefs. Buckets are merged by powers of two to keep the
+ * output small.
+ *
+ * @param metrics pointer to exporter
+ * @param file file pointer to write to
+ */
+static void upipe_metrics_print_trace(struct upipe_metrics *metrics,
+                                      FILE *file)
+{
+    fprintf(file, "# TYPE upipe_ingress_latency_seconds histogram\n"
+            "# HELP upipe_ingress_latency_seconds Latency of the traced "
+            "urefs since their ingress date.\n");
+
+    struct uchain *uchain;
+    ulist_foreach (&metrics->items, uchain) {
+        struct upipe_metrics_item *item =
+            upipe_metrics_item_from_uchain(uchain);
+        struct upipe_stats *stats;
+        if (item->upipe == NULL || (stats = item->upipe->stats) == NULL ||
+            !stats->traced)
+            continue;
+
+        uint64_t count = 0;
+        for (unsigned int i = 0; i < UPIPE_STATS_TRACE_BUCKETS - 1; i++) {
+            count += stats->trace[i];
+            if ((i + 1) % UPIPE_STATS_TRACE_SUB_BUCKETS)
+                continue;
+            fprintf(file, "upipe_ingress_latency_seconds_bucket{pipe=\"");
+            upipe_metrics_print_label(file, item->name);
+            fprintf(file, "\",le=\"%.9f\"} %"PRIu64"\n",
+                    (double)upipe_stats_trace_bound(i) / UCLOCK_FREQ, count);
+        }
+        fprintf(file, "upipe_ingress_latency_seconds_bucket{pipe=\"");
+        upipe_metrics_print_label(file, item->name);
+        fprintf(file, "\",le=\"+Inf\"} %"PRIu64"\n", stats->traced);
+        fprintf(file, "upipe_ingress_latency_seconds_sum{pipe=\"");
+        upipe_metrics_print_label(file, item->name);
+        fprintf(file, "\"} %.9f\n", (double)stats->trace_time / UCLOCK_FREQ);
+        fprintf(file, "upipe_ingress_latency_seconds_count{pipe=\"");
+        upipe_metrics_print_label(file, item->name);
+        fprintf(file, "\"} %"PRIu64"\n", stats->traced);
+    }
+}
+
+/** @This prints all metrics in OpenMetrics text format.
+ *
+ * @param metrics pointer to exporter
+ * @param file file pointer to write to
+ */
+void upipe_metrics_print(struct upipe_metrics *metrics, FILE *file)
+{
+#define PIPE_COUNTER(name, field, scale, help)                              \
+    upipe_metrics_print_pipes(metrics, file, "upipe_" name, "counter",      \
+                              help, offsetof(struct upipe_stats, field),    \
+                              scale)
+#define PIPE_GAUGE(name, field, scale, help)                                \
+    upipe_metrics_print_pipes(metrics, file, "upipe_" name, "gauge",        \
+                              help, offsetof(struct upipe_stats, field),    \
+                              scale)
+    PIPE_COUNTER("urefs", urefs, 1, "Urefs received by the pipe.");
+    PIPE_COUNTER("bytes", bytes, 1, "Octets received by the pipe.");
+    PIPE_COUNTER("input_seconds", input_time, UCLOCK_FREQ,
+                 "Time spent in the input function.");
+    PIPE_GAUGE("input_max_seconds", max_input_time, UCLOCK_FREQ,
+               "Maximum time spent in one call to the input function.");
+    upipe_metrics_print_pipes(metrics, file, "upipe_input_p99_seconds",
+            "gauge", "99th percentile of the time spent in the input "
+            "function.", -1, UCLOCK_FREQ);
+    upipe_metrics_print_pipes(metrics, file,
+            "upipe_ingress_latency_p99_seconds", "gauge", "99th percentile "
+            "of the latency of the traced urefs since their ingress date.",
+            -2, UCLOCK_FREQ);
+    upipe_metrics_print_trace(metrics, file);
+    PIPE_COUNTER("errors", errors, 1,
+                 "Stream errors detected by the pipe.");
+    PIPE_GAUGE("jitter_seconds", jitter, UCLOCK_FREQ,
+               "Last jitter measured on clock references.");
+    PIPE_GAUGE("max_jitter_seconds", max_jitter, UCLOCK_FREQ,
+               "Maximum jitter measured on clock references.");
+    PIPE_GAUGE("held_bytes", held_bytes, 1,
+               "Octets of the buffers held by the pipe.");
+    PIPE_GAUGE("max_held_bytes", max_held_bytes, 1,
+               "Maximum octets of the buffers held by the pipe.");
+    PIPE_GAUGE("memory_cap_bytes", memory_cap, 1,
+               "Memory cap of the pipe, or 0.");
+#undef PIPE_COUNTER
+#undef PIPE_GAUGE
+
+    /* queue lengths are unsigned int */
+    const char *queue_families[] = { "upipe_queue_length",
+                                     "upipe_queue_max_length" };
+    for (int i = 0; i < 2; i++) {
+        fprintf(file, "# TYPE %s gauge\n# HELP %s %s\n",
+                queue_families[i], queue_families[i],
+                i ? "Maximum number of urefs held by the pipe."
+                  : "Number of urefs held by the pipe.");
+        struct uchain *uchain;
+        ulist_foreach (&metrics->items, uchain) {
+            struct upipe_metrics_item *item =
+                upipe_metrics_item_from_uchain(uchain);
+            struct upipe_stats *stats;
+            if (item->upipe == NULL || (stats = item->upipe->stats) == NULL)
+                continue;
+            fprintf(file, "%s{pipe=\"", queue_families[i]);
+            upipe_metrics_print_label(file, item->name);
+            fprintf(file, "\"} %u\n", i ? stats->max_queue : stats->queue);
+        }
+    }
+
+    /* umem managers */
+    const char *umem_families[] = { "upipe_umem_hits", "upipe_umem_misses",
+                                    "upipe_umem_fallbacks" };
+    for (int i = 0; i < 3; i++) {
+        fprintf(file, "# TYPE %s counter\n", umem_families[i]);
+        struct uchain *uchain;
+        ulist_foreach (&metrics->items, uchain) {
+            struct upipe_metrics_item *item =
+                upipe_metrics_item_from_uchain(uchain);
+            struct umem_mgr_stats stats;
+            if (item->umem_mgr == NULL ||
+                !ubase_check(umem_mgr_get_stats(item->umem_mgr, &stats)))
+                continue;
+            fprintf(file, "%s_total{umem=\"", umem_families[i]);
+            upipe_metrics_print_label(file, item->name);
+            fprintf(file, "\"} %"PRIu64"\n",
+                    i == 0 ? stats.hits : i == 1 ? stats.misses :
+                    stats.fallbacks);
+        }
+    }
+
+    /* event loop */
+    if (metrics->timer != NULL) {
+        fprintf(file, "# TYPE upipe_loop_lag_seconds gauge\n"
+                "upipe_loop_lag_seconds %.9f\n",
+                (double)metrics->lag / UCLOCK_FREQ);
+        fprintf(file, "# TYPE upipe_loop_max_lag_seconds gauge\n"
+                "upipe_loop_max_lag_seconds %.9f\n",
+                (double)metrics->max_lag / UCLOCK_FREQ);
+    }
+
+    /* custom collectors */
+    struct uchain *uchain;
+    ulist_foreach (&metrics->items, uchain) {
+        struct upipe_metrics_item *item =
+            upipe_metrics_item_from_uchain(uchain);
+        if (item->collector != NULL)
+            item->collector(item->opaque, file);
+    }
+
+    fprintf(file, "# EOF\n");
+}
+
+/** @internal @This closes a client connection.
+ *
+ * @param client client connection
+ */
+static void upipe_metrics_client_free(struct upipe_metrics_client *client)
+{
+    ulist_delete(upipe_metrics_client_to_uchain(client));
+    upump_stop(client->upump);
+    upump_free(client->upump);
+    close(client->fd);
+    free(client);
+}
+
+/** @internal @This writes a whole buffer to a client.
+ *
+ * @param fd socket
+ * @param buffer buffer to write
+ * @param size size of the buffer
+ */
+static void upipe_metrics_client_write(int fd, const char *buffer,
+                                       size_t size)
+{
+    while (size) {
+        ssize_t ret = write(fd, buffer, size);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return;
+        buffer += ret;
+        size -= ret;
+    }
+}
+
+/** @internal @This answers a complete HTTP request.
+ *
+ * @param client client connection
+ */
+static void upipe_metrics_client_answer(struct upipe_metrics_client *client)
+{
+    char *body = NULL;
+    size_t body_size = 0;
+    const char *status = "404 Not Found";
+    if (!strncmp(client->request, "GET /metrics ", strlen("GET /metrics ")) ||
+        !strncmp(client->request, "GET /metrics?", strlen("GET /metrics?"))) {
+        FILE *file = open_memstream(&body, &body_size);
+        if (file != NULL) {
+            upipe_metrics_print(client->metrics, file);
+            fclose(file);
+            status = "200 OK";
+        } else
+            status = "500 Internal Server Error";
+    }
+
+    char header[256];
+    int len = snprintf(header, sizeof(header),
+            "HTTP/1.0 %s\r\n"
+            "Content-Type: application/openmetrics-text; version=1.0.0; "
+            "charset=utf-8\r\n"
+            "Content-Length: %zu\r\n"
+            "Connection: close\r\n\r\n", status, body != NULL ? body_size : 0);
+
+    /* the response fits in the socket buffer in most cases, so write it
+     * synchronously */
+    int flags = fcntl(client->fd, F_GETFL);
+    fcntl(client->fd, F_SETFL, flags & ~O_NONBLOCK);
+    upipe_metrics_client_write(client->fd, header, len);
+    if (body != NULL)
+        upipe_metrics_client_write(client->fd, body, body_size);
+    free(body);
+}
+
+/** @internal @This reads an HTTP request from a client.
+ *
+ * @param upump description structure of the read watcher
+ */
+static void upipe_metrics_client_read(struct upump *upump)
+{
+    struct upipe_metrics_client *client =
+        upump_get_opaque(upump, struct upipe_metrics_client *);
+    ssize_t ret = read(client->fd, client->request + client->size,
+                       sizeof(client->request) - 1 - client->size);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return;
+    if (ret <= 0) {
+        upipe_metrics_client_free(client);
+        return;
+    }
+
+    client->size += ret;
+    client->request[client->size] = '\0';
+    if (strstr(client->request, "\r\n\r\n") != NULL ||
+        strstr(client->request, "\n\n") != NULL) {
+        upipe_metrics_client_answer(client);
+        upipe_metrics_client_free(client);
+    } else if (client->size == sizeof(client->request) - 1)
+        upipe_metrics_client_free(client);
+}
+
+/** @internal @This accepts a new client connection.
+ *
+ * @param upump description structure of the accept watcher
+ */
+static void upipe_metrics_accept(struct upump *upump)
+{
+    struct upipe_metrics *metrics =
+        upump_get_opaque(upump, struct upipe_metrics *);
+    int fd = accept(metrics->fd, NULL, NULL);
+    if (fd < 0)
+        return;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    struct upipe_metrics_client *client =
+        malloc(sizeof(struct upipe_metrics_client));
+    if (unlikely(client == NULL)) {
+        close(fd);
+        return;
+    }
+    client->metrics = metrics;
+    client->fd = fd;
+    client->size = 0;
+    client->upump = upump_alloc_fd_read(metrics->upump_mgr,
+                                        upipe_metrics_client_read, client,
+                                        NULL, fd);
+    if (unlikely(client->upump == NULL)) {
+        close(fd);
+        free(client);
+        return;
+    }
+    ulist_add(&metrics->clients, upipe_metrics_client_to_uchain(client));
+    upump_start(client->upump);
+}
+
+/** @internal @This opens the listening socket.
+ *
+ * @param host address to listen to, or NULL for any address
+ * @param service port to listen to
+ * @return socket, or -1 in case of error
+ */
+static int upipe_metrics_listen(const char *host, const char *service)
+{
+    struct addrinfo hints, *res, *ai;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo(host, service, &hints, &res) != 0)
+        return -1;
+
+    int fd = -1;
+    for (ai = res; ai != NULL; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0)
+            continue;
+        int opt = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 &&
+            listen(fd, UPIPE_METRICS_BACKLOG) == 0)
+            break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+
+    if (fd >= 0)
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+/** @This allocates a metrics exporter.
+ *
+ * @param upump_mgr management structure of the event loop, or NULL if
+ * there is neither an HTTP server nor a loop lag measurement
+ * @param uclock clock used to measure the loop lag, or NULL
+ * @param period period of the loop lag measurement, in units of
+ * @ref UCLOCK_FREQ
+ * @param host address to listen to, or NULL for any address
+ * @param service port to listen to, or NULL to disable the HTTP server
+ * @return pointer to exporter, or NULL in case of error
+ */
+struct upipe_metrics *upipe_metrics_alloc(struct upump_mgr *upump_mgr,
+                                          struct uclock *uclock,
+                                          uint64_t period,
+                                          const char *host,
+                                          const char *service)
+{
+    struct upipe_metrics *metrics = malloc(sizeof(struct upipe_metrics));
+    if (unlikely(metrics == NULL))
+        return NULL;
+
+    metrics->upump_mgr = upump_mgr_use(upump_mgr);
+    metrics->uclock = uclock_use(uclock);
+    metrics->period = period;
+    metrics->timer = NULL;
+    metrics->last_tick = 0;
+    metrics->lag = metrics->max_lag = 0;
+    metrics->fd = -1;
+    metrics->upump = NULL;
+    ulist_init(&metrics->clients);
+    ulist_init(&metrics->items);
+
+    if (upump_mgr != NULL && uclock != NULL && period) {
+        metrics->last_tick = uclock_now(uclock);
+        metrics->timer = upump_alloc_timer(upump_mgr, upipe_metrics_timer,
+                                           metrics, NULL, period, period);
+        if (unlikely(metrics->timer == NULL))
+            goto upipe_metrics_alloc_err;
+        upump_start(metrics->timer);
+    }
+
+    if (service != NULL) {
+        if (upump_mgr == NULL ||
+            (metrics->fd = upipe_metrics_listen(host, service)) < 0)
+            goto upipe_metrics_alloc_err;
+        metrics->upump = upump_alloc_fd_read(upump_mgr, upipe_metrics_accept,
+                                             metrics, NULL, metrics->fd);
+        if (unlikely(metrics->upump == NULL))
+            goto upipe_metrics_alloc_err;
+        upump_start(metrics->upump);
+    }
+    return metrics;
+
+upipe_metrics_alloc_err:
+    upipe_metrics_free(metrics);
+    return NULL;
+}
+
+/** @internal @This allocates a registered object.
+ *
+ * @param metrics pointer to exporter
+ * @param name label value, or NULL
+ * @return pointer to registered object, or NULL in case of error
+ */
+static struct upipe_metrics_item *
+    upipe_metrics_item_alloc(struct upipe_metrics *metrics, const char *name)
+{
+    struct upipe_metrics_item *item =
+        malloc(sizeof(struct upipe_metrics_item));
+    if (unlikely(item == NULL))
+        return NULL;
+    item->name = NULL;
+    if (name != NULL && (item->name = strdup(name)) == NULL) {
+        free(item);
+        return NULL;
+    }
+    item->upipe = NULL;
+    item->umem_mgr = NULL;
+    item->collector = NULL;
+    item->opaque = NULL;
+    ulist_add(&metrics->items, upipe_metrics_item_to_uchain(item));
+    return item;
+}
+
+/** @This registers a pipe whose instrumentation counters are exported.
+ *
+ * @param metrics pointer to exporter
+ * @param upipe description structure of the pipe, which is used
+ * @param name value of the pipe label
+ * @return an error code
+ */
+int upipe_metrics_add_pipe(struct upipe_metrics *metrics,
+                           struct upipe *upipe, const char *name)
+{
+    if (unlikely(upipe == NULL || name == NULL))
+        return UBASE_ERR_INVALID;
+    struct upipe_metrics_item *item = upipe_metrics_item_alloc(metrics, name);
+    if (unlikely(item == NULL))
+        return UBASE_ERR_ALLOC;
+    item->upipe = upipe_use(upipe);
+    return UBASE_ERR_NONE;
+}
+
+/** @This registers a umem manager whose allocation statistics are exported.
+ *
+ * @param metrics pointer to exporter
+ * @param umem_mgr umem manager, which is used
+ * @param name value of the umem label
+ * @return an error code
+ */
+int upipe_metrics_add_umem_mgr(struct upipe_metrics *metrics,
+                               struct umem_mgr *umem_mgr, const char *name)
+{
+    if (unlikely(umem_mgr == NULL || name == NULL))
+        return UBASE_ERR_INVALID;
+    struct upipe_metrics_item *item = upipe_metrics_item_alloc(metrics, name);
+    if (unlikely(item == NULL))
+        return UBASE_ERR_ALLOC;
+    item->umem_mgr = umem_mgr_use(umem_mgr);
+    return UBASE_ERR_NONE;
+}
+
+/** @This registers a function printing custom metrics.
+ *
+ * @param metrics pointer to exporter
+ * @param collector function printing metrics
+ * @param opaque opaque passed to the function
+ * @return an error code
+ */
+int upipe_metrics_add_collector(struct upipe_metrics *metrics,
+                                upipe_metrics_collector collector,
+                                void *opaque)
+{
+    if (unlikely(collector == NULL))
+        return UBASE_ERR_INVALID;
+    struct upipe_metrics_item *item = upipe_metrics_item_alloc(metrics, NULL);
+    if (unlikely(item == NULL))
+        return UBASE_ERR_ALLOC;
+    item->collector = collector;
+    item->opaque = opaque;
+    return UBASE_ERR_NONE;
+}
+
+/** @This frees a metrics exporter and releases the registered objects.
+ *
+ * @param metrics pointer to exporter
+ */
+void upipe_metrics_free(struct upipe_metrics *metrics)
+{
+    if (metrics == NULL)
+        return;
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&metrics->clients, uchain, uchain_tmp)
+        upipe_metrics_client_free(upipe_metrics_client_from_uchain(uchain));
+
+    ulist_delete_foreach (&metrics->items, uchain, uchain_tmp) {
+        struct upipe_metrics_item *item =
+            upipe_metrics_item_from_uchain(uchain);
+        ulist_delete(uchain);
+        upipe_release(item->upipe);
+        umem_mgr_release(item->umem_mgr);
+        free(item->name);
+        free(item);
+    }
+
+    if (metrics->upump != NULL) {
+        upump_stop(metrics->upump);
+        upump_free(metrics->upump);
+    }
+    if (metrics->fd >= 0)
+        close(metrics->fd);
+    if (metrics->timer != NULL) {
+        upump_stop(metrics->timer);
+        upump_free(metrics->timer);
+    }
+    uclock_release(metrics->uclock);
+    upump_mgr_release(metrics->upump_mgr);
+    free(metrics);
+}
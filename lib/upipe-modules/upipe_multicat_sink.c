@@ -88,6 +88,10 @@ struct upipe_multicat_sink {
     enum upipe_fsink_mode mode;
     /** sync period */
     uint64_t sync_period;
+    /** direct I/O chunk size, or 0 */
+    unsigned int direct_size;
+    /** number of octets to preallocate in each file */
+    uint64_t prealloc;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -114,6 +118,11 @@ static bool _upipe_multicat_sink_change_file(struct upipe *upipe, int64_t idx)
         return false;
     }
     snprintf(filepath, MAXPATHLEN, "%s%"PRId64"%s", upipe_multicat_sink->dirpath, idx, upipe_multicat_sink->suffix);
+    /* applied when the file is opened */
+    upipe_fsink_set_direct(upipe_multicat_sink->fsink,
+                           upipe_multicat_sink->direct_size);
+    upipe_fsink_set_preallocate(upipe_multicat_sink->fsink,
+                                upipe_multicat_sink->prealloc);
     if (!ubase_check(upipe_fsink_set_path(upipe_multicat_sink->fsink, filepath, upipe_multicat_sink->mode)))
         return false;
     if (upipe_multicat_sink->sync_period)
@@ -398,6 +407,25 @@ static int upipe_multicat_sink_control(struct upipe *upipe,
             *p = upipe_multicat_sink->sync_period;
             return UBASE_ERR_NONE;
         }
+        case UPIPE_FSINK_SET_DIRECT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSINK_SIGNATURE)
+            unsigned int direct_size = va_arg(args, unsigned int);
+            if (unlikely(direct_size % UPIPE_FSINK_DIRECT_ALIGN))
+                return UBASE_ERR_INVALID;
+            upipe_multicat_sink->direct_size = direct_size;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_FSINK_GET_DIRECT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSINK_SIGNATURE)
+            unsigned int *p = va_arg(args, unsigned int *);
+            *p = upipe_multicat_sink->direct_size;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_FSINK_SET_PREALLOCATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSINK_SIGNATURE)
+            upipe_multicat_sink->prealloc = va_arg(args, uint64_t);
+            return UBASE_ERR_NONE;
+        }
         default:
             if (upipe_multicat_sink->fsink != NULL)
                 return upipe_control_va(upipe_multicat_sink->fsink,
@@ -437,6 +465,8 @@ static struct upipe *upipe_multicat_sink_alloc(struct upipe_mgr *mgr,
     upipe_multicat_sink->rotate_offset = UPIPE_MULTICAT_SINK_DEF_ROTATE_OFFSET;
     upipe_multicat_sink->mode = UPIPE_FSINK_APPEND;
     upipe_multicat_sink->sync_period = 0;
+    upipe_multicat_sink->direct_size = 0;
+    upipe_multicat_sink->prealloc = 0;
     upipe_multicat_sink->flow_def = NULL;
     upipe_throw_ready(upipe);
     return upipe;
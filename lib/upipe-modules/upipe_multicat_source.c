@@ -28,6 +28,8 @@
  * @short Upipe module - multicat file source
  */
 
+#include <config.h>
+
 #include <upipe/ubase.h>
 #include <upipe/uprobe.h>
 #include <upipe/uref_clock.h>
@@ -36,6 +38,7 @@
 #include <upipe/uref_block.h>
 #include <upipe/uref_block_flow.h>
 #include <upipe/uref_flow.h>
+#include <upipe/uts_filter.h>
 #include <upipe/upipe.h>
 #include <upipe/upipe_helper_urefcount.h>
 #include <upipe/upipe_helper_upipe.h>
@@ -47,6 +50,7 @@
 #include <upipe/upipe_helper_upump.h>
 #include <upipe/upipe_helper_output_size.h>
 #include <upipe-modules/upipe_multicat_source.h>
+#include <upipe-modules/upipe_genrap.h>
 
 #include <stdlib.h>
 #include <stdbool.h>
@@ -111,12 +115,28 @@ struct upipe_msrc {
     int fd;
     /** aux file pointer */
     FILE *aux_file;
+    /** aligned buffer for direct I/O reads, or NULL */
+    uint8_t *direct_buf;
+    /** size of the direct I/O buffer */
+    size_t direct_size;
+    /** first unread octet in the direct I/O buffer */
+    size_t direct_start;
+    /** end of valid data in the direct I/O buffer */
+    size_t direct_end;
+    /** offset in the data file of the next octet to read */
+    uint64_t direct_offset;
     /** file index */
     uint64_t fileidx;
     /** current position */
     uint64_t pos;
+    /** true if the next output uref follows a seek */
+    bool discontinuity;
     /** number of missing segments */
     unsigned long missing;
+    /** bitmap of wanted TS PIDs, or NULL */
+    const uint8_t *pid_filter;
+    /** refcount of the owner of the bitmap, or NULL */
+    struct urefcount *pid_filter_owner;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -188,9 +208,16 @@ static struct upipe *upipe_msrc_alloc(struct upipe_mgr *mgr,
     upipe_msrc->flow_def_input = NULL;
     upipe_msrc->fd = -1;
     upipe_msrc->aux_file = NULL;
+    upipe_msrc->direct_buf = NULL;
+    upipe_msrc->direct_size = 0;
+    upipe_msrc->direct_start = upipe_msrc->direct_end = 0;
+    upipe_msrc->direct_offset = 0;
     upipe_msrc->fileidx = -1;
     upipe_msrc->pos = UINT64_MAX;
+    upipe_msrc->discontinuity = false;
     upipe_msrc->missing = 0;
+    upipe_msrc->pid_filter = NULL;
+    upipe_msrc->pid_filter_owner = NULL;
     upipe_throw_ready(upipe);
     return upipe;
 }
@@ -233,7 +260,36 @@ static int upipe_msrc_setup(struct upipe *upipe)
                    sizeof("18446744073709551615")];
     sprintf(data_file, "%s%"PRIu64"%s", path, upipe_msrc->fileidx, data);
 
-    upipe_msrc->fd = open(data_file, O_RDONLY);
+    uint64_t direct = 0;
+    uref_msrc_flow_get_direct(upipe_msrc->flow_def_input, &direct);
+    if (direct % UPIPE_MSRC_DIRECT_ALIGN || direct > INT32_MAX) {
+        upipe_warn_va(upipe, "invalid direct I/O size %"PRIu64, direct);
+        direct = 0;
+    }
+    if (direct != upipe_msrc->direct_size) {
+        free(upipe_msrc->direct_buf);
+        upipe_msrc->direct_buf = NULL;
+        upipe_msrc->direct_size = 0;
+        void *buffer;
+        if (direct && unlikely(posix_memalign(&buffer, UPIPE_MSRC_DIRECT_ALIGN,
+                                              direct)))
+            upipe_warn(upipe, "can't allocate direct I/O buffer");
+        else if (direct) {
+            upipe_msrc->direct_buf = buffer;
+            upipe_msrc->direct_size = direct;
+        }
+    }
+    upipe_msrc->direct_start = upipe_msrc->direct_end = 0;
+    upipe_msrc->direct_offset = 0;
+
+    upipe_msrc->fd = -1;
+#ifdef O_DIRECT
+    if (upipe_msrc->direct_buf != NULL)
+        upipe_msrc->fd = open(data_file, O_RDONLY | O_DIRECT);
+#endif
+    /* the file system may not support O_DIRECT, reads are still batched */
+    if (upipe_msrc->fd == -1)
+        upipe_msrc->fd = open(data_file, O_RDONLY);
     if (unlikely(upipe_msrc->fd == -1)) {
         upipe_warn_va(upipe, "segment %"PRIu64" not found (data)",
                       upipe_msrc->fileidx);
@@ -255,6 +311,59 @@ static int upipe_msrc_setup(struct upipe *upipe)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This looks up in the RAP index of a segment the last random
+ * access point received before the given position.
+ *
+ * @param upipe description structure of the pipe
+ * @param path directory path
+ * @param rap RAP index suffix
+ * @param fileidx index of the segment
+ * @param pos wanted position
+ * @param cr_sys_p filled in with the system time of the access point
+ * @return an error code
+ */
+static int upipe_msrc_find_rap(struct upipe *upipe, const char *path,
+                               const char *rap, uint64_t fileidx,
+                               uint64_t pos, uint64_t *cr_sys_p)
+{
+    char rap_file[strlen(path) + strlen(rap) +
+                  sizeof(".18446744073709551615")];
+    sprintf(rap_file, "%s%"PRIu64"%s", path, fileidx, rap);
+
+    int fd = open(rap_file, O_RDONLY);
+    if (unlikely(fd == -1))
+        return UBASE_ERR_EXTERNAL;
+
+    struct stat rap_stat;
+    if (unlikely(fstat(fd, &rap_stat) == -1 ||
+                 rap_stat.st_size < UPIPE_GENRAP_RECORD_SIZE)) {
+        close(fd);
+        return UBASE_ERR_INVALID;
+    }
+
+    uint8_t *rap_buf = mmap(NULL, rap_stat.st_size, PROT_READ, MAP_SHARED,
+                            fd, 0);
+    close(fd);
+    if (unlikely(rap_buf == MAP_FAILED))
+        return UBASE_ERR_EXTERNAL;
+
+    int64_t found = upipe_genrap_find(rap_buf,
+            rap_stat.st_size / UPIPE_GENRAP_RECORD_SIZE, pos);
+    int err = UBASE_ERR_INVALID;
+    if (found >= 0) {
+        struct upipe_genrap_record record;
+        upipe_genrap_read(rap_buf + found * UPIPE_GENRAP_RECORD_SIZE,
+                          &record);
+        upipe_dbg_va(upipe, "starting at access point %"PRIu64
+                     " of segment %"PRIu64" (%"PRIu64")",
+                     found, fileidx, record.cr_sys);
+        *cr_sys_p = record.cr_sys;
+        err = UBASE_ERR_NONE;
+    }
+    munmap(rap_buf, rap_stat.st_size);
+    return err;
+}
+
 /** @internal @This starts the reader.
  *
  * @param upipe description structure of the pipe
@@ -263,7 +372,7 @@ static int upipe_msrc_setup(struct upipe *upipe)
 static int upipe_msrc_start(struct upipe *upipe)
 {
     struct upipe_msrc *upipe_msrc = upipe_msrc_from_upipe(upipe);
-    const char *path, *data, *aux;
+    const char *path, *data, *aux, *rap;
     uint64_t rotate = UPIPE_MSRC_DEF_ROTATE;
     uint64_t offset = UPIPE_MSRC_DEF_OFFSET;
     UBASE_RETURN(uref_msrc_flow_get_path(upipe_msrc->flow_def_input, &path))
@@ -271,7 +380,27 @@ static int upipe_msrc_start(struct upipe *upipe)
     UBASE_RETURN(uref_msrc_flow_get_aux(upipe_msrc->flow_def_input, &aux))
     uref_msrc_flow_get_rotate(upipe_msrc->flow_def_input, &rotate);
     uref_msrc_flow_get_offset(upipe_msrc->flow_def_input, &offset);
-    upipe_msrc->fileidx = (upipe_msrc->pos - offset) / rotate;
+    uint64_t pos = upipe_msrc->pos;
+    upipe_msrc->fileidx = (pos - offset) / rotate;
+
+    if (ubase_check(uref_msrc_flow_get_rap(upipe_msrc->flow_def_input,
+                                           &rap))) {
+        /* rewind to the previous access point, possibly in the previous
+         * segment */
+        uint64_t cr_sys;
+        if (ubase_check(upipe_msrc_find_rap(upipe, path, rap,
+                                            upipe_msrc->fileidx, pos,
+                                            &cr_sys)) ||
+            (upipe_msrc->fileidx &&
+             ubase_check(upipe_msrc_find_rap(upipe, path, rap,
+                                             upipe_msrc->fileidx - 1, pos,
+                                             &cr_sys)))) {
+            pos = cr_sys;
+            upipe_msrc->fileidx = (pos - offset) / rotate;
+        } else
+            upipe_warn_va(upipe, "no access point found before %"PRIu64,
+                          pos);
+    }
 
     char aux_file[strlen(path) + strlen(aux) +
                   sizeof(".18446744073709551615")];
@@ -312,7 +441,7 @@ static int upipe_msrc_start(struct upipe *upipe)
         if (offset1 == mid_offset)
             break;
 
-        if (mid_aux >= upipe_msrc->pos)
+        if (mid_aux >= pos)
             offset2 = mid_offset;
         else
             offset1 = mid_offset;
@@ -322,17 +451,68 @@ static int upipe_msrc_start(struct upipe *upipe)
     close(fd);
 
     UBASE_RETURN(upipe_msrc_setup(upipe))
-    if (unlikely(lseek(upipe_msrc->fd, (off_t)upipe_msrc->output_size * offset1,
-                       SEEK_SET) == -1 ||
+    upipe_msrc->direct_offset = (uint64_t)upipe_msrc->output_size * offset1;
+    if (unlikely((upipe_msrc->direct_buf == NULL &&
+                  lseek(upipe_msrc->fd,
+                        (off_t)upipe_msrc->output_size * offset1,
+                        SEEK_SET) == -1) ||
                  fseeko(upipe_msrc->aux_file, 8 * offset1, SEEK_SET) == -1)) {
         upipe_warn_va(upipe, "invalid segment %"PRIu64, upipe_msrc->fileidx);
         /* try next file anyway */
         return upipe_msrc_skip(upipe);
     }
 
+    upipe_msrc->discontinuity = true;
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This reads from the data file, through the direct I/O buffer
+ * if it is enabled.
+ *
+ * @param upipe description structure of the pipe
+ * @param buffer buffer to fill in
+ * @param size size of the buffer
+ * @return number of octets read, or -1 with errno set
+ */
+static ssize_t upipe_msrc_read(struct upipe *upipe, uint8_t *buffer,
+                               size_t size)
+{
+    struct upipe_msrc *upipe_msrc = upipe_msrc_from_upipe(upipe);
+    if (upipe_msrc->direct_buf == NULL)
+        return read(upipe_msrc->fd, buffer, size);
+
+    size_t done = 0;
+    while (done < size) {
+        if (upipe_msrc->direct_start == upipe_msrc->direct_end) {
+            /* O_DIRECT requires aligned offsets */
+            uint64_t skip = upipe_msrc->direct_offset %
+                            UPIPE_MSRC_DIRECT_ALIGN;
+            uint64_t aligned = upipe_msrc->direct_offset - skip;
+            ssize_t ret = pread(upipe_msrc->fd, upipe_msrc->direct_buf,
+                                upipe_msrc->direct_size, aligned);
+            if (unlikely(ret == -1)) {
+                if (errno == EINTR)
+                    continue;
+                return done ? done : -1;
+            }
+            if (ret <= skip)
+                break;
+            upipe_msrc->direct_start = skip;
+            upipe_msrc->direct_end = ret;
+        }
+
+        size_t chunk = upipe_msrc->direct_end - upipe_msrc->direct_start;
+        if (chunk > size - done)
+            chunk = size - done;
+        memcpy(buffer + done,
+               upipe_msrc->direct_buf + upipe_msrc->direct_start, chunk);
+        upipe_msrc->direct_start += chunk;
+        upipe_msrc->direct_offset += chunk;
+        done += chunk;
+    }
+    return done;
+}
+
 /** @internal @This reads data from the source and outputs it.
  *
  * @param upipe description structure of the pipe
@@ -362,7 +542,9 @@ static int upipe_msrc_handle(struct upipe *upipe)
     }
     assert(output_size == upipe_msrc->output_size);
 
-    ssize_t ret = read(upipe_msrc->fd, buffer, upipe_msrc->output_size);
+    ssize_t ret = upipe_msrc_read(upipe, buffer, upipe_msrc->output_size);
+    size_t filtered = ret > 0 ?
+        uts_filter_compact(upipe_msrc->pid_filter, buffer, ret) : 0;
     uref_block_unmap(uref, 0);
 
     if (unlikely(ret == -1)) {
@@ -386,11 +568,20 @@ static int upipe_msrc_handle(struct upipe *upipe)
                       upipe_msrc->fileidx);
         return upipe_msrc_skip(upipe);
     }
-    if (unlikely(ret != upipe_msrc->output_size))
-        uref_block_resize(uref, 0, ret);
+    upipe_msrc->missing = 0;
+    if (unlikely(ret > 0 && !filtered)) {
+        /* only unwanted TS packets */
+        uref_free(uref);
+        return UBASE_ERR_NONE;
+    }
+    if (unlikely(filtered != upipe_msrc->output_size))
+        uref_block_resize(uref, 0, filtered);
     uref_clock_set_cr_sys(uref, cr_sys);
+    if (upipe_msrc->discontinuity) {
+        upipe_msrc->discontinuity = false;
+        uref_flow_set_discontinuity(uref);
+    }
 
-    upipe_msrc->missing = 0;
     upipe_msrc_output(upipe, uref, &upipe_msrc->upump);
     return UBASE_ERR_NONE;
 }
@@ -628,6 +819,22 @@ static int _upipe_msrc_control(struct upipe *upipe, int command, va_list args)
             uint64_t *p = va_arg(args, uint64_t *);
             return upipe_msrc_get_position(upipe, p);
         }
+        case UPIPE_MSRC_GET_PID_FILTER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_MSRC_SIGNATURE)
+            const uint8_t **pid_filter_p = va_arg(args, const uint8_t **);
+            *pid_filter_p = upipe_msrc_from_upipe(upipe)->pid_filter;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_MSRC_SET_PID_FILTER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_MSRC_SIGNATURE)
+            struct upipe_msrc *upipe_msrc = upipe_msrc_from_upipe(upipe);
+            const uint8_t *pid_filter = va_arg(args, const uint8_t *);
+            struct urefcount *owner = va_arg(args, struct urefcount *);
+            urefcount_release(upipe_msrc->pid_filter_owner);
+            upipe_msrc->pid_filter_owner = urefcount_use(owner);
+            upipe_msrc->pid_filter = pid_filter;
+            return UBASE_ERR_NONE;
+        }
 
         default:
             return UBASE_ERR_UNHANDLED;
@@ -661,6 +868,8 @@ static void upipe_msrc_free(struct upipe *upipe)
 
     struct upipe_msrc *upipe_msrc = upipe_msrc_from_upipe(upipe);
     uref_free(upipe_msrc->flow_def_input);
+    free(upipe_msrc->direct_buf);
+    urefcount_release(upipe_msrc->pid_filter_owner);
     upipe_msrc_clean_output_size(upipe);
     upipe_msrc_clean_upump(upipe);
     upipe_msrc_clean_upump_mgr(upipe);
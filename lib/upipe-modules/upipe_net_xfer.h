@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short common definitions for net xfer sinks and sources
+ *
+ * The sink sends a stream of frames of @ref uref_serial_write_frame, each
+ * followed by the block payload of the uref. The source answers with credit
+ * frames, each allowing the sink to send the given number of additional
+ * data urefs; flow definitions do not consume credits.
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uref_serial.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netdb.h>
+
+/** @internal @This is the type of a credit frame. */
+#define UPIPE_NET_XFER_CREDIT 'C'
+/** @internal @This is the size of a credit frame. */
+#define UPIPE_NET_XFER_CREDIT_SIZE UREF_SERIAL_FRAME_SIZE
+
+/** @internal @This writes a credit frame.
+ *
+ * @param buffer buffer of at least @ref UPIPE_NET_XFER_CREDIT_SIZE octets
+ * @param credits number of urefs granted
+ */
+static inline void upipe_net_xfer_write_credit(uint8_t *buffer,
+                                               uint32_t credits)
+{
+    memset(buffer, 0, UPIPE_NET_XFER_CREDIT_SIZE);
+    buffer[0] = UPIPE_NET_XFER_CREDIT;
+    buffer[1] = credits >> 24;
+    buffer[2] = credits >> 16;
+    buffer[3] = credits >> 8;
+    buffer[4] = credits;
+}
+
+/** @internal @This reads a credit frame.
+ *
+ * @param buffer buffer of at least @ref UPIPE_NET_XFER_CREDIT_SIZE octets
+ * @param credits_p filled in with the number of urefs granted
+ * @return an error code
+ */
+static inline int upipe_net_xfer_read_credit(const uint8_t *buffer,
+                                             uint32_t *credits_p)
+{
+    if (unlikely(buffer[0] != UPIPE_NET_XFER_CREDIT))
+        return UBASE_ERR_INVALID;
+    *credits_p = ((uint32_t)buffer[1] << 24) | (buffer[2] << 16) |
+                 (buffer[3] << 8) | buffer[4];
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This resolves a TCP address given as host:port, where host
+ * may be enclosed in square brackets, or be empty to designate any local
+ * address.
+ *
+ * @param uri address to resolve
+ * @param passive true if the address is used to listen
+ * @param res_p filled in with the list of addresses, to be freed with
+ * freeaddrinfo
+ * @return an error code
+ */
+static inline int upipe_net_xfer_resolve(const char *uri, bool passive,
+                                         struct addrinfo **res_p)
+{
+    char *host = strdup(uri);
+    UBASE_ALLOC_RETURN(host)
+    char *port = strrchr(host, ':');
+    if (unlikely(port == NULL || !port[1])) {
+        free(host);
+        return UBASE_ERR_INVALID;
+    }
+    *port++ = '\0';
+    char *node = host;
+    size_t len = strlen(node);
+    if (len >= 2 && node[0] == '[' && node[len - 1] == ']') {
+        node[len - 1] = '\0';
+        node++;
+    }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = passive ? AI_PASSIVE : 0;
+    int ret = getaddrinfo(*node ? node : NULL, port, &hints, res_p);
+    free(host);
+    return ret == 0 ? UBASE_ERR_NONE : UBASE_ERR_EXTERNAL;
+}
@@ -0,0 +1,895 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe sink module sending urefs to a remote host
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uref.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_serial.h>
+#include <upipe/upump.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_ubuf_mgr.h>
+#include <upipe/upipe_helper_upump_mgr.h>
+#include <upipe/upipe_helper_upump.h>
+#include <upipe/upipe_helper_input.h>
+#include <upipe-modules/upipe_net_xfer_sink.h>
+
+#include "upipe_net_xfer.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <assert.h>
+
+/** default maximum number of urefs sent at once */
+#define DEFAULT_BATCH 64
+/** maximum number of buffer segments sent with a single system call */
+#define MAX_IOVECS 256
+
+/** @hidden */
+static bool upipe_net_xfer_sink_handle(struct upipe *upipe, struct uref *uref,
+                                       struct upump **upump_p);
+/** @hidden */
+static int upipe_net_xfer_sink_check(struct upipe *upipe,
+                                     struct uref *flow_format);
+/** @hidden */
+static void upipe_net_xfer_sink_poll(struct upipe *upipe);
+
+/** @internal @This is the private context of a net xfer sink pipe. */
+struct upipe_net_xfer_sink {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** ubuf manager */
+    struct ubuf_mgr *ubuf_mgr;
+    /** flow format packet */
+    struct uref *flow_format;
+    /** ubuf manager request */
+    struct urequest ubuf_mgr_request;
+
+    /** upump manager */
+    struct upump_mgr *upump_mgr;
+    /** write watcher */
+    struct upump *upump;
+    /** credit watcher */
+    struct upump *upump_credit;
+
+    /** temporary uref storage */
+    struct uchain urefs;
+    /** nb urefs in storage */
+    unsigned int nb_urefs;
+    /** max urefs in storage */
+    unsigned int max_urefs;
+    /** list of blockers */
+    struct uchain blockers;
+
+    /** socket */
+    int fd;
+    /** uri */
+    char *uri;
+    /** maximum number of urefs sent at once */
+    unsigned int batch;
+    /** number of urefs the source allows to send */
+    uint64_t credits;
+    /** partially received credit frame */
+    uint8_t credit[UPIPE_NET_XFER_CREDIT_SIZE];
+    /** number of octets in the partially received credit frame */
+    size_t credit_size;
+
+    /** input flow definition */
+    struct uref *input_flow_def;
+    /** true if the input flow definition was sent */
+    bool input_flow_def_sent;
+    /** attributes of the previous uref, or NULL */
+    struct uref *ref;
+    /** serialized stream not yet sent, or NULL */
+    struct ubuf *stream;
+    /** number of urefs in the serialized stream */
+    unsigned int nb_stream;
+    /** true if the socket is full */
+    bool blocked;
+    /** true while held urefs are being sent */
+    bool draining;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_net_xfer_sink, upipe, UPIPE_NET_XFER_SINK_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_net_xfer_sink, urefcount,
+                       upipe_net_xfer_sink_free)
+UPIPE_HELPER_VOID(upipe_net_xfer_sink)
+UPIPE_HELPER_UBUF_MGR(upipe_net_xfer_sink, ubuf_mgr, flow_format,
+                      ubuf_mgr_request, upipe_net_xfer_sink_check,
+                      upipe_throw_provide_request, NULL)
+UPIPE_HELPER_UPUMP_MGR(upipe_net_xfer_sink, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_net_xfer_sink, upump, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_net_xfer_sink, upump_credit, upump_mgr)
+UPIPE_HELPER_INPUT(upipe_net_xfer_sink, urefs, nb_urefs, max_urefs, blockers,
+                   upipe_net_xfer_sink_handle)
+
+/** @internal @This allocates a net xfer sink pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_net_xfer_sink_alloc(struct upipe_mgr *mgr,
+                                               struct uprobe *uprobe,
+                                               uint32_t signature,
+                                               va_list args)
+{
+    struct upipe *upipe = upipe_net_xfer_sink_alloc_void(mgr, uprobe,
+                                                         signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_net_xfer_sink *upipe_net_xfer_sink =
+        upipe_net_xfer_sink_from_upipe(upipe);
+    upipe_net_xfer_sink_init_urefcount(upipe);
+    upipe_net_xfer_sink_init_ubuf_mgr(upipe);
+    upipe_net_xfer_sink_init_upump_mgr(upipe);
+    upipe_net_xfer_sink_init_upump(upipe);
+    upipe_net_xfer_sink_init_upump_credit(upipe);
+    upipe_net_xfer_sink_init_input(upipe);
+    upipe_net_xfer_sink->fd = -1;
+    upipe_net_xfer_sink->uri = NULL;
+    upipe_net_xfer_sink->batch = DEFAULT_BATCH;
+    upipe_net_xfer_sink->credits = 0;
+    upipe_net_xfer_sink->credit_size = 0;
+    upipe_net_xfer_sink->input_flow_def = NULL;
+    upipe_net_xfer_sink->input_flow_def_sent = false;
+    upipe_net_xfer_sink->ref = NULL;
+    upipe_net_xfer_sink->stream = NULL;
+    upipe_net_xfer_sink->nb_stream = 0;
+    upipe_net_xfer_sink->blocked = false;
+    upipe_net_xfer_sink->draining = false;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This closes the socket and forgets the state of the
+ * connection.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_net_xfer_sink_close(struct upipe *upipe)
+{
+    struct upipe_net_xfer_sink *upipe_net_xfer_sink =
+        upipe_net_xfer_sink_from_upipe(upipe);
+    if (upipe_net_xfer_sink->fd != -1) {
+        if (upipe_net_xfer_sink->uri != NULL)
+            upipe_notice_va(upipe, "closing socket %s",
+                            upipe_net_xfer_sink->uri);
+        ubase_clean_fd(&upipe_net_xfer_sink->fd);
+    }
+    upipe_net_xfer_sink_set_upump(upipe, NULL);
+    upipe_net_xfer_sink_set_upump_credit(upipe, NULL);
+    if (upipe_net_xfer_sink->stream != NULL) {
+        ubuf_free(upipe_net_xfer_sink->stream);
+        upipe_net_xfer_sink->stream = NULL;
+    }
+    upipe_net_xfer_sink->nb_stream = 0;
+    upipe_net_xfer_sink->blocked = false;
+    upipe_net_xfer_sink->credits = 0;
+    upipe_net_xfer_sink->credit_size = 0;
+    upipe_net_xfer_sink->input_flow_def_sent = false;
+    uref_free(upipe_net_xfer_sink->ref);
+    upipe_net_xfer_sink->ref = NULL;
+}
+
+/** @internal @This sends as much of the serialized stream as the socket
+ * accepts.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_net_xfer_sink_send(struct upipe *upipe)
+{
+    struct upipe_net_xfer_sink *upipe_net_xfer_sink =
+        upipe_net_xfer_sink_from_upipe(upipe);
+
+    while (upipe_net_xfer_sink->stream != NULL &&
+           !upipe_net_xfer_sink->blocked) {
+        struct ubuf *stream = upipe_net_xfer_sink->stream;
+        size_t size;
+        if (unlikely(!ubase_check(ubuf_block_size(stream, &size))))
+            size = 0;
+
+        struct iovec iovecs[MAX_IOVECS];
+        int nb_iovecs = 0;
+        size_t offset = 0;
+        while (nb_iovecs < MAX_IOVECS && offset < size) {
+            int read_size = -1;
+            const uint8_t *buffer;
+            if (unlikely(!ubase_check(ubuf_block_read(stream, offset,
+                                                      &read_size,
+                                                      &buffer))))
+                break;
+            iovecs[nb_iovecs].iov_base = (void *)buffer;
+            iovecs[nb_iovecs].iov_len = read_size;
+            nb_iovecs++;
+            offset += read_size;
+        }
+
+        struct msghdr msghdr;
+        memset(&msghdr, 0, sizeof(msghdr));
+        msghdr.msg_iov = iovecs;
+        msghdr.msg_iovlen = nb_iovecs;
+        ssize_t ret = nb_iovecs ?
+            sendmsg(upipe_net_xfer_sink->fd, &msghdr, MSG_NOSIGNAL) : 0;
+        int err = errno;
+
+        offset = 0;
+        for (int i = 0; i < nb_iovecs; i++) {
+            ubuf_block_unmap(stream, offset);
+            offset += iovecs[i].iov_len;
+        }
+
+        if (unlikely(ret == -1)) {
+            switch (err) {
+                case EINTR:
+                    continue;
+                case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+                case EWOULDBLOCK:
+#endif
+                    upipe_net_xfer_sink->blocked = true;
+                    return;
+                default:
+                    break;
+            }
+            errno = err;
+            upipe_err_va(upipe, "write error to %s (%m)",
+                         upipe_net_xfer_sink->uri ?: "socket");
+            upipe_net_xfer_sink_close(upipe);
+            return;
+        }
+
+        if ((size_t)ret >= size) {
+            ubuf_free(stream);
+            upipe_net_xfer_sink->stream = NULL;
+            upipe_net_xfer_sink->nb_stream = 0;
+        } else
+            ubuf_block_resize(stream, ret, -1);
+    }
+}
+
+/** @internal @This appends a buffer to the serialized stream.
+ *
+ * @param upipe description structure of the pipe
+ * @param ubuf buffer to append
+ */
+static void upipe_net_xfer_sink_append(struct upipe *upipe, struct ubuf *ubuf)
+{
+    struct upipe_net_xfer_sink *upipe_net_xfer_sink =
+        upipe_net_xfer_sink_from_upipe(upipe);
+    if (upipe_net_xfer_sink->stream == NULL)
+        upipe_net_xfer_sink->stream = ubuf;
+    else if (unlikely(!ubase_check(ubuf_block_append(
+                        upipe_net_xfer_sink->stream, ubuf)))) {
+        ubuf_free(ubuf);
+        upipe_warn(upipe, "unable to append buffer");
+    }
+}
+
+/** @internal @This allocates a frame holding a serialized uref.
+ *
+ * @param upipe description structure of the pipe
+ * @param frame type of frame
+ * @param uref uref to serialize
+ * @param ref reference uref, or NULL
+ * @param payload_size size of the payload following the frame
+ * @return pointer to the frame, or NULL in case of error
+ */
+static struct ubuf *upipe_net_xfer_sink_frame(struct upipe *upipe,
+                                              enum uref_serial_frame frame,
+                                              struct uref *uref,
+                                              struct uref *ref,
+                                              size_t payload_size)
+{
+    struct upipe_net_xfer_sink *upipe_net_xfer_sink =
+        upipe_net_xfer_sink_from_upipe(upipe);
+    size_t header_size;
+    if (unlikely(!ubase_check(uref_serial_encode(uref, ref, NULL,
+                                                 &header_size)) ||
+                 header_size > INT_MAX - UREF_SERIAL_FRAME_SIZE ||
+                 payload_size > INT_MAX - UREF_SERIAL_FRAME_SIZE -
+                                header_size)) {
+        upipe_warn(upipe, "unable to serialize uref");
+        return NULL;
+    }
+
+    struct ubuf *ubuf = ubuf_block_alloc(upipe_net_xfer_sink->ubuf_mgr,
+                                         UREF_SERIAL_FRAME_SIZE + header_size);
+    if (unlikely(ubuf == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
+
+    int size = -1;
+    uint8_t *buffer;
+    if (unlikely(!ubase_check(ubuf_block_write(ubuf, 0, &size, &buffer)) ||
+                 (size_t)size != UREF_SERIAL_FRAME_SIZE + header_size)) {
+        ubuf_free(ubuf);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
+    uref_serial_write_frame(buffer, frame, header_size, payload_size);
+    int err = uref_serial_encode(uref, ref, buffer + UREF_SERIAL_FRAME_SIZE,
+                                 &header_size);
+    ubuf_block_unmap(ubuf, 0);
+    if (unlikely(!ubase_check(err))) {
+        ubuf_free(ubuf);
+        upipe_warn(upipe, "unable to serialize uref");
+        return NULL;
+    }
+    return ubuf;
+}
+
+/** @internal @This handles data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ * @return false if the input must be blocked
+ */
+static bool upipe_net_xfer_sink_handle(struct upipe *upipe, struct uref *uref,
+                                       struct upump **upump_p)
+{
+    struct upipe_net_xfer_sink *upipe_net_xfer_sink =
+        upipe_net_xfer_sink_from_upipe(upipe);
+    const char *def;
+    if (unlikely(ubase_check(uref_flow_get_def(uref, &def)))) {
+        uref_free(upipe_net_xfer_sink->input_flow_def);
+        upipe_net_xfer_sink->input_flow_def = uref;
+        upipe_net_xfer_sink->input_flow_def_sent = false;
+        uref_free(upipe_net_xfer_sink->ref);
+        upipe_net_xfer_sink->ref = NULL;
+
+        if (upipe_net_xfer_sink->ubuf_mgr == NULL) {
+            struct uref *flow_format =
+                uref_block_flow_alloc_def(uref->mgr, NULL);
+            if (unlikely(flow_format == NULL)) {
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                return true;
+            }
+            upipe_net_xfer_sink_require_ubuf_mgr(upipe, flow_format);
+        }
+        return true;
+    }
+
+    if (unlikely(upipe_net_xfer_sink->fd == -1)) {
+        upipe_warn(upipe, "received a buffer before opening a socket");
+        uref_free(uref);
+        return true;
+    }
+    if (upipe_net_xfer_sink->ubuf_mgr == NULL ||
+        upipe_net_xfer_sink->blocked || !upipe_net_xfer_sink->credits)
+        return false;
+
+    size_t payload_size = 0;
+    if (uref->ubuf != NULL &&
+        unlikely(!ubase_check(uref_block_size(uref, &payload_size)))) {
+        upipe_warn(upipe, "only block buffers may be sent");
+        uref_free(uref);
+        return true;
+    }
+
+    if (!upipe_net_xfer_sink->input_flow_def_sent &&
+        upipe_net_xfer_sink->input_flow_def != NULL) {
+        struct ubuf *ubuf = upipe_net_xfer_sink_frame(upipe,
+                UREF_SERIAL_FRAME_FLOW_DEF,
+                upipe_net_xfer_sink->input_flow_def, NULL, 0);
+        if (unlikely(ubuf == NULL)) {
+            uref_free(uref);
+            return true;
+        }
+        upipe_net_xfer_sink_append(upipe, ubuf);
+        upipe_net_xfer_sink->input_flow_def_sent = true;
+    }
+
+    struct ubuf *ubuf = upipe_net_xfer_sink_frame(upipe,
+            UREF_SERIAL_FRAME_UREF, uref, upipe_net_xfer_sink->ref,
+            payload_size);
+    if (unlikely(ubuf == NULL)) {
+        uref_free(uref);
+        return true;
+    }
+
+    /* keep the attributes as reference for the next uref */
+    struct uref *ref = uref_sibling_alloc(uref);
+    if (unlikely(ref == NULL)) {
+        ubuf_free(ubuf);
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return true;
+    }
+    ref->udict = uref->udict;
+    uref->udict = NULL;
+    uref_free(upipe_net_xfer_sink->ref);
+    upipe_net_xfer_sink->ref = ref;
+
+    if (uref->ubuf != NULL) {
+        struct ubuf *payload = uref_detach_ubuf(uref);
+        if (unlikely(!ubase_check(ubuf_block_append(ubuf, payload)))) {
+            ubuf_free(payload);
+            ubuf_free(ubuf);
+            uref_free(uref);
+            upipe_warn(upipe, "unable to append payload");
+            return true;
+        }
+    }
+    uref_free(uref);
+
+    upipe_net_xfer_sink_append(upipe, ubuf);
+    upipe_net_xfer_sink->credits--;
+    upipe_net_xfer_sink->nb_stream++;
+    if (!upipe_net_xfer_sink->draining ||
+        upipe_net_xfer_sink->nb_stream >= upipe_net_xfer_sink->batch)
+        upipe_net_xfer_sink_send(upipe);
+    return true;
+}
+
+/** @internal @This sends the held urefs in batches, and releases the pipe
+ * when all of them have been sent.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_net_xfer_sink_drain(struct upipe *upipe)
+{
+    struct upipe_net_xfer_sink *upipe_net_xfer_sink =
+        upipe_net_xfer_sink_from_upipe(upipe);
+    bool was_buffered = !upipe_net_xfer_sink_check_input(upipe);
+    upipe_net_xfer_sink->draining = true;
+    upipe_net_xfer_sink_output_input(upipe);
+    upipe_net_xfer_sink->draining = false;
+    upipe_net_xfer_sink_send(upipe);
+    if (upipe_net_xfer_sink->blocked)
+        upipe_net_xfer_sink_poll(upipe);
+
+    if (was_buffered && upipe_net_xfer_sink_check_input(upipe)) {
+        upipe_net_xfer_sink_unblock_input(upipe);
+        /* All packets have been output, release again the pipe that has been
+         * used in @ref upipe_net_xfer_sink_input. */
+        upipe_release(upipe);
+    }
+}
+
+/** @internal @This is called when the socket can be written again.
+ *
+ * @param upump description structure of the watcher
+ */
+static void upipe_net_xfer_sink_watcher(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_net_xfer_sink *upipe_net_xfer_sink =
+        upipe_net_xfer_sink_from_upipe(upipe);
+    upipe_net_xfer_sink_set_upump(upipe, NULL);
+    upipe_net_xfer_sink->blocked = false;
+    upipe_net_xfer_sink_drain(upipe);
+}
+
+/** @internal @This is called when credit frames are received.
+ *
+ * @param upump description structure of the watcher
+ */
+static void upipe_net_xfer_sink_credit_watcher(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_net_xfer_sink *upipe_net_xfer_sink =
+        upipe_net_xfer_sink_from_upipe(upipe);
+    bool granted = false;
+
+    for ( ; ; ) {
+        ssize_t ret = read(upipe_net_xfer_sink->fd,
+                upipe_net_xfer_sink->credit + upipe_net_xfer_sink->credit_size,
+                UPIPE_NET_XFER_CREDIT_SIZE - upipe_net_xfer_sink->credit_size);
+        if (ret == -1 && errno == EINTR)
+            continue;
+        if (ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (unlikely(ret <= 0)) {
+            if (ret == 0)
+                upipe_warn_va(upipe, "connection to %s closed by peer",
+                              upipe_net_xfer_sink->uri ?: "socket");
+            else
+                upipe_err_va(upipe, "read error from %s (%m)",
+                             upipe_net_xfer_sink->uri ?: "socket");
+            upipe_net_xfer_sink_close(upipe);
+            /* held urefs are dropped */
+            upipe_net_xfer_sink_drain(upipe);
+            return;
+        }
+
+        upipe_net_xfer_sink->credit_size += ret;
+        if (upipe_net_xfer_sink->credit_size < UPIPE_NET_XFER_CREDIT_SIZE)
+            continue;
+        upipe_net_xfer_sink->credit_size = 0;
+
+        uint32_t credits;
+        if (unlikely(!ubase_check(upipe_net_xfer_read_credit(
+                            upipe_net_xfer_sink->credit, &credits)))) {
+            upipe_err(upipe, "invalid credit frame");
+            upipe_net_xfer_sink_close(upipe);
+            upipe_net_xfer_sink_drain(upipe);
+            return;
+        }
+        upipe_net_xfer_sink->credits += credits;
+        granted = true;
+    }
+
+    if (granted)
+        upipe_net_xfer_sink_drain(upipe);
+}
+
+/** @internal @This starts the watchers of the socket.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_net_xfer_sink_poll(struct upipe *upipe)
+{
+    struct upipe_net_xfer_sink *upipe_net_xfer_sink =
+        upipe_net_xfer_sink_from_upipe(upipe);
+    if (upipe_net_xfer_sink->fd == -1)
+        return;
+    if (unlikely(!ubase_check(upipe_net_xfer_sink_check_upump_mgr(upipe))))
+        return;
+
+    if (upipe_net_xfer_sink->upump_credit == NULL) {
+        struct upump *upump = upump_alloc_fd_read(
+                upipe_net_xfer_sink->upump_mgr,
+                upipe_net_xfer_sink_credit_watcher, upipe, upipe->refcount,
+                upipe_net_xfer_sink->fd);
+        if (unlikely(upump == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+            return;
+        }
+        upipe_net_xfer_sink_set_upump_credit(upipe, upump);
+        upump_start(upump);
+    }
+
+    if (upipe_net_xfer_sink->blocked && upipe_net_xfer_sink->upump == NULL) {
+        struct upump *upump = upump_alloc_fd_write(
+                upipe_net_xfer_sink->upump_mgr,
+                upipe_net_xfer_sink_watcher, upipe, upipe->refcount,
+                upipe_net_xfer_sink->fd);
+        if (unlikely(upump == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+            return;
+        }
+        upipe_net_xfer_sink_set_upump(upipe, upump);
+        upump_start(upump);
+    }
+}
+
+/** @internal @This receives data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_net_xfer_sink_input(struct upipe *upipe, struct uref *uref,
+                                      struct upump **upump_p)
+{
+    struct upipe_net_xfer_sink *upipe_net_xfer_sink =
+        upipe_net_xfer_sink_from_upipe(upipe);
+    if (!upipe_net_xfer_sink_check_input(upipe)) {
+        upipe_net_xfer_sink_hold_input(upipe, uref);
+        upipe_net_xfer_sink_block_input(upipe, upump_p);
+    } else if (!upipe_net_xfer_sink_handle(upipe, uref, upump_p)) {
+        upipe_net_xfer_sink_hold_input(upipe, uref);
+        upipe_net_xfer_sink_block_input(upipe, upump_p);
+        /* Increment upipe refcount to avoid disappearing before all packets
+         * have been sent. */
+        upipe_use(upipe);
+    }
+    if (upipe_net_xfer_sink->blocked)
+        upipe_net_xfer_sink_poll(upipe);
+}
+
+/** @internal @This is called when the ubuf manager is available.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_net_xfer_sink_check(struct upipe *upipe,
+                                     struct uref *flow_format)
+{
+    uref_free(flow_format);
+    upipe_use(upipe);
+    upipe_net_xfer_sink_drain(upipe);
+    upipe_net_xfer_sink_poll(upipe);
+    upipe_release(upipe);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_net_xfer_sink_set_flow_def(struct upipe *upipe,
+                                            struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup)
+    upipe_input(upipe, flow_def_dup, NULL);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This uses a connected socket.
+ *
+ * @param upipe description structure of the pipe
+ * @param fd connected socket, or -1
+ * @param uri description of the peer, or NULL
+ * @return an error code
+ */
+static int upipe_net_xfer_sink_open(struct upipe *upipe, int fd,
+                                    const char *uri)
+{
+    struct upipe_net_xfer_sink *upipe_net_xfer_sink =
+        upipe_net_xfer_sink_from_upipe(upipe);
+    upipe_net_xfer_sink_close(upipe);
+    ubase_clean_str(&upipe_net_xfer_sink->uri);
+    if (fd == -1)
+        return UBASE_ERR_NONE;
+
+    int flags = fcntl(fd, F_GETFL);
+    if (unlikely(flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1)) {
+        upipe_err_va(upipe, "unable to set the socket non-blocking (%m)");
+        close(fd);
+        return UBASE_ERR_EXTERNAL;
+    }
+    if (uri != NULL) {
+        upipe_net_xfer_sink->uri = strdup(uri);
+        if (unlikely(upipe_net_xfer_sink->uri == NULL)) {
+            close(fd);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return UBASE_ERR_ALLOC;
+        }
+    }
+    upipe_net_xfer_sink->fd = fd;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This connects to the given host:port.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri host:port of the remote source
+ * @return an error code
+ */
+static int upipe_net_xfer_sink_set_uri(struct upipe *upipe, const char *uri)
+{
+    if (unlikely(uri == NULL))
+        return upipe_net_xfer_sink_open(upipe, -1, NULL);
+
+    struct addrinfo *res;
+    int err = upipe_net_xfer_resolve(uri, false, &res);
+    if (unlikely(!ubase_check(err))) {
+        upipe_err_va(upipe, "unable to resolve %s", uri);
+        return err;
+    }
+
+    int fd = -1;
+    for (struct addrinfo *ai = res; ai != NULL; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd == -1)
+            continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+            break;
+        ubase_clean_fd(&fd);
+    }
+    freeaddrinfo(res);
+    if (unlikely(fd == -1)) {
+        upipe_err_va(upipe, "can't connect to %s (%m)", uri);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    /* frames are already batched */
+    int nodelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    UBASE_RETURN(upipe_net_xfer_sink_open(upipe, fd, uri))
+    upipe_notice_va(upipe, "connected to %s", uri);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This flushes all held urefs.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_net_xfer_sink_flush(struct upipe *upipe)
+{
+    if (upipe_net_xfer_sink_flush_input(upipe)) {
+        /* All packets have been output, release again the pipe that has been
+         * used in @ref upipe_net_xfer_sink_input. */
+        upipe_release(upipe);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a net xfer sink pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int _upipe_net_xfer_sink_control(struct upipe *upipe, int command,
+                                        va_list args)
+{
+    struct upipe_net_xfer_sink *upipe_net_xfer_sink =
+        upipe_net_xfer_sink_from_upipe(upipe);
+
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST:
+        case UPIPE_UNREGISTER_REQUEST:
+            return upipe_control_provide_request(upipe, command, args);
+        case UPIPE_ATTACH_UPUMP_MGR:
+            upipe_net_xfer_sink_set_upump(upipe, NULL);
+            upipe_net_xfer_sink_set_upump_credit(upipe, NULL);
+            return upipe_net_xfer_sink_attach_upump_mgr(upipe);
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_net_xfer_sink_set_flow_def(upipe, flow_def);
+        }
+        case UPIPE_GET_URI: {
+            const char **uri_p = va_arg(args, const char **);
+            *uri_p = upipe_net_xfer_sink->uri;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SET_URI: {
+            const char *uri = va_arg(args, const char *);
+            return upipe_net_xfer_sink_set_uri(upipe, uri);
+        }
+        case UPIPE_GET_MAX_LENGTH: {
+            unsigned int *p = va_arg(args, unsigned int *);
+            return upipe_net_xfer_sink_get_max_length(upipe, p);
+        }
+        case UPIPE_SET_MAX_LENGTH: {
+            unsigned int max_length = va_arg(args, unsigned int);
+            return upipe_net_xfer_sink_set_max_length(upipe, max_length);
+        }
+        case UPIPE_FLUSH:
+            return upipe_net_xfer_sink_flush(upipe);
+
+        case UPIPE_NET_XFER_SINK_SET_FD: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NET_XFER_SINK_SIGNATURE)
+            int fd = va_arg(args, int);
+            return upipe_net_xfer_sink_open(upipe, fd, NULL);
+        }
+        case UPIPE_NET_XFER_SINK_GET_FD: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NET_XFER_SINK_SIGNATURE)
+            int *fd_p = va_arg(args, int *);
+            *fd_p = upipe_net_xfer_sink->fd;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_NET_XFER_SINK_SET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NET_XFER_SINK_SIGNATURE)
+            unsigned int batch = va_arg(args, unsigned int);
+            if (unlikely(!batch))
+                return UBASE_ERR_INVALID;
+            upipe_net_xfer_sink->batch = batch;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_NET_XFER_SINK_GET_CREDITS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NET_XFER_SINK_SIGNATURE)
+            uint64_t *credits_p = va_arg(args, uint64_t *);
+            *credits_p = upipe_net_xfer_sink->credits;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This processes control commands on a net xfer sink pipe, and
+ * starts the watchers if needed.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_net_xfer_sink_control(struct upipe *upipe, int command,
+                                       va_list args)
+{
+    UBASE_RETURN(_upipe_net_xfer_sink_control(upipe, command, args))
+    upipe_net_xfer_sink_poll(upipe);
+    return UBASE_ERR_NONE;
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_net_xfer_sink_free(struct upipe *upipe)
+{
+    struct upipe_net_xfer_sink *upipe_net_xfer_sink =
+        upipe_net_xfer_sink_from_upipe(upipe);
+    upipe_net_xfer_sink_close(upipe);
+    upipe_throw_dead(upipe);
+
+    free(upipe_net_xfer_sink->uri);
+    uref_free(upipe_net_xfer_sink->input_flow_def);
+    upipe_net_xfer_sink_clean_upump_credit(upipe);
+    upipe_net_xfer_sink_clean_upump(upipe);
+    upipe_net_xfer_sink_clean_upump_mgr(upipe);
+    upipe_net_xfer_sink_clean_input(upipe);
+    /* the ubuf manager request was only thrown to the probes */
+    if (urequest_get_opaque(&upipe_net_xfer_sink->ubuf_mgr_request,
+                            struct upipe *) != NULL)
+        urequest_clean(&upipe_net_xfer_sink->ubuf_mgr_request);
+    upipe_net_xfer_sink_clean_ubuf_mgr(upipe);
+    upipe_net_xfer_sink_clean_urefcount(upipe);
+    upipe_net_xfer_sink_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_net_xfer_sink_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_NET_XFER_SINK_SIGNATURE,
+
+    .upipe_alloc = upipe_net_xfer_sink_alloc,
+    .upipe_input = upipe_net_xfer_sink_input,
+    .upipe_control = upipe_net_xfer_sink_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all net xfer sink pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_net_xfer_sink_mgr_alloc(void)
+{
+    return &upipe_net_xfer_sink_mgr;
+}
@@ -0,0 +1,860 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe source module receiving urefs from a remote host
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uref.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_serial.h>
+#include <upipe/upump.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe/upipe_helper_uref_mgr.h>
+#include <upipe/upipe_helper_ubuf_mgr.h>
+#include <upipe/upipe_helper_upump_mgr.h>
+#include <upipe/upipe_helper_upump.h>
+#include <upipe-modules/upipe_net_xfer_source.h>
+
+#include "upipe_net_xfer.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <assert.h>
+
+/** default number of urefs the sink may send ahead */
+#define DEFAULT_WINDOW 256
+/** size of the buffers read from the socket */
+#define READ_SIZE 65536
+/** default maximum size of a received frame */
+#define DEFAULT_MAX_FRAME_SIZE (64 * 1024 * 1024)
+
+/** @internal @This is the private context of a net xfer source pipe. */
+struct upipe_net_xfer_src {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** uref manager */
+    struct uref_mgr *uref_mgr;
+    /** uref manager request */
+    struct urequest uref_mgr_request;
+
+    /** ubuf manager */
+    struct ubuf_mgr *ubuf_mgr;
+    /** flow format packet */
+    struct uref *flow_format;
+    /** ubuf manager request */
+    struct urequest ubuf_mgr_request;
+
+    /** upump manager */
+    struct upump_mgr *upump_mgr;
+    /** read or accept watcher */
+    struct upump *upump;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** output flow definition */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** connected socket */
+    int fd;
+    /** listening socket */
+    int listen_fd;
+    /** uri */
+    char *uri;
+
+    /** number of urefs the sink may send ahead */
+    unsigned int window;
+    /** maximum size of a received frame */
+    unsigned int max_frame_size;
+    /** number of credits not yet granted to the sink */
+    uint64_t credits;
+    /** credit frame being sent */
+    uint8_t credit[UPIPE_NET_XFER_CREDIT_SIZE];
+    /** number of octets of the credit frame not yet sent */
+    size_t credit_size;
+
+    /** input stream not yet deserialized, or NULL */
+    struct uref *next_uref;
+    /** attributes of the previous uref, or NULL */
+    struct uref *ref;
+    /** buffer used to read serialized urefs spanning several segments */
+    uint8_t *scratch;
+    /** size of the scratch buffer */
+    size_t scratch_size;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+/** @hidden */
+static int upipe_net_xfer_src_check(struct upipe *upipe,
+                                    struct uref *flow_format);
+
+UPIPE_HELPER_UPIPE(upipe_net_xfer_src, upipe, UPIPE_NET_XFER_SRC_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_net_xfer_src, urefcount, upipe_net_xfer_src_free)
+UPIPE_HELPER_VOID(upipe_net_xfer_src)
+UPIPE_HELPER_OUTPUT(upipe_net_xfer_src, output, flow_def, output_state,
+                    request_list)
+UPIPE_HELPER_UREF_MGR(upipe_net_xfer_src, uref_mgr, uref_mgr_request,
+                      upipe_net_xfer_src_check,
+                      upipe_net_xfer_src_register_output_request,
+                      upipe_net_xfer_src_unregister_output_request)
+UPIPE_HELPER_UBUF_MGR(upipe_net_xfer_src, ubuf_mgr, flow_format,
+                      ubuf_mgr_request, upipe_net_xfer_src_check,
+                      upipe_net_xfer_src_register_output_request,
+                      upipe_net_xfer_src_unregister_output_request)
+UPIPE_HELPER_UPUMP_MGR(upipe_net_xfer_src, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_net_xfer_src, upump, upump_mgr)
+
+/** @internal @This allocates a net xfer source pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_net_xfer_src_alloc(struct upipe_mgr *mgr,
+                                              struct uprobe *uprobe,
+                                              uint32_t signature,
+                                              va_list args)
+{
+    struct upipe *upipe = upipe_net_xfer_src_alloc_void(mgr, uprobe,
+                                                        signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_net_xfer_src *upipe_net_xfer_src =
+        upipe_net_xfer_src_from_upipe(upipe);
+    upipe_net_xfer_src_init_urefcount(upipe);
+    upipe_net_xfer_src_init_uref_mgr(upipe);
+    upipe_net_xfer_src_init_ubuf_mgr(upipe);
+    upipe_net_xfer_src_init_upump_mgr(upipe);
+    upipe_net_xfer_src_init_upump(upipe);
+    upipe_net_xfer_src_init_output(upipe);
+    upipe_net_xfer_src->fd = -1;
+    upipe_net_xfer_src->listen_fd = -1;
+    upipe_net_xfer_src->uri = NULL;
+    upipe_net_xfer_src->window = DEFAULT_WINDOW;
+    upipe_net_xfer_src->max_frame_size = DEFAULT_MAX_FRAME_SIZE;
+    upipe_net_xfer_src->credits = 0;
+    upipe_net_xfer_src->credit_size = 0;
+    upipe_net_xfer_src->next_uref = NULL;
+    upipe_net_xfer_src->ref = NULL;
+    upipe_net_xfer_src->scratch = NULL;
+    upipe_net_xfer_src->scratch_size = 0;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This closes the sockets and forgets the state of the
+ * connection.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_net_xfer_src_close(struct upipe *upipe)
+{
+    struct upipe_net_xfer_src *upipe_net_xfer_src =
+        upipe_net_xfer_src_from_upipe(upipe);
+    if ((upipe_net_xfer_src->fd != -1 ||
+         upipe_net_xfer_src->listen_fd != -1) &&
+        upipe_net_xfer_src->uri != NULL)
+        upipe_notice_va(upipe, "closing socket %s", upipe_net_xfer_src->uri);
+    ubase_clean_fd(&upipe_net_xfer_src->fd);
+    ubase_clean_fd(&upipe_net_xfer_src->listen_fd);
+    upipe_net_xfer_src_set_upump(upipe, NULL);
+    upipe_net_xfer_src->credits = 0;
+    upipe_net_xfer_src->credit_size = 0;
+    uref_free(upipe_net_xfer_src->next_uref);
+    upipe_net_xfer_src->next_uref = NULL;
+    uref_free(upipe_net_xfer_src->ref);
+    upipe_net_xfer_src->ref = NULL;
+}
+
+/** @internal @This grants credits to the sink, once half of the window has
+ * been output. A credit frame that doesn't fit in the socket is sent on the
+ * next occasion.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_net_xfer_src_grant(struct upipe *upipe)
+{
+    struct upipe_net_xfer_src *upipe_net_xfer_src =
+        upipe_net_xfer_src_from_upipe(upipe);
+    if (upipe_net_xfer_src->fd == -1)
+        return;
+
+    for ( ; ; ) {
+        if (!upipe_net_xfer_src->credit_size) {
+            uint64_t threshold = (upipe_net_xfer_src->window + 1) / 2;
+            if (upipe_net_xfer_src->credits < threshold)
+                return;
+            uint32_t credits = upipe_net_xfer_src->credits > UINT32_MAX ?
+                               UINT32_MAX : upipe_net_xfer_src->credits;
+            upipe_net_xfer_write_credit(upipe_net_xfer_src->credit, credits);
+            upipe_net_xfer_src->credit_size = UPIPE_NET_XFER_CREDIT_SIZE;
+            upipe_net_xfer_src->credits -= credits;
+        }
+
+        ssize_t ret = send(upipe_net_xfer_src->fd,
+                upipe_net_xfer_src->credit + UPIPE_NET_XFER_CREDIT_SIZE -
+                    upipe_net_xfer_src->credit_size,
+                upipe_net_xfer_src->credit_size, MSG_NOSIGNAL);
+        if (ret == -1) {
+            if (errno == EINTR)
+                continue;
+            /* a closed connection is reported by the read watcher */
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EPIPE)
+                upipe_warn_va(upipe, "unable to send credits (%m)");
+            return;
+        }
+        upipe_net_xfer_src->credit_size -= ret;
+    }
+}
+
+/** @internal @This deserializes a uref from the input stream.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref to fill in
+ * @param ref reference uref, or NULL
+ * @param header_size size of the serialized uref
+ * @return an error code
+ */
+static int upipe_net_xfer_src_decode(struct upipe *upipe, struct uref *uref,
+                                     struct uref *ref, uint32_t header_size)
+{
+    struct upipe_net_xfer_src *upipe_net_xfer_src =
+        upipe_net_xfer_src_from_upipe(upipe);
+    if (header_size > upipe_net_xfer_src->scratch_size) {
+        uint8_t *scratch = realloc(upipe_net_xfer_src->scratch, header_size);
+        UBASE_ALLOC_RETURN(scratch)
+        upipe_net_xfer_src->scratch = scratch;
+        upipe_net_xfer_src->scratch_size = header_size;
+    }
+
+    const uint8_t *buffer = uref_block_peek(upipe_net_xfer_src->next_uref,
+                                            UREF_SERIAL_FRAME_SIZE,
+                                            header_size,
+                                            upipe_net_xfer_src->scratch);
+    if (unlikely(buffer == NULL))
+        return UBASE_ERR_INVALID;
+    int err = uref_serial_decode(uref, ref, buffer, header_size);
+    uref_block_peek_unmap(upipe_net_xfer_src->next_uref,
+                          UREF_SERIAL_FRAME_SIZE,
+                          upipe_net_xfer_src->scratch, buffer);
+    return err;
+}
+
+/** @internal @This handles a complete frame at the beginning of the input
+ * stream.
+ *
+ * @param upipe description structure of the pipe
+ * @param frame type of frame
+ * @param header_size size of the serialized uref
+ * @param payload_size size of the payload
+ * @return an error code
+ */
+static int upipe_net_xfer_src_frame(struct upipe *upipe,
+                                    enum uref_serial_frame frame,
+                                    uint32_t header_size,
+                                    uint32_t payload_size)
+{
+    struct upipe_net_xfer_src *upipe_net_xfer_src =
+        upipe_net_xfer_src_from_upipe(upipe);
+    struct uref *next = upipe_net_xfer_src->next_uref;
+    struct uref *uref = frame == UREF_SERIAL_FRAME_FLOW_DEF ?
+                        uref_sibling_alloc_control(next) :
+                        uref_sibling_alloc(next);
+    UBASE_ALLOC_RETURN(uref)
+
+    if (frame == UREF_SERIAL_FRAME_UREF)
+        /* the sink spent a credit whatever happens to the uref */
+        upipe_net_xfer_src->credits++;
+
+    int err = upipe_net_xfer_src_decode(upipe, uref,
+            frame == UREF_SERIAL_FRAME_UREF ? upipe_net_xfer_src->ref : NULL,
+            header_size);
+    if (unlikely(!ubase_check(err))) {
+        uref_free(uref);
+        return err;
+    }
+
+    if (frame == UREF_SERIAL_FRAME_FLOW_DEF) {
+        uref_free(upipe_net_xfer_src->ref);
+        upipe_net_xfer_src->ref = NULL;
+        upipe_net_xfer_src_store_flow_def(upipe, uref);
+        return UBASE_ERR_NONE;
+    }
+
+    if (payload_size) {
+        struct ubuf *ubuf = ubuf_block_splice(next->ubuf,
+                UREF_SERIAL_FRAME_SIZE + header_size, payload_size);
+        if (unlikely(ubuf == NULL)) {
+            uref_free(uref);
+            return UBASE_ERR_ALLOC;
+        }
+        uref_attach_ubuf(uref, ubuf);
+    }
+
+    struct uref *ref = uref_sibling_alloc(uref);
+    if (unlikely(ref == NULL)) {
+        uref_free(uref);
+        return UBASE_ERR_ALLOC;
+    }
+    if (uref->udict != NULL) {
+        ref->udict = udict_dup(uref->udict);
+        if (unlikely(ref->udict == NULL)) {
+            uref_free(ref);
+            uref_free(uref);
+            return UBASE_ERR_ALLOC;
+        }
+    }
+    uref_free(upipe_net_xfer_src->ref);
+    upipe_net_xfer_src->ref = ref;
+
+    if (unlikely(upipe_net_xfer_src->flow_def == NULL)) {
+        upipe_warn(upipe, "received a uref before the flow definition");
+        uref_free(uref);
+        return UBASE_ERR_NONE;
+    }
+    upipe_net_xfer_src_output(upipe, uref, &upipe_net_xfer_src->upump);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This deserializes all complete frames of the input stream.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_net_xfer_src_work(struct upipe *upipe)
+{
+    struct upipe_net_xfer_src *upipe_net_xfer_src =
+        upipe_net_xfer_src_from_upipe(upipe);
+
+    while (upipe_net_xfer_src->next_uref != NULL) {
+        size_t total;
+        uint8_t buffer[UREF_SERIAL_FRAME_SIZE];
+        if (unlikely(!ubase_check(uref_block_size(
+                            upipe_net_xfer_src->next_uref, &total))))
+            total = 0;
+        if (total < UREF_SERIAL_FRAME_SIZE ||
+            unlikely(!ubase_check(uref_block_extract(
+                        upipe_net_xfer_src->next_uref, 0,
+                        UREF_SERIAL_FRAME_SIZE, buffer))))
+            break;
+
+        enum uref_serial_frame frame;
+        uint32_t header_size, payload_size;
+        if (unlikely(!ubase_check(uref_serial_read_frame(buffer, &frame,
+                            &header_size, &payload_size)))) {
+            /* the stream can't be resynchronized */
+            upipe_err(upipe, "invalid frame, closing connection");
+            upipe_net_xfer_src_close(upipe);
+            upipe_throw_source_end(upipe);
+            return;
+        }
+        if (unlikely((uint64_t)header_size + payload_size >
+                     upipe_net_xfer_src->max_frame_size)) {
+            upipe_err_va(upipe, "frame too large (%"PRIu32" + %"PRIu32
+                         " octets), closing connection",
+                         header_size, payload_size);
+            upipe_net_xfer_src_close(upipe);
+            upipe_throw_source_end(upipe);
+            return;
+        }
+        size_t frame_size =
+            UREF_SERIAL_FRAME_SIZE + (size_t)header_size + payload_size;
+        if (total < frame_size)
+            break;
+
+        int err = upipe_net_xfer_src_frame(upipe, frame, header_size,
+                                           payload_size);
+        if (unlikely(!ubase_check(err)))
+            upipe_warn_va(upipe, "unable to deserialize frame (%s)",
+                          ubase_err_str(err) ?: "unknown");
+
+        if (upipe_net_xfer_src->next_uref == NULL)
+            return;
+        if (total == frame_size) {
+            uref_free(upipe_net_xfer_src->next_uref);
+            upipe_net_xfer_src->next_uref = NULL;
+        } else
+            uref_block_resize(upipe_net_xfer_src->next_uref, frame_size, -1);
+    }
+    upipe_net_xfer_src_grant(upipe);
+}
+
+/** @internal @This reads data from the socket.
+ *
+ * @param upump description structure of the read watcher
+ */
+static void upipe_net_xfer_src_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_net_xfer_src *upipe_net_xfer_src =
+        upipe_net_xfer_src_from_upipe(upipe);
+
+    struct uref *uref = uref_block_alloc(upipe_net_xfer_src->uref_mgr,
+                                         upipe_net_xfer_src->ubuf_mgr,
+                                         READ_SIZE);
+    if (unlikely(uref == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+
+    uint8_t *buffer;
+    int size = -1;
+    if (unlikely(!ubase_check(uref_block_write(uref, 0, &size, &buffer)))) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    ssize_t ret = read(upipe_net_xfer_src->fd, buffer, size);
+    uref_block_unmap(uref, 0);
+
+    if (unlikely(ret == -1)) {
+        uref_free(uref);
+        switch (errno) {
+            case EINTR:
+            case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+            case EWOULDBLOCK:
+#endif
+                /* not an issue, try again later */
+                return;
+            default:
+                break;
+        }
+        upipe_err_va(upipe, "read error from %s (%m)",
+                     upipe_net_xfer_src->uri ?: "socket");
+        upipe_net_xfer_src_close(upipe);
+        upipe_throw_source_end(upipe);
+        return;
+    }
+    if (unlikely(ret == 0)) {
+        uref_free(uref);
+        upipe_notice(upipe, "end of connection");
+        upipe_net_xfer_src_close(upipe);
+        upipe_throw_source_end(upipe);
+        return;
+    }
+    if (ret < size)
+        uref_block_resize(uref, 0, ret);
+
+    if (upipe_net_xfer_src->next_uref == NULL)
+        upipe_net_xfer_src->next_uref = uref;
+    else {
+        struct ubuf *ubuf = uref_detach_ubuf(uref);
+        uref_free(uref);
+        if (unlikely(!ubase_check(uref_block_append(
+                            upipe_net_xfer_src->next_uref, ubuf)))) {
+            ubuf_free(ubuf);
+            upipe_err(upipe, "unable to append buffer, closing connection");
+            upipe_net_xfer_src_close(upipe);
+            upipe_throw_source_end(upipe);
+            return;
+        }
+    }
+
+    upipe_use(upipe);
+    upipe_net_xfer_src_work(upipe);
+    upipe_release(upipe);
+}
+
+/** @internal @This uses a connected socket.
+ *
+ * @param upipe description structure of the pipe
+ * @param fd connected socket
+ * @return an error code
+ */
+static int upipe_net_xfer_src_connected(struct upipe *upipe, int fd)
+{
+    struct upipe_net_xfer_src *upipe_net_xfer_src =
+        upipe_net_xfer_src_from_upipe(upipe);
+    int flags = fcntl(fd, F_GETFL);
+    if (unlikely(flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1)) {
+        upipe_err_va(upipe, "unable to set the socket non-blocking (%m)");
+        close(fd);
+        return UBASE_ERR_EXTERNAL;
+    }
+    upipe_net_xfer_src->fd = fd;
+    /* the initial window is granted at once */
+    upipe_net_xfer_src->credits = upipe_net_xfer_src->window;
+    upipe_net_xfer_src_grant(upipe);
+    return upipe_net_xfer_src_check(upipe, NULL);
+}
+
+/** @internal @This accepts a connection on the listening socket.
+ *
+ * @param upump description structure of the accept watcher
+ */
+static void upipe_net_xfer_src_acceptor(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_net_xfer_src *upipe_net_xfer_src =
+        upipe_net_xfer_src_from_upipe(upipe);
+
+    int fd = accept(upipe_net_xfer_src->listen_fd, NULL, NULL);
+    if (unlikely(fd == -1)) {
+        if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK ||
+            errno == ECONNABORTED)
+            return;
+        upipe_err_va(upipe, "accept error on %s (%m)",
+                     upipe_net_xfer_src->uri);
+        upipe_net_xfer_src_close(upipe);
+        upipe_throw_source_end(upipe);
+        return;
+    }
+
+    /* only one sink is served */
+    upipe_net_xfer_src_set_upump(upipe, NULL);
+    ubase_clean_fd(&upipe_net_xfer_src->listen_fd);
+    upipe_notice_va(upipe, "accepted connection on %s",
+                    upipe_net_xfer_src->uri);
+    upipe_net_xfer_src_connected(upipe, fd);
+}
+
+/** @internal @This checks if the pump may be allocated.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_net_xfer_src_check(struct upipe *upipe,
+                                    struct uref *flow_format)
+{
+    struct upipe_net_xfer_src *upipe_net_xfer_src =
+        upipe_net_xfer_src_from_upipe(upipe);
+    /* the output flow definition is received from the sink */
+    uref_free(flow_format);
+
+    upipe_net_xfer_src_check_upump_mgr(upipe);
+    if (upipe_net_xfer_src->upump_mgr == NULL)
+        return UBASE_ERR_NONE;
+
+    if (upipe_net_xfer_src->uref_mgr == NULL) {
+        upipe_net_xfer_src_require_uref_mgr(upipe);
+        return UBASE_ERR_NONE;
+    }
+
+    if (upipe_net_xfer_src->ubuf_mgr == NULL) {
+        struct uref *flow_format =
+            uref_block_flow_alloc_def(upipe_net_xfer_src->uref_mgr, NULL);
+        if (unlikely(flow_format == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return UBASE_ERR_ALLOC;
+        }
+        uref_block_flow_set_size(flow_format, READ_SIZE);
+        upipe_net_xfer_src_require_ubuf_mgr(upipe, flow_format);
+        return UBASE_ERR_NONE;
+    }
+
+    if (upipe_net_xfer_src->upump != NULL)
+        return UBASE_ERR_NONE;
+
+    struct upump *upump = NULL;
+    if (upipe_net_xfer_src->fd != -1)
+        upump = upump_alloc_fd_read(upipe_net_xfer_src->upump_mgr,
+                                    upipe_net_xfer_src_worker, upipe,
+                                    upipe->refcount, upipe_net_xfer_src->fd);
+    else if (upipe_net_xfer_src->listen_fd != -1)
+        upump = upump_alloc_fd_read(upipe_net_xfer_src->upump_mgr,
+                                    upipe_net_xfer_src_acceptor, upipe,
+                                    upipe->refcount,
+                                    upipe_net_xfer_src->listen_fd);
+    else
+        return UBASE_ERR_NONE;
+    if (unlikely(upump == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+        return UBASE_ERR_UPUMP;
+    }
+    upipe_net_xfer_src_set_upump(upipe, upump);
+    upump_start(upump);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This uses a connected socket given by the application.
+ *
+ * @param upipe description structure of the pipe
+ * @param fd connected socket, or -1
+ * @return an error code
+ */
+static int upipe_net_xfer_src_set_fd_internal(struct upipe *upipe, int fd)
+{
+    struct upipe_net_xfer_src *upipe_net_xfer_src =
+        upipe_net_xfer_src_from_upipe(upipe);
+    upipe_net_xfer_src_close(upipe);
+    ubase_clean_str(&upipe_net_xfer_src->uri);
+    if (fd == -1)
+        return UBASE_ERR_NONE;
+    return upipe_net_xfer_src_connected(upipe, fd);
+}
+
+/** @internal @This listens on the given host:port.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri local host:port
+ * @return an error code
+ */
+static int upipe_net_xfer_src_set_uri(struct upipe *upipe, const char *uri)
+{
+    struct upipe_net_xfer_src *upipe_net_xfer_src =
+        upipe_net_xfer_src_from_upipe(upipe);
+    upipe_net_xfer_src_set_fd_internal(upipe, -1);
+    if (unlikely(uri == NULL))
+        return UBASE_ERR_NONE;
+
+    struct addrinfo *res;
+    int err = upipe_net_xfer_resolve(uri, true, &res);
+    if (unlikely(!ubase_check(err))) {
+        upipe_err_va(upipe, "unable to resolve %s", uri);
+        return err;
+    }
+
+    int fd = -1;
+    for (struct addrinfo *ai = res; ai != NULL; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd == -1)
+            continue;
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, 1) == 0)
+            break;
+        ubase_clean_fd(&fd);
+    }
+    freeaddrinfo(res);
+    if (unlikely(fd == -1)) {
+        upipe_err_va(upipe, "can't listen on %s (%m)", uri);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    int flags = fcntl(fd, F_GETFL);
+    if (unlikely(flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1)) {
+        upipe_err_va(upipe, "unable to set the socket non-blocking (%m)");
+        close(fd);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    upipe_net_xfer_src->uri = strdup(uri);
+    if (unlikely(upipe_net_xfer_src->uri == NULL)) {
+        close(fd);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_net_xfer_src->listen_fd = fd;
+    upipe_notice_va(upipe, "listening on %s", uri);
+    return upipe_net_xfer_src_check(upipe, NULL);
+}
+
+/** @internal @This sets the number of urefs the sink may send ahead.
+ *
+ * @param upipe description structure of the pipe
+ * @param window number of credits
+ * @return an error code
+ */
+static int upipe_net_xfer_src_set_window_internal(struct upipe *upipe,
+                                                  unsigned int window)
+{
+    struct upipe_net_xfer_src *upipe_net_xfer_src =
+        upipe_net_xfer_src_from_upipe(upipe);
+    if (unlikely(!window))
+        return UBASE_ERR_INVALID;
+    /* credits already granted can't be taken back */
+    if (upipe_net_xfer_src->fd != -1 && window > upipe_net_xfer_src->window)
+        upipe_net_xfer_src->credits += window - upipe_net_xfer_src->window;
+    upipe_net_xfer_src->window = window;
+    upipe_net_xfer_src_grant(upipe);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the maximum size of a received frame.
+ *
+ * @param upipe description structure of the pipe
+ * @param max_frame_size maximum size of a frame, in octets
+ * @return an error code
+ */
+static int upipe_net_xfer_src_set_max_frame_size_internal(
+        struct upipe *upipe, unsigned int max_frame_size)
+{
+    struct upipe_net_xfer_src *upipe_net_xfer_src =
+        upipe_net_xfer_src_from_upipe(upipe);
+    /* the frame size must fit in an int for the block functions */
+    if (unlikely(!max_frame_size ||
+                 max_frame_size > INT_MAX - UREF_SERIAL_FRAME_SIZE))
+        return UBASE_ERR_INVALID;
+    upipe_net_xfer_src->max_frame_size = max_frame_size;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a net xfer source pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int _upipe_net_xfer_src_control(struct upipe *upipe, int command,
+                                       va_list args)
+{
+    struct upipe_net_xfer_src *upipe_net_xfer_src =
+        upipe_net_xfer_src_from_upipe(upipe);
+
+    switch (command) {
+        case UPIPE_ATTACH_UPUMP_MGR:
+            upipe_net_xfer_src_set_upump(upipe, NULL);
+            return upipe_net_xfer_src_attach_upump_mgr(upipe);
+
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_net_xfer_src_control_output(upipe, command, args);
+
+        case UPIPE_GET_URI: {
+            const char **uri_p = va_arg(args, const char **);
+            *uri_p = upipe_net_xfer_src->uri;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SET_URI: {
+            const char *uri = va_arg(args, const char *);
+            return upipe_net_xfer_src_set_uri(upipe, uri);
+        }
+
+        case UPIPE_NET_XFER_SRC_SET_FD: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NET_XFER_SRC_SIGNATURE)
+            int fd = va_arg(args, int);
+            return upipe_net_xfer_src_set_fd_internal(upipe, fd);
+        }
+        case UPIPE_NET_XFER_SRC_GET_FD: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NET_XFER_SRC_SIGNATURE)
+            int *fd_p = va_arg(args, int *);
+            *fd_p = upipe_net_xfer_src->fd;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_NET_XFER_SRC_SET_WINDOW: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NET_XFER_SRC_SIGNATURE)
+            unsigned int window = va_arg(args, unsigned int);
+            return upipe_net_xfer_src_set_window_internal(upipe, window);
+        }
+        case UPIPE_NET_XFER_SRC_GET_WINDOW: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NET_XFER_SRC_SIGNATURE)
+            unsigned int *window_p = va_arg(args, unsigned int *);
+            *window_p = upipe_net_xfer_src->window;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_NET_XFER_SRC_SET_MAX_FRAME_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NET_XFER_SRC_SIGNATURE)
+            unsigned int max_frame_size = va_arg(args, unsigned int);
+            return upipe_net_xfer_src_set_max_frame_size_internal(upipe,
+                    max_frame_size);
+        }
+        case UPIPE_NET_XFER_SRC_GET_MAX_FRAME_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NET_XFER_SRC_SIGNATURE)
+            unsigned int *max_frame_size_p = va_arg(args, unsigned int *);
+            *max_frame_size_p = upipe_net_xfer_src->max_frame_size;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This processes control commands on a net xfer source pipe, and
+ * checks the status of the pipe afterwards.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_net_xfer_src_control(struct upipe *upipe, int command,
+                                      va_list args)
+{
+    UBASE_RETURN(_upipe_net_xfer_src_control(upipe, command, args))
+    return upipe_net_xfer_src_check(upipe, NULL);
+}
+
+/** @internal @This frees a net xfer source pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_net_xfer_src_free(struct upipe *upipe)
+{
+    struct upipe_net_xfer_src *upipe_net_xfer_src =
+        upipe_net_xfer_src_from_upipe(upipe);
+    upipe_net_xfer_src_close(upipe);
+    upipe_throw_dead(upipe);
+
+    free(upipe_net_xfer_src->uri);
+    free(upipe_net_xfer_src->scratch);
+    upipe_net_xfer_src_clean_upump(upipe);
+    upipe_net_xfer_src_clean_upump_mgr(upipe);
+    upipe_net_xfer_src_clean_ubuf_mgr(upipe);
+    upipe_net_xfer_src_clean_uref_mgr(upipe);
+    upipe_net_xfer_src_clean_output(upipe);
+    upipe_net_xfer_src_clean_urefcount(upipe);
+    upipe_net_xfer_src_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_net_xfer_src_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_NET_XFER_SRC_SIGNATURE,
+
+    .upipe_alloc = upipe_net_xfer_src_alloc,
+    .upipe_input = NULL,
+    .upipe_control = upipe_net_xfer_src_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all net xfer source pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_net_xfer_src_mgr_alloc(void)
+{
+    return &upipe_net_xfer_src_mgr;
+}
@@ -0,0 +1,386 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe byte-swap and PCM conversion kernels
+ */
+
+#include "upipe_pcm_convert.h"
+
+#if defined(__i686__) || defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/* The vector variants process the remaining words or samples with the
+ * scalar loops below. Loads never read past the end of the source. */
+
+/** @This swaps the bytes of 16-bit words, one at a time.
+ *
+ * @param dst destination words
+ * @param src source words
+ * @param words number of words
+ */
+void upipe_pcm_bswap16_c(uint8_t *dst, const uint8_t *src, size_t words)
+{
+    for (size_t i = 0; i < words; i++) {
+        uint8_t t = src[2 * i];
+        dst[2 * i] = src[2 * i + 1];
+        dst[2 * i + 1] = t;
+    }
+}
+
+/** @This converts s16be samples to native s32 samples, one at a time.
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+void upipe_pcm_s16be_to_s32_c(int32_t *dst, const uint8_t *src,
+                              size_t samples)
+{
+    for (size_t i = 0; i < samples; i++)
+        dst[i] = (int32_t)(((uint32_t)src[2 * i] << 24) |
+                           ((uint32_t)src[2 * i + 1] << 16));
+}
+
+/** @This converts s24be samples to native s32 samples, one at a time.
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+void upipe_pcm_s24be_to_s32_c(int32_t *dst, const uint8_t *src,
+                              size_t samples)
+{
+    for (size_t i = 0; i < samples; i++)
+        dst[i] = (int32_t)(((uint32_t)src[3 * i] << 24) |
+                           ((uint32_t)src[3 * i + 1] << 16) |
+                           ((uint32_t)src[3 * i + 2] << 8));
+}
+
+/** @This converts s32be samples to native s32 samples, one at a time.
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+void upipe_pcm_s32be_to_s32_c(int32_t *dst, const uint8_t *src,
+                              size_t samples)
+{
+    for (size_t i = 0; i < samples; i++)
+        dst[i] = (int32_t)(((uint32_t)src[4 * i] << 24) |
+                           ((uint32_t)src[4 * i + 1] << 16) |
+                           ((uint32_t)src[4 * i + 2] << 8) |
+                           (uint32_t)src[4 * i + 3]);
+}
+
+#if defined(__i686__) || defined(__x86_64__)
+/** @This swaps the bytes of 16-bit words, 8 at a time (SSSE3).
+ *
+ * @param dst destination words
+ * @param src source words
+ * @param words number of words
+ */
+__attribute__((target("ssse3")))
+void upipe_pcm_bswap16_ssse3(uint8_t *dst, const uint8_t *src, size_t words)
+{
+    const __m128i shuf = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6,
+                                       9, 8, 11, 10, 13, 12, 15, 14);
+    size_t i;
+    for (i = 0; i + 8 <= words; i += 8) {
+        __m128i c = _mm_loadu_si128((const __m128i *)(src + 2 * i));
+        _mm_storeu_si128((__m128i *)(dst + 2 * i), _mm_shuffle_epi8(c, shuf));
+    }
+    upipe_pcm_bswap16_c(dst + 2 * i, src + 2 * i, words - i);
+}
+
+/** @This converts s16be samples to native s32 samples, 8 at a time (SSSE3).
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+__attribute__((target("ssse3")))
+void upipe_pcm_s16be_to_s32_ssse3(int32_t *dst, const uint8_t *src,
+                                  size_t samples)
+{
+    const __m128i shuf_lo = _mm_setr_epi8(-1, -1, 1, 0, -1, -1, 3, 2,
+                                          -1, -1, 5, 4, -1, -1, 7, 6);
+    const __m128i shuf_hi = _mm_setr_epi8(-1, -1, 9, 8, -1, -1, 11, 10,
+                                          -1, -1, 13, 12, -1, -1, 15, 14);
+    size_t i;
+    for (i = 0; i + 8 <= samples; i += 8) {
+        __m128i c = _mm_loadu_si128((const __m128i *)(src + 2 * i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi8(c, shuf_lo));
+        _mm_storeu_si128((__m128i *)(dst + i + 4),
+                         _mm_shuffle_epi8(c, shuf_hi));
+    }
+    upipe_pcm_s16be_to_s32_c(dst + i, src + 2 * i, samples - i);
+}
+
+/** @This converts s24be samples to native s32 samples, 4 at a time (SSSE3).
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+__attribute__((target("ssse3")))
+void upipe_pcm_s24be_to_s32_ssse3(int32_t *dst, const uint8_t *src,
+                                  size_t samples)
+{
+    const __m128i shuf = _mm_setr_epi8(-1, 2, 1, 0, -1, 5, 4, 3,
+                                       -1, 8, 7, 6, -1, 11, 10, 9);
+    size_t i;
+    /* each load reads 16 bytes and uses 12, so keep 2 samples of margin */
+    for (i = 0; i + 6 <= samples; i += 4) {
+        __m128i c = _mm_loadu_si128((const __m128i *)(src + 3 * i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi8(c, shuf));
+    }
+    upipe_pcm_s24be_to_s32_c(dst + i, src + 3 * i, samples - i);
+}
+
+/** @This converts s32be samples to native s32 samples, 4 at a time (SSSE3).
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+__attribute__((target("ssse3")))
+void upipe_pcm_s32be_to_s32_ssse3(int32_t *dst, const uint8_t *src,
+                                  size_t samples)
+{
+    const __m128i shuf = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,
+                                       11, 10, 9, 8, 15, 14, 13, 12);
+    size_t i;
+    for (i = 0; i + 4 <= samples; i += 4) {
+        __m128i c = _mm_loadu_si128((const __m128i *)(src + 4 * i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi8(c, shuf));
+    }
+    upipe_pcm_s32be_to_s32_c(dst + i, src + 4 * i, samples - i);
+}
+
+/** @This swaps the bytes of 16-bit words, 16 at a time (AVX2).
+ *
+ * @param dst destination words
+ * @param src source words
+ * @param words number of words
+ */
+__attribute__((target("avx2")))
+void upipe_pcm_bswap16_avx2(uint8_t *dst, const uint8_t *src, size_t words)
+{
+    const __m256i shuf = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6,
+                                          9, 8, 11, 10, 13, 12, 15, 14,
+                                          1, 0, 3, 2, 5, 4, 7, 6,
+                                          9, 8, 11, 10, 13, 12, 15, 14);
+    size_t i;
+    for (i = 0; i + 16 <= words; i += 16) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(src + 2 * i));
+        _mm256_storeu_si256((__m256i *)(dst + 2 * i),
+                            _mm256_shuffle_epi8(c, shuf));
+    }
+    upipe_pcm_bswap16_c(dst + 2 * i, src + 2 * i, words - i);
+}
+
+/** @This converts s16be samples to native s32 samples, 8 at a time (AVX2).
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+__attribute__((target("avx2")))
+void upipe_pcm_s16be_to_s32_avx2(int32_t *dst, const uint8_t *src,
+                                 size_t samples)
+{
+    /* zero-extended words have their bytes at 0 and 1 of each dword */
+    const __m256i shuf = _mm256_setr_epi8(-1, -1, 1, 0, -1, -1, 5, 4,
+                                          -1, -1, 9, 8, -1, -1, 13, 12,
+                                          -1, -1, 1, 0, -1, -1, 5, 4,
+                                          -1, -1, 9, 8, -1, -1, 13, 12);
+    size_t i;
+    for (i = 0; i + 8 <= samples; i += 8) {
+        __m128i c = _mm_loadu_si128((const __m128i *)(src + 2 * i));
+        _mm256_storeu_si256((__m256i *)(dst + i),
+            _mm256_shuffle_epi8(_mm256_cvtepu16_epi32(c), shuf));
+    }
+    upipe_pcm_s16be_to_s32_c(dst + i, src + 2 * i, samples - i);
+}
+
+/** @This converts s24be samples to native s32 samples, 8 at a time (AVX2).
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+__attribute__((target("avx2")))
+void upipe_pcm_s24be_to_s32_avx2(int32_t *dst, const uint8_t *src,
+                                 size_t samples)
+{
+    /* move bytes 12..23 to the upper lane */
+    const __m256i perm = _mm256_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0);
+    const __m256i shuf = _mm256_setr_epi8(-1, 2, 1, 0, -1, 5, 4, 3,
+                                          -1, 8, 7, 6, -1, 11, 10, 9,
+                                          -1, 2, 1, 0, -1, 5, 4, 3,
+                                          -1, 8, 7, 6, -1, 11, 10, 9);
+    size_t i;
+    /* each load reads 32 bytes and uses 24, so keep 3 samples of margin */
+    for (i = 0; i + 11 <= samples; i += 8) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(src + 3 * i));
+        c = _mm256_permutevar8x32_epi32(c, perm);
+        _mm256_storeu_si256((__m256i *)(dst + i),
+                            _mm256_shuffle_epi8(c, shuf));
+    }
+    upipe_pcm_s24be_to_s32_c(dst + i, src + 3 * i, samples - i);
+}
+
+/** @This converts s32be samples to native s32 samples, 8 at a time (AVX2).
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+__attribute__((target("avx2")))
+void upipe_pcm_s32be_to_s32_avx2(int32_t *dst, const uint8_t *src,
+                                 size_t samples)
+{
+    const __m256i shuf = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,
+                                          11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4,
+                                          11, 10, 9, 8, 15, 14, 13, 12);
+    size_t i;
+    for (i = 0; i + 8 <= samples; i += 8) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(src + 4 * i));
+        _mm256_storeu_si256((__m256i *)(dst + i),
+                            _mm256_shuffle_epi8(c, shuf));
+    }
+    upipe_pcm_s32be_to_s32_c(dst + i, src + 4 * i, samples - i);
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/** @This swaps the bytes of 16-bit words, 8 at a time (NEON).
+ *
+ * @param dst destination words
+ * @param src source words
+ * @param words number of words
+ */
+void upipe_pcm_bswap16_neon(uint8_t *dst, const uint8_t *src, size_t words)
+{
+    size_t i;
+    for (i = 0; i + 8 <= words; i += 8)
+        vst1q_u8(dst + 2 * i, vrev16q_u8(vld1q_u8(src + 2 * i)));
+    upipe_pcm_bswap16_c(dst + 2 * i, src + 2 * i, words - i);
+}
+
+/** @This converts s16be samples to native s32 samples, 8 at a time (NEON).
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+void upipe_pcm_s16be_to_s32_neon(int32_t *dst, const uint8_t *src,
+                                 size_t samples)
+{
+    size_t i;
+    for (i = 0; i + 8 <= samples; i += 8) {
+        int16x8_t c = vreinterpretq_s16_u8(vrev16q_u8(vld1q_u8(src + 2 * i)));
+        vst1q_s32(dst + i, vshll_n_s16(vget_low_s16(c), 16));
+        vst1q_s32(dst + i + 4, vshll_high_n_s16(c, 16));
+    }
+    upipe_pcm_s16be_to_s32_c(dst + i, src + 2 * i, samples - i);
+}
+
+/** @This converts s24be samples to native s32 samples, 8 at a time (NEON).
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+void upipe_pcm_s24be_to_s32_neon(int32_t *dst, const uint8_t *src,
+                                 size_t samples)
+{
+    size_t i;
+    for (i = 0; i + 8 <= samples; i += 8) {
+        uint8x8x3_t c = vld3_u8(src + 3 * i);
+        uint16x8_t hi = vorrq_u16(vshll_n_u8(c.val[0], 8), vmovl_u8(c.val[1]));
+        uint16x8_t lo = vshll_n_u8(c.val[2], 8);
+        vst1q_s32(dst + i, vreinterpretq_s32_u16(vzip1q_u16(lo, hi)));
+        vst1q_s32(dst + i + 4, vreinterpretq_s32_u16(vzip2q_u16(lo, hi)));
+    }
+    upipe_pcm_s24be_to_s32_c(dst + i, src + 3 * i, samples - i);
+}
+
+/** @This converts s32be samples to native s32 samples, 4 at a time (NEON).
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+void upipe_pcm_s32be_to_s32_neon(int32_t *dst, const uint8_t *src,
+                                 size_t samples)
+{
+    size_t i;
+    for (i = 0; i + 4 <= samples; i += 4) {
+        uint8x16_t c = vrev32q_u8(vld1q_u8(src + 4 * i));
+        vst1q_s32(dst + i, vreinterpretq_s32_u8(c));
+    }
+    upipe_pcm_s32be_to_s32_c(dst + i, src + 4 * i, samples - i);
+}
+#endif
+
+/** @This defines the function picking the fastest variant of a kernel.
+ *
+ * @param name name of the kernel
+ * @param dst_type type of the destination
+ * @param count name of the count argument
+ */
+#define UPIPE_PCM_DISPATCH(name, dst_type, count)                           \
+void upipe_pcm_##name(dst_type *dst, const uint8_t *src, size_t count)      \
+{                                                                           \
+    UPIPE_PCM_DISPATCH_ARCH(name, dst, src, count)                          \
+    upipe_pcm_##name##_c(dst, src, count);                                  \
+}
+
+#if defined(__i686__) || defined(__x86_64__)
+#define UPIPE_PCM_DISPATCH_ARCH(name, dst, src, count)                      \
+    if (__builtin_cpu_supports("avx2")) {                                   \
+        upipe_pcm_##name##_avx2(dst, src, count);                           \
+        return;                                                             \
+    }                                                                       \
+    if (__builtin_cpu_supports("ssse3")) {                                  \
+        upipe_pcm_##name##_ssse3(dst, src, count);                          \
+        return;                                                             \
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define UPIPE_PCM_DISPATCH_ARCH(name, dst, src, count)                      \
+    upipe_pcm_##name##_neon(dst, src, count);                               \
+    return;
+#else
+#define UPIPE_PCM_DISPATCH_ARCH(name, dst, src, count)
+#endif
+
+UPIPE_PCM_DISPATCH(bswap16, uint8_t, words)
+UPIPE_PCM_DISPATCH(s16be_to_s32, int32_t, samples)
+UPIPE_PCM_DISPATCH(s24be_to_s32, int32_t, samples)
+UPIPE_PCM_DISPATCH(s32be_to_s32, int32_t, samples)
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe byte-swap and PCM conversion kernels
+ * The variants below are called by the upipe_pcm_* functions, which pick the
+ * fastest one supported by the CPU. They are exported for checkasm.
+ *
+ * The s16be, s24be and s32be kernels convert big-endian (network order)
+ * samples to native s32 samples, with the significant bits at the top.
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_PCM_CONVERT_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_PCM_CONVERT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** @This swaps the bytes of 16-bit words. dst may be equal to src.
+ *
+ * @param dst destination words
+ * @param src source words
+ * @param words number of words
+ */
+typedef void (*upipe_pcm_bswap16_func)(uint8_t *dst, const uint8_t *src,
+                                       size_t words);
+
+/** @This converts big-endian samples to native s32 samples.
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+typedef void (*upipe_pcm_to_s32_func)(int32_t *dst, const uint8_t *src,
+                                      size_t samples);
+
+/** @This swaps the bytes of 16-bit words, using the fastest variant
+ * supported by the CPU. dst may be equal to src.
+ *
+ * @param dst destination words
+ * @param src source words
+ * @param words number of words
+ */
+void upipe_pcm_bswap16(uint8_t *dst, const uint8_t *src, size_t words);
+
+/** @This converts s16be samples to native s32 samples, using the fastest
+ * variant supported by the CPU.
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+void upipe_pcm_s16be_to_s32(int32_t *dst, const uint8_t *src, size_t samples);
+
+/** @This converts s24be samples to native s32 samples, using the fastest
+ * variant supported by the CPU.
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+void upipe_pcm_s24be_to_s32(int32_t *dst, const uint8_t *src, size_t samples);
+
+/** @This converts s32be samples to native s32 samples, using the fastest
+ * variant supported by the CPU.
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+void upipe_pcm_s32be_to_s32(int32_t *dst, const uint8_t *src, size_t samples);
+
+/* one word or sample at a time */
+void upipe_pcm_bswap16_c(uint8_t *dst, const uint8_t *src, size_t words);
+void upipe_pcm_s16be_to_s32_c(int32_t *dst, const uint8_t *src,
+                              size_t samples);
+void upipe_pcm_s24be_to_s32_c(int32_t *dst, const uint8_t *src,
+                              size_t samples);
+void upipe_pcm_s32be_to_s32_c(int32_t *dst, const uint8_t *src,
+                              size_t samples);
+
+#if defined(__i686__) || defined(__x86_64__)
+/* 8 (bswap16) or 4 samples at a time */
+void upipe_pcm_bswap16_ssse3(uint8_t *dst, const uint8_t *src, size_t words);
+void upipe_pcm_s16be_to_s32_ssse3(int32_t *dst, const uint8_t *src,
+                                  size_t samples);
+void upipe_pcm_s24be_to_s32_ssse3(int32_t *dst, const uint8_t *src,
+                                  size_t samples);
+void upipe_pcm_s32be_to_s32_ssse3(int32_t *dst, const uint8_t *src,
+                                  size_t samples);
+
+/* 16 (bswap16) or 8 samples at a time */
+void upipe_pcm_bswap16_avx2(uint8_t *dst, const uint8_t *src, size_t words);
+void upipe_pcm_s16be_to_s32_avx2(int32_t *dst, const uint8_t *src,
+                                 size_t samples);
+void upipe_pcm_s24be_to_s32_avx2(int32_t *dst, const uint8_t *src,
+                                 size_t samples);
+void upipe_pcm_s32be_to_s32_avx2(int32_t *dst, const uint8_t *src,
+                                 size_t samples);
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/* 8 (bswap16, s16be, s24be) or 4 (s32be) samples at a time */
+void upipe_pcm_bswap16_neon(uint8_t *dst, const uint8_t *src, size_t words);
+void upipe_pcm_s16be_to_s32_neon(int32_t *dst, const uint8_t *src,
+                                 size_t samples);
+void upipe_pcm_s24be_to_s32_neon(int32_t *dst, const uint8_t *src,
+                                 size_t samples);
+void upipe_pcm_s32be_to_s32_neon(int32_t *dst, const uint8_t *src,
+                                 size_t samples);
+#endif
+
+#endif
@@ -29,10 +29,15 @@
 
 #include <upipe/ubase.h>
 #include <upipe/uqueue.h>
+#include <upipe/uclock.h>
 #include <upipe/upipe.h>
 
 #include <assert.h>
 
+/** @internal @This is the maximum number of urefs moved through the queue
+ * in one batch. */
+#define UPIPE_QUEUE_BATCH 32
+
 /** @internal @This is the structure exported from source to sinks. */
 struct upipe_queue {
     /** max length of the queue */
@@ -59,6 +64,24 @@ static inline struct upipe_queue *upipe_queue(struct upipe *upipe)
     return container_of(upipe, struct upipe_queue, upipe);
 }
 
+/** @internal @This sets the wait policy of the consumer of a queue.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param spin time (in 27 MHz ticks) to busy-poll the queue
+ * @param yields number of times to yield the CPU before blocking
+ * @return an error code
+ */
+static inline int upipe_queue_set_wait_policy(struct uqueue *uqueue,
+                                              uint64_t spin,
+                                              unsigned int yields)
+{
+    if (unlikely(spin > UCLOCK_FREQ))
+        return UBASE_ERR_INVALID;
+    uqueue_set_wait_policy(uqueue, spin * UINT64_C(1000000000) / UCLOCK_FREQ,
+                           yields);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This is a super-set of @ref urequest. */
 struct upipe_queue_request {
     /** refcount management structure */
@@ -51,6 +51,7 @@
 #include <stdint.h>
 #include <stdarg.h>
 #include <string.h>
+#include <inttypes.h>
 #include <assert.h>
 
 /** @hidden */
@@ -72,6 +73,8 @@ struct upipe_qsink {
     struct upump *upump;
     /** oob watcher */
     struct upump *upump_oob;
+    /** watcher waiting for the queue to drain to the low watermark */
+    struct upump *upump_wm;
 
     /** pseudo-output */
     struct upipe *output;
@@ -93,6 +96,19 @@ struct upipe_qsink {
     /** list of blockers */
     struct uchain blockers;
 
+    /** depth of the queue at which upstream pumps are blocked, or 0 */
+    unsigned int high_mark;
+    /** depth of the queue at which upstream pumps are released */
+    unsigned int low_mark;
+    /** list of blockers set on the high watermark */
+    struct uchain wm_blockers;
+    /** date at which upstream pumps were blocked (in ns), or 0 */
+    uint64_t blocked_since;
+    /** cumulated time spent blocked on the high watermark (in ns) */
+    uint64_t blocked_time;
+    /** number of times upstream pumps were blocked on the high watermark */
+    uint64_t nb_blocks;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -102,6 +118,7 @@ UPIPE_HELPER_UREFCOUNT(upipe_qsink, urefcount, upipe_qsink_free)
 UPIPE_HELPER_UPUMP_MGR(upipe_qsink, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_qsink, upump, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_qsink, upump_oob, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_qsink, upump_wm, upump_mgr)
 UPIPE_HELPER_INPUT(upipe_qsink, urefs, nb_urefs, max_urefs, blockers, upipe_qsink_output)
 
 /** @internal @This allocates a queue sink pipe.
@@ -132,7 +149,14 @@ static struct upipe *_upipe_qsink_alloc(struct upipe_mgr *mgr,
     upipe_qsink_init_upump_mgr(upipe);
     upipe_qsink_init_upump(upipe);
     upipe_qsink_init_upump_oob(upipe);
+    upipe_qsink_init_upump_wm(upipe);
     upipe_qsink_init_input(upipe);
+    upipe_qsink->high_mark = 0;
+    upipe_qsink->low_mark = 0;
+    ulist_init(&upipe_qsink->wm_blockers);
+    upipe_qsink->blocked_since = 0;
+    upipe_qsink->blocked_time = 0;
+    upipe_qsink->nb_blocks = 0;
     upipe_qsink->qsrc = upipe_use(qsrc);
     upipe_qsink->flow_def = NULL;
     upipe_qsink->flow_def_sent = false;
@@ -159,10 +183,43 @@ static bool upipe_qsink_output(struct upipe *upipe, struct uref *uref,
                                struct upump **upump_p)
 {
     struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
+    uref_share(uref);
     return uqueue_push(&upipe_queue(upipe_qsink->qsrc)->uqueue,
                        uref_to_uchain(uref));
 }
 
+/** @internal @This outputs the held urefs to the queue, in batches.
+ *
+ * @param upipe description structure of the pipe
+ * @return true if all urefs could be output
+ */
+static bool upipe_qsink_output_held(struct upipe *upipe)
+{
+    struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
+    struct uqueue *uqueue = &upipe_queue(upipe_qsink->qsrc)->uqueue;
+    void *elements[UPIPE_QUEUE_BATCH];
+
+    for ( ; ; ) {
+        unsigned int nb = 0;
+        struct uref *uref;
+        while (nb < UPIPE_QUEUE_BATCH &&
+               (uref = upipe_qsink_pop_input(upipe)) != NULL) {
+            uref_share(uref);
+            elements[nb++] = uref_to_uchain(uref);
+        }
+        if (!nb)
+            return true;
+
+        unsigned int pushed = uqueue_push_batch(uqueue, elements, nb);
+        if (pushed < nb) {
+            while (nb > pushed)
+                upipe_qsink_unshift_input(upipe,
+                        uref_from_uchain((struct uchain *)elements[--nb]));
+            return false;
+        }
+    }
+}
+
 /** @internal @This is called when the queue can be written again.
  * Unblock the sink.
  *
@@ -171,7 +228,7 @@ static bool upipe_qsink_output(struct upipe *upipe, struct uref *uref,
 static void upipe_qsink_watcher(struct upump *upump)
 {
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
-    upipe_qsink_output_input(upipe);
+    upipe_qsink_output_held(upipe);
     upipe_qsink_unblock_input(upipe);
     if (upipe_qsink_check_input(upipe)) {
         upump_stop(upump);
@@ -210,6 +267,188 @@ static bool upipe_qsink_check_watcher(struct upipe *upipe)
     return true;
 }
 
+/** @internal @This is called when a pump blocked on the high watermark is
+ * released by its owner.
+ *
+ * @param blocker description structure of the blocker
+ */
+static void upipe_qsink_wm_block_cb(struct upump_blocker *blocker)
+{
+    ulist_delete(upump_blocker_to_uchain(blocker));
+    upump_blocker_free(blocker);
+}
+
+/** @internal @This releases the pumps blocked on the high watermark.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_qsink_wm_unblock(struct upipe *upipe)
+{
+    struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&upipe_qsink->wm_blockers, uchain, uchain_tmp) {
+        ulist_delete(uchain);
+        upump_blocker_free(upump_blocker_from_uchain(uchain));
+    }
+
+    if (upipe_qsink->blocked_since) {
+        upipe_qsink->blocked_time += uqueue_now_ns() -
+                                     upipe_qsink->blocked_since;
+        upipe_qsink->blocked_since = 0;
+        /* the push eventfd is set again whenever the queue is not full */
+        struct uqueue *uqueue = &upipe_queue(upipe_qsink->qsrc)->uqueue;
+        if (uqueue_length(uqueue) < uqueue->length)
+            ueventfd_write(&uqueue->event_push);
+    }
+    if (upipe_qsink->upump_wm != NULL)
+        upump_stop(upipe_qsink->upump_wm);
+}
+
+/** @internal @This checks whether the queue drained to the low watermark.
+ * Otherwise the push eventfd is cleared, so that the next trigger comes from
+ * the queue source popping down to the low watermark.
+ *
+ * @param upipe description structure of the pipe
+ * @return true if the queue drained to the low watermark
+ */
+static bool upipe_qsink_wm_drained(struct upipe *upipe)
+{
+    struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
+    struct uqueue *uqueue = &upipe_queue(upipe_qsink->qsrc)->uqueue;
+    if ((int32_t)uqueue_length(uqueue) <= (int32_t)upipe_qsink->low_mark)
+        return true;
+
+    ueventfd_read(&uqueue->event_push);
+    /* double-check */
+    if (likely((int32_t)uqueue_length(uqueue) >
+               (int32_t)upipe_qsink->low_mark))
+        return false;
+    ueventfd_write(&uqueue->event_push);
+    return true;
+}
+
+/** @internal @This is called when the push eventfd of the queue is
+ * triggered while upstream pumps are blocked on the high watermark, to
+ * release them once the queue has drained.
+ *
+ * @param upump description structure of the watcher
+ */
+static void upipe_qsink_wm_watcher(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
+    if (!ulist_empty(&upipe_qsink->wm_blockers) &&
+        !upipe_qsink_wm_drained(upipe))
+        /* the queue was full and can be written again */
+        return;
+
+    upipe_verbose_va(upipe, "queue drained to %u, unblocking",
+            uqueue_length(&upipe_queue(upipe_qsink->qsrc)->uqueue));
+    upipe_qsink_wm_unblock(upipe);
+}
+
+/** @internal @This blocks the given source pump if the depth of the queue
+ * reached the high watermark.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_qsink_wm_check(struct upipe *upipe, struct upump **upump_p)
+{
+    struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
+    if (likely(!upipe_qsink->high_mark) || upump_p == NULL ||
+        *upump_p == NULL ||
+        uqueue_length(&upipe_queue(upipe_qsink->qsrc)->uqueue) <
+            upipe_qsink->high_mark ||
+        upump_blocker_find(&upipe_qsink->wm_blockers, *upump_p) != NULL)
+        return;
+
+    if (upipe_qsink->upump_wm == NULL) {
+        upipe_qsink_check_upump_mgr(upipe);
+        if (upipe_qsink->upump_mgr == NULL)
+            return;
+
+        struct upump *upump =
+            uqueue_upump_alloc_push(&upipe_queue(upipe_qsink->qsrc)->uqueue,
+                                    upipe_qsink->upump_mgr,
+                                    upipe_qsink_wm_watcher, upipe,
+                                    upipe->refcount);
+        if (unlikely(upump == NULL)) {
+            upipe_warn(upipe, "can't create watermark watcher");
+            return;
+        }
+        upipe_qsink_set_upump_wm(upipe, upump);
+    }
+
+    struct upump_blocker *blocker = upump_blocker_alloc(*upump_p,
+            upipe_qsink_wm_block_cb, upipe, upipe->refcount);
+    if (unlikely(blocker == NULL))
+        return;
+    ulist_add(&upipe_qsink->wm_blockers, upump_blocker_to_uchain(blocker));
+
+    if (!upipe_qsink->blocked_since) {
+        upipe_verbose(upipe, "high watermark reached, blocking");
+        upipe_qsink->blocked_since = uqueue_now_ns();
+        upipe_qsink->nb_blocks++;
+        if (upipe_qsink_wm_drained(upipe))
+            /* the queue source was faster */
+            upipe_qsink_wm_unblock(upipe);
+        else
+            upump_start(upipe_qsink->upump_wm);
+    }
+}
+
+/** @internal @This sets the watermarks of the queue.
+ *
+ * @param upipe description structure of the pipe
+ * @param high_mark depth at which upstream pumps are blocked, or 0
+ * @param low_mark depth at which upstream pumps are released
+ * @return an error code
+ */
+static int _upipe_qsink_set_watermarks(struct upipe *upipe,
+                                       unsigned int high_mark,
+                                       unsigned int low_mark)
+{
+    struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
+    if (high_mark &&
+        (low_mark >= high_mark ||
+         high_mark > upipe_queue(upipe_qsink->qsrc)->max_length))
+        return UBASE_ERR_INVALID;
+
+    upipe_qsink->high_mark = high_mark;
+    upipe_qsink->low_mark = low_mark;
+    uqueue_set_low_mark(&upipe_queue(upipe_qsink->qsrc)->uqueue,
+                        high_mark ? low_mark : UINT32_MAX);
+    if (!high_mark)
+        upipe_qsink_wm_unblock(upipe);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the backpressure statistics of the queue.
+ *
+ * @param upipe description structure of the pipe
+ * @param stats filled in with the statistics
+ * @return an error code
+ */
+static int _upipe_qsink_get_stats(struct upipe *upipe,
+                                  struct upipe_qsink_stats *stats)
+{
+    struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
+    assert(stats != NULL);
+    int32_t depth = uqueue_length(&upipe_queue(upipe_qsink->qsrc)->uqueue);
+    uint64_t blocked_time = upipe_qsink->blocked_time;
+    if (upipe_qsink->blocked_since)
+        blocked_time += uqueue_now_ns() - upipe_qsink->blocked_since;
+
+    stats->depth = depth > 0 ? depth : 0;
+    stats->high_mark = upipe_qsink->high_mark;
+    stats->low_mark = upipe_qsink->low_mark;
+    stats->blocked = upipe_qsink->blocked_since != 0;
+    stats->nb_blocks = upipe_qsink->nb_blocks;
+    stats->blocked_time = blocked_time * UCLOCK_FREQ / UINT64_C(1000000000);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This receives data.
  *
  * @param upipe description structure of the pipe
@@ -233,7 +472,9 @@ static void upipe_qsink_input(struct upipe *upipe, struct uref *uref,
     if (!upipe_qsink_check_input(upipe)) {
         upipe_qsink_hold_input(upipe, uref);
         upipe_qsink_block_input(upipe, upump_p);
-    } else if (!upipe_qsink_output(upipe, uref, upump_p)) {
+    } else if (likely(upipe_qsink_output(upipe, uref, upump_p)))
+        upipe_qsink_wm_check(upipe, upump_p);
+    else {
         if (!upipe_qsink_check_watcher(upipe)) {
             upipe_warn(upipe, "unable to spool uref");
             uref_free(uref);
@@ -314,6 +555,7 @@ static int upipe_qsink_set_flow_def(struct upipe *upipe, struct uref *uref)
  */
 static int upipe_qsink_flush(struct upipe *upipe)
 {
+    upipe_qsink_wm_unblock(upipe);
     if (upipe_qsink_flush_input(upipe)) {
         struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
         upump_stop(upipe_qsink->upump);
@@ -494,6 +736,8 @@ static int _upipe_qsink_control(struct upipe *upipe, int command, va_list args)
             return upipe_qsink_unregister_request(upipe, request);
         }
         case UPIPE_ATTACH_UPUMP_MGR:
+            upipe_qsink_wm_unblock(upipe);
+            upipe_qsink_set_upump_wm(upipe, NULL);
             upipe_qsink_set_upump(upipe, NULL);
             return upipe_qsink_attach_upump_mgr(upipe);
         case UPIPE_GET_OUTPUT: {
@@ -520,6 +764,27 @@ static int _upipe_qsink_control(struct upipe *upipe, int command, va_list args)
 
         case UPIPE_FLUSH:
             return upipe_qsink_flush(upipe);
+
+        case UPIPE_QSINK_SET_WAIT_POLICY: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_QSINK_SIGNATURE)
+            struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
+            uint64_t spin = va_arg(args, uint64_t);
+            unsigned int yields = va_arg(args, unsigned int);
+            return upipe_queue_set_wait_policy(
+                    &upipe_queue(upipe_qsink->qsrc)->uqueue, spin, yields);
+        }
+        case UPIPE_QSINK_SET_WATERMARKS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_QSINK_SIGNATURE)
+            unsigned int high_mark = va_arg(args, unsigned int);
+            unsigned int low_mark = va_arg(args, unsigned int);
+            return _upipe_qsink_set_watermarks(upipe, high_mark, low_mark);
+        }
+        case UPIPE_QSINK_GET_STATS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_QSINK_SIGNATURE)
+            struct upipe_qsink_stats *stats =
+                va_arg(args, struct upipe_qsink_stats *);
+            return _upipe_qsink_get_stats(upipe, stats);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -556,6 +821,11 @@ static void upipe_qsink_free(struct upipe *upipe)
 
     /* play source end */
     upipe_notice_va(upipe, "ending queue source %p", upipe_qsink->qsrc);
+    upipe_qsink_wm_unblock(upipe);
+    upipe_qsink_clean_upump_wm(upipe);
+    if (upipe_qsink->high_mark)
+        uqueue_set_low_mark(&upipe_queue(upipe_qsink->qsrc)->uqueue,
+                            UINT32_MAX);
     upipe_qsink_push_downstream(upipe, UPIPE_QUEUE_DOWNSTREAM_SOURCE_END, NULL);
     upipe_release(upipe_qsink->qsrc);
 
@@ -167,7 +167,7 @@ static void upipe_qsrc_input(struct upipe *upipe, struct uref *uref,
     upipe_qsrc_output(upipe, uref, upump_p);
 }
 
-/** @internal @This reads data from the queue and outputs it.
+/** @internal @This reads a batch of data from the queue and outputs it.
  *
  * @param upump description structure of the read watcher
  */
@@ -175,9 +175,16 @@ static void upipe_qsrc_worker(struct upump *upump)
 {
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     struct upipe_qsrc *upipe_qsrc = upipe_qsrc_from_upipe(upipe);
-    struct uref *uref = uqueue_pop(&upipe_queue(upipe)->uqueue, struct uref *);
-    if (likely(uref != NULL))
-        upipe_qsrc_input(upipe, uref, &upipe_qsrc->upump);
+    void *elements[UPIPE_QUEUE_BATCH];
+    upipe_stats_queue(upipe, uqueue_length(&upipe_queue(upipe)->uqueue));
+    unsigned int nb = uqueue_pop_batch(&upipe_queue(upipe)->uqueue, elements,
+                                       UPIPE_QUEUE_BATCH);
+    /* the downstream pipes may release us in the middle of the batch */
+    upipe_use(upipe);
+    for (unsigned int i = 0; i < nb; i++)
+        upipe_qsrc_input(upipe, (struct uref *)elements[i],
+                         &upipe_qsrc->upump);
+    upipe_release(upipe);
 }
 
 /** @internal @This handles the result of a request.
@@ -408,6 +415,13 @@ static int _upipe_qsrc_control(struct upipe *upipe, int command, va_list args)
             unsigned int *length_p = va_arg(args, unsigned int *);
             return _upipe_qsrc_get_length(upipe, length_p);
         }
+        case UPIPE_QSRC_SET_WAIT_POLICY: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_QSRC_SIGNATURE)
+            uint64_t spin = va_arg(args, uint64_t);
+            unsigned int yields = va_arg(args, unsigned int);
+            return upipe_queue_set_wait_policy(&upipe_queue(upipe)->uqueue,
+                                               spin, yields);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
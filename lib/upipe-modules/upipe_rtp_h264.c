@@ -24,6 +24,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <upipe/upipe.h>
 #include <upipe/uclock.h>
@@ -38,24 +39,18 @@
 #include <upipe/upipe_helper_flow_def.h>
 #include <upipe-modules/upipe_rtp_h264.h>
 
-static const uint8_t *upipe_mpeg_scan(const uint8_t *p, const uint8_t *end,
-                                      uint8_t *len)
-{
-    while (p < end) {
-        if ((p + 2 < end) && p[0] == 0 && p[1] == 0) {
-            if ((p + 3 < end) && p[2] == 1) {
-                *len = 3;
-                return p;
-            }
-            else if ((p + 4 < end) && p[2] == 0 && p[3] == 1) {
-                *len = 4;
-                return p;
-            }
-        }
-        p++;
-    }
-    return NULL;
-}
+/** maximum size of a RTP payload */
+#define RTP_SPLIT_SIZE  1400
+/** maximum number of NAL units in a STAP-A packet */
+#define STAP_MAX_NALU   16
+#define FU_START        (1 << 7)
+#define FU_END          (1 << 6)
+#define FU_A            28
+#define STAP_A          24
+
+#define NALU_F(Nalu)    ((Nalu) & 0x80)
+#define NALU_NRI(Nalu)  ((Nalu) & 0x60)
+#define NALU_TYPE(Nalu) ((Nalu) & 0x1f)
 
 struct upipe_rtp_h264 {
     /** refcount management structure */
@@ -71,6 +66,9 @@ struct upipe_rtp_h264 {
     /** list of output requests */
     struct uchain request_list;
 
+    /** aggregate small NAL units in STAP-A packets */
+    bool aggregate;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -81,6 +79,14 @@ UPIPE_HELPER_VOID(upipe_rtp_h264)
 UPIPE_HELPER_OUTPUT(upipe_rtp_h264, output, flow_def, output_state,
                     request_list)
 
+/** @internal @This is a NAL unit waiting to be aggregated. */
+struct upipe_rtp_h264_nalu {
+    /** NAL unit, including its header */
+    struct uref *uref;
+    /** NAL unit header */
+    uint8_t header;
+};
+
 static int upipe_rtp_h264_set_flow_def(struct upipe *upipe,
                                        struct uref *flow_def)
 {
@@ -101,6 +107,8 @@ static int upipe_rtp_h264_set_flow_def(struct upipe *upipe,
 static int upipe_rtp_h264_control(struct upipe *upipe, int command,
                                   va_list args)
 {
+    struct upipe_rtp_h264 *upipe_rtp_h264 = upipe_rtp_h264_from_upipe(upipe);
+
     switch (command) {
         case UPIPE_REGISTER_REQUEST:
         case UPIPE_UNREGISTER_REQUEST:
@@ -114,6 +122,18 @@ static int upipe_rtp_h264_control(struct upipe *upipe, int command,
         case UPIPE_GET_OUTPUT:
         case UPIPE_SET_OUTPUT:
             return upipe_rtp_h264_control_output(upipe, command, args);
+
+        case UPIPE_RTP_H264_SET_AGGREGATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_H264_SIGNATURE)
+            upipe_rtp_h264->aggregate = !!va_arg(args, int);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_RTP_H264_GET_AGGREGATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_H264_SIGNATURE)
+            int *aggregate_p = va_arg(args, int *);
+            *aggregate_p = upipe_rtp_h264->aggregate ? 1 : 0;
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -138,24 +158,56 @@ static struct upipe *upipe_rtp_h264_alloc(struct upipe_mgr *mgr,
     if (unlikely(upipe == NULL))
         return NULL;
 
+    struct upipe_rtp_h264 *upipe_rtp_h264 = upipe_rtp_h264_from_upipe(upipe);
     upipe_rtp_h264_init_urefcount(upipe);
     upipe_rtp_h264_init_output(upipe);
+    upipe_rtp_h264->aggregate = false;
 
     upipe_throw_ready(upipe);
 
     return upipe;
 }
 
-#define RTP_SPLIT_SIZE  1400
-#define FU_START        (1 << 7)
-#define FU_END          (1 << 6)
-#define FU_A            28
+/** @internal @This allocates a small block holding a payload header.
+ *
+ * @param upipe description structure of the pipe
+ * @param mgr block buffer manager
+ * @param hdr header to copy
+ * @param hdr_size size of the header
+ * @return allocated block or NULL
+ */
+static struct ubuf *upipe_rtp_h264_alloc_header(struct upipe *upipe,
+                                                struct ubuf_mgr *mgr,
+                                                const uint8_t *hdr,
+                                                int hdr_size)
+{
+    struct ubuf *header = ubuf_block_alloc(mgr, hdr_size);
+    if (unlikely(header == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
 
-#define NALU_F(Nalu)    ((Nalu) & 0x80)
-#define NALU_NRI(Nalu)  ((Nalu) & 0x60)
-#define NALU_TYPE(Nalu) ((Nalu) & 0x1f)
-#define NALU_TYPE_DELIM 0x09
+    uint8_t *buf;
+    int buf_size = hdr_size;
+    if (unlikely(!ubase_check(ubuf_block_write(header, 0, &buf_size, &buf)))) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        ubuf_free(header);
+        return NULL;
+    }
+    memcpy(buf, hdr, hdr_size);
+    ubuf_block_unmap(header, 0);
+    return header;
+}
 
+/** @internal @This outputs a NAL unit, in a single NAL unit packet if it
+ * fits, or else in FU-A fragments. The fragments are slices of the original
+ * block behind a small header block, so the payload is never copied.
+ *
+ * @param upipe description structure of the pipe
+ * @param nalu NAL unit header
+ * @param uref NAL unit, including its header
+ * @param upump_p reference to pump that generated the buffer
+ */
 static void upipe_rtp_h264_output_nalu(struct upipe *upipe,
                                        uint8_t nalu,
                                        struct uref *uref,
@@ -164,54 +216,51 @@ static void upipe_rtp_h264_output_nalu(struct upipe *upipe,
     size_t size = 0;
     if (unlikely(!ubase_check(uref_block_size(uref, &size)))) {
         upipe_err(upipe, "fail to get block size");
+        uref_free(uref);
         return;
     }
 
-    bool split = size > RTP_SPLIT_SIZE;
-    uint32_t fragment = 0;
+    if (size <= RTP_SPLIT_SIZE + 1) {
+        uref_clock_set_cr_dts_delay(uref, 0);
+        upipe_rtp_h264_output(upipe, uref, upump_p);
+        return;
+    }
 
+    /* the NAL unit header is replaced by the FU indicator and header */
+    uref_block_resize(uref, 1, -1);
+    size--;
+
+    uint32_t fragment = 0;
     while (size) {
         bool last_fragment = size <= RTP_SPLIT_SIZE;
         size_t split_size = last_fragment ? size : RTP_SPLIT_SIZE;
-        uint8_t hdr[2] = { nalu, 0 };
-        size_t hdr_size = 1;
-
-        if (split) {
-            if (!fragment)
-                hdr[1] = FU_START;
-            else if (last_fragment)
-                hdr[1] = FU_END;
-            hdr[1] |= NALU_TYPE(hdr[0]);
-
-            hdr[0] = NALU_F(hdr[0]) | NALU_NRI(hdr[0]) | FU_A;
-            hdr_size++;
-        }
+        uint8_t hdr[2];
+        hdr[0] = NALU_F(nalu) | NALU_NRI(nalu) | FU_A;
+        hdr[1] = NALU_TYPE(nalu);
+        if (!fragment)
+            hdr[1] |= FU_START;
+        else if (last_fragment)
+            hdr[1] |= FU_END;
 
         struct uref *next = NULL;
         if (!last_fragment) {
             next = uref_block_split(uref, split_size);
             if (unlikely(next == NULL)) {
                 upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                uref_free(uref);
                 return;
             }
         }
 
         /* FIXME should require a ubuf_mgr */
-        struct ubuf *header =
-                ubuf_block_alloc(uref->ubuf->mgr, hdr_size * sizeof (hdr[0]));
+        struct ubuf *header = upipe_rtp_h264_alloc_header(upipe,
+                uref->ubuf->mgr, hdr, sizeof (hdr));
         if (unlikely(header == NULL)) {
-            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             uref_free(uref);
             uref_free(next);
             return;
         }
 
-        uint8_t *buf = NULL;
-        int buf_size = hdr_size;
-        ubuf_block_write(header, 0, &buf_size, &buf);
-        memcpy(buf, hdr, hdr_size * sizeof (hdr[0]));
-        ubuf_block_unmap(header, 0);
-
         /* append payload (current ubuf) to header to form segmented ubuf */
         struct ubuf *payload = uref_detach_ubuf(uref);
         if (unlikely(!ubase_check(ubuf_block_append(header, payload)))) {
@@ -231,49 +280,176 @@ static void upipe_rtp_h264_output_nalu(struct upipe *upipe,
     }
 }
 
+/** @internal @This outputs the pending NAL units, in a STAP-A packet if
+ * there are several of them.
+ *
+ * @param upipe description structure of the pipe
+ * @param pending array of pending NAL units
+ * @param nb number of pending NAL units
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtp_h264_output_stap(struct upipe *upipe,
+                                       struct upipe_rtp_h264_nalu *pending,
+                                       unsigned nb,
+                                       struct upump **upump_p)
+{
+    if (nb == 0)
+        return;
+    if (nb == 1) {
+        upipe_rtp_h264_output_nalu(upipe, pending[0].header, pending[0].uref,
+                                   upump_p);
+        return;
+    }
+
+    uint8_t nri = 0, f = 0;
+    for (unsigned i = 0; i < nb; i++) {
+        f |= NALU_F(pending[i].header);
+        if (NALU_NRI(pending[i].header) > nri)
+            nri = NALU_NRI(pending[i].header);
+    }
+
+    struct uref *uref = pending[0].uref;
+    /* FIXME should require a ubuf_mgr */
+    struct ubuf_mgr *ubuf_mgr = uref->ubuf->mgr;
+    struct ubuf *stap = NULL;
+    for (unsigned i = 0; i < nb; i++) {
+        size_t size = 0;
+        uref_block_size(pending[i].uref, &size);
+        uint8_t hdr[3] = { f | nri | STAP_A, size >> 8, size };
+        struct ubuf *header = NULL;
+        if (stap == NULL)
+            header = stap = upipe_rtp_h264_alloc_header(upipe,
+                ubuf_mgr, hdr, 3);
+        else {
+            header = upipe_rtp_h264_alloc_header(upipe,
+                ubuf_mgr, hdr + 1, 2);
+            if (header != NULL && !ubase_check(ubuf_block_append(stap, header)))
+            {
+                ubuf_free(header);
+                header = NULL;
+            }
+        }
+
+        struct ubuf *payload = header == NULL ? NULL :
+            uref_detach_ubuf(pending[i].uref);
+        if (unlikely(payload == NULL ||
+                     !ubase_check(ubuf_block_append(stap, payload)))) {
+            upipe_warn(upipe, "could not build aggregation packet");
+            if (payload != NULL)
+                ubuf_free(payload);
+            if (stap != NULL)
+                ubuf_free(stap);
+            for (unsigned j = 1; j < nb; j++)
+                uref_free(pending[j].uref);
+            uref_free(uref);
+            return;
+        }
+    }
+
+    for (unsigned i = 1; i < nb; i++)
+        uref_free(pending[i].uref);
+    uref_attach_ubuf(uref, stap);
+    uref_clock_set_cr_dts_delay(uref, 0);
+    upipe_rtp_h264_output(upipe, uref, upump_p);
+}
+
 static void upipe_rtp_h264_drop(struct upipe *upipe, struct uref *uref)
 {
     upipe_warn(upipe, "drop...");
     uref_free(uref);
 }
 
+/** @internal @This returns the offset of the next start code, scanning the
+ * block in place.
+ *
+ * @param uref input access unit
+ * @param offset_p offset to start from, filled in with the start code offset
+ * @return false if there is no more start code
+ */
+static bool upipe_rtp_h264_find_start(struct uref *uref, size_t *offset_p)
+{
+    return ubase_check(uref_block_find(uref, offset_p, 3, 0, 0, 1));
+}
+
 static void upipe_rtp_h264_input(struct upipe *upipe,
                                 struct uref *uref,
                                 struct upump **upump_p)
 {
+    struct upipe_rtp_h264 *upipe_rtp_h264 = upipe_rtp_h264_from_upipe(upipe);
+
     size_t bz = 0;
     if (!ubase_check(uref_block_size(uref, &bz))) {
         upipe_err(upipe, "fail to get uref block size");
         return upipe_rtp_h264_drop(upipe, uref);
     }
 
-    uint8_t buf[bz];
-    int size = bz;
-    if (unlikely(!ubase_check(uref_block_extract(uref, 0, size, buf)))) {
-        upipe_err(upipe, "fail to read from uref");
-        return upipe_rtp_h264_drop(upipe, uref);
-    }
-
-    uint8_t s_len;
-    const uint8_t *s = upipe_mpeg_scan(buf, buf + size, &s_len);
-    if (s != buf) {
+    size_t start = 0;
+    uint8_t zero = 0;
+    if (!upipe_rtp_h264_find_start(uref, &start) || start > 1 ||
+        (start == 1 && (!ubase_check(uref_block_extract(uref, 0, 1, &zero)) ||
+                        zero))) {
         upipe_err(upipe, "uref does not start with a mpeg start code");
         return upipe_rtp_h264_drop(upipe, uref);
     }
+    start += 3;
+
+    struct upipe_rtp_h264_nalu pending[STAP_MAX_NALU];
+    unsigned nb_pending = 0;
+    size_t stap_size = 1;
+
+    while (start < bz) {
+        size_t end = start;
+        size_t next = bz;
+        if (upipe_rtp_h264_find_start(uref, &end))
+            next = end + 3;
+        else
+            end = bz;
+
+        /* strip the leading zero of 4-byte start codes and trailing zeros */
+        while (end > start) {
+            uint8_t byte;
+            if (unlikely(!ubase_check(uref_block_extract(uref, end - 1, 1,
+                                                         &byte))) || byte)
+                break;
+            end--;
+        }
+
+        uint8_t nalu;
+        if (end == start ||
+            unlikely(!ubase_check(uref_block_extract(uref, start, 1, &nalu)))) {
+            start = next;
+            continue;
+        }
 
-    while (s < buf + size) {
-        uint8_t e_len = 0;
-        const uint8_t *e = upipe_mpeg_scan(s + s_len, buf + size, &e_len);
-        if (!e)
-            e = buf + size;
-
-        struct uref *part = uref_block_splice(uref, s - buf + s_len + 1,
-                                              e - (s + s_len + 1));
-        upipe_rtp_h264_output_nalu(upipe, *(s + s_len), part, upump_p);
-        s = e;
-        s_len = e_len;
+        struct uref *part = uref_block_splice(uref, start, end - start);
+        if (unlikely(part == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            break;
+        }
+        size_t size = end - start;
+        start = next;
+
+        if (!upipe_rtp_h264->aggregate || size + 3 > RTP_SPLIT_SIZE) {
+            upipe_rtp_h264_output_stap(upipe, pending, nb_pending, upump_p);
+            nb_pending = 0;
+            stap_size = 1;
+            upipe_rtp_h264_output_nalu(upipe, nalu, part, upump_p);
+            continue;
+        }
+
+        if (nb_pending == STAP_MAX_NALU ||
+            stap_size + 2 + size > RTP_SPLIT_SIZE) {
+            upipe_rtp_h264_output_stap(upipe, pending, nb_pending, upump_p);
+            nb_pending = 0;
+            stap_size = 1;
+        }
+        pending[nb_pending].uref = part;
+        pending[nb_pending].header = nalu;
+        nb_pending++;
+        stap_size += 2 + size;
     }
 
+    upipe_rtp_h264_output_stap(upipe, pending, nb_pending, upump_p);
     uref_free(uref);
 }
 
@@ -288,6 +464,10 @@ static struct upipe_mgr upipe_rtp_h264_mgr = {
     .upipe_mgr_control = NULL,
 };
 
+/** @This returns the management structure for rtp h264 pipes.
+ *
+ * @return pointer to manager
+ */
 struct upipe_mgr *upipe_rtp_h264_mgr_alloc(void)
 {
     return &upipe_rtp_h264_mgr;
@@ -0,0 +1,480 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <upipe/upipe.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_block.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe-modules/upipe_rtp_h265.h>
+
+/** maximum size of a RTP payload */
+#define RTP_SPLIT_SIZE  1400
+/** maximum number of NAL units in an aggregation packet */
+#define AP_MAX_NALU     16
+/** size of a NAL unit header */
+#define NALU_HDR_SIZE   2
+#define FU_START        (1 << 7)
+#define FU_END          (1 << 6)
+#define FU              49
+#define AP              48
+
+#define NALU_F(Nalu)        ((Nalu) & 0x8000)
+#define NALU_TYPE(Nalu)     (((Nalu) >> 9) & 0x3f)
+#define NALU_LAYER(Nalu)    ((Nalu) & 0x01f8)
+#define NALU_TID(Nalu)      ((Nalu) & 0x0007)
+
+struct upipe_rtp_h265 {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /* output stuff */
+    /** pipe acting as output */
+    struct upipe *output;
+    /** output flow definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** aggregate small NAL units in aggregation packets */
+    bool aggregate;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_rtp_h265, upipe, UPIPE_RTP_H265_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_rtp_h265, urefcount, upipe_rtp_h265_free)
+UPIPE_HELPER_VOID(upipe_rtp_h265)
+UPIPE_HELPER_OUTPUT(upipe_rtp_h265, output, flow_def, output_state,
+                    request_list)
+
+/** @internal @This is a NAL unit waiting to be aggregated. */
+struct upipe_rtp_h265_nalu {
+    /** NAL unit, including its header */
+    struct uref *uref;
+    /** NAL unit header */
+    uint16_t header;
+};
+
+static int upipe_rtp_h265_set_flow_def(struct upipe *upipe,
+                                       struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, "block.hevc."))
+
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    if (unlikely(flow_def_dup == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
+
+    upipe_rtp_h265_store_flow_def(upipe, flow_def_dup);
+    return UBASE_ERR_NONE;
+}
+
+static int upipe_rtp_h265_control(struct upipe *upipe, int command,
+                                  va_list args)
+{
+    struct upipe_rtp_h265 *upipe_rtp_h265 = upipe_rtp_h265_from_upipe(upipe);
+
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST:
+        case UPIPE_UNREGISTER_REQUEST:
+            return upipe_control_provide_request(upipe, command, args);
+
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_rtp_h265_set_flow_def(upipe, flow_def);
+        }
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_rtp_h265_control_output(upipe, command, args);
+
+        case UPIPE_RTP_H265_SET_AGGREGATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_H265_SIGNATURE)
+            upipe_rtp_h265->aggregate = !!va_arg(args, int);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_RTP_H265_GET_AGGREGATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_H265_SIGNATURE)
+            int *aggregate_p = va_arg(args, int *);
+            *aggregate_p = upipe_rtp_h265->aggregate ? 1 : 0;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+static void upipe_rtp_h265_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+
+    upipe_rtp_h265_clean_output(upipe);
+    upipe_rtp_h265_clean_urefcount(upipe);
+    upipe_rtp_h265_free_void(upipe);
+}
+
+static struct upipe *upipe_rtp_h265_alloc(struct upipe_mgr *mgr,
+                                          struct uprobe *uprobe,
+                                          uint32_t signature,
+                                          va_list args)
+{
+    struct upipe *upipe =
+        upipe_rtp_h265_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_rtp_h265 *upipe_rtp_h265 = upipe_rtp_h265_from_upipe(upipe);
+    upipe_rtp_h265_init_urefcount(upipe);
+    upipe_rtp_h265_init_output(upipe);
+    upipe_rtp_h265->aggregate = false;
+
+    upipe_throw_ready(upipe);
+
+    return upipe;
+}
+
+/** @internal @This allocates a small block holding a payload header.
+ *
+ * @param upipe description structure of the pipe
+ * @param mgr block buffer manager
+ * @param hdr header to copy
+ * @param hdr_size size of the header
+ * @return allocated block or NULL
+ */
+static struct ubuf *upipe_rtp_h265_alloc_header(struct upipe *upipe,
+                                                struct ubuf_mgr *mgr,
+                                                const uint8_t *hdr,
+                                                int hdr_size)
+{
+    struct ubuf *header = ubuf_block_alloc(mgr, hdr_size);
+    if (unlikely(header == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
+
+    uint8_t *buf;
+    int buf_size = hdr_size;
+    if (unlikely(!ubase_check(ubuf_block_write(header, 0, &buf_size, &buf)))) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        ubuf_free(header);
+        return NULL;
+    }
+    memcpy(buf, hdr, hdr_size);
+    ubuf_block_unmap(header, 0);
+    return header;
+}
+
+/** @internal @This outputs a NAL unit, in a single NAL unit packet if it
+ * fits, or else in fragmentation units. The fragments are slices of the original
+ * block behind a small header block, so the payload is never copied.
+ *
+ * @param upipe description structure of the pipe
+ * @param nalu NAL unit header
+ * @param uref NAL unit, including its header
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtp_h265_output_nalu(struct upipe *upipe,
+                                       uint16_t nalu,
+                                       struct uref *uref,
+                                       struct upump **upump_p)
+{
+    size_t size = 0;
+    if (unlikely(!ubase_check(uref_block_size(uref, &size)))) {
+        upipe_err(upipe, "fail to get block size");
+        uref_free(uref);
+        return;
+    }
+
+    if (size <= RTP_SPLIT_SIZE + NALU_HDR_SIZE) {
+        uref_clock_set_cr_dts_delay(uref, 0);
+        upipe_rtp_h265_output(upipe, uref, upump_p);
+        return;
+    }
+
+    /* the NAL unit header is replaced by the payload and FU headers */
+    uref_block_resize(uref, NALU_HDR_SIZE, -1);
+    size -= NALU_HDR_SIZE;
+
+    uint32_t fragment = 0;
+    while (size) {
+        bool last_fragment = size <= RTP_SPLIT_SIZE;
+        size_t split_size = last_fragment ? size : RTP_SPLIT_SIZE;
+        uint8_t hdr[3];
+        hdr[0] = ((nalu >> 8) & 0x81) | (FU << 1);
+        hdr[1] = nalu & 0xff;
+        hdr[2] = NALU_TYPE(nalu);
+        if (!fragment)
+            hdr[2] |= FU_START;
+        else if (last_fragment)
+            hdr[2] |= FU_END;
+
+        struct uref *next = NULL;
+        if (!last_fragment) {
+            next = uref_block_split(uref, split_size);
+            if (unlikely(next == NULL)) {
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                uref_free(uref);
+                return;
+            }
+        }
+
+        /* FIXME should require a ubuf_mgr */
+        struct ubuf *header = upipe_rtp_h265_alloc_header(upipe,
+                uref->ubuf->mgr, hdr, sizeof (hdr));
+        if (unlikely(header == NULL)) {
+            uref_free(uref);
+            uref_free(next);
+            return;
+        }
+
+        /* append payload (current ubuf) to header to form segmented ubuf */
+        struct ubuf *payload = uref_detach_ubuf(uref);
+        if (unlikely(!ubase_check(ubuf_block_append(header, payload)))) {
+            upipe_warn(upipe, "could not append payload to header");
+            ubuf_free(header);
+            ubuf_free(payload);
+            uref_free(uref);
+            uref_free(next);
+            return;
+        }
+        uref_attach_ubuf(uref, header);
+        uref_clock_set_cr_dts_delay(uref, 0);
+        upipe_rtp_h265_output(upipe, uref, upump_p);
+        size -= split_size;
+        fragment++;
+        uref = next;
+    }
+}
+
+/** @internal @This outputs the pending NAL units, in an aggregation packet if
+ * there are several of them.
+ *
+ * @param upipe description structure of the pipe
+ * @param pending array of pending NAL units
+ * @param nb number of pending NAL units
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtp_h265_output_ap(struct upipe *upipe,
+                                       struct upipe_rtp_h265_nalu *pending,
+                                       unsigned nb,
+                                       struct upump **upump_p)
+{
+    if (nb == 0)
+        return;
+    if (nb == 1) {
+        upipe_rtp_h265_output_nalu(upipe, pending[0].header, pending[0].uref,
+                                   upump_p);
+        return;
+    }
+
+    /* F is set if any F is set, LayerId and TID are the lowest ones */
+    uint16_t f = 0, layer = NALU_LAYER(pending[0].header),
+             tid = NALU_TID(pending[0].header);
+    for (unsigned i = 0; i < nb; i++) {
+        f |= NALU_F(pending[i].header);
+        if (NALU_LAYER(pending[i].header) < layer)
+            layer = NALU_LAYER(pending[i].header);
+        if (NALU_TID(pending[i].header) < tid)
+            tid = NALU_TID(pending[i].header);
+    }
+    uint16_t ap_hdr = f | (AP << 9) | layer | tid;
+
+    struct uref *uref = pending[0].uref;
+    /* FIXME should require a ubuf_mgr */
+    struct ubuf_mgr *ubuf_mgr = uref->ubuf->mgr;
+    struct ubuf *ap = NULL;
+    for (unsigned i = 0; i < nb; i++) {
+        size_t size = 0;
+        uref_block_size(pending[i].uref, &size);
+        uint8_t hdr[4] = { ap_hdr >> 8, ap_hdr, size >> 8, size };
+        struct ubuf *header = NULL;
+        if (ap == NULL)
+            header = ap = upipe_rtp_h265_alloc_header(upipe,
+                ubuf_mgr, hdr, 4);
+        else {
+            header = upipe_rtp_h265_alloc_header(upipe,
+                ubuf_mgr, hdr + 2, 2);
+            if (header != NULL && !ubase_check(ubuf_block_append(ap, header)))
+            {
+                ubuf_free(header);
+                header = NULL;
+            }
+        }
+
+        struct ubuf *payload = header == NULL ? NULL :
+            uref_detach_ubuf(pending[i].uref);
+        if (unlikely(payload == NULL ||
+                     !ubase_check(ubuf_block_append(ap, payload)))) {
+            upipe_warn(upipe, "could not build aggregation packet");
+            if (payload != NULL)
+                ubuf_free(payload);
+            if (ap != NULL)
+                ubuf_free(ap);
+            for (unsigned j = 1; j < nb; j++)
+                uref_free(pending[j].uref);
+            uref_free(uref);
+            return;
+        }
+    }
+
+    for (unsigned i = 1; i < nb; i++)
+        uref_free(pending[i].uref);
+    uref_attach_ubuf(uref, ap);
+    uref_clock_set_cr_dts_delay(uref, 0);
+    upipe_rtp_h265_output(upipe, uref, upump_p);
+}
+
+static void upipe_rtp_h265_drop(struct upipe *upipe, struct uref *uref)
+{
+    upipe_warn(upipe, "drop...");
+    uref_free(uref);
+}
+
+/** @internal @This returns the offset of the next start code, scanning the
+ * block in place.
+ *
+ * @param uref input access unit
+ * @param offset_p offset to start from, filled in with the start code offset
+ * @return false if there is no more start code
+ */
+static bool upipe_rtp_h265_find_start(struct uref *uref, size_t *offset_p)
+{
+    return ubase_check(uref_block_find(uref, offset_p, 3, 0, 0, 1));
+}
+
+static void upipe_rtp_h265_input(struct upipe *upipe,
+                                struct uref *uref,
+                                struct upump **upump_p)
+{
+    struct upipe_rtp_h265 *upipe_rtp_h265 = upipe_rtp_h265_from_upipe(upipe);
+
+    size_t bz = 0;
+    if (!ubase_check(uref_block_size(uref, &bz))) {
+        upipe_err(upipe, "fail to get uref block size");
+        return upipe_rtp_h265_drop(upipe, uref);
+    }
+
+    size_t start = 0;
+    uint8_t zero = 0;
+    if (!upipe_rtp_h265_find_start(uref, &start) || start > 1 ||
+        (start == 1 && (!ubase_check(uref_block_extract(uref, 0, 1, &zero)) ||
+                        zero))) {
+        upipe_err(upipe, "uref does not start with a mpeg start code");
+        return upipe_rtp_h265_drop(upipe, uref);
+    }
+    start += 3;
+
+    struct upipe_rtp_h265_nalu pending[AP_MAX_NALU];
+    unsigned nb_pending = 0;
+    size_t ap_size = NALU_HDR_SIZE;
+
+    while (start < bz) {
+        size_t end = start;
+        size_t next = bz;
+        if (upipe_rtp_h265_find_start(uref, &end))
+            next = end + 3;
+        else
+            end = bz;
+
+        /* strip the leading zero of 4-byte start codes and trailing zeros */
+        while (end > start) {
+            uint8_t byte;
+            if (unlikely(!ubase_check(uref_block_extract(uref, end - 1, 1,
+                                                         &byte))) || byte)
+                break;
+            end--;
+        }
+
+        uint8_t hdr[NALU_HDR_SIZE];
+        if (end < start + NALU_HDR_SIZE ||
+            unlikely(!ubase_check(uref_block_extract(uref, start,
+                                                     NALU_HDR_SIZE, hdr)))) {
+            start = next;
+            continue;
+        }
+        uint16_t nalu = (hdr[0] << 8) | hdr[1];
+
+        struct uref *part = uref_block_splice(uref, start, end - start);
+        if (unlikely(part == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            break;
+        }
+        size_t size = end - start;
+        start = next;
+
+        if (!upipe_rtp_h265->aggregate ||
+            NALU_HDR_SIZE + 2 + size > RTP_SPLIT_SIZE) {
+            upipe_rtp_h265_output_ap(upipe, pending, nb_pending, upump_p);
+            nb_pending = 0;
+            ap_size = NALU_HDR_SIZE;
+            upipe_rtp_h265_output_nalu(upipe, nalu, part, upump_p);
+            continue;
+        }
+
+        if (nb_pending == AP_MAX_NALU ||
+            ap_size + 2 + size > RTP_SPLIT_SIZE) {
+            upipe_rtp_h265_output_ap(upipe, pending, nb_pending, upump_p);
+            nb_pending = 0;
+            ap_size = NALU_HDR_SIZE;
+        }
+        pending[nb_pending].uref = part;
+        pending[nb_pending].header = nalu;
+        nb_pending++;
+        ap_size += 2 + size;
+    }
+
+    upipe_rtp_h265_output_ap(upipe, pending, nb_pending, upump_p);
+    uref_free(uref);
+}
+
+static struct upipe_mgr upipe_rtp_h265_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_RTP_H265_SIGNATURE,
+
+    .upipe_alloc = upipe_rtp_h265_alloc,
+    .upipe_input = upipe_rtp_h265_input,
+    .upipe_control = upipe_rtp_h265_control,
+
+    .upipe_mgr_control = NULL,
+};
+
+/** @This returns the management structure for rtp h265 pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_rtp_h265_mgr_alloc(void)
+{
+    return &upipe_rtp_h265_mgr;
+}
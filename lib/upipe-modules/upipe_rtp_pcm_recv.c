@@ -0,0 +1,685 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module receiving RTP PCM (AES67, SMPTE 2110-30) into frames
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uclock.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_sound_flow.h>
+#include <upipe/ubuf_sound.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_flow.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe/upipe_helper_ubuf_mgr.h>
+#include <upipe-modules/upipe_rtp_pcm_recv.h>
+
+#include "upipe_pcm_convert.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <bitstream/ietf/rtp.h>
+
+/** default number of samples per output frame */
+#define DEFAULT_FRAME_SIZE 1024
+/** default jitter window, in frames */
+#define DEFAULT_LATENCY 2
+
+/** @internal @This is a frame of the ring. */
+struct upipe_rtp_pcm_recv_frame {
+    /** uref carrying the frame, or NULL if the slot is free */
+    struct uref *uref;
+    /** mapped samples of the frame */
+    int32_t *buffer;
+    /** number of samples received */
+    unsigned int filled;
+};
+
+/** @internal @This is the private context of an rtp_pcm_recv pipe. */
+struct upipe_rtp_pcm_recv {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** output flow definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** ubuf manager */
+    struct ubuf_mgr *ubuf_mgr;
+    /** flow format packet */
+    struct uref *flow_format;
+    /** ubuf manager request */
+    struct urequest ubuf_mgr_request;
+
+    /** sample rate */
+    uint64_t rate;
+    /** number of channels */
+    uint8_t channels;
+    /** size of an input sample, in octets */
+    uint8_t in_size;
+    /** conversion of input samples to s32 */
+    upipe_pcm_to_s32_func convert;
+
+    /** number of samples per frame */
+    unsigned int frame_size;
+    /** jitter window, in frames */
+    unsigned int latency;
+    /** ring of frames */
+    struct upipe_rtp_pcm_recv_frame *frames;
+    /** number of frames in the ring */
+    unsigned int nb_frames;
+    /** index of the oldest frame */
+    unsigned int head;
+    /** extended RTP timestamp of the oldest frame, or UINT64_MAX */
+    uint64_t base;
+    /** extended RTP timestamp of the last packet, or UINT64_MAX */
+    uint64_t last_timestamp;
+
+    /** expected sequence number, or -1 */
+    int expected_seqnum;
+    /** number of lost packets */
+    uint64_t lost;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+/** @hidden */
+static int upipe_rtp_pcm_recv_check(struct upipe *upipe,
+                                    struct uref *flow_format);
+
+UPIPE_HELPER_UPIPE(upipe_rtp_pcm_recv, upipe, UPIPE_RTP_PCM_RECV_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_rtp_pcm_recv, urefcount, upipe_rtp_pcm_recv_free)
+UPIPE_HELPER_FLOW(upipe_rtp_pcm_recv, "block.")
+UPIPE_HELPER_OUTPUT(upipe_rtp_pcm_recv, output, flow_def, output_state,
+                    request_list)
+UPIPE_HELPER_UBUF_MGR(upipe_rtp_pcm_recv, ubuf_mgr, flow_format,
+                      ubuf_mgr_request, upipe_rtp_pcm_recv_check,
+                      upipe_rtp_pcm_recv_register_output_request,
+                      upipe_rtp_pcm_recv_unregister_output_request)
+
+/** @internal @This receives the flow format.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_rtp_pcm_recv_check(struct upipe *upipe,
+                                    struct uref *flow_format)
+{
+    if (flow_format != NULL)
+        upipe_rtp_pcm_recv_store_flow_def(upipe, flow_format);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This releases a frame without outputting it.
+ *
+ * @param frame frame of the ring
+ */
+static void upipe_rtp_pcm_recv_discard(struct upipe_rtp_pcm_recv_frame *frame)
+{
+    if (frame->uref == NULL)
+        return;
+    ubuf_sound_unmap(frame->uref->ubuf, 0, -1, 1);
+    uref_free(frame->uref);
+    frame->uref = NULL;
+    frame->filled = 0;
+}
+
+/** @internal @This outputs the oldest frame if it was started, and moves
+ * the ring forward by one frame.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtp_pcm_recv_advance(struct upipe *upipe,
+                                       struct upump **upump_p)
+{
+    struct upipe_rtp_pcm_recv *upipe_rtp_pcm_recv =
+        upipe_rtp_pcm_recv_from_upipe(upipe);
+    struct upipe_rtp_pcm_recv_frame *frame =
+        &upipe_rtp_pcm_recv->frames[upipe_rtp_pcm_recv->head];
+    upipe_rtp_pcm_recv->head =
+        (upipe_rtp_pcm_recv->head + 1) % upipe_rtp_pcm_recv->nb_frames;
+    upipe_rtp_pcm_recv->base += upipe_rtp_pcm_recv->frame_size;
+
+    if (frame->uref == NULL)
+        return;
+
+    struct uref *uref = frame->uref;
+    if (frame->filled < upipe_rtp_pcm_recv->frame_size)
+        upipe_dbg_va(upipe, "missing %u samples, filled with silence",
+                     upipe_rtp_pcm_recv->frame_size - frame->filled);
+    ubuf_sound_unmap(uref->ubuf, 0, -1, 1);
+    frame->uref = NULL;
+    frame->filled = 0;
+
+    upipe_throw_clock_ts(upipe, uref);
+    upipe_rtp_pcm_recv_output(upipe, uref, upump_p);
+}
+
+/** @internal @This outputs all started frames and resets the alignment of
+ * the ring.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtp_pcm_recv_flush(struct upipe *upipe,
+                                     struct upump **upump_p)
+{
+    struct upipe_rtp_pcm_recv *upipe_rtp_pcm_recv =
+        upipe_rtp_pcm_recv_from_upipe(upipe);
+    if (upipe_rtp_pcm_recv->base != UINT64_MAX)
+        for (unsigned int i = 0; i < upipe_rtp_pcm_recv->nb_frames; i++)
+            upipe_rtp_pcm_recv_advance(upipe, upump_p);
+    upipe_rtp_pcm_recv->head = 0;
+    upipe_rtp_pcm_recv->base = UINT64_MAX;
+}
+
+/** @internal @This (re)allocates the ring of frames, after outputting the
+ * pending ones.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_rtp_pcm_recv_alloc_ring(struct upipe *upipe)
+{
+    struct upipe_rtp_pcm_recv *upipe_rtp_pcm_recv =
+        upipe_rtp_pcm_recv_from_upipe(upipe);
+    if (upipe_rtp_pcm_recv->frames != NULL)
+        upipe_rtp_pcm_recv_flush(upipe, NULL);
+    free(upipe_rtp_pcm_recv->frames);
+
+    upipe_rtp_pcm_recv->nb_frames = upipe_rtp_pcm_recv->latency + 1;
+    upipe_rtp_pcm_recv->frames = calloc(upipe_rtp_pcm_recv->nb_frames,
+                                        sizeof (struct upipe_rtp_pcm_recv_frame));
+    if (unlikely(upipe_rtp_pcm_recv->frames == NULL)) {
+        upipe_rtp_pcm_recv->nb_frames = 0;
+        return UBASE_ERR_ALLOC;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This allocates an rtp_pcm_recv pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_rtp_pcm_recv_alloc(struct upipe_mgr *mgr,
+                                              struct uprobe *uprobe,
+                                              uint32_t signature,
+                                              va_list args)
+{
+    struct uref *flow_def;
+    struct upipe *upipe = upipe_rtp_pcm_recv_alloc_flow(mgr, uprobe,
+                                                        signature, args,
+                                                        &flow_def);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_rtp_pcm_recv *upipe_rtp_pcm_recv =
+        upipe_rtp_pcm_recv_from_upipe(upipe);
+    upipe_rtp_pcm_recv_init_urefcount(upipe);
+    upipe_rtp_pcm_recv_init_output(upipe);
+    upipe_rtp_pcm_recv_init_ubuf_mgr(upipe);
+    upipe_rtp_pcm_recv->frame_size = DEFAULT_FRAME_SIZE;
+    upipe_rtp_pcm_recv->latency = DEFAULT_LATENCY;
+    upipe_rtp_pcm_recv->frames = NULL;
+    upipe_rtp_pcm_recv->nb_frames = 0;
+    upipe_rtp_pcm_recv->head = 0;
+    upipe_rtp_pcm_recv->base = UINT64_MAX;
+    upipe_rtp_pcm_recv->last_timestamp = UINT64_MAX;
+    upipe_rtp_pcm_recv->expected_seqnum = -1;
+    upipe_rtp_pcm_recv->lost = 0;
+    upipe_throw_ready(upipe);
+
+    if (ubase_check(uref_flow_match_def(flow_def, "block.s16be.sound."))) {
+        upipe_rtp_pcm_recv->in_size = 2;
+        upipe_rtp_pcm_recv->convert = upipe_pcm_s16be_to_s32;
+    } else if (ubase_check(uref_flow_match_def(flow_def,
+                                               "block.s24be.sound."))) {
+        upipe_rtp_pcm_recv->in_size = 3;
+        upipe_rtp_pcm_recv->convert = upipe_pcm_s24be_to_s32;
+    } else {
+        upipe_err(upipe, "unsupported payload format");
+        uref_free(flow_def);
+        upipe_release(upipe);
+        return NULL;
+    }
+
+    if (unlikely(!ubase_check(uref_sound_flow_get_rate(flow_def,
+                    &upipe_rtp_pcm_recv->rate)) ||
+                 !upipe_rtp_pcm_recv->rate ||
+                 !ubase_check(uref_sound_flow_get_channels(flow_def,
+                    &upipe_rtp_pcm_recv->channels)) ||
+                 !upipe_rtp_pcm_recv->channels)) {
+        upipe_err(upipe, "flow def needs rate and channels");
+        uref_free(flow_def);
+        upipe_release(upipe);
+        return NULL;
+    }
+
+    if (unlikely(!ubase_check(upipe_rtp_pcm_recv_alloc_ring(upipe)))) {
+        uref_free(flow_def);
+        upipe_release(upipe);
+        return NULL;
+    }
+
+    uref_sound_flow_clear_format(flow_def);
+    if (unlikely(!ubase_check(uref_flow_set_def(flow_def, "sound.s32.")) ||
+                 !ubase_check(uref_sound_flow_add_plane(flow_def, "all")) ||
+                 !ubase_check(uref_sound_flow_set_sample_size(flow_def,
+                         4 * upipe_rtp_pcm_recv->channels)))) {
+        uref_free(flow_def);
+        upipe_release(upipe);
+        return NULL;
+    }
+    upipe_rtp_pcm_recv_require_ubuf_mgr(upipe, flow_def);
+    return upipe;
+}
+
+/** @internal @This starts a frame of the ring.
+ *
+ * @param upipe description structure of the pipe
+ * @param frame frame of the ring
+ * @param uref packet whose attributes are copied
+ * @param frame_timestamp extended RTP timestamp of the first sample of the
+ * frame
+ * @param timestamp extended RTP timestamp of the packet
+ * @return an error code
+ */
+static int upipe_rtp_pcm_recv_start(struct upipe *upipe,
+                                    struct upipe_rtp_pcm_recv_frame *frame,
+                                    struct uref *uref,
+                                    uint64_t frame_timestamp,
+                                    uint64_t timestamp)
+{
+    struct upipe_rtp_pcm_recv *upipe_rtp_pcm_recv =
+        upipe_rtp_pcm_recv_from_upipe(upipe);
+    uint64_t rate = upipe_rtp_pcm_recv->rate;
+
+    struct ubuf *ubuf = ubuf_sound_alloc(upipe_rtp_pcm_recv->ubuf_mgr,
+                                         upipe_rtp_pcm_recv->frame_size);
+    UBASE_ALLOC_RETURN(ubuf);
+    if (unlikely(!ubase_check(ubuf_sound_write_int32_t(ubuf, 0, -1,
+                                                       &frame->buffer, 1)))) {
+        ubuf_free(ubuf);
+        return UBASE_ERR_ALLOC;
+    }
+    /* missing packets are heard as silence */
+    memset(frame->buffer, 0, sizeof (int32_t) * upipe_rtp_pcm_recv->channels *
+                             upipe_rtp_pcm_recv->frame_size);
+
+    frame->uref = uref_fork(uref, ubuf);
+    if (unlikely(frame->uref == NULL)) {
+        ubuf_sound_unmap(ubuf, 0, -1, 1);
+        ubuf_free(ubuf);
+        return UBASE_ERR_ALLOC;
+    }
+    frame->filled = 0;
+
+    uref_clock_set_pts_orig(frame->uref,
+                            frame_timestamp * UCLOCK_FREQ / rate);
+    uref_clock_set_dts_pts_delay(frame->uref, 0);
+    uref_clock_set_duration(frame->uref,
+            (uint64_t)upipe_rtp_pcm_recv->frame_size * UCLOCK_FREQ / rate);
+
+    /* the packet reception time is moved to the start of the frame */
+    uint64_t cr_sys;
+    if (ubase_check(uref_clock_get_cr_sys(frame->uref, &cr_sys))) {
+        int64_t delta = ((int64_t)frame_timestamp - (int64_t)timestamp) *
+                        (int64_t)UCLOCK_FREQ / (int64_t)rate;
+        if (delta >= 0 || cr_sys >= -delta)
+            uref_clock_set_cr_sys(frame->uref, cr_sys + delta);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This places samples into the ring.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref packet
+ * @param timestamp extended RTP timestamp of the first sample
+ * @param payload big-endian samples
+ * @param samples number of samples per channel
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtp_pcm_recv_place(struct upipe *upipe, struct uref *uref,
+                                     uint64_t timestamp,
+                                     const uint8_t *payload, size_t samples,
+                                     struct upump **upump_p)
+{
+    struct upipe_rtp_pcm_recv *upipe_rtp_pcm_recv =
+        upipe_rtp_pcm_recv_from_upipe(upipe);
+    uint64_t frame_size = upipe_rtp_pcm_recv->frame_size;
+    uint64_t window = frame_size * upipe_rtp_pcm_recv->nb_frames;
+    size_t in_frame = upipe_rtp_pcm_recv->in_size *
+                      upipe_rtp_pcm_recv->channels;
+    uint64_t packet_timestamp = timestamp;
+
+    if (upipe_rtp_pcm_recv->base != UINT64_MAX &&
+        (timestamp + window < upipe_rtp_pcm_recv->base ||
+         timestamp >= upipe_rtp_pcm_recv->base + 2 * window)) {
+        upipe_warn(upipe, "timestamp discontinuity, resyncing");
+        upipe_rtp_pcm_recv_flush(upipe, upump_p);
+    }
+    if (upipe_rtp_pcm_recv->base == UINT64_MAX)
+        upipe_rtp_pcm_recv->base = timestamp;
+
+    if (timestamp < upipe_rtp_pcm_recv->base) {
+        uint64_t late = upipe_rtp_pcm_recv->base - timestamp;
+        if (late >= samples) {
+            upipe_dbg(upipe, "dropping late packet");
+            return;
+        }
+        payload += late * in_frame;
+        samples -= late;
+        timestamp = upipe_rtp_pcm_recv->base;
+    }
+
+    /* make room by moving the jitter window */
+    while (timestamp + samples > upipe_rtp_pcm_recv->base + window)
+        upipe_rtp_pcm_recv_advance(upipe, upump_p);
+
+    uint64_t pos = timestamp - upipe_rtp_pcm_recv->base;
+    while (samples) {
+        struct upipe_rtp_pcm_recv_frame *frame =
+            &upipe_rtp_pcm_recv->frames[(upipe_rtp_pcm_recv->head +
+                                         pos / frame_size) %
+                                        upipe_rtp_pcm_recv->nb_frames];
+        uint64_t local = pos % frame_size;
+        size_t n = frame_size - local;
+        if (n > samples)
+            n = samples;
+
+        if (frame->uref == NULL) {
+            int err = upipe_rtp_pcm_recv_start(upipe, frame, uref,
+                    upipe_rtp_pcm_recv->base + pos - local, packet_timestamp);
+            if (unlikely(!ubase_check(err))) {
+                upipe_throw_fatal(upipe, err);
+                return;
+            }
+        }
+        upipe_rtp_pcm_recv->convert(
+                frame->buffer + local * upipe_rtp_pcm_recv->channels,
+                payload, n * upipe_rtp_pcm_recv->channels);
+        frame->filled += n;
+        payload += n * in_frame;
+        pos += n;
+        samples -= n;
+    }
+
+    /* output the complete frames */
+    while (upipe_rtp_pcm_recv->frames[upipe_rtp_pcm_recv->head].filled >=
+           frame_size)
+        upipe_rtp_pcm_recv_advance(upipe, upump_p);
+}
+
+/** @internal @This receives RTP packets.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtp_pcm_recv_input(struct upipe *upipe, struct uref *uref,
+                                     struct upump **upump_p)
+{
+    struct upipe_rtp_pcm_recv *upipe_rtp_pcm_recv =
+        upipe_rtp_pcm_recv_from_upipe(upipe);
+    if (unlikely(upipe_rtp_pcm_recv->ubuf_mgr == NULL)) {
+        upipe_warn(upipe, "no ubuf manager, dropping packet");
+        uref_free(uref);
+        return;
+    }
+
+    size_t size;
+    if (unlikely(!ubase_check(uref_block_size(uref, &size)) ||
+                 size < RTP_HEADER_SIZE)) {
+        upipe_warn(upipe, "invalid buffer received");
+        uref_free(uref);
+        return;
+    }
+
+    /* packets from udpsrc are contiguous, merge the others */
+    const uint8_t *buffer;
+    int read_size = -1;
+    if (unlikely(!ubase_check(uref_block_read(uref, 0, &read_size,
+                                              &buffer)))) {
+        upipe_warn(upipe, "invalid buffer received");
+        uref_free(uref);
+        return;
+    }
+    if (unlikely(read_size < size)) {
+        uref_block_unmap(uref, 0);
+        read_size = -1;
+        if (unlikely(!ubase_check(uref_block_merge(uref, uref->ubuf->mgr,
+                                                   0, size)) ||
+                     !ubase_check(uref_block_read(uref, 0, &read_size,
+                                                  &buffer)))) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            uref_free(uref);
+            return;
+        }
+    }
+
+    size_t offset = RTP_HEADER_SIZE + 4 * rtp_get_cc(buffer);
+    size_t end = size;
+    if (rtp_check_extension(buffer)) {
+        if (offset + RTP_EXTENSION_SIZE <= size)
+            offset += 4 * (1 + rtpx_get_length(buffer + offset));
+        else
+            offset = SIZE_MAX;
+    }
+    if (rtp_check_padding(buffer))
+        end -= buffer[size - 1];
+    if (unlikely(!rtp_check_hdr(buffer) || offset > end)) {
+        upipe_warn(upipe, "invalid RTP header");
+        uref_block_unmap(uref, 0);
+        uref_free(uref);
+        return;
+    }
+
+    uint16_t seqnum = rtp_get_seqnum(buffer);
+    if (upipe_rtp_pcm_recv->expected_seqnum == -1)
+        upipe_rtp_pcm_recv->expected_seqnum = seqnum;
+    uint16_t gap = seqnum - upipe_rtp_pcm_recv->expected_seqnum;
+    if (likely(gap < 0x8000)) {
+        if (unlikely(gap)) {
+            upipe_dbg_va(upipe, "potentially lost %u RTP packets", gap);
+            upipe_rtp_pcm_recv->lost += gap;
+        }
+        upipe_rtp_pcm_recv->expected_seqnum = (seqnum + 1) & UINT16_MAX;
+    } else if (upipe_rtp_pcm_recv->lost) {
+        /* reordered packet previously counted as lost */
+        upipe_rtp_pcm_recv->lost--;
+    }
+
+    /* extend the timestamp to 64 bits, starting one wrap ahead so that
+     * earlier packets do not underflow */
+    uint32_t rtp_timestamp = rtp_get_timestamp(buffer);
+    uint64_t timestamp;
+    if (upipe_rtp_pcm_recv->last_timestamp == UINT64_MAX)
+        timestamp = (UINT64_C(1) << 32) + rtp_timestamp;
+    else
+        timestamp = upipe_rtp_pcm_recv->last_timestamp +
+            (int32_t)(rtp_timestamp -
+                      (uint32_t)upipe_rtp_pcm_recv->last_timestamp);
+    upipe_rtp_pcm_recv->last_timestamp = timestamp;
+
+    size_t samples = (end - offset) /
+        (upipe_rtp_pcm_recv->in_size * upipe_rtp_pcm_recv->channels);
+    if (samples)
+        upipe_rtp_pcm_recv_place(upipe, uref, timestamp, buffer + offset,
+                                 samples, upump_p);
+    uref_block_unmap(uref, 0);
+    uref_free(uref);
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_rtp_pcm_recv_set_flow_def(struct upipe *upipe,
+                                           struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, "block."))
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_rtp_pcm_recv_control(struct upipe *upipe, int command,
+                                      va_list args)
+{
+    struct upipe_rtp_pcm_recv *upipe_rtp_pcm_recv =
+        upipe_rtp_pcm_recv_from_upipe(upipe);
+
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_FLOW_FORMAT ||
+                request->type == UREQUEST_UBUF_MGR)
+                return upipe_throw_provide_request(upipe, request);
+            return upipe_rtp_pcm_recv_alloc_output_proxy(upipe, request);
+        }
+        case UPIPE_UNREGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_FLOW_FORMAT ||
+                request->type == UREQUEST_UBUF_MGR)
+                return UBASE_ERR_NONE;
+            return upipe_rtp_pcm_recv_free_output_proxy(upipe, request);
+        }
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_rtp_pcm_recv_set_flow_def(upipe, flow_def);
+        }
+        case UPIPE_FLUSH:
+            for (unsigned int i = 0; i < upipe_rtp_pcm_recv->nb_frames; i++)
+                upipe_rtp_pcm_recv_discard(&upipe_rtp_pcm_recv->frames[i]);
+            upipe_rtp_pcm_recv->head = 0;
+            upipe_rtp_pcm_recv->base = UINT64_MAX;
+            return UBASE_ERR_NONE;
+
+        case UPIPE_RTP_PCM_RECV_GET_FRAME_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_PCM_RECV_SIGNATURE)
+            unsigned int *frame_size_p = va_arg(args, unsigned int *);
+            *frame_size_p = upipe_rtp_pcm_recv->frame_size;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_RTP_PCM_RECV_SET_FRAME_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_PCM_RECV_SIGNATURE)
+            unsigned int frame_size = va_arg(args, unsigned int);
+            if (!frame_size)
+                return UBASE_ERR_INVALID;
+            upipe_rtp_pcm_recv_flush(upipe, NULL);
+            upipe_rtp_pcm_recv->frame_size = frame_size;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_RTP_PCM_RECV_GET_LATENCY: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_PCM_RECV_SIGNATURE)
+            unsigned int *latency_p = va_arg(args, unsigned int *);
+            *latency_p = upipe_rtp_pcm_recv->latency;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_RTP_PCM_RECV_SET_LATENCY: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_PCM_RECV_SIGNATURE)
+            upipe_rtp_pcm_recv->latency = va_arg(args, unsigned int);
+            return upipe_rtp_pcm_recv_alloc_ring(upipe);
+        }
+
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+        case UPIPE_GET_FLOW_DEF:
+            return upipe_rtp_pcm_recv_control_output(upipe, command, args);
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This frees all resources allocated.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_rtp_pcm_recv_free(struct upipe *upipe)
+{
+    struct upipe_rtp_pcm_recv *upipe_rtp_pcm_recv =
+        upipe_rtp_pcm_recv_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    if (upipe_rtp_pcm_recv->frames != NULL)
+        for (unsigned int i = 0; i < upipe_rtp_pcm_recv->nb_frames; i++)
+            upipe_rtp_pcm_recv_discard(&upipe_rtp_pcm_recv->frames[i]);
+    free(upipe_rtp_pcm_recv->frames);
+
+    upipe_rtp_pcm_recv_clean_ubuf_mgr(upipe);
+    upipe_rtp_pcm_recv_clean_output(upipe);
+    upipe_rtp_pcm_recv_clean_urefcount(upipe);
+    upipe_rtp_pcm_recv_free_flow(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_rtp_pcm_recv_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_RTP_PCM_RECV_SIGNATURE,
+
+    .upipe_alloc = upipe_rtp_pcm_recv_alloc,
+    .upipe_input = upipe_rtp_pcm_recv_input,
+    .upipe_control = upipe_rtp_pcm_recv_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for rtp_pcm_recv pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_rtp_pcm_recv_mgr_alloc(void)
+{
+    return &upipe_rtp_pcm_recv_mgr;
+}
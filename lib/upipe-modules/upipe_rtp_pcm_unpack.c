@@ -49,6 +49,8 @@
 #include <upipe/ubuf_sound.h>
 #include <upipe/ubuf_block.h>
 
+#include "upipe_pcm_convert.h"
+
 struct upipe_rtp_pcm_unpack {
     /** refcount management structure */
     struct urefcount urefcount;
@@ -252,8 +254,7 @@ static bool upipe_rtp_pcm_unpack_handle(struct upipe *upipe, struct uref *uref,
     uref_block_read(uref, 0, &size, &src);
     ubuf_sound_write_int32_t(ubuf, 0, -1, &dst, 1);
 
-    for (int i = 0; i < s; i++)
-        dst[i] = (src[3*i] << 24) | (src[3*i+1] << 16) | (src[3*i+2] << 8);
+    upipe_pcm_s24be_to_s32(dst, src, s);
 
     ubuf_sound_unmap(ubuf, 0, -1, 1);
     uref_block_unmap(uref, 0);
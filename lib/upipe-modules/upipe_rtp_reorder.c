@@ -39,6 +39,7 @@
 #include <upipe/uclock.h>
 #include <upipe/upipe.h>
 #include <upipe/ulist.h>
+#include <upipe/uref_ring.h>
 #include <upipe/upipe_helper_upipe.h>
 #include <upipe/upipe_helper_upump_mgr.h>
 #include <upipe/upipe_helper_upump.h>
@@ -102,7 +103,8 @@ struct upipe_rtpr {
     /** manager to create subs */
     struct upipe_mgr sub_mgr;
 
-    struct uchain queue;
+    /** packets waiting for their date, indexed by sequence number */
+    struct uref_ring queue;
 
     uint64_t last_sent_seqnum;
     uint64_t num_consecutive_late;
@@ -268,33 +270,25 @@ static void upipe_rtpr_timer(struct upump *upump)
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     struct upipe_rtpr *rtpr = upipe_rtpr_from_upipe(upipe);
     uint64_t now = uclock_now(rtpr->uclock);
-    uint64_t date_sys;
-    int type;
-    struct uchain *uchain, *uchain_tmp;
     struct uref *uref;
+    uint16_t seqnum;
 
-    ulist_delete_foreach(&rtpr->queue, uchain, uchain_tmp) {
-        uref = uref_from_uchain(uchain);
+    while ((uref = uref_ring_peek(&rtpr->queue, &seqnum)) != NULL) {
+        uint64_t date_sys = UINT64_MAX;
+        int type;
         uref_clock_get_date_sys(uref, &date_sys, &type);
-        uint64_t seqnum = 0;
-        uref_attr_get_priv(uref, &seqnum);
-
-        if (now >= date_sys || date_sys == UINT64_MAX) {
-            ulist_delete(uchain);
-            upipe_rtpr_output(upipe, uref, NULL);
-            rtpr->last_sent_seqnum = seqnum;
-        }
-        else {
+        if (now < date_sys && date_sys != UINT64_MAX)
             break;
-        }
+
+        uref_ring_pop(&rtpr->queue, NULL);
+        upipe_rtpr_output(upipe, uref, NULL);
+        rtpr->last_sent_seqnum = seqnum;
     }
 }
 
 static void upipe_rtpr_list_add(struct upipe *upipe, struct uref *uref)
 {
     struct upipe_rtpr *rtpr = upipe_rtpr_from_upipe(upipe);
-    int dup = 0, ooo = 0;
-    struct uchain *uchain, *uchain_tmp;
 
     uint8_t rtp_buffer[RTP_HEADER_SIZE];
     const uint8_t *rtp_header = uref_block_peek(uref, 0, RTP_HEADER_SIZE,
@@ -306,7 +300,6 @@ static void upipe_rtpr_list_add(struct upipe *upipe, struct uref *uref)
         return;
     }
     uint16_t new_seqnum = rtp_get_seqnum(rtp_header);
-    uref_attr_set_priv(uref, new_seqnum);
     uref_block_peek_unmap(uref, 0, rtp_buffer, rtp_header);
 
     /* Drop late packets */
@@ -325,45 +318,20 @@ static void upipe_rtpr_list_add(struct upipe *upipe, struct uref *uref)
     rtpr->num_consecutive_late = 0;
 
     /* Remove date_sys for any late packets */
-    ulist_delete_foreach_reverse(&rtpr->queue, uchain, uchain_tmp) {
-        struct uref *cur_uref = uref_from_uchain(uchain);
-        uint64_t seqnum = 0;
-        uref_attr_get_priv(cur_uref, &seqnum);
-
-        if (seq_num_lt(new_seqnum, seqnum)) {
-            if (ulist_is_first(&rtpr->queue, uchain)) {
-                uref_clock_delete_date_sys(uref);
-                ulist_insert(uchain->prev, uchain, uref_to_uchain(uref));
-                ooo = 1;
-                break;
-            }
-            else {
-                struct uref *prev_uref = uref_from_uchain(uchain->prev);
-                uint64_t prev_seqnum = 0;
-                uref_attr_get_priv(prev_uref, &prev_seqnum);
-                if (!seq_num_lt(new_seqnum, prev_seqnum) && !(new_seqnum == prev_seqnum)) {
-                    uref_clock_delete_date_sys(uref);
-                    ulist_insert(uchain->prev, uchain, uref_to_uchain(uref));
-                    ooo = 1;
-                    break;
-                }
-            }
-        }
-        /* Duplicate packet */
-        else if (new_seqnum == seqnum) {
-            dup = 1;
-            uref_free(uref);
-            break;
-        }
-        else
-            break;
+    if (uref_ring_is_late(&rtpr->queue, new_seqnum))
+        uref_clock_delete_date_sys(uref);
+
+    /* Output the oldest packets early if the window is exceeded */
+    while (!uref_ring_fits(&rtpr->queue, new_seqnum)) {
+        uint16_t seqnum;
+        struct uref *old = uref_ring_pop(&rtpr->queue, &seqnum);
+        upipe_rtpr_output(upipe, old, NULL);
+        rtpr->last_sent_seqnum = seqnum;
     }
 
-
-    /* Add to end if normal packet */
-    if (!dup && !ooo) {
-        ulist_add(&rtpr->queue, uref_to_uchain(uref));
-    }
+    /* Duplicate packet */
+    if (!ubase_check(uref_ring_insert(&rtpr->queue, new_seqnum, uref)))
+        uref_free(uref);
 }
 
 /** @internal @This receives data.
@@ -440,19 +408,6 @@ static void upipe_rtpr_init_sub_mgr(struct upipe *upipe)
     sub_mgr->upipe_mgr_control = NULL;
 }
 
-static void upipe_rtpr_clean_queue(struct upipe *upipe)
-{
-    struct upipe_rtpr *rtpr = upipe_rtpr_from_upipe(upipe);
-    struct uchain *uchain, *uchain_tmp;
-    struct uref *uref;
-
-    ulist_delete_foreach(&rtpr->queue, uchain, uchain_tmp) {
-        uref = uref_from_uchain(uchain);
-        ulist_delete(uchain);
-        uref_free(uref);
-    }
-}
-
 /** @internal @This allocates a rtpr pipe.
  *
  * @param mgr common management structure
@@ -470,6 +425,11 @@ static struct upipe *upipe_rtpr_alloc(struct upipe_mgr *mgr,
         return NULL;
 
     struct upipe_rtpr *upipe_rtpr = upipe_rtpr_from_upipe(upipe);
+    if (unlikely(!ubase_check(uref_ring_init(&upipe_rtpr->queue,
+                                             UREF_RING_MAX_SIZE)))) {
+        upipe_rtpr_free_void(upipe);
+        return NULL;
+    }
     upipe_rtpr_init_urefcount(upipe);
 
     urefcount_init(upipe_rtpr_to_urefcount_real(upipe_rtpr),
@@ -484,8 +444,6 @@ static struct upipe *upipe_rtpr_alloc(struct upipe_mgr *mgr,
 
     upipe_rtpr->flow_def_input = NULL;
 
-    ulist_init(&upipe_rtpr->queue);
-
     upipe_rtpr->last_sent_seqnum = UINT64_MAX;
     upipe_rtpr->num_consecutive_late = 0;
     upipe_rtpr->delay = UCLOCK_FREQ/10;
@@ -615,7 +573,7 @@ static void upipe_rtpr_free(struct urefcount *urefcount_real)
 
     upump_stop(upipe_rtpr->upump2);
     upump_free(upipe_rtpr->upump2);
-    upipe_rtpr_clean_queue(upipe);
+    uref_ring_clean(&upipe_rtpr->queue);
 
     upipe_rtpr_clean_uclock(upipe);
     upipe_rtpr_clean_sub_inputs(upipe);
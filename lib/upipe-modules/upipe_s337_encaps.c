@@ -123,6 +123,21 @@ static int upipe_s337_encaps_check(struct upipe *upipe, struct uref *flow_format
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This packs big-endian 16-bit words of a burst payload into
+ * the upper half of 32-bit samples. The loop has no dependency between
+ * iterations so that it is vectorized by the compiler.
+ *
+ * @param out pointer to output samples
+ * @param in pointer to payload octets
+ * @param words number of 16-bit words to pack
+ */
+static void upipe_s337_encaps_pack16(int32_t *restrict out,
+                                     const uint8_t *restrict in, size_t words)
+{
+    for (size_t i = 0; i < words; i++)
+        out[i] = ((uint32_t)in[2*i + 0] << 24) | ((uint32_t)in[2*i + 1] << 16);
+}
+
 /** @internal @This inputs data.
  *
  * @param upipe description structure of the pipe
@@ -184,6 +199,8 @@ static bool upipe_s337_encaps_handle(struct upipe *upipe, struct uref *uref,
         (S337_TYPE_A52_REP_RATE_FLAG << 24);
     out_data[3] = ((block_size * 8) & 0xffff) << 16;
 
+    size_t words = 4;
+    int carry = -1;
     int offset = 0;
     while (block_size) {
         const uint8_t *buf;
@@ -196,8 +213,21 @@ static bool upipe_s337_encaps_handle(struct upipe *upipe, struct uref *uref,
             return true;
         }
 
-        for (int i = 0; i < size/2; i++)
-            out_data[4 + offset/2 + i] = (buf[2*i + 0] << 24) | (buf[2*i + 1] << 16);
+        /* complete a word split across two segments */
+        int i = 0;
+        if (carry >= 0) {
+            out_data[words++] = ((uint32_t)carry << 24) |
+                                ((uint32_t)buf[0] << 16);
+            carry = -1;
+            i = 1;
+        }
+
+        size_t pairs = (size - i) / 2;
+        upipe_s337_encaps_pack16(&out_data[words], buf + i, pairs);
+        words += pairs;
+        i += 2 * pairs;
+        if (i < size)
+            carry = buf[i];
 
         uref_block_unmap(uref, offset);
 
@@ -205,7 +235,10 @@ static bool upipe_s337_encaps_handle(struct upipe *upipe, struct uref *uref,
         offset += size;
     }
 
-    memset(&out_data[4 + offset/2], 0, 4 * (A52_FRAME_SAMPLES*2 - 4 - offset/2));
+    if (carry >= 0)
+        out_data[words++] = (uint32_t)carry << 24;
+
+    memset(&out_data[words], 0, 4 * (A52_FRAME_SAMPLES*2 - words));
 
     ubuf_sound_unmap(ubuf, 0, -1, 1);
 
@@ -23,7 +23,12 @@
 
 #include <upipe-modules/upipe_sequential_source.h>
 #include <upipe-modules/upipe_probe_uref.h>
+#include <upipe/uref_block.h>
 #include <upipe/upipe_helper_uclock.h>
+#include <upipe/upipe_helper_input.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe/upipe_helper_upump_mgr.h>
+#include <upipe/upipe_helper_upump.h>
 #include <upipe/upipe_helper_bin_output.h>
 #include <upipe/upipe_helper_inner.h>
 #include <upipe/upipe_helper_uprobe.h>
@@ -46,6 +51,13 @@ struct upipe_seq_src {
     struct urefcount inner_ref;
     struct uclock *uclock;
     struct urequest uclock_request;
+    /** inner source when prefetching, its output is the prefetch gate */
+    struct upipe *source;
+    /** true when the inner source is dead */
+    bool source_done;
+    /** true when the prefetch gate does not hold anything anymore */
+    bool drained;
+    struct uprobe probe_prefetch;
 };
 
 static int probe_src(struct uprobe *uprobe, struct upipe *inner,
@@ -56,6 +68,7 @@ UPIPE_HELPER_UREFCOUNT(upipe_seq_src, urefcount, upipe_seq_src_no_ref);
 UPIPE_HELPER_VOID(upipe_seq_src);
 UPIPE_HELPER_INNER(upipe_seq_src, src);
 UPIPE_HELPER_UPROBE(upipe_seq_src, urefcount_real, probe_src, probe_src);
+UPIPE_HELPER_UPROBE(upipe_seq_src, urefcount_real, probe_prefetch, NULL);
 UPIPE_HELPER_BIN_OUTPUT(upipe_seq_src, src, output, requests);
 UPIPE_HELPER_UCLOCK(upipe_seq_src, uclock, uclock_request, NULL,
                     upipe_seq_src_register_bin_output_request,
@@ -74,12 +87,194 @@ struct upipe_seq_src_mgr {
     struct upipe_mgr *source_mgr;
     struct uchain jobs;
     struct urefcount *lock;
+    /** number of octets to read ahead from the next job, 0 to disable */
+    uint64_t prefetch;
+    /** job being prefetched */
+    struct upipe_seq_src *prefetched;
 };
 
 UBASE_FROM_TO(upipe_seq_src_mgr, upipe_mgr, mgr, mgr);
 UBASE_FROM_TO(upipe_seq_src_mgr, urefcount, urefcount, urefcount);
 
 static int upipe_seq_src_mgr_next(struct upipe_mgr *mgr);
+static void upipe_seq_src_drained(struct upipe *upipe);
+
+/*
+ * prefetch gate
+ */
+
+/** @internal @This is the private context of a prefetch gate. It holds the
+ * beginning of a job while the previous one is playing, and lets everything
+ * through once opened. */
+struct upipe_seq_src_gate {
+    struct upipe upipe;
+    struct urefcount urefcount;
+
+    struct uchain urefs;
+    unsigned int nb_urefs;
+    unsigned int max_urefs;
+    struct uchain blockers;
+
+    struct upipe *output;
+    struct uref *flow_def;
+    enum upipe_helper_output_state output_state;
+    struct uchain request_list;
+
+    struct upump_mgr *upump_mgr;
+    struct upump *upump;
+
+    /** sequential source pipe to notify, or NULL */
+    struct upipe *job;
+    /** octets currently held */
+    uint64_t size;
+    /** octets to hold before blocking the source */
+    uint64_t max_size;
+    /** true when the job is playing */
+    bool open;
+};
+
+static bool upipe_seq_src_gate_process(struct upipe *upipe,
+                                       struct uref *uref,
+                                       struct upump **upump_p);
+
+UPIPE_HELPER_UPIPE(upipe_seq_src_gate, upipe,
+                   UPIPE_SEQ_SRC_GATE_SIGNATURE);
+UPIPE_HELPER_UREFCOUNT(upipe_seq_src_gate, urefcount,
+                       upipe_seq_src_gate_free);
+UPIPE_HELPER_VOID(upipe_seq_src_gate);
+UPIPE_HELPER_INPUT(upipe_seq_src_gate, urefs, nb_urefs, max_urefs, blockers,
+                   upipe_seq_src_gate_process);
+UPIPE_HELPER_OUTPUT(upipe_seq_src_gate, output, flow_def, output_state,
+                    request_list);
+UPIPE_HELPER_UPUMP_MGR(upipe_seq_src_gate, upump_mgr);
+UPIPE_HELPER_UPUMP(upipe_seq_src_gate, upump, upump_mgr);
+
+static struct upipe *upipe_seq_src_gate_alloc(struct upipe_mgr *mgr,
+                                              struct uprobe *uprobe,
+                                              uint32_t signature,
+                                              va_list args)
+{
+    struct upipe *upipe =
+        upipe_seq_src_gate_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    upipe_seq_src_gate_init_urefcount(upipe);
+    upipe_seq_src_gate_init_input(upipe);
+    upipe_seq_src_gate_init_output(upipe);
+    upipe_seq_src_gate_init_upump_mgr(upipe);
+    upipe_seq_src_gate_init_upump(upipe);
+
+    struct upipe_seq_src_gate *gate = upipe_seq_src_gate_from_upipe(upipe);
+    gate->job = NULL;
+    gate->size = 0;
+    gate->max_size = UINT64_MAX;
+    gate->open = false;
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+static void upipe_seq_src_gate_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+
+    upipe_seq_src_gate_clean_upump(upipe);
+    upipe_seq_src_gate_clean_upump_mgr(upipe);
+    upipe_seq_src_gate_clean_output(upipe);
+    upipe_seq_src_gate_clean_input(upipe);
+    upipe_seq_src_gate_clean_urefcount(upipe);
+    upipe_seq_src_gate_free_void(upipe);
+}
+
+static bool upipe_seq_src_gate_process(struct upipe *upipe,
+                                       struct uref *uref,
+                                       struct upump **upump_p)
+{
+    upipe_seq_src_gate_output(upipe, uref, upump_p);
+    return true;
+}
+
+static void upipe_seq_src_gate_input(struct upipe *upipe,
+                                     struct uref *uref,
+                                     struct upump **upump_p)
+{
+    struct upipe_seq_src_gate *gate = upipe_seq_src_gate_from_upipe(upipe);
+
+    if (gate->open && upipe_seq_src_gate_check_input(upipe)) {
+        upipe_seq_src_gate_output(upipe, uref, upump_p);
+        return;
+    }
+
+    size_t size = 0;
+    uref_block_size(uref, &size);
+    gate->size += size;
+    upipe_seq_src_gate_hold_input(upipe, uref);
+    if (gate->size >= gate->max_size)
+        upipe_seq_src_gate_block_input(upipe, upump_p);
+}
+
+/** @internal @This outputs the held urefs and notifies the job. */
+static void upipe_seq_src_gate_drain(struct upipe *upipe)
+{
+    struct upipe_seq_src_gate *gate = upipe_seq_src_gate_from_upipe(upipe);
+
+    upipe_seq_src_gate_output_input(upipe);
+    upipe_seq_src_gate_unblock_input(upipe);
+    gate->size = 0;
+    if (gate->job != NULL)
+        upipe_seq_src_drained(gate->job);
+}
+
+static void upipe_seq_src_gate_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    upipe_seq_src_gate_set_upump(upipe, NULL);
+    upipe_seq_src_gate_drain(upipe);
+}
+
+/** @internal @This opens the gate when the job starts playing. The held
+ * urefs are output from an idler so that the caller, typically the end of
+ * the previous job, is not reentered. */
+static void upipe_seq_src_gate_open(struct upipe *upipe)
+{
+    struct upipe_seq_src_gate *gate = upipe_seq_src_gate_from_upipe(upipe);
+
+    gate->open = true;
+    upipe_seq_src_gate_check_upump_mgr(upipe);
+    if (gate->upump_mgr == NULL || upipe_seq_src_gate_check_input(upipe))
+        upipe_seq_src_gate_drain(upipe);
+    else
+        upipe_seq_src_gate_wait_upump(upipe, 0, upipe_seq_src_gate_worker);
+}
+
+static int upipe_seq_src_gate_control(struct upipe *upipe,
+                                      int command,
+                                      va_list args)
+{
+    UBASE_HANDLED_RETURN(upipe_seq_src_gate_control_output(upipe, command,
+                                                           args));
+    switch (command) {
+    case UPIPE_ATTACH_UPUMP_MGR:
+        return upipe_seq_src_gate_attach_upump_mgr(upipe);
+    case UPIPE_SET_FLOW_DEF: {
+        struct uref *flow_def = va_arg(args, struct uref *);
+        struct uref *flow_def_dup = uref_dup(flow_def);
+        UBASE_ALLOC_RETURN(flow_def_dup);
+        upipe_seq_src_gate_store_flow_def(upipe, flow_def_dup);
+        return UBASE_ERR_NONE;
+    }
+    }
+    return UBASE_ERR_UNHANDLED;
+}
+
+static struct upipe_mgr upipe_seq_src_gate_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_SEQ_SRC_GATE_SIGNATURE,
+    .upipe_alloc = upipe_seq_src_gate_alloc,
+    .upipe_input = upipe_seq_src_gate_input,
+    .upipe_control = upipe_seq_src_gate_control,
+};
 
 /*
  * pipe
@@ -93,7 +288,12 @@ static int probe_src(struct uprobe *uprobe, struct upipe *inner,
 
     switch (event) {
     case UPROBE_SOURCE_END:
-        upipe_seq_src_store_bin_output(upipe, NULL);
+        if (upipe_seq_src->source != NULL) {
+            struct upipe *source = upipe_seq_src->source;
+            upipe_seq_src->source = NULL;
+            upipe_release(source);
+        } else
+            upipe_seq_src_store_bin_output(upipe, NULL);
         break;
     }
 
@@ -112,6 +312,7 @@ static struct upipe *upipe_seq_src_alloc(struct upipe_mgr *mgr,
 
     upipe_seq_src_init_urefcount(upipe);
     upipe_seq_src_init_probe_src(upipe);
+    upipe_seq_src_init_probe_prefetch(upipe);
     upipe_seq_src_init_bin_output(upipe);
     upipe_seq_src_init_uclock(upipe);
 
@@ -119,6 +320,9 @@ static struct upipe *upipe_seq_src_alloc(struct upipe_mgr *mgr,
     urefcount_init(&upipe_seq_src->urefcount_real, upipe_seq_src_free);
     uchain_init(&upipe_seq_src->uchain);
     upipe_seq_src->uri = NULL;
+    upipe_seq_src->source = NULL;
+    upipe_seq_src->source_done = false;
+    upipe_seq_src->drained = true;
 
     upipe_throw_ready(upipe);
 
@@ -137,17 +341,57 @@ static void upipe_seq_src_free(struct urefcount *urefcount)
     urefcount_clean(&upipe_seq_src->urefcount_real);
     upipe_seq_src_clean_uclock(upipe);
     upipe_seq_src_clean_bin_output(upipe);
+    upipe_seq_src_clean_probe_prefetch(upipe);
     upipe_seq_src_clean_probe_src(upipe);
     upipe_seq_src_clean_urefcount(upipe);
     upipe_seq_src_free_void(upipe);
 }
 
+/** @internal @This releases the lock if the job is playing and has
+ * completed, that is its source is dead and nothing is left in the
+ * prefetch gate. */
+static void upipe_seq_src_check_done(struct upipe *upipe)
+{
+    struct upipe_seq_src *upipe_seq_src = upipe_seq_src_from_upipe(upipe);
+    struct upipe_seq_src_mgr *upipe_seq_src_mgr =
+        upipe_seq_src_mgr_from_mgr(upipe->mgr);
+
+    if (!upipe_seq_src->source_done || !upipe_seq_src->drained ||
+        upipe_seq_src_mgr->lock != &upipe_seq_src->inner_ref)
+        return;
+
+    upipe_seq_src_mgr->lock = NULL;
+    upipe_seq_src_mgr_next(upipe->mgr);
+}
+
+/** @internal @This stops a prefetched or playing job and releases its inner
+ * pipes. */
+static void upipe_seq_src_cancel(struct upipe *upipe)
+{
+    struct upipe_seq_src *upipe_seq_src = upipe_seq_src_from_upipe(upipe);
+    struct upipe_seq_src_mgr *upipe_seq_src_mgr =
+        upipe_seq_src_mgr_from_mgr(upipe->mgr);
+
+    if (upipe_seq_src_mgr->prefetched == upipe_seq_src)
+        upipe_seq_src_mgr->prefetched = NULL;
+    if (upipe_seq_src->src != NULL &&
+        upipe_seq_src->src->mgr == &upipe_seq_src_gate_mgr)
+        upipe_seq_src_gate_from_upipe(upipe_seq_src->src)->job = NULL;
+    upipe_seq_src->drained = true;
+
+    struct upipe *source = upipe_seq_src->source;
+    upipe_seq_src->source = NULL;
+    upipe_release(source);
+    upipe_seq_src_store_bin_output(upipe, NULL);
+}
+
 static void upipe_seq_src_no_ref(struct upipe *upipe)
 {
     struct upipe_seq_src *upipe_seq_src = upipe_seq_src_from_upipe(upipe);
     if (ulist_is_in(&upipe_seq_src->uchain))
         ulist_delete(&upipe_seq_src->uchain);
-    upipe_seq_src_store_bin_output(upipe, NULL);
+    upipe_seq_src_cancel(upipe);
+    upipe_seq_src_check_done(upipe);
     urefcount_release(&upipe_seq_src->urefcount_real);
 }
 
@@ -156,15 +400,22 @@ static void upipe_seq_src_done(struct urefcount *urefcount)
     struct upipe_seq_src *upipe_seq_src =
         upipe_seq_src_from_inner_ref(urefcount);
     struct upipe *upipe = upipe_seq_src_to_upipe(upipe_seq_src);
-    struct upipe_seq_src_mgr *upipe_seq_src_mgr =
-        upipe_seq_src_mgr_from_mgr(upipe->mgr);
 
     upipe_seq_src->probe_src.refcount = NULL;
-    upipe_seq_src_mgr->lock = NULL;
-    upipe_seq_src_mgr_next(upipe->mgr);
+    upipe_seq_src->source_done = true;
+    upipe_seq_src_check_done(upipe);
     urefcount_release(&upipe_seq_src->urefcount_real);
 }
 
+/** @internal @This is called by the prefetch gate once it has output
+ * everything it held. */
+static void upipe_seq_src_drained(struct upipe *upipe)
+{
+    struct upipe_seq_src *upipe_seq_src = upipe_seq_src_from_upipe(upipe);
+    upipe_seq_src->drained = true;
+    upipe_seq_src_check_done(upipe);
+}
+
 static inline void upipe_seq_src_set_inner(struct upipe *upipe,
                                            struct upipe *inner)
 {
@@ -175,12 +426,14 @@ static inline void upipe_seq_src_set_inner(struct upipe *upipe,
         upipe_attach_uclock(inner);
 }
 
-static int upipe_seq_src_worker(struct upipe *upipe)
+static int upipe_seq_src_worker(struct upipe *upipe, bool prefetch)
 {
     struct upipe_seq_src *upipe_seq_src = upipe_seq_src_from_upipe(upipe);
     struct upipe_seq_src_mgr *upipe_seq_src_mgr =
         upipe_seq_src_mgr_from_mgr(upipe->mgr);
 
+    upipe_seq_src->source_done = false;
+    upipe_seq_src->drained = true;
     urefcount_init(&upipe_seq_src->inner_ref, upipe_seq_src_done);
     urefcount_use(&upipe_seq_src->urefcount_real);
     upipe_seq_src->probe_src.refcount = &upipe_seq_src->inner_ref;
@@ -195,7 +448,31 @@ static int upipe_seq_src_worker(struct upipe *upipe)
         upipe_release(inner);
         return ret;
     }
-    upipe_seq_src_set_inner(upipe, inner);
+    if (!prefetch) {
+        upipe_seq_src_set_inner(upipe, inner);
+        return UBASE_ERR_NONE;
+    }
+
+    struct upipe *gate = upipe_void_alloc(
+        &upipe_seq_src_gate_mgr,
+        uprobe_pfx_alloc(uprobe_use(&upipe_seq_src->probe_prefetch),
+                         UPROBE_LOG_VERBOSE, "prefetch"));
+    if (unlikely(gate == NULL)) {
+        upipe_release(inner);
+        return UBASE_ERR_ALLOC;
+    }
+    struct upipe_seq_src_gate *upipe_seq_src_gate =
+        upipe_seq_src_gate_from_upipe(gate);
+    upipe_seq_src_gate->job = upipe;
+    upipe_seq_src_gate->max_size = upipe_seq_src_mgr->prefetch;
+    upipe_seq_src->drained = false;
+
+    /* the gate is the last inner pipe, the source only feeds it */
+    upipe_seq_src->source = inner;
+    upipe_set_output(inner, gate);
+    upipe_seq_src_store_bin_output(upipe, gate);
+    if (upipe_seq_src->uclock)
+        upipe_attach_uclock(inner);
     return UBASE_ERR_NONE;
 }
 
@@ -207,6 +484,8 @@ static int upipe_seq_src_set_uri(struct upipe *upipe, const char *uri)
 
     if (ulist_is_in(&upipe_seq_src->uchain))
         ulist_delete(&upipe_seq_src->uchain);
+    if (upipe_seq_src_mgr->prefetched == upipe_seq_src)
+        upipe_seq_src_cancel(upipe);
     if (upipe_seq_src->uri)
         free(upipe_seq_src->uri);
     upipe_seq_src->uri = NULL;
@@ -247,7 +526,8 @@ static int upipe_seq_src_control(struct upipe *upipe,
     case UPIPE_BIN_GET_FIRST_INNER: {
         struct upipe_seq_src *upipe_seq_src = upipe_seq_src_from_upipe(upipe);
         struct upipe **p = va_arg(args, struct upipe **);
-        *p = upipe_seq_src->src;
+        *p = upipe_seq_src->source != NULL ? upipe_seq_src->source :
+             upipe_seq_src->src;
         return (*p != NULL) ? UBASE_ERR_NONE : UBASE_ERR_UNHANDLED;
     }
     }
@@ -276,6 +556,8 @@ struct upipe_mgr *upipe_seq_src_mgr_alloc(void)
     upipe_seq_src_mgr->mgr.upipe_control = upipe_seq_src_control;
     upipe_seq_src_mgr->source_mgr = NULL;
     upipe_seq_src_mgr->lock = NULL;
+    upipe_seq_src_mgr->prefetch = 0;
+    upipe_seq_src_mgr->prefetched = NULL;
     ulist_init(&upipe_seq_src_mgr->jobs);
 
     return upipe_seq_src_mgr_to_mgr(upipe_seq_src_mgr);
@@ -303,19 +585,68 @@ int upipe_seq_src_mgr_set_source_mgr(struct upipe_mgr *mgr,
     return UBASE_ERR_NONE;
 }
 
+int upipe_seq_src_mgr_set_prefetch(struct upipe_mgr *mgr, uint64_t size)
+{
+    struct upipe_seq_src_mgr *upipe_seq_src_mgr =
+        upipe_seq_src_mgr_from_mgr(mgr);
+    upipe_seq_src_mgr->prefetch = size;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This opens and starts reading the next queued job while the
+ * current one is playing. */
+static void upipe_seq_src_mgr_prefetch(struct upipe_mgr *mgr)
+{
+    struct upipe_seq_src_mgr *upipe_seq_src_mgr =
+        upipe_seq_src_mgr_from_mgr(mgr);
+
+    if (!upipe_seq_src_mgr->prefetch || upipe_seq_src_mgr->lock == NULL ||
+        upipe_seq_src_mgr->prefetched != NULL)
+        return;
+
+    struct uchain *uchain = ulist_pop(&upipe_seq_src_mgr->jobs);
+    if (uchain == NULL)
+        return;
+
+    struct upipe_seq_src *upipe_seq_src = upipe_seq_src_from_uchain(uchain);
+    struct upipe *upipe = upipe_seq_src_to_upipe(upipe_seq_src);
+    upipe_seq_src_mgr->prefetched = upipe_seq_src;
+    int ret = upipe_seq_src_worker(upipe, true);
+    if (unlikely(!ubase_check(ret)))
+        upipe_warn_va(upipe, "unable to prefetch %s", upipe_seq_src->uri);
+}
+
 static int upipe_seq_src_mgr_next(struct upipe_mgr *mgr)
 {
     struct upipe_seq_src_mgr *upipe_seq_src_mgr =
         upipe_seq_src_mgr_from_mgr(mgr);
 
-    if (unlikely(upipe_seq_src_mgr->lock))
+    if (unlikely(upipe_seq_src_mgr->lock)) {
+        upipe_seq_src_mgr_prefetch(mgr);
+        return UBASE_ERR_NONE;
+    }
+
+    struct upipe_seq_src *upipe_seq_src = upipe_seq_src_mgr->prefetched;
+    if (upipe_seq_src != NULL) {
+        struct upipe *upipe = upipe_seq_src_to_upipe(upipe_seq_src);
+        upipe_seq_src_mgr->prefetched = NULL;
+        upipe_seq_src_mgr->lock = &upipe_seq_src->inner_ref;
+        if (upipe_seq_src->drained)
+            upipe_seq_src_check_done(upipe);
+        else
+            upipe_seq_src_gate_open(upipe_seq_src->src);
+        upipe_seq_src_mgr_prefetch(mgr);
         return UBASE_ERR_NONE;
+    }
 
     struct uchain *uchain = ulist_pop(&upipe_seq_src_mgr->jobs);
     if (unlikely(uchain == NULL))
         return UBASE_ERR_NONE;
 
-    struct upipe_seq_src *upipe_seq_src = upipe_seq_src_from_uchain(uchain);
+    upipe_seq_src = upipe_seq_src_from_uchain(uchain);
     upipe_seq_src_mgr->lock = &upipe_seq_src->inner_ref;
-    return upipe_seq_src_worker(upipe_seq_src_to_upipe(upipe_seq_src));
+    int ret = upipe_seq_src_worker(upipe_seq_src_to_upipe(upipe_seq_src),
+                                   false);
+    upipe_seq_src_mgr_prefetch(mgr);
+    return ret;
 }
@@ -30,7 +30,7 @@
 #include <upipe/ubase.h>
 #include <upipe/uprobe.h>
 #include <upipe/uref.h>
-#include <upipe/uref.h>
+#include <upipe/uref_attr.h>
 #include <upipe/uref_flow.h>
 #include <upipe/upipe.h>
 #include <upipe/upipe_helper_upipe.h>
@@ -110,32 +110,11 @@ static void upipe_setattr_input(struct upipe *upipe, struct uref *uref,
         return;
     }
 
-    if (upipe_setattr->dict->udict != NULL) {
-        if (uref->udict == NULL) {
-            uref->udict = udict_alloc(uref->mgr->udict_mgr, 0);
-            if (unlikely(uref->udict == NULL)) {
-                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-                uref_free(uref);
-                return;
-            }
-        }
-        const char *name = NULL;
-        enum udict_type type = UDICT_TYPE_END;
-        while (ubase_check(udict_iterate(upipe_setattr->dict->udict,
-                                         &name, &type)) &&
-               type != UDICT_TYPE_END) {
-            size_t size;
-            const uint8_t *v1 = NULL;
-            udict_get(upipe_setattr->dict->udict, name, type, &size, &v1);
-            uint8_t *v2 = NULL;
-            udict_set(uref->udict, name, type, size, &v2);
-            if (unlikely(v1 == NULL || v2 == NULL)) {
-                uref_free(uref);
-                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-                return;
-            }
-            memcpy(v2, v1, size);
-        }
+    if (unlikely(!ubase_check(uref_attr_import(uref,
+                                               upipe_setattr->dict)))) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
     }
     upipe_setattr_output(upipe, uref, upump_p);
 }
@@ -30,7 +30,7 @@
 #include <upipe/ubase.h>
 #include <upipe/uprobe.h>
 #include <upipe/uref.h>
-#include <upipe/uref.h>
+#include <upipe/uref_attr.h>
 #include <upipe/uref_flow.h>
 #include <upipe/upipe.h>
 #include <upipe/upipe_helper_upipe.h>
@@ -132,30 +132,10 @@ static int upipe_setflowdef_build_flow_def(struct upipe *upipe)
         return UBASE_ERR_NONE;
     }
 
-    if (upipe_setflowdef->dict->udict != NULL) {
-        if (flow_def_dup->udict == NULL) {
-            flow_def_dup->udict = udict_alloc(flow_def_dup->mgr->udict_mgr, 0);
-            if (unlikely(flow_def_dup->udict == NULL)) {
-                uref_free(flow_def_dup);
-                return UBASE_ERR_ALLOC;
-            }
-        }
-        const char *name = NULL;
-        enum udict_type type = UDICT_TYPE_END;
-        while (ubase_check(udict_iterate(upipe_setflowdef->dict->udict,
-                                         &name, &type)) &&
-               type != UDICT_TYPE_END) {
-            size_t size;
-            const uint8_t *v1 = NULL;
-            udict_get(upipe_setflowdef->dict->udict, name, type, &size, &v1);
-            uint8_t *v2 = NULL;
-            udict_set(flow_def_dup->udict, name, type, size, &v2);
-            if (unlikely(v1 == NULL || v2 == NULL)) {
-                uref_free(flow_def_dup);
-                return UBASE_ERR_ALLOC;
-            }
-            memcpy(v2, v1, size);
-        }
+    if (unlikely(!ubase_check(uref_attr_import(flow_def_dup,
+                                               upipe_setflowdef->dict)))) {
+        uref_free(flow_def_dup);
+        return UBASE_ERR_ALLOC;
     }
 
     upipe_setflowdef_store_flow_def(upipe, flow_def_dup);
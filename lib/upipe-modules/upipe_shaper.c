@@ -0,0 +1,709 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module shaping several flows with hierarchical token buckets
+ *
+ * Tokens are counted in octets multiplied by @ref #UCLOCK_FREQ, so that the
+ * refill of a bucket is exact whatever the elapsed time and the rate. A
+ * packet may be sent as soon as the buckets of its flow and of the super
+ * pipe are not empty; its size is then deducted, possibly making the buckets
+ * negative. This keeps the long-term rates exact even when the burst budget
+ * is smaller than a packet.
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/ulist.h>
+#include <upipe/uprobe.h>
+#include <upipe/uclock.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_flow.h>
+#include <upipe/upump.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_input.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe/upipe_helper_subpipe.h>
+#include <upipe/upipe_helper_upump_mgr.h>
+#include <upipe/upipe_helper_upump.h>
+#include <upipe/upipe_helper_uclock.h>
+#include <upipe-modules/upipe_shaper.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <assert.h>
+
+/** default timer period */
+#define DEFAULT_TICK (UCLOCK_FREQ / 1000)
+/** duration of the automatic burst budget */
+#define DEFAULT_BURST_DURATION (UCLOCK_FREQ / 100)
+/** default number of packets held by a flow before blocking its source */
+#define DEFAULT_MAX_LENGTH 128
+
+/** @internal @This is a token bucket. */
+struct upipe_shaper_bucket {
+    /** rate in octets per second, or 0 */
+    uint64_t rate;
+    /** burst budget in octets, or 0 */
+    uint64_t burst;
+    /** available tokens, in octets * UCLOCK_FREQ */
+    int64_t tokens;
+};
+
+/** @internal @This returns the capacity of a bucket.
+ *
+ * @param bucket token bucket
+ * @return the maximum number of tokens
+ */
+static int64_t upipe_shaper_bucket_cap(struct upipe_shaper_bucket *bucket)
+{
+    if (bucket->burst)
+        return bucket->burst * UCLOCK_FREQ;
+    return bucket->rate * DEFAULT_BURST_DURATION;
+}
+
+/** @internal @This initializes a bucket.
+ *
+ * @param bucket token bucket
+ */
+static void upipe_shaper_bucket_init(struct upipe_shaper_bucket *bucket)
+{
+    bucket->rate = 0;
+    bucket->burst = 0;
+    bucket->tokens = 0;
+}
+
+/** @internal @This fills a bucket to its capacity.
+ *
+ * @param bucket token bucket
+ */
+static void upipe_shaper_bucket_fill(struct upipe_shaper_bucket *bucket)
+{
+    bucket->tokens = upipe_shaper_bucket_cap(bucket);
+}
+
+/** @internal @This adds the tokens earned during the given duration.
+ *
+ * @param bucket token bucket
+ * @param elapsed duration in @ref #UCLOCK_FREQ units
+ */
+static void upipe_shaper_bucket_refill(struct upipe_shaper_bucket *bucket,
+                                       uint64_t elapsed)
+{
+    if (!bucket->rate)
+        return;
+    int64_t cap = upipe_shaper_bucket_cap(bucket);
+    if (bucket->tokens >= cap)
+        return;
+    uint64_t missing = cap - bucket->tokens;
+    if (elapsed >= missing / bucket->rate + 1)
+        bucket->tokens = cap;
+    else
+        bucket->tokens += bucket->rate * elapsed;
+    if (bucket->tokens > cap)
+        bucket->tokens = cap;
+}
+
+/** @internal @This checks whether a packet may be sent.
+ *
+ * @param bucket token bucket
+ * @return true if the bucket is not empty
+ */
+static bool upipe_shaper_bucket_ready(struct upipe_shaper_bucket *bucket)
+{
+    return !bucket->rate || bucket->tokens > 0;
+}
+
+/** @internal @This deducts the size of a sent packet.
+ *
+ * @param bucket token bucket
+ * @param size size of the packet in octets
+ */
+static void upipe_shaper_bucket_consume(struct upipe_shaper_bucket *bucket,
+                                        size_t size)
+{
+    if (bucket->rate)
+        bucket->tokens -= (int64_t)size * UCLOCK_FREQ;
+}
+
+/** @internal @This is the private context of a shaper pipe. */
+struct upipe_shaper {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** upump manager */
+    struct upump_mgr *upump_mgr;
+    /** release timer */
+    struct upump *upump;
+    /** uclock */
+    struct uclock *uclock;
+    /** uclock request */
+    struct urequest uclock_request;
+
+    /** timer period */
+    uint64_t tick;
+    /** date of the last refill, or UINT64_MAX */
+    uint64_t last;
+    /** aggregate token bucket */
+    struct upipe_shaper_bucket bucket;
+
+    /** list of subs */
+    struct uchain subs;
+    /** manager to create subs */
+    struct upipe_mgr sub_mgr;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_shaper, upipe, UPIPE_SHAPER_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_shaper, urefcount, upipe_shaper_free)
+UPIPE_HELPER_VOID(upipe_shaper)
+UPIPE_HELPER_UPUMP_MGR(upipe_shaper, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_shaper, upump, upump_mgr)
+UPIPE_HELPER_UCLOCK(upipe_shaper, uclock, uclock_request, NULL,
+                    upipe_throw_provide_request, NULL)
+
+/** @internal @This is the private context of a flow of a shaper pipe. */
+struct upipe_shaper_sub {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** structure for double-linked lists */
+    struct uchain uchain;
+
+    /** list of held urefs */
+    struct uchain urefs;
+    /** number of held urefs */
+    unsigned int nb_urefs;
+    /** maximum number of held urefs */
+    unsigned int max_urefs;
+    /** list of input blockers */
+    struct uchain blockers;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** flow definition packet on this output */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** flow token bucket */
+    struct upipe_shaper_bucket bucket;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+/** @hidden */
+static bool upipe_shaper_sub_process(struct upipe *upipe, struct uref *uref,
+                                     struct upump **upump_p);
+
+UPIPE_HELPER_UPIPE(upipe_shaper_sub, upipe, UPIPE_SHAPER_SUB_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_shaper_sub, urefcount, upipe_shaper_sub_free)
+UPIPE_HELPER_VOID(upipe_shaper_sub)
+UPIPE_HELPER_INPUT(upipe_shaper_sub, urefs, nb_urefs, max_urefs, blockers,
+                   upipe_shaper_sub_process)
+UPIPE_HELPER_OUTPUT(upipe_shaper_sub, output, flow_def, output_state,
+                    request_list)
+
+UPIPE_HELPER_SUBPIPE(upipe_shaper, upipe_shaper_sub, sub, sub_mgr, subs, uchain)
+
+/** @hidden */
+static void upipe_shaper_schedule(struct upipe *upipe);
+
+/** @internal @This refills all buckets with the time elapsed since the last
+ * refill.
+ *
+ * @param upipe description structure of the super pipe
+ * @param elapsed elapsed time if there is no uclock
+ */
+static void upipe_shaper_refill(struct upipe *upipe, uint64_t elapsed)
+{
+    struct upipe_shaper *upipe_shaper = upipe_shaper_from_upipe(upipe);
+
+    if (upipe_shaper->uclock != NULL) {
+        uint64_t now = uclock_now(upipe_shaper->uclock);
+        uint64_t last = upipe_shaper->last;
+        upipe_shaper->last = now;
+        if (last == UINT64_MAX || now <= last)
+            return;
+        elapsed = now - last;
+    }
+    if (!elapsed)
+        return;
+
+    upipe_shaper_bucket_refill(&upipe_shaper->bucket, elapsed);
+    struct uchain *uchain;
+    ulist_foreach (&upipe_shaper->subs, uchain) {
+        struct upipe_shaper_sub *sub = upipe_shaper_sub_from_uchain(uchain);
+        upipe_shaper_bucket_refill(&sub->bucket, elapsed);
+    }
+}
+
+/** @internal @This outputs a packet of a flow if the budgets allow it.
+ *
+ * @param upipe description structure of the subpipe
+ * @param uref uref to output
+ * @param upump_p reference to pump that generated the buffer
+ * @return true if the packet was output
+ */
+static bool upipe_shaper_sub_try_output(struct upipe *upipe,
+                                        struct uref *uref,
+                                        struct upump **upump_p)
+{
+    struct upipe_shaper_sub *sub = upipe_shaper_sub_from_upipe(upipe);
+    struct upipe_shaper *upipe_shaper = upipe_shaper_from_sub_mgr(upipe->mgr);
+
+    if (!upipe_shaper_bucket_ready(&upipe_shaper->bucket) ||
+        !upipe_shaper_bucket_ready(&sub->bucket))
+        return false;
+
+    size_t size = 0;
+    uref_block_size(uref, &size);
+    upipe_shaper_bucket_consume(&upipe_shaper->bucket, size);
+    upipe_shaper_bucket_consume(&sub->bucket, size);
+    upipe_shaper_sub_output(upipe, uref, upump_p);
+    return true;
+}
+
+/** @internal @This outputs a held packet without shaping, when no timer
+ * can be allocated.
+ *
+ * @param upipe description structure of the subpipe
+ * @param uref uref to output
+ * @param upump_p reference to pump that generated the buffer
+ * @return always true
+ */
+static bool upipe_shaper_sub_process(struct upipe *upipe, struct uref *uref,
+                                     struct upump **upump_p)
+{
+    upipe_shaper_sub_output(upipe, uref, upump_p);
+    return true;
+}
+
+/** @internal @This allocates a flow of a shaper pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_shaper_sub_alloc(struct upipe_mgr *mgr,
+                                            struct uprobe *uprobe,
+                                            uint32_t signature,
+                                            va_list args)
+{
+    struct upipe *upipe = upipe_shaper_sub_alloc_void(mgr, uprobe, signature,
+                                                      args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_shaper_sub *sub = upipe_shaper_sub_from_upipe(upipe);
+    upipe_shaper_sub_init_urefcount(upipe);
+    upipe_shaper_sub_init_input(upipe);
+    upipe_shaper_sub_init_output(upipe);
+    upipe_shaper_sub_init_sub(upipe);
+    upipe_shaper_bucket_init(&sub->bucket);
+    sub->max_urefs = DEFAULT_MAX_LENGTH;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This receives data on a flow.
+ *
+ * @param upipe description structure of the subpipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_shaper_sub_input(struct upipe *upipe, struct uref *uref,
+                                   struct upump **upump_p)
+{
+    struct upipe_shaper *upipe_shaper = upipe_shaper_from_sub_mgr(upipe->mgr);
+    struct upipe *super = upipe_shaper_to_upipe(upipe_shaper);
+
+    if (upipe_shaper_sub_check_input(upipe)) {
+        upipe_shaper_refill(super, 0);
+        if (upipe_shaper_sub_try_output(upipe, uref, upump_p))
+            return;
+    }
+
+    upipe_shaper_sub_hold_input(upipe, uref);
+    upipe_shaper_sub_block_input(upipe, upump_p);
+    upipe_shaper_schedule(super);
+}
+
+/** @internal @This sets the input flow definition of a flow.
+ *
+ * @param upipe description structure of the subpipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_shaper_sub_set_flow_def(struct upipe *upipe,
+                                         struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, "block."))
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup);
+    upipe_shaper_sub_store_flow_def(upipe, flow_def_dup);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a flow of a shaper pipe.
+ *
+ * @param upipe description structure of the subpipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_shaper_sub_control(struct upipe *upipe,
+                                    int command, va_list args)
+{
+    struct upipe_shaper_sub *sub = upipe_shaper_sub_from_upipe(upipe);
+
+    UBASE_HANDLED_RETURN(upipe_shaper_sub_control_output(upipe, command,
+                                                         args));
+    UBASE_HANDLED_RETURN(upipe_shaper_sub_control_super(upipe, command, args));
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_shaper_sub_set_flow_def(upipe, flow_def);
+        }
+        case UPIPE_GET_MAX_LENGTH: {
+            unsigned int *p = va_arg(args, unsigned int *);
+            return upipe_shaper_sub_get_max_length(upipe, p);
+        }
+        case UPIPE_SET_MAX_LENGTH: {
+            unsigned int max_length = va_arg(args, unsigned int);
+            return upipe_shaper_sub_set_max_length(upipe, max_length);
+        }
+        case UPIPE_SHAPER_SET_RATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SHAPER_SUB_SIGNATURE)
+            sub->bucket.rate = va_arg(args, uint64_t);
+            upipe_shaper_bucket_fill(&sub->bucket);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SHAPER_GET_RATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SHAPER_SUB_SIGNATURE)
+            uint64_t *rate_p = va_arg(args, uint64_t *);
+            *rate_p = sub->bucket.rate;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SHAPER_SET_BURST: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SHAPER_SUB_SIGNATURE)
+            sub->bucket.burst = va_arg(args, uint64_t);
+            upipe_shaper_bucket_fill(&sub->bucket);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SHAPER_GET_BURST: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SHAPER_SUB_SIGNATURE)
+            uint64_t *burst_p = va_arg(args, uint64_t *);
+            *burst_p = upipe_shaper_bucket_cap(&sub->bucket) / UCLOCK_FREQ;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a flow of a shaper pipe.
+ *
+ * @param upipe description structure of the subpipe
+ */
+static void upipe_shaper_sub_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+
+    upipe_shaper_sub_clean_output(upipe);
+    upipe_shaper_sub_clean_input(upipe);
+    upipe_shaper_sub_clean_sub(upipe);
+    upipe_shaper_sub_clean_urefcount(upipe);
+    upipe_shaper_sub_free_void(upipe);
+}
+
+/** @internal @This initializes the flow manager for a shaper pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_shaper_init_sub_mgr(struct upipe *upipe)
+{
+    struct upipe_shaper *upipe_shaper = upipe_shaper_from_upipe(upipe);
+    struct upipe_mgr *sub_mgr = &upipe_shaper->sub_mgr;
+    sub_mgr->refcount = upipe_shaper_to_urefcount(upipe_shaper);
+    sub_mgr->signature = UPIPE_SHAPER_SUB_SIGNATURE;
+    sub_mgr->upipe_command_str = upipe_shaper_command_str;
+    sub_mgr->upipe_alloc = upipe_shaper_sub_alloc;
+    sub_mgr->upipe_input = upipe_shaper_sub_input;
+    sub_mgr->upipe_control = upipe_shaper_sub_control;
+    sub_mgr->upipe_mgr_control = NULL;
+}
+
+/** @internal @This allocates a shaper pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_shaper_alloc(struct upipe_mgr *mgr,
+                                        struct uprobe *uprobe,
+                                        uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_shaper_alloc_void(mgr, uprobe, signature,
+                                                  args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_shaper *upipe_shaper = upipe_shaper_from_upipe(upipe);
+    upipe_shaper_init_urefcount(upipe);
+    upipe_shaper_init_upump_mgr(upipe);
+    upipe_shaper_init_upump(upipe);
+    upipe_shaper_init_uclock(upipe);
+    upipe_shaper_init_sub_mgr(upipe);
+    upipe_shaper_init_sub_subs(upipe);
+    upipe_shaper->tick = DEFAULT_TICK;
+    upipe_shaper->last = UINT64_MAX;
+    upipe_shaper_bucket_init(&upipe_shaper->bucket);
+    upipe_throw_ready(upipe);
+
+    upipe_shaper_require_uclock(upipe);
+    return upipe;
+}
+
+/** @internal @This outputs held packets as long as the budgets allow it,
+ * one packet per flow at a time. The flows are rotated as they are visited,
+ * so that the next release starts where this one stopped.
+ *
+ * @param upipe description structure of the pipe
+ * @return true if packets are still held
+ */
+static bool upipe_shaper_release(struct upipe *upipe)
+{
+    struct upipe_shaper *upipe_shaper = upipe_shaper_from_upipe(upipe);
+    bool progress, pending;
+
+    do {
+        progress = pending = false;
+        size_t nb = ulist_depth(&upipe_shaper->subs);
+        while (nb--) {
+            if (!upipe_shaper_bucket_ready(&upipe_shaper->bucket))
+                return true;
+
+            struct uchain *uchain = ulist_pop(&upipe_shaper->subs);
+            ulist_add(&upipe_shaper->subs, uchain);
+            struct upipe *sub =
+                upipe_shaper_sub_to_upipe(upipe_shaper_sub_from_uchain(uchain));
+            if (upipe_shaper_sub_check_input(sub))
+                continue;
+
+            struct uref *uref = upipe_shaper_sub_pop_input(sub);
+            upipe_use(sub);
+            if (!upipe_shaper_sub_try_output(sub, uref, NULL)) {
+                upipe_shaper_sub_unshift_input(sub, uref);
+                pending = true;
+            } else {
+                progress = true;
+                if (!upipe_shaper_sub_check_input(sub))
+                    pending = true;
+                upipe_shaper_sub_unblock_input(sub);
+            }
+            upipe_release(sub);
+        }
+    } while (progress && pending);
+
+    return pending;
+}
+
+/** @internal @This is called by the release timer.
+ *
+ * @param upump description structure of the timer
+ */
+static void upipe_shaper_tick(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_shaper *upipe_shaper = upipe_shaper_from_upipe(upipe);
+
+    upipe_shaper_refill(upipe, upipe_shaper->tick);
+    if (!upipe_shaper_release(upipe))
+        upipe_shaper_set_upump(upipe, NULL);
+}
+
+/** @internal @This starts the release timer if it is not running.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_shaper_schedule(struct upipe *upipe)
+{
+    struct upipe_shaper *upipe_shaper = upipe_shaper_from_upipe(upipe);
+    if (upipe_shaper->upump != NULL)
+        return;
+
+    upipe_shaper_check_upump_mgr(upipe);
+    if (unlikely(upipe_shaper->upump_mgr == NULL)) {
+        upipe_warn(upipe, "no upump manager, not shaping");
+        struct uchain *uchain, *uchain_tmp;
+        ulist_delete_foreach (&upipe_shaper->subs, uchain, uchain_tmp) {
+            struct upipe *sub =
+                upipe_shaper_sub_to_upipe(upipe_shaper_sub_from_uchain(uchain));
+            upipe_use(sub);
+            upipe_shaper_sub_output_input(sub);
+            upipe_shaper_sub_unblock_input(sub);
+            upipe_release(sub);
+        }
+        return;
+    }
+
+    struct upump *upump = upump_alloc_timer(upipe_shaper->upump_mgr,
+                                            upipe_shaper_tick, upipe,
+                                            upipe->refcount,
+                                            upipe_shaper->tick,
+                                            upipe_shaper->tick);
+    if (unlikely(upump == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+        return;
+    }
+    upipe_shaper_set_upump(upipe, upump);
+    upump_start(upump);
+}
+
+/** @internal @This processes control commands on a shaper pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_shaper_control(struct upipe *upipe, int command,
+                                va_list args)
+{
+    struct upipe_shaper *upipe_shaper = upipe_shaper_from_upipe(upipe);
+
+    UBASE_HANDLED_RETURN(upipe_shaper_control_subs(upipe, command, args));
+    switch (command) {
+        case UPIPE_ATTACH_UPUMP_MGR:
+            upipe_shaper_set_upump(upipe, NULL);
+            UBASE_RETURN(upipe_shaper_attach_upump_mgr(upipe))
+            upipe_shaper_schedule(upipe);
+            return UBASE_ERR_NONE;
+        case UPIPE_ATTACH_UCLOCK:
+            upipe_shaper->last = UINT64_MAX;
+            upipe_shaper_require_uclock(upipe);
+            return UBASE_ERR_NONE;
+        case UPIPE_SHAPER_SET_RATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SHAPER_SIGNATURE)
+            upipe_shaper->bucket.rate = va_arg(args, uint64_t);
+            upipe_shaper_bucket_fill(&upipe_shaper->bucket);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SHAPER_GET_RATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SHAPER_SIGNATURE)
+            uint64_t *rate_p = va_arg(args, uint64_t *);
+            *rate_p = upipe_shaper->bucket.rate;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SHAPER_SET_BURST: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SHAPER_SIGNATURE)
+            upipe_shaper->bucket.burst = va_arg(args, uint64_t);
+            upipe_shaper_bucket_fill(&upipe_shaper->bucket);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SHAPER_GET_BURST: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SHAPER_SIGNATURE)
+            uint64_t *burst_p = va_arg(args, uint64_t *);
+            *burst_p = upipe_shaper_bucket_cap(&upipe_shaper->bucket) /
+                       UCLOCK_FREQ;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SHAPER_SET_TICK: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SHAPER_SIGNATURE)
+            uint64_t tick = va_arg(args, uint64_t);
+            if (!tick)
+                return UBASE_ERR_INVALID;
+            upipe_shaper->tick = tick;
+            if (upipe_shaper->upump != NULL) {
+                upipe_shaper_set_upump(upipe, NULL);
+                upipe_shaper_schedule(upipe);
+            }
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SHAPER_GET_TICK: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SHAPER_SIGNATURE)
+            uint64_t *tick_p = va_arg(args, uint64_t *);
+            *tick_p = upipe_shaper->tick;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a shaper pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_shaper_free(struct upipe *upipe)
+{
+    struct upipe_shaper *upipe_shaper = upipe_shaper_from_upipe(upipe);
+
+    upipe_throw_dead(upipe);
+    if (urequest_get_opaque(&upipe_shaper->uclock_request,
+                            struct upipe *) != NULL)
+        urequest_clean(&upipe_shaper->uclock_request);
+    upipe_shaper_clean_uclock(upipe);
+    upipe_shaper_clean_upump(upipe);
+    upipe_shaper_clean_upump_mgr(upipe);
+    upipe_shaper_clean_sub_subs(upipe);
+    upipe_shaper_clean_urefcount(upipe);
+    upipe_shaper_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_shaper_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_SHAPER_SIGNATURE,
+
+    .upipe_command_str = upipe_shaper_command_str,
+    .upipe_alloc = upipe_shaper_alloc,
+    .upipe_input = NULL,
+    .upipe_control = upipe_shaper_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all shaper pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_shaper_mgr_alloc(void)
+{
+    return &upipe_shaper_mgr;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short common definitions for shm sinks and sources
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uref.h>
+#include <upipe/uref_serial.h>
+
+#include <stdint.h>
+
+/** @internal @This is the maximum number of buffer extents of a uref. */
+#define UPIPE_SHM_MAX_EXTENTS 16
+/** @internal @This is the space for the serialized uref in a message. */
+#define UPIPE_SHM_HEADER_SIZE 3712
+
+/** @internal @This is the type of a message. */
+enum upipe_shm_msg_type {
+    /** uref with an optional block buffer */
+    UPIPE_SHM_MSG_UREF,
+    /** new flow definition */
+    UPIPE_SHM_MSG_FLOW_DEF,
+    /** the sink is gone */
+    UPIPE_SHM_MSG_END
+};
+
+/** @internal @This describes a part of a buffer in a slot of the segment.
+ * The message holds a reference to the slot. */
+struct upipe_shm_extent {
+    /** index of the slot */
+    uint32_t slot;
+    /** offset in the slot */
+    uint32_t offset;
+    /** size in octets */
+    uint32_t size;
+};
+
+/** @internal @This is the message passed from sink to source. Only
+ * fixed-size types are used, since it is shared between processes. */
+struct upipe_shm_msg {
+    /** type of message (@ref upipe_shm_msg_type) */
+    uint32_t type;
+    /** number of valid extents */
+    uint32_t nb_extents;
+    /** buffer extents */
+    struct upipe_shm_extent extents[UPIPE_SHM_MAX_EXTENTS];
+    /** size of the serialized uref */
+    uint32_t header_size;
+    /** uref serialized with @ref uref_serial_encode */
+    uint8_t header[UPIPE_SHM_HEADER_SIZE];
+};
+
+/** @internal @This serializes a uref into a message, except its buffer.
+ *
+ * @param msg pointer to message
+ * @param uref pointer to uref
+ * @return an error code
+ */
+static inline int upipe_shm_msg_from_uref(struct upipe_shm_msg *msg,
+                                          struct uref *uref)
+{
+    size_t size = UPIPE_SHM_HEADER_SIZE;
+    msg->header_size = 0;
+    UBASE_RETURN(uref_serial_encode(uref, NULL, msg->header, &size))
+    msg->header_size = size;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This deserializes a message into a uref, except its buffer.
+ *
+ * @param msg pointer to message
+ * @param uref pointer to uref
+ * @return an error code
+ */
+static inline int upipe_shm_msg_to_uref(const struct upipe_shm_msg *msg,
+                                        struct uref *uref)
+{
+    if (unlikely(msg->header_size > UPIPE_SHM_HEADER_SIZE))
+        return UBASE_ERR_INVALID;
+    return uref_serial_decode(uref, NULL, msg->header, msg->header_size);
+}
@@ -0,0 +1,489 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe sink module passing block urefs to another process through
+ * shared memory
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/umem.h>
+#include <upipe/umem_shm.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_block.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe-modules/upipe_shm_sink.h>
+
+#include "upipe_shm.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <assert.h>
+
+/** we only accept blocks */
+#define EXPECTED_FLOW_DEF "block."
+/** default size of a buffer slot */
+#define DEFAULT_SLOT_SIZE (256 * 1024)
+/** default number of buffer slots */
+#define DEFAULT_NB_SLOTS 512
+/** default length of the ring */
+#define DEFAULT_RING_LENGTH 256
+/** depth of the pools of the ubuf managers provided upstream */
+#define UBUF_POOL_DEPTH 32
+
+/** @internal @This is the private context of a shm sink pipe. */
+struct upipe_shm_sink {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** name of the segment */
+    char *uri;
+    /** shared memory allocator, or NULL */
+    struct umem_mgr *umem_mgr;
+    /** size of a slot of the next segment */
+    size_t slot_size;
+    /** number of slots of the next segment */
+    unsigned int nb_slots;
+    /** length of the ring of the next segment */
+    unsigned int ring_length;
+
+    /** input flow definition */
+    struct uref *flow_def;
+    /** true if the flow definition was passed to the source */
+    bool flow_def_sent;
+    /** number of dropped urefs */
+    uint64_t dropped;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_shm_sink, upipe, UPIPE_SHM_SINK_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_shm_sink, urefcount, upipe_shm_sink_free)
+UPIPE_HELPER_VOID(upipe_shm_sink)
+
+/** @internal @This allocates a shm sink pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_shm_sink_alloc(struct upipe_mgr *mgr,
+                                          struct uprobe *uprobe,
+                                          uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_shm_sink_alloc_void(mgr, uprobe, signature,
+                                                    args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_shm_sink *upipe_shm_sink = upipe_shm_sink_from_upipe(upipe);
+    upipe_shm_sink_init_urefcount(upipe);
+    upipe_shm_sink->uri = NULL;
+    upipe_shm_sink->umem_mgr = NULL;
+    upipe_shm_sink->slot_size = DEFAULT_SLOT_SIZE;
+    upipe_shm_sink->nb_slots = DEFAULT_NB_SLOTS;
+    upipe_shm_sink->ring_length = DEFAULT_RING_LENGTH;
+    upipe_shm_sink->flow_def = NULL;
+    upipe_shm_sink->flow_def_sent = false;
+    upipe_shm_sink->dropped = 0;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This pushes a message to the source.
+ *
+ * @param upipe description structure of the pipe
+ * @param msg message to push
+ * @return false if the ring is full
+ */
+static bool upipe_shm_sink_push(struct upipe *upipe,
+                                const struct upipe_shm_msg *msg)
+{
+    struct upipe_shm_sink *upipe_shm_sink = upipe_shm_sink_from_upipe(upipe);
+    return umem_shm_mgr_push(upipe_shm_sink->umem_mgr, msg);
+}
+
+/** @internal @This releases the slots referenced by a message.
+ *
+ * @param upipe description structure of the pipe
+ * @param msg message
+ */
+static void upipe_shm_sink_unref(struct upipe *upipe,
+                                 const struct upipe_shm_msg *msg)
+{
+    struct upipe_shm_sink *upipe_shm_sink = upipe_shm_sink_from_upipe(upipe);
+    for (uint32_t i = 0; i < msg->nb_extents; i++)
+        umem_shm_mgr_unref(upipe_shm_sink->umem_mgr, msg->extents[i].slot);
+}
+
+/** @internal @This passes the flow definition to the source if needed.
+ *
+ * @param upipe description structure of the pipe
+ * @return false if the ring is full
+ */
+static bool upipe_shm_sink_send_flow_def(struct upipe *upipe)
+{
+    struct upipe_shm_sink *upipe_shm_sink = upipe_shm_sink_from_upipe(upipe);
+    if (upipe_shm_sink->flow_def_sent || upipe_shm_sink->flow_def == NULL)
+        return true;
+
+    struct upipe_shm_msg msg;
+    msg.type = UPIPE_SHM_MSG_FLOW_DEF;
+    msg.nb_extents = 0;
+    if (unlikely(!ubase_check(upipe_shm_msg_from_uref(&msg,
+                                        upipe_shm_sink->flow_def)))) {
+        upipe_err(upipe, "flow definition too large");
+        upipe_shm_sink->flow_def_sent = true;
+        return true;
+    }
+    if (!upipe_shm_sink_push(upipe, &msg))
+        return false;
+    upipe_shm_sink->flow_def_sent = true;
+    return true;
+}
+
+/** @internal @This appends an extent to a message, exporting the buffer if
+ * it belongs to the segment, or copying it otherwise.
+ *
+ * @param upipe description structure of the pipe
+ * @param msg message
+ * @param buffer pointer to buffer
+ * @param size size of the buffer
+ * @return an error code
+ */
+static int upipe_shm_sink_add_extent(struct upipe *upipe,
+                                     struct upipe_shm_msg *msg,
+                                     const uint8_t *buffer, size_t size)
+{
+    struct upipe_shm_sink *upipe_shm_sink = upipe_shm_sink_from_upipe(upipe);
+    struct umem_mgr *umem_mgr = upipe_shm_sink->umem_mgr;
+    if (unlikely(msg->nb_extents >= UPIPE_SHM_MAX_EXTENTS))
+        return UBASE_ERR_INVALID;
+
+    struct upipe_shm_extent *extent = &msg->extents[msg->nb_extents];
+    if (ubase_check(umem_shm_mgr_export(umem_mgr, buffer, size,
+                                        &extent->slot, &extent->offset))) {
+        extent->size = size;
+        msg->nb_extents++;
+        return UBASE_ERR_NONE;
+    }
+
+    size_t slot_size = umem_shm_mgr_slot_size(umem_mgr);
+    while (size) {
+        if (unlikely(msg->nb_extents >= UPIPE_SHM_MAX_EXTENTS))
+            return UBASE_ERR_INVALID;
+        extent = &msg->extents[msg->nb_extents];
+        uint8_t *slot = umem_shm_mgr_reserve(umem_mgr, &extent->slot);
+        if (unlikely(slot == NULL))
+            return UBASE_ERR_ALLOC;
+        size_t chunk = size < slot_size ? size : slot_size;
+        memcpy(slot, buffer, chunk);
+        extent->offset = 0;
+        extent->size = chunk;
+        msg->nb_extents++;
+        buffer += chunk;
+        size -= chunk;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This builds the message for a uref.
+ *
+ * @param upipe description structure of the pipe
+ * @param msg message to fill in
+ * @param uref uref structure
+ * @return an error code
+ */
+static int upipe_shm_sink_build(struct upipe *upipe, struct upipe_shm_msg *msg,
+                                struct uref *uref)
+{
+    msg->type = UPIPE_SHM_MSG_UREF;
+    msg->nb_extents = 0;
+    UBASE_RETURN(upipe_shm_msg_from_uref(msg, uref))
+    if (uref->ubuf == NULL)
+        return UBASE_ERR_NONE;
+
+    size_t total;
+    UBASE_RETURN(uref_block_size(uref, &total))
+    size_t offset = 0;
+    while (offset < total) {
+        int size = -1;
+        const uint8_t *buffer;
+        int err = uref_block_read(uref, offset, &size, &buffer);
+        if (unlikely(!ubase_check(err)))
+            return err;
+        err = upipe_shm_sink_add_extent(upipe, msg, buffer, size);
+        uref_block_unmap(uref, offset);
+        if (unlikely(!ubase_check(err)))
+            return err;
+        offset += size;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This passes a uref to the source.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_shm_sink_input(struct upipe *upipe, struct uref *uref,
+                                 struct upump **upump_p)
+{
+    struct upipe_shm_sink *upipe_shm_sink = upipe_shm_sink_from_upipe(upipe);
+    if (unlikely(upipe_shm_sink->umem_mgr == NULL)) {
+        upipe_warn(upipe, "received a buffer before opening a segment");
+        uref_free(uref);
+        return;
+    }
+
+    struct upipe_shm_msg msg;
+    if (unlikely(!upipe_shm_sink_send_flow_def(upipe))) {
+        upipe_shm_sink->dropped++;
+        upipe_warn(upipe, "ring is full, dropping buffer");
+        uref_free(uref);
+        return;
+    }
+
+    int err = upipe_shm_sink_build(upipe, &msg, uref);
+    uref_free(uref);
+    if (unlikely(!ubase_check(err))) {
+        upipe_shm_sink_unref(upipe, &msg);
+        upipe_shm_sink->dropped++;
+        upipe_warn_va(upipe, "unable to pass buffer (%s)",
+                      ubase_err_str(err) ?: "unknown");
+        return;
+    }
+
+    if (unlikely(!upipe_shm_sink_push(upipe, &msg))) {
+        upipe_shm_sink_unref(upipe, &msg);
+        upipe_shm_sink->dropped++;
+        upipe_warn(upipe, "ring is full, dropping buffer");
+    }
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_shm_sink_set_flow_def(struct upipe *upipe,
+                                       struct uref *flow_def)
+{
+    struct upipe_shm_sink *upipe_shm_sink = upipe_shm_sink_from_upipe(upipe);
+    const char *def;
+    UBASE_RETURN(uref_flow_get_def(flow_def, &def))
+    if (unlikely(ubase_ncmp(def, EXPECTED_FLOW_DEF)))
+        return UBASE_ERR_INVALID;
+
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup)
+    uref_free(upipe_shm_sink->flow_def);
+    upipe_shm_sink->flow_def = flow_def_dup;
+    upipe_shm_sink->flow_def_sent = false;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This handles a request from upstream, providing a ubuf
+ * manager allocating in the segment.
+ *
+ * @param upipe description structure of the pipe
+ * @param request description structure of the request
+ * @return an error code
+ */
+static int upipe_shm_sink_register_request(struct upipe *upipe,
+                                           struct urequest *request)
+{
+    struct upipe_shm_sink *upipe_shm_sink = upipe_shm_sink_from_upipe(upipe);
+    const char *def;
+    if (request->type != UREQUEST_UBUF_MGR ||
+        upipe_shm_sink->umem_mgr == NULL || request->uref == NULL ||
+        !ubase_check(uref_flow_get_def(request->uref, &def)) ||
+        ubase_ncmp(def, EXPECTED_FLOW_DEF))
+        return upipe_throw_provide_request(upipe, request);
+
+    struct uref *uref = uref_dup(request->uref);
+    UBASE_ALLOC_RETURN(uref)
+    struct ubuf_mgr *ubuf_mgr =
+        ubuf_mem_mgr_alloc_from_flow_def(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH,
+                                         upipe_shm_sink->umem_mgr, uref);
+    if (unlikely(ubuf_mgr == NULL)) {
+        uref_free(uref);
+        return upipe_throw_provide_request(upipe, request);
+    }
+    return urequest_provide_ubuf_mgr(request, ubuf_mgr, uref);
+}
+
+/** @internal @This closes the segment.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_shm_sink_close(struct upipe *upipe)
+{
+    struct upipe_shm_sink *upipe_shm_sink = upipe_shm_sink_from_upipe(upipe);
+    if (upipe_shm_sink->umem_mgr != NULL) {
+        struct upipe_shm_msg msg = { .type = UPIPE_SHM_MSG_END };
+        if (!upipe_shm_sink_push(upipe, &msg))
+            upipe_warn(upipe, "unable to signal the end of stream");
+        upipe_notice_va(upipe, "closing segment %s", upipe_shm_sink->uri);
+        umem_mgr_release(upipe_shm_sink->umem_mgr);
+        upipe_shm_sink->umem_mgr = NULL;
+    }
+    ubase_clean_str(&upipe_shm_sink->uri);
+}
+
+/** @internal @This creates the segment.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri name of the segment
+ * @return an error code
+ */
+static int upipe_shm_sink_set_uri(struct upipe *upipe, const char *uri)
+{
+    struct upipe_shm_sink *upipe_shm_sink = upipe_shm_sink_from_upipe(upipe);
+    upipe_shm_sink_close(upipe);
+    if (uri == NULL)
+        return UBASE_ERR_NONE;
+
+    upipe_shm_sink->uri = strdup(uri);
+    UBASE_ALLOC_RETURN(upipe_shm_sink->uri)
+    upipe_shm_sink->umem_mgr =
+        umem_shm_mgr_alloc(uri, upipe_shm_sink->slot_size,
+                           upipe_shm_sink->nb_slots,
+                           upipe_shm_sink->ring_length,
+                           sizeof(struct upipe_shm_msg));
+    if (unlikely(upipe_shm_sink->umem_mgr == NULL)) {
+        upipe_err_va(upipe, "unable to create segment %s", uri);
+        ubase_clean_str(&upipe_shm_sink->uri);
+        return UBASE_ERR_EXTERNAL;
+    }
+    upipe_shm_sink->flow_def_sent = false;
+    upipe_notice_va(upipe, "opening segment %s", uri);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a shm sink pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_shm_sink_control(struct upipe *upipe, int command,
+                                  va_list args)
+{
+    struct upipe_shm_sink *upipe_shm_sink = upipe_shm_sink_from_upipe(upipe);
+
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            return upipe_shm_sink_register_request(upipe, request);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_shm_sink_set_flow_def(upipe, flow_def);
+        }
+        case UPIPE_GET_URI: {
+            const char **uri_p = va_arg(args, const char **);
+            *uri_p = upipe_shm_sink->uri;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SET_URI: {
+            const char *uri = va_arg(args, const char *);
+            return upipe_shm_sink_set_uri(upipe, uri);
+        }
+        case UPIPE_SHM_SINK_SET_ARENA: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SHM_SINK_SIGNATURE)
+            size_t slot_size = va_arg(args, size_t);
+            unsigned int nb_slots = va_arg(args, unsigned int);
+            unsigned int ring_length = va_arg(args, unsigned int);
+            if (unlikely(!slot_size || slot_size > UINT32_MAX || !nb_slots ||
+                         !ring_length))
+                return UBASE_ERR_INVALID;
+            upipe_shm_sink->slot_size = slot_size;
+            upipe_shm_sink->nb_slots = nb_slots;
+            upipe_shm_sink->ring_length = ring_length;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SHM_SINK_GET_DROPPED: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SHM_SINK_SIGNATURE)
+            uint64_t *dropped_p = va_arg(args, uint64_t *);
+            *dropped_p = upipe_shm_sink->dropped;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This frees a shm sink pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_shm_sink_free(struct upipe *upipe)
+{
+    struct upipe_shm_sink *upipe_shm_sink = upipe_shm_sink_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    upipe_shm_sink_close(upipe);
+    uref_free(upipe_shm_sink->flow_def);
+    upipe_shm_sink_clean_urefcount(upipe);
+    upipe_shm_sink_free_void(upipe);
+}
+
+/** shm sink management structure */
+static struct upipe_mgr upipe_shm_sink_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_SHM_SINK_SIGNATURE,
+
+    .upipe_alloc = upipe_shm_sink_alloc,
+    .upipe_input = upipe_shm_sink_input,
+    .upipe_control = upipe_shm_sink_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for shm sinks.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_shm_sink_mgr_alloc(void)
+{
+    return &upipe_shm_sink_mgr;
+}
@@ -0,0 +1,505 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe source module receiving block urefs from another process
+ * through shared memory
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uclock.h>
+#include <upipe/umem.h>
+#include <upipe/umem_shm.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/upump.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe/upipe_helper_uref_mgr.h>
+#include <upipe/upipe_helper_upump_mgr.h>
+#include <upipe/upipe_helper_upump.h>
+#include <upipe-modules/upipe_shm_source.h>
+
+#include "upipe_shm.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+/** default polling interval */
+#define DEFAULT_INTERVAL (UCLOCK_FREQ / 1000)
+/** depth of the pools of the ubuf manager */
+#define UBUF_POOL_DEPTH 32
+
+/** @internal @This is the private context of a shm source pipe. */
+struct upipe_shm_src {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** uref manager */
+    struct uref_mgr *uref_mgr;
+    /** uref manager request */
+    struct urequest uref_mgr_request;
+
+    /** upump manager */
+    struct upump_mgr *upump_mgr;
+    /** polling timer */
+    struct upump *timer;
+    /** polling interval */
+    uint64_t interval;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** output flow definition */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** name of the segment */
+    char *uri;
+    /** shared memory allocator, or NULL */
+    struct umem_mgr *umem_mgr;
+    /** ubuf manager wrapping slots of the segment */
+    struct ubuf_mgr *ubuf_mgr;
+    /** true if the end of stream was received */
+    bool ended;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+/** @hidden */
+static int upipe_shm_src_check(struct upipe *upipe, struct uref *flow_format);
+
+UPIPE_HELPER_UPIPE(upipe_shm_src, upipe, UPIPE_SHM_SRC_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_shm_src, urefcount, upipe_shm_src_free)
+UPIPE_HELPER_VOID(upipe_shm_src)
+UPIPE_HELPER_OUTPUT(upipe_shm_src, output, flow_def, output_state,
+                    request_list)
+UPIPE_HELPER_UREF_MGR(upipe_shm_src, uref_mgr, uref_mgr_request,
+                      upipe_shm_src_check,
+                      upipe_shm_src_register_output_request,
+                      upipe_shm_src_unregister_output_request)
+UPIPE_HELPER_UPUMP_MGR(upipe_shm_src, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_shm_src, timer, upump_mgr)
+
+/** @internal @This allocates a shm source pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_shm_src_alloc(struct upipe_mgr *mgr,
+                                         struct uprobe *uprobe,
+                                         uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_shm_src_alloc_void(mgr, uprobe, signature,
+                                                   args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_shm_src *upipe_shm_src = upipe_shm_src_from_upipe(upipe);
+    upipe_shm_src_init_urefcount(upipe);
+    upipe_shm_src_init_uref_mgr(upipe);
+    upipe_shm_src_init_upump_mgr(upipe);
+    upipe_shm_src_init_timer(upipe);
+    upipe_shm_src_init_output(upipe);
+    upipe_shm_src->interval = DEFAULT_INTERVAL;
+    upipe_shm_src->uri = NULL;
+    upipe_shm_src->umem_mgr = NULL;
+    upipe_shm_src->ubuf_mgr = NULL;
+    upipe_shm_src->ended = false;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This releases the slots referenced by a message, starting
+ * from the given extent.
+ *
+ * @param upipe description structure of the pipe
+ * @param msg message
+ * @param first index of the first extent to release
+ */
+static void upipe_shm_src_unref(struct upipe *upipe,
+                                const struct upipe_shm_msg *msg,
+                                uint32_t first)
+{
+    struct upipe_shm_src *upipe_shm_src = upipe_shm_src_from_upipe(upipe);
+    uint32_t nb_extents = msg->nb_extents;
+    if (nb_extents > UPIPE_SHM_MAX_EXTENTS)
+        nb_extents = UPIPE_SHM_MAX_EXTENTS;
+    for (uint32_t i = first; i < nb_extents; i++)
+        umem_shm_mgr_unref(upipe_shm_src->umem_mgr, msg->extents[i].slot);
+}
+
+/** @internal @This builds the buffer of a uref from the extents of a
+ * message, without copying.
+ *
+ * @param upipe description structure of the pipe
+ * @param msg message
+ * @param uref uref structure
+ * @return an error code
+ */
+static int upipe_shm_src_import(struct upipe *upipe,
+                                const struct upipe_shm_msg *msg,
+                                struct uref *uref)
+{
+    struct upipe_shm_src *upipe_shm_src = upipe_shm_src_from_upipe(upipe);
+    if (unlikely(msg->nb_extents > UPIPE_SHM_MAX_EXTENTS)) {
+        upipe_shm_src_unref(upipe, msg, 0);
+        return UBASE_ERR_INVALID;
+    }
+
+    struct ubuf *ubuf = NULL;
+    for (uint32_t i = 0; i < msg->nb_extents; i++) {
+        const struct upipe_shm_extent *extent = &msg->extents[i];
+        struct umem umem;
+        int err = umem_shm_mgr_import(upipe_shm_src->umem_mgr, &umem,
+                                      extent->slot);
+        if (unlikely(!ubase_check(err))) {
+            upipe_shm_src_unref(upipe, msg, i + 1);
+            if (ubuf != NULL)
+                ubuf_free(ubuf);
+            return err;
+        }
+
+        struct ubuf *part = ubuf_block_mem_alloc_from_umem(
+                upipe_shm_src->ubuf_mgr, &umem);
+        if (unlikely(part == NULL)) {
+            umem_free(&umem);
+            upipe_shm_src_unref(upipe, msg, i + 1);
+            if (ubuf != NULL)
+                ubuf_free(ubuf);
+            return UBASE_ERR_ALLOC;
+        }
+        if (unlikely(!ubase_check(ubuf_block_resize(part, extent->offset,
+                                                    extent->size)))) {
+            ubuf_free(part);
+            upipe_shm_src_unref(upipe, msg, i + 1);
+            if (ubuf != NULL)
+                ubuf_free(ubuf);
+            return UBASE_ERR_INVALID;
+        }
+
+        if (ubuf == NULL)
+            ubuf = part;
+        else if (unlikely(!ubase_check(ubuf_block_append(ubuf, part)))) {
+            ubuf_free(part);
+            upipe_shm_src_unref(upipe, msg, i + 1);
+            ubuf_free(ubuf);
+            return UBASE_ERR_INVALID;
+        }
+    }
+
+    if (ubuf != NULL)
+        uref_attach_ubuf(uref, ubuf);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This handles a message received from the sink.
+ *
+ * @param upipe description structure of the pipe
+ * @param msg message
+ */
+static void upipe_shm_src_handle(struct upipe *upipe,
+                                 const struct upipe_shm_msg *msg)
+{
+    struct upipe_shm_src *upipe_shm_src = upipe_shm_src_from_upipe(upipe);
+
+    if (msg->type == UPIPE_SHM_MSG_END) {
+        upipe_shm_src->ended = true;
+        upipe_shm_src_set_timer(upipe, NULL);
+        upipe_throw_source_end(upipe);
+        return;
+    }
+
+    struct uref *uref = uref_alloc(upipe_shm_src->uref_mgr);
+    if (unlikely(uref == NULL)) {
+        upipe_shm_src_unref(upipe, msg, 0);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    int err = upipe_shm_msg_to_uref(msg, uref);
+    if (unlikely(!ubase_check(err))) {
+        upipe_shm_src_unref(upipe, msg, 0);
+        uref_free(uref);
+        upipe_warn(upipe, "invalid attributes, dropping message");
+        return;
+    }
+
+    switch (msg->type) {
+        case UPIPE_SHM_MSG_FLOW_DEF:
+            upipe_shm_src_unref(upipe, msg, 0);
+            upipe_shm_src_store_flow_def(upipe, uref);
+            break;
+        case UPIPE_SHM_MSG_UREF:
+            err = upipe_shm_src_import(upipe, msg, uref);
+            if (unlikely(!ubase_check(err))) {
+                uref_free(uref);
+                upipe_warn_va(upipe, "unable to import buffer (%s)",
+                              ubase_err_str(err) ?: "unknown");
+                break;
+            }
+            upipe_shm_src_output(upipe, uref, &upipe_shm_src->timer);
+            break;
+        default:
+            upipe_shm_src_unref(upipe, msg, 0);
+            uref_free(uref);
+            upipe_warn_va(upipe, "unknown message type %"PRIu32, msg->type);
+            break;
+    }
+}
+
+/** @internal @This polls the ring of the segment.
+ *
+ * @param upump description structure of the timer
+ */
+static void upipe_shm_src_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_shm_src *upipe_shm_src = upipe_shm_src_from_upipe(upipe);
+    struct upipe_shm_msg msg;
+
+    /* the pipe may be released on end of stream */
+    upipe_use(upipe);
+    while (upipe_shm_src->umem_mgr != NULL && !upipe_shm_src->ended &&
+           umem_shm_mgr_pop(upipe_shm_src->umem_mgr, &msg))
+        upipe_shm_src_handle(upipe, &msg);
+    upipe_release(upipe);
+}
+
+/** @internal @This checks if the timer may be allocated.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_shm_src_check(struct upipe *upipe, struct uref *flow_format)
+{
+    struct upipe_shm_src *upipe_shm_src = upipe_shm_src_from_upipe(upipe);
+    if (flow_format != NULL)
+        upipe_shm_src_store_flow_def(upipe, flow_format);
+
+    upipe_shm_src_check_upump_mgr(upipe);
+    if (upipe_shm_src->upump_mgr == NULL)
+        return UBASE_ERR_NONE;
+
+    if (upipe_shm_src->uref_mgr == NULL) {
+        upipe_shm_src_require_uref_mgr(upipe);
+        return UBASE_ERR_NONE;
+    }
+
+    if (upipe_shm_src->umem_mgr != NULL && !upipe_shm_src->ended &&
+        upipe_shm_src->timer == NULL) {
+        struct upump *timer =
+            upump_alloc_timer(upipe_shm_src->upump_mgr, upipe_shm_src_worker,
+                              upipe, upipe->refcount,
+                              upipe_shm_src->interval,
+                              upipe_shm_src->interval);
+        if (unlikely(timer == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+            return UBASE_ERR_UPUMP;
+        }
+        upipe_shm_src_set_timer(upipe, timer);
+        upump_start(timer);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This detaches from the segment.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_shm_src_close(struct upipe *upipe)
+{
+    struct upipe_shm_src *upipe_shm_src = upipe_shm_src_from_upipe(upipe);
+    upipe_shm_src_set_timer(upipe, NULL);
+    if (upipe_shm_src->ubuf_mgr != NULL) {
+        ubuf_mgr_release(upipe_shm_src->ubuf_mgr);
+        upipe_shm_src->ubuf_mgr = NULL;
+    }
+    if (upipe_shm_src->umem_mgr != NULL) {
+        upipe_notice_va(upipe, "closing segment %s", upipe_shm_src->uri);
+        umem_mgr_release(upipe_shm_src->umem_mgr);
+        upipe_shm_src->umem_mgr = NULL;
+    }
+    ubase_clean_str(&upipe_shm_src->uri);
+}
+
+/** @internal @This attaches to a segment created by a shm sink.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri name of the segment
+ * @return an error code
+ */
+static int upipe_shm_src_set_uri(struct upipe *upipe, const char *uri)
+{
+    struct upipe_shm_src *upipe_shm_src = upipe_shm_src_from_upipe(upipe);
+    upipe_shm_src_close(upipe);
+    upipe_shm_src->ended = false;
+    if (uri == NULL)
+        return UBASE_ERR_NONE;
+
+    upipe_shm_src->umem_mgr = umem_shm_mgr_attach(uri);
+    if (unlikely(upipe_shm_src->umem_mgr == NULL)) {
+        upipe_err_va(upipe, "unable to attach to segment %s", uri);
+        return UBASE_ERR_EXTERNAL;
+    }
+    if (unlikely(umem_shm_mgr_msg_size(upipe_shm_src->umem_mgr) !=
+                 sizeof(struct upipe_shm_msg))) {
+        upipe_err_va(upipe, "incompatible segment %s", uri);
+        upipe_shm_src_close(upipe);
+        return UBASE_ERR_INVALID;
+    }
+
+    upipe_shm_src->ubuf_mgr =
+        ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH,
+                                 upipe_shm_src->umem_mgr, 0, 0, 0, 0);
+    upipe_shm_src->uri = strdup(uri);
+    if (unlikely(upipe_shm_src->ubuf_mgr == NULL ||
+                 upipe_shm_src->uri == NULL)) {
+        upipe_shm_src_close(upipe);
+        return UBASE_ERR_ALLOC;
+    }
+    /* buffers only leave this thread through queues, which share them */
+    if (unlikely(!ubase_check(ubuf_block_mem_mgr_set_local(
+                        upipe_shm_src->ubuf_mgr, true))))
+        upipe_warn(upipe, "unable to use thread-local buffers");
+    upipe_notice_va(upipe, "attaching to segment %s", uri);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a shm source pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_shm_src_control_real(struct upipe *upipe, int command,
+                                      va_list args)
+{
+    struct upipe_shm_src *upipe_shm_src = upipe_shm_src_from_upipe(upipe);
+
+    switch (command) {
+        case UPIPE_ATTACH_UPUMP_MGR:
+            upipe_shm_src_set_timer(upipe, NULL);
+            return upipe_shm_src_attach_upump_mgr(upipe);
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_shm_src_control_output(upipe, command, args);
+        case UPIPE_GET_URI: {
+            const char **uri_p = va_arg(args, const char **);
+            *uri_p = upipe_shm_src->uri;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SET_URI: {
+            const char *uri = va_arg(args, const char *);
+            return upipe_shm_src_set_uri(upipe, uri);
+        }
+        case UPIPE_SHM_SRC_SET_INTERVAL: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SHM_SRC_SIGNATURE)
+            uint64_t interval = va_arg(args, uint64_t);
+            if (unlikely(!interval))
+                return UBASE_ERR_INVALID;
+            upipe_shm_src->interval = interval;
+            upipe_shm_src_set_timer(upipe, NULL);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SHM_SRC_GET_INTERVAL: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SHM_SRC_SIGNATURE)
+            uint64_t *interval_p = va_arg(args, uint64_t *);
+            *interval_p = upipe_shm_src->interval;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This processes control commands and checks if the timer may
+ * be allocated.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_shm_src_control(struct upipe *upipe, int command,
+                                 va_list args)
+{
+    UBASE_RETURN(upipe_shm_src_control_real(upipe, command, args))
+    return upipe_shm_src_check(upipe, NULL);
+}
+
+/** @internal @This frees a shm source pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_shm_src_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+
+    upipe_shm_src_close(upipe);
+    upipe_shm_src_clean_output(upipe);
+    upipe_shm_src_clean_timer(upipe);
+    upipe_shm_src_clean_upump_mgr(upipe);
+    upipe_shm_src_clean_uref_mgr(upipe);
+    upipe_shm_src_clean_urefcount(upipe);
+    upipe_shm_src_free_void(upipe);
+}
+
+/** shm source management structure */
+static struct upipe_mgr upipe_shm_src_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_SHM_SRC_SIGNATURE,
+
+    .upipe_alloc = upipe_shm_src_alloc,
+    .upipe_input = NULL,
+    .upipe_control = upipe_shm_src_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for shm sources.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_shm_src_mgr_alloc(void)
+{
+    return &upipe_shm_src_mgr;
+}
@@ -97,8 +97,17 @@ struct upipe_stream_switcher {
     uint64_t pts_orig;
     /** last pts of the output stream */
     uint64_t last_pts_orig;
+    /** original date of the rebase point */
     uint64_t rebase_timestamp;
+    /** output date of the rebase point */
+    uint64_t rebase_prog;
     bool rebase_timestamp_set;
+    /** last output date */
+    uint64_t last_dts;
+    /** expected date of the next output frame */
+    uint64_t next_dts;
+    /** splice inputs with unrelated timelines */
+    bool splice;
 
     /** for upipe helper */
     struct upipe upipe;
@@ -330,6 +339,9 @@ static void upipe_stream_switcher_switch(struct upipe_stream_switcher *super)
     /* switch */
     super->selected = super->waiting;
     super->waiting = NULL;
+    if (super->splice)
+        /* rebase the new input after the last output frame */
+        super->rebase_timestamp_set = false;
 
     /* wake up the new one */
     if (super->selected) {
@@ -364,12 +376,15 @@ static bool upipe_stream_switcher_fwd(struct upipe *upipe,
     if (!upipe_stream_switcher->rebase_timestamp_set) {
         upipe_stream_switcher->rebase_timestamp_set = true;
         upipe_stream_switcher->rebase_timestamp = dts_orig;
+        upipe_stream_switcher->rebase_prog = upipe_stream_switcher->next_dts;
     }
     if (upipe_stream_switcher->rebase_timestamp > dts_orig) {
         upipe_warn(upipe, "dts is in the past");
         upipe_stream_switcher->rebase_timestamp = dts_orig;
+        upipe_stream_switcher->rebase_prog = upipe_stream_switcher->next_dts;
     }
-    dts_orig -= upipe_stream_switcher->rebase_timestamp;
+    dts_orig += upipe_stream_switcher->rebase_prog -
+                upipe_stream_switcher->rebase_timestamp;
 
     uint64_t dts_prog;
     if (!ubase_check(uref_clock_get_dts_prog(uref, &dts_prog)))
@@ -379,11 +394,44 @@ static bool upipe_stream_switcher_fwd(struct upipe *upipe,
                      dts_prog, dts_prog / (UCLOCK_FREQ / 1000),
                      dts_orig, dts_orig / (UCLOCK_FREQ / 1000));
     uref_clock_set_dts_prog(uref, dts_orig);
+
+    /* the PTS follows as the DTS/PTS delay is kept */
+    uint64_t duration;
+    if (ubase_check(uref_clock_get_duration(uref, &duration)))
+        upipe_stream_switcher->next_dts = dts_orig + duration;
+    else if (upipe_stream_switcher->last_dts != UINT64_MAX &&
+             upipe_stream_switcher->last_dts < dts_orig)
+        upipe_stream_switcher->next_dts =
+            2 * dts_orig - upipe_stream_switcher->last_dts;
+    else
+        upipe_stream_switcher->next_dts = dts_orig;
+    upipe_stream_switcher->last_dts = dts_orig;
+
     upipe_stream_switcher_output(super, uref, upump_p);
 
     return true;
 }
 
+/** @internal @This checks whether an uref is a random access point, that is
+ * a frame flagged random by the framer or a key picture. Non picture flows
+ * can be entered at any frame.
+ *
+ * @param super pointer to the private description of the super pipe
+ * @param uref uref to check
+ * @return true if the stream may be entered on this uref
+ */
+static bool upipe_stream_switcher_is_rap(struct upipe_stream_switcher *super,
+                                         struct uref *uref)
+{
+    if (ubase_check(uref_flow_get_random(uref)))
+        return true;
+
+    const char *flow_def;
+    if (!ubase_check(uref_flow_get_def(super->flow_def, &flow_def)))
+        return false;
+    return !strstr(flow_def, ".pic.") || ubase_check(uref_pic_get_key(uref));
+}
+
 /** @internal @This sets the upipe as waiting, return false to save the uref
  *
  * @param super pointer to the private description of the super pipe
@@ -408,10 +456,18 @@ static bool upipe_stream_switcher_wait(struct upipe_stream_switcher *super,
         return upipe_stream_switcher_drop(upipe, uref);
     }
 
-    if (strstr(flow_def, ".pic.") && !ubase_check(uref_pic_get_key(uref)))
-        /* drop if not a key frames */
+    if (!upipe_stream_switcher_is_rap(super, uref))
+        /* drop if not a random access point */
         return upipe_stream_switcher_drop(upipe, uref);
 
+    if (super->splice) {
+        /* unrelated timeline, switch on the next random access point
+         * of the selected stream */
+        upipe_stream_switcher_input->sync = true;
+        upipe_stream_switcher_input_throw_sync(upipe);
+        return false;
+    }
+
     uint64_t pts_orig = 0;
     if (!ubase_check(uref_clock_get_pts_orig(uref, &pts_orig))) {
         /* fail to get pts, dropping... */
@@ -482,6 +538,16 @@ static bool upipe_stream_switcher_input_output(struct upipe *upipe,
             /* no key frame found, forward */
             return upipe_stream_switcher_fwd(upipe, uref, upump_p);
 
+        if (super->splice) {
+            if (!upipe_stream_switcher_is_rap(super, uref))
+                /* finish the current group of pictures */
+                return upipe_stream_switcher_fwd(upipe, uref, upump_p);
+
+            upipe_dbg_va(upipe, "splice at %"PRIu64, pts_orig);
+            upipe_stream_switcher_switch(super);
+            return upipe_stream_switcher_drop(upipe, uref);
+        }
+
         if (pts_orig < super->pts_orig)
             /* previous frame, forward */
             return upipe_stream_switcher_fwd(upipe, uref, upump_p);
@@ -574,6 +640,10 @@ static struct upipe *upipe_stream_switcher_alloc(struct upipe_mgr *mgr,
     upipe_stream_switcher->last_pts_orig = 0;
     upipe_stream_switcher->rebase_timestamp_set = false;
     upipe_stream_switcher->rebase_timestamp = 0;
+    upipe_stream_switcher->rebase_prog = 0;
+    upipe_stream_switcher->last_dts = UINT64_MAX;
+    upipe_stream_switcher->next_dts = 0;
+    upipe_stream_switcher->splice = false;
     urefcount_init(
         upipe_stream_switcher_to_urefcount_real(upipe_stream_switcher),
         upipe_stream_switcher_free);
@@ -661,6 +731,9 @@ static int upipe_stream_switcher_set_flow_def(struct upipe *upipe,
 static int upipe_stream_switcher_control(struct upipe *upipe,
                                          int command, va_list args)
 {
+    struct upipe_stream_switcher *upipe_stream_switcher =
+        upipe_stream_switcher_from_upipe(upipe);
+
     UBASE_HANDLED_RETURN(
         upipe_stream_switcher_control_inputs(upipe, command, args));
     UBASE_HANDLED_RETURN(upipe_control_provide_request(upipe, command, args));
@@ -676,6 +749,12 @@ static int upipe_stream_switcher_control(struct upipe *upipe,
     case UPIPE_SET_OUTPUT:
         return upipe_stream_switcher_control_output(upipe, command, args);
 
+    case UPIPE_STREAM_SWITCHER_SET_SPLICE: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_STREAM_SWITCHER_SIGNATURE)
+        upipe_stream_switcher->splice = !!va_arg(args, int);
+        return UBASE_ERR_NONE;
+    }
+
     default:
         return UBASE_ERR_UNHANDLED;
     }
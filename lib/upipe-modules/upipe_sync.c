@@ -156,6 +156,9 @@ struct upipe_sync_sub {
     /** channels */
     uint8_t channels;
 
+    /** zeroed buffer shared by all silent frames */
+    struct ubuf *silence;
+
     /** linked list of buffered urefs */
     struct uchain urefs;
 
@@ -205,6 +208,7 @@ static struct upipe *upipe_sync_sub_alloc(struct upipe_mgr *mgr,
     upipe_sync_sub->a52 = false;
     upipe_sync_sub->missed_compressed_audio_e = 0;
     upipe_sync_sub->uref = NULL;
+    upipe_sync_sub->silence = NULL;
 
     upipe_sync_sub_init_urefcount(upipe);
     upipe_sync_sub_init_output(upipe);
@@ -338,6 +342,11 @@ static int upipe_sync_sub_set_flow_def(struct upipe *upipe, struct uref *flow_de
         return UBASE_ERR_INVALID;
 
     UBASE_RETURN(uref_sound_flow_get_channels(flow_def, &upipe_sync_sub->channels));
+    /* the silence buffer depends on the number of channels */
+    if (upipe_sync_sub->silence != NULL) {
+        ubuf_free(upipe_sync_sub->silence);
+        upipe_sync_sub->silence = NULL;
+    }
 
     uint64_t rate;
     UBASE_RETURN(uref_sound_flow_get_rate(flow_def, &rate));
@@ -562,21 +571,46 @@ static struct uref *get_silence(struct upipe *upipe, size_t samples)
     if (!upipe_sync_sub->uref_mgr || !upipe_sync_sub->ubuf_mgr)
         return NULL;
 
-    struct uref *uref = uref_sound_alloc(upipe_sync_sub->uref_mgr,
-            upipe_sync_sub->ubuf_mgr, samples);
+    /* silence is zeroed once, and then shared by all the silent frames */
+    size_t silence_samples = 0;
+    if (upipe_sync_sub->silence == NULL ||
+        !ubase_check(ubuf_sound_size(upipe_sync_sub->silence,
+                                     &silence_samples, NULL)) ||
+        silence_samples < samples) {
+        if (upipe_sync_sub->silence != NULL) {
+            ubuf_free(upipe_sync_sub->silence);
+            upipe_sync_sub->silence = NULL;
+        }
 
-    if (!uref)
-        return NULL;
+        struct ubuf *ubuf = ubuf_sound_alloc(upipe_sync_sub->ubuf_mgr,
+                                             samples);
+        if (!ubuf)
+            return NULL;
+
+        int32_t *buf;
+        if (!ubase_check(ubuf_sound_write_int32_t(ubuf, 0, -1, &buf, 1))) {
+            upipe_err_va(upipe, "Could not map ubuf");
+            ubuf_free(ubuf);
+            return NULL;
+        }
+
+        memset(buf, 0, samples * sizeof(int32_t) * upipe_sync_sub->channels);
 
-    int32_t *buf;
-    if (!ubase_check(uref_sound_write_int32_t(uref, 0, -1, &buf, 1))) {
-        upipe_err_va(upipe, "Could not map uref");
-        return uref;
+        ubuf_sound_unmap(ubuf, 0, -1, 1);
+        upipe_sync_sub->silence = ubuf;
     }
 
-    memset(buf, 0, samples * sizeof(int32_t) * upipe_sync_sub->channels);
+    struct ubuf *ubuf = ubuf_dup(upipe_sync_sub->silence);
+    if (!ubuf)
+        return NULL;
+    ubuf_sound_resize(ubuf, 0, samples);
 
-    uref_sound_unmap(uref, 0, -1, 1);
+    struct uref *uref = uref_alloc(upipe_sync_sub->uref_mgr);
+    if (!uref) {
+        ubuf_free(ubuf);
+        return NULL;
+    }
+    uref_attach_ubuf(uref, ubuf);
 
     return uref;
 }
@@ -656,12 +690,13 @@ static void output_sound(struct upipe *upipe, const struct urational *fps,
         /* look at first uref without dequeuing */
         struct uref *src = uref_from_uchain(ulist_peek(&upipe_sync_sub->urefs));
         if (!src) {
-            src = get_silence(upipe_sub, samples);
-            if (src)
-                uref_clock_set_pts_sys(src, upipe_sync->pts - upipe_sync->latency);
-        }
-        if (!src) {
-            upipe_dbg_va(upipe_sub, "no urefs");
+            struct uref *uref = get_silence(upipe_sub, samples);
+            if (!uref) {
+                upipe_dbg_va(upipe_sub, "no urefs");
+                continue;
+            }
+            uref_clock_set_pts_sys(uref, upipe_sync->pts - upipe_sync->latency);
+            upipe_sync_sub_output(upipe_sub, uref, upump_p);
             continue;
         }
 
@@ -673,62 +708,93 @@ static void output_sound(struct upipe *upipe, const struct urational *fps,
             continue;
         }
 
-        /* output */
-        struct uref *uref = uref_dup_inner(src);
-        if (!uref)
-            upipe_err_va(upipe_sub, "Could not allocate ubuf");
-        uref->ubuf = ubuf_sound_alloc(src->ubuf->mgr, samples);
-        if (!uref->ubuf)
-            upipe_err_va(upipe_sub, "Could not allocate ubuf");
-        int32_t *dst_buf;
-        if (!ubase_check(uref_sound_write_int32_t(uref, 0, -1, &dst_buf, 1))) {
-            upipe_err_va(upipe_sub, "Could not map dst");
-        }
-        // map
-
-        while (samples) {
-            const int32_t *src_buf;
-            size_t src_samples = 0;
-            uref_sound_size(src, &src_samples, NULL);
-
-            if (!ubase_check(uref_sound_read_int32_t(src, 0, src_samples, &src_buf, 1))) {
-                upipe_err_va(upipe_sub, "Could not map src");
+        size_t src_samples = 0;
+        uref_sound_size(src, &src_samples, NULL);
+
+        struct uref *uref;
+        if (src_samples == samples) {
+            /* the buffer is exactly one frame, forward it */
+            ulist_pop(&upipe_sync_sub->urefs);
+            upipe_sync_sub->samples -= samples;
+            uref = src;
+        } else if (src_samples > samples) {
+            /* output a view on the beginning of the buffer */
+            uref = uref_dup(src);
+            if (!uref) {
+                upipe_err_va(upipe_sub, "Could not allocate uref");
+                continue;
             }
+            uref_sound_resize(uref, 0, samples);
+            uref_sound_resize(src, samples, -1);
+            upipe_sync_sub->samples -= samples;
 
-            size_t uref_samples = src_samples;
-            if (uref_samples > samples) {
-                uref_samples = samples;
+            pts += samples * UCLOCK_FREQ / 48000;
+            uref_clock_set_pts_sys(src, pts);
+        } else {
+            /* the frame spans several buffers, gather them */
+            uref = uref_dup_inner(src);
+            if (!uref) {
+                upipe_err_va(upipe_sub, "Could not allocate uref");
+                continue;
+            }
+            uref->ubuf = ubuf_sound_alloc(src->ubuf->mgr, samples);
+            if (!uref->ubuf) {
+                upipe_err_va(upipe_sub, "Could not allocate ubuf");
+                uref_free(uref);
+                continue;
+            }
+            int32_t *dst_buf;
+            if (!ubase_check(uref_sound_write_int32_t(uref, 0, -1, &dst_buf, 1))) {
+                upipe_err_va(upipe_sub, "Could not map dst");
+                uref_free(uref);
+                continue;
             }
 
-            memcpy(dst_buf, src_buf, channels * sizeof(int32_t) * uref_samples);
-            dst_buf += channels * uref_samples;
+            while (samples) {
+                const int32_t *src_buf;
+                src_samples = 0;
+                uref_sound_size(src, &src_samples, NULL);
 
-            uref_sound_unmap(src, 0, -1, 1);
+                if (!ubase_check(uref_sound_read_int32_t(src, 0, src_samples, &src_buf, 1))) {
+                    upipe_err_va(upipe_sub, "Could not map src");
+                }
 
-            src_samples -= uref_samples;
-            samples -= uref_samples;
-            upipe_sync_sub->samples -= uref_samples;
-            //upipe_notice_va(upipe_sub, "pop, samples %" PRIu64, upipe_sync_sub->samples);
+                size_t uref_samples = src_samples;
+                if (uref_samples > samples) {
+                    uref_samples = samples;
+                }
 
-            if (src_samples == 0) {
-                ulist_pop(&upipe_sync_sub->urefs);
-                uref_free(src);
-                src = uref_from_uchain(ulist_peek(&upipe_sync_sub->urefs));
-                if (!src)
-                    break;
-            } else {
-                uref_sound_resize(src, uref_samples, -1);
-                assert(samples == 0);
+                memcpy(dst_buf, src_buf, channels * sizeof(int32_t) * uref_samples);
+                dst_buf += channels * uref_samples;
+
+                uref_sound_unmap(src, 0, -1, 1);
 
-                uref_clock_get_pts_sys(src, &pts);
-                pts += uref_samples * UCLOCK_FREQ / 48000;
-                uref_clock_set_pts_sys(src, pts);
+                src_samples -= uref_samples;
+                samples -= uref_samples;
+                upipe_sync_sub->samples -= uref_samples;
+
+                if (src_samples == 0) {
+                    ulist_pop(&upipe_sync_sub->urefs);
+                    uref_free(src);
+                    src = uref_from_uchain(ulist_peek(&upipe_sync_sub->urefs));
+                    if (!src)
+                        break;
+                } else {
+                    uref_sound_resize(src, uref_samples, -1);
+                    assert(samples == 0);
+
+                    uref_clock_get_pts_sys(src, &pts);
+                    pts += uref_samples * UCLOCK_FREQ / 48000;
+                    uref_clock_set_pts_sys(src, pts);
+                }
             }
 
-            // TODO : next uref
+            /* pad with silence if the queue ran out */
+            memset(dst_buf, 0, channels * sizeof(int32_t) * samples);
+
+            uref_sound_unmap(uref, 0, -1, 1);
         }
 
-        uref_sound_unmap(uref, 0, -1, 1);
         uref_clock_set_pts_sys(uref, upipe_sync->pts - upipe_sync->latency);
         upipe_sync_sub_output(upipe_sub, uref, upump_p);
     }
@@ -1120,6 +1186,8 @@ static void upipe_sync_sub_free(struct upipe *upipe)
 
     ulist_uref_flush(&upipe_sync_sub->urefs);
     uref_free(upipe_sync_sub->uref);
+    if (upipe_sync_sub->silence != NULL)
+        ubuf_free(upipe_sync_sub->silence);
 
     upipe_sync_sub_clean_urefcount(upipe);
     upipe_sync_sub_clean_output(upipe);
@@ -31,8 +31,10 @@
 #include <upipe/ubase.h>
 #include <upipe/urefcount.h>
 #include <upipe/umutex.h>
+#include <upipe/uatomic.h>
 #include <upipe/ulifo.h>
 #include <upipe/uqueue.h>
+#include <upipe/uclock.h>
 #include <upipe/uprobe.h>
 #include <upipe/upump.h>
 #include <upipe/upipe.h>
@@ -70,6 +72,14 @@ struct upipe_xfer_mgr {
     struct upump_mgr *upump_mgr;
     /** queue length */
     uint8_t queue_length;
+    /** number of live xfer pipes */
+    uatomic_uint32_t nb_pipes;
+    /** lock protecting the batch, as commands may come from any thread */
+    uatomic_uint32_t batch_lock;
+    /** nesting level of @ref upipe_xfer_mgr_start_batch */
+    unsigned int batch_depth;
+    /** coalesced messages waiting to be sent, or NULL */
+    struct upipe_xfer_msg *batch;
     /** queue of messages */
     struct uqueue uqueue;
     /** pool of @ref upipe_xfer_msg */
@@ -118,12 +128,14 @@ union upipe_xfer_event_arg {
 /** @hidden */
 static int upipe_xfer_mgr_send(struct upipe_mgr *mgr, int type,
                                struct upipe *upipe_remote,
-                               union upipe_xfer_arg arg);
+                               union upipe_xfer_arg arg,
+                               struct upump_mgr *upump_mgr);
 
 /** @This stores a message to send.
  */
 struct upipe_xfer_msg {
-    /** structure for double-linked lists */
+    /** structure for double-linked lists, also used as the list of the
+     * messages coalesced behind this one */
     struct uchain uchain;
 
     /** type of command */
@@ -154,6 +166,7 @@ static struct upipe_xfer_msg *upipe_xfer_msg_alloc(struct upipe_mgr *mgr)
         msg = malloc(sizeof(struct upipe_xfer_msg));
     if (unlikely(msg == NULL))
         return NULL;
+    ulist_init(&msg->uchain);
     return msg;
 }
 
@@ -354,6 +367,7 @@ static struct upipe *_upipe_xfer_alloc(struct upipe_mgr *mgr,
         upipe_xfer_to_urefcount_probe(upipe_xfer);
     upipe_push_probe(upipe_remote, &upipe_xfer->uprobe_remote);
     upipe_xfer->upipe_remote = upipe_remote;
+    uatomic_fetch_add(&xfer_mgr->nb_pipes, 1);
     upipe_throw_ready(upipe);
     return upipe;
 
@@ -428,7 +442,8 @@ static int upipe_xfer_control(struct upipe *upipe, int command, va_list args)
                 upipe_warn(upipe, "unable to allocate upstream queue");
             union upipe_xfer_arg arg = { .pipe = NULL };
             return upipe_xfer_mgr_send(upipe->mgr, UPIPE_XFER_ATTACH_UPUMP_MGR,
-                                       upipe_xfer->upipe_remote, arg);
+                                       upipe_xfer->upipe_remote, arg,
+                                       upipe_xfer->upump_mgr);
         }
         case UPIPE_SET_URI: {
             struct upipe_xfer *upipe_xfer = upipe_xfer_from_upipe(upipe);
@@ -441,14 +456,16 @@ static int upipe_xfer_control(struct upipe *upipe, int command, va_list args)
             }
             union upipe_xfer_arg arg = { .string = uri_dup };
             return upipe_xfer_mgr_send(upipe->mgr, UPIPE_XFER_SET_URI,
-                                       upipe_xfer->upipe_remote, arg);
+                                       upipe_xfer->upipe_remote, arg,
+                                       upipe_xfer->upump_mgr);
         }
         case UPIPE_SET_OUTPUT: {
             struct upipe_xfer *upipe_xfer = upipe_xfer_from_upipe(upipe);
             struct upipe *output = va_arg(args, struct upipe *);
             union upipe_xfer_arg arg = { .pipe = upipe_use(output) };
             return upipe_xfer_mgr_send(upipe->mgr, UPIPE_XFER_SET_OUTPUT,
-                                       upipe_xfer->upipe_remote, arg);
+                                       upipe_xfer->upipe_remote, arg,
+                                       upipe_xfer->upump_mgr);
         }
 
         case UPIPE_XFER_GET_REMOTE: {
@@ -472,7 +489,9 @@ static void upipe_xfer_free(struct urefcount *urefcount_real)
     struct upipe_xfer *upipe_xfer =
         upipe_xfer_from_urefcount_real(urefcount_real);
     struct upipe *upipe = upipe_xfer_to_upipe(upipe_xfer);
+    struct upipe_xfer_mgr *xfer_mgr = upipe_xfer_mgr_from_upipe_mgr(upipe->mgr);
     upipe_throw_dead(upipe);
+    uatomic_fetch_sub(&xfer_mgr->nb_pipes, 1);
     uqueue_clean(&upipe_xfer->uqueue);
     upipe_xfer_clean_upump(upipe);
     upipe_xfer_clean_upump_mgr(upipe);
@@ -495,7 +514,8 @@ static void upipe_xfer_no_ref(struct upipe *upipe)
     if (unlikely(!ubase_check(upipe_xfer_mgr_send(upipe->mgr,
                                                   UPIPE_XFER_RELEASE,
                                                   upipe_xfer->upipe_remote,
-                                                  arg))))
+                                                  arg,
+                                                  upipe_xfer->upump_mgr))))
         upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
 }
 
@@ -525,11 +545,41 @@ static void upipe_xfer_mgr_free(struct upipe_mgr *mgr)
     upump_free(xfer_mgr->upump);
     upump_mgr_release(xfer_mgr->upump_mgr);
     uqueue_clean(&xfer_mgr->uqueue);
+    uatomic_clean(&xfer_mgr->nb_pipes);
+    uatomic_clean(&xfer_mgr->batch_lock);
     umutex_release(xfer_mgr->mutex);
     upipe_xfer_mgr_vacuum(mgr);
     free(xfer_mgr);
 }
 
+/** @internal @This executes a command on a remote pipe. This runs in the
+ * remote thread.
+ *
+ * @param msg message containing the command
+ */
+static void upipe_xfer_mgr_process(struct upipe_xfer_msg *msg)
+{
+    switch (msg->type) {
+        case UPIPE_XFER_ATTACH_UPUMP_MGR:
+            upipe_attach_upump_mgr(msg->upipe_remote);
+            break;
+        case UPIPE_XFER_SET_URI:
+            upipe_set_uri(msg->upipe_remote, msg->arg.string);
+            free(msg->arg.string);
+            break;
+        case UPIPE_XFER_SET_OUTPUT:
+            upipe_set_output(msg->upipe_remote, msg->arg.pipe);
+            upipe_release(msg->arg.pipe);
+            break;
+        case UPIPE_XFER_RELEASE:
+            upipe_release(msg->upipe_remote);
+            break;
+        default:
+            /* this should not happen */
+            break;
+    }
+}
+
 /** @This is called by the remote upump manager to receive messages.
  *
  * @param upump description structure of the read watcher
@@ -541,47 +591,109 @@ static void upipe_xfer_mgr_worker(struct upump *upump)
     struct upipe_xfer_msg *msg;
     while ((msg = uqueue_pop(&xfer_mgr->uqueue,
                              struct upipe_xfer_msg *)) != NULL) {
-        switch (msg->type) {
-            case UPIPE_XFER_ATTACH_UPUMP_MGR:
-                upipe_attach_upump_mgr(msg->upipe_remote);
-                break;
-            case UPIPE_XFER_SET_URI:
-                upipe_set_uri(msg->upipe_remote, msg->arg.string);
-                free(msg->arg.string);
-                break;
-            case UPIPE_XFER_SET_OUTPUT:
-                upipe_set_output(msg->upipe_remote, msg->arg.pipe);
-                upipe_release(msg->arg.pipe);
-                break;
-            case UPIPE_XFER_RELEASE:
-                upipe_release(msg->upipe_remote);
-                break;
-            case UPIPE_XFER_DETACH:
-                upipe_xfer_msg_free(mgr, msg);
-                upipe_xfer_mgr_free(mgr);
-                return;
-            default:
-                /* this should not happen */
-                break;
+        if (unlikely(msg->type == UPIPE_XFER_DETACH)) {
+            /* execute the batch carried by the detach message */
+            struct uchain *uchain;
+            while ((uchain = ulist_pop(&msg->uchain)) != NULL) {
+                struct upipe_xfer_msg *coalesced =
+                    upipe_xfer_msg_from_uchain(uchain);
+                upipe_xfer_mgr_process(coalesced);
+                upipe_xfer_msg_free(mgr, coalesced);
+            }
+            upipe_xfer_msg_free(mgr, msg);
+            upipe_xfer_mgr_free(mgr);
+            return;
         }
 
+        upipe_xfer_mgr_process(msg);
+        struct uchain *uchain;
+        while ((uchain = ulist_pop(&msg->uchain)) != NULL) {
+            struct upipe_xfer_msg *coalesced =
+                upipe_xfer_msg_from_uchain(uchain);
+            upipe_xfer_mgr_process(coalesced);
+            upipe_xfer_msg_free(mgr, coalesced);
+        }
         upipe_xfer_msg_free(mgr, msg);
     }
 }
 
-/** @This sends a message to the remote upump manager.
+/** @internal @This takes the lock protecting the batch.
+ *
+ * @param xfer_mgr xfer_mgr structure
+ */
+static void upipe_xfer_mgr_lock_batch(struct upipe_xfer_mgr *xfer_mgr)
+{
+    uint32_t expected = 0;
+    while (!uatomic_compare_exchange(&xfer_mgr->batch_lock, &expected, 1))
+        expected = 0;
+}
+
+/** @internal @This releases the lock protecting the batch.
+ *
+ * @param xfer_mgr xfer_mgr structure
+ */
+static void upipe_xfer_mgr_unlock_batch(struct upipe_xfer_mgr *xfer_mgr)
+{
+    uatomic_store(&xfer_mgr->batch_lock, 0);
+}
+
+/** @internal @This pushes the coalesced messages to the remote upump
+ * manager. It must be called with the batch lock held.
+ *
+ * @param mgr xfer_mgr structure
+ * @return an error code
+ */
+static int upipe_xfer_mgr_push_batch(struct upipe_mgr *mgr)
+{
+    struct upipe_xfer_mgr *xfer_mgr = upipe_xfer_mgr_from_upipe_mgr(mgr);
+    if (xfer_mgr->batch == NULL)
+        return UBASE_ERR_NONE;
+    if (unlikely(!uqueue_push(&xfer_mgr->uqueue, xfer_mgr->batch)))
+        /* kept for the next attempt */
+        return UBASE_ERR_EXTERNAL;
+    xfer_mgr->batch = NULL;
+    return UBASE_ERR_NONE;
+}
+
+/** @This sends a message to the remote upump manager. If the caller runs
+ * the remote event loop itself and no message is pending, the command is
+ * executed synchronously. While a batch is open, commands are coalesced
+ * into a single message. Otherwise a batch left over by a failed
+ * @ref upipe_xfer_mgr_end_batch is sent first, so that the commands are
+ * executed in order.
  *
  * @param mgr xfer_mgr structure
  * @param type type of message
  * @param upipe_remote optional remote pipe
- * @paral arg optional argument
+ * @param arg optional argument
+ * @param upump_mgr event loop of the caller, or NULL if unknown
  * @return an error code
  */
 static int upipe_xfer_mgr_send(struct upipe_mgr *mgr, int type,
                                struct upipe *upipe_remote,
-                               union upipe_xfer_arg arg)
+                               union upipe_xfer_arg arg,
+                               struct upump_mgr *upump_mgr)
 {
     struct upipe_xfer_mgr *xfer_mgr = upipe_xfer_mgr_from_upipe_mgr(mgr);
+
+    /* upump managers are not thread-safe, so the caller is in the remote
+     * thread; xfer_mgr->upump_mgr is only written once, on attach */
+    if (upump_mgr != NULL && type != UPIPE_XFER_DETACH &&
+        upump_mgr == xfer_mgr->upump_mgr) {
+        upipe_xfer_mgr_lock_batch(xfer_mgr);
+        bool pending = xfer_mgr->batch_depth || xfer_mgr->batch != NULL ||
+                       uqueue_length(&xfer_mgr->uqueue);
+        upipe_xfer_mgr_unlock_batch(xfer_mgr);
+        if (!pending) {
+            struct upipe_xfer_msg msg;
+            msg.type = type;
+            msg.upipe_remote = upipe_remote;
+            msg.arg = arg;
+            upipe_xfer_mgr_process(&msg);
+            return UBASE_ERR_NONE;
+        }
+    }
+
     struct upipe_xfer_msg *msg = upipe_xfer_msg_alloc(mgr);
     if (msg == NULL)
         return UBASE_ERR_ALLOC;
@@ -590,10 +702,37 @@ static int upipe_xfer_mgr_send(struct upipe_mgr *mgr, int type,
     msg->upipe_remote = upipe_remote;
     msg->arg = arg;
 
-    if (unlikely(!uqueue_push(&xfer_mgr->uqueue, msg))) {
+    upipe_xfer_mgr_lock_batch(xfer_mgr);
+    if (type == UPIPE_XFER_DETACH && xfer_mgr->batch != NULL) {
+        /* the pending batch is carried by the detach message, so that it is
+         * executed before the detach even if the queue is full */
+        struct upipe_xfer_msg *pending = xfer_mgr->batch;
+        xfer_mgr->batch = NULL;
+        struct uchain coalesced, *uchain;
+        ulist_init(&coalesced);
+        while ((uchain = ulist_pop(&pending->uchain)) != NULL)
+            ulist_add(&coalesced, uchain);
+        ulist_add(&msg->uchain, upipe_xfer_msg_to_uchain(pending));
+        while ((uchain = ulist_pop(&coalesced)) != NULL)
+            ulist_add(&msg->uchain, uchain);
+    }
+
+    if (type != UPIPE_XFER_DETACH && xfer_mgr->batch_depth) {
+        if (xfer_mgr->batch == NULL)
+            xfer_mgr->batch = msg;
+        else
+            ulist_add(&xfer_mgr->batch->uchain, upipe_xfer_msg_to_uchain(msg));
+        upipe_xfer_mgr_unlock_batch(xfer_mgr);
+        return UBASE_ERR_NONE;
+    }
+
+    if (unlikely(!ubase_check(upipe_xfer_mgr_push_batch(mgr)) ||
+                 !uqueue_push(&xfer_mgr->uqueue, msg))) {
+        upipe_xfer_mgr_unlock_batch(xfer_mgr);
         upipe_xfer_msg_free(mgr, msg);
         return UBASE_ERR_EXTERNAL;
     }
+    upipe_xfer_mgr_unlock_batch(xfer_mgr);
     return UBASE_ERR_NONE;
 }
 
@@ -609,7 +748,7 @@ static void upipe_xfer_mgr_detach(struct urefcount *urefcount)
     assert(xfer_mgr->upump_mgr != NULL);
     union upipe_xfer_arg arg = { .pipe = NULL };
     upipe_xfer_mgr_send(upipe_xfer_mgr_to_upipe_mgr(xfer_mgr),
-                        UPIPE_XFER_DETACH, NULL, arg);
+                        UPIPE_XFER_DETACH, NULL, arg, NULL);
     urefcount_clean(urefcount);
 }
 
@@ -676,6 +815,25 @@ static inline int _upipe_xfer_mgr_thaw(struct upipe_mgr *mgr)
     return err;
 }
 
+/** @This sets the wait policy of the remote event loop on an empty queue of
+ * commands.
+ *
+ * @param mgr xfer_mgr structure
+ * @param spin time (in 27 MHz ticks) to busy-poll the queue
+ * @param yields number of times to yield the CPU before blocking
+ * @return an error code
+ */
+static int _upipe_xfer_mgr_set_wait_policy(struct upipe_mgr *mgr,
+                                           uint64_t spin, unsigned int yields)
+{
+    struct upipe_xfer_mgr *xfer_mgr = upipe_xfer_mgr_from_upipe_mgr(mgr);
+    if (unlikely(spin > UCLOCK_FREQ))
+        return UBASE_ERR_INVALID;
+    uqueue_set_wait_policy(&xfer_mgr->uqueue,
+                           spin * UINT64_C(1000000000) / UCLOCK_FREQ, yields);
+    return UBASE_ERR_NONE;
+}
+
 /** @This processes manager control commands.
  *
  * @param mgr xfer_mgr structure
@@ -700,6 +858,46 @@ static int upipe_xfer_mgr_control(struct upipe_mgr *mgr,
             UBASE_SIGNATURE_CHECK(args, UPIPE_XFER_SIGNATURE)
             return _upipe_xfer_mgr_thaw(mgr);
         }
+        case UPIPE_XFER_MGR_SET_WAIT_POLICY: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_XFER_SIGNATURE)
+            uint64_t spin = va_arg(args, uint64_t);
+            unsigned int yields = va_arg(args, unsigned int);
+            return _upipe_xfer_mgr_set_wait_policy(mgr, spin, yields);
+        }
+        case UPIPE_XFER_MGR_START_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_XFER_SIGNATURE)
+            struct upipe_xfer_mgr *xfer_mgr =
+                upipe_xfer_mgr_from_upipe_mgr(mgr);
+            upipe_xfer_mgr_lock_batch(xfer_mgr);
+            xfer_mgr->batch_depth++;
+            upipe_xfer_mgr_unlock_batch(xfer_mgr);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_XFER_MGR_END_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_XFER_SIGNATURE)
+            struct upipe_xfer_mgr *xfer_mgr =
+                upipe_xfer_mgr_from_upipe_mgr(mgr);
+            upipe_xfer_mgr_lock_batch(xfer_mgr);
+            int err = UBASE_ERR_NONE;
+            if (!xfer_mgr->batch_depth || !--xfer_mgr->batch_depth)
+                err = upipe_xfer_mgr_push_batch(mgr);
+            upipe_xfer_mgr_unlock_batch(xfer_mgr);
+            return err;
+        }
+        case UPIPE_XFER_MGR_GET_LOAD: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_XFER_SIGNATURE)
+            struct upipe_xfer_mgr *xfer_mgr =
+                upipe_xfer_mgr_from_upipe_mgr(mgr);
+            unsigned int *load_p = va_arg(args, unsigned int *);
+            *load_p = uatomic_load(&xfer_mgr->nb_pipes);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_XFER_MGR_SELECT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_XFER_SIGNATURE)
+            struct upipe_mgr **xfer_mgr_p = va_arg(args, struct upipe_mgr **);
+            *xfer_mgr_p = upipe_mgr_use(mgr);
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -736,6 +934,10 @@ struct upipe_mgr *upipe_xfer_mgr_alloc(uint8_t queue_length,
     xfer_mgr->upump = NULL;
     xfer_mgr->upump_mgr = NULL;
     xfer_mgr->queue_length = queue_length;
+    uatomic_init(&xfer_mgr->nb_pipes, 0);
+    uatomic_init(&xfer_mgr->batch_lock, 0);
+    xfer_mgr->batch_depth = 0;
+    xfer_mgr->batch = NULL;
     ulifo_init(&xfer_mgr->msg_pool, msg_pool_depth,
                xfer_mgr->extra + uqueue_sizeof(queue_length));
 
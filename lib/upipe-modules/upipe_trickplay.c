@@ -33,6 +33,7 @@
 #include <upipe/uclock.h>
 #include <upipe/uref.h>
 #include <upipe/uref_clock.h>
+#include <upipe/uref_flow.h>
 #include <upipe/upipe.h>
 #include <upipe/upipe_helper_upipe.h>
 #include <upipe/upipe_helper_urefcount.h>
@@ -54,6 +55,8 @@ static uint64_t upipe_trickp_get_date_sys(struct upipe *upipe, uint64_t ts);
 /** @hidden */
 static int upipe_trickp_check_start(struct upipe *upipe, struct uref *);
 /** @hidden */
+static void upipe_trickp_reset_uclock(struct upipe *upipe);
+/** @hidden */
 static bool upipe_trickp_sub_process(struct upipe *upipe, struct uref *uref,
                                      struct upump **upump);
 
@@ -76,6 +79,8 @@ struct upipe_trickp {
 
     /** current rate */
     struct urational rate;
+    /** rate above which only random access pictures are output, or 0 */
+    struct urational keyframe_rate;
     /** list of subs */
     struct uchain subs;
 
@@ -206,6 +211,22 @@ static bool upipe_trickp_sub_process(struct upipe *upipe, struct uref *uref,
     return true;
 }
 
+/** @internal @This checks if the current rate only allows random access
+ * pictures.
+ *
+ * @param upipe_trickp private context of the trickp pipe
+ * @return true if other pictures must be skipped
+ */
+static inline bool upipe_trickp_keyframe_only(struct upipe_trickp *upipe_trickp)
+{
+    struct urational *rate = &upipe_trickp->rate;
+    struct urational *keyframe_rate = &upipe_trickp->keyframe_rate;
+    if (keyframe_rate->num <= 0 || rate->num <= 0 || !rate->den)
+        return false;
+    return (uint64_t)rate->num * keyframe_rate->den >
+           (uint64_t)keyframe_rate->num * rate->den;
+}
+
 /** @internal @This receives data.
  *
  * @param upipe description structure of the pipe
@@ -216,6 +237,23 @@ static void upipe_trickp_sub_input(struct upipe *upipe, struct uref *uref,
                                    struct upump **upump_p)
 {
     struct upipe_trickp *upipe_trickp = upipe_trickp_from_sub_mgr(upipe->mgr);
+    struct upipe_trickp_sub *upipe_trickp_sub =
+        upipe_trickp_sub_from_upipe(upipe);
+
+    if (unlikely(ubase_check(uref_flow_get_discontinuity(uref)) &&
+                 upipe_trickp->systime_offset)) {
+        /* the source has sought, re-anchor on the new access point */
+        upipe_dbg(upipe, "discontinuity, resetting origin");
+        upipe_trickp_reset_uclock(upipe_trickp_to_upipe(upipe_trickp));
+    }
+
+    if (upipe_trickp_sub->type == UPIPE_TRICKP_PIC &&
+        upipe_trickp_keyframe_only(upipe_trickp) &&
+        !ubase_check(uref_flow_get_random(uref))) {
+        /* skip the picture before it reaches the decoder */
+        uref_free(uref);
+        return;
+    }
 
     if (upipe_trickp->uclock == NULL || upipe_trickp->rate.num == 0 ||
         upipe_trickp->rate.den == 0) {
@@ -351,6 +389,8 @@ static struct upipe *upipe_trickp_alloc(struct upipe_mgr *mgr,
     upipe_trickp->ts_origin = 0;
     upipe_trickp->preroll = true;
     upipe_trickp->rate.num = upipe_trickp->rate.den = 1;
+    upipe_trickp->keyframe_rate.num = 0;
+    upipe_trickp->keyframe_rate.den = 1;
     upipe_throw_ready(upipe);
     upipe_trickp_require_uclock(upipe);
     return upipe;
@@ -498,6 +538,40 @@ static inline int _upipe_trickp_set_rate(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @This returns the rate above which only random access pictures are
+ * output.
+ *
+ * @param upipe description structure of the pipe
+ * @param rate_p filled with the rate (0 = disabled)
+ * @return an error code
+ */
+static inline int _upipe_trickp_get_keyframe_rate(struct upipe *upipe,
+                                                  struct urational *rate_p)
+{
+    struct upipe_trickp *upipe_trickp = upipe_trickp_from_upipe(upipe);
+    *rate_p = upipe_trickp->keyframe_rate;
+    return UBASE_ERR_NONE;
+}
+
+/** @This sets the rate above which only random access pictures are output.
+ *
+ * @param upipe description structure of the pipe
+ * @param rate new rate (0 = disabled)
+ * @return an error code
+ */
+static inline int _upipe_trickp_set_keyframe_rate(struct upipe *upipe,
+                                                  struct urational rate)
+{
+    struct upipe_trickp *upipe_trickp = upipe_trickp_from_upipe(upipe);
+    if (rate.num && !rate.den)
+        return UBASE_ERR_INVALID;
+    upipe_trickp->keyframe_rate = rate;
+    if (rate.num)
+        upipe_dbg_va(upipe, "skipping non-key pictures above rate %f",
+                     (float)rate.num/rate.den);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a trickp pipe.
  *
  * @param upipe description structure of the pipe
@@ -527,6 +601,16 @@ static int upipe_trickp_control(struct upipe *upipe, int command, va_list args)
             struct urational rate = va_arg(args, struct urational);
             return _upipe_trickp_set_rate(upipe, rate);
         }
+        case UPIPE_TRICKP_GET_KEYFRAME_RATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TRICKP_SIGNATURE)
+            struct urational *p = va_arg(args, struct urational *);
+            return _upipe_trickp_get_keyframe_rate(upipe, p);
+        }
+        case UPIPE_TRICKP_SET_KEYFRAME_RATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TRICKP_SIGNATURE)
+            struct urational rate = va_arg(args, struct urational);
+            return _upipe_trickp_set_keyframe_rate(upipe, rate);
+        }
 
         default:
             return UBASE_ERR_UNHANDLED;
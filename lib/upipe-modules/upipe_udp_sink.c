@@ -28,6 +28,8 @@
  * @short Upipe sink module for udp
  */
 
+#include <config.h>
+
 #include <upipe/ubase.h>
 #include <upipe/ulist.h>
 #include <upipe/uprobe.h>
@@ -35,6 +37,8 @@
 #include <upipe/uref.h>
 #include <upipe/uref_block.h>
 #include <upipe/uref_clock.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uts_pcr.h>
 #include <upipe/upump.h>
 #include <upipe/ubuf.h>
 #include <upipe/upipe.h>
@@ -56,11 +60,19 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <errno.h>
+#include <limits.h>
 #include <assert.h>
+#include <time.h>
+#ifdef SO_TXTIME
+#include <linux/net_tstamp.h>
+#endif
 
 /** tolerance for late packets */
 #define SYSTIME_TOLERANCE UCLOCK_FREQ
@@ -72,6 +84,23 @@
 #define UDP_DEFAULT_TTL 0
 #define UDP_DEFAULT_PORT 1234
 
+/** maximum number of datagrams sent at once in batch mode */
+#define UDP_MAX_BATCH_SIZE 1024
+/** maximum number of segments of a GSO send */
+#define UDP_MAX_GSO_SEGMENTS 64
+/** maximum payload of a GSO send */
+#define UDP_MAX_GSO_SIZE 65000
+/** margin applied to the flow octetrate when pacing by rate (percent) */
+#define PACING_RATE_MARGIN 5
+
+/** @internal @This is a destination of a multi-destination sink. */
+struct upipe_udpsink_peer {
+    /** remote address */
+    struct sockaddr_storage addr;
+    /** size of the remote address */
+    socklen_t addrlen;
+};
+
 /** @hidden */
 static void upipe_udpsink_watcher(struct upump *upump);
 /** @hidden */
@@ -108,6 +137,39 @@ struct upipe_udpsink {
     /** list of blockers */
     struct uchain blockers;
 
+    /** maximum number of datagrams sent at once (1 disables batching) */
+    unsigned int batch_size;
+    /** held datagrams due within this delay are sent early in batch mode */
+    uint64_t batch_window;
+    /** true if UDP generic segmentation offload is requested */
+    bool gso;
+
+    /** datagrams due within this delay are handed to the kernel for
+     * pacing (0 disables kernel pacing) */
+    uint64_t pacing_horizon;
+    /** clock of the launch times given to the kernel */
+    clockid_t txtime_clockid;
+    /** true if the socket accepts launch times (SO_TXTIME) */
+    bool txtime;
+    /** maximum pacing rate set by the user, in octets per second */
+    uint64_t pacing_rate;
+    /** octetrate of the flow definition */
+    uint64_t octetrate;
+    /** true if the socket is rate-limited (SO_MAX_PACING_RATE) */
+    bool rate_limited;
+    /** true if the PCRs are restamped with the launch times */
+    bool pcr_restamp;
+
+    /** burst rate when a receiver joins, in octets per second (0 disables
+     * bursts) */
+    uint64_t burst_rate;
+    /** true if a burst starts with the next datagram */
+    bool burst_pending;
+    /** true if late datagrams are being sent at the burst rate */
+    bool burst;
+    /** date at which the next datagram of the burst may be sent */
+    uint64_t burst_next;
+
     /** RAW sockets */
     bool raw;
     /** RAW header */
@@ -117,6 +179,12 @@ struct upipe_udpsink {
     struct sockaddr_storage addr;
     /** destination for not-connected socket (size) */
     socklen_t addrlen;
+    /** array of destinations */
+    struct upipe_udpsink_peer *peers;
+    /** number of destinations */
+    unsigned int nb_peers;
+    /** number of destinations the first held datagram was sent to */
+    unsigned int peer_sent;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -158,6 +226,23 @@ static struct upipe *upipe_udpsink_alloc(struct upipe_mgr *mgr,
     upipe_udpsink->uri = NULL;
     upipe_udpsink->raw = false;
     upipe_udpsink->addrlen = 0;
+    upipe_udpsink->peers = NULL;
+    upipe_udpsink->nb_peers = 0;
+    upipe_udpsink->peer_sent = 0;
+    upipe_udpsink->batch_size = 1;
+    upipe_udpsink->batch_window = 0;
+    upipe_udpsink->gso = false;
+    upipe_udpsink->pacing_horizon = 0;
+    upipe_udpsink->txtime_clockid = CLOCK_MONOTONIC;
+    upipe_udpsink->txtime = false;
+    upipe_udpsink->pacing_rate = 0;
+    upipe_udpsink->octetrate = 0;
+    upipe_udpsink->rate_limited = false;
+    upipe_udpsink->pcr_restamp = false;
+    upipe_udpsink->burst_rate = 0;
+    upipe_udpsink->burst_pending = false;
+    upipe_udpsink->burst = false;
+    upipe_udpsink->burst_next = 0;
     upipe_throw_ready(upipe);
     return upipe;
 }
@@ -185,6 +270,475 @@ static void upipe_udpsink_poll(struct upipe *upipe)
     }
 }
 
+/** @internal @This configures kernel pacing on the socket. Launch times
+ * (SO_TXTIME, honoured by the fq and etf qdiscs) are preferred, otherwise
+ * the socket is rate-limited (SO_MAX_PACING_RATE, honoured by the fq qdisc)
+ * to the configured rate or slightly above the flow octetrate.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsink_apply_pacing(struct upipe *upipe)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    upipe_udpsink->txtime = false;
+    if (upipe_udpsink->fd == -1)
+        return;
+
+#ifdef SO_TXTIME
+    if (upipe_udpsink->pacing_horizon && !upipe_udpsink->raw) {
+        struct sock_txtime sock_txtime = {
+            .clockid = upipe_udpsink->txtime_clockid,
+            .flags = 0,
+        };
+        if (setsockopt(upipe_udpsink->fd, SOL_SOCKET, SO_TXTIME,
+                       &sock_txtime, sizeof(sock_txtime)) == 0)
+            upipe_udpsink->txtime = true;
+        else
+            upipe_dbg_va(upipe, "can't set launch times (%m)");
+    }
+#endif
+
+#ifdef SO_MAX_PACING_RATE
+    uint64_t rate = 0;
+    if (upipe_udpsink->pacing_rate)
+        rate = upipe_udpsink->pacing_rate;
+    else if (upipe_udpsink->pacing_horizon && !upipe_udpsink->txtime)
+        rate = upipe_udpsink->octetrate * (100 + PACING_RATE_MARGIN) / 100;
+    if (rate || upipe_udpsink->rate_limited) {
+        /* the option is an unsigned long since Linux 4.20 */
+        unsigned long value = !rate || rate > ULONG_MAX ? ULONG_MAX : rate;
+        upipe_udpsink->rate_limited = rate != 0;
+        if (setsockopt(upipe_udpsink->fd, SOL_SOCKET, SO_MAX_PACING_RATE,
+                       &value, sizeof(value)) < 0) {
+            upipe_warn_va(upipe, "can't set pacing rate (%m)");
+            upipe_udpsink->rate_limited = false;
+        }
+    }
+#endif
+}
+
+/** @internal @This returns the delay before the due time of a datagram at
+ * which it may be handed to the kernel.
+ *
+ * @param upipe description structure of the pipe
+ * @return delay in 27 MHz units
+ */
+static uint64_t upipe_udpsink_horizon(struct upipe *upipe)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    if (upipe_udpsink->raw || upipe_udpsink->uclock == NULL)
+        return 0;
+    if (upipe_udpsink->txtime)
+        return upipe_udpsink->pacing_horizon;
+    if (upipe_udpsink->rate_limited)
+        return upipe_udpsink->pacing_horizon;
+    return 0;
+}
+
+/** @internal @This sends a contiguous range of datagrams of the same size
+ * (except the last one) with a single write, using UDP generic
+ * segmentation offload.
+ *
+ * @param upipe description structure of the pipe
+ * @param urefs array of urefs to send
+ * @param nb number of urefs in the array
+ * @param sent_p filled in with the number of urefs sent
+ * @return -1 in case of error, in which case errno is set
+ */
+static int upipe_udpsink_send_gso(struct upipe *upipe, struct uref **urefs,
+                                  unsigned int nb, unsigned int *sent_p)
+{
+    *sent_p = 0;
+#ifdef UDP_SEGMENT
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    size_t segment_size = 0;
+    int iovec_count = 0;
+    unsigned int count;
+    for (count = 0; count < nb && count < UDP_MAX_GSO_SEGMENTS; count++) {
+        size_t size = 0;
+        int iovecs = uref_block_iovec_count(urefs[count], 0, -1);
+        if (!ubase_check(uref_block_size(urefs[count], &size)) ||
+            iovecs <= 0 || iovec_count + iovecs > IOV_MAX)
+            break;
+        if (count == 0)
+            segment_size = size;
+        else if (size > segment_size ||
+                 (count + 1) * segment_size > UDP_MAX_GSO_SIZE)
+            break;
+        iovec_count += iovecs;
+        if (size < segment_size) {
+            /* only the last segment may be shorter */
+            count++;
+            break;
+        }
+    }
+    if (count < 2)
+        return 0;
+
+    struct iovec iovecs[iovec_count];
+    int iovec_nb = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        int nb_iovecs = uref_block_iovec_count(urefs[i], 0, -1);
+        if (unlikely(!ubase_check(uref_block_iovec_read(urefs[i], 0, -1,
+                                                        iovecs + iovec_nb)))) {
+            for (unsigned int j = 0, k = 0; j < i; j++) {
+                uref_block_iovec_unmap(urefs[j], 0, -1, iovecs + k);
+                k += uref_block_iovec_count(urefs[j], 0, -1);
+            }
+            errno = EINVAL;
+            return -1;
+        }
+        iovec_nb += nb_iovecs;
+    }
+
+    uint16_t gso_size = segment_size;
+    uint8_t control[CMSG_SPACE(sizeof(gso_size))];
+    memset(control, 0, sizeof(control));
+    struct msghdr msghdr = {
+        .msg_name = upipe_udpsink->addrlen ? &upipe_udpsink->addr : NULL,
+        .msg_namelen = upipe_udpsink->addrlen,
+
+        .msg_iov = iovecs,
+        .msg_iovlen = iovec_nb,
+
+        .msg_control = control,
+        .msg_controllen = sizeof(control),
+        .msg_flags = 0,
+    };
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msghdr);
+    cmsg->cmsg_level = IPPROTO_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(gso_size));
+    memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+
+    ssize_t ret = sendmsg(upipe_udpsink->fd, &msghdr, 0);
+    for (unsigned int i = 0, k = 0; i < count; i++) {
+        uref_block_iovec_unmap(urefs[i], 0, -1, iovecs + k);
+        k += uref_block_iovec_count(urefs[i], 0, -1);
+    }
+    if (ret == -1)
+        return -1;
+    *sent_p = count;
+#endif
+    return 0;
+}
+
+/** @internal @This sends an array of datagrams with a single sendmmsg()
+ * call. With several destinations, each datagram is sent to all of them,
+ * from the destination where the previous call stopped.
+ *
+ * @param upipe description structure of the pipe
+ * @param urefs array of urefs to send
+ * @param txtimes array of launch times in nanoseconds, or NULL
+ * @param nb number of urefs in the array
+ * @param sent_p filled in with the number of urefs sent
+ * @return -1 in case of error, in which case errno is set
+ */
+static int upipe_udpsink_send_mmsg(struct upipe *upipe, struct uref **urefs,
+                                   const uint64_t *txtimes,
+                                   unsigned int nb, unsigned int *sent_p)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    int iovec_count = 0;
+    unsigned int count;
+    *sent_p = 0;
+    for (count = 0; count < nb; count++) {
+        int iovecs = uref_block_iovec_count(urefs[count], 0, -1);
+        if (iovecs <= 0)
+            break;
+        iovec_count += iovecs;
+    }
+    if (unlikely(count == 0)) {
+        /* empty or invalid buffer, skip it */
+        upipe_udpsink->peer_sent = 0;
+        *sent_p = 1;
+        return 0;
+    }
+
+    /* the datagrams share their iovecs between destinations */
+    unsigned int nb_peers = upipe_udpsink->nb_peers ?
+                            upipe_udpsink->nb_peers : 1;
+    unsigned int offset = upipe_udpsink->nb_peers ?
+                          upipe_udpsink->peer_sent : 0;
+    unsigned int nb_msgs = count * nb_peers - offset;
+    if (nb_msgs > UDP_MAX_BATCH_SIZE) {
+        nb_msgs = UDP_MAX_BATCH_SIZE;
+        count = (offset + nb_msgs + nb_peers - 1) / nb_peers;
+    }
+
+    struct iovec iovecs[iovec_count];
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr msgs[nb_msgs];
+#else
+    struct msghdr msgs[nb_msgs];
+#endif
+#ifdef SO_TXTIME
+    uint8_t controls[txtimes != NULL ? nb_msgs : 1]
+                    [CMSG_SPACE(sizeof(uint64_t))];
+#endif
+    int iovec_nb = 0;
+    unsigned int msg = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        int nb_iovecs = uref_block_iovec_count(urefs[i], 0, -1);
+        if (unlikely(!ubase_check(uref_block_iovec_read(urefs[i], 0, -1,
+                                                        iovecs + iovec_nb)))) {
+            count = i;
+            break;
+        }
+        for (unsigned int j = i ? 0 : offset;
+             j < nb_peers && msg < nb_msgs; j++, msg++) {
+#ifdef HAVE_SENDMMSG
+            struct msghdr *msghdr = &msgs[msg].msg_hdr;
+            msgs[msg].msg_len = 0;
+#else
+            struct msghdr *msghdr = &msgs[msg];
+#endif
+            if (upipe_udpsink->nb_peers) {
+                msghdr->msg_name = &upipe_udpsink->peers[j].addr;
+                msghdr->msg_namelen = upipe_udpsink->peers[j].addrlen;
+            } else {
+                msghdr->msg_name = upipe_udpsink->addrlen ?
+                                   &upipe_udpsink->addr : NULL;
+                msghdr->msg_namelen = upipe_udpsink->addrlen;
+            }
+            msghdr->msg_iov = iovecs + iovec_nb;
+            msghdr->msg_iovlen = nb_iovecs;
+            msghdr->msg_control = NULL;
+            msghdr->msg_controllen = 0;
+            msghdr->msg_flags = 0;
+#ifdef SO_TXTIME
+            if (txtimes != NULL) {
+                memset(controls[msg], 0, sizeof(controls[msg]));
+                msghdr->msg_control = controls[msg];
+                msghdr->msg_controllen = sizeof(controls[msg]);
+                struct cmsghdr *cmsg = CMSG_FIRSTHDR(msghdr);
+                cmsg->cmsg_level = SOL_SOCKET;
+                cmsg->cmsg_type = SCM_TXTIME;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+                memcpy(CMSG_DATA(cmsg), &txtimes[i], sizeof(uint64_t));
+            }
+#endif
+        }
+        iovec_nb += nb_iovecs;
+    }
+    if (unlikely(count == 0)) {
+        upipe_udpsink->peer_sent = 0;
+        *sent_p = 1;
+        return 0;
+    }
+    nb_msgs = msg;
+
+#ifdef HAVE_SENDMMSG
+    int ret = sendmmsg(upipe_udpsink->fd, msgs, nb_msgs, 0);
+    int err = errno;
+#else
+    int ret = 0, err = 0;
+    while (ret < nb_msgs) {
+        if (sendmsg(upipe_udpsink->fd, &msgs[ret], 0) == -1) {
+            err = errno;
+            if (ret == 0)
+                ret = -1;
+            break;
+        }
+        ret++;
+    }
+#endif
+
+    for (unsigned int i = 0, k = 0; i < count; i++) {
+        uref_block_iovec_unmap(urefs[i], 0, -1, iovecs + k);
+        k += uref_block_iovec_count(urefs[i], 0, -1);
+    }
+    if (ret == -1) {
+        errno = err;
+        return -1;
+    }
+    ret += offset;
+    *sent_p = ret / nb_peers;
+    upipe_udpsink->peer_sent = ret % nb_peers;
+    return 0;
+}
+
+/** @internal @This shifts the PCRs of the TS packets of a uref by the
+ * difference between the launch time of the datagram and the date it was
+ * muxed for. The date of the uref is then updated so that a datagram sent
+ * again after a short write is not shifted twice.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param launch launch time of the datagram, in the uclock time base
+ */
+static void upipe_udpsink_restamp(struct upipe *upipe, struct uref *uref,
+                                  uint64_t launch)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    uint64_t systime;
+    size_t size;
+    if (!upipe_udpsink->pcr_restamp || upipe_udpsink->uclock == NULL ||
+        !ubase_check(uref_clock_get_cr_sys(uref, &systime)) ||
+        !ubase_check(uref_block_size(uref, &size)) ||
+        size % UTS_PCR_PACKET_SIZE)
+        return;
+
+    systime += upipe_udpsink->latency;
+    int64_t delta = (int64_t)(launch - systime);
+    if (!delta)
+        return;
+
+    for (size_t offset = 0; offset < size; offset += UTS_PCR_PACKET_SIZE) {
+        uint8_t header_s[UTS_PCR_HEADER_SIZE];
+        const uint8_t *header = uref_block_peek(uref, offset,
+                                                UTS_PCR_HEADER_SIZE, header_s);
+        if (unlikely(header == NULL))
+            return;
+        uint64_t pcr;
+        bool has_pcr = uts_pcr_get(header, &pcr);
+        uref_block_peek_unmap(uref, offset, header_s, header);
+        if (!has_pcr)
+            continue;
+
+        for (int retry = 0; ; retry++) {
+            int len = UTS_PCR_HEADER_SIZE;
+            uint8_t *buffer;
+            if (ubase_check(uref_block_write(uref, offset, &len, &buffer))) {
+                if (len >= UTS_PCR_HEADER_SIZE) {
+                    uts_pcr_set(buffer, uts_pcr_add(pcr, delta));
+                    uref_block_unmap(uref, offset);
+                    break;
+                }
+                uref_block_unmap(uref, offset);
+            }
+            /* the buffer is shared or the header is segmented */
+            if (retry ||
+                !ubase_check(uref_block_merge(uref, uref->ubuf->mgr, 0, -1))) {
+                upipe_warn(upipe, "unable to restamp PCR");
+                return;
+            }
+        }
+    }
+    uref_clock_set_cr_sys(uref, launch - upipe_udpsink->latency);
+}
+
+/** @internal @This outputs the given uref, and the following held urefs that
+ * are due within the batch window, with as few system calls as possible.
+ * When the kernel paces the socket, the urefs due within the pacing horizon
+ * are sent as well, with their launch times if supported.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref first uref to output
+ * @return true if the first uref was processed
+ */
+static bool upipe_udpsink_output_batch(struct upipe *upipe, struct uref *uref)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    uint64_t horizon = upipe_udpsink_horizon(upipe);
+    uint64_t now = 0, limit = UINT64_MAX;
+    if (upipe_udpsink->uclock != NULL) {
+        now = uclock_now(upipe_udpsink->uclock);
+        limit = now + (horizon > upipe_udpsink->batch_window ?
+                       horizon : upipe_udpsink->batch_window);
+    }
+
+    /* datagrams of a burst are paced one by one */
+    unsigned int batch_size = upipe_udpsink->burst ? 1 :
+                              upipe_udpsink->batch_size;
+    struct uref *urefs[batch_size];
+    unsigned int nb = 0;
+    urefs[nb++] = uref;
+    while (nb < batch_size) {
+        struct uchain *uchain = ulist_peek(&upipe_udpsink->urefs);
+        if (uchain == NULL)
+            break;
+        struct uref *next = uref_from_uchain(uchain);
+        const char *def;
+        uint64_t systime;
+        if (ubase_check(uref_flow_get_def(next, &def)) ||
+            (upipe_udpsink->uclock != NULL &&
+             ubase_check(uref_clock_get_cr_sys(next, &systime)) &&
+             systime + upipe_udpsink->latency > limit))
+            break;
+        urefs[nb++] = upipe_udpsink_pop_input(upipe);
+    }
+
+    uint64_t txtimes_s[nb];
+    uint64_t *txtimes = NULL;
+    struct timespec ts;
+    if (horizon && upipe_udpsink->txtime &&
+        clock_gettime(upipe_udpsink->txtime_clockid, &ts) == 0) {
+        uint64_t base = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+        for (unsigned int i = 0; i < nb; i++) {
+            uint64_t systime = 0;
+            uref_clock_get_cr_sys(urefs[i], &systime);
+            systime += upipe_udpsink->latency;
+            txtimes_s[i] = base;
+            if (systime > now)
+                txtimes_s[i] += (systime - now) * 1000 /
+                                (UCLOCK_FREQ / 1000000);
+        }
+        txtimes = txtimes_s;
+    }
+    if (upipe_udpsink->pcr_restamp && upipe_udpsink->uclock != NULL &&
+        !upipe_udpsink->burst) {
+        for (unsigned int i = 0; i < nb; i++) {
+            uint64_t launch = now;
+            uint64_t systime;
+            if (txtimes != NULL &&
+                ubase_check(uref_clock_get_cr_sys(urefs[i], &systime)) &&
+                systime + upipe_udpsink->latency > now)
+                launch = systime + upipe_udpsink->latency;
+            upipe_udpsink_restamp(upipe, urefs[i], launch);
+        }
+    }
+
+    unsigned int done = 0;
+    while (done < nb) {
+        unsigned int sent = 0;
+        int ret = 0;
+        /* a segmented write has a single launch time */
+        if (upipe_udpsink->gso && txtimes == NULL &&
+            !upipe_udpsink->nb_peers) {
+            ret = upipe_udpsink_send_gso(upipe, urefs + done, nb - done,
+                                         &sent);
+            if (ret == -1 && errno != EINTR && errno != EAGAIN &&
+                errno != EWOULDBLOCK) {
+                upipe_warn_va(upipe, "disabling segmentation offload (%m)");
+                upipe_udpsink->gso = false;
+                continue;
+            }
+        }
+        if (ret == 0 && sent == 0)
+            ret = upipe_udpsink_send_mmsg(upipe, urefs + done,
+                                          txtimes != NULL ? txtimes + done :
+                                                            NULL,
+                                          nb - done, &sent);
+
+        if (unlikely(ret == -1)) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            /* Errors at this point come from ICMP messages such as
+             * "port unreachable", and we do not want to kill the
+             * application with transient errors. */
+            sent = 1;
+            upipe_udpsink->peer_sent = 0;
+        }
+        done += sent;
+    }
+
+    for (unsigned int i = 0; i < done; i++)
+        uref_free(urefs[i]);
+    /* put back the urefs that could not be sent, in order */
+    for (unsigned int i = nb - 1; i > done && i > 0; i--)
+        upipe_udpsink_unshift_input(upipe, urefs[i]);
+    if (done == 0) {
+        upipe_udpsink_poll(upipe);
+        return false;
+    }
+    if (done < nb)
+        upipe_udpsink_unshift_input(upipe, urefs[done]);
+    return true;
+}
+
 /** @internal @This outputs data to the udp sink.
  *
  * @param upipe description structure of the pipe
@@ -202,6 +756,12 @@ static bool upipe_udpsink_output(struct upipe *upipe, struct uref *uref,
         uref_clock_get_latency(uref, &latency);
         if (latency > upipe_udpsink->latency)
             upipe_udpsink->latency = latency;
+        uint64_t octetrate = 0;
+        uref_block_flow_get_octetrate(uref, &octetrate);
+        if (octetrate != upipe_udpsink->octetrate) {
+            upipe_udpsink->octetrate = octetrate;
+            upipe_udpsink_apply_pacing(upipe);
+        }
         uref_free(uref);
         return true;
     }
@@ -212,6 +772,7 @@ static bool upipe_udpsink_output(struct upipe *upipe, struct uref *uref,
         return true;
     }
 
+    uint64_t horizon = upipe_udpsink_horizon(upipe);
     if (likely(upipe_udpsink->uclock == NULL))
         goto write_buffer;
 
@@ -223,12 +784,38 @@ static bool upipe_udpsink_output(struct upipe *upipe, struct uref *uref,
 
     uint64_t now = uclock_now(upipe_udpsink->uclock);
     systime += upipe_udpsink->latency;
-    if (unlikely(now < systime)) {
+    if (unlikely(upipe_udpsink->burst_pending)) {
+        upipe_udpsink->burst_pending = false;
+        upipe_udpsink->burst = true;
+        upipe_udpsink->burst_next = now;
+    }
+    if (unlikely(upipe_udpsink->burst)) {
+        if (systime >= upipe_udpsink->burst_next) {
+            upipe_dbg(upipe, "burst caught up with the stream");
+            upipe_udpsink->burst = false;
+        } else if (now < upipe_udpsink->burst_next &&
+                   ubase_check(upipe_udpsink_check_upump_mgr(upipe))) {
+            upipe_udpsink_wait_upump(upipe, upipe_udpsink->burst_next - now,
+                                     upipe_udpsink_watcher);
+            return false;
+        } else {
+            /* late datagrams are sent as is, one at a time */
+            size_t size = 0;
+            uref_block_size(uref, &size);
+            if (now > upipe_udpsink->burst_next + SYSTIME_PRINT)
+                upipe_udpsink->burst_next = now;
+            upipe_udpsink->burst_next +=
+                size * UCLOCK_FREQ / upipe_udpsink->burst_rate;
+            goto write_datagram;
+        }
+    }
+
+    if (unlikely(now + horizon < systime)) {
         upipe_udpsink_check_upump_mgr(upipe);
         if (likely(upipe_udpsink->upump_mgr != NULL)) {
             upipe_verbose_va(upipe, "sleeping %"PRIu64" (%"PRIu64")",
-                             systime - now, systime);
-            upipe_udpsink_wait_upump(upipe, systime - now,
+                             systime - horizon - now, systime);
+            upipe_udpsink_wait_upump(upipe, systime - horizon - now,
                                      upipe_udpsink_watcher);
             return false;
         }
@@ -246,6 +833,18 @@ static bool upipe_udpsink_output(struct upipe *upipe, struct uref *uref,
                       upipe_udpsink->latency / (UCLOCK_FREQ / 1000));
 
 write_buffer:
+    if ((upipe_udpsink->batch_size > 1 || horizon ||
+         upipe_udpsink->nb_peers) && !upipe_udpsink->raw)
+        return upipe_udpsink_output_batch(upipe, uref);
+
+    if (upipe_udpsink->pcr_restamp && upipe_udpsink->uclock != NULL)
+        upipe_udpsink_restamp(upipe, uref,
+                              uclock_now(upipe_udpsink->uclock));
+
+write_datagram:
+    if (upipe_udpsink->nb_peers && !upipe_udpsink->raw)
+        return upipe_udpsink_output_batch(upipe, uref);
+
     for ( ; ; ) {
         size_t payload_len = 0;
         if (unlikely(!ubase_check(uref_block_size(uref, &payload_len)))) {
@@ -447,9 +1046,182 @@ static int _upipe_udpsink_set_uri(struct upipe *upipe, const char *uri)
         /* Use again the pipe that we previously released. */
         upipe_use(upipe);
     upipe_notice_va(upipe, "opening uri %s", upipe_udpsink->uri);
+    upipe_udpsink_apply_pacing(upipe);
+    upipe_udpsink->burst_pending = upipe_udpsink->burst_rate != 0;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the batch mode parameters.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_size maximum number of datagrams sent at once
+ * @param window held datagrams due within this delay are sent early
+ * @return an error code
+ */
+static int _upipe_udpsink_set_batch(struct upipe *upipe,
+                                    unsigned int batch_size, uint64_t window)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    if (unlikely(batch_size == 0 || batch_size > UDP_MAX_BATCH_SIZE))
+        return UBASE_ERR_INVALID;
+    upipe_udpsink->batch_size = batch_size;
+    upipe_udpsink->batch_window = window;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This enables or disables UDP generic segmentation offload.
+ *
+ * @param upipe description structure of the pipe
+ * @param enable true to enable segmentation offload
+ * @return an error code
+ */
+static int _upipe_udpsink_set_gso(struct upipe *upipe, bool enable)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+#ifndef UDP_SEGMENT
+    if (enable)
+        return UBASE_ERR_INVALID;
+#endif
+    upipe_udpsink->gso = enable;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the kernel pacing parameters.
+ *
+ * @param upipe description structure of the pipe
+ * @param clockid clock of the launch times
+ * @param horizon datagrams due within this delay are handed to the kernel
+ * @return an error code
+ */
+static int _upipe_udpsink_set_txtime(struct upipe *upipe, int clockid,
+                                     uint64_t horizon)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+#ifndef SO_TXTIME
+#ifndef SO_MAX_PACING_RATE
+    if (horizon)
+        return UBASE_ERR_INVALID;
+#endif
+#endif
+    upipe_udpsink->txtime_clockid = clockid;
+    upipe_udpsink->pacing_horizon = horizon;
+    upipe_udpsink_apply_pacing(upipe);
+    if (horizon && upipe_udpsink->fd != -1)
+        upipe_notice_va(upipe, "pacing with %s",
+                        upipe_udpsink->txtime ? "launch times" :
+                        upipe_udpsink->rate_limited ? "maximum rate" :
+                        "timers");
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This enables or disables the restamping of the PCRs with the
+ * launch times of the datagrams.
+ *
+ * @param upipe description structure of the pipe
+ * @param enable true to restamp the PCRs
+ * @return an error code
+ */
+static int _upipe_udpsink_set_pcr_restamp(struct upipe *upipe, bool enable)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    upipe_udpsink->pcr_restamp = enable;
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the maximum pacing rate of the socket.
+ *
+ * @param upipe description structure of the pipe
+ * @param rate maximum rate in octets per second, or 0
+ * @return an error code
+ */
+static int _upipe_udpsink_set_pacing_rate(struct upipe *upipe, uint64_t rate)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+#ifndef SO_MAX_PACING_RATE
+    if (rate)
+        return UBASE_ERR_INVALID;
+#endif
+    upipe_udpsink->pacing_rate = rate;
+    upipe_udpsink_apply_pacing(upipe);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the burst rate used when a receiver joins.
+ *
+ * @param upipe description structure of the pipe
+ * @param rate burst rate in octets per second, or 0
+ * @return an error code
+ */
+static int _upipe_udpsink_set_burst(struct upipe *upipe, uint64_t rate)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    upipe_udpsink->burst_rate = rate;
+    upipe_udpsink->burst_pending = rate != 0;
+    upipe_udpsink->burst = false;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This adds a destination.
+ *
+ * @param upipe description structure of the pipe
+ * @param addr remote address
+ * @param addrlen size of the remote address
+ * @return an error code
+ */
+static int _upipe_udpsink_add_peer(struct upipe *upipe,
+                                   const struct sockaddr *addr,
+                                   socklen_t addrlen)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    if (addr == NULL || !addrlen ||
+        addrlen > sizeof(struct sockaddr_storage))
+        return UBASE_ERR_INVALID;
+
+    struct upipe_udpsink_peer *peers = realloc(upipe_udpsink->peers,
+            (upipe_udpsink->nb_peers + 1) * sizeof(*peers));
+    UBASE_ALLOC_RETURN(peers);
+    upipe_udpsink->peers = peers;
+    struct upipe_udpsink_peer *peer = &peers[upipe_udpsink->nb_peers++];
+    memset(&peer->addr, 0, sizeof(peer->addr));
+    memcpy(&peer->addr, addr, addrlen);
+    peer->addrlen = addrlen;
+    upipe_dbg_va(upipe, "adding destination %u", upipe_udpsink->nb_peers);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This removes a destination.
+ *
+ * @param upipe description structure of the pipe
+ * @param addr remote address
+ * @param addrlen size of the remote address
+ * @return an error code
+ */
+static int _upipe_udpsink_del_peer(struct upipe *upipe,
+                                   const struct sockaddr *addr,
+                                   socklen_t addrlen)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    if (addr == NULL)
+        return UBASE_ERR_INVALID;
+
+    for (unsigned int i = 0; i < upipe_udpsink->nb_peers; i++) {
+        struct upipe_udpsink_peer *peer = &upipe_udpsink->peers[i];
+        if (peer->addrlen != addrlen || memcmp(&peer->addr, addr, addrlen))
+            continue;
+
+        memmove(peer, peer + 1,
+                (upipe_udpsink->nb_peers - i - 1) * sizeof(*peer));
+        upipe_udpsink->nb_peers--;
+        /* the held datagram may be sent again to some destinations */
+        if (upipe_udpsink->peer_sent > i)
+            upipe_udpsink->peer_sent--;
+        if (upipe_udpsink->peer_sent >= upipe_udpsink->nb_peers)
+            upipe_udpsink->peer_sent = 0;
+        return UBASE_ERR_NONE;
+    }
+    return UBASE_ERR_INVALID;
+}
+
 /** @internal @This flushes all currently held buffers, and unblocks the
  * sources.
  *
@@ -524,6 +1296,8 @@ static int _upipe_udpsink_control(struct upipe *upipe,
             UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
             upipe_udpsink_set_upump(upipe, NULL);
             upipe_udpsink->fd = va_arg(args, int );
+            upipe_udpsink_apply_pacing(upipe);
+            upipe_udpsink->burst_pending = upipe_udpsink->burst_rate != 0;
             return UBASE_ERR_NONE;
         }
         case UPIPE_UDPSINK_SET_PEER: {
@@ -531,6 +1305,67 @@ static int _upipe_udpsink_control(struct upipe *upipe,
             const struct sockaddr *s = va_arg(args, const struct sockaddr *);
             upipe_udpsink->addrlen = va_arg(args, socklen_t);
             memcpy(&upipe_udpsink->addr, s, upipe_udpsink->addrlen);
+            upipe_udpsink->burst_pending = upipe_udpsink->burst_rate != 0;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_UDPSINK_GET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            unsigned int *batch_size_p = va_arg(args, unsigned int *);
+            uint64_t *window_p = va_arg(args, uint64_t *);
+            if (batch_size_p != NULL)
+                *batch_size_p = upipe_udpsink->batch_size;
+            if (window_p != NULL)
+                *window_p = upipe_udpsink->batch_window;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_UDPSINK_SET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            unsigned int batch_size = va_arg(args, unsigned int);
+            uint64_t window = va_arg(args, uint64_t);
+            return _upipe_udpsink_set_batch(upipe, batch_size, window);
+        }
+        case UPIPE_UDPSINK_SET_GSO: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            int enable = va_arg(args, int);
+            return _upipe_udpsink_set_gso(upipe, !!enable);
+        }
+        case UPIPE_UDPSINK_SET_TXTIME: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            int clockid = va_arg(args, int);
+            uint64_t horizon = va_arg(args, uint64_t);
+            return _upipe_udpsink_set_txtime(upipe, clockid, horizon);
+        }
+        case UPIPE_UDPSINK_SET_PACING_RATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            uint64_t rate = va_arg(args, uint64_t);
+            return _upipe_udpsink_set_pacing_rate(upipe, rate);
+        }
+        case UPIPE_UDPSINK_SET_PCR_RESTAMP: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            int enable = va_arg(args, int);
+            return _upipe_udpsink_set_pcr_restamp(upipe, !!enable);
+        }
+        case UPIPE_UDPSINK_SET_BURST: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            uint64_t rate = va_arg(args, uint64_t);
+            return _upipe_udpsink_set_burst(upipe, rate);
+        }
+        case UPIPE_UDPSINK_ADD_PEER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            const struct sockaddr *s = va_arg(args, const struct sockaddr *);
+            socklen_t addrlen = va_arg(args, socklen_t);
+            return _upipe_udpsink_add_peer(upipe, s, addrlen);
+        }
+        case UPIPE_UDPSINK_DEL_PEER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            const struct sockaddr *s = va_arg(args, const struct sockaddr *);
+            socklen_t addrlen = va_arg(args, socklen_t);
+            return _upipe_udpsink_del_peer(upipe, s, addrlen);
+        }
+        case UPIPE_UDPSINK_GET_PEERS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            unsigned int *nb_p = va_arg(args, unsigned int *);
+            *nb_p = upipe_udpsink->nb_peers;
             return UBASE_ERR_NONE;
         }
         case UPIPE_FLUSH:
@@ -573,6 +1408,7 @@ static void upipe_udpsink_free(struct upipe *upipe)
     upipe_throw_dead(upipe);
 
     free(upipe_udpsink->uri);
+    free(upipe_udpsink->peers);
     upipe_udpsink_clean_uclock(upipe);
     upipe_udpsink_clean_upump(upipe);
     upipe_udpsink_clean_upump_mgr(upipe);
@@ -28,13 +28,17 @@
  * @short Upipe source module for udp sockets
  */
 
+#include <config.h>
+
 #include <upipe/ubase.h>
+#include <upipe/ulist.h>
 #include <upipe/uprobe.h>
 #include <upipe/uclock.h>
 #include <upipe/uref.h>
 #include <upipe/uref_block.h>
 #include <upipe/uref_block_flow.h>
 #include <upipe/uref_clock.h>
+#include <upipe/uts_filter.h>
 #include <upipe/upump.h>
 #include <upipe/ubuf.h>
 #include <upipe/upipe.h>
@@ -64,13 +68,32 @@
 #include <errno.h>
 #include <assert.h>
 #include <sys/socket.h>
+#include <time.h>
 
 /** default size of buffers when unspecified */
 #define UBUF_DEFAULT_SIZE       4096
+/** maximum number of datagrams read per wakeup in batch mode */
+#define UDP_MAX_BATCH_SIZE      1024
+/** size of the ancillary data buffer of each datagram in batch mode */
+#ifdef SO_TIMESTAMPNS
+#define UDP_CMSG_SIZE           CMSG_SPACE(sizeof(struct timespec))
+#else
+#define UDP_CMSG_SIZE           0
+#endif
 
 #define UDP_DEFAULT_TTL 0
 #define UDP_DEFAULT_PORT 1234
 
+#ifndef HAVE_RECVMMSG
+/** @hidden */
+struct mmsghdr {
+    /** message header */
+    struct msghdr msg_hdr;
+    /** number of received bytes */
+    unsigned int msg_len;
+};
+#endif
+
 /** @hidden */
 static int upipe_udpsrc_check(struct upipe *upipe, struct uref *flow_format);
 
@@ -122,6 +145,25 @@ struct upipe_udpsrc {
     /** source address (size) */
     socklen_t addrlen;
 
+    /** maximum number of datagrams read per wakeup (1 disables batching) */
+    unsigned int batch_size;
+    /** pre-allocated urefs of the batch mode, mapped before reading */
+    struct uref **batch_urefs;
+    /** message headers of the batch mode */
+    struct mmsghdr *batch_msgs;
+    /** I/O vectors of the batch mode */
+    struct iovec *batch_iovecs;
+    /** source addresses of the batch mode */
+    struct sockaddr_storage *batch_addrs;
+    /** ancillary data buffers of the batch mode */
+    uint8_t *batch_cmsgs;
+    /** true if kernel timestamps were enabled on the socket */
+    bool timestamps;
+    /** bitmap of the wanted TS PIDs, or NULL */
+    const uint8_t *pid_filter;
+    /** refcount of the owner of the bitmap, or NULL */
+    struct urefcount *pid_filter_owner;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -172,10 +214,258 @@ static struct upipe *upipe_udpsrc_alloc(struct upipe_mgr *mgr,
     upipe_udpsrc->fd = -1;
     upipe_udpsrc->uri = NULL;
     upipe_udpsrc->addrlen = 0;
+    upipe_udpsrc->batch_size = 1;
+    upipe_udpsrc->batch_urefs = NULL;
+    upipe_udpsrc->batch_msgs = NULL;
+    upipe_udpsrc->batch_iovecs = NULL;
+    upipe_udpsrc->batch_addrs = NULL;
+    upipe_udpsrc->batch_cmsgs = NULL;
+    upipe_udpsrc->timestamps = false;
+    upipe_udpsrc->pid_filter = NULL;
+    upipe_udpsrc->pid_filter_owner = NULL;
     upipe_throw_ready(upipe);
     return upipe;
 }
 
+/** @internal @This releases the pre-allocated urefs of the batch mode.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsrc_flush_batch(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (upipe_udpsrc->batch_urefs == NULL)
+        return;
+    for (unsigned int i = 0; i < upipe_udpsrc->batch_size; i++) {
+        if (upipe_udpsrc->batch_urefs[i] != NULL) {
+            uref_free(upipe_udpsrc->batch_urefs[i]);
+            upipe_udpsrc->batch_urefs[i] = NULL;
+        }
+    }
+}
+
+/** @internal @This frees the structures of the batch mode.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsrc_clean_batch(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    upipe_udpsrc_flush_batch(upipe);
+    free(upipe_udpsrc->batch_urefs);
+    free(upipe_udpsrc->batch_msgs);
+    free(upipe_udpsrc->batch_iovecs);
+    free(upipe_udpsrc->batch_addrs);
+    free(upipe_udpsrc->batch_cmsgs);
+    upipe_udpsrc->batch_urefs = NULL;
+    upipe_udpsrc->batch_msgs = NULL;
+    upipe_udpsrc->batch_iovecs = NULL;
+    upipe_udpsrc->batch_addrs = NULL;
+    upipe_udpsrc->batch_cmsgs = NULL;
+    upipe_udpsrc->batch_size = 1;
+}
+
+/** @internal @This checks if the peer address changed, and throws an event
+ * in that case.
+ *
+ * @param upipe description structure of the pipe
+ * @param addr address of the peer
+ * @param addrlen size of the address of the peer
+ */
+static void upipe_udpsrc_check_peer(struct upipe *upipe,
+                                    struct sockaddr_storage *addr,
+                                    socklen_t addrlen)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (addrlen != upipe_udpsrc->addrlen ||
+        memcmp(addr, &upipe_udpsrc->addr, addrlen)) {
+        upipe_throw(upipe, UPROBE_UDPSRC_NEW_PEER, UPIPE_UDPSRC_SIGNATURE,
+                addr, &addrlen);
+        upipe_udpsrc->addrlen = addrlen;
+        memcpy(&upipe_udpsrc->addr, addr, addrlen);
+    }
+}
+
+/** @internal @This returns the system time of reception of a datagram,
+ * using the kernel timestamp if available.
+ *
+ * @param upipe description structure of the pipe
+ * @param msg message header of the datagram
+ * @param systime system time of the wakeup
+ * @param realtime real time of the wakeup, in 27 MHz units
+ * @return system time of reception of the datagram
+ */
+static uint64_t upipe_udpsrc_get_systime(struct upipe *upipe,
+                                         struct msghdr *msg,
+                                         uint64_t systime, uint64_t realtime)
+{
+#ifdef SO_TIMESTAMPNS
+    struct cmsghdr *cmsg;
+    for (cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL;
+         cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET ||
+            cmsg->cmsg_type != SCM_TIMESTAMPNS)
+            continue;
+
+        struct timespec ts;
+        memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+        uint64_t pkttime = (uint64_t)ts.tv_sec * UCLOCK_FREQ +
+                           (uint64_t)ts.tv_nsec * UCLOCK_FREQ / 1000000000;
+        /* the kernel timestamp is taken on the real time clock, so apply
+         * the delay since reception to the uclock date of the wakeup */
+        if (pkttime < realtime && realtime - pkttime < systime)
+            return systime - (realtime - pkttime);
+        break;
+    }
+#endif
+    return systime;
+}
+
+/** @internal @This reads several datagrams at once from the socket and
+ * outputs them, using pre-allocated buffers.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsrc_worker_batch(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    unsigned int batch_size = upipe_udpsrc->batch_size;
+    uint64_t systime = 0; /* to keep gcc quiet */
+    uint64_t realtime = 0;
+    if (unlikely(upipe_udpsrc->uclock != NULL)) {
+        systime = uclock_now(upipe_udpsrc->uclock);
+        struct timespec ts;
+        if (upipe_udpsrc->timestamps &&
+            clock_gettime(CLOCK_REALTIME, &ts) == 0)
+            realtime = (uint64_t)ts.tv_sec * UCLOCK_FREQ +
+                       (uint64_t)ts.tv_nsec * UCLOCK_FREQ / 1000000000;
+    }
+
+    for (unsigned int i = 0; i < batch_size; i++) {
+        struct uref *uref = upipe_udpsrc->batch_urefs[i];
+        if (uref == NULL) {
+            uref = uref_block_alloc(upipe_udpsrc->uref_mgr,
+                                    upipe_udpsrc->ubuf_mgr,
+                                    upipe_udpsrc->output_size);
+            if (unlikely(uref == NULL)) {
+                for (unsigned int j = 0; j < i; j++)
+                    uref_block_unmap(upipe_udpsrc->batch_urefs[j], 0);
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                return;
+            }
+            upipe_udpsrc->batch_urefs[i] = uref;
+        }
+
+        uint8_t *buffer;
+        int output_size = -1;
+        if (unlikely(!ubase_check(uref_block_write(uref, 0, &output_size,
+                                                   &buffer)))) {
+            for (unsigned int j = 0; j < i; j++)
+                uref_block_unmap(upipe_udpsrc->batch_urefs[j], 0);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        assert(output_size == upipe_udpsrc->output_size);
+
+        struct mmsghdr *mmsg = &upipe_udpsrc->batch_msgs[i];
+        upipe_udpsrc->batch_iovecs[i].iov_base = buffer;
+        upipe_udpsrc->batch_iovecs[i].iov_len = output_size;
+        mmsg->msg_hdr.msg_name = &upipe_udpsrc->batch_addrs[i];
+        mmsg->msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+        mmsg->msg_hdr.msg_iov = &upipe_udpsrc->batch_iovecs[i];
+        mmsg->msg_hdr.msg_iovlen = 1;
+        mmsg->msg_hdr.msg_control = UDP_CMSG_SIZE ?
+            upipe_udpsrc->batch_cmsgs + i * UDP_CMSG_SIZE : NULL;
+        mmsg->msg_hdr.msg_controllen = UDP_CMSG_SIZE;
+        mmsg->msg_hdr.msg_flags = 0;
+        mmsg->msg_len = 0;
+    }
+
+#ifdef HAVE_RECVMMSG
+    int ret = recvmmsg(upipe_udpsrc->fd, upipe_udpsrc->batch_msgs, batch_size,
+                       MSG_DONTWAIT, NULL);
+#else
+    int ret = 0;
+    while (ret < batch_size) {
+        struct mmsghdr *mmsg = &upipe_udpsrc->batch_msgs[ret];
+        ssize_t len = recvmsg(upipe_udpsrc->fd, &mmsg->msg_hdr, MSG_DONTWAIT);
+        if (len == -1) {
+            if (ret == 0)
+                ret = -1;
+            break;
+        }
+        mmsg->msg_len = len;
+        ret++;
+    }
+#endif
+
+    for (int i = 0; i < ret; i++) {
+        struct mmsghdr *mmsg = &upipe_udpsrc->batch_msgs[i];
+        mmsg->msg_len = uts_filter_compact(upipe_udpsrc->pid_filter,
+                upipe_udpsrc->batch_iovecs[i].iov_base, mmsg->msg_len);
+    }
+    for (unsigned int i = 0; i < batch_size; i++)
+        uref_block_unmap(upipe_udpsrc->batch_urefs[i], 0);
+
+    if (unlikely(ret == -1)) {
+        switch (errno) {
+            case EINTR:
+            case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+            case EWOULDBLOCK:
+#endif
+                /* not an issue, try again later */
+                return;
+            case EBADF:
+            case EINVAL:
+            case EIO:
+            default:
+                break;
+        }
+        upipe_err_va(upipe, "read error from %s (%m)", upipe_udpsrc->uri);
+        upipe_udpsrc_set_upump(upipe, NULL);
+        upipe_throw_source_end(upipe);
+        return;
+    }
+
+    /* detach the received urefs first, as the output may change the
+     * configuration of the pipe */
+    struct uchain urefs;
+    ulist_init(&urefs);
+    for (unsigned int i = 0; i < ret; i++) {
+        struct mmsghdr *mmsg = &upipe_udpsrc->batch_msgs[i];
+        struct uref *uref = upipe_udpsrc->batch_urefs[i];
+
+        upipe_udpsrc_check_peer(upipe, mmsg->msg_hdr.msg_name,
+                                mmsg->msg_hdr.msg_namelen);
+        /* empty or filtered out, keep the buffer for the next read */
+        if (unlikely(mmsg->msg_len == 0))
+            continue;
+        upipe_udpsrc->batch_urefs[i] = NULL;
+        if (unlikely(upipe_udpsrc->uclock != NULL))
+            uref_clock_set_cr_sys(uref,
+                upipe_udpsrc_get_systime(upipe, &mmsg->msg_hdr,
+                                         systime, realtime));
+        if (unlikely(mmsg->msg_len != upipe_udpsrc->output_size))
+            uref_block_resize(uref, 0, mmsg->msg_len);
+        ulist_add(&urefs, uref_to_uchain(uref));
+    }
+
+    /* move the remaining pre-allocated urefs to the front */
+    unsigned int j = 0;
+    for (unsigned int i = 0; i < batch_size; i++) {
+        struct uref *uref = upipe_udpsrc->batch_urefs[i];
+        upipe_udpsrc->batch_urefs[i] = NULL;
+        if (uref != NULL)
+            upipe_udpsrc->batch_urefs[j++] = uref;
+    }
+
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&urefs)) != NULL)
+        upipe_udpsrc_output(upipe, uref_from_uchain(uchain),
+                            &upipe_udpsrc->upump);
+}
+
 /** @internal @This reads data from the source and outputs it.
  * It is called either when the idler triggers (permanent storage mode) or
  * when data is available on the udp socket descriptor (live stream mode).
@@ -186,6 +476,11 @@ static void upipe_udpsrc_worker(struct upump *upump)
 {
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (upipe_udpsrc->batch_size > 1) {
+        upipe_udpsrc_worker_batch(upipe);
+        return;
+    }
+
     uint64_t systime = 0; /* to keep gcc quiet */
     if (unlikely(upipe_udpsrc->uclock != NULL))
         systime = uclock_now(upipe_udpsrc->uclock);
@@ -213,6 +508,8 @@ static void upipe_udpsrc_worker(struct upump *upump)
 
     ssize_t ret = recvfrom(upipe_udpsrc->fd, buffer, upipe_udpsrc->output_size,
                         0, (struct sockaddr*)&addr, &addrlen);
+    size_t filtered = ret > 0 ?
+        uts_filter_compact(upipe_udpsrc->pid_filter, buffer, ret) : 0;
     uref_block_unmap(uref, 0);
 
     if (unlikely(ret == -1)) {
@@ -235,13 +532,8 @@ static void upipe_udpsrc_worker(struct upump *upump)
         upipe_udpsrc_set_upump(upipe, NULL);
         upipe_throw_source_end(upipe);
         return;
-    } else if (addrlen != upipe_udpsrc->addrlen ||
-        memcmp(&addr, &upipe_udpsrc->addr, addrlen)) {
-        upipe_throw(upipe, UPROBE_UDPSRC_NEW_PEER, UPIPE_UDPSRC_SIGNATURE,
-                &addr, &addrlen);
-        upipe_udpsrc->addrlen = addrlen;
-        memcpy(&upipe_udpsrc->addr, &addr, addrlen);
     }
+    upipe_udpsrc_check_peer(upipe, &addr, addrlen);
 
     if (unlikely(ret == 0)) {
         uref_free(uref);
@@ -252,10 +544,14 @@ static void upipe_udpsrc_worker(struct upump *upump)
         }
         return;
     }
+    if (unlikely(filtered == 0)) {
+        uref_free(uref);
+        return;
+    }
     if (unlikely(upipe_udpsrc->uclock != NULL))
         uref_clock_set_cr_sys(uref, systime);
-    if (unlikely(ret != upipe_udpsrc->output_size))
-        uref_block_resize(uref, 0, ret);
+    if (unlikely(filtered != upipe_udpsrc->output_size))
+        uref_block_resize(uref, 0, filtered);
     upipe_udpsrc_output(upipe, uref, &upipe_udpsrc->upump);
 }
 
@@ -298,6 +594,18 @@ static int upipe_udpsrc_check(struct upipe *upipe, struct uref *flow_format)
         return UBASE_ERR_NONE;
 
     if (upipe_udpsrc->fd != -1 && upipe_udpsrc->upump == NULL) {
+#ifdef SO_TIMESTAMPNS
+        if (upipe_udpsrc->batch_size > 1 && upipe_udpsrc->uclock != NULL &&
+            !upipe_udpsrc->timestamps) {
+            int enable = 1;
+            if (setsockopt(upipe_udpsrc->fd, SOL_SOCKET, SO_TIMESTAMPNS,
+                           &enable, sizeof(enable)) == 0)
+                upipe_udpsrc->timestamps = true;
+            else
+                upipe_warn_va(upipe, "unable to enable timestamps (%m)");
+        }
+#endif
+
         struct upump *upump;
         upump = upump_alloc_fd_read(upipe_udpsrc->upump_mgr,
                                     upipe_udpsrc_worker, upipe, upipe->refcount,
@@ -345,6 +653,7 @@ static int upipe_udpsrc_set_uri(struct upipe *upipe, const char *uri)
     }
     ubase_clean_str(&upipe_udpsrc->uri);
     upipe_udpsrc_set_upump(upipe, NULL);
+    upipe_udpsrc->timestamps = false;
 
     if (unlikely(uri == NULL))
         return UBASE_ERR_NONE;
@@ -366,6 +675,45 @@ static int upipe_udpsrc_set_uri(struct upipe *upipe, const char *uri)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the maximum number of datagrams read per wakeup.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_size maximum number of datagrams (1 disables batching)
+ * @return an error code
+ */
+static int _upipe_udpsrc_set_batch_size(struct upipe *upipe,
+                                        unsigned int batch_size)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (unlikely(batch_size == 0 || batch_size > UDP_MAX_BATCH_SIZE))
+        return UBASE_ERR_INVALID;
+
+    upipe_udpsrc_clean_batch(upipe);
+    if (batch_size == 1)
+        return UBASE_ERR_NONE;
+
+    upipe_udpsrc->batch_urefs = calloc(batch_size, sizeof(struct uref *));
+    upipe_udpsrc->batch_msgs = calloc(batch_size, sizeof(struct mmsghdr));
+    upipe_udpsrc->batch_iovecs = calloc(batch_size, sizeof(struct iovec));
+    upipe_udpsrc->batch_addrs = calloc(batch_size,
+                                       sizeof(struct sockaddr_storage));
+    upipe_udpsrc->batch_cmsgs = UDP_CMSG_SIZE ?
+                                calloc(batch_size, UDP_CMSG_SIZE) : NULL;
+    if (unlikely(upipe_udpsrc->batch_urefs == NULL ||
+                 upipe_udpsrc->batch_msgs == NULL ||
+                 upipe_udpsrc->batch_iovecs == NULL ||
+                 upipe_udpsrc->batch_addrs == NULL ||
+                 (UDP_CMSG_SIZE && upipe_udpsrc->batch_cmsgs == NULL))) {
+        upipe_udpsrc_clean_batch(upipe);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_udpsrc->batch_size = batch_size;
+    /* restart the pump to enable timestamps if needed */
+    upipe_udpsrc_set_upump(upipe, NULL);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a udp socket source pipe.
  *
  * @param upipe description structure of the pipe
@@ -393,7 +741,10 @@ static int _upipe_udpsrc_control(struct upipe *upipe,
             return upipe_udpsrc_control_output(upipe, command, args);
 
         case UPIPE_GET_OUTPUT_SIZE:
+            return upipe_udpsrc_control_output_size(upipe, command, args);
         case UPIPE_SET_OUTPUT_SIZE:
+            /* pre-allocated buffers have the previous size */
+            upipe_udpsrc_flush_batch(upipe);
             return upipe_udpsrc_control_output_size(upipe, command, args);
 
         case UPIPE_GET_URI: {
@@ -414,6 +765,33 @@ static int _upipe_udpsrc_control(struct upipe *upipe,
             UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
             upipe_udpsrc_set_upump(upipe, NULL);
             upipe_udpsrc->fd = va_arg(args, int );
+            upipe_udpsrc->timestamps = false;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_UDPSRC_GET_BATCH_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
+            unsigned int *batch_size_p = va_arg(args, unsigned int *);
+            *batch_size_p = upipe_udpsrc->batch_size;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_UDPSRC_SET_BATCH_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
+            unsigned int batch_size = va_arg(args, unsigned int);
+            return _upipe_udpsrc_set_batch_size(upipe, batch_size);
+        }
+        case UPIPE_UDPSRC_GET_PID_FILTER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
+            const uint8_t **pid_filter_p = va_arg(args, const uint8_t **);
+            *pid_filter_p = upipe_udpsrc->pid_filter;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_UDPSRC_SET_PID_FILTER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
+            const uint8_t *pid_filter = va_arg(args, const uint8_t *);
+            struct urefcount *owner = va_arg(args, struct urefcount *);
+            urefcount_release(upipe_udpsrc->pid_filter_owner);
+            upipe_udpsrc->pid_filter_owner = urefcount_use(owner);
+            upipe_udpsrc->pid_filter = pid_filter;
             return UBASE_ERR_NONE;
         }
         default:
@@ -453,6 +831,8 @@ static void upipe_udpsrc_free(struct upipe *upipe)
     upipe_throw_dead(upipe);
 
     free(upipe_udpsrc->uri);
+    urefcount_release(upipe_udpsrc->pid_filter_owner);
+    upipe_udpsrc_clean_batch(upipe);
     upipe_udpsrc_clean_output_size(upipe);
     upipe_udpsrc_clean_uclock(upipe);
     upipe_udpsrc_clean_upump(upipe);
@@ -0,0 +1,395 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module rebuilding urefs from a serialized stream
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uref.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_serial.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe-modules/upipe_uref_deserialize.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <assert.h>
+
+/** we only accept serialized streams */
+#define EXPECTED_FLOW_DEF "block.uref."
+
+/** @internal @This is the private context of a uref deserializer pipe. */
+struct upipe_urefdeser {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** output pipe */
+    struct upipe *output;
+    /** output flow definition */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** input stream not yet deserialized, or NULL */
+    struct uref *next_uref;
+    /** attributes of the previous uref, or NULL */
+    struct uref *ref;
+    /** buffer used to read serialized urefs spanning several segments */
+    uint8_t *scratch;
+    /** size of the scratch buffer */
+    size_t scratch_size;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_urefdeser, upipe, UPIPE_UREFDESER_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_urefdeser, urefcount, upipe_urefdeser_free)
+UPIPE_HELPER_VOID(upipe_urefdeser)
+UPIPE_HELPER_OUTPUT(upipe_urefdeser, output, flow_def, output_state,
+                    request_list)
+
+/** @internal @This allocates a uref deserializer pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_urefdeser_alloc(struct upipe_mgr *mgr,
+                                           struct uprobe *uprobe,
+                                           uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_urefdeser_alloc_void(mgr, uprobe, signature,
+                                                     args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_urefdeser *upipe_urefdeser =
+        upipe_urefdeser_from_upipe(upipe);
+    upipe_urefdeser_init_urefcount(upipe);
+    upipe_urefdeser_init_output(upipe);
+    upipe_urefdeser->next_uref = NULL;
+    upipe_urefdeser->ref = NULL;
+    upipe_urefdeser->scratch = NULL;
+    upipe_urefdeser->scratch_size = 0;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This flushes the input stream.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_urefdeser_flush(struct upipe *upipe)
+{
+    struct upipe_urefdeser *upipe_urefdeser =
+        upipe_urefdeser_from_upipe(upipe);
+    uref_free(upipe_urefdeser->next_uref);
+    upipe_urefdeser->next_uref = NULL;
+}
+
+/** @internal @This deserializes a uref from the input stream.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref to fill in
+ * @param ref reference uref, or NULL
+ * @param header_size size of the serialized uref
+ * @return an error code
+ */
+static int upipe_urefdeser_decode(struct upipe *upipe, struct uref *uref,
+                                  struct uref *ref, uint32_t header_size)
+{
+    struct upipe_urefdeser *upipe_urefdeser =
+        upipe_urefdeser_from_upipe(upipe);
+    if (header_size > upipe_urefdeser->scratch_size) {
+        uint8_t *scratch = realloc(upipe_urefdeser->scratch, header_size);
+        UBASE_ALLOC_RETURN(scratch)
+        upipe_urefdeser->scratch = scratch;
+        upipe_urefdeser->scratch_size = header_size;
+    }
+
+    const uint8_t *buffer = uref_block_peek(upipe_urefdeser->next_uref,
+                                            UREF_SERIAL_FRAME_SIZE,
+                                            header_size,
+                                            upipe_urefdeser->scratch);
+    if (unlikely(buffer == NULL))
+        return UBASE_ERR_INVALID;
+    int err = uref_serial_decode(uref, ref, buffer, header_size);
+    uref_block_peek_unmap(upipe_urefdeser->next_uref, UREF_SERIAL_FRAME_SIZE,
+                          upipe_urefdeser->scratch, buffer);
+    return err;
+}
+
+/** @internal @This handles a complete frame at the beginning of the input
+ * stream.
+ *
+ * @param upipe description structure of the pipe
+ * @param frame type of frame
+ * @param header_size size of the serialized uref
+ * @param payload_size size of the payload
+ * @param upump_p reference to pump that generated the buffer
+ * @return an error code
+ */
+static int upipe_urefdeser_frame(struct upipe *upipe,
+                                 enum uref_serial_frame frame,
+                                 uint32_t header_size, uint32_t payload_size,
+                                 struct upump **upump_p)
+{
+    struct upipe_urefdeser *upipe_urefdeser =
+        upipe_urefdeser_from_upipe(upipe);
+    struct uref *next = upipe_urefdeser->next_uref;
+    struct uref *uref = frame == UREF_SERIAL_FRAME_FLOW_DEF ?
+                        uref_sibling_alloc_control(next) :
+                        uref_sibling_alloc(next);
+    UBASE_ALLOC_RETURN(uref)
+
+    int err = upipe_urefdeser_decode(upipe, uref,
+            frame == UREF_SERIAL_FRAME_UREF ? upipe_urefdeser->ref : NULL,
+            header_size);
+    if (unlikely(!ubase_check(err))) {
+        uref_free(uref);
+        return err;
+    }
+
+    if (frame == UREF_SERIAL_FRAME_FLOW_DEF) {
+        uref_free(upipe_urefdeser->ref);
+        upipe_urefdeser->ref = NULL;
+        upipe_urefdeser_store_flow_def(upipe, uref);
+        return UBASE_ERR_NONE;
+    }
+
+    if (payload_size) {
+        struct ubuf *ubuf = ubuf_block_splice(next->ubuf,
+                UREF_SERIAL_FRAME_SIZE + header_size, payload_size);
+        if (unlikely(ubuf == NULL)) {
+            uref_free(uref);
+            return UBASE_ERR_ALLOC;
+        }
+        uref_attach_ubuf(uref, ubuf);
+    }
+
+    struct uref *ref = uref_sibling_alloc(uref);
+    if (unlikely(ref == NULL)) {
+        uref_free(uref);
+        return UBASE_ERR_ALLOC;
+    }
+    if (uref->udict != NULL) {
+        ref->udict = udict_dup(uref->udict);
+        if (unlikely(ref->udict == NULL)) {
+            uref_free(ref);
+            uref_free(uref);
+            return UBASE_ERR_ALLOC;
+        }
+    }
+    uref_free(upipe_urefdeser->ref);
+    upipe_urefdeser->ref = ref;
+
+    if (unlikely(upipe_urefdeser->flow_def == NULL)) {
+        upipe_warn(upipe, "received a uref before the flow definition");
+        uref_free(uref);
+        return UBASE_ERR_NONE;
+    }
+    upipe_urefdeser_output(upipe, uref, upump_p);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This deserializes all complete frames of the input stream.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_urefdeser_work(struct upipe *upipe, struct upump **upump_p)
+{
+    struct upipe_urefdeser *upipe_urefdeser =
+        upipe_urefdeser_from_upipe(upipe);
+
+    while (upipe_urefdeser->next_uref != NULL) {
+        size_t total;
+        uint8_t buffer[UREF_SERIAL_FRAME_SIZE];
+        if (unlikely(!ubase_check(uref_block_size(upipe_urefdeser->next_uref,
+                                                  &total))))
+            total = 0;
+        if (total < UREF_SERIAL_FRAME_SIZE ||
+            unlikely(!ubase_check(uref_block_extract(
+                        upipe_urefdeser->next_uref, 0,
+                        UREF_SERIAL_FRAME_SIZE, buffer))))
+            return;
+
+        enum uref_serial_frame frame;
+        uint32_t header_size, payload_size;
+        if (unlikely(!ubase_check(uref_serial_read_frame(buffer, &frame,
+                            &header_size, &payload_size)) ||
+                     (uint64_t)header_size + payload_size >
+                        INT_MAX - UREF_SERIAL_FRAME_SIZE)) {
+            upipe_warn(upipe, "invalid frame, flushing");
+            upipe_urefdeser_flush(upipe);
+            return;
+        }
+        size_t frame_size =
+            UREF_SERIAL_FRAME_SIZE + (size_t)header_size + payload_size;
+        if (total < frame_size)
+            return;
+
+        int err = upipe_urefdeser_frame(upipe, frame, header_size,
+                                        payload_size, upump_p);
+        if (unlikely(!ubase_check(err)))
+            upipe_warn_va(upipe, "unable to deserialize frame (%s)",
+                          ubase_err_str(err) ?: "unknown");
+
+        if (upipe_urefdeser->next_uref == NULL)
+            return;
+        if (total == frame_size)
+            upipe_urefdeser_flush(upipe);
+        else
+            uref_block_resize(upipe_urefdeser->next_uref, frame_size, -1);
+    }
+}
+
+/** @internal @This receives a chunk of the input stream.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_urefdeser_input(struct upipe *upipe, struct uref *uref,
+                                  struct upump **upump_p)
+{
+    struct upipe_urefdeser *upipe_urefdeser =
+        upipe_urefdeser_from_upipe(upipe);
+    if (unlikely(uref->ubuf == NULL)) {
+        uref_free(uref);
+        return;
+    }
+
+    if (upipe_urefdeser->next_uref == NULL)
+        upipe_urefdeser->next_uref = uref;
+    else {
+        struct ubuf *ubuf = uref_detach_ubuf(uref);
+        uref_free(uref);
+        if (unlikely(!ubase_check(uref_block_append(
+                            upipe_urefdeser->next_uref, ubuf)))) {
+            ubuf_free(ubuf);
+            upipe_warn(upipe, "unable to append buffer, flushing");
+            upipe_urefdeser_flush(upipe);
+            return;
+        }
+    }
+
+    upipe_use(upipe);
+    upipe_urefdeser_work(upipe, upump_p);
+    upipe_release(upipe);
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_urefdeser_set_flow_def(struct upipe *upipe,
+                                        struct uref *flow_def)
+{
+    const char *def;
+    if (unlikely(flow_def == NULL ||
+                 !ubase_check(uref_flow_get_def(flow_def, &def)) ||
+                 ubase_ncmp(def, EXPECTED_FLOW_DEF)))
+        return UBASE_ERR_INVALID;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a uref deserializer pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_urefdeser_control(struct upipe *upipe, int command,
+                                   va_list args)
+{
+    UBASE_HANDLED_RETURN(
+        upipe_urefdeser_control_output(upipe, command, args));
+
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_urefdeser_set_flow_def(upipe, flow_def);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This frees a uref deserializer pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_urefdeser_free(struct upipe *upipe)
+{
+    struct upipe_urefdeser *upipe_urefdeser =
+        upipe_urefdeser_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    upipe_urefdeser_flush(upipe);
+    uref_free(upipe_urefdeser->ref);
+    free(upipe_urefdeser->scratch);
+    upipe_urefdeser_clean_output(upipe);
+    upipe_urefdeser_clean_urefcount(upipe);
+    upipe_urefdeser_free_void(upipe);
+}
+
+/** uref deserializer management structure */
+static struct upipe_mgr upipe_urefdeser_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_UREFDESER_SIGNATURE,
+
+    .upipe_alloc = upipe_urefdeser_alloc,
+    .upipe_input = upipe_urefdeser_input,
+    .upipe_control = upipe_urefdeser_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for uref deserializer pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_urefdeser_mgr_alloc(void)
+{
+    return &upipe_urefdeser_mgr;
+}
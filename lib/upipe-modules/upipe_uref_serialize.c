@@ -0,0 +1,439 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module serializing urefs and their block buffers into a stream
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uref.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_serial.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_ubuf_mgr.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe/upipe_helper_input.h>
+#include <upipe-modules/upipe_uref_serialize.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <assert.h>
+
+/** output flow definition */
+#define OUTPUT_FLOW_DEF "uref."
+
+/** @hidden */
+static bool upipe_urefser_handle(struct upipe *upipe, struct uref *uref,
+                                 struct upump **upump_p);
+/** @hidden */
+static int upipe_urefser_check(struct upipe *upipe, struct uref *flow_format);
+
+/** @internal @This is the private context of a uref serializer pipe. */
+struct upipe_urefser {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** ubuf manager */
+    struct ubuf_mgr *ubuf_mgr;
+    /** flow format packet */
+    struct uref *flow_format;
+    /** ubuf manager request */
+    struct urequest ubuf_mgr_request;
+
+    /** output pipe */
+    struct upipe *output;
+    /** output flow definition */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** temporary uref storage (used during urequest) */
+    struct uchain urefs;
+    /** nb urefs in storage */
+    unsigned int nb_urefs;
+    /** max urefs in storage */
+    unsigned int max_urefs;
+    /** list of blockers (used during urequest) */
+    struct uchain blockers;
+
+    /** input flow definition not written yet, or NULL */
+    struct uref *input_flow_def;
+    /** attributes of the previous uref, or NULL */
+    struct uref *ref;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_urefser, upipe, UPIPE_UREFSER_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_urefser, urefcount, upipe_urefser_free)
+UPIPE_HELPER_VOID(upipe_urefser)
+UPIPE_HELPER_OUTPUT(upipe_urefser, output, flow_def, output_state,
+                    request_list)
+UPIPE_HELPER_UBUF_MGR(upipe_urefser, ubuf_mgr, flow_format, ubuf_mgr_request,
+                      upipe_urefser_check,
+                      upipe_urefser_register_output_request,
+                      upipe_urefser_unregister_output_request)
+UPIPE_HELPER_INPUT(upipe_urefser, urefs, nb_urefs, max_urefs, blockers,
+                   upipe_urefser_handle)
+
+/** @internal @This allocates a uref serializer pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_urefser_alloc(struct upipe_mgr *mgr,
+                                         struct uprobe *uprobe,
+                                         uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_urefser_alloc_void(mgr, uprobe, signature,
+                                                   args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_urefser *upipe_urefser = upipe_urefser_from_upipe(upipe);
+    upipe_urefser_init_urefcount(upipe);
+    upipe_urefser_init_ubuf_mgr(upipe);
+    upipe_urefser_init_output(upipe);
+    upipe_urefser_init_input(upipe);
+    upipe_urefser->input_flow_def = NULL;
+    upipe_urefser->ref = NULL;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This allocates a frame holding a serialized uref.
+ *
+ * @param upipe description structure of the pipe
+ * @param frame type of frame
+ * @param uref uref to serialize
+ * @param ref reference uref, or NULL
+ * @param payload_size size of the payload following the frame
+ * @return pointer to the frame, or NULL in case of error
+ */
+static struct ubuf *upipe_urefser_frame(struct upipe *upipe,
+                                        enum uref_serial_frame frame,
+                                        struct uref *uref, struct uref *ref,
+                                        size_t payload_size)
+{
+    struct upipe_urefser *upipe_urefser = upipe_urefser_from_upipe(upipe);
+    size_t header_size;
+    if (unlikely(!ubase_check(uref_serial_encode(uref, ref, NULL,
+                                                 &header_size)) ||
+                 header_size > INT_MAX - UREF_SERIAL_FRAME_SIZE ||
+                 payload_size > INT_MAX - UREF_SERIAL_FRAME_SIZE -
+                                header_size)) {
+        upipe_warn(upipe, "unable to serialize uref");
+        return NULL;
+    }
+
+    struct ubuf *ubuf = ubuf_block_alloc(upipe_urefser->ubuf_mgr,
+                                         UREF_SERIAL_FRAME_SIZE + header_size);
+    if (unlikely(ubuf == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
+
+    int size = -1;
+    uint8_t *buffer;
+    if (unlikely(!ubase_check(ubuf_block_write(ubuf, 0, &size, &buffer)) ||
+                 (size_t)size != UREF_SERIAL_FRAME_SIZE + header_size)) {
+        ubuf_free(ubuf);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
+    uref_serial_write_frame(buffer, frame, header_size, payload_size);
+    int err = uref_serial_encode(uref, ref, buffer + UREF_SERIAL_FRAME_SIZE,
+                                 &header_size);
+    ubuf_block_unmap(ubuf, 0);
+    if (unlikely(!ubase_check(err))) {
+        ubuf_free(ubuf);
+        upipe_warn(upipe, "unable to serialize uref");
+        return NULL;
+    }
+    return ubuf;
+}
+
+/** @internal @This outputs the input flow definition as a frame.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_urefser_output_flow_def(struct upipe *upipe,
+                                          struct upump **upump_p)
+{
+    struct upipe_urefser *upipe_urefser = upipe_urefser_from_upipe(upipe);
+    struct uref *flow_def = upipe_urefser->input_flow_def;
+    upipe_urefser->input_flow_def = NULL;
+
+    struct ubuf *ubuf = upipe_urefser_frame(upipe, UREF_SERIAL_FRAME_FLOW_DEF,
+                                            flow_def, NULL, 0);
+    if (unlikely(ubuf == NULL)) {
+        uref_free(flow_def);
+        return;
+    }
+    struct uref *uref = uref_sibling_alloc(flow_def);
+    uref_free(flow_def);
+    if (unlikely(uref == NULL)) {
+        ubuf_free(ubuf);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    uref_attach_ubuf(uref, ubuf);
+    upipe_urefser_output(upipe, uref, upump_p);
+}
+
+/** @internal @This handles data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ * @return false if the input must be blocked
+ */
+static bool upipe_urefser_handle(struct upipe *upipe, struct uref *uref,
+                                 struct upump **upump_p)
+{
+    struct upipe_urefser *upipe_urefser = upipe_urefser_from_upipe(upipe);
+    const char *def;
+    if (unlikely(ubase_check(uref_flow_get_def(uref, &def)))) {
+        uref_free(upipe_urefser->input_flow_def);
+        upipe_urefser->input_flow_def = uref;
+        uref_free(upipe_urefser->ref);
+        upipe_urefser->ref = NULL;
+
+        struct uref *flow_def =
+            uref_block_flow_alloc_def(uref->mgr, OUTPUT_FLOW_DEF);
+        if (unlikely(flow_def == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return true;
+        }
+        upipe_urefser_store_flow_def(upipe, NULL);
+        upipe_urefser_require_ubuf_mgr(upipe, flow_def);
+        return true;
+    }
+
+    if (upipe_urefser->flow_def == NULL)
+        return false;
+
+    size_t payload_size = 0;
+    if (uref->ubuf != NULL &&
+        unlikely(!ubase_check(uref_block_size(uref, &payload_size)))) {
+        upipe_warn(upipe, "only block buffers may be serialized");
+        uref_free(uref);
+        return true;
+    }
+
+    if (upipe_urefser->input_flow_def != NULL)
+        upipe_urefser_output_flow_def(upipe, upump_p);
+
+    struct ubuf *ubuf = upipe_urefser_frame(upipe, UREF_SERIAL_FRAME_UREF,
+                                            uref, upipe_urefser->ref,
+                                            payload_size);
+    if (unlikely(ubuf == NULL)) {
+        uref_free(uref);
+        return true;
+    }
+
+    /* keep the attributes as reference for the next uref */
+    struct uref *ref = uref_sibling_alloc(uref);
+    if (unlikely(ref == NULL)) {
+        ubuf_free(ubuf);
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return true;
+    }
+    ref->udict = uref->udict;
+    uref->udict = NULL;
+    uref_free(upipe_urefser->ref);
+    upipe_urefser->ref = ref;
+
+    if (uref->ubuf != NULL) {
+        struct ubuf *payload = uref_detach_ubuf(uref);
+        if (unlikely(!ubase_check(ubuf_block_append(ubuf, payload)))) {
+            ubuf_free(payload);
+            ubuf_free(ubuf);
+            uref_free(uref);
+            upipe_warn(upipe, "unable to append payload");
+            return true;
+        }
+    }
+    uref_attach_ubuf(uref, ubuf);
+    upipe_urefser_output(upipe, uref, upump_p);
+    return true;
+}
+
+/** @internal @This inputs data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_urefser_input(struct upipe *upipe, struct uref *uref,
+                                struct upump **upump_p)
+{
+    if (!upipe_urefser_check_input(upipe)) {
+        upipe_urefser_hold_input(upipe, uref);
+        upipe_urefser_block_input(upipe, upump_p);
+    } else if (!upipe_urefser_handle(upipe, uref, upump_p)) {
+        upipe_urefser_hold_input(upipe, uref);
+        upipe_urefser_block_input(upipe, upump_p);
+        /* Increment upipe refcount to avoid disappearing before all packets
+         * have been sent. */
+        upipe_use(upipe);
+    }
+}
+
+/** @internal @This checks if the input may start.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_urefser_check(struct upipe *upipe, struct uref *flow_format)
+{
+    struct upipe_urefser *upipe_urefser = upipe_urefser_from_upipe(upipe);
+    if (flow_format != NULL)
+        upipe_urefser_store_flow_def(upipe, flow_format);
+
+    if (upipe_urefser->flow_def == NULL)
+        return UBASE_ERR_NONE;
+
+    bool was_buffered = !upipe_urefser_check_input(upipe);
+    upipe_urefser_output_input(upipe);
+    upipe_urefser_unblock_input(upipe);
+    if (was_buffered && upipe_urefser_check_input(upipe)) {
+        /* All packets have been output, release again the pipe that has been
+         * used in @ref upipe_urefser_input. */
+        upipe_release(upipe);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_urefser_set_flow_def(struct upipe *upipe,
+                                      struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup)
+    upipe_input(upipe, flow_def_dup, NULL);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a uref serializer pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_urefser_control(struct upipe *upipe, int command,
+                                 va_list args)
+{
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_UBUF_MGR ||
+                request->type == UREQUEST_FLOW_FORMAT)
+                return upipe_throw_provide_request(upipe, request);
+            return upipe_urefser_alloc_output_proxy(upipe, request);
+        }
+        case UPIPE_UNREGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_UBUF_MGR ||
+                request->type == UREQUEST_FLOW_FORMAT)
+                return UBASE_ERR_NONE;
+            return upipe_urefser_free_output_proxy(upipe, request);
+        }
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_urefser_set_flow_def(upipe, flow_def);
+        }
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_urefser_control_output(upipe, command, args);
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This frees a uref serializer pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_urefser_free(struct upipe *upipe)
+{
+    struct upipe_urefser *upipe_urefser = upipe_urefser_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    uref_free(upipe_urefser->input_flow_def);
+    uref_free(upipe_urefser->ref);
+    upipe_urefser_clean_input(upipe);
+    upipe_urefser_clean_ubuf_mgr(upipe);
+    upipe_urefser_clean_output(upipe);
+    upipe_urefser_clean_urefcount(upipe);
+    upipe_urefser_free_void(upipe);
+}
+
+/** uref serializer management structure */
+static struct upipe_mgr upipe_urefser_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_UREFSER_SIGNATURE,
+
+    .upipe_alloc = upipe_urefser_alloc,
+    .upipe_input = upipe_urefser_input,
+    .upipe_control = upipe_urefser_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for uref serializer pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_urefser_mgr_alloc(void)
+{
+    return &upipe_urefser_mgr;
+}
@@ -101,6 +101,8 @@ struct upipe_work {
     struct upipe *first_remote_xfer;
     /** last remote pipe */
     struct upipe *last_remote_xfer;
+    /** xfer manager of the event loop running the remote pipes */
+    struct upipe_mgr *xfer_mgr;
     /** output */
     struct upipe *output;
 
@@ -228,6 +230,10 @@ static struct upipe *_upipe_work_alloc(struct upipe_mgr *mgr,
     upipe_work->out_qsrc_probe.refcount =
         upipe_work_to_urefcount_real(upipe_work);
     upipe_work->frozen = false;
+    /* all remote pipes must run in the same event loop */
+    if (unlikely(!ubase_check(upipe_xfer_mgr_select(work_mgr->xfer_mgr,
+                                                    &upipe_work->xfer_mgr))))
+        upipe_work->xfer_mgr = upipe_mgr_use(work_mgr->xfer_mgr);
     upipe_throw_ready(upipe);
 
     /* last remote */
@@ -277,7 +283,7 @@ static struct upipe *_upipe_work_alloc(struct upipe_mgr *mgr,
         upipe_work_store_bin_output(upipe, upipe_use(out_qsrc));
     }
 
-    struct upipe *last_remote_xfer = upipe_xfer_alloc(work_mgr->xfer_mgr,
+    struct upipe *last_remote_xfer = upipe_xfer_alloc(upipe_work->xfer_mgr,
             uprobe_pfx_alloc(uprobe_use(&upipe_work->proxy_probe),
                              UPROBE_LOG_VERBOSE, "lin_last_xfer"),
             upipe_use(last_remote));
@@ -291,7 +297,7 @@ static struct upipe *_upipe_work_alloc(struct upipe_mgr *mgr,
 
     /* remote */
     if (last_remote != remote) {
-        struct upipe *remote_xfer = upipe_xfer_alloc(work_mgr->xfer_mgr,
+        struct upipe *remote_xfer = upipe_xfer_alloc(upipe_work->xfer_mgr,
                 uprobe_pfx_alloc(uprobe_use(&upipe_work->proxy_probe),
                                  UPROBE_LOG_VERBOSE, "lin_xfer"),
                 upipe_use(remote));
@@ -332,7 +338,7 @@ static struct upipe *_upipe_work_alloc(struct upipe_mgr *mgr,
             upipe_set_max_length(upipe_work->in_qsink,
                                       in_queue_length - UINT8_MAX);
 
-        struct upipe *in_qsrc_xfer = upipe_xfer_alloc(work_mgr->xfer_mgr,
+        struct upipe *in_qsrc_xfer = upipe_xfer_alloc(upipe_work->xfer_mgr,
                 uprobe_pfx_alloc(uprobe_use(&upipe_work->proxy_probe),
                                  UPROBE_LOG_VERBOSE, "in_qsrc_xfer"),
                 in_qsrc);
@@ -371,8 +377,7 @@ static int upipe_work_freeze(struct upipe *upipe)
     if (upipe_work->frozen)
         return UBASE_ERR_NONE;
 
-    struct upipe_work_mgr *work_mgr = upipe_work_mgr_from_upipe_mgr(upipe->mgr);
-    UBASE_RETURN(upipe_xfer_mgr_freeze(work_mgr->xfer_mgr));
+    UBASE_RETURN(upipe_xfer_mgr_freeze(upipe_work->xfer_mgr));
     upipe_work->frozen = true;
     return UBASE_ERR_NONE;
 }
@@ -388,8 +393,7 @@ static int upipe_work_thaw(struct upipe *upipe)
     if (!upipe_work->frozen)
         return UBASE_ERR_NONE;
 
-    struct upipe_work_mgr *work_mgr = upipe_work_mgr_from_upipe_mgr(upipe->mgr);
-    UBASE_RETURN(upipe_xfer_mgr_thaw(work_mgr->xfer_mgr));
+    UBASE_RETURN(upipe_xfer_mgr_thaw(upipe_work->xfer_mgr));
     upipe_work->frozen = false;
     return UBASE_ERR_NONE;
 }
@@ -476,6 +480,7 @@ static void upipe_work_free(struct upipe *upipe)
     upipe_work_clean_last_inner_probe(upipe);
     uprobe_clean(&upipe_work->in_qsrc_probe);
     uprobe_clean(&upipe_work->out_qsrc_probe);
+    upipe_mgr_release(upipe_work->xfer_mgr);
     upipe_work_clean_urefcount_real(upipe);
     upipe_work_clean_urefcount(upipe);
     upipe_clean(upipe);
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe pool of worker threads running linear subpipelines
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/upipe.h>
+#include <upipe-modules/upipe_worker_linear.h>
+#include <upipe-modules/upipe_worker_pool.h>
+
+#include <stdlib.h>
+#include <stdarg.h>
+
+/** @This initializes an empty pool.
+ *
+ * @param pool pointer to the pool
+ */
+void upipe_work_pool_init(struct upipe_work_pool *pool)
+{
+    pool->nb_workers = 0;
+    pool->workers = NULL;
+    pool->uprobe = NULL;
+    pool->next_worker = 0;
+}
+
+/** @This releases the workers of a pool.
+ *
+ * @param pool pointer to the pool
+ */
+void upipe_work_pool_clean(struct upipe_work_pool *pool)
+{
+    for (unsigned int i = 0; i < pool->nb_workers; i++)
+        upipe_mgr_release(pool->workers[i]);
+    free(pool->workers);
+    uprobe_release(pool->uprobe);
+    upipe_work_pool_init(pool);
+}
+
+/** @This replaces the worker threads of a pool.
+ *
+ * @param pool pointer to the pool
+ * @param nb_workers number of worker threads, or 0 to disable
+ * @param xfer_mgrs array of xfer managers, one per worker thread
+ * @param uprobe_remote probe hierarchy to use in the worker threads
+ * @return an error code
+ */
+int upipe_work_pool_set(struct upipe_work_pool *pool, unsigned int nb_workers,
+                        struct upipe_mgr **xfer_mgrs,
+                        struct uprobe *uprobe_remote)
+{
+    struct upipe_mgr **workers = NULL;
+    if (nb_workers) {
+        if (unlikely(xfer_mgrs == NULL || uprobe_remote == NULL))
+            return UBASE_ERR_INVALID;
+        workers = malloc(sizeof(struct upipe_mgr *) * nb_workers);
+        UBASE_ALLOC_RETURN(workers);
+        for (unsigned int i = 0; i < nb_workers; i++) {
+            workers[i] = upipe_wlin_mgr_alloc(xfer_mgrs[i]);
+            if (unlikely(workers[i] == NULL)) {
+                while (i--)
+                    upipe_mgr_release(workers[i]);
+                free(workers);
+                return UBASE_ERR_ALLOC;
+            }
+        }
+    }
+
+    upipe_work_pool_clean(pool);
+    pool->nb_workers = nb_workers;
+    pool->workers = workers;
+    pool->uprobe = nb_workers ? uprobe_use(uprobe_remote) : NULL;
+    return UBASE_ERR_NONE;
+}
+
+/** @This processes a get workers command, with an unsigned int * argument
+ * following the signature.
+ *
+ * @param pool pointer to the pool
+ * @param args arguments of the command
+ * @return an error code
+ */
+int upipe_work_pool_get_workers_va(struct upipe_work_pool *pool,
+                                   va_list args)
+{
+    unsigned int *p = va_arg(args, unsigned int *);
+    *p = pool->nb_workers;
+    return UBASE_ERR_NONE;
+}
+
+/** @This processes a set workers command, with unsigned int,
+ * struct upipe_mgr ** and struct uprobe * arguments following the
+ * signature.
+ *
+ * @param pool pointer to the pool
+ * @param args arguments of the command
+ * @return an error code
+ */
+int upipe_work_pool_set_workers_va(struct upipe_work_pool *pool,
+                                   va_list args)
+{
+    unsigned int nb_workers = va_arg(args, unsigned int);
+    struct upipe_mgr **xfer_mgrs = va_arg(args, struct upipe_mgr **);
+    struct uprobe *uprobe_remote = va_arg(args, struct uprobe *);
+    return upipe_work_pool_set(pool, nb_workers, xfer_mgrs, uprobe_remote);
+}
@@ -27,16 +27,22 @@
 #include <upipe/ubase.h>
 #include <upipe/uprobe.h>
 #include <upipe/uclock.h>
+#include <upipe/uatomic.h>
+#include <upipe/uqueue.h>
 #include <upipe/uref.h>
+#include <upipe/uref_attr.h>
 #include <upipe/uref_block.h>
 #include <upipe/uref_block_flow.h>
 #include <upipe/uref_clock.h>
+#include <upipe/uts_filter.h>
 #include <upipe/upump.h>
 #include <upipe/ubuf.h>
 #include <upipe/upipe.h>
 #include <upipe/upipe_helper_upipe.h>
 #include <upipe/upipe_helper_urefcount.h>
 #include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_flow.h>
+#include <upipe/upipe_helper_subpipe.h>
 #include <upipe/upipe_helper_uref_mgr.h>
 #include <upipe/upipe_helper_ubuf_mgr.h>
 #include <upipe/upipe_helper_output.h>
@@ -44,6 +50,14 @@
 #include <upipe/upipe_helper_upump.h>
 #include <upipe/upipe_helper_uclock.h>
 #include <upipe-netmap/upipe_netmap_source.h>
+#include <upipe-netmap/uref_netmap_flow.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
 
 #include <net/if.h>
 
@@ -57,12 +71,57 @@
 #include <bitstream/ietf/udp.h>
 #include <bitstream/ieee/ethernet.h>
 
+/** maximum number of hardware rings opened by a pipe */
+#define MAX_RINGS 64
+/** number of buffers queued between a transfer thread and the pipe */
+#define RING_QUEUE_LENGTH 255
+/** maximum number of buffers dequeued at once by the pipe */
+#define RING_POP_BATCH 32
+/** poll timeout of the transfer threads, in milliseconds */
+#define THREAD_POLL_TIMEOUT 10
+
 /** @hidden */
 static int upipe_netmap_source_check(struct upipe *upipe, struct uref *flow_format);
+/** @hidden */
+static void upipe_netmap_source_free(struct urefcount *urefcount_real);
+
+/** @internal @This is the context of an opened hardware ring. */
+struct upipe_netmap_source_ring {
+    /** pointer to the pipe */
+    struct upipe *upipe;
+    /** netmap descriptor of the ring */
+    struct nm_desc *d;
+
+    /** true if the transfer thread is running */
+    bool thread_started;
+    /** transfer thread */
+    pthread_t thread;
+    /** set to ask the transfer thread to exit */
+    uatomic_uint32_t stop;
+    /** uref manager used by the transfer thread */
+    struct uref_mgr *uref_mgr;
+    /** ubuf manager used by the transfer thread */
+    struct ubuf_mgr *ubuf_mgr;
+    /** uclock used by the transfer thread, or NULL */
+    struct uclock *uclock;
+
+    /** queue of buffers from the transfer thread to the pipe */
+    struct uqueue uqueue;
+    /** extra data for the queue */
+    uint8_t *uqueue_extra;
+    /** watcher on the queue */
+    struct upump *upump_pop;
+    /** number of buffers dropped by the transfer thread */
+    uatomic_uint32_t dropped;
+    /** number of dropped buffers already reported */
+    uint32_t dropped_reported;
+};
 
 /** @internal @This is the private context of a netmap source pipe. */
 struct upipe_netmap_source {
-    /** refcount management structure */
+    /** real refcount management structure */
+    struct urefcount urefcount_real;
+    /** refcount management structure exported to the public structure */
     struct urefcount urefcount;
 
     /** uref manager */
@@ -102,15 +161,31 @@ struct upipe_netmap_source {
     /** netmape uri **/
     char *uri;
 
-    /** netmap ring **/
-    unsigned int ring_idx;
+    /** opened hardware rings */
+    struct upipe_netmap_source_ring rings[MAX_RINGS];
+    /** number of opened hardware rings */
+    unsigned int nb_rings;
+    /** true if each ring is read by a transfer thread */
+    bool threads;
+    /** bitmap of wanted TS PIDs, or NULL, read by the transfer threads */
+    uatomic_ptr_t pid_filter;
+    /** refcount of the owner of the bitmap, or NULL */
+    struct urefcount *pid_filter_owner;
+
+    /** list of output subpipes */
+    struct uchain subs;
+    /** last output subpipe a buffer was dispatched to */
+    struct upipe_netmap_source_sub *last_sub;
+
+    /** manager to create output subpipes */
+    struct upipe_mgr sub_mgr;
 
     /** public upipe structure */
     struct upipe upipe;
 };
 
 UPIPE_HELPER_UPIPE(upipe_netmap_source, upipe, UPIPE_NETMAP_SOURCE_SIGNATURE)
-UPIPE_HELPER_UREFCOUNT(upipe_netmap_source, urefcount, upipe_netmap_source_free)
+UPIPE_HELPER_UREFCOUNT(upipe_netmap_source, urefcount, upipe_netmap_source_no_ref)
 UPIPE_HELPER_VOID(upipe_netmap_source)
 
 UPIPE_HELPER_OUTPUT(upipe_netmap_source, output, flow_def, output_state, request_list)
@@ -129,6 +204,161 @@ UPIPE_HELPER_UCLOCK(upipe_netmap_source, uclock, uclock_request, upipe_netmap_so
 UPIPE_HELPER_UPUMP_MGR(upipe_netmap_source, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_netmap_source, upump, upump_mgr)
 
+UBASE_FROM_TO(upipe_netmap_source, urefcount, urefcount_real, urefcount_real)
+
+/** @internal @This is the private context of an output subpipe of a netmap
+ * source pipe, receiving the datagrams of one UDP flow. */
+struct upipe_netmap_source_sub {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** structure for double-linked lists */
+    struct uchain uchain;
+
+    /** flow key (destination address and port) */
+    uint64_t key;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** flow definition packet on this output */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_netmap_source_sub, upipe,
+                   UPIPE_NETMAP_SOURCE_OUTPUT_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_netmap_source_sub, urefcount,
+                       upipe_netmap_source_sub_free)
+UPIPE_HELPER_FLOW(upipe_netmap_source_sub, NULL)
+UPIPE_HELPER_OUTPUT(upipe_netmap_source_sub, output, flow_def, output_state,
+                    request_list)
+
+UPIPE_HELPER_SUBPIPE(upipe_netmap_source, upipe_netmap_source_sub, sub,
+                     sub_mgr, subs, uchain)
+
+/** @internal @This returns the key of a UDP flow.
+ *
+ * @param dst_addr destination IPv4 address
+ * @param dst_port destination UDP port
+ * @return flow key
+ */
+static inline uint64_t upipe_netmap_source_key(uint32_t dst_addr,
+                                               uint16_t dst_port)
+{
+    return ((uint64_t)dst_addr << 16) | dst_port;
+}
+
+/** @internal @This allocates an output subpipe of a netmap source pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_netmap_source_sub_alloc(struct upipe_mgr *mgr,
+                                                   struct uprobe *uprobe,
+                                                   uint32_t signature,
+                                                   va_list args)
+{
+    struct uref *flow_def;
+    struct upipe *upipe = upipe_netmap_source_sub_alloc_flow(mgr, uprobe,
+            signature, args, &flow_def);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    uint64_t dst_addr, dst_port;
+    if (unlikely(!ubase_check(uref_netmap_flow_get_dst_addr(flow_def,
+                                                            &dst_addr)) ||
+                 !ubase_check(uref_netmap_flow_get_dst_port(flow_def,
+                                                            &dst_port)) ||
+                 dst_addr > UINT32_MAX || dst_port > UINT16_MAX)) {
+        uref_free(flow_def);
+        upipe_netmap_source_sub_free_flow(upipe);
+        return NULL;
+    }
+
+    struct upipe_netmap_source_sub *upipe_netmap_source_sub =
+        upipe_netmap_source_sub_from_upipe(upipe);
+    upipe_netmap_source_sub_init_urefcount(upipe);
+    upipe_netmap_source_sub_init_output(upipe);
+    upipe_netmap_source_sub_init_sub(upipe);
+    upipe_netmap_source_sub->key =
+        upipe_netmap_source_key(dst_addr, dst_port);
+    upipe_netmap_source_sub_store_flow_def(upipe, flow_def);
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This processes control commands on an output subpipe of a
+ * netmap source pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_netmap_source_sub_control(struct upipe *upipe,
+                                           int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(
+        upipe_netmap_source_sub_control_super(upipe, command, args));
+    switch (command) {
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_netmap_source_sub_control_output(upipe, command,
+                                                          args);
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_netmap_source_sub_free(struct upipe *upipe)
+{
+    struct upipe_netmap_source_sub *upipe_netmap_source_sub =
+        upipe_netmap_source_sub_from_upipe(upipe);
+    struct upipe_netmap_source *upipe_netmap_source =
+        upipe_netmap_source_from_sub_mgr(upipe->mgr);
+    if (upipe_netmap_source->last_sub == upipe_netmap_source_sub)
+        upipe_netmap_source->last_sub = NULL;
+
+    upipe_throw_dead(upipe);
+    upipe_netmap_source_sub_clean_output(upipe);
+    upipe_netmap_source_sub_clean_sub(upipe);
+    upipe_netmap_source_sub_clean_urefcount(upipe);
+    upipe_netmap_source_sub_free_flow(upipe);
+}
+
+/** @internal @This initializes the output manager for a netmap source pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_netmap_source_init_sub_mgr(struct upipe *upipe)
+{
+    struct upipe_netmap_source *upipe_netmap_source =
+        upipe_netmap_source_from_upipe(upipe);
+    struct upipe_mgr *sub_mgr = &upipe_netmap_source->sub_mgr;
+    sub_mgr->refcount =
+        upipe_netmap_source_to_urefcount_real(upipe_netmap_source);
+    sub_mgr->signature = UPIPE_NETMAP_SOURCE_OUTPUT_SIGNATURE;
+    sub_mgr->upipe_alloc = upipe_netmap_source_sub_alloc;
+    sub_mgr->upipe_input = NULL;
+    sub_mgr->upipe_control = upipe_netmap_source_sub_control;
+    sub_mgr->upipe_mgr_control = NULL;
+}
+
 /** @internal @This allocates a netmap source pipe.
  *
  * @param mgr common management structure
@@ -142,34 +372,103 @@ static struct upipe *upipe_netmap_source_alloc(struct upipe_mgr *mgr,
                                         uint32_t signature, va_list args)
 {
     struct upipe *upipe = upipe_netmap_source_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
     struct upipe_netmap_source *upipe_netmap_source = upipe_netmap_source_from_upipe(upipe);
     upipe_netmap_source_init_urefcount(upipe);
+    urefcount_init(upipe_netmap_source_to_urefcount_real(upipe_netmap_source),
+                   upipe_netmap_source_free);
     upipe_netmap_source_init_uref_mgr(upipe);
     upipe_netmap_source_init_ubuf_mgr(upipe);
     upipe_netmap_source_init_output(upipe);
     upipe_netmap_source_init_upump_mgr(upipe);
     upipe_netmap_source_init_upump(upipe);
     upipe_netmap_source_init_uclock(upipe);
+    upipe_netmap_source_init_sub_mgr(upipe);
+    upipe_netmap_source_init_sub_subs(upipe);
     upipe_netmap_source->uri = NULL;
     upipe_netmap_source->d = NULL;
+    upipe_netmap_source->nb_rings = 0;
+    upipe_netmap_source->threads = false;
+    uatomic_ptr_init(&upipe_netmap_source->pid_filter, NULL);
+    upipe_netmap_source->pid_filter_owner = NULL;
+    upipe_netmap_source->last_sub = NULL;
     upipe_throw_ready(upipe);
     return upipe;
 }
 
-static void upipe_netmap_source_worker(struct upump *upump)
+/** @internal @This outputs a buffer on the output subpipe matching its
+ * flow key, or on the output of the pipe if there is none.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure, with the flow key in its private field
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_netmap_source_dispatch(struct upipe *upipe,
+                                         struct uref *uref,
+                                         struct upump **upump_p)
 {
-    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     struct upipe_netmap_source *upipe_netmap_source = upipe_netmap_source_from_upipe(upipe);
+    uint64_t key = UINT64_MAX;
+    uref_attr_get_priv(uref, &key);
+    uref_attr_delete_priv(uref);
+
+    struct upipe_netmap_source_sub *sub = upipe_netmap_source->last_sub;
+    if (sub == NULL || sub->key != key) {
+        struct uchain *uchain;
+        sub = NULL;
+        ulist_foreach (&upipe_netmap_source->subs, uchain) {
+            struct upipe_netmap_source_sub *output =
+                upipe_netmap_source_sub_from_uchain(uchain);
+            if (output->key == key) {
+                sub = output;
+                break;
+            }
+        }
+    }
 
-    uint64_t systime = 0;
-    if (likely(upipe_netmap_source->uclock != NULL))
-        systime = uclock_now(upipe_netmap_source->uclock);
-
-    ioctl(NETMAP_FD(upipe_netmap_source->d), NIOCRXSYNC, NULL);
-    struct netmap_ring *rxring = NETMAP_RXRING(upipe_netmap_source->d->nifp,
-            upipe_netmap_source->ring_idx);
+    if (sub == NULL) {
+        upipe_netmap_source_output(upipe, uref, upump_p);
+        return;
+    }
+    upipe_netmap_source->last_sub = sub;
+    upipe_netmap_source_sub_output(upipe_netmap_source_sub_to_upipe(sub),
+                                   uref, upump_p);
+}
 
-    while (!nm_ring_empty(rxring)) {
+/** @internal @This reads the pending packets of a ring into urefs.
+ *
+ * @param ring ring to read
+ * @param uref_mgr uref manager
+ * @param ubuf_mgr ubuf manager
+ * @param systime reception date
+ * @param urefs filled in with the allocated urefs, carrying their flow key
+ * in their private field
+ * @param nb_p size of the array, filled in with the number of urefs
+ * @return an error code, in which case the packet that couldn't be allocated
+ * was dropped
+ *
+ * The TS packets of unwanted PIDs are removed in place from the netmap
+ * buffer before it is copied, and datagrams left empty are skipped.
+ */
+static int upipe_netmap_source_read(struct upipe_netmap_source_ring *ring,
+                                    struct uref_mgr *uref_mgr,
+                                    struct ubuf_mgr *ubuf_mgr,
+                                    uint64_t systime,
+                                    struct uref **urefs, unsigned int *nb_p)
+{
+    struct netmap_ring *rxring = NETMAP_RXRING(ring->d->nifp,
+                                               ring->d->first_rx_ring);
+    struct upipe_netmap_source *upipe_netmap_source =
+        upipe_netmap_source_from_upipe(ring->upipe);
+    const uint8_t *pid_filter =
+        uatomic_ptr_load_ptr(&upipe_netmap_source->pid_filter,
+                             const uint8_t *);
+    unsigned int nb = 0;
+    int err = UBASE_ERR_NONE;
+
+    while (!nm_ring_empty(rxring) && nb < *nb_p) {
         const uint32_t cur = rxring->cur;
         uint8_t *src = (uint8_t*)NETMAP_BUF(rxring, rxring->slot[cur].buf_idx);
 
@@ -181,15 +480,17 @@ static void upipe_netmap_source_worker(struct upump *upump)
             goto next;
 
         uint8_t *udp = ip_payload(ip);
-        const uint8_t *rtp = udp_payload(udp);
-        uint16_t payload_len = udp_get_len(udp) - UDP_HEADER_SIZE;
+        uint8_t *rtp = udp_payload(udp);
+        size_t payload_len = uts_filter_compact(pid_filter, rtp,
+                udp_get_len(udp) - UDP_HEADER_SIZE);
+        if (!payload_len)
+            goto next;
 
-        struct uref *uref = uref_block_alloc(upipe_netmap_source->uref_mgr,
-                                             upipe_netmap_source->ubuf_mgr,
-                                             payload_len);
+        struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, payload_len);
         if (unlikely(uref == NULL)) {
-            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-            return;
+            err = UBASE_ERR_ALLOC;
+            rxring->head = rxring->cur = nm_ring_next(rxring, cur);
+            break;
         }
 
         uint8_t *buffer;
@@ -197,19 +498,237 @@ static void upipe_netmap_source_worker(struct upump *upump)
         if (unlikely(!ubase_check(uref_block_write(uref, 0, &output_size,
                                                    &buffer)))) {
             uref_free(uref);
-            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-            return;
+            err = UBASE_ERR_ALLOC;
+            rxring->head = rxring->cur = nm_ring_next(rxring, cur);
+            break;
         }
 
         memcpy(buffer, rtp, payload_len);
         uref_block_unmap(uref, 0);
 
         uref_clock_set_cr_sys(uref, systime);
-
-        upipe_netmap_source_output(upipe, uref, &upipe_netmap_source->upump);
+        uref_attr_set_priv(uref,
+                upipe_netmap_source_key(ip_get_dstaddr(ip),
+                                        udp_get_dstport(udp)));
+        urefs[nb++] = uref;
 next:
         rxring->head = rxring->cur = nm_ring_next(rxring, cur);
     }
+
+    *nb_p = nb;
+    return err;
+}
+
+/** @internal @This is the main loop of a transfer thread. It polls its ring
+ * and queues the received buffers for the pipe.
+ *
+ * @param arg ring to read
+ * @return NULL
+ */
+static void *upipe_netmap_source_thread(void *arg)
+{
+    struct upipe_netmap_source_ring *ring = arg;
+    struct pollfd pfd;
+    pfd.fd = NETMAP_FD(ring->d);
+    pfd.events = POLLIN;
+
+    while (!uatomic_load(&ring->stop)) {
+        if (poll(&pfd, 1, THREAD_POLL_TIMEOUT) <= 0)
+            continue;
+
+        uint64_t systime = 0;
+        if (likely(ring->uclock != NULL))
+            systime = uclock_now(ring->uclock);
+
+        for ( ; ; ) {
+            struct uref *urefs[RING_POP_BATCH];
+            unsigned int nb = RING_POP_BATCH;
+            int err = upipe_netmap_source_read(ring, ring->uref_mgr,
+                                               ring->ubuf_mgr, systime,
+                                               urefs, &nb);
+
+            unsigned int pushed = uqueue_push_batch(&ring->uqueue,
+                                                    (void **)urefs, nb);
+            if (unlikely(pushed < nb)) {
+                uatomic_fetch_add(&ring->dropped, nb - pushed);
+                for (unsigned int i = pushed; i < nb; i++)
+                    uref_free(urefs[i]);
+            }
+
+            if (unlikely(!ubase_check(err)))
+                uatomic_fetch_add(&ring->dropped, 1);
+            else if (nb < RING_POP_BATCH)
+                break;
+        }
+    }
+    return NULL;
+}
+
+/** @internal @This is called when buffers were queued by a transfer thread.
+ *
+ * @param upump description structure of the watcher
+ */
+static void upipe_netmap_source_pop(struct upump *upump)
+{
+    struct upipe_netmap_source_ring *ring =
+        upump_get_opaque(upump, struct upipe_netmap_source_ring *);
+    struct upipe *upipe = ring->upipe;
+
+    uint32_t dropped = uatomic_load(&ring->dropped);
+    if (unlikely(dropped != ring->dropped_reported)) {
+        upipe_warn_va(upipe, "ring %u: dropped %"PRIu32" packets",
+                      ring->d->first_rx_ring, dropped - ring->dropped_reported);
+        ring->dropped_reported = dropped;
+    }
+
+    struct uref *urefs[RING_POP_BATCH];
+    unsigned int nb = uqueue_pop_batch(&ring->uqueue, (void **)urefs,
+                                       RING_POP_BATCH);
+    for (unsigned int i = 0; i < nb; i++)
+        upipe_netmap_source_dispatch(upipe, urefs[i], &ring->upump_pop);
+}
+
+/** @internal @This flushes the queue of a ring and releases the resources
+ * of its transfer thread, once it has exited.
+ *
+ * @param ring ring to clean
+ */
+static void upipe_netmap_source_ring_clean(struct upipe_netmap_source_ring *ring)
+{
+    upump_stop(ring->upump_pop);
+    upump_free(ring->upump_pop);
+    ring->upump_pop = NULL;
+
+    struct uref *uref;
+    while ((uref = uqueue_pop(&ring->uqueue, struct uref *)) != NULL)
+        uref_free(uref);
+    uqueue_clean(&ring->uqueue);
+    free(ring->uqueue_extra);
+    ring->uqueue_extra = NULL;
+
+    uref_mgr_release(ring->uref_mgr);
+    ring->uref_mgr = NULL;
+    ubuf_mgr_release(ring->ubuf_mgr);
+    ring->ubuf_mgr = NULL;
+    uclock_release(ring->uclock);
+    ring->uclock = NULL;
+    uatomic_clean(&ring->dropped);
+    uatomic_clean(&ring->stop);
+}
+
+/** @internal @This stops the transfer thread of a ring.
+ *
+ * @param ring ring to stop
+ */
+static void upipe_netmap_source_ring_stop(struct upipe_netmap_source_ring *ring)
+{
+    if (!ring->thread_started)
+        return;
+
+    uatomic_store(&ring->stop, 1);
+    pthread_join(ring->thread, NULL);
+    ring->thread_started = false;
+    upipe_netmap_source_ring_clean(ring);
+}
+
+/** @internal @This starts the transfer thread of a ring.
+ *
+ * @param upipe description structure of the pipe
+ * @param ring ring to start
+ * @return an error code
+ */
+static int upipe_netmap_source_ring_start(struct upipe *upipe,
+                                          struct upipe_netmap_source_ring *ring)
+{
+    struct upipe_netmap_source *upipe_netmap_source = upipe_netmap_source_from_upipe(upipe);
+
+    ring->uqueue_extra = malloc(uqueue_sizeof(RING_QUEUE_LENGTH));
+    if (unlikely(ring->uqueue_extra == NULL))
+        return UBASE_ERR_ALLOC;
+    if (unlikely(!uqueue_init(&ring->uqueue, RING_QUEUE_LENGTH,
+                              ring->uqueue_extra))) {
+        free(ring->uqueue_extra);
+        ring->uqueue_extra = NULL;
+        return UBASE_ERR_ALLOC;
+    }
+
+    ring->upump_pop = uqueue_upump_alloc_pop(&ring->uqueue,
+            upipe_netmap_source->upump_mgr, upipe_netmap_source_pop, ring,
+            upipe->refcount);
+    if (unlikely(ring->upump_pop == NULL)) {
+        uqueue_clean(&ring->uqueue);
+        free(ring->uqueue_extra);
+        ring->uqueue_extra = NULL;
+        return UBASE_ERR_UPUMP;
+    }
+
+    ring->uref_mgr = uref_mgr_use(upipe_netmap_source->uref_mgr);
+    ring->ubuf_mgr = ubuf_mgr_use(upipe_netmap_source->ubuf_mgr);
+    ring->uclock = uclock_use(upipe_netmap_source->uclock);
+    uatomic_init(&ring->stop, 0);
+    uatomic_init(&ring->dropped, 0);
+    ring->dropped_reported = 0;
+
+    if (unlikely(pthread_create(&ring->thread, NULL,
+                                upipe_netmap_source_thread, ring) != 0)) {
+        upipe_err_va(upipe, "can't create transfer thread for ring %u",
+                     ring->d->first_rx_ring);
+        upipe_netmap_source_ring_clean(ring);
+        return UBASE_ERR_EXTERNAL;
+    }
+    ring->thread_started = true;
+    upump_start(ring->upump_pop);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This stops all the transfer threads.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_netmap_source_stop_threads(struct upipe *upipe)
+{
+    struct upipe_netmap_source *upipe_netmap_source = upipe_netmap_source_from_upipe(upipe);
+    for (unsigned int i = 0; i < upipe_netmap_source->nb_rings; i++)
+        upipe_netmap_source_ring_stop(&upipe_netmap_source->rings[i]);
+}
+
+/** @internal @This polls all the rings from the event loop, when no transfer
+ * thread is used.
+ *
+ * @param upump description structure of the watcher
+ */
+static void upipe_netmap_source_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_netmap_source *upipe_netmap_source = upipe_netmap_source_from_upipe(upipe);
+
+    uint64_t systime = 0;
+    if (likely(upipe_netmap_source->uclock != NULL))
+        systime = uclock_now(upipe_netmap_source->uclock);
+
+    for (unsigned int i = 0; i < upipe_netmap_source->nb_rings; i++) {
+        struct upipe_netmap_source_ring *ring = &upipe_netmap_source->rings[i];
+        ioctl(NETMAP_FD(ring->d), NIOCRXSYNC, NULL);
+
+        int err;
+        do {
+            struct uref *urefs[RING_POP_BATCH];
+            unsigned int nb = RING_POP_BATCH;
+            err = upipe_netmap_source_read(ring,
+                    upipe_netmap_source->uref_mgr,
+                    upipe_netmap_source->ubuf_mgr, systime, urefs, &nb);
+            for (unsigned int j = 0; j < nb; j++)
+                upipe_netmap_source_dispatch(upipe, urefs[j],
+                                             &upipe_netmap_source->upump);
+            if (!nb)
+                break;
+        } while (ubase_check(err));
+
+        if (unlikely(!ubase_check(err))) {
+            upipe_throw_fatal(upipe, err);
+            return;
+        }
+    }
 }
 
 /** @internal @This checks if the pump may be allocated.
@@ -249,11 +768,24 @@ static int upipe_netmap_source_check(struct upipe *upipe, struct uref *flow_form
             != NULL)
         return UBASE_ERR_NONE;
 
-    if (!upipe_netmap_source->d)
+    if (!upipe_netmap_source->nb_rings)
         return UBASE_ERR_NONE;
 
-    if (NETMAP_FD(upipe_netmap_source->d) == -1)
+    if (upipe_netmap_source->threads) {
+        for (unsigned int i = 0; i < upipe_netmap_source->nb_rings; i++) {
+            struct upipe_netmap_source_ring *ring =
+                &upipe_netmap_source->rings[i];
+            if (ring->thread_started)
+                continue;
+            if (unlikely(!ubase_check(upipe_netmap_source_ring_start(upipe,
+                                                                     ring)))) {
+                upipe_netmap_source_stop_threads(upipe);
+                upipe_throw_fatal(upipe, UBASE_ERR_EXTERNAL);
+                return UBASE_ERR_EXTERNAL;
+            }
+        }
         return UBASE_ERR_NONE;
+    }
 
     if (upipe_netmap_source->upump)
         return UBASE_ERR_NONE;
@@ -268,6 +800,46 @@ static int upipe_netmap_source_check(struct upipe *upipe, struct uref *flow_form
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This stops the transfer and closes all the rings.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_netmap_source_close(struct upipe *upipe)
+{
+    struct upipe_netmap_source *upipe_netmap_source = upipe_netmap_source_from_upipe(upipe);
+
+    upipe_netmap_source_stop_threads(upipe);
+    upipe_netmap_source_set_upump(upipe, NULL);
+    for (unsigned int i = 0; i < upipe_netmap_source->nb_rings; i++)
+        if (upipe_netmap_source->rings[i].d != upipe_netmap_source->d)
+            nm_close(upipe_netmap_source->rings[i].d);
+    upipe_netmap_source->nb_rings = 0;
+    if (upipe_netmap_source->d != NULL)
+        nm_close(upipe_netmap_source->d);
+    upipe_netmap_source->d = NULL;
+}
+
+/** @internal @This initializes the context of an opened ring.
+ *
+ * @param upipe description structure of the pipe
+ * @param d netmap descriptor of the ring
+ */
+static void upipe_netmap_source_add_ring(struct upipe *upipe,
+                                         struct nm_desc *d)
+{
+    struct upipe_netmap_source *upipe_netmap_source = upipe_netmap_source_from_upipe(upipe);
+    struct upipe_netmap_source_ring *ring =
+        &upipe_netmap_source->rings[upipe_netmap_source->nb_rings++];
+    ring->upipe = upipe;
+    ring->d = d;
+    ring->thread_started = false;
+    ring->uref_mgr = NULL;
+    ring->ubuf_mgr = NULL;
+    ring->uclock = NULL;
+    ring->uqueue_extra = NULL;
+    ring->upump_pop = NULL;
+}
+
 /** @internal @This returns the uri of the currently opened netmap.
  *
  * @param upipe description structure of the pipe
@@ -292,14 +864,15 @@ static int upipe_netmap_source_set_uri(struct upipe *upipe, const char *uri)
 {
     struct upipe_netmap_source *upipe_netmap_source = upipe_netmap_source_from_upipe(upipe);
 
-    nm_close(upipe_netmap_source->d);
+    upipe_netmap_source_close(upipe);
     ubase_clean_str(&upipe_netmap_source->uri);
-    upipe_netmap_source_set_upump(upipe, NULL);
 
     if (unlikely(uri == NULL))
         return UBASE_ERR_NONE;
 
-    if (sscanf(uri, "%*[^-]-%u/R", &upipe_netmap_source->ring_idx) != 1) {
+    unsigned int ring_idx;
+    bool single = strchr(uri, '-') != NULL;
+    if (single && sscanf(uri, "%*[^-]-%u/R", &ring_idx) != 1) {
         upipe_err_va(upipe, "invalid netmap receive uri %s", uri);
         return UBASE_ERR_EXTERNAL;
     }
@@ -310,16 +883,62 @@ static int upipe_netmap_source_set_uri(struct upipe *upipe, const char *uri)
         return UBASE_ERR_EXTERNAL;
     }
 
+    if (single) {
+        upipe_netmap_source_add_ring(upipe, upipe_netmap_source->d);
+    } else {
+        /* open each hardware ring on the memory of the parent descriptor */
+        unsigned int nb_rings = upipe_netmap_source->d->req.nr_rx_rings;
+        if (nb_rings > MAX_RINGS) {
+            upipe_warn_va(upipe, "only opening %u rings out of %u",
+                          MAX_RINGS, nb_rings);
+            nb_rings = MAX_RINGS;
+        }
+        for (unsigned int i = 0; i < nb_rings; i++) {
+            char ring_uri[strlen(uri) + sizeof("-4294967295/R")];
+            snprintf(ring_uri, sizeof(ring_uri), "%s-%u/R", uri, i);
+            struct nm_desc *d = nm_open(ring_uri, NULL, NM_OPEN_NO_MMAP,
+                                        upipe_netmap_source->d);
+            if (unlikely(d == NULL)) {
+                upipe_err_va(upipe, "can't open netmap socket %s", ring_uri);
+                upipe_netmap_source_close(upipe);
+                return UBASE_ERR_EXTERNAL;
+            }
+            upipe_netmap_source_add_ring(upipe, d);
+        }
+    }
+
     upipe_netmap_source->uri = strdup(uri);
     if (unlikely(upipe_netmap_source->uri == NULL)) {
-        nm_close(upipe_netmap_source->d);
-        upipe_netmap_source->d = NULL;
+        upipe_netmap_source_close(upipe);
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return UBASE_ERR_ALLOC;
     }
 
-    upipe_notice_va(upipe, "opening netmap socket %s ring %u",
-            upipe_netmap_source->uri, upipe_netmap_source->ring_idx);
+    if (single)
+        upipe_notice_va(upipe, "opening netmap socket %s ring %u",
+                upipe_netmap_source->uri, ring_idx);
+    else
+        upipe_notice_va(upipe, "opening netmap socket %s (%u rings)",
+                upipe_netmap_source->uri, upipe_netmap_source->nb_rings);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets whether each ring is read by a transfer thread.
+ *
+ * @param upipe description structure of the pipe
+ * @param threads true to use transfer threads
+ * @return an error code
+ */
+static int upipe_netmap_source_set_threads_real(struct upipe *upipe,
+                                                bool threads)
+{
+    struct upipe_netmap_source *upipe_netmap_source = upipe_netmap_source_from_upipe(upipe);
+    if (threads == upipe_netmap_source->threads)
+        return UBASE_ERR_NONE;
+
+    upipe_netmap_source_stop_threads(upipe);
+    upipe_netmap_source_set_upump(upipe, NULL);
+    upipe_netmap_source->threads = threads;
     return UBASE_ERR_NONE;
 }
 
@@ -333,11 +952,17 @@ static int upipe_netmap_source_set_uri(struct upipe *upipe, const char *uri)
 static int _upipe_netmap_source_control(struct upipe *upipe,
                                  int command, va_list args)
 {
+    struct upipe_netmap_source *upipe_netmap_source =
+        upipe_netmap_source_from_upipe(upipe);
+    UBASE_HANDLED_RETURN(upipe_netmap_source_control_subs(upipe, command, args));
+
     switch (command) {
         case UPIPE_ATTACH_UPUMP_MGR:
+            upipe_netmap_source_stop_threads(upipe);
             upipe_netmap_source_set_upump(upipe, NULL);
             return upipe_netmap_source_attach_upump_mgr(upipe);
         case UPIPE_ATTACH_UCLOCK:
+            upipe_netmap_source_stop_threads(upipe);
             upipe_netmap_source_set_upump(upipe, NULL);
             upipe_netmap_source_require_uclock(upipe);
             return UBASE_ERR_NONE;
@@ -355,6 +980,32 @@ static int _upipe_netmap_source_control(struct upipe *upipe,
             const char *uri = va_arg(args, const char *);
             return upipe_netmap_source_set_uri(upipe, uri);
         }
+        case UPIPE_NETMAP_SOURCE_SET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NETMAP_SOURCE_SIGNATURE)
+            bool threads = va_arg(args, int);
+            return upipe_netmap_source_set_threads_real(upipe, threads);
+        }
+        case UPIPE_NETMAP_SOURCE_GET_PID_FILTER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NETMAP_SOURCE_SIGNATURE)
+            const uint8_t **pid_filter_p = va_arg(args, const uint8_t **);
+            *pid_filter_p =
+                uatomic_ptr_load_ptr(&upipe_netmap_source->pid_filter,
+                                     const uint8_t *);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_NETMAP_SOURCE_SET_PID_FILTER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NETMAP_SOURCE_SIGNATURE)
+            const uint8_t *pid_filter = va_arg(args, const uint8_t *);
+            struct urefcount *owner = va_arg(args, struct urefcount *);
+            /* the threads may still read the previous bitmap, they are
+             * restarted by the check */
+            upipe_netmap_source_stop_threads(upipe);
+            uatomic_ptr_store(&upipe_netmap_source->pid_filter,
+                              (void *)pid_filter);
+            urefcount_release(upipe_netmap_source->pid_filter_owner);
+            upipe_netmap_source->pid_filter_owner = urefcount_use(owner);
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -377,27 +1028,43 @@ static int upipe_netmap_source_control(struct upipe *upipe, int command, va_list
 
 /** @This frees a upipe.
  *
- * @param upipe description structure of the pipe
+ * @param urefcount_real pointer to urefcount_real structure
  */
-static void upipe_netmap_source_free(struct upipe *upipe)
+static void upipe_netmap_source_free(struct urefcount *urefcount_real)
 {
-    struct upipe_netmap_source *upipe_netmap_source = upipe_netmap_source_from_upipe(upipe);
-
-    nm_close(upipe_netmap_source->d);
+    struct upipe_netmap_source *upipe_netmap_source =
+        upipe_netmap_source_from_urefcount_real(urefcount_real);
+    struct upipe *upipe = upipe_netmap_source_to_upipe(upipe_netmap_source);
 
     upipe_throw_dead(upipe);
 
     free(upipe_netmap_source->uri);
+    uatomic_ptr_clean(&upipe_netmap_source->pid_filter);
+    urefcount_release(upipe_netmap_source->pid_filter_owner);
+    upipe_netmap_source_clean_sub_subs(upipe);
     upipe_netmap_source_clean_uclock(upipe);
     upipe_netmap_source_clean_upump(upipe);
     upipe_netmap_source_clean_upump_mgr(upipe);
     upipe_netmap_source_clean_output(upipe);
     upipe_netmap_source_clean_ubuf_mgr(upipe);
     upipe_netmap_source_clean_uref_mgr(upipe);
+    urefcount_clean(urefcount_real);
     upipe_netmap_source_clean_urefcount(upipe);
     upipe_netmap_source_free_void(upipe);
 }
 
+/** @This is called when there is no external reference to the pipe anymore.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_netmap_source_no_ref(struct upipe *upipe)
+{
+    struct upipe_netmap_source *upipe_netmap_source = upipe_netmap_source_from_upipe(upipe);
+    upipe_netmap_source_close(upipe);
+    upipe_netmap_source_throw_sub_subs(upipe, UPROBE_SOURCE_END);
+    urefcount_release(upipe_netmap_source_to_urefcount_real(upipe_netmap_source));
+}
+
 /** module manager static descriptor */
 static struct upipe_mgr upipe_netmap_source_mgr = {
     .refcount = NULL,
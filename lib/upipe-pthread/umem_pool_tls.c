@@ -0,0 +1,522 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe umem pool manager with per-thread magazines
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/urefcount.h>
+#include <upipe/ulist.h>
+#include <upipe/ulifo.h>
+#include <upipe/umem.h>
+#include <upipe/ualloc_audit.h>
+#include <upipe-pthread/umem_pool_tls.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+/** @This defines the private data structures of the umem pool manager. */
+struct umem_pool_tls_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** key to the magazines of the current thread */
+    pthread_key_t key;
+    /** mutex protecting the list of magazines and the statistics */
+    pthread_mutex_t mutex;
+    /** list of magazines of all threads */
+    struct uchain magazines;
+    /** statistics of the threads that have exited */
+    struct umem_mgr_stats stats;
+
+    /** common management structure */
+    struct umem_mgr mgr;
+
+    /** size (in octets) of buffers of pools[0] */
+    size_t pool0_size;
+    /** number of pools of buffers */
+    size_t nb_pools;
+    /** number of buffers kept per pool in each magazine */
+    unsigned int magazine_size;
+    /** buffer pools */
+    struct ulifo pools[];
+};
+
+UBASE_FROM_TO(umem_pool_tls_mgr, umem_mgr, umem_mgr, mgr)
+UBASE_FROM_TO(umem_pool_tls_mgr, urefcount, urefcount, urefcount)
+
+/** @This defines the buffers cached by a thread. */
+struct umem_pool_tls_magazine {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** pointer to the manager */
+    struct umem_pool_tls_mgr *pool_mgr;
+    /** statistics of the thread */
+    struct umem_mgr_stats stats;
+    /** number of buffers in each pool */
+    unsigned int *counts;
+    /** buffers, magazine_size per pool */
+    uint8_t **buffers;
+};
+
+UBASE_FROM_TO(umem_pool_tls_magazine, uchain, uchain, uchain)
+
+/** @internal @This returns the nearest bigger size to allocate for a umem of
+ * the given size to fit into and returns the index of the appropriate pool.
+ *
+ * @param pool_mgr description structure of the umem mgr
+ * @param wanted desired size of the umem
+ * @param real_p reference written with the actual size of the future buffer
+ * @return index of the pool in which to find appropriate buffers
+ */
+static unsigned int umem_pool_tls_find(struct umem_pool_tls_mgr *pool_mgr,
+                                       size_t wanted, size_t *real_p)
+{
+    size_t size = pool_mgr->pool0_size;
+    unsigned int pool;
+
+    for (pool = 0; pool < pool_mgr->nb_pools; pool++)
+        if (wanted <= (size << pool))
+            break;
+    if (likely(real_p != NULL))
+        *real_p = pool < pool_mgr->nb_pools ? size << pool : wanted;
+    return pool;
+}
+
+/** @internal @This returns the buffers of a magazine to the shared pools.
+ *
+ * @param magazine description structure of the magazine
+ */
+static void umem_pool_tls_magazine_flush(
+        struct umem_pool_tls_magazine *magazine)
+{
+    struct umem_pool_tls_mgr *pool_mgr = magazine->pool_mgr;
+    for (unsigned int i = 0; i < pool_mgr->nb_pools; i++) {
+        uint8_t **buffers = magazine->buffers + i * pool_mgr->magazine_size;
+        while (magazine->counts[i]) {
+            uint8_t *buffer = buffers[--magazine->counts[i]];
+            if (!ulifo_push(&pool_mgr->pools[i], buffer))
+                free(buffer);
+        }
+    }
+}
+
+/** @internal @This is called when a thread having a magazine exits.
+ *
+ * @param opaque pointer to the magazine
+ */
+static void umem_pool_tls_magazine_free(void *opaque)
+{
+    struct umem_pool_tls_magazine *magazine = opaque;
+    struct umem_pool_tls_mgr *pool_mgr = magazine->pool_mgr;
+
+    pthread_mutex_lock(&pool_mgr->mutex);
+    ulist_delete(umem_pool_tls_magazine_to_uchain(magazine));
+    pool_mgr->stats.hits += magazine->stats.hits;
+    pool_mgr->stats.misses += magazine->stats.misses;
+    pool_mgr->stats.fallbacks += magazine->stats.fallbacks;
+    pthread_mutex_unlock(&pool_mgr->mutex);
+
+    umem_pool_tls_magazine_flush(magazine);
+    free(magazine);
+}
+
+/** @internal @This returns the magazine of the current thread, allocating it
+ * if needed.
+ *
+ * @param pool_mgr description structure of the umem mgr
+ * @return pointer to the magazine, or NULL in case of allocation error
+ */
+static struct umem_pool_tls_magazine *
+    umem_pool_tls_magazine(struct umem_pool_tls_mgr *pool_mgr)
+{
+    struct umem_pool_tls_magazine *magazine =
+        pthread_getspecific(pool_mgr->key);
+    if (likely(magazine != NULL))
+        return magazine;
+
+    magazine = malloc(sizeof(struct umem_pool_tls_magazine) +
+                      sizeof(unsigned int) * pool_mgr->nb_pools +
+                      sizeof(uint8_t *) * pool_mgr->nb_pools *
+                                          pool_mgr->magazine_size);
+    if (unlikely(magazine == NULL))
+        return NULL;
+
+    magazine->pool_mgr = pool_mgr;
+    memset(&magazine->stats, 0, sizeof(magazine->stats));
+    magazine->buffers = (uint8_t **)(magazine + 1);
+    magazine->counts = (unsigned int *)(magazine->buffers +
+            pool_mgr->nb_pools * pool_mgr->magazine_size);
+    memset(magazine->counts, 0, sizeof(unsigned int) * pool_mgr->nb_pools);
+
+    if (unlikely(pthread_setspecific(pool_mgr->key, magazine) != 0)) {
+        free(magazine);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&pool_mgr->mutex);
+    ulist_add(&pool_mgr->magazines,
+              umem_pool_tls_magazine_to_uchain(magazine));
+    pthread_mutex_unlock(&pool_mgr->mutex);
+    return magazine;
+}
+
+/** @This allocates a new umem buffer space.
+ *
+ * @param mgr management structure
+ * @param umem caller-allocated structure, filled in with the required pointer
+ * and size (previous content is discarded)
+ * @param size requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_pool_tls_alloc(struct umem_mgr *mgr, struct umem *umem,
+                                size_t size)
+{
+    struct umem_pool_tls_mgr *pool_mgr = umem_pool_tls_mgr_from_umem_mgr(mgr);
+    size_t real_size;
+    unsigned int pool = umem_pool_tls_find(pool_mgr, size, &real_size);
+    struct umem_pool_tls_magazine *magazine =
+        umem_pool_tls_magazine(pool_mgr);
+    uint8_t *buffer = NULL;
+
+    if (likely(pool < pool_mgr->nb_pools && magazine != NULL)) {
+        uint8_t **buffers = magazine->buffers +
+                            pool * pool_mgr->magazine_size;
+        unsigned int *count = &magazine->counts[pool];
+        if (likely(*count)) {
+            magazine->stats.hits++;
+            buffer = buffers[--(*count)];
+        } else {
+            /* refill half of the magazine from the shared pool */
+            magazine->stats.misses++;
+            while (*count < (pool_mgr->magazine_size + 1) / 2) {
+                uint8_t *refill = ulifo_pop(&pool_mgr->pools[pool],
+                                            uint8_t *);
+                if (refill == NULL)
+                    break;
+                buffers[(*count)++] = refill;
+            }
+            if (*count)
+                buffer = buffers[--(*count)];
+        }
+    }
+    if (unlikely(buffer == NULL)) {
+        if (likely(magazine != NULL))
+            magazine->stats.fallbacks++;
+        ualloc_audit_fallback("umem_pool_tls");
+        buffer = malloc(real_size);
+    }
+    if (unlikely(buffer == NULL))
+        return false;
+
+    umem->buffer = buffer;
+    umem->size = size;
+    umem->real_size = real_size;
+    umem->mgr = mgr;
+    return true;
+}
+
+/** @This frees a umem.
+ *
+ * @param umem caller-allocated structure, previously successfully passed to
+ * @ref umem_alloc
+ */
+static void umem_pool_tls_free(struct umem *umem)
+{
+    struct umem_pool_tls_mgr *pool_mgr =
+        umem_pool_tls_mgr_from_umem_mgr(umem->mgr);
+    unsigned int pool = umem_pool_tls_find(pool_mgr, umem->real_size, NULL);
+    struct umem_pool_tls_magazine *magazine =
+        pool < pool_mgr->nb_pools ? umem_pool_tls_magazine(pool_mgr) : NULL;
+
+    if (likely(magazine != NULL)) {
+        uint8_t **buffers = magazine->buffers +
+                            pool * pool_mgr->magazine_size;
+        unsigned int *count = &magazine->counts[pool];
+        if (unlikely(*count >= pool_mgr->magazine_size)) {
+            /* flush half of the magazine to the shared pool */
+            while (*count > pool_mgr->magazine_size / 2) {
+                uint8_t *flush = buffers[--(*count)];
+                if (!ulifo_push(&pool_mgr->pools[pool], flush))
+                    free(flush);
+            }
+        }
+        buffers[(*count)++] = umem->buffer;
+    } else if (pool >= pool_mgr->nb_pools ||
+               !ulifo_push(&pool_mgr->pools[pool], umem->buffer))
+        free(umem->buffer);
+    umem->buffer = NULL;
+    umem->mgr = NULL;
+}
+
+/** @This resizes a umem. We do not realloc() the buffer because it would
+ * artificially grow the size of a pool, and create a malloc/free contention.
+ *
+ * @param umem caller-allocated structure, previously successfully passed to
+ * @ref umem_alloc, and filled in with the new pointer and size
+ * @param new_size new requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_pool_tls_realloc(struct umem *umem, size_t new_size)
+{
+    if (likely(new_size <= umem->real_size)) {
+        umem->size = new_size;
+        return true;
+    }
+
+    struct umem new_umem;
+    if (!umem_pool_tls_alloc(umem->mgr, &new_umem, new_size))
+        return false;
+    memcpy(new_umem.buffer, umem->buffer, umem->size);
+    umem_pool_tls_free(umem);
+    *umem = new_umem;
+    return true;
+}
+
+/** @This instructs an existing umem manager to release all structures
+ * currently kept in the shared pools and in the magazine of the current
+ * thread. It is intended as a debug tool only.
+ *
+ * @param mgr pointer to umem manager
+ */
+static void umem_pool_tls_mgr_vacuum(struct umem_mgr *mgr)
+{
+    struct umem_pool_tls_mgr *pool_mgr = umem_pool_tls_mgr_from_umem_mgr(mgr);
+    struct umem_pool_tls_magazine *magazine =
+        pthread_getspecific(pool_mgr->key);
+    if (magazine != NULL)
+        umem_pool_tls_magazine_flush(magazine);
+
+    for (unsigned int i = 0; i < pool_mgr->nb_pools; i++) {
+        uint8_t *buffer;
+        while ((buffer = ulifo_pop(&pool_mgr->pools[i], uint8_t *)) != NULL)
+            free(buffer);
+    }
+}
+
+/** @internal @This returns the allocation statistics of all threads. The
+ * counters of running threads are read without synchronization, so the
+ * result is approximate.
+ *
+ * @param pool_mgr description structure of the umem mgr
+ * @param stats filled in with the statistics
+ * @return an error code
+ */
+static int umem_pool_tls_mgr_get_stats(struct umem_pool_tls_mgr *pool_mgr,
+                                       struct umem_mgr_stats *stats)
+{
+    assert(stats != NULL);
+    pthread_mutex_lock(&pool_mgr->mutex);
+    *stats = pool_mgr->stats;
+    struct uchain *uchain;
+    ulist_foreach (&pool_mgr->magazines, uchain) {
+        struct umem_pool_tls_magazine *magazine =
+            umem_pool_tls_magazine_from_uchain(uchain);
+        stats->hits += magazine->stats.hits;
+        stats->misses += magazine->stats.misses;
+        stats->fallbacks += magazine->stats.fallbacks;
+    }
+    pthread_mutex_unlock(&pool_mgr->mutex);
+    return UBASE_ERR_NONE;
+}
+
+/** @This processes control commands on a umem manager.
+ *
+ * @param mgr pointer to umem manager
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int umem_pool_tls_mgr_control(struct umem_mgr *mgr,
+                                     int command, va_list args)
+{
+    struct umem_pool_tls_mgr *pool_mgr = umem_pool_tls_mgr_from_umem_mgr(mgr);
+
+    switch (command) {
+        case UMEM_MGR_GET_STATS: {
+            struct umem_mgr_stats *stats =
+                va_arg(args, struct umem_mgr_stats *);
+            return umem_pool_tls_mgr_get_stats(pool_mgr, stats);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a umem manager.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void umem_pool_tls_mgr_free(struct urefcount *urefcount)
+{
+    struct umem_pool_tls_mgr *pool_mgr =
+        umem_pool_tls_mgr_from_urefcount(urefcount);
+
+    /* no thread may use the manager anymore */
+    pthread_key_delete(pool_mgr->key);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&pool_mgr->magazines, uchain, uchain_tmp) {
+        struct umem_pool_tls_magazine *magazine =
+            umem_pool_tls_magazine_from_uchain(uchain);
+        ulist_delete(uchain);
+        umem_pool_tls_magazine_flush(magazine);
+        free(magazine);
+    }
+
+    for (unsigned int i = 0; i < pool_mgr->nb_pools; i++) {
+        uint8_t *buffer;
+        while ((buffer = ulifo_pop(&pool_mgr->pools[i], uint8_t *)) != NULL)
+            free(buffer);
+        ulifo_clean(&pool_mgr->pools[i]);
+    }
+
+    pthread_mutex_destroy(&pool_mgr->mutex);
+    urefcount_clean(urefcount);
+    free(pool_mgr);
+}
+
+/** @internal @This allocates a new instance of the umem pool manager with
+ * per-thread magazines.
+ *
+ * @param pool0_size size (in octets) of the smallest allocatable buffer; it
+ * must be a power of 2
+ * @param nb_pools number of buffer pools to maintain
+ * @param magazine_size number of buffers kept per pool in each thread
+ * @param args maximum number of buffers to keep in each shared pool
+ * (unsigned int)
+ * @return pointer to manager, or NULL in case of error
+ */
+static struct umem_mgr *umem_pool_mgr_alloc_tls_va(size_t pool0_size,
+                                                   size_t nb_pools,
+                                                   unsigned int magazine_size,
+                                                   va_list args)
+{
+    size_t alloc_size = sizeof(struct umem_pool_tls_mgr) +
+                        sizeof(struct ulifo) * nb_pools;
+    unsigned int pools_depths[nb_pools];
+    for (unsigned int i = 0; i < nb_pools; i++) {
+        pools_depths[i] = va_arg(args, unsigned int);
+        assert(pools_depths[i] <= UINT16_MAX);
+        alloc_size += ulifo_sizeof(pools_depths[i]);
+    }
+    if (unlikely(magazine_size == 0))
+        return NULL;
+
+    struct umem_pool_tls_mgr *pool_mgr = malloc(alloc_size);
+    if (unlikely(pool_mgr == NULL))
+        return NULL;
+
+    if (unlikely(pthread_key_create(&pool_mgr->key,
+                                    umem_pool_tls_magazine_free) != 0)) {
+        free(pool_mgr);
+        return NULL;
+    }
+    pthread_mutex_init(&pool_mgr->mutex, NULL);
+    ulist_init(&pool_mgr->magazines);
+    memset(&pool_mgr->stats, 0, sizeof(pool_mgr->stats));
+
+    pool_mgr->pool0_size = pool0_size;
+    pool_mgr->nb_pools = nb_pools;
+    pool_mgr->magazine_size = magazine_size;
+
+    void *extra = (void *)pool_mgr + sizeof(struct umem_pool_tls_mgr) +
+                  sizeof(struct ulifo) * nb_pools;
+
+    for (unsigned int i = 0; i < nb_pools; i++) {
+        ulifo_init(&pool_mgr->pools[i], pools_depths[i], extra);
+        extra += ulifo_sizeof(pools_depths[i]);
+    }
+
+    urefcount_init(umem_pool_tls_mgr_to_urefcount(pool_mgr),
+                   umem_pool_tls_mgr_free);
+    pool_mgr->mgr.refcount = umem_pool_tls_mgr_to_urefcount(pool_mgr);
+    pool_mgr->mgr.umem_alloc = umem_pool_tls_alloc;
+    pool_mgr->mgr.umem_realloc = umem_pool_tls_realloc;
+    pool_mgr->mgr.umem_free = umem_pool_tls_free;
+    pool_mgr->mgr.umem_mgr_vacuum = umem_pool_tls_mgr_vacuum;
+    pool_mgr->mgr.umem_mgr_control = umem_pool_tls_mgr_control;
+
+    return umem_pool_tls_mgr_to_umem_mgr(pool_mgr);
+}
+
+/** @This allocates a new instance of the umem pool manager allocating buffers
+ * from application memory, using pools in power of 2's, with a per-thread
+ * magazine of buffers in front of each pool.
+ *
+ * @param pool0_size size (in octets) of the smallest allocatable buffer; it
+ * must be a power of 2
+ * @param nb_pools number of buffer pools to maintain, with sizes in power of
+ * 2's increments
+ * @param magazine_size number of buffers kept per pool in each thread
+ * @param ... for each pool, the maximum number of buffers to keep in the
+ * shared pool (unsigned int); larger buffers will be directly managed
+ * with malloc() and free()
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_pool_mgr_alloc_tls(size_t pool0_size, size_t nb_pools,
+                                         unsigned int magazine_size, ...)
+{
+    va_list args;
+    va_start(args, magazine_size);
+    struct umem_mgr *mgr = umem_pool_mgr_alloc_tls_va(pool0_size, nb_pools,
+                                                      magazine_size, args);
+    va_end(args);
+    return mgr;
+}
+
+/** @This allocates a new instance of the umem pool manager with per-thread
+ * magazines, with a simpler API.
+ *
+ * @param base_pools_depth number of buffers to keep in the shared pool for the
+ * smaller buffers; for larger buffers the same number is used, divided by 2,
+ * 4, or 8
+ * @param magazine_size number of buffers kept per pool in each thread
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_pool_mgr_alloc_tls_simple(uint16_t base_pools_depth,
+                                                unsigned int magazine_size)
+{
+    return umem_pool_mgr_alloc_tls(32, 18, magazine_size,
+                                   base_pools_depth, /* 32 */
+                                   base_pools_depth, /* 64 */
+                                   base_pools_depth, /* 128 */
+                                   base_pools_depth, /* 256 */
+                                   base_pools_depth, /* 512 */
+                                   base_pools_depth, /* 1 Ki */
+                                   base_pools_depth, /* 2 Ki */
+                                   base_pools_depth, /* 4 Ki */
+                                   base_pools_depth / 2, /* 8 Ki */
+                                   base_pools_depth / 2, /* 16 Ki */
+                                   base_pools_depth / 2, /* 32 Ki */
+                                   base_pools_depth / 4, /* 64 Ki */
+                                   base_pools_depth / 4, /* 128 Ki */
+                                   base_pools_depth / 4, /* 256 Ki */
+                                   base_pools_depth / 4, /* 512 Ki */
+                                   base_pools_depth / 8, /* 1 Mi */
+                                   base_pools_depth / 8, /* 2 Mi */
+                                   base_pools_depth / 8); /* 4 Mi */
+}
@@ -28,9 +28,12 @@
  * This is particularly helpful for multithreaded applications.
  */
 
+#include <config.h>
+
 #include <upipe/ubase.h>
 #include <upipe/urefcount.h>
 #include <upipe/ueventfd.h>
+#include <upipe/umem.h>
 #include <upipe/umutex.h>
 #include <upipe/uprobe.h>
 #include <upipe/uprobe_prefix.h>
@@ -53,6 +56,10 @@
 #include <errno.h>
 #include <math.h>
 #include <assert.h>
+#include <stdio.h>
+#include <sched.h>
+#include <limits.h>
+#include <sys/mman.h>
 
 /** @internal @This is the private context for pthread. */
 struct upipe_pthread_ctx {
@@ -72,8 +79,216 @@ struct upipe_pthread_ctx {
     struct ueventfd event;
     /** mutual exclusion primitives for access to the event loop */
     struct umutex *mutex;
+    /** true if the thread must be pinned */
+    bool pin;
+#ifdef CPU_SETSIZE
+    /** CPUs to pin the thread to */
+    cpu_set_t cpuset;
+#endif
+    /** SCHED_FIFO priority, or 0 */
+    int priority;
+    /** true to lock the pages of the process in memory */
+    bool mlock;
+    /** octets of stack to fault in */
+    size_t prefault_stack;
+    /** true to fill the upump pool */
+    bool prefault_pools;
+    /** memory manager whose buffers are faulted in, or NULL */
+    struct umem_mgr *umem_mgr;
+    /** size of the buffers to fault in */
+    size_t umem_size;
+    /** number of buffers to fault in */
+    unsigned int umem_nb;
 };
 
+#ifdef CPU_SETSIZE
+/** @internal @This adds the CPUs of a cpulist (for instance "2,4-7") to a
+ * CPU set.
+ *
+ * @param cpus list of CPUs
+ * @param cpuset CPU set to fill in
+ * @return false if the list is invalid or empty
+ */
+static bool upipe_pthread_parse_cpus(const char *cpus, cpu_set_t *cpuset)
+{
+    bool found = false;
+    for (;;) {
+        char *end;
+        unsigned long first = strtoul(cpus, &end, 10), last = first;
+        if (end == cpus)
+            return false;
+        cpus = end;
+        if (*cpus == '-') {
+            last = strtoul(++cpus, &end, 10);
+            if (end == cpus || last < first)
+                return false;
+            cpus = end;
+        }
+        for (unsigned long cpu = first; cpu <= last; cpu++) {
+            if (cpu >= CPU_SETSIZE)
+                return false;
+            CPU_SET(cpu, cpuset);
+            found = true;
+        }
+        if (*cpus != ',')
+            break;
+        cpus++;
+    }
+    return found && (*cpus == '\0' || *cpus == '\n');
+}
+
+/** @internal @This adds the CPUs of a NUMA node to a CPU set.
+ *
+ * @param node NUMA node
+ * @param cpuset CPU set to fill in
+ * @return false if the CPUs of the node couldn't be determined
+ */
+static bool upipe_pthread_node_cpus(int node, cpu_set_t *cpuset)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+             node);
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+        return false;
+
+    char cpus[4096];
+    bool found = fgets(cpus, sizeof(cpus), file) != NULL &&
+                 upipe_pthread_parse_cpus(cpus, cpuset);
+    fclose(file);
+    return found;
+}
+#endif
+
+/** @internal @This computes the CPUs to pin the thread to.
+ *
+ * @param pthread_ctx private context
+ * @param pthread_attr options of the thread
+ * @return false if the options are invalid
+ */
+static bool upipe_pthread_init_affinity(struct upipe_pthread_ctx *pthread_ctx,
+        const struct upipe_pthread_attr *pthread_attr)
+{
+    pthread_ctx->pin = pthread_attr->cpus != NULL || pthread_attr->node >= 0;
+    if (!pthread_ctx->pin)
+        return true;
+#ifdef CPU_SETSIZE
+    CPU_ZERO(&pthread_ctx->cpuset);
+    if (pthread_attr->cpus != NULL)
+        return upipe_pthread_parse_cpus(pthread_attr->cpus,
+                                        &pthread_ctx->cpuset);
+    return upipe_pthread_node_cpus(pthread_attr->node, &pthread_ctx->cpuset);
+#else
+    return false;
+#endif
+}
+
+/** @internal @This faults in the given size of the stack of the calling
+ * thread.
+ *
+ * @param size octets of stack to fault in
+ */
+static void __attribute__((noinline))
+    upipe_pthread_prefault_stack(size_t size)
+{
+    volatile uint8_t stack[size];
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (page_size <= 0)
+        page_size = 4096;
+    for (size_t i = 0; i < size; i += page_size)
+        stack[i] = 0;
+}
+
+/** @internal @This faults in buffers of the memory manager from the calling
+ * thread, so that they are resident when released to its pools.
+ *
+ * @param pthread_ctx private context
+ * @return false in case of allocation error
+ */
+static bool upipe_pthread_prefault_umem(struct upipe_pthread_ctx *pthread_ctx)
+{
+    struct umem *umems = malloc(pthread_ctx->umem_nb * sizeof(struct umem));
+    if (unlikely(umems == NULL))
+        return false;
+    unsigned int nb;
+    for (nb = 0; nb < pthread_ctx->umem_nb; nb++) {
+        if (unlikely(!umem_alloc(pthread_ctx->umem_mgr, &umems[nb],
+                                 pthread_ctx->umem_size)))
+            break;
+        memset(umem_buffer(&umems[nb]), 0, umem_size(&umems[nb]));
+    }
+    for (unsigned int i = 0; i < nb; i++)
+        umem_free(&umems[i]);
+    free(umems);
+    return nb == pthread_ctx->umem_nb;
+}
+
+/** @internal @This fills the upump pool of the event loop, by allocating
+ * as many pumps as it may keep.
+ *
+ * @param pthread_ctx private context
+ * @param upump_mgr event loop of the thread
+ */
+static void upipe_pthread_prefault_pools(struct upipe_pthread_ctx *pthread_ctx,
+                                         struct upump_mgr *upump_mgr)
+{
+    unsigned int depth = pthread_ctx->upump_pool_depth;
+    struct upump **upumps = malloc(depth * sizeof(struct upump *));
+    if (unlikely(upumps == NULL))
+        return;
+    unsigned int nb;
+    for (nb = 0; nb < depth; nb++) {
+        upumps[nb] = upump_alloc_idler(upump_mgr, NULL, NULL, NULL);
+        if (unlikely(upumps[nb] == NULL))
+            break;
+    }
+    for (unsigned int i = 0; i < nb; i++)
+        upump_free(upumps[i]);
+    free(upumps);
+}
+
+/** @internal @This applies the options of the calling thread before
+ * anything is allocated, so that the event loop and the buffers it
+ * allocates are node-local, and not paged out.
+ *
+ * @param pthread_ctx private context
+ */
+static void upipe_pthread_apply_attr(struct upipe_pthread_ctx *pthread_ctx)
+{
+    struct uprobe *uprobe = pthread_ctx->uprobe_pthread_upump_mgr;
+    if (pthread_ctx->pin) {
+#ifdef CPU_SETSIZE
+        if (unlikely(pthread_setaffinity_np(pthread_self(),
+                        sizeof(pthread_ctx->cpuset),
+                        &pthread_ctx->cpuset) != 0))
+#endif
+            uprobe_warn(uprobe, NULL, "unable to set thread affinity");
+    }
+
+    if (pthread_ctx->priority) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = pthread_ctx->priority;
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (unlikely(err != 0))
+            uprobe_warn_va(uprobe, NULL,
+                           "unable to set SCHED_FIFO priority %d (%s)",
+                           pthread_ctx->priority, strerror(err));
+    }
+
+    if (pthread_ctx->mlock &&
+        unlikely(mlockall(MCL_CURRENT | MCL_FUTURE) == -1))
+        uprobe_warn_va(uprobe, NULL, "unable to lock memory (%s)",
+                       strerror(errno));
+
+    if (pthread_ctx->prefault_stack)
+        upipe_pthread_prefault_stack(pthread_ctx->prefault_stack);
+
+    if (pthread_ctx->umem_mgr != NULL &&
+        unlikely(!upipe_pthread_prefault_umem(pthread_ctx)))
+        uprobe_warn(uprobe, NULL, "unable to fault in buffers");
+}
+
 /** @internal @This is the main function of the new thread.
  *
  * @param mgr pointer to a upipe pthread manager
@@ -93,6 +308,8 @@ static void *upipe_pthread_start(void *_pthread_ctx)
 
     pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, NULL);
 
+    upipe_pthread_apply_attr(pthread_ctx);
+
     /* spawn the upump manager */
     struct upump_mgr *upump_mgr =
         pthread_ctx->upump_mgr_alloc(pthread_ctx->upump_pool_depth,
@@ -105,6 +322,9 @@ static void *upipe_pthread_start(void *_pthread_ctx)
         goto upipe_pthread_start_abort;
     }
 
+    if (pthread_ctx->prefault_pools)
+        upipe_pthread_prefault_pools(pthread_ctx, upump_mgr);
+
     int err =
         uprobe_pthread_upump_mgr_set(pthread_ctx->uprobe_pthread_upump_mgr,
                                      upump_mgr);
@@ -150,11 +370,12 @@ static void upipe_pthread_stop(struct upump *upump)
     pthread_join(pthread_ctx->pthread_id, NULL);
     ueventfd_clean(&pthread_ctx->event);
     umutex_release(pthread_ctx->mutex);
+    umem_mgr_release(pthread_ctx->umem_mgr);
     free(pthread_ctx);
 }
 
 /** @This returns a management structure for transfer pipes, using a new
- * pthread. You would need one management structure per target thread.
+ * pthread configured with the given options.
  *
  * @param queue_length maximum length of the internal queue of commands
  * @param msg_pool_depth maximum number of messages in the pool
@@ -167,19 +388,30 @@ static void upipe_pthread_stop(struct upump *upump)
  * @param mutex mutual exclusion pimitives to access the event loop, or NULL
  * @param pthread_id_p reference to created thread ID (may be NULL)
  * @param attr pthread attributes
- * @return pointer to xfer manager
+ * @param pthread_attr options of the thread
+ * @return pointer to xfer manager, or NULL in case of error or invalid
+ * options
  */
-struct upipe_mgr *upipe_pthread_xfer_mgr_alloc(uint8_t queue_length,
+struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_attr(uint8_t queue_length,
         uint16_t msg_pool_depth, struct uprobe *uprobe_pthread_upump_mgr,
         upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
         uint16_t upump_blocker_pool_depth, struct umutex *mutex,
-        pthread_t *pthread_id_p, const pthread_attr_t *restrict attr)
+        pthread_t *pthread_id_p, const pthread_attr_t *restrict attr,
+        const struct upipe_pthread_attr *pthread_attr)
 {
+    if (pthread_attr->priority &&
+        (pthread_attr->priority < sched_get_priority_min(SCHED_FIFO) ||
+         pthread_attr->priority > sched_get_priority_max(SCHED_FIFO)))
+        goto upipe_pthread_xfer_mgr_alloc_err1;
+
     struct upipe_pthread_ctx *pthread_ctx =
         malloc(sizeof(struct upipe_pthread_ctx));
     if (unlikely(pthread_ctx == NULL))
         goto upipe_pthread_xfer_mgr_alloc_err1;
 
+    if (unlikely(!upipe_pthread_init_affinity(pthread_ctx, pthread_attr)))
+        goto upipe_pthread_xfer_mgr_alloc_err2;
+
     if (unlikely(!ueventfd_init(&pthread_ctx->event, false)))
         goto upipe_pthread_xfer_mgr_alloc_err2;
 
@@ -207,6 +439,13 @@ struct upipe_mgr *upipe_pthread_xfer_mgr_alloc(uint8_t queue_length,
     pthread_ctx->upump_pool_depth = upump_pool_depth;
     pthread_ctx->upump_blocker_pool_depth = upump_blocker_pool_depth;
     pthread_ctx->mutex = umutex_use(mutex);
+    pthread_ctx->priority = pthread_attr->priority;
+    pthread_ctx->mlock = pthread_attr->mlock;
+    pthread_ctx->prefault_stack = pthread_attr->prefault_stack;
+    pthread_ctx->prefault_pools = pthread_attr->prefault_pools;
+    pthread_ctx->umem_mgr = umem_mgr_use(pthread_attr->umem_mgr);
+    pthread_ctx->umem_size = pthread_attr->umem_size;
+    pthread_ctx->umem_nb = pthread_attr->umem_nb;
 
     if (unlikely(pthread_create(&pthread_ctx->pthread_id, attr,
                                 upipe_pthread_start, pthread_ctx) != 0))
@@ -218,6 +457,7 @@ struct upipe_mgr *upipe_pthread_xfer_mgr_alloc(uint8_t queue_length,
     return xfer_mgr;
 
 upipe_pthread_xfer_mgr_alloc_err5:
+    umem_mgr_release(pthread_ctx->umem_mgr);
     umutex_release(mutex);
     upipe_mgr_release(pthread_ctx->xfer_mgr);
     upipe_mgr_release(xfer_mgr);
@@ -231,3 +471,260 @@ upipe_pthread_xfer_mgr_alloc_err1:
     uprobe_release(uprobe_pthread_upump_mgr);
     return NULL;
 }
+
+/** @This returns a management structure for transfer pipes, using a new
+ * pthread pinned to a CPU or to the CPUs of a NUMA node.
+ *
+ * @param queue_length maximum length of the internal queue of commands
+ * @param msg_pool_depth maximum number of messages in the pool
+ * @param uprobe_pthread_upump_mgr pointer to optional probe, that will be set
+ * with the created upump_mgr
+ * @param upump_mgr_alloc alloc function provided by the upump manager
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @param mutex mutual exclusion pimitives to access the event loop, or NULL
+ * @param pthread_id_p reference to created thread ID (may be NULL)
+ * @param attr pthread attributes
+ * @param cpu CPU to pin the thread to, or -1
+ * @param node NUMA node to pin the thread to, if cpu is -1, or -1
+ * @return pointer to xfer manager
+ */
+struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_affinity(uint8_t queue_length,
+        uint16_t msg_pool_depth, struct uprobe *uprobe_pthread_upump_mgr,
+        upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
+        uint16_t upump_blocker_pool_depth, struct umutex *mutex,
+        pthread_t *pthread_id_p, const pthread_attr_t *restrict attr,
+        int cpu, int node)
+{
+    struct upipe_pthread_attr pthread_attr;
+    upipe_pthread_attr_init(&pthread_attr);
+    char cpus[16];
+    if (cpu >= 0) {
+        snprintf(cpus, sizeof(cpus), "%d", cpu);
+        pthread_attr.cpus = cpus;
+    } else
+        pthread_attr.node = node;
+    return upipe_pthread_xfer_mgr_alloc_attr(queue_length, msg_pool_depth,
+            uprobe_pthread_upump_mgr, upump_mgr_alloc, upump_pool_depth,
+            upump_blocker_pool_depth, mutex, pthread_id_p, attr,
+            &pthread_attr);
+}
+
+/** @This returns a management structure for transfer pipes, using a new
+ * pthread. You would need one management structure per target thread.
+ *
+ * @param queue_length maximum length of the internal queue of commands
+ * @param msg_pool_depth maximum number of messages in the pool
+ * @param uprobe_pthread_upump_mgr pointer to optional probe, that will be set
+ * with the created upump_mgr
+ * @param upump_mgr_alloc alloc function provided by the upump manager
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @param mutex mutual exclusion pimitives to access the event loop, or NULL
+ * @param pthread_id_p reference to created thread ID (may be NULL)
+ * @param attr pthread attributes
+ * @return pointer to xfer manager
+ */
+struct upipe_mgr *upipe_pthread_xfer_mgr_alloc(uint8_t queue_length,
+        uint16_t msg_pool_depth, struct uprobe *uprobe_pthread_upump_mgr,
+        upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
+        uint16_t upump_blocker_pool_depth, struct umutex *mutex,
+        pthread_t *pthread_id_p, const pthread_attr_t *restrict attr)
+{
+    return upipe_pthread_xfer_mgr_alloc_affinity(queue_length,
+            msg_pool_depth, uprobe_pthread_upump_mgr, upump_mgr_alloc,
+            upump_pool_depth, upump_blocker_pool_depth, mutex, pthread_id_p,
+            attr, -1, -1);
+}
+
+/** @internal @This is the private context of a pool of xfer managers. */
+struct upipe_pthread_xfer_pool {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** public upipe manager structure */
+    struct upipe_mgr mgr;
+    /** index of the manager to try first on equal loads */
+    unsigned int next;
+    /** number of xfer managers */
+    unsigned int nb_xfer_mgrs;
+    /** xfer managers, one per thread */
+    struct upipe_mgr *xfer_mgrs[];
+};
+
+UBASE_FROM_TO(upipe_pthread_xfer_pool, upipe_mgr, upipe_mgr, mgr)
+UBASE_FROM_TO(upipe_pthread_xfer_pool, urefcount, urefcount, urefcount)
+
+/** @internal @This returns the least loaded xfer manager of the pool.
+ *
+ * @param pool private context of the pool
+ * @return pointer to xfer manager (not used)
+ */
+static struct upipe_mgr *
+    upipe_pthread_xfer_pool_least_loaded(struct upipe_pthread_xfer_pool *pool)
+{
+    struct upipe_mgr *xfer_mgr = NULL;
+    unsigned int min_load = UINT_MAX;
+    for (unsigned int i = 0; i < pool->nb_xfer_mgrs; i++) {
+        unsigned int j = (pool->next + i) % pool->nb_xfer_mgrs;
+        unsigned int load;
+        if (!ubase_check(upipe_xfer_mgr_get_load(pool->xfer_mgrs[j], &load)))
+            continue;
+        if (load < min_load) {
+            min_load = load;
+            xfer_mgr = pool->xfer_mgrs[j];
+        }
+    }
+    pool->next = (pool->next + 1) % pool->nb_xfer_mgrs;
+    return xfer_mgr != NULL ? xfer_mgr : pool->xfer_mgrs[0];
+}
+
+/** @internal @This allocates an xfer pipe on the least loaded thread.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_pthread_xfer_pool_alloc_pipe(struct upipe_mgr *mgr,
+                                                        struct uprobe *uprobe,
+                                                        uint32_t signature,
+                                                        va_list args)
+{
+    struct upipe_pthread_xfer_pool *pool =
+        upipe_pthread_xfer_pool_from_upipe_mgr(mgr);
+    struct upipe_mgr *xfer_mgr = upipe_pthread_xfer_pool_least_loaded(pool);
+    return xfer_mgr->upipe_alloc(xfer_mgr, uprobe, signature, args);
+}
+
+/** @internal @This processes pool control commands.
+ *
+ * @param mgr pointer to pool manager
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_pthread_xfer_pool_control(struct upipe_mgr *mgr,
+                                           int command, va_list args)
+{
+    struct upipe_pthread_xfer_pool *pool =
+        upipe_pthread_xfer_pool_from_upipe_mgr(mgr);
+    switch (command) {
+        case UPIPE_XFER_MGR_SET_WAIT_POLICY: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_XFER_SIGNATURE)
+            uint64_t spin = va_arg(args, uint64_t);
+            unsigned int yields = va_arg(args, unsigned int);
+            for (unsigned int i = 0; i < pool->nb_xfer_mgrs; i++)
+                UBASE_RETURN(upipe_xfer_mgr_set_wait_policy(
+                            pool->xfer_mgrs[i], spin, yields))
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_XFER_MGR_GET_LOAD: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_XFER_SIGNATURE)
+            unsigned int *load_p = va_arg(args, unsigned int *);
+            *load_p = 0;
+            for (unsigned int i = 0; i < pool->nb_xfer_mgrs; i++) {
+                unsigned int load;
+                UBASE_RETURN(upipe_xfer_mgr_get_load(pool->xfer_mgrs[i],
+                                                     &load))
+                *load_p += load;
+            }
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_XFER_MGR_SELECT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_XFER_SIGNATURE)
+            struct upipe_mgr **xfer_mgr_p = va_arg(args, struct upipe_mgr **);
+            *xfer_mgr_p =
+                upipe_mgr_use(upipe_pthread_xfer_pool_least_loaded(pool));
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_XFER_MGR_ATTACH:
+        case UPIPE_XFER_MGR_FREEZE:
+        case UPIPE_XFER_MGR_THAW:
+            return UBASE_ERR_INVALID;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This frees a pool, which makes its threads exit once all their
+ * pipes are released.
+ *
+ * @param urefcount pointer to urefcount structure
+ */
+static void upipe_pthread_xfer_pool_free(struct urefcount *urefcount)
+{
+    struct upipe_pthread_xfer_pool *pool =
+        upipe_pthread_xfer_pool_from_urefcount(urefcount);
+    for (unsigned int i = 0; i < pool->nb_xfer_mgrs; i++)
+        upipe_mgr_release(pool->xfer_mgrs[i]);
+    urefcount_clean(urefcount);
+    free(pool);
+}
+
+/** @This returns a management structure for transfer pipes, backed by a pool
+ * of new pthreads each running an event loop.
+ *
+ * @param nb_threads number of threads in the pool
+ * @param queue_length maximum length of the internal queue of commands
+ * @param msg_pool_depth maximum number of messages in the pool
+ * @param uprobe_pthread_upump_mgr pointer to optional probe, that will be set
+ * with the created upump_mgr of each thread
+ * @param upump_mgr_alloc alloc function provided by the upump manager
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @param attr pthread attributes
+ * @param pin true to pin the n-th thread to the n-th CPU
+ * @return pointer to xfer manager
+ */
+struct upipe_mgr *upipe_pthread_xfer_pool_alloc(unsigned int nb_threads,
+        uint8_t queue_length, uint16_t msg_pool_depth,
+        struct uprobe *uprobe_pthread_upump_mgr,
+        upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
+        uint16_t upump_blocker_pool_depth, const pthread_attr_t *restrict attr,
+        bool pin)
+{
+    if (unlikely(!nb_threads))
+        goto upipe_pthread_xfer_pool_alloc_err;
+
+    struct upipe_pthread_xfer_pool *pool =
+        malloc(sizeof(struct upipe_pthread_xfer_pool) +
+               nb_threads * sizeof(struct upipe_mgr *));
+    if (unlikely(pool == NULL))
+        goto upipe_pthread_xfer_pool_alloc_err;
+
+    pool->next = 0;
+    pool->nb_xfer_mgrs = 0;
+    urefcount_init(upipe_pthread_xfer_pool_to_urefcount(pool),
+                   upipe_pthread_xfer_pool_free);
+    struct upipe_mgr *mgr = upipe_pthread_xfer_pool_to_upipe_mgr(pool);
+    mgr->refcount = upipe_pthread_xfer_pool_to_urefcount(pool);
+    mgr->signature = UPIPE_XFER_SIGNATURE;
+    mgr->upipe_alloc = upipe_pthread_xfer_pool_alloc_pipe;
+    mgr->upipe_input = NULL;
+    mgr->upipe_control = NULL;
+    mgr->upipe_mgr_control = upipe_pthread_xfer_pool_control;
+
+    for (unsigned int i = 0; i < nb_threads; i++) {
+        struct upipe_mgr *xfer_mgr = upipe_pthread_xfer_mgr_alloc_affinity(
+                queue_length, msg_pool_depth,
+                uprobe_use(uprobe_pthread_upump_mgr), upump_mgr_alloc,
+                upump_pool_depth, upump_blocker_pool_depth, NULL, NULL, attr,
+                pin ? (int)i : -1, -1);
+        if (unlikely(xfer_mgr == NULL)) {
+            upipe_mgr_release(mgr);
+            goto upipe_pthread_xfer_pool_alloc_err;
+        }
+        pool->xfer_mgrs[pool->nb_xfer_mgrs++] = xfer_mgr;
+    }
+
+    uprobe_release(uprobe_pthread_upump_mgr);
+    return mgr;
+
+upipe_pthread_xfer_pool_alloc_err:
+    uprobe_release(uprobe_pthread_upump_mgr);
+    return NULL;
+}
@@ -0,0 +1,375 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short probe logging messages asynchronously from a dedicated thread
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uatomic.h>
+#include <upipe/ulist.h>
+#include <upipe/ulog.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_helper_alloc.h>
+#include <upipe-pthread/uprobe_async_log.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <stdarg.h>
+#include <inttypes.h>
+#include <assert.h>
+#include <pthread.h>
+
+/** period at which the logger thread writes pending messages, in ms */
+#define UPROBE_ASYNC_LOG_PERIOD 10
+
+/** @This is the ring buffer of messages of a thread. It has a single
+ * producer, the thread, and a single consumer, protected by the mutex of the
+ * probe. */
+struct uprobe_async_log_ring {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** pointer to the probe */
+    struct uprobe_async_log *uprobe_async_log;
+    /** index of the next message to write */
+    uatomic_uint32_t head;
+    /** index of the next message to read */
+    uatomic_uint32_t tail;
+    /** true if the thread has exited */
+    bool orphan;
+    /** messages */
+    char msgs[][UPROBE_ASYNC_LOG_MSG_SIZE];
+};
+
+UBASE_FROM_TO(uprobe_async_log_ring, uchain, uchain, uchain)
+
+/** @internal @This returns the name of a log level.
+ *
+ * @param level log level
+ * @return name of the level
+ */
+static const char *uprobe_async_log_level(enum uprobe_log_level level)
+{
+    switch (level) {
+        case UPROBE_LOG_VERBOSE: return "verbose";
+        case UPROBE_LOG_DEBUG: return "debug";
+        case UPROBE_LOG_NOTICE: return "notice";
+        case UPROBE_LOG_WARNING: return "warning";
+        case UPROBE_LOG_ERROR: return "error";
+        default: return "unknown";
+    }
+}
+
+/** @internal @This is called when a thread having a ring exits.
+ *
+ * @param opaque pointer to the ring
+ */
+static void uprobe_async_log_ring_orphan(void *opaque)
+{
+    struct uprobe_async_log_ring *ring = opaque;
+    struct uprobe_async_log *uprobe_async_log = ring->uprobe_async_log;
+    pthread_mutex_lock(&uprobe_async_log->mutex);
+    ring->orphan = true;
+    pthread_mutex_unlock(&uprobe_async_log->mutex);
+}
+
+/** @internal @This returns the ring of the current thread, allocating it if
+ * needed.
+ *
+ * @param uprobe_async_log description structure of the probe
+ * @return pointer to the ring, or NULL in case of allocation error
+ */
+static struct uprobe_async_log_ring *
+    uprobe_async_log_ring(struct uprobe_async_log *uprobe_async_log)
+{
+    struct uprobe_async_log_ring *ring =
+        pthread_getspecific(uprobe_async_log->key);
+    if (likely(ring != NULL))
+        return ring;
+
+    ring = malloc(sizeof(struct uprobe_async_log_ring) +
+                  uprobe_async_log->ring_size * UPROBE_ASYNC_LOG_MSG_SIZE);
+    if (unlikely(ring == NULL))
+        return NULL;
+    ring->uprobe_async_log = uprobe_async_log;
+    uatomic_init(&ring->head, 0);
+    uatomic_init(&ring->tail, 0);
+    ring->orphan = false;
+    if (unlikely(pthread_setspecific(uprobe_async_log->key, ring) != 0)) {
+        free(ring);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&uprobe_async_log->mutex);
+    ulist_add(&uprobe_async_log->rings, uprobe_async_log_ring_to_uchain(ring));
+    pthread_mutex_unlock(&uprobe_async_log->mutex);
+    return ring;
+}
+
+/** @internal @This frees a ring.
+ *
+ * @param ring pointer to the ring
+ */
+static void uprobe_async_log_ring_free(struct uprobe_async_log_ring *ring)
+{
+    ulist_delete(uprobe_async_log_ring_to_uchain(ring));
+    uatomic_clean(&ring->head);
+    uatomic_clean(&ring->tail);
+    free(ring);
+}
+
+/** @internal @This writes all pending messages. It must be called with the
+ * mutex held.
+ *
+ * @param uprobe_async_log description structure of the probe
+ */
+static void uprobe_async_log_drain(struct uprobe_async_log *uprobe_async_log)
+{
+    uint32_t mask = uprobe_async_log->ring_size - 1;
+    bool written = false;
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&uprobe_async_log->rings, uchain, uchain_tmp) {
+        struct uprobe_async_log_ring *ring =
+            uprobe_async_log_ring_from_uchain(uchain);
+        uint32_t tail = uatomic_load(&ring->tail);
+        uint32_t head = uatomic_load(&ring->head);
+        for ( ; tail != head; tail++) {
+            fputs(ring->msgs[tail & mask], uprobe_async_log->stream);
+            written = true;
+        }
+        uatomic_store(&ring->tail, tail);
+
+        if (ring->orphan)
+            uprobe_async_log_ring_free(ring);
+    }
+
+    uint32_t dropped = uatomic_load(&uprobe_async_log->dropped);
+    if (unlikely(dropped != uprobe_async_log->reported)) {
+        fprintf(uprobe_async_log->stream,
+                "warning: %"PRIu32" log messages dropped\n",
+                dropped - uprobe_async_log->reported);
+        uprobe_async_log->reported = dropped;
+        written = true;
+    }
+
+    if (written)
+        fflush(uprobe_async_log->stream);
+}
+
+/** @internal @This is the main function of the logger thread.
+ *
+ * @param opaque description structure of the probe
+ * @return NULL
+ */
+static void *uprobe_async_log_thread(void *opaque)
+{
+    struct uprobe_async_log *uprobe_async_log = opaque;
+
+    pthread_mutex_lock(&uprobe_async_log->mutex);
+    while (!uprobe_async_log->stop) {
+        uprobe_async_log_drain(uprobe_async_log);
+
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += UPROBE_ASYNC_LOG_PERIOD * 1000000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&uprobe_async_log->cond,
+                               &uprobe_async_log->mutex, &ts);
+    }
+    uprobe_async_log_drain(uprobe_async_log);
+    pthread_mutex_unlock(&uprobe_async_log->mutex);
+    return NULL;
+}
+
+/** @internal @This catches events thrown by pipes.
+ *
+ * @param uprobe pointer to probe
+ * @param upipe pointer to pipe throwing the event
+ * @param event event thrown
+ * @param args optional event-specific parameters
+ * @return an error code
+ */
+static int uprobe_async_log_throw(struct uprobe *uprobe, struct upipe *upipe,
+                                  int event, va_list args)
+{
+    struct uprobe_async_log *uprobe_async_log =
+        uprobe_async_log_from_uprobe(uprobe);
+    if (event != UPROBE_LOG)
+        return uprobe_throw_next(uprobe, upipe, event, args);
+
+    struct ulog *ulog = va_arg(args, struct ulog *);
+    if (uprobe_async_log->min_level > ulog->level)
+        return UBASE_ERR_NONE;
+
+    struct uprobe_async_log_ring *ring =
+        uprobe_async_log_ring(uprobe_async_log);
+    if (unlikely(ring == NULL)) {
+        uatomic_fetch_add(&uprobe_async_log->dropped, 1);
+        return UBASE_ERR_NONE;
+    }
+
+    uint32_t head = uatomic_load(&ring->head);
+    uint32_t tail = uatomic_load(&ring->tail);
+    if (unlikely(head - tail >= uprobe_async_log->ring_size)) {
+        uatomic_fetch_add(&uprobe_async_log->dropped, 1);
+        return UBASE_ERR_NONE;
+    }
+
+    char *msg = ring->msgs[head & (uprobe_async_log->ring_size - 1)];
+    size_t size = UPROBE_ASYNC_LOG_MSG_SIZE - 1;
+    int len = snprintf(msg, size, "%s: ",
+                       uprobe_async_log_level(ulog->level));
+    struct uchain *uchain;
+    ulist_foreach_reverse(&ulog->prefixes, uchain) {
+        struct ulog_pfx *ulog_pfx = ulog_pfx_from_uchain(uchain);
+        if (len < size)
+            len += snprintf(msg + len, size - len, "[%s] ", ulog_pfx->tag);
+    }
+    if (len < size)
+        len += snprintf(msg + len, size - len, "%s", ulog->msg);
+    if (len > size - 1)
+        len = size - 1;
+    msg[len++] = '\n';
+    msg[len] = '\0';
+
+    uatomic_store(&ring->head, head + 1);
+    return UBASE_ERR_NONE;
+}
+
+/** @This initializes an already allocated uprobe_async_log structure, and
+ * starts the logger thread.
+ *
+ * @param uprobe_async_log pointer to the already allocated structure
+ * @param next next probe to test if this one doesn't catch the event
+ * @param stream stdio stream to which to log the messages
+ * @param min_level level at which to log the messages
+ * @param ring_size number of messages buffered per thread
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_async_log_init(struct uprobe_async_log *uprobe_async_log,
+                                     struct uprobe *next, FILE *stream,
+                                     enum uprobe_log_level min_level,
+                                     unsigned int ring_size)
+{
+    assert(uprobe_async_log != NULL);
+    struct uprobe *uprobe = uprobe_async_log_to_uprobe(uprobe_async_log);
+    if (unlikely(stream == NULL || !ring_size))
+        return NULL;
+
+    uprobe_async_log->stream = stream;
+    uprobe_async_log->min_level = min_level;
+    uprobe_async_log->ring_size = 1;
+    while (uprobe_async_log->ring_size < ring_size)
+        uprobe_async_log->ring_size <<= 1;
+
+    if (unlikely(pthread_key_create(&uprobe_async_log->key,
+                                    uprobe_async_log_ring_orphan) != 0))
+        return NULL;
+    pthread_mutex_init(&uprobe_async_log->mutex, NULL);
+    pthread_cond_init(&uprobe_async_log->cond, NULL);
+    ulist_init(&uprobe_async_log->rings);
+    uprobe_async_log->stop = false;
+    uatomic_init(&uprobe_async_log->dropped, 0);
+    uprobe_async_log->reported = 0;
+
+    if (unlikely(pthread_create(&uprobe_async_log->thread, NULL,
+                                uprobe_async_log_thread,
+                                uprobe_async_log) != 0)) {
+        uatomic_clean(&uprobe_async_log->dropped);
+        pthread_cond_destroy(&uprobe_async_log->cond);
+        pthread_mutex_destroy(&uprobe_async_log->mutex);
+        pthread_key_delete(uprobe_async_log->key);
+        return NULL;
+    }
+
+    uprobe_init(uprobe, uprobe_async_log_throw, next);
+    uprobe->log_level = min_level;
+    return uprobe;
+}
+
+/** @This stops the logger thread after it has written all pending messages,
+ * and cleans a uprobe_async_log structure.
+ *
+ * @param uprobe_async_log structure to clean
+ */
+void uprobe_async_log_clean(struct uprobe_async_log *uprobe_async_log)
+{
+    assert(uprobe_async_log != NULL);
+    struct uprobe *uprobe = uprobe_async_log_to_uprobe(uprobe_async_log);
+
+    pthread_mutex_lock(&uprobe_async_log->mutex);
+    uprobe_async_log->stop = true;
+    pthread_cond_signal(&uprobe_async_log->cond);
+    pthread_mutex_unlock(&uprobe_async_log->mutex);
+    pthread_join(uprobe_async_log->thread, NULL);
+
+    /* no thread may log anymore */
+    pthread_key_delete(uprobe_async_log->key);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&uprobe_async_log->rings, uchain, uchain_tmp)
+        uprobe_async_log_ring_free(uprobe_async_log_ring_from_uchain(uchain));
+
+    uatomic_clean(&uprobe_async_log->dropped);
+    pthread_cond_destroy(&uprobe_async_log->cond);
+    pthread_mutex_destroy(&uprobe_async_log->mutex);
+    uprobe_clean(uprobe);
+}
+
+/** @This waits until all the messages logged so far have been written.
+ *
+ * @param uprobe pointer to probe
+ */
+void uprobe_async_log_flush(struct uprobe *uprobe)
+{
+    struct uprobe_async_log *uprobe_async_log =
+        uprobe_async_log_from_uprobe(uprobe);
+    pthread_mutex_lock(&uprobe_async_log->mutex);
+    uprobe_async_log_drain(uprobe_async_log);
+    pthread_mutex_unlock(&uprobe_async_log->mutex);
+}
+
+/** @This returns the number of messages dropped because a ring was full.
+ *
+ * @param uprobe pointer to probe
+ * @return number of dropped messages
+ */
+unsigned int uprobe_async_log_get_dropped(struct uprobe *uprobe)
+{
+    struct uprobe_async_log *uprobe_async_log =
+        uprobe_async_log_from_uprobe(uprobe);
+    return uatomic_load(&uprobe_async_log->dropped);
+}
+
+#define ARGS_DECL struct uprobe *next, FILE *stream,                        \
+                  enum uprobe_log_level min_level, unsigned int ring_size
+#define ARGS next, stream, min_level, ring_size
+UPROBE_HELPER_ALLOC(uprobe_async_log)
+#undef ARGS
+#undef ARGS_DECL
@@ -151,6 +151,10 @@ struct uprobe *uprobe_pthread_upump_mgr_init(
                                     uprobe_pthread_upump_mgr_destr) != 0))
         return NULL;
     uprobe_init(uprobe, uprobe_pthread_upump_mgr_throw, next);
+    uprobe->log_forward = true;
+    uprobe->events = UPROBE_EVENT_BIT(UPROBE_NEED_UPUMP_MGR) |
+        UPROBE_EVENT_BIT(UPROBE_FREEZE_UPUMP_MGR) |
+        UPROBE_EVENT_BIT(UPROBE_THAW_UPUMP_MGR);
     return uprobe;
 }
 
@@ -70,13 +70,38 @@ Thumbnail::Thumbnail(const char *url)
 {
     QUrl qurl;
     this->url = url;
+    this->last = NULL;
+    this->dirty = true;
     if (!strncmp(url,"http",4)) {
         qurl = QUrl(this->url);
     } else {
         qurl = QUrl::fromLocalFile(this->url);
     }
 
-    view.load(qurl);
+    /* without a view, the page signals its repaints */
+    QObject::connect(&page, SIGNAL(repaintRequested(const QRect &)),
+                     this, SLOT(invalidate()));
+    QObject::connect(&page, SIGNAL(loadFinished(bool)),
+                     this, SLOT(invalidate()));
+    page.mainFrame()->load(qurl);
+}
+
+/** @This is the destructor of the Thumbnail
+ *
+ */
+Thumbnail::~Thumbnail()
+{
+    if (last != NULL)
+        uref_free(last);
+}
+
+/** @This marks the page as changed, so that it is rendered on the next
+ * timer tick
+ *
+ */
+void Thumbnail::invalidate()
+{
+    dirty = true;
 }
 
 /** @This set the uref_mgr of the Thumbnail
@@ -142,7 +167,9 @@ void Thumbnail::setV(int V)
     this->V = V;
 }
 
-/** @This is the rendering function of the Thumbnail
+/** @This is the rendering function of the Thumbnail. The page is only
+ * rendered when it requested a repaint, otherwise the last picture is
+ * output again.
  *
  */
 void Thumbnail::render()
@@ -153,28 +180,37 @@ void Thumbnail::render()
         return;
     }
 
+    if (!dirty && last != NULL) {
+        struct uref *uref = uref_dup(last);
+        if (uref != NULL)
+            uqueue_push(uqueue, uref);
+        return;
+    }
+
+    if (last == NULL || page.viewportSize() != QSize(H, V)) {
+        page.setViewportSize(QSize(H, V));
+
+        QPalette palette = page.palette();
+        palette.setBrush(QPalette::Background, Qt::transparent);
+        page.setPalette(palette);
+    }
+
     size_t h, v, stride;
     uint8_t hsub, vsub, macropixel_size, macropixel;
     uint8_t *data;
     struct uref *uref = uref_pic_alloc(this->uref_mgr, this->ubuf_mgr, H, V);
+    if (uref == NULL)
+        return;
     uref_pic_size(uref, &h, &v, &macropixel);
     uref_pic_plane_size(uref, "b8g8r8a8", &stride, &hsub, &vsub, &macropixel_size);
     uref_pic_plane_write(uref, "b8g8r8a8", 0, 0, -1, -1, &data);
-    QSize S  = QSize(H, V);
-    view.resize(S);
-
-    QPalette palette = view.palette();
-    palette.setBrush(QPalette::Background, Qt::transparent);
-    view.page()->setPalette(palette);
-    view.setAttribute(Qt::WA_OpaquePaintEvent, false);
-    view.setAttribute(Qt::WA_NoSystemBackground, false);
-    view.setAttribute(Qt::WA_TranslucentBackground, true);
-    view.setAutoFillBackground(false);
 
+    /* the page is painted straight into the picture buffer */
+    dirty = false;
     QImage image = QImage (data, h, v, stride, QImage::Format_ARGB32);
     image.fill(Qt::transparent);
     QPainter painter(&image);
-    view.render(&painter);
+    page.mainFrame()->render(&painter);
     painter.end();
 
 #if 0
@@ -182,5 +218,9 @@ void Thumbnail::render()
 #endif
 
     uref_pic_plane_unmap(uref, "b8g8r8a8", 0, 0, -1, -1);
+
+    if (last != NULL)
+        uref_free(last);
+    last = uref_dup(uref);
     uqueue_push(uqueue, uref);
 }
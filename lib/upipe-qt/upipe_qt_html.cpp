@@ -278,6 +278,8 @@ static int upipe_qt_html_check(struct upipe *upipe, struct uref *flow_format)
         uref_pic_flow_add_plane(flow_format, 1, 1, 4, "b8g8r8a8");
         uref_pic_flow_set_hsize(flow_format, upipe_qt_html->H);
         uref_pic_flow_set_vsize(flow_format, upipe_qt_html->V);
+        /* lines aligned for the raster engine painting into the buffer */
+        uref_pic_flow_set_align(flow_format, 16);
 
         if (unlikely(flow_format == NULL)) {
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
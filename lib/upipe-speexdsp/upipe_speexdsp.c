@@ -100,6 +100,8 @@ struct upipe_speexdsp {
 
     /** current drift rate */
     struct urational drift_rate;
+    /** drift rate used when buffers carry no rate attribute */
+    struct urational default_drift_rate;
 
     /** resampling quality */
     int quality;
@@ -133,9 +135,10 @@ static bool upipe_speexdsp_handle(struct upipe *upipe, struct uref *uref,
 
     struct urational drift_rate;
     if (!ubase_check(uref_clock_get_rate(uref, &drift_rate)))
-        drift_rate = (struct urational){ 1, 1 };
+        drift_rate = upipe_speexdsp->default_drift_rate;
 
-    /* reinitialize resampler when drift rate changes */
+    /* update the ratio when drift rate changes, speex keeps the filter
+     * memory so that this does not cause discontinuities */
     if (urational_cmp(&drift_rate, &upipe_speexdsp->drift_rate)) {
         upipe_speexdsp->drift_rate = drift_rate;
         spx_uint32_t ratio_num = drift_rate.den;
@@ -159,7 +162,11 @@ static bool upipe_speexdsp_handle(struct upipe *upipe, struct uref *uref,
         return true;
     }
 
-    struct ubuf *ubuf = ubuf_sound_alloc(upipe_speexdsp->ubuf_mgr, size + 10);
+    /* output holds size * num / den samples, plus margin for rounding
+     * and the filter phase */
+    size_t out_size = size * upipe_speexdsp->drift_rate.num /
+        upipe_speexdsp->drift_rate.den + 10;
+    struct ubuf *ubuf = ubuf_sound_alloc(upipe_speexdsp->ubuf_mgr, out_size);
     if (!ubuf)
         return false;
 
@@ -170,7 +177,7 @@ static bool upipe_speexdsp_handle(struct upipe *upipe, struct uref *uref,
     ubuf_sound_write_void(ubuf, 0, -1, &out, 1);
 
     spx_uint32_t in_len = size;         /* input size */
-    spx_uint32_t out_len = size + 10;   /* available output size */
+    spx_uint32_t out_len = out_size;    /* available output size */
 
     int err;
 
@@ -410,6 +417,23 @@ static int upipe_speexdsp_control(struct upipe *upipe, int command, va_list args
             return UBASE_ERR_NONE;
         }
 
+        case UPIPE_SPEEXDSP_GET_DRIFT_RATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SPEEXDSP_SIGNATURE)
+            struct urational *drift_rate_p = va_arg(args, struct urational *);
+            *drift_rate_p = upipe_speexdsp->default_drift_rate;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SPEEXDSP_SET_DRIFT_RATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SPEEXDSP_SIGNATURE)
+            struct urational drift_rate = va_arg(args, struct urational);
+            if (drift_rate.num <= 0 || !drift_rate.den ||
+                drift_rate.num > UINT32_MAX || drift_rate.den > UINT32_MAX)
+                return UBASE_ERR_INVALID;
+            urational_simplify(&drift_rate);
+            upipe_speexdsp->default_drift_rate = drift_rate;
+            return UBASE_ERR_NONE;
+        }
+
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -436,6 +460,7 @@ static struct upipe *upipe_speexdsp_alloc(struct upipe_mgr *mgr,
 
     upipe_speexdsp->ctx = NULL;
     upipe_speexdsp->drift_rate = (struct urational){ 0, 0 };
+    upipe_speexdsp->default_drift_rate = (struct urational){ 1, 1 };
     upipe_speexdsp->quality = SPEEX_RESAMPLER_QUALITY_MAX;
 
     upipe_speexdsp_init_urefcount(upipe);
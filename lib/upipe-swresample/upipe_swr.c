@@ -118,6 +118,17 @@ struct upipe_swr {
     /** output format */
     enum AVSampleFormat out_fmt;
 
+    /** number of samples per output block, or 0 */
+    unsigned int block_size;
+    /** uref of the block being filled */
+    struct uref *block_uref;
+    /** number of samples in the block being filled */
+    size_t block_fill;
+    /** number of samples allocated for the block being filled */
+    size_t block_alloc;
+    /** delay of the first samples of the block being filled */
+    uint64_t block_delay;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -133,6 +144,51 @@ UPIPE_HELPER_UBUF_MGR(upipe_swr, ubuf_mgr, flow_format, ubuf_mgr_request,
                       upipe_swr_unregister_output_request)
 UPIPE_HELPER_INPUT(upipe_swr, urefs, nb_urefs, max_urefs, blockers, upipe_swr_handle)
 
+/** @internal @This outputs converted samples.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure carrying the converted samples
+ * @param samples number of converted samples
+ * @param delay delay of the first sample in the resampler
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_swr_output_samples(struct upipe *upipe, struct uref *uref,
+                                     size_t samples, uint64_t delay,
+                                     struct upump **upump_p)
+{
+    /* set new samples count and resize ubuf */
+    uref_sound_flow_set_samples(uref, samples);
+    uref_sound_resize(uref, 0, samples);
+
+    /* set new pts and rebase */
+    uint64_t pts;
+    if (likely(ubase_check(uref_clock_get_pts_sys(uref, &pts))))
+        uref_clock_set_pts_sys(uref, pts - delay);
+    if (likely(ubase_check(uref_clock_get_pts_prog(uref, &pts))))
+        uref_clock_set_pts_prog(uref, pts - delay);
+    if (likely(ubase_check(uref_clock_get_pts_orig(uref, &pts))))
+        uref_clock_set_pts_orig(uref, pts - delay);
+
+    upipe_swr_output(upipe, uref, upump_p);
+}
+
+/** @internal @This outputs the block being filled, if any.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_swr_flush(struct upipe *upipe, struct upump **upump_p)
+{
+    struct upipe_swr *upipe_swr = upipe_swr_from_upipe(upipe);
+    struct uref *uref = upipe_swr->block_uref;
+    if (uref == NULL)
+        return;
+
+    upipe_swr->block_uref = NULL;
+    upipe_swr_output_samples(upipe, uref, upipe_swr->block_fill,
+                             upipe_swr->block_delay, upump_p);
+}
+
 /** @internal @This handles data.
  *
  * @param upipe description structure of the pipe
@@ -146,6 +202,7 @@ static bool upipe_swr_handle(struct upipe *upipe, struct uref *uref,
     struct upipe_swr *upipe_swr = upipe_swr_from_upipe(upipe);
     const char *def;
     if (unlikely(ubase_check(uref_flow_get_def(uref, &def)))) {
+        upipe_swr_flush(upipe, upump_p);
         upipe_swr_store_flow_def(upipe, NULL);
 
         uref_sound_flow_get_planes(uref, &upipe_swr->in_planes);
@@ -231,23 +288,39 @@ static bool upipe_swr_handle(struct upipe *upipe, struct uref *uref,
         return true;
     }
 
-    /* allocate output ubuf */
+    /* allocate output ubuf, or append to the block being filled */
     out_planes = upipe_swr->out_planes ?
                   upipe_swr->out_planes : upipe_swr->in_planes;
 
-    ubuf = ubuf_sound_alloc(upipe_swr->ubuf_mgr, out_samples);
-    if (unlikely(!ubuf)) {
-        uref_sound_unmap(uref, 0, -1, upipe_swr->in_planes);
-        uref_free(uref);
-        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        return true;
+    if (upipe_swr->block_uref != NULL &&
+        upipe_swr->block_fill + out_samples > upipe_swr->block_alloc)
+        upipe_swr_flush(upipe, upump_p);
+
+    size_t offset = 0;
+    if (upipe_swr->block_uref != NULL) {
+        ubuf = upipe_swr->block_uref->ubuf;
+        offset = upipe_swr->block_fill;
+    } else {
+        size_t alloc = out_samples;
+        if (upipe_swr->block_size > alloc)
+            alloc = upipe_swr->block_size;
+        ubuf = ubuf_sound_alloc(upipe_swr->ubuf_mgr, alloc);
+        if (unlikely(!ubuf)) {
+            uref_sound_unmap(uref, 0, -1, upipe_swr->in_planes);
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return true;
+        }
+        upipe_swr->block_alloc = alloc;
     }
 
     uint8_t *out_buf[out_planes];
-    if (unlikely(!ubase_check(ubuf_sound_write_uint8_t(ubuf, 0, -1, out_buf,
-                                                             out_planes)))) {
+    if (unlikely(!ubase_check(ubuf_sound_write_uint8_t(ubuf, offset,
+                                                       out_samples, out_buf,
+                                                       out_planes)))) {
         upipe_err(upipe, "could not write uref, dropping samples");
-        ubuf_free(ubuf);
+        if (upipe_swr->block_uref == NULL)
+            ubuf_free(ubuf);
         uref_sound_unmap(uref, 0, -1, upipe_swr->in_planes);
         uref_free(uref);
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
@@ -258,32 +331,40 @@ static bool upipe_swr_handle(struct upipe *upipe, struct uref *uref,
     ret = swr_convert(upipe_swr->swr, out_buf, out_samples,
                                       in_buf, in_samples);
 
-    ubuf_sound_unmap(ubuf, 0, -1, out_planes);
+    ubuf_sound_unmap(ubuf, offset, out_samples, out_planes);
     uref_sound_unmap(uref, 0, -1, upipe_swr->in_planes);
-    ubuf_free(uref_detach_ubuf(uref));
-    uref_attach_ubuf(uref, ubuf);
 
-    if (ret < 0) {
-        upipe_err(upipe, "error during swresample conversion");
+    if (upipe_swr->block_uref != NULL) {
+        /* appended to the block being filled */
         uref_free(uref);
-        return true;
-    }
-    out_samples = ret;
+        if (ret < 0) {
+            upipe_err(upipe, "error during swresample conversion");
+            return true;
+        }
+        upipe_swr->block_fill += ret;
+    } else {
+        ubuf_free(uref_detach_ubuf(uref));
+        uref_attach_ubuf(uref, ubuf);
+
+        if (ret < 0) {
+            upipe_err(upipe, "error during swresample conversion");
+            uref_free(uref);
+            return true;
+        }
 
-    /* set new samples count and resize ubuf */
-    uref_sound_flow_set_samples(uref, out_samples);
-    uref_sound_resize(uref, 0, out_samples);
+        if (!upipe_swr->block_size) {
+            upipe_swr_output_samples(upipe, uref, ret, delay, upump_p);
+            return true;
+        }
 
-    /* set new pts and rebase */
-    uint64_t pts;
-    if (likely(ubase_check(uref_clock_get_pts_sys(uref, &pts))))
-        uref_clock_set_pts_sys(uref, pts - delay);
-    if (likely(ubase_check(uref_clock_get_pts_prog(uref, &pts))))
-        uref_clock_set_pts_prog(uref, pts - delay);
-    if (likely(ubase_check(uref_clock_get_pts_orig(uref, &pts))))
-        uref_clock_set_pts_orig(uref, pts - delay);
+        /* start a new block */
+        upipe_swr->block_uref = uref;
+        upipe_swr->block_fill = ret;
+        upipe_swr->block_delay = delay;
+    }
 
-    upipe_swr_output(upipe, uref, upump_p);
+    if (upipe_swr->block_fill >= upipe_swr->block_size)
+        upipe_swr_flush(upipe, upump_p);
     return true;
 }
 
@@ -373,6 +454,22 @@ static int upipe_swr_set_flow_def(struct upipe *upipe, struct uref *flow_def)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the number of samples per output block.
+ *
+ * @param upipe description structure of the pipe
+ * @param block_size number of samples per output block, or 0
+ * @return an error code
+ */
+static int _upipe_swr_set_block_size(struct upipe *upipe,
+                                     unsigned int block_size)
+{
+    struct upipe_swr *upipe_swr = upipe_swr_from_upipe(upipe);
+    upipe_swr_flush(upipe, NULL);
+    upipe_swr->block_size = block_size;
+    upipe_dbg_va(upipe, "setting block size to %u", block_size);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a file source pipe, and
  * checks the status of the pipe afterwards.
  *
@@ -409,6 +506,18 @@ static int upipe_swr_control(struct upipe *upipe, int command, va_list args)
             return upipe_swr_set_flow_def(upipe, flow);
         }
 
+        case UPIPE_SWR_SET_BLOCK_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWR_SIGNATURE)
+            unsigned int block_size = va_arg(args, unsigned int);
+            return _upipe_swr_set_block_size(upipe, block_size);
+        }
+        case UPIPE_SWR_GET_BLOCK_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWR_SIGNATURE)
+            unsigned int *block_size_p = va_arg(args, unsigned int *);
+            *block_size_p = upipe_swr_from_upipe(upipe)->block_size;
+            return UBASE_ERR_NONE;
+        }
+
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -438,6 +547,11 @@ static struct upipe *upipe_swr_alloc(struct upipe_mgr *mgr,
     upipe_swr->out_chan = 0;
     upipe_swr->out_planes = 0;
     upipe_swr->out_fmt = AV_SAMPLE_FMT_NONE;
+    upipe_swr->block_size = 0;
+    upipe_swr->block_uref = NULL;
+    upipe_swr->block_fill = 0;
+    upipe_swr->block_alloc = 0;
+    upipe_swr->block_delay = 0;
 
     /* get sample format */
     const char *def = "(none)";
@@ -510,6 +624,7 @@ static struct upipe *upipe_swr_alloc(struct upipe_mgr *mgr,
 static void upipe_swr_free(struct upipe *upipe)
 {
     struct upipe_swr *upipe_swr = upipe_swr_from_upipe(upipe);
+    upipe_swr_flush(upipe, NULL);
     if (likely(upipe_swr->swr))
         swr_free(&upipe_swr->swr);
 
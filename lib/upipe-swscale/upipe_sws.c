@@ -57,8 +57,15 @@
 #include <assert.h>
 
 #include <libavutil/opt.h>
+#include <libavutil/frame.h>
+#include <libavutil/buffer.h>
 #include <libswscale/swscale.h>
 
+#if LIBSWSCALE_VERSION_INT >= AV_VERSION_INT(6, 1, 100)
+/** libswscale is able to scale slices of a frame in parallel */
+#define SWS_SLICE_THREADS
+#endif
+
 /** @hidden */
 static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
                              struct upump **upump_p);
@@ -122,6 +129,17 @@ struct upipe_sws {
     /** true if the we already tried to set the colorspace, but failed at it */
     bool colorspace_invalid;
 
+    /** number of slice threads, 0 for one per CPU, 1 to disable */
+    unsigned int threads;
+#ifdef SWS_SLICE_THREADS
+    /** true if the conversion context was initialized for slice threads */
+    bool convert_threaded[3];
+    /** source frame given to libswscale */
+    AVFrame *src_frame;
+    /** destination frame given to libswscale */
+    AVFrame *dst_frame;
+#endif
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -163,6 +181,186 @@ static int upipe_sws_convert_color(struct upipe *upipe, struct uref *flow_def)
     return colorspace;
 }
 
+#ifdef SWS_SLICE_THREADS
+/** @internal @This is called when libswscale releases a plane, which is
+ * owned by the ubuf.
+ *
+ * @param opaque unused
+ * @param data plane
+ */
+static void upipe_sws_plane_free(void *opaque, uint8_t *data)
+{
+}
+
+/** @internal @This allocates a conversion context using slice threads.
+ *
+ * @param upipe description structure of the pipe
+ * @param i index of the context
+ * @param input_hsize horizontal size of the source
+ * @param input_vsize vertical size of the source
+ * @param output_hsize horizontal size of the destination
+ * @param output_vsize vertical size of the destination
+ * @return pointer to the context, or NULL in case of error
+ */
+static struct SwsContext *upipe_sws_get_threaded_context(struct upipe *upipe,
+        int i, int input_hsize, int input_vsize,
+        int output_hsize, int output_vsize)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+    struct SwsContext *ctx = upipe_sws->convert_ctx[i];
+    const char *const options[] = {
+        "srcw", "srch", "src_format", "dstw", "dsth", "dst_format",
+        "sws_flags", "threads"
+    };
+    int64_t values[] = {
+        input_hsize, input_vsize, upipe_sws->input_pix_fmt,
+        output_hsize, output_vsize, upipe_sws->output_pix_fmt,
+        upipe_sws->flags, upipe_sws->threads
+    };
+    int j;
+
+    if (ctx != NULL && upipe_sws->convert_threaded[i]) {
+        for (j = 0; j < UBASE_ARRAY_SIZE(options); j++) {
+            int64_t value;
+            if (av_opt_get_int(ctx, options[j], 0, &value) < 0 ||
+                value != values[j])
+                break;
+        }
+        if (j == UBASE_ARRAY_SIZE(options))
+            return ctx;
+    }
+
+    struct SwsContext *new_ctx = sws_alloc_context();
+    if (unlikely(new_ctx == NULL))
+        goto upipe_sws_get_threaded_context_err;
+    for (j = 0; j < UBASE_ARRAY_SIZE(options); j++)
+        av_opt_set_int(new_ctx, options[j], values[j], 0);
+
+    /* keep chroma siting */
+    if (ctx != NULL) {
+        int64_t value;
+        if (av_opt_get_int(ctx, "src_v_chr_pos", 0, &value) >= 0)
+            av_opt_set_int(new_ctx, "src_v_chr_pos", value, 0);
+        if (av_opt_get_int(ctx, "dst_v_chr_pos", 0, &value) >= 0)
+            av_opt_set_int(new_ctx, "dst_v_chr_pos", value, 0);
+    }
+
+    if (unlikely(sws_init_context(new_ctx, NULL, NULL) < 0)) {
+        sws_freeContext(new_ctx);
+        goto upipe_sws_get_threaded_context_err;
+    }
+    sws_freeContext(ctx);
+    upipe_sws->convert_threaded[i] = true;
+    return new_ctx;
+
+upipe_sws_get_threaded_context_err:
+    sws_freeContext(ctx);
+    upipe_sws->convert_threaded[i] = false;
+    return NULL;
+}
+
+/** @internal @This wraps planes into a frame given to libswscale, without
+ * copying them.
+ *
+ * @param frame frame to fill in
+ * @param planes array of planes
+ * @param strides array of strides
+ * @param hsize horizontal size
+ * @param vsize vertical size
+ * @return an error code
+ */
+static int upipe_sws_wrap_frame(AVFrame *frame, uint8_t *const *planes,
+                                const int *strides, int hsize, int vsize)
+{
+    frame->width = hsize;
+    frame->height = vsize;
+    for (int i = 0; i < UPIPE_AV_MAX_PLANES && planes[i] != NULL; i++) {
+        frame->data[i] = planes[i];
+        frame->linesize[i] = strides[i];
+        frame->buf[i] = av_buffer_create(planes[i], strides[i] * vsize,
+                                         upipe_sws_plane_free, NULL, 0);
+        if (unlikely(frame->buf[i] == NULL)) {
+            av_frame_unref(frame);
+            return UBASE_ERR_ALLOC;
+        }
+    }
+    return UBASE_ERR_NONE;
+}
+#endif
+
+/** @internal @This returns a conversion context matching the picture.
+ *
+ * @param upipe description structure of the pipe
+ * @param i index of the context
+ * @param input_hsize horizontal size of the source
+ * @param input_vsize vertical size of the source
+ * @param output_hsize horizontal size of the destination
+ * @param output_vsize vertical size of the destination
+ * @return pointer to the context, or NULL in case of error
+ */
+static struct SwsContext *upipe_sws_get_context(struct upipe *upipe, int i,
+        int input_hsize, int input_vsize, int output_hsize, int output_vsize)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+#ifdef SWS_SLICE_THREADS
+    if (upipe_sws->threads != 1)
+        return upipe_sws_get_threaded_context(upipe, i,
+                input_hsize, input_vsize, output_hsize, output_vsize);
+    upipe_sws->convert_threaded[i] = false;
+#endif
+    return sws_getCachedContext(upipe_sws->convert_ctx[i],
+                input_hsize, input_vsize, upipe_sws->input_pix_fmt,
+                output_hsize, output_vsize, upipe_sws->output_pix_fmt,
+                upipe_sws->flags, NULL, NULL, NULL);
+}
+
+/** @internal @This scales a picture or a field.
+ *
+ * @param upipe description structure of the pipe
+ * @param i index of the context
+ * @param input_planes array of source planes
+ * @param input_strides array of source strides
+ * @param input_hsize horizontal size of the source
+ * @param input_vsize vertical size of the source
+ * @param output_planes array of destination planes
+ * @param output_strides array of destination strides
+ * @param output_hsize horizontal size of the destination
+ * @param output_vsize vertical size of the destination
+ * @return number of lines output, or a negative value in case of error
+ */
+static int upipe_sws_scale(struct upipe *upipe, int i,
+        const uint8_t *const *input_planes, const int *input_strides,
+        int input_hsize, int input_vsize,
+        uint8_t *const *output_planes, const int *output_strides,
+        int output_hsize, int output_vsize)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+#ifdef SWS_SLICE_THREADS
+    if (upipe_sws->convert_threaded[i]) {
+        AVFrame *src = upipe_sws->src_frame;
+        AVFrame *dst = upipe_sws->dst_frame;
+        src->format = upipe_sws->input_pix_fmt;
+        dst->format = upipe_sws->output_pix_fmt;
+        if (unlikely(!ubase_check(upipe_sws_wrap_frame(src,
+                            (uint8_t *const *)input_planes, input_strides,
+                            input_hsize, input_vsize))))
+            return -1;
+        if (unlikely(!ubase_check(upipe_sws_wrap_frame(dst,
+                            output_planes, output_strides,
+                            output_hsize, output_vsize)))) {
+            av_frame_unref(src);
+            return -1;
+        }
+        int ret = sws_scale_frame(upipe_sws->convert_ctx[i], dst, src);
+        av_frame_unref(src);
+        av_frame_unref(dst);
+        return ret < 0 ? ret : output_vsize;
+    }
+#endif
+    return sws_scale(upipe_sws->convert_ctx[i], input_planes, input_strides,
+                     0, input_vsize, output_planes, output_strides);
+}
+
 /** @internal @This handles data.
  *
  * @param upipe description structure of the pipe
@@ -211,10 +409,9 @@ static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
 
     int i;
     for (i = 0; i < 3; i++) {
-        upipe_sws->convert_ctx[i] = sws_getCachedContext(upipe_sws->convert_ctx[i],
-                    input_hsize, input_vsize >> !!i, upipe_sws->input_pix_fmt,
-                    output_hsize, output_vsize >> !!i, upipe_sws->output_pix_fmt,
-                    upipe_sws->flags, NULL, NULL, NULL);
+        upipe_sws->convert_ctx[i] = upipe_sws_get_context(upipe, i,
+                    input_hsize, input_vsize >> !!i,
+                    output_hsize, output_vsize >> !!i);
 
         if (unlikely(upipe_sws->convert_ctx[i] == NULL)) {
             upipe_err(upipe, "sws_getContext failed");
@@ -328,14 +525,18 @@ static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
     /* fire ! */
     int ret = 0, ret2 = 1;
     if (progressive) {
-        ret = sws_scale(upipe_sws->convert_ctx[0],
-                        input_planes, input_strides, 0, input_vsize,
-                        output_planes, output_strides);
+        ret = upipe_sws_scale(upipe, 0,
+                              input_planes, input_strides,
+                              input_hsize, input_vsize,
+                              output_planes, output_strides,
+                              output_hsize, output_vsize);
     }
     else {
-        ret = sws_scale(upipe_sws->convert_ctx[1],
-                        input_planes, input_strides, 0, (input_vsize+1)/2,
-                        output_planes, output_strides);
+        ret = upipe_sws_scale(upipe, 1,
+                              input_planes, input_strides,
+                              input_hsize, (input_vsize+1)/2,
+                              output_planes, output_strides,
+                              output_hsize, (output_vsize+1)/2);
 
         for (i = 0; i < UPIPE_AV_MAX_PLANES && input_planes[i]; i++) {
                 input_planes[i] += input_strides[i] >> 1;
@@ -344,9 +545,11 @@ static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
                 output_planes[i] += output_strides[i] >> 1;
         }
 
-        ret2 = sws_scale(upipe_sws->convert_ctx[2],
-                         input_planes, input_strides, 0, input_vsize/2,
-                         output_planes, output_strides);
+        ret2 = upipe_sws_scale(upipe, 2,
+                               input_planes, input_strides,
+                               input_hsize, input_vsize/2,
+                               output_planes, output_strides,
+                               output_hsize, output_vsize/2);
     }
 
     /* unmap pictures */
@@ -431,14 +634,7 @@ static int upipe_sws_amend_ubuf_mgr(struct upipe *upipe,
     struct uref *flow_format = uref_dup(request->uref);
     UBASE_ALLOC_RETURN(flow_format);
 
-    uint64_t align;
-    if (!ubase_check(uref_pic_flow_get_align(flow_format, &align)) || !align)
-        uref_pic_flow_set_align(flow_format, 16);
-
-    if (align % 16) {
-        align = align * 16 / ubase_gcd(align, 16);
-        uref_pic_flow_set_align(flow_format, align);
-    }
+    uref_pic_flow_require_align(flow_format, 16);
 
     struct urequest ubuf_mgr_request;
     urequest_set_opaque(&ubuf_mgr_request, request);
@@ -565,6 +761,26 @@ static int _upipe_sws_set_flags(struct upipe *upipe, int flags)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the number of slice threads.
+ *
+ * @param upipe description structure of the pipe
+ * @param threads number of threads, 0 for one per CPU, 1 to disable
+ * @return an error code
+ */
+static int _upipe_sws_set_threads(struct upipe *upipe, unsigned int threads)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+#ifndef SWS_SLICE_THREADS
+    if (threads != 1) {
+        upipe_warn(upipe, "slice threads are not supported by libswscale");
+        return UBASE_ERR_EXTERNAL;
+    }
+#endif
+    upipe_sws->threads = threads;
+    upipe_dbg_va(upipe, "setting threads to %u", threads);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a file source pipe, and
  * checks the status of the pipe afterwards.
  *
@@ -612,6 +828,17 @@ static int upipe_sws_control(struct upipe *upipe, int command, va_list args)
             int flags = va_arg(args, int);
             return _upipe_sws_set_flags(upipe, flags);
         }
+        case UPIPE_SWS_GET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWS_SIGNATURE)
+            unsigned int *threads_p = va_arg(args, unsigned int *);
+            *threads_p = upipe_sws_from_upipe(upipe)->threads;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SWS_SET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWS_SIGNATURE)
+            unsigned int threads = va_arg(args, unsigned int);
+            return _upipe_sws_set_threads(upipe, threads);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -653,11 +880,25 @@ static struct upipe *upipe_sws_alloc(struct upipe_mgr *mgr,
     upipe_sws->colorspace_invalid = false;
 
     memset(upipe_sws->convert_ctx, 0, sizeof(upipe_sws->convert_ctx));
+    upipe_sws->threads = 1;
+#ifdef SWS_SLICE_THREADS
+    upipe_sws->src_frame = NULL;
+    upipe_sws->dst_frame = NULL;
+#endif
     for (int i = 0; i < 3; i++) {
         upipe_sws->convert_ctx[i] = sws_alloc_context();
         if (!upipe_sws->convert_ctx[i])
             goto fail;
+#ifdef SWS_SLICE_THREADS
+        upipe_sws->convert_threaded[i] = false;
+#endif
     }
+#ifdef SWS_SLICE_THREADS
+    upipe_sws->src_frame = av_frame_alloc();
+    upipe_sws->dst_frame = av_frame_alloc();
+    if (!upipe_sws->src_frame || !upipe_sws->dst_frame)
+        goto fail;
+#endif
 
     upipe_sws->flags = SWS_FULL_CHR_H_INP | SWS_ACCURATE_RND | SWS_LANCZOS;
 
@@ -677,6 +918,10 @@ fail:
             sws_freeContext(upipe_sws->convert_ctx[i]);
         upipe_sws->convert_ctx[i] = NULL;
     }
+#ifdef SWS_SLICE_THREADS
+    av_frame_free(&upipe_sws->src_frame);
+    av_frame_free(&upipe_sws->dst_frame);
+#endif
     uref_free(flow_def);
     upipe_sws_free_flow(upipe);
     return NULL;
@@ -694,6 +939,10 @@ static void upipe_sws_free(struct upipe *upipe)
             sws_freeContext(upipe_sws->convert_ctx[i]);
         upipe_sws->convert_ctx[i] = NULL;
     }
+#ifdef SWS_SLICE_THREADS
+    av_frame_free(&upipe_sws->src_frame);
+    av_frame_free(&upipe_sws->dst_frame);
+#endif
 
     upipe_throw_dead(upipe);
     upipe_sws_clean_input(upipe);
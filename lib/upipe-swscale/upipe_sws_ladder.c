@@ -0,0 +1,875 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe swscale module scaling a picture to several resolutions
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/ulist.h>
+#include <upipe/uprobe.h>
+#include <upipe/uref.h>
+#include <upipe/uref_attr.h>
+#include <upipe/ubuf.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/uref_pic.h>
+#include <upipe/upipe.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_dump.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_flow.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe/upipe_helper_subpipe.h>
+#include <upipe/upipe_helper_ubuf_mgr.h>
+#include <upipe-swscale/upipe_sws_ladder.h>
+#include <upipe-av/upipe_av_pixfmt.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <assert.h>
+
+#include <libswscale/swscale.h>
+
+/** @internal @This is the private context of a sws_ladder pipe. */
+struct upipe_sws_ladder {
+    /** real refcount management structure */
+    struct urefcount urefcount_real;
+    /** refcount management structure exported to the public structure */
+    struct urefcount urefcount;
+
+    /** list of output subpipes, sorted by decreasing size */
+    struct uchain outputs;
+    /** input flow definition packet */
+    struct uref *flow_def;
+    /** input pixel format */
+    enum AVPixelFormat pix_fmt;
+    /** input chroma map */
+    const char *chroma_map[UPIPE_AV_MAX_PLANES];
+    /** input colorspace */
+    int colorspace;
+    /** input color range */
+    int color_range;
+
+    /** manager to create output subpipes */
+    struct upipe_mgr sub_mgr;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_sws_ladder, upipe, UPIPE_SWS_LADDER_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_sws_ladder, urefcount, upipe_sws_ladder_no_input)
+UPIPE_HELPER_VOID(upipe_sws_ladder)
+
+UBASE_FROM_TO(upipe_sws_ladder, urefcount, urefcount_real, urefcount_real)
+
+/** @hidden */
+static void upipe_sws_ladder_free(struct urefcount *urefcount_real);
+
+/** @internal @This is the private context of an output of a sws_ladder
+ * pipe. */
+struct upipe_sws_ladder_output {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** structure for double-linked lists */
+    struct uchain uchain;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** flow definition packet */
+    struct uref *flow_def;
+    /** attributes / parameters from application */
+    struct uref *flow_def_params;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** ubuf manager */
+    struct ubuf_mgr *ubuf_mgr;
+    /** flow format packet */
+    struct uref *flow_format;
+    /** ubuf manager request */
+    struct urequest ubuf_mgr_request;
+
+    /** horizontal size */
+    uint64_t hsize;
+    /** vertical size */
+    uint64_t vsize;
+    /** swscale flags */
+    int flags;
+    /** true if the output must be scaled from the source picture */
+    bool direct;
+    /** swscale image conversion context [0] for progressive, [1,2] interlaced */
+    struct SwsContext *convert_ctx[3];
+    /** output pixel format */
+    enum AVPixelFormat pix_fmt;
+    /** output chroma map */
+    const char *chroma_map[UPIPE_AV_MAX_PLANES];
+    /** output colorspace */
+    int colorspace;
+    /** output color range */
+    int color_range;
+    /** true if the we already tried to set the colorspace, but failed at it */
+    bool colorspace_invalid;
+
+    /** picture produced for the current input, if any */
+    struct uref *uref;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+/** @hidden */
+static int upipe_sws_ladder_output_check(struct upipe *upipe,
+                                         struct uref *flow_format);
+
+UPIPE_HELPER_UPIPE(upipe_sws_ladder_output, upipe,
+                   UPIPE_SWS_LADDER_OUTPUT_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_sws_ladder_output, urefcount,
+                       upipe_sws_ladder_output_free)
+UPIPE_HELPER_FLOW(upipe_sws_ladder_output, "pic.")
+UPIPE_HELPER_OUTPUT(upipe_sws_ladder_output, output, flow_def, output_state,
+                    request_list)
+UPIPE_HELPER_UBUF_MGR(upipe_sws_ladder_output, ubuf_mgr, flow_format,
+                      ubuf_mgr_request,
+                      upipe_sws_ladder_output_check,
+                      upipe_sws_ladder_output_register_output_request,
+                      upipe_sws_ladder_output_unregister_output_request)
+
+UPIPE_HELPER_SUBPIPE(upipe_sws_ladder, upipe_sws_ladder_output, output,
+                     sub_mgr, outputs, uchain)
+
+/** @internal @This converts Upipe color space to sws color space.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return sws color space
+ */
+static int upipe_sws_ladder_convert_color(struct upipe *upipe,
+                                          struct uref *flow_def)
+{
+    int colorspace = -1;
+    const char *matrix_coefficients;
+    if (ubase_check(uref_pic_flow_get_matrix_coefficients(flow_def,
+                    &matrix_coefficients))) {
+        if (!strcmp(matrix_coefficients, "bt709"))
+            colorspace = SWS_CS_ITU709;
+        else if (!strcmp(matrix_coefficients, "fcc"))
+            colorspace = SWS_CS_FCC;
+        else if (!strcmp(matrix_coefficients, "smpte170m"))
+            colorspace = SWS_CS_SMPTE170M;
+        else if (!strcmp(matrix_coefficients, "smpte240m"))
+            colorspace = SWS_CS_SMPTE240M;
+        else
+            upipe_warn_va(upipe, "unknown color space %s", matrix_coefficients);
+    }
+    return colorspace;
+}
+
+/** @internal @This compares two outputs by decreasing size.
+ *
+ * @param uchain1 pointer to first output
+ * @param uchain2 pointer to second output
+ * @return an integer less than, equal to, or greater than zero if the first
+ * output is respectively larger than, as large as, or smaller than the second
+ */
+static int upipe_sws_ladder_output_compare(struct uchain *uchain1,
+                                           struct uchain *uchain2)
+{
+    struct upipe_sws_ladder_output *output1 =
+        upipe_sws_ladder_output_from_uchain(uchain1);
+    struct upipe_sws_ladder_output *output2 =
+        upipe_sws_ladder_output_from_uchain(uchain2);
+    uint64_t size1 = output1->hsize * output1->vsize;
+    uint64_t size2 = output2->hsize * output2->vsize;
+    return size1 > size2 ? -1 : size1 < size2 ? 1 : 0;
+}
+
+/** @internal @This builds the flow definition of an output from the input
+ * flow definition.
+ *
+ * @param upipe description structure of the output subpipe
+ */
+static void upipe_sws_ladder_output_build_flow_def(struct upipe *upipe)
+{
+    struct upipe_sws_ladder_output *output =
+        upipe_sws_ladder_output_from_upipe(upipe);
+    struct upipe_sws_ladder *ladder =
+        upipe_sws_ladder_from_sub_mgr(upipe->mgr);
+    upipe_sws_ladder_output_store_flow_def(upipe, NULL);
+    if (ladder->flow_def == NULL)
+        return;
+
+    struct uref *flow_def = uref_dup(ladder->flow_def);
+    if (unlikely(flow_def == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    uref_pic_flow_clear_format(flow_def);
+
+    uint64_t input_hsize, input_vsize;
+    if (ubase_check(uref_pic_flow_get_hsize(flow_def, &input_hsize)) &&
+        ubase_check(uref_pic_flow_get_vsize(flow_def, &input_vsize)) &&
+        (input_hsize != output->hsize || input_vsize != output->vsize)) {
+        uint64_t hsize_visible;
+        if (input_hsize != output->hsize &&
+            ubase_check(uref_pic_flow_get_hsize_visible(flow_def,
+                                                        &hsize_visible))) {
+            hsize_visible *= output->hsize;
+            hsize_visible /= input_hsize;
+            UBASE_FATAL(upipe, uref_pic_flow_set_hsize_visible(flow_def,
+                        hsize_visible))
+        }
+
+        uint64_t vsize_visible;
+        if (input_vsize != output->vsize &&
+            ubase_check(uref_pic_flow_get_vsize_visible(flow_def,
+                                                        &vsize_visible))) {
+            vsize_visible *= output->vsize;
+            vsize_visible /= input_vsize;
+            UBASE_FATAL(upipe, uref_pic_flow_set_vsize_visible(flow_def,
+                        vsize_visible))
+        }
+
+        struct urational sar;
+        if (!ubase_check(uref_pic_flow_get_sar(output->flow_def_params,
+                                               &sar)) &&
+            ubase_check(uref_pic_flow_get_sar(flow_def, &sar))) {
+            sar.num *= input_hsize * output->vsize;
+            sar.den *= input_vsize * output->hsize;
+            urational_simplify(&sar);
+            UBASE_FATAL(upipe, uref_pic_flow_set_sar(flow_def, sar))
+        }
+    }
+
+    uref_attr_import(flow_def, output->flow_def_params);
+    output->colorspace_invalid = false;
+    upipe_sws_ladder_output_require_ubuf_mgr(upipe, flow_def);
+}
+
+/** @internal @This allocates an output subpipe of a sws_ladder pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_sws_ladder_output_alloc(struct upipe_mgr *mgr,
+                                                   struct uprobe *uprobe,
+                                                   uint32_t signature,
+                                                   va_list args)
+{
+    struct uref *flow_def;
+    struct upipe *upipe = upipe_sws_ladder_output_alloc_flow(mgr,
+                            uprobe, signature, args, &flow_def);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_sws_ladder_output *output =
+        upipe_sws_ladder_output_from_upipe(upipe);
+    output->pix_fmt = upipe_av_pixfmt_from_flow_def(flow_def, NULL,
+                                                    output->chroma_map);
+    if (unlikely(output->pix_fmt == AV_PIX_FMT_NONE ||
+                 !sws_isSupportedOutput(output->pix_fmt) ||
+                 !ubase_check(uref_pic_flow_get_hsize(flow_def,
+                                                      &output->hsize)) ||
+                 !ubase_check(uref_pic_flow_get_vsize(flow_def,
+                                                      &output->vsize)) ||
+                 !output->hsize || !output->vsize)) {
+        uref_free(flow_def);
+        upipe_sws_ladder_output_free_flow(upipe);
+        return NULL;
+    }
+
+    upipe_sws_ladder_output_init_urefcount(upipe);
+    upipe_sws_ladder_output_init_output(upipe);
+    upipe_sws_ladder_output_init_ubuf_mgr(upipe);
+    upipe_sws_ladder_output_init_sub(upipe);
+    output->flow_def_params = flow_def;
+    output->flags = SWS_FULL_CHR_H_INP | SWS_ACCURATE_RND | SWS_LANCZOS;
+    output->direct = false;
+    output->colorspace_invalid = false;
+    output->uref = NULL;
+    for (int i = 0; i < 3; i++)
+        output->convert_ctx[i] = NULL;
+
+    /* keep the list of outputs sorted */
+    struct upipe_sws_ladder *ladder = upipe_sws_ladder_from_sub_mgr(mgr);
+    ulist_delete(upipe_sws_ladder_output_to_uchain(output));
+    ulist_bubble(&ladder->outputs, upipe_sws_ladder_output_to_uchain(output),
+                 upipe_sws_ladder_output_compare);
+
+    upipe_throw_ready(upipe);
+
+    output->colorspace = upipe_sws_ladder_convert_color(upipe, flow_def);
+    output->color_range =
+        ubase_check(uref_pic_flow_get_full_range(flow_def)) ? 1 : 0;
+    UBASE_FATAL(upipe, uref_pic_flow_set_align(flow_def, 16))
+
+    upipe_sws_ladder_output_build_flow_def(upipe);
+    return upipe;
+}
+
+/** @internal @This receives a provided ubuf manager.
+ *
+ * @param upipe description structure of the output subpipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_sws_ladder_output_check(struct upipe *upipe,
+                                         struct uref *flow_format)
+{
+    if (flow_format != NULL)
+        upipe_sws_ladder_output_store_flow_def(upipe, flow_format);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This finds the picture an output must be scaled from, that is
+ * the smallest picture already produced for the current input which is at
+ * least as large as the output, but not larger than the source.
+ *
+ * @param upipe description structure of the output subpipe
+ * @param src_hsize horizontal size of the source picture
+ * @param src_vsize vertical size of the source picture
+ * @return pointer to the output which produced the picture, or NULL to use
+ * the source picture
+ */
+static struct upipe_sws_ladder_output *
+    upipe_sws_ladder_output_find_src(struct upipe *upipe,
+                                     size_t src_hsize, size_t src_vsize)
+{
+    struct upipe_sws_ladder_output *output =
+        upipe_sws_ladder_output_from_upipe(upipe);
+    struct upipe_sws_ladder *ladder =
+        upipe_sws_ladder_from_sub_mgr(upipe->mgr);
+    if (output->direct)
+        return NULL;
+
+    struct uchain *uchain;
+    for (uchain = output->uchain.prev; uchain != &ladder->outputs;
+         uchain = uchain->prev) {
+        struct upipe_sws_ladder_output *src =
+            upipe_sws_ladder_output_from_uchain(uchain);
+        if (src->uref != NULL &&
+            src->hsize >= output->hsize && src->vsize >= output->vsize &&
+            src->hsize <= src_hsize && src->vsize <= src_vsize)
+            return src;
+    }
+    return NULL;
+}
+
+/** @internal @This scales a picture into a newly allocated buffer.
+ *
+ * @param upipe description structure of the output subpipe
+ * @param uref picture to scale
+ * @param pix_fmt pixel format of the picture
+ * @param chroma_map chroma map of the picture
+ * @param colorspace color space of the picture
+ * @param color_range color range of the picture
+ * @return pointer to the scaled buffer, or NULL in case of error
+ */
+static struct ubuf *upipe_sws_ladder_output_scale(struct upipe *upipe,
+        struct uref *uref, enum AVPixelFormat pix_fmt,
+        const char *const *chroma_map, int colorspace, int color_range)
+{
+    struct upipe_sws_ladder_output *output =
+        upipe_sws_ladder_output_from_upipe(upipe);
+
+    size_t input_hsize, input_vsize;
+    if (!ubase_check(uref_pic_size(uref, &input_hsize, &input_vsize, NULL))) {
+        upipe_warn(upipe, "invalid buffer received");
+        return NULL;
+    }
+
+    int progressive = ubase_check(uref_pic_get_progressive(uref)) ? 1 : 0;
+    if (unlikely(!progressive && input_vsize % 2))
+        progressive = 1;
+
+    int i;
+    for (i = 0; i < 3; i++) {
+        output->convert_ctx[i] = sws_getCachedContext(output->convert_ctx[i],
+                    input_hsize, input_vsize >> !!i, pix_fmt,
+                    output->hsize, output->vsize >> !!i, output->pix_fmt,
+                    output->flags, NULL, NULL, NULL);
+
+        if (unlikely(output->convert_ctx[i] == NULL)) {
+            upipe_err(upipe, "sws_getContext failed");
+            return NULL;
+        }
+
+        if (output->colorspace_invalid)
+            continue;
+
+        int in_full, out_full, brightness, contrast, saturation;
+        const int *inv_table, *table;
+
+        if (unlikely(sws_getColorspaceDetails(output->convert_ctx[i],
+                        (int **)&inv_table, &in_full, (int **)&table, &out_full,
+                        &brightness, &contrast, &saturation) < 0)) {
+            upipe_warn(upipe, "unable to set color space data");
+            output->colorspace_invalid = true;
+            continue;
+        }
+
+        if (colorspace != -1)
+            inv_table = sws_getCoefficients(colorspace);
+        if (color_range != -1)
+            in_full = color_range;
+        if (output->colorspace != -1)
+            table = sws_getCoefficients(output->colorspace);
+        if (output->color_range != -1)
+            out_full = output->color_range;
+
+        if (unlikely(sws_setColorspaceDetails(output->convert_ctx[i],
+                        inv_table, in_full, table, out_full,
+                        brightness, contrast, saturation) < 0)) {
+            upipe_warn(upipe, "unable to set color space data");
+            output->colorspace_invalid = true;
+        }
+    }
+
+    /* map input */
+    const uint8_t *input_planes[UPIPE_AV_MAX_PLANES + 1];
+    int input_strides[UPIPE_AV_MAX_PLANES + 1];
+    for (i = 0; i < UPIPE_AV_MAX_PLANES && chroma_map[i] != NULL; i++) {
+        const uint8_t *data;
+        size_t stride;
+        if (unlikely(!ubase_check(uref_pic_plane_read(uref, chroma_map[i],
+                                          0, 0, -1, -1, &data)) ||
+                     !ubase_check(uref_pic_plane_size(uref, chroma_map[i],
+                                          &stride, NULL, NULL, NULL)))) {
+            upipe_warn(upipe, "invalid buffer received");
+            while (--i >= 0)
+                uref_pic_plane_unmap(uref, chroma_map[i], 0, 0, -1, -1);
+            return NULL;
+        }
+        input_planes[i] = data;
+        input_strides[i] = stride * (1+!progressive);
+    }
+    for ( ; i < UPIPE_AV_MAX_PLANES + 1; i++) {
+        input_planes[i] = NULL;
+        input_strides[i] = 0;
+    }
+
+    /* allocate dest ubuf */
+    struct ubuf *ubuf = ubuf_pic_alloc(output->ubuf_mgr,
+                                       output->hsize, output->vsize);
+    if (unlikely(ubuf == NULL)) {
+        for (i = 0; i < UPIPE_AV_MAX_PLANES && chroma_map[i] != NULL; i++)
+            uref_pic_plane_unmap(uref, chroma_map[i], 0, 0, -1, -1);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
+
+    /* map output */
+    uint8_t *output_planes[UPIPE_AV_MAX_PLANES + 1];
+    int output_strides[UPIPE_AV_MAX_PLANES + 1];
+    for (i = 0; i < UPIPE_AV_MAX_PLANES && output->chroma_map[i] != NULL;
+         i++) {
+        uint8_t *data;
+        size_t stride;
+        if (unlikely(!ubase_check(ubuf_pic_plane_write(ubuf,
+                                           output->chroma_map[i],
+                                           0, 0, -1, -1, &data)) ||
+                     !ubase_check(ubuf_pic_plane_size(ubuf,
+                                          output->chroma_map[i],
+                                          &stride, NULL, NULL, NULL)))) {
+            upipe_warn(upipe, "invalid buffer allocated");
+            ubuf_free(ubuf);
+            ubuf = NULL;
+            goto upipe_sws_ladder_output_scale_unmap;
+        }
+        output_planes[i] = data;
+        output_strides[i] = stride * (1+!progressive);
+    }
+    for ( ; i < UPIPE_AV_MAX_PLANES + 1; i++) {
+        output_planes[i] = NULL;
+        output_strides[i] = 0;
+    }
+
+    /* fire ! */
+    int ret = 0, ret2 = 1;
+    if (progressive) {
+        ret = sws_scale(output->convert_ctx[0],
+                        input_planes, input_strides, 0, input_vsize,
+                        output_planes, output_strides);
+    } else {
+        ret = sws_scale(output->convert_ctx[1],
+                        input_planes, input_strides, 0, (input_vsize+1)/2,
+                        output_planes, output_strides);
+
+        for (i = 0; i < UPIPE_AV_MAX_PLANES && input_planes[i]; i++)
+            input_planes[i] += input_strides[i] >> 1;
+        for (i = 0; i < UPIPE_AV_MAX_PLANES && output_planes[i]; i++)
+            output_planes[i] += output_strides[i] >> 1;
+
+        ret2 = sws_scale(output->convert_ctx[2],
+                         input_planes, input_strides, 0, input_vsize/2,
+                         output_planes, output_strides);
+    }
+
+    for (i = 0; i < UPIPE_AV_MAX_PLANES && output->chroma_map[i] != NULL;
+         i++)
+        ubuf_pic_plane_unmap(ubuf, output->chroma_map[i], 0, 0, -1, -1);
+
+    if (unlikely(ret <= 0 || ret2 <= 0)) {
+        upipe_warn(upipe, "error during sws conversion");
+        ubuf_free(ubuf);
+        ubuf = NULL;
+    }
+
+upipe_sws_ladder_output_scale_unmap:
+    for (i = 0; i < UPIPE_AV_MAX_PLANES && chroma_map[i] != NULL; i++)
+        uref_pic_plane_unmap(uref, chroma_map[i], 0, 0, -1, -1);
+    return ubuf;
+}
+
+/** @internal @This produces the picture of an output for the current input.
+ *
+ * @param upipe description structure of the output subpipe
+ * @param uref source picture
+ */
+static void upipe_sws_ladder_output_process(struct upipe *upipe,
+                                            struct uref *uref)
+{
+    struct upipe_sws_ladder_output *output =
+        upipe_sws_ladder_output_from_upipe(upipe);
+    struct upipe_sws_ladder *ladder =
+        upipe_sws_ladder_from_sub_mgr(upipe->mgr);
+    if (unlikely(output->flow_def == NULL || output->ubuf_mgr == NULL))
+        return;
+
+    size_t src_hsize, src_vsize;
+    if (unlikely(!ubase_check(uref_pic_size(uref, &src_hsize, &src_vsize,
+                                            NULL)))) {
+        upipe_warn(upipe, "invalid buffer received");
+        return;
+    }
+
+    struct upipe_sws_ladder_output *src =
+        upipe_sws_ladder_output_find_src(upipe, src_hsize, src_vsize);
+    struct ubuf *ubuf;
+    if (src != NULL) {
+        upipe_verbose_va(upipe, "scaling from %"PRIu64"x%"PRIu64,
+                         src->hsize, src->vsize);
+        ubuf = upipe_sws_ladder_output_scale(upipe, src->uref, src->pix_fmt,
+                src->chroma_map, src->colorspace, src->color_range);
+    } else
+        ubuf = upipe_sws_ladder_output_scale(upipe, uref, ladder->pix_fmt,
+                ladder->chroma_map, ladder->colorspace, ladder->color_range);
+    if (unlikely(ubuf == NULL))
+        return;
+
+    output->uref = uref_dup(uref);
+    if (unlikely(output->uref == NULL)) {
+        ubuf_free(ubuf);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    uref_attach_ubuf(output->uref, ubuf);
+}
+
+/** @internal @This processes control commands on an output subpipe of a
+ * sws_ladder pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_sws_ladder_output_control(struct upipe *upipe,
+                                           int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(
+        upipe_sws_ladder_output_control_super(upipe, command, args));
+    struct upipe_sws_ladder_output *output =
+        upipe_sws_ladder_output_from_upipe(upipe);
+    switch (command) {
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_sws_ladder_output_control_output(upipe, command,
+                                                          args);
+
+        case UPIPE_SWS_LADDER_OUTPUT_GET_FLAGS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWS_LADDER_OUTPUT_SIGNATURE)
+            int *flags_p = va_arg(args, int *);
+            *flags_p = output->flags;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SWS_LADDER_OUTPUT_SET_FLAGS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWS_LADDER_OUTPUT_SIGNATURE)
+            output->flags = va_arg(args, int);
+            upipe_dbg_va(upipe, "setting flags to %d", output->flags);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SWS_LADDER_OUTPUT_SET_DIRECT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWS_LADDER_OUTPUT_SIGNATURE)
+            output->direct = !!va_arg(args, int);
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_sws_ladder_output_free(struct upipe *upipe)
+{
+    struct upipe_sws_ladder_output *output =
+        upipe_sws_ladder_output_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    for (int i = 0; i < 3; i++)
+        if (output->convert_ctx[i] != NULL)
+            sws_freeContext(output->convert_ctx[i]);
+    uref_free(output->uref);
+    uref_free(output->flow_def_params);
+    upipe_sws_ladder_output_clean_output(upipe);
+    upipe_sws_ladder_output_clean_sub(upipe);
+    upipe_sws_ladder_output_clean_ubuf_mgr(upipe);
+    upipe_sws_ladder_output_clean_urefcount(upipe);
+    upipe_sws_ladder_output_free_flow(upipe);
+}
+
+/** @internal @This initializes the output manager for a sws_ladder pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_sws_ladder_init_sub_mgr(struct upipe *upipe)
+{
+    struct upipe_sws_ladder *upipe_sws_ladder =
+        upipe_sws_ladder_from_upipe(upipe);
+    struct upipe_mgr *sub_mgr = &upipe_sws_ladder->sub_mgr;
+    sub_mgr->refcount = upipe_sws_ladder_to_urefcount_real(upipe_sws_ladder);
+    sub_mgr->signature = UPIPE_SWS_LADDER_OUTPUT_SIGNATURE;
+    sub_mgr->upipe_alloc = upipe_sws_ladder_output_alloc;
+    sub_mgr->upipe_input = NULL;
+    sub_mgr->upipe_control = upipe_sws_ladder_output_control;
+    sub_mgr->upipe_mgr_control = NULL;
+}
+
+/** @internal @This allocates a sws_ladder pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_sws_ladder_alloc(struct upipe_mgr *mgr,
+                                            struct uprobe *uprobe,
+                                            uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_sws_ladder_alloc_void(mgr, uprobe, signature,
+                                                      args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_sws_ladder *upipe_sws_ladder =
+        upipe_sws_ladder_from_upipe(upipe);
+    upipe_sws_ladder_init_urefcount(upipe);
+    urefcount_init(upipe_sws_ladder_to_urefcount_real(upipe_sws_ladder),
+                   upipe_sws_ladder_free);
+    upipe_sws_ladder_init_sub_mgr(upipe);
+    upipe_sws_ladder_init_sub_outputs(upipe);
+    upipe_sws_ladder->flow_def = NULL;
+    upipe_sws_ladder->pix_fmt = AV_PIX_FMT_NONE;
+    upipe_sws_ladder->colorspace = -1;
+    upipe_sws_ladder->color_range = -1;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This receives data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_sws_ladder_input(struct upipe *upipe, struct uref *uref,
+                                   struct upump **upump_p)
+{
+    struct upipe_sws_ladder *ladder = upipe_sws_ladder_from_upipe(upipe);
+    if (unlikely(ladder->flow_def == NULL)) {
+        upipe_warn(upipe, "received buffer before flow definition");
+        uref_free(uref);
+        return;
+    }
+
+    /* scale from the largest to the smallest output */
+    struct uchain *uchain;
+    ulist_foreach (&ladder->outputs, uchain) {
+        struct upipe_sws_ladder_output *output =
+            upipe_sws_ladder_output_from_uchain(uchain);
+        upipe_sws_ladder_output_process(
+                upipe_sws_ladder_output_to_upipe(output), uref);
+    }
+    uref_free(uref);
+
+    struct uchain *uchain_tmp;
+    ulist_delete_foreach (&ladder->outputs, uchain, uchain_tmp) {
+        struct upipe_sws_ladder_output *output =
+            upipe_sws_ladder_output_from_uchain(uchain);
+        struct uref *output_uref = output->uref;
+        if (output_uref == NULL)
+            continue;
+        output->uref = NULL;
+        upipe_sws_ladder_output_output(upipe_sws_ladder_output_to_upipe(output),
+                                       output_uref, upump_p);
+    }
+}
+
+/** @internal @This changes the flow definition on all outputs.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def new flow definition
+ * @return an error code
+ */
+static int upipe_sws_ladder_set_flow_def(struct upipe *upipe,
+                                         struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+
+    struct upipe_sws_ladder *ladder = upipe_sws_ladder_from_upipe(upipe);
+    UBASE_RETURN(uref_flow_match_def(flow_def, "pic."))
+    enum AVPixelFormat pix_fmt =
+        upipe_av_pixfmt_from_flow_def(flow_def, NULL, ladder->chroma_map);
+    if (pix_fmt == AV_PIX_FMT_NONE || !sws_isSupportedInput(pix_fmt)) {
+        upipe_err(upipe, "incompatible flow def");
+        uref_dump(flow_def, upipe->uprobe);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup)
+    struct urational dar;
+    if (ubase_check(uref_pic_flow_get_dar(flow_def_dup, &dar)))
+        uref_pic_flow_infer_sar(flow_def_dup, dar);
+
+    uref_free(ladder->flow_def);
+    ladder->flow_def = flow_def_dup;
+    ladder->pix_fmt = pix_fmt;
+    ladder->colorspace = upipe_sws_ladder_convert_color(upipe, flow_def);
+    ladder->color_range =
+        ubase_check(uref_pic_flow_get_full_range(flow_def)) ? 1 : 0;
+
+    /* rebuild output flow definitions */
+    struct uchain *uchain;
+    ulist_foreach (&ladder->outputs, uchain) {
+        struct upipe_sws_ladder_output *output =
+            upipe_sws_ladder_output_from_uchain(uchain);
+        upipe_sws_ladder_output_build_flow_def(
+                upipe_sws_ladder_output_to_upipe(output));
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a sws_ladder pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_sws_ladder_control(struct upipe *upipe,
+                                    int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(
+        upipe_sws_ladder_control_outputs(upipe, command, args));
+
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST:
+        case UPIPE_UNREGISTER_REQUEST:
+            return upipe_control_provide_request(upipe, command, args);
+
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *uref = va_arg(args, struct uref *);
+            return upipe_sws_ladder_set_flow_def(upipe, uref);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param urefcount_real pointer to urefcount_real structure
+ */
+static void upipe_sws_ladder_free(struct urefcount *urefcount_real)
+{
+    struct upipe_sws_ladder *upipe_sws_ladder =
+        upipe_sws_ladder_from_urefcount_real(urefcount_real);
+    struct upipe *upipe = upipe_sws_ladder_to_upipe(upipe_sws_ladder);
+    upipe_throw_dead(upipe);
+    upipe_sws_ladder_clean_sub_outputs(upipe);
+    uref_free(upipe_sws_ladder->flow_def);
+    urefcount_clean(urefcount_real);
+    upipe_sws_ladder_clean_urefcount(upipe);
+    upipe_sws_ladder_free_void(upipe);
+}
+
+/** @This is called when there is no external reference to the pipe anymore.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_sws_ladder_no_input(struct upipe *upipe)
+{
+    struct upipe_sws_ladder *upipe_sws_ladder =
+        upipe_sws_ladder_from_upipe(upipe);
+    upipe_sws_ladder_throw_sub_outputs(upipe, UPROBE_SOURCE_END);
+    urefcount_release(upipe_sws_ladder_to_urefcount_real(upipe_sws_ladder));
+}
+
+/** sws_ladder module manager static descriptor */
+static struct upipe_mgr upipe_sws_ladder_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_SWS_LADDER_SIGNATURE,
+
+    .upipe_alloc = upipe_sws_ladder_alloc,
+    .upipe_input = upipe_sws_ladder_input,
+    .upipe_control = upipe_sws_ladder_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all sws_ladder pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_sws_ladder_mgr_alloc(void)
+{
+    return &upipe_sws_ladder_mgr;
+}
@@ -494,14 +494,7 @@ static int upipe_sws_thumbs_amend_ubuf_mgr(struct upipe *upipe,
     struct uref *flow_format = uref_dup(request->uref);
     UBASE_ALLOC_RETURN(flow_format);
 
-    uint64_t align;
-    if (!ubase_check(uref_pic_flow_get_align(flow_format, &align)) || !align)
-        uref_pic_flow_set_align(flow_format, 16);
-
-    if (align % 16) {
-        align = align * 16 / ubase_gcd(align, 16);
-        uref_pic_flow_set_align(flow_format, align);
-    }
+    uref_pic_flow_require_align(flow_format, 16);
 
     struct urequest ubuf_mgr_request;
     urequest_set_opaque(&ubuf_mgr_request, request);
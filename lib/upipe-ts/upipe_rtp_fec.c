@@ -44,6 +44,7 @@
 #include <upipe/ulist.h>
 #include <upipe/uref_flow.h>
 #include <upipe/uref.h>
+#include <upipe/uref_ring.h>
 #include <upipe/uref_dump.h>
 #include <upipe/uref_clock.h>
 #include <upipe/upump.h>
@@ -57,6 +58,7 @@
 #include <upipe/upipe_helper_upump.h>
 
 #include <upipe-ts/upipe_rtp_fec.h>
+#include "upipe_rtp_fec_xor.h"
 
 #include <bitstream/ietf/rtp.h>
 #include <bitstream/mpeg/ts.h>
@@ -64,6 +66,8 @@
 
 #define UPIPE_FEC_JITTER UCLOCK_FREQ/25
 #define FEC_MAX 255
+/** number of slots of the FEC packet rings */
+#define FEC_QUEUE_SIZE 1024
 
 /** upipe_rtp_fec structure with rtp-fec parameters */
 struct upipe_rtp_fec {
@@ -110,9 +114,12 @@ struct upipe_rtp_fec {
     /** row subpipe */
     struct upipe row_subpipe;
 
-    struct uchain main_queue;
-    struct uchain col_queue;
-    struct uchain row_queue;
+    /** media packets, indexed by sequence number */
+    struct uref_ring main_queue;
+    /** column FEC packets, indexed by their own sequence number */
+    struct uref_ring col_queue;
+    /** row FEC packets, indexed by their own sequence number */
+    struct uref_ring row_queue;
 
     /* number of packets not recovered */
     uint64_t lost;
@@ -193,74 +200,87 @@ static void upipe_rtp_fec_extract_parameters(struct uref *fec_uref,
     uref_block_peek_unmap(fec_uref, RTP_HEADER_SIZE, fec_header, peek);
 }
 
+/** @internal @This outputs a media packet and accounts for the packets
+ * that could not be recovered.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param seqnum sequence number of the packet
+ */
+static void upipe_rtp_fec_output_packet(struct upipe *upipe,
+                                        struct uref *uref, uint16_t seqnum)
+{
+    struct upipe_rtp_fec *upipe_rtp_fec = upipe_rtp_fec_from_upipe(upipe);
+
+    upipe_rtp_fec_output(upipe, uref, NULL);
+
+    if (upipe_rtp_fec->last_send_seqnum != UINT32_MAX) {
+        uint16_t expected = upipe_rtp_fec->last_send_seqnum + 1;
+        if (expected != seqnum) {
+            upipe_warn_va(upipe, "FEC output LOST, expected seqnum %hu got %hu",
+                    expected, seqnum);
+            upipe_rtp_fec->lost +=
+                (seqnum + UINT16_MAX + 1 - expected) & UINT16_MAX;
+
+        }
+    }
+
+    upipe_rtp_fec->last_send_seqnum = seqnum;
+}
+
 /* Delete main packets older than the reference point */
-static void clear_main_list(struct uchain *main_list, uint16_t snbase)
+static void clear_main_list(struct uref_ring *main_list, uint16_t snbase)
 {
-    struct uchain *uchain, *uchain_tmp;
+    struct uref *uref;
+    uint16_t seqnum;
 
-    ulist_delete_foreach (main_list, uchain, uchain_tmp) {
-        struct uref *uref = uref_from_uchain(uchain);
-        if (!seq_num_lt(uref->priv, snbase))
+    while ((uref = uref_ring_peek(main_list, &seqnum)) != NULL) {
+        if (!seq_num_lt(seqnum, snbase))
             break;
 
-        ulist_delete(uchain);
+        uref_ring_pop(main_list, NULL);
         uref_free(uref);
     }
 }
 
-// TODO : merge with above, cache seqnum
 /* Delete FEC packets older than the reference point */
-static void clear_fec_list(struct uchain *fec_list, uint16_t last_fec_snbase)
+static void clear_fec_list(struct uref_ring *fec_list, uint16_t last_fec_snbase)
 {
-    struct uchain *uchain, *uchain_tmp;
-    ulist_delete_foreach (fec_list, uchain, uchain_tmp) {
-        struct uref *fec_uref = uref_from_uchain(uchain);
+    struct uref *fec_uref;
+
+    while ((fec_uref = uref_ring_peek(fec_list, NULL)) != NULL) {
         uint16_t snbase_low = fec_uref->priv >> 32;
 
         if (!seq_num_lt(snbase_low, last_fec_snbase))
             break;
 
-        ulist_delete(uchain);
+        uref_ring_pop(fec_list, NULL);
         uref_free(fec_uref);
     }
 }
 
-static void insert_ordered_uref(struct uchain *queue, struct uref *uref)
+static void insert_ordered_uref(struct upipe *upipe, struct uref_ring *queue,
+                                struct uref *uref)
 {
+    struct upipe_rtp_fec *upipe_rtp_fec = upipe_rtp_fec_from_upipe(upipe);
     uint16_t new_seqnum = uref->priv;
 
-    struct uchain *uchain, *uchain_tmp;
-    ulist_delete_foreach_reverse(queue, uchain, uchain_tmp) {
-        struct uref *cur_uref = uref_from_uchain(uchain);
-        uint16_t seqnum = cur_uref->priv;
-
-        /* Duplicate packet */
-        if (new_seqnum == seqnum) {
-            uref_free(uref);
-            return;
-        }
-
-        if (!seq_num_lt(new_seqnum, seqnum))
-            break;
-
-        /* Check previous packet if any */
-        struct uref *prev_uref = uref_from_uchain(uchain->prev);
-        if (prev_uref) {
-            uint16_t prev_seqnum = prev_uref->priv;
-            if (prev_seqnum == new_seqnum)
-                continue;
-
-            if (seq_num_lt(new_seqnum, prev_uref->priv))
-                continue;
-        }
-
+    if (uref_ring_is_late(queue, new_seqnum))
         uref_clock_delete_date_sys(uref);
-        ulist_insert(uchain->prev, uchain, uref_to_uchain(uref));
-        return;
+
+    /* Make room for the packet, media packets are output early */
+    while (!uref_ring_fits(queue, new_seqnum)) {
+        uint16_t seqnum;
+        struct uref *old = uref_ring_pop(queue, &seqnum);
+        if (queue == &upipe_rtp_fec->main_queue)
+            upipe_rtp_fec_output_packet(upipe, old, seqnum);
+        else
+            uref_free(old);
     }
 
-    /* Add to end of queue */
-    ulist_add(queue, uref_to_uchain(uref));
+    /* Duplicate packet */
+    if (!ubase_check(uref_ring_insert(queue, new_seqnum, uref)))
+        uref_free(uref);
 }
 
 /* apply the correction from that fec packet */
@@ -269,28 +289,20 @@ static void upipe_rtp_fec_correct_packets(struct upipe *upipe,
 {
     struct upipe_rtp_fec *upipe_rtp_fec = upipe_rtp_fec_from_upipe(upipe);
 
-    bool found_seqnum[FEC_MAX] = {0};
+    struct uref *found[FEC_MAX];
 
     /* Search to see if any packets are lost */
     int processed = 0;
-    struct uchain *uchain, *uchain_tmp;
-    ulist_foreach (&upipe_rtp_fec->main_queue, uchain) {
-        struct uref *uref = uref_from_uchain(uchain);
-        uint16_t seqnum = uref->priv;
-
-        for (int i = 0; i < items; i++) {
-            if (seqnum_list[i] == seqnum) {
-                processed++;
-                found_seqnum[i] = true;
-                break;
-            }
-        }
+    for (int i = 0; i < items; i++) {
+        found[i] = uref_ring_get(&upipe_rtp_fec->main_queue, seqnum_list[i]);
+        if (found[i] != NULL)
+            processed++;
+    }
 
-        if (processed == items) {
-            upipe_verbose_va(upipe, "no packets lost");
-            uref_free(fec_uref);
-            return;
-        }
+    if (processed == items) {
+        upipe_verbose_va(upipe, "no packets lost");
+        uref_free(fec_uref);
+        return;
     }
 
     if (processed != items - 1) {
@@ -306,10 +318,10 @@ static void upipe_rtp_fec_correct_packets(struct upipe *upipe,
     upipe_rtp_fec_extract_parameters(fec_uref, &ts_rec, &length_rec);
 
     /* Recoverable packet */
-    ulist_foreach (&upipe_rtp_fec->main_queue, uchain) {
-        struct uref *uref = uref_from_uchain(uchain);
-
-        // TODO: only if in list?
+    for (int i = 0; i < items; i++) {
+        struct uref *uref = found[i];
+        if (uref == NULL)
+            continue;
 
         uint8_t rtp_buffer[RTP_HEADER_SIZE];
         const uint8_t *rtp_header = uref_block_peek(uref, 0, RTP_HEADER_SIZE,
@@ -323,16 +335,12 @@ static void upipe_rtp_fec_correct_packets(struct upipe *upipe,
         uref_block_peek_unmap(uref, 0, rtp_buffer, rtp_header);
 
         /* Recover length and timestamp of missing packet */
-        for (int i = 0; i < items; i++) {
-            if (seqnum_list[i] == uref->priv) {
-                size_t uref_len = 0;
-                uref_block_size(uref, &uref_len);
-                uref_len -= RTP_HEADER_SIZE;
-
-                length_rec ^= uref_len;
-                ts_rec ^= timestamp;
-            }
-        }
+        size_t uref_len = 0;
+        uref_block_size(uref, &uref_len);
+        uref_len -= RTP_HEADER_SIZE;
+
+        length_rec ^= uref_len;
+        ts_rec ^= timestamp;
     }
 
     if (length_rec != 7 * TS_SIZE)
@@ -345,46 +353,61 @@ static void upipe_rtp_fec_correct_packets(struct upipe *upipe,
     uref_block_write(fec_uref, 0, &size, &dst);
 
     bool copy_header = true;
+    int dst_len = size - RTP_HEADER_SIZE;
 
-    processed = 0;
-    ulist_foreach (&upipe_rtp_fec->main_queue, uchain) {
-        struct uref *uref = uref_from_uchain(uchain);
-        for (int i = 0; i < items; i++) {
-            if (seqnum_list[i] == uref->priv) {
-                size_t size = 0;
-                uref_block_size(uref, &size);
-                uint8_t payload_buf[TS_SIZE * 7 + RTP_HEADER_SIZE];
-
-                if(size < sizeof(payload_buf))
-                    continue;
-
-                // TODO: uref_block_read in a loop
-                const uint8_t *peek = uref_block_peek(uref, 0, size,
-                        payload_buf);
-                if (copy_header) {
-                    memcpy(dst, peek, RTP_HEADER_SIZE);
-                    copy_header = false;
-                }
-                for (int i = 0; i < size - RTP_HEADER_SIZE; i++)
-                    dst[RTP_HEADER_SIZE + i] ^= peek[RTP_HEADER_SIZE + i];
-                uref_block_peek_unmap(uref, RTP_HEADER_SIZE, payload_buf, peek);
-                processed++;
-                break;
-            }
-        }
-
-        if (processed == items-1)
-            break;
-    }
+    /* Map the payloads to XOR them in a single pass */
+    const uint8_t *payloads[FEC_MAX];
+    struct uref *mapped[FEC_MAX];
+    unsigned int nb_mapped = 0;
 
-    /* Maybe possible to merge with above */
     uint16_t missing_seqnum = 0;
-    for (int i = 0; i < items; i++)
-        if (!found_seqnum[i]) {
+    for (int i = 0; i < items; i++) {
+        struct uref *uref = found[i];
+        if (uref == NULL) {
             missing_seqnum = seqnum_list[i];
-            break;
+            continue;
+        }
+
+        size_t uref_size = 0;
+        uref_block_size(uref, &uref_size);
+        if (uref_size < TS_SIZE * 7 + RTP_HEADER_SIZE)
+            continue;
+
+        int read_size = -1;
+        const uint8_t *peek;
+        if (unlikely(!ubase_check(uref_block_read(uref, 0, &read_size,
+                                                  &peek))))
+            continue;
+        if (copy_header) {
+            memcpy(dst, peek, RTP_HEADER_SIZE);
+            copy_header = false;
+        }
+
+        if (read_size - RTP_HEADER_SIZE >= dst_len) {
+            payloads[nb_mapped] = peek + RTP_HEADER_SIZE;
+            mapped[nb_mapped++] = uref;
+            continue;
         }
 
+        /* Segmented or short packet */
+        uref_block_unmap(uref, 0);
+        uint8_t payload_buf[TS_SIZE * 7 + RTP_HEADER_SIZE];
+        int len = uref_size - RTP_HEADER_SIZE;
+        if (len > dst_len)
+            len = dst_len;
+        if (len > TS_SIZE * 7)
+            len = TS_SIZE * 7;
+        peek = uref_block_peek(uref, RTP_HEADER_SIZE, len, payload_buf);
+        if (unlikely(peek == NULL))
+            continue;
+        upipe_rtp_fec_xor(dst + RTP_HEADER_SIZE, &peek, 1, len);
+        uref_block_peek_unmap(uref, RTP_HEADER_SIZE, payload_buf, peek);
+    }
+
+    upipe_rtp_fec_xor(dst + RTP_HEADER_SIZE, payloads, nb_mapped, dst_len);
+    for (unsigned int i = 0; i < nb_mapped; i++)
+        uref_block_unmap(mapped[i], 0);
+
     upipe_dbg_va(&upipe_rtp_fec->upipe, "Corrected packet. Sequence number: %u", missing_seqnum);
     upipe_rtp_fec->recovered++;
     fec_uref->priv = missing_seqnum;
@@ -393,7 +416,7 @@ static void upipe_rtp_fec_correct_packets(struct upipe *upipe,
     uref_block_unmap(fec_uref, 0);
     uref_block_resize(fec_uref, 0, size);
 
-    insert_ordered_uref(&upipe_rtp_fec->main_queue, fec_uref);
+    insert_ordered_uref(upipe, &upipe_rtp_fec->main_queue, fec_uref);
 }
 
 static void upipe_rtp_fec_apply_col_fec(struct upipe *upipe)
@@ -402,11 +425,11 @@ static void upipe_rtp_fec_apply_col_fec(struct upipe *upipe)
     uint16_t seqnum_list[FEC_MAX];
 
     for (;;) {
-        struct uchain *fec_uchain = ulist_peek(&upipe_rtp_fec->col_queue);
-        if (!fec_uchain)
+        struct uref *fec_uref = uref_ring_peek(&upipe_rtp_fec->col_queue,
+                                               NULL);
+        if (!fec_uref)
             break;
 
-        struct uref *fec_uref = uref_from_uchain(fec_uchain);
         uint16_t snbase_low = fec_uref->priv >> 32;
         uint16_t col_delta = upipe_rtp_fec->last_seqnum - snbase_low - 1;
 
@@ -414,7 +437,7 @@ static void upipe_rtp_fec_apply_col_fec(struct upipe *upipe)
         if (col_delta <= (upipe_rtp_fec->cols + 1) * upipe_rtp_fec->rows)
             break;
 
-        ulist_pop(&upipe_rtp_fec->col_queue);
+        uref_ring_pop(&upipe_rtp_fec->col_queue, NULL);
 
         /* If no current matrix is being processed and we have enough packets
          * set existing matrix to the snbase value */
@@ -444,11 +467,10 @@ static void upipe_rtp_fec_apply_row_fec(struct upipe *upipe,
     clear_fec_list(&upipe_rtp_fec->row_queue, cur_row_fec_snbase);
 
     /* Row FEC packets are optional so may not actually exist */
-    struct uchain *fec_uchain = ulist_pop(&upipe_rtp_fec->row_queue);
-    if (!fec_uchain)
+    struct uref *fec_uref = uref_ring_pop(&upipe_rtp_fec->row_queue, NULL);
+    if (!fec_uref)
         return;
 
-    struct uref *fec_uref = uref_from_uchain(fec_uchain);
     uint16_t snbase_low = fec_uref->priv >> 32;
 
     upipe_rtp_fec->cur_row_fec_snbase = snbase_low;
@@ -461,21 +483,11 @@ static void upipe_rtp_fec_apply_row_fec(struct upipe *upipe,
             upipe_rtp_fec->cols);
 }
 
-static void upipe_rtp_fec_clear_queue(struct uchain *queue)
-{
-    struct uchain *uchain, *uchain_tmp;
-    ulist_delete_foreach (queue, uchain, uchain_tmp) {
-        struct uref *uref = uref_from_uchain(uchain);
-        ulist_delete(uchain);
-        uref_free(uref);
-    }
-}
-
 static void upipe_rtp_fec_clear(struct upipe_rtp_fec *upipe_rtp_fec)
 {
-    upipe_rtp_fec_clear_queue(&upipe_rtp_fec->main_queue);
-    upipe_rtp_fec_clear_queue(&upipe_rtp_fec->col_queue);
-    upipe_rtp_fec_clear_queue(&upipe_rtp_fec->row_queue);
+    uref_ring_flush(&upipe_rtp_fec->main_queue);
+    uref_ring_flush(&upipe_rtp_fec->col_queue);
+    uref_ring_flush(&upipe_rtp_fec->row_queue);
 }
 
 // TODO: wait_upump?
@@ -485,13 +497,14 @@ static void upipe_rtp_fec_timer(struct upump *upump)
     struct upipe_rtp_fec *upipe_rtp_fec = upipe_rtp_fec_from_upipe(upipe);
     uint64_t now = uclock_now(upipe_rtp_fec->uclock);
 
-    struct uchain *uchain, *uchain_tmp;
-    ulist_delete_foreach (&upipe_rtp_fec->main_queue, uchain, uchain_tmp) {
-        struct uref *uref = uref_from_uchain(uchain);
+    struct uref *uref;
+    uint16_t seqnum;
+
+    while ((uref = uref_ring_peek(&upipe_rtp_fec->main_queue,
+                                  &seqnum)) != NULL) {
         uint64_t date_sys = UINT64_MAX;
         int type;
         uref_clock_get_date_sys(uref, &date_sys, &type);
-        uint64_t seqnum = uref->priv & UINT32_MAX;
 
         if (date_sys != UINT64_MAX) {
             // TODO: replace by output latency
@@ -503,21 +516,8 @@ static void upipe_rtp_fec_timer(struct upump *upump)
             uref_clock_set_date_sys(uref, date_sys, type);
         }
 
-        ulist_delete(uchain);
-        upipe_rtp_fec_output(upipe, uref, NULL);
-
-        if (upipe_rtp_fec->last_send_seqnum != UINT32_MAX) {
-            uint16_t expected = upipe_rtp_fec->last_send_seqnum + 1;
-            if (expected != seqnum) {
-                upipe_warn_va(upipe, "FEC output LOST, expected seqnum %hu got %" PRIu64,
-                        expected, seqnum);
-                upipe_rtp_fec->lost +=
-                    (seqnum + UINT16_MAX + 1 - expected) & UINT16_MAX;
-
-            }
-        }
-
-        upipe_rtp_fec->last_send_seqnum = seqnum;
+        uref_ring_pop(&upipe_rtp_fec->main_queue, NULL);
+        upipe_rtp_fec_output_packet(upipe, uref, seqnum);
     }
 }
 
@@ -563,12 +563,13 @@ static void upipe_rtp_fec_start_timer(struct upipe *upipe, uint16_t seqnum)
     /* Clear any old non-FEC packets */
     clear_main_list(&upipe_rtp_fec->main_queue, upipe_rtp_fec->cur_matrix_snbase);
 
-    struct uchain *first_uchain = ulist_peek(&upipe_rtp_fec->main_queue);
-    if (!first_uchain)
+    uint16_t first_seqnum;
+    struct uref *first_uref = uref_ring_peek(&upipe_rtp_fec->main_queue,
+                                             &first_seqnum);
+    if (!first_uref)
         return;
 
-    struct uref *first_uref = uref_from_uchain(first_uchain);
-    upipe_rtp_fec->first_seqnum = first_uref->priv;
+    upipe_rtp_fec->first_seqnum = first_seqnum;
 
     /* Make sure we have at least two matrices of data as per the spec */
     uint16_t seq_delta = seqnum - upipe_rtp_fec->first_seqnum - 1;
@@ -584,13 +585,10 @@ static void upipe_rtp_fec_start_timer(struct upipe *upipe, uint16_t seqnum)
 
     if (date_sys == UINT64_MAX) {
         /* First packet having an unusable date_sys is not useful */
-        ulist_delete(first_uchain);
+        uref_ring_pop(&upipe_rtp_fec->main_queue, NULL);
         uref_free(first_uref);
-        first_uchain = ulist_peek(&upipe_rtp_fec->main_queue);
-        if (first_uchain) {
-            struct uref *uref = uref_from_uchain(first_uchain);
-            upipe_rtp_fec->first_seqnum = uref->priv;
-        }
+        if (uref_ring_peek(&upipe_rtp_fec->main_queue, &first_seqnum))
+            upipe_rtp_fec->first_seqnum = first_seqnum;
         return;
     }
 
@@ -664,7 +662,7 @@ static void upipe_rtp_fec_main_input(struct upipe *upipe, struct uref *uref)
         uint64_t date_sys = 0;
         uref_clock_get_date_sys(uref, &date_sys, &type);
 
-        insert_ordered_uref(&upipe_rtp_fec->main_queue, uref);
+        insert_ordered_uref(super_pipe, &upipe_rtp_fec->main_queue, uref);
 
         /* Owing to clock drift the latency of 2x the FEC matrix may increase
          * Build a continually updating duration and correct the latency if necessary.
@@ -734,7 +732,7 @@ static void upipe_rtp_fec_colrow_input(struct upipe *upipe, struct uref *uref)
     uref_block_peek_unmap(uref, RTP_HEADER_SIZE, fec_buffer, fec_header);
 
     bool col = (upipe == upipe_rtp_fec_to_col_subpipe(upipe_rtp_fec));
-    struct uchain *queue = col ? &upipe_rtp_fec->col_queue :
+    struct uref_ring *queue = col ? &upipe_rtp_fec->col_queue :
         &upipe_rtp_fec->row_queue;
 
     if (col) {
@@ -764,7 +762,7 @@ static void upipe_rtp_fec_colrow_input(struct upipe *upipe, struct uref *uref)
         }
     }
 
-    insert_ordered_uref(queue, uref);
+    insert_ordered_uref(upipe_rtp_fec_to_upipe(upipe_rtp_fec), queue, uref);
     upipe_rtp_fec->pkts_since_last_fec = 0;
     return;
 
@@ -907,6 +905,21 @@ static struct upipe *_upipe_rtp_fec_alloc(struct upipe_mgr *mgr,
         return NULL;
     }
 
+    if (unlikely(!ubase_check(uref_ring_init(&upipe_rtp_fec->main_queue,
+                                             UREF_RING_MAX_SIZE)) ||
+                 !ubase_check(uref_ring_init(&upipe_rtp_fec->col_queue,
+                                             FEC_QUEUE_SIZE)) ||
+                 !ubase_check(uref_ring_init(&upipe_rtp_fec->row_queue,
+                                             FEC_QUEUE_SIZE)))) {
+        uref_ring_clean(&upipe_rtp_fec->main_queue);
+        uref_ring_clean(&upipe_rtp_fec->col_queue);
+        free(upipe_rtp_fec);
+        uprobe_release(uprobe_main);
+        uprobe_release(uprobe_col);
+        uprobe_release(uprobe_row);
+        return NULL;
+    }
+
     upipe_rtp_fec->first_seqnum = UINT32_MAX;
     upipe_rtp_fec->last_seqnum = UINT32_MAX;
     upipe_rtp_fec->last_send_seqnum = UINT32_MAX;
@@ -935,10 +948,6 @@ static struct upipe *_upipe_rtp_fec_alloc(struct upipe_mgr *mgr,
     upipe_rtp_fec_sub_init(upipe_rtp_fec_to_row_subpipe(upipe_rtp_fec),
                             &upipe_rtp_fec->sub_mgr, uprobe_row);
 
-    ulist_init(&upipe_rtp_fec->main_queue);
-    ulist_init(&upipe_rtp_fec->col_queue);
-    ulist_init(&upipe_rtp_fec->row_queue);
-
     upipe_rtp_fec_check_upump_mgr(upipe);
 
     upipe_throw_ready(upipe);
@@ -1045,7 +1054,9 @@ static void upipe_rtp_fec_free(struct upipe *upipe)
 
     upipe_throw_dead(upipe);
 
-    upipe_rtp_fec_clear(upipe_rtp_fec);
+    uref_ring_clean(&upipe_rtp_fec->main_queue);
+    uref_ring_clean(&upipe_rtp_fec->col_queue);
+    uref_ring_clean(&upipe_rtp_fec->row_queue);
 
     upipe_rtp_fec_sub_clean(upipe_rtp_fec_to_main_subpipe(upipe_rtp_fec));
     upipe_rtp_fec_sub_clean(upipe_rtp_fec_to_col_subpipe(upipe_rtp_fec));
@@ -0,0 +1,783 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe module generating SMPTE 2022-1 FEC streams
+ *
+ * Packets are placed in a L x D matrix in the order of their sequence
+ * numbers. Each packet is XORed into the FEC packet of its column as soon
+ * as it arrives. The packets of the current row are kept by reference, and
+ * XORed in a single pass when the row is complete. Row FEC packets are
+ * only computed when the row subpipe has an output, as they are optional.
+ *
+ * FEC packets are allocated from the buffer manager of the incoming
+ * packets, so they are recycled by its pool once sent.
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_flow.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_output.h>
+
+#include <upipe-ts/upipe_rtp_fec_enc.h>
+#include "upipe_rtp_fec_xor.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include <bitstream/ietf/rtp.h>
+#include <bitstream/mpeg/ts.h>
+#include <bitstream/smpte/2022_1_fec.h>
+
+/** we only accept blocks */
+#define EXPECTED_FLOW_DEF "block."
+/** default number of columns */
+#define DEFAULT_COLS 10
+/** default number of rows */
+#define DEFAULT_ROWS 10
+/** maximum number of columns and rows */
+#define FEC_ENC_MAX 20
+/** maximum number of packets in a matrix */
+#define FEC_ENC_MAX_PACKETS 100
+/** maximum payload size of protected packets (7 TS packets) */
+#define FEC_ENC_MAX_PAYLOAD (7 * TS_SIZE)
+/** size of the headers of FEC packets */
+#define FEC_ENC_HEADER_SIZE (RTP_HEADER_SIZE + SMPTE_2022_FEC_HEADER_SIZE)
+/** RTP type of FEC packets */
+#define FEC_ENC_TYPE 96
+
+/** @internal @This is a FEC packet being computed. */
+struct upipe_rtp_fec_enc_acc {
+    /** FEC packet, or NULL */
+    struct ubuf *ubuf;
+    /** mapped FEC packet */
+    uint8_t *buffer;
+    /** sequence number of the first protected packet */
+    uint16_t snbase;
+    /** XOR of the payload sizes */
+    uint16_t length_rec;
+    /** XOR of the RTP types */
+    uint8_t pt_rec;
+    /** XOR of the RTP timestamps */
+    uint32_t ts_rec;
+    /** largest payload size */
+    int size;
+};
+
+/** @internal @This is the private context of a FEC output subpipe. */
+struct upipe_rtp_fec_enc_sub {
+    /** output pipe */
+    struct upipe *output;
+    /** flow_definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** sequence number of the next FEC packet */
+    uint16_t seqnum;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_rtp_fec_enc_sub, upipe,
+                   UPIPE_RTP_FEC_ENC_OUTPUT_SIGNATURE)
+UPIPE_HELPER_OUTPUT(upipe_rtp_fec_enc_sub, output, flow_def, output_state,
+                    request_list)
+
+/** @internal @This is the private context of a rtp fec enc pipe. */
+struct upipe_rtp_fec_enc {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** output pipe */
+    struct upipe *output;
+    /** flow_definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** manager of the subpipes */
+    struct upipe_mgr sub_mgr;
+    /** fec-column subpipe */
+    struct upipe_rtp_fec_enc_sub col_sub;
+    /** fec-row subpipe */
+    struct upipe_rtp_fec_enc_sub row_sub;
+
+    /** number of columns (L) */
+    unsigned int cols;
+    /** number of rows (D) */
+    unsigned int rows;
+    /** position of the next packet in the matrix */
+    unsigned int position;
+    /** expected sequence number of the next packet */
+    uint16_t next_seqnum;
+
+    /** column FEC packets */
+    struct upipe_rtp_fec_enc_acc col_acc[FEC_ENC_MAX];
+    /** row FEC packet */
+    struct upipe_rtp_fec_enc_acc row_acc;
+    /** packets of the current row */
+    struct ubuf *row_ubufs[FEC_ENC_MAX];
+    /** number of packets of the current row */
+    unsigned int nb_row_ubufs;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_rtp_fec_enc, upipe, UPIPE_RTP_FEC_ENC_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_rtp_fec_enc, urefcount, upipe_rtp_fec_enc_free)
+UPIPE_HELPER_OUTPUT(upipe_rtp_fec_enc, output, flow_def, output_state,
+                    request_list)
+
+UBASE_FROM_TO(upipe_rtp_fec_enc, upipe_mgr, sub_mgr, sub_mgr)
+UBASE_FROM_TO(upipe_rtp_fec_enc, upipe_rtp_fec_enc_sub, col_sub, col_sub)
+UBASE_FROM_TO(upipe_rtp_fec_enc, upipe_rtp_fec_enc_sub, row_sub, row_sub)
+
+/** @internal @This resets the recovery fields of a FEC packet.
+ *
+ * @param acc FEC packet
+ * @param snbase sequence number of the first protected packet
+ */
+static inline void upipe_rtp_fec_enc_acc_reset(
+        struct upipe_rtp_fec_enc_acc *acc, uint16_t snbase)
+{
+    acc->snbase = snbase;
+    acc->length_rec = 0;
+    acc->pt_rec = 0;
+    acc->ts_rec = 0;
+    acc->size = 0;
+}
+
+/** @internal @This allocates the buffer of a FEC packet.
+ *
+ * @param acc FEC packet
+ * @param ubuf_mgr manager to allocate the FEC packet from
+ * @return an error code
+ */
+static int upipe_rtp_fec_enc_acc_alloc(struct upipe_rtp_fec_enc_acc *acc,
+                                       struct ubuf_mgr *ubuf_mgr)
+{
+    int size = FEC_ENC_HEADER_SIZE + FEC_ENC_MAX_PAYLOAD;
+    acc->ubuf = ubuf_block_alloc(ubuf_mgr, size);
+    UBASE_ALLOC_RETURN(acc->ubuf)
+    if (unlikely(!ubase_check(ubuf_block_write(acc->ubuf, 0, &size,
+                                               &acc->buffer)) ||
+                 size != FEC_ENC_HEADER_SIZE + FEC_ENC_MAX_PAYLOAD)) {
+        ubuf_free(acc->ubuf);
+        acc->ubuf = NULL;
+        return UBASE_ERR_ALLOC;
+    }
+    memset(acc->buffer, 0, size);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This drops a FEC packet.
+ *
+ * @param acc FEC packet
+ */
+static void upipe_rtp_fec_enc_acc_clean(struct upipe_rtp_fec_enc_acc *acc)
+{
+    if (acc->ubuf == NULL)
+        return;
+    ubuf_block_unmap(acc->ubuf, 0);
+    ubuf_free(acc->ubuf);
+    acc->ubuf = NULL;
+}
+
+/** @internal @This accounts for the RTP header of a protected packet.
+ *
+ * @param acc FEC packet
+ * @param type RTP type of the packet
+ * @param timestamp RTP timestamp of the packet
+ * @param size payload size of the packet
+ */
+static inline void upipe_rtp_fec_enc_acc_add(struct upipe_rtp_fec_enc_acc *acc,
+                                             uint8_t type, uint32_t timestamp,
+                                             int size)
+{
+    acc->length_rec ^= size;
+    acc->pt_rec ^= type;
+    acc->ts_rec ^= timestamp;
+    if (acc->size < size)
+        acc->size = size;
+}
+
+/** @internal @This XORs the payload of a protected packet into a buffer,
+ * one segment at a time.
+ *
+ * @param dst destination buffer
+ * @param ubuf protected packet
+ * @param size payload size of the packet
+ * @return an error code
+ */
+static int upipe_rtp_fec_enc_xor_ubuf(uint8_t *dst, struct ubuf *ubuf,
+                                      int size)
+{
+    int offset = 0;
+    while (offset < size) {
+        int len = size - offset;
+        const uint8_t *src;
+        UBASE_RETURN(ubuf_block_read(ubuf, RTP_HEADER_SIZE + offset, &len,
+                                     &src))
+        upipe_rtp_fec_xor(dst + offset, &src, 1, len);
+        ubuf_block_unmap(ubuf, RTP_HEADER_SIZE + offset);
+        offset += len;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This XORs the payloads of the packets of the current row into
+ * the row FEC packet. Packets with a contiguous payload of the largest size
+ * are XORed in a single pass.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_rtp_fec_enc_xor_row(struct upipe *upipe)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_upipe(upipe);
+    struct upipe_rtp_fec_enc_acc *acc = &upipe_rtp_fec_enc->row_acc;
+    uint8_t *dst = acc->buffer + FEC_ENC_HEADER_SIZE;
+    const uint8_t *payloads[FEC_ENC_MAX];
+    struct ubuf *mapped[FEC_ENC_MAX];
+    unsigned int nb_mapped = 0;
+
+    for (unsigned int i = 0; i < upipe_rtp_fec_enc->nb_row_ubufs; i++) {
+        struct ubuf *ubuf = upipe_rtp_fec_enc->row_ubufs[i];
+        size_t size = 0;
+        ubuf_block_size(ubuf, &size);
+        int len = size - RTP_HEADER_SIZE;
+        if (len == acc->size) {
+            const uint8_t *src;
+            if (likely(ubase_check(ubuf_block_read(ubuf, RTP_HEADER_SIZE,
+                                                   &len, &src)))) {
+                if (len == acc->size) {
+                    payloads[nb_mapped] = src;
+                    mapped[nb_mapped++] = ubuf;
+                    continue;
+                }
+                ubuf_block_unmap(ubuf, RTP_HEADER_SIZE);
+            }
+            len = size - RTP_HEADER_SIZE;
+        }
+
+        if (unlikely(!ubase_check(upipe_rtp_fec_enc_xor_ubuf(dst, ubuf,
+                                                             len))))
+            upipe_warn(upipe, "unable to read packet");
+    }
+
+    if (nb_mapped)
+        upipe_rtp_fec_xor(dst, payloads, nb_mapped, acc->size);
+    for (unsigned int i = 0; i < nb_mapped; i++)
+        ubuf_block_unmap(mapped[i], RTP_HEADER_SIZE);
+}
+
+/** @internal @This releases the packets of the current row.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_rtp_fec_enc_clean_row(struct upipe *upipe)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_upipe(upipe);
+    for (unsigned int i = 0; i < upipe_rtp_fec_enc->nb_row_ubufs; i++)
+        ubuf_free(upipe_rtp_fec_enc->row_ubufs[i]);
+    upipe_rtp_fec_enc->nb_row_ubufs = 0;
+}
+
+/** @internal @This drops the current matrix.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_rtp_fec_enc_reset(struct upipe *upipe)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_upipe(upipe);
+    for (unsigned int i = 0; i < FEC_ENC_MAX; i++)
+        upipe_rtp_fec_enc_acc_clean(&upipe_rtp_fec_enc->col_acc[i]);
+    upipe_rtp_fec_enc_acc_clean(&upipe_rtp_fec_enc->row_acc);
+    upipe_rtp_fec_enc_clean_row(upipe);
+    upipe_rtp_fec_enc->position = 0;
+}
+
+/** @internal @This finishes a FEC packet.
+ *
+ * @param upipe description structure of the pipe
+ * @param acc FEC packet
+ * @param sub subpipe the FEC packet will be output on
+ * @param uref last protected packet, to copy the attributes from
+ * @param timestamp RTP timestamp of the last protected packet
+ * @param row true for a row FEC packet
+ * @return FEC packet, or NULL in case of allocation error
+ */
+static struct uref *upipe_rtp_fec_enc_acc_finish(struct upipe *upipe,
+        struct upipe_rtp_fec_enc_acc *acc, struct upipe_rtp_fec_enc_sub *sub,
+        struct uref *uref, uint32_t timestamp, bool row)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_upipe(upipe);
+    uint8_t *rtp = acc->buffer;
+    rtp_set_hdr(rtp);
+    rtp_set_type(rtp, FEC_ENC_TYPE);
+    rtp_set_seqnum(rtp, sub->seqnum++);
+    rtp_set_timestamp(rtp, timestamp);
+
+    uint8_t *fec = rtp + RTP_HEADER_SIZE;
+    smpte_fec_set_snbase_low(fec, acc->snbase);
+    smpte_fec_set_length_rec(fec, acc->length_rec);
+    smpte_fec_set_e(fec);
+    smpte_fec_set_pt_recovery(fec, acc->pt_rec);
+    smpte_fec_set_ts_recovery(fec, acc->ts_rec);
+    if (row) {
+        smpte_fec_set_d(fec);
+        smpte_fec_set_offset(fec, 1);
+        smpte_fec_set_na(fec, upipe_rtp_fec_enc->cols);
+    } else {
+        smpte_fec_set_offset(fec, upipe_rtp_fec_enc->cols);
+        smpte_fec_set_na(fec, upipe_rtp_fec_enc->rows);
+    }
+
+    struct ubuf *ubuf = acc->ubuf;
+    acc->ubuf = NULL;
+    ubuf_block_unmap(ubuf, 0);
+    ubuf_block_resize(ubuf, 0, FEC_ENC_HEADER_SIZE + acc->size);
+
+    struct uref *fec_uref = uref_fork(uref, ubuf);
+    if (unlikely(fec_uref == NULL)) {
+        ubuf_free(ubuf);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+    }
+    return fec_uref;
+}
+
+/** @internal @This handles input packets.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtp_fec_enc_input(struct upipe *upipe, struct uref *uref,
+                                    struct upump **upump_p)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_upipe(upipe);
+    struct upipe_rtp_fec_enc_sub *col_sub = &upipe_rtp_fec_enc->col_sub;
+    struct upipe_rtp_fec_enc_sub *row_sub = &upipe_rtp_fec_enc->row_sub;
+    struct uref *col_fec = NULL, *row_fec = NULL;
+
+    uint8_t rtp_buffer[RTP_HEADER_SIZE];
+    const uint8_t *rtp_header = uref_block_peek(uref, 0, RTP_HEADER_SIZE,
+                                                rtp_buffer);
+    size_t size = 0;
+    if (unlikely(rtp_header == NULL ||
+                 !ubase_check(uref_block_size(uref, &size)))) {
+        upipe_warn(upipe, "invalid buffer received");
+        uref_free(uref);
+        return;
+    }
+    uint16_t seqnum = rtp_get_seqnum(rtp_header);
+    uint8_t type = rtp_get_type(rtp_header);
+    uint32_t timestamp = rtp_get_timestamp(rtp_header);
+    uref_block_peek_unmap(uref, 0, rtp_buffer, rtp_header);
+
+    int payload_size = size - RTP_HEADER_SIZE;
+    if (unlikely(payload_size > FEC_ENC_MAX_PAYLOAD)) {
+        upipe_warn_va(upipe, "payload too large (%d), not protected",
+                      payload_size);
+        upipe_rtp_fec_enc_reset(upipe);
+        goto output;
+    }
+
+    if (upipe_rtp_fec_enc->position &&
+        seqnum != upipe_rtp_fec_enc->next_seqnum) {
+        upipe_warn_va(upipe, "discontinuity, expected seqnum %hu got %hu",
+                      upipe_rtp_fec_enc->next_seqnum, seqnum);
+        upipe_rtp_fec_enc_reset(upipe);
+    }
+    upipe_rtp_fec_enc->next_seqnum = seqnum + 1;
+
+    unsigned int col = upipe_rtp_fec_enc->position % upipe_rtp_fec_enc->cols;
+    unsigned int row = upipe_rtp_fec_enc->position / upipe_rtp_fec_enc->cols;
+    upipe_rtp_fec_enc->position = (upipe_rtp_fec_enc->position + 1) %
+        (upipe_rtp_fec_enc->cols * upipe_rtp_fec_enc->rows);
+
+    /* column FEC */
+    struct upipe_rtp_fec_enc_acc *acc = &upipe_rtp_fec_enc->col_acc[col];
+    if (!row) {
+        upipe_rtp_fec_enc_acc_clean(acc);
+        upipe_rtp_fec_enc_acc_reset(acc, seqnum);
+        if (unlikely(!ubase_check(upipe_rtp_fec_enc_acc_alloc(acc,
+                            uref->ubuf->mgr)))) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            upipe_rtp_fec_enc_reset(upipe);
+            goto output;
+        }
+    }
+    if (acc->ubuf != NULL) {
+        upipe_rtp_fec_enc_acc_add(acc, type, timestamp, payload_size);
+        if (unlikely(!ubase_check(upipe_rtp_fec_enc_xor_ubuf(
+                            acc->buffer + FEC_ENC_HEADER_SIZE, uref->ubuf,
+                            payload_size)))) {
+            upipe_warn(upipe, "unable to read packet");
+            upipe_rtp_fec_enc_reset(upipe);
+            goto output;
+        }
+        if (row == upipe_rtp_fec_enc->rows - 1)
+            col_fec = upipe_rtp_fec_enc_acc_finish(upipe, acc, col_sub, uref,
+                                                   timestamp, false);
+    }
+
+    /* row FEC, optional */
+    acc = &upipe_rtp_fec_enc->row_acc;
+    if (!col) {
+        upipe_rtp_fec_enc_clean_row(upipe);
+        upipe_rtp_fec_enc_acc_reset(acc, seqnum);
+    }
+    if (row_sub->output == NULL || upipe_rtp_fec_enc->nb_row_ubufs != col)
+        goto output;
+
+    struct ubuf *ubuf = ubuf_dup(uref->ubuf);
+    if (unlikely(ubuf == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        goto output;
+    }
+    upipe_rtp_fec_enc->row_ubufs[upipe_rtp_fec_enc->nb_row_ubufs++] = ubuf;
+    upipe_rtp_fec_enc_acc_add(acc, type, timestamp, payload_size);
+
+    if (col == upipe_rtp_fec_enc->cols - 1) {
+        if (unlikely(!ubase_check(upipe_rtp_fec_enc_acc_alloc(acc,
+                            uref->ubuf->mgr)))) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        } else {
+            upipe_rtp_fec_enc_xor_row(upipe);
+            row_fec = upipe_rtp_fec_enc_acc_finish(upipe, acc, row_sub, uref,
+                                                   timestamp, true);
+        }
+        upipe_rtp_fec_enc_clean_row(upipe);
+    }
+
+output:
+    upipe_rtp_fec_enc_output(upipe, uref, upump_p);
+    if (col_fec != NULL)
+        upipe_rtp_fec_enc_sub_output(upipe_rtp_fec_enc_sub_to_upipe(col_sub),
+                                     col_fec, upump_p);
+    if (row_fec != NULL)
+        upipe_rtp_fec_enc_sub_output(upipe_rtp_fec_enc_sub_to_upipe(row_sub),
+                                     row_fec, upump_p);
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_rtp_fec_enc_set_flow_def(struct upipe *upipe,
+                                          struct uref *flow_def)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_upipe(upipe);
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, EXPECTED_FLOW_DEF))
+
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup)
+    upipe_rtp_fec_enc_store_flow_def(upipe, flow_def_dup);
+
+    struct upipe_rtp_fec_enc_sub *subs[] = {
+        &upipe_rtp_fec_enc->col_sub, &upipe_rtp_fec_enc->row_sub
+    };
+    for (unsigned int i = 0; i < UBASE_ARRAY_SIZE(subs); i++) {
+        flow_def_dup = uref_dup(flow_def);
+        UBASE_ALLOC_RETURN(flow_def_dup)
+        upipe_rtp_fec_enc_sub_store_flow_def(
+                upipe_rtp_fec_enc_sub_to_upipe(subs[i]), flow_def_dup);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the size of the FEC matrix.
+ *
+ * @param upipe description structure of the pipe
+ * @param cols number of columns (L)
+ * @param rows number of rows (D)
+ * @return an error code
+ */
+static int _upipe_rtp_fec_enc_set_matrix(struct upipe *upipe,
+                                         unsigned int cols, unsigned int rows)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_upipe(upipe);
+    if (!cols || cols > FEC_ENC_MAX || rows < 4 || rows > FEC_ENC_MAX ||
+        cols * rows > FEC_ENC_MAX_PACKETS) {
+        upipe_err_va(upipe, "invalid matrix %ux%u", cols, rows);
+        return UBASE_ERR_INVALID;
+    }
+    upipe_rtp_fec_enc_reset(upipe);
+    upipe_rtp_fec_enc->cols = cols;
+    upipe_rtp_fec_enc->rows = rows;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a FEC output subpipe.
+ *
+ * @param upipe description structure of the subpipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_rtp_fec_enc_sub_control(struct upipe *upipe,
+                                         int command, va_list args)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_sub_mgr(upipe->mgr);
+
+    UBASE_HANDLED_RETURN(upipe_rtp_fec_enc_sub_control_output(upipe, command,
+                                                              args));
+    switch (command) {
+        case UPIPE_SUB_GET_SUPER: {
+            struct upipe **p = va_arg(args, struct upipe **);
+            *p = upipe_rtp_fec_enc_to_upipe(upipe_rtp_fec_enc);
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This initializes a FEC output subpipe.
+ *
+ * @param upipe description structure of the super pipe
+ * @param sub subpipe
+ * @param uprobe structure used to raise events by the subpipe
+ */
+static void upipe_rtp_fec_enc_sub_init(struct upipe *upipe,
+                                       struct upipe_rtp_fec_enc_sub *sub,
+                                       struct uprobe *uprobe)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_upipe(upipe);
+    struct upipe *subpipe = upipe_rtp_fec_enc_sub_to_upipe(sub);
+    upipe_init(subpipe, &upipe_rtp_fec_enc->sub_mgr, uprobe);
+    subpipe->refcount = &upipe_rtp_fec_enc->urefcount;
+    upipe_rtp_fec_enc_sub_init_output(subpipe);
+    sub->seqnum = 0;
+    upipe_throw_ready(subpipe);
+}
+
+/** @internal @This cleans up a FEC output subpipe.
+ *
+ * @param sub subpipe
+ */
+static void upipe_rtp_fec_enc_sub_clean(struct upipe_rtp_fec_enc_sub *sub)
+{
+    struct upipe *subpipe = upipe_rtp_fec_enc_sub_to_upipe(sub);
+    upipe_throw_dead(subpipe);
+    upipe_rtp_fec_enc_sub_clean_output(subpipe);
+    upipe_clean(subpipe);
+}
+
+/** @internal @This initializes the manager of the FEC output subpipes.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_rtp_fec_enc_init_sub_mgr(struct upipe *upipe)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_upipe(upipe);
+    struct upipe_mgr *sub_mgr = &upipe_rtp_fec_enc->sub_mgr;
+    /* the subpipes live as long as the super pipe */
+    sub_mgr->refcount = NULL;
+    sub_mgr->signature = UPIPE_RTP_FEC_ENC_OUTPUT_SIGNATURE;
+    sub_mgr->upipe_alloc = NULL;
+    sub_mgr->upipe_input = NULL;
+    sub_mgr->upipe_control = upipe_rtp_fec_enc_sub_control;
+    sub_mgr->upipe_mgr_control = NULL;
+}
+
+/** @internal @This allocates a rtp fec enc pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *_upipe_rtp_fec_enc_alloc(struct upipe_mgr *mgr,
+                                              struct uprobe *uprobe,
+                                              uint32_t signature,
+                                              va_list args)
+{
+    if (signature != UPIPE_RTP_FEC_ENC_SIGNATURE) {
+        uprobe_release(uprobe);
+        return NULL;
+    }
+    struct uprobe *uprobe_col = va_arg(args, struct uprobe *);
+    struct uprobe *uprobe_row = va_arg(args, struct uprobe *);
+
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        calloc(1, sizeof(struct upipe_rtp_fec_enc));
+    if (unlikely(upipe_rtp_fec_enc == NULL)) {
+        uprobe_release(uprobe);
+        uprobe_release(uprobe_col);
+        uprobe_release(uprobe_row);
+        return NULL;
+    }
+
+    struct upipe *upipe = upipe_rtp_fec_enc_to_upipe(upipe_rtp_fec_enc);
+    upipe_init(upipe, mgr, uprobe);
+    upipe_rtp_fec_enc_init_urefcount(upipe);
+    upipe_rtp_fec_enc_init_output(upipe);
+    upipe_rtp_fec_enc_init_sub_mgr(upipe);
+
+    upipe_rtp_fec_enc->cols = DEFAULT_COLS;
+    upipe_rtp_fec_enc->rows = DEFAULT_ROWS;
+    upipe_rtp_fec_enc->position = 0;
+    upipe_rtp_fec_enc->next_seqnum = 0;
+    upipe_rtp_fec_enc->nb_row_ubufs = 0;
+
+    upipe_rtp_fec_enc_sub_init(upipe, &upipe_rtp_fec_enc->col_sub,
+                               uprobe_col);
+    upipe_rtp_fec_enc_sub_init(upipe, &upipe_rtp_fec_enc->row_sub,
+                               uprobe_row);
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This processes control commands on a rtp fec enc pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_rtp_fec_enc_control(struct upipe *upipe,
+                                     int command, va_list args)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_upipe(upipe);
+
+    UBASE_HANDLED_RETURN(upipe_rtp_fec_enc_control_output(upipe, command,
+                                                          args));
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_rtp_fec_enc_set_flow_def(upipe, flow_def);
+        }
+
+        case UPIPE_RTP_FEC_ENC_GET_COL_SUB: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_FEC_ENC_SIGNATURE)
+            struct upipe **upipe_p = va_arg(args, struct upipe **);
+            *upipe_p = upipe_rtp_fec_enc_sub_to_upipe(
+                    &upipe_rtp_fec_enc->col_sub);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_RTP_FEC_ENC_GET_ROW_SUB: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_FEC_ENC_SIGNATURE)
+            struct upipe **upipe_p = va_arg(args, struct upipe **);
+            *upipe_p = upipe_rtp_fec_enc_sub_to_upipe(
+                    &upipe_rtp_fec_enc->row_sub);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_RTP_FEC_ENC_SET_MATRIX: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_FEC_ENC_SIGNATURE)
+            unsigned int cols = va_arg(args, unsigned int);
+            unsigned int rows = va_arg(args, unsigned int);
+            return _upipe_rtp_fec_enc_set_matrix(upipe, cols, rows);
+        }
+        case UPIPE_RTP_FEC_ENC_GET_MATRIX: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_FEC_ENC_SIGNATURE)
+            unsigned int *cols_p = va_arg(args, unsigned int *);
+            unsigned int *rows_p = va_arg(args, unsigned int *);
+            if (cols_p != NULL)
+                *cols_p = upipe_rtp_fec_enc->cols;
+            if (rows_p != NULL)
+                *rows_p = upipe_rtp_fec_enc->rows;
+            return UBASE_ERR_NONE;
+        }
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_rtp_fec_enc_free(struct upipe *upipe)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_upipe(upipe);
+
+    upipe_throw_dead(upipe);
+
+    upipe_rtp_fec_enc_reset(upipe);
+    upipe_rtp_fec_enc_sub_clean(&upipe_rtp_fec_enc->col_sub);
+    upipe_rtp_fec_enc_sub_clean(&upipe_rtp_fec_enc->row_sub);
+
+    upipe_rtp_fec_enc_clean_output(upipe);
+    upipe_rtp_fec_enc_clean_urefcount(upipe);
+    upipe_clean(upipe);
+    free(upipe_rtp_fec_enc);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_rtp_fec_enc_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_RTP_FEC_ENC_SIGNATURE,
+
+    .upipe_alloc = _upipe_rtp_fec_enc_alloc,
+    .upipe_input = upipe_rtp_fec_enc_input,
+    .upipe_control = upipe_rtp_fec_enc_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for rtp fec enc pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_rtp_fec_enc_mgr_alloc(void)
+{
+    return &upipe_rtp_fec_enc_mgr;
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe multi-source XOR kernels for SMPTE 2022-1 FEC recovery
+ *
+ * Each block of the destination is loaded once in registers, XORed with
+ * the same block of every source, and stored once, instead of reading and
+ * writing the destination again for every source packet.
+ */
+
+#include <upipe/ubase.h>
+
+#include "upipe_rtp_fec_xor.h"
+
+#include <string.h>
+
+#if defined(__i686__) || defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/** @This XORs several buffers into a destination buffer, eight octets at a
+ * time.
+ *
+ * @param dst destination buffer
+ * @param src array of source buffers, each at least size octets long
+ * @param nb_src number of source buffers
+ * @param size number of octets to process
+ */
+void upipe_rtp_fec_xor_c(uint8_t *dst, const uint8_t *const *src,
+                         unsigned int nb_src, size_t size)
+{
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t acc, word;
+        memcpy(&acc, dst + i, sizeof(acc));
+        for (unsigned int j = 0; j < nb_src; j++) {
+            memcpy(&word, src[j] + i, sizeof(word));
+            acc ^= word;
+        }
+        memcpy(dst + i, &acc, sizeof(acc));
+    }
+    for (; i < size; i++) {
+        uint8_t acc = dst[i];
+        for (unsigned int j = 0; j < nb_src; j++)
+            acc ^= src[j][i];
+        dst[i] = acc;
+    }
+}
+
+/** @internal @This processes the last octets with the portable version.
+ *
+ * @param dst destination buffer
+ * @param src array of source buffers
+ * @param nb_src number of source buffers
+ * @param offset first octet to process
+ * @param size number of octets of the buffers
+ */
+static inline void upipe_rtp_fec_xor_tail(uint8_t *dst,
+                                          const uint8_t *const *src,
+                                          unsigned int nb_src,
+                                          size_t offset, size_t size)
+{
+    const uint8_t *tail[nb_src];
+    for (unsigned int j = 0; j < nb_src; j++)
+        tail[j] = src[j] + offset;
+    upipe_rtp_fec_xor_c(dst + offset, tail, nb_src, size - offset);
+}
+
+#if defined(__i686__) || defined(__x86_64__)
+__attribute__((target("sse2")))
+void upipe_rtp_fec_xor_sse2(uint8_t *dst, const uint8_t *const *src,
+                            unsigned int nb_src, size_t size)
+{
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        __m128i a0 = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i a1 = _mm_loadu_si128((const __m128i *)(dst + i + 16));
+        __m128i a2 = _mm_loadu_si128((const __m128i *)(dst + i + 32));
+        __m128i a3 = _mm_loadu_si128((const __m128i *)(dst + i + 48));
+        for (unsigned int j = 0; j < nb_src; j++) {
+            const uint8_t *s = src[j] + i;
+            a0 = _mm_xor_si128(a0, _mm_loadu_si128((const __m128i *)s));
+            a1 = _mm_xor_si128(a1, _mm_loadu_si128((const __m128i *)(s + 16)));
+            a2 = _mm_xor_si128(a2, _mm_loadu_si128((const __m128i *)(s + 32)));
+            a3 = _mm_xor_si128(a3, _mm_loadu_si128((const __m128i *)(s + 48)));
+        }
+        _mm_storeu_si128((__m128i *)(dst + i), a0);
+        _mm_storeu_si128((__m128i *)(dst + i + 16), a1);
+        _mm_storeu_si128((__m128i *)(dst + i + 32), a2);
+        _mm_storeu_si128((__m128i *)(dst + i + 48), a3);
+    }
+    for (; i + 16 <= size; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(dst + i));
+        for (unsigned int j = 0; j < nb_src; j++)
+            a = _mm_xor_si128(a, _mm_loadu_si128((const __m128i *)(src[j] + i)));
+        _mm_storeu_si128((__m128i *)(dst + i), a);
+    }
+    if (i < size)
+        upipe_rtp_fec_xor_tail(dst, src, nb_src, i, size);
+}
+
+__attribute__((target("avx2")))
+void upipe_rtp_fec_xor_avx2(uint8_t *dst, const uint8_t *const *src,
+                            unsigned int nb_src, size_t size)
+{
+    size_t i = 0;
+    for (; i + 128 <= size; i += 128) {
+        __m256i a0 = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i a1 = _mm256_loadu_si256((const __m256i *)(dst + i + 32));
+        __m256i a2 = _mm256_loadu_si256((const __m256i *)(dst + i + 64));
+        __m256i a3 = _mm256_loadu_si256((const __m256i *)(dst + i + 96));
+        for (unsigned int j = 0; j < nb_src; j++) {
+            const uint8_t *s = src[j] + i;
+            a0 = _mm256_xor_si256(a0,
+                    _mm256_loadu_si256((const __m256i *)s));
+            a1 = _mm256_xor_si256(a1,
+                    _mm256_loadu_si256((const __m256i *)(s + 32)));
+            a2 = _mm256_xor_si256(a2,
+                    _mm256_loadu_si256((const __m256i *)(s + 64)));
+            a3 = _mm256_xor_si256(a3,
+                    _mm256_loadu_si256((const __m256i *)(s + 96)));
+        }
+        _mm256_storeu_si256((__m256i *)(dst + i), a0);
+        _mm256_storeu_si256((__m256i *)(dst + i + 32), a1);
+        _mm256_storeu_si256((__m256i *)(dst + i + 64), a2);
+        _mm256_storeu_si256((__m256i *)(dst + i + 96), a3);
+    }
+    for (; i + 32 <= size; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(dst + i));
+        for (unsigned int j = 0; j < nb_src; j++)
+            a = _mm256_xor_si256(a,
+                    _mm256_loadu_si256((const __m256i *)(src[j] + i)));
+        _mm256_storeu_si256((__m256i *)(dst + i), a);
+    }
+    if (i < size)
+        upipe_rtp_fec_xor_tail(dst, src, nb_src, i, size);
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+void upipe_rtp_fec_xor_neon(uint8_t *dst, const uint8_t *const *src,
+                            unsigned int nb_src, size_t size)
+{
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        uint8x16x4_t a = vld1q_u8_x4(dst + i);
+        for (unsigned int j = 0; j < nb_src; j++) {
+            uint8x16x4_t s = vld1q_u8_x4(src[j] + i);
+            a.val[0] = veorq_u8(a.val[0], s.val[0]);
+            a.val[1] = veorq_u8(a.val[1], s.val[1]);
+            a.val[2] = veorq_u8(a.val[2], s.val[2]);
+            a.val[3] = veorq_u8(a.val[3], s.val[3]);
+        }
+        vst1q_u8_x4(dst + i, a);
+    }
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t a = vld1q_u8(dst + i);
+        for (unsigned int j = 0; j < nb_src; j++)
+            a = veorq_u8(a, vld1q_u8(src[j] + i));
+        vst1q_u8(dst + i, a);
+    }
+    if (i < size)
+        upipe_rtp_fec_xor_tail(dst, src, nb_src, i, size);
+}
+#endif
+
+/** @This XORs several buffers into a destination buffer, using the fastest
+ * implementation supported by the CPU.
+ *
+ * @param dst destination buffer
+ * @param src array of source buffers, each at least size octets long
+ * @param nb_src number of source buffers
+ * @param size number of octets to process
+ */
+void upipe_rtp_fec_xor(uint8_t *dst, const uint8_t *const *src,
+                       unsigned int nb_src, size_t size)
+{
+#if defined(__i686__) || defined(__x86_64__)
+    if (size >= 32 && __builtin_cpu_supports("avx2")) {
+        upipe_rtp_fec_xor_avx2(dst, src, nb_src, size);
+        return;
+    }
+    if (size >= 16 && __builtin_cpu_supports("sse2")) {
+        upipe_rtp_fec_xor_sse2(dst, src, nb_src, size);
+        return;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    if (size >= 16) {
+        upipe_rtp_fec_xor_neon(dst, src, nb_src, size);
+        return;
+    }
+#endif
+    upipe_rtp_fec_xor_c(dst, src, nb_src, size);
+}
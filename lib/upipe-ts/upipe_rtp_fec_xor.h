@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe multi-source XOR kernels for SMPTE 2022-1 FEC recovery
+ * A lost packet is rebuilt by XORing the payload of a FEC packet with the
+ * payloads of the L or D other packets it protects. The variants below
+ * combine all the sources in a single pass over the destination.
+ */
+
+#ifndef _UPIPE_TS_UPIPE_RTP_FEC_XOR_H_
+/** @hidden */
+#define _UPIPE_TS_UPIPE_RTP_FEC_XOR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** @This XORs several buffers into a destination buffer.
+ *
+ * @param dst destination buffer
+ * @param src array of source buffers, each at least size octets long
+ * @param nb_src number of source buffers
+ * @param size number of octets to process
+ */
+typedef void (*upipe_rtp_fec_xor_func)(uint8_t *dst,
+                                       const uint8_t *const *src,
+                                       unsigned int nb_src, size_t size);
+
+/* eight octets at a time */
+void upipe_rtp_fec_xor_c(uint8_t *dst, const uint8_t *const *src,
+                         unsigned int nb_src, size_t size);
+
+#if defined(__i686__) || defined(__x86_64__)
+/* 64 or 128 octets at a time */
+void upipe_rtp_fec_xor_sse2(uint8_t *dst, const uint8_t *const *src,
+                            unsigned int nb_src, size_t size);
+void upipe_rtp_fec_xor_avx2(uint8_t *dst, const uint8_t *const *src,
+                            unsigned int nb_src, size_t size);
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/* 64 octets at a time */
+void upipe_rtp_fec_xor_neon(uint8_t *dst, const uint8_t *const *src,
+                            unsigned int nb_src, size_t size);
+#endif
+
+/** @This XORs several buffers into a destination buffer, using the fastest
+ * implementation supported by the CPU.
+ *
+ * @param dst destination buffer
+ * @param src array of source buffers, each at least size octets long
+ * @param nb_src number of source buffers
+ * @param size number of octets to process
+ */
+void upipe_rtp_fec_xor(uint8_t *dst, const uint8_t *const *src,
+                       unsigned int nb_src, size_t size);
+
+#endif
@@ -39,6 +39,7 @@
 #include <upipe-ts/upipe_ts_align.h>
 #include <upipe-ts/upipe_ts_sync.h>
 #include <upipe-ts/upipe_ts_check.h>
+#include <upipe-ts/uref_ts_burst.h>
 #include <upipe-modules/upipe_idem.h>
 
 #include <stdlib.h>
@@ -52,6 +53,8 @@
 #define EXPECTED_FLOW_DEF "block."
 /** but already sync'ed TS packets are better */
 #define EXPECTED_FLOW_DEF_SYNC "block.mpegts."
+/** as well as bursts of sync'ed TS packets */
+#define EXPECTED_FLOW_DEF_BURST UREF_TS_BURST_FLOW_DEF
 /** or otherwise aligned TS packets to check */
 #define EXPECTED_FLOW_DEF_CHECK "block.mpegtsaligned."
 
@@ -156,7 +159,8 @@ static int upipe_ts_align_set_flow_def(struct upipe *upipe,
 
     struct upipe_mgr *inner_mgr;
     const char *inner_name;
-    if (!ubase_ncmp(def, EXPECTED_FLOW_DEF_SYNC)) {
+    if (!ubase_ncmp(def, EXPECTED_FLOW_DEF_SYNC) ||
+        !ubase_ncmp(def, EXPECTED_FLOW_DEF_BURST)) {
         inner_mgr = upipe_idem_mgr_alloc();
         inner_name = "idem";
     } else if (!ubase_ncmp(def, EXPECTED_FLOW_DEF_CHECK)) {
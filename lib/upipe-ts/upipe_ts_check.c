@@ -134,6 +134,7 @@ static bool upipe_ts_check_check(struct upipe *upipe, struct uref *uref,
     uref_block_unmap(uref, 0);
     if (word != TS_SYNC) {
         uref_free(uref);
+        upipe_stats_error(upipe, 1);
         upipe_warn_va(upipe, "invalid TS sync 0x%"PRIx8, word);
         return false;
     }
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe CRC-32/MPEG-2 computation for PSI sections
+ * The functions below replace psi_set_crc() and psi_check_crc() from
+ * bitstream, which compute the CRC one octet at a time.
+ */
+
+#ifndef _UPIPE_TS_UPIPE_TS_CRC_H_
+/** @hidden */
+#define _UPIPE_TS_UPIPE_TS_CRC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <bitstream/mpeg/psi.h>
+
+/** @This updates a CRC-32/MPEG-2 with a buffer, eight octets at a time.
+ *
+ * @param crc current value of the CRC, or 0xffffffff to start a new one
+ * @param buffer buffer to compute the CRC of
+ * @param size size of the buffer
+ * @return updated value of the CRC
+ */
+uint32_t upipe_ts_crc32_c(uint32_t crc, const uint8_t *buffer, size_t size);
+
+#if defined(__i686__) || defined(__x86_64__)
+/** @This updates a CRC-32/MPEG-2 with a buffer, using carry-less
+ * multiplications (PCLMULQDQ and SSSE3).
+ *
+ * @param crc current value of the CRC, or 0xffffffff to start a new one
+ * @param buffer buffer to compute the CRC of
+ * @param size size of the buffer
+ * @return updated value of the CRC
+ */
+uint32_t upipe_ts_crc32_pclmul(uint32_t crc, const uint8_t *buffer,
+                               size_t size);
+#endif
+
+/** @This updates a CRC-32/MPEG-2 with a buffer, using the fastest
+ * implementation supported by the CPU.
+ *
+ * @param crc current value of the CRC, or 0xffffffff to start a new one
+ * @param buffer buffer to compute the CRC of
+ * @param size size of the buffer
+ * @return updated value of the CRC
+ */
+uint32_t upipe_ts_crc32(uint32_t crc, const uint8_t *buffer, size_t size);
+
+/** @This computes the CRC of a PSI section and writes it at the end of the
+ * section, like psi_set_crc().
+ *
+ * @param section PSI section
+ */
+static inline void upipe_ts_psi_set_crc(uint8_t *section)
+{
+    uint16_t size = psi_get_length(section) + PSI_HEADER_SIZE - PSI_CRC_SIZE;
+    uint32_t crc = upipe_ts_crc32(0xffffffff, section, size);
+    section[size] = crc >> 24;
+    section[size + 1] = crc >> 16;
+    section[size + 2] = crc >> 8;
+    section[size + 3] = crc;
+}
+
+/** @This checks the CRC at the end of a PSI section, like psi_check_crc().
+ *
+ * @param section PSI section
+ * @return true if the CRC is correct
+ */
+static inline bool upipe_ts_psi_check_crc(const uint8_t *section)
+{
+    uint16_t size = psi_get_length(section) + PSI_HEADER_SIZE - PSI_CRC_SIZE;
+    uint32_t crc = upipe_ts_crc32(0xffffffff, section, size);
+    return section[size] == (uint8_t)(crc >> 24) &&
+           section[size + 1] == (uint8_t)(crc >> 16) &&
+           section[size + 2] == (uint8_t)(crc >> 8) &&
+           section[size + 3] == (uint8_t)crc;
+}
+
+#endif
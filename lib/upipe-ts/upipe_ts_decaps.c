@@ -200,6 +200,7 @@ static void upipe_ts_decaps_input(struct upipe *upipe, struct uref *uref,
         }
         upipe_warn_va(upipe, "potentially lost 16 packets");
         upipe_ts_decaps->lost += 16;
+        upipe_stats_error(upipe, 1);
         discontinuity = true;
     }
 
@@ -207,6 +208,7 @@ static void upipe_ts_decaps_input(struct upipe *upipe, struct uref *uref,
                  ts_check_discontinuity(cc, upipe_ts_decaps->last_cc))) {
         int lost = (0x10 + cc - upipe_ts_decaps->last_cc - 1) & 0xf;
         upipe_ts_decaps->lost += lost;
+        upipe_stats_error(upipe, 1);
         upipe_warn_va(upipe, "potentially lost %d packets", lost);
         discontinuity = true;
     }
@@ -43,6 +43,7 @@
 #include <upipe/uprobe.h>
 #include <upipe/uprobe_prefix.h>
 #include <upipe/uref.h>
+#include <upipe/uref_attr.h>
 #include <upipe/uref_block.h>
 #include <upipe/uref_flow.h>
 #include <upipe/uref_block_flow.h>
@@ -65,10 +66,14 @@
 #include <upipe/upipe_helper_subpipe.h>
 #include <upipe-modules/upipe_null.h>
 #include <upipe-modules/upipe_setrap.h>
+#include <upipe-modules/upipe_setattr.h>
 #include <upipe-modules/upipe_idem.h>
 #include <upipe-modules/upipe_setflowdef.h>
+#include <upipe-modules/upipe_worker_linear.h>
+#include <upipe-modules/upipe_worker_pool.h>
 #include <upipe-ts/uref_ts_flow.h>
 #include <upipe-ts/uref_ts_event.h>
+#include <upipe-ts/uref_ts_burst.h>
 #include <upipe-ts/upipe_ts_demux.h>
 #include <upipe-ts/upipe_ts_split.h>
 #include <upipe-ts/upipe_ts_sync.h>
@@ -101,6 +106,8 @@
 #define EXPECTED_FLOW_DEF_SYNC "block.mpegts."
 /** or otherwise aligned TS packets to check */
 #define EXPECTED_FLOW_DEF_CHECK "block.mpegtsaligned."
+/** bursts of sync'ed TS packets are directly demuxed by ts_split */
+#define EXPECTED_FLOW_DEF_BURST UREF_TS_BURST_FLOW_DEF
 /** maximum number of PIDs */
 #define MAX_PIDS 8192
 /** 2^33 (max resolution of PCR, PTS and DTS) */
@@ -114,6 +121,8 @@
 #define MAX_DELAY UCLOCK_FREQ
 /** number of EITs table IDs */
 #define EITS_TABLEIDS 16
+UREF_ATTR_UNSIGNED(ts_demux, pcr, "tsd.pcr", last PCR of the program)
+UREF_ATTR_INT(ts_demux, offset, "tsd.offset", timestamp offset of the program)
 
 /** @internal @This is the private context of a ts_demux manager. */
 struct upipe_ts_demux_mgr {
@@ -124,6 +133,8 @@ struct upipe_ts_demux_mgr {
     struct upipe_mgr *null_mgr;
     /** pointer to setrap manager */
     struct upipe_mgr *setrap_mgr;
+    /** pointer to setattr manager */
+    struct upipe_mgr *setattr_mgr;
     /** pointer to idem manager */
     struct upipe_mgr *idem_mgr;
 
@@ -165,6 +176,10 @@ struct upipe_ts_demux_mgr {
     /** pointer to autof manager */
     struct upipe_mgr *autof_mgr;
 
+    /* workers */
+    /** pool of worker threads */
+    struct upipe_work_pool workers;
+
     /** public upipe_mgr structure */
     struct upipe_mgr mgr;
 };
@@ -220,6 +235,8 @@ struct upipe_ts_demux {
     struct upipe *patd;
     /** list of available programs (from PAT) */
     struct uchain pat_programs;
+    /** list of PMT sections from a snapshot, waiting for their program */
+    struct uchain snapshot_pmts;
 
     /** psi_pid structure for NIT */
     struct upipe_ts_demux_psi_pid *psi_pid_nit;
@@ -351,10 +368,17 @@ struct upipe_ts_demux_program {
     /** PCR ts_split output inner pipe */
     struct upipe *pcr_split_output;
 
+    /** wlin manager of the worker thread, or NULL */
+    struct upipe_mgr *worker_mgr;
+    /** probe hierarchy used in the worker thread */
+    struct uprobe *uprobe_worker;
+
     /** offset between MPEG timestamps and Upipe timestamps */
     int64_t timestamp_offset;
     /** last MPEG clock reference */
     uint64_t last_pcr;
+    /** system date of the last MPEG clock reference, for jitter */
+    uint64_t last_pcr_sys;
     /** highest Upipe timestamp given to a frame */
     uint64_t timestamp_highest;
 
@@ -413,7 +437,9 @@ struct upipe_ts_demux_output {
     struct upipe *split_output;
     /** setrap inner pipe */
     struct upipe *setrap;
-    /** decaps inner pipe */
+    /** setattr inner pipe giving the clock of the program to the worker */
+    struct upipe *setattr;
+    /** decaps inner pipe, or wlin pipe if running in a worker thread */
     struct upipe *decaps;
 
     /** maximum retention time in the pipeline */
@@ -603,6 +629,126 @@ static void
 }
 
 
+/*
+ * upipe_ts_demux_remote structure handling
+ */
+
+/** @internal @This is the context of the probe catching events from the
+ * inner pipes of an output running in a worker thread. */
+struct upipe_ts_demux_remote {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** maximum retention time in the pipeline */
+    uint64_t max_delay;
+    /** probe structure */
+    struct uprobe uprobe;
+};
+
+UBASE_FROM_TO(upipe_ts_demux_remote, uprobe, uprobe, uprobe)
+UBASE_FROM_TO(upipe_ts_demux_remote, urefcount, urefcount, urefcount)
+
+/** @internal @This catches clock_ts events coming from inner pipes running
+ * in a worker thread, and converts the dates with the clock of the program
+ * stored in the uref by the setattr inner pipe.
+ *
+ * @param uprobe pointer to the probe in upipe_ts_demux_remote
+ * @param inner pointer to the inner pipe
+ * @param event event triggered by the inner pipe
+ * @param args arguments of the event
+ * @return an error code
+ */
+static int upipe_ts_demux_remote_clock_ts(struct uprobe *uprobe,
+                                          struct upipe *inner,
+                                          int event, va_list args)
+{
+    struct upipe_ts_demux_remote *remote =
+        upipe_ts_demux_remote_from_uprobe(uprobe);
+    struct uref *uref = va_arg(args, struct uref *);
+    uint64_t dts_orig, last_pcr;
+    int64_t timestamp_offset;
+    if (ubase_check(uref_clock_get_dts_orig(uref, &dts_orig)) &&
+        ubase_check(uref_ts_demux_get_pcr(uref, &last_pcr)) &&
+        ubase_check(uref_ts_demux_get_offset(uref, &timestamp_offset))) {
+        /* handle 2^33 wrap-arounds */
+        uint64_t delta = (TS_CLOCK_MAX + dts_orig -
+                          (last_pcr % TS_CLOCK_MAX)) % TS_CLOCK_MAX;
+        if (delta <= remote->max_delay) {
+            uint64_t dts = timestamp_offset + last_pcr + delta;
+            uref_clock_set_dts_prog(uref, dts);
+            upipe_verbose_va(inner, "read DTS %"PRIu64" -> %"PRIu64,
+                             dts_orig, dts);
+        } else
+            upipe_warn_va(inner, "too long delay for DTS %"PRIu64" (%"PRIu64")",
+                          dts_orig, delta);
+    }
+    uref_ts_demux_delete_pcr(uref);
+    uref_ts_demux_delete_offset(uref);
+
+    return uprobe_throw(uprobe->next, inner, event, uref);
+}
+
+/** @internal @This catches events coming from inner pipes running in a
+ * worker thread.
+ *
+ * @param uprobe pointer to the probe in upipe_ts_demux_remote
+ * @param inner pointer to the inner pipe
+ * @param event event triggered by the inner pipe
+ * @param args arguments of the event
+ * @return an error code
+ */
+static int upipe_ts_demux_remote_probe(struct uprobe *uprobe,
+                                       struct upipe *inner,
+                                       int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_CLOCK_REF:
+            /* the PCR is handled in the thread of the demux */
+            return UBASE_ERR_NONE;
+        case UPROBE_CLOCK_TS:
+            return upipe_ts_demux_remote_clock_ts(uprobe, inner, event, args);
+        default:
+            return uprobe_throw_next(uprobe, inner, event, args);
+    }
+}
+
+/** @internal @This frees a remote probe.
+ *
+ * @param urefcount pointer to urefcount structure
+ */
+static void upipe_ts_demux_remote_free(struct urefcount *urefcount)
+{
+    struct upipe_ts_demux_remote *remote =
+        upipe_ts_demux_remote_from_urefcount(urefcount);
+    uprobe_clean(&remote->uprobe);
+    urefcount_clean(urefcount);
+    free(remote);
+}
+
+/** @internal @This allocates a probe for the inner pipes of an output
+ * running in a worker thread.
+ *
+ * @param next next probe to test if this one doesn't catch the event
+ * (belongs to the callee)
+ * @param max_delay maximum retention time in the pipeline
+ * @return pointer to probe, or NULL in case of allocation error
+ */
+static struct uprobe *upipe_ts_demux_remote_alloc(struct uprobe *next,
+                                                  uint64_t max_delay)
+{
+    struct upipe_ts_demux_remote *remote =
+        malloc(sizeof(struct upipe_ts_demux_remote));
+    if (unlikely(remote == NULL)) {
+        uprobe_release(next);
+        return NULL;
+    }
+    urefcount_init(&remote->urefcount, upipe_ts_demux_remote_free);
+    uprobe_init(&remote->uprobe, upipe_ts_demux_remote_probe, next);
+    remote->uprobe.refcount = &remote->urefcount;
+    remote->max_delay = max_delay;
+    return &remote->uprobe;
+}
+
+
 /*
  * upipe_ts_demux_output structure handling (derived from upipe structure)
  */
@@ -759,6 +905,38 @@ static int upipe_ts_demux_output_plumber(struct upipe *upipe,
         return UBASE_ERR_NONE;
     }
 
+    struct upipe_mgr *worker_mgr = ts_demux_mgr->autof_mgr != NULL ?
+        upipe_work_pool_next(&ts_demux_mgr->workers) : NULL;
+    if (worker_mgr != NULL) {
+        /* allocate autof in a worker thread, the dates are already
+         * converted by the clock events of pesd */
+        struct upipe *remote =
+            upipe_void_alloc(ts_demux_mgr->autof_mgr,
+                uprobe_pfx_alloc_va(uprobe_use(ts_demux_mgr->workers.uprobe),
+                                    UPROBE_LOG_VERBOSE, "autof %"PRIu64,
+                                    upipe_ts_demux_output->pid));
+        if (unlikely(remote == NULL))
+            return UBASE_ERR_ALLOC;
+        struct upipe *output =
+            upipe_work_pool_alloc(worker_mgr,
+                uprobe_pfx_alloc(
+                    uprobe_use(&upipe_ts_demux_output->last_inner_probe),
+                    UPROBE_LOG_VERBOSE, "autof worker"),
+                remote,
+                uprobe_pfx_alloc_va(uprobe_use(ts_demux_mgr->workers.uprobe),
+                                    UPROBE_LOG_VERBOSE, "autof worker %"PRIu64,
+                                    upipe_ts_demux_output->pid));
+        if (unlikely(output == NULL))
+            return UBASE_ERR_ALLOC;
+        int err = upipe_set_output(inner, output);
+        if (unlikely(!ubase_check(err))) {
+            upipe_release(output);
+            return err;
+        }
+        upipe_ts_demux_output_store_bin_output(upipe, output);
+        return UBASE_ERR_NONE;
+    }
+
     if (ts_demux_mgr->autof_mgr != NULL) {
         /* allocate autof inner */
         struct upipe *output =
@@ -813,6 +991,58 @@ static int upipe_ts_demux_output_probe(struct uprobe *uprobe,
     }
 }
 
+/** @internal @This allocates the ts_decaps and ts_pesd inner pipes of an
+ * output in the worker thread of the program.
+ *
+ * @param upipe description structure of the pipe
+ * @return pointer to the wlin pipe, or NULL in case of allocation error
+ */
+static struct upipe *upipe_ts_demux_output_alloc_worker(struct upipe *upipe)
+{
+    struct upipe_ts_demux_output *upipe_ts_demux_output =
+        upipe_ts_demux_output_from_upipe(upipe);
+    struct upipe_ts_demux_program *program =
+        upipe_ts_demux_program_from_output_mgr(upipe->mgr);
+    struct upipe_ts_demux *demux = upipe_ts_demux_from_program_mgr(
+                upipe_ts_demux_program_to_upipe(program)->mgr);
+    struct upipe_ts_demux_mgr *ts_demux_mgr =
+        upipe_ts_demux_mgr_from_upipe_mgr(upipe_ts_demux_to_upipe(demux)->mgr);
+
+    struct uprobe *uprobe_remote =
+        upipe_ts_demux_remote_alloc(uprobe_use(program->uprobe_worker),
+                                    upipe_ts_demux_output->max_delay);
+    if (unlikely(uprobe_remote == NULL))
+        return NULL;
+
+    struct upipe *decaps = upipe_void_alloc(ts_demux_mgr->ts_decaps_mgr,
+            uprobe_pfx_alloc_va(uprobe_use(uprobe_remote),
+                                UPROBE_LOG_VERBOSE, "decaps %"PRIu64,
+                                upipe_ts_demux_output->pid));
+    if (unlikely(decaps == NULL)) {
+        uprobe_release(uprobe_remote);
+        return NULL;
+    }
+    struct upipe *pesd = upipe_void_alloc_output(decaps,
+            ts_demux_mgr->ts_pesd_mgr,
+            uprobe_pfx_alloc_va(uprobe_use(uprobe_remote),
+                                UPROBE_LOG_VERBOSE, "pesd %"PRIu64,
+                                upipe_ts_demux_output->pid));
+    uprobe_release(uprobe_remote);
+    if (unlikely(pesd == NULL)) {
+        upipe_release(decaps);
+        return NULL;
+    }
+    upipe_release(pesd);
+
+    return upipe_work_pool_alloc(program->worker_mgr,
+            uprobe_pfx_alloc(uprobe_use(&upipe_ts_demux_output->probe),
+                             UPROBE_LOG_VERBOSE, "worker"),
+            decaps,
+            uprobe_pfx_alloc_va(uprobe_use(program->uprobe_worker),
+                                UPROBE_LOG_VERBOSE, "worker %"PRIu64,
+                                upipe_ts_demux_output->pid));
+}
+
 /** @internal @This allocates an output subpipe of a ts_demux_program subpipe.
  *
  * @param mgr common management structure
@@ -857,6 +1087,7 @@ static struct upipe *upipe_ts_demux_output_alloc(struct upipe_mgr *mgr,
     upipe_ts_demux_output->pcr = false;
     upipe_ts_demux_output->split_output = NULL;
     upipe_ts_demux_output->setrap = NULL;
+    upipe_ts_demux_output->setattr = NULL;
     upipe_ts_demux_output->max_delay = MAX_DELAY;
     uref_ts_flow_get_max_delay(flow_def, &upipe_ts_demux_output->max_delay);
     uprobe_init(&upipe_ts_demux_output->probe,
@@ -897,7 +1128,26 @@ static struct upipe *upipe_ts_demux_output_alloc(struct upipe_mgr *mgr,
                                    upipe_ts_demux_output->pid))) == NULL))
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
 
-    upipe_ts_demux_output->decaps = upipe_void_alloc(ts_demux_mgr->ts_decaps_mgr,
+    if (program->worker_mgr != NULL && program->pcr_pid != 8191 &&
+        ubase_check(uref_flow_get_def(flow_def, &def)) &&
+        !ubase_ncmp(def, "block.mpegts.mpegtspes.")) {
+        /* the clock of the program is attached to the packets before they
+         * are sent to the worker thread */
+        upipe_ts_demux_output->decaps =
+            upipe_ts_demux_output_alloc_worker(upipe);
+        if (likely(upipe_ts_demux_output->decaps != NULL &&
+                   upipe_ts_demux_output->setrap != NULL) &&
+            unlikely((upipe_ts_demux_output->setattr =
+                upipe_void_alloc_output(upipe_ts_demux_output->setrap,
+                               ts_demux_mgr->setattr_mgr,
+                               uprobe_pfx_alloc_va(
+                                   uprobe_use(&upipe_ts_demux_output->probe),
+                                   UPROBE_LOG_VERBOSE, "setattr %"PRIu64,
+                                   upipe_ts_demux_output->pid))) == NULL))
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+    } else
+        upipe_ts_demux_output->decaps =
+            upipe_void_alloc(ts_demux_mgr->ts_decaps_mgr,
                 uprobe_pfx_alloc(uprobe_use(&upipe_ts_demux_output->probe),
                     UPROBE_LOG_VERBOSE, "decaps"));
     if (unlikely(upipe_ts_demux_output->decaps == NULL))
@@ -1022,6 +1272,8 @@ static void upipe_ts_demux_output_no_input(struct upipe *upipe)
         upipe_release(upipe_ts_demux_output->split_output);
     if (upipe_ts_demux_output->setrap != NULL)
         upipe_release(upipe_ts_demux_output->setrap);
+    if (upipe_ts_demux_output->setattr != NULL)
+        upipe_release(upipe_ts_demux_output->setattr);
     upipe_release(upipe_ts_demux_output->decaps);
     upipe_ts_demux_output_clean_bin_output(upipe);
     upipe_ts_demux_output_clean_sub(upipe);
@@ -1525,6 +1777,20 @@ static void upipe_ts_demux_program_handle_pcr(struct upipe *upipe,
             upipe_ts_demux_program->timestamp_highest - pcr_orig;
         discontinuity = 1;
     }
+
+    /* measure the jitter of the PCR against the reception date */
+    uint64_t cr_sys;
+    if (ubase_check(uref_clock_get_cr_sys(uref, &cr_sys))) {
+        if (!discontinuity &&
+            upipe_ts_demux_program->last_pcr_sys != UINT64_MAX) {
+            int64_t drift = (int64_t)(cr_sys -
+                    upipe_ts_demux_program->last_pcr_sys) - (int64_t)delta;
+            upipe_stats_jitter(upipe, drift < 0 ? -drift : drift);
+        }
+        upipe_ts_demux_program->last_pcr_sys = cr_sys;
+    } else
+        upipe_ts_demux_program->last_pcr_sys = UINT64_MAX;
+
     upipe_throw_clock_ref(upipe, uref,
                           upipe_ts_demux_program->last_pcr +
                           upipe_ts_demux_program->timestamp_offset,
@@ -1544,6 +1810,41 @@ static void upipe_ts_demux_program_handle_pcr(struct upipe *upipe,
         /* this is also valid for the packet we are processing */
         uref_clock_set_rap_sys(uref, pcr_rap);
     }
+
+    struct upipe_ts_demux *demux = upipe_ts_demux_from_program_mgr(upipe->mgr);
+    struct uref *dict = NULL;
+    struct uchain *uchain;
+    ulist_foreach (&upipe_ts_demux_program->outputs, uchain) {
+        struct upipe_ts_demux_output *output =
+            upipe_ts_demux_output_from_uchain(uchain);
+        if (output->setattr == NULL)
+            continue;
+
+        if (dict == NULL) {
+            dict = uref_alloc_control(demux->uref_mgr);
+            if (unlikely(dict == NULL ||
+                         !ubase_check(uref_ts_demux_set_pcr(dict,
+                                 upipe_ts_demux_program->last_pcr)) ||
+                         !ubase_check(uref_ts_demux_set_offset(dict,
+                                 upipe_ts_demux_program->timestamp_offset)))) {
+                if (dict != NULL)
+                    uref_free(dict);
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                return;
+            }
+        }
+        UBASE_FATAL(upipe, upipe_setattr_set_dict(output->setattr, dict));
+
+        /* the dates given in the worker thread are not known here, so
+         * assume the highest possible one */
+        uint64_t highest = upipe_ts_demux_program->timestamp_offset +
+                           upipe_ts_demux_program->last_pcr +
+                           output->max_delay + MAX_DELAY;
+        if (highest > upipe_ts_demux_program->timestamp_highest)
+            upipe_ts_demux_program->timestamp_highest = highest;
+    }
+    if (dict != NULL)
+        uref_free(dict);
 }
 
 /** @internal @This checks whether there is a ts_decaps on the PID
@@ -1568,7 +1869,8 @@ static void upipe_ts_demux_program_check_pcr(struct upipe *upipe)
     ulist_foreach (&upipe_ts_demux_program->outputs, uchain) {
         struct upipe_ts_demux_output *output =
             upipe_ts_demux_output_from_uchain(uchain);
-        if (output->pid == upipe_ts_demux_program->pcr_pid) {
+        if (output->pid == upipe_ts_demux_program->pcr_pid &&
+            output->setattr == NULL) {
             output->pcr = !found;
             found = true;
         } else
@@ -1628,6 +1930,49 @@ static void upipe_ts_demux_program_check_pcr(struct upipe *upipe)
     upipe_release(decaps);
 }
 
+/** @internal @This feeds the PMT sections of the program preloaded from a
+ * snapshot, so that the outputs may be allocated before the PMT is received
+ * from the stream.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_demux_program_snapshot(struct upipe *upipe)
+{
+    struct upipe_ts_demux_program *upipe_ts_demux_program =
+        upipe_ts_demux_program_from_upipe(upipe);
+    struct upipe_ts_demux *demux = upipe_ts_demux_from_program_mgr(upipe->mgr);
+    if (upipe_ts_demux_program->psi_pid_pmt == NULL)
+        return;
+
+    /* move the sections first as the program may be released meanwhile */
+    struct uchain sections;
+    ulist_init(&sections);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&demux->snapshot_pmts, uchain, uchain_tmp) {
+        struct uref *section = uref_from_uchain(uchain);
+        uint8_t buffer[PSI_HEADER_SIZE_SYNTAX1];
+        const uint8_t *header = uref_block_peek(section, 0,
+                                                PSI_HEADER_SIZE_SYNTAX1,
+                                                buffer);
+        if (unlikely(header == NULL))
+            continue;
+        uint16_t program = psi_get_tableidext(header);
+        UBASE_ERROR(upipe, uref_block_peek_unmap(section, 0, buffer, header))
+        if (program == upipe_ts_demux_program->program) {
+            ulist_delete(uchain);
+            ulist_add(&sections, uchain);
+        }
+    }
+
+    struct upipe *psi_split = upipe_ts_demux_program->psi_pid_pmt->psi_split;
+    upipe_use(psi_split);
+    ulist_delete_foreach (&sections, uchain, uchain_tmp) {
+        ulist_delete(uchain);
+        upipe_input(psi_split, uref_from_uchain(uchain), NULL);
+    }
+    upipe_release(psi_split);
+}
+
 /** @internal @This allocates a program subpipe of a ts_demux pipe.
  *
  * @param mgr common management structure
@@ -1659,6 +2004,8 @@ static struct upipe *upipe_ts_demux_program_alloc(struct upipe_mgr *mgr,
     upipe_ts_demux_program->pmt_rap = 0;
     upipe_ts_demux_program->pcr_pid = 0;
     upipe_ts_demux_program->pcr_split_output = NULL;
+    upipe_ts_demux_program->worker_mgr = NULL;
+    upipe_ts_demux_program->uprobe_worker = NULL;
     upipe_ts_demux_program->psi_pid_pmt =
         upipe_ts_demux_program->psi_pid_eit = NULL;
     upipe_ts_demux_program->psi_split_output_pmt =
@@ -1673,6 +2020,7 @@ static struct upipe *upipe_ts_demux_program_alloc(struct upipe_mgr *mgr,
     upipe_ts_demux_program->timestamp_offset = 0;
     upipe_ts_demux_program->timestamp_highest = TS_CLOCK_MAX;
     upipe_ts_demux_program->last_pcr = TS_CLOCK_MAX;
+    upipe_ts_demux_program->last_pcr_sys = UINT64_MAX;
     uprobe_init(&upipe_ts_demux_program->pmtd_probe,
                 upipe_ts_demux_program_pmtd_probe, NULL);
     upipe_ts_demux_program->pmtd_probe.refcount =
@@ -1769,10 +2117,44 @@ static struct upipe *upipe_ts_demux_program_alloc(struct upipe_mgr *mgr,
         return upipe;
     }
     upipe_ts_demux_program_build_flow_def(upipe);
+    upipe_ts_demux_program_snapshot(upipe);
 
     return upipe;
 }
 
+/** @internal @This sets the worker thread of a program.
+ *
+ * @param upipe description structure of the pipe
+ * @param xfer_mgr manager to transfer pipes to the worker thread, or NULL
+ * to disable
+ * @param uprobe_remote probe hierarchy to use in the worker thread
+ * @return an error code
+ */
+static int upipe_ts_demux_program_set_worker_real(struct upipe *upipe,
+                                                  struct upipe_mgr *xfer_mgr,
+                                                  struct uprobe *uprobe_remote)
+{
+    struct upipe_ts_demux_program *upipe_ts_demux_program =
+        upipe_ts_demux_program_from_upipe(upipe);
+    if (!ulist_empty(&upipe_ts_demux_program->outputs))
+        return UBASE_ERR_BUSY;
+
+    struct upipe_mgr *worker_mgr = NULL;
+    if (xfer_mgr != NULL) {
+        if (unlikely(uprobe_remote == NULL))
+            return UBASE_ERR_INVALID;
+        worker_mgr = upipe_wlin_mgr_alloc(xfer_mgr);
+        UBASE_ALLOC_RETURN(worker_mgr);
+    }
+
+    upipe_mgr_release(upipe_ts_demux_program->worker_mgr);
+    uprobe_release(upipe_ts_demux_program->uprobe_worker);
+    upipe_ts_demux_program->worker_mgr = worker_mgr;
+    upipe_ts_demux_program->uprobe_worker =
+        worker_mgr != NULL ? uprobe_use(uprobe_remote) : NULL;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a ts_demux_program pipe.
  *
  * @param upipe description structure of the pipe
@@ -1816,6 +2198,14 @@ static int upipe_ts_demux_program_control(struct upipe *upipe,
             return (*p != NULL) ? UBASE_ERR_NONE : UBASE_ERR_UNHANDLED;
         }
 
+        case UPIPE_TS_DEMUX_PROGRAM_SET_WORKER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_DEMUX_PROGRAM_SIGNATURE)
+            struct upipe_mgr *xfer_mgr = va_arg(args, struct upipe_mgr *);
+            struct uprobe *uprobe_remote = va_arg(args, struct uprobe *);
+            return upipe_ts_demux_program_set_worker_real(upipe, xfer_mgr,
+                                                          uprobe_remote);
+        }
+
         default:
             return UBASE_ERR_NONE;
     }
@@ -1838,6 +2228,8 @@ static void upipe_ts_demux_program_free(struct urefcount *urefcount_real)
     uprobe_clean(&upipe_ts_demux_program->eitd_probe);
     uprobe_clean(&upipe_ts_demux_program->pcr_probe);
     uprobe_clean(&upipe_ts_demux_program->proxy_probe);
+    upipe_mgr_release(upipe_ts_demux_program->worker_mgr);
+    uprobe_release(upipe_ts_demux_program->uprobe_worker);
     urefcount_clean(urefcount_real);
     upipe_ts_demux_program_clean_sub_outputs(upipe);
     if (upipe_ts_demux_program->flow_def_input != NULL)
@@ -2696,6 +3088,7 @@ static struct upipe *upipe_ts_demux_alloc(struct upipe_mgr *mgr,
     upipe_ts_demux->psi_pid_pat = upipe_ts_demux->psi_pid_nit =
         upipe_ts_demux->psi_pid_sdt = upipe_ts_demux->psi_pid_tdt = NULL;
     ulist_init(&upipe_ts_demux->pat_programs);
+    ulist_init(&upipe_ts_demux->snapshot_pmts);
 
     ulist_init(&upipe_ts_demux->psi_pids);
     upipe_ts_demux->conformance = UPIPE_TS_CONFORMANCE_DVB_NO_TABLES;
@@ -2824,7 +3217,8 @@ static int upipe_ts_demux_set_flow_def(struct upipe *upipe,
     struct upipe_ts_demux_mgr *ts_demux_mgr =
         upipe_ts_demux_mgr_from_upipe_mgr(upipe->mgr);
     struct upipe *input;
-    if (ubase_ncmp(def, EXPECTED_FLOW_DEF_SYNC)) {
+    if (ubase_ncmp(def, EXPECTED_FLOW_DEF_SYNC) &&
+        ubase_ncmp(def, EXPECTED_FLOW_DEF_BURST)) {
         if (!ubase_ncmp(def, EXPECTED_FLOW_DEF_CHECK))
             /* allocate ts_check inner pipe */
             input = upipe_void_alloc(ts_demux_mgr->ts_check_mgr,
@@ -2922,6 +3316,126 @@ static int _upipe_ts_demux_set_conformance(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This returns a snapshot of the PSI tables in effect.
+ *
+ * @param upipe description structure of the pipe
+ * @param snapshot_p filled in with a block uref, which must be freed by the
+ * caller
+ * @return an error code
+ */
+static int _upipe_ts_demux_get_snapshot(struct upipe *upipe,
+                                        struct uref **snapshot_p)
+{
+    struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
+    if (unlikely(upipe_ts_demux->patd == NULL ||
+                 upipe_ts_demux->uref_mgr == NULL))
+        return UBASE_ERR_INVALID;
+
+    struct uref *snapshot = uref_alloc(upipe_ts_demux->uref_mgr);
+    UBASE_ALLOC_RETURN(snapshot);
+    int err = upipe_ts_patd_export(upipe_ts_demux->patd, snapshot);
+    if (unlikely(!ubase_check(err))) {
+        uref_free(snapshot);
+        return err;
+    }
+
+    struct uchain *uchain;
+    ulist_foreach (&upipe_ts_demux->programs, uchain) {
+        struct upipe_ts_demux_program *program =
+            upipe_ts_demux_program_from_uchain(uchain);
+        /* the PMT of the program may not have been received yet */
+        if (program->pmtd != NULL &&
+            upipe_ts_pmtd_export(program->pmtd, snapshot) == UBASE_ERR_ALLOC) {
+            uref_free(snapshot);
+            return UBASE_ERR_ALLOC;
+        }
+    }
+
+    err = upipe_ts_conformance_to_flow_def(snapshot,
+                                           upipe_ts_demux->conformance);
+    if (unlikely(!ubase_check(err))) {
+        uref_free(snapshot);
+        return err;
+    }
+    *snapshot_p = snapshot;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This preloads a snapshot of the PSI tables.
+ *
+ * @param upipe description structure of the pipe
+ * @param snapshot block uref returned by @ref upipe_ts_demux_get_snapshot
+ * @return an error code
+ */
+static int _upipe_ts_demux_set_snapshot(struct upipe *upipe,
+                                        struct uref *snapshot)
+{
+    struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
+    if (unlikely(upipe_ts_demux->psi_pid_pat == NULL))
+        return UBASE_ERR_INVALID;
+
+    size_t total;
+    UBASE_RETURN(uref_block_size(snapshot, &total))
+
+    struct uchain pat;
+    ulist_init(&pat);
+    size_t offset = 0;
+    while (offset < total) {
+        uint8_t buffer[PSI_HEADER_SIZE_SYNTAX1];
+        const uint8_t *header = uref_block_peek(snapshot, offset,
+                                                PSI_HEADER_SIZE_SYNTAX1,
+                                                buffer);
+        if (unlikely(header == NULL)) {
+            upipe_warn(upipe, "truncated section in snapshot");
+            break;
+        }
+        uint8_t table_id = psi_get_tableid(header);
+        size_t size = psi_get_length(header) + PSI_HEADER_SIZE;
+        UBASE_ERROR(upipe, uref_block_peek_unmap(snapshot, offset, buffer,
+                                                 header))
+
+        struct uref *section = uref_block_splice(snapshot, offset, size);
+        if (unlikely(section == NULL)) {
+            upipe_warn(upipe, "truncated section in snapshot");
+            break;
+        }
+        offset += size;
+
+        switch (table_id) {
+            case PAT_TABLE_ID:
+                ulist_add(&pat, uref_to_uchain(section));
+                break;
+            case PMT_TABLE_ID:
+                ulist_add(&upipe_ts_demux->snapshot_pmts,
+                          uref_to_uchain(section));
+                break;
+            default:
+                upipe_warn_va(upipe, "ignoring table 0x%"PRIx8" in snapshot",
+                              table_id);
+                uref_free(section);
+                break;
+        }
+    }
+
+    /* the conformance may still be revised by the tables of the stream */
+    enum upipe_ts_conformance conformance =
+        upipe_ts_conformance_from_flow_def(snapshot);
+    if (upipe_ts_demux->auto_conformance &&
+        conformance != UPIPE_TS_CONFORMANCE_AUTO)
+        upipe_ts_demux_conformance_change(upipe, conformance);
+
+    /* the PMT sections are fed as soon as the programs are allocated */
+    struct upipe *psi_split = upipe_ts_demux->psi_pid_pat->psi_split;
+    upipe_use(psi_split);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&pat, uchain, uchain_tmp) {
+        ulist_delete(uchain);
+        upipe_input(psi_split, uref_from_uchain(uchain), NULL);
+    }
+    upipe_release(psi_split);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a ts_demux pipe.
  *
  * @param upipe description structure of the pipe
@@ -2971,6 +3485,16 @@ static int upipe_ts_demux_control(struct upipe *upipe,
                 va_arg(args, enum upipe_ts_conformance);
             return _upipe_ts_demux_set_conformance(upipe, conformance);
         }
+        case UPIPE_TS_DEMUX_GET_SNAPSHOT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_DEMUX_SIGNATURE)
+            struct uref **snapshot_p = va_arg(args, struct uref **);
+            return _upipe_ts_demux_get_snapshot(upipe, snapshot_p);
+        }
+        case UPIPE_TS_DEMUX_SET_SNAPSHOT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_DEMUX_SIGNATURE)
+            struct uref *snapshot = va_arg(args, struct uref *);
+            return _upipe_ts_demux_set_snapshot(upipe, snapshot);
+        }
 
         default:
             break;
@@ -2997,6 +3521,11 @@ static void upipe_ts_demux_free(struct urefcount *urefcount_real)
     uprobe_clean(&upipe_ts_demux->input_probe);
     uprobe_clean(&upipe_ts_demux->split_probe);
     uref_free(upipe_ts_demux->flow_def_input);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&upipe_ts_demux->snapshot_pmts, uchain, uchain_tmp) {
+        ulist_delete(uchain);
+        uref_free(uref_from_uchain(uchain));
+    }
     upipe_ts_demux_clean_sub_programs(upipe);
     upipe_ts_demux_clean_sync(upipe);
     upipe_ts_demux_clean_uref_mgr(upipe);
@@ -3089,6 +3618,7 @@ static void upipe_ts_demux_mgr_free(struct urefcount *urefcount)
         upipe_ts_demux_mgr_from_urefcount(urefcount);
     upipe_mgr_release(ts_demux_mgr->null_mgr);
     upipe_mgr_release(ts_demux_mgr->setrap_mgr);
+    upipe_mgr_release(ts_demux_mgr->setattr_mgr);
     upipe_mgr_release(ts_demux_mgr->idem_mgr);
     upipe_mgr_release(ts_demux_mgr->ts_split_mgr);
     upipe_mgr_release(ts_demux_mgr->ts_sync_mgr);
@@ -3105,6 +3635,7 @@ static void upipe_ts_demux_mgr_free(struct urefcount *urefcount)
     upipe_mgr_release(ts_demux_mgr->ts_pesd_mgr);
     upipe_mgr_release(ts_demux_mgr->ts_scte35d_mgr);
     upipe_mgr_release(ts_demux_mgr->autof_mgr);
+    upipe_work_pool_clean(&ts_demux_mgr->workers);
 
     urefcount_clean(urefcount);
     free(ts_demux_mgr);
@@ -3143,6 +3674,7 @@ static int upipe_ts_demux_mgr_control(struct upipe_mgr *mgr,
 
         GET_SET_MGR(null, NULL)
         GET_SET_MGR(setrap, SETRAP)
+        GET_SET_MGR(setattr, SETATTR)
         GET_SET_MGR(idem, IDEM)
 
         GET_SET_MGR(ts_split, TS_SPLIT)
@@ -3163,6 +3695,15 @@ static int upipe_ts_demux_mgr_control(struct upipe_mgr *mgr,
         GET_SET_MGR(autof, AUTOF)
 #undef GET_SET_MGR
 
+        case UPIPE_TS_DEMUX_MGR_GET_WORKERS:
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_DEMUX_SIGNATURE)
+            return upipe_work_pool_get_workers_va(&ts_demux_mgr->workers, args);
+        case UPIPE_TS_DEMUX_MGR_SET_WORKERS:
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_DEMUX_SIGNATURE)
+            if (!urefcount_single(&ts_demux_mgr->urefcount))
+                return UBASE_ERR_BUSY;
+            return upipe_work_pool_set_workers_va(&ts_demux_mgr->workers, args);
+
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -3182,6 +3723,7 @@ struct upipe_mgr *upipe_ts_demux_mgr_alloc(void)
     memset(ts_demux_mgr, 0, sizeof(*ts_demux_mgr));
     ts_demux_mgr->null_mgr = upipe_null_mgr_alloc();
     ts_demux_mgr->setrap_mgr = upipe_setrap_mgr_alloc();
+    ts_demux_mgr->setattr_mgr = upipe_setattr_mgr_alloc();
     ts_demux_mgr->idem_mgr = upipe_idem_mgr_alloc();
 
     ts_demux_mgr->ts_split_mgr = upipe_ts_split_mgr_alloc();
@@ -3200,6 +3742,7 @@ struct upipe_mgr *upipe_ts_demux_mgr_alloc(void)
     ts_demux_mgr->ts_scte35d_mgr = upipe_ts_scte35d_mgr_alloc();
 
     ts_demux_mgr->autof_mgr = NULL;
+    upipe_work_pool_init(&ts_demux_mgr->workers);
 
     urefcount_init(upipe_ts_demux_mgr_to_urefcount(ts_demux_mgr),
                    upipe_ts_demux_mgr_free);
@@ -94,6 +94,8 @@ struct upipe_ts_eitd {
     UPIPE_TS_PSID_TABLE_DECLARE(eit);
     /** EIT table being gathered */
     UPIPE_TS_PSID_TABLE_DECLARE(next_eit);
+    /** number of sections dropped because they were unchanged */
+    uint64_t unchanged;
 
     /** encoding of the following iconv handle */
     const char *current_encoding;
@@ -140,6 +142,7 @@ static struct upipe *upipe_ts_eitd_alloc(struct upipe_mgr *mgr,
     upipe_ts_eitd_init_iconv(upipe);
     upipe_ts_psid_table_init(upipe_ts_eitd->eit);
     upipe_ts_psid_table_init(upipe_ts_eitd->next_eit);
+    upipe_ts_eitd->unchanged = 0;
     upipe_throw_ready(upipe);
     return upipe;
 }
@@ -331,6 +334,12 @@ static void upipe_ts_eitd_input(struct upipe *upipe, struct uref *uref,
     struct upipe_ts_eitd *upipe_ts_eitd = upipe_ts_eitd_from_upipe(upipe);
     assert(upipe_ts_eitd->flow_def_input != NULL);
 
+    if (upipe_ts_psid_table_section_unchanged(upipe_ts_eitd->eit, uref)) {
+        upipe_ts_eitd->unchanged++;
+        uref_free(uref);
+        return;
+    }
+
     if (!upipe_ts_eitd_table_section(upipe_ts_eitd->next_eit, uref))
         return;
 
@@ -490,6 +499,12 @@ static int upipe_ts_eitd_control(struct upipe *upipe, int command, va_list args)
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_ts_eitd_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_TS_EITD_GET_UNCHANGED: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_EITD_SIGNATURE)
+            uint64_t *unchanged_p = va_arg(args, uint64_t *);
+            *unchanged_p = upipe_ts_eitd_from_upipe(upipe)->unchanged;
+            return UBASE_ERR_NONE;
+        }
 
         default:
             return UBASE_ERR_UNHANDLED;
@@ -144,6 +144,16 @@ struct upipe_ts_encaps {
 
     /** a padding packet for PSI streams */
     struct ubuf *padding;
+    /** a zero pointer_field shared by all PSI sections */
+    struct ubuf *pointer_field;
+    /** ubuf holding the TS headers of the current access unit */
+    struct ubuf *arena;
+    /** mapped buffer of the header arena */
+    uint8_t *arena_buffer;
+    /** size of the header arena */
+    size_t arena_size;
+    /** offset of the next free header in the arena */
+    size_t arena_offset;
     /** last continuity counter for this PID */
     uint8_t last_cc;
     /** last time prepare was called */
@@ -230,6 +240,10 @@ static struct upipe *upipe_ts_encaps_alloc(struct upipe_mgr *mgr,
     upipe_ts_encaps->pes_min_duration = 0;
     upipe_ts_encaps->pes_alignment = true;
     upipe_ts_encaps->padding = NULL;
+    upipe_ts_encaps->pointer_field = NULL;
+    upipe_ts_encaps->arena = NULL;
+    upipe_ts_encaps->arena_buffer = NULL;
+    upipe_ts_encaps->arena_size = upipe_ts_encaps->arena_offset = 0;
     upipe_ts_encaps->last_cc = 0;
     upipe_ts_encaps->last_splice = 0;
     upipe_ts_encaps->last_pcr = 0;
@@ -591,7 +605,20 @@ static int upipe_ts_encaps_check(struct upipe *upipe, struct uref *flow_format)
         }
         memset(buffer, 0xff, size);
         ubuf_block_unmap(padding, 0);
+
+        struct ubuf *pointer_field = ubuf_block_alloc(encaps->ubuf_mgr, 1);
+        size = -1;
+        if (unlikely(pointer_field == NULL ||
+                     !ubase_check(ubuf_block_write(pointer_field, 0,
+                                                   &size, &buffer)))) {
+            ubuf_free(pointer_field);
+            ubuf_free(padding);
+            return UBASE_ERR_ALLOC;
+        }
+        buffer[0] = 0;
+        ubuf_block_unmap(pointer_field, 0);
         encaps->padding = padding;
+        encaps->pointer_field = pointer_field;
 
         encaps->need_ready = encaps->need_status = true;
         upipe_ts_encaps_check_status(upipe);
@@ -864,6 +891,70 @@ static bool upipe_ts_encaps_count_pcr_au(struct upipe *upipe,
     return encaps->last_splice == encaps->last_pcr;
 }
 
+/** @internal @This releases the header arena of the current access unit.
+ * Headers already output keep a reference to it.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_encaps_release_arena(struct upipe *upipe)
+{
+    struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
+    if (encaps->arena == NULL)
+        return;
+    ubuf_block_unmap(encaps->arena, 0);
+    ubuf_free(encaps->arena);
+    encaps->arena = NULL;
+    encaps->arena_buffer = NULL;
+    encaps->arena_size = encaps->arena_offset = 0;
+}
+
+/** @internal @This precomputes the layout of the TS packets of an access
+ * unit, and allocates a single buffer large enough for all their headers.
+ * The arena stays mapped so that headers may be written after slices of it
+ * have been output. If the estimate is exceeded (because of unplanned PCRs),
+ * @ref upipe_ts_encaps_build_ts falls back to individual allocations.
+ *
+ * @param upipe description structure of the pipe
+ * @param au_size size of the access unit, including the PES header
+ */
+static void upipe_ts_encaps_alloc_arena(struct upipe *upipe, size_t au_size)
+{
+    struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
+    upipe_ts_encaps_release_arena(upipe);
+
+    size_t nb_pcr;
+    bool first_has_pcr = upipe_ts_encaps_count_pcr_au(upipe, &nb_pcr);
+    size_t first_size = TS_SIZE -
+        (first_has_pcr ? TS_HEADER_SIZE_PCR :
+         (ubase_check(uref_flow_get_random(encaps->uref)) ||
+          ubase_check(uref_flow_get_discontinuity(encaps->uref))) ?
+         TS_HEADER_SIZE_AF : TS_HEADER_SIZE);
+    size_t nb_ts = 1;
+    if (au_size > first_size)
+        nb_ts += (au_size - first_size + TS_SIZE - TS_HEADER_SIZE - 1) /
+                 (TS_SIZE - TS_HEADER_SIZE);
+    if (nb_ts <= 1)
+        return;
+
+    /* one plain header per packet, the planned adaptation fields, and
+     * stuffing in the last packet */
+    size_t arena_size = nb_ts * TS_HEADER_SIZE +
+        (nb_pcr + 2) * (TS_HEADER_SIZE_PCR - TS_HEADER_SIZE) + TS_SIZE;
+    struct ubuf *arena = ubuf_block_alloc(encaps->ubuf_mgr, arena_size);
+    uint8_t *buffer;
+    int size = -1;
+    if (unlikely(arena == NULL ||
+                 !ubase_check(ubuf_block_write(arena, 0, &size, &buffer)))) {
+        /* not fatal, headers will be allocated one by one */
+        ubuf_free(arena);
+        return;
+    }
+    encaps->arena = arena;
+    encaps->arena_buffer = buffer;
+    encaps->arena_size = size;
+    encaps->arena_offset = 0;
+}
+
 /** @internal @This copies the last incomplete TS of an access unit to the
  * beginning of the next access unit.
  *
@@ -942,17 +1033,8 @@ static int upipe_ts_encaps_promote_au(struct upipe *upipe)
 #ifdef VERBOSE_HEADERS
         upipe_verbose_va(upipe, "preparing PSI pointer_field");
 #endif
-        struct ubuf *ubuf = ubuf_block_alloc(encaps->ubuf_mgr, 1);
-        uint8_t *buffer;
-        int size = -1;
-        if (unlikely(ubuf == NULL ||
-                     !ubase_check(ubuf_block_write(ubuf, 0, &size, &buffer)))) {
-            ubuf_free(ubuf);
-            return UBASE_ERR_ALLOC;
-        }
-        assert(size == 1);
-        buffer[0] = 0;
-        ubuf_block_unmap(ubuf, 0);
+        struct ubuf *ubuf = ubuf_dup(encaps->pointer_field);
+        UBASE_ALLOC_RETURN(ubuf);
         struct ubuf *section = uref_detach_ubuf(encaps->uref);
         uref_attach_ubuf(encaps->uref, ubuf);
         uref_attr_set_priv(encaps->uref, 1);
@@ -962,6 +1044,7 @@ static int upipe_ts_encaps_promote_au(struct upipe *upipe)
         }
         encaps->uref_size++;
         encaps->au_size = encaps->uref_size;
+        upipe_ts_encaps_alloc_arena(upipe, encaps->au_size);
         return UBASE_ERR_NONE;
     }
 
@@ -1077,6 +1160,7 @@ static int upipe_ts_encaps_promote_au(struct upipe *upipe)
     encaps->uref_size += header_size;
     encaps->au_size = au_size + header_size;
     assert(encaps->uref_size <= encaps->au_size);
+    upipe_ts_encaps_alloc_arena(upipe, encaps->au_size);
     return UBASE_ERR_NONE;
 }
 
@@ -1113,15 +1197,29 @@ static struct ubuf *upipe_ts_encaps_build_ts(struct upipe *upipe,
             discontinuity ? ", disc" : "",
             pcr_prog != UINT64_MAX ? ", pcr" : "");
 #endif
-    struct ubuf *ubuf = ubuf_block_alloc(encaps->ubuf_mgr, header_size);
+    struct ubuf *ubuf;
     uint8_t *buffer;
-    int size = -1;
-    if (unlikely(ubuf == NULL ||
-                 !ubase_check(ubuf_block_write(ubuf, 0, &size, &buffer)))) {
-        ubuf_free(ubuf);
-        return NULL;
+    bool mapped = false;
+    if (payload_size && encaps->arena != NULL &&
+        encaps->arena_offset + header_size <= encaps->arena_size) {
+        ubuf = ubuf_block_splice(encaps->arena, encaps->arena_offset,
+                                 header_size);
+        if (unlikely(ubuf == NULL))
+            return NULL;
+        buffer = encaps->arena_buffer + encaps->arena_offset;
+        encaps->arena_offset += header_size;
+    } else {
+        ubuf = ubuf_block_alloc(encaps->ubuf_mgr, header_size);
+        int size = -1;
+        if (unlikely(ubuf == NULL ||
+                     !ubase_check(ubuf_block_write(ubuf, 0, &size,
+                                                   &buffer)))) {
+            ubuf_free(ubuf);
+            return NULL;
+        }
+        assert(size == header_size);
+        mapped = true;
     }
-    assert(size == header_size);
 
     ts_init(buffer);
     ts_set_pid(buffer, encaps->pid);
@@ -1147,7 +1245,8 @@ static struct ubuf *upipe_ts_encaps_build_ts(struct upipe *upipe,
         }
     }
 
-    ubuf_block_unmap(ubuf, 0);
+    if (mapped)
+        ubuf_block_unmap(ubuf, 0);
     return ubuf;
 }
 
@@ -1276,6 +1375,7 @@ static int _upipe_ts_encaps_splice(struct upipe *upipe, uint64_t cr_sys_min,
                 upipe_warn_va(upipe, "dropping late packet (%"PRIu64" ms)",
                               (cr_sys_min - dts_sys) * 1000 / UCLOCK_FREQ);
                 upipe_ts_encaps_consume_uref(upipe);
+                upipe_ts_encaps_release_arena(upipe);
                 encaps->au_size = 0;
                 encaps->need_ready = encaps->need_status = true;
 
@@ -1447,7 +1547,9 @@ static void upipe_ts_encaps_free(struct upipe *upipe)
     upipe_throw_dead(upipe);
 
     uref_free(upipe_ts_encaps->uref);
+    upipe_ts_encaps_release_arena(upipe);
     ubuf_free(upipe_ts_encaps->padding);
+    ubuf_free(upipe_ts_encaps->pointer_field);
     upipe_ts_encaps_clean_input(upipe);
     upipe_ts_encaps_clean_output(upipe);
     upipe_ts_encaps_clean_ubuf_mgr(upipe);
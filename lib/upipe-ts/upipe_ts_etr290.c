@@ -0,0 +1,966 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe module analysing a transport stream against ETSI TR 101 290
+ *
+ * The headers of the packets of a uref are first extracted by a vector
+ * kernel, which also flags the packets with a wrong sync byte or a
+ * transport error. The per-PID state then fits in two octets, so that the
+ * continuity check of the common packets only touches the header word and
+ * one cache line of the PID table; the payload is only read for adaptation
+ * fields and for the sections of the PAT and PMTs.
+ *
+ * PAT and PMT sections are only decoded when they fit in a single packet;
+ * the timeouts are still checked on longer tables, but their PIDs are not
+ * learnt from them.
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/ulist.h>
+#include <upipe/uprobe.h>
+#include <upipe/uref.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uclock.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe-ts/uref_ts_burst.h>
+#include <upipe-ts/upipe_ts_etr290.h>
+
+#include "upipe_ts_crc.h"
+#include "upipe_ts_etr290_headers.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#include <bitstream/mpeg/ts.h>
+#include <bitstream/mpeg/psi.h>
+
+/** we accept TS packets */
+#define EXPECTED_FLOW_DEF "block.mpegts."
+/** or bursts of TS packets */
+#define EXPECTED_FLOW_DEF_BURST UREF_TS_BURST_FLOW_DEF
+/** maximum number of PIDs */
+#define MAX_PIDS 8192
+/** PID of null packets */
+#define NULL_PID 8191
+/** max resolution of PCR */
+#define PCR_MAX (UINT64_C(8589934592) * 300)
+/** max interval between PAT or PMT sections (1.3 and 1.5) */
+#define PSI_TIMEOUT (UCLOCK_FREQ / 2)
+/** max interval between PCRs (2.3a) */
+#define PCR_REPETITION_MAX (UCLOCK_FREQ / 25)
+/** max difference between consecutive PCRs (2.3b) */
+#define PCR_DISCONTINUITY_MAX (UCLOCK_FREQ / 10)
+/** max PCR inaccuracy (2.4), 500 ns in units of 27 MHz, doubled */
+#define PCR_ACCURACY_MAX2 27
+/** default timeout of PIDs referred to in a PMT (1.6) */
+#define DEFAULT_PID_TIMEOUT (UCLOCK_FREQ * 5)
+
+/** continuity counter of a PID not seen yet */
+#define CC_UNKNOWN 0xff
+/** flag set in the continuity counter after a duplicate packet */
+#define CC_DUPLICATE 0x10
+
+/** the PID carries a PMT */
+#define PID_FLAG_PMT 0x1
+/** the PID is referred to in a PMT */
+#define PID_FLAG_ES 0x2
+/** the PID carries the PCR of a program */
+#define PID_FLAG_PCR 0x4
+/** the PID was seen since the last PID check */
+#define PID_FLAG_SEEN 0x8
+
+/** @internal @This is the state of a PID. */
+struct upipe_ts_etr290_pid {
+    /** last continuity counter, or CC_UNKNOWN */
+    uint8_t cc;
+    /** PID_FLAG_* flags */
+    uint8_t flags;
+};
+
+/** @internal @This is the state of a program found in the PAT. */
+struct upipe_ts_etr290_program {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** program number */
+    uint16_t program;
+    /** PMT PID */
+    uint16_t pmt_pid;
+    /** true if the program is not in the last PAT */
+    bool stale;
+    /** version of the last PMT, or -1 */
+    int version;
+    /** date of the last PMT section, or UINT64_MAX */
+    uint64_t last_pmt;
+    /** PCR PID, or NULL_PID */
+    uint16_t pcr_pid;
+    /** number of elementary stream PIDs */
+    unsigned int nb_es;
+    /** elementary stream PIDs */
+    uint16_t *es;
+};
+
+UBASE_FROM_TO(upipe_ts_etr290_program, uchain, uchain, uchain)
+
+/** @internal @This is the state of a PID carrying a PCR. */
+struct upipe_ts_etr290_pcr {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** PID */
+    uint16_t pid;
+    /** last PCR, in units of 27 MHz, or UINT64_MAX */
+    uint64_t pcr;
+    /** index of the packet carrying the last PCR */
+    uint64_t packet;
+    /** date of the last PCR, or UINT64_MAX */
+    uint64_t date;
+    /** PCR ticks per packet of the last interval, in 1/65536, or 0 */
+    uint64_t rate;
+    /** true if a repetition error was already reported for this interval */
+    bool late;
+};
+
+UBASE_FROM_TO(upipe_ts_etr290_pcr, uchain, uchain, uchain)
+
+/** @internal @This gives the dates of the packets of a uref. */
+struct upipe_ts_etr290_dates {
+    /** per-packet system clock references, or NULL */
+    const uint8_t *index;
+    /** number of entries in the index */
+    size_t nb_index;
+    /** system clock reference of the uref, or UINT64_MAX */
+    uint64_t cr_sys;
+};
+
+/** @internal @This is the private context of a ts_etr290 pipe. */
+struct upipe_ts_etr290 {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** output flow definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** true if the input is made of bursts */
+    bool burst;
+    /** counters */
+    struct upipe_ts_etr290_counters counters;
+    /** index of the next packet */
+    uint64_t packet;
+    /** timeout of PIDs referred to in a PMT */
+    uint64_t pid_timeout;
+    /** date of the next PID check, or UINT64_MAX */
+    uint64_t next_pid_check;
+
+    /** version of the last PAT, or -1 */
+    int pat_version;
+    /** date of the last PAT section, or UINT64_MAX */
+    uint64_t last_pat;
+    /** list of programs */
+    struct uchain programs;
+    /** list of PIDs carrying PCRs */
+    struct uchain pcrs;
+
+    /** state of the PIDs */
+    struct upipe_ts_etr290_pid pids[MAX_PIDS];
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_ts_etr290, upipe, UPIPE_TS_ETR290_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_ts_etr290, urefcount, upipe_ts_etr290_free)
+UPIPE_HELPER_VOID(upipe_ts_etr290)
+UPIPE_HELPER_OUTPUT(upipe_ts_etr290, output, flow_def, output_state,
+                    request_list)
+
+/** @internal @This allocates a ts_etr290 pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_ts_etr290_alloc(struct upipe_mgr *mgr,
+                                           struct uprobe *uprobe,
+                                           uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_ts_etr290_alloc_void(mgr, uprobe, signature,
+                                                     args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_ts_etr290 *upipe_ts_etr290 = upipe_ts_etr290_from_upipe(upipe);
+    upipe_ts_etr290_init_urefcount(upipe);
+    upipe_ts_etr290_init_output(upipe);
+    upipe_ts_etr290->burst = false;
+    memset(&upipe_ts_etr290->counters, 0, sizeof(upipe_ts_etr290->counters));
+    upipe_ts_etr290->packet = 0;
+    upipe_ts_etr290->pid_timeout = DEFAULT_PID_TIMEOUT;
+    upipe_ts_etr290->next_pid_check = UINT64_MAX;
+    upipe_ts_etr290->pat_version = -1;
+    upipe_ts_etr290->last_pat = UINT64_MAX;
+    ulist_init(&upipe_ts_etr290->programs);
+    ulist_init(&upipe_ts_etr290->pcrs);
+    for (unsigned int i = 0; i < MAX_PIDS; i++) {
+        upipe_ts_etr290->pids[i].cc = CC_UNKNOWN;
+        upipe_ts_etr290->pids[i].flags = 0;
+    }
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This reports an error.
+ *
+ * @param upipe description structure of the pipe
+ * @param indicator indicator in error
+ * @param pid PID in error, or MAX_PIDS if unknown
+ */
+static void upipe_ts_etr290_error(struct upipe *upipe,
+                                  enum upipe_ts_etr290_indicator indicator,
+                                  unsigned int pid)
+{
+    struct upipe_ts_etr290 *upipe_ts_etr290 = upipe_ts_etr290_from_upipe(upipe);
+    upipe_ts_etr290->counters.errors[indicator]++;
+    upipe_stats_error(upipe, 1);
+    upipe_dbg_va(upipe, "%s on PID %u",
+                 upipe_ts_etr290_indicator_str(indicator), pid);
+    upipe_throw(upipe, UPROBE_TS_ETR290_ERROR, UPIPE_TS_ETR290_SIGNATURE,
+                (int)indicator, pid);
+}
+
+/** @internal @This returns the date of a packet.
+ *
+ * @param dates dates of the packets of the uref
+ * @param n index of the packet in the uref
+ * @return date of the packet, or UINT64_MAX
+ */
+static inline uint64_t
+    upipe_ts_etr290_date(const struct upipe_ts_etr290_dates *dates,
+                         unsigned int n)
+{
+    if (dates->index != NULL && n < dates->nb_index) {
+        uint64_t date;
+        memcpy(&date, dates->index + n * sizeof(uint64_t), sizeof(uint64_t));
+        return date;
+    }
+    return dates->cr_sys;
+}
+
+/** @internal @This finds a PID carrying PCRs.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID
+ * @return pointer to the PCR state, or NULL
+ */
+static struct upipe_ts_etr290_pcr *
+    upipe_ts_etr290_find_pcr(struct upipe *upipe, uint16_t pid)
+{
+    struct upipe_ts_etr290 *upipe_ts_etr290 = upipe_ts_etr290_from_upipe(upipe);
+    struct uchain *uchain;
+    ulist_foreach (&upipe_ts_etr290->pcrs, uchain) {
+        struct upipe_ts_etr290_pcr *pcr =
+            upipe_ts_etr290_pcr_from_uchain(uchain);
+        if (pcr->pid == pid)
+            return pcr;
+    }
+    return NULL;
+}
+
+/** @internal @This updates the flags of the PIDs after a PAT or PMT change.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_ts_etr290_update_pids(struct upipe *upipe)
+{
+    struct upipe_ts_etr290 *upipe_ts_etr290 = upipe_ts_etr290_from_upipe(upipe);
+    for (unsigned int i = 0; i < MAX_PIDS; i++)
+        upipe_ts_etr290->pids[i].flags &=
+            ~(PID_FLAG_PMT | PID_FLAG_ES | PID_FLAG_PCR);
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_foreach (&upipe_ts_etr290->programs, uchain) {
+        struct upipe_ts_etr290_program *program =
+            upipe_ts_etr290_program_from_uchain(uchain);
+        upipe_ts_etr290->pids[program->pmt_pid].flags |= PID_FLAG_PMT;
+        if (program->pcr_pid != NULL_PID)
+            upipe_ts_etr290->pids[program->pcr_pid].flags |= PID_FLAG_PCR;
+        for (unsigned int i = 0; i < program->nb_es; i++)
+            upipe_ts_etr290->pids[program->es[i]].flags |= PID_FLAG_ES;
+    }
+
+    ulist_delete_foreach (&upipe_ts_etr290->pcrs, uchain, uchain_tmp) {
+        struct upipe_ts_etr290_pcr *pcr =
+            upipe_ts_etr290_pcr_from_uchain(uchain);
+        if (!(upipe_ts_etr290->pids[pcr->pid].flags & PID_FLAG_PCR)) {
+            ulist_delete(uchain);
+            free(pcr);
+        }
+    }
+
+    ulist_foreach (&upipe_ts_etr290->programs, uchain) {
+        struct upipe_ts_etr290_program *program =
+            upipe_ts_etr290_program_from_uchain(uchain);
+        if (program->pcr_pid == NULL_PID ||
+            upipe_ts_etr290_find_pcr(upipe, program->pcr_pid) != NULL)
+            continue;
+
+        struct upipe_ts_etr290_pcr *pcr =
+            malloc(sizeof(struct upipe_ts_etr290_pcr));
+        UBASE_ALLOC_RETURN(pcr);
+        pcr->pid = program->pcr_pid;
+        pcr->pcr = UINT64_MAX;
+        pcr->packet = 0;
+        pcr->date = UINT64_MAX;
+        pcr->rate = 0;
+        pcr->late = false;
+        uchain_init(&pcr->uchain);
+        ulist_add(&upipe_ts_etr290->pcrs, &pcr->uchain);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This frees a program.
+ *
+ * @param program program state
+ */
+static void upipe_ts_etr290_program_free(
+        struct upipe_ts_etr290_program *program)
+{
+    ulist_delete(upipe_ts_etr290_program_to_uchain(program));
+    free(program->es);
+    free(program);
+}
+
+/** @internal @This finds the section starting in the payload of a packet.
+ *
+ * @param packet TS packet
+ * @param offset offset of the payload in the packet
+ * @param complete_p filled in with true if the section ends in the packet
+ * @return pointer to the section, or NULL if its header is not in the packet
+ */
+static const uint8_t *upipe_ts_etr290_section(const uint8_t *packet,
+                                              unsigned int offset,
+                                              bool *complete_p)
+{
+    if (offset >= TS_SIZE)
+        return NULL;
+    unsigned int start = offset + 1 + packet[offset];
+    if (start + PSI_HEADER_SIZE > TS_SIZE)
+        return NULL;
+    const uint8_t *section = packet + start;
+    *complete_p = start + PSI_HEADER_SIZE + psi_get_length(section) <= TS_SIZE;
+    return section;
+}
+
+/** @internal @This handles a section starting on PID 0.
+ *
+ * @param upipe description structure of the pipe
+ * @param section section
+ * @param complete true if the section ends in the packet
+ * @param date date of the packet, or UINT64_MAX
+ */
+static void upipe_ts_etr290_pat(struct upipe *upipe, const uint8_t *section,
+                                bool complete, uint64_t date)
+{
+    struct upipe_ts_etr290 *upipe_ts_etr290 = upipe_ts_etr290_from_upipe(upipe);
+    uint8_t table_id = psi_get_tableid(section);
+    if (table_id == 0xff)
+        return;
+    if (table_id != PAT_TABLE_ID) {
+        upipe_ts_etr290_error(upipe, UPIPE_TS_ETR290_PAT, 0);
+        return;
+    }
+    if (date != UINT64_MAX)
+        upipe_ts_etr290->last_pat = date;
+    if (!complete)
+        return;
+    if (!upipe_ts_psi_check_crc(section)) {
+        upipe_ts_etr290_error(upipe, UPIPE_TS_ETR290_CRC, 0);
+        return;
+    }
+    if (!pat_validate(section) || !psi_get_current(section) ||
+        psi_get_section(section) || psi_get_lastsection(section) ||
+        psi_get_version(section) == upipe_ts_etr290->pat_version)
+        return;
+    upipe_ts_etr290->pat_version = psi_get_version(section);
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_foreach (&upipe_ts_etr290->programs, uchain)
+        upipe_ts_etr290_program_from_uchain(uchain)->stale = true;
+
+    const uint8_t *pat_program;
+    unsigned int j = 0;
+    while ((pat_program = pat_get_program((uint8_t *)section, j++)) != NULL) {
+        uint16_t number = patn_get_program(pat_program);
+        uint16_t pid = patn_get_pid(pat_program);
+        if (!number)
+            /* NIT */
+            continue;
+
+        struct upipe_ts_etr290_program *program = NULL;
+        ulist_foreach (&upipe_ts_etr290->programs, uchain) {
+            struct upipe_ts_etr290_program *p =
+                upipe_ts_etr290_program_from_uchain(uchain);
+            if (p->program == number && p->pmt_pid == pid) {
+                program = p;
+                break;
+            }
+        }
+        if (program != NULL) {
+            program->stale = false;
+            continue;
+        }
+
+        program = malloc(sizeof(struct upipe_ts_etr290_program));
+        if (unlikely(program == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        program->program = number;
+        program->pmt_pid = pid;
+        program->stale = false;
+        program->version = -1;
+        program->last_pmt = date;
+        program->pcr_pid = NULL_PID;
+        program->nb_es = 0;
+        program->es = NULL;
+        uchain_init(&program->uchain);
+        ulist_add(&upipe_ts_etr290->programs, &program->uchain);
+    }
+
+    ulist_delete_foreach (&upipe_ts_etr290->programs, uchain, uchain_tmp) {
+        struct upipe_ts_etr290_program *program =
+            upipe_ts_etr290_program_from_uchain(uchain);
+        if (program->stale)
+            upipe_ts_etr290_program_free(program);
+    }
+    UBASE_FATAL(upipe, upipe_ts_etr290_update_pids(upipe))
+}
+
+/** @internal @This handles a section starting on a PMT PID.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID of the packet
+ * @param section section
+ * @param complete true if the section ends in the packet
+ * @param date date of the packet, or UINT64_MAX
+ */
+static void upipe_ts_etr290_pmt(struct upipe *upipe, uint16_t pid,
+                                const uint8_t *section, bool complete,
+                                uint64_t date)
+{
+    struct upipe_ts_etr290 *upipe_ts_etr290 = upipe_ts_etr290_from_upipe(upipe);
+    if (psi_get_tableid(section) != PMT_TABLE_ID ||
+        !psi_get_syntax(section))
+        return;
+
+    uint16_t number = psi_get_tableidext(section);
+    struct upipe_ts_etr290_program *program = NULL;
+    struct uchain *uchain;
+    ulist_foreach (&upipe_ts_etr290->programs, uchain) {
+        struct upipe_ts_etr290_program *p =
+            upipe_ts_etr290_program_from_uchain(uchain);
+        if (p->program == number && p->pmt_pid == pid) {
+            program = p;
+            break;
+        }
+    }
+    if (program == NULL)
+        return;
+
+    if (date != UINT64_MAX)
+        program->last_pmt = date;
+    if (!complete)
+        return;
+    if (!upipe_ts_psi_check_crc(section)) {
+        upipe_ts_etr290_error(upipe, UPIPE_TS_ETR290_CRC, pid);
+        return;
+    }
+    if (!pmt_validate(section) || !psi_get_current(section) ||
+        psi_get_version(section) == program->version)
+        return;
+
+    unsigned int nb_es = 0;
+    while (pmt_get_es((uint8_t *)section, nb_es) != NULL)
+        nb_es++;
+    uint16_t *es = realloc(program->es, sizeof(uint16_t) * (nb_es + 1));
+    if (unlikely(es == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    for (unsigned int j = 0; j < nb_es; j++)
+        es[j] = pmtn_get_pid(pmt_get_es((uint8_t *)section, j));
+    program->es = es;
+    program->nb_es = nb_es;
+    program->pcr_pid = pmt_get_pcrpid(section);
+    program->version = psi_get_version(section);
+    UBASE_FATAL(upipe, upipe_ts_etr290_update_pids(upipe))
+}
+
+/** @internal @This checks a PCR.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID of the packet
+ * @param value PCR, in units of 27 MHz
+ * @param discontinuity true if the discontinuity_indicator is set
+ * @param date date of the packet, or UINT64_MAX
+ */
+static void upipe_ts_etr290_pcr(struct upipe *upipe, uint16_t pid,
+                                uint64_t value, bool discontinuity,
+                                uint64_t date)
+{
+    struct upipe_ts_etr290 *upipe_ts_etr290 = upipe_ts_etr290_from_upipe(upipe);
+    struct upipe_ts_etr290_pcr *pcr = upipe_ts_etr290_find_pcr(upipe, pid);
+    if (unlikely(pcr == NULL))
+        return;
+
+    uint64_t packet = upipe_ts_etr290->packet;
+    if (pcr->pcr == UINT64_MAX || discontinuity)
+        pcr->rate = 0;
+    else {
+        /* handle 2^33 wrap-arounds, PCRs going backwards look huge */
+        uint64_t delta = (PCR_MAX + value - pcr->pcr) % PCR_MAX;
+        if (delta > PCR_DISCONTINUITY_MAX) {
+            upipe_ts_etr290_error(upipe, UPIPE_TS_ETR290_PCR_DISCONTINUITY,
+                                  pid);
+            pcr->rate = 0;
+        } else {
+            if (delta > PCR_REPETITION_MAX && !pcr->late)
+                upipe_ts_etr290_error(upipe, UPIPE_TS_ETR290_PCR_REPETITION,
+                                      pid);
+
+            uint64_t packets = packet - pcr->packet;
+            if (packets && pcr->rate) {
+                uint64_t expected = (packets * pcr->rate + 0x8000) >> 16;
+                uint64_t accuracy = delta > expected ? delta - expected :
+                                                       expected - delta;
+                if (accuracy > upipe_ts_etr290->counters.max_pcr_accuracy)
+                    upipe_ts_etr290->counters.max_pcr_accuracy = accuracy;
+                /* PCRs are in units of 27 MHz like UCLOCK_FREQ */
+                upipe_stats_jitter(upipe, accuracy);
+                if (accuracy * 2 > PCR_ACCURACY_MAX2)
+                    upipe_ts_etr290_error(upipe,
+                            UPIPE_TS_ETR290_PCR_ACCURACY, pid);
+            }
+            pcr->rate = packets ? (delta << 16) / packets : 0;
+        }
+    }
+    pcr->pcr = value;
+    pcr->packet = packet;
+    if (date != UINT64_MAX)
+        pcr->date = date;
+    pcr->late = false;
+}
+
+/** @internal @This checks a packet whose header shows no error.
+ *
+ * @param upipe description structure of the pipe
+ * @param packet TS packet
+ * @param header header of the packet, in host order
+ * @param dates dates of the packets of the uref
+ * @param n index of the packet in the uref
+ */
+static void upipe_ts_etr290_packet(struct upipe *upipe, const uint8_t *packet,
+                                   uint32_t header,
+                                   const struct upipe_ts_etr290_dates *dates,
+                                   unsigned int n)
+{
+    struct upipe_ts_etr290 *upipe_ts_etr290 = upipe_ts_etr290_from_upipe(upipe);
+    uint16_t pid = (header >> 8) & 0x1fff;
+    if (pid == NULL_PID)
+        return;
+
+    struct upipe_ts_etr290_pid *state = &upipe_ts_etr290->pids[pid];
+    state->flags |= PID_FLAG_SEEN;
+
+    bool has_payload = header & 0x10;
+    uint8_t cc = header & 0xf;
+    unsigned int offset = TS_HEADER_SIZE;
+    bool discontinuity = false;
+    bool has_pcr = false;
+    if (header & 0x20) {
+        uint8_t af_length = packet[TS_HEADER_SIZE];
+        if (unlikely(af_length > TS_SIZE - TS_HEADER_SIZE - 1))
+            return;
+        offset += 1 + af_length;
+        if (af_length) {
+            discontinuity = tsaf_has_discontinuity(packet);
+            has_pcr = af_length >= TS_HEADER_SIZE_PCR - TS_HEADER_SIZE - 1 &&
+                      tsaf_has_pcr(packet);
+        }
+    }
+
+    if (unlikely(state->cc == CC_UNKNOWN || discontinuity))
+        state->cc = cc;
+    else {
+        uint8_t last_cc = state->cc & 0xf;
+        if (!has_payload) {
+            /* the counter does not increment without payload */
+            if (unlikely(cc != last_cc))
+                upipe_ts_etr290_error(upipe, UPIPE_TS_ETR290_CC, pid);
+            state->cc = cc;
+        } else if (likely(cc == ((last_cc + 1) & 0xf)))
+            state->cc = cc;
+        else if (cc == last_cc) {
+            /* a packet may be sent twice */
+            if (state->cc & CC_DUPLICATE)
+                upipe_ts_etr290_error(upipe, UPIPE_TS_ETR290_CC, pid);
+            state->cc = cc | CC_DUPLICATE;
+        } else {
+            upipe_ts_etr290_error(upipe, UPIPE_TS_ETR290_CC, pid);
+            state->cc = cc;
+        }
+    }
+
+    if (unlikely(has_pcr && (state->flags & PID_FLAG_PCR)))
+        upipe_ts_etr290_pcr(upipe, pid,
+                            tsaf_get_pcr(packet) * 300 + tsaf_get_pcrext(packet),
+                            discontinuity, upipe_ts_etr290_date(dates, n));
+
+    if (likely(pid && !(state->flags & PID_FLAG_PMT)))
+        return;
+
+    if (header & 0xc0) {
+        upipe_ts_etr290_error(upipe,
+                pid ? UPIPE_TS_ETR290_PMT : UPIPE_TS_ETR290_PAT, pid);
+        return;
+    }
+    if (!has_payload || !(header & 0x400000))
+        return;
+
+    bool complete;
+    const uint8_t *section = upipe_ts_etr290_section(packet, offset,
+                                                     &complete);
+    if (section == NULL)
+        return;
+    if (!pid)
+        upipe_ts_etr290_pat(upipe, section, complete,
+                            upipe_ts_etr290_date(dates, n));
+    else
+        upipe_ts_etr290_pmt(upipe, pid, section, complete,
+                            upipe_ts_etr290_date(dates, n));
+}
+
+/** @internal @This checks consecutive packets.
+ *
+ * @param upipe description structure of the pipe
+ * @param buf first packet
+ * @param nb number of packets
+ * @param dates dates of the packets of the uref
+ * @param n index of the first packet in the uref
+ */
+static void upipe_ts_etr290_work(struct upipe *upipe, const uint8_t *buf,
+                                 unsigned int nb,
+                                 const struct upipe_ts_etr290_dates *dates,
+                                 unsigned int n)
+{
+    struct upipe_ts_etr290 *upipe_ts_etr290 = upipe_ts_etr290_from_upipe(upipe);
+    uint32_t headers[UPIPE_TS_ETR290_HEADERS_MAX];
+
+    while (nb) {
+        unsigned int chunk = nb < UPIPE_TS_ETR290_HEADERS_MAX ? nb :
+                             UPIPE_TS_ETR290_HEADERS_MAX;
+        uint64_t errors = upipe_ts_etr290_headers(buf, chunk, headers);
+        for (unsigned int i = 0; i < chunk; i++) {
+            if (unlikely(errors & (UINT64_C(1) << i)))
+                upipe_ts_etr290_error(upipe, (headers[i] >> 24) != TS_SYNC ?
+                        UPIPE_TS_ETR290_SYNC_BYTE : UPIPE_TS_ETR290_TRANSPORT,
+                        (headers[i] >> 24) != TS_SYNC ? MAX_PIDS :
+                        (headers[i] >> 8) & 0x1fff);
+            else
+                upipe_ts_etr290_packet(upipe, buf + i * TS_SIZE, headers[i],
+                                       dates, n + i);
+            upipe_ts_etr290->packet++;
+        }
+        upipe_ts_etr290->counters.packets += chunk;
+        buf += chunk * TS_SIZE;
+        nb -= chunk;
+        n += chunk;
+    }
+}
+
+/** @internal @This checks the timeouts.
+ *
+ * @param upipe description structure of the pipe
+ * @param now date of the last packet
+ */
+static void upipe_ts_etr290_check_timeouts(struct upipe *upipe, uint64_t now)
+{
+    struct upipe_ts_etr290 *upipe_ts_etr290 = upipe_ts_etr290_from_upipe(upipe);
+    if (upipe_ts_etr290->last_pat == UINT64_MAX ||
+        now < upipe_ts_etr290->last_pat)
+        upipe_ts_etr290->last_pat = now;
+    else if (now - upipe_ts_etr290->last_pat > PSI_TIMEOUT) {
+        upipe_ts_etr290_error(upipe, UPIPE_TS_ETR290_PAT, 0);
+        upipe_ts_etr290->last_pat = now;
+    }
+
+    struct uchain *uchain;
+    ulist_foreach (&upipe_ts_etr290->programs, uchain) {
+        struct upipe_ts_etr290_program *program =
+            upipe_ts_etr290_program_from_uchain(uchain);
+        if (program->last_pmt == UINT64_MAX || now < program->last_pmt)
+            program->last_pmt = now;
+        else if (now - program->last_pmt > PSI_TIMEOUT) {
+            upipe_ts_etr290_error(upipe, UPIPE_TS_ETR290_PMT,
+                                  program->pmt_pid);
+            program->last_pmt = now;
+        }
+    }
+
+    ulist_foreach (&upipe_ts_etr290->pcrs, uchain) {
+        struct upipe_ts_etr290_pcr *pcr =
+            upipe_ts_etr290_pcr_from_uchain(uchain);
+        if (pcr->date == UINT64_MAX || now < pcr->date)
+            pcr->date = now;
+        else if (now - pcr->date > PCR_REPETITION_MAX) {
+            upipe_ts_etr290_error(upipe, UPIPE_TS_ETR290_PCR_REPETITION,
+                                  pcr->pid);
+            pcr->date = now;
+            pcr->late = true;
+        }
+    }
+
+    if (upipe_ts_etr290->next_pid_check == UINT64_MAX ||
+        now + upipe_ts_etr290->pid_timeout <
+            upipe_ts_etr290->next_pid_check)
+        upipe_ts_etr290->next_pid_check = now + upipe_ts_etr290->pid_timeout;
+    else if (now >= upipe_ts_etr290->next_pid_check) {
+        for (unsigned int i = 0; i < MAX_PIDS; i++) {
+            struct upipe_ts_etr290_pid *state = &upipe_ts_etr290->pids[i];
+            if ((state->flags & (PID_FLAG_ES | PID_FLAG_SEEN)) == PID_FLAG_ES)
+                upipe_ts_etr290_error(upipe, UPIPE_TS_ETR290_PID, i);
+            state->flags &= ~PID_FLAG_SEEN;
+        }
+        upipe_ts_etr290->next_pid_check = now + upipe_ts_etr290->pid_timeout;
+    }
+}
+
+/** @internal @This analyses the packets of a uref and forwards it.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_etr290_input(struct upipe *upipe, struct uref *uref,
+                                  struct upump **upump_p)
+{
+    struct upipe_ts_etr290 *upipe_ts_etr290 = upipe_ts_etr290_from_upipe(upipe);
+    size_t size;
+    if (unlikely(!ubase_check(uref_block_size(uref, &size)))) {
+        upipe_warn(upipe, "invalid TS packet");
+        uref_free(uref);
+        return;
+    }
+
+    struct upipe_ts_etr290_dates dates;
+    dates.index = NULL;
+    dates.nb_index = 0;
+    size_t index_size;
+    if (upipe_ts_etr290->burst &&
+        ubase_check(uref_ts_burst_get_cr_sys_index(uref, &dates.index,
+                                                   &index_size)))
+        dates.nb_index = index_size / sizeof(uint64_t);
+    if (!ubase_check(uref_clock_get_cr_sys(uref, &dates.cr_sys)))
+        dates.cr_sys = UINT64_MAX;
+
+    unsigned int n = 0;
+    size_t offset = 0;
+    while (offset + TS_SIZE <= size) {
+        const uint8_t *buf;
+        int read_size = -1;
+        if (unlikely(!ubase_check(uref_block_read(uref, offset, &read_size,
+                                                  &buf)))) {
+            upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
+            break;
+        }
+        if (likely(read_size >= TS_SIZE)) {
+            unsigned int nb = read_size / TS_SIZE;
+            upipe_ts_etr290_work(upipe, buf, nb, &dates, n);
+            uref_block_unmap(uref, offset);
+            offset += nb * TS_SIZE;
+            n += nb;
+            continue;
+        }
+        uref_block_unmap(uref, offset);
+
+        /* packet split between segments */
+        uint8_t packet[TS_SIZE];
+        if (unlikely(!ubase_check(uref_block_extract(uref, offset, TS_SIZE,
+                                                     packet)))) {
+            upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
+            break;
+        }
+        upipe_ts_etr290_work(upipe, packet, 1, &dates, n);
+        offset += TS_SIZE;
+        n++;
+    }
+    if (unlikely(offset != size))
+        upipe_warn_va(upipe, "ignoring %zu trailing octets", size - offset);
+
+    if (n) {
+        uint64_t now = upipe_ts_etr290_date(&dates, n - 1);
+        if (now != UINT64_MAX)
+            upipe_ts_etr290_check_timeouts(upipe, now);
+    }
+    upipe_ts_etr290_output(upipe, uref, upump_p);
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_ts_etr290_set_flow_def(struct upipe *upipe,
+                                        struct uref *flow_def)
+{
+    struct upipe_ts_etr290 *upipe_ts_etr290 = upipe_ts_etr290_from_upipe(upipe);
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    const char *def;
+    UBASE_RETURN(uref_flow_get_def(flow_def, &def))
+    bool burst = !ubase_ncmp(def, EXPECTED_FLOW_DEF_BURST);
+    if (!burst && ubase_ncmp(def, EXPECTED_FLOW_DEF))
+        return UBASE_ERR_INVALID;
+    struct uref *flow_def_dup;
+    if (unlikely((flow_def_dup = uref_dup(flow_def)) == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_ts_etr290->burst = burst;
+    upipe_ts_etr290_store_flow_def(upipe, flow_def_dup);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a ts_etr290 pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_ts_etr290_control(struct upipe *upipe,
+                                   int command, va_list args)
+{
+    struct upipe_ts_etr290 *upipe_ts_etr290 = upipe_ts_etr290_from_upipe(upipe);
+    UBASE_HANDLED_RETURN(upipe_ts_etr290_control_output(upipe, command, args));
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_ts_etr290_set_flow_def(upipe, flow_def);
+        }
+        case UPIPE_TS_ETR290_GET_COUNTERS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_ETR290_SIGNATURE)
+            struct upipe_ts_etr290_counters *p =
+                va_arg(args, struct upipe_ts_etr290_counters *);
+            *p = upipe_ts_etr290->counters;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_TS_ETR290_RESET_COUNTERS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_ETR290_SIGNATURE)
+            memset(&upipe_ts_etr290->counters, 0,
+                   sizeof(upipe_ts_etr290->counters));
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_TS_ETR290_GET_PID_TIMEOUT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_ETR290_SIGNATURE)
+            uint64_t *p = va_arg(args, uint64_t *);
+            *p = upipe_ts_etr290->pid_timeout;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_TS_ETR290_SET_PID_TIMEOUT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_ETR290_SIGNATURE)
+            uint64_t timeout = va_arg(args, uint64_t);
+            if (unlikely(!timeout))
+                return UBASE_ERR_INVALID;
+            upipe_ts_etr290->pid_timeout = timeout;
+            upipe_ts_etr290->next_pid_check = UINT64_MAX;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_etr290_free(struct upipe *upipe)
+{
+    struct upipe_ts_etr290 *upipe_ts_etr290 = upipe_ts_etr290_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&upipe_ts_etr290->programs, uchain, uchain_tmp)
+        upipe_ts_etr290_program_free(
+                upipe_ts_etr290_program_from_uchain(uchain));
+    ulist_delete_foreach (&upipe_ts_etr290->pcrs, uchain, uchain_tmp) {
+        ulist_delete(uchain);
+        free(upipe_ts_etr290_pcr_from_uchain(uchain));
+    }
+    upipe_ts_etr290_clean_output(upipe);
+    upipe_ts_etr290_clean_urefcount(upipe);
+    upipe_ts_etr290_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_ts_etr290_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_TS_ETR290_SIGNATURE,
+
+    .upipe_alloc = upipe_ts_etr290_alloc,
+    .upipe_input = upipe_ts_etr290_input,
+    .upipe_control = upipe_ts_etr290_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all ts_etr290 pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_ts_etr290_mgr_alloc(void)
+{
+    return &upipe_ts_etr290_mgr;
+}
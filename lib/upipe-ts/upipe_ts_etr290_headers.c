@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe kernels extracting the headers of a burst of TS packets
+ *
+ * The headers are 188 octets apart, so the vector variants gather them
+ * instead of loading contiguous data, then swap their octets and compare
+ * the sync byte and transport_error_indicator of all the lanes at once.
+ */
+
+#include <upipe/ubase.h>
+
+#include "upipe_ts_etr290_headers.h"
+
+#include <string.h>
+
+#if defined(__i686__) || defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/** mask of the sync byte and transport_error_indicator */
+#define HEADER_CHECK_MASK UINT32_C(0xff800000)
+/** expected value of the sync byte and transport_error_indicator */
+#define HEADER_CHECK_VALUE UINT32_C(0x47000000)
+
+/** @This extracts the headers of consecutive TS packets, one packet at a
+ * time.
+ *
+ * @param buf first packet
+ * @param nb number of packets, at most @ref UPIPE_TS_ETR290_HEADERS_MAX
+ * @param headers filled in with the headers of the packets, in host order
+ * @return bitmask of the packets having a sync byte different from 0x47 or
+ * the transport_error_indicator set
+ */
+uint64_t upipe_ts_etr290_headers_c(const uint8_t *buf, unsigned int nb,
+                                   uint32_t *headers)
+{
+    uint64_t mask = 0;
+    for (unsigned int i = 0; i < nb; i++) {
+        const uint8_t *p = buf + i * UPIPE_TS_ETR290_PACKET_SIZE;
+        uint32_t header = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+                          ((uint32_t)p[2] << 8) | p[3];
+        headers[i] = header;
+        if ((header & HEADER_CHECK_MASK) != HEADER_CHECK_VALUE)
+            mask |= UINT64_C(1) << i;
+    }
+    return mask;
+}
+
+#if defined(__i686__) || defined(__x86_64__)
+__attribute__((target("avx2")))
+uint64_t upipe_ts_etr290_headers_avx2(const uint8_t *buf, unsigned int nb,
+                                      uint32_t *headers)
+{
+    const __m256i offsets = _mm256_setr_epi32(
+            0, UPIPE_TS_ETR290_PACKET_SIZE, 2 * UPIPE_TS_ETR290_PACKET_SIZE,
+            3 * UPIPE_TS_ETR290_PACKET_SIZE, 4 * UPIPE_TS_ETR290_PACKET_SIZE,
+            5 * UPIPE_TS_ETR290_PACKET_SIZE, 6 * UPIPE_TS_ETR290_PACKET_SIZE,
+            7 * UPIPE_TS_ETR290_PACKET_SIZE);
+    const __m256i bswap = _mm256_setr_epi8(
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m256i check_mask = _mm256_set1_epi32((int)HEADER_CHECK_MASK);
+    const __m256i check_value = _mm256_set1_epi32((int)HEADER_CHECK_VALUE);
+
+    uint64_t mask = 0;
+    unsigned int i = 0;
+    for (; i + 8 <= nb; i += 8) {
+        __m256i h = _mm256_i32gather_epi32(
+                (const int *)(buf + i * UPIPE_TS_ETR290_PACKET_SIZE),
+                offsets, 1);
+        h = _mm256_shuffle_epi8(h, bswap);
+        _mm256_storeu_si256((__m256i *)(headers + i), h);
+        __m256i ok = _mm256_cmpeq_epi32(_mm256_and_si256(h, check_mask),
+                                        check_value);
+        unsigned int bad =
+            ~(unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(ok)) & 0xff;
+        mask |= (uint64_t)bad << i;
+    }
+    if (i < nb)
+        mask |= upipe_ts_etr290_headers_c(
+                buf + i * UPIPE_TS_ETR290_PACKET_SIZE, nb - i,
+                headers + i) << i;
+    return mask;
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+uint64_t upipe_ts_etr290_headers_neon(const uint8_t *buf, unsigned int nb,
+                                      uint32_t *headers)
+{
+    static const uint32_t weights[4] = { 1, 2, 4, 8 };
+    const uint32x4_t w = vld1q_u32(weights);
+    const uint32x4_t check_mask = vdupq_n_u32(HEADER_CHECK_MASK);
+    const uint32x4_t check_value = vdupq_n_u32(HEADER_CHECK_VALUE);
+
+    uint64_t mask = 0;
+    unsigned int i = 0;
+    for (; i + 4 <= nb; i += 4) {
+        const uint8_t *p = buf + i * UPIPE_TS_ETR290_PACKET_SIZE;
+        uint32x4_t h = vdupq_n_u32(0);
+        h = vld1q_lane_u32((const uint32_t *)p, h, 0);
+        h = vld1q_lane_u32((const uint32_t *)(p + UPIPE_TS_ETR290_PACKET_SIZE),
+                           h, 1);
+        h = vld1q_lane_u32(
+                (const uint32_t *)(p + 2 * UPIPE_TS_ETR290_PACKET_SIZE), h, 2);
+        h = vld1q_lane_u32(
+                (const uint32_t *)(p + 3 * UPIPE_TS_ETR290_PACKET_SIZE), h, 3);
+        h = vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(h)));
+        vst1q_u32(headers + i, h);
+        uint32x4_t ok = vceqq_u32(vandq_u32(h, check_mask), check_value);
+        unsigned int good = vaddvq_u32(vandq_u32(ok, w));
+        mask |= (uint64_t)(~good & 0xf) << i;
+    }
+    if (i < nb)
+        mask |= upipe_ts_etr290_headers_c(
+                buf + i * UPIPE_TS_ETR290_PACKET_SIZE, nb - i,
+                headers + i) << i;
+    return mask;
+}
+#endif
+
+/** @This extracts the headers of consecutive TS packets, using the fastest
+ * implementation supported by the CPU.
+ *
+ * @param buf first packet
+ * @param nb number of packets, at most @ref UPIPE_TS_ETR290_HEADERS_MAX
+ * @param headers filled in with the headers of the packets, in host order
+ * @return bitmask of the packets having a sync byte different from 0x47 or
+ * the transport_error_indicator set
+ */
+uint64_t upipe_ts_etr290_headers(const uint8_t *buf, unsigned int nb,
+                                 uint32_t *headers)
+{
+#if defined(__i686__) || defined(__x86_64__)
+    if (nb >= 8 && __builtin_cpu_supports("avx2"))
+        return upipe_ts_etr290_headers_avx2(buf, nb, headers);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    if (nb >= 4)
+        return upipe_ts_etr290_headers_neon(buf, nb, headers);
+#endif
+    return upipe_ts_etr290_headers_c(buf, nb, headers);
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe kernels extracting the headers of a burst of TS packets
+ * The 4-octet headers of consecutive packets are gathered, converted to
+ * host order, and checked for a wrong sync byte or a transport error in a
+ * single pass, so that the analysis of a burst only looks at the rest of a
+ * packet when its header requires it.
+ */
+
+#ifndef _UPIPE_TS_UPIPE_TS_ETR290_HEADERS_H_
+/** @hidden */
+#define _UPIPE_TS_UPIPE_TS_ETR290_HEADERS_H_
+
+#include <stdint.h>
+
+/** size of a TS packet */
+#define UPIPE_TS_ETR290_PACKET_SIZE 188
+/** maximum number of packets processed by a call to the kernels */
+#define UPIPE_TS_ETR290_HEADERS_MAX 64
+
+/** @This extracts the headers of consecutive TS packets.
+ *
+ * @param buf first packet
+ * @param nb number of packets, at most @ref UPIPE_TS_ETR290_HEADERS_MAX
+ * @param headers filled in with the headers of the packets, in host order
+ * @return bitmask of the packets having a sync byte different from 0x47 or
+ * the transport_error_indicator set
+ */
+typedef uint64_t (*upipe_ts_etr290_headers_func)(const uint8_t *buf,
+                                                 unsigned int nb,
+                                                 uint32_t *headers);
+
+/* one packet at a time */
+uint64_t upipe_ts_etr290_headers_c(const uint8_t *buf, unsigned int nb,
+                                   uint32_t *headers);
+
+#if defined(__i686__) || defined(__x86_64__)
+/* 8 packets at a time */
+uint64_t upipe_ts_etr290_headers_avx2(const uint8_t *buf, unsigned int nb,
+                                      uint32_t *headers);
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/* 4 packets at a time */
+uint64_t upipe_ts_etr290_headers_neon(const uint8_t *buf, unsigned int nb,
+                                      uint32_t *headers);
+#endif
+
+/** @This extracts the headers of consecutive TS packets, using the fastest
+ * implementation supported by the CPU.
+ *
+ * @param buf first packet
+ * @param nb number of packets, at most @ref UPIPE_TS_ETR290_HEADERS_MAX
+ * @param headers filled in with the headers of the packets, in host order
+ * @return bitmask of the packets having a sync byte different from 0x47 or
+ * the transport_error_indicator set
+ */
+uint64_t upipe_ts_etr290_headers(const uint8_t *buf, unsigned int nb,
+                                 uint32_t *headers);
+
+#endif
@@ -63,6 +63,8 @@
 #include <upipe/upipe_helper_inner.h>
 #include <upipe/upipe_helper_bin_input.h>
 #include <upipe/upipe_helper_subpipe.h>
+#include <upipe-modules/upipe_worker_linear.h>
+#include <upipe-modules/upipe_worker_pool.h>
 #include <upipe-framers/uref_h265_flow.h>
 #include <upipe-framers/uref_h26x_flow.h>
 #include <upipe-framers/uref_mpga_flow.h>
@@ -178,6 +180,17 @@
 /** default first automatic PID */
 #define DEFAULT_PID_AUTO 256
 
+/** default maximum delay of a packet in VBR mode */
+#define DEFAULT_VBR_JITTER (UCLOCK_FREQ / 100)
+/** minimum statistical multiplexing period */
+#define STATMUX_MIN_PERIOD (UCLOCK_FREQ / 10)
+/** maximum statistical multiplexing weight of a program */
+#define STATMUX_MAX_WEIGHT 255
+/** T-STD fullness (per mille) assumed when no sample was taken */
+#define STATMUX_DEFAULT_FULLNESS 500
+/** minimum relative change (per mille) suggested to an encoder */
+#define STATMUX_MIN_CHANGE 20
+
 /** define to debug file mode */
 #undef DEBUG_FILE
 
@@ -204,6 +217,10 @@ struct upipe_ts_mux_mgr {
     /** pointer to ts_tstd manager */
     struct upipe_mgr *ts_tstd_mgr;
 
+    /* workers */
+    /** pool of worker threads */
+    struct upipe_work_pool workers;
+
     /** public upipe_mgr structure */
     struct upipe_mgr mgr;
 };
@@ -216,6 +233,31 @@ static int upipe_ts_mux_check(struct upipe *upipe, struct uref *unused);
 
 /** @hidden */
 struct upipe_ts_mux_psi_pid;
+/** @hidden */
+struct upipe_ts_mux_input;
+
+/** @internal @This identifies the heaps used to schedule inputs. */
+enum upipe_ts_mux_heap_type {
+    /** inputs ordered by dts_sys */
+    UPIPE_TS_MUX_HEAP_DTS,
+    /** inputs ordered by pcr_sys */
+    UPIPE_TS_MUX_HEAP_PCR,
+    /** inputs ordered by cr_sys */
+    UPIPE_TS_MUX_HEAP_CR,
+
+    /** number of heaps */
+    UPIPE_TS_MUX_HEAP_NB
+};
+
+/** @internal @This is a binary min-heap of inputs. */
+struct upipe_ts_mux_heap {
+    /** array of inputs */
+    struct upipe_ts_mux_input **inputs;
+    /** number of inputs in the heap */
+    unsigned int nb;
+    /** allocated size of the array */
+    unsigned int size;
+};
 
 /** @internal @This is the private context of a ts_mux pipe. */
 struct upipe_ts_mux {
@@ -337,6 +379,12 @@ struct upipe_ts_mux {
     uint64_t interval;
     /** mux mode */
     enum upipe_ts_mux_mode mode;
+    /** maximum delay of a packet in VBR mode */
+    uint64_t vbr_jitter;
+    /** statistical multiplexing period, or 0 */
+    uint64_t statmux_period;
+    /** date of the next statistical multiplexing reallocation */
+    uint64_t statmux_next;
     /** MTU */
     size_t mtu;
     /** size of the TB buffer */
@@ -348,6 +396,12 @@ struct upipe_ts_mux {
     struct uchain psi_pids_splice;
     /** list of inputs that are actually PSI */
     struct uchain psi_inputs;
+    /** heaps of all inputs, updated on each status change */
+    struct upipe_ts_mux_heap heaps[UPIPE_TS_MUX_HEAP_NB];
+    /** order of the next input in the heaps, to break ties */
+    uint64_t heap_order;
+    /** number of inputs which are not ready */
+    unsigned int nb_not_ready;
     /** max latency of the subpipes */
     uint64_t latency;
     /** date of the current uref (system time, latency taken into account) */
@@ -408,6 +462,8 @@ static void upipe_ts_mux_work(struct upipe *upipe, struct upump **upump_p);
 /** @hidden */
 static void upipe_ts_mux_update(struct upipe *upipe);
 /** @hidden */
+static void upipe_ts_mux_statmux(struct upipe *upipe);
+/** @hidden */
 static bool upipe_ts_mux_find_sid(struct upipe *upipe, uint16_t sid);
 /** @hidden */
 static bool upipe_ts_mux_find_pid(struct upipe *upipe, uint16_t pid);
@@ -456,6 +512,10 @@ struct upipe_ts_mux_program {
     uint64_t max_delay;
     /** AAC encapsulation */
     int aac_encaps;
+    /** statistical multiplexing weight */
+    unsigned int statmux_weight;
+    /** wlin manager running the T-STD of inputs, or NULL */
+    struct upipe_mgr *worker_mgr;
 
     /** input flow definition */
     struct uref *flow_def_input;
@@ -529,6 +589,18 @@ struct upipe_ts_mux_input {
     bool pcr;
     /** calculated required octetrate including overheads */
     uint64_t required_octetrate;
+    /** maximum octetrate allowed by the flow definition, or 0 */
+    uint64_t max_octetrate;
+    /** flow format request of the upstream pipe, or NULL */
+    struct urequest *flow_format_request;
+    /** octetrate allocated by the statistical multiplexing, or 0 */
+    uint64_t statmux_octetrate;
+    /** sum of the T-STD fullness samples (per mille) over the period */
+    uint64_t statmux_fullness;
+    /** number of T-STD fullness samples over the period */
+    uint64_t statmux_samples;
+    /** octetrate demand over the last period */
+    uint64_t statmux_demand;
 
     /** proxy probe */
     struct uprobe probe;
@@ -552,6 +624,10 @@ struct upipe_ts_mux_input {
     uint64_t pcr_sys;
     /** true if the input is ready to output packet */
     bool ready;
+    /** position in each heap of the mux */
+    unsigned int heap_index[UPIPE_TS_MUX_HEAP_NB];
+    /** order of creation, to break ties in the heaps */
+    uint64_t heap_order;
 
     /** psi_pid structure for PSI-based elementary streams */
     struct upipe_ts_mux_psi_pid *psi_pid;
@@ -588,6 +664,202 @@ UPIPE_HELPER_SUBPIPE(upipe_ts_mux_program, upipe_ts_mux_input, input,
 static void upipe_ts_mux_input_free(struct urefcount *urefcount_real);
 
 
+/*
+ * scheduling heaps handling
+ */
+
+/** @internal @This returns the key of an input in a heap.
+ *
+ * @param input description structure of the input
+ * @param type type of heap
+ * @return the key
+ */
+static inline uint64_t upipe_ts_mux_heap_key(struct upipe_ts_mux_input *input,
+                                             enum upipe_ts_mux_heap_type type)
+{
+    switch (type) {
+        case UPIPE_TS_MUX_HEAP_DTS: return input->dts_sys;
+        case UPIPE_TS_MUX_HEAP_PCR: return input->pcr_sys;
+        case UPIPE_TS_MUX_HEAP_CR: return input->cr_sys;
+        default: break;
+    }
+    return UINT64_MAX;
+}
+
+/** @internal @This compares two inputs in a heap. Ties are broken by order
+ * of creation.
+ *
+ * @param a first input
+ * @param b second input
+ * @param type type of heap
+ * @return true if a must be scheduled before b
+ */
+static inline bool upipe_ts_mux_heap_less(struct upipe_ts_mux_input *a,
+                                          struct upipe_ts_mux_input *b,
+                                          enum upipe_ts_mux_heap_type type)
+{
+    uint64_t key_a = upipe_ts_mux_heap_key(a, type);
+    uint64_t key_b = upipe_ts_mux_heap_key(b, type);
+    return key_a < key_b || (key_a == key_b && a->heap_order < b->heap_order);
+}
+
+/** @internal @This stores an input at a given position of a heap.
+ *
+ * @param heap pointer to the heap
+ * @param type type of heap
+ * @param i position in the heap
+ * @param input description structure of the input
+ */
+static inline void upipe_ts_mux_heap_set(struct upipe_ts_mux_heap *heap,
+                                         enum upipe_ts_mux_heap_type type,
+                                         unsigned int i,
+                                         struct upipe_ts_mux_input *input)
+{
+    heap->inputs[i] = input;
+    input->heap_index[type] = i;
+}
+
+/** @internal @This moves an input to its place in a heap after its key has
+ * changed.
+ *
+ * @param heap pointer to the heap
+ * @param type type of heap
+ * @param i current position of the input in the heap
+ */
+static void upipe_ts_mux_heap_sift(struct upipe_ts_mux_heap *heap,
+                                   enum upipe_ts_mux_heap_type type,
+                                   unsigned int i)
+{
+    struct upipe_ts_mux_input *input = heap->inputs[i];
+
+    while (i > 0) {
+        unsigned int parent = (i - 1) / 2;
+        if (!upipe_ts_mux_heap_less(input, heap->inputs[parent], type))
+            break;
+        upipe_ts_mux_heap_set(heap, type, i, heap->inputs[parent]);
+        i = parent;
+    }
+
+    for ( ; ; ) {
+        unsigned int child = 2 * i + 1;
+        if (child >= heap->nb)
+            break;
+        if (child + 1 < heap->nb &&
+            upipe_ts_mux_heap_less(heap->inputs[child + 1],
+                                   heap->inputs[child], type))
+            child++;
+        if (!upipe_ts_mux_heap_less(heap->inputs[child], input, type))
+            break;
+        upipe_ts_mux_heap_set(heap, type, i, heap->inputs[child]);
+        i = child;
+    }
+    upipe_ts_mux_heap_set(heap, type, i, input);
+}
+
+/** @internal @This adds an input to all heaps of the mux.
+ *
+ * @param mux private structure of the mux
+ * @param input description structure of the input
+ * @return an error code
+ */
+static int upipe_ts_mux_heaps_add(struct upipe_ts_mux *mux,
+                                  struct upipe_ts_mux_input *input)
+{
+    input->heap_order = mux->heap_order++;
+    for (int type = 0; type < UPIPE_TS_MUX_HEAP_NB; type++) {
+        struct upipe_ts_mux_heap *heap = &mux->heaps[type];
+        if (heap->nb == heap->size) {
+            unsigned int size = heap->size ? heap->size * 2 : 16;
+            struct upipe_ts_mux_input **inputs =
+                realloc(heap->inputs, size * sizeof(*inputs));
+            UBASE_ALLOC_RETURN(inputs);
+            heap->inputs = inputs;
+            heap->size = size;
+        }
+    }
+    for (int type = 0; type < UPIPE_TS_MUX_HEAP_NB; type++) {
+        struct upipe_ts_mux_heap *heap = &mux->heaps[type];
+        upipe_ts_mux_heap_set(heap, type, heap->nb, input);
+        upipe_ts_mux_heap_sift(heap, type, heap->nb++);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This removes an input from all heaps of the mux.
+ *
+ * @param mux private structure of the mux
+ * @param input description structure of the input
+ */
+static void upipe_ts_mux_heaps_remove(struct upipe_ts_mux *mux,
+                                      struct upipe_ts_mux_input *input)
+{
+    for (int type = 0; type < UPIPE_TS_MUX_HEAP_NB; type++) {
+        struct upipe_ts_mux_heap *heap = &mux->heaps[type];
+        unsigned int i = input->heap_index[type];
+        if (unlikely(i >= heap->nb || heap->inputs[i] != input))
+            continue; /* allocation error */
+        heap->nb--;
+        if (i == heap->nb)
+            continue;
+        upipe_ts_mux_heap_set(heap, type, i, heap->inputs[heap->nb]);
+        upipe_ts_mux_heap_sift(heap, type, i);
+    }
+}
+
+/** @internal @This returns the first input of a heap.
+ *
+ * @param mux private structure of the mux
+ * @param type type of heap
+ * @return pointer to the input, or NULL if there is no input
+ */
+static inline struct upipe_ts_mux_input *
+    upipe_ts_mux_heap_peek(struct upipe_ts_mux *mux,
+                           enum upipe_ts_mux_heap_type type)
+{
+    struct upipe_ts_mux_heap *heap = &mux->heaps[type];
+    return heap->nb ? heap->inputs[0] : NULL;
+}
+
+/** @internal @This updates the scheduling status of an input.
+ *
+ * @param mux private structure of the mux
+ * @param input description structure of the input
+ * @param cr_sys cr_sys of the next packet
+ * @param dts_sys dts_sys of the next packet
+ * @param pcr_sys cr_sys of the next PCR
+ * @param ready true if the input is ready to output packets
+ */
+static void upipe_ts_mux_input_set_status(struct upipe_ts_mux *mux,
+                                          struct upipe_ts_mux_input *input,
+                                          uint64_t cr_sys, uint64_t dts_sys,
+                                          uint64_t pcr_sys, bool ready)
+{
+    if (input->ready != ready) {
+        if (ready)
+            mux->nb_not_ready--;
+        else
+            mux->nb_not_ready++;
+    }
+    input->cr_sys = cr_sys;
+    input->dts_sys = dts_sys;
+    input->pcr_sys = pcr_sys;
+    input->ready = ready;
+    if (mux->statmux_period && ready && input->buffer_duration &&
+        cr_sys != UINT64_MAX && dts_sys != UINT64_MAX) {
+        uint64_t fullness = dts_sys > cr_sys ?
+            (dts_sys - cr_sys) * 1000 / input->buffer_duration : 0;
+        input->statmux_fullness += fullness > 1000 ? 1000 : fullness;
+        input->statmux_samples++;
+    }
+    for (int type = 0; type < UPIPE_TS_MUX_HEAP_NB; type++) {
+        struct upipe_ts_mux_heap *heap = &mux->heaps[type];
+        unsigned int i = input->heap_index[type];
+        if (likely(i < heap->nb && heap->inputs[i] == input))
+            upipe_ts_mux_heap_sift(heap, type, i);
+    }
+}
+
+
 /*
  * psi_pid structure handling
  */
@@ -916,10 +1188,16 @@ static int upipe_ts_mux_input_encaps_probe(struct uprobe *uprobe,
 
     UBASE_SIGNATURE_CHECK(args, UPIPE_TS_ENCAPS_SIGNATURE)
 
-    upipe_ts_mux_input->cr_sys = va_arg(args, uint64_t);
-    upipe_ts_mux_input->dts_sys = va_arg(args, uint64_t);
-    upipe_ts_mux_input->pcr_sys = va_arg(args, uint64_t);
-    upipe_ts_mux_input->ready = !!va_arg(args, int);
+    struct upipe_ts_mux_program *program =
+        upipe_ts_mux_program_from_input_mgr(upipe->mgr);
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_program_mgr(
+                upipe_ts_mux_program_to_upipe(program)->mgr);
+    uint64_t cr_sys = va_arg(args, uint64_t);
+    uint64_t dts_sys = va_arg(args, uint64_t);
+    uint64_t pcr_sys = va_arg(args, uint64_t);
+    bool ready = !!va_arg(args, int);
+    upipe_ts_mux_input_set_status(mux, upipe_ts_mux_input,
+                                  cr_sys, dts_sys, pcr_sys, ready);
     return UBASE_ERR_NONE;
 }
 
@@ -960,6 +1238,12 @@ static struct upipe *upipe_ts_mux_input_alloc(struct upipe_mgr *mgr,
     upipe_ts_mux_input->octetrate = 0;
     upipe_ts_mux_input->buffer_duration = 0;
     upipe_ts_mux_input->required_octetrate = 0;
+    upipe_ts_mux_input->max_octetrate = 0;
+    upipe_ts_mux_input->flow_format_request = NULL;
+    upipe_ts_mux_input->statmux_octetrate = 0;
+    upipe_ts_mux_input->statmux_fullness = 0;
+    upipe_ts_mux_input->statmux_samples = 0;
+    upipe_ts_mux_input->statmux_demand = 0;
     upipe_ts_mux_input->encaps = NULL;
     upipe_ts_mux_input->psig_flow = NULL;
     upipe_ts_mux_input->cr_sys = UINT64_MAX;
@@ -975,6 +1259,10 @@ static struct upipe *upipe_ts_mux_input_alloc(struct upipe_mgr *mgr,
         upipe_ts_mux_input->original_au_per_sec.den = 0;
 
     upipe_ts_mux_input_init_sub(upipe);
+    for (int type = 0; type < UPIPE_TS_MUX_HEAP_NB; type++)
+        upipe_ts_mux_input->heap_index[type] = UINT_MAX;
+    upipe_ts_mux->nb_not_ready++;
+    int err = upipe_ts_mux_heaps_add(upipe_ts_mux, upipe_ts_mux_input);
     uprobe_init(&upipe_ts_mux_input->probe, upipe_ts_mux_input_probe, NULL);
     upipe_ts_mux_input->probe.refcount =
         upipe_ts_mux_input_to_urefcount_real(upipe_ts_mux_input);
@@ -983,14 +1271,33 @@ static struct upipe *upipe_ts_mux_input_alloc(struct upipe_mgr *mgr,
     upipe_ts_mux_input->encaps_probe.refcount =
         upipe_ts_mux_input_to_urefcount_real(upipe_ts_mux_input);
     upipe_throw_ready(upipe);
+    if (unlikely(!ubase_check(err))) {
+        upipe_throw_fatal(upipe, err);
+        return upipe;
+    }
 
     struct upipe_ts_mux_mgr *ts_mux_mgr =
         upipe_ts_mux_mgr_from_upipe_mgr(upipe_ts_mux_to_upipe(upipe_ts_mux)->mgr);
-    if (unlikely((upipe_ts_mux_input->tstd =
-                  upipe_void_alloc(ts_mux_mgr->ts_tstd_mgr,
-                         uprobe_pfx_alloc_va(
-                             uprobe_use(&upipe_ts_mux_input->probe),
-                             UPROBE_LOG_VERBOSE, "tstd"))) == NULL ||
+    if (program->worker_mgr != NULL) {
+        /* T-STD runs in the worker thread, the rest stays here */
+        struct upipe *tstd_remote =
+            upipe_void_alloc(ts_mux_mgr->ts_tstd_mgr,
+                    uprobe_pfx_alloc_va(uprobe_use(ts_mux_mgr->workers.uprobe),
+                                        UPROBE_LOG_VERBOSE, "tstd"));
+        if (likely(tstd_remote != NULL))
+            upipe_ts_mux_input->tstd =
+                upipe_work_pool_alloc(program->worker_mgr,
+                    uprobe_pfx_alloc_va(uprobe_use(&upipe_ts_mux_input->probe),
+                                        UPROBE_LOG_VERBOSE, "tstd worker"),
+                    tstd_remote,
+                    uprobe_pfx_alloc_va(uprobe_use(ts_mux_mgr->workers.uprobe),
+                                        UPROBE_LOG_VERBOSE, "tstd worker"));
+    } else
+        upipe_ts_mux_input->tstd =
+            upipe_void_alloc(ts_mux_mgr->ts_tstd_mgr,
+                    uprobe_pfx_alloc_va(uprobe_use(&upipe_ts_mux_input->probe),
+                                        UPROBE_LOG_VERBOSE, "tstd"));
+    if (unlikely(upipe_ts_mux_input->tstd == NULL ||
                  (upipe_ts_mux_input->encaps =
                   upipe_void_alloc_output(upipe_ts_mux_input->tstd,
                          ts_mux_mgr->ts_encaps_mgr,
@@ -1034,6 +1341,34 @@ static void upipe_ts_mux_input_input(struct upipe *upipe, struct uref *uref,
     upipe_ts_mux_work(upipe_ts_mux_to_upipe(upipe_ts_mux), upump_p);
 }
 
+/** @internal @This sets the maximum retention delay of the T-STD of an
+ * input. If the T-STD runs in a worker thread, the remote event loop is
+ * frozen for the time of the command.
+ *
+ * @param upipe description structure of the pipe
+ * @param delay new delay
+ * @return an error code
+ */
+static int upipe_ts_mux_input_set_tstd_max_delay(struct upipe *upipe,
+                                                 uint64_t delay)
+{
+    struct upipe_ts_mux_input *input = upipe_ts_mux_input_from_upipe(upipe);
+    struct upipe_ts_mux_program *program =
+        upipe_ts_mux_program_from_input_mgr(upipe->mgr);
+    if (input->tstd == NULL)
+        return UBASE_ERR_INVALID;
+    if (program->worker_mgr == NULL)
+        return upipe_ts_mux_set_max_delay(input->tstd, delay);
+
+    UBASE_RETURN(upipe_bin_freeze(input->tstd))
+    struct upipe *tstd_remote;
+    int err = upipe_bin_get_first_inner(input->tstd, &tstd_remote);
+    if (ubase_check(err))
+        err = upipe_ts_mux_set_max_delay(tstd_remote, delay);
+    upipe_bin_thaw(input->tstd);
+    return err;
+}
+
 /** @internal @This sets the input flow definition.
  *
  * @param upipe description structure of the pipe
@@ -1082,6 +1417,7 @@ static int upipe_ts_mux_input_set_flow_def(struct upipe *upipe,
     uint64_t pes_overhead = 0;
     enum upipe_ts_mux_input_type input_type = UPIPE_TS_MUX_INPUT_OTHER;
     uint64_t buffer_size = 0;
+    uint64_t max_octetrate = 0;
     uint64_t max_delay = MAX_DELAY;
     struct urational au_per_sec, original_au_per_sec;
     au_per_sec.num = au_per_sec.den = 0;
@@ -1147,7 +1483,7 @@ static int upipe_ts_mux_input_set_flow_def(struct upipe *upipe,
         UBASE_FATAL(upipe, uref_ts_flow_set_pes_id(flow_def_dup,
                                                 PES_STREAM_ID_VIDEO_MPEG));
 
-        uint64_t max_octetrate = octetrate;
+        max_octetrate = octetrate;
         uref_block_flow_get_max_octetrate(flow_def, &max_octetrate);
         /* ISO/IEC 13818-1 2.4.2.3 */
         UBASE_FATAL(upipe, uref_ts_flow_set_tb_rate(flow_def_dup,
@@ -1263,10 +1599,8 @@ static int upipe_ts_mux_input_set_flow_def(struct upipe *upipe,
 
     if (!ubase_ncmp(def, "void.scte35.")) {
         input_type = UPIPE_TS_MUX_INPUT_SCTE35;
-        input->cr_sys = UINT64_MAX;
-        input->dts_sys = UINT64_MAX;
-        input->pcr_sys = UINT64_MAX;
-        input->ready = false;
+        upipe_ts_mux_input_set_status(upipe_ts_mux, input, UINT64_MAX,
+                                      UINT64_MAX, UINT64_MAX, false);
         ulist_add(&upipe_ts_mux->psi_inputs,
                   upipe_ts_mux_input_to_uchain_psi(input));
 
@@ -1310,7 +1644,7 @@ static int upipe_ts_mux_input_set_flow_def(struct upipe *upipe,
 
     } else { /* standard PES */
         upipe_ts_mux_input_store_bin_input(upipe, upipe_use(input->tstd));
-        upipe_ts_mux_set_max_delay(input->tstd, input->max_delay);
+        upipe_ts_mux_input_set_tstd_max_delay(upipe, input->max_delay);
 
         if (input->psi_pid != NULL) {
             upipe_ts_mux_psi_pid_release(input->psi_pid);
@@ -1350,6 +1684,7 @@ static int upipe_ts_mux_input_set_flow_def(struct upipe *upipe,
     input->input_type = input_type;
     input->pid = pid;
     input->octetrate = octetrate;
+    input->max_octetrate = max_octetrate;
     input->required_octetrate = octetrate + pes_overhead + ts_overhead;
     input->pcr = false; /* reset PCR state to trigger a new PMT */
 
@@ -1380,16 +1715,23 @@ static int upipe_ts_mux_input_set_flow_def(struct upipe *upipe,
  *
  * @param upipe description structure of the pipe
  * @param request description structure of the request
+ * @param octetrate suggested octetrate, or 0
  * @return an error code
  */
 static int upipe_ts_mux_input_provide_flow_format(struct upipe *upipe,
-                                                  struct urequest *request)
+                                                  struct urequest *request,
+                                                  uint64_t octetrate)
 {
     struct upipe_ts_mux_input *input = upipe_ts_mux_input_from_upipe(upipe);
     struct uref *flow_format = uref_dup(request->uref);
     UBASE_ALLOC_RETURN(flow_format);
     /* we never want global headers */
     uref_flow_delete_global(flow_format);
+    if (octetrate &&
+        !ubase_check(uref_block_flow_set_octetrate(flow_format, octetrate))) {
+        uref_free(flow_format);
+        return UBASE_ERR_ALLOC;
+    }
     const char *def;
     if (likely(ubase_check(uref_flow_get_def(flow_format, &def)))) {
         if (!ubase_ncmp(def, "block.h264.") || !ubase_ncmp(def, "block.hevc."))
@@ -1483,12 +1825,23 @@ static int upipe_ts_mux_input_control(struct upipe *upipe,
     switch (command) {
         case UPIPE_REGISTER_REQUEST: {
             struct urequest *request = va_arg(args, struct urequest *);
-            if (request->type == UREQUEST_FLOW_FORMAT)
-                return upipe_ts_mux_input_provide_flow_format(upipe, request);
+            if (request->type == UREQUEST_FLOW_FORMAT) {
+                struct upipe_ts_mux_input *upipe_ts_mux_input =
+                    upipe_ts_mux_input_from_upipe(upipe);
+                upipe_ts_mux_input->flow_format_request = request;
+                return upipe_ts_mux_input_provide_flow_format(upipe, request,
+                                                              0);
+            }
             return upipe_throw_provide_request(upipe, request);
         }
-        case UPIPE_UNREGISTER_REQUEST:
+        case UPIPE_UNREGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            struct upipe_ts_mux_input *upipe_ts_mux_input =
+                upipe_ts_mux_input_from_upipe(upipe);
+            if (upipe_ts_mux_input->flow_format_request == request)
+                upipe_ts_mux_input->flow_format_request = NULL;
             return UBASE_ERR_NONE;
+        }
 
         case UPIPE_SET_FLOW_DEF: {
             struct uref *flow_def = va_arg(args, struct uref *);
@@ -1544,11 +1897,21 @@ static int upipe_ts_mux_input_control(struct upipe *upipe,
             return (*p != NULL) ? UBASE_ERR_NONE : UBASE_ERR_UNHANDLED;
         }
 
-        case UPIPE_TS_MUX_GET_MAX_DELAY:
+        case UPIPE_TS_MUX_GET_MAX_DELAY: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
+            struct upipe_ts_mux_input *upipe_ts_mux_input =
+                upipe_ts_mux_input_from_upipe(upipe);
+            uint64_t *delay_p = va_arg(args, uint64_t *);
+            *delay_p = upipe_ts_mux_input->max_delay;
+            return UBASE_ERR_NONE;
+        }
         case UPIPE_TS_MUX_SET_MAX_DELAY: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
             struct upipe_ts_mux_input *upipe_ts_mux_input =
                 upipe_ts_mux_input_from_upipe(upipe);
-            return upipe_control_va(upipe_ts_mux_input->input, command, args);
+            uint64_t delay = va_arg(args, uint64_t);
+            upipe_ts_mux_input->max_delay = delay;
+            return upipe_ts_mux_input_set_tstd_max_delay(upipe, delay);
         }
         default:
             break;
@@ -1568,7 +1931,12 @@ static void upipe_ts_mux_input_free(struct urefcount *urefcount_real)
     struct upipe *upipe = upipe_ts_mux_input_to_upipe(upipe_ts_mux_input);
     struct upipe_ts_mux_program *program =
         upipe_ts_mux_program_from_input_mgr(upipe->mgr);
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_program_mgr(
+                upipe_ts_mux_program_to_upipe(program)->mgr);
 
+    upipe_ts_mux_heaps_remove(mux, upipe_ts_mux_input);
+    if (!upipe_ts_mux_input->ready)
+        mux->nb_not_ready--;
     upipe_ts_mux_input_clean_sub(upipe);
     if (!upipe_single(upipe_ts_mux_program_to_upipe(program)))
         upipe_ts_mux_program_change(upipe_ts_mux_program_to_upipe(program));
@@ -1737,9 +2105,16 @@ static struct upipe *upipe_ts_mux_program_alloc(struct upipe_mgr *mgr,
     upipe_ts_mux_program->scte35_interval = upipe_ts_mux->scte35_interval;
     upipe_ts_mux_program->aac_encaps = upipe_ts_mux->aac_encaps;
     upipe_ts_mux_program->max_delay = upipe_ts_mux->max_delay;
+    upipe_ts_mux_program->statmux_weight = 1;
     upipe_ts_mux_program->required_octetrate = 0;
+    upipe_ts_mux_program->worker_mgr = NULL;
     upipe_ts_mux_program_init_sub(upipe);
 
+    struct upipe_ts_mux_mgr *ts_mux_mgr =
+        upipe_ts_mux_mgr_from_upipe_mgr(upipe_ts_mux_to_upipe(upipe_ts_mux)->mgr);
+    upipe_ts_mux_program->worker_mgr =
+        upipe_mgr_use(upipe_work_pool_next(&ts_mux_mgr->workers));
+
     uprobe_init(&upipe_ts_mux_program->probe, upipe_ts_mux_program_probe, NULL);
     upipe_ts_mux_program->probe.refcount =
         upipe_ts_mux_program_to_urefcount_real(upipe_ts_mux_program);
@@ -2168,6 +2543,39 @@ static int _upipe_ts_mux_program_set_aac_encaps(struct upipe *upipe, int encaps)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This returns the current statistical multiplexing weight.
+ *
+ * @param upipe description structure of the pipe
+ * @param weight_p filled in with the weight
+ * @return an error code
+ */
+static int upipe_ts_mux_program_get_statmux_weight(struct upipe *upipe,
+                                                   unsigned int *weight_p)
+{
+    struct upipe_ts_mux_program *upipe_ts_mux_program =
+        upipe_ts_mux_program_from_upipe(upipe);
+    assert(weight_p != NULL);
+    *weight_p = upipe_ts_mux_program->statmux_weight;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the statistical multiplexing weight.
+ *
+ * @param upipe description structure of the pipe
+ * @param weight new weight
+ * @return an error code
+ */
+static int upipe_ts_mux_program_set_statmux_weight(struct upipe *upipe,
+                                                   unsigned int weight)
+{
+    struct upipe_ts_mux_program *upipe_ts_mux_program =
+        upipe_ts_mux_program_from_upipe(upipe);
+    if (weight > STATMUX_MAX_WEIGHT)
+        return UBASE_ERR_INVALID;
+    upipe_ts_mux_program->statmux_weight = weight;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a ts_mux_program pipe.
  *
  * @param upipe description structure of the pipe
@@ -2239,6 +2647,16 @@ static int upipe_ts_mux_program_control(struct upipe *upipe,
             uint64_t delay = va_arg(args, uint64_t);
             return upipe_ts_mux_program_set_max_delay(upipe, delay);
         }
+        case UPIPE_TS_MUX_GET_STATMUX_WEIGHT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
+            unsigned int *weight_p = va_arg(args, unsigned int *);
+            return upipe_ts_mux_program_get_statmux_weight(upipe, weight_p);
+        }
+        case UPIPE_TS_MUX_SET_STATMUX_WEIGHT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
+            unsigned int weight = va_arg(args, unsigned int);
+            return upipe_ts_mux_program_set_statmux_weight(upipe, weight);
+        }
         case UPIPE_TS_MUX_GET_AAC_ENCAPS: {
             UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
             int *encaps_p = va_arg(args, int *);
@@ -2288,6 +2706,7 @@ static void upipe_ts_mux_program_free(struct urefcount *urefcount_real)
 
     upipe_throw_dead(upipe);
 
+    upipe_mgr_release(upipe_ts_mux_program->worker_mgr);
     uprobe_clean(&upipe_ts_mux_program->probe);
     urefcount_clean(urefcount_real);
     upipe_ts_mux_program_clean_urefcount(upipe);
@@ -2485,8 +2904,17 @@ static struct upipe *upipe_ts_mux_alloc(struct upipe_mgr *mgr,
 
     ulist_init(&upipe_ts_mux->psi_pids);
     ulist_init(&upipe_ts_mux->psi_pids_splice);
+    for (int type = 0; type < UPIPE_TS_MUX_HEAP_NB; type++) {
+        upipe_ts_mux->heaps[type].inputs = NULL;
+        upipe_ts_mux->heaps[type].nb = upipe_ts_mux->heaps[type].size = 0;
+    }
+    upipe_ts_mux->heap_order = 0;
+    upipe_ts_mux->nb_not_ready = 0;
     ulist_init(&upipe_ts_mux->psi_inputs);
     upipe_ts_mux->mode = UPIPE_TS_MUX_MODE_CBR;
+    upipe_ts_mux->vbr_jitter = DEFAULT_VBR_JITTER;
+    upipe_ts_mux->statmux_period = 0;
+    upipe_ts_mux->statmux_next = UINT64_MAX;
     upipe_ts_mux->tb_size = T_STD_TS_BUFFER;
     upipe_ts_mux->mtu = TS_SIZE;
     upipe_ts_mux->latency = 0;
@@ -2618,15 +3046,18 @@ static uint64_t upipe_ts_mux_show_increment(struct upipe *upipe)
  * @param upipe description structure of the pipe
  * @param ubuf_p filled in with the ubuf to output, or NULL if none is available
  * @param dts_sys_p filled with the dts_sys of the fragment
+ * @param random_p set to true if the packet is a random access point of
+ * the PCR stream of its program
  */
 static void upipe_ts_mux_splice(struct upipe *upipe, struct ubuf **ubuf_p,
-                                uint64_t *dts_sys_p)
+                                uint64_t *dts_sys_p, bool *random_p)
 {
     struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
     uint64_t original_cr_sys = mux->cr_sys - mux->latency;
     struct uchain *uchain;
     int err;
     *ubuf_p = NULL;
+    *random_p = false;
 
     /* Order of priority: 1. PSI */
     while (!ulist_empty(&mux->psi_pids_splice)) {
@@ -2656,51 +3087,50 @@ static void upipe_ts_mux_splice(struct upipe *upipe, struct ubuf **ubuf_p,
         return;
     }
 
-    /* 2. Inputs */
-    uint64_t cr_sys = UINT64_MAX;
-    struct upipe_ts_mux_input *selected_input = NULL;
-    struct uchain *uchain_tmp;
-    ulist_delete_foreach (&mux->programs, uchain, uchain_tmp) {
-        struct upipe_ts_mux_program *program =
-            upipe_ts_mux_program_from_uchain(uchain);
-        upipe_use(upipe_ts_mux_program_to_upipe(program));
-
-        struct uchain *uchain_input, *uchain_tmp2;
-        ulist_delete_foreach (&program->inputs, uchain_input, uchain_tmp2) {
-            struct upipe_ts_mux_input *input =
-                upipe_ts_mux_input_from_uchain(uchain_input);
-            if (input->dts_sys < original_cr_sys) { /* flush */
-                upipe_ts_encaps_splice(input->encaps, original_cr_sys,
-                                       original_cr_sys + mux->interval,
-                                       NULL, NULL);
-
-                if (input->deleted && !input->ready) {
-                    /* This triggers the immediate deletion of the input. */
-                    upipe_release(input->encaps);
-                    continue;
-                }
-            }
+    /* 2. Inputs: flush late packets */
+    for (unsigned int i = mux->heaps[UPIPE_TS_MUX_HEAP_DTS].nb; i > 0; i--) {
+        struct upipe_ts_mux_input *input =
+            upipe_ts_mux_heap_peek(mux, UPIPE_TS_MUX_HEAP_DTS);
+        if (input->dts_sys >= original_cr_sys)
+            break;
+        upipe_ts_encaps_splice(input->encaps, original_cr_sys,
+                               original_cr_sys + mux->interval, NULL, NULL);
 
-            if (input->dts_sys <= original_cr_sys + mux->interval ||
-                input->pcr_sys <= original_cr_sys) {
-                selected_input = input;
-                upipe_release(upipe_ts_mux_program_to_upipe(program));
-                goto upipe_ts_mux_splice_done;
-            }
-            if (input->cr_sys < cr_sys) {
-                selected_input = input;
-                cr_sys = input->cr_sys;
-            }
+        if (input->deleted && !input->ready) {
+            /* This triggers the immediate deletion of the input. */
+            upipe_release(input->encaps);
+            continue;
         }
-
-        upipe_release(upipe_ts_mux_program_to_upipe(program));
+        if (upipe_ts_mux_heap_peek(mux, UPIPE_TS_MUX_HEAP_DTS) == input)
+            break; /* still late, it will be selected below */
     }
 
-    if (selected_input == NULL ||
-        selected_input->cr_sys > original_cr_sys)
-        return;
+    /* 3. Inputs with an imminent DTS or PCR, then the earliest cr_sys */
+    struct upipe_ts_mux_input *selected_input = NULL;
+    struct upipe_ts_mux_input *dts_input =
+        upipe_ts_mux_heap_peek(mux, UPIPE_TS_MUX_HEAP_DTS);
+    struct upipe_ts_mux_input *pcr_input =
+        upipe_ts_mux_heap_peek(mux, UPIPE_TS_MUX_HEAP_PCR);
+    if (dts_input != NULL &&
+        dts_input->dts_sys > original_cr_sys + mux->interval)
+        dts_input = NULL;
+    if (pcr_input != NULL && pcr_input->pcr_sys > original_cr_sys)
+        pcr_input = NULL;
+
+    if (dts_input != NULL && pcr_input != NULL)
+        selected_input = dts_input->dts_sys < pcr_input->pcr_sys +
+                         mux->interval ? dts_input : pcr_input;
+    else if (dts_input != NULL)
+        selected_input = dts_input;
+    else if (pcr_input != NULL)
+        selected_input = pcr_input;
+    else {
+        selected_input = upipe_ts_mux_heap_peek(mux, UPIPE_TS_MUX_HEAP_CR);
+        if (selected_input == NULL ||
+            selected_input->cr_sys > original_cr_sys)
+            return;
+    }
 
-upipe_ts_mux_splice_done:
     err = upipe_ts_encaps_splice(selected_input->encaps, original_cr_sys,
                                  original_cr_sys + mux->interval,
                                  ubuf_p, dts_sys_p);
@@ -2709,6 +3139,20 @@ upipe_ts_mux_splice_done:
         upipe_throw_fatal(upipe, err);
     }
 
+    if (selected_input->pcr && *ubuf_p != NULL) {
+        /* packagers cut segments on the random access points of the
+         * reference stream, which ts_encaps flags in the adaptation field */
+        uint8_t buffer[TS_HEADER_SIZE_AF];
+        const uint8_t *ts_header = ubuf_block_peek(*ubuf_p, 0,
+                                                   TS_HEADER_SIZE_AF, buffer);
+        if (ts_header != NULL) {
+            *random_p = ts_has_adaptation(ts_header) &&
+                        ts_get_adaptation(ts_header) &&
+                        tsaf_has_randomaccess(ts_header);
+            ubuf_block_peek_unmap(*ubuf_p, 0, buffer, ts_header);
+        }
+    }
+
     if (selected_input->deleted && !selected_input->ready) {
         /* This triggers the immediate deletion of the input. */
         upipe_release(selected_input->encaps);
@@ -2720,9 +3164,10 @@ upipe_ts_mux_splice_done:
  * @param upipe description structure of the pipe
  * @param ubuf ubuf to append
  * @param dts_sys dts_sys associated with the ubuf
+ * @param random true if the ubuf is a random access point
  */
 static void upipe_ts_mux_append(struct upipe *upipe, struct ubuf *ubuf,
-                                uint64_t dts_sys)
+                                uint64_t dts_sys, bool random)
 {
     struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
     if (mux->uref == NULL) {
@@ -2747,9 +3192,33 @@ static void upipe_ts_mux_append(struct upipe *upipe, struct ubuf *ubuf,
                     dts_sys - (mux->cr_sys - mux->latency));
         uref_block_append(mux->uref, ubuf);
     }
+    if (random)
+        uref_flow_set_random(mux->uref);
     mux->uref_size += TS_SIZE;
 }
 
+/** @internal @This checks if the incomplete uref must be output now in VBR
+ * mode, either because one of its packets would be late or because its first
+ * packet has waited for too long.
+ *
+ * @param upipe description structure of the pipe
+ * @return true if the uref must be output
+ */
+static bool upipe_ts_mux_check_vbr(struct upipe *upipe)
+{
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
+    if (mux->uref == NULL)
+        return false;
+
+    uint64_t next_cr_sys = upipe_ts_mux_show_increment(upipe);
+    uint64_t dts_sys, cr_sys;
+    if (ubase_check(uref_clock_get_dts_sys(mux->uref, &dts_sys)) &&
+        dts_sys + mux->latency < next_cr_sys)
+        return true;
+    return ubase_check(uref_clock_get_cr_sys(mux->uref, &cr_sys)) &&
+           cr_sys + mux->latency + mux->vbr_jitter < next_cr_sys;
+}
+
 /** @internal @This completes a uref and outputs it.
  *
  * @param upipe description structure of the pipe
@@ -2777,30 +3246,35 @@ static void _upipe_ts_mux_watcher(struct upipe *upipe)
     unsigned int nb_packets = 0;
     while (nb_packets < NB_PACKETS) {
         upipe_ts_mux_increment(upipe);
-        if (mux->uref != NULL) /* capped VBR */
+        if (mux->uref != NULL && mux->mode == UPIPE_TS_MUX_MODE_CAPPED)
             uref_clock_set_cr_sys(mux->uref, mux->cr_sys - mux->latency);
 
         while (mux->uref_size < mux->mtu) {
             nb_packets++;
             struct ubuf *ubuf;
             uint64_t dts_sys;
-            upipe_ts_mux_splice(upipe, &ubuf, &dts_sys);
+            bool random;
+            upipe_ts_mux_splice(upipe, &ubuf, &dts_sys, &random);
             if (ubuf == NULL)
                 break;
-            upipe_ts_mux_append(upipe, ubuf, dts_sys);
+            upipe_ts_mux_append(upipe, ubuf, dts_sys, random);
         }
 
         uint64_t dts_sys;
-        if (mux->mode != UPIPE_TS_MUX_MODE_CAPPED ||
-            (mux->uref != NULL &&
-             ubase_check(uref_clock_get_dts_sys(mux->uref, &dts_sys)) &&
-             dts_sys + mux->latency < upipe_ts_mux_show_increment(upipe))) {
+        if (mux->mode == UPIPE_TS_MUX_MODE_VBR) {
+            if (upipe_ts_mux_check_vbr(upipe))
+                upipe_ts_mux_complete(upipe, &mux->upump);
+        } else if (mux->mode != UPIPE_TS_MUX_MODE_CAPPED ||
+                   (mux->uref != NULL &&
+                    ubase_check(uref_clock_get_dts_sys(mux->uref, &dts_sys)) &&
+                    dts_sys + mux->latency <
+                        upipe_ts_mux_show_increment(upipe))) {
             while (mux->uref_size < mux->mtu) {
                 nb_packets++;
                 struct ubuf *ubuf = ubuf_dup(mux->padding);
                 if (ubuf == NULL)
                     break;
-                upipe_ts_mux_append(upipe, ubuf, UINT64_MAX);
+                upipe_ts_mux_append(upipe, ubuf, UINT64_MAX, false);
             }
         }
 
@@ -2833,6 +3307,13 @@ static uint64_t upipe_ts_mux_check_available(struct upipe *upipe)
     struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
     uint64_t min_cr_sys = UINT64_MAX;
 
+    if (likely(!mux->nb_not_ready)) {
+        /* all inputs are ready: the earliest cr_sys is on top of the heap */
+        struct upipe_ts_mux_input *input =
+            upipe_ts_mux_heap_peek(mux, UPIPE_TS_MUX_HEAP_CR);
+        return input != NULL ? input->cr_sys : UINT64_MAX;
+    }
+
     struct uchain *uchain_program, *uchain_program_tmp;
     ulist_delete_foreach (&mux->programs, uchain_program,
                           uchain_program_tmp) {
@@ -2911,9 +3392,10 @@ static void upipe_ts_mux_work_file(struct upipe *upipe, struct upump **upump_p)
 
         struct ubuf *ubuf;
         uint64_t dts_sys;
-        upipe_ts_mux_splice(upipe, &ubuf, &dts_sys);
+        bool random;
+        upipe_ts_mux_splice(upipe, &ubuf, &dts_sys, &random);
         if (ubuf != NULL) {
-            upipe_ts_mux_append(upipe, ubuf, dts_sys);
+            upipe_ts_mux_append(upipe, ubuf, dts_sys, random);
             if (mux->uref_size >= mux->mtu) {
                 upipe_ts_mux_complete(upipe, &mux->upump);
                 upipe_ts_mux_increment(upipe);
@@ -2921,6 +3403,13 @@ static void upipe_ts_mux_work_file(struct upipe *upipe, struct upump **upump_p)
             continue;
         }
 
+        if (mux->mode == UPIPE_TS_MUX_MODE_VBR) {
+            if (upipe_ts_mux_check_vbr(upipe))
+                upipe_ts_mux_complete(upipe, upump_p);
+            upipe_ts_mux_increment(upipe);
+            continue;
+        }
+
         if (mux->mode == UPIPE_TS_MUX_MODE_CAPPED &&
             (mux->uref == NULL ||
              !ubase_check(uref_clock_get_dts_sys(mux->uref, &dts_sys)) ||
@@ -2933,7 +3422,7 @@ static void upipe_ts_mux_work_file(struct upipe *upipe, struct upump **upump_p)
             struct ubuf *ubuf = ubuf_dup(mux->padding);
             if (ubuf == NULL)
                 break;
-            upipe_ts_mux_append(upipe, ubuf, UINT64_MAX);
+            upipe_ts_mux_append(upipe, ubuf, UINT64_MAX, false);
         }
 
         upipe_ts_mux_complete(upipe, upump_p);
@@ -3008,6 +3497,136 @@ static void upipe_ts_mux_work(struct upipe *upipe, struct upump **upump_p)
         upipe_ts_mux_work_file(upipe, upump_p);
     else
         upipe_ts_mux_work_live(upipe, upump_p);
+    upipe_ts_mux_statmux(upipe);
+}
+
+/** @internal @This resets the T-STD fullness samples of all inputs.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_mux_statmux_reset(struct upipe *upipe)
+{
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
+    struct uchain *uchain_program;
+    ulist_foreach (&mux->programs, uchain_program) {
+        struct upipe_ts_mux_program *program =
+            upipe_ts_mux_program_from_uchain(uchain_program);
+        struct uchain *uchain;
+        ulist_foreach (&program->inputs, uchain) {
+            struct upipe_ts_mux_input *input =
+                upipe_ts_mux_input_from_uchain(uchain);
+            input->statmux_fullness = 0;
+            input->statmux_samples = 0;
+        }
+    }
+}
+
+/** @internal @This returns true if the input takes part in the statistical
+ * multiplexing.
+ *
+ * @param program description structure of the program
+ * @param input description structure of the input
+ * @return true if the octetrate of the input may be reallocated
+ */
+static bool upipe_ts_mux_statmux_check(struct upipe_ts_mux_program *program,
+                                       struct upipe_ts_mux_input *input)
+{
+    return program->statmux_weight && !input->deleted &&
+           input->input_type == UPIPE_TS_MUX_INPUT_VIDEO &&
+           input->flow_format_request != NULL && input->octetrate;
+}
+
+/** @internal @This reallocates the octetrate of the video elementary streams
+ * between programs, according to the average fullness of their T-STD buffer
+ * over the last period. Emptier buffers get a larger share of the octetrate
+ * that was allocated to all video streams, so the total octetrate is
+ * unchanged. New octetrates are suggested to the encoders via their flow
+ * format requests.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_mux_statmux(struct upipe *upipe)
+{
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
+    if (!mux->statmux_period || mux->cr_sys == UINT64_MAX)
+        return;
+    if (mux->statmux_next == UINT64_MAX) {
+        mux->statmux_next = mux->cr_sys + mux->statmux_period;
+        return;
+    }
+    if (mux->cr_sys < mux->statmux_next)
+        return;
+    mux->statmux_next += mux->statmux_period;
+    if (mux->statmux_next <= mux->cr_sys)
+        mux->statmux_next = mux->cr_sys + mux->statmux_period;
+
+    uint64_t pool = 0, total_demand = 0;
+    unsigned int nb_inputs = 0;
+    struct upipe_ts_mux_input *last = NULL;
+    struct uchain *uchain_program;
+    ulist_foreach (&mux->programs, uchain_program) {
+        struct upipe_ts_mux_program *program =
+            upipe_ts_mux_program_from_uchain(uchain_program);
+        struct uchain *uchain;
+        ulist_foreach (&program->inputs, uchain) {
+            struct upipe_ts_mux_input *input =
+                upipe_ts_mux_input_from_uchain(uchain);
+            if (!upipe_ts_mux_statmux_check(program, input))
+                continue;
+            if (!input->statmux_octetrate)
+                input->statmux_octetrate = input->octetrate;
+            uint64_t fullness = STATMUX_DEFAULT_FULLNESS;
+            if (input->statmux_samples)
+                fullness = input->statmux_fullness / input->statmux_samples;
+            input->statmux_demand =
+                (uint64_t)program->statmux_weight * (2000 - fullness);
+            pool += input->statmux_octetrate;
+            total_demand += input->statmux_demand;
+            nb_inputs++;
+            last = input;
+        }
+    }
+    upipe_ts_mux_statmux_reset(upipe);
+    if (nb_inputs < 2)
+        return;
+
+    uint64_t remainder = pool;
+    ulist_foreach (&mux->programs, uchain_program) {
+        struct upipe_ts_mux_program *program =
+            upipe_ts_mux_program_from_uchain(uchain_program);
+        struct uchain *uchain;
+        ulist_foreach (&program->inputs, uchain) {
+            struct upipe_ts_mux_input *input =
+                upipe_ts_mux_input_from_uchain(uchain);
+            if (!upipe_ts_mux_statmux_check(program, input))
+                continue;
+
+            /* smooth the allocation to avoid oscillations */
+            uint64_t octetrate = input == last ? remainder :
+                (input->statmux_octetrate * 3 +
+                 pool * input->statmux_demand / total_demand) / 4;
+            if (octetrate > remainder)
+                octetrate = remainder;
+            remainder -= octetrate;
+            input->statmux_octetrate = octetrate;
+
+            if (input->max_octetrate && octetrate > input->max_octetrate)
+                octetrate = input->max_octetrate;
+            uint64_t delta = octetrate > input->octetrate ?
+                octetrate - input->octetrate : input->octetrate - octetrate;
+            if (!octetrate ||
+                delta * 1000 < input->octetrate * STATMUX_MIN_CHANGE)
+                continue;
+
+            struct upipe *sub = upipe_ts_mux_input_to_upipe(input);
+            upipe_verbose_va(sub, "suggesting %"PRIu64" bits/s to the encoder",
+                             octetrate * 8);
+            if (!ubase_check(upipe_ts_mux_input_provide_flow_format(sub,
+                            input->flow_format_request, octetrate)))
+                upipe_warn_va(sub, "unable to suggest %"PRIu64" bits/s",
+                              octetrate * 8);
+        }
+    }
 }
 
 /** @internal @This checks if the input may start.
@@ -4124,6 +4743,67 @@ static int _upipe_ts_mux_set_mode(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This returns the maximum delay of a packet in VBR mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param jitter_p filled in with the delay
+ * @return an error code
+ */
+static int _upipe_ts_mux_get_vbr_jitter(struct upipe *upipe,
+                                        uint64_t *jitter_p)
+{
+    struct upipe_ts_mux *upipe_ts_mux = upipe_ts_mux_from_upipe(upipe);
+    assert(jitter_p != NULL);
+    *jitter_p = upipe_ts_mux->vbr_jitter;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the maximum delay of a packet in VBR mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param jitter new delay
+ * @return an error code
+ */
+static int _upipe_ts_mux_set_vbr_jitter(struct upipe *upipe, uint64_t jitter)
+{
+    struct upipe_ts_mux *upipe_ts_mux = upipe_ts_mux_from_upipe(upipe);
+    upipe_ts_mux->vbr_jitter = jitter;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the current statistical multiplexing period.
+ *
+ * @param upipe description structure of the pipe
+ * @param period_p filled in with the period
+ * @return an error code
+ */
+static int _upipe_ts_mux_get_statmux_period(struct upipe *upipe,
+                                            uint64_t *period_p)
+{
+    struct upipe_ts_mux *upipe_ts_mux = upipe_ts_mux_from_upipe(upipe);
+    assert(period_p != NULL);
+    *period_p = upipe_ts_mux->statmux_period;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the statistical multiplexing period.
+ *
+ * @param upipe description structure of the pipe
+ * @param period new period, or 0 to disable
+ * @return an error code
+ */
+static int _upipe_ts_mux_set_statmux_period(struct upipe *upipe,
+                                            uint64_t period)
+{
+    struct upipe_ts_mux *upipe_ts_mux = upipe_ts_mux_from_upipe(upipe);
+    if (period && period < STATMUX_MIN_PERIOD)
+        return UBASE_ERR_INVALID;
+    upipe_ts_mux->statmux_period = period;
+    upipe_ts_mux->statmux_next = UINT64_MAX;
+    upipe_ts_mux_statmux_reset(upipe);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This returns the current encapsulation for AAC streams.
  *
  * @param upipe description structure of the pipe
@@ -4391,6 +5071,26 @@ static int _upipe_ts_mux_control(struct upipe *upipe, int command, va_list args)
             enum upipe_ts_mux_mode mode = va_arg(args, enum upipe_ts_mux_mode);
             return _upipe_ts_mux_set_mode(upipe, mode);
         }
+        case UPIPE_TS_MUX_GET_VBR_JITTER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
+            uint64_t *jitter_p = va_arg(args, uint64_t *);
+            return _upipe_ts_mux_get_vbr_jitter(upipe, jitter_p);
+        }
+        case UPIPE_TS_MUX_SET_VBR_JITTER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
+            uint64_t jitter = va_arg(args, uint64_t);
+            return _upipe_ts_mux_set_vbr_jitter(upipe, jitter);
+        }
+        case UPIPE_TS_MUX_GET_STATMUX_PERIOD: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
+            uint64_t *period_p = va_arg(args, uint64_t *);
+            return _upipe_ts_mux_get_statmux_period(upipe, period_p);
+        }
+        case UPIPE_TS_MUX_SET_STATMUX_PERIOD: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
+            uint64_t period = va_arg(args, uint64_t);
+            return _upipe_ts_mux_set_statmux_period(upipe, period);
+        }
         case UPIPE_TS_MUX_GET_AAC_ENCAPS: {
             UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
             int *encaps_p = va_arg(args, int *);
@@ -4466,7 +5166,7 @@ static void upipe_ts_mux_free(struct urefcount *urefcount_real)
             struct ubuf *ubuf = ubuf_dup(mux->padding);
             if (ubuf == NULL)
                 break;
-            upipe_ts_mux_append(upipe, ubuf, UINT64_MAX);
+            upipe_ts_mux_append(upipe, ubuf, UINT64_MAX, false);
         }
 
         upipe_ts_mux_complete(upipe, NULL);
@@ -4474,6 +5174,8 @@ static void upipe_ts_mux_free(struct urefcount *urefcount_real)
 
     upipe_throw_dead(upipe);
 
+    for (int type = 0; type < UPIPE_TS_MUX_HEAP_NB; type++)
+        free(mux->heaps[type].inputs);
     ubuf_free(mux->padding);
     uref_free(mux->flow_def_input);
     uprobe_clean(&mux->probe);
@@ -4530,6 +5232,7 @@ static void upipe_ts_mux_mgr_free(struct urefcount *urefcount)
     upipe_mgr_release(ts_mux_mgr->ts_psig_mgr);
     upipe_mgr_release(ts_mux_mgr->ts_sig_mgr);
     upipe_mgr_release(ts_mux_mgr->ts_scte35g_mgr);
+    upipe_work_pool_clean(&ts_mux_mgr->workers);
 
     urefcount_clean(urefcount);
     free(ts_mux_mgr);
@@ -4572,6 +5275,15 @@ static int upipe_ts_mux_mgr_control(struct upipe_mgr *mgr,
         GET_SET_MGR(ts_sig, TS_SIG)
 #undef GET_SET_MGR
 
+        case UPIPE_TS_MUX_MGR_GET_WORKERS:
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
+            return upipe_work_pool_get_workers_va(&ts_mux_mgr->workers, args);
+        case UPIPE_TS_MUX_MGR_SET_WORKERS:
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
+            if (!urefcount_single(&ts_mux_mgr->urefcount))
+                return UBASE_ERR_BUSY;
+            return upipe_work_pool_set_workers_va(&ts_mux_mgr->workers, args);
+
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -4624,6 +5336,12 @@ const char *upipe_ts_mux_command_str(int cmd)
         UBASE_CASE_TO_STR(UPIPE_TS_MUX_SET_ENCODING);
         UBASE_CASE_TO_STR(UPIPE_TS_MUX_FREEZE_PSI);
         UBASE_CASE_TO_STR(UPIPE_TS_MUX_PREPARE);
+        UBASE_CASE_TO_STR(UPIPE_TS_MUX_GET_STATMUX_PERIOD);
+        UBASE_CASE_TO_STR(UPIPE_TS_MUX_SET_STATMUX_PERIOD);
+        UBASE_CASE_TO_STR(UPIPE_TS_MUX_GET_STATMUX_WEIGHT);
+        UBASE_CASE_TO_STR(UPIPE_TS_MUX_SET_STATMUX_WEIGHT);
+        UBASE_CASE_TO_STR(UPIPE_TS_MUX_GET_VBR_JITTER);
+        UBASE_CASE_TO_STR(UPIPE_TS_MUX_SET_VBR_JITTER);
         default: break;
     }
     return NULL;
@@ -4655,6 +5373,7 @@ struct upipe_mgr *upipe_ts_mux_mgr_alloc(void)
         return NULL;
 
     memset(ts_mux_mgr, 0, sizeof(*ts_mux_mgr));
+    upipe_work_pool_init(&ts_mux_mgr->workers);
     ts_mux_mgr->ts_encaps_mgr = upipe_ts_encaps_mgr_alloc();
     ts_mux_mgr->ts_tstd_mgr = upipe_ts_tstd_mgr_alloc();
     ts_mux_mgr->ts_psi_join_mgr = upipe_ts_psi_join_mgr_alloc();
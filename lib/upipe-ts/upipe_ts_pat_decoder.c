@@ -42,6 +42,7 @@
 #include <upipe-ts/upipe_ts_pat_decoder.h>
 #include <upipe-ts/uref_ts_flow.h>
 #include "upipe_ts_psi_decoder.h"
+#include "upipe_ts_crc.h"
 
 #include <stdlib.h>
 #include <stdbool.h>
@@ -204,7 +205,7 @@ static bool upipe_ts_patd_table_validate(struct upipe *upipe)
                                                   &section))))
             return false;
 
-        if (!pat_validate(section) || !psi_check_crc(section)) {
+        if (!pat_validate(section) || !upipe_ts_psi_check_crc(section)) {
             uref_block_unmap(section_uref, 0);
             return false;
         }
@@ -499,6 +500,24 @@ static int _upipe_ts_patd_get_nit(struct upipe *upipe, struct uref **p)
     return UBASE_ERR_UNHANDLED;
 }
 
+/** @internal @This appends the sections of the PAT in effect to a uref.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref block uref to append the sections to
+ * @return an error code
+ */
+static int _upipe_ts_patd_export(struct upipe *upipe, struct uref *uref)
+{
+    struct upipe_ts_patd *upipe_ts_patd = upipe_ts_patd_from_upipe(upipe);
+    if (!upipe_ts_psid_table_validate(upipe_ts_patd->pat))
+        return UBASE_ERR_INVALID;
+
+    upipe_ts_psid_table_foreach (upipe_ts_patd->pat, section) {
+        UBASE_RETURN(upipe_ts_psid_export(section, uref))
+    }
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands.
  *
  * @param upipe description structure of the pipe
@@ -524,6 +543,11 @@ static int upipe_ts_patd_control(struct upipe *upipe, int command, va_list args)
             struct uref **p = va_arg(args, struct uref **);
             return _upipe_ts_patd_get_nit(upipe, p);
         }
+        case UPIPE_TS_PATD_EXPORT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_PATD_SIGNATURE)
+            struct uref *uref = va_arg(args, struct uref *);
+            return _upipe_ts_patd_export(upipe, uref);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
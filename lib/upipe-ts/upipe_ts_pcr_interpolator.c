@@ -37,6 +37,7 @@
 #include <upipe/upipe_helper_urefcount.h>
 #include <upipe/upipe_helper_void.h>
 #include <upipe/upipe_helper_output.h>
+#include <upipe/uts_pcr.h>
 #include <upipe-ts/upipe_ts_pcr_interpolator.h>
 
 #include <stdlib.h>
@@ -62,17 +63,11 @@ struct upipe_ts_pcr_interpolator {
     /** list of output requests */
     struct uchain request_list;
 
-    /** previous PCR value */
-    uint64_t last_pcr;
+    /** PCR interpolator */
+    struct uts_pcr_interp interp;
 
-    /** number of TS packets since last PCR */
-    unsigned int packets;
-
-    /** number of TS packets between the last 2 PCRs */
-    unsigned int pcr_packets;
-
-    /** delta between the last 2 PCRs */
-    uint64_t pcr_delta;
+    /** cumulative number of octets received */
+    uint64_t offset;
 
     /** if next packet output should show discontinuity */
     bool discontinuity;
@@ -106,10 +101,8 @@ static struct upipe *upipe_ts_pcr_interpolator_alloc(struct upipe_mgr *mgr,
     struct upipe_ts_pcr_interpolator *upipe_ts_pcr_interpolator = upipe_ts_pcr_interpolator_from_upipe(upipe);
     upipe_ts_pcr_interpolator_init_urefcount(upipe);
     upipe_ts_pcr_interpolator_init_output(upipe);
-    upipe_ts_pcr_interpolator->last_pcr = 0;
-    upipe_ts_pcr_interpolator->packets = 0;
-    upipe_ts_pcr_interpolator->pcr_packets = 0;
-    upipe_ts_pcr_interpolator->pcr_delta = 0;
+    uts_pcr_interp_init(&upipe_ts_pcr_interpolator->interp);
+    upipe_ts_pcr_interpolator->offset = 0;
     upipe_ts_pcr_interpolator->discontinuity = true;
 
     upipe_throw_ready(upipe);
@@ -126,45 +119,37 @@ static void upipe_ts_pcr_interpolator_input(struct upipe *upipe, struct uref *ur
                                   struct upump **upump_p)
 {
     struct upipe_ts_pcr_interpolator *upipe_ts_pcr_interpolator = upipe_ts_pcr_interpolator_from_upipe(upipe);
+    struct uts_pcr_interp *interp = &upipe_ts_pcr_interpolator->interp;
     bool discontinuity = ubase_check(uref_flow_get_discontinuity(uref));
     if (discontinuity) {
-        upipe_ts_pcr_interpolator->last_pcr = 0;
-        upipe_ts_pcr_interpolator->packets = 0;
-        upipe_ts_pcr_interpolator->pcr_packets = 0;
-        upipe_ts_pcr_interpolator->pcr_delta = 0;
+        uts_pcr_interp_discontinuity(interp);
         upipe_ts_pcr_interpolator->discontinuity = true;
-        upipe_notice_va(upipe, "Clearing state");
+        upipe_notice_va(upipe, "discontinuity, waiting for the next PCR");
     }
 
-    upipe_ts_pcr_interpolator->packets++;
+    uint64_t offset = upipe_ts_pcr_interpolator->offset;
+    size_t size = 0;
+    uref_block_size(uref, &size);
+    upipe_ts_pcr_interpolator->offset += size;
 
     uint64_t pcr_prog = 0;
     uref_clock_get_cr_prog(uref, &pcr_prog);
 
     if (pcr_prog) {
-        uint64_t delta = pcr_prog - upipe_ts_pcr_interpolator->last_pcr;
-        upipe_ts_pcr_interpolator->last_pcr = pcr_prog;
-
-        upipe_verbose_va(upipe,
-                "pcr_prog %"PRId64" offset %"PRId64" stored offset %"PRIu64" bitrate %"PRId64" bps",
-                pcr_prog, delta,
-                upipe_ts_pcr_interpolator->pcr_delta,
-                INT64_C(27000000) * upipe_ts_pcr_interpolator->packets * 188 * 8 / delta);
-
-        if (upipe_ts_pcr_interpolator->pcr_delta)
-            upipe_ts_pcr_interpolator->pcr_packets = upipe_ts_pcr_interpolator->packets;
-
-        upipe_ts_pcr_interpolator->pcr_delta = delta;
-        upipe_ts_pcr_interpolator->packets = 0;
-    } else if (upipe_ts_pcr_interpolator->pcr_packets) {
-        uint64_t offset = upipe_ts_pcr_interpolator->pcr_delta *
-                    upipe_ts_pcr_interpolator->packets / upipe_ts_pcr_interpolator->pcr_packets;
-        uint64_t prog = upipe_ts_pcr_interpolator->last_pcr + offset;
-        uref_clock_set_date_prog(uref, prog, UREF_DATE_CR);
-        upipe_throw_clock_ts(upipe, uref);
+        if (uts_pcr_interp_update(interp, offset, pcr_prog))
+            upipe_verbose_va(upipe,
+                    "pcr_prog %"PRIu64" bitrate %"PRIu64" bps", pcr_prog,
+                    ((UINT64_C(27000000) * 8) << UTS_PCR_INTERP_SHIFT) /
+                    interp->rate);
+    } else {
+        uint64_t prog;
+        if (uts_pcr_interp_get(interp, offset, &prog)) {
+            uref_clock_set_date_prog(uref, prog, UREF_DATE_CR);
+            upipe_throw_clock_ts(upipe, uref);
+        }
     }
 
-    if (!upipe_ts_pcr_interpolator->pcr_packets) {
+    if (!interp->rate || interp->pcr == UINT64_MAX) {
         uref_free(uref);
         return;
     }
@@ -223,8 +208,8 @@ static int upipe_ts_pcr_interpolator_control(struct upipe *upipe,
         case UPIPE_TS_PCR_INTERPOLATOR_GET_BITRATE: {
             UBASE_SIGNATURE_CHECK(args, UPIPE_TS_PCR_INTERPOLATOR_SIGNATURE)
             struct urational *urational = va_arg(args, struct urational *);
-            urational->num = upipe_ts_pcr_interpolator->pcr_packets * 188 * 8;
-            urational->den = upipe_ts_pcr_interpolator->pcr_delta;
+            urational->num = UINT64_C(8) << UTS_PCR_INTERP_SHIFT;
+            urational->den = upipe_ts_pcr_interpolator->interp.rate;
             return UBASE_ERR_NONE;
         }
         default:
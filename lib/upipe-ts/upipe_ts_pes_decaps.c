@@ -79,6 +79,8 @@ struct upipe_ts_pesd {
     bool acquired;
     /** true if subsequent (non-start) packets have to be dropped */
     bool drop;
+    /** true if only PES headers are output, without payload */
+    bool headers_only;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -112,6 +114,7 @@ static struct upipe *upipe_ts_pesd_alloc(struct upipe_mgr *mgr,
     upipe_ts_pesd_init_sync(upipe);
     upipe_ts_pesd_init_output(upipe);
     upipe_ts_pesd->drop = true;
+    upipe_ts_pesd->headers_only = false;
     upipe_ts_pesd->next_uref = NULL;
     upipe_ts_pesd->next_uref_size = 0;
     upipe_throw_ready(upipe);
@@ -147,6 +150,23 @@ static void upipe_ts_pesd_check_output(struct upipe *upipe,
     struct upipe_ts_pesd *upipe_ts_pesd = upipe_ts_pesd_from_upipe(upipe);
     upipe_ts_pesd_sync_acquired(upipe);
     upipe_ts_pesd->drop = false;
+    if (upipe_ts_pesd->headers_only) {
+        /* only keep the attributes parsed from the header */
+        struct uref *uref = upipe_ts_pesd->next_uref;
+        upipe_ts_pesd->next_uref = NULL;
+        ubuf_free(uref_detach_ubuf(uref));
+        uref_block_delete_start(uref);
+        if (upipe_ts_pesd->next_pes_size &&
+            unlikely(!ubase_check(uref_ts_pesd_set_pes_size(uref,
+                        upipe_ts_pesd->next_pes_size)))) {
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        upipe_ts_pesd->next_uref_size = upipe_ts_pesd->next_pes_size = 0;
+        upipe_ts_pesd_output(upipe, uref, upump_p);
+        return;
+    }
     if (upipe_ts_pesd->next_uref_size == upipe_ts_pesd->next_pes_size) {
         uref_block_set_end(upipe_ts_pesd->next_uref);
         upipe_ts_pesd->next_uref_size = upipe_ts_pesd->next_pes_size = 0;
@@ -325,10 +345,11 @@ static void upipe_ts_pesd_input(struct upipe *upipe, struct uref *uref,
         upipe_ts_pesd_decaps(upipe, upump_p);
 
     } else if (upipe_ts_pesd->next_uref != NULL) {
+        /* the PES header is incomplete, including in headers-only mode */
         struct ubuf *ubuf = uref_detach_ubuf(uref);
         uref_free(uref);
-        if (unlikely(!ubase_check(uref_block_append(upipe_ts_pesd->next_uref,
-                                                    ubuf)))) {
+        if (unlikely(!ubase_check(uref_block_append_gather(
+                        upipe_ts_pesd->next_uref, ubuf)))) {
             ubuf_free(ubuf);
             upipe_ts_pesd_flush(upipe, false);
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
@@ -336,7 +357,7 @@ static void upipe_ts_pesd_input(struct upipe *upipe, struct uref *uref,
         }
         upipe_ts_pesd->next_uref_size += uref_size;
         upipe_ts_pesd_decaps(upipe, upump_p);
-    } else if (likely(!upipe_ts_pesd->drop)) {
+    } else if (likely(!upipe_ts_pesd->drop && !upipe_ts_pesd->headers_only)) {
         upipe_ts_pesd->next_uref = uref;
         upipe_ts_pesd->next_uref_size += uref_size;
         upipe_ts_pesd_check_output(upipe, upump_p);
@@ -353,6 +374,7 @@ static void upipe_ts_pesd_input(struct upipe *upipe, struct uref *uref,
 static int upipe_ts_pesd_set_flow_def(struct upipe *upipe,
                                       struct uref *flow_def)
 {
+    struct upipe_ts_pesd *upipe_ts_pesd = upipe_ts_pesd_from_upipe(upipe);
     if (flow_def == NULL)
         return UBASE_ERR_INVALID;
     const char *def;
@@ -364,9 +386,51 @@ static int upipe_ts_pesd_set_flow_def(struct upipe *upipe,
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return UBASE_ERR_ALLOC;
     }
-    if (unlikely(!ubase_check(uref_flow_set_def_va(flow_def_dup, "block.%s",
-                                       def + strlen(EXPECTED_FLOW_DEF)))))
+    if (unlikely(!ubase_check(uref_flow_set_def_va(flow_def_dup, "%s%s",
+                        upipe_ts_pesd->headers_only ? "void." : "block.",
+                        def + strlen(EXPECTED_FLOW_DEF)))))
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+    upipe_ts_pesd_store_flow_def(upipe, flow_def_dup);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the headers-only mode. In this mode, the payload of
+ * the PES is dropped, and an empty uref carrying the timestamps, the random
+ * flag and the PES size is output for each PES header.
+ *
+ * @param upipe description structure of the pipe
+ * @param headers_only true to only output PES headers
+ * @return an error code
+ */
+static int _upipe_ts_pesd_set_headers_only(struct upipe *upipe,
+                                           bool headers_only)
+{
+    struct upipe_ts_pesd *upipe_ts_pesd = upipe_ts_pesd_from_upipe(upipe);
+    if (upipe_ts_pesd->headers_only == headers_only)
+        return UBASE_ERR_NONE;
+    upipe_ts_pesd->headers_only = headers_only;
+    /* the current PES is truncated either way */
+    upipe_ts_pesd_flush(upipe, false);
+
+    if (upipe_ts_pesd->flow_def == NULL)
+        return UBASE_ERR_NONE;
+    const char *def;
+    UBASE_RETURN(uref_flow_get_def(upipe_ts_pesd->flow_def, &def))
+    const char *old_prefix = headers_only ? "block." : "void.";
+    if (ubase_ncmp(def, old_prefix))
+        return UBASE_ERR_INVALID;
+    struct uref *flow_def_dup;
+    if (unlikely((flow_def_dup = uref_dup(upipe_ts_pesd->flow_def)) == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
+    if (unlikely(!ubase_check(uref_flow_set_def_va(flow_def_dup, "%s%s",
+                        headers_only ? "void." : "block.",
+                        def + strlen(old_prefix))))) {
+        uref_free(flow_def_dup);
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
     upipe_ts_pesd_store_flow_def(upipe, flow_def_dup);
     return UBASE_ERR_NONE;
 }
@@ -380,12 +444,24 @@ static int upipe_ts_pesd_set_flow_def(struct upipe *upipe,
  */
 static int upipe_ts_pesd_control(struct upipe *upipe, int command, va_list args)
 {
+    struct upipe_ts_pesd *upipe_ts_pesd = upipe_ts_pesd_from_upipe(upipe);
     UBASE_HANDLED_RETURN(upipe_ts_pesd_control_output(upipe, command, args));
     switch (command) {
         case UPIPE_SET_FLOW_DEF: {
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_ts_pesd_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_TS_PESD_GET_HEADERS_ONLY: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_PESD_SIGNATURE)
+            bool *headers_only_p = va_arg(args, bool *);
+            *headers_only_p = upipe_ts_pesd->headers_only;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_TS_PESD_SET_HEADERS_ONLY: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_PESD_SIGNATURE)
+            bool headers_only = va_arg(args, int);
+            return _upipe_ts_pesd_set_headers_only(upipe, headers_only);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -29,6 +29,7 @@
 #include <upipe/uref_block.h>
 
 #include <stdbool.h>
+#include <string.h>
 #include <assert.h>
 
 #include <bitstream/mpeg/psi.h>
@@ -244,6 +245,86 @@ static inline bool upipe_ts_psid_table_compare(struct uref **sections1,
     return true;
 }
 
+/** size of the key identifying the contents of a PSI section */
+#define UPIPE_TS_PSID_KEY_SIZE (PSI_HEADER_SIZE_SYNTAX1 + PSI_CRC_SIZE)
+
+/** @This extracts the key identifying the contents of a PSI section, made
+ * of its syntax 1 header (table ID, length, table ID extension, version,
+ * section numbers) and of its CRC, without merging it.
+ *
+ * @param section PSI section
+ * @param key filled in with the key (UPIPE_TS_PSID_KEY_SIZE octets)
+ * @return false if the section is too short
+ */
+static inline bool upipe_ts_psid_get_key(struct uref *section, uint8_t *key)
+{
+    if (unlikely(!ubase_check(uref_block_extract(section, 0,
+                                                 PSI_HEADER_SIZE_SYNTAX1,
+                                                 key))))
+        return false;
+    uint16_t length = psi_get_length(key);
+    if (unlikely(length + PSI_HEADER_SIZE <
+                 PSI_HEADER_SIZE_SYNTAX1 + PSI_CRC_SIZE))
+        return false;
+    return ubase_check(uref_block_extract(section,
+                PSI_HEADER_SIZE + length - PSI_CRC_SIZE, PSI_CRC_SIZE,
+                key + PSI_HEADER_SIZE_SYNTAX1));
+}
+
+/** @This checks if a PSI section has the given key.
+ *
+ * @param section PSI section, or NULL
+ * @param key key of the other section
+ * @return true if the section has the same key
+ */
+static inline bool upipe_ts_psid_equal_key(struct uref *section,
+                                           const uint8_t *key)
+{
+    uint8_t section_key[UPIPE_TS_PSID_KEY_SIZE];
+    return section != NULL && upipe_ts_psid_get_key(section, section_key) &&
+           !memcmp(section_key, key, UPIPE_TS_PSID_KEY_SIZE);
+}
+
+/** @This checks if a PSI section is a repetition of the section with the
+ * same number in the given table, comparing only their keys. Since the
+ * version is common to all sections of a table, a repetition belongs to the
+ * table and may be dropped before being gathered, merged or parsed.
+ *
+ * @param sections PSI table
+ * @param uref PSI section
+ * @return true if the section is unchanged
+ */
+static inline bool upipe_ts_psid_table_section_unchanged(
+        struct uref **sections, struct uref *uref)
+{
+    uint8_t key[UPIPE_TS_PSID_KEY_SIZE];
+    if (!upipe_ts_psid_table_validate(sections) ||
+        !upipe_ts_psid_get_key(uref, key))
+        return false;
+    return upipe_ts_psid_equal_key(sections[psi_get_section(key)], key);
+}
+
+/** @This appends a copy of a section to a block uref, attaching the buffer
+ * if the uref has none yet.
+ *
+ * @param section uref containing the section
+ * @param uref block uref to append to
+ * @return an error code
+ */
+static inline int upipe_ts_psid_export(struct uref *section, struct uref *uref)
+{
+    struct ubuf *ubuf = ubuf_dup(section->ubuf);
+    UBASE_ALLOC_RETURN(ubuf);
+    if (uref->ubuf == NULL) {
+        uref_attach_ubuf(uref, ubuf);
+        return UBASE_ERR_NONE;
+    }
+    int err = uref_block_append(uref, ubuf);
+    if (unlikely(!ubase_check(err)))
+        ubuf_free(ubuf);
+    return err;
+}
+
 /** @This calls @ref ubuf_block_merge on all sections of the PSI table.
  *
  * @param sections PSI table
@@ -169,13 +169,23 @@ static int upipe_ts_psi_join_sub_set_flow_def(struct upipe *upipe,
     UBASE_RETURN(uref_flow_match_def(flow_def, EXPECTED_FLOW_DEF))
 
     struct upipe_ts_psi_join_sub *sub = upipe_ts_psi_join_sub_from_upipe(upipe);
-    sub->octetrate = 0;
-    uref_block_flow_get_octetrate(flow_def, &sub->octetrate);
-    sub->section_interval = 0;
-    uref_ts_flow_get_psi_section_interval(flow_def, &sub->section_interval);
-    sub->latency = 0;
-    uref_clock_get_latency(flow_def, &sub->latency);
-
+    uint64_t octetrate = 0;
+    uref_block_flow_get_octetrate(flow_def, &octetrate);
+    uint64_t section_interval = 0;
+    uref_ts_flow_get_psi_section_interval(flow_def, &section_interval);
+    uint64_t latency = 0;
+    uref_clock_get_latency(flow_def, &latency);
+
+    /* with many inputs, rebuilding would walk all of them and send a new
+     * flow definition downstream for nothing */
+    if (octetrate == sub->octetrate &&
+        section_interval == sub->section_interval &&
+        latency == sub->latency)
+        return UBASE_ERR_NONE;
+
+    sub->octetrate = octetrate;
+    sub->section_interval = section_interval;
+    sub->latency = latency;
     return upipe_ts_psi_join_build_flow_def(
             upipe_ts_psi_join_to_upipe(upipe_ts_psi_join));
 }
@@ -132,7 +132,8 @@ static bool upipe_ts_psim_merge(struct upipe *upipe, struct uref *uref,
     if (upipe_ts_psim->next_uref != NULL) {
         struct ubuf *ubuf = ubuf_dup(uref->ubuf);
         if (unlikely(ubuf == NULL ||
-                     !ubase_check(uref_block_append(upipe_ts_psim->next_uref, ubuf)))) {
+                     !ubase_check(uref_block_append_gather(upipe_ts_psim->next_uref,
+                                                          ubuf)))) {
             upipe_ts_psim_flush(upipe);
             if (ubuf != NULL)
                 ubuf_free(ubuf);
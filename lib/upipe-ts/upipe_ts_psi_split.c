@@ -45,9 +45,17 @@
 #include <assert.h>
 
 #include <bitstream/mpeg/ts.h>
+#include <bitstream/mpeg/psi.h>
 
 /** we only accept blocks containing exactly one PSI section */
 #define EXPECTED_FLOW_DEF "block.mpegtspsi."
+/** number of lists of outputs filtering a table_id and extension */
+#define EXTENSION_BUCKETS 256
+
+/** @internal @This returns the list of outputs filtering a table_id and
+ * extension. */
+#define EXTENSION_BUCKET(table_id, extension)                               \
+    (((table_id) ^ (extension) ^ ((extension) >> 8)) % EXTENSION_BUCKETS)
 
 /** @internal @This is the private context of a ts_psi_split pipe. */
 struct upipe_ts_psi_split {
@@ -58,6 +66,12 @@ struct upipe_ts_psi_split {
 
     /** list of output subpipes */
     struct uchain subs;
+    /** outputs filtering a table_id and extension, hashed */
+    struct uchain extensions[EXTENSION_BUCKETS];
+    /** outputs filtering a table_id only, indexed by table_id */
+    struct uchain tables[256];
+    /** other outputs */
+    struct uchain others;
 
     /** manager to create output subpipes */
     struct upipe_mgr sub_mgr;
@@ -82,6 +96,14 @@ struct upipe_ts_psi_split_sub {
     struct urefcount urefcount;
     /** structure for double-linked lists */
     struct uchain uchain;
+    /** structure for the routing lists */
+    struct uchain uchain_route;
+    /** PSI filter, in flow_def, or NULL */
+    const uint8_t *filter;
+    /** PSI filter mask, in flow_def */
+    const uint8_t *mask;
+    /** PSI filter size */
+    size_t filter_size;
 
     /** pipe acting as output */
     struct upipe *output;
@@ -105,6 +127,40 @@ UPIPE_HELPER_OUTPUT(upipe_ts_psi_split_sub, output, flow_def, output_state, requ
 
 UPIPE_HELPER_SUBPIPE(upipe_ts_psi_split, upipe_ts_psi_split_sub, sub,
                      sub_mgr, subs, uchain)
+UBASE_FROM_TO(upipe_ts_psi_split_sub, uchain, uchain_route, uchain_route)
+
+/** @internal @This adds an output to the routing list matching its filter,
+ * so that a section is only matched against the outputs filtering its
+ * table_id and extension, its table_id, or neither.
+ *
+ * @param upipe description structure of the output subpipe
+ */
+static void upipe_ts_psi_split_sub_route(struct upipe *upipe)
+{
+    struct upipe_ts_psi_split_sub *sub =
+        upipe_ts_psi_split_sub_from_upipe(upipe);
+    struct upipe_ts_psi_split *upipe_ts_psi_split =
+        upipe_ts_psi_split_from_sub_mgr(upipe->mgr);
+    sub->filter = NULL;
+    if (!ubase_check(uref_ts_flow_get_psi_filter(sub->flow_def, &sub->filter,
+                    &sub->mask, &sub->filter_size))) {
+        /* never matches */
+        sub->filter = NULL;
+        return;
+    }
+
+    const uint8_t *filter = sub->filter, *mask = sub->mask;
+    struct uchain *list;
+    if (sub->filter_size >= PSI_HEADER_SIZE + 2 && mask[0] == 0xff &&
+        mask[PSI_HEADER_SIZE] == 0xff && mask[PSI_HEADER_SIZE + 1] == 0xff)
+        list = &upipe_ts_psi_split->extensions[EXTENSION_BUCKET(filter[0],
+                (filter[PSI_HEADER_SIZE] << 8) | filter[PSI_HEADER_SIZE + 1])];
+    else if (sub->filter_size >= 1 && mask[0] == 0xff)
+        list = &upipe_ts_psi_split->tables[filter[0]];
+    else
+        list = &upipe_ts_psi_split->others;
+    ulist_add(list, upipe_ts_psi_split_sub_to_uchain_route(sub));
+}
 
 /** @internal @This allocates an output subpipe of a ts_psi_split pipe.
  *
@@ -129,6 +185,7 @@ static struct upipe *upipe_ts_psi_split_sub_alloc(struct upipe_mgr *mgr,
     upipe_ts_psi_split_sub_init_output(upipe);
     upipe_ts_psi_split_sub_init_sub(upipe);
     upipe_ts_psi_split_sub_store_flow_def(upipe, flow_def);
+    upipe_ts_psi_split_sub_route(upipe);
 
     upipe_throw_ready(upipe);
     return upipe;
@@ -166,6 +223,10 @@ static void upipe_ts_psi_split_sub_free(struct upipe *upipe)
 {
     upipe_throw_dead(upipe);
 
+    struct upipe_ts_psi_split_sub *sub =
+        upipe_ts_psi_split_sub_from_upipe(upipe);
+    if (sub->filter != NULL)
+        ulist_delete(upipe_ts_psi_split_sub_to_uchain_route(sub));
     upipe_ts_psi_split_sub_clean_output(upipe);
     upipe_ts_psi_split_sub_clean_sub(upipe);
     upipe_ts_psi_split_sub_clean_urefcount(upipe);
@@ -213,10 +274,39 @@ static struct upipe *upipe_ts_psi_split_alloc(struct upipe_mgr *mgr,
                    upipe_ts_psi_split_free);
     upipe_ts_psi_split_init_sub_mgr(upipe);
     upipe_ts_psi_split_init_sub_subs(upipe);
+    for (int i = 0; i < EXTENSION_BUCKETS; i++)
+        ulist_init(&upipe_ts_psi_split->extensions[i]);
+    for (int i = 0; i < 256; i++)
+        ulist_init(&upipe_ts_psi_split->tables[i]);
+    ulist_init(&upipe_ts_psi_split->others);
     upipe_throw_ready(upipe);
     return upipe;
 }
 
+/** @internal @This checks whether a section matches the filter of an output.
+ *
+ * @param sub private context of the output subpipe
+ * @param uref uref structure
+ * @param header beginning of the section
+ * @param header_size size of header
+ * @return true if the section matches
+ */
+static bool upipe_ts_psi_split_sub_match(struct upipe_ts_psi_split_sub *sub,
+                                         struct uref *uref,
+                                         const uint8_t *header,
+                                         size_t header_size)
+{
+    if (unlikely(sub->filter_size > PSI_HEADER_SIZE_SYNTAX1))
+        return ubase_check(uref_block_match(uref, sub->filter, sub->mask,
+                                            sub->filter_size));
+    if (sub->filter_size > header_size)
+        return false;
+    for (size_t i = 0; i < sub->filter_size; i++)
+        if ((header[i] & sub->mask[i]) != sub->filter[i])
+            return false;
+    return true;
+}
+
 /** @internal @This demuxes a PSI section to the appropriate output(s).
  *
  * @param upipe description structure of the pipe
@@ -228,35 +318,62 @@ static void upipe_ts_psi_split_input(struct upipe *upipe, struct uref *uref,
 {
     struct upipe_ts_psi_split *upipe_ts_psi_split =
         upipe_ts_psi_split_from_upipe(upipe);
-    struct uchain *uchain;
-    ulist_foreach (&upipe_ts_psi_split->subs, uchain) {
-        struct upipe_ts_psi_split_sub *output =
-                upipe_ts_psi_split_sub_from_uchain(uchain);
-        const uint8_t *filter, *mask;
-        size_t size;
-        if (ubase_check(uref_ts_flow_get_psi_filter(output->flow_def, &filter,
-                        &mask, &size)) &&
-            ubase_check(uref_block_match(uref, filter, mask, size))) {
-            if (likely(uchain->next == NULL)) {
-                upipe_ts_psi_split_sub_output(
-                        upipe_ts_psi_split_sub_to_upipe(output), uref,
-                        upump_p);
-                uref = NULL;
-            } else {
+
+    /* the filters are matched against a copy of the header */
+    uint8_t header[PSI_HEADER_SIZE_SYNTAX1];
+    size_t header_size;
+    if (unlikely(!ubase_check(uref_block_size(uref, &header_size)))) {
+        uref_free(uref);
+        return;
+    }
+    if (header_size > PSI_HEADER_SIZE_SYNTAX1)
+        header_size = PSI_HEADER_SIZE_SYNTAX1;
+    if (unlikely(!header_size ||
+                 !ubase_check(uref_block_extract(uref, 0, header_size,
+                                                 header)))) {
+        uref_free(uref);
+        return;
+    }
+
+    struct uchain *lists[3];
+    unsigned int nb_lists = 0;
+    if (header_size >= PSI_HEADER_SIZE + 2)
+        lists[nb_lists++] = &upipe_ts_psi_split->extensions[
+            EXTENSION_BUCKET(header[0], (header[PSI_HEADER_SIZE] << 8) |
+                                        header[PSI_HEADER_SIZE + 1])];
+    lists[nb_lists++] = &upipe_ts_psi_split->tables[header[0]];
+    lists[nb_lists++] = &upipe_ts_psi_split->others;
+
+    /* the last matching output gets the uref without duplicating it */
+    struct upipe_ts_psi_split_sub *matched = NULL;
+    for (unsigned int i = 0; i < nb_lists; i++) {
+        struct uchain *uchain;
+        ulist_foreach (lists[i], uchain) {
+            struct upipe_ts_psi_split_sub *output =
+                upipe_ts_psi_split_sub_from_uchain_route(uchain);
+            if (!upipe_ts_psi_split_sub_match(output, uref, header,
+                                              header_size))
+                continue;
+
+            if (matched != NULL) {
                 struct uref *new_uref = uref_dup(uref);
-                if (likely(new_uref != NULL))
-                    upipe_ts_psi_split_sub_output(
-                            upipe_ts_psi_split_sub_to_upipe(output), new_uref,
-                            upump_p);
-                else {
+                if (unlikely(new_uref == NULL)) {
                     uref_free(uref);
                     upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
                     return;
                 }
+                upipe_ts_psi_split_sub_output(
+                        upipe_ts_psi_split_sub_to_upipe(matched), new_uref,
+                        upump_p);
             }
+            matched = output;
         }
     }
-    if (uref != NULL)
+
+    if (matched != NULL)
+        upipe_ts_psi_split_sub_output(
+                upipe_ts_psi_split_sub_to_upipe(matched), uref, upump_p);
+    else
         uref_free(uref);
 }
 
@@ -0,0 +1,397 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module rewriting the PIDs of a transport stream
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_flow.h>
+#include <upipe/ubuf.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe-ts/uref_ts_burst.h>
+#include <upipe-ts/upipe_ts_remux.h>
+
+#include "upipe_ts_crc.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#include <bitstream/mpeg/ts.h>
+#include <bitstream/mpeg/psi.h>
+
+/** we accept blocks containing exactly one TS packet */
+#define EXPECTED_FLOW_DEF "block.mpegts."
+/** or bursts of TS packets */
+#define EXPECTED_BURST_FLOW_DEF UREF_TS_BURST_FLOW_DEF
+/** maximum number of PIDs */
+#define MAX_PIDS 8192
+/** null PID */
+#define NULL_PID 8191
+
+/** @internal @This is the private context of a ts remux pipe. */
+struct upipe_ts_remux {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** flow definition packet on this output */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** true if the input is made of TS bursts */
+    bool burst;
+    /** output PID of each input PID */
+    uint16_t pids[MAX_PIDS];
+    /** PMT PIDs announced by the PAT */
+    uint8_t pmt_pids[MAX_PIDS / 8];
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_ts_remux, upipe, UPIPE_TS_REMUX_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_ts_remux, urefcount, upipe_ts_remux_free)
+UPIPE_HELPER_VOID(upipe_ts_remux)
+UPIPE_HELPER_OUTPUT(upipe_ts_remux, output, flow_def, output_state,
+                    request_list)
+
+/** @internal @This allocates a ts_remux pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_ts_remux_alloc(struct upipe_mgr *mgr,
+                                          struct uprobe *uprobe,
+                                          uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_ts_remux_alloc_void(mgr, uprobe, signature,
+                                                    args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_ts_remux *upipe_ts_remux = upipe_ts_remux_from_upipe(upipe);
+    upipe_ts_remux_init_urefcount(upipe);
+    upipe_ts_remux_init_output(upipe);
+    upipe_ts_remux->burst = false;
+    for (unsigned int i = 0; i < MAX_PIDS; i++)
+        upipe_ts_remux->pids[i] = i;
+    memset(upipe_ts_remux->pmt_pids, 0, sizeof(upipe_ts_remux->pmt_pids));
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This removes an entry from a PSI section, and pads the end of
+ * the packet. The CRC must be computed afterwards.
+ *
+ * @param section pointer to the PSI section
+ * @param entry pointer to the entry to remove
+ * @param size size of the entry
+ */
+static void upipe_ts_remux_remove(uint8_t *section, uint8_t *entry,
+                                  size_t size)
+{
+    uint16_t length = psi_get_length(section);
+    uint8_t *end = section + PSI_HEADER_SIZE + length;
+    memmove(entry, entry + size, end - entry - size);
+    memset(end - size, 0xff, size);
+    psi_set_length(section, length - size);
+}
+
+/** @internal @This rewrites the PIDs in a PAT or PMT section starting in the
+ * given packet. Programs and elementary streams mapped to the null PID are
+ * removed. Sections spanning several packets are left untouched.
+ *
+ * @param upipe description structure of the pipe
+ * @param ts pointer to the TS packet
+ * @param pid PID of the packet
+ */
+static void upipe_ts_remux_section(struct upipe *upipe, uint8_t *ts,
+                                   uint16_t pid)
+{
+    struct upipe_ts_remux *upipe_ts_remux = upipe_ts_remux_from_upipe(upipe);
+    if (!ts_has_payload(ts))
+        return;
+
+    const uint8_t *end = ts + TS_SIZE;
+    uint8_t *payload = ts_payload(ts);
+    if (payload + 1 + PSI_HEADER_SIZE > end ||
+        payload + 1 + *payload + PSI_HEADER_SIZE > end)
+        return;
+    uint8_t *section = payload + 1 + *payload;
+    if (section + PSI_HEADER_SIZE + psi_get_length(section) > end) {
+        upipe_verbose_va(upipe, "section on PID %"PRIu16" is not rewritten",
+                         pid);
+        return;
+    }
+    if (!psi_validate(section) || !upipe_ts_psi_check_crc(section))
+        return;
+
+    bool changed = false;
+    if (pid == PAT_PID) {
+        if (!pat_validate(section))
+            return;
+        uint8_t *program;
+        uint8_t j = 0;
+        while ((program = pat_get_program(section, j)) != NULL) {
+            uint16_t pmt_pid = patn_get_pid(program);
+            if (patn_get_program(program))
+                upipe_ts_remux->pmt_pids[pmt_pid / 8] |= 1 << (pmt_pid & 0x7);
+            uint16_t out_pid = upipe_ts_remux->pids[pmt_pid];
+            changed = changed || out_pid != pmt_pid;
+            if (out_pid == NULL_PID) {
+                upipe_ts_remux_remove(section, program, PAT_PROGRAM_SIZE);
+                continue;
+            }
+            patn_set_pid(program, out_pid);
+            j++;
+        }
+    } else {
+        if (psi_get_tableid(section) != PMT_TABLE_ID ||
+            !pmt_validate(section))
+            return;
+        uint16_t pcr_pid = pmt_get_pcrpid(section);
+        if (upipe_ts_remux->pids[pcr_pid] != pcr_pid) {
+            pmt_set_pcrpid(section, upipe_ts_remux->pids[pcr_pid]);
+            changed = true;
+        }
+        uint8_t *es;
+        uint8_t j = 0;
+        while ((es = pmt_get_es(section, j)) != NULL) {
+            uint16_t es_pid = pmtn_get_pid(es);
+            uint16_t out_pid = upipe_ts_remux->pids[es_pid];
+            changed = changed || out_pid != es_pid;
+            if (out_pid == NULL_PID) {
+                upipe_ts_remux_remove(section, es,
+                                      PMT_ES_SIZE + pmtn_get_desclength(es));
+                continue;
+            }
+            pmtn_set_pid(es, out_pid);
+            j++;
+        }
+    }
+
+    if (changed)
+        upipe_ts_psi_set_crc(section);
+}
+
+/** @internal @This rewrites a TS packet in place.
+ *
+ * @param upipe description structure of the pipe
+ * @param ts pointer to the TS packet
+ * @return the output PID of the packet
+ */
+static uint16_t upipe_ts_remux_packet(struct upipe *upipe, uint8_t *ts)
+{
+    struct upipe_ts_remux *upipe_ts_remux = upipe_ts_remux_from_upipe(upipe);
+    uint16_t pid = ts_get_pid(ts);
+    if (ts_get_unitstart(ts) &&
+        (pid == PAT_PID ||
+         upipe_ts_remux->pmt_pids[pid / 8] & (1 << (pid & 0x7))))
+        upipe_ts_remux_section(upipe, ts, pid);
+
+    uint16_t out_pid = upipe_ts_remux->pids[pid];
+    if (out_pid != pid)
+        ts_set_pid(ts, out_pid);
+    return out_pid;
+}
+
+/** @internal @This rewrites the packets of a TS packet or burst, and
+ * outputs it.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_remux_input(struct upipe *upipe, struct uref *uref,
+                                 struct upump **upump_p)
+{
+    struct upipe_ts_remux *upipe_ts_remux = upipe_ts_remux_from_upipe(upipe);
+    size_t size;
+    if (unlikely(!ubase_check(uref_block_size(uref, &size)))) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    if (unlikely(size % TS_SIZE))
+        upipe_warn_va(upipe, "block of %zu octets is not aligned", size);
+
+    bool merged = false;
+    bool dropped = false;
+    size_t offset = 0;
+    while (offset + TS_SIZE <= size) {
+        int len = -1;
+        uint8_t *buffer;
+        bool mapped = ubase_check(uref_block_write(uref, offset, &len,
+                                                   &buffer));
+        if (unlikely(!mapped || len < TS_SIZE)) {
+            if (mapped)
+                uref_block_unmap(uref, offset);
+            /* the buffer is shared or a packet is segmented */
+            if (merged ||
+                !ubase_check(uref_block_merge(uref, uref->ubuf->mgr, 0, -1))) {
+                uref_free(uref);
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                return;
+            }
+            merged = true;
+            continue;
+        }
+
+        int done;
+        for (done = 0; done + TS_SIZE <= len; done += TS_SIZE) {
+            uint16_t pid = ts_get_pid(buffer + done);
+            if (upipe_ts_remux_packet(upipe, buffer + done) == NULL_PID &&
+                pid != NULL_PID)
+                dropped = true;
+        }
+        uref_block_unmap(uref, offset);
+        offset += done;
+    }
+
+    /* packets of removed PIDs are kept as null packets in bursts */
+    if (dropped && !upipe_ts_remux->burst) {
+        uref_free(uref);
+        return;
+    }
+    upipe_ts_remux_output(upipe, uref, upump_p);
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_ts_remux_set_flow_def(struct upipe *upipe,
+                                       struct uref *flow_def)
+{
+    struct upipe_ts_remux *upipe_ts_remux = upipe_ts_remux_from_upipe(upipe);
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    bool burst = ubase_check(uref_flow_match_def(flow_def,
+                                                 EXPECTED_BURST_FLOW_DEF));
+    if (!burst)
+        UBASE_RETURN(uref_flow_match_def(flow_def, EXPECTED_FLOW_DEF))
+    flow_def = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def);
+    upipe_ts_remux->burst = burst;
+    memset(upipe_ts_remux->pmt_pids, 0, sizeof(upipe_ts_remux->pmt_pids));
+    upipe_ts_remux_store_flow_def(upipe, flow_def);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_ts_remux_control(struct upipe *upipe,
+                                  int command, va_list args)
+{
+    struct upipe_ts_remux *upipe_ts_remux = upipe_ts_remux_from_upipe(upipe);
+
+    UBASE_HANDLED_RETURN(upipe_ts_remux_control_output(upipe, command, args));
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_ts_remux_set_flow_def(upipe, flow_def);
+        }
+
+        case UPIPE_TS_REMUX_SET_PID: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_REMUX_SIGNATURE)
+            unsigned int pid = va_arg(args, unsigned int);
+            unsigned int out_pid = va_arg(args, unsigned int);
+            if (pid >= MAX_PIDS || out_pid >= MAX_PIDS)
+                return UBASE_ERR_INVALID;
+            upipe_ts_remux->pids[pid] = out_pid;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_TS_REMUX_DEL_PID: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_REMUX_SIGNATURE)
+            unsigned int pid = va_arg(args, unsigned int);
+            if (pid >= MAX_PIDS)
+                return UBASE_ERR_INVALID;
+            upipe_ts_remux->pids[pid] = pid;
+            return UBASE_ERR_NONE;
+        }
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_remux_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+
+    upipe_ts_remux_clean_output(upipe);
+    upipe_ts_remux_clean_urefcount(upipe);
+    upipe_ts_remux_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_ts_remux_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_TS_REMUX_SIGNATURE,
+
+    .upipe_alloc = upipe_ts_remux_alloc,
+    .upipe_input = upipe_ts_remux_input,
+    .upipe_control = upipe_ts_remux_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all ts_remux pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_ts_remux_mgr_alloc(void)
+{
+    return &upipe_ts_remux_mgr;
+}
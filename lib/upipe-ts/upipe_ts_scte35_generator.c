@@ -28,6 +28,7 @@
 #include <upipe/ubase.h>
 #include <upipe/ulist.h>
 #include <upipe/uclock.h>
+#include <upipe/uheap.h>
 #include <upipe/uprobe.h>
 #include <upipe/uref.h>
 #include <upipe/uref_block.h>
@@ -46,6 +47,7 @@
 #include <upipe-ts/upipe_ts_scte35_generator.h>
 #include <upipe-ts/upipe_ts_mux.h>
 #include <upipe-ts/uref_ts_scte35.h>
+#include "upipe_ts_crc.h"
 
 #include <stdlib.h>
 #include <stdbool.h>
@@ -96,17 +98,30 @@ struct upipe_ts_scte35g {
     uint64_t scte35_cr_sys;
     /** SCTE-35 null command section */
     struct ubuf *scte35_null_section;
-    /** SCTE-35 insert command section */
-    struct ubuf *scte35_insert_section;
+    /** scheduled splices, by splice time */
+    struct uheap splices;
     /** SCTE-35 immediate insert command section */
     struct ubuf *scte35_immediate_section;
-    /** SCTE-35 insert cr_sys */
-    uint64_t scte35_insert_cr_sys;
 
     /** public upipe structure */
     struct upipe upipe;
 };
 
+/** @internal @This describes a scheduled splice. */
+struct upipe_ts_scte35g_splice {
+    /** node in the schedule, keyed on the splice time */
+    struct uheap_node node;
+    /** event ID */
+    uint64_t event_id;
+    /** SCTE-35 insert command section */
+    struct ubuf *section;
+    /** SCTE-35 immediate insert command section, until the insert command
+     * is sent */
+    struct ubuf *immediate;
+};
+
+UBASE_FROM_TO(upipe_ts_scte35g_splice, uheap_node, node, node)
+
 UPIPE_HELPER_UPIPE(upipe_ts_scte35g, upipe, UPIPE_TS_SCTE35G_SIGNATURE)
 UPIPE_HELPER_UREFCOUNT(upipe_ts_scte35g, urefcount, upipe_ts_scte35g_free)
 UPIPE_HELPER_VOID(upipe_ts_scte35g)
@@ -147,9 +162,8 @@ static struct upipe *upipe_ts_scte35g_alloc(struct upipe_mgr *mgr,
     upipe_ts_scte35g->scte35_interval = 0;
     upipe_ts_scte35g->scte35_cr_sys = 0;
     upipe_ts_scte35g->scte35_null_section = NULL;
-    upipe_ts_scte35g->scte35_insert_section = NULL;
+    uheap_init(&upipe_ts_scte35g->splices);
     upipe_ts_scte35g->scte35_immediate_section = NULL;
-    upipe_ts_scte35g->scte35_insert_cr_sys = 0;
 
     upipe_throw_ready(upipe);
     upipe_ts_scte35g_demand_uref_mgr(upipe);
@@ -161,6 +175,43 @@ static struct upipe *upipe_ts_scte35g_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
+/** @internal @This frees a scheduled splice.
+ *
+ * @param upipe description structure of the pipe
+ * @param splice description structure of the splice
+ */
+static void upipe_ts_scte35g_splice_free(struct upipe *upipe,
+                                         struct upipe_ts_scte35g_splice *splice)
+{
+    struct upipe_ts_scte35g *scte35g = upipe_ts_scte35g_from_upipe(upipe);
+    if (uheap_node_is_in(&splice->node))
+        uheap_delete(&scte35g->splices, &splice->node);
+    ubuf_free(splice->section);
+    ubuf_free(splice->immediate);
+    free(splice);
+}
+
+/** @internal @This finds a scheduled splice by event ID.
+ *
+ * @param upipe description structure of the pipe
+ * @param event_id event ID
+ * @return pointer to the splice, or NULL
+ */
+static struct upipe_ts_scte35g_splice *
+    upipe_ts_scte35g_splice_find(struct upipe *upipe, uint64_t event_id)
+{
+    struct upipe_ts_scte35g *scte35g = upipe_ts_scte35g_from_upipe(upipe);
+    struct uheap_node *node;
+    for (unsigned int i = 0; (node = uheap_at(&scte35g->splices, i)) != NULL;
+         i++) {
+        struct upipe_ts_scte35g_splice *splice =
+            upipe_ts_scte35g_splice_from_node(node);
+        if (splice->event_id == event_id)
+            return splice;
+    }
+    return NULL;
+}
+
 /** @internal @This creates a new PSI section.
  *
  * @param upipe description structure of the pipe
@@ -175,8 +226,10 @@ static void upipe_ts_scte35g_input(struct upipe *upipe, struct uref *uref,
     if (uref == NULL || uref->udict == NULL) {
         upipe_notice(upipe, "now using splice_null command due to empty event");
         uref_free(uref);
-        ubuf_free(scte35g->scte35_insert_section);
-        scte35g->scte35_insert_section = NULL;
+        struct uheap_node *node;
+        while ((node = uheap_peek(&scte35g->splices)) != NULL)
+            upipe_ts_scte35g_splice_free(upipe,
+                    upipe_ts_scte35g_splice_from_node(node));
         return;
     }
 
@@ -184,8 +237,8 @@ static void upipe_ts_scte35g_input(struct upipe *upipe, struct uref *uref,
     uref_clock_get_pts_prog(uref, &pts_prog);
     uint64_t duration = UINT64_MAX;
     uref_clock_get_duration(uref, &duration);
-    scte35g->scte35_insert_cr_sys = 0;
-    uref_clock_get_pts_sys(uref, &scte35g->scte35_insert_cr_sys);
+    uint64_t pts_sys = 0;
+    uref_clock_get_pts_sys(uref, &pts_sys);
     uint64_t event_id = 0;
     uref_ts_scte35_get_event_id(uref, &event_id);
     bool cancel = ubase_check(uref_ts_scte35_get_cancel(uref));
@@ -195,10 +248,18 @@ static void upipe_ts_scte35g_input(struct upipe *upipe, struct uref *uref,
     uref_ts_scte35_get_unique_program_id(uref, &program_id);
     uref_free(uref);
 
+    /* a new command for an event replaces the scheduled one */
+    struct upipe_ts_scte35g_splice *splice =
+        upipe_ts_scte35g_splice_find(upipe, event_id);
+    if (splice != NULL)
+        upipe_ts_scte35g_splice_free(upipe, splice);
+
+    struct ubuf *insert = NULL;
     for ( ; ; ) {
         struct ubuf *ubuf = ubuf_block_alloc(scte35g->ubuf_mgr,
                                              PSI_MAX_SIZE + PSI_HEADER_SIZE);
         if (unlikely(ubuf == NULL)) {
+            ubuf_free(insert);
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             return;
         }
@@ -207,6 +268,7 @@ static void upipe_ts_scte35g_input(struct upipe *upipe, struct uref *uref,
         int size = -1;
         if (!ubase_check(ubuf_block_write(ubuf, 0, &size, &scte35))) {
             ubuf_free(ubuf);
+            ubuf_free(insert);
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             return;
         }
@@ -257,28 +319,49 @@ static void upipe_ts_scte35g_input(struct upipe *upipe, struct uref *uref,
         scte35_set_desclength(scte35, 0);
         psi_set_length(scte35,
                 scte35_get_descl(scte35) + PSI_CRC_SIZE - scte35 - PSI_HEADER_SIZE);
-        psi_set_crc(scte35);
+        upipe_ts_psi_set_crc(scte35);
 
         uint16_t scte35_size = psi_get_length(scte35) + PSI_HEADER_SIZE;
         ubuf_block_unmap(ubuf, 0);
         ubuf_block_resize(ubuf, 0, scte35_size);
 
         if (pts_prog == UINT64_MAX) {
-            ubuf_free(scte35g->scte35_immediate_section);
-            scte35g->scte35_immediate_section = ubuf;
+            if (insert == NULL) {
+                ubuf_free(scte35g->scte35_immediate_section);
+                scte35g->scte35_immediate_section = ubuf;
+                break;
+            }
+
+            splice = malloc(sizeof(struct upipe_ts_scte35g_splice));
+            if (unlikely(splice == NULL)) {
+                ubuf_free(insert);
+                ubuf_free(ubuf);
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                return;
+            }
+            uheap_node_init(&splice->node);
+            splice->event_id = event_id;
+            splice->section = insert;
+            splice->immediate = ubuf;
+            if (unlikely(!ubase_check(uheap_push(&scte35g->splices,
+                                                 &splice->node, pts_sys)))) {
+                upipe_ts_scte35g_splice_free(upipe, splice);
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                return;
+            }
             break;
         }
 
-        ubuf_free(scte35g->scte35_insert_section);
-        scte35g->scte35_insert_section = ubuf;
+        insert = ubuf;
         pts_prog = UINT64_MAX;
     }
 
     /* Force sending the table immediately */
     scte35g->scte35_cr_sys = 0;
     upipe_notice_va(upipe,
-                    "now using splice_insert command for event %"PRIu64,
-                    event_id);
+                    "now using splice_insert command for event %"PRIu64
+                    " (%u scheduled)", event_id,
+                    uheap_size(&scte35g->splices));
 }
 
 /** @internal @This builds a null command SCTE-35 section.
@@ -314,7 +397,7 @@ static void upipe_ts_scte35g_build_null(struct upipe *upipe)
     scte35_set_desclength(scte35, 0);
     psi_set_length(scte35,
             scte35_get_descl(scte35) + PSI_CRC_SIZE - scte35 - PSI_HEADER_SIZE);
-    psi_set_crc(scte35);
+    upipe_ts_psi_set_crc(scte35);
 
     uint16_t scte35_size = psi_get_length(scte35) + PSI_HEADER_SIZE;
     ubuf_block_unmap(ubuf, 0);
@@ -458,21 +541,30 @@ static int upipe_ts_scte35g_prepare(struct upipe *upipe, uint64_t cr_sys,
                  scte35g->scte35_cr_sys + scte35g->scte35_interval > cr_sys))
         return UBASE_ERR_NONE;
 
-    if (scte35g->scte35_insert_section != NULL) {
-        if (scte35g->scte35_insert_cr_sys < cr_sys) {
-            upipe_notice(upipe, "event expired");
-            ubuf_free(scte35g->scte35_insert_section);
-            scte35g->scte35_insert_section = NULL;
-
-        } else {
-            upipe_dbg(upipe, "sending a splice insert event");
-            upipe_ts_scte35g_send(upipe, scte35g->scte35_insert_section,
-                                  cr_sys);
-            /* From now on we no longer need a splice immediate section */
+    struct uheap_node *node;
+    while ((node = uheap_peek(&scte35g->splices)) != NULL &&
+           node->key < cr_sys) {
+        struct upipe_ts_scte35g_splice *splice =
+            upipe_ts_scte35g_splice_from_node(node);
+        upipe_notice_va(upipe, "event %"PRIu64" expired", splice->event_id);
+        /* the insert command was never sent, splice immediately */
+        if (splice->immediate != NULL) {
             ubuf_free(scte35g->scte35_immediate_section);
-            scte35g->scte35_immediate_section = NULL;
-            return UBASE_ERR_NONE;
+            scte35g->scte35_immediate_section = splice->immediate;
+            splice->immediate = NULL;
         }
+        upipe_ts_scte35g_splice_free(upipe, splice);
+    }
+
+    if (scte35g->scte35_immediate_section == NULL && node != NULL) {
+        struct upipe_ts_scte35g_splice *splice =
+            upipe_ts_scte35g_splice_from_node(node);
+        upipe_dbg(upipe, "sending a splice insert event");
+        upipe_ts_scte35g_send(upipe, splice->section, cr_sys);
+        /* From now on we no longer need a splice immediate section */
+        ubuf_free(splice->immediate);
+        splice->immediate = NULL;
+        return UBASE_ERR_NONE;
     }
 
     if (scte35g->scte35_immediate_section != NULL) {
@@ -536,7 +628,11 @@ static void upipe_ts_scte35g_free(struct upipe *upipe)
 
     uref_free(scte35g->flow_def);
     ubuf_free(scte35g->scte35_null_section);
-    ubuf_free(scte35g->scte35_insert_section);
+    struct uheap_node *node;
+    while ((node = uheap_peek(&scte35g->splices)) != NULL)
+        upipe_ts_scte35g_splice_free(upipe,
+                upipe_ts_scte35g_splice_from_node(node));
+    uheap_clean(&scte35g->splices);
     ubuf_free(scte35g->scte35_immediate_section);
     upipe_ts_scte35g_clean_output(upipe);
     upipe_ts_scte35g_clean_ubuf_mgr(upipe);
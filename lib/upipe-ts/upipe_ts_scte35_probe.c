@@ -26,6 +26,7 @@
 
 #include <upipe/ubase.h>
 #include <upipe/ulist.h>
+#include <upipe/uheap.h>
 #include <upipe/uclock.h>
 #include <upipe/uprobe.h>
 #include <upipe/uref.h>
@@ -36,6 +37,7 @@
 #include <upipe/upipe_helper_urefcount.h>
 #include <upipe/upipe_helper_void.h>
 #include <upipe/upipe_helper_upump_mgr.h>
+#include <upipe/upipe_helper_upump.h>
 #include <upipe/upipe_helper_uclock.h>
 #include <upipe-ts/upipe_ts_scte35_probe.h>
 #include <upipe-ts/uref_ts_flow.h>
@@ -49,6 +51,8 @@
 
 /** we only accept SCTE 35 metadata */
 #define EXPECTED_FLOW_DEF "void.scte35."
+/** number of buckets of the event ID hash table */
+#define EVENT_BUCKETS 64
 
 /** @internal @This is the private context of a ts_scte35p pipe. */
 struct upipe_ts_scte35p {
@@ -57,14 +61,20 @@ struct upipe_ts_scte35p {
 
     /** upump manager */
     struct upump_mgr *upump_mgr;
+    /** timer of the next event */
+    struct upump *upump;
+    /** date the timer is armed for */
+    uint64_t upump_date;
 
     /** uclock structure */
     struct uclock *uclock;
     /** uclock request */
     struct urequest uclock_request;
 
-    /** list of events */
-    struct uchain events;
+    /** lists of events, hashed by event ID */
+    struct uchain events[EVENT_BUCKETS];
+    /** pending events, by date */
+    struct uheap timeline;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -74,25 +84,24 @@ UPIPE_HELPER_UPIPE(upipe_ts_scte35p, upipe, UPIPE_TS_SCTE35P_SIGNATURE)
 UPIPE_HELPER_UREFCOUNT(upipe_ts_scte35p, urefcount, upipe_ts_scte35p_free)
 UPIPE_HELPER_VOID(upipe_ts_scte35p)
 UPIPE_HELPER_UPUMP_MGR(upipe_ts_scte35p, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_ts_scte35p, upump, upump_mgr)
 UPIPE_HELPER_UCLOCK(upipe_ts_scte35p, uclock, uclock_request, NULL, upipe_throw_provide_request, NULL)
 
 /** @internal @This describes an SCTE-35 event. */
 struct upipe_ts_scte35p_event {
     /** structure for double-linked lists */
     struct uchain uchain;
+    /** node in the timeline, keyed on the date of the event */
+    struct uheap_node node;
 
     /** event ID */
     uint64_t event_id;
     /** uref describing the event */
     struct uref *uref;
-    /** upump which will trigger the event */
-    struct upump *upump;
-
-    /** pointer to public upipe structure */
-    struct upipe *upipe;
 };
 
 UBASE_FROM_TO(upipe_ts_scte35p_event, uchain, uchain, uchain)
+UBASE_FROM_TO(upipe_ts_scte35p_event, uheap_node, node, node)
 
 static void upipe_ts_scte35p_event_trigger(struct upipe *upipe,
         struct upipe_ts_scte35p_event *event, uint64_t skew);
@@ -118,14 +127,32 @@ static struct upipe *upipe_ts_scte35p_alloc(struct upipe_mgr *mgr,
         upipe_ts_scte35p_from_upipe(upipe);
     upipe_ts_scte35p_init_urefcount(upipe);
     upipe_ts_scte35p_init_upump_mgr(upipe);
+    upipe_ts_scte35p_init_upump(upipe);
     upipe_ts_scte35p_init_uclock(upipe);
-    ulist_init(&upipe_ts_scte35p->events);
+    upipe_ts_scte35p->upump_date = UINT64_MAX;
+    for (unsigned int i = 0; i < EVENT_BUCKETS; i++)
+        ulist_init(&upipe_ts_scte35p->events[i]);
+    uheap_init(&upipe_ts_scte35p->timeline);
     upipe_throw_ready(upipe);
     upipe_ts_scte35p_check_upump_mgr(upipe);
     upipe_ts_scte35p_require_uclock(upipe);
     return upipe;
 }
 
+/** @internal @This removes an SCTE35 event from the timeline.
+ *
+ * @param upipe description structure of the pipe
+ * @param event description structure of the event
+ */
+static void upipe_ts_scte35p_event_unschedule(struct upipe *upipe,
+        struct upipe_ts_scte35p_event *event)
+{
+    struct upipe_ts_scte35p *upipe_ts_scte35p =
+        upipe_ts_scte35p_from_upipe(upipe);
+    if (uheap_node_is_in(&event->node))
+        uheap_delete(&upipe_ts_scte35p->timeline, &event->node);
+}
+
 /** @internal @This finds or allocates an SCTE35 event.
  *
  * @param upipe description structure of the pipe
@@ -139,18 +166,16 @@ static struct upipe_ts_scte35p_event *
 {
     struct upipe_ts_scte35p *upipe_ts_scte35p =
         upipe_ts_scte35p_from_upipe(upipe);
+    struct uchain *bucket =
+        &upipe_ts_scte35p->events[event_id % EVENT_BUCKETS];
     struct uchain *uchain;
-    ulist_foreach (&upipe_ts_scte35p->events, uchain) {
+    ulist_foreach (bucket, uchain) {
         struct upipe_ts_scte35p_event *event =
             upipe_ts_scte35p_event_from_uchain(uchain);
         if (event->event_id == event_id) {
             uref_free(event->uref);
             event->uref = uref;
-            if (event->upump != NULL) {
-                upump_stop(event->upump);
-                upump_free(event->upump);
-                event->upump = NULL;
-            }
+            upipe_ts_scte35p_event_unschedule(upipe, event);
             return event;
         }
     }
@@ -161,12 +186,10 @@ static struct upipe_ts_scte35p_event *
         return NULL;
 
     uchain_init(&event->uchain);
+    uheap_node_init(&event->node);
     event->event_id = event_id;
     event->uref = uref;
-    event->upump = NULL;
-    event->upipe = upipe;
-    ulist_add(&upipe_ts_scte35p->events,
-              upipe_ts_scte35p_event_to_uchain(event));
+    ulist_add(bucket, upipe_ts_scte35p_event_to_uchain(event));
     return event;
 }
 
@@ -179,54 +202,101 @@ static void upipe_ts_scte35p_event_free(struct upipe *upipe,
         struct upipe_ts_scte35p_event *event)
 {
     uref_free(event->uref);
-    if (event->upump != NULL) {
-        upump_stop(event->upump);
-        upump_free(event->upump);
-    }
+    upipe_ts_scte35p_event_unschedule(upipe, event);
     ulist_delete(upipe_ts_scte35p_event_to_uchain(event));
     free(event);
 }
 
-/** @internal @This is called when an SCTE35 event triggers.
+/** @hidden */
+static void upipe_ts_scte35p_watcher(struct upump *upump);
+
+/** @internal @This arms the timer for the first event of the timeline.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_scte35p_arm(struct upipe *upipe)
+{
+    struct upipe_ts_scte35p *upipe_ts_scte35p =
+        upipe_ts_scte35p_from_upipe(upipe);
+    struct uheap_node *node = uheap_peek(&upipe_ts_scte35p->timeline);
+    upipe_ts_scte35p_check_upump_mgr(upipe);
+    if (node == NULL || upipe_ts_scte35p->upump_mgr == NULL ||
+        upipe_ts_scte35p->uclock == NULL) {
+        upipe_ts_scte35p_set_upump(upipe, NULL);
+        upipe_ts_scte35p->upump_date = UINT64_MAX;
+        return;
+    }
+    if (upipe_ts_scte35p->upump != NULL &&
+        upipe_ts_scte35p->upump_date == node->key)
+        return;
+
+    uint64_t now = uclock_now(upipe_ts_scte35p->uclock);
+    upipe_ts_scte35p->upump_date = node->key;
+    upipe_ts_scte35p_wait_upump(upipe, node->key > now ? node->key - now : 0,
+                                upipe_ts_scte35p_watcher);
+}
+
+/** @internal @This is called when the first event of the timeline is due,
+ * and triggers all the events which are due.
  *
  * @param upump description structure of the watcher
  */
-static void upipe_ts_scte35p_event_watcher(struct upump *upump)
+static void upipe_ts_scte35p_watcher(struct upump *upump)
 {
-    struct upipe_ts_scte35p_event *event =
-        upump_get_opaque(upump, struct upipe_ts_scte35p_event *);
-    struct upipe *upipe = event->upipe;
-    upump_stop(upump);
-    upump_free(upump);
-    event->upump = NULL;
-    upipe_ts_scte35p_event_trigger(upipe, event, 0);
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_ts_scte35p *upipe_ts_scte35p =
+        upipe_ts_scte35p_from_upipe(upipe);
+    /* the timer may expire slightly before the uclock reaches the date */
+    uint64_t now = uclock_now(upipe_ts_scte35p->uclock);
+    uint64_t date = upipe_ts_scte35p->upump_date;
+    if (date < now)
+        date = now;
+    upipe_ts_scte35p_set_upump(upipe, NULL);
+    upipe_ts_scte35p->upump_date = UINT64_MAX;
+
+    struct uheap_node *node;
+    while ((node = uheap_peek(&upipe_ts_scte35p->timeline)) != NULL &&
+           node->key <= date) {
+        uheap_delete(&upipe_ts_scte35p->timeline, node);
+        upipe_ts_scte35p_event_trigger(upipe,
+                upipe_ts_scte35p_event_from_node(node),
+                now > node->key ? now - node->key : 0);
+    }
+    upipe_ts_scte35p_arm(upipe);
 }
 
-/** @internal @This waits for an SCTE35 event.
+/** @internal @This puts an SCTE35 event in the timeline.
  *
  * @param upipe description structure of the pipe
  * @param event description structure of the event
- * @param timeout time after which the event triggers
+ * @param date date of the event
  */
-static void upipe_ts_scte35p_event_wait(struct upipe *upipe,
-        struct upipe_ts_scte35p_event *event, uint64_t timeout)
+static void upipe_ts_scte35p_event_schedule(struct upipe *upipe,
+        struct upipe_ts_scte35p_event *event, uint64_t date)
 {
     struct upipe_ts_scte35p *upipe_ts_scte35p =
         upipe_ts_scte35p_from_upipe(upipe);
+    upipe_ts_scte35p_check_upump_mgr(upipe);
+    if (unlikely(upipe_ts_scte35p->upump_mgr == NULL ||
+                 upipe_ts_scte35p->uclock == NULL)) {
+        upipe_warn_va(upipe, "splice %"PRIu64" can't be scheduled",
+                      event->event_id);
+        upipe_ts_scte35p_event_free(upipe, event);
+        return;
+    }
+
+    uint64_t now = uclock_now(upipe_ts_scte35p->uclock);
     upipe_dbg_va(upipe, "splice %"PRIu64" waiting %"PRIu64" ms",
-                 event->event_id, timeout * 1000 / UCLOCK_FREQ);
+                 event->event_id,
+                 date > now ? (date - now) * 1000 / UCLOCK_FREQ : 0);
 
-    struct upump *watcher = upump_alloc_timer(upipe_ts_scte35p->upump_mgr,
-            upipe_ts_scte35p_event_watcher, event, upipe->refcount, timeout, 0);
-    if (unlikely(watcher == NULL)) {
+    if (unlikely(!ubase_check(uheap_push(&upipe_ts_scte35p->timeline,
+                                         &event->node, date)))) {
         upipe_ts_scte35p_event_free(upipe, event);
-        upipe_err(upipe, "can't create watcher");
-        upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return;
     }
-
-    event->upump = watcher;
-    upump_start(watcher);
+    upipe_ts_scte35p_arm(upipe);
 }
 
 /** @internal @This triggers an SCTE35 event and handles its duration.
@@ -255,6 +325,7 @@ static void upipe_ts_scte35p_event_trigger(struct upipe *upipe,
     else
         uref_ts_scte35_set_out_of_network(event->uref);
 
+    event->node.key += duration;
     if (duration <= skew) {
         upipe_warn_va(upipe, "splice return %"PRIu64" in the past (%"PRIu64")",
                       event->event_id, skew - duration);
@@ -262,7 +333,7 @@ static void upipe_ts_scte35p_event_trigger(struct upipe *upipe,
         return;
     }
 
-    upipe_ts_scte35p_event_wait(upipe, event, duration - skew);
+    upipe_ts_scte35p_event_schedule(upipe, event, event->node.key);
 }
 
 /** @internal @This handles an SCTE35 meta.
@@ -292,44 +363,52 @@ static void upipe_ts_scte35p_input(struct upipe *upipe, struct uref *uref,
         return;
     }
 
+    if (unlikely(upipe_ts_scte35p->uclock == NULL))
+        upipe_ts_scte35p_require_uclock(upipe);
+
     if (ubase_check(uref_ts_scte35_get_cancel(uref))) {
         upipe_dbg_va(upipe, "splice %"PRIu64" cancelled", event_id);
         upipe_ts_scte35p_event_free(upipe, event);
+        upipe_ts_scte35p_arm(upipe);
         return;
     }
 
     uint64_t pts;
     if (!ubase_check(uref_clock_get_pts_sys(uref, &pts))) {
         upipe_dbg_va(upipe, "splice %"PRIu64" immediate", event_id);
+        event->node.key = upipe_ts_scte35p->uclock != NULL ?
+                          uclock_now(upipe_ts_scte35p->uclock) : 0;
         upipe_ts_scte35p_event_trigger(upipe, event, 0);
+        upipe_ts_scte35p_arm(upipe);
         return;
     }
 
     upipe_ts_scte35p_check_upump_mgr(upipe);
     if (unlikely(upipe_ts_scte35p->upump_mgr == NULL)) {
-        uref_free(uref);
+        upipe_ts_scte35p_event_free(upipe, event);
+        upipe_ts_scte35p_arm(upipe);
         upipe_warn(upipe, "no upump manager");
         return;
     }
 
     if (unlikely(upipe_ts_scte35p->uclock == NULL)) {
-        upipe_ts_scte35p_require_uclock(upipe);
-        if (unlikely(upipe_ts_scte35p->uclock == NULL)) {
-            upipe_ts_scte35p_event_free(upipe, event);
-            upipe_warn(upipe, "no uclock");
-            return;
-        }
+        upipe_ts_scte35p_event_free(upipe, event);
+        upipe_ts_scte35p_arm(upipe);
+        upipe_warn(upipe, "no uclock");
+        return;
     }
 
     uint64_t now = uclock_now(upipe_ts_scte35p->uclock);
     if (pts <= now) {
         upipe_warn_va(upipe, "splice %"PRIu64" in the past (%"PRIu64")",
                       event_id, now - pts);
+        event->node.key = pts;
         upipe_ts_scte35p_event_trigger(upipe, event, now - pts);
+        upipe_ts_scte35p_arm(upipe);
         return;
     }
 
-    upipe_ts_scte35p_event_wait(upipe, event, pts - now);
+    upipe_ts_scte35p_event_schedule(upipe, event, pts);
 }
 
 /** @internal @This sets the input flow definition.
@@ -362,8 +441,12 @@ static int upipe_ts_scte35p_control(struct upipe *upipe,
         case UPIPE_UNREGISTER_REQUEST:
             return upipe_control_provide_request(upipe, command, args);
 
-        case UPIPE_ATTACH_UPUMP_MGR:
-            return upipe_ts_scte35p_attach_upump_mgr(upipe);
+        case UPIPE_ATTACH_UPUMP_MGR: {
+            upipe_ts_scte35p_set_upump(upipe, NULL);
+            int err = upipe_ts_scte35p_attach_upump_mgr(upipe);
+            upipe_ts_scte35p_arm(upipe);
+            return err;
+        }
         case UPIPE_ATTACH_UCLOCK:
             upipe_ts_scte35p_require_uclock(upipe);
             return UBASE_ERR_NONE;
@@ -387,13 +470,18 @@ static void upipe_ts_scte35p_free(struct upipe *upipe)
 
     struct upipe_ts_scte35p *upipe_ts_scte35p =
         upipe_ts_scte35p_from_upipe(upipe);
-    struct uchain *uchain, *uchain_tmp;
-    ulist_delete_foreach (&upipe_ts_scte35p->events, uchain, uchain_tmp) {
-        struct upipe_ts_scte35p_event *event =
-            upipe_ts_scte35p_event_from_uchain(uchain);
-        upipe_ts_scte35p_event_free(upipe, event);
+    for (unsigned int i = 0; i < EVENT_BUCKETS; i++) {
+        struct uchain *uchain, *uchain_tmp;
+        ulist_delete_foreach (&upipe_ts_scte35p->events[i], uchain,
+                              uchain_tmp) {
+            struct upipe_ts_scte35p_event *event =
+                upipe_ts_scte35p_event_from_uchain(uchain);
+            upipe_ts_scte35p_event_free(upipe, event);
+        }
     }
+    uheap_clean(&upipe_ts_scte35p->timeline);
 
+    upipe_ts_scte35p_clean_upump(upipe);
     upipe_ts_scte35p_clean_upump_mgr(upipe);
     upipe_ts_scte35p_clean_uclock(upipe);
     upipe_ts_scte35p_clean_urefcount(upipe);
@@ -44,6 +44,7 @@
 #include <upipe-ts/upipe_ts_sdt_decoder.h>
 #include <upipe-ts/uref_ts_flow.h>
 #include "upipe_ts_psi_decoder.h"
+#include "upipe_ts_crc.h"
 
 #include <stdlib.h>
 #include <stdbool.h>
@@ -92,6 +93,8 @@ struct upipe_ts_sdtd {
     UPIPE_TS_PSID_TABLE_DECLARE(sdt);
     /** SDT table being gathered */
     UPIPE_TS_PSID_TABLE_DECLARE(next_sdt);
+    /** number of sections dropped because they were unchanged */
+    uint64_t unchanged;
     /** current TSID */
     int tsid;
     /** current original network ID */
@@ -144,6 +147,7 @@ static struct upipe *upipe_ts_sdtd_alloc(struct upipe_mgr *mgr,
     upipe_ts_sdtd_init_iconv(upipe);
     upipe_ts_psid_table_init(upipe_ts_sdtd->sdt);
     upipe_ts_psid_table_init(upipe_ts_sdtd->next_sdt);
+    upipe_ts_sdtd->unchanged = 0;
     upipe_ts_sdtd->tsid = upipe_ts_sdtd->onid = -1;
     ulist_init(&upipe_ts_sdtd->services);
     upipe_throw_ready(upipe);
@@ -220,7 +224,7 @@ static bool upipe_ts_sdtd_table_validate(struct upipe *upipe)
                                                   &section))))
             return false;
 
-        if (!sdt_validate(section) || !psi_check_crc(section)) {
+        if (!sdt_validate(section) || !upipe_ts_psi_check_crc(section)) {
             uref_block_unmap(section_uref, 0);
             return false;
         }
@@ -362,6 +366,12 @@ static void upipe_ts_sdtd_input(struct upipe *upipe, struct uref *uref,
     struct upipe_ts_sdtd *upipe_ts_sdtd = upipe_ts_sdtd_from_upipe(upipe);
     assert(upipe_ts_sdtd->flow_def_input != NULL);
 
+    if (upipe_ts_psid_table_section_unchanged(upipe_ts_sdtd->sdt, uref)) {
+        upipe_ts_sdtd->unchanged++;
+        uref_free(uref);
+        return;
+    }
+
     if (!upipe_ts_psid_table_section(upipe_ts_sdtd->next_sdt, uref))
         return;
 
@@ -520,6 +530,12 @@ static int upipe_ts_sdtd_control(struct upipe *upipe, int command, va_list args)
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_ts_sdtd_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_TS_SDTD_GET_UNCHANGED: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_SDTD_SIGNATURE)
+            uint64_t *unchanged_p = va_arg(args, uint64_t *);
+            *unchanged_p = upipe_ts_sdtd_from_upipe(upipe)->unchanged;
+            return UBASE_ERR_NONE;
+        }
         case UPIPE_SPLIT_ITERATE: {
             struct uref **p = va_arg(args, struct uref **);
             return upipe_ts_sdtd_iterate(upipe, p);
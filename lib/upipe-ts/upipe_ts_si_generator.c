@@ -52,6 +52,7 @@
 #include <upipe-ts/upipe_ts_mux.h>
 #include <upipe-ts/uref_ts_flow.h>
 #include <upipe-ts/uref_ts_event.h>
+#include "upipe_ts_crc.h"
 
 #include <stdlib.h>
 #include <stdbool.h>
@@ -187,6 +188,10 @@ struct upipe_ts_sig {
     uint16_t eits_nb_sections;
     /** next EIT schedule cr_sys */
     uint64_t eits_cr_sys;
+    /** service with the next EITp/f due, or NULL */
+    struct upipe_ts_sig_service *eit_service;
+    /** service whose EIT schedule is being sent, or NULL */
+    struct upipe_ts_sig_service *eits_service;
 
     /** TDT interval */
     uint64_t tdt_interval;
@@ -243,6 +248,21 @@ static void upipe_ts_sig_build_sdt(struct upipe *upipe);
 static void upipe_ts_sig_build_eit_flow_def(struct upipe *upipe);
 /** @hidden */
 static void upipe_ts_sig_update_status(struct upipe *upipe);
+/** @hidden */
+static void upipe_ts_sig_schedule_eit(struct upipe *upipe);
+/** @hidden */
+static void upipe_ts_sig_schedule_eits(struct upipe *upipe);
+
+/** @internal @This describes the events carried by an EIT schedule
+ * section. */
+struct upipe_ts_sig_eits_events {
+    /** EIT schedule section */
+    struct ubuf *ubuf;
+    /** number of the first event */
+    uint64_t first;
+    /** number of the event following the last event */
+    uint64_t end;
+};
 
 /** @internal @This is the private context of a service of a ts_sig pipe
  * (outputs EITp/f). */
@@ -278,8 +298,14 @@ struct upipe_ts_sig_service {
     uint64_t eits_size;
     /** last EIT schedule cr_sys */
     uint64_t eits_cr_sys;
-    /** next EIT schedule section number */
-    uint16_t eits_next_section;
+    /** next EIT schedule section to send, or NULL to start a new cycle */
+    struct uchain *eits_next;
+    /** flow definition the EIT schedule sections were built from */
+    struct uref *eits_flow_def;
+    /** events carried by each EIT schedule section */
+    struct upipe_ts_sig_eits_events *eits_events;
+    /** number of entries in eits_events */
+    unsigned int eits_events_size;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -329,7 +355,10 @@ static struct upipe *upipe_ts_sig_service_alloc(struct upipe_mgr *mgr,
     service->eits_nb_sections = 0;
     service->eits_size = 0;
     service->eits_cr_sys = 0;
-    service->eits_next_section = 0;
+    service->eits_next = NULL;
+    service->eits_flow_def = NULL;
+    service->eits_events = NULL;
+    service->eits_events_size = 0;
 
     upipe_throw_ready(upipe);
     return upipe;
@@ -421,6 +450,199 @@ static int upipe_ts_sig_service_build_eit_event(struct upipe *upipe, uint64_t i,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This checks if two events of two flow definitions are
+ * identical.
+ *
+ * @param uref1 first flow definition
+ * @param event1 event number in the first flow definition
+ * @param uref2 second flow definition
+ * @param event2 event number in the second flow definition
+ * @return true if the events are identical
+ */
+static bool upipe_ts_sig_event_equal(struct uref *uref1, uint64_t event1,
+                                     struct uref *uref2, uint64_t event2)
+{
+    uint64_t u1 = 0, u2 = 0;
+#define UNSIGNED_EQUAL(getter)                                              \
+    if (ubase_check(getter(uref1, &u1, event1)) !=                          \
+            ubase_check(getter(uref2, &u2, event2)) || u1 != u2)            \
+        return false;
+    UNSIGNED_EQUAL(uref_event_get_id)
+    UNSIGNED_EQUAL(uref_event_get_start)
+    UNSIGNED_EQUAL(uref_event_get_duration)
+    u1 = u2 = 0;
+    UNSIGNED_EQUAL(uref_ts_event_get_descriptors)
+#undef UNSIGNED_EQUAL
+
+    const char *str1 = NULL, *str2 = NULL;
+#define STRING_EQUAL(getter)                                                \
+    if (ubase_check(getter(uref1, &str1, event1)) !=                        \
+            ubase_check(getter(uref2, &str2, event2)) ||                    \
+        (str1 != NULL && str2 != NULL && strcmp(str1, str2)))               \
+        return false;
+    STRING_EQUAL(uref_event_get_language)
+    STRING_EQUAL(uref_event_get_name)
+    STRING_EQUAL(uref_event_get_description)
+#undef STRING_EQUAL
+
+    uint8_t running1 = 0, running2 = 0;
+    uref_ts_event_get_running_status(uref1, &running1, event1);
+    uref_ts_event_get_running_status(uref2, &running2, event2);
+    if (running1 != running2 ||
+        ubase_check(uref_ts_event_get_scrambled(uref1, event1)) !=
+        ubase_check(uref_ts_event_get_scrambled(uref2, event2)))
+        return false;
+
+    for (uint64_t j = 0; j < u1; j++) {
+        const uint8_t *desc1 = NULL, *desc2 = NULL;
+        size_t size1 = 0, size2 = 0;
+        uref_ts_event_get_descriptor(uref1, &desc1, &size1, event1, j);
+        uref_ts_event_get_descriptor(uref2, &desc2, &size2, event2, j);
+        if (size1 != size2 || (size1 && memcmp(desc1, desc2, size1)))
+            return false;
+    }
+    return true;
+}
+
+/** @internal @This frees the EIT schedule sections of a service.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_sig_service_clean_eits(struct upipe *upipe)
+{
+    struct upipe_ts_sig_service *service =
+        upipe_ts_sig_service_from_upipe(upipe);
+    struct upipe_ts_sig *sig =
+        upipe_ts_sig_from_service_mgr(upipe->mgr);
+    struct uchain *section_chain;
+    while ((section_chain = ulist_pop(&service->eits_sections)) != NULL)
+        ubuf_free(ubuf_from_uchain(section_chain));
+    sig->eits_nb_sections -= service->eits_nb_sections;
+    service->eits_nb_sections = 0;
+    service->eits_size = 0;
+    service->eits_next = NULL;
+    free(service->eits_events);
+    service->eits_events = NULL;
+    service->eits_events_size = 0;
+    uref_free(service->eits_flow_def);
+    service->eits_flow_def = NULL;
+}
+
+/** @internal @This looks up the EIT schedule sections of the previous
+ * flow definition in the current one. Sections whose events are found
+ * unchanged, in the same order, are kept and renumbered to their new
+ * position, so that they do not need to be rebuilt; the others are freed.
+ *
+ * @param upipe description structure of the pipe
+ * @param first number of the first event of the schedule
+ * @param event_number number of events in the current flow definition
+ */
+static void upipe_ts_sig_service_match_eits(struct upipe *upipe,
+                                            uint64_t first,
+                                            uint64_t event_number)
+{
+    struct upipe_ts_sig_service *service =
+        upipe_ts_sig_service_from_upipe(upipe);
+    struct uref *old_flow_def = service->eits_flow_def;
+    uint64_t next = first;
+
+    for (unsigned int k = 0; k < service->eits_events_size; k++) {
+        struct upipe_ts_sig_eits_events *events = &service->eits_events[k];
+        uint64_t nb = events->end - events->first;
+        uint64_t event_id;
+        bool found = false;
+        if (old_flow_def != NULL && nb &&
+            ubase_check(uref_event_get_id(old_flow_def, &event_id,
+                                          events->first))) {
+            for (uint64_t i = next; !found && i + nb <= event_number; i++) {
+                uint64_t id;
+                if (!ubase_check(uref_event_get_id(service->flow_def, &id,
+                                                   i)) || id != event_id)
+                    continue;
+
+                found = true;
+                for (uint64_t j = 0; found && j < nb; j++)
+                    found = upipe_ts_sig_event_equal(service->flow_def, i + j,
+                            old_flow_def, events->first + j);
+                if (found) {
+                    events->first = i;
+                    events->end = next = i + nb;
+                }
+                break;
+            }
+        }
+
+        if (!found) {
+            ubuf_free(events->ubuf);
+            events->ubuf = NULL;
+        }
+    }
+}
+
+/** @internal @This generates a new EIT schedule PSI section. Table ID,
+ * section numbers and CRC are set later.
+ *
+ * @param upipe description structure of the pipe
+ * @param event_p pointer to the number of the first event, incremented for
+ * each consumed event
+ * @param limit number of the event where the section must end
+ * @return pointer to the section, or NULL in case of allocation error
+ */
+static struct ubuf *upipe_ts_sig_service_build_eits_section(
+        struct upipe *upipe, uint64_t *event_p, uint64_t limit)
+{
+    struct upipe_ts_sig *sig =
+        upipe_ts_sig_from_service_mgr(upipe->mgr);
+    struct ubuf *ubuf = ubuf_block_alloc(sig->ubuf_mgr,
+            PSI_PRIVATE_MAX_SIZE + PSI_HEADER_SIZE);
+    if (unlikely(ubuf == NULL))
+        return NULL;
+
+    uint8_t *buffer;
+    int size = -1;
+    if (!ubase_check(ubuf_block_write(ubuf, 0, &size, &buffer))) {
+        ubuf_free(ubuf);
+        return NULL;
+    }
+
+    psi_init(buffer, true);
+    psi_set_tableid(buffer, EIT_TABLE_ID_SCHED_ACTUAL_FIRST);
+    /* set length later */
+    psi_set_length(buffer, PSI_PRIVATE_MAX_SIZE);
+    psi_set_current(buffer);
+
+    uint64_t i = *event_p;
+    uint16_t j = 0;
+    uint8_t *event;
+    while ((event = eit_get_event(buffer, j)) != NULL && i < limit) {
+        int err = upipe_ts_sig_service_build_eit_event(upipe, i,
+                                                       buffer, event);
+
+        if (err != UBASE_ERR_NONE) {
+            if (err == UBASE_ERR_NOSPC) {
+                if (j)
+                    break;
+                upipe_warn_va(upipe, "EIT event too large");
+            } else
+                upipe_warn_va(upipe, "EIT event invalid");
+
+            i++;
+            continue;
+        }
+
+        i++;
+        j++;
+    }
+    *event_p = i;
+
+    eit_set_length(buffer, event - buffer - EIT_HEADER_SIZE);
+    uint16_t eit_size = psi_get_length(buffer) + PSI_HEADER_SIZE;
+    ubuf_block_unmap(ubuf, 0);
+
+    ubuf_block_resize(ubuf, 0, eit_size);
+    return ubuf;
+}
+
 /** @internal @This generates a new EIT PSI section.
  *
  * @param upipe description structure of the pipe
@@ -450,12 +672,13 @@ static void upipe_ts_sig_service_build_eit(struct upipe *upipe)
         struct uchain *section_chain;
         while ((section_chain = ulist_pop(&service->eit_sections)) != NULL)
             ubuf_free(ubuf_from_uchain(section_chain));
-        while ((section_chain = ulist_pop(&service->eits_sections)) != NULL)
-            ubuf_free(ubuf_from_uchain(section_chain));
         service->eit_nb_sections = 0;
         service->eit_size = 0;
-        service->eits_nb_sections = 0;
-        service->eits_size = 0;
+        upipe_ts_sig_service_clean_eits(upipe);
+        upipe_ts_sig_schedule_eit(upipe_ts_sig_to_upipe(sig));
+        if (sig->eits_service == service)
+            sig->eits_service = NULL;
+        upipe_ts_sig_schedule_eits(upipe_ts_sig_to_upipe(sig));
         return;
     }
 
@@ -551,7 +774,7 @@ static void upipe_ts_sig_service_build_eit(struct upipe *upipe)
 
         eit_set_segment_last_sec_number(buffer, nb_sections - 1);
         psi_set_lastsection(buffer, nb_sections - 1);
-        psi_set_crc(buffer);
+        upipe_ts_psi_set_crc(buffer);
 
         ubuf_block_unmap(ubuf, 0);
     }
@@ -561,123 +784,136 @@ static void upipe_ts_sig_service_build_eit(struct upipe *upipe)
     service->eit_sent = false;
 
 
-    /* EIT schedules */
-    total_size = 0;
-    nb_sections = 0;
-
-    while ((section_chain = ulist_pop(&service->eits_sections)) != NULL)
-        ubuf_free(ubuf_from_uchain(section_chain));
+    /* EIT schedules, keeping the sections whose events did not change */
+    /* the sections are owned by eits_events until they are kept */
+    ulist_init(&service->eits_sections);
     sig->eits_nb_sections -= service->eits_nb_sections;
+    upipe_ts_sig_service_match_eits(upipe, i, event_number);
+    struct upipe_ts_sig_eits_events *old_events = service->eits_events;
+    unsigned int old_size = service->eits_events_size;
+    unsigned int k = 0;
+
+    /* each section carries at least one event */
+    struct upipe_ts_sig_eits_events *events = NULL;
+    if (i < event_number) {
+        events = malloc(sizeof(struct upipe_ts_sig_eits_events) *
+                        (event_number - i));
+        if (unlikely(events == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            i = event_number;
+        }
+    }
 
-    uint8_t table_id = EIT_TABLE_ID_SCHED_ACTUAL_FIRST;
-
+    unsigned int nb_events = 0;
+    unsigned int nb_reused = 0;
+    total_size = 0;
     while (i < event_number) {
-        if (unlikely(table_id > EIT_TABLE_ID_SCHED_ACTUAL_LAST)) {
+        if (unlikely(nb_events >=
+                     PSI_TABLE_MAX_SECTIONS * (EIT_TABLE_ID_SCHED_ACTUAL_LAST -
+                                               EIT_TABLE_ID_SCHED_ACTUAL_FIRST +
+                                               1))) {
             upipe_warn(upipe, "EIT too large");
             upipe_throw_error(upipe, UBASE_ERR_INVALID);
             break;
         }
-        nb_sections = 0;
 
-        while (i < event_number) {
-            if (unlikely(nb_sections >= PSI_TABLE_MAX_SECTIONS)) {
-                table_id++;
-                break;
-            }
+        while (k < old_size &&
+               (old_events[k].ubuf == NULL || old_events[k].first < i)) {
+            ubuf_free(old_events[k].ubuf);
+            old_events[k].ubuf = NULL;
+            k++;
+        }
 
-            struct ubuf *ubuf = ubuf_block_alloc(sig->ubuf_mgr,
-                    PSI_PRIVATE_MAX_SIZE + PSI_HEADER_SIZE);
+        uint64_t first = i;
+        struct ubuf *ubuf;
+        if (k < old_size && old_events[k].first == i) {
+            ubuf = old_events[k].ubuf;
+            old_events[k].ubuf = NULL;
+            i = old_events[k].end;
+            k++;
+            nb_reused++;
+        } else {
+            ubuf = upipe_ts_sig_service_build_eits_section(upipe, &i,
+                    k < old_size ? old_events[k].first : event_number);
             if (unlikely(ubuf == NULL)) {
                 upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-                return;
-            }
-
-            uint8_t *buffer;
-            int size = -1;
-            if (!ubase_check(ubuf_block_write(ubuf, 0, &size, &buffer))) {
-                ubuf_free(ubuf);
-                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-                return;
-            }
-
-            psi_init(buffer, true);
-            psi_set_tableid(buffer, table_id);
-            /* set length later */
-            psi_set_length(buffer, PSI_PRIVATE_MAX_SIZE);
-            eit_set_sid(buffer, sid);
-            eit_set_tsid(buffer, tsid);
-            eit_set_onid(buffer, onid);
-            /* set last table id later */
-            psi_set_version(buffer, service->eit_version);
-            psi_set_current(buffer);
-            psi_set_section(buffer, nb_sections);
-            /* assume max number of sections, and overwrite later for the last
-             * table ID */
-            eit_set_segment_last_sec_number(buffer, PSI_TABLE_MAX_SECTIONS - 1);
-            psi_set_lastsection(buffer, PSI_TABLE_MAX_SECTIONS - 1);
-
-            uint16_t j = 0;
-            uint8_t *event;
-            while ((event = eit_get_event(buffer, j)) != NULL && i < event_number) {
-                int err = upipe_ts_sig_service_build_eit_event(upipe, i,
-                                                               buffer, event);
-
-                if (err != UBASE_ERR_NONE) {
-                    if (err == UBASE_ERR_NOSPC) {
-                        if (j)
-                            break;
-                        upipe_warn_va(upipe, "EIT event too large");
-                    } else
-                        upipe_warn_va(upipe, "EIT event invalid");
-
-                    i++;
-                    continue;
-                }
-
-                i++;
-                j++;
+                break;
             }
-
-            eit_set_length(buffer, event - buffer - EIT_HEADER_SIZE);
-            uint16_t eit_size = psi_get_length(buffer) + PSI_HEADER_SIZE;
-            ubuf_block_unmap(ubuf, 0);
-
-            ubuf_block_resize(ubuf, 0, eit_size);
-            ulist_add(&service->eits_sections, ubuf_to_uchain(ubuf));
-            nb_sections++;
-            total_size += eit_size;
         }
+
+        size_t eit_size = 0;
+        ubuf_block_size(ubuf, &eit_size);
+        events[nb_events].ubuf = ubuf;
+        events[nb_events].first = first;
+        events[nb_events].end = i;
+        nb_events++;
+        total_size += eit_size;
     }
 
-    ulist_foreach (&service->eits_sections, section_chain) {
-        struct ubuf *ubuf = ubuf_from_uchain(section_chain);
+    for ( ; k < old_size; k++)
+        ubuf_free(old_events[k].ubuf);
+    free(old_events);
+
+    /* number the sections, and copy the kept sections which are still
+     * referenced by packets being muxed */
+    uint8_t last_table_id = EIT_TABLE_ID_SCHED_ACTUAL_FIRST +
+        (nb_events ? (nb_events - 1) / PSI_TABLE_MAX_SECTIONS : 0);
+    for (k = 0; k < nb_events; k++) {
+        uint8_t table_id = EIT_TABLE_ID_SCHED_ACTUAL_FIRST +
+                           k / PSI_TABLE_MAX_SECTIONS;
+        uint8_t last_section = table_id == last_table_id ?
+            (nb_events - 1) % PSI_TABLE_MAX_SECTIONS :
+            PSI_TABLE_MAX_SECTIONS - 1;
         uint8_t *buffer;
         int size = -1;
-        if (!ubase_check(ubuf_block_write(ubuf, 0, &size, &buffer))) {
-            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-            continue;
-        }
-
-        if (psi_get_tableid(buffer) == table_id) {
-            eit_set_segment_last_sec_number(buffer, nb_sections - 1);
-            psi_set_lastsection(buffer, nb_sections - 1);
+        if (!ubase_check(ubuf_block_write(events[k].ubuf, 0, &size,
+                                          &buffer))) {
+            struct ubuf *ubuf = ubuf_block_copy(sig->ubuf_mgr,
+                                                events[k].ubuf, 0, -1);
+            size = -1;
+            if (unlikely(ubuf == NULL ||
+                         !ubase_check(ubuf_block_write(ubuf, 0, &size,
+                                                       &buffer)))) {
+                ubuf_free(ubuf);
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                continue;
+            }
+            ubuf_free(events[k].ubuf);
+            events[k].ubuf = ubuf;
         }
-        eit_set_last_table_id(buffer, table_id);
-        psi_set_crc(buffer);
 
-        ubuf_block_unmap(ubuf, 0);
+        psi_set_tableid(buffer, table_id);
+        eit_set_sid(buffer, sid);
+        eit_set_tsid(buffer, tsid);
+        eit_set_onid(buffer, onid);
+        psi_set_version(buffer, service->eit_version);
+        psi_set_section(buffer, k % PSI_TABLE_MAX_SECTIONS);
+        psi_set_lastsection(buffer, last_section);
+        eit_set_segment_last_sec_number(buffer, last_section);
+        eit_set_last_table_id(buffer, last_table_id);
+        upipe_ts_psi_set_crc(buffer);
+
+        ubuf_block_unmap(events[k].ubuf, 0);
+        ulist_add(&service->eits_sections, ubuf_to_uchain(events[k].ubuf));
     }
 
-    service->eits_nb_sections =
-        (table_id - EIT_TABLE_ID_SCHED_ACTUAL_FIRST) * PSI_TABLE_MAX_SECTIONS +
-        nb_sections;
+    service->eits_events = events;
+    service->eits_events_size = nb_events;
+    uref_free(service->eits_flow_def);
+    service->eits_flow_def = nb_events ? uref_dup(service->flow_def) : NULL;
+    service->eits_nb_sections = nb_events;
     sig->eits_nb_sections += service->eits_nb_sections;
     service->eits_size = total_size;
-    service->eits_next_section = 0;
+    service->eits_next = NULL;
 
-    upipe_notice_va(upipe, "end EIT (%"PRIu8" sections p/f, %"PRIu16" sections schedule)",
-                    service->eit_nb_sections, service->eits_nb_sections);
+    upipe_notice_va(upipe, "end EIT (%"PRIu8" sections p/f, %"PRIu16" sections schedule, %u unchanged)",
+                    service->eit_nb_sections, service->eits_nb_sections,
+                    nb_reused);
 
+    upipe_ts_sig_schedule_eit(upipe_ts_sig_to_upipe(sig));
+    if (sig->eits_service == service)
+        sig->eits_service = NULL;
+    upipe_ts_sig_schedule_eits(upipe_ts_sig_to_upipe(sig));
     upipe_ts_sig_update_status(upipe_ts_sig_to_upipe(sig));
 }
 
@@ -826,6 +1062,7 @@ static int upipe_ts_sig_service_control(struct upipe *upipe,
         case UPIPE_TS_MUX_SET_EIT_INTERVAL: {
             UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
             upipe_ts_sig_service->eit_interval = va_arg(args, uint64_t);
+            upipe_ts_sig_schedule_eit(upipe_ts_sig_to_upipe(sig));
             upipe_ts_sig_build_eit_flow_def(upipe_ts_sig_to_upipe(sig));
             upipe_ts_sig_build_sdt(upipe_ts_sig_to_upipe(sig));
             upipe_ts_sig_build_sdt_flow_def(upipe_ts_sig_to_upipe(sig));
@@ -852,10 +1089,14 @@ static void upipe_ts_sig_service_free(struct upipe *upipe)
     struct uchain *section_chain;
     while ((section_chain = ulist_pop(&service->eit_sections)) != NULL)
         ubuf_free(ubuf_from_uchain(section_chain));
-    while ((section_chain = ulist_pop(&service->eits_sections)) != NULL)
-        ubuf_free(ubuf_from_uchain(section_chain));
+    upipe_ts_sig_service_clean_eits(upipe);
     uref_free(service->flow_def);
 
+    if (sig->eits_service == service)
+        sig->eits_service = NULL;
+    upipe_ts_sig_schedule_eit(upipe_ts_sig_to_upipe(sig));
+    upipe_ts_sig_schedule_eits(upipe_ts_sig_to_upipe(sig));
+
     upipe_ts_sig_build_sdt(upipe_ts_sig_to_upipe(sig));
     upipe_ts_sig_build_sdt_flow_def(upipe_ts_sig_to_upipe(sig));
 
@@ -1036,6 +1277,8 @@ static struct upipe *_upipe_ts_sig_alloc(struct upipe_mgr *mgr,
     upipe_ts_sig->eits_octetrate = 0;
     upipe_ts_sig->eits_nb_sections = 0;
     upipe_ts_sig->eits_cr_sys = 0;
+    upipe_ts_sig->eit_service = NULL;
+    upipe_ts_sig->eits_service = NULL;
 
     upipe_ts_sig->tdt_interval = 0;
     upipe_ts_sig->tdt_cr_sys = 0;
@@ -1295,7 +1538,7 @@ static void upipe_ts_sig_build_nit(struct upipe *upipe)
         }
 
         psi_set_lastsection(buffer, nb_sections - 1);
-        psi_set_crc(buffer);
+        upipe_ts_psi_set_crc(buffer);
 
         ubuf_block_unmap(ubuf, 0);
     }
@@ -1553,7 +1796,7 @@ static void upipe_ts_sig_build_sdt(struct upipe *upipe)
         }
 
         psi_set_lastsection(buffer, nb_sections - 1);
-        psi_set_crc(buffer);
+        upipe_ts_psi_set_crc(buffer);
 
         ubuf_block_unmap(ubuf, 0);
     }
@@ -1670,43 +1913,86 @@ static void upipe_ts_sig_build_eit_flow_def(struct upipe *upipe)
                                NULL, NULL);
 }
 
-/** @internal @This sends an EITp/f PSI section.
+/** @internal @This finds the service whose EITp/f is due first, so that
+ * the services are not scanned for each muxed packet.
  *
  * @param upipe description structure of the pipe
- * @param cr_sys cr_sys of the next muxed packet
  */
-static void upipe_ts_sig_send_eit(struct upipe *upipe, uint64_t cr_sys)
+static void upipe_ts_sig_schedule_eit(struct upipe *upipe)
 {
     struct upipe_ts_sig *sig = upipe_ts_sig_from_upipe(upipe);
-    if (unlikely(sig->flow_def == NULL))
-        return;
+    uint64_t eit_cr_sys = UINT64_MAX;
+    sig->eit_service = NULL;
 
-    struct upipe_ts_sig_output *output = upipe_ts_sig_to_eit_output(sig);
-    if (cr_sys < output->cr_sys)
+    struct uchain *uchain;
+    ulist_foreach (&sig->services, uchain) {
+        struct upipe_ts_sig_service *service =
+            upipe_ts_sig_service_from_uchain(uchain);
+        if (!ulist_empty(&service->eit_sections) && service->eit_interval &&
+            service->eit_cr_sys + service->eit_interval < eit_cr_sys) {
+            eit_cr_sys = service->eit_cr_sys + service->eit_interval;
+            sig->eit_service = service;
+        }
+    }
+}
+
+/** @internal @This finds the service whose EIT schedule is sent next, that
+ * is the one which completed its last cycle first. The service being sent
+ * is kept until its cycle is complete.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_sig_schedule_eits(struct upipe *upipe)
+{
+    struct upipe_ts_sig *sig = upipe_ts_sig_from_upipe(upipe);
+    if (sig->eits_service != NULL && sig->eits_service->eits_next != NULL)
         return;
 
+    uint64_t eits_cr_sys = UINT64_MAX;
+    sig->eits_service = NULL;
+
     struct uchain *uchain;
     ulist_foreach (&sig->services, uchain) {
         struct upipe_ts_sig_service *service =
             upipe_ts_sig_service_from_uchain(uchain);
-        if (ulist_empty(&service->eit_sections) || !service->eit_interval ||
-            service->eit_cr_sys + service->eit_interval > cr_sys)
-            continue;
-
-        output->cr_sys = cr_sys;
-        service->eit_cr_sys = cr_sys;
-        if (!service->eit_sent) {
-            service->eit_version++;
-            service->eit_version &= 0x1f;
-            service->eit_sent = true;
+        if (service->eits_nb_sections &&
+            (sig->eits_service == NULL || service->eits_cr_sys < eits_cr_sys)) {
+            eits_cr_sys = service->eits_cr_sys;
+            sig->eits_service = service;
         }
+    }
+}
+
+/** @internal @This sends an EITp/f PSI section.
+ *
+ * @param upipe description structure of the pipe
+ * @param cr_sys cr_sys of the next muxed packet
+ */
+static void upipe_ts_sig_send_eit(struct upipe *upipe, uint64_t cr_sys)
+{
+    struct upipe_ts_sig *sig = upipe_ts_sig_from_upipe(upipe);
+    if (unlikely(sig->flow_def == NULL))
+        return;
 
-        upipe_verbose_va(upipe_ts_sig_service_to_upipe(service),
-                         "sending EIT (%"PRIu64")", cr_sys);
-        upipe_ts_sig_send(upipe, upipe_ts_sig_output_to_upipe(output),
-                          &service->eit_sections);
+    struct upipe_ts_sig_output *output = upipe_ts_sig_to_eit_output(sig);
+    struct upipe_ts_sig_service *service = sig->eit_service;
+    if (cr_sys < output->cr_sys || service == NULL ||
+        service->eit_cr_sys + service->eit_interval > cr_sys)
         return;
+
+    output->cr_sys = cr_sys;
+    service->eit_cr_sys = cr_sys;
+    if (!service->eit_sent) {
+        service->eit_version++;
+        service->eit_version &= 0x1f;
+        service->eit_sent = true;
     }
+
+    upipe_verbose_va(upipe_ts_sig_service_to_upipe(service),
+                     "sending EIT (%"PRIu64")", cr_sys);
+    upipe_ts_sig_send(upipe, upipe_ts_sig_output_to_upipe(output),
+                      &service->eit_sections);
+    upipe_ts_sig_schedule_eit(upipe);
 }
 
 /** @internal @This sends an EIT schedule PSI section.
@@ -1728,31 +2014,21 @@ static void upipe_ts_sig_send_eits(struct upipe *upipe, uint64_t cr_sys)
     if (output->flow_def == NULL || cr_sys < output->cr_sys)
         return;
 
-    uint64_t last_cr_sys = UINT64_MAX;
-    struct upipe_ts_sig_service *service = NULL;
-    struct uchain *uchain;
-    ulist_foreach (&sig->services, uchain) {
-        struct upipe_ts_sig_service *service_chain =
-            upipe_ts_sig_service_from_uchain(uchain);
-        if (service_chain->eits_nb_sections &&
-            service_chain->eits_cr_sys < last_cr_sys)
-            service = service_chain;
-    }
-
+    struct upipe_ts_sig_service *service = sig->eits_service;
     if (service == NULL)
         return; /* This should not happen */
 
-    assert(service->eits_next_section < service->eits_nb_sections);
-
-    uchain = ulist_at(&service->eits_sections, service->eits_next_section);
+    struct uchain *uchain = service->eits_next;
+    if (uchain == NULL)
+        uchain = ulist_peek(&service->eits_sections);
     assert(uchain != NULL);
 
     output->cr_sys = cr_sys;
-    service->eits_next_section++;
-    if (service->eits_next_section >= service->eits_nb_sections) {
+    if (ulist_is_last(&service->eits_sections, uchain)) {
         service->eits_cr_sys = cr_sys;
-        service->eits_next_section = 0;
-    }
+        service->eits_next = NULL;
+    } else
+        service->eits_next = uchain->next;
     if (!service->eit_sent) {
         service->eit_version++;
         service->eit_version &= 0x1f;
@@ -1774,6 +2050,8 @@ static void upipe_ts_sig_send_eits(struct upipe *upipe, uint64_t cr_sys)
     *uchain = uchain_bak;
 
     sig->eits_cr_sys = cr_sys + eits_interval;
+    if (service->eits_next == NULL)
+        upipe_ts_sig_schedule_eits(upipe);
 }
 
 /** @internal @This builds a new output flow definition for TDT.
@@ -1912,21 +2190,15 @@ static void upipe_ts_sig_update_status(struct upipe *upipe)
             cr_sys = sdt_cr_sys;
     }
 
-    uint64_t eit_cr_sys = cr_sys;
-    struct uchain *uchain;
-    ulist_foreach (&sig->services, uchain) {
-        struct upipe_ts_sig_service *service =
-            upipe_ts_sig_service_from_uchain(uchain);
-        if (likely(!ulist_empty(&service->eit_sections) &&
-                   service->eit_interval &&
-                   eit_cr_sys > service->eit_cr_sys + service->eit_interval))
-            eit_cr_sys = service->eit_cr_sys + service->eit_interval;
+    if (likely(sig->eit_service != NULL)) {
+        uint64_t eit_cr_sys = sig->eit_service->eit_cr_sys +
+                              sig->eit_service->eit_interval;
+        struct upipe_ts_sig_output *output = upipe_ts_sig_to_eit_output(sig);
+        if (unlikely(eit_cr_sys < output->cr_sys))
+            eit_cr_sys = output->cr_sys;
+        if (eit_cr_sys < cr_sys)
+            cr_sys = eit_cr_sys;
     }
-    struct upipe_ts_sig_output *output = upipe_ts_sig_to_eit_output(sig);
-    if (unlikely(eit_cr_sys < output->cr_sys))
-        eit_cr_sys = output->cr_sys;
-    if (eit_cr_sys < cr_sys)
-        cr_sys = eit_cr_sys;
 
     if (sig->eits_octetrate && sig->eits_nb_sections &&
         sig->eits_cr_sys < cr_sys)
@@ -2079,6 +2351,9 @@ static int upipe_ts_sig_set_encoding(struct upipe *upipe, const char *encoding)
     ulist_foreach (&sig->services, uchain) {
         struct upipe_ts_sig_service *service =
             upipe_ts_sig_service_from_uchain(uchain);
+        /* the strings of all events must be converted again */
+        uref_free(service->eits_flow_def);
+        service->eits_flow_def = NULL;
         upipe_ts_sig_service_build_eit(upipe_ts_sig_service_to_upipe(service));
     }
     upipe_ts_sig_build_eit_flow_def(upipe);
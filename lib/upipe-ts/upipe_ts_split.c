@@ -27,6 +27,7 @@
 #include <upipe/uprobe.h>
 #include <upipe/uref.h>
 #include <upipe/uref_block.h>
+#include <upipe/uref_clock.h>
 #include <upipe/ubuf.h>
 #include <upipe/upipe.h>
 #include <upipe/upipe_helper_upipe.h>
@@ -36,6 +37,7 @@
 #include <upipe/upipe_helper_output.h>
 #include <upipe/upipe_helper_subpipe.h>
 #include <upipe-ts/uref_ts_flow.h>
+#include <upipe-ts/uref_ts_burst.h>
 #include <upipe-ts/upipe_ts_split.h>
 
 #include <stdlib.h>
@@ -48,17 +50,33 @@
 
 /** we only accept blocks containing exactly one TS packet */
 #define EXPECTED_FLOW_DEF "block.mpegts."
+/** or bursts of TS packets */
+#define EXPECTED_FLOW_DEF_BURST UREF_TS_BURST_FLOW_DEF
 /** maximum number of PIDs */
 #define MAX_PIDS 8192
 
+/** number of PIDs in a lazily allocated block of the PID table */
+#define PID_BLOCK_SIZE 128
+
 /** @internal @This keeps internal information about a PID. */
 struct upipe_ts_split_pid {
     /** subs specific to that PID */
     struct uchain subs;
+    /** output of the PID if it has exactly one output, or NULL */
+    struct upipe_ts_split_sub *single;
     /** true if we asked for this PID */
     bool set;
 };
 
+/** @internal @This is a block of consecutive PIDs, allocated when one of them
+ * gets an output, and freed when they have none. */
+struct upipe_ts_split_pid_block {
+    /** number of PIDs of the block having outputs */
+    unsigned int nb_set;
+    /** PIDs of the block */
+    struct upipe_ts_split_pid pids[PID_BLOCK_SIZE];
+};
+
 /** @internal @This is the private context of a ts split pipe. */
 struct upipe_ts_split {
     /** real refcount management structure */
@@ -69,8 +87,15 @@ struct upipe_ts_split {
     /** list of output subpipes */
     struct uchain subs;
 
-    /** PIDs array */
-    struct upipe_ts_split_pid pids[MAX_PIDS];
+    /** true if the input is made of TS bursts */
+    bool burst;
+
+    /** bitmap of the PIDs having at least one output, checked first to
+     * drop unwanted packets */
+    uint8_t pid_filter[UPIPE_TS_SPLIT_PID_FILTER_SIZE];
+    /** PID table, as blocks of PID_BLOCK_SIZE PIDs, or NULL if none of the
+     * PIDs of the block has an output */
+    struct upipe_ts_split_pid_block *pid_blocks[MAX_PIDS / PID_BLOCK_SIZE];
 
     /** manager to create output subpipes */
     struct upipe_mgr sub_mgr;
@@ -255,18 +280,74 @@ static struct upipe *upipe_ts_split_alloc(struct upipe_mgr *mgr,
                    upipe_ts_split_free);
     upipe_ts_split_init_sub_mgr(upipe);
     upipe_ts_split_init_sub_subs(upipe);
+    upipe_ts_split->burst = false;
 
-    int i;
-    for (i = 0; i < MAX_PIDS; i++) {
-        ulist_init(&upipe_ts_split->pids[i].subs);
-        upipe_ts_split->pids[i].set = false;
-    }
+    memset(upipe_ts_split->pid_filter, 0,
+           sizeof(upipe_ts_split->pid_filter));
+    for (int i = 0; i < MAX_PIDS / PID_BLOCK_SIZE; i++)
+        upipe_ts_split->pid_blocks[i] = NULL;
     upipe_throw_ready(upipe);
     return upipe;
 }
 
-/** @internal @This checks the status of the PID, and sends the split_set_pid
- * or split_unset_pid event if it has not already been sent.
+/** @internal @This returns true if the given PID has at least one output.
+ *
+ * @param upipe_ts_split private context of the ts_split pipe
+ * @param pid PID to check
+ * @return true if the PID has outputs
+ */
+static inline bool upipe_ts_split_pid_wanted(
+        struct upipe_ts_split *upipe_ts_split, uint16_t pid)
+{
+    return upipe_ts_split->pid_filter[pid >> 3] & (1 << (pid & 7));
+}
+
+/** @internal @This returns the state of a PID, if its block is allocated.
+ *
+ * @param upipe_ts_split private context of the ts_split pipe
+ * @param pid PID
+ * @return pointer to the state of the PID, or NULL
+ */
+static inline struct upipe_ts_split_pid *upipe_ts_split_pid_get(
+        struct upipe_ts_split *upipe_ts_split, uint16_t pid)
+{
+    struct upipe_ts_split_pid_block *block =
+        upipe_ts_split->pid_blocks[pid / PID_BLOCK_SIZE];
+    return block != NULL ? &block->pids[pid % PID_BLOCK_SIZE] : NULL;
+}
+
+/** @internal @This returns the state of a PID, allocating its block if
+ * needed.
+ *
+ * @param upipe_ts_split private context of the ts_split pipe
+ * @param pid PID
+ * @return pointer to the state of the PID, or NULL in case of allocation
+ * error
+ */
+static struct upipe_ts_split_pid *upipe_ts_split_pid_alloc(
+        struct upipe_ts_split *upipe_ts_split, uint16_t pid)
+{
+    struct upipe_ts_split_pid_block **block_p =
+        &upipe_ts_split->pid_blocks[pid / PID_BLOCK_SIZE];
+    if (*block_p == NULL) {
+        struct upipe_ts_split_pid_block *block =
+            malloc(sizeof(struct upipe_ts_split_pid_block));
+        if (unlikely(block == NULL))
+            return NULL;
+        block->nb_set = 0;
+        for (int i = 0; i < PID_BLOCK_SIZE; i++) {
+            ulist_init(&block->pids[i].subs);
+            block->pids[i].single = NULL;
+            block->pids[i].set = false;
+        }
+        *block_p = block;
+    }
+    return &(*block_p)->pids[pid % PID_BLOCK_SIZE];
+}
+
+/** @internal @This checks the status of the PID, updates the dispatch table,
+ * and sends the split_set_pid or split_unset_pid event if it has not already
+ * been sent. The block of the PID is freed when none of its PIDs has outputs.
  *
  * @param upipe description structure of the pipe
  * @param pid PID to check
@@ -275,19 +356,41 @@ static void upipe_ts_split_pid_check(struct upipe *upipe, uint16_t pid)
 {
     assert(pid < MAX_PIDS);
     struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
-    if (!ulist_empty(&upipe_ts_split->pids[pid].subs)) {
-        if (!upipe_ts_split->pids[pid].set) {
-            upipe_ts_split->pids[pid].set = true;
+    struct upipe_ts_split_pid_block *block =
+        upipe_ts_split->pid_blocks[pid / PID_BLOCK_SIZE];
+    struct upipe_ts_split_pid *state = &block->pids[pid % PID_BLOCK_SIZE];
+    struct uchain *subs = &state->subs;
+    state->single = NULL;
+    if (!ulist_empty(subs)) {
+        upipe_ts_split->pid_filter[pid >> 3] |= 1 << (pid & 7);
+        if (ulist_is_last(subs, ulist_peek(subs)))
+            state->single =
+                upipe_ts_split_sub_from_uchain_pid(ulist_peek(subs));
+    } else
+        upipe_ts_split->pid_filter[pid >> 3] &= ~(1 << (pid & 7));
+
+    if (!ulist_empty(subs)) {
+        if (!state->set) {
+            state->set = true;
+            block->nb_set++;
             upipe_dbg_va(upipe, "throw ts split add pid %"PRIu16, pid);
             upipe_throw(upipe, UPROBE_TS_SPLIT_ADD_PID,
                         UPIPE_TS_SPLIT_SIGNATURE, (unsigned int)pid);
         }
     } else {
-        if (upipe_ts_split->pids[pid].set) {
-            upipe_ts_split->pids[pid].set = false;
+        if (state->set) {
+            state->set = false;
+            block->nb_set--;
             upipe_dbg_va(upipe, "throw ts split del pid %"PRIu16, pid);
             upipe_throw(upipe, UPROBE_TS_SPLIT_DEL_PID,
                         UPIPE_TS_SPLIT_SIGNATURE, (unsigned int)pid);
+            /* the probe may have added an output in the meantime, or
+             * removed the outputs of other PIDs and freed the block */
+            block = upipe_ts_split->pid_blocks[pid / PID_BLOCK_SIZE];
+            if (block != NULL && !block->nb_set) {
+                upipe_ts_split->pid_blocks[pid / PID_BLOCK_SIZE] = NULL;
+                free(block);
+            }
         }
     }
 }
@@ -303,8 +406,13 @@ static void upipe_ts_split_pid_set(struct upipe *upipe, uint16_t pid,
 {
     assert(pid < MAX_PIDS);
     struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
-    ulist_add(&upipe_ts_split->pids[pid].subs,
-              upipe_ts_split_sub_to_uchain_pid(output));
+    struct upipe_ts_split_pid *state =
+        upipe_ts_split_pid_alloc(upipe_ts_split, pid);
+    if (unlikely(state == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    ulist_add(&state->subs, upipe_ts_split_sub_to_uchain_pid(output));
     upipe_ts_split_pid_check(upipe, pid);
 }
 
@@ -319,8 +427,12 @@ static void upipe_ts_split_pid_unset(struct upipe *upipe, uint16_t pid,
 {
     assert(pid < MAX_PIDS);
     struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
+    struct upipe_ts_split_pid *state =
+        upipe_ts_split_pid_get(upipe_ts_split, pid);
+    if (unlikely(state == NULL))
+        return;
     struct uchain *uchain, *uchain_tmp;
-    ulist_delete_foreach (&upipe_ts_split->pids[pid].subs, uchain, uchain_tmp) {
+    ulist_delete_foreach (&state->subs, uchain, uchain_tmp) {
         if (output == upipe_ts_split_sub_from_uchain_pid(uchain)) {
             ulist_delete(uchain);
         }
@@ -328,29 +440,33 @@ static void upipe_ts_split_pid_unset(struct upipe *upipe, uint16_t pid,
     upipe_ts_split_pid_check(upipe, pid);
 }
 
-/** @internal @This demuxes a TS packet to the appropriate output(s).
+/** @internal @This outputs a TS packet to the outputs of its PID.
  *
  * @param upipe description structure of the pipe
  * @param uref uref structure
+ * @param pid PID of the packet
  * @param upump_p reference to pump that generated the buffer
  */
-static void upipe_ts_split_input(struct upipe *upipe, struct uref *uref,
-                                 struct upump **upump_p)
+static void upipe_ts_split_output_pid(struct upipe *upipe, struct uref *uref,
+                                      uint16_t pid, struct upump **upump_p)
 {
     struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
-    uint8_t buffer[TS_HEADER_SIZE];
-    const uint8_t *ts_header = uref_block_peek(uref, 0, TS_HEADER_SIZE,
-                                               buffer);
-    if (unlikely(ts_header == NULL)) {
+    if (!upipe_ts_split_pid_wanted(upipe_ts_split, pid)) {
         uref_free(uref);
-        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return;
     }
-    uint16_t pid = ts_get_pid(ts_header);
-    UBASE_FATAL(upipe, uref_block_peek_unmap(uref, 0, buffer, ts_header))
+    /* the block is allocated as the PID has outputs */
+    struct upipe_ts_split_pid *state =
+        upipe_ts_split_pid_get(upipe_ts_split, pid);
+    struct upipe_ts_split_sub *single = state->single;
+    if (likely(single != NULL)) {
+        upipe_ts_split_sub_output(upipe_ts_split_sub_to_upipe(single),
+                                  uref, upump_p);
+        return;
+    }
 
     struct uchain *uchain;
-    ulist_foreach (&upipe_ts_split->pids[pid].subs, uchain) {
+    ulist_foreach (&state->subs, uchain) {
         struct upipe_ts_split_sub *output =
                 upipe_ts_split_sub_from_uchain_pid(uchain);
         if (likely(uchain->next == NULL)) {
@@ -374,6 +490,94 @@ static void upipe_ts_split_input(struct upipe *upipe, struct uref *uref,
         uref_free(uref);
 }
 
+/** @internal @This demuxes a burst of TS packets in a single pass. Only the
+ * packets of the PIDs which have outputs are allocated a uref.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_split_input_burst(struct upipe *upipe, struct uref *uref,
+                                       struct upump **upump_p)
+{
+    struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
+    size_t size;
+    if (unlikely(!ubase_check(uref_block_size(uref, &size)))) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    if (unlikely(size % TS_SIZE))
+        upipe_warn_va(upipe, "burst of %zu octets is not aligned", size);
+
+    const uint8_t *index;
+    size_t index_size;
+    bool indexed = ubase_check(uref_ts_burst_get_cr_sys_index(uref, &index,
+                                                              &index_size));
+    unsigned int nb = 0;
+    for (size_t offset = 0; offset + TS_SIZE <= size;
+         offset += TS_SIZE, nb++) {
+        uint8_t buffer[TS_HEADER_SIZE];
+        const uint8_t *ts_header = uref_block_peek(uref, offset,
+                                                   TS_HEADER_SIZE, buffer);
+        if (unlikely(ts_header == NULL)) {
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        uint16_t pid = ts_get_pid(ts_header);
+        uref_block_peek_unmap(uref, offset, buffer, ts_header);
+        if (!upipe_ts_split_pid_wanted(upipe_ts_split, pid))
+            continue;
+
+        struct uref *packet = uref_dup(uref);
+        if (unlikely(packet == NULL ||
+                     !ubase_check(uref_block_resize(packet, offset,
+                                                    TS_SIZE)))) {
+            uref_free(packet);
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        if (indexed) {
+            uint64_t cr_sys;
+            if (ubase_check(uref_ts_burst_get_cr_sys(uref, nb, &cr_sys)))
+                uref_clock_set_cr_sys(packet, cr_sys);
+            uref_ts_burst_delete_cr_sys_index(packet);
+        }
+        upipe_ts_split_output_pid(upipe, packet, pid, upump_p);
+    }
+    uref_free(uref);
+}
+
+/** @internal @This demuxes a TS packet to the appropriate output(s).
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_split_input(struct upipe *upipe, struct uref *uref,
+                                 struct upump **upump_p)
+{
+    struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
+    if (upipe_ts_split->burst) {
+        upipe_ts_split_input_burst(upipe, uref, upump_p);
+        return;
+    }
+
+    uint8_t buffer[TS_HEADER_SIZE];
+    const uint8_t *ts_header = uref_block_peek(uref, 0, TS_HEADER_SIZE,
+                                               buffer);
+    if (unlikely(ts_header == NULL)) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    uint16_t pid = ts_get_pid(ts_header);
+    UBASE_FATAL(upipe, uref_block_peek_unmap(uref, 0, buffer, ts_header))
+    upipe_ts_split_output_pid(upipe, uref, pid, upump_p);
+}
+
 /** @internal @This sets the input flow definition.
  *
  * @param upipe description structure of the pipe
@@ -385,7 +589,14 @@ static int upipe_ts_split_set_flow_def(struct upipe *upipe,
 {
     if (flow_def == NULL)
         return UBASE_ERR_INVALID;
-    return uref_flow_match_def(flow_def, EXPECTED_FLOW_DEF);
+    struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
+    if (ubase_check(uref_flow_match_def(flow_def, EXPECTED_FLOW_DEF_BURST))) {
+        upipe_ts_split->burst = true;
+        return UBASE_ERR_NONE;
+    }
+    UBASE_RETURN(uref_flow_match_def(flow_def, EXPECTED_FLOW_DEF))
+    upipe_ts_split->burst = false;
+    return UBASE_ERR_NONE;
 }
 
 /** @internal @This processes control commands.
@@ -413,6 +624,16 @@ static int upipe_ts_split_control(struct upipe *upipe,
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_ts_split_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_TS_SPLIT_GET_PID_FILTER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_SPLIT_SIGNATURE)
+            const uint8_t **pid_filter_p = va_arg(args, const uint8_t **);
+            struct urefcount **owner_p = va_arg(args, struct urefcount **);
+            struct upipe_ts_split *upipe_ts_split =
+                upipe_ts_split_from_upipe(upipe);
+            *pid_filter_p = upipe_ts_split->pid_filter;
+            *owner_p = upipe_ts_split_to_urefcount_real(upipe_ts_split);
+            return UBASE_ERR_NONE;
+        }
 
         default:
             return UBASE_ERR_UNHANDLED;
@@ -46,6 +46,7 @@
 #include <upipe/upipe_helper_output.h>
 #include <upipe/upipe_helper_output_size.h>
 #include <upipe-ts/upipe_ts_sync.h>
+#include <upipe-ts/uref_ts_burst.h>
 
 #include <stdlib.h>
 #include <stdbool.h>
@@ -61,6 +62,8 @@
 #define EXPECTED_FLOW_DEF "block."
 /** when configured with standard TS size, we output TS packets */
 #define OUTPUT_FLOW_DEF "block.mpegts."
+/** when outputting several packets per buffer */
+#define BURST_OUTPUT_FLOW_DEF UREF_TS_BURST_FLOW_DEF
 /** otherwise there is a suffix to decaps */
 #define SUFFIX_OUTPUT_FLOW_DEF "block.mpegtssuffix."
 /** TS synchronization word */
@@ -84,6 +87,8 @@ struct upipe_ts_sync {
     size_t output_size;
     /** number of packets to sync with */
     unsigned int ts_sync;
+    /** maximum number of packets per output buffer */
+    unsigned int batch;
     /** next uref to be processed */
     struct uref *next_uref;
     /** original size of the next uref */
@@ -129,6 +134,7 @@ static struct upipe *upipe_ts_sync_alloc(struct upipe_mgr *mgr,
     upipe_ts_sync_init_output(upipe);
     upipe_ts_sync_init_output_size(upipe, TS_SIZE);
     upipe_ts_sync->ts_sync = DEFAULT_TS_SYNC;
+    upipe_ts_sync->batch = 1;
     upipe_ts_sync->next_uref = NULL;
     ulist_init(&upipe_ts_sync->urefs);
     upipe_throw_ready(upipe);
@@ -146,35 +152,40 @@ static struct upipe *upipe_ts_sync_alloc(struct upipe_mgr *mgr,
 static bool upipe_ts_sync_check(struct upipe *upipe, size_t *offset_p)
 {
     struct upipe_ts_sync *upipe_ts_sync = upipe_ts_sync_from_upipe(upipe);
-    for ( ; ; ) {
-        if (unlikely(!ubase_check(uref_block_scan(upipe_ts_sync->next_uref,
-                                                  offset_p, TS_SYNC))))
-            return false;
-
-        /* first octet at *offset_p is a sync word */
-        int ts_sync = upipe_ts_sync->ts_sync - 1;
-        for (int offset = *offset_p + upipe_ts_sync->output_size; ts_sync;
-             ts_sync--, offset += upipe_ts_sync->output_size) {
-            const uint8_t *buffer;
-            int size = 1;
-            uint8_t word;
-            if (unlikely(!ubase_check(uref_block_read(upipe_ts_sync->next_uref,
-                                          offset, &size, &buffer))))
-                /* not enough sync words could be tested */
-                return false;
-            assert(size == 1);
-            word = *buffer;
-            uref_block_unmap(upipe_ts_sync->next_uref, offset);
-            if (word != TS_SYNC) {
-                *offset_p += 1;
-                break;
-            }
-        }
-        if (!ts_sync)
+    return ubase_check(uref_block_scan_stride(upipe_ts_sync->next_uref,
+                offset_p, TS_SYNC, upipe_ts_sync->output_size,
+                upipe_ts_sync->ts_sync));
+}
+
+/** @internal @This counts the TS packets at the beginning of the working
+ * buffer which may be output at once, after @ref upipe_ts_sync_check found
+ * a TS packet at offset 0. Each of them is followed by the required number
+ * of sync words, and starts in the same input uref, so that they share its
+ * attributes.
+ *
+ * @param upipe description structure of the pipe
+ * @return number of TS packets
+ */
+static unsigned int upipe_ts_sync_count(struct upipe *upipe)
+{
+    struct upipe_ts_sync *upipe_ts_sync = upipe_ts_sync_from_upipe(upipe);
+    unsigned int nb = 1;
+    while (nb < upipe_ts_sync->batch &&
+           nb * upipe_ts_sync->output_size < upipe_ts_sync->next_uref_size) {
+        size_t offset = (nb + upipe_ts_sync->ts_sync - 1) *
+                        upipe_ts_sync->output_size;
+        const uint8_t *buffer;
+        int size = 1;
+        if (!ubase_check(uref_block_read(upipe_ts_sync->next_uref, offset,
+                                         &size, &buffer)))
+            break;
+        uint8_t word = *buffer;
+        uref_block_unmap(upipe_ts_sync->next_uref, offset);
+        if (word != TS_SYNC)
             break;
+        nb++;
     }
-
-    return true;
+    return nb;
 }
 
 /** @internal @This flushes all input buffers.
@@ -236,7 +247,7 @@ static void upipe_ts_sync_input(struct upipe *upipe, struct uref *uref,
         /* upipe_ts_sync_check said there is at least one TS packet there. */
         upipe_ts_sync_sync_acquired(upipe);
         struct uref *output = upipe_ts_sync_extract_uref_stream(upipe,
-                                                    upipe_ts_sync->output_size);
+                upipe_ts_sync_count(upipe) * upipe_ts_sync->output_size);
         if (unlikely(output == NULL)) {
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             continue;
@@ -265,7 +276,9 @@ static int upipe_ts_sync_set_flow_def(struct upipe *upipe,
     struct upipe_ts_sync *upipe_ts_sync = upipe_ts_sync_from_upipe(upipe);
     UBASE_RETURN(uref_block_flow_set_size(flow_def_dup,
                                           upipe_ts_sync->output_size))
-    UBASE_RETURN(uref_flow_set_def(flow_def_dup, OUTPUT_FLOW_DEF))
+    UBASE_RETURN(uref_flow_set_def(flow_def_dup,
+                upipe_ts_sync->batch > 1 ? BURST_OUTPUT_FLOW_DEF :
+                                           OUTPUT_FLOW_DEF))
     upipe_ts_sync_store_flow_def(upipe, flow_def_dup);
     return UBASE_ERR_NONE;
 }
@@ -302,6 +315,32 @@ static int _upipe_ts_sync_set_sync(struct upipe *upipe, int sync)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the maximum number of packets per output buffer.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch maximum number of packets
+ * @return an error code
+ */
+static int _upipe_ts_sync_set_batch(struct upipe *upipe, unsigned int batch)
+{
+    struct upipe_ts_sync *upipe_ts_sync = upipe_ts_sync_from_upipe(upipe);
+    if (!batch)
+        return UBASE_ERR_INVALID;
+    upipe_ts_sync->batch = batch;
+
+    if (upipe_ts_sync->flow_def != NULL) {
+        struct uref *flow_def = uref_dup(upipe_ts_sync->flow_def);
+        if (unlikely(flow_def == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return UBASE_ERR_ALLOC;
+        }
+        UBASE_RETURN(uref_flow_set_def(flow_def,
+                    batch > 1 ? BURST_OUTPUT_FLOW_DEF : OUTPUT_FLOW_DEF))
+        upipe_ts_sync_store_flow_def(upipe, flow_def);
+    }
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a ts sync pipe.
  *
  * @param upipe description structure of the pipe
@@ -333,6 +372,19 @@ static int upipe_ts_sync_control(struct upipe *upipe,
             int sync = va_arg(args, int);
             return _upipe_ts_sync_set_sync(upipe, sync);
         }
+        case UPIPE_TS_SYNC_GET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_SYNC_SIGNATURE)
+            unsigned int *batch_p = va_arg(args, unsigned int *);
+            struct upipe_ts_sync *upipe_ts_sync =
+                upipe_ts_sync_from_upipe(upipe);
+            *batch_p = upipe_ts_sync->batch;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_TS_SYNC_SET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_SYNC_SIGNATURE)
+            unsigned int batch = va_arg(args, unsigned int);
+            return _upipe_ts_sync_set_batch(upipe, batch);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
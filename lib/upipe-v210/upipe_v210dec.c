@@ -189,6 +189,17 @@ static void v210dec_setup_asm(struct upipe *upipe, bool assembly)
     }
 #endif
 #endif
+
+#if defined(__i686__) || defined(__x86_64__)
+    if (__builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512vl")) {
+        v210dec->v210_to_planar_8  = upipe_v210_to_planar_8_avx512;
+        v210dec->v210_to_planar_10 = upipe_v210_to_planar_10_avx512;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    v210dec->v210_to_planar_8  = upipe_v210_to_planar_8_neon;
+    v210dec->v210_to_planar_10 = upipe_v210_to_planar_10_neon;
+#endif
 }
 
 /** @internal @This handles data.
@@ -413,16 +424,7 @@ static int upipe_v210dec_amend_ubuf_mgr(struct upipe *upipe,
     struct uref *flow_format = uref_dup(request->uref);
     UBASE_ALLOC_RETURN(flow_format);
 
-    uint64_t align;
-    if (!ubase_check(uref_pic_flow_get_align(flow_format, &align)) || !align) {
-        uref_pic_flow_set_align(flow_format, 32);
-        align = 32;
-    }
-
-    if (align % 32) {
-        align = align * 32 / ubase_gcd(align, 32);
-        uref_pic_flow_set_align(flow_format, align);
-    }
+    uref_pic_flow_require_align(flow_format, 32);
 
     struct urequest ubuf_mgr_request;
     urequest_set_opaque(&ubuf_mgr_request, request);
@@ -419,17 +419,7 @@ static int upipe_v210enc_amend_ubuf_mgr(struct upipe *upipe,
     struct uref *flow_format = uref_dup(request->uref);
     UBASE_ALLOC_RETURN(flow_format);
 
-    uint64_t align;
-    if (!ubase_check(uref_pic_flow_get_align(flow_format, &align)) || !align) {
-        uref_pic_flow_set_align(flow_format, 32);
-        align = 32;
-    }
-
-
-    if (align % 32) {
-        align = align * 32 / ubase_gcd(align, 32);
-        uref_pic_flow_set_align(flow_format, align);
-    }
+    uref_pic_flow_require_align(flow_format, 32);
 
     struct urequest ubuf_mgr_request;
     urequest_set_opaque(&ubuf_mgr_request, request);
@@ -598,6 +588,17 @@ static struct upipe *upipe_v210enc_alloc(struct upipe_mgr *mgr,
 #endif
 #endif
 
+#if defined(__i686__) || defined(__x86_64__)
+    if (__builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512vl")) {
+        upipe_v210enc->pack_line_8  = upipe_planar_to_v210_8_avx512;
+        upipe_v210enc->pack_line_10 = upipe_planar_to_v210_10_avx512;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    upipe_v210enc->pack_line_8  = upipe_planar_to_v210_8_neon;
+    upipe_v210enc->pack_line_10 = upipe_planar_to_v210_10_neon;
+#endif
+
     upipe_v210enc_init_urefcount(upipe);
     upipe_v210enc_init_ubuf_mgr(upipe);
     upipe_v210enc_init_output(upipe);
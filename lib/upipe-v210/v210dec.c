@@ -30,6 +30,12 @@
 
 #include "v210dec.h"
 
+#if defined(__i686__) || defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 // TODO: handle endianess
 
 static inline uint32_t rl32(const void *src)
@@ -79,3 +85,173 @@ void upipe_v210_to_planar_10_c(const void *src, uint16_t *y, uint16_t *u, uint16
         READ_PIXELS_10(y, v, y);
     }
 }
+
+/* The vector variants below process 4 or 8 groups of 6 pixels (16 octets)
+ * per iteration, and leave the remaining groups to the C version, so that
+ * they don't write past the given number of pixels. */
+
+#if defined(__i686__) || defined(__x86_64__)
+/* Each 32-bit word of a group carries 3 components, at bits 0, 10 and 20.
+ * The components of 16 words are extracted, and gathered in a table of 48
+ * words (first components, then second, then third), from which the
+ * planes are picked. */
+static const uint16_t v210dec_avx512_y[32] = {
+    16,  1, 33, 18,  3, 35,
+    20,  5, 37, 22,  7, 39,
+    24,  9, 41, 26, 11, 43,
+    28, 13, 45, 30, 15, 47,
+};
+static const uint16_t v210dec_avx512_u[32] = {
+     0, 17, 34,  4, 21, 38,  8, 25, 42, 12, 29, 46,
+};
+static const uint16_t v210dec_avx512_v[32] = {
+    32,  2, 19, 36,  6, 23, 40, 10, 27, 44, 14, 31,
+};
+
+/** @internal @This unpacks 24 pixels into 10-bit components.
+ *
+ * @param src v210 source (64 octets)
+ * @param y_p filled in with 24 luma components
+ * @param u_p filled in with 12 Cb components
+ * @param v_p filled in with 12 Cr components
+ */
+__attribute__((target("avx512f,avx512bw,avx512vl")))
+static inline void v210dec_unpack_avx512(const void *src, __m512i *y_p,
+                                         __m512i *u_p, __m512i *v_p)
+{
+    const __m512i mask = _mm512_set1_epi32(0x3ff);
+    __m512i w = _mm512_loadu_si512(src);
+    __m256i c0 = _mm512_cvtepi32_epi16(_mm512_and_si512(w, mask));
+    __m256i c1 = _mm512_cvtepi32_epi16(
+            _mm512_and_si512(_mm512_srli_epi32(w, 10), mask));
+    __m256i c2 = _mm512_cvtepi32_epi16(
+            _mm512_and_si512(_mm512_srli_epi32(w, 20), mask));
+    __m512i c01 = _mm512_inserti64x4(_mm512_castsi256_si512(c0), c1, 1);
+    __m512i c2x = _mm512_castsi256_si512(c2);
+
+    *y_p = _mm512_permutex2var_epi16(c01,
+            _mm512_loadu_si512(v210dec_avx512_y), c2x);
+    *u_p = _mm512_permutex2var_epi16(c01,
+            _mm512_loadu_si512(v210dec_avx512_u), c2x);
+    *v_p = _mm512_permutex2var_epi16(c01,
+            _mm512_loadu_si512(v210dec_avx512_v), c2x);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl")))
+void upipe_v210_to_planar_10_avx512(const void *src, uint16_t *y, uint16_t *u, uint16_t *v, uintptr_t pixels)
+{
+    const uint8_t *s = src;
+    uintptr_t i;
+    for (i = 0; i + 24 <= pixels; i += 24) {
+        __m512i yy, uu, vv;
+        v210dec_unpack_avx512(s, &yy, &uu, &vv);
+        _mm512_mask_storeu_epi16(y + i, 0xffffff, yy);
+        _mm512_mask_storeu_epi16(u + i / 2, 0xfff, uu);
+        _mm512_mask_storeu_epi16(v + i / 2, 0xfff, vv);
+        s += 64;
+    }
+    if (pixels - i >= 6)
+        upipe_v210_to_planar_10_c(s, y + i, u + i / 2, v + i / 2, pixels - i);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl")))
+void upipe_v210_to_planar_8_avx512(const void *src, uint8_t *y, uint8_t *u, uint8_t *v, uintptr_t pixels)
+{
+    const uint8_t *s = src;
+    uintptr_t i;
+    for (i = 0; i + 24 <= pixels; i += 24) {
+        __m512i yy, uu, vv;
+        v210dec_unpack_avx512(s, &yy, &uu, &vv);
+        _mm256_mask_storeu_epi8(y + i, 0xffffff,
+                _mm512_cvtepi16_epi8(_mm512_srli_epi16(yy, 2)));
+        _mm256_mask_storeu_epi8(u + i / 2, 0xfff,
+                _mm512_cvtepi16_epi8(_mm512_srli_epi16(uu, 2)));
+        _mm256_mask_storeu_epi8(v + i / 2, 0xfff,
+                _mm512_cvtepi16_epi8(_mm512_srli_epi16(vv, 2)));
+        s += 64;
+    }
+    if (pixels - i >= 6)
+        upipe_v210_to_planar_8_c(s, y + i, u + i / 2, v + i / 2, pixels - i);
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/* vld4q_u32 deinterleaves the 4 words of 4 groups. In each group:
+ * word 0 is U0 Y0 V0, word 1 is Y1 U1 Y2, word 2 is V1 Y3 U2 and word 3 is
+ * Y4 V2 Y5, from the least significant bits. */
+#define V210DEC_C(w, shift, mask) vandq_u32(vshrq_n_u32(w, shift), mask)
+
+void upipe_v210_to_planar_10_neon(const void *src, uint16_t *y, uint16_t *u, uint16_t *v, uintptr_t pixels)
+{
+    const uint32_t *s = src;
+    const uint32x4_t mask = vdupq_n_u32(0x3ff);
+    uintptr_t i;
+    for (i = 0; i + 24 <= pixels; i += 24) {
+        uint32x4x4_t w = vld4q_u32(s);
+        uint16x4x3_t uu, vv;
+        uu.val[0] = vmovn_u32(vandq_u32(w.val[0], mask));
+        uu.val[1] = vmovn_u32(V210DEC_C(w.val[1], 10, mask));
+        uu.val[2] = vmovn_u32(V210DEC_C(w.val[2], 20, mask));
+        vv.val[0] = vmovn_u32(V210DEC_C(w.val[0], 20, mask));
+        vv.val[1] = vmovn_u32(vandq_u32(w.val[2], mask));
+        vv.val[2] = vmovn_u32(V210DEC_C(w.val[3], 10, mask));
+        vst3_u16(u + i / 2, uu);
+        vst3_u16(v + i / 2, vv);
+
+        /* pairs of luma components */
+        uint32x4x3_t yy;
+        yy.val[0] = vorrq_u32(V210DEC_C(w.val[0], 10, mask),
+                vshlq_n_u32(vandq_u32(w.val[1], mask), 16));
+        yy.val[1] = vorrq_u32(V210DEC_C(w.val[1], 20, mask),
+                vshlq_n_u32(V210DEC_C(w.val[2], 10, mask), 16));
+        yy.val[2] = vorrq_u32(vandq_u32(w.val[3], mask),
+                vshlq_n_u32(V210DEC_C(w.val[3], 20, mask), 16));
+        vst3q_u32((uint32_t *)(y + i), yy);
+        s += 16;
+    }
+    if (pixels - i >= 6)
+        upipe_v210_to_planar_10_c(s, y + i, u + i / 2, v + i / 2, pixels - i);
+}
+
+/** @internal @This narrows the components of 8 groups to 8 bits. */
+#define V210DEC_C8(w0, w1, shift, mask)                                     \
+    vmovn_u16(vcombine_u16(vmovn_u32(V210DEC_C(w0, shift, mask)),           \
+                           vmovn_u32(V210DEC_C(w1, shift, mask))))
+
+/** @internal @This builds pairs of 8-bit luma components of 8 groups. */
+#define V210DEC_Y8(w0, w1, a, sa, b, sb, mask)                              \
+    vcombine_u16(                                                           \
+        vmovn_u32(vorrq_u32(V210DEC_C(w0.val[a], sa, mask),                 \
+                  vshlq_n_u32(V210DEC_C(w0.val[b], sb, mask), 8))),         \
+        vmovn_u32(vorrq_u32(V210DEC_C(w1.val[a], sa, mask),                 \
+                  vshlq_n_u32(V210DEC_C(w1.val[b], sb, mask), 8))))
+
+void upipe_v210_to_planar_8_neon(const void *src, uint8_t *y, uint8_t *u, uint8_t *v, uintptr_t pixels)
+{
+    const uint32_t *s = src;
+    const uint32x4_t mask = vdupq_n_u32(0xff);
+    uintptr_t i;
+    for (i = 0; i + 48 <= pixels; i += 48) {
+        uint32x4x4_t w0 = vld4q_u32(s);
+        uint32x4x4_t w1 = vld4q_u32(s + 16);
+        uint8x8x3_t uu, vv;
+        uu.val[0] = V210DEC_C8(w0.val[0], w1.val[0], 2, mask);
+        uu.val[1] = V210DEC_C8(w0.val[1], w1.val[1], 12, mask);
+        uu.val[2] = V210DEC_C8(w0.val[2], w1.val[2], 22, mask);
+        vv.val[0] = V210DEC_C8(w0.val[0], w1.val[0], 22, mask);
+        vv.val[1] = V210DEC_C8(w0.val[2], w1.val[2], 2, mask);
+        vv.val[2] = V210DEC_C8(w0.val[3], w1.val[3], 12, mask);
+        vst3_u8(u + i / 2, uu);
+        vst3_u8(v + i / 2, vv);
+
+        uint16x8x3_t yy;
+        yy.val[0] = V210DEC_Y8(w0, w1, 0, 12, 1, 2, mask);
+        yy.val[1] = V210DEC_Y8(w0, w1, 1, 22, 2, 12, mask);
+        yy.val[2] = V210DEC_Y8(w0, w1, 3, 2, 3, 22, mask);
+        vst3q_u16((uint16_t *)(y + i), yy);
+        s += 32;
+    }
+    if (pixels - i >= 6)
+        upipe_v210_to_planar_8_c(s, y + i, u + i / 2, v + i / 2, pixels - i);
+}
+#endif
@@ -10,3 +10,15 @@ void upipe_v210_to_planar_10_aligned_avx2 (const void *src, uint16_t *y, uint16_
 void upipe_v210_to_planar_8_aligned_ssse3(const void *src, uint8_t *y, uint8_t *u, uint8_t *v, uintptr_t pixels);
 void upipe_v210_to_planar_8_aligned_avx  (const void *src, uint8_t *y, uint8_t *u, uint8_t *v, uintptr_t pixels);
 void upipe_v210_to_planar_8_aligned_avx2 (const void *src, uint8_t *y, uint8_t *u, uint8_t *v, uintptr_t pixels);
+
+#if defined(__i686__) || defined(__x86_64__)
+/* process 24 pixels per iteration, requires AVX-512 BW and VL */
+void upipe_v210_to_planar_10_avx512(const void *src, uint16_t *y, uint16_t *u, uint16_t *v, uintptr_t pixels);
+void upipe_v210_to_planar_8_avx512 (const void *src, uint8_t *y, uint8_t *u, uint8_t *v, uintptr_t pixels);
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/* process 24 (10-bit) or 48 (8-bit) pixels per iteration */
+void upipe_v210_to_planar_10_neon(const void *src, uint16_t *y, uint16_t *u, uint16_t *v, uintptr_t pixels);
+void upipe_v210_to_planar_8_neon (const void *src, uint8_t *y, uint8_t *u, uint8_t *v, uintptr_t pixels);
+#endif
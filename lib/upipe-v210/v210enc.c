@@ -30,6 +30,12 @@
 #include <upipe-v210/upipe_v210enc.h>
 #include "v210enc.h"
 
+#if defined(__i686__) || defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #define CLIP(v) ubase_clip(v, 4, 1019)
 #define CLIP8(v) ubase_clip(v, 1, 254)
 
@@ -91,3 +97,189 @@ void upipe_planar_to_v210_10_c(const uint16_t *y, const uint16_t *u,
         WRITE_PIXELS(y, v, y);
     }
 }
+
+/* The vector variants below process 4 or 8 groups of 6 pixels (16 octets)
+ * per iteration, and leave the remaining pixels to the C version, so that
+ * they don't read past the given number of pixels. */
+
+#if defined(__i686__) || defined(__x86_64__)
+/* The first, second and third components of the 16 words of 4 groups are
+ * picked from a table of 64 words: 24 luma components, 8 unused, 12 Cb
+ * components, 4 unused, and 12 Cr components. */
+static const uint16_t v210enc_avx512_c01[32] = {
+    /* first components */
+    32,  1, 49,  4, 35,  7, 52, 10, 38, 13, 55, 16, 41, 19, 58, 22,
+    /* second components */
+     0, 33,  3, 50,  6, 36,  9, 53, 12, 39, 15, 56, 18, 42, 21, 59,
+};
+static const uint16_t v210enc_avx512_c2[32] = {
+    48,  2, 34,  5, 51,  8, 37, 11, 54, 14, 40, 17, 57, 20, 43, 23,
+};
+
+/** @internal @This packs 24 pixels of clipped 10-bit components.
+ *
+ * @param yy 24 luma components
+ * @param uu 12 Cb components
+ * @param vv 12 Cr components
+ * @param dst v210 destination (64 octets)
+ */
+__attribute__((target("avx512f,avx512bw,avx512vl")))
+static inline void v210enc_pack_avx512(__m512i yy, __m256i uu, __m256i vv,
+                                       uint8_t *dst)
+{
+    __m512i uv = _mm512_inserti64x4(_mm512_castsi256_si512(uu), vv, 1);
+    __m512i c01 = _mm512_permutex2var_epi16(yy,
+            _mm512_loadu_si512(v210enc_avx512_c01), uv);
+    __m512i c2 = _mm512_permutex2var_epi16(yy,
+            _mm512_loadu_si512(v210enc_avx512_c2), uv);
+    __m512i w = _mm512_cvtepu16_epi32(_mm512_castsi512_si256(c01));
+    w = _mm512_or_si512(w, _mm512_slli_epi32(
+                _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(c01, 1)), 10));
+    w = _mm512_or_si512(w, _mm512_slli_epi32(
+                _mm512_cvtepu16_epi32(_mm512_castsi512_si256(c2)), 20));
+    _mm512_storeu_si512(dst, w);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl")))
+void upipe_planar_to_v210_10_avx512(const uint16_t *y, const uint16_t *u,
+                                    const uint16_t *v, uint8_t *dst, ptrdiff_t pixels)
+{
+    const __m512i min = _mm512_set1_epi16(4);
+    const __m512i max = _mm512_set1_epi16(1019);
+    ptrdiff_t i;
+    for (i = 0; i + 24 <= pixels; i += 24) {
+        __m512i yy = _mm512_maskz_loadu_epi16(0xffffff, y + i);
+        __m256i uu = _mm256_maskz_loadu_epi16(0xfff, u + i / 2);
+        __m256i vv = _mm256_maskz_loadu_epi16(0xfff, v + i / 2);
+        yy = _mm512_min_epu16(_mm512_max_epu16(yy, min), max);
+        uu = _mm256_min_epu16(_mm256_max_epu16(uu, _mm512_castsi512_si256(min)),
+                              _mm512_castsi512_si256(max));
+        vv = _mm256_min_epu16(_mm256_max_epu16(vv, _mm512_castsi512_si256(min)),
+                              _mm512_castsi512_si256(max));
+        v210enc_pack_avx512(yy, uu, vv, dst);
+        dst += 64;
+    }
+    upipe_planar_to_v210_10_c(y + i, u + i / 2, v + i / 2, dst, pixels - i);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl")))
+void upipe_planar_to_v210_8_avx512(const uint8_t *y, const uint8_t *u,
+                                   const uint8_t *v, uint8_t *dst, ptrdiff_t pixels)
+{
+    const __m256i min = _mm256_set1_epi8(1);
+    const __m256i max = _mm256_set1_epi8(254);
+    ptrdiff_t i;
+    for (i = 0; i + 24 <= pixels; i += 24) {
+        __m256i y8 = _mm256_maskz_loadu_epi8(0xffffff, y + i);
+        __m128i u8 = _mm_maskz_loadu_epi8(0xfff, u + i / 2);
+        __m128i v8 = _mm_maskz_loadu_epi8(0xfff, v + i / 2);
+        y8 = _mm256_min_epu8(_mm256_max_epu8(y8, min), max);
+        u8 = _mm_min_epu8(_mm_max_epu8(u8, _mm256_castsi256_si128(min)),
+                          _mm256_castsi256_si128(max));
+        v8 = _mm_min_epu8(_mm_max_epu8(v8, _mm256_castsi256_si128(min)),
+                          _mm256_castsi256_si128(max));
+        v210enc_pack_avx512(_mm512_slli_epi16(_mm512_cvtepu8_epi16(y8), 2),
+                            _mm256_slli_epi16(_mm256_cvtepu8_epi16(u8), 2),
+                            _mm256_slli_epi16(_mm256_cvtepu8_epi16(v8), 2),
+                            dst);
+        dst += 64;
+    }
+    upipe_planar_to_v210_8_c(y + i, u + i / 2, v + i / 2, dst, pixels - i);
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/* vst4q_u32 interleaves the 4 words of 4 groups. In each group:
+ * word 0 is U0 Y0 V0, word 1 is Y1 U1 Y2, word 2 is V1 Y3 U2 and word 3 is
+ * Y4 V2 Y5, from the least significant bits. */
+#define V210ENC_W(c0, c1, c2)                                               \
+    vorrq_u32(vorrq_u32(c0, vshlq_n_u32(c1, 10)), vshlq_n_u32(c2, 20))
+
+void upipe_planar_to_v210_10_neon(const uint16_t *y, const uint16_t *u,
+                                  const uint16_t *v, uint8_t *dst, ptrdiff_t pixels)
+{
+    const uint16x8_t min = vdupq_n_u16(4);
+    const uint16x8_t max = vdupq_n_u16(1019);
+    const uint32x4_t mask = vdupq_n_u32(0xffff);
+    ptrdiff_t i;
+    for (i = 0; i + 24 <= pixels; i += 24) {
+        /* pairs of luma components */
+        uint32x4x3_t yy = vld3q_u32((const uint32_t *)(y + i));
+        uint16x4x3_t uu = vld3_u16(u + i / 2);
+        uint16x4x3_t vv = vld3_u16(v + i / 2);
+        uint32x4_t yc[6], uc[3], vc[3];
+        for (int j = 0; j < 3; j++) {
+            uint32x4_t pair = vreinterpretq_u32_u16(vminq_u16(vmaxq_u16(
+                        vreinterpretq_u16_u32(yy.val[j]), min), max));
+            yc[2 * j] = vandq_u32(pair, mask);
+            yc[2 * j + 1] = vshrq_n_u32(pair, 16);
+            uc[j] = vmovl_u16(vmin_u16(vmax_u16(uu.val[j], vget_low_u16(min)),
+                                       vget_low_u16(max)));
+            vc[j] = vmovl_u16(vmin_u16(vmax_u16(vv.val[j], vget_low_u16(min)),
+                                       vget_low_u16(max)));
+        }
+
+        uint32x4x4_t w;
+        w.val[0] = V210ENC_W(uc[0], yc[0], vc[0]);
+        w.val[1] = V210ENC_W(yc[1], uc[1], yc[2]);
+        w.val[2] = V210ENC_W(vc[1], yc[3], uc[2]);
+        w.val[3] = V210ENC_W(yc[4], vc[2], yc[5]);
+        vst4q_u32((uint32_t *)dst, w);
+        dst += 64;
+    }
+    upipe_planar_to_v210_10_c(y + i, u + i / 2, v + i / 2, dst, pixels - i);
+}
+
+void upipe_planar_to_v210_8_neon(const uint8_t *y, const uint8_t *u,
+                                 const uint8_t *v, uint8_t *dst, ptrdiff_t pixels)
+{
+    const uint8x16_t min = vdupq_n_u8(1);
+    const uint8x16_t max = vdupq_n_u8(254);
+    const uint16x8_t mask = vdupq_n_u16(0xff);
+    ptrdiff_t i;
+    for (i = 0; i + 48 <= pixels; i += 48) {
+        /* pairs of luma components */
+        uint16x8x3_t yy = vld3q_u16((const uint16_t *)(y + i));
+        uint8x8x3_t uu = vld3_u8(u + i / 2);
+        uint8x8x3_t vv = vld3_u8(v + i / 2);
+        uint16x8_t yc[6], uc[3], vc[3];
+        for (int j = 0; j < 3; j++) {
+            uint16x8_t pair = vreinterpretq_u16_u8(vminq_u8(vmaxq_u8(
+                        vreinterpretq_u8_u16(yy.val[j]), min), max));
+            yc[2 * j] = vshlq_n_u16(vandq_u16(pair, mask), 2);
+            yc[2 * j + 1] = vshlq_n_u16(vshrq_n_u16(pair, 8), 2);
+            uc[j] = vshll_n_u8(vmin_u8(vmax_u8(uu.val[j], vget_low_u8(min)),
+                                       vget_low_u8(max)), 2);
+            vc[j] = vshll_n_u8(vmin_u8(vmax_u8(vv.val[j], vget_low_u8(min)),
+                                       vget_low_u8(max)), 2);
+        }
+
+        /* first 4 groups, then last 4 groups */
+        uint32x4x4_t w;
+        w.val[0] = V210ENC_W(vmovl_u16(vget_low_u16(uc[0])),
+                             vmovl_u16(vget_low_u16(yc[0])),
+                             vmovl_u16(vget_low_u16(vc[0])));
+        w.val[1] = V210ENC_W(vmovl_u16(vget_low_u16(yc[1])),
+                             vmovl_u16(vget_low_u16(uc[1])),
+                             vmovl_u16(vget_low_u16(yc[2])));
+        w.val[2] = V210ENC_W(vmovl_u16(vget_low_u16(vc[1])),
+                             vmovl_u16(vget_low_u16(yc[3])),
+                             vmovl_u16(vget_low_u16(uc[2])));
+        w.val[3] = V210ENC_W(vmovl_u16(vget_low_u16(yc[4])),
+                             vmovl_u16(vget_low_u16(vc[2])),
+                             vmovl_u16(vget_low_u16(yc[5])));
+        vst4q_u32((uint32_t *)dst, w);
+        w.val[0] = V210ENC_W(vmovl_high_u16(uc[0]), vmovl_high_u16(yc[0]),
+                             vmovl_high_u16(vc[0]));
+        w.val[1] = V210ENC_W(vmovl_high_u16(yc[1]), vmovl_high_u16(uc[1]),
+                             vmovl_high_u16(yc[2]));
+        w.val[2] = V210ENC_W(vmovl_high_u16(vc[1]), vmovl_high_u16(yc[3]),
+                             vmovl_high_u16(uc[2]));
+        w.val[3] = V210ENC_W(vmovl_high_u16(yc[4]), vmovl_high_u16(vc[2]),
+                             vmovl_high_u16(yc[5]));
+        vst4q_u32((uint32_t *)(dst + 64), w);
+        dst += 128;
+    }
+    upipe_planar_to_v210_8_c(y + i, u + i / 2, v + i / 2, dst, pixels - i);
+}
+#endif
@@ -13,3 +13,19 @@ void upipe_planar_to_v210_8_avx(const uint8_t *y, const uint8_t *u,
                                   const uint8_t *v, uint8_t *dst, ptrdiff_t pixels);
 void upipe_planar_to_v210_8_avx2(const uint8_t *y, const uint8_t *u,
                                    const uint8_t *v, uint8_t *dst, ptrdiff_t pixels);
+
+#if defined(__i686__) || defined(__x86_64__)
+/* process 24 pixels per iteration, requires AVX-512 BW and VL */
+void upipe_planar_to_v210_10_avx512(const uint16_t *y, const uint16_t *u,
+                                    const uint16_t *v, uint8_t *dst, ptrdiff_t pixels);
+void upipe_planar_to_v210_8_avx512(const uint8_t *y, const uint8_t *u,
+                                   const uint8_t *v, uint8_t *dst, ptrdiff_t pixels);
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/* process 24 (10-bit) or 48 (8-bit) pixels per iteration */
+void upipe_planar_to_v210_10_neon(const uint16_t *y, const uint16_t *u,
+                                  const uint16_t *v, uint8_t *dst, ptrdiff_t pixels);
+void upipe_planar_to_v210_8_neon(const uint8_t *y, const uint8_t *u,
+                                 const uint8_t *v, uint8_t *dst, ptrdiff_t pixels);
+#endif
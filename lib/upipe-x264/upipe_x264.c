@@ -61,6 +61,7 @@
 #include <upipe-framers/uref_h264.h>
 #include <upipe-framers/uref_mpgv.h>
 #include <upipe-framers/upipe_h26x_common.h>
+#include <upipe-filters/upipe_scene_analysis.h>
 
 #include <stdlib.h>
 #include <strings.h>
@@ -93,6 +94,8 @@ struct upipe_x264 {
     uint64_t sc_latency;
     /** true if the existing slice types must be enforced */
     bool slice_type_enforce;
+    /** true if the scene analysis decisions must be enforced */
+    bool scene_enforce;
 
     /** x264 "PTS" */
     uint64_t x264_ts;
@@ -367,6 +370,21 @@ static int _upipe_x264_set_slice_type_enforce(struct upipe *upipe, bool enforce)
     return UBASE_ERR_NONE;
 }
 
+/** @This sets the scene analysis enforcement mode (true or false).
+ *
+ * @param upipe description structure of the pipe
+ * @param enforce true if the scene analysis decisions must be enforced
+ * @return an error code
+ */
+static int _upipe_x264_set_scene_enforce(struct upipe *upipe, bool enforce)
+{
+    struct upipe_x264 *upipe_x264 = upipe_x264_from_upipe(upipe);
+    upipe_x264->scene_enforce = enforce;
+    upipe_dbg_va(upipe, "%sactivating scene analysis enforcement",
+                 enforce ? "" : "de");
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This allocates a filter pipe.
  *
  * @param mgr common management structure
@@ -391,6 +409,7 @@ static struct upipe *upipe_x264_alloc(struct upipe_mgr *mgr,
     upipe_x264->initial_latency = 0;
     upipe_x264->sc_latency = 0;
     upipe_x264->slice_type_enforce = false;
+    upipe_x264->scene_enforce = false;
     upipe_x264->x264_ts = 0;
 
     upipe_x264_init_urefcount(upipe);
@@ -488,6 +507,15 @@ static bool upipe_x264_open(struct upipe *upipe, int width, int height)
         upipe_err_va(upipe, "can't set option %s:%s (%d)",
                      "colormatrix", content, ret);
 
+    if (upipe_x264->scene_enforce) {
+        /* keyframes and lookahead are decided upstream */
+        params->i_scenecut_threshold = 0;
+        params->i_keyint_max = X264_KEYINT_MAX_INFINITE;
+        params->i_bframe_adaptive = X264_B_ADAPT_NONE;
+        params->rc.b_mb_tree = 0;
+        params->rc.i_lookahead = 0;
+    }
+
     /* reconfigure encoder with new parameters and return */
     if (unlikely(upipe_x264->encoder)) {
         if (!ubase_check(_upipe_x264_reconfigure(upipe)))
@@ -735,6 +763,24 @@ static inline bool upipe_x264_need_update(struct upipe *upipe,
             params->vui.i_overscan != upipe_x264->overscan);
 }
 
+/** @internal @This throws an event with the state of the encoder, when an
+ * encoded frame is output.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref output frame
+ */
+static void upipe_x264_throw_stats(struct upipe *upipe, struct uref *uref)
+{
+    struct upipe_x264 *upipe_x264 = upipe_x264_from_upipe(upipe);
+    int delayed = x264_encoder_delayed_frames(upipe_x264->encoder);
+    uint64_t pts = UINT64_MAX, latency = 0;
+    if (ubase_check(uref_clock_get_pts_prog(uref, &pts)) &&
+        upipe_x264->input_pts != UINT64_MAX && upipe_x264->input_pts > pts)
+        latency = upipe_x264->input_pts - pts;
+    upipe_throw(upipe, UPROBE_X264_STATS, UPIPE_X264_SIGNATURE,
+                delayed > 0 ? (unsigned int)delayed : 0, latency);
+}
+
 /** @internal @This processes pictures.
  *
  * @param upipe description structure of the pipe
@@ -896,6 +942,23 @@ static bool upipe_x264_handle(struct upipe *upipe, struct uref *uref,
         }
         pic.img.i_plane = i;
 
+        if (upipe_x264->scene_enforce) {
+            int64_t qp_offset;
+            if (ubase_check(uref_scene_get_key(uref)))
+                pic.i_type = X264_TYPE_IDR;
+            if (ubase_check(uref_scene_get_qp_offset(uref, &qp_offset))) {
+                size_t mbs = ((curparams.i_width + 15) / 16) *
+                             ((curparams.i_height + 15) / 16);
+                float *offsets = malloc(mbs * sizeof(float));
+                if (offsets != NULL) {
+                    for (size_t j = 0; j < mbs; j++)
+                        offsets[j] = qp_offset;
+                    pic.prop.quant_offsets = offsets;
+                    pic.prop.quant_offsets_free = free;
+                }
+            }
+        }
+
         /* encode frame ! */
         ret = x264_encoder_encode(upipe_x264->encoder,
                                   &nals, &nals_num, &pic, &pic);
@@ -925,6 +988,7 @@ static bool upipe_x264_handle(struct upipe *upipe, struct uref *uref,
     /* get uref back */
     uref = pic.opaque;
     assert(uref);
+    upipe_x264_throw_stats(upipe, uref);
 
     for (i = 0; i < nals_num; i++) {
         size += nals[i].i_payload;
@@ -1059,6 +1123,48 @@ static void upipe_x264_input(struct upipe *upipe, struct uref *uref,
     }
 }
 
+/** @internal @This applies the octetrate suggested by a flow format, for
+ * instance by a statistical multiplexer. Only streams encoded with a target
+ * bitrate are affected.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return true if the bitrate was changed
+ */
+static bool upipe_x264_apply_octetrate(struct upipe *upipe,
+                                       struct uref *flow_format)
+{
+    struct upipe_x264 *upipe_x264 = upipe_x264_from_upipe(upipe);
+    x264_param_t *params = &upipe_x264->params;
+    uint64_t octetrate;
+    if (!ubase_check(uref_block_flow_get_octetrate(flow_format, &octetrate)) ||
+        params->rc.i_rc_method != X264_RC_ABR || params->rc.i_bitrate <= 0)
+        return false;
+
+    int bitrate = octetrate / 125;
+    if (bitrate <= 0 || bitrate == params->rc.i_bitrate)
+        return false;
+
+    int old_bitrate = params->rc.i_bitrate;
+    int old_max_bitrate = params->rc.i_vbv_max_bitrate;
+    if (params->rc.i_vbv_max_bitrate > 0)
+        params->rc.i_vbv_max_bitrate = (int64_t)params->rc.i_vbv_max_bitrate *
+                                       bitrate / params->rc.i_bitrate;
+    params->rc.i_bitrate = bitrate;
+    if (!ubase_check(_upipe_x264_reconfigure(upipe))) {
+        upipe_warn_va(upipe, "unable to switch to %d kbits/s", bitrate);
+        params->rc.i_bitrate = old_bitrate;
+        params->rc.i_vbv_max_bitrate = old_max_bitrate;
+        return false;
+    }
+    upipe_dbg_va(upipe, "switched to %d kbits/s", bitrate);
+
+    if (upipe_x264->flow_def_attr != NULL)
+        uref_block_flow_set_octetrate(upipe_x264->flow_def_attr,
+                                      (uint64_t)bitrate * 125);
+    return true;
+}
+
 /** @internal @This receives the result of a flow format request.
  *
  * @param upipe description structure of the pipe
@@ -1072,9 +1178,26 @@ static int upipe_x264_check_flow_format(struct upipe *upipe,
     if (flow_format == NULL)
         return UBASE_ERR_INVALID;
 
-    upipe_x264->headers_requested =
-        ubase_check(uref_flow_get_global(flow_format));
-    upipe_x264->encaps_requested = uref_h26x_flow_infer_encaps(flow_format);
+    bool rate_changed = upipe_x264_apply_octetrate(upipe, flow_format);
+    bool headers_requested = ubase_check(uref_flow_get_global(flow_format));
+    enum uref_h26x_encaps encaps_requested =
+        uref_h26x_flow_infer_encaps(flow_format);
+    if (upipe_x264->ubuf_mgr != NULL &&
+        upipe_x264->flow_def_requested != NULL &&
+        upipe_x264->headers_requested == headers_requested &&
+        upipe_x264->encaps_requested == encaps_requested) {
+        /* only the octetrate may have changed, keep the ubuf manager */
+        if (rate_changed) {
+            uref_block_flow_set_octetrate(upipe_x264->flow_def_requested,
+                    (uint64_t)upipe_x264->params.rc.i_bitrate * 125);
+            upipe_x264_store_flow_def(upipe, NULL);
+        }
+        uref_free(flow_format);
+        return UBASE_ERR_NONE;
+    }
+
+    upipe_x264->headers_requested = headers_requested;
+    upipe_x264->encaps_requested = encaps_requested;
     bool annexb = upipe_x264->encaps_requested == UREF_H26X_ENCAPS_ANNEXB;
     if (upipe_x264->params.b_annexb != annexb) {
         upipe_x264->params.b_annexb = annexb;
@@ -1299,6 +1422,11 @@ static int upipe_x264_control(struct upipe *upipe, int command, va_list args)
             bool enforce = !(va_arg(args, int) == 0);
             return _upipe_x264_set_slice_type_enforce(upipe, enforce);
         }
+        case UPIPE_X264_SET_SCENE_ENFORCE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_X264_SIGNATURE)
+            bool enforce = !(va_arg(args, int) == 0);
+            return _upipe_x264_set_scene_enforce(upipe, enforce);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
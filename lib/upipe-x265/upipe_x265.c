@@ -61,6 +61,7 @@
 #include <upipe-framers/uref_h265.h>
 #include <upipe-framers/uref_mpgv.h>
 #include <upipe-framers/upipe_h26x_common.h>
+#include <upipe-filters/upipe_scene_analysis.h>
 
 #include <stdlib.h>
 #include <strings.h>
@@ -101,10 +102,14 @@ struct upipe_x265 {
     uint64_t input_latency;
     /** buffered frames count */
     int latency_frames;
+    /** number of pictures queued in the encoder */
+    unsigned int nb_pending;
     /** supposed latency of the packets when leaving the encoder */
     uint64_t initial_latency;
     /** true if the existing slice types must be enforced */
     bool slice_type_enforce;
+    /** true if the scene analysis decisions must be enforced */
+    bool scene_enforce;
     /** true if delayed frames are available */
     bool delayed_frames;
 
@@ -348,6 +353,21 @@ static int _upipe_x265_set_slice_type_enforce(struct upipe *upipe, bool enforce)
     return UBASE_ERR_NONE;
 }
 
+/** @This sets the scene analysis enforcement mode (true or false).
+ *
+ * @param upipe description structure of the pipe
+ * @param enforce true if the scene analysis decisions must be enforced
+ * @return an error code
+ */
+static int _upipe_x265_set_scene_enforce(struct upipe *upipe, bool enforce)
+{
+    struct upipe_x265 *upipe_x265 = upipe_x265_from_upipe(upipe);
+    upipe_x265->scene_enforce = enforce;
+    upipe_dbg_va(upipe, "%sactivating scene analysis enforcement",
+                 enforce ? "" : "de");
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This allocates a filter pipe.
  *
  * @param mgr common management structure
@@ -371,9 +391,11 @@ static struct upipe *upipe_x265_alloc(struct upipe_mgr *mgr,
     _upipe_x265_set_default(upipe, 0);
     upipe_x265->input_latency = 0;
     upipe_x265->latency_frames = 3;
+    upipe_x265->nb_pending = 0;
     upipe_x265->initial_latency = 0;
     upipe_x265->sc_latency = 0;
     upipe_x265->slice_type_enforce = false;
+    upipe_x265->scene_enforce = false;
     upipe_x265->delayed_frames = true;
 
     upipe_x265_init_urefcount(upipe);
@@ -501,6 +523,16 @@ static bool upipe_x265_open(struct upipe *upipe, int width, int height)
     upipe_x265->height = height;
     apply_params(upipe);
 
+    if (upipe_x265->scene_enforce) {
+        /* keyframes and lookahead are decided upstream; a negative maximum
+         * interval means infinite */
+        params->scenecutThreshold = 0;
+        params->keyframeMax = -1;
+        params->bFrameAdaptive = X265_B_ADAPT_NONE;
+        params->rc.cuTree = 0;
+        params->lookaheadDepth = 0;
+    }
+
     /* reconfigure encoder with new parameters and return */
     if (unlikely(upipe_x265->encoder)) {
         if (!ubase_check(_upipe_x265_reconfigure(upipe)))
@@ -741,6 +773,23 @@ static void upipe_x265_get_aspect_ratio(struct upipe *upipe,
     upipe_x265->sar_height = sar.den;
 }
 
+/** @internal @This throws an event with the state of the encoder, when an
+ * encoded frame is output.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref output frame
+ */
+static void upipe_x265_throw_stats(struct upipe *upipe, struct uref *uref)
+{
+    struct upipe_x265 *upipe_x265 = upipe_x265_from_upipe(upipe);
+    uint64_t pts = UINT64_MAX, latency = 0;
+    if (ubase_check(uref_clock_get_pts_prog(uref, &pts)) &&
+        upipe_x265->input_pts != UINT64_MAX && upipe_x265->input_pts > pts)
+        latency = upipe_x265->input_pts - pts;
+    upipe_throw(upipe, UPROBE_X265_STATS, UPIPE_X265_SIGNATURE,
+                upipe_x265->nb_pending, latency);
+}
+
 /** @internal @This processes pictures.
  *
  * @param upipe description structure of the pipe
@@ -859,6 +908,10 @@ static bool upipe_x265_handle(struct upipe *upipe,
             }
         }
 
+        if (upipe_x265->scene_enforce &&
+            ubase_check(uref_scene_get_key(uref)))
+            pic.sliceType = X265_TYPE_IDR;
+
         /* map */
         for (i = 0; i < 3; i++) {
             size_t stride;
@@ -886,6 +939,8 @@ static bool upipe_x265_handle(struct upipe *upipe,
             uref_pic_plane_unmap(uref, chromas[i], 0, 0, -1, -1);
 
         ubuf_free(uref_detach_ubuf(uref));
+        if (likely(ret >= 0))
+            upipe_x265->nb_pending++;
 
         /* delayed frame, increase latency */
         if (unlikely(ret == 0))
@@ -913,6 +968,9 @@ static bool upipe_x265_handle(struct upipe *upipe,
     /* get uref back */
     uref = pic.userData;
     assert(uref);
+    if (upipe_x265->nb_pending)
+        upipe_x265->nb_pending--;
+    upipe_x265_throw_stats(upipe, uref);
 
     for (i = 0; i < nals_num; i++) {
         size += nals[i].sizeBytes;
@@ -1043,6 +1101,48 @@ static void upipe_x265_input(struct upipe *upipe, struct uref *uref,
     }
 }
 
+/** @internal @This applies the octetrate suggested by a flow format, for
+ * instance by a statistical multiplexer. Only streams encoded with a target
+ * bitrate are affected.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return true if the bitrate was changed
+ */
+static bool upipe_x265_apply_octetrate(struct upipe *upipe,
+                                       struct uref *flow_format)
+{
+    struct upipe_x265 *upipe_x265 = upipe_x265_from_upipe(upipe);
+    x265_param *params = &upipe_x265->params;
+    uint64_t octetrate;
+    if (!ubase_check(uref_block_flow_get_octetrate(flow_format, &octetrate)) ||
+        params->rc.rateControlMode != X265_RC_ABR || params->rc.bitrate <= 0)
+        return false;
+
+    int bitrate = octetrate / 125;
+    if (bitrate <= 0 || bitrate == params->rc.bitrate)
+        return false;
+
+    int old_bitrate = params->rc.bitrate;
+    int old_max_bitrate = params->rc.vbvMaxBitrate;
+    if (params->rc.vbvMaxBitrate > 0)
+        params->rc.vbvMaxBitrate = (int64_t)params->rc.vbvMaxBitrate *
+                                   bitrate / params->rc.bitrate;
+    params->rc.bitrate = bitrate;
+    if (!ubase_check(_upipe_x265_reconfigure(upipe))) {
+        upipe_warn_va(upipe, "unable to switch to %d kbits/s", bitrate);
+        params->rc.bitrate = old_bitrate;
+        params->rc.vbvMaxBitrate = old_max_bitrate;
+        return false;
+    }
+    upipe_dbg_va(upipe, "switched to %d kbits/s", bitrate);
+
+    if (upipe_x265->flow_def_attr != NULL)
+        uref_block_flow_set_octetrate(upipe_x265->flow_def_attr,
+                                      (uint64_t)bitrate * 125);
+    return true;
+}
+
 /** @internal @This receives the result of a flow format request.
  *
  * @param upipe description structure of the pipe
@@ -1056,9 +1156,26 @@ static int upipe_x265_check_flow_format(struct upipe *upipe,
     if (flow_format == NULL)
         return UBASE_ERR_INVALID;
 
-    upipe_x265->headers_requested =
-        ubase_check(uref_flow_get_global(flow_format));
-    upipe_x265->encaps_requested = uref_h26x_flow_infer_encaps(flow_format);
+    bool rate_changed = upipe_x265_apply_octetrate(upipe, flow_format);
+    bool headers_requested = ubase_check(uref_flow_get_global(flow_format));
+    enum uref_h26x_encaps encaps_requested =
+        uref_h26x_flow_infer_encaps(flow_format);
+    if (upipe_x265->ubuf_mgr != NULL &&
+        upipe_x265->flow_def_requested != NULL &&
+        upipe_x265->headers_requested == headers_requested &&
+        upipe_x265->encaps_requested == encaps_requested) {
+        /* only the octetrate may have changed, keep the ubuf manager */
+        if (rate_changed) {
+            uref_block_flow_set_octetrate(upipe_x265->flow_def_requested,
+                    (uint64_t)upipe_x265->params.rc.bitrate * 125);
+            upipe_x265_store_flow_def(upipe, NULL);
+        }
+        uref_free(flow_format);
+        return UBASE_ERR_NONE;
+    }
+
+    upipe_x265->headers_requested = headers_requested;
+    upipe_x265->encaps_requested = encaps_requested;
     bool annexb = upipe_x265->encaps_requested == UREF_H26X_ENCAPS_ANNEXB;
     if (upipe_x265->params.bAnnexB != annexb) {
         upipe_x265->params.bAnnexB = annexb;
@@ -1283,6 +1400,11 @@ static int upipe_x265_control(struct upipe *upipe, int command, va_list args)
             bool enforce = va_arg(args, int);
             return _upipe_x265_set_slice_type_enforce(upipe, enforce);
         }
+        case UPIPE_X265_SET_SCENE_ENFORCE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_X265_SIGNATURE)
+            bool enforce = va_arg(args, int);
+            return _upipe_x265_set_scene_enforce(upipe, enforce);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -0,0 +1,564 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe internal helpers for AF_XDP sockets
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uatomic.h>
+#include <upipe/urefcount.h>
+#include <upipe/umem.h>
+#include <upipe/upipe.h>
+
+#include "upipe_xdp.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <arpa/inet.h>
+#include <linux/bpf.h>
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+/** offset of the IPv4 header in an Ethernet frame */
+#define XDP_IP_OFFSET 14
+/** offset of the UDP header in an Ethernet frame without IP options */
+#define XDP_UDP_OFFSET (XDP_IP_OFFSET + 20)
+/** size of the Ethernet, IPv4 and UDP headers */
+#define XDP_HEADERS_SIZE (XDP_UDP_OFFSET + 8)
+/** maximum number of instructions of the XDP program */
+#define XDP_MAX_INSNS 32
+
+UBASE_FROM_TO(upipe_xdp_socket, urefcount, urefcount, urefcount)
+UBASE_FROM_TO(upipe_xdp_socket, umem_mgr, umem_mgr, umem_mgr)
+
+/** @internal @This calls the bpf system call.
+ *
+ * @param cmd command
+ * @param attr attributes of the command
+ * @return the result of the system call
+ */
+static int upipe_xdp_bpf(int cmd, union bpf_attr *attr)
+{
+    return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+/** @internal @This maps a ring shared with the kernel.
+ *
+ * @param xsk pointer to socket
+ * @param ring ring to map
+ * @param off offsets of the ring
+ * @param size number of descriptors
+ * @param desc_size size of a descriptor
+ * @param pgoff page offset of the ring
+ * @return false in case of error
+ */
+static bool upipe_xdp_ring_map(struct upipe_xdp_socket *xsk,
+                               struct upipe_xdp_ring *ring,
+                               const struct xdp_ring_offset *off,
+                               uint32_t size, size_t desc_size, off_t pgoff)
+{
+    ring->map_size = off->desc + size * desc_size;
+    ring->map = mmap(NULL, ring->map_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, xsk->fd, pgoff);
+    if (unlikely(ring->map == MAP_FAILED)) {
+        ring->map = NULL;
+        return false;
+    }
+    ring->producer = (uint32_t *)((uint8_t *)ring->map + off->producer);
+    ring->consumer = (uint32_t *)((uint8_t *)ring->map + off->consumer);
+    ring->flags = (uint32_t *)((uint8_t *)ring->map + off->flags);
+    ring->desc = (uint8_t *)ring->map + off->desc;
+    ring->mask = size - 1;
+    return true;
+}
+
+/** @internal @This unmaps a ring.
+ *
+ * @param ring ring to unmap
+ */
+static void upipe_xdp_ring_unmap(struct upipe_xdp_ring *ring)
+{
+    if (ring->map != NULL)
+        munmap(ring->map, ring->map_size);
+    ring->map = NULL;
+}
+
+/** @internal @This allocates a buffer which is not a UMEM frame, in case the
+ * ubuf manager wrapping the frames is asked for a new buffer.
+ *
+ * @param mgr pointer to umem manager
+ * @param umem caller-allocated structure
+ * @param size requested size of the umem
+ * @return false if the memory couldn't be allocated
+ */
+static bool upipe_xdp_umem_alloc(struct umem_mgr *mgr, struct umem *umem,
+                                 size_t size)
+{
+    umem->buffer = malloc(size);
+    if (unlikely(umem->buffer == NULL))
+        return false;
+    umem->mgr = mgr;
+    umem->size = umem->real_size = size;
+    umem_mgr_use(mgr);
+    return true;
+}
+
+/** @internal @This returns true if a buffer is a UMEM frame.
+ *
+ * @param umem pointer to umem
+ * @return true for a UMEM frame
+ */
+static bool upipe_xdp_umem_is_frame(struct umem *umem)
+{
+    struct upipe_xdp_socket *xsk =
+        upipe_xdp_socket_from_umem_mgr(umem->mgr);
+    return umem->buffer >= xsk->area &&
+           umem->buffer < xsk->area + xsk->area_size;
+}
+
+/** @internal @This resizes a buffer, which must not be a UMEM frame.
+ *
+ * @param umem pointer to umem
+ * @param new_size new requested size of the umem
+ * @return false if the memory couldn't be allocated
+ */
+static bool upipe_xdp_umem_realloc(struct umem *umem, size_t new_size)
+{
+    if (upipe_xdp_umem_is_frame(umem))
+        return false;
+    uint8_t *buffer = realloc(umem->buffer, new_size);
+    if (unlikely(buffer == NULL))
+        return false;
+    umem->buffer = buffer;
+    umem->size = umem->real_size = new_size;
+    return true;
+}
+
+/** @internal @This frees a buffer, putting UMEM frames back into the fill
+ * ring.
+ *
+ * @param umem pointer to umem
+ */
+static void upipe_xdp_umem_free(struct umem *umem)
+{
+    struct umem_mgr *mgr = umem->mgr;
+    struct upipe_xdp_socket *xsk = upipe_xdp_socket_from_umem_mgr(mgr);
+    if (upipe_xdp_umem_is_frame(umem))
+        upipe_xdp_socket_fill(xsk, umem->buffer - xsk->area);
+    else
+        free(umem->buffer);
+    umem->buffer = NULL;
+    umem_mgr_release(mgr);
+}
+
+/** @internal @This frees a socket.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void upipe_xdp_socket_free(struct urefcount *urefcount)
+{
+    struct upipe_xdp_socket *xsk = upipe_xdp_socket_from_urefcount(urefcount);
+    upipe_xdp_ring_unmap(&xsk->tx);
+    upipe_xdp_ring_unmap(&xsk->rx);
+    upipe_xdp_ring_unmap(&xsk->comp);
+    upipe_xdp_ring_unmap(&xsk->fill);
+    if (xsk->fd != -1)
+        close(xsk->fd);
+    if (xsk->area != NULL)
+        munmap(xsk->area, xsk->area_size);
+    uatomic_clean(&xsk->fill_lock);
+    urefcount_clean(urefcount);
+    free(xsk);
+}
+
+/** @This allocates an AF_XDP socket and its UMEM, and binds it to an
+ * interface queue.
+ *
+ * @param upipe description structure of the pipe, to log errors
+ * @param ifname name of the interface
+ * @param queue queue id
+ * @param rx true to create an rx ring and fill the UMEM with all frames
+ * @param tx true to create a tx ring
+ * @return pointer to the socket, or NULL in case of error
+ */
+struct upipe_xdp_socket *upipe_xdp_socket_alloc(struct upipe *upipe,
+                                                const char *ifname,
+                                                uint32_t queue,
+                                                bool rx, bool tx)
+{
+    struct upipe_xdp_socket *xsk = malloc(sizeof(struct upipe_xdp_socket));
+    if (unlikely(xsk == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
+    memset(xsk, 0, sizeof(struct upipe_xdp_socket));
+    urefcount_init(&xsk->urefcount, upipe_xdp_socket_free);
+    uatomic_init(&xsk->fill_lock, 0);
+    xsk->umem_mgr.refcount = &xsk->urefcount;
+    xsk->umem_mgr.umem_alloc = upipe_xdp_umem_alloc;
+    xsk->umem_mgr.umem_realloc = upipe_xdp_umem_realloc;
+    xsk->umem_mgr.umem_free = upipe_xdp_umem_free;
+    xsk->umem_mgr.umem_mgr_vacuum = NULL;
+    xsk->umem_mgr.umem_mgr_control = NULL;
+    xsk->fd = -1;
+    xsk->queue = queue;
+
+    xsk->ifindex = if_nametoindex(ifname);
+    if (unlikely(!xsk->ifindex)) {
+        upipe_err_va(upipe, "unknown interface %s", ifname);
+        goto upipe_xdp_socket_alloc_err;
+    }
+
+    xsk->area_size = (size_t)UPIPE_XDP_FRAME_SIZE * UPIPE_XDP_FRAMES;
+    xsk->area = mmap(NULL, xsk->area_size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (unlikely(xsk->area == MAP_FAILED)) {
+        xsk->area = NULL;
+        upipe_err_va(upipe, "can't allocate UMEM (%m)");
+        goto upipe_xdp_socket_alloc_err;
+    }
+
+    xsk->fd = socket(AF_XDP, SOCK_RAW | SOCK_CLOEXEC, 0);
+    if (unlikely(xsk->fd == -1)) {
+        upipe_err_va(upipe, "can't open AF_XDP socket (%m)");
+        goto upipe_xdp_socket_alloc_err;
+    }
+
+    struct xdp_umem_reg mr;
+    memset(&mr, 0, sizeof(mr));
+    mr.addr = (uintptr_t)xsk->area;
+    mr.len = xsk->area_size;
+    mr.chunk_size = UPIPE_XDP_FRAME_SIZE;
+    int umem_ring_size = UPIPE_XDP_UMEM_RING_SIZE;
+    int ring_size = UPIPE_XDP_RING_SIZE;
+    if (unlikely(setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_REG,
+                            &mr, sizeof(mr)) < 0 ||
+                 setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_FILL_RING,
+                            &umem_ring_size, sizeof(int)) < 0 ||
+                 setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING,
+                            &umem_ring_size, sizeof(int)) < 0 ||
+                 (rx && setsockopt(xsk->fd, SOL_XDP, XDP_RX_RING,
+                                   &ring_size, sizeof(int)) < 0) ||
+                 (tx && setsockopt(xsk->fd, SOL_XDP, XDP_TX_RING,
+                                   &ring_size, sizeof(int)) < 0))) {
+        upipe_err_va(upipe, "can't register UMEM (%m)");
+        goto upipe_xdp_socket_alloc_err;
+    }
+
+    struct xdp_mmap_offsets off;
+    socklen_t optlen = sizeof(off);
+    if (unlikely(getsockopt(xsk->fd, SOL_XDP, XDP_MMAP_OFFSETS,
+                            &off, &optlen) < 0 ||
+                 !upipe_xdp_ring_map(xsk, &xsk->fill, &off.fr,
+                                     UPIPE_XDP_UMEM_RING_SIZE,
+                                     sizeof(uint64_t),
+                                     XDP_UMEM_PGOFF_FILL_RING) ||
+                 !upipe_xdp_ring_map(xsk, &xsk->comp, &off.cr,
+                                     UPIPE_XDP_UMEM_RING_SIZE,
+                                     sizeof(uint64_t),
+                                     XDP_UMEM_PGOFF_COMPLETION_RING) ||
+                 (rx && !upipe_xdp_ring_map(xsk, &xsk->rx, &off.rx,
+                                            UPIPE_XDP_RING_SIZE,
+                                            sizeof(struct xdp_desc),
+                                            XDP_PGOFF_RX_RING)) ||
+                 (tx && !upipe_xdp_ring_map(xsk, &xsk->tx, &off.tx,
+                                            UPIPE_XDP_RING_SIZE,
+                                            sizeof(struct xdp_desc),
+                                            XDP_PGOFF_TX_RING)))) {
+        upipe_err_va(upipe, "can't map AF_XDP rings (%m)");
+        goto upipe_xdp_socket_alloc_err;
+    }
+
+    /* prefer zero-copy, and fall back to copy mode if the driver doesn't
+     * support it */
+    struct sockaddr_xdp sxdp;
+    memset(&sxdp, 0, sizeof(sxdp));
+    sxdp.sxdp_family = AF_XDP;
+    sxdp.sxdp_flags = XDP_ZEROCOPY;
+    sxdp.sxdp_ifindex = xsk->ifindex;
+    sxdp.sxdp_queue_id = queue;
+    xsk->zerocopy = true;
+    if (bind(xsk->fd, (struct sockaddr *)&sxdp, sizeof(sxdp)) < 0) {
+        sxdp.sxdp_flags = XDP_COPY;
+        xsk->zerocopy = false;
+        if (unlikely(bind(xsk->fd, (struct sockaddr *)&sxdp,
+                          sizeof(sxdp)) < 0)) {
+            upipe_err_va(upipe, "can't bind AF_XDP socket to %s queue %"PRIu32
+                         " (%m)", ifname, queue);
+            goto upipe_xdp_socket_alloc_err;
+        }
+    }
+
+    if (rx) {
+        for (uint32_t i = 0; i < UPIPE_XDP_FRAMES; i++)
+            *upipe_xdp_ring_addr(&xsk->fill, *xsk->fill.producer + i) =
+                (uint64_t)i * UPIPE_XDP_FRAME_SIZE;
+        upipe_xdp_ring_submit(&xsk->fill, UPIPE_XDP_FRAMES);
+    }
+    return xsk;
+
+upipe_xdp_socket_alloc_err:
+    upipe_xdp_socket_release(xsk);
+    return NULL;
+}
+
+/** @This gives a frame back to the kernel through the fill ring. It may be
+ * called from any thread.
+ *
+ * @param xsk pointer to socket
+ * @param addr UMEM address of the frame
+ */
+void upipe_xdp_socket_fill(struct upipe_xdp_socket *xsk, uint64_t addr)
+{
+    uint32_t expected = 0;
+    while (!uatomic_compare_exchange(&xsk->fill_lock, &expected, 1))
+        expected = 0;
+    *upipe_xdp_ring_addr(&xsk->fill, *xsk->fill.producer) =
+        addr & ~(uint64_t)(UPIPE_XDP_FRAME_SIZE - 1);
+    upipe_xdp_ring_submit(&xsk->fill, 1);
+    uatomic_store(&xsk->fill_lock, 0);
+}
+
+/** @internal @This builds an instruction of the XDP program. */
+#define XDP_INSN(CODE, DST, SRC, OFF, IMM)                                  \
+    ((struct bpf_insn){ .code = (CODE), .dst_reg = (DST), .src_reg = (SRC), \
+                        .off = (OFF), .imm = (IMM) })
+
+/** @This loads an XDP program redirecting the IPv4 UDP datagrams to the given
+ * address and port to the socket, and attaches it to the interface of the
+ * socket. Other packets are passed to the kernel stack.
+ *
+ * @param upipe description structure of the pipe, to log errors
+ * @param prog filled in with the program
+ * @param xsk pointer to socket
+ * @param addr destination address in network byte order, or INADDR_ANY
+ * @param port destination port in network byte order, or 0
+ * @return an error code
+ */
+int upipe_xdp_prog_attach(struct upipe *upipe, struct upipe_xdp_prog *prog,
+                          struct upipe_xdp_socket *xsk,
+                          in_addr_t addr, uint16_t port)
+{
+    prog->map_fd = prog->prog_fd = prog->link_fd = -1;
+
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = sizeof(uint32_t);
+    attr.max_entries = xsk->queue + 1;
+    prog->map_fd = upipe_xdp_bpf(BPF_MAP_CREATE, &attr);
+    if (unlikely(prog->map_fd < 0)) {
+        upipe_err_va(upipe, "can't create XDP socket map (%m)");
+        goto upipe_xdp_prog_attach_err;
+    }
+
+    uint32_t key = xsk->queue;
+    uint32_t value = xsk->fd;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = prog->map_fd;
+    attr.key = (uintptr_t)&key;
+    attr.value = (uintptr_t)&value;
+    attr.flags = BPF_ANY;
+    if (unlikely(upipe_xdp_bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0)) {
+        upipe_err_va(upipe, "can't add socket to XDP map (%m)");
+        goto upipe_xdp_prog_attach_err;
+    }
+
+    /* packet loads are done in host byte order, so the constants are the
+     * raw network byte order values; r2 points to the packet and r3 to its
+     * end, and every mismatch jumps to XDP_PASS */
+    struct bpf_insn insns[XDP_MAX_INSNS];
+    unsigned int pass[8];
+    unsigned int n = 0, nb_pass = 0;
+#define XDP_EMIT(insn) insns[n++] = (insn)
+#define XDP_EMIT_JNE(size, offset, value)                                   \
+    do {                                                                    \
+        XDP_EMIT(XDP_INSN(BPF_LDX | size | BPF_MEM, BPF_REG_5, BPF_REG_2,   \
+                          offset, 0));                                      \
+        pass[nb_pass++] = n;                                                \
+        XDP_EMIT(XDP_INSN(BPF_JMP32 | BPF_JNE | BPF_K, BPF_REG_5, 0, 0,     \
+                          value));                                          \
+    } while (0)
+
+    XDP_EMIT(XDP_INSN(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1,
+                      0, 0));
+    XDP_EMIT(XDP_INSN(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_2, BPF_REG_6,
+                      offsetof(struct xdp_md, data), 0));
+    XDP_EMIT(XDP_INSN(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_3, BPF_REG_6,
+                      offsetof(struct xdp_md, data_end), 0));
+    XDP_EMIT(XDP_INSN(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2,
+                      0, 0));
+    XDP_EMIT(XDP_INSN(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0,
+                      XDP_HEADERS_SIZE));
+    pass[nb_pass++] = n;
+    XDP_EMIT(XDP_INSN(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 0, 0));
+    /* IPv4 without options, UDP */
+    XDP_EMIT_JNE(BPF_H, 12, htons(0x0800));
+    XDP_EMIT_JNE(BPF_B, XDP_IP_OFFSET, 0x45);
+    XDP_EMIT_JNE(BPF_B, XDP_IP_OFFSET + 9, IPPROTO_UDP);
+    if (addr != INADDR_ANY)
+        XDP_EMIT_JNE(BPF_W, XDP_IP_OFFSET + 16, (int32_t)addr);
+    if (port)
+        XDP_EMIT_JNE(BPF_H, XDP_UDP_OFFSET + 2, port);
+    /* bpf_redirect_map(map, rx_queue_index, XDP_PASS) */
+    XDP_EMIT(XDP_INSN(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_2, BPF_REG_6,
+                      offsetof(struct xdp_md, rx_queue_index), 0));
+    XDP_EMIT(XDP_INSN(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1,
+                      BPF_PSEUDO_MAP_FD, 0, prog->map_fd));
+    XDP_EMIT(XDP_INSN(0, 0, 0, 0, 0));
+    XDP_EMIT(XDP_INSN(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0,
+                      XDP_PASS));
+    XDP_EMIT(XDP_INSN(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map));
+    XDP_EMIT(XDP_INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+    for (unsigned int i = 0; i < nb_pass; i++)
+        insns[pass[i]].off = n - (pass[i] + 1);
+    XDP_EMIT(XDP_INSN(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0,
+                      XDP_PASS));
+    XDP_EMIT(XDP_INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+#undef XDP_EMIT_JNE
+#undef XDP_EMIT
+
+    char log[4096];
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insns = (uintptr_t)insns;
+    attr.insn_cnt = n;
+    attr.license = (uintptr_t)"Dual MIT/GPL";
+    attr.log_buf = (uintptr_t)log;
+    attr.log_size = sizeof(log);
+    attr.log_level = 1;
+    log[0] = '\0';
+    prog->prog_fd = upipe_xdp_bpf(BPF_PROG_LOAD, &attr);
+    if (unlikely(prog->prog_fd < 0)) {
+        upipe_err_va(upipe, "can't load XDP program (%m): %s", log);
+        goto upipe_xdp_prog_attach_err;
+    }
+
+    memset(&attr, 0, sizeof(attr));
+    attr.link_create.prog_fd = prog->prog_fd;
+    attr.link_create.target_ifindex = xsk->ifindex;
+    attr.link_create.attach_type = BPF_XDP;
+    prog->link_fd = upipe_xdp_bpf(BPF_LINK_CREATE, &attr);
+    if (unlikely(prog->link_fd < 0)) {
+        upipe_err_va(upipe, "can't attach XDP program (%m)");
+        goto upipe_xdp_prog_attach_err;
+    }
+    return UBASE_ERR_NONE;
+
+upipe_xdp_prog_attach_err:
+    upipe_xdp_prog_detach(prog);
+    return UBASE_ERR_EXTERNAL;
+}
+
+/** @This detaches and unloads an XDP program.
+ *
+ * @param prog pointer to the program
+ */
+void upipe_xdp_prog_detach(struct upipe_xdp_prog *prog)
+{
+    if (prog->link_fd >= 0)
+        close(prog->link_fd);
+    if (prog->prog_fd >= 0)
+        close(prog->prog_fd);
+    if (prog->map_fd >= 0)
+        close(prog->map_fd);
+    prog->map_fd = prog->prog_fd = prog->link_fd = -1;
+}
+
+/** @This parses a uri of the form ifname[-queue][@address[:port]].
+ *
+ * @param upipe description structure of the pipe, to log errors
+ * @param uri uri to parse
+ * @param ifname filled in with the interface name
+ * @param queue_p filled in with the queue id (0 by default)
+ * @param addr_p filled in with the address in network byte order
+ * (INADDR_ANY by default)
+ * @param port_p filled in with the port in network byte order (0 by default)
+ * @return an error code
+ */
+int upipe_xdp_parse_uri(struct upipe *upipe, const char *uri,
+                        char ifname[IF_NAMESIZE], uint32_t *queue_p,
+                        in_addr_t *addr_p, uint16_t *port_p)
+{
+    *queue_p = 0;
+    *addr_p = INADDR_ANY;
+    *port_p = 0;
+
+    const char *at = strchr(uri, '@');
+    size_t len = at != NULL ? at - uri : strlen(uri);
+    size_t digits = 0;
+    while (digits < len && uri[len - digits - 1] >= '0' &&
+           uri[len - digits - 1] <= '9')
+        digits++;
+    if (digits && digits < len && uri[len - digits - 1] == '-') {
+        *queue_p = strtoul(uri + len - digits, NULL, 10);
+        len -= digits + 1;
+    }
+    if (unlikely(!len || len >= IF_NAMESIZE)) {
+        upipe_err_va(upipe, "invalid interface in uri %s", uri);
+        return UBASE_ERR_INVALID;
+    }
+    memcpy(ifname, uri, len);
+    ifname[len] = '\0';
+
+    if (at == NULL)
+        return UBASE_ERR_NONE;
+
+    char host[INET_ADDRSTRLEN];
+    const char *colon = strchr(at + 1, ':');
+    size_t host_len = colon != NULL ? colon - (at + 1) : strlen(at + 1);
+    struct in_addr in;
+    if (unlikely(host_len >= sizeof(host)))
+        goto upipe_xdp_parse_uri_err;
+    memcpy(host, at + 1, host_len);
+    host[host_len] = '\0';
+    if (unlikely(inet_pton(AF_INET, host, &in) != 1))
+        goto upipe_xdp_parse_uri_err;
+    *addr_p = in.s_addr;
+
+    if (colon != NULL) {
+        char *end;
+        unsigned long port = strtoul(colon + 1, &end, 10);
+        if (unlikely(*end || !port || port > UINT16_MAX))
+            goto upipe_xdp_parse_uri_err;
+        *port_p = htons(port);
+    }
+    return UBASE_ERR_NONE;
+
+upipe_xdp_parse_uri_err:
+    upipe_err_va(upipe, "invalid address in uri %s", uri);
+    return UBASE_ERR_INVALID;
+}
@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe internal helpers for AF_XDP sockets
+ */
+
+#ifndef _UPIPE_XDP_UPIPE_XDP_H_
+/** @hidden */
+#define _UPIPE_XDP_UPIPE_XDP_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+#include <upipe/uatomic.h>
+#include <upipe/urefcount.h>
+#include <upipe/umem.h>
+#include <upipe/upipe.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <netinet/in.h>
+#include <net/if.h>
+#include <linux/if_xdp.h>
+
+/** size of a UMEM frame (must be a power of 2) */
+#define UPIPE_XDP_FRAME_SIZE 2048
+/** number of UMEM frames */
+#define UPIPE_XDP_FRAMES 4096
+/** number of descriptors of the fill and completion rings */
+#define UPIPE_XDP_UMEM_RING_SIZE UPIPE_XDP_FRAMES
+/** number of descriptors of the rx and tx rings */
+#define UPIPE_XDP_RING_SIZE 2048
+
+/** @This is a ring shared with the kernel. */
+struct upipe_xdp_ring {
+    /** pointer to the producer index */
+    uint32_t *producer;
+    /** pointer to the consumer index */
+    uint32_t *consumer;
+    /** pointer to the flags */
+    uint32_t *flags;
+    /** pointer to the descriptors */
+    void *desc;
+    /** number of descriptors minus 1 */
+    uint32_t mask;
+    /** mapped area */
+    void *map;
+    /** size of the mapped area */
+    size_t map_size;
+};
+
+/** @This returns the number of entries available to a consumer.
+ *
+ * @param ring pointer to ring
+ * @return number of entries to read
+ */
+static inline uint32_t upipe_xdp_ring_avail(struct upipe_xdp_ring *ring)
+{
+    return __atomic_load_n(ring->producer, __ATOMIC_ACQUIRE) - *ring->consumer;
+}
+
+/** @This releases entries read by a consumer.
+ *
+ * @param ring pointer to ring
+ * @param nb number of entries
+ */
+static inline void upipe_xdp_ring_release(struct upipe_xdp_ring *ring,
+                                          uint32_t nb)
+{
+    __atomic_store_n(ring->consumer, *ring->consumer + nb, __ATOMIC_RELEASE);
+}
+
+/** @This returns the number of free entries for a producer.
+ *
+ * @param ring pointer to ring
+ * @return number of entries to write
+ */
+static inline uint32_t upipe_xdp_ring_free(struct upipe_xdp_ring *ring)
+{
+    return ring->mask + 1 -
+        (*ring->producer - __atomic_load_n(ring->consumer, __ATOMIC_ACQUIRE));
+}
+
+/** @This submits entries written by a producer.
+ *
+ * @param ring pointer to ring
+ * @param nb number of entries
+ */
+static inline void upipe_xdp_ring_submit(struct upipe_xdp_ring *ring,
+                                         uint32_t nb)
+{
+    __atomic_store_n(ring->producer, *ring->producer + nb, __ATOMIC_RELEASE);
+}
+
+/** @This returns the address of a frame descriptor of the fill or
+ * completion ring.
+ *
+ * @param ring pointer to ring
+ * @param idx index of the entry
+ * @return pointer to the UMEM address
+ */
+static inline uint64_t *upipe_xdp_ring_addr(struct upipe_xdp_ring *ring,
+                                            uint32_t idx)
+{
+    return &((uint64_t *)ring->desc)[idx & ring->mask];
+}
+
+/** @This returns a packet descriptor of the rx or tx ring.
+ *
+ * @param ring pointer to ring
+ * @param idx index of the entry
+ * @return pointer to the descriptor
+ */
+static inline struct xdp_desc *upipe_xdp_ring_desc(struct upipe_xdp_ring *ring,
+                                                   uint32_t idx)
+{
+    return &((struct xdp_desc *)ring->desc)[idx & ring->mask];
+}
+
+/** @This is an AF_XDP socket and its UMEM. It is refcounted because the
+ * UMEM frames wrapped in ubufs may outlive the pipe. */
+struct upipe_xdp_socket {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** umem manager recycling frames to the fill ring */
+    struct umem_mgr umem_mgr;
+
+    /** socket */
+    int fd;
+    /** interface index */
+    int ifindex;
+    /** queue id */
+    uint32_t queue;
+    /** true if the socket is bound in zero-copy mode */
+    bool zerocopy;
+
+    /** UMEM area */
+    uint8_t *area;
+    /** size of the UMEM area */
+    size_t area_size;
+
+    /** fill ring */
+    struct upipe_xdp_ring fill;
+    /** lock protecting the fill ring from concurrent recycling */
+    uatomic_uint32_t fill_lock;
+    /** completion ring */
+    struct upipe_xdp_ring comp;
+    /** rx ring */
+    struct upipe_xdp_ring rx;
+    /** tx ring */
+    struct upipe_xdp_ring tx;
+};
+
+/** @This returns the UMEM frame containing a UMEM address.
+ *
+ * @param xsk pointer to socket
+ * @param addr UMEM address
+ * @return pointer to the start of the frame
+ */
+static inline uint8_t *upipe_xdp_socket_frame(struct upipe_xdp_socket *xsk,
+                                              uint64_t addr)
+{
+    return xsk->area + (addr & ~(uint64_t)(UPIPE_XDP_FRAME_SIZE - 1));
+}
+
+/** @This allocates an AF_XDP socket and its UMEM, and binds it to an
+ * interface queue.
+ *
+ * @param upipe description structure of the pipe, to log errors
+ * @param ifname name of the interface
+ * @param queue queue id
+ * @param rx true to create an rx ring and fill the UMEM with all frames
+ * @param tx true to create a tx ring
+ * @return pointer to the socket, or NULL in case of error
+ */
+struct upipe_xdp_socket *upipe_xdp_socket_alloc(struct upipe *upipe,
+                                                const char *ifname,
+                                                uint32_t queue,
+                                                bool rx, bool tx);
+
+/** @This releases a socket.
+ *
+ * @param xsk pointer to socket
+ */
+static inline void upipe_xdp_socket_release(struct upipe_xdp_socket *xsk)
+{
+    if (xsk != NULL)
+        urefcount_release(&xsk->urefcount);
+}
+
+/** @This gives a frame back to the kernel through the fill ring. It may be
+ * called from any thread.
+ *
+ * @param xsk pointer to socket
+ * @param addr UMEM address of the frame
+ */
+void upipe_xdp_socket_fill(struct upipe_xdp_socket *xsk, uint64_t addr);
+
+/** @This is an XDP program redirecting a UDP flow to a socket. */
+struct upipe_xdp_prog {
+    /** socket map */
+    int map_fd;
+    /** program */
+    int prog_fd;
+    /** link attaching the program to the interface */
+    int link_fd;
+};
+
+/** @This loads an XDP program redirecting the IPv4 UDP datagrams to the given
+ * address and port to the socket, and attaches it to the interface of the
+ * socket. Other packets are passed to the kernel stack.
+ *
+ * @param upipe description structure of the pipe, to log errors
+ * @param prog filled in with the program
+ * @param xsk pointer to socket
+ * @param addr destination address in network byte order, or INADDR_ANY
+ * @param port destination port in network byte order, or 0
+ * @return an error code
+ */
+int upipe_xdp_prog_attach(struct upipe *upipe, struct upipe_xdp_prog *prog,
+                          struct upipe_xdp_socket *xsk,
+                          in_addr_t addr, uint16_t port);
+
+/** @This detaches and unloads an XDP program.
+ *
+ * @param prog pointer to the program
+ */
+void upipe_xdp_prog_detach(struct upipe_xdp_prog *prog);
+
+/** @This parses a uri of the form ifname[-queue][@address[:port]].
+ *
+ * @param upipe description structure of the pipe, to log errors
+ * @param uri uri to parse
+ * @param ifname filled in with the interface name
+ * @param queue_p filled in with the queue id (0 by default)
+ * @param addr_p filled in with the address in network byte order
+ * (INADDR_ANY by default)
+ * @param port_p filled in with the port in network byte order (0 by default)
+ * @return an error code
+ */
+int upipe_xdp_parse_uri(struct upipe *upipe, const char *uri,
+                        char ifname[IF_NAMESIZE], uint32_t *queue_p,
+                        in_addr_t *addr_p, uint16_t *port_p);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
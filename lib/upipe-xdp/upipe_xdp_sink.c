@@ -0,0 +1,571 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe sink module for AF_XDP sockets
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/ulist.h>
+#include <upipe/uprobe.h>
+#include <upipe/uclock.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_flow.h>
+#include <upipe/upump.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_upump_mgr.h>
+#include <upipe/upipe_helper_upump.h>
+#include <upipe/upipe_helper_input.h>
+#include <upipe-xdp/upipe_xdp_sink.h>
+
+#include "upipe_xdp.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <arpa/inet.h>
+#include <assert.h>
+
+/** expected flow definition on all flows */
+#define EXPECTED_FLOW_DEF "block."
+/** size of the Ethernet, IPv4 and UDP headers */
+#define HEADER_SIZE (14 + 20 + 8)
+/** maximum size of a payload */
+#define MAX_PAYLOAD_SIZE (UPIPE_XDP_FRAME_SIZE - HEADER_SIZE)
+/** delay before retrying when the rings are full */
+#define RETRY_DELAY (UCLOCK_FREQ / 1000)
+
+/** @hidden */
+static void upipe_xdp_sink_watcher(struct upump *upump);
+/** @hidden */
+static bool upipe_xdp_sink_output(struct upipe *upipe, struct uref *uref,
+                                  struct upump **upump_p);
+
+/** @internal @This is the private context of an AF_XDP sink pipe. */
+struct upipe_xdp_sink {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** upump manager */
+    struct upump_mgr *upump_mgr;
+    /** retry timer */
+    struct upump *upump;
+
+    /** temporary uref storage */
+    struct uchain urefs;
+    /** nb urefs in storage */
+    unsigned int nb_urefs;
+    /** max urefs in storage */
+    unsigned int max_urefs;
+    /** list of blockers */
+    struct uchain blockers;
+
+    /** uri */
+    char *uri;
+    /** AF_XDP socket */
+    struct upipe_xdp_socket *xsk;
+    /** UMEM addresses of the frames not owned by the kernel */
+    uint64_t frames[UPIPE_XDP_FRAMES];
+    /** number of free frames */
+    unsigned int nb_frames;
+    /** template of the Ethernet, IPv4 and UDP headers */
+    uint8_t header[HEADER_SIZE];
+    /** IPv4 identification of the next datagram */
+    uint16_t ip_id;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_xdp_sink, upipe, UPIPE_XDP_SINK_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_xdp_sink, urefcount, upipe_xdp_sink_free)
+UPIPE_HELPER_VOID(upipe_xdp_sink)
+UPIPE_HELPER_UPUMP_MGR(upipe_xdp_sink, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_xdp_sink, upump, upump_mgr)
+UPIPE_HELPER_INPUT(upipe_xdp_sink, urefs, nb_urefs, max_urefs, blockers,
+                   upipe_xdp_sink_output)
+
+/** @internal @This allocates an AF_XDP sink pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_xdp_sink_alloc(struct upipe_mgr *mgr,
+                                          struct uprobe *uprobe,
+                                          uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_xdp_sink_alloc_void(mgr, uprobe, signature,
+                                                    args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_xdp_sink *upipe_xdp_sink = upipe_xdp_sink_from_upipe(upipe);
+    upipe_xdp_sink_init_urefcount(upipe);
+    upipe_xdp_sink_init_upump_mgr(upipe);
+    upipe_xdp_sink_init_upump(upipe);
+    upipe_xdp_sink_init_input(upipe);
+    upipe_xdp_sink->uri = NULL;
+    upipe_xdp_sink->xsk = NULL;
+    upipe_xdp_sink->nb_frames = 0;
+    upipe_xdp_sink->ip_id = 0;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This computes the checksum of an IPv4 header.
+ *
+ * @param ip pointer to the header
+ * @return checksum in host byte order
+ */
+static uint16_t upipe_xdp_sink_ip_checksum(const uint8_t *ip)
+{
+    uint32_t sum = 0;
+    for (unsigned int i = 0; i < 20; i += 2)
+        sum += (ip[i] << 8) | ip[i + 1];
+    while (sum >> 16)
+        sum = (sum & 0xffff) + (sum >> 16);
+    return ~sum;
+}
+
+/** @internal @This takes back the frames whose transmission is complete.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_xdp_sink_complete(struct upipe *upipe)
+{
+    struct upipe_xdp_sink *upipe_xdp_sink = upipe_xdp_sink_from_upipe(upipe);
+    struct upipe_xdp_socket *xsk = upipe_xdp_sink->xsk;
+    uint32_t nb = upipe_xdp_ring_avail(&xsk->comp);
+    uint32_t cons = *xsk->comp.consumer;
+    for (uint32_t i = 0; i < nb; i++)
+        upipe_xdp_sink->frames[upipe_xdp_sink->nb_frames++] =
+            *upipe_xdp_ring_addr(&xsk->comp, cons + i);
+    upipe_xdp_ring_release(&xsk->comp, nb);
+}
+
+/** @internal @This copies a buffer to a UMEM frame and queues it to the tx
+ * ring.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ * @return true if the uref was processed
+ */
+static bool upipe_xdp_sink_output(struct upipe *upipe, struct uref *uref,
+                                  struct upump **upump_p)
+{
+    struct upipe_xdp_sink *upipe_xdp_sink = upipe_xdp_sink_from_upipe(upipe);
+    struct upipe_xdp_socket *xsk = upipe_xdp_sink->xsk;
+    const char *def;
+    if (unlikely(ubase_check(uref_flow_get_def(uref, &def)))) {
+        uref_free(uref);
+        return true;
+    }
+
+    if (unlikely(xsk == NULL)) {
+        uref_free(uref);
+        upipe_warn(upipe, "received a buffer before opening a socket");
+        return true;
+    }
+
+    size_t size = 0;
+    if (unlikely(!ubase_check(uref_block_size(uref, &size)) ||
+                 size > MAX_PAYLOAD_SIZE)) {
+        upipe_warn_va(upipe, "dropping buffer too large for a frame (%zu)",
+                      size);
+        uref_free(uref);
+        return true;
+    }
+
+    upipe_xdp_sink_complete(upipe);
+    if (unlikely(upipe_xdp_sink->nb_frames == 0 ||
+                 upipe_xdp_ring_free(&xsk->tx) == 0)) {
+        /* give the kernel a chance to empty the tx ring */
+        sendto(xsk->fd, NULL, 0, MSG_DONTWAIT, NULL, 0);
+        upipe_xdp_sink_check_upump_mgr(upipe);
+        if (likely(upipe_xdp_sink->upump_mgr != NULL))
+            upipe_xdp_sink_wait_upump(upipe, RETRY_DELAY,
+                                      upipe_xdp_sink_watcher);
+        return false;
+    }
+
+    uint64_t addr = upipe_xdp_sink->frames[--upipe_xdp_sink->nb_frames];
+    uint8_t *pkt = xsk->area + addr;
+    memcpy(pkt, upipe_xdp_sink->header, HEADER_SIZE);
+    if (unlikely(!ubase_check(uref_block_extract(uref, 0, size,
+                                                 pkt + HEADER_SIZE)))) {
+        upipe_xdp_sink->frames[upipe_xdp_sink->nb_frames++] = addr;
+        upipe_warn(upipe, "cannot read ubuf buffer");
+        uref_free(uref);
+        return true;
+    }
+    uref_free(uref);
+
+    uint8_t *ip = pkt + 14;
+    uint16_t ip_len = 20 + 8 + size;
+    ip[2] = ip_len >> 8;
+    ip[3] = ip_len;
+    ip[4] = upipe_xdp_sink->ip_id >> 8;
+    ip[5] = upipe_xdp_sink->ip_id;
+    upipe_xdp_sink->ip_id++;
+    uint16_t csum = upipe_xdp_sink_ip_checksum(ip);
+    ip[10] = csum >> 8;
+    ip[11] = csum;
+    uint8_t *udp = ip + 20;
+    udp[4] = (8 + size) >> 8;
+    udp[5] = 8 + size;
+
+    uint32_t prod = *xsk->tx.producer;
+    struct xdp_desc *desc = upipe_xdp_ring_desc(&xsk->tx, prod);
+    desc->addr = addr;
+    desc->len = HEADER_SIZE + size;
+    desc->options = 0;
+    upipe_xdp_ring_submit(&xsk->tx, 1);
+    sendto(xsk->fd, NULL, 0, MSG_DONTWAIT, NULL, 0);
+    return true;
+}
+
+/** @internal @This is called when the rings may have room again.
+ * Unblock the sink and unqueue all queued buffers.
+ *
+ * @param upump description structure of the watcher
+ */
+static void upipe_xdp_sink_watcher(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    upipe_xdp_sink_set_upump(upipe, NULL);
+    upipe_xdp_sink_output_input(upipe);
+    upipe_xdp_sink_unblock_input(upipe);
+    if (upipe_xdp_sink_check_input(upipe)) {
+        /* All packets have been output, release again the pipe that has been
+         * used in @ref upipe_xdp_sink_input. */
+        upipe_release(upipe);
+    }
+}
+
+/** @internal @This receives data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_xdp_sink_input(struct upipe *upipe, struct uref *uref,
+                                 struct upump **upump_p)
+{
+    if (!upipe_xdp_sink_check_input(upipe)) {
+        upipe_xdp_sink_hold_input(upipe, uref);
+        upipe_xdp_sink_block_input(upipe, upump_p);
+    } else if (!upipe_xdp_sink_output(upipe, uref, upump_p)) {
+        upipe_xdp_sink_hold_input(upipe, uref);
+        upipe_xdp_sink_block_input(upipe, upump_p);
+        /* Increment upipe refcount to avoid disappearing before all packets
+         * have been sent. */
+        upipe_use(upipe);
+    }
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_xdp_sink_set_flow_def(struct upipe *upipe,
+                                       struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, EXPECTED_FLOW_DEF))
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This builds the template of the headers from the addresses of
+ * the interface.
+ *
+ * @param upipe description structure of the pipe
+ * @param ifname name of the interface
+ * @param addr destination address in network byte order
+ * @param port destination port in network byte order
+ * @return an error code
+ */
+static int upipe_xdp_sink_build_header(struct upipe *upipe,
+                                       const char ifname[IF_NAMESIZE],
+                                       in_addr_t addr, uint16_t port)
+{
+    struct upipe_xdp_sink *upipe_xdp_sink = upipe_xdp_sink_from_upipe(upipe);
+    uint8_t *header = upipe_xdp_sink->header;
+
+    if (unlikely(!IN_MULTICAST(ntohl(addr)) || port == 0)) {
+        upipe_err(upipe, "destination must be a multicast address and port");
+        return UBASE_ERR_INVALID;
+    }
+
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (unlikely(fd == -1)) {
+        upipe_err_va(upipe, "can't open socket (%m)");
+        return UBASE_ERR_EXTERNAL;
+    }
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    memcpy(ifr.ifr_name, ifname, IF_NAMESIZE);
+    if (unlikely(ioctl(fd, SIOCGIFHWADDR, &ifr) < 0)) {
+        upipe_err_va(upipe, "can't get address of %s (%m)", ifname);
+        close(fd);
+        return UBASE_ERR_EXTERNAL;
+    }
+    memcpy(header + 6, ifr.ifr_hwaddr.sa_data, 6);
+
+    in_addr_t src_addr = INADDR_ANY;
+    if (likely(ioctl(fd, SIOCGIFADDR, &ifr) >= 0))
+        src_addr = ((struct sockaddr_in *)&ifr.ifr_addr)->sin_addr.s_addr;
+    else
+        upipe_warn_va(upipe, "%s has no IPv4 address", ifname);
+    close(fd);
+
+    /* Ethernet, with the multicast MAC address of the group */
+    uint32_t group = ntohl(addr);
+    header[0] = 0x01;
+    header[1] = 0x00;
+    header[2] = 0x5e;
+    header[3] = (group >> 16) & 0x7f;
+    header[4] = group >> 8;
+    header[5] = group;
+    header[12] = 0x08;
+    header[13] = 0x00;
+
+    /* IPv4, lengths, id and checksum are set per datagram */
+    uint8_t *ip = header + 14;
+    memset(ip, 0, 20 + 8);
+    ip[0] = 0x45;
+    ip[6] = 0x40; /* don't fragment */
+    ip[8] = 64;
+    ip[9] = IPPROTO_UDP;
+    memcpy(ip + 12, &src_addr, 4);
+    memcpy(ip + 16, &addr, 4);
+
+    /* UDP, without checksum */
+    uint8_t *udp = ip + 20;
+    memcpy(udp, &port, 2);
+    memcpy(udp + 2, &port, 2);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This closes the socket and flushes the held buffers.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_xdp_sink_close(struct upipe *upipe)
+{
+    struct upipe_xdp_sink *upipe_xdp_sink = upipe_xdp_sink_from_upipe(upipe);
+
+    if (upipe_xdp_sink_flush_input(upipe))
+        /* Release the pipe used in @ref upipe_xdp_sink_input. */
+        upipe_release(upipe);
+    upipe_xdp_sink_set_upump(upipe, NULL);
+    if (upipe_xdp_sink->xsk != NULL && upipe_xdp_sink->uri != NULL)
+        upipe_notice_va(upipe, "closing AF_XDP socket %s",
+                        upipe_xdp_sink->uri);
+    upipe_xdp_socket_release(upipe_xdp_sink->xsk);
+    upipe_xdp_sink->xsk = NULL;
+    upipe_xdp_sink->nb_frames = 0;
+    ubase_clean_str(&upipe_xdp_sink->uri);
+}
+
+/** @internal @This returns the uri of the currently opened socket.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri_p filled in with the uri of the socket
+ * @return an error code
+ */
+static int upipe_xdp_sink_get_uri(struct upipe *upipe, const char **uri_p)
+{
+    struct upipe_xdp_sink *upipe_xdp_sink = upipe_xdp_sink_from_upipe(upipe);
+    assert(uri_p != NULL);
+    *uri_p = upipe_xdp_sink->uri;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This asks to open the given socket.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri uri of the socket
+ * @return an error code
+ */
+static int upipe_xdp_sink_set_uri(struct upipe *upipe, const char *uri)
+{
+    struct upipe_xdp_sink *upipe_xdp_sink = upipe_xdp_sink_from_upipe(upipe);
+
+    upipe_xdp_sink_close(upipe);
+    if (unlikely(uri == NULL))
+        return UBASE_ERR_NONE;
+
+    char ifname[IF_NAMESIZE];
+    uint32_t queue;
+    in_addr_t addr;
+    uint16_t port;
+    UBASE_RETURN(upipe_xdp_parse_uri(upipe, uri, ifname, &queue, &addr, &port))
+    UBASE_RETURN(upipe_xdp_sink_build_header(upipe, ifname, addr, port))
+
+    upipe_xdp_sink->uri = strdup(uri);
+    if (unlikely(upipe_xdp_sink->uri == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
+
+    upipe_xdp_sink->xsk = upipe_xdp_socket_alloc(upipe, ifname, queue,
+                                                 false, true);
+    if (unlikely(upipe_xdp_sink->xsk == NULL)) {
+        ubase_clean_str(&upipe_xdp_sink->uri);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    for (unsigned int i = 0; i < UPIPE_XDP_FRAMES; i++)
+        upipe_xdp_sink->frames[i] =
+            (uint64_t)(UPIPE_XDP_FRAMES - 1 - i) * UPIPE_XDP_FRAME_SIZE;
+    upipe_xdp_sink->nb_frames = UPIPE_XDP_FRAMES;
+
+    upipe_notice_va(upipe, "opening AF_XDP socket %s in %s mode",
+                    upipe_xdp_sink->uri,
+                    upipe_xdp_sink->xsk->zerocopy ? "zero-copy" : "copy");
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This flushes all currently held buffers, and unblocks the
+ * sources.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_xdp_sink_flush(struct upipe *upipe)
+{
+    if (upipe_xdp_sink_flush_input(upipe)) {
+        upipe_xdp_sink_set_upump(upipe, NULL);
+        /* All packets have been output, release again the pipe that has been
+         * used in @ref upipe_xdp_sink_input. */
+        upipe_release(upipe);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on an AF_XDP sink pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_xdp_sink_control(struct upipe *upipe, int command,
+                                  va_list args)
+{
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST:
+        case UPIPE_UNREGISTER_REQUEST:
+            return upipe_control_provide_request(upipe, command, args);
+
+        case UPIPE_ATTACH_UPUMP_MGR: {
+            struct upipe_xdp_sink *upipe_xdp_sink =
+                upipe_xdp_sink_from_upipe(upipe);
+            upipe_xdp_sink_set_upump(upipe, NULL);
+            UBASE_RETURN(upipe_xdp_sink_attach_upump_mgr(upipe))
+            if (!upipe_xdp_sink_check_input(upipe) &&
+                upipe_xdp_sink->upump_mgr != NULL)
+                upipe_xdp_sink_wait_upump(upipe, RETRY_DELAY,
+                                          upipe_xdp_sink_watcher);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_xdp_sink_set_flow_def(upipe, flow_def);
+        }
+
+        case UPIPE_GET_MAX_LENGTH: {
+            unsigned int *p = va_arg(args, unsigned int *);
+            return upipe_xdp_sink_get_max_length(upipe, p);
+        }
+        case UPIPE_SET_MAX_LENGTH: {
+            unsigned int max_length = va_arg(args, unsigned int);
+            return upipe_xdp_sink_set_max_length(upipe, max_length);
+        }
+
+        case UPIPE_GET_URI: {
+            const char **uri_p = va_arg(args, const char **);
+            return upipe_xdp_sink_get_uri(upipe, uri_p);
+        }
+        case UPIPE_SET_URI: {
+            const char *uri = va_arg(args, const char *);
+            return upipe_xdp_sink_set_uri(upipe, uri);
+        }
+        case UPIPE_FLUSH:
+            return upipe_xdp_sink_flush(upipe);
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_xdp_sink_free(struct upipe *upipe)
+{
+    upipe_xdp_sink_close(upipe);
+
+    upipe_throw_dead(upipe);
+
+    upipe_xdp_sink_clean_upump(upipe);
+    upipe_xdp_sink_clean_upump_mgr(upipe);
+    upipe_xdp_sink_clean_input(upipe);
+    upipe_xdp_sink_clean_urefcount(upipe);
+    upipe_xdp_sink_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_xdp_sink_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_XDP_SINK_SIGNATURE,
+
+    .upipe_alloc = upipe_xdp_sink_alloc,
+    .upipe_input = upipe_xdp_sink_input,
+    .upipe_control = upipe_xdp_sink_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all AF_XDP sinks.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_xdp_sink_mgr_alloc(void)
+{
+    return &upipe_xdp_sink_mgr;
+}
@@ -0,0 +1,494 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe source module for AF_XDP sockets
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uclock.h>
+#include <upipe/umem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_clock.h>
+#include <upipe/upump.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_uref_mgr.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe/upipe_helper_upump_mgr.h>
+#include <upipe/upipe_helper_upump.h>
+#include <upipe/upipe_helper_uclock.h>
+#include <upipe-xdp/upipe_xdp_source.h>
+
+#include "upipe_xdp.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+/** depth of the pools of the ubuf manager wrapping UMEM frames */
+#define UBUF_POOL_DEPTH 1024
+
+/** @hidden */
+static int upipe_xdp_source_check(struct upipe *upipe, struct uref *flow_format);
+
+/** @internal @This is the private context of an AF_XDP source pipe. */
+struct upipe_xdp_source {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** uref manager */
+    struct uref_mgr *uref_mgr;
+    /** uref manager request */
+    struct urequest uref_mgr_request;
+
+    /** uclock structure, if not NULL we are in live mode */
+    struct uclock *uclock;
+    /** uclock request */
+    struct urequest uclock_request;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** flow definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** upump manager */
+    struct upump_mgr *upump_mgr;
+    /** read watcher */
+    struct upump *upump;
+
+    /** uri */
+    char *uri;
+    /** AF_XDP socket */
+    struct upipe_xdp_socket *xsk;
+    /** ubuf manager wrapping UMEM frames */
+    struct ubuf_mgr *ubuf_mgr;
+    /** XDP program */
+    struct upipe_xdp_prog prog;
+    /** socket used to join the multicast group, or -1 */
+    int mcast_fd;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_xdp_source, upipe, UPIPE_XDP_SOURCE_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_xdp_source, urefcount, upipe_xdp_source_free)
+UPIPE_HELPER_VOID(upipe_xdp_source)
+
+UPIPE_HELPER_OUTPUT(upipe_xdp_source, output, flow_def, output_state, request_list)
+UPIPE_HELPER_UREF_MGR(upipe_xdp_source, uref_mgr, uref_mgr_request,
+                      upipe_xdp_source_check,
+                      upipe_xdp_source_register_output_request,
+                      upipe_xdp_source_unregister_output_request)
+UPIPE_HELPER_UCLOCK(upipe_xdp_source, uclock, uclock_request, upipe_xdp_source_check,
+                    upipe_xdp_source_register_output_request,
+                    upipe_xdp_source_unregister_output_request)
+
+UPIPE_HELPER_UPUMP_MGR(upipe_xdp_source, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_xdp_source, upump, upump_mgr)
+
+/** @internal @This allocates an AF_XDP source pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_xdp_source_alloc(struct upipe_mgr *mgr,
+                                            struct uprobe *uprobe,
+                                            uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_xdp_source_alloc_void(mgr, uprobe, signature,
+                                                      args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_xdp_source *upipe_xdp_source = upipe_xdp_source_from_upipe(upipe);
+    upipe_xdp_source_init_urefcount(upipe);
+    upipe_xdp_source_init_uref_mgr(upipe);
+    upipe_xdp_source_init_output(upipe);
+    upipe_xdp_source_init_upump_mgr(upipe);
+    upipe_xdp_source_init_upump(upipe);
+    upipe_xdp_source_init_uclock(upipe);
+    upipe_xdp_source->uri = NULL;
+    upipe_xdp_source->xsk = NULL;
+    upipe_xdp_source->ubuf_mgr = NULL;
+    upipe_xdp_source->prog.map_fd = -1;
+    upipe_xdp_source->prog.prog_fd = -1;
+    upipe_xdp_source->prog.link_fd = -1;
+    upipe_xdp_source->mcast_fd = -1;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This returns the UDP payload of a received frame.
+ *
+ * @param pkt pointer to the Ethernet frame
+ * @param len size of the frame
+ * @param payload_len_p filled in with the size of the payload
+ * @return pointer to the payload, or NULL if the frame is not a valid IPv4
+ * UDP datagram
+ */
+static const uint8_t *upipe_xdp_source_parse(const uint8_t *pkt, uint32_t len,
+                                             uint16_t *payload_len_p)
+{
+    if (len < 14 + 20 + 8 || pkt[12] != 0x08 || pkt[13] != 0x00)
+        return NULL;
+
+    const uint8_t *ip = pkt + 14;
+    unsigned int ihl = (ip[0] & 0xf) * 4;
+    if ((ip[0] >> 4) != 4 || ihl < 20 || ip[9] != IPPROTO_UDP ||
+        14 + ihl + 8 > len)
+        return NULL;
+
+    const uint8_t *udp = ip + ihl;
+    uint16_t udp_len = (udp[4] << 8) | udp[5];
+    if (udp_len < 8 || 14 + ihl + udp_len > len)
+        return NULL;
+
+    *payload_len_p = udp_len - 8;
+    return udp + 8;
+}
+
+/** @internal @This reads the received frames and outputs them without copy.
+ *
+ * @param upump description structure of the watcher
+ */
+static void upipe_xdp_source_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_xdp_source *upipe_xdp_source = upipe_xdp_source_from_upipe(upipe);
+    struct upipe_xdp_socket *xsk = upipe_xdp_source->xsk;
+
+    uint64_t systime = 0;
+    if (likely(upipe_xdp_source->uclock != NULL))
+        systime = uclock_now(upipe_xdp_source->uclock);
+
+    /* the output may close the socket */
+    urefcount_use(&xsk->urefcount);
+    uint32_t nb = upipe_xdp_ring_avail(&xsk->rx);
+    uint32_t cons = *xsk->rx.consumer;
+    uint32_t i;
+    for (i = 0; i < nb; i++) {
+        const struct xdp_desc *desc = upipe_xdp_ring_desc(&xsk->rx, cons + i);
+        uint8_t *frame = upipe_xdp_socket_frame(xsk, desc->addr);
+        const uint8_t *pkt = xsk->area + desc->addr;
+        uint16_t payload_len;
+        const uint8_t *payload = upipe_xdp_source_parse(pkt, desc->len,
+                                                        &payload_len);
+        if (unlikely(payload == NULL || upipe_xdp_source->xsk != xsk)) {
+            upipe_xdp_socket_fill(xsk, desc->addr);
+            continue;
+        }
+
+        struct umem umem;
+        umem.mgr = umem_mgr_use(&xsk->umem_mgr);
+        umem.buffer = frame;
+        umem.size = umem.real_size = UPIPE_XDP_FRAME_SIZE;
+        struct ubuf *ubuf =
+            ubuf_block_mem_alloc_from_umem(upipe_xdp_source->ubuf_mgr, &umem);
+        struct uref *uref = NULL;
+        if (likely(ubuf != NULL))
+            uref = uref_alloc(upipe_xdp_source->uref_mgr);
+        if (unlikely(uref == NULL)) {
+            if (ubuf != NULL)
+                ubuf_free(ubuf);
+            else
+                umem_free(&umem);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            i++;
+            break;
+        }
+
+        ubuf_block_resize(ubuf, payload - frame, payload_len);
+        uref_attach_ubuf(uref, ubuf);
+        uref_clock_set_cr_sys(uref, systime);
+        upipe_xdp_source_output(upipe, uref, &upipe_xdp_source->upump);
+    }
+    upipe_xdp_ring_release(&xsk->rx, i);
+    upipe_xdp_socket_release(xsk);
+}
+
+/** @internal @This checks if the pump may be allocated.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_xdp_source_check(struct upipe *upipe, struct uref *flow_format)
+{
+    struct upipe_xdp_source *upipe_xdp_source = upipe_xdp_source_from_upipe(upipe);
+    if (flow_format != NULL)
+        uref_free(flow_format);
+
+    upipe_xdp_source_check_upump_mgr(upipe);
+    if (upipe_xdp_source->upump_mgr == NULL)
+        return UBASE_ERR_NONE;
+
+    if (upipe_xdp_source->uref_mgr == NULL) {
+        upipe_xdp_source_require_uref_mgr(upipe);
+        return UBASE_ERR_NONE;
+    }
+
+    if (upipe_xdp_source->flow_def == NULL) {
+        struct uref *flow_def =
+            uref_block_flow_alloc_def(upipe_xdp_source->uref_mgr, NULL);
+        if (unlikely(flow_def == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return UBASE_ERR_ALLOC;
+        }
+        upipe_xdp_source_store_flow_def(upipe, flow_def);
+    }
+
+    if (upipe_xdp_source->uclock == NULL &&
+        urequest_get_opaque(&upipe_xdp_source->uclock_request, struct upipe *)
+            != NULL)
+        return UBASE_ERR_NONE;
+
+    if (upipe_xdp_source->xsk == NULL || upipe_xdp_source->upump != NULL)
+        return UBASE_ERR_NONE;
+
+    struct upump *upump = upump_alloc_fd_read(upipe_xdp_source->upump_mgr,
+            upipe_xdp_source_worker, upipe, upipe->refcount,
+            upipe_xdp_source->xsk->fd);
+    if (unlikely(upump == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+        return UBASE_ERR_UPUMP;
+    }
+    upipe_xdp_source_set_upump(upipe, upump);
+    upump_start(upump);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This closes the socket and detaches the XDP program.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_xdp_source_close(struct upipe *upipe)
+{
+    struct upipe_xdp_source *upipe_xdp_source = upipe_xdp_source_from_upipe(upipe);
+
+    upipe_xdp_source_set_upump(upipe, NULL);
+    upipe_xdp_prog_detach(&upipe_xdp_source->prog);
+    if (upipe_xdp_source->mcast_fd != -1)
+        close(upipe_xdp_source->mcast_fd);
+    upipe_xdp_source->mcast_fd = -1;
+    /* frames still used by urefs keep the socket alive */
+    ubuf_mgr_release(upipe_xdp_source->ubuf_mgr);
+    upipe_xdp_source->ubuf_mgr = NULL;
+    upipe_xdp_socket_release(upipe_xdp_source->xsk);
+    upipe_xdp_source->xsk = NULL;
+    ubase_clean_str(&upipe_xdp_source->uri);
+}
+
+/** @internal @This returns the uri of the currently opened socket.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri_p filled in with the uri of the socket
+ * @return an error code
+ */
+static int upipe_xdp_source_get_uri(struct upipe *upipe, const char **uri_p)
+{
+    struct upipe_xdp_source *upipe_xdp_source = upipe_xdp_source_from_upipe(upipe);
+    assert(uri_p != NULL);
+    *uri_p = upipe_xdp_source->uri;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This asks to open the given socket.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri uri of the socket
+ * @return an error code
+ */
+static int upipe_xdp_source_set_uri(struct upipe *upipe, const char *uri)
+{
+    struct upipe_xdp_source *upipe_xdp_source = upipe_xdp_source_from_upipe(upipe);
+
+    upipe_xdp_source_close(upipe);
+    if (unlikely(uri == NULL))
+        return UBASE_ERR_NONE;
+
+    char ifname[IF_NAMESIZE];
+    uint32_t queue;
+    in_addr_t addr;
+    uint16_t port;
+    UBASE_RETURN(upipe_xdp_parse_uri(upipe, uri, ifname, &queue, &addr, &port))
+
+    upipe_xdp_source->xsk = upipe_xdp_socket_alloc(upipe, ifname, queue,
+                                                   true, false);
+    if (unlikely(upipe_xdp_source->xsk == NULL))
+        return UBASE_ERR_EXTERNAL;
+
+    upipe_xdp_source->ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, &upipe_xdp_source->xsk->umem_mgr, -1, 0, -1, 0);
+    upipe_xdp_source->uri = strdup(uri);
+    if (unlikely(upipe_xdp_source->ubuf_mgr == NULL ||
+                 upipe_xdp_source->uri == NULL)) {
+        upipe_xdp_source_close(upipe);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
+    /* buffers only leave this thread through queues, which share them */
+    if (unlikely(!ubase_check(ubuf_block_mem_mgr_set_local(
+                        upipe_xdp_source->ubuf_mgr, true))))
+        upipe_warn(upipe, "unable to use thread-local buffers");
+
+    if (unlikely(!ubase_check(upipe_xdp_prog_attach(upipe,
+                        &upipe_xdp_source->prog, upipe_xdp_source->xsk,
+                        addr, port)))) {
+        upipe_xdp_source_close(upipe);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    if (IN_MULTICAST(ntohl(addr))) {
+        /* let the kernel subscribe to the group and program the NIC
+         * filters, the datagrams themselves are redirected before */
+        struct ip_mreqn mreqn;
+        memset(&mreqn, 0, sizeof(mreqn));
+        mreqn.imr_multiaddr.s_addr = addr;
+        mreqn.imr_ifindex = upipe_xdp_source->xsk->ifindex;
+        upipe_xdp_source->mcast_fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC,
+                                            0);
+        if (unlikely(upipe_xdp_source->mcast_fd == -1 ||
+                     setsockopt(upipe_xdp_source->mcast_fd, IPPROTO_IP,
+                                IP_ADD_MEMBERSHIP, &mreqn,
+                                sizeof(mreqn)) < 0))
+            upipe_warn_va(upipe, "can't join multicast group (%m)");
+    }
+
+    upipe_notice_va(upipe, "opening AF_XDP socket %s in %s mode",
+                    upipe_xdp_source->uri,
+                    upipe_xdp_source->xsk->zerocopy ? "zero-copy" : "copy");
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on an AF_XDP source pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int _upipe_xdp_source_control(struct upipe *upipe,
+                                     int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_ATTACH_UPUMP_MGR:
+            upipe_xdp_source_set_upump(upipe, NULL);
+            return upipe_xdp_source_attach_upump_mgr(upipe);
+        case UPIPE_ATTACH_UCLOCK:
+            upipe_xdp_source_set_upump(upipe, NULL);
+            upipe_xdp_source_require_uclock(upipe);
+            return UBASE_ERR_NONE;
+
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_xdp_source_control_output(upipe, command, args);
+
+        case UPIPE_GET_URI: {
+            const char **uri_p = va_arg(args, const char **);
+            return upipe_xdp_source_get_uri(upipe, uri_p);
+        }
+        case UPIPE_SET_URI: {
+            const char *uri = va_arg(args, const char *);
+            return upipe_xdp_source_set_uri(upipe, uri);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This processes control commands on an AF_XDP source pipe, and
+ * checks the status of the pipe afterwards.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_xdp_source_control(struct upipe *upipe, int command,
+                                    va_list args)
+{
+    UBASE_RETURN(_upipe_xdp_source_control(upipe, command, args));
+
+    return upipe_xdp_source_check(upipe, NULL);
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_xdp_source_free(struct upipe *upipe)
+{
+    upipe_xdp_source_close(upipe);
+
+    upipe_throw_dead(upipe);
+
+    upipe_xdp_source_clean_uclock(upipe);
+    upipe_xdp_source_clean_upump(upipe);
+    upipe_xdp_source_clean_upump_mgr(upipe);
+    upipe_xdp_source_clean_output(upipe);
+    upipe_xdp_source_clean_uref_mgr(upipe);
+    upipe_xdp_source_clean_urefcount(upipe);
+    upipe_xdp_source_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_xdp_source_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_XDP_SOURCE_SIGNATURE,
+
+    .upipe_alloc = upipe_xdp_source_alloc,
+    .upipe_input = NULL,
+    .upipe_control = upipe_xdp_source_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all AF_XDP sources.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_xdp_source_mgr_alloc(void)
+{
+    return &upipe_xdp_source_mgr;
+}
@@ -27,6 +27,7 @@
 #include <upipe/uref.h>
 #include <upipe/uref_pic.h>
 #include <upipe/uref_flow.h>
+#include <upipe/ubuf_pic.h>
 #include <upipe/upipe.h>
 #include <upipe/upipe_helper_upipe.h>
 #include <upipe/upipe_helper_urefcount.h>
@@ -36,6 +37,7 @@
 #include <upipe/uref_pic_flow.h>
 
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdarg.h>
@@ -61,6 +63,11 @@ struct upipe_zvbienc {
 
     vbi_sliced sliced[2];
 
+    /** rendered VBI lines of both fields */
+    uint8_t lines[2 * 720];
+    /** true if lines hold the rendering of sliced */
+    bool lines_valid;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -82,8 +89,8 @@ static void upipe_zvbienc_input(struct upipe *upipe, struct uref *uref,
     struct upipe_zvbienc *upipe_zvbienc = upipe_zvbienc_from_upipe(upipe);
 
     /* Initialise VBI data with defaults */
-    for (int i = 0; i < 2; i++)
-        memset(upipe_zvbienc->sliced[i].data, 0x80, 2);
+    uint8_t data[2][2];
+    memset(data, 0x80, sizeof(data));
 
     const uint8_t *pic_data = NULL;
     size_t pic_data_size = 0;
@@ -93,17 +100,50 @@ static void upipe_zvbienc_input(struct upipe *upipe, struct uref *uref,
         const uint8_t cc_type = pic_data[3*i] & 0x3;
 
         if (valid && cc_type < 2)
-            memcpy(upipe_zvbienc->sliced[cc_type].data, &pic_data[3*i + 1], 2);
+            memcpy(data[cc_type], &pic_data[3*i + 1], 2);
     }
 
-    uint8_t *buf;
-    if (ubase_check(uref_pic_plane_write(uref, "y8", 0, 1, -1, 2, &buf))) {
-        if (!vbi_raw_video_image(buf, 720*2, &upipe_zvbienc->sp,
-                0, 0, 0, 0x000000FF, false, upipe_zvbienc->sliced, 2)) {
+    /* both fields are rendered in one call, and only when they change */
+    if (!upipe_zvbienc->lines_valid ||
+        memcmp(upipe_zvbienc->sliced[0].data, data[0], 2) ||
+        memcmp(upipe_zvbienc->sliced[1].data, data[1], 2)) {
+        for (int i = 0; i < 2; i++)
+            memcpy(upipe_zvbienc->sliced[i].data, data[i], 2);
+        upipe_zvbienc->lines_valid =
+            vbi_raw_video_image(upipe_zvbienc->lines,
+                sizeof(upipe_zvbienc->lines), &upipe_zvbienc->sp,
+                0, 0, 0, 0x000000FF, false, upipe_zvbienc->sliced, 2);
+        if (!upipe_zvbienc->lines_valid)
             upipe_err(upipe, "Couldn't store VBI");
+    }
+
+    if (upipe_zvbienc->lines_valid && uref->ubuf != NULL) {
+        uint8_t *buf;
+        if (!ubase_check(uref_pic_plane_write(uref, "y8", 0, 1, -1, 2,
+                                              &buf))) {
+            /* the picture is shared, insert into a private copy */
+            struct ubuf *ubuf = ubuf_pic_copy(uref->ubuf->mgr, uref->ubuf,
+                                              0, 0, -1, -1);
+            if (unlikely(ubuf == NULL)) {
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                uref_free(uref);
+                return;
+            }
+            uref_attach_ubuf(uref, ubuf);
+            if (!ubase_check(uref_pic_plane_write(uref, "y8", 0, 1, -1, 2,
+                                                  &buf)))
+                buf = NULL;
         }
 
-        uref_pic_plane_unmap(uref, "y8", 0, 1, -1, 2);
+        size_t stride;
+        if (buf != NULL) {
+            if (ubase_check(uref_pic_plane_size(uref, "y8", &stride,
+                                                NULL, NULL, NULL))) {
+                memcpy(buf, upipe_zvbienc->lines, 720);
+                memcpy(buf + stride, upipe_zvbienc->lines + 720, 720);
+            }
+            uref_pic_plane_unmap(uref, "y8", 0, 1, -1, 2);
+        }
     }
 
     upipe_zvbienc_output(upipe, uref, upump_p);
@@ -215,6 +255,7 @@ static struct upipe *upipe_zvbienc_alloc(struct upipe_mgr *mgr,
     upipe_zvbienc->sliced[0].line = upipe_zvbienc->sp.start[0];
     upipe_zvbienc->sliced[1].id = VBI_SLICED_CAPTION_525_F2;
     upipe_zvbienc->sliced[1].line = upipe_zvbienc->sp.start[1];
+    upipe_zvbienc->lines_valid = false;
 
     upipe_zvbienc_init_urefcount(upipe);
     upipe_zvbienc_init_output(upipe);
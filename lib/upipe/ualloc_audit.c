@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short Upipe audit of the allocations falling back to the system allocator
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uatomic.h>
+#include <upipe/uprobe.h>
+#include <upipe/ualloc_audit.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+/** @hidden */
+#define UALLOC_AUDIT_BACKTRACE
+#endif
+
+/** maximum number of distinct call sites */
+#define UALLOC_AUDIT_SITES 64
+/** maximum number of frames of a backtrace */
+#define UALLOC_AUDIT_FRAMES 16
+
+/** @internal @This describes a call site of fallback allocations. */
+struct ualloc_audit_site {
+    /** name of the kind of pool or manager */
+    const char *name;
+    /** number of frames of the backtrace */
+    int nb_frames;
+    /** backtrace of the call site */
+    void *frames[UALLOC_AUDIT_FRAMES];
+    /** number of fallback allocations */
+    uint64_t count;
+};
+
+/** true if the audit is armed */
+static uatomic_uint32_t ualloc_audit_armed;
+/** lock protecting the fields below */
+static uatomic_uint32_t ualloc_audit_spinlock;
+/** true if backtraces are recorded */
+static bool ualloc_audit_backtraces = false;
+/** number of fallback allocations */
+static uint64_t ualloc_audit_total = 0;
+/** call sites */
+static struct ualloc_audit_site ualloc_audit_sites[UALLOC_AUDIT_SITES];
+/** number of call sites */
+static unsigned int ualloc_audit_nb_sites = 0;
+
+/** @internal @This takes the lock. Contention only happens while fallback
+ * allocations are audited, which is a debug mode.
+ */
+static void ualloc_audit_lock(void)
+{
+    for (;;) {
+        uint32_t expected = 0;
+        if (uatomic_compare_exchange(&ualloc_audit_spinlock, &expected, 1))
+            return;
+    }
+}
+
+/** @internal @This releases the lock. */
+static void ualloc_audit_unlock(void)
+{
+    uatomic_store(&ualloc_audit_spinlock, 0);
+}
+
+/** @This marks the beginning of the steady state, resets the counters,
+ * and starts auditing fallback allocations.
+ *
+ * @param backtraces true to record the backtrace of each call site, where
+ * supported
+ */
+void ualloc_audit_checkpoint(bool backtraces)
+{
+    ualloc_audit_lock();
+    ualloc_audit_backtraces = backtraces;
+    ualloc_audit_total = 0;
+    ualloc_audit_nb_sites = 0;
+    ualloc_audit_unlock();
+#ifdef UALLOC_AUDIT_BACKTRACE
+    if (backtraces) {
+        /* the first call may load the unwinder, which allocates */
+        void *frame;
+        backtrace(&frame, 1);
+    }
+#endif
+    uatomic_store(&ualloc_audit_armed, 1);
+}
+
+/** @This stops auditing fallback allocations.
+ */
+void ualloc_audit_disarm(void)
+{
+    uatomic_store(&ualloc_audit_armed, 0);
+}
+
+/** @This is called by pools and memory managers when they fall back to the
+ * system allocator.
+ *
+ * @param name name of the kind of pool or manager
+ */
+void ualloc_audit_fallback(const char *name)
+{
+    if (likely(!uatomic_load(&ualloc_audit_armed)))
+        return;
+
+    void *frames[UALLOC_AUDIT_FRAMES + 1];
+    int nb_frames = 0;
+#ifdef UALLOC_AUDIT_BACKTRACE
+    if (ualloc_audit_backtraces)
+        nb_frames = backtrace(frames, UALLOC_AUDIT_FRAMES + 1);
+#endif
+    /* skip this function */
+    nb_frames = nb_frames > 1 ? nb_frames - 1 : 0;
+
+    ualloc_audit_lock();
+    ualloc_audit_total++;
+    unsigned int i;
+    for (i = 0; i < ualloc_audit_nb_sites; i++) {
+        struct ualloc_audit_site *site = &ualloc_audit_sites[i];
+        if (site->name == name && site->nb_frames == nb_frames &&
+            !memcmp(site->frames, frames + 1, nb_frames * sizeof(void *)))
+            break;
+    }
+    if (i == ualloc_audit_nb_sites && i < UALLOC_AUDIT_SITES) {
+        struct ualloc_audit_site *site = &ualloc_audit_sites[i];
+        site->name = name;
+        site->nb_frames = nb_frames;
+        memcpy(site->frames, frames + 1, nb_frames * sizeof(void *));
+        site->count = 0;
+        ualloc_audit_nb_sites++;
+    }
+    /* beyond the last site, allocations are only counted in the total */
+    if (i < ualloc_audit_nb_sites)
+        ualloc_audit_sites[i].count++;
+    ualloc_audit_unlock();
+}
+
+/** @This returns the number of fallback allocations since the checkpoint.
+ *
+ * @return number of fallback allocations
+ */
+uint64_t ualloc_audit_count(void)
+{
+    ualloc_audit_lock();
+    uint64_t total = ualloc_audit_total;
+    ualloc_audit_unlock();
+    return total;
+}
+
+/** @This reports the fallback allocations since the checkpoint as log
+ * events.
+ *
+ * @param uprobe pointer to probe hierarchy to throw the events to
+ * @return number of fallback allocations
+ */
+uint64_t ualloc_audit_report(struct uprobe *uprobe)
+{
+    /* copy the sites, as logging may allocate */
+    struct ualloc_audit_site *sites =
+        malloc(UALLOC_AUDIT_SITES * sizeof(struct ualloc_audit_site));
+    ualloc_audit_lock();
+    uint64_t total = ualloc_audit_total;
+    unsigned int nb_sites = sites != NULL ? ualloc_audit_nb_sites : 0;
+    if (sites != NULL)
+        memcpy(sites, ualloc_audit_sites, nb_sites * sizeof(*sites));
+    ualloc_audit_unlock();
+
+    if (!total) {
+        free(sites);
+        uprobe_notice(uprobe, NULL,
+                      "no fallback allocation since the checkpoint");
+        return 0;
+    }
+
+    uint64_t sites_total = 0;
+    for (unsigned int i = 0; i < nb_sites; i++) {
+        struct ualloc_audit_site *site = &sites[i];
+        sites_total += site->count;
+        uprobe_warn_va(uprobe, NULL,
+                       "%"PRIu64" fallback allocations from %s",
+                       site->count, site->name);
+        if (!site->nb_frames)
+            continue;
+#ifdef UALLOC_AUDIT_BACKTRACE
+        char **symbols = backtrace_symbols(site->frames, site->nb_frames);
+        for (int j = 0; j < site->nb_frames; j++)
+            uprobe_warn_va(uprobe, NULL, "  #%d %s", j,
+                           symbols != NULL ? symbols[j] : "?");
+        free(symbols);
+#endif
+    }
+    if (sites_total < total)
+        uprobe_warn_va(uprobe, NULL,
+                       "%"PRIu64" fallback allocations from other sites",
+                       total - sites_total);
+    free(sites);
+    return total;
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe buffer handling for block managers
+ * This file defines the block-specific API to access buffers.
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/ubuf_block.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/** @internal @This scans a contiguous buffer for a word repeated at a given
+ * stride.
+ *
+ * @param buffer pointer to the buffer
+ * @param end number of candidate positions, the buffer being at least
+ * end + (nb - 1) * stride octets long
+ * @param word word to scan for
+ * @param stride distance between two occurrences of the word, in octets
+ * @param nb number of occurrences of the word
+ * @return position of the first match, or end if none was found
+ */
+static size_t ubuf_block_scan_stride_buffer(const uint8_t *buffer, size_t end,
+                                            uint8_t word, size_t stride,
+                                            unsigned int nb)
+{
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256i words = _mm256_set1_epi8(word);
+    for ( ; i + 32 <= end; i += 32) {
+        uint32_t mask = 0xffffffff;
+        for (unsigned int k = 0; k < nb && mask; k++) {
+            __m256i data = _mm256_loadu_si256((const __m256i *)
+                                              (buffer + i + k * stride));
+            mask &= _mm256_movemask_epi8(_mm256_cmpeq_epi8(data, words));
+        }
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+#elif defined(__SSE2__)
+    const __m128i words = _mm_set1_epi8(word);
+    for ( ; i + 16 <= end; i += 16) {
+        uint32_t mask = 0xffff;
+        for (unsigned int k = 0; k < nb && mask; k++) {
+            __m128i data = _mm_loadu_si128((const __m128i *)
+                                           (buffer + i + k * stride));
+            mask &= _mm_movemask_epi8(_mm_cmpeq_epi8(data, words));
+        }
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t words = vdupq_n_u8(word);
+    for ( ; i + 16 <= end; i += 16) {
+        uint8x16_t match = vdupq_n_u8(0xff);
+        for (unsigned int k = 0; k < nb && vmaxvq_u8(match); k++)
+            match = vandq_u8(match, vceqq_u8(vld1q_u8(buffer + i + k * stride),
+                                             words));
+        if (vmaxvq_u8(match))
+            /* the scalar loop below returns the exact position */
+            break;
+    }
+#endif
+
+    while (i < end) {
+        const uint8_t *match = memchr(buffer + i, word, end - i);
+        if (match == NULL)
+            return end;
+        i = match - buffer;
+        unsigned int k;
+        for (k = 1; k < nb; k++)
+            if (buffer[i + k * stride] != word)
+                break;
+        if (k == nb)
+            return i;
+        i++;
+    }
+    return end;
+}
+
+/** @This scans for an octet word repeated at a given stride in a block ubuf,
+ * for instance the sync words of consecutive TS packets.
+ *
+ * @param ubuf pointer to ubuf
+ * @param offset_p start offset (in octets), written with the offset of the
+ * first wanted word, or first candidate if there aren't enough octets in the
+ * ubuf, or the total size of the ubuf if none was found
+ * @param word word to scan for
+ * @param stride distance between two occurrences of the word, in octets
+ * @param nb number of occurrences of the word
+ * @return UBASE_ERR_NONE if the word was found
+ */
+int ubuf_block_scan_stride(struct ubuf *ubuf, size_t *offset_p,
+                           uint8_t word, size_t stride, unsigned int nb)
+{
+    if (unlikely(!nb || !stride))
+        return UBASE_ERR_INVALID;
+    size_t span = (nb - 1) * stride;
+
+    for ( ; ; ) {
+        const uint8_t *buffer;
+        int size = -1;
+        UBASE_RETURN(ubuf_block_read(ubuf, *offset_p, &size, &buffer))
+
+        /* candidates which may be tested inside this segment */
+        size_t end = 0;
+        if ((size_t)size > span) {
+            end = size - span;
+            size_t found = ubuf_block_scan_stride_buffer(buffer, end, word,
+                                                         stride, nb);
+            if (found < end) {
+                ubuf_block_unmap(ubuf, *offset_p);
+                *offset_p += found;
+                return UBASE_ERR_NONE;
+            }
+        }
+
+        /* candidates spanning several segments */
+        const uint8_t *match = memchr(buffer + end, word, size - end);
+        ubuf_block_unmap(ubuf, *offset_p);
+        if (match == NULL) {
+            *offset_p += size;
+            continue;
+        }
+        *offset_p += match - buffer;
+
+        unsigned int k;
+        for (k = 1; k < nb; k++) {
+            uint8_t octet;
+            const uint8_t *read = ubuf_block_peek(ubuf,
+                    *offset_p + k * stride, 1, &octet);
+            if (read == NULL)
+                /* not enough octets */
+                return UBASE_ERR_INVALID;
+            bool found = *read == word;
+            ubuf_block_peek_unmap(ubuf, *offset_p + k * stride, &octet, read);
+            if (!found)
+                break;
+        }
+        if (k == nb)
+            return UBASE_ERR_NONE;
+        (*offset_p)++;
+    }
+    return UBASE_ERR_INVALID;
+}
@@ -44,6 +44,7 @@
 #include <upipe/uref_block_flow.h>
 
 #include <stdlib.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdarg.h>
 #include <string.h>
@@ -55,6 +56,8 @@
 #define UBUF_DEFAULT_PREPEND        32
 /** default minimum extra space after buffer when unspecified */
 #define UBUF_DEFAULT_APPEND         0
+/** alignment of slab elements and of their buffer */
+#define UBUF_SLAB_ALIGN             64
 
 /** @This is a super-set of the @ref ubuf (and @ref ubuf_block)
  * structure with private fields pointing to shared data. */
@@ -68,6 +71,24 @@ struct ubuf_block_mem {
 
 UBASE_FROM_TO(ubuf_block_mem, ubuf, ubuf, ubuf_block.ubuf)
 
+/** @This is a slab element, carrying in a single allocation a ubuf, its
+ * shared structure and a small buffer. The element is recycled with the
+ * last reference to the buffer, so the ubuf embedded in it may be released
+ * before. */
+struct ubuf_block_mem_slab {
+    /** shared structure, first so that the element is freed as such */
+    struct ubuf_mem_shared shared;
+    /** ubuf handed out with the element */
+    struct ubuf_block_mem block_mem;
+};
+
+UBASE_FROM_TO(ubuf_block_mem_slab, ubuf_mem_shared, shared, shared)
+
+/** size of the structures at the beginning of a slab element */
+#define UBUF_SLAB_HEADER                                                    \
+    ((sizeof(struct ubuf_block_mem_slab) + UBUF_SLAB_ALIGN - 1) &           \
+     ~(UBUF_SLAB_ALIGN - 1))
+
 /** @This is a super-set of the ubuf_mgr structure with additional local
  * members. */
 struct ubuf_block_mem_mgr {
@@ -82,6 +103,14 @@ struct ubuf_block_mem_mgr {
     size_t align;
     /** alignment offset */
     int align_offset;
+    /** true if new buffers use thread-local reference counts */
+    bool local;
+    /** size of the buffer of slab elements, or 0 if disabled */
+    size_t slab_size;
+    /** pool of slab elements */
+    struct upool slab_pool;
+    /** extra space for the slab pool */
+    uint8_t *slab_extra;
 
     /** ubuf pool */
     struct upool ubuf_pool;
@@ -100,9 +129,44 @@ struct ubuf_block_mem_mgr {
 UBASE_FROM_TO(ubuf_block_mem_mgr, ubuf_mgr, ubuf_mgr, mgr)
 UBASE_FROM_TO(ubuf_block_mem_mgr, urefcount, urefcount, urefcount)
 UBASE_FROM_TO(ubuf_block_mem_mgr, upool, ubuf_pool, ubuf_pool)
+UBASE_FROM_TO(ubuf_block_mem_mgr, upool, slab_pool, slab_pool)
 
 UBUF_MEM_MGR_HELPER_POOL(ubuf_block_mem, ubuf_pool, shared_pool, shared)
 
+/** @internal @This allocates a ubuf from a slab element.
+ *
+ * @param mgr common management structure
+ * @param size size of the block
+ * @return pointer to ubuf or NULL in case of allocation error
+ */
+static struct ubuf *ubuf_block_mem_alloc_slab(struct ubuf_mgr *mgr, int size)
+{
+    struct ubuf_block_mem_mgr *block_mem_mgr =
+        ubuf_block_mem_mgr_from_ubuf_mgr(mgr);
+    struct ubuf_block_mem_slab *slab =
+        upool_alloc(&block_mem_mgr->slab_pool, struct ubuf_block_mem_slab *);
+    if (unlikely(slab == NULL))
+        return NULL;
+
+    uatomic_store(&slab->shared.refcount, 1);
+    slab->shared.local = 0;
+    if (block_mem_mgr->local)
+        ubuf_mem_shared_set_local(&slab->shared);
+
+    struct ubuf_block_mem *block_mem = &slab->block_mem;
+    block_mem->shared = &slab->shared;
+    struct ubuf *ubuf = ubuf_block_mem_to_ubuf(block_mem);
+    ubuf_block_common_init(ubuf, false);
+
+    size_t offset = block_mem_mgr->prepend + block_mem_mgr->align;
+    if (block_mem_mgr->align)
+        offset -= ((uintptr_t)ubuf_mem_shared_buffer(&slab->shared) +
+                  offset + block_mem_mgr->align_offset) % block_mem_mgr->align;
+    ubuf_block_common_set(ubuf, offset, size);
+    ubuf_block_common_set_buffer(ubuf, ubuf_mem_shared_buffer(&slab->shared));
+    return ubuf;
+}
+
 /** @This allocates a ubuf, a shared structure and a umem buffer.
  *
  * @param mgr common management structure
@@ -118,6 +182,7 @@ static struct ubuf *ubuf_block_mem_alloc(struct ubuf_mgr *mgr,
     const char *plane_orig;
     struct ubuf_mem_shared *shared_orig;
     size_t offset_orig, size_orig;
+    struct umem *umem_orig = NULL;
     switch (signature) {
         case UBUF_ALLOC_BLOCK:
             size = va_arg(args, int);
@@ -147,12 +212,25 @@ static struct ubuf *ubuf_block_mem_alloc(struct ubuf_mgr *mgr,
                 return NULL;
             break;
 
+        case UBUF_BLOCK_MEM_ALLOC_FROM_UMEM:
+            umem_orig = va_arg(args, struct umem *);
+            if (unlikely(umem_orig == NULL || umem_orig->mgr == NULL ||
+                         umem_size(umem_orig) > INT_MAX))
+                return NULL;
+            break;
+
         default:
             return NULL;
     }
 
     struct ubuf_block_mem_mgr *block_mem_mgr =
         ubuf_block_mem_mgr_from_ubuf_mgr(mgr);
+    size_t buffer_size = size + block_mem_mgr->prepend + block_mem_mgr->align +
+        block_mem_mgr->append;
+    if (block_mem_mgr->slab_size && signature == UBUF_ALLOC_BLOCK &&
+        buffer_size <= block_mem_mgr->slab_size)
+        return ubuf_block_mem_alloc_slab(mgr, size);
+
     struct ubuf_block_mem *block_mem = ubuf_block_mem_alloc_pool(mgr);
     if (unlikely(block_mem == NULL))
         return NULL;
@@ -160,6 +238,22 @@ static struct ubuf *ubuf_block_mem_alloc(struct ubuf_mgr *mgr,
     struct ubuf *ubuf = ubuf_block_mem_to_ubuf(block_mem);
     ubuf_block_common_init(ubuf, false);
 
+    if (signature == UBUF_BLOCK_MEM_ALLOC_FROM_UMEM) {
+        /* We take ownership of an existing buffer. */
+        block_mem->shared = ubuf_block_mem_shared_alloc_pool(mgr);
+        if (unlikely(block_mem->shared == NULL)) {
+            ubuf_block_mem_free_pool(mgr, block_mem);
+            return NULL;
+        }
+        if (block_mem_mgr->local)
+            ubuf_mem_shared_set_local(block_mem->shared);
+        block_mem->shared->umem = *umem_orig;
+        ubuf_block_common_set(ubuf, 0, umem_size(umem_orig));
+        ubuf_block_common_set_buffer(ubuf,
+                                     ubuf_mem_shared_buffer(block_mem->shared));
+        return ubuf;
+    }
+
     if (signature != UBUF_ALLOC_BLOCK) {
         /* We reuse a shared structure. */
         block_mem->shared = ubuf_mem_shared_use(shared_orig);
@@ -174,9 +268,9 @@ static struct ubuf *ubuf_block_mem_alloc(struct ubuf_mgr *mgr,
         ubuf_block_mem_free_pool(mgr, block_mem);
         return NULL;
     }
+    if (block_mem_mgr->local)
+        ubuf_mem_shared_set_local(block_mem->shared);
 
-    size_t buffer_size = size + block_mem_mgr->prepend + block_mem_mgr->align +
-        block_mem_mgr->append;
     if (unlikely(!umem_alloc(block_mem_mgr->umem_mgr, &block_mem->shared->umem,
                              buffer_size))) {
         ubuf_block_mem_shared_free_pool(block_mem->shared);
@@ -233,6 +327,25 @@ static int ubuf_block_mem_single(struct ubuf *ubuf)
            UBASE_ERR_NONE : UBASE_ERR_BUSY;
 }
 
+/** @This returns the spare space after the exported part of the buffer, if
+ * it is not shared.
+ *
+ * @param ubuf pointer to ubuf
+ * @param tailroom_p filled in with the number of spare octets
+ * @return an error code
+ */
+static int ubuf_block_mem_tailroom(struct ubuf *ubuf, size_t *tailroom_p)
+{
+    struct ubuf_block_mem *block_mem = ubuf_block_mem_from_ubuf(ubuf);
+    struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
+    if (!ubuf_mem_shared_single(block_mem->shared))
+        return UBASE_ERR_BUSY;
+    size_t buffer_size = umem_size(&block_mem->shared->umem);
+    *tailroom_p = buffer_size > block->offset + block->size ?
+                  buffer_size - block->offset - block->size : 0;
+    return UBASE_ERR_NONE;
+}
+
 /** @This asks for the creation of a new reference to the same buffer space.
  *
  * @param ubuf pointer to ubuf
@@ -264,6 +377,22 @@ static int ubuf_block_mem_splice(struct ubuf *ubuf, struct ubuf **new_ubuf_p,
     return UBASE_ERR_NONE;
 }
 
+/** @This switches the reference counts of a ubuf and of the following
+ * ubufs of its chain to atomic ones.
+ *
+ * @param ubuf pointer to ubuf
+ * @return an error code
+ */
+static int ubuf_block_mem_share(struct ubuf *ubuf)
+{
+    struct ubuf_block_mem *block_mem = ubuf_block_mem_from_ubuf(ubuf);
+    ubuf_mem_shared_share(block_mem->shared);
+    struct ubuf *next = ubuf_block_from_ubuf(ubuf)->next_ubuf;
+    if (next != NULL)
+        ubuf_share(next);
+    return UBASE_ERR_NONE;
+}
+
 /** @This handles control commands.
  *
  * @param ubuf pointer to ubuf
@@ -280,6 +409,10 @@ static int ubuf_block_mem_control(struct ubuf *ubuf, int command, va_list args)
         }
         case UBUF_SINGLE:
             return ubuf_block_mem_single(ubuf);
+        case UBUF_SIZE_BLOCK_TAILROOM: {
+            size_t *tailroom_p = va_arg(args, size_t *);
+            return ubuf_block_mem_tailroom(ubuf, tailroom_p);
+        }
 
         case UBUF_SPLICE_BLOCK: {
             struct ubuf **new_ubuf_p = va_arg(args, struct ubuf **);
@@ -287,6 +420,8 @@ static int ubuf_block_mem_control(struct ubuf *ubuf, int command, va_list args)
             int size = va_arg(args, int);
             return ubuf_block_mem_splice(ubuf, new_ubuf_p, offset, size);
         }
+        case UBUF_SHARE:
+            return ubuf_block_mem_share(ubuf);
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -299,15 +434,23 @@ static int ubuf_block_mem_control(struct ubuf *ubuf, int command, va_list args)
 static void ubuf_block_mem_free(struct ubuf *ubuf)
 {
     struct ubuf_mgr *mgr = ubuf->mgr;
+    struct ubuf_block_mem_mgr *block_mem_mgr =
+        ubuf_block_mem_mgr_from_ubuf_mgr(mgr);
     struct ubuf_block_mem *block_mem = ubuf_block_mem_from_ubuf(ubuf);
+    struct ubuf_mem_shared *shared = block_mem->shared;
 
     ubuf_block_common_clean(ubuf);
 
-    if (unlikely(ubuf_mem_shared_release(block_mem->shared))) {
-        umem_free(&block_mem->shared->umem);
-        ubuf_block_mem_shared_free_pool(block_mem->shared);
+    bool slab = shared->pool == &block_mem_mgr->slab_pool;
+    bool embedded = slab &&
+        block_mem == &ubuf_block_mem_slab_from_shared(shared)->block_mem;
+    if (unlikely(ubuf_mem_shared_release(shared))) {
+        if (!slab)
+            umem_free(&shared->umem);
+        ubuf_block_mem_shared_free_pool(shared);
     }
-    ubuf_block_mem_free_pool(mgr, block_mem);
+    if (!embedded)
+        ubuf_block_mem_free_pool(mgr, block_mem);
 }
 
 /** @internal @This allocates the data structure.
@@ -339,6 +482,75 @@ static void ubuf_block_mem_free_inner(struct upool *upool, void *_block_mem)
     free(block_mem);
 }
 
+/** @internal @This allocates a slab element.
+ *
+ * @param upool pointer to upool
+ * @return pointer to ubuf_block_mem_slab or NULL in case of allocation error
+ */
+static void *ubuf_block_mem_slab_alloc_inner(struct upool *upool)
+{
+    struct ubuf_block_mem_mgr *block_mem_mgr =
+        ubuf_block_mem_mgr_from_slab_pool(upool);
+    void *element;
+    if (unlikely(posix_memalign(&element, UBUF_SLAB_ALIGN,
+                                UBUF_SLAB_HEADER + block_mem_mgr->slab_size)))
+        return NULL;
+
+    struct ubuf_block_mem_slab *slab = element;
+    uatomic_init(&slab->shared.refcount, 1);
+    slab->shared.local = 0;
+    slab->shared.pool = upool;
+    slab->shared.umem.mgr = NULL;
+    slab->shared.umem.buffer = (uint8_t *)element + UBUF_SLAB_HEADER;
+    slab->shared.umem.size = slab->shared.umem.real_size =
+        block_mem_mgr->slab_size;
+    struct ubuf *ubuf = ubuf_block_mem_to_ubuf(&slab->block_mem);
+    ubuf->mgr = ubuf_block_mem_mgr_to_ubuf_mgr(block_mem_mgr);
+    return slab;
+}
+
+/** @internal @This frees a slab element.
+ *
+ * @param upool pointer to upool
+ * @param _slab pointer to a ubuf_block_mem_slab structure to free
+ */
+static void ubuf_block_mem_slab_free_inner(struct upool *upool, void *_slab)
+{
+    struct ubuf_block_mem_slab *slab = (struct ubuf_block_mem_slab *)_slab;
+    uatomic_clean(&slab->shared.refcount);
+    free(slab);
+}
+
+/** @internal @This enables the allocation of small blocks from slab
+ * elements.
+ *
+ * @param mgr pointer to ubuf manager
+ * @param size size of the buffer of slab elements, including prepend,
+ * append and alignment
+ * @param depth maximum number of elements kept in the pool
+ * @return an error code
+ */
+static int ubuf_block_mem_mgr_set_slab_internal(struct ubuf_mgr *mgr,
+                                                unsigned int size,
+                                                unsigned int depth)
+{
+    struct ubuf_block_mem_mgr *block_mem_mgr =
+        ubuf_block_mem_mgr_from_ubuf_mgr(mgr);
+    if (block_mem_mgr->slab_size)
+        return UBASE_ERR_BUSY;
+    if (!size || size > INT_MAX || depth > UINT16_MAX)
+        return UBASE_ERR_INVALID;
+
+    block_mem_mgr->slab_extra = malloc(upool_sizeof(depth));
+    if (unlikely(block_mem_mgr->slab_extra == NULL))
+        return UBASE_ERR_ALLOC;
+    upool_init(&block_mem_mgr->slab_pool, mgr->refcount, depth,
+               block_mem_mgr->slab_extra, ubuf_block_mem_slab_alloc_inner,
+               ubuf_block_mem_slab_free_inner);
+    block_mem_mgr->slab_size = size;
+    return UBASE_ERR_NONE;
+}
+
 /** @This checks if the given flow format can be allocated with the manager.
  *
  * @param mgr pointer to ubuf manager
@@ -383,8 +595,29 @@ static int ubuf_block_mem_mgr_control(struct ubuf_mgr *mgr,
         }
         case UBUF_MGR_VACUUM: {
             ubuf_block_mem_mgr_vacuum_pool(mgr);
+            struct ubuf_block_mem_mgr *block_mem_mgr =
+                ubuf_block_mem_mgr_from_ubuf_mgr(mgr);
+            if (block_mem_mgr->slab_size)
+                upool_vacuum(&block_mem_mgr->slab_pool);
+            return UBASE_ERR_NONE;
+        }
+        case UBUF_BLOCK_MEM_MGR_SET_LOCAL: {
+            UBASE_SIGNATURE_CHECK(args, UBUF_BLOCK_MEM_SIGNATURE)
+            struct ubuf_block_mem_mgr *block_mem_mgr =
+                ubuf_block_mem_mgr_from_ubuf_mgr(mgr);
+            bool local = !!va_arg(args, int);
+            /* another reference may live in another thread */
+            if (local && !urefcount_single(mgr->refcount))
+                return UBASE_ERR_BUSY;
+            block_mem_mgr->local = local;
             return UBASE_ERR_NONE;
         }
+        case UBUF_BLOCK_MEM_MGR_SET_SLAB: {
+            UBASE_SIGNATURE_CHECK(args, UBUF_BLOCK_MEM_SIGNATURE)
+            unsigned int size = va_arg(args, unsigned int);
+            unsigned int depth = va_arg(args, unsigned int);
+            return ubuf_block_mem_mgr_set_slab_internal(mgr, size, depth);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -400,6 +633,10 @@ static void ubuf_block_mem_mgr_free(struct urefcount *urefcount)
         ubuf_block_mem_mgr_from_urefcount(urefcount);
     struct ubuf_mgr *mgr = ubuf_block_mem_mgr_to_ubuf_mgr(block_mem_mgr);
     ubuf_block_mem_mgr_clean_pool(mgr);
+    if (block_mem_mgr->slab_size) {
+        upool_clean(&block_mem_mgr->slab_pool);
+        free(block_mem_mgr->slab_extra);
+    }
     umem_mgr_release(block_mem_mgr->umem_mgr);
 
     urefcount_clean(urefcount);
@@ -439,6 +676,9 @@ struct ubuf_mgr *ubuf_block_mem_mgr_alloc(uint16_t ubuf_pool_depth,
     block_mem_mgr->append = append >= 0 ? append : UBUF_DEFAULT_APPEND;
     block_mem_mgr->align = align > 0 ? align : UBUF_DEFAULT_ALIGN;
     block_mem_mgr->align_offset = align_offset;
+    block_mem_mgr->local = false;
+    block_mem_mgr->slab_size = 0;
+    block_mem_mgr->slab_extra = NULL;
 
     urefcount_init(ubuf_block_mem_mgr_to_urefcount(block_mem_mgr),
                    ubuf_block_mem_mgr_free);
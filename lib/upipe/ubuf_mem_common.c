@@ -51,6 +51,7 @@ void *ubuf_mem_shared_alloc_inner(struct upool *upool)
     if (unlikely(shared == NULL))
         return NULL;
     uatomic_init(&shared->refcount, 1);
+    shared->local = 0;
     shared->pool = upool;
     return shared;
 }
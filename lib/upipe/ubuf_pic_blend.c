@@ -0,0 +1,783 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe line kernels for alpha blending of pictures
+ */
+
+#include <upipe/ubuf_pic.h>
+
+#include "ubuf_pic_blend.h"
+
+#if defined(__i686__) || defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/* All variants divide by 0xff rounding down, like the scalar code, so that
+ * their output is identical. The vector variants process the remaining
+ * samples with the C version, and stop early enough not to read the alpha
+ * plane past the last sample. */
+
+/** @internal @This returns the alpha value of a sample.
+ *
+ * @param alpha_plane alpha plane, or NULL
+ * @param alpha_hsub horizontal subsampling of the plane relative to the alpha
+ * plane
+ * @param j index of the sample
+ * @param alpha alpha multiplier
+ * @return alpha value between 0 and 0xff
+ */
+static inline unsigned int ubuf_pic_blend_alpha(const uint8_t *alpha_plane,
+                                                uint8_t alpha_hsub, int j,
+                                                uint8_t alpha)
+{
+    if (alpha_plane == NULL)
+        return alpha;
+    return alpha_plane[j * alpha_hsub] * alpha / 0xff;
+}
+
+void ubuf_pic_blend_8_c(uint8_t *dst, const uint8_t *src,
+                        const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                        int samples, uint8_t alpha)
+{
+    for (int j = 0; j < samples; j++) {
+        unsigned int a = ubuf_pic_blend_alpha(alpha_plane, alpha_hsub, j,
+                                              alpha);
+        dst[j] = (dst[j] * (0xff - a) + src[j] * a) / 0xff;
+    }
+}
+
+void ubuf_pic_blend_16_c(uint16_t *dst, const uint16_t *src,
+                         const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                         int samples, uint8_t alpha)
+{
+    for (int j = 0; j < samples; j++) {
+        uint32_t a = ubuf_pic_blend_alpha(alpha_plane, alpha_hsub, j, alpha);
+        dst[j] = (dst[j] * (0xff - a) + src[j] * a) / 0xff;
+    }
+}
+
+void ubuf_pic_key_8_c(uint8_t *dst, const uint8_t *src,
+                      const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                      int samples, uint8_t alpha, uint8_t threshold)
+{
+    for (int j = 0; j < samples; j++)
+        if (ubuf_pic_blend_alpha(alpha_plane, alpha_hsub, j, alpha) >
+            threshold)
+            dst[j] = src[j];
+}
+
+void ubuf_pic_key_16_c(uint16_t *dst, const uint16_t *src,
+                       const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                       int samples, uint8_t alpha, uint8_t threshold)
+{
+    for (int j = 0; j < samples; j++)
+        if (ubuf_pic_blend_alpha(alpha_plane, alpha_hsub, j, alpha) >
+            threshold)
+            dst[j] = src[j];
+}
+
+/** @internal @This returns the number of samples that the vector loops may
+ * process.
+ *
+ * @param alpha_plane alpha plane, or NULL
+ * @param alpha_hsub horizontal subsampling of the plane relative to the alpha
+ * plane
+ * @param samples number of samples
+ * @return number of samples
+ */
+static inline int ubuf_pic_blend_end(const uint8_t *alpha_plane,
+                                     uint8_t alpha_hsub, int samples)
+{
+    /* the last octet of each pair is read for subsampled planes */
+    return alpha_plane != NULL && alpha_hsub == 2 ? samples - 1 : samples;
+}
+
+#if defined(__i686__) || defined(__x86_64__)
+/** @internal @This divides 16-bit words up to 0xff * 0xff by 0xff. */
+__attribute__((target("sse2")))
+static inline __m128i ubuf_pic_div255_epu16_sse2(__m128i x)
+{
+    x = _mm_add_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)),
+                      _mm_set1_epi16(1));
+    return _mm_srli_epi16(x, 8);
+}
+
+/** @internal @This divides 32-bit words up to 0xffff * 0xff by 0xff. The
+ * first approximation may be one below the quotient. */
+__attribute__((target("sse2")))
+static inline __m128i ubuf_pic_div255_epi32_sse2(__m128i x)
+{
+    __m128i q = _mm_add_epi32(_mm_add_epi32(x, _mm_srli_epi32(x, 8)),
+            _mm_add_epi32(_mm_srli_epi32(x, 16), _mm_set1_epi32(1)));
+    q = _mm_srli_epi32(q, 8);
+    __m128i r = _mm_add_epi32(_mm_sub_epi32(x, _mm_slli_epi32(q, 8)), q);
+    return _mm_sub_epi32(q, _mm_cmpgt_epi32(r, _mm_set1_epi32(0xfe)));
+}
+
+/** @internal @This divides 16-bit words up to 0xff * 0xff by 0xff. */
+__attribute__((target("avx2")))
+static inline __m256i ubuf_pic_div255_epu16_avx2(__m256i x)
+{
+    x = _mm256_add_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)),
+                         _mm256_set1_epi16(1));
+    return _mm256_srli_epi16(x, 8);
+}
+
+/** @internal @This divides 32-bit words up to 0xffff * 0xff by 0xff. The
+ * first approximation may be one below the quotient. */
+__attribute__((target("avx2")))
+static inline __m256i ubuf_pic_div255_epi32_avx2(__m256i x)
+{
+    __m256i q = _mm256_add_epi32(_mm256_add_epi32(x, _mm256_srli_epi32(x, 8)),
+            _mm256_add_epi32(_mm256_srli_epi32(x, 16), _mm256_set1_epi32(1)));
+    q = _mm256_srli_epi32(q, 8);
+    __m256i r = _mm256_add_epi32(_mm256_sub_epi32(x, _mm256_slli_epi32(q, 8)),
+                                 q);
+    return _mm256_sub_epi32(q, _mm256_cmpgt_epi32(r, _mm256_set1_epi32(0xfe)));
+}
+
+/** @internal @This loads 16 alpha values as 16-bit words.
+ *
+ * @param alpha_plane alpha plane
+ * @param alpha_hsub horizontal subsampling (1 or 2)
+ * @param alpha alpha multiplier
+ * @param lo filled in with the first 8 values
+ * @param hi filled in with the last 8 values
+ */
+__attribute__((target("sse2")))
+static inline void ubuf_pic_blend_load_sse2(const uint8_t *alpha_plane,
+                                            uint8_t alpha_hsub, uint8_t alpha,
+                                            __m128i *lo, __m128i *hi)
+{
+    if (alpha_hsub == 1) {
+        __m128i a = _mm_loadu_si128((const __m128i *)alpha_plane);
+        *lo = _mm_unpacklo_epi8(a, _mm_setzero_si128());
+        *hi = _mm_unpackhi_epi8(a, _mm_setzero_si128());
+    } else {
+        const __m128i mask = _mm_set1_epi16(0xff);
+        *lo = _mm_and_si128(
+                _mm_loadu_si128((const __m128i *)alpha_plane), mask);
+        *hi = _mm_and_si128(
+                _mm_loadu_si128((const __m128i *)(alpha_plane + 16)), mask);
+    }
+    if (alpha != 0xff) {
+        const __m128i m = _mm_set1_epi16(alpha);
+        *lo = ubuf_pic_div255_epu16_sse2(_mm_mullo_epi16(*lo, m));
+        *hi = ubuf_pic_div255_epu16_sse2(_mm_mullo_epi16(*hi, m));
+    }
+}
+
+/** @internal @This blends 8 8-bit samples held in 16-bit words. */
+__attribute__((target("sse2")))
+static inline __m128i ubuf_pic_blend_8_sse2_words(__m128i d, __m128i s,
+                                                  __m128i a)
+{
+    __m128i x = _mm_add_epi16(
+            _mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(0xff), a)),
+            _mm_mullo_epi16(s, a));
+    return ubuf_pic_div255_epu16_sse2(x);
+}
+
+__attribute__((target("sse2")))
+void ubuf_pic_blend_8_sse2(uint8_t *dst, const uint8_t *src,
+                           const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                           int samples, uint8_t alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i alo = _mm_set1_epi16(alpha), ahi = alo;
+    int end = ubuf_pic_blend_end(alpha_plane, alpha_hsub, samples);
+    int i;
+    for (i = 0; i + 16 <= end; i += 16) {
+        if (alpha_plane != NULL)
+            ubuf_pic_blend_load_sse2(alpha_plane + i * alpha_hsub, alpha_hsub,
+                                     alpha, &alo, &ahi);
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i lo = ubuf_pic_blend_8_sse2_words(_mm_unpacklo_epi8(d, zero),
+                _mm_unpacklo_epi8(s, zero), alo);
+        __m128i hi = ubuf_pic_blend_8_sse2_words(_mm_unpackhi_epi8(d, zero),
+                _mm_unpackhi_epi8(s, zero), ahi);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    ubuf_pic_blend_8_c(dst + i, src + i,
+                       alpha_plane ? alpha_plane + i * alpha_hsub : NULL,
+                       alpha_hsub, samples - i, alpha);
+}
+
+/** @internal @This blends 4 16-bit samples held in 32-bit words, from
+ * their products with the alpha values. */
+__attribute__((target("sse2")))
+static inline __m128i ubuf_pic_blend_16_sse2_dwords(__m128i x)
+{
+    /* there is no unsigned saturation of 32-bit words with SSE2 */
+    return _mm_sub_epi32(ubuf_pic_div255_epi32_sse2(x),
+                         _mm_set1_epi32(0x8000));
+}
+
+__attribute__((target("sse2")))
+void ubuf_pic_blend_16_sse2(uint16_t *dst, const uint16_t *src,
+                            const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                            int samples, uint8_t alpha)
+{
+    __m128i a = _mm_set1_epi16(alpha);
+    int end = ubuf_pic_blend_end(alpha_plane, alpha_hsub, samples);
+    int i;
+    for (i = 0; i + 8 <= end; i += 8) {
+        if (alpha_plane != NULL) {
+            const uint8_t *p = alpha_plane + i * alpha_hsub;
+            if (alpha_hsub == 1)
+                a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)p),
+                                      _mm_setzero_si128());
+            else
+                a = _mm_and_si128(_mm_loadu_si128((const __m128i *)p),
+                                  _mm_set1_epi16(0xff));
+            if (alpha != 0xff)
+                a = ubuf_pic_div255_epu16_sse2(
+                        _mm_mullo_epi16(a, _mm_set1_epi16(alpha)));
+        }
+        __m128i na = _mm_sub_epi16(_mm_set1_epi16(0xff), a);
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i dl = _mm_mullo_epi16(d, na), dh = _mm_mulhi_epu16(d, na);
+        __m128i sl = _mm_mullo_epi16(s, a), sh = _mm_mulhi_epu16(s, a);
+        __m128i lo = ubuf_pic_blend_16_sse2_dwords(
+                _mm_add_epi32(_mm_unpacklo_epi16(dl, dh),
+                              _mm_unpacklo_epi16(sl, sh)));
+        __m128i hi = ubuf_pic_blend_16_sse2_dwords(
+                _mm_add_epi32(_mm_unpackhi_epi16(dl, dh),
+                              _mm_unpackhi_epi16(sl, sh)));
+        _mm_storeu_si128((__m128i *)(dst + i),
+                _mm_xor_si128(_mm_packs_epi32(lo, hi),
+                              _mm_set1_epi16((int16_t)0x8000)));
+    }
+    ubuf_pic_blend_16_c(dst + i, src + i,
+                        alpha_plane ? alpha_plane + i * alpha_hsub : NULL,
+                        alpha_hsub, samples - i, alpha);
+}
+
+__attribute__((target("sse2")))
+void ubuf_pic_key_8_sse2(uint8_t *dst, const uint8_t *src,
+                         const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                         int samples, uint8_t alpha, uint8_t threshold)
+{
+    if (threshold == 0xff)
+        return;
+    const __m128i thres = _mm_set1_epi8(threshold + 1);
+    int end = ubuf_pic_blend_end(alpha_plane, alpha_hsub, samples);
+    int i;
+    for (i = 0; i + 16 <= end; i += 16) {
+        __m128i lo, hi;
+        ubuf_pic_blend_load_sse2(alpha_plane + i * alpha_hsub, alpha_hsub,
+                                 alpha, &lo, &hi);
+        __m128i a = _mm_packus_epi16(lo, hi);
+        __m128i mask = _mm_cmpeq_epi8(_mm_max_epu8(a, thres), a);
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i),
+                _mm_or_si128(_mm_and_si128(mask, s),
+                             _mm_andnot_si128(mask, d)));
+    }
+    ubuf_pic_key_8_c(dst + i, src + i, alpha_plane + i * alpha_hsub,
+                     alpha_hsub, samples - i, alpha, threshold);
+}
+
+__attribute__((target("sse2")))
+void ubuf_pic_key_16_sse2(uint16_t *dst, const uint16_t *src,
+                          const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                          int samples, uint8_t alpha, uint8_t threshold)
+{
+    const __m128i thres = _mm_set1_epi16(threshold);
+    int end = ubuf_pic_blend_end(alpha_plane, alpha_hsub, samples);
+    int i;
+    for (i = 0; i + 16 <= end; i += 16) {
+        __m128i lo, hi;
+        ubuf_pic_blend_load_sse2(alpha_plane + i * alpha_hsub, alpha_hsub,
+                                 alpha, &lo, &hi);
+        for (int k = 0; k < 2; k++) {
+            __m128i mask = _mm_cmpgt_epi16(k ? hi : lo, thres);
+            __m128i d = _mm_loadu_si128((const __m128i *)(dst + i + 8 * k));
+            __m128i s = _mm_loadu_si128((const __m128i *)(src + i + 8 * k));
+            _mm_storeu_si128((__m128i *)(dst + i + 8 * k),
+                    _mm_or_si128(_mm_and_si128(mask, s),
+                                 _mm_andnot_si128(mask, d)));
+        }
+    }
+    ubuf_pic_key_16_c(dst + i, src + i, alpha_plane + i * alpha_hsub,
+                      alpha_hsub, samples - i, alpha, threshold);
+}
+
+/** @internal @This loads 32 alpha values as 16-bit words, in the order of
+ * _mm256_unpacklo_epi8 and _mm256_unpackhi_epi8.
+ *
+ * @param alpha_plane alpha plane
+ * @param alpha_hsub horizontal subsampling (1 or 2)
+ * @param alpha alpha multiplier
+ * @param lo filled in with values 0-7 and 16-23
+ * @param hi filled in with values 8-15 and 24-31
+ */
+__attribute__((target("avx2")))
+static inline void ubuf_pic_blend_load_avx2(const uint8_t *alpha_plane,
+                                            uint8_t alpha_hsub, uint8_t alpha,
+                                            __m256i *lo, __m256i *hi)
+{
+    if (alpha_hsub == 1) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)alpha_plane);
+        *lo = _mm256_unpacklo_epi8(a, _mm256_setzero_si256());
+        *hi = _mm256_unpackhi_epi8(a, _mm256_setzero_si256());
+    } else {
+        const __m256i mask = _mm256_set1_epi16(0xff);
+        __m256i a0 = _mm256_and_si256(
+                _mm256_loadu_si256((const __m256i *)alpha_plane), mask);
+        __m256i a1 = _mm256_and_si256(
+                _mm256_loadu_si256((const __m256i *)(alpha_plane + 32)), mask);
+        *lo = _mm256_permute2x128_si256(a0, a1, 0x20);
+        *hi = _mm256_permute2x128_si256(a0, a1, 0x31);
+    }
+    if (alpha != 0xff) {
+        const __m256i m = _mm256_set1_epi16(alpha);
+        *lo = ubuf_pic_div255_epu16_avx2(_mm256_mullo_epi16(*lo, m));
+        *hi = ubuf_pic_div255_epu16_avx2(_mm256_mullo_epi16(*hi, m));
+    }
+}
+
+/** @internal @This blends 16 8-bit samples held in 16-bit words. */
+__attribute__((target("avx2")))
+static inline __m256i ubuf_pic_blend_8_avx2_words(__m256i d, __m256i s,
+                                                  __m256i a)
+{
+    __m256i x = _mm256_add_epi16(
+            _mm256_mullo_epi16(d, _mm256_sub_epi16(_mm256_set1_epi16(0xff), a)),
+            _mm256_mullo_epi16(s, a));
+    return ubuf_pic_div255_epu16_avx2(x);
+}
+
+__attribute__((target("avx2")))
+void ubuf_pic_blend_8_avx2(uint8_t *dst, const uint8_t *src,
+                           const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                           int samples, uint8_t alpha)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i alo = _mm256_set1_epi16(alpha), ahi = alo;
+    int end = ubuf_pic_blend_end(alpha_plane, alpha_hsub, samples);
+    int i;
+    for (i = 0; i + 32 <= end; i += 32) {
+        if (alpha_plane != NULL)
+            ubuf_pic_blend_load_avx2(alpha_plane + i * alpha_hsub, alpha_hsub,
+                                     alpha, &alo, &ahi);
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i lo = ubuf_pic_blend_8_avx2_words(
+                _mm256_unpacklo_epi8(d, zero),
+                _mm256_unpacklo_epi8(s, zero), alo);
+        __m256i hi = ubuf_pic_blend_8_avx2_words(
+                _mm256_unpackhi_epi8(d, zero),
+                _mm256_unpackhi_epi8(s, zero), ahi);
+        _mm256_storeu_si256((__m256i *)(dst + i),
+                            _mm256_packus_epi16(lo, hi));
+    }
+    ubuf_pic_blend_8_c(dst + i, src + i,
+                       alpha_plane ? alpha_plane + i * alpha_hsub : NULL,
+                       alpha_hsub, samples - i, alpha);
+}
+
+__attribute__((target("avx2")))
+void ubuf_pic_blend_16_avx2(uint16_t *dst, const uint16_t *src,
+                            const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                            int samples, uint8_t alpha)
+{
+    __m256i a = _mm256_set1_epi16(alpha);
+    int end = ubuf_pic_blend_end(alpha_plane, alpha_hsub, samples);
+    int i;
+    for (i = 0; i + 16 <= end; i += 16) {
+        if (alpha_plane != NULL) {
+            const uint8_t *p = alpha_plane + i * alpha_hsub;
+            if (alpha_hsub == 1)
+                a = _mm256_cvtepu8_epi16(
+                        _mm_loadu_si128((const __m128i *)p));
+            else
+                a = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)p),
+                                     _mm256_set1_epi16(0xff));
+            if (alpha != 0xff)
+                a = ubuf_pic_div255_epu16_avx2(_mm256_mullo_epi16(a, _mm256_set1_epi16(alpha)));
+        }
+        __m256i na = _mm256_sub_epi16(_mm256_set1_epi16(0xff), a);
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i dl = _mm256_mullo_epi16(d, na), dh = _mm256_mulhi_epu16(d, na);
+        __m256i sl = _mm256_mullo_epi16(s, a), sh = _mm256_mulhi_epu16(s, a);
+        __m256i x = _mm256_add_epi32(_mm256_unpacklo_epi16(dl, dh),
+                                     _mm256_unpacklo_epi16(sl, sh));
+        __m256i lo = ubuf_pic_div255_epi32_avx2(x);
+        x = _mm256_add_epi32(_mm256_unpackhi_epi16(dl, dh),
+                             _mm256_unpackhi_epi16(sl, sh));
+        __m256i hi = ubuf_pic_div255_epi32_avx2(x);
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_packus_epi32(lo, hi));
+    }
+    ubuf_pic_blend_16_c(dst + i, src + i,
+                        alpha_plane ? alpha_plane + i * alpha_hsub : NULL,
+                        alpha_hsub, samples - i, alpha);
+}
+
+__attribute__((target("avx2")))
+void ubuf_pic_key_8_avx2(uint8_t *dst, const uint8_t *src,
+                         const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                         int samples, uint8_t alpha, uint8_t threshold)
+{
+    if (threshold == 0xff)
+        return;
+    const __m256i thres = _mm256_set1_epi8(threshold + 1);
+    int end = ubuf_pic_blend_end(alpha_plane, alpha_hsub, samples);
+    int i;
+    for (i = 0; i + 32 <= end; i += 32) {
+        __m256i lo, hi;
+        ubuf_pic_blend_load_avx2(alpha_plane + i * alpha_hsub, alpha_hsub,
+                                 alpha, &lo, &hi);
+        __m256i a = _mm256_packus_epi16(lo, hi);
+        __m256i mask = _mm256_cmpeq_epi8(_mm256_max_epu8(a, thres), a);
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i),
+                            _mm256_blendv_epi8(d, s, mask));
+    }
+    ubuf_pic_key_8_c(dst + i, src + i, alpha_plane + i * alpha_hsub,
+                     alpha_hsub, samples - i, alpha, threshold);
+}
+
+__attribute__((target("avx2")))
+void ubuf_pic_key_16_avx2(uint16_t *dst, const uint16_t *src,
+                          const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                          int samples, uint8_t alpha, uint8_t threshold)
+{
+    const __m256i thres = _mm256_set1_epi16(threshold);
+    int end = ubuf_pic_blend_end(alpha_plane, alpha_hsub, samples);
+    int i;
+    for (i = 0; i + 16 <= end; i += 16) {
+        const uint8_t *p = alpha_plane + i * alpha_hsub;
+        __m256i a;
+        if (alpha_hsub == 1)
+            a = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+        else
+            a = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)p),
+                                 _mm256_set1_epi16(0xff));
+        if (alpha != 0xff)
+            a = ubuf_pic_div255_epu16_avx2(_mm256_mullo_epi16(a, _mm256_set1_epi16(alpha)));
+        __m256i mask = _mm256_cmpgt_epi16(a, thres);
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i),
+                            _mm256_blendv_epi8(d, s, mask));
+    }
+    ubuf_pic_key_16_c(dst + i, src + i, alpha_plane + i * alpha_hsub,
+                      alpha_hsub, samples - i, alpha, threshold);
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/** @internal @This divides 16-bit words up to 0xff * 0xff by 0xff, and
+ * narrows them. */
+static inline uint8x8_t ubuf_pic_div255_neon(uint16x8_t x)
+{
+    return vshrn_n_u16(vaddq_u16(vsraq_n_u16(x, x, 8), vdupq_n_u16(1)), 8);
+}
+
+/** @internal @This divides 32-bit words up to 0xffff * 0xff by 0xff, and
+ * narrows them. The first approximation may be one below the quotient. */
+static inline uint16x4_t ubuf_pic_div255_u32_neon(uint32x4_t x)
+{
+    uint32x4_t q = vaddq_u32(vsraq_n_u32(x, x, 8),
+                             vsraq_n_u32(vdupq_n_u32(1), x, 16));
+    q = vshrq_n_u32(q, 8);
+    uint32x4_t r = vaddq_u32(vsubq_u32(x, vshlq_n_u32(q, 8)), q);
+    /* all ones adds one */
+    q = vsubq_u32(q, vcgtq_u32(r, vdupq_n_u32(0xfe)));
+    return vmovn_u32(q);
+}
+
+/** @internal @This loads 16 8-bit alpha values.
+ *
+ * @param alpha_plane alpha plane
+ * @param alpha_hsub horizontal subsampling (1 or 2)
+ * @param alpha alpha multiplier
+ * @return alpha values
+ */
+static inline uint8x16_t ubuf_pic_blend_load_neon(const uint8_t *alpha_plane,
+                                                  uint8_t alpha_hsub,
+                                                  uint8_t alpha)
+{
+    uint8x16_t a = alpha_hsub == 1 ? vld1q_u8(alpha_plane) :
+                   vld2q_u8(alpha_plane).val[0];
+    if (alpha != 0xff) {
+        const uint8x8_t m = vdup_n_u8(alpha);
+        a = vcombine_u8(
+                ubuf_pic_div255_neon(vmull_u8(vget_low_u8(a), m)),
+                ubuf_pic_div255_neon(vmull_high_u8(a, vdupq_n_u8(alpha))));
+    }
+    return a;
+}
+
+void ubuf_pic_blend_8_neon(uint8_t *dst, const uint8_t *src,
+                           const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                           int samples, uint8_t alpha)
+{
+    uint8x16_t a = vdupq_n_u8(alpha);
+    int end = ubuf_pic_blend_end(alpha_plane, alpha_hsub, samples);
+    int i;
+    for (i = 0; i + 16 <= end; i += 16) {
+        if (alpha_plane != NULL)
+            a = ubuf_pic_blend_load_neon(alpha_plane + i * alpha_hsub,
+                                         alpha_hsub, alpha);
+        uint8x16_t na = vmvnq_u8(a);
+        uint8x16_t d = vld1q_u8(dst + i);
+        uint8x16_t s = vld1q_u8(src + i);
+        uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(d), vget_low_u8(na)),
+                                 vget_low_u8(s), vget_low_u8(a));
+        uint16x8_t hi = vmlal_high_u8(vmull_high_u8(d, na), s, a);
+        vst1q_u8(dst + i, vcombine_u8(ubuf_pic_div255_neon(lo),
+                                      ubuf_pic_div255_neon(hi)));
+    }
+    ubuf_pic_blend_8_c(dst + i, src + i,
+                       alpha_plane ? alpha_plane + i * alpha_hsub : NULL,
+                       alpha_hsub, samples - i, alpha);
+}
+
+void ubuf_pic_blend_16_neon(uint16_t *dst, const uint16_t *src,
+                            const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                            int samples, uint8_t alpha)
+{
+    uint8x16_t a = vdupq_n_u8(alpha);
+    int end = ubuf_pic_blend_end(alpha_plane, alpha_hsub, samples);
+    int i;
+    for (i = 0; i + 16 <= end; i += 16) {
+        if (alpha_plane != NULL)
+            a = ubuf_pic_blend_load_neon(alpha_plane + i * alpha_hsub,
+                                         alpha_hsub, alpha);
+        uint16x8_t a16[2] = { vmovl_u8(vget_low_u8(a)), vmovl_high_u8(a) };
+        for (int k = 0; k < 2; k++) {
+            uint16x8_t na = vsubq_u16(vdupq_n_u16(0xff), a16[k]);
+            uint16x8_t d = vld1q_u16(dst + i + 8 * k);
+            uint16x8_t s = vld1q_u16(src + i + 8 * k);
+            uint32x4_t lo = vmlal_u16(vmull_u16(vget_low_u16(d),
+                                                vget_low_u16(na)),
+                                      vget_low_u16(s), vget_low_u16(a16[k]));
+            uint32x4_t hi = vmlal_high_u16(vmull_high_u16(d, na), s, a16[k]);
+            vst1q_u16(dst + i + 8 * k,
+                      vcombine_u16(ubuf_pic_div255_u32_neon(lo),
+                                   ubuf_pic_div255_u32_neon(hi)));
+        }
+    }
+    ubuf_pic_blend_16_c(dst + i, src + i,
+                        alpha_plane ? alpha_plane + i * alpha_hsub : NULL,
+                        alpha_hsub, samples - i, alpha);
+}
+
+void ubuf_pic_key_8_neon(uint8_t *dst, const uint8_t *src,
+                         const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                         int samples, uint8_t alpha, uint8_t threshold)
+{
+    const uint8x16_t thres = vdupq_n_u8(threshold);
+    int end = ubuf_pic_blend_end(alpha_plane, alpha_hsub, samples);
+    int i;
+    for (i = 0; i + 16 <= end; i += 16) {
+        uint8x16_t a = ubuf_pic_blend_load_neon(alpha_plane + i * alpha_hsub,
+                                                alpha_hsub, alpha);
+        vst1q_u8(dst + i, vbslq_u8(vcgtq_u8(a, thres), vld1q_u8(src + i),
+                                   vld1q_u8(dst + i)));
+    }
+    ubuf_pic_key_8_c(dst + i, src + i, alpha_plane + i * alpha_hsub,
+                     alpha_hsub, samples - i, alpha, threshold);
+}
+
+void ubuf_pic_key_16_neon(uint16_t *dst, const uint16_t *src,
+                          const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                          int samples, uint8_t alpha, uint8_t threshold)
+{
+    const uint8x16_t thres = vdupq_n_u8(threshold);
+    int end = ubuf_pic_blend_end(alpha_plane, alpha_hsub, samples);
+    int i;
+    for (i = 0; i + 16 <= end; i += 16) {
+        uint8x16_t a = ubuf_pic_blend_load_neon(alpha_plane + i * alpha_hsub,
+                                                alpha_hsub, alpha);
+        uint8x16_t mask = vcgtq_u8(a, thres);
+        uint16x8_t m0 = vreinterpretq_u16_u8(vzip1q_u8(mask, mask));
+        uint16x8_t m1 = vreinterpretq_u16_u8(vzip2q_u8(mask, mask));
+        vst1q_u16(dst + i, vbslq_u16(m0, vld1q_u16(src + i),
+                                     vld1q_u16(dst + i)));
+        vst1q_u16(dst + i + 8, vbslq_u16(m1, vld1q_u16(src + i + 8),
+                                         vld1q_u16(dst + i + 8)));
+    }
+    ubuf_pic_key_16_c(dst + i, src + i, alpha_plane + i * alpha_hsub,
+                      alpha_hsub, samples - i, alpha, threshold);
+}
+#endif
+
+/** @This blends a line of 8-bit samples, using the fastest variant supported
+ * by the CPU.
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param alpha_plane alpha values, or NULL to use alpha for all samples
+ * @param alpha_hsub horizontal subsampling of the samples relative to the
+ * alpha values
+ * @param samples number of samples
+ * @param alpha alpha multiplier
+ */
+void ubuf_pic_blend_8(uint8_t *dst, const uint8_t *src,
+                      const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                      int samples, uint8_t alpha)
+{
+    if (alpha_plane == NULL || alpha_hsub <= 2) {
+#if defined(__i686__) || defined(__x86_64__)
+        if (__builtin_cpu_supports("avx2")) {
+            ubuf_pic_blend_8_avx2(dst, src, alpha_plane, alpha_hsub, samples,
+                                  alpha);
+            return;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            ubuf_pic_blend_8_sse2(dst, src, alpha_plane, alpha_hsub, samples,
+                                  alpha);
+            return;
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        ubuf_pic_blend_8_neon(dst, src, alpha_plane, alpha_hsub, samples,
+                              alpha);
+        return;
+#endif
+    }
+    ubuf_pic_blend_8_c(dst, src, alpha_plane, alpha_hsub, samples, alpha);
+}
+
+/** @This blends a line of 16-bit samples, using the fastest variant
+ * supported by the CPU.
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param alpha_plane alpha values, or NULL to use alpha for all samples
+ * @param alpha_hsub horizontal subsampling of the samples relative to the
+ * alpha values
+ * @param samples number of samples
+ * @param alpha alpha multiplier
+ */
+void ubuf_pic_blend_16(uint16_t *dst, const uint16_t *src,
+                       const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                       int samples, uint8_t alpha)
+{
+    if (alpha_plane == NULL || alpha_hsub <= 2) {
+#if defined(__i686__) || defined(__x86_64__)
+        if (__builtin_cpu_supports("avx2")) {
+            ubuf_pic_blend_16_avx2(dst, src, alpha_plane, alpha_hsub, samples,
+                                   alpha);
+            return;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            ubuf_pic_blend_16_sse2(dst, src, alpha_plane, alpha_hsub, samples,
+                                   alpha);
+            return;
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        ubuf_pic_blend_16_neon(dst, src, alpha_plane, alpha_hsub, samples,
+                               alpha);
+        return;
+#endif
+    }
+    ubuf_pic_blend_16_c(dst, src, alpha_plane, alpha_hsub, samples, alpha);
+}
+
+/** @This copies the 8-bit samples of a line whose alpha value is above a
+ * threshold, using the fastest variant supported by the CPU.
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param alpha_plane alpha values
+ * @param alpha_hsub horizontal subsampling of the samples relative to the
+ * alpha values
+ * @param samples number of samples
+ * @param alpha alpha multiplier
+ * @param threshold alpha threshold
+ */
+void ubuf_pic_key_8(uint8_t *dst, const uint8_t *src,
+                    const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                    int samples, uint8_t alpha, uint8_t threshold)
+{
+    if (alpha_hsub <= 2) {
+#if defined(__i686__) || defined(__x86_64__)
+        if (__builtin_cpu_supports("avx2")) {
+            ubuf_pic_key_8_avx2(dst, src, alpha_plane, alpha_hsub, samples,
+                                alpha, threshold);
+            return;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            ubuf_pic_key_8_sse2(dst, src, alpha_plane, alpha_hsub, samples,
+                                alpha, threshold);
+            return;
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        ubuf_pic_key_8_neon(dst, src, alpha_plane, alpha_hsub, samples,
+                            alpha, threshold);
+        return;
+#endif
+    }
+    ubuf_pic_key_8_c(dst, src, alpha_plane, alpha_hsub, samples, alpha,
+                     threshold);
+}
+
+/** @This copies the 16-bit samples of a line whose alpha value is above a
+ * threshold, using the fastest variant supported by the CPU.
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param alpha_plane alpha values
+ * @param alpha_hsub horizontal subsampling of the samples relative to the
+ * alpha values
+ * @param samples number of samples
+ * @param alpha alpha multiplier
+ * @param threshold alpha threshold
+ */
+void ubuf_pic_key_16(uint16_t *dst, const uint16_t *src,
+                     const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                     int samples, uint8_t alpha, uint8_t threshold)
+{
+    if (alpha_hsub <= 2) {
+#if defined(__i686__) || defined(__x86_64__)
+        if (__builtin_cpu_supports("avx2")) {
+            ubuf_pic_key_16_avx2(dst, src, alpha_plane, alpha_hsub, samples,
+                                 alpha, threshold);
+            return;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            ubuf_pic_key_16_sse2(dst, src, alpha_plane, alpha_hsub, samples,
+                                 alpha, threshold);
+            return;
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        ubuf_pic_key_16_neon(dst, src, alpha_plane, alpha_hsub, samples,
+                             alpha, threshold);
+        return;
+#endif
+    }
+    ubuf_pic_key_16_c(dst, src, alpha_plane, alpha_hsub, samples, alpha,
+                      threshold);
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe line kernels for alpha blending of pictures
+ * The variants below are called by the ubuf_pic_blend_* and ubuf_pic_key_*
+ * functions, which pick the fastest one supported by the CPU. They are
+ * exported for checkasm.
+ *
+ * The alpha value of sample j is alpha_plane[j * alpha_hsub] multiplied by
+ * alpha / 0xff, or alpha if there is no alpha plane. The key variants require
+ * an alpha plane. The vector variants only handle alpha_hsub values of 1 and
+ * 2.
+ */
+
+#ifndef _LIB_UPIPE_UBUF_PIC_BLEND_H_
+/** @hidden */
+#define _LIB_UPIPE_UBUF_PIC_BLEND_H_
+
+#include <stdint.h>
+
+/** @This declares the kernels of a variant.
+ *
+ * @param suffix name of the variant
+ */
+#define UBUF_PIC_BLEND_DECLARE(suffix)                                      \
+void ubuf_pic_blend_8_##suffix(uint8_t *dst, const uint8_t *src,            \
+        const uint8_t *alpha_plane, uint8_t alpha_hsub, int samples,        \
+        uint8_t alpha);                                                     \
+void ubuf_pic_blend_16_##suffix(uint16_t *dst, const uint16_t *src,         \
+        const uint8_t *alpha_plane, uint8_t alpha_hsub, int samples,        \
+        uint8_t alpha);                                                     \
+void ubuf_pic_key_8_##suffix(uint8_t *dst, const uint8_t *src,              \
+        const uint8_t *alpha_plane, uint8_t alpha_hsub, int samples,        \
+        uint8_t alpha, uint8_t threshold);                                  \
+void ubuf_pic_key_16_##suffix(uint16_t *dst, const uint16_t *src,           \
+        const uint8_t *alpha_plane, uint8_t alpha_hsub, int samples,        \
+        uint8_t alpha, uint8_t threshold);
+
+/* one sample at a time */
+UBUF_PIC_BLEND_DECLARE(c)
+
+#if defined(__i686__) || defined(__x86_64__)
+/* 16 samples at a time, or 8 for ubuf_pic_blend_16_sse2 */
+UBUF_PIC_BLEND_DECLARE(sse2)
+/* 32 (8-bit) or 16 (16-bit) samples at a time */
+UBUF_PIC_BLEND_DECLARE(avx2)
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/* 16 samples at a time */
+UBUF_PIC_BLEND_DECLARE(neon)
+#endif
+
+#undef UBUF_PIC_BLEND_DECLARE
+
+#endif
@@ -31,7 +31,9 @@
 #include <upipe/uatomic.h>
 #include <upipe/urefcount.h>
 #include <upipe/upool.h>
+#include <upipe/ulifo.h>
 #include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
 #include <upipe/ubuf.h>
 #include <upipe/ubuf_pic.h>
 #include <upipe/ubuf_pic_common.h>
@@ -75,6 +77,22 @@ struct ubuf_pic_mem {
 
 UBASE_FROM_TO(ubuf_pic_mem, ubuf, ubuf, ubuf_pic_common.ubuf)
 
+/** @This is a pool of frame buffers of exact size. Buffers are copied in and
+ * out of preallocated slots, so that a buffer sitting in the pool doesn't
+ * hold a reference to the manager. */
+struct ubuf_pic_mem_frame_pool {
+    /** exact-size allocator for frame buffers */
+    struct umem_mgr *umem_mgr;
+    /** LIFO of slots carrying a frame buffer */
+    struct ulifo frames;
+    /** LIFO of free slots */
+    struct ulifo slots;
+    /** extra space for the LIFOs */
+    uint8_t *lifo_extra;
+    /** slots */
+    struct umem umems[];
+};
+
 /** @This is a super-set of the ubuf_mgr structure with additional local
  * members. */
 struct ubuf_pic_mem_mgr {
@@ -100,6 +118,8 @@ struct ubuf_pic_mem_mgr {
     struct upool shared_pool;
     /** umem allocator */
     struct umem_mgr *umem_mgr;
+    /** exact-size frame pool, or NULL */
+    struct ubuf_pic_mem_frame_pool *frame_pool;
 
     /** common picture management structure */
     struct ubuf_pic_common_mgr common_mgr;
@@ -114,6 +134,111 @@ UBASE_FROM_TO(ubuf_pic_mem_mgr, upool, ubuf_pool, ubuf_pool)
 
 UBUF_MEM_MGR_HELPER_POOL(ubuf_pic_mem, ubuf_pool, shared_pool, shared)
 
+/** @internal @This allocates a frame buffer, from the frame pool if a buffer
+ * of the right size is available.
+ *
+ * @param pic_mgr pointer to the ubuf_pic_mem_mgr structure
+ * @param umem caller-allocated structure, filled in
+ * @param size exact size of the frame buffer
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool ubuf_pic_mem_frame_alloc(struct ubuf_pic_mem_mgr *pic_mgr,
+                                     struct umem *umem, size_t size)
+{
+    struct ubuf_pic_mem_frame_pool *pool = pic_mgr->frame_pool;
+    if (pool == NULL)
+        return umem_alloc(pic_mgr->umem_mgr, umem, size);
+
+    struct umem *slot = ulifo_pop(&pool->frames, struct umem *);
+    if (slot != NULL) {
+        /* the dimensions are the only parameters of the layout that are not
+         * fixed by the manager, so the size is enough to key the frames */
+        bool match = umem_size(slot) == size;
+        if (match)
+            *umem = *slot;
+        else
+            umem_free(slot);
+        ulifo_push(&pool->slots, slot);
+        if (match)
+            return true;
+    }
+    return umem_alloc(pool->umem_mgr, umem, size);
+}
+
+/** @internal @This releases a frame buffer, to the frame pool if possible.
+ *
+ * @param pic_mgr pointer to the ubuf_pic_mem_mgr structure
+ * @param umem pointer to the umem to release
+ */
+static void ubuf_pic_mem_frame_free(struct ubuf_pic_mem_mgr *pic_mgr,
+                                    struct umem *umem)
+{
+    struct ubuf_pic_mem_frame_pool *pool = pic_mgr->frame_pool;
+    if (pool != NULL && umem->mgr == pool->umem_mgr) {
+        struct umem *slot = ulifo_pop(&pool->slots, struct umem *);
+        if (slot != NULL) {
+            *slot = *umem;
+            ulifo_push(&pool->frames, slot);
+            return;
+        }
+    }
+    umem_free(umem);
+}
+
+/** @internal @This frees the frame buffers kept in the frame pool.
+ *
+ * @param pic_mgr pointer to the ubuf_pic_mem_mgr structure
+ */
+static void ubuf_pic_mem_frame_vacuum(struct ubuf_pic_mem_mgr *pic_mgr)
+{
+    struct ubuf_pic_mem_frame_pool *pool = pic_mgr->frame_pool;
+    if (pool == NULL)
+        return;
+
+    struct umem *slot;
+    while ((slot = ulifo_pop(&pool->frames, struct umem *)) != NULL) {
+        umem_free(slot);
+        ulifo_push(&pool->slots, slot);
+    }
+}
+
+/** @internal @This enables the exact-size frame pool.
+ *
+ * @param mgr pointer to ubuf manager
+ * @param depth maximum number of frames kept in the pool
+ * @return an error code
+ */
+static int ubuf_pic_mem_mgr_set_frame_pool_internal(struct ubuf_mgr *mgr,
+                                                    unsigned int depth)
+{
+    struct ubuf_pic_mem_mgr *pic_mgr = ubuf_pic_mem_mgr_from_ubuf_mgr(mgr);
+    if (pic_mgr->frame_pool != NULL)
+        return UBASE_ERR_BUSY;
+    if (!depth || depth > UINT16_MAX)
+        return UBASE_ERR_INVALID;
+
+    struct ubuf_pic_mem_frame_pool *pool =
+        malloc(sizeof(struct ubuf_pic_mem_frame_pool) +
+               depth * sizeof(struct umem));
+    if (unlikely(pool == NULL))
+        return UBASE_ERR_ALLOC;
+    pool->lifo_extra = malloc(2 * ulifo_sizeof(depth));
+    pool->umem_mgr = umem_alloc_mgr_alloc();
+    if (unlikely(pool->lifo_extra == NULL || pool->umem_mgr == NULL)) {
+        umem_mgr_release(pool->umem_mgr);
+        free(pool->lifo_extra);
+        free(pool);
+        return UBASE_ERR_ALLOC;
+    }
+
+    ulifo_init(&pool->frames, depth, pool->lifo_extra);
+    ulifo_init(&pool->slots, depth, pool->lifo_extra + ulifo_sizeof(depth));
+    for (unsigned int i = 0; i < depth; i++)
+        ulifo_push(&pool->slots, &pool->umems[i]);
+    pic_mgr->frame_pool = pool;
+    return UBASE_ERR_NONE;
+}
+
 /** @This allocates a ubuf, a shared structure and a umem buffer.
  *
  * @param mgr common management structure
@@ -170,8 +295,8 @@ static struct ubuf *ubuf_pic_mem_alloc(struct ubuf_mgr *mgr,
         buffer_size += plane_sizes[plane];
     }
 
-    if (unlikely(!umem_alloc(pic_mgr->umem_mgr, &pic_mem->shared->umem,
-                             buffer_size))) {
+    if (unlikely(!ubuf_pic_mem_frame_alloc(pic_mgr, &pic_mem->shared->umem,
+                                           buffer_size))) {
         ubuf_pic_mem_shared_free_pool(pic_mem->shared);
         ubuf_pic_mem_free_pool(mgr, pic_mem);
         return NULL;
@@ -387,7 +512,7 @@ static void ubuf_pic_mem_free(struct ubuf *ubuf)
 #endif
 
     if (unlikely(ubuf_mem_shared_release(pic_mem->shared))) {
-        umem_free(&pic_mem->shared->umem);
+        ubuf_pic_mem_frame_free(pic_mgr, &pic_mem->shared->umem);
         ubuf_pic_mem_shared_free_pool(pic_mem->shared);
     }
     ubuf_pic_mem_free_pool(mgr, pic_mem);
@@ -461,10 +586,12 @@ static int ubuf_pic_mem_mgr_check(struct ubuf_mgr *mgr,
     struct ubuf_pic_common_mgr *common_mgr =
         ubuf_pic_common_mgr_from_ubuf_mgr(mgr);
     struct ubuf_pic_mem_mgr *pic_mgr = ubuf_pic_mem_mgr_from_ubuf_mgr(mgr);
+    /* more padding than required is harmless, for instance when a probe
+     * adds padding to all the managers it allocates */
     if (common_mgr->macropixel != macropixel ||
         common_mgr->nb_planes != planes ||
-        pic_mgr->hmprepend != hmprepend || pic_mgr->hmappend != hmappend ||
-        pic_mgr->vprepend != vprepend || pic_mgr->vappend != vappend)
+        pic_mgr->hmprepend < hmprepend || pic_mgr->hmappend < hmappend ||
+        pic_mgr->vprepend < vprepend || pic_mgr->vappend < vappend)
         return UBASE_ERR_INVALID;
     if (align && (!pic_mgr->align ||
                   pic_mgr->align % align ||
@@ -506,8 +633,14 @@ static int ubuf_pic_mem_mgr_control(struct ubuf_mgr *mgr,
         }
         case UBUF_MGR_VACUUM: {
             ubuf_pic_mem_mgr_vacuum_pool(mgr);
+            ubuf_pic_mem_frame_vacuum(ubuf_pic_mem_mgr_from_ubuf_mgr(mgr));
             return UBASE_ERR_NONE;
         }
+        case UBUF_PIC_MEM_MGR_SET_FRAME_POOL: {
+            UBASE_SIGNATURE_CHECK(args, UBUF_PIC_MEM_SIGNATURE)
+            unsigned int depth = va_arg(args, unsigned int);
+            return ubuf_pic_mem_mgr_set_frame_pool_internal(mgr, depth);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -524,6 +657,14 @@ static void ubuf_pic_mem_mgr_free(struct urefcount *urefcount)
     struct ubuf_mgr *mgr = ubuf_pic_mem_mgr_to_ubuf_mgr(pic_mgr);
     ubuf_pic_mem_mgr_clean_pool(mgr);
     umem_mgr_release(pic_mgr->umem_mgr);
+    if (pic_mgr->frame_pool != NULL) {
+        ubuf_pic_mem_frame_vacuum(pic_mgr);
+        ulifo_clean(&pic_mgr->frame_pool->frames);
+        ulifo_clean(&pic_mgr->frame_pool->slots);
+        umem_mgr_release(pic_mgr->frame_pool->umem_mgr);
+        free(pic_mgr->frame_pool->lifo_extra);
+        free(pic_mgr->frame_pool);
+    }
 
     ubuf_pic_common_mgr_clean(mgr);
 
@@ -599,6 +740,7 @@ struct ubuf_mgr *ubuf_pic_mem_mgr_alloc(uint16_t ubuf_pool_depth,
 
     pic_mgr->umem_mgr = umem_mgr;
     umem_mgr_use(umem_mgr);
+    pic_mgr->frame_pool = NULL;
 
     return mgr;
 }
@@ -55,6 +55,9 @@
 struct ubuf_sound_mem {
     /** pointer to shared structure */
     struct ubuf_mem_shared *shared;
+    /** true if the shared structure was borrowed from another ubuf, and must
+     * be copied before writing */
+    bool view;
 #ifndef NDEBUG
     /** atomic counter of the number of readers, to check for unsufficient
      * use of unmap() */
@@ -96,37 +99,25 @@ UBASE_FROM_TO(ubuf_sound_mem_mgr, upool, ubuf_pool, ubuf_pool)
 
 UBUF_MEM_MGR_HELPER_POOL(ubuf_sound_mem, ubuf_pool, shared_pool, shared)
 
-/** @This allocates a ubuf, a shared structure and a umem buffer.
+/** @internal @This allocates a shared structure and a umem buffer for a ubuf,
+ * and points the planes to it.
  *
  * @param mgr common management structure
- * @param alloc_type must be UBUF_ALLOC_SOUND (sentinel)
- * @param args optional arguments (1st = size)
- * @return pointer to ubuf or NULL in case of allocation error
+ * @param sound_mem pointer to the ubuf_sound_mem structure
+ * @param size number of samples
+ * @return an error code
  */
-static struct ubuf *ubuf_sound_mem_alloc(struct ubuf_mgr *mgr,
-                                         uint32_t signature, va_list args)
+static int ubuf_sound_mem_alloc_buffer(struct ubuf_mgr *mgr,
+                                       struct ubuf_sound_mem *sound_mem,
+                                       size_t size)
 {
-    if (unlikely(signature != UBUF_ALLOC_SOUND))
-        return NULL;
-
-    int ssize = va_arg(args, int);
-    if (ssize < 0)
-        return NULL;
-    size_t size = ssize;
-
     struct ubuf_sound_mem_mgr *sound_mgr =
         ubuf_sound_mem_mgr_from_ubuf_mgr(mgr);
-    struct ubuf_sound_mem *sound_mem = ubuf_sound_mem_alloc_pool(mgr);
-    if (unlikely(sound_mem == NULL))
-        return NULL;
-
     struct ubuf *ubuf = ubuf_sound_mem_to_ubuf(sound_mem);
 
     sound_mem->shared = ubuf_sound_mem_shared_alloc_pool(mgr);
-    if (unlikely(sound_mem->shared == NULL)) {
-        ubuf_sound_mem_free_pool(mgr, sound_mem);
-        return NULL;
-    }
+    if (unlikely(sound_mem->shared == NULL))
+        return UBASE_ERR_ALLOC;
 
     size_t buffer_size = 0;
     size_t plane_sizes[sound_mgr->common_mgr.nb_planes];
@@ -145,10 +136,8 @@ static struct ubuf *ubuf_sound_mem_alloc(struct ubuf_mgr *mgr,
     if (unlikely(!umem_alloc(sound_mgr->umem_mgr, &sound_mem->shared->umem,
                              buffer_size))) {
         ubuf_sound_mem_shared_free_pool(sound_mem->shared);
-        ubuf_sound_mem_free_pool(mgr, sound_mem);
-        return NULL;
+        return UBASE_ERR_ALLOC;
     }
-    ubuf_sound_common_init(ubuf, size);
 
     uint8_t *buffer = ubuf_mem_shared_buffer(sound_mem->shared);
     for (uint8_t plane = 0; plane < sound_mgr->common_mgr.nb_planes; plane++) {
@@ -158,10 +147,136 @@ static struct ubuf *ubuf_sound_mem_alloc(struct ubuf_mgr *mgr,
         ubuf_sound_common_plane_init(ubuf, plane, plane_buffer);
         buffer += plane_sizes[plane];
     }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This allocates a view on the planes of another sound ubuf,
+ * without copying.
+ *
+ * @param mgr common management structure
+ * @param ubuf_orig sound ubuf to map
+ * @param channels channel of the original ubuf to map for each plane of the
+ * manager, or NULL to use the channels of the manager
+ * @return pointer to ubuf or NULL in case of error
+ */
+static struct ubuf *_ubuf_sound_mem_alloc_view(struct ubuf_mgr *mgr,
+                                               struct ubuf *ubuf_orig,
+                                               const char *const *channels)
+{
+    struct ubuf_sound_mem_mgr *sound_mgr =
+        ubuf_sound_mem_mgr_from_ubuf_mgr(mgr);
+    size_t size;
+    uint8_t sample_size;
+    if (unlikely(ubuf_orig == NULL ||
+                 !ubase_check(ubuf_sound_size(ubuf_orig, &size,
+                                              &sample_size)) ||
+                 sample_size != sound_mgr->common_mgr.sample_size))
+        return NULL;
+
+    struct ubuf_mem_shared *shared = NULL;
+    uint8_t *buffers[sound_mgr->common_mgr.nb_planes];
+    for (uint8_t plane = 0; plane < sound_mgr->common_mgr.nb_planes; plane++) {
+        const char *channel = channels != NULL ? channels[plane] :
+                              sound_mgr->common_mgr.planes[plane]->channel;
+        struct ubuf_mem_shared *plane_shared;
+        size_t offset, plane_size;
+        if (unlikely(channel == NULL ||
+                     !ubase_check(ubuf_sound_mem_get_shared(ubuf_orig, channel,
+                             &plane_shared, &offset, &plane_size)) ||
+                     (shared != NULL && plane_shared != shared)))
+            return NULL;
+        shared = plane_shared;
+        buffers[plane] = ubuf_mem_shared_buffer(shared) + offset;
+    }
+    if (unlikely(shared == NULL))
+        return NULL;
+
+    struct ubuf_sound_mem *sound_mem = ubuf_sound_mem_alloc_pool(mgr);
+    if (unlikely(sound_mem == NULL))
+        return NULL;
+
+    struct ubuf *ubuf = ubuf_sound_mem_to_ubuf(sound_mem);
+    sound_mem->shared = ubuf_mem_shared_use(shared);
+    sound_mem->view = true;
+    ubuf_sound_common_init(ubuf, size);
+    for (uint8_t plane = 0; plane < sound_mgr->common_mgr.nb_planes; plane++)
+        ubuf_sound_common_plane_init(ubuf, plane, buffers[plane]);
+    return ubuf;
+}
+
+/** @This allocates a ubuf, a shared structure and a umem buffer.
+ *
+ * @param mgr common management structure
+ * @param alloc_type UBUF_ALLOC_SOUND or UBUF_SOUND_MEM_ALLOC_VIEW
+ * @param args optional arguments (1st = size, or 1st = original ubuf and
+ * 2nd = channels for a view)
+ * @return pointer to ubuf or NULL in case of allocation error
+ */
+static struct ubuf *ubuf_sound_mem_alloc(struct ubuf_mgr *mgr,
+                                         uint32_t signature, va_list args)
+{
+    if (signature == UBUF_SOUND_MEM_ALLOC_VIEW) {
+        struct ubuf *ubuf_orig = va_arg(args, struct ubuf *);
+        const char *const *channels = va_arg(args, const char *const *);
+        return _ubuf_sound_mem_alloc_view(mgr, ubuf_orig, channels);
+    }
+    if (unlikely(signature != UBUF_ALLOC_SOUND))
+        return NULL;
+
+    int ssize = va_arg(args, int);
+    if (ssize < 0)
+        return NULL;
+    size_t size = ssize;
 
+    struct ubuf_sound_mem *sound_mem = ubuf_sound_mem_alloc_pool(mgr);
+    if (unlikely(sound_mem == NULL))
+        return NULL;
+
+    struct ubuf *ubuf = ubuf_sound_mem_to_ubuf(sound_mem);
+    sound_mem->view = false;
+    if (unlikely(!ubase_check(ubuf_sound_mem_alloc_buffer(mgr, sound_mem,
+                                                          size)))) {
+        ubuf_sound_mem_free_pool(mgr, sound_mem);
+        return NULL;
+    }
+    ubuf_sound_common_init(ubuf, size);
     return ubuf;
 }
 
+/** @internal @This gives a view its own copy of the samples, so that it can
+ * be written to without affecting the buffer it maps.
+ *
+ * @param ubuf pointer to ubuf
+ * @return an error code
+ */
+static int ubuf_sound_mem_materialize(struct ubuf *ubuf)
+{
+    struct ubuf_sound_mem *sound_mem = ubuf_sound_mem_from_ubuf(ubuf);
+    if (!sound_mem->view || ubuf_mem_shared_single(sound_mem->shared))
+        return UBASE_ERR_NONE;
+
+    struct ubuf_sound_mem_mgr *sound_mgr =
+        ubuf_sound_mem_mgr_from_ubuf_mgr(ubuf->mgr);
+    struct ubuf_sound_common *common = ubuf_sound_common_from_ubuf(ubuf);
+    struct ubuf_mem_shared *shared = sound_mem->shared;
+    uint8_t *buffers[sound_mgr->common_mgr.nb_planes];
+    for (uint8_t plane = 0; plane < sound_mgr->common_mgr.nb_planes; plane++)
+        buffers[plane] = common->planes[plane].buffer;
+
+    UBASE_RETURN(ubuf_sound_mem_alloc_buffer(ubuf->mgr, sound_mem,
+                                             common->size))
+    for (uint8_t plane = 0; plane < sound_mgr->common_mgr.nb_planes; plane++)
+        memcpy(common->planes[plane].buffer, buffers[plane],
+               common->size * sound_mgr->common_mgr.sample_size);
+
+    if (unlikely(ubuf_mem_shared_release(shared))) {
+        umem_free(&shared->umem);
+        ubuf_sound_mem_shared_free_pool(shared);
+    }
+    sound_mem->view = false;
+    return UBASE_ERR_NONE;
+}
+
 /** @This asks for the creation of a new reference to the same buffer space.
  *
  * @param ubuf pointer to ubuf
@@ -193,6 +308,7 @@ static int ubuf_sound_mem_dup(struct ubuf *ubuf, struct ubuf **new_ubuf_p)
 
     struct ubuf_sound_mem *sound_mem = ubuf_sound_mem_from_ubuf(ubuf);
     new_sound->shared = ubuf_mem_shared_use(sound_mem->shared);
+    new_sound->view = sound_mem->view;
     return UBASE_ERR_NONE;
 }
 
@@ -268,6 +384,7 @@ static int ubuf_sound_mem_control(struct ubuf *ubuf, int command, va_list args)
             int size = va_arg(args, int);
             uint8_t **buffer_p = va_arg(args, uint8_t **);
             struct ubuf_sound_mem *sound = ubuf_sound_mem_from_ubuf(ubuf);
+            UBASE_RETURN(ubuf_sound_mem_materialize(ubuf))
             if (!ubuf_mem_shared_single(sound->shared))
                 return UBASE_ERR_BUSY;
             int err =
@@ -0,0 +1,348 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short Upipe implementation of uclock based on the CPU time-stamp counter
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/urefcount.h>
+#include <upipe/uatomic.h>
+#include <upipe/uclock.h>
+#include <upipe/uclock_std.h>
+#include <upipe/uclock_tsc.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__i686__) || defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define UCLOCK_TSC_SUPPORTED
+#elif defined(__aarch64__)
+#define UCLOCK_TSC_SUPPORTED
+#endif
+
+#ifdef UCLOCK_TSC_SUPPORTED
+
+/** duration of the initial calibration */
+#define UCLOCK_TSC_CALIBRATION (UCLOCK_FREQ / 200)
+/** period of the recalibration */
+#define UCLOCK_TSC_PERIOD UCLOCK_FREQ
+
+/** @This describes the conversion from the counter to the 27 MHz clock. */
+struct uclock_tsc_scale {
+    /** value of the counter at the origin */
+    uint64_t tsc;
+    /** date at the origin */
+    uint64_t ticks;
+    /** number of 27 MHz ticks per counter tick, in 32.32 fixed point */
+    uint64_t mult;
+};
+
+/** super-set of the uclock structure with additional local members */
+struct uclock_tsc {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** conversion scales, the current one being selected by index */
+    struct uclock_tsc_scale scales[2];
+    /** index of the current scale, incremented on recalibration */
+    uatomic_uint32_t index;
+    /** set while a thread recalibrates the scale */
+    uatomic_uint32_t calibrating;
+    /** number of counter ticks between recalibrations */
+    uint64_t period;
+    /** value of the counter at the last recalibration */
+    uint64_t last_tsc;
+    /** monotonic date at the last recalibration */
+    uint64_t last_mono;
+
+    /** structure exported to modules */
+    struct uclock uclock;
+};
+
+UBASE_FROM_TO(uclock_tsc, uclock, uclock, uclock)
+UBASE_FROM_TO(uclock_tsc, urefcount, urefcount, urefcount)
+
+/** @internal @This reads the time-stamp counter.
+ *
+ * @return value of the counter
+ */
+static inline uint64_t uclock_tsc_read(void)
+{
+#if defined(__i686__) || defined(__x86_64__)
+    return __rdtsc();
+#else
+    uint64_t tsc;
+    __asm__ __volatile__("isb; mrs %0, cntvct_el0" : "=r" (tsc));
+    return tsc;
+#endif
+}
+
+/** @internal @This reads the given system clock.
+ *
+ * @param clock_id system clock to read
+ * @return date in 27 MHz ticks
+ */
+static uint64_t uclock_tsc_system(clockid_t clock_id)
+{
+    struct timespec ts;
+    if (unlikely(clock_gettime(clock_id, &ts) == -1))
+        return UINT64_MAX;
+    return ts.tv_sec * UCLOCK_FREQ +
+           ts.tv_nsec * UCLOCK_FREQ / UINT64_C(1000000000);
+}
+
+/** @internal @This converts a counter value with the given scale.
+ *
+ * @param scale conversion scale
+ * @param tsc value of the counter
+ * @return date in 27 MHz ticks
+ */
+static inline uint64_t uclock_tsc_convert(const struct uclock_tsc_scale *scale,
+                                          uint64_t tsc)
+{
+    /* another CPU may have a counter slightly behind */
+    if (unlikely(tsc < scale->tsc))
+        return scale->ticks;
+    return scale->ticks +
+        (uint64_t)(((unsigned __int128)(tsc - scale->tsc) * scale->mult) >> 32);
+}
+
+/** @internal @This recalibrates the scale against the monotonic system
+ * clock. The new scale starts from the date given by the current one, so
+ * that the clock never jumps backwards, and its rate absorbs the drift
+ * measured on the monotonic clock within a period.
+ *
+ * @param tsc description structure of the clock
+ * @param scale current scale
+ * @param counter current value of the counter
+ * @return current date in 27 MHz ticks
+ */
+static uint64_t uclock_tsc_recalibrate(struct uclock_tsc *tsc,
+                                       const struct uclock_tsc_scale *scale,
+                                       uint64_t counter)
+{
+    uint64_t now = uclock_tsc_convert(scale, counter);
+    uint32_t expected = 0;
+    if (!uatomic_compare_exchange(&tsc->calibrating, &expected, 1))
+        /* another thread is recalibrating */
+        return now;
+
+    uint64_t mono = uclock_tsc_system(CLOCK_MONOTONIC);
+    uint64_t elapsed_tsc = counter - tsc->last_tsc;
+    uint64_t elapsed_mono = mono - tsc->last_mono;
+    if (unlikely(mono == UINT64_MAX || !elapsed_tsc || !elapsed_mono ||
+                 counter < tsc->last_tsc || mono < tsc->last_mono)) {
+        uatomic_store(&tsc->calibrating, 0);
+        return now;
+    }
+
+    uint64_t target;
+    if (mono > now + UCLOCK_TSC_PERIOD) {
+        /* the counter stopped (suspend?), catch up at once */
+        now = mono;
+        target = elapsed_mono;
+    } else if (mono >= now)
+        target = elapsed_mono + (mono - now);
+    else if (now - mono < elapsed_mono / 2)
+        target = elapsed_mono - (now - mono);
+    else
+        target = elapsed_mono / 2;
+
+    uint32_t index = uatomic_load(&tsc->index);
+    struct uclock_tsc_scale *next = &tsc->scales[(index + 1) & 1];
+    next->tsc = counter;
+    next->ticks = now;
+    next->mult = ((unsigned __int128)target << 32) / elapsed_tsc;
+    tsc->last_tsc = counter;
+    tsc->last_mono = mono;
+    uatomic_store(&tsc->index, index + 1);
+    uatomic_store(&tsc->calibrating, 0);
+    return now;
+}
+
+/** @This returns the current system time.
+ *
+ * @param uclock utility structure passed to the module
+ * @return current system time in 27 MHz ticks
+ */
+static uint64_t uclock_tsc_now(struct uclock *uclock)
+{
+    struct uclock_tsc *tsc = uclock_tsc_from_uclock(uclock);
+    uint64_t counter = uclock_tsc_read();
+    const struct uclock_tsc_scale *scale =
+        &tsc->scales[uatomic_load(&tsc->index) & 1];
+    if (unlikely(counter - scale->tsc >= tsc->period))
+        return uclock_tsc_recalibrate(tsc, scale, counter);
+    return uclock_tsc_convert(scale, counter);
+}
+
+/** @This converts a system time to Epoch-based real time.
+ *
+ * @param uclock pointer to uclock
+ * @param systime system time in 27 MHz ticks
+ * @return number of ticks since the Epoch, or UINT64_MAX in case of error
+ */
+static uint64_t uclock_tsc_to_real(struct uclock *uclock, uint64_t systime)
+{
+    uint64_t now = uclock_tsc_now(uclock);
+    uint64_t ref = uclock_tsc_system(CLOCK_REALTIME);
+    if (unlikely(ref == UINT64_MAX))
+        return UINT64_MAX;
+    return ref + systime - now;
+}
+
+/** @This converts Epoch-based real time to a system time.
+ *
+ * @param uclock pointer to uclock
+ * @param real number of ticks since the Epoch
+ * @return system time in 27 MHz ticks, or UINT64_MAX in case of error
+ */
+static uint64_t uclock_tsc_from_real(struct uclock *uclock, uint64_t real)
+{
+    uint64_t now = uclock_tsc_now(uclock);
+    uint64_t ref = uclock_tsc_system(CLOCK_REALTIME);
+    if (unlikely(ref == UINT64_MAX))
+        return UINT64_MAX;
+    return now + real - ref;
+}
+
+/** @This frees a uclock.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void uclock_tsc_free(struct urefcount *urefcount)
+{
+    struct uclock_tsc *tsc = uclock_tsc_from_urefcount(urefcount);
+    uatomic_clean(&tsc->index);
+    uatomic_clean(&tsc->calibrating);
+    urefcount_clean(urefcount);
+    free(tsc);
+}
+
+/** @internal @This checks whether the counter runs at a constant rate,
+ * whatever the power state of the CPU.
+ *
+ * @return true if the counter is invariant
+ */
+static bool uclock_tsc_invariant(void)
+{
+#if defined(__i686__) || defined(__x86_64__)
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+        return false;
+    return (edx & (1 << 8)) != 0;
+#else
+    /* the generic timer of ARMv8 has a fixed frequency */
+    return true;
+#endif
+}
+
+/** @internal @This measures the initial scale of the counter.
+ *
+ * @param scale filled in with the scale
+ * @param last_mono filled in with the monotonic date of the measure
+ * @return false in case of error
+ */
+static bool uclock_tsc_calibrate(struct uclock_tsc_scale *scale,
+                                 uint64_t *last_mono)
+{
+#if defined(__i686__) || defined(__x86_64__)
+    uint64_t mono0 = uclock_tsc_system(CLOCK_MONOTONIC);
+    uint64_t tsc0 = uclock_tsc_read();
+    uint64_t mono, tsc;
+    do {
+        mono = uclock_tsc_system(CLOCK_MONOTONIC);
+        tsc = uclock_tsc_read();
+        if (unlikely(mono == UINT64_MAX || mono0 == UINT64_MAX))
+            return false;
+    } while (mono - mono0 < UCLOCK_TSC_CALIBRATION);
+    if (unlikely(tsc <= tsc0))
+        return false;
+    scale->mult = ((unsigned __int128)(mono - mono0) << 32) / (tsc - tsc0);
+#else
+    uint64_t freq;
+    __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r" (freq));
+    if (unlikely(!freq))
+        return false;
+    uint64_t mono = uclock_tsc_system(CLOCK_MONOTONIC);
+    uint64_t tsc = uclock_tsc_read();
+    if (unlikely(mono == UINT64_MAX))
+        return false;
+    scale->mult = (UCLOCK_FREQ << 32) / freq;
+#endif
+    scale->tsc = tsc;
+    scale->ticks = mono;
+    *last_mono = mono;
+    return scale->mult != 0;
+}
+
+/** @This allocates a new uclock structure based on the time-stamp counter.
+ *
+ * @return pointer to uclock, or NULL in case of error
+ */
+struct uclock *uclock_tsc_alloc(void)
+{
+    struct uclock_tsc_scale scale;
+    uint64_t last_mono;
+    if (!uclock_tsc_invariant() || !uclock_tsc_calibrate(&scale, &last_mono))
+        return uclock_std_alloc(0);
+
+    struct uclock_tsc *tsc = malloc(sizeof(struct uclock_tsc));
+    if (unlikely(tsc == NULL))
+        return NULL;
+
+    tsc->scales[0] = scale;
+    tsc->scales[1] = scale;
+    uatomic_init(&tsc->index, 0);
+    uatomic_init(&tsc->calibrating, 0);
+    tsc->period = (UCLOCK_TSC_PERIOD << 32) / scale.mult;
+    tsc->last_tsc = scale.tsc;
+    tsc->last_mono = last_mono;
+    urefcount_init(uclock_tsc_to_urefcount(tsc), uclock_tsc_free);
+    tsc->uclock.refcount = uclock_tsc_to_urefcount(tsc);
+    tsc->uclock.uclock_now = uclock_tsc_now;
+    tsc->uclock.uclock_to_real = uclock_tsc_to_real;
+    tsc->uclock.uclock_from_real = uclock_tsc_from_real;
+    return uclock_tsc_to_uclock(tsc);
+}
+
+#else /* UCLOCK_TSC_SUPPORTED */
+
+/** @This allocates a new uclock structure based on the time-stamp counter,
+ * which isn't supported on this architecture.
+ *
+ * @return pointer to a standard uclock, or NULL in case of error
+ */
+struct uclock *uclock_tsc_alloc(void)
+{
+    return uclock_std_alloc(0);
+}
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short Upipe virtual implementation of uclock
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/urefcount.h>
+#include <upipe/uclock.h>
+#include <upipe/uclock_virtual.h>
+
+#include <stdlib.h>
+#include <time.h>
+
+/** super-set of the uclock structure with additional local members */
+struct uclock_virtual {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** current date */
+    uint64_t now;
+    /** offset between real time and the date of the clock */
+    int64_t real_offset;
+
+    /** structure exported to modules */
+    struct uclock uclock;
+};
+
+UBASE_FROM_TO(uclock_virtual, uclock, uclock, uclock)
+UBASE_FROM_TO(uclock_virtual, urefcount, urefcount, urefcount)
+
+/** @This returns the current date of the clock.
+ *
+ * @param uclock utility structure passed to the module
+ * @return current date in 27 MHz ticks
+ */
+static uint64_t uclock_virtual_now(struct uclock *uclock)
+{
+    struct uclock_virtual *vclock = uclock_virtual_from_uclock(uclock);
+    return vclock->now;
+}
+
+/** @This converts a date of the clock to Epoch-based real time.
+ *
+ * @param uclock pointer to uclock
+ * @param systime date in 27 MHz ticks
+ * @return number of ticks since the Epoch
+ */
+static uint64_t uclock_virtual_to_real(struct uclock *uclock, uint64_t systime)
+{
+    struct uclock_virtual *vclock = uclock_virtual_from_uclock(uclock);
+    return systime + vclock->real_offset;
+}
+
+/** @This converts Epoch-based real time to a date of the clock.
+ *
+ * @param uclock pointer to uclock
+ * @param real number of ticks since the Epoch
+ * @return date in 27 MHz ticks
+ */
+static uint64_t uclock_virtual_from_real(struct uclock *uclock, uint64_t real)
+{
+    struct uclock_virtual *vclock = uclock_virtual_from_uclock(uclock);
+    return real - vclock->real_offset;
+}
+
+/** @This advances a virtual uclock to the given date.
+ *
+ * @param uclock pointer to uclock
+ * @param date new date, in 27 MHz ticks
+ * @return an error code
+ */
+int uclock_virtual_advance(struct uclock *uclock, uint64_t date)
+{
+    if (unlikely(uclock->uclock_now != uclock_virtual_now))
+        return UBASE_ERR_INVALID;
+
+    struct uclock_virtual *vclock = uclock_virtual_from_uclock(uclock);
+    if (date > vclock->now)
+        vclock->now = date;
+    return UBASE_ERR_NONE;
+}
+
+/** @This frees a uclock.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void uclock_virtual_free(struct urefcount *urefcount)
+{
+    struct uclock_virtual *vclock = uclock_virtual_from_urefcount(urefcount);
+    urefcount_clean(urefcount);
+    free(vclock);
+}
+
+/** @This allocates a new virtual uclock structure.
+ *
+ * @param start initial date of the clock, in 27 MHz ticks
+ * @return pointer to uclock, or NULL in case of error
+ */
+struct uclock *uclock_virtual_alloc(uint64_t start)
+{
+    struct timespec ts;
+    if (unlikely(clock_gettime(CLOCK_REALTIME, &ts) == -1))
+        return NULL;
+
+    struct uclock_virtual *vclock = malloc(sizeof(struct uclock_virtual));
+    if (unlikely(vclock == NULL))
+        return NULL;
+
+    uint64_t real = ts.tv_sec * UCLOCK_FREQ +
+                    ts.tv_nsec * UCLOCK_FREQ / UINT64_C(1000000000);
+    vclock->now = start;
+    vclock->real_offset = real - start;
+    urefcount_init(uclock_virtual_to_urefcount(vclock), uclock_virtual_free);
+    vclock->uclock.refcount = uclock_virtual_to_urefcount(vclock);
+    vclock->uclock.uclock_now = uclock_virtual_now;
+    vclock->uclock.uclock_to_real = uclock_virtual_to_real;
+    vclock->uclock.uclock_from_real = uclock_virtual_from_real;
+    return uclock_virtual_to_uclock(vclock);
+}
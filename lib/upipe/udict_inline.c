@@ -28,9 +28,13 @@
  * This manager stores all attributes inline inside a single umem block.
  * This is designed in order to minimize calls to memory allocators, and
  * to transmit dictionaries over streams.
+ *
+ * The umem block is refcounted and shared between duplicated udicts; it is
+ * only copied when one of them is modified (copy-on-write).
  */
 
 #include <upipe/ubase.h>
+#include <upipe/uatomic.h>
 #include <upipe/urefcount.h>
 #include <upipe/upool.h>
 #include <upipe/umem.h>
@@ -47,6 +51,12 @@
 #define UDICT_MIN_SIZE 128
 /** default extra space added on udict expansion */
 #define UDICT_EXTRA_SIZE 64
+/** number of attributes from which lookups go through the index */
+#define UDICT_INDEX_THRESHOLD 16
+/** number of slots of the index (power of 2) */
+#define UDICT_INDEX_SIZE 64
+/** maximum number of attributes in the index */
+#define UDICT_INDEX_MAX 48
 
 /** @internal @This represents a shorthand attribute type. */
 struct inline_shorthand {
@@ -141,6 +151,19 @@ struct udict_inline {
     struct umem umem;
     /** used size */
     size_t size;
+    /** number of attributes */
+    unsigned int nb_attrs;
+    /** true if the hash of the attributes is up-to-date */
+    bool hash_valid;
+    /** hash of the attributes */
+    uint64_t hash;
+
+    /** true if the index is up-to-date */
+    bool index_valid;
+    /** bitmap of the shorthand attributes present in the index */
+    uint64_t index_shorthands;
+    /** hash table of attribute offsets (+ 1, 0 meaning empty slot) */
+    uint32_t index[UDICT_INDEX_SIZE];
 
     /** common structure */
     struct udict udict;
@@ -148,6 +171,93 @@ struct udict_inline {
 
 UBASE_FROM_TO(udict_inline, udict, udict, udict)
 
+/** @internal @This is the header of the umem block, shared between all
+ * duplicates of a udict. */
+struct udict_inline_shared {
+    /** number of udicts using the block */
+    uatomic_uint32_t refcount;
+};
+
+/** @internal @This returns the shared header of the umem block.
+ *
+ * @param inl pointer to the udict_inline structure
+ * @return pointer to the shared header
+ */
+static inline struct udict_inline_shared *
+    udict_inline_shared(struct udict_inline *inl)
+{
+    return (struct udict_inline_shared *)umem_buffer(&inl->umem);
+}
+
+/** @internal @This returns the attributes space of the umem block.
+ *
+ * @param inl pointer to the udict_inline structure
+ * @return pointer to the first attribute
+ */
+static inline uint8_t *udict_inline_buffer(struct udict_inline *inl)
+{
+    return umem_buffer(&inl->umem) + sizeof(struct udict_inline_shared);
+}
+
+/** @internal @This allocates a new umem block for a udict.
+ *
+ * @param inline_mgr pointer to the udict_inline manager
+ * @param umem pointer to the umem to allocate
+ * @param size size of the attributes space
+ * @return false in case of allocation error
+ */
+static bool udict_inline_umem_alloc(struct udict_inline_mgr *inline_mgr,
+                                    struct umem *umem, size_t size)
+{
+    if (unlikely(!umem_alloc(inline_mgr->umem_mgr, umem,
+                             size + sizeof(struct udict_inline_shared))))
+        return false;
+    struct udict_inline_shared *shared =
+        (struct udict_inline_shared *)umem_buffer(umem);
+    uatomic_init(&shared->refcount, 1);
+    return true;
+}
+
+/** @internal @This releases the umem block of a udict, and frees it if it
+ * was the last user.
+ *
+ * @param inl pointer to the udict_inline structure
+ */
+static void udict_inline_umem_release(struct udict_inline *inl)
+{
+    struct udict_inline_shared *shared = udict_inline_shared(inl);
+    if (uatomic_fetch_sub(&shared->refcount, 1) == 1) {
+        uatomic_clean(&shared->refcount);
+        umem_free(&inl->umem);
+    }
+}
+
+/** @internal @This makes sure the umem block of a udict is not shared with
+ * another udict before it is modified.
+ *
+ * @param inl pointer to the udict_inline structure
+ * @return an error code
+ */
+static int udict_inline_unshare(struct udict_inline *inl)
+{
+    struct udict_inline_shared *shared = udict_inline_shared(inl);
+    if (likely(uatomic_load(&shared->refcount) == 1))
+        return UBASE_ERR_NONE;
+
+    struct udict_inline_mgr *inline_mgr =
+        udict_inline_mgr_from_udict_mgr(inl->udict.mgr);
+    struct umem umem;
+    if (unlikely(!udict_inline_umem_alloc(inline_mgr, &umem,
+                umem_size(&inl->umem) - sizeof(struct udict_inline_shared))))
+        return UBASE_ERR_ALLOC;
+
+    memcpy(umem_buffer(&umem) + sizeof(struct udict_inline_shared),
+           udict_inline_buffer(inl), inl->size);
+    udict_inline_umem_release(inl);
+    inl->umem = umem;
+    return UBASE_ERR_NONE;
+}
+
 /** @This allocates a udict with attributes space.
  *
  * @param mgr common management structure
@@ -163,19 +273,23 @@ static struct udict *udict_inline_alloc(struct udict_mgr *mgr, size_t size)
 
     if (size < inline_mgr->min_size)
         size = inline_mgr->min_size;
-    if (unlikely(!umem_alloc(inline_mgr->umem_mgr, &inl->umem, size))) {
+    if (unlikely(!udict_inline_umem_alloc(inline_mgr, &inl->umem, size))) {
         upool_free(&inline_mgr->udict_pool, inl);
         return NULL;
     }
 
-    uint8_t *buffer = umem_buffer(&inl->umem);
+    uint8_t *buffer = udict_inline_buffer(inl);
     buffer[0] = UDICT_TYPE_END;
     inl->size = 1;
+    inl->nb_attrs = 0;
+    inl->hash_valid = false;
+    inl->index_valid = false;
 
     return udict;
 }
 
-/** @This duplicates a given udict.
+/** @This duplicates a given udict. The attributes space is shared until
+ * one of the udicts is modified.
  *
  * @param udict pointer to udict
  * @param new_udict_p reference written with a pointer to the newly allocated
@@ -185,16 +299,26 @@ static struct udict *udict_inline_alloc(struct udict_mgr *mgr, size_t size)
 static int udict_inline_dup(struct udict *udict, struct udict **new_udict_p)
 {
     assert(new_udict_p != NULL);
+    struct udict_inline_mgr *inline_mgr =
+        udict_inline_mgr_from_udict_mgr(udict->mgr);
     struct udict_inline *inl = udict_inline_from_udict(udict);
-    struct udict *new_udict = udict_inline_alloc(udict->mgr, inl->size);
-    if (unlikely(new_udict == NULL))
+    struct udict_inline *new_inl = upool_alloc(&inline_mgr->udict_pool,
+                                               struct udict_inline *);
+    if (unlikely(new_inl == NULL))
         return UBASE_ERR_ALLOC;
 
-    *new_udict_p = new_udict;
-
-    struct udict_inline *new_inl = udict_inline_from_udict(new_udict);
-    memcpy(umem_buffer(&new_inl->umem), umem_buffer(&inl->umem), inl->size);
+    uatomic_fetch_add(&udict_inline_shared(inl)->refcount, 1);
+    new_inl->umem = inl->umem;
     new_inl->size = inl->size;
+    new_inl->nb_attrs = inl->nb_attrs;
+    new_inl->hash_valid = inl->hash_valid;
+    new_inl->hash = inl->hash;
+    new_inl->index_valid = inl->index_valid;
+    if (inl->index_valid) {
+        new_inl->index_shorthands = inl->index_shorthands;
+        memcpy(new_inl->index, inl->index, sizeof(inl->index));
+    }
+    *new_udict_p = udict_inline_to_udict(new_inl);
     return UBASE_ERR_NONE;
 }
 
@@ -206,8 +330,8 @@ static int udict_inline_dup(struct udict *udict, struct udict **new_udict_p)
 static const struct inline_shorthand *
     udict_inline_shorthand(enum udict_type type)
 {
-    if (unlikely(type > UDICT_TYPE_SHORTHAND + 1 + sizeof(inline_shorthands) /
-                                               sizeof(struct inline_shorthand)))
+    if (unlikely(type > UDICT_TYPE_SHORTHAND + sizeof(inline_shorthands) /
+                                           sizeof(struct inline_shorthand)))
         return NULL;
     return &inline_shorthands[type - UDICT_TYPE_SHORTHAND - 1];
 }
@@ -236,6 +360,91 @@ static uint8_t *udict_inline_next(uint8_t *attr)
     return attr + 3 + size;
 }
 
+/** @internal @This hashes the name and type of an attribute.
+ *
+ * @param name name of the attribute (ignored for shorthands)
+ * @param type type of the attribute
+ * @return hash value
+ */
+static inline uint32_t udict_inline_hash(const char *name,
+                                         enum udict_type type)
+{
+    uint32_t hash = (2166136261U ^ type) * 16777619U;
+    if (type <= UDICT_TYPE_SHORTHAND)
+        for ( ; *name; name++)
+            hash = (hash ^ (uint8_t)*name) * 16777619U;
+    return hash;
+}
+
+/** @internal @This adds an attribute to the index, or invalidates the index
+ * if it is full.
+ *
+ * @param inl pointer to the udict_inline structure
+ * @param attr pointer to the attribute
+ */
+static void udict_inline_index_add(struct udict_inline *inl, uint8_t *attr)
+{
+    if (!inl->index_valid)
+        return;
+    if (unlikely(inl->nb_attrs > UDICT_INDEX_MAX)) {
+        inl->index_valid = false;
+        return;
+    }
+
+    enum udict_type type = *attr;
+    if (type > UDICT_TYPE_SHORTHAND)
+        inl->index_shorthands |= UINT64_C(1) << (type - UDICT_TYPE_SHORTHAND);
+    uint32_t slot = udict_inline_hash((const char *)(attr + 3), type) &
+                    (UDICT_INDEX_SIZE - 1);
+    while (inl->index[slot])
+        slot = (slot + 1) & (UDICT_INDEX_SIZE - 1);
+    inl->index[slot] = attr - udict_inline_buffer(inl) + 1;
+}
+
+/** @internal @This builds the index of a udict.
+ *
+ * @param inl pointer to the udict_inline structure
+ */
+static void udict_inline_index_build(struct udict_inline *inl)
+{
+    memset(inl->index, 0, sizeof(inl->index));
+    inl->index_shorthands = 0;
+    inl->index_valid = true;
+
+    uint8_t *attr = udict_inline_buffer(inl);
+    while (inl->index_valid && attr != NULL && *attr != UDICT_TYPE_END) {
+        udict_inline_index_add(inl, attr);
+        attr = udict_inline_next(attr);
+    }
+}
+
+/** @internal @This finds an attribute in the index.
+ *
+ * @param inl pointer to the udict_inline structure
+ * @param name name of the attribute
+ * @param type type of the attribute
+ * @return pointer to the attribute, or NULL
+ */
+static uint8_t *udict_inline_index_find(struct udict_inline *inl,
+                                        const char *name,
+                                        enum udict_type type)
+{
+    if (type > UDICT_TYPE_SHORTHAND &&
+        !(inl->index_shorthands & (UINT64_C(1) << (type - UDICT_TYPE_SHORTHAND))))
+        return NULL;
+
+    uint32_t slot = udict_inline_hash(name, type) & (UDICT_INDEX_SIZE - 1);
+    while (inl->index[slot]) {
+        uint8_t *attr = udict_inline_buffer(inl) + inl->index[slot] - 1;
+        if (*attr == type &&
+            (type > UDICT_TYPE_SHORTHAND ||
+             !strcmp((const char *)(attr + 3), name)))
+            return attr;
+        slot = (slot + 1) & (UDICT_INDEX_SIZE - 1);
+    }
+    return NULL;
+}
+
 /** @internal @This finds an attribute (shorthand or not) of the given name
  * and type and returns a pointer to its beginning.
  *
@@ -255,7 +464,16 @@ static uint8_t *udict_inline_find(struct udict *udict, const char *name,
         inline_mgr->stats[type - UDICT_TYPE_SHORTHAND - 1]++;
     }
 #endif
-    uint8_t *attr = umem_buffer(&inl->umem);
+    if (type != UDICT_TYPE_END) {
+        if (unlikely(!inl->index_valid &&
+                     inl->nb_attrs >= UDICT_INDEX_THRESHOLD &&
+                     inl->nb_attrs <= UDICT_INDEX_MAX))
+            udict_inline_index_build(inl);
+        if (inl->index_valid)
+            return udict_inline_index_find(inl, name, type);
+    }
+
+    uint8_t *attr = udict_inline_buffer(inl);
     while (attr != NULL) {
         if (*attr == type &&
              (type > UDICT_TYPE_SHORTHAND || type == UDICT_TYPE_END ||
@@ -288,7 +506,7 @@ static void udict_inline_iterate(struct udict *udict, const char **name_p,
         if (likely(attr != NULL))
             attr = udict_inline_next(attr);
     } else
-        attr = umem_buffer(&inl->umem);
+        attr = udict_inline_buffer(inl);
     if (unlikely(attr == NULL || *attr == UDICT_TYPE_END)) {
         *type_p = UDICT_TYPE_END;
         return;
@@ -377,13 +595,17 @@ static int udict_inline_delete(struct udict *udict, const char *name,
 {
     assert(type != UDICT_TYPE_END);
     struct udict_inline *inl = udict_inline_from_udict(udict);
-    uint8_t *attr = udict_inline_find(udict, name, type);
-    if (unlikely(attr == NULL))
+    if (unlikely(udict_inline_find(udict, name, type) == NULL))
         return UBASE_ERR_INVALID;
+    UBASE_RETURN(udict_inline_unshare(inl))
 
+    uint8_t *attr = udict_inline_find(udict, name, type);
     uint8_t *end = udict_inline_next(attr);
-    memmove(attr, end, umem_buffer(&inl->umem) + inl->size - end);
+    memmove(attr, end, udict_inline_buffer(inl) + inl->size - end);
     inl->size -= end - attr;
+    inl->nb_attrs--;
+    inl->hash_valid = false;
+    inl->index_valid = false;
     return UBASE_ERR_NONE;
 }
 
@@ -409,6 +631,9 @@ static int udict_inline_set(struct udict *udict, const char *name,
             return UBASE_ERR_INVALID;
         base_type = shorthand->base_type;
     }
+    UBASE_RETURN(udict_inline_unshare(inl))
+    /* the value is written by the caller */
+    inl->hash_valid = false;
 
     /* check if it already exists */
     size_t current_size;
@@ -444,7 +669,7 @@ static int udict_inline_set(struct udict *udict, const char *name,
     }
 
     /* check total attributes size */
-    attr = umem_buffer(&inl->umem) + inl->size - 1;
+    attr = udict_inline_buffer(inl) + inl->size - 1;
     size_t total_size = (attr - umem_buffer(&inl->umem)) + header_size +
                         attr_size + 1;
     if (unlikely(total_size >= umem_size(&inl->umem))) {
@@ -454,7 +679,7 @@ static int udict_inline_set(struct udict *udict, const char *name,
                                                inline_mgr->extra_size)))
             return UBASE_ERR_ALLOC;
 
-        attr = umem_buffer(&inl->umem) + inl->size - 1;
+        attr = udict_inline_buffer(inl) + inl->size - 1;
     }
     assert(*attr == UDICT_TYPE_END);
 
@@ -481,6 +706,38 @@ static int udict_inline_set(struct udict *udict, const char *name,
     if (attr_p != NULL)
         *attr_p = attr;
     inl->size += header_size + attr_size;
+    inl->nb_attrs++;
+    udict_inline_index_add(inl, attr - header_size);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns a hash of the attributes, computed as the sum of
+ * the hashes of the packed attributes so that it doesn't depend on their
+ * order. It is cached until the udict is modified.
+ *
+ * @param udict pointer to the udict
+ * @param hash_p filled in with the hash
+ * @return an error code
+ */
+static int udict_inline_hash_all(struct udict *udict, uint64_t *hash_p)
+{
+    struct udict_inline *inl = udict_inline_from_udict(udict);
+    if (!inl->hash_valid) {
+        uint64_t hash = 0;
+        uint8_t *attr = udict_inline_buffer(inl);
+        while (attr != NULL && *attr != UDICT_TYPE_END) {
+            uint8_t *next = udict_inline_next(attr);
+            if (unlikely(next == NULL))
+                return UBASE_ERR_INVALID;
+            uint64_t attr_hash = UINT64_C(14695981039346656037);
+            for ( ; attr < next; attr++)
+                attr_hash = (attr_hash ^ *attr) * UINT64_C(1099511628211);
+            hash += attr_hash;
+        }
+        inl->hash = hash;
+        inl->hash_valid = true;
+    }
+    *hash_p = inl->hash;
     return UBASE_ERR_NONE;
 }
 
@@ -551,6 +808,10 @@ static int udict_inline_control(struct udict *udict, int command, va_list args)
             enum udict_type *base_type_p = va_arg(args, enum udict_type *);
             return udict_inline_name(type, name_p, base_type_p);
         }
+        case UDICT_HASH: {
+            uint64_t *hash_p = va_arg(args, uint64_t *);
+            return udict_inline_hash_all(udict, hash_p);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -566,7 +827,7 @@ static void udict_inline_free(struct udict *udict)
         udict_inline_mgr_from_udict_mgr(udict->mgr);
     struct udict_inline *inl = udict_inline_from_udict(udict);
 
-    umem_free(&inl->umem);
+    udict_inline_umem_release(inl);
     upool_free(&inline_mgr->udict_pool, inl);
 }
 
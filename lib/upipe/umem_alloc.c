@@ -27,6 +27,7 @@
 #include <upipe/urefcount.h>
 #include <upipe/umem.h>
 #include <upipe/umem_alloc.h>
+#include <upipe/ualloc_audit.h>
 
 #include <stdlib.h>
 #include <stdbool.h>
@@ -54,6 +55,7 @@ UBASE_FROM_TO(umem_alloc_mgr, urefcount, urefcount, urefcount)
 static bool umem_alloc_alloc(struct umem_mgr *mgr, struct umem *umem,
                              size_t size)
 {
+    ualloc_audit_fallback("umem_alloc");
     uint8_t *buffer = malloc(size);
     if (unlikely(buffer == NULL))
         return false;
@@ -74,6 +76,7 @@ static bool umem_alloc_alloc(struct umem_mgr *mgr, struct umem *umem,
  */
 static bool umem_alloc_realloc(struct umem *umem, size_t new_size)
 {
+    ualloc_audit_fallback("umem_alloc");
     uint8_t *buffer = realloc(umem->buffer, new_size);
     if (unlikely(buffer == NULL))
         return false;
@@ -124,6 +127,7 @@ struct umem_mgr *umem_alloc_mgr_alloc(void)
     alloc_mgr->mgr.umem_realloc = umem_alloc_realloc;
     alloc_mgr->mgr.umem_free = umem_alloc_free;
     alloc_mgr->mgr.umem_mgr_vacuum = NULL;
+    alloc_mgr->mgr.umem_mgr_control = NULL;
 
     return umem_alloc_mgr_to_umem_mgr(alloc_mgr);
 }
@@ -0,0 +1,454 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe umem manager carving buffers out of hugepage arenas
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/urefcount.h>
+#include <upipe/uatomic.h>
+#include <upipe/ulifo.h>
+#include <upipe/umem.h>
+#include <upipe/umem_hugepage.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/** size of a regular hugepage */
+#define HUGEPAGE_SIZE (UINT64_C(2) << 20)
+/** size of a gigantic hugepage */
+#define HUGEPAGE_SIZE_1G (UINT64_C(1) << 30)
+/** alignment of carved buffers */
+#define CARVE_ALIGN 64
+/** preferred node memory policy, from linux/mempolicy.h */
+#define UMEM_MPOL_PREFERRED 1
+
+/** @This defines the private data structures of the umem hugepage manager. */
+struct umem_hugepage_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** common management structure */
+    struct umem_mgr mgr;
+
+    /** pointer to the arena */
+    uint8_t *arena;
+    /** size of the arena */
+    size_t arena_size;
+    /** used part of the arena, in units of CARVE_ALIGN octets */
+    uatomic_uint32_t carved;
+
+    /** size (in octets) of buffers of pools[0] */
+    size_t pool0_size;
+    /** number of pools of buffers */
+    size_t nb_pools;
+    /** number of buffers carved for each pool */
+    uatomic_uint32_t *pools_carved;
+    /** maximum number of buffers for each pool */
+    unsigned int *pools_depths;
+    /** buffer pools */
+    struct ulifo pools[];
+};
+
+UBASE_FROM_TO(umem_hugepage_mgr, umem_mgr, umem_mgr, mgr)
+UBASE_FROM_TO(umem_hugepage_mgr, urefcount, urefcount, urefcount)
+
+/** @internal @This returns the nearest bigger size to allocate for a umem of
+ * the given size to fit into and returns the index of the appropriate pool.
+ *
+ * @param hugepage_mgr description structure of the umem mgr
+ * @param wanted desired size of the umem
+ * @param real_p reference written with the actual size of the future buffer
+ * @return index of the pool in which to find appropriate buffers
+ */
+static unsigned int umem_hugepage_find(struct umem_hugepage_mgr *hugepage_mgr,
+                                       size_t wanted, size_t *real_p)
+{
+    size_t size = hugepage_mgr->pool0_size;
+    unsigned int pool;
+
+    for (pool = 0; pool < hugepage_mgr->nb_pools; pool++)
+        if (wanted <= (size << pool))
+            break;
+    if (likely(real_p != NULL))
+        *real_p = pool < hugepage_mgr->nb_pools ? size << pool : wanted;
+    return pool;
+}
+
+/** @internal @This checks if a buffer belongs to the arena.
+ *
+ * @param hugepage_mgr description structure of the umem mgr
+ * @param buffer pointer to the buffer
+ * @return true if the buffer was carved out of the arena
+ */
+static inline bool umem_hugepage_in_arena(
+        struct umem_hugepage_mgr *hugepage_mgr, uint8_t *buffer)
+{
+    return buffer >= hugepage_mgr->arena &&
+           buffer < hugepage_mgr->arena + hugepage_mgr->arena_size;
+}
+
+/** @internal @This carves a new buffer out of the arena.
+ *
+ * @param hugepage_mgr description structure of the umem mgr
+ * @param pool index of the pool of the buffer
+ * @param size size of the buffer
+ * @return pointer to the buffer, or NULL if the arena is exhausted
+ */
+static uint8_t *umem_hugepage_carve(struct umem_hugepage_mgr *hugepage_mgr,
+                                    unsigned int pool, size_t size)
+{
+    /* limit the number of buffers so that a pool never overflows */
+    if (uatomic_fetch_add(&hugepage_mgr->pools_carved[pool], 1) >=
+            hugepage_mgr->pools_depths[pool]) {
+        uatomic_fetch_sub(&hugepage_mgr->pools_carved[pool], 1);
+        return NULL;
+    }
+
+    uint32_t units = (size + CARVE_ALIGN - 1) / CARVE_ALIGN;
+    uint32_t max_units = hugepage_mgr->arena_size / CARVE_ALIGN;
+    uint32_t carved = uatomic_load(&hugepage_mgr->carved);
+    do {
+        if (carved + units > max_units) {
+            uatomic_fetch_sub(&hugepage_mgr->pools_carved[pool], 1);
+            return NULL;
+        }
+    } while (!uatomic_compare_exchange(&hugepage_mgr->carved, &carved,
+                                       carved + units));
+    return hugepage_mgr->arena + (size_t)carved * CARVE_ALIGN;
+}
+
+/** @This allocates a new umem buffer space.
+ *
+ * @param mgr management structure
+ * @param umem caller-allocated structure, filled in with the required pointer
+ * and size (previous content is discarded)
+ * @param size requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_hugepage_alloc(struct umem_mgr *mgr, struct umem *umem,
+                                size_t size)
+{
+    struct umem_hugepage_mgr *hugepage_mgr =
+        umem_hugepage_mgr_from_umem_mgr(mgr);
+    size_t real_size;
+    unsigned int pool = umem_hugepage_find(hugepage_mgr, size, &real_size);
+    uint8_t *buffer = NULL;
+
+    if (likely(pool < hugepage_mgr->nb_pools)) {
+        buffer = ulifo_pop(&hugepage_mgr->pools[pool], uint8_t *);
+        if (buffer == NULL)
+            buffer = umem_hugepage_carve(hugepage_mgr, pool, real_size);
+    }
+    if (unlikely(buffer == NULL))
+        buffer = malloc(real_size);
+    if (unlikely(buffer == NULL))
+        return false;
+
+    umem->buffer = buffer;
+    umem->size = size;
+    umem->real_size = real_size;
+    umem->mgr = mgr;
+    return true;
+}
+
+/** @This frees a umem.
+ *
+ * @param umem caller-allocated structure, previously successfully passed to
+ * @ref umem_alloc
+ */
+static void umem_hugepage_free(struct umem *umem)
+{
+    struct umem_hugepage_mgr *hugepage_mgr =
+        umem_hugepage_mgr_from_umem_mgr(umem->mgr);
+
+    if (likely(umem_hugepage_in_arena(hugepage_mgr, umem->buffer))) {
+        unsigned int pool = umem_hugepage_find(hugepage_mgr, umem->real_size,
+                                               NULL);
+        /* the pool is deep enough for all carved buffers */
+        if (unlikely(!ulifo_push(&hugepage_mgr->pools[pool], umem->buffer)))
+            assert(0);
+    } else
+        free(umem->buffer);
+    umem->buffer = NULL;
+    umem->mgr = NULL;
+}
+
+/** @This resizes a umem.
+ *
+ * @param umem caller-allocated structure, previously successfully passed to
+ * @ref umem_alloc, and filled in with the new pointer and size
+ * @param new_size new requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_hugepage_realloc(struct umem *umem, size_t new_size)
+{
+    if (likely(new_size <= umem->real_size)) {
+        umem->size = new_size;
+        return true;
+    }
+
+    struct umem new_umem;
+    if (!umem_hugepage_alloc(umem->mgr, &new_umem, new_size))
+        return false;
+    memcpy(new_umem.buffer, umem->buffer, umem->size);
+    umem_hugepage_free(umem);
+    *umem = new_umem;
+    return true;
+}
+
+/** @This frees a umem manager.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void umem_hugepage_mgr_free(struct urefcount *urefcount)
+{
+    struct umem_hugepage_mgr *hugepage_mgr =
+        umem_hugepage_mgr_from_urefcount(urefcount);
+
+    for (unsigned int i = 0; i < hugepage_mgr->nb_pools; i++) {
+        ulifo_clean(&hugepage_mgr->pools[i]);
+        uatomic_clean(&hugepage_mgr->pools_carved[i]);
+    }
+    uatomic_clean(&hugepage_mgr->carved);
+    munmap(hugepage_mgr->arena, hugepage_mgr->arena_size);
+
+    urefcount_clean(urefcount);
+    free(hugepage_mgr);
+}
+
+/** @internal @This sets the preferred NUMA node of a mapping that hasn't
+ * been touched yet, so that pages are faulted in node-local memory.
+ *
+ * @param arena pointer to the mapping
+ * @param size size of the mapping
+ * @param node NUMA node
+ */
+static void umem_hugepage_bind(void *arena, size_t size, int node)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+    unsigned long nodemask[4];
+    const unsigned long bits = sizeof(unsigned long) * 8;
+    if (node < 0 || node >= (int)(sizeof(nodemask) * 8))
+        return;
+    memset(nodemask, 0, sizeof(nodemask));
+    nodemask[node / bits] |= 1UL << (node % bits);
+    /* failure is not fatal: the kernel then uses its default policy */
+    syscall(SYS_mbind, arena, size, UMEM_MPOL_PREFERRED, nodemask,
+            sizeof(nodemask) * 8 + 1, 0);
+#endif
+}
+
+/** @internal @This maps the arena.
+ *
+ * @param size_p pointer to the requested size of the arena, rounded up to the
+ * page size
+ * @param flags mapping flags
+ * @return pointer to the arena, or NULL in case of error
+ */
+static uint8_t *umem_hugepage_map(size_t *size_p, int flags)
+{
+    void *arena = MAP_FAILED;
+    size_t size;
+#ifdef MAP_HUGETLB
+    int mmap_flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+    uint64_t page_size = HUGEPAGE_SIZE;
+#ifdef MAP_HUGE_1GB
+    if (flags & UMEM_HUGEPAGE_1G) {
+        page_size = HUGEPAGE_SIZE_1G;
+        mmap_flags |= MAP_HUGE_1GB;
+    }
+#endif
+    size = (*size_p + page_size - 1) & ~(page_size - 1);
+    arena = mmap(NULL, size, PROT_READ | PROT_WRITE, mmap_flags, -1, 0);
+#endif
+
+    if (arena == MAP_FAILED) {
+        /* revert to regular pages, and let the kernel merge them */
+        long page_size = sysconf(_SC_PAGESIZE);
+        if (page_size <= 0)
+            page_size = 4096;
+        size = (*size_p + page_size - 1) & ~((size_t)page_size - 1);
+        arena = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (unlikely(arena == MAP_FAILED))
+            return NULL;
+#ifdef MADV_HUGEPAGE
+        madvise(arena, size, MADV_HUGEPAGE);
+#endif
+    }
+
+    int node = UMEM_HUGEPAGE_FLAGS_NODE(flags);
+    if (node >= 0)
+        umem_hugepage_bind(arena, size, node);
+
+    if ((flags & UMEM_HUGEPAGE_LOCK) && mlock(arena, size) != 0) {
+        munmap(arena, size);
+        return NULL;
+    }
+    *size_p = size;
+    return arena;
+}
+
+/** @internal @This allocates a new instance of the umem hugepage manager.
+ *
+ * @param arena_size size of the arena
+ * @param flags mapping flags
+ * @param pool0_size size (in octets) of the smallest allocatable buffer
+ * @param nb_pools number of buffer pools to maintain
+ * @param args for each pool, the maximum number of buffers (unsigned int)
+ * @return pointer to manager, or NULL in case of error
+ */
+static struct umem_mgr *umem_hugepage_mgr_alloc_va(size_t arena_size,
+                                                   int flags,
+                                                   size_t pool0_size,
+                                                   size_t nb_pools,
+                                                   va_list args)
+{
+    size_t alloc_size = sizeof(struct umem_hugepage_mgr) +
+                        sizeof(struct ulifo) * nb_pools +
+                        sizeof(uatomic_uint32_t) * nb_pools +
+                        sizeof(unsigned int) * nb_pools;
+    unsigned int pools_depths[nb_pools];
+    for (unsigned int i = 0; i < nb_pools; i++) {
+        pools_depths[i] = va_arg(args, unsigned int);
+        assert(pools_depths[i] <= UINT16_MAX);
+        alloc_size += ulifo_sizeof(pools_depths[i]);
+    }
+    if (unlikely(arena_size / CARVE_ALIGN > UINT32_MAX))
+        return NULL;
+
+    struct umem_hugepage_mgr *hugepage_mgr = malloc(alloc_size);
+    if (unlikely(hugepage_mgr == NULL))
+        return NULL;
+
+    hugepage_mgr->arena_size = arena_size;
+    hugepage_mgr->arena = umem_hugepage_map(&hugepage_mgr->arena_size, flags);
+    if (unlikely(hugepage_mgr->arena == NULL)) {
+        free(hugepage_mgr);
+        return NULL;
+    }
+    uatomic_init(&hugepage_mgr->carved, 0);
+
+    hugepage_mgr->pool0_size = pool0_size;
+    hugepage_mgr->nb_pools = nb_pools;
+
+    void *extra = (void *)hugepage_mgr + sizeof(struct umem_hugepage_mgr) +
+                  sizeof(struct ulifo) * nb_pools;
+    hugepage_mgr->pools_carved = extra;
+    extra += sizeof(uatomic_uint32_t) * nb_pools;
+    hugepage_mgr->pools_depths = extra;
+    extra += sizeof(unsigned int) * nb_pools;
+
+    for (unsigned int i = 0; i < nb_pools; i++) {
+        uatomic_init(&hugepage_mgr->pools_carved[i], 0);
+        hugepage_mgr->pools_depths[i] = pools_depths[i];
+        ulifo_init(&hugepage_mgr->pools[i], pools_depths[i], extra);
+        extra += ulifo_sizeof(pools_depths[i]);
+    }
+
+    urefcount_init(umem_hugepage_mgr_to_urefcount(hugepage_mgr),
+                   umem_hugepage_mgr_free);
+    hugepage_mgr->mgr.refcount = umem_hugepage_mgr_to_urefcount(hugepage_mgr);
+    hugepage_mgr->mgr.umem_alloc = umem_hugepage_alloc;
+    hugepage_mgr->mgr.umem_realloc = umem_hugepage_realloc;
+    hugepage_mgr->mgr.umem_free = umem_hugepage_free;
+    hugepage_mgr->mgr.umem_mgr_vacuum = NULL;
+    hugepage_mgr->mgr.umem_mgr_control = NULL;
+
+    return umem_hugepage_mgr_to_umem_mgr(hugepage_mgr);
+}
+
+/** @This allocates a new instance of the umem hugepage manager, carving
+ * buffers out of an arena mapped on hugepages.
+ *
+ * @param arena_size size (in octets) of the arena, rounded up to the page size
+ * @param flags mapping flags (@ref umem_hugepage_flags), optionally or'ed with
+ * @ref UMEM_HUGEPAGE_NODE
+ * @param pool0_size size (in octets) of the smallest allocatable buffer; it
+ * must be a power of 2
+ * @param nb_pools number of buffer pools to maintain, with sizes in power of
+ * 2's increments, followed, for each pool, by the maximum number of buffers
+ * to carve out of the arena for the pool (unsigned int); larger buffers,
+ * and buffers that do not fit in the arena, will be directly managed
+ * with malloc() and free()
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_hugepage_mgr_alloc(size_t arena_size, int flags,
+                                         size_t pool0_size, size_t nb_pools,
+                                         ...)
+{
+    va_list args;
+    va_start(args, nb_pools);
+    struct umem_mgr *mgr = umem_hugepage_mgr_alloc_va(arena_size, flags,
+                                                      pool0_size, nb_pools,
+                                                      args);
+    va_end(args);
+    return mgr;
+}
+
+/** @This allocates a new instance of the umem hugepage manager, with size
+ * classes matching @ref umem_pool_mgr_alloc_simple.
+ *
+ * @param arena_size size (in octets) of the arena, rounded up to the page size
+ * @param flags mapping flags (@ref umem_hugepage_flags), optionally or'ed with
+ * @ref UMEM_HUGEPAGE_NODE
+ * @param base_pools_depth maximum number of buffers for the smaller buffers;
+ * for larger buffers the same number is used, divided by 2, 4, or 8
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_hugepage_mgr_alloc_simple(size_t arena_size, int flags,
+                                                uint16_t base_pools_depth)
+{
+    return umem_hugepage_mgr_alloc(arena_size, flags, 32, 18,
+                                   base_pools_depth, /* 32 */
+                                   base_pools_depth, /* 64 */
+                                   base_pools_depth, /* 128 */
+                                   base_pools_depth, /* 256 */
+                                   base_pools_depth, /* 512 */
+                                   base_pools_depth, /* 1 Ki */
+                                   base_pools_depth, /* 2 Ki */
+                                   base_pools_depth, /* 4 Ki */
+                                   base_pools_depth / 2, /* 8 Ki */
+                                   base_pools_depth / 2, /* 16 Ki */
+                                   base_pools_depth / 2, /* 32 Ki */
+                                   base_pools_depth / 4, /* 64 Ki */
+                                   base_pools_depth / 4, /* 128 Ki */
+                                   base_pools_depth / 4, /* 256 Ki */
+                                   base_pools_depth / 4, /* 512 Ki */
+                                   base_pools_depth / 8, /* 1 Mi */
+                                   base_pools_depth / 8, /* 2 Mi */
+                                   base_pools_depth / 8); /* 4 Mi */
+}
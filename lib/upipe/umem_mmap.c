@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe umem manager using memory mappings
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/umem.h>
+#include <upipe/umem_mmap.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/** @This returns the page size, to which file offsets must be aligned.
+ *
+ * @return page size in octets
+ */
+size_t umem_mmap_page_size(void)
+{
+    long page_size = sysconf(_SC_PAGESIZE);
+    return page_size > 0 ? page_size : 4096;
+}
+
+/** @internal @This rounds up a size to the page size.
+ *
+ * @param size requested size
+ * @return size of the mapping
+ */
+static inline size_t umem_mmap_round(size_t size)
+{
+    size_t page_size = umem_mmap_page_size();
+    return size ? (size + page_size - 1) & ~(page_size - 1) : page_size;
+}
+
+/** @This allocates a new umem buffer space.
+ *
+ * @param mgr management structure
+ * @param umem caller-allocated structure, filled in with the required pointer
+ * and size (previous content is discarded)
+ * @param size requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_mmap_alloc(struct umem_mgr *mgr, struct umem *umem,
+                            size_t size)
+{
+    size_t real_size = umem_mmap_round(size);
+    void *buffer = mmap(NULL, real_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (unlikely(buffer == MAP_FAILED))
+        return false;
+
+    umem->buffer = buffer;
+    umem->size = size;
+    umem->real_size = real_size;
+    umem->mgr = mgr;
+    return true;
+}
+
+/** @This frees a umem.
+ *
+ * @param umem caller-allocated structure, previously successfully passed to
+ * @ref umem_alloc
+ */
+static void umem_mmap_free(struct umem *umem)
+{
+    munmap(umem->buffer, umem->real_size);
+    umem->buffer = NULL;
+    umem->mgr = NULL;
+}
+
+/** @This resizes a umem.
+ *
+ * @param umem caller-allocated structure, previously successfully passed to
+ * @ref umem_alloc, and filled in with the new pointer and size
+ * @param new_size new requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_mmap_realloc(struct umem *umem, size_t new_size)
+{
+    if (likely(new_size <= umem->real_size)) {
+        umem->size = new_size;
+        return true;
+    }
+
+    struct umem new_umem;
+    if (!umem_mmap_alloc(umem->mgr, &new_umem, new_size))
+        return false;
+    memcpy(new_umem.buffer, umem->buffer, umem->size);
+    umem_mmap_free(umem);
+    *umem = new_umem;
+    return true;
+}
+
+/** static manager, so that mappings may outlive the module which created
+ * them */
+static struct umem_mgr umem_mmap_mgr = {
+    .refcount = NULL,
+    .umem_alloc = umem_mmap_alloc,
+    .umem_realloc = umem_mmap_realloc,
+    .umem_free = umem_mmap_free,
+    .umem_mgr_vacuum = NULL,
+    .umem_mgr_control = NULL
+};
+
+/** @This returns the umem mmap manager. It is a static structure which is
+ * never deallocated, so that buffers may outlive their users.
+ *
+ * @return pointer to manager
+ */
+struct umem_mgr *umem_mmap_mgr_alloc(void)
+{
+    return &umem_mmap_mgr;
+}
+
+/** @This maps a range of a file into a umem. The mapping is private, so that
+ * writing into the buffer doesn't modify the file. The kernel is advised that
+ * the range will be read sequentially and soon.
+ *
+ * @param umem caller-allocated structure, filled in with the mapping (previous
+ * content is discarded)
+ * @param fd file descriptor, open for reading
+ * @param offset offset of the range in the file, multiple of the page size
+ * @param size size of the range
+ * @return false if the file couldn't be mapped (umem left untouched)
+ */
+bool umem_mmap_file(struct umem *umem, int fd, uint64_t offset, size_t size)
+{
+    if (unlikely(offset % umem_mmap_page_size() || !size))
+        return false;
+
+    size_t real_size = umem_mmap_round(size);
+    void *buffer = mmap(NULL, real_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                        fd, offset);
+    if (unlikely(buffer == MAP_FAILED))
+        return false;
+
+#ifdef MADV_SEQUENTIAL
+    madvise(buffer, real_size, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_WILLNEED
+    madvise(buffer, real_size, MADV_WILLNEED);
+#endif
+
+    umem->buffer = buffer;
+    umem->size = size;
+    umem->real_size = real_size;
+    umem->mgr = &umem_mmap_mgr;
+    return true;
+}
@@ -26,13 +26,40 @@
 #include <upipe/ubase.h>
 #include <upipe/urefcount.h>
 #include <upipe/ulifo.h>
+#include <upipe/uatomic.h>
 #include <upipe/umem.h>
 #include <upipe/umem_pool.h>
+#include <upipe/ualloc_audit.h>
+#include <upipe/utrace.h>
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
 #include <assert.h>
 
+/** maximum number of buffers kept in each adaptive pool, with the simple
+ * API */
+#define UMEM_POOL_ADAPTIVE_MAX_DEPTH 8192
+/** number of allocations between adaptations, with the simple API */
+#define UMEM_POOL_ADAPTIVE_WINDOW 1024
+
+/** @internal @This defines the adaptive state of a pool of buffers. */
+struct umem_pool_class {
+    /** current maximum number of buffers kept in the pool */
+    uatomic_uint32_t depth;
+    /** upper bound of the depth, which is the size of the LIFO */
+    unsigned int max_depth;
+    /** number of buffers kept in the pool */
+    uatomic_uint32_t cached;
+    /** number of buffers of this size currently allocated */
+    uatomic_uint32_t in_use;
+    /** peak number of buffers allocated during the current window */
+    uatomic_uint32_t peak;
+    /** number of allocations during the current window */
+    uatomic_uint32_t ops;
+};
+
 /** @This defines the private data structures of the umem pool manager. */
 struct umem_pool_mgr {
     /** refcount management structure */
@@ -45,6 +72,18 @@ struct umem_pool_mgr {
     size_t pool0_size;
     /** number of pools of buffers */
     size_t nb_pools;
+
+    /** adaptive state of the pools, or NULL if their depths are static */
+    struct umem_pool_class *classes;
+    /** number of allocations from a pool between adaptations */
+    unsigned int window;
+    /** maximum number of octets kept in all pools */
+    uint64_t max_memory;
+    /** number of octets the pools may currently keep */
+    uint64_t reserved;
+    /** lock protecting the adaptations */
+    uatomic_uint32_t lock;
+
     /** buffer pools */
     struct ulifo pools[];
 };
@@ -75,6 +114,89 @@ static unsigned int umem_pool_find(struct umem_mgr *mgr, size_t wanted,
     return pool;
 }
 
+/** @internal @This adapts the depth of a pool at the end of a window,
+ * growing it to the peak usage within the memory bound, or shrinking it
+ * halfway towards the peak, and releases the buffers beyond the new depth.
+ *
+ * @param pool_mgr description structure of the umem mgr
+ * @param pool index of the pool
+ */
+static void umem_pool_adapt(struct umem_pool_mgr *pool_mgr, unsigned int pool)
+{
+    struct umem_pool_class *state = &pool_mgr->classes[pool];
+    size_t size = pool_mgr->pool0_size << pool;
+
+    uint32_t expected = 0;
+    while (!uatomic_compare_exchange(&pool_mgr->lock, &expected, 1))
+        expected = 0;
+    uint32_t depth = uatomic_load(&state->depth);
+    uint32_t peak = uatomic_load(&state->peak);
+    uint32_t target = peak > depth ? peak : (depth + peak) / 2;
+    if (target > state->max_depth)
+        target = state->max_depth;
+    if (target > depth) {
+        uint64_t room = (pool_mgr->max_memory - pool_mgr->reserved) / size;
+        if (target - depth > room)
+            target = depth + room;
+    }
+    pool_mgr->reserved -= (uint64_t)depth * size;
+    pool_mgr->reserved += (uint64_t)target * size;
+    uatomic_store(&state->depth, target);
+    uatomic_store(&pool_mgr->lock, 0);
+
+    uatomic_store(&state->peak, uatomic_load(&state->in_use));
+    while (uatomic_load(&state->cached) > target) {
+        uint8_t *buffer = ulifo_pop(&pool_mgr->pools[pool], uint8_t *);
+        if (buffer == NULL)
+            break;
+        uatomic_fetch_sub(&state->cached, 1);
+        free(buffer);
+    }
+}
+
+/** @internal @This accounts for the allocation of a buffer from an adaptive
+ * pool.
+ *
+ * @param pool_mgr description structure of the umem mgr
+ * @param pool index of the pool
+ * @param cached true if the buffer was taken from the pool
+ */
+static void umem_pool_adaptive_alloc(struct umem_pool_mgr *pool_mgr,
+                                     unsigned int pool, bool cached)
+{
+    struct umem_pool_class *state = &pool_mgr->classes[pool];
+    if (cached)
+        uatomic_fetch_sub(&state->cached, 1);
+    uint32_t in_use = uatomic_fetch_add(&state->in_use, 1) + 1;
+    uint32_t peak = uatomic_load(&state->peak);
+    while (in_use > peak &&
+           !uatomic_compare_exchange(&state->peak, &peak, in_use));
+    if (uatomic_fetch_add(&state->ops, 1) + 1 == pool_mgr->window) {
+        uatomic_store(&state->ops, 0);
+        umem_pool_adapt(pool_mgr, pool);
+    }
+}
+
+/** @internal @This releases a buffer to an adaptive pool, within its
+ * current depth.
+ *
+ * @param pool_mgr description structure of the umem mgr
+ * @param pool index of the pool
+ * @param buffer buffer to release
+ * @return false if the buffer wasn't kept
+ */
+static bool umem_pool_adaptive_free(struct umem_pool_mgr *pool_mgr,
+                                    unsigned int pool, uint8_t *buffer)
+{
+    struct umem_pool_class *state = &pool_mgr->classes[pool];
+    uatomic_fetch_sub(&state->in_use, 1);
+    if (uatomic_fetch_add(&state->cached, 1) < uatomic_load(&state->depth) &&
+        ulifo_push(&pool_mgr->pools[pool], buffer))
+        return true;
+    uatomic_fetch_sub(&state->cached, 1);
+    return false;
+}
+
 /** @This allocates a new umem buffer space.
  *
  * @param mgr management structure
@@ -93,10 +215,16 @@ static bool umem_pool_alloc(struct umem_mgr *mgr, struct umem *umem,
 
     if (likely(pool < pool_mgr->nb_pools))
         buffer = ulifo_pop(&pool_mgr->pools[pool], uint8_t *);
-    if (unlikely(buffer == NULL))
+    bool cached = buffer != NULL;
+    if (unlikely(buffer == NULL)) {
+        ualloc_audit_fallback("umem_pool");
         buffer = malloc(real_size);
+    }
+    UTRACE4(umem_alloc, mgr, buffer, size, !cached);
     if (unlikely(buffer == NULL))
         return false;
+    if (pool_mgr->classes != NULL && pool < pool_mgr->nb_pools)
+        umem_pool_adaptive_alloc(pool_mgr, pool, cached);
 
     umem->buffer = buffer;
     umem->size = size;
@@ -117,8 +245,13 @@ static void umem_pool_free(struct umem *umem)
     struct umem_pool_mgr *pool_mgr = umem_pool_mgr_from_umem_mgr(umem->mgr);
     unsigned int pool = umem_pool_find(umem->mgr, umem->real_size, NULL);
 
-    if (unlikely(pool >= pool_mgr->nb_pools ||
-                 !ulifo_push(&pool_mgr->pools[pool], umem->buffer)))
+    UTRACE2(umem_free, umem->mgr, umem->buffer);
+    if (unlikely(pool >= pool_mgr->nb_pools))
+        free(umem->buffer);
+    else if (pool_mgr->classes != NULL) {
+        if (!umem_pool_adaptive_free(pool_mgr, pool, umem->buffer))
+            free(umem->buffer);
+    } else if (unlikely(!ulifo_push(&pool_mgr->pools[pool], umem->buffer)))
         free(umem->buffer);
     umem->buffer = NULL;
     umem->mgr = NULL;
@@ -160,8 +293,57 @@ static void umem_pool_mgr_vacuum(struct umem_mgr *mgr)
 
     for (unsigned int i = 0; i < pool_mgr->nb_pools; i++) {
         uint8_t *buffer;
-        while ((buffer = ulifo_pop(&pool_mgr->pools[i], uint8_t *)) != NULL)
+        while ((buffer = ulifo_pop(&pool_mgr->pools[i], uint8_t *)) != NULL) {
+            if (pool_mgr->classes != NULL)
+                uatomic_fetch_sub(&pool_mgr->classes[i].cached, 1);
             free(buffer);
+        }
+    }
+}
+
+/** @internal @This processes control commands on a umem pool manager.
+ *
+ * @param mgr pointer to umem manager
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int umem_pool_mgr_control(struct umem_mgr *mgr, int command,
+                                 va_list args)
+{
+    struct umem_pool_mgr *pool_mgr = umem_pool_mgr_from_umem_mgr(mgr);
+
+    switch (command) {
+        case UMEM_POOL_MGR_GET_POOL_STATS: {
+            UBASE_SIGNATURE_CHECK(args, UMEM_POOL_SIGNATURE)
+            unsigned int pool = va_arg(args, unsigned int);
+            struct umem_pool_stats *stats =
+                va_arg(args, struct umem_pool_stats *);
+            if (pool >= pool_mgr->nb_pools)
+                return UBASE_ERR_INVALID;
+            struct umem_pool_class *state = &pool_mgr->classes[pool];
+            stats->size = pool_mgr->pool0_size << pool;
+            stats->depth = uatomic_load(&state->depth);
+            stats->max_depth = state->max_depth;
+            stats->cached = uatomic_load(&state->cached);
+            stats->in_use = uatomic_load(&state->in_use);
+            stats->peak = uatomic_load(&state->peak);
+            return UBASE_ERR_NONE;
+        }
+        case UMEM_POOL_MGR_GET_MEMORY: {
+            UBASE_SIGNATURE_CHECK(args, UMEM_POOL_SIGNATURE)
+            uint64_t *reserved_p = va_arg(args, uint64_t *);
+            uint64_t *max_p = va_arg(args, uint64_t *);
+            uint32_t expected = 0;
+            while (!uatomic_compare_exchange(&pool_mgr->lock, &expected, 1))
+                expected = 0;
+            *reserved_p = pool_mgr->reserved;
+            uatomic_store(&pool_mgr->lock, 0);
+            *max_p = pool_mgr->max_memory;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
     }
 }
 
@@ -174,37 +356,45 @@ static void umem_pool_mgr_free(struct urefcount *urefcount)
     struct umem_pool_mgr *pool_mgr = umem_pool_mgr_from_urefcount(urefcount);
     umem_pool_mgr_vacuum(umem_pool_mgr_to_umem_mgr(pool_mgr));
 
-    for (unsigned int i = 0; i < pool_mgr->nb_pools; i++)
+    for (unsigned int i = 0; i < pool_mgr->nb_pools; i++) {
         ulifo_clean(&pool_mgr->pools[i]);
+        if (pool_mgr->classes != NULL) {
+            struct umem_pool_class *state = &pool_mgr->classes[i];
+            uatomic_clean(&state->depth);
+            uatomic_clean(&state->cached);
+            uatomic_clean(&state->in_use);
+            uatomic_clean(&state->peak);
+            uatomic_clean(&state->ops);
+        }
+    }
+    uatomic_clean(&pool_mgr->lock);
 
     urefcount_clean(urefcount);
     free(pool_mgr);
 }
 
-/** @This allocates a new instance of the umem pool manager allocating buffers
- * from application memory, using pools in power of 2's.
+/** @internal @This allocates a umem pool manager with the given sizes of
+ * pools.
  *
- * @param pool0_size size (in octets) of the smallest allocatable buffer; it
- * must be a power of 2
- * @param nb_pools number of buffer pools to maintain, with sizes in power of
- * 2's increments, followed, for each pool, by the maximum number of buffers
- * to keep in the pool (unsigned int); larger buffers will be directly managed
- * with malloc() and free()
+ * @param pool0_size size (in octets) of the smallest allocatable buffer
+ * @param nb_pools number of buffer pools to maintain
+ * @param pools_depths maximum number of buffers to keep in each pool
+ * @param adaptive true to allocate the adaptive state of the pools
  * @return pointer to manager, or NULL in case of error
  */
-struct umem_mgr *umem_pool_mgr_alloc(size_t pool0_size, size_t nb_pools, ...)
+static struct umem_pool_mgr *umem_pool_mgr_alloc_internal(size_t pool0_size,
+        size_t nb_pools, const unsigned int *pools_depths, bool adaptive)
 {
-    size_t alloc_size = sizeof(struct umem_pool_mgr) +
-                        sizeof(struct ulifo) * nb_pools;
-    unsigned int pools_depths[nb_pools];
-    va_list args;
-    va_start(args, nb_pools);
+    size_t classes_offset = sizeof(struct umem_pool_mgr) +
+                            sizeof(struct ulifo) * nb_pools;
+    size_t extra_offset = classes_offset;
+    if (adaptive)
+        extra_offset += nb_pools * sizeof(struct umem_pool_class);
+    size_t alloc_size = extra_offset;
     for (unsigned int i = 0; i < nb_pools; i++) {
-        pools_depths[i] = va_arg(args, unsigned int);
         assert(pools_depths[i] <= UINT16_MAX);
         alloc_size += ulifo_sizeof(pools_depths[i]);
     }
-    va_end(args);
 
     struct umem_pool_mgr *pool_mgr = malloc(alloc_size);
     if (unlikely(pool_mgr == NULL))
@@ -212,9 +402,24 @@ struct umem_mgr *umem_pool_mgr_alloc(size_t pool0_size, size_t nb_pools, ...)
 
     pool_mgr->pool0_size = pool0_size;
     pool_mgr->nb_pools = nb_pools;
+    pool_mgr->classes = NULL;
+    pool_mgr->window = 0;
+    pool_mgr->max_memory = pool_mgr->reserved = 0;
+    uatomic_init(&pool_mgr->lock, 0);
+    if (adaptive) {
+        pool_mgr->classes = (void *)pool_mgr + classes_offset;
+        for (unsigned int i = 0; i < nb_pools; i++) {
+            struct umem_pool_class *state = &pool_mgr->classes[i];
+            uatomic_init(&state->depth, 0);
+            state->max_depth = pools_depths[i];
+            uatomic_init(&state->cached, 0);
+            uatomic_init(&state->in_use, 0);
+            uatomic_init(&state->peak, 0);
+            uatomic_init(&state->ops, 0);
+        }
+    }
 
-    void *extra = (void *)pool_mgr + sizeof(struct umem_pool_mgr) +
-                  sizeof(struct ulifo) * nb_pools;
+    void *extra = (void *)pool_mgr + extra_offset;
 
     for (unsigned int i = 0; i < nb_pools; i++) {
         ulifo_init(&pool_mgr->pools[i], pools_depths[i], extra);
@@ -227,7 +432,35 @@ struct umem_mgr *umem_pool_mgr_alloc(size_t pool0_size, size_t nb_pools, ...)
     pool_mgr->mgr.umem_realloc = umem_pool_realloc;
     pool_mgr->mgr.umem_free = umem_pool_free;
     pool_mgr->mgr.umem_mgr_vacuum = umem_pool_mgr_vacuum;
+    pool_mgr->mgr.umem_mgr_control = adaptive ? umem_pool_mgr_control : NULL;
+    return pool_mgr;
+}
+
+/** @This allocates a new instance of the umem pool manager allocating buffers
+ * from application memory, using pools in power of 2's.
+ *
+ * @param pool0_size size (in octets) of the smallest allocatable buffer; it
+ * must be a power of 2
+ * @param nb_pools number of buffer pools to maintain, with sizes in power of
+ * 2's increments, followed, for each pool, by the maximum number of buffers
+ * to keep in the pool (unsigned int); larger buffers will be directly managed
+ * with malloc() and free()
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_pool_mgr_alloc(size_t pool0_size, size_t nb_pools, ...)
+{
+    unsigned int pools_depths[nb_pools];
+    va_list args;
+    va_start(args, nb_pools);
+    for (unsigned int i = 0; i < nb_pools; i++)
+        pools_depths[i] = va_arg(args, unsigned int);
+    va_end(args);
 
+    struct umem_pool_mgr *pool_mgr =
+        umem_pool_mgr_alloc_internal(pool0_size, nb_pools, pools_depths,
+                                     false);
+    if (unlikely(pool_mgr == NULL))
+        return NULL;
     return umem_pool_mgr_to_umem_mgr(pool_mgr);
 }
 
@@ -260,3 +493,56 @@ struct umem_mgr *umem_pool_mgr_alloc_simple(uint16_t base_pools_depth)
                                base_pools_depth / 8, /* 2 Mi */
                                base_pools_depth / 8); /* 4 Mi */
 }
+
+/** @This allocates a new instance of the umem pool manager allocating buffers
+ * from application memory, using adaptive pools in power of 2's.
+ *
+ * @param pool0_size size (in octets) of the smallest allocatable buffer; it
+ * must be a power of 2
+ * @param nb_pools number of buffer pools to maintain, with sizes in power of
+ * 2's increments; larger buffers will be directly managed with malloc() and
+ * free()
+ * @param max_memory maximum number of octets kept in all pools
+ * @param max_depth maximum number of buffers kept in each pool
+ * @param window number of allocations from a pool between adaptations
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_pool_mgr_alloc_adaptive(size_t pool0_size,
+                                              size_t nb_pools,
+                                              uint64_t max_memory,
+                                              uint16_t max_depth,
+                                              unsigned int window)
+{
+    if (unlikely(!window))
+        return NULL;
+
+    /* a pool never needs more buffers than the memory bound allows */
+    unsigned int pools_depths[nb_pools];
+    for (unsigned int i = 0; i < nb_pools; i++) {
+        uint64_t depth = max_memory / (pool0_size << i);
+        pools_depths[i] = depth < max_depth ? depth : max_depth;
+    }
+
+    struct umem_pool_mgr *pool_mgr =
+        umem_pool_mgr_alloc_internal(pool0_size, nb_pools, pools_depths,
+                                     true);
+    if (unlikely(pool_mgr == NULL))
+        return NULL;
+    pool_mgr->window = window;
+    pool_mgr->max_memory = max_memory;
+    return umem_pool_mgr_to_umem_mgr(pool_mgr);
+}
+
+/** @This allocates a new instance of the umem pool manager allocating buffers
+ * from application memory, using adaptive pools in power of 2's, with a
+ * simpler API.
+ *
+ * @param max_memory maximum number of octets kept in all pools
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_pool_mgr_alloc_adaptive_simple(uint64_t max_memory)
+{
+    return umem_pool_mgr_alloc_adaptive(32, 18, max_memory,
+                                        UMEM_POOL_ADAPTIVE_MAX_DEPTH,
+                                        UMEM_POOL_ADAPTIVE_WINDOW);
+}
@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short Upipe ring memory allocator for single-producer transports
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/urefcount.h>
+#include <upipe/uatomic.h>
+#include <upipe/umem.h>
+#include <upipe/umem_ring.h>
+#include <upipe/ualloc_audit.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdarg.h>
+#include <assert.h>
+
+/** alignment of chunks in the ring, and size of their header */
+#define UMEM_RING_ALIGN 64
+
+/** @This is the header preceding each buffer in the ring. */
+struct umem_ring_chunk {
+    /** set when the buffer has been released (possibly by another thread) */
+    uatomic_uint32_t freed;
+    /** size of the chunk in octets, including the header */
+    uint32_t size;
+};
+
+/** @This is the private context of a umem ring manager. */
+struct umem_ring_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** ring space */
+    uint8_t *ring;
+    /** size of the ring space */
+    size_t ring_size;
+    /** offset of the next chunk to allocate (producer only) */
+    size_t head;
+    /** number of octets currently reserved in the ring (producer only) */
+    size_t used;
+
+    /** allocation statistics (producer only) */
+    struct umem_mgr_stats stats;
+
+    /** common management structure */
+    struct umem_mgr mgr;
+};
+
+UBASE_FROM_TO(umem_ring_mgr, umem_mgr, umem_mgr, mgr)
+UBASE_FROM_TO(umem_ring_mgr, urefcount, urefcount, urefcount)
+
+/** @internal @This returns the chunk at the given offset of the ring.
+ *
+ * @param ring_mgr pointer to umem ring manager
+ * @param offset offset in the ring
+ * @return pointer to chunk
+ */
+static inline struct umem_ring_chunk *
+    umem_ring_chunk_at(struct umem_ring_mgr *ring_mgr, size_t offset)
+{
+    return (struct umem_ring_chunk *)(ring_mgr->ring + offset);
+}
+
+/** @internal @This returns the chunk owning a buffer, or NULL if the buffer
+ * was allocated outside of the ring.
+ *
+ * @param ring_mgr pointer to umem ring manager
+ * @param buffer pointer to buffer
+ * @return pointer to chunk, or NULL
+ */
+static inline struct umem_ring_chunk *
+    umem_ring_chunk_from_buffer(struct umem_ring_mgr *ring_mgr,
+                                uint8_t *buffer)
+{
+    if (buffer < ring_mgr->ring ||
+        buffer >= ring_mgr->ring + ring_mgr->ring_size)
+        return NULL;
+    return (struct umem_ring_chunk *)(buffer - UMEM_RING_ALIGN);
+}
+
+/** @internal @This reclaims the chunks released at the tail of the ring.
+ *
+ * @param ring_mgr pointer to umem ring manager
+ */
+static void umem_ring_reclaim(struct umem_ring_mgr *ring_mgr)
+{
+    while (ring_mgr->used) {
+        size_t tail = ring_mgr->head >= ring_mgr->used ?
+                      ring_mgr->head - ring_mgr->used :
+                      ring_mgr->head + ring_mgr->ring_size - ring_mgr->used;
+        struct umem_ring_chunk *chunk = umem_ring_chunk_at(ring_mgr, tail);
+        if (!uatomic_load(&chunk->freed))
+            break;
+        ring_mgr->used -= chunk->size;
+    }
+}
+
+/** @internal @This reserves a chunk at the head of the ring.
+ *
+ * @param ring_mgr pointer to umem ring manager
+ * @param size size of the chunk, including the header
+ * @return pointer to chunk, or NULL if the ring is full
+ */
+static struct umem_ring_chunk *umem_ring_reserve(struct umem_ring_mgr *ring_mgr,
+                                                 size_t size)
+{
+    umem_ring_reclaim(ring_mgr);
+    if (unlikely(size > ring_mgr->ring_size - ring_mgr->used))
+        return NULL;
+
+    if (!ring_mgr->used)
+        ring_mgr->head = 0;
+    else if (ring_mgr->head + size > ring_mgr->ring_size) {
+        /* not enough contiguous space, pad until the end of the ring */
+        size_t padding = ring_mgr->ring_size - ring_mgr->head;
+        if (ring_mgr->used + padding + size > ring_mgr->ring_size)
+            return NULL;
+        struct umem_ring_chunk *chunk =
+            umem_ring_chunk_at(ring_mgr, ring_mgr->head);
+        chunk->size = padding;
+        uatomic_store(&chunk->freed, 1);
+        ring_mgr->used += padding;
+        ring_mgr->head = 0;
+    }
+
+    struct umem_ring_chunk *chunk = umem_ring_chunk_at(ring_mgr,
+                                                       ring_mgr->head);
+    chunk->size = size;
+    uatomic_store(&chunk->freed, 0);
+    ring_mgr->used += size;
+    ring_mgr->head += size;
+    if (ring_mgr->head == ring_mgr->ring_size)
+        ring_mgr->head = 0;
+    return chunk;
+}
+
+/** @This allocates a new umem buffer space. It must always be called from
+ * the same thread.
+ *
+ * @param mgr pointer to umem manager
+ * @param umem caller-allocated structure, filled in with the required pointer
+ * and size (previous content is discarded)
+ * @param size requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_ring_alloc(struct umem_mgr *mgr, struct umem *umem,
+                            size_t size)
+{
+    struct umem_ring_mgr *ring_mgr = umem_ring_mgr_from_umem_mgr(mgr);
+    size_t chunk_size = UMEM_RING_ALIGN +
+        (size + UMEM_RING_ALIGN - 1) / UMEM_RING_ALIGN * UMEM_RING_ALIGN;
+    struct umem_ring_chunk *chunk = NULL;
+    if (likely(chunk_size <= UINT32_MAX))
+        chunk = umem_ring_reserve(ring_mgr, chunk_size);
+
+    uint8_t *buffer;
+    size_t real_size;
+    if (likely(chunk != NULL)) {
+        ring_mgr->stats.hits++;
+        buffer = (uint8_t *)chunk + UMEM_RING_ALIGN;
+        real_size = chunk_size - UMEM_RING_ALIGN;
+    } else {
+        ring_mgr->stats.fallbacks++;
+        ualloc_audit_fallback("umem_ring");
+        buffer = malloc(size);
+        if (unlikely(buffer == NULL))
+            return false;
+        real_size = size;
+    }
+
+    umem->buffer = buffer;
+    umem->size = size;
+    umem->real_size = real_size;
+    umem->mgr = mgr;
+    return true;
+}
+
+/** @This resizes a umem. A buffer that doesn't fit in its chunk anymore is
+ * moved to the system allocator, so that this may be called from any thread.
+ *
+ * @param umem caller-allocated structure, previously successfully passed to
+ * @ref umem_alloc, and filled in with the new pointer and size
+ * @param new_size new requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_ring_realloc(struct umem *umem, size_t new_size)
+{
+    struct umem_ring_mgr *ring_mgr = umem_ring_mgr_from_umem_mgr(umem->mgr);
+    struct umem_ring_chunk *chunk =
+        umem_ring_chunk_from_buffer(ring_mgr, umem->buffer);
+
+    if (chunk == NULL) {
+        uint8_t *buffer = realloc(umem->buffer, new_size);
+        if (unlikely(buffer == NULL))
+            return false;
+        umem->buffer = buffer;
+        umem->real_size = new_size;
+    } else if (new_size > umem->real_size) {
+        ualloc_audit_fallback("umem_ring");
+        uint8_t *buffer = malloc(new_size);
+        if (unlikely(buffer == NULL))
+            return false;
+        memcpy(buffer, umem->buffer, umem->size);
+        uatomic_store(&chunk->freed, 1);
+        umem->buffer = buffer;
+        umem->real_size = new_size;
+    }
+
+    umem->size = new_size;
+    return true;
+}
+
+/** @This frees a umem. It may be called from any thread.
+ *
+ * @param umem pointer to umem
+ */
+static void umem_ring_free(struct umem *umem)
+{
+    struct umem_ring_mgr *ring_mgr = umem_ring_mgr_from_umem_mgr(umem->mgr);
+    struct umem_ring_chunk *chunk =
+        umem_ring_chunk_from_buffer(ring_mgr, umem->buffer);
+
+    if (chunk != NULL) {
+        uatomic_store(&chunk->freed, 1);
+        umem->buffer = NULL;
+    } else
+        ubase_clean_data(&umem->buffer);
+    umem->mgr = NULL;
+}
+
+/** @This processes control commands on a umem manager.
+ *
+ * @param mgr pointer to umem manager
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int umem_ring_mgr_control(struct umem_mgr *mgr,
+                                 int command, va_list args)
+{
+    struct umem_ring_mgr *ring_mgr = umem_ring_mgr_from_umem_mgr(mgr);
+
+    switch (command) {
+        case UMEM_MGR_GET_STATS: {
+            struct umem_mgr_stats *stats =
+                va_arg(args, struct umem_mgr_stats *);
+            assert(stats != NULL);
+            *stats = ring_mgr->stats;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a umem manager.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void umem_ring_mgr_free(struct urefcount *urefcount)
+{
+    struct umem_ring_mgr *ring_mgr = umem_ring_mgr_from_urefcount(urefcount);
+    free(ring_mgr->ring);
+    urefcount_clean(urefcount);
+    free(ring_mgr);
+}
+
+/** @This allocates a new instance of the umem ring manager.
+ *
+ * @param ring_size size of the ring in octets
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_ring_mgr_alloc(size_t ring_size)
+{
+    ring_size = ring_size / UMEM_RING_ALIGN * UMEM_RING_ALIGN;
+    if (unlikely(!ring_size))
+        return NULL;
+
+    struct umem_ring_mgr *ring_mgr = malloc(sizeof(struct umem_ring_mgr));
+    if (unlikely(ring_mgr == NULL))
+        return NULL;
+
+    void *ring;
+    if (unlikely(posix_memalign(&ring, UMEM_RING_ALIGN, ring_size))) {
+        free(ring_mgr);
+        return NULL;
+    }
+
+    ring_mgr->ring = ring;
+    ring_mgr->ring_size = ring_size;
+    ring_mgr->head = 0;
+    ring_mgr->used = 0;
+    memset(&ring_mgr->stats, 0, sizeof(ring_mgr->stats));
+
+    urefcount_init(umem_ring_mgr_to_urefcount(ring_mgr), umem_ring_mgr_free);
+    ring_mgr->mgr.refcount = umem_ring_mgr_to_urefcount(ring_mgr);
+    ring_mgr->mgr.umem_alloc = umem_ring_alloc;
+    ring_mgr->mgr.umem_realloc = umem_ring_realloc;
+    ring_mgr->mgr.umem_free = umem_ring_free;
+    ring_mgr->mgr.umem_mgr_vacuum = NULL;
+    ring_mgr->mgr.umem_mgr_control = umem_ring_mgr_control;
+
+    return umem_ring_mgr_to_umem_mgr(ring_mgr);
+}
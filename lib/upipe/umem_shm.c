@@ -0,0 +1,576 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe shared memory allocator for multi-process pipelines
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/urefcount.h>
+#include <upipe/uatomic.h>
+#include <upipe/umem.h>
+#include <upipe/umem_shm.h>
+#include <upipe/ualloc_audit.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/** magic number identifying an initialized segment */
+#define UMEM_SHM_MAGIC UBASE_FOURCC('u','s','h','m')
+/** version of the segment layout */
+#define UMEM_SHM_VERSION 1
+/** alignment of slots and messages, and of the areas of the segment */
+#define UMEM_SHM_ALIGN 64
+
+/** @This is the header of the shared memory segment. Only fixed-size types
+ * are used, since it is shared between processes. */
+struct umem_shm_segment {
+    /** set to @ref UMEM_SHM_MAGIC once the segment is initialized */
+    uatomic_uint32_t magic;
+    /** version of the layout */
+    uint32_t version;
+    /** total size of the segment */
+    uint64_t size;
+    /** size of a slot */
+    uint64_t slot_size;
+    /** size of a message */
+    uint64_t msg_size;
+    /** distance between two messages in the ring */
+    uint64_t msg_stride;
+    /** number of slots */
+    uint32_t nb_slots;
+    /** maximum number of messages in the ring */
+    uint32_t ring_length;
+    /** offset of the slot reference counters */
+    uint64_t refcounts_offset;
+    /** offset of the ring of messages */
+    uint64_t ring_offset;
+    /** offset of the slots */
+    uint64_t slots_offset;
+    /** index of the slot to try first on the next allocation */
+    uatomic_uint32_t hint;
+    /** number of messages pushed (producer) */
+    uatomic_uint32_t ring_head;
+    /** number of messages popped (consumer) */
+    uatomic_uint32_t ring_tail;
+};
+
+/** @This is the private context of a umem shm manager. */
+struct umem_shm_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** name of the segment to unlink on exit, or NULL if attached */
+    char *name;
+    /** mapped segment */
+    struct umem_shm_segment *segment;
+    /** size of the mapping */
+    size_t size;
+    /** slot reference counters */
+    uatomic_uint32_t *refcounts;
+    /** ring of messages */
+    uint8_t *ring;
+    /** slots */
+    uint8_t *slots;
+
+    /** common management structure */
+    struct umem_mgr mgr;
+};
+
+UBASE_FROM_TO(umem_shm_mgr, umem_mgr, umem_mgr, mgr)
+UBASE_FROM_TO(umem_shm_mgr, urefcount, urefcount, urefcount)
+
+/** @hidden */
+static bool umem_shm_alloc(struct umem_mgr *mgr, struct umem *umem,
+                           size_t size);
+
+/** @internal @This returns the private context of a umem shm manager.
+ *
+ * @param mgr pointer to umem manager
+ * @return pointer to umem shm manager
+ */
+static inline struct umem_shm_mgr *umem_shm_mgr(struct umem_mgr *mgr)
+{
+    assert(mgr->umem_alloc == umem_shm_alloc);
+    return umem_shm_mgr_from_umem_mgr(mgr);
+}
+
+/** @internal @This returns the slot containing a buffer.
+ *
+ * @param shm_mgr pointer to umem shm manager
+ * @param buffer pointer to buffer
+ * @return index of the slot, or UINT32_MAX if the buffer was allocated
+ * outside of the segment
+ */
+static inline uint32_t umem_shm_slot_from_buffer(struct umem_shm_mgr *shm_mgr,
+                                                 const uint8_t *buffer)
+{
+    struct umem_shm_segment *segment = shm_mgr->segment;
+    if (buffer < shm_mgr->slots ||
+        buffer >= shm_mgr->slots + segment->slot_size * segment->nb_slots)
+        return UINT32_MAX;
+    return (buffer - shm_mgr->slots) / segment->slot_size;
+}
+
+/** @internal @This returns the buffer of a slot.
+ *
+ * @param shm_mgr pointer to umem shm manager
+ * @param slot index of the slot
+ * @return pointer to buffer
+ */
+static inline uint8_t *umem_shm_slot_buffer(struct umem_shm_mgr *shm_mgr,
+                                            uint32_t slot)
+{
+    return shm_mgr->slots + shm_mgr->segment->slot_size * slot;
+}
+
+/** @internal @This finds an unused slot and takes a reference to it.
+ *
+ * @param shm_mgr pointer to umem shm manager
+ * @return index of the slot, or UINT32_MAX if all slots are in use
+ */
+static uint32_t umem_shm_slot_alloc(struct umem_shm_mgr *shm_mgr)
+{
+    struct umem_shm_segment *segment = shm_mgr->segment;
+    uint32_t start = uatomic_fetch_add(&segment->hint, 1) % segment->nb_slots;
+    for (uint32_t i = 0; i < segment->nb_slots; i++) {
+        uint32_t slot = (start + i) % segment->nb_slots;
+        uint32_t expected = 0;
+        if (uatomic_load(&shm_mgr->refcounts[slot]) == 0 &&
+            uatomic_compare_exchange(&shm_mgr->refcounts[slot],
+                                     &expected, 1))
+            return slot;
+    }
+    return UINT32_MAX;
+}
+
+/** @internal @This releases a reference to a slot.
+ *
+ * @param shm_mgr pointer to umem shm manager
+ * @param slot index of the slot
+ */
+static inline void umem_shm_slot_release(struct umem_shm_mgr *shm_mgr,
+                                         uint32_t slot)
+{
+    uint32_t refcount = uatomic_fetch_sub(&shm_mgr->refcounts[slot], 1);
+    assert(refcount > 0);
+    (void)refcount;
+}
+
+/** @This allocates a new umem buffer space.
+ *
+ * @param mgr pointer to umem manager
+ * @param umem caller-allocated structure, filled in with the required pointer
+ * and size (previous content is discarded)
+ * @param size requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_shm_alloc(struct umem_mgr *mgr, struct umem *umem,
+                           size_t size)
+{
+    struct umem_shm_mgr *shm_mgr = umem_shm_mgr_from_umem_mgr(mgr);
+    uint32_t slot = UINT32_MAX;
+    if (likely(size <= shm_mgr->segment->slot_size))
+        slot = umem_shm_slot_alloc(shm_mgr);
+
+    if (likely(slot != UINT32_MAX)) {
+        umem->buffer = umem_shm_slot_buffer(shm_mgr, slot);
+        umem->real_size = shm_mgr->segment->slot_size;
+    } else {
+        ualloc_audit_fallback("umem_shm");
+        umem->buffer = malloc(size);
+        if (unlikely(umem->buffer == NULL))
+            return false;
+        umem->real_size = size;
+    }
+    umem->size = size;
+    umem->mgr = mgr;
+    return true;
+}
+
+/** @This resizes a umem. A buffer that doesn't fit in its slot anymore is
+ * moved to the system allocator.
+ *
+ * @param umem caller-allocated structure, previously successfully passed to
+ * @ref umem_alloc, and filled in with the new pointer and size
+ * @param new_size new requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_shm_realloc(struct umem *umem, size_t new_size)
+{
+    struct umem_shm_mgr *shm_mgr = umem_shm_mgr_from_umem_mgr(umem->mgr);
+    uint32_t slot = umem_shm_slot_from_buffer(shm_mgr, umem->buffer);
+
+    if (slot == UINT32_MAX) {
+        uint8_t *buffer = realloc(umem->buffer, new_size);
+        if (unlikely(buffer == NULL))
+            return false;
+        umem->buffer = buffer;
+        umem->real_size = new_size;
+    } else if (new_size > umem->real_size) {
+        ualloc_audit_fallback("umem_shm");
+        uint8_t *buffer = malloc(new_size);
+        if (unlikely(buffer == NULL))
+            return false;
+        memcpy(buffer, umem->buffer, umem->size);
+        umem_shm_slot_release(shm_mgr, slot);
+        umem->buffer = buffer;
+        umem->real_size = new_size;
+    }
+
+    umem->size = new_size;
+    return true;
+}
+
+/** @This frees a umem.
+ *
+ * @param umem pointer to umem
+ */
+static void umem_shm_free(struct umem *umem)
+{
+    struct umem_shm_mgr *shm_mgr = umem_shm_mgr_from_umem_mgr(umem->mgr);
+    uint32_t slot = umem_shm_slot_from_buffer(shm_mgr, umem->buffer);
+
+    if (slot != UINT32_MAX) {
+        umem_shm_slot_release(shm_mgr, slot);
+        umem->buffer = NULL;
+    } else
+        ubase_clean_data(&umem->buffer);
+    umem->mgr = NULL;
+}
+
+/** @This frees a umem manager.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void umem_shm_mgr_free(struct urefcount *urefcount)
+{
+    struct umem_shm_mgr *shm_mgr = umem_shm_mgr_from_urefcount(urefcount);
+    munmap(shm_mgr->segment, shm_mgr->size);
+    if (shm_mgr->name != NULL) {
+        shm_unlink(shm_mgr->name);
+        free(shm_mgr->name);
+    }
+    urefcount_clean(urefcount);
+    free(shm_mgr);
+}
+
+/** @internal @This allocates a umem shm manager on a mapped segment.
+ *
+ * @param segment mapped segment
+ * @param size size of the mapping
+ * @return pointer to manager, or NULL in case of error
+ */
+static struct umem_mgr *umem_shm_mgr_alloc_segment(
+        struct umem_shm_segment *segment, size_t size)
+{
+    struct umem_shm_mgr *shm_mgr = malloc(sizeof(struct umem_shm_mgr));
+    if (unlikely(shm_mgr == NULL)) {
+        munmap(segment, size);
+        return NULL;
+    }
+
+    shm_mgr->name = NULL;
+    shm_mgr->segment = segment;
+    shm_mgr->size = size;
+    shm_mgr->refcounts =
+        (uatomic_uint32_t *)((uint8_t *)segment + segment->refcounts_offset);
+    shm_mgr->ring = (uint8_t *)segment + segment->ring_offset;
+    shm_mgr->slots = (uint8_t *)segment + segment->slots_offset;
+
+    urefcount_init(umem_shm_mgr_to_urefcount(shm_mgr), umem_shm_mgr_free);
+    shm_mgr->mgr.refcount = umem_shm_mgr_to_urefcount(shm_mgr);
+    shm_mgr->mgr.umem_alloc = umem_shm_alloc;
+    shm_mgr->mgr.umem_realloc = umem_shm_realloc;
+    shm_mgr->mgr.umem_free = umem_shm_free;
+    shm_mgr->mgr.umem_mgr_vacuum = NULL;
+    shm_mgr->mgr.umem_mgr_control = NULL;
+
+    return umem_shm_mgr_to_umem_mgr(shm_mgr);
+}
+
+/** @This allocates a new instance of the umem shm manager, and creates the
+ * shared memory segment.
+ *
+ * @param name name of the segment, as passed to shm_open()
+ * @param slot_size size of a slot in octets (rounded up to 64 octets)
+ * @param nb_slots number of slots in the segment
+ * @param ring_length maximum number of messages in the ring
+ * @param msg_size size of a message in octets
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_shm_mgr_alloc(const char *name, size_t slot_size,
+                                    uint32_t nb_slots, uint32_t ring_length,
+                                    size_t msg_size)
+{
+    if (unlikely(name == NULL || !slot_size || !nb_slots || !ring_length ||
+                 !msg_size || nb_slots == UINT32_MAX))
+        return NULL;
+
+    slot_size = (slot_size + UMEM_SHM_ALIGN - 1) & ~(size_t)(UMEM_SHM_ALIGN - 1);
+    size_t msg_stride =
+        (msg_size + UMEM_SHM_ALIGN - 1) & ~(size_t)(UMEM_SHM_ALIGN - 1);
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (page_size <= 0)
+        page_size = 4096;
+
+    size_t refcounts_offset =
+        (sizeof(struct umem_shm_segment) + UMEM_SHM_ALIGN - 1) &
+        ~(size_t)(UMEM_SHM_ALIGN - 1);
+    size_t ring_offset = refcounts_offset +
+        ((sizeof(uatomic_uint32_t) * nb_slots + UMEM_SHM_ALIGN - 1) &
+         ~(size_t)(UMEM_SHM_ALIGN - 1));
+    size_t slots_offset = ring_offset + msg_stride * ring_length;
+    slots_offset = (slots_offset + page_size - 1) & ~(size_t)(page_size - 1);
+    if (unlikely(slot_size > (SIZE_MAX - slots_offset) / nb_slots))
+        return NULL;
+    size_t size = slots_offset + slot_size * nb_slots;
+
+    char *name_copy = strdup(name);
+    if (unlikely(name_copy == NULL))
+        return NULL;
+    shm_unlink(name);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (unlikely(fd == -1)) {
+        free(name_copy);
+        return NULL;
+    }
+    if (unlikely(ftruncate(fd, size) == -1)) {
+        close(fd);
+        shm_unlink(name);
+        free(name_copy);
+        return NULL;
+    }
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (unlikely(map == MAP_FAILED)) {
+        shm_unlink(name);
+        free(name_copy);
+        return NULL;
+    }
+
+    /* the segment is zeroed by ftruncate(), so are the counters */
+    struct umem_shm_segment *segment = map;
+    segment->version = UMEM_SHM_VERSION;
+    segment->size = size;
+    segment->slot_size = slot_size;
+    segment->msg_size = msg_size;
+    segment->msg_stride = msg_stride;
+    segment->nb_slots = nb_slots;
+    segment->ring_length = ring_length;
+    segment->refcounts_offset = refcounts_offset;
+    segment->ring_offset = ring_offset;
+    segment->slots_offset = slots_offset;
+    uatomic_store(&segment->magic, UMEM_SHM_MAGIC);
+
+    struct umem_mgr *mgr = umem_shm_mgr_alloc_segment(segment, size);
+    if (unlikely(mgr == NULL)) {
+        shm_unlink(name);
+        free(name_copy);
+        return NULL;
+    }
+    umem_shm_mgr_from_umem_mgr(mgr)->name = name_copy;
+    return mgr;
+}
+
+/** @This allocates a new instance of the umem shm manager, attaching to an
+ * existing shared memory segment.
+ *
+ * @param name name of the segment, as passed to shm_open()
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_shm_mgr_attach(const char *name)
+{
+    if (unlikely(name == NULL))
+        return NULL;
+
+    int fd = shm_open(name, O_RDWR, 0);
+    if (unlikely(fd == -1))
+        return NULL;
+    struct stat st;
+    if (unlikely(fstat(fd, &st) == -1 ||
+                 st.st_size < (off_t)sizeof(struct umem_shm_segment))) {
+        close(fd);
+        return NULL;
+    }
+    size_t size = st.st_size;
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (unlikely(map == MAP_FAILED))
+        return NULL;
+
+    struct umem_shm_segment *segment = map;
+    if (unlikely(uatomic_load(&segment->magic) != UMEM_SHM_MAGIC ||
+                 segment->version != UMEM_SHM_VERSION ||
+                 segment->size != size)) {
+        munmap(map, size);
+        return NULL;
+    }
+    return umem_shm_mgr_alloc_segment(segment, size);
+}
+
+/** @This returns the size of the slots of a umem shm manager.
+ *
+ * @param mgr pointer to umem shm manager
+ * @return size of a slot in octets
+ */
+size_t umem_shm_mgr_slot_size(struct umem_mgr *mgr)
+{
+    return umem_shm_mgr(mgr)->segment->slot_size;
+}
+
+/** @This returns the size of the messages of a umem shm manager.
+ *
+ * @param mgr pointer to umem shm manager
+ * @return size of a message in octets
+ */
+size_t umem_shm_mgr_msg_size(struct umem_mgr *mgr)
+{
+    return umem_shm_mgr(mgr)->segment->msg_size;
+}
+
+/** @This takes a new reference on the slot containing the given buffer.
+ *
+ * @param mgr pointer to umem shm manager
+ * @param buffer pointer to the beginning of the buffer
+ * @param size size of the buffer in octets
+ * @param slot_p filled in with the index of the slot
+ * @param offset_p filled in with the offset of the buffer in the slot
+ * @return an error code
+ */
+int umem_shm_mgr_export(struct umem_mgr *mgr, const uint8_t *buffer,
+                        size_t size, uint32_t *slot_p, uint32_t *offset_p)
+{
+    struct umem_shm_mgr *shm_mgr = umem_shm_mgr(mgr);
+    uint32_t slot = umem_shm_slot_from_buffer(shm_mgr, buffer);
+    if (slot == UINT32_MAX)
+        return UBASE_ERR_INVALID;
+    size_t offset = buffer - umem_shm_slot_buffer(shm_mgr, slot);
+    if (unlikely(size > shm_mgr->segment->slot_size - offset))
+        return UBASE_ERR_INVALID;
+
+    /* the caller holds a reference, so the slot can't be reused meanwhile */
+    assert(uatomic_load(&shm_mgr->refcounts[slot]) > 0);
+    uatomic_fetch_add(&shm_mgr->refcounts[slot], 1);
+    *slot_p = slot;
+    *offset_p = offset;
+    return UBASE_ERR_NONE;
+}
+
+/** @This allocates a slot and takes a reference to it.
+ *
+ * @param mgr pointer to umem shm manager
+ * @param slot_p filled in with the index of the slot
+ * @return pointer to the slot buffer, or NULL if all slots are in use
+ */
+uint8_t *umem_shm_mgr_reserve(struct umem_mgr *mgr, uint32_t *slot_p)
+{
+    struct umem_shm_mgr *shm_mgr = umem_shm_mgr(mgr);
+    uint32_t slot = umem_shm_slot_alloc(shm_mgr);
+    if (unlikely(slot == UINT32_MAX))
+        return NULL;
+    *slot_p = slot;
+    return umem_shm_slot_buffer(shm_mgr, slot);
+}
+
+/** @This releases a reference on a slot.
+ *
+ * @param mgr pointer to umem shm manager
+ * @param slot index of the slot
+ */
+void umem_shm_mgr_unref(struct umem_mgr *mgr, uint32_t slot)
+{
+    struct umem_shm_mgr *shm_mgr = umem_shm_mgr(mgr);
+    assert(slot < shm_mgr->segment->nb_slots);
+    umem_shm_slot_release(shm_mgr, slot);
+}
+
+/** @This wraps a slot into a umem, taking over a reference.
+ *
+ * @param mgr pointer to umem shm manager
+ * @param umem caller-allocated structure, filled in with the whole slot
+ * @param slot index of the slot
+ * @return an error code
+ */
+int umem_shm_mgr_import(struct umem_mgr *mgr, struct umem *umem,
+                        uint32_t slot)
+{
+    struct umem_shm_mgr *shm_mgr = umem_shm_mgr(mgr);
+    if (unlikely(slot >= shm_mgr->segment->nb_slots ||
+                 !uatomic_load(&shm_mgr->refcounts[slot])))
+        return UBASE_ERR_INVALID;
+
+    umem->buffer = umem_shm_slot_buffer(shm_mgr, slot);
+    umem->size = umem->real_size = shm_mgr->segment->slot_size;
+    umem->mgr = mgr;
+    return UBASE_ERR_NONE;
+}
+
+/** @This pushes a message into the ring of the segment.
+ *
+ * @param mgr pointer to umem shm manager
+ * @param msg pointer to the message
+ * @return false if the ring is full
+ */
+bool umem_shm_mgr_push(struct umem_mgr *mgr, const void *msg)
+{
+    struct umem_shm_mgr *shm_mgr = umem_shm_mgr(mgr);
+    struct umem_shm_segment *segment = shm_mgr->segment;
+    uint32_t head = uatomic_load(&segment->ring_head);
+    if (head - uatomic_load(&segment->ring_tail) >= segment->ring_length)
+        return false;
+
+    memcpy(shm_mgr->ring + (head % segment->ring_length) * segment->msg_stride,
+           msg, segment->msg_size);
+    uatomic_store(&segment->ring_head, head + 1);
+    return true;
+}
+
+/** @This pops a message from the ring of the segment.
+ *
+ * @param mgr pointer to umem shm manager
+ * @param msg filled in with the message
+ * @return false if the ring is empty
+ */
+bool umem_shm_mgr_pop(struct umem_mgr *mgr, void *msg)
+{
+    struct umem_shm_mgr *shm_mgr = umem_shm_mgr(mgr);
+    struct umem_shm_segment *segment = shm_mgr->segment;
+    uint32_t tail = uatomic_load(&segment->ring_tail);
+    if (tail == uatomic_load(&segment->ring_head))
+        return false;
+
+    memcpy(msg,
+           shm_mgr->ring + (tail % segment->ring_length) * segment->msg_stride,
+           segment->msg_size);
+    uatomic_store(&segment->ring_tail, tail + 1);
+    return true;
+}
@@ -28,14 +28,21 @@
  */
 
 #include <upipe/ubase.h>
+#include <upipe/uclock.h>
+#include <upipe/upump.h>
 #include <upipe/upipe.h>
 #include <upipe/upipe_dump.h>
 #include <upipe/uprobe_prefix.h>
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <errno.h>
 #include <assert.h>
 
+/** @This is the percentile of the input latency reported by the dumps. */
+#define UPIPE_DUMP_LATENCY_PERCENTILE 99
+
 /** @This is a structure allocated per pipe. */
 struct upipe_dump_ctx {
     /** unique ID for pipe input */
@@ -101,6 +108,67 @@ char *upipe_dump_flow_def_label_default(struct uref *flow_def)
     return string;
 }
 
+/** @internal @This computes the throughput of an instrumented pipe since
+ * its counters were enabled.
+ *
+ * @param stats instrumentation counters
+ * @param urefs_p filled in with the number of urefs per second
+ * @param bytes_p filled in with the number of octets per second
+ * @return false if the counters do not cover any measurable duration
+ */
+static bool upipe_dump_throughput(const struct upipe_stats *stats,
+                                  double *urefs_p, double *bytes_p)
+{
+    if (stats->last <= stats->start) {
+        *urefs_p = *bytes_p = 0;
+        return false;
+    }
+    double duration = (double)(stats->last - stats->start) / UCLOCK_FREQ;
+    *urefs_p = stats->urefs / duration;
+    *bytes_p = stats->bytes / duration;
+    return true;
+}
+
+/** @This converts a pipe to a label, annotated with its instrumentation
+ * counters if they are enabled (see @ref upipe_stats_enable).
+ *
+ * @param upipe upipe structure
+ * @return allocated string
+ */
+char *upipe_dump_upipe_label_stats(struct upipe *upipe)
+{
+    char *label = upipe_dump_upipe_label_default(upipe);
+    struct upipe_stats stats;
+    if (label == NULL || !ubase_check(upipe_get_stats(upipe, &stats)))
+        return label;
+
+    double urefs, bytes;
+    upipe_dump_throughput(&stats, &urefs, &bytes);
+    uint64_t mean = stats.urefs ? stats.input_time / stats.urefs : 0;
+    uint64_t pct = upipe_stats_latency_percentile(&stats,
+            UPIPE_DUMP_LATENCY_PERCENTILE);
+
+#define UPIPE_DUMP_STATS_FORMAT "%s\\n%.1f urefs/s, %.1f kbit/s\\l"         \
+    "latency mean %"PRIu64" us, p%u %"PRIu64" us\\l"                        \
+    "queue %u (max %u), held %"PRIu64" kB (max %"PRIu64" kB)\\l"
+    mean = mean * 1000000 / UCLOCK_FREQ;
+    pct = pct * 1000000 / UCLOCK_FREQ;
+    int len = snprintf(NULL, 0, UPIPE_DUMP_STATS_FORMAT, label, urefs, bytes * 8 / 1000,
+                       mean, UPIPE_DUMP_LATENCY_PERCENTILE, pct,
+                       stats.queue, stats.max_queue,
+                       stats.held_bytes / 1000, stats.max_held_bytes / 1000);
+    char *string = len < 0 ? NULL : malloc(len + 1);
+    if (string == NULL)
+        return label;
+    sprintf(string, UPIPE_DUMP_STATS_FORMAT, label, urefs, bytes * 8 / 1000,
+            mean, UPIPE_DUMP_LATENCY_PERCENTILE, pct,
+            stats.queue, stats.max_queue,
+            stats.held_bytes / 1000, stats.max_held_bytes / 1000);
+#undef UPIPE_DUMP_STATS_FORMAT
+    free(label);
+    return string;
+}
+
 /** @internal @This finds in the list of a pipe has already been printed.
  *
  * @param upipe first pipe of the pipeline
@@ -223,10 +291,19 @@ static void upipe_dump_pipe(upipe_dump_pipe_label pipe_label,
 
     struct upipe_dump_ctx *output_ctx =
             upipe_get_opaque(output, struct upipe_dump_ctx *);
-    fprintf(file, "pipe%"PRIu64"->pipe%"PRIu64" [label=\"%s\"];\n",
+    fprintf(file, "pipe%"PRIu64"->pipe%"PRIu64" [label=\"%s",
             ctx->output_uid, output_ctx->input_uid, label);
     free(label);
 
+    /* Annotate the edge with the input rate of the output. */
+    struct upipe_stats stats;
+    double urefs, bytes;
+    if (ubase_check(upipe_get_stats(output, &stats)) &&
+        upipe_dump_throughput(&stats, &urefs, &bytes))
+        fprintf(file, "%.1f urefs/s\\l%.1f kbit/s\\l",
+                urefs, bytes * 8 / 1000);
+    fprintf(file, "\"];\n");
+
 upipe_dump_pipe_end:
     fprintf(file, "#end pipe%"PRIu64"\n", ctx->input_uid);
 }
@@ -326,3 +403,388 @@ int upipe_dump_open_va(upipe_dump_pipe_label pipe_label,
     fclose(file);
     return UBASE_ERR_NONE;
 }
+
+/** @internal @This prints a string in JSON format.
+ *
+ * @param file file pointer to write to
+ * @param string string to print, or NULL
+ */
+static void upipe_dump_json_string(FILE *file, const char *string)
+{
+    if (string == NULL) {
+        fprintf(file, "null");
+        return;
+    }
+
+    fputc('"', file);
+    for (const char *p = string; *p; p++) {
+        if (*p == '"' || *p == '\\')
+            fprintf(file, "\\%c", *p);
+        else if ((unsigned char)*p < 0x20)
+            fprintf(file, "\\u%04x", (unsigned char)*p);
+        else
+            fputc(*p, file);
+    }
+    fputc('"', file);
+}
+
+/** @internal @This returns the unique ID of an already walked pipe.
+ *
+ * @param upipe upipe structure
+ * @return unique ID
+ */
+static uint64_t upipe_dump_json_uid(struct upipe *upipe)
+{
+    struct upipe_dump_ctx *ctx =
+        upipe_get_opaque(upipe, struct upipe_dump_ctx *);
+    return ctx->input_uid;
+}
+
+/** @internal @This prints the instrumentation counters of a pipe in JSON
+ * format.
+ *
+ * @param file file pointer to write to
+ * @param stats instrumentation counters
+ */
+static void upipe_dump_json_stats(FILE *file, const struct upipe_stats *stats)
+{
+    double urefs, bytes;
+    upipe_dump_throughput(stats, &urefs, &bytes);
+    uint64_t mean = stats->urefs ? stats->input_time / stats->urefs : 0;
+    uint64_t pct = upipe_stats_latency_percentile(stats,
+            UPIPE_DUMP_LATENCY_PERCENTILE);
+
+    fprintf(file, ", \"stats\": {\"urefs\": %"PRIu64", \"bytes\": %"PRIu64
+            ", \"urefs_per_sec\": %.1f, \"bytes_per_sec\": %.1f"
+            ", \"mean_latency_us\": %"PRIu64", \"p%u_latency_us\": %"PRIu64
+            ", \"max_latency_us\": %"PRIu64
+            ", \"queue\": %u, \"max_queue\": %u"
+            ", \"held_bytes\": %"PRIu64", \"max_held_bytes\": %"PRIu64"}",
+            stats->urefs, stats->bytes, urefs, bytes,
+            mean * 1000000 / UCLOCK_FREQ, UPIPE_DUMP_LATENCY_PERCENTILE,
+            pct * 1000000 / UCLOCK_FREQ,
+            stats->max_input_time * 1000000 / UCLOCK_FREQ,
+            stats->queue, stats->max_queue,
+            stats->held_bytes, stats->max_held_bytes);
+}
+
+/** @internal @This dumps a pipe and its neighbours in JSON format.
+ *
+ * @param file file pointer to write to
+ * @param upipe upipe to dump
+ * @param uid_p pointer to unique ID
+ * @param list list of already printed pipes
+ * @param last_output last output pipe of the pipeline
+ * @param first_p set to false once a pipe has been printed
+ */
+static void upipe_dump_json_pipe(FILE *file, struct upipe *upipe,
+                                 uint64_t *uid_p, struct uchain *list,
+                                 struct upipe *last_output, bool *first_p)
+{
+    if (upipe_dump_find(upipe, list))
+        return;
+
+    /* Prepare context. */
+    struct upipe_dump_ctx *ctx = malloc(sizeof(struct upipe_dump_ctx));
+    assert(ctx != NULL);
+    ctx->input_uid = ctx->output_uid = (*uid_p)++;
+    ctx->original_uchain = upipe->uchain;
+    ctx->original_opaque = upipe->opaque;
+    upipe_set_opaque(upipe, ctx);
+    ulist_add(list, upipe_to_uchain(upipe));
+
+    /* Walk the neighbours first so that their IDs are known. */
+    struct upipe *sub = NULL;
+    while (ubase_check(upipe_iterate_sub(upipe, &sub)) && sub != NULL)
+        upipe_dump_json_pipe(file, sub, uid_p, list, last_output, first_p);
+
+    upipe_bin_freeze(upipe);
+    struct upipe *first_inner = NULL;
+    struct upipe *last_inner = NULL;
+    upipe_bin_get_first_inner(upipe, &first_inner);
+    upipe_bin_get_last_inner(upipe, &last_inner);
+    if (first_inner != NULL || last_inner != NULL) {
+        first_inner = first_inner ?: last_inner;
+        last_inner = last_inner ?: first_inner;
+        upipe_dump_json_pipe(file, first_inner, uid_p, list, last_inner,
+                             first_p);
+        upipe_dump_json_pipe(file, last_inner, uid_p, list, last_inner,
+                             first_p);
+    }
+
+    struct upipe *output = NULL;
+    if (upipe != last_output) {
+        upipe_get_output(upipe, &output);
+        if (output != NULL)
+            upipe_dump_json_pipe(file, output, uid_p, list, last_output,
+                                 first_p);
+    }
+
+    /* Print the pipe. */
+    struct uprobe *uprobe = upipe->uprobe;
+    const char *name = NULL;
+    while (uprobe != NULL && name == NULL) {
+        name = uprobe_pfx_get_name(uprobe);
+        uprobe = uprobe->next;
+    }
+    char signature[5];
+    snprintf(signature, sizeof(signature), "%4.4s",
+             (const char *)&upipe->mgr->signature);
+
+    fprintf(file, "%s\n{\"id\": %"PRIu64", \"name\": ",
+            *first_p ? "" : ",", ctx->input_uid);
+    *first_p = false;
+    upipe_dump_json_string(file, name);
+    fprintf(file, ", \"signature\": ");
+    upipe_dump_json_string(file, signature);
+
+    fprintf(file, ", \"subs\": [");
+    sub = NULL;
+    bool first_sub = true;
+    while (ubase_check(upipe_iterate_sub(upipe, &sub)) && sub != NULL) {
+        fprintf(file, "%s%"PRIu64, first_sub ? "" : ", ",
+                upipe_dump_json_uid(sub));
+        first_sub = false;
+    }
+    fprintf(file, "]");
+
+    if (first_inner != NULL)
+        fprintf(file, ", \"first_inner\": %"PRIu64
+                ", \"last_inner\": %"PRIu64,
+                upipe_dump_json_uid(first_inner),
+                upipe_dump_json_uid(last_inner));
+    upipe_bin_thaw(upipe);
+
+    if (output != NULL) {
+        struct uref *flow_def = NULL;
+        const char *def = NULL;
+        upipe_get_flow_def(upipe, &flow_def);
+        if (flow_def != NULL)
+            uref_flow_get_def(flow_def, &def);
+        fprintf(file, ", \"output\": %"PRIu64", \"flow_def\": ",
+                upipe_dump_json_uid(output));
+        upipe_dump_json_string(file, def);
+    }
+
+    struct upipe_stats stats;
+    if (ubase_check(upipe_get_stats(upipe, &stats)))
+        upipe_dump_json_stats(file, &stats);
+    fprintf(file, "}");
+}
+
+/** @internal @This finishes a dump in JSON format, walking through the
+ * super-pipes that we may have forgotten, and cleans up.
+ *
+ * @param file file pointer to write to
+ * @param uid_p pointer to unique ID
+ * @param list list of already printed pipes
+ * @param first_p set to false once a pipe has been printed
+ */
+static void upipe_dump_json_end(FILE *file, uint64_t *uid_p,
+                                struct uchain *list, bool *first_p)
+{
+    struct uchain *uchain, *uchain_tmp;
+    uint64_t last_uid;
+    do {
+        last_uid = *uid_p;
+        ulist_foreach (list, uchain) {
+            struct upipe *upipe = upipe_from_uchain(uchain);
+            struct upipe *super = NULL;
+            while (ubase_check(upipe_sub_get_super(upipe, &upipe)) &&
+                   upipe != NULL)
+                super = upipe;
+            if (super != NULL)
+                upipe_dump_json_pipe(file, super, uid_p, list, NULL, first_p);
+        }
+    } while (last_uid != *uid_p);
+
+    fprintf(file, "\n]}\n");
+
+    /* Clean up. */
+    ulist_delete_foreach (list, uchain, uchain_tmp) {
+        struct upipe *upipe = upipe_from_uchain(uchain);
+        struct upipe_dump_ctx *ctx =
+            upipe_get_opaque(upipe, struct upipe_dump_ctx *);
+        upipe->uchain = ctx->original_uchain;
+        upipe->opaque = ctx->original_opaque;
+        free(ctx);
+    }
+}
+
+/** @This dumps a pipeline in JSON format, with the instrumentation counters
+ * of the pipes that have them enabled.
+ *
+ * @param file file pointer to write to
+ * @param ulist list of sources pipes in ulist format
+ * @param args list of sources pipes terminated with NULL
+ */
+void upipe_dump_json_va(FILE *file, struct uchain *ulist, va_list args)
+{
+    uint64_t uid = 0;
+    bool first = true;
+    struct uchain list;
+    struct uchain *uchain;
+    ulist_init(&list);
+
+    fprintf(file, "{\"pipes\": [");
+
+    if (ulist != NULL) {
+        ulist_foreach (ulist, uchain) {
+            struct upipe *source = upipe_from_uchain(uchain);
+            upipe_dump_json_pipe(file, source, &uid, &list, NULL, &first);
+        }
+    }
+
+    struct upipe *source;
+    while ((source = va_arg(args, struct upipe *)) != NULL)
+        upipe_dump_json_pipe(file, source, &uid, &list, NULL, &first);
+
+    upipe_dump_json_end(file, &uid, &list, &first);
+}
+
+/** @This opens a file and dumps a pipeline in JSON format.
+ *
+ * @param path path of the file to open
+ * @param ulist list of sources pipes in ulist format
+ * @param args list of sources pipes terminated with NULL
+ * @return an error code
+ */
+int upipe_dump_json_open_va(const char *path, struct uchain *ulist,
+                            va_list args)
+{
+    FILE *file = fopen(path, "w");
+    if (file == NULL)
+        return UBASE_ERR_EXTERNAL;
+
+    upipe_dump_json_va(file, ulist, args);
+    fclose(file);
+    return UBASE_ERR_NONE;
+}
+
+/** @This is the private context of a pipeline profiler. */
+struct upipe_dump_profiler {
+    /** timer pump */
+    struct upump *upump;
+    /** path of the file to write to */
+    char *path;
+    /** path of the temporary file */
+    char *tmp_path;
+    /** number of source pipes */
+    unsigned int nb_sources;
+    /** source pipes */
+    struct upipe **sources;
+};
+
+/** @internal @This is called periodically to export the pipeline.
+ *
+ * @param upump description structure of the timer
+ */
+static void upipe_dump_profiler_timer(struct upump *upump)
+{
+    struct upipe_dump_profiler *profiler =
+        upump_get_opaque(upump, struct upipe_dump_profiler *);
+    upipe_dump_profiler_export(profiler);
+}
+
+/** @This allocates a pipeline profiler, which periodically exports a
+ * pipeline in JSON format (see @ref upipe_dump_json_va). The file is
+ * replaced atomically so that it may be polled by another process.
+ *
+ * @param upump_mgr management structure of the event loop, or NULL to only
+ * export with @ref upipe_dump_profiler_export
+ * @param period period of the export, in units of @ref UCLOCK_FREQ
+ * @param path path of the file to write to
+ * @param args list of sources pipes terminated with NULL, which are used by
+ * the profiler
+ * @return pointer to profiler, or NULL in case of error
+ */
+struct upipe_dump_profiler *
+    upipe_dump_profiler_alloc_va(struct upump_mgr *upump_mgr, uint64_t period,
+                                 const char *path, va_list args)
+{
+    struct upipe_dump_profiler *profiler =
+        malloc(sizeof(struct upipe_dump_profiler));
+    if (unlikely(profiler == NULL))
+        return NULL;
+
+    profiler->upump = NULL;
+    profiler->nb_sources = 0;
+    profiler->sources = NULL;
+    profiler->path = strdup(path);
+    profiler->tmp_path = malloc(strlen(path) + sizeof(".tmp"));
+    if (unlikely(profiler->path == NULL || profiler->tmp_path == NULL))
+        goto upipe_dump_profiler_alloc_err;
+    sprintf(profiler->tmp_path, "%s.tmp", path);
+
+    struct upipe *source;
+    while ((source = va_arg(args, struct upipe *)) != NULL) {
+        struct upipe **sources = realloc(profiler->sources,
+                (profiler->nb_sources + 1) * sizeof(struct upipe *));
+        if (unlikely(sources == NULL))
+            goto upipe_dump_profiler_alloc_err;
+        profiler->sources = sources;
+        profiler->sources[profiler->nb_sources++] = upipe_use(source);
+    }
+
+    if (upump_mgr != NULL) {
+        profiler->upump = upump_alloc_timer(upump_mgr,
+                upipe_dump_profiler_timer, profiler, NULL, period, period);
+        if (unlikely(profiler->upump == NULL))
+            goto upipe_dump_profiler_alloc_err;
+        upump_start(profiler->upump);
+    }
+    return profiler;
+
+upipe_dump_profiler_alloc_err:
+    upipe_dump_profiler_free(profiler);
+    return NULL;
+}
+
+/** @This exports the pipeline of a profiler immediately.
+ *
+ * @param profiler pointer to profiler
+ * @return an error code
+ */
+int upipe_dump_profiler_export(struct upipe_dump_profiler *profiler)
+{
+    FILE *file = fopen(profiler->tmp_path, "w");
+    if (file == NULL)
+        return UBASE_ERR_EXTERNAL;
+
+    uint64_t uid = 0;
+    bool first = true;
+    struct uchain list;
+    ulist_init(&list);
+
+    fprintf(file, "{\"pipes\": [");
+    for (unsigned int i = 0; i < profiler->nb_sources; i++)
+        upipe_dump_json_pipe(file, profiler->sources[i], &uid, &list, NULL,
+                             &first);
+    upipe_dump_json_end(file, &uid, &list, &first);
+
+    if (fclose(file) != 0 || rename(profiler->tmp_path, profiler->path) < 0) {
+        remove(profiler->tmp_path);
+        return UBASE_ERR_EXTERNAL;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @This frees a pipeline profiler and releases its source pipes.
+ *
+ * @param profiler pointer to profiler
+ */
+void upipe_dump_profiler_free(struct upipe_dump_profiler *profiler)
+{
+    if (profiler == NULL)
+        return;
+    if (profiler->upump != NULL) {
+        upump_stop(profiler->upump);
+        upump_free(profiler->upump);
+    }
+    for (unsigned int i = 0; i < profiler->nb_sources; i++)
+        upipe_release(profiler->sources[i]);
+    free(profiler->sources);
+    free(profiler->tmp_path);
+    free(profiler->path);
+    free(profiler);
+}
@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short Upipe instrumentation of pipe inputs
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uclock.h>
+#include <upipe/uref.h>
+#include <upipe/ubuf_pic.h>
+#include <upipe/ubuf_sound.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_trace.h>
+#include <upipe/upipe.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/** @This is the private context of the instrumentation of a pipe. */
+struct upipe_stats_priv {
+    /** clock used to measure time, or NULL */
+    struct uclock *uclock;
+    /** period of the stats events */
+    uint64_t period;
+    /** date of the last stats event */
+    uint64_t last_report;
+    /** sampling period of the traced urefs, or 0 */
+    unsigned int trace_sample;
+    /** number of urefs to skip before stamping the next one */
+    unsigned int trace_countdown;
+
+    /** public counters */
+    struct upipe_stats stats;
+};
+
+UBASE_FROM_TO(upipe_stats_priv, upipe_stats, upipe_stats, stats)
+
+/** @This enables instrumentation of a pipe. Counting urefs and octets is
+ * always done; the time spent in the input function is only measured if a
+ * uclock is given, which also allows reporting the counters periodically
+ * with a @ref UPROBE_STATS event.
+ *
+ * @param upipe description structure of the pipe
+ * @param uclock clock used to measure time, or NULL
+ * @param period period of the @ref UPROBE_STATS events, or 0 to disable them
+ * @return an error code
+ */
+int upipe_stats_enable(struct upipe *upipe, struct uclock *uclock,
+                       uint64_t period)
+{
+    if (upipe->stats != NULL)
+        upipe_stats_disable(upipe);
+
+    struct upipe_stats_priv *priv = malloc(sizeof(struct upipe_stats_priv));
+    if (unlikely(priv == NULL))
+        return UBASE_ERR_ALLOC;
+
+    priv->uclock = uclock_use(uclock);
+    priv->period = uclock != NULL ? period : 0;
+    priv->last_report = uclock != NULL ? uclock_now(uclock) : 0;
+    priv->trace_sample = 0;
+    priv->trace_countdown = 0;
+    priv->stats.urefs = 0;
+    priv->stats.bytes = 0;
+    priv->stats.input_time = 0;
+    priv->stats.max_input_time = 0;
+    priv->stats.queue = 0;
+    priv->stats.max_queue = 0;
+    priv->stats.errors = 0;
+    priv->stats.jitter = 0;
+    priv->stats.max_jitter = 0;
+    priv->stats.start = priv->last_report;
+    priv->stats.last = priv->last_report;
+    memset(priv->stats.latency, 0, sizeof(priv->stats.latency));
+    priv->stats.traced = 0;
+    priv->stats.trace_time = 0;
+    priv->stats.max_trace = 0;
+    memset(priv->stats.trace, 0, sizeof(priv->stats.trace));
+    priv->stats.held_bytes = 0;
+    priv->stats.max_held_bytes = 0;
+    priv->stats.memory_cap = 0;
+    upipe->stats = upipe_stats_priv_to_upipe_stats(priv);
+    return UBASE_ERR_NONE;
+}
+
+/** @This disables instrumentation of a pipe and releases the counters.
+ *
+ * @param upipe description structure of the pipe
+ */
+void upipe_stats_disable(struct upipe *upipe)
+{
+    if (upipe->stats == NULL)
+        return;
+
+    struct upipe_stats_priv *priv =
+        upipe_stats_priv_from_upipe_stats(upipe->stats);
+    upipe->stats = NULL;
+    uclock_release(priv->uclock);
+    free(priv);
+}
+
+/** @This configures latency tracing on an instrumented pipe, which must have
+ * been given a uclock.
+ *
+ * @param upipe description structure of the pipe
+ * @param sample sampling period of the stamped urefs, or 0 to only measure
+ * urefs stamped upstream
+ * @return an error code
+ */
+int upipe_stats_set_trace(struct upipe *upipe, unsigned int sample)
+{
+    if (upipe->stats == NULL)
+        return UBASE_ERR_INVALID;
+    struct upipe_stats_priv *priv =
+        upipe_stats_priv_from_upipe_stats(upipe->stats);
+    if (priv->uclock == NULL)
+        return UBASE_ERR_INVALID;
+    priv->trace_sample = sample;
+    priv->trace_countdown = 0;
+    return UBASE_ERR_NONE;
+}
+
+/** @This sets the memory cap of an instrumented pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param cap maximum number of octets held, or 0 to disable the event
+ * @return an error code
+ */
+int upipe_stats_set_memory_cap(struct upipe *upipe, uint64_t cap)
+{
+    if (upipe->stats == NULL)
+        return UBASE_ERR_INVALID;
+    upipe->stats->memory_cap = cap;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the size of the payload of a buffer.
+ *
+ * @param ubuf pointer to buffer
+ * @return size in octets, or 0 for unknown buffer types
+ */
+static uint64_t upipe_stats_ubuf_size(struct ubuf *ubuf)
+{
+    size_t size;
+    if (ubase_check(ubuf_block_size(ubuf, &size)))
+        return size;
+
+    uint64_t total = 0;
+    size_t hsize, vsize;
+    uint8_t sample_size;
+    const char *plane = NULL;
+    if (ubase_check(ubuf_pic_size(ubuf, &hsize, &vsize, NULL))) {
+        while (ubase_check(ubuf_pic_plane_iterate(ubuf, &plane)) &&
+               plane != NULL) {
+            size_t stride;
+            uint8_t vsub;
+            if (ubase_check(ubuf_pic_plane_size(ubuf, plane, &stride, NULL,
+                                                &vsub, NULL)) && vsub)
+                total += (uint64_t)stride * (vsize / vsub);
+        }
+    } else if (ubase_check(ubuf_sound_size(ubuf, &size, &sample_size))) {
+        while (ubase_check(ubuf_sound_plane_iterate(ubuf, &plane)) &&
+               plane != NULL)
+            total += (uint64_t)size * sample_size;
+    }
+    return total;
+}
+
+/** @internal @This accounts the buffers of a uref taken or given back by an
+ * instrumented pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref taken or given back
+ * @param hold true if the uref is taken
+ */
+void upipe_stats_account(struct upipe *upipe, struct uref *uref, bool hold)
+{
+    struct upipe_stats *stats = upipe->stats;
+    if (uref->ubuf == NULL)
+        return;
+    uint64_t size = upipe_stats_ubuf_size(uref->ubuf);
+    uint64_t cap = stats->memory_cap;
+    bool over = cap && stats->held_bytes > cap;
+
+    if (!hold) {
+        /* the buffer may have been resized while held */
+        stats->held_bytes -= size < stats->held_bytes ?
+                             size : stats->held_bytes;
+        return;
+    }
+
+    stats->held_bytes += size;
+    if (stats->held_bytes > stats->max_held_bytes)
+        stats->max_held_bytes = stats->held_bytes;
+    if (cap && !over && stats->held_bytes > cap)
+        upipe_throw(upipe, UPROBE_MEMORY_CAP, stats->held_bytes);
+}
+
+/** @internal @This stamps or measures the ingress date of a uref entering an
+ * instrumented pipe.
+ *
+ * @param priv private context of the instrumentation
+ * @param uref uref entering the pipe
+ * @param now current date
+ */
+static void upipe_stats_trace(struct upipe_stats_priv *priv,
+                              struct uref *uref, uint64_t now)
+{
+    uint64_t ingress;
+    if (!ubase_check(uref_trace_get_ingress(uref, &ingress))) {
+        if (!priv->trace_sample || priv->trace_countdown--)
+            return;
+        priv->trace_countdown = priv->trace_sample - 1;
+        if (!ubase_check(uref_clock_get_cr_sys(uref, &ingress)) ||
+            ingress > now)
+            ingress = now;
+        uref_trace_set_ingress(uref, ingress);
+    }
+
+    uint64_t latency = now > ingress ? now - ingress : 0;
+    priv->stats.traced++;
+    priv->stats.trace_time += latency;
+    if (latency > priv->stats.max_trace)
+        priv->stats.max_trace = latency;
+    priv->stats.trace[upipe_stats_trace_bucket(latency)]++;
+}
+
+/** @internal @This sends a uref to an instrumented pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure to send
+ * @param upump_p reference to pump that generated the buffer
+ */
+void upipe_stats_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    struct upipe_stats_priv *priv =
+        upipe_stats_priv_from_upipe_stats(upipe->stats);
+    size_t size;
+    priv->stats.urefs++;
+    if (uref->ubuf != NULL && ubase_check(uref_block_size(uref, &size)))
+        priv->stats.bytes += size;
+
+    if (priv->uclock == NULL) {
+        upipe->mgr->upipe_input(upipe, uref, upump_p);
+        return;
+    }
+
+    struct uclock *uclock = uclock_use(priv->uclock);
+    uint64_t start = uclock_now(uclock);
+    upipe_stats_trace(priv, uref, start);
+    upipe->mgr->upipe_input(upipe, uref, upump_p);
+    uint64_t now = uclock_now(uclock);
+    uclock_release(uclock);
+
+    /* the pipe may have changed its instrumentation */
+    if (unlikely(upipe->stats == NULL ||
+                 upipe_stats_priv_from_upipe_stats(upipe->stats) != priv))
+        return;
+
+    uint64_t duration = now - start;
+    priv->stats.input_time += duration;
+    if (duration > priv->stats.max_input_time)
+        priv->stats.max_input_time = duration;
+    unsigned int bucket = 0;
+    while (bucket < UPIPE_STATS_LATENCY_BUCKETS - 1 &&
+           duration >= UINT64_C(2) << bucket)
+        bucket++;
+    priv->stats.latency[bucket]++;
+    priv->stats.last = now;
+
+    if (priv->period && now - priv->last_report >= priv->period) {
+        priv->last_report = now;
+        upipe_throw(upipe, UPROBE_STATS, &priv->stats);
+    }
+}
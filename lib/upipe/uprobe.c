@@ -27,6 +27,9 @@
 
 #include <upipe/uprobe.h>
 
+volatile uint32_t uprobe_log_generation = 0;
+volatile uint32_t uprobe_event_generation = 0;
+
 /** @internal @This is the private structure for a simple allocated probe. */
 struct uprobe_alloc {
     /** refcount structure */
@@ -33,6 +33,12 @@
  * -desperate, -standard, 0, +standard, and +desperate.
  * The desperate modes are not compliant with ISO MPEG, but we have to use them
  * in desperate situations.
+ *
+ * Alternatively, when a loop bandwidth is set, a second-order
+ * proportional-integral loop in fixed point tracks the phase and the drift
+ * of the stream clock. Its gains follow a least-squares fit during the first
+ * references, so that it locks within a few PCRs, and discontinuities
+ * only reset the phase.
  */
 
 #include <upipe/ubase.h>
@@ -74,6 +80,140 @@
 #define PLL_DESPERATE (UCLOCK_FREQ / 1000)
 /** debug print periodicity */
 #define PRINT_PERIODICITY (60 * UCLOCK_FREQ)
+/** max loop bandwidth of the PI controller (1 Hz) */
+#define PLL_MAX_BANDWIDTH 1000
+/** 2 pi, in 2^-16 */
+#define PLL_2PI UINT64_C(411775)
+/** twice the damping factor of the loop (1/sqrt(2)), in 2^-16 */
+#define PLL_2ZETA UINT64_C(92682)
+/** max number of references of the initial least-squares fit */
+#define PLL_LOCK_COUNT 4096
+/** max interval between references taken into account for the gains */
+#define PLL_MAX_INTERVAL UCLOCK_FREQ
+/** max drift of the PI controller (1000 ppm), in 2^-32 */
+#define PLL_MAX_DRIFT (INT64_C(4294967296) / 1000)
+/** deviation divider of the PI controller */
+#define PLL_DEVIATION_DIVIDER 64
+
+/** @internal @This returns the gain of a least-squares fit, or of the loop
+ * in steady state if it is higher.
+ *
+ * @param count number of references of the fit
+ * @param num numerator of the gain for count references
+ * @param steady gain of the loop in steady state, in 2^-16
+ * @return the gain, in 2^-16
+ */
+static inline uint64_t uprobe_dejitter_pll_gain(unsigned int count,
+                                                uint64_t num, uint64_t steady)
+{
+    uint64_t gain = steady;
+    if (count <= PLL_LOCK_COUNT) {
+        uint64_t fit = (num << 16) / ((uint64_t)count * (count + 1));
+        if (fit > gain)
+            gain = fit;
+    }
+    return gain > (UINT64_C(1) << 16) ? UINT64_C(1) << 16 : gain;
+}
+
+/** @internal @This updates the PI controller with a new clock reference.
+ *
+ * @param uprobe pointer to probe
+ * @param upipe pointer to pipe throwing the event
+ * @param cr_prog reference in the stream clock
+ * @param cr_sys reception date of the reference
+ * @param discontinuity true if the stream clock is discontinuous
+ */
+static void uprobe_dejitter_pll(struct uprobe *uprobe, struct upipe *upipe,
+                                uint64_t cr_prog, uint64_t cr_sys,
+                                int discontinuity)
+{
+    struct uprobe_dejitter *uprobe_dejitter =
+        uprobe_dejitter_from_uprobe(uprobe);
+    struct uprobe_dejitter *master = uprobe_dejitter->pll_master != NULL ?
+        uprobe_dejitter_from_uprobe(uprobe_dejitter->pll_master) : NULL;
+    if (master != NULL && !master->bandwidth)
+        master = NULL;
+    if (master != NULL)
+        uprobe_dejitter->pll_drift = master->pll_drift;
+
+    int64_t interval = cr_prog - uprobe_dejitter->last_cr_prog;
+    int64_t error = 0;
+    if (unlikely(discontinuity || interval <= 0)) {
+        if (uprobe_dejitter->pll_phase_count)
+            upipe_warn(upipe, "[dejitter] discontinuity");
+        discontinuity = 1;
+    } else if (uprobe_dejitter->pll_phase_count) {
+        int64_t predicted = uprobe_dejitter->last_cr_sys + interval +
+            interval * uprobe_dejitter->pll_drift / (INT64_C(1) << 32);
+        error = (int64_t)cr_sys - predicted;
+        uint64_t abs_error = error < 0 ? -error : error;
+        if (unlikely(abs_error >
+                     MAX_JITTER + 3 * uprobe_dejitter->pll_deviation)) {
+            upipe_warn_va(upipe, "[dejitter] max jitter reached (%"PRId64
+                          " ms)", error * 1000 / UCLOCK_FREQ);
+            discontinuity = 1;
+        }
+    }
+
+    if (!uprobe_dejitter->pll_phase_count || discontinuity) {
+        /* anchor the phase, but keep the drift and the deviation */
+        uprobe_dejitter->last_cr_prog = cr_prog;
+        uprobe_dejitter->last_cr_sys = cr_sys;
+        uprobe_dejitter->pll_phase_count = 1;
+    } else {
+        uint64_t steady = (interval > PLL_MAX_INTERVAL ?
+                           PLL_MAX_INTERVAL : interval) *
+                          uprobe_dejitter->pll_pulsation >> 24;
+        if (uprobe_dejitter->pll_phase_count <= PLL_LOCK_COUNT)
+            uprobe_dejitter->pll_phase_count++;
+        uint64_t alpha = uprobe_dejitter_pll_gain(
+                uprobe_dejitter->pll_phase_count,
+                2 * (2 * uprobe_dejitter->pll_phase_count - 1),
+                steady * PLL_2ZETA >> 16);
+
+        uprobe_dejitter->last_cr_sys = cr_sys - error +
+                                       (int64_t)alpha * error / 65536;
+        uprobe_dejitter->last_cr_prog = cr_prog;
+
+        if (master == NULL) {
+            if (uprobe_dejitter->pll_drift_count <= PLL_LOCK_COUNT)
+                uprobe_dejitter->pll_drift_count++;
+            uint64_t beta = uprobe_dejitter_pll_gain(
+                    uprobe_dejitter->pll_drift_count + 1, 6,
+                    steady * steady >> 16);
+            int64_t drift = uprobe_dejitter->pll_drift +
+                (int64_t)beta * error * 65536 / interval;
+            if (drift > PLL_MAX_DRIFT)
+                drift = PLL_MAX_DRIFT;
+            else if (drift < -PLL_MAX_DRIFT)
+                drift = -PLL_MAX_DRIFT;
+            uprobe_dejitter->pll_drift = drift;
+        }
+
+        uint64_t abs_error = error < 0 ? -error : error;
+        uprobe_dejitter->pll_deviation =
+            (int64_t)uprobe_dejitter->pll_deviation +
+            ((int64_t)abs_error - (int64_t)uprobe_dejitter->pll_deviation) /
+            PLL_DEVIATION_DIVIDER;
+    }
+
+    uprobe_dejitter->drift_rate.num = UCLOCK_FREQ +
+        (int64_t)UCLOCK_FREQ * uprobe_dejitter->pll_drift /
+        (INT64_C(1) << 32);
+    uprobe_dejitter->drift_rate.den = UCLOCK_FREQ;
+    urational_simplify(&uprobe_dejitter->drift_rate);
+
+    if (cr_sys > uprobe_dejitter->last_print + PRINT_PERIODICITY) {
+        upipe_dbg_va(upipe,
+                "dejitter drift %"PRId64" ppb error %"PRId64" deviation %"PRIu64,
+                uprobe_dejitter->pll_drift * 1000000000 / (INT64_C(1) << 32),
+                error, uprobe_dejitter->pll_deviation);
+        uprobe_dejitter->last_print = cr_sys;
+    }
+
+    upipe_verbose_va(upipe, "new ref error %"PRId64" deviation %"PRIu64,
+                     error, uprobe_dejitter->pll_deviation);
+}
 
 /** @internal @This catches clock_ref events thrown by pipes.
  *
@@ -99,6 +239,11 @@ static int uprobe_dejitter_clock_ref(struct uprobe *uprobe, struct upipe *upipe,
         return UBASE_ERR_INVALID;
     }
 
+    if (uprobe_dejitter->bandwidth) {
+        uprobe_dejitter_pll(uprobe, upipe, cr_prog, cr_sys, discontinuity);
+        return UBASE_ERR_NONE;
+    }
+
     double offset = (double)((int64_t)cr_sys - (int64_t)cr_prog);
     if (unlikely(discontinuity))
         upipe_warn(upipe, "[dejitter] discontinuity");
@@ -219,8 +364,10 @@ static int uprobe_dejitter_clock_ts(struct uprobe *uprobe, struct upipe *upipe,
     struct uprobe_dejitter *uprobe_dejitter =
         uprobe_dejitter_from_uprobe(uprobe);
     struct uref *uref = va_arg(args, struct uref *);
-    if (unlikely(uref == NULL || !uprobe_dejitter->offset_count ||
-                 !uprobe_dejitter->drift_rate.den))
+    if (unlikely(uref == NULL || !uprobe_dejitter->drift_rate.den ||
+                 !(uprobe_dejitter->bandwidth ?
+                   uprobe_dejitter->pll_phase_count :
+                   uprobe_dejitter->offset_count)))
         return UBASE_ERR_INVALID;
 
     uint64_t date;
@@ -229,6 +376,16 @@ static int uprobe_dejitter_clock_ts(struct uprobe *uprobe, struct upipe *upipe,
     if (type == UREF_DATE_NONE)
         return UBASE_ERR_INVALID;
 
+    if (uprobe_dejitter->bandwidth) {
+        int64_t interval = date - uprobe_dejitter->last_cr_prog;
+        uint64_t date_sys = uprobe_dejitter->last_cr_sys + interval +
+            interval * uprobe_dejitter->pll_drift / (INT64_C(1) << 32) +
+            3 * uprobe_dejitter->pll_deviation;
+        uref_clock_set_date_sys(uref, date_sys, type);
+        uref_clock_set_rate(uref, uprobe_dejitter->drift_rate);
+        return UBASE_ERR_NONE;
+    }
+
     uint64_t date_sys = (int64_t)uprobe_dejitter->last_cr_sys +
         ((int64_t)date - (int64_t)uprobe_dejitter->last_cr_prog) *
         uprobe_dejitter->drift_rate.num /
@@ -286,6 +443,50 @@ void uprobe_dejitter_set(struct uprobe *uprobe, bool enabled,
         uprobe_dejitter->deviation = deviation;
     else
         uprobe_dejitter->deviation = DEFAULT_INITIAL_DEVIATION;
+    uprobe_dejitter->pll_phase_count = 0;
+    uprobe_dejitter->pll_drift_count = 0;
+    uprobe_dejitter->pll_drift = 0;
+    uprobe_dejitter->pll_deviation = uprobe_dejitter->deviation;
+}
+
+/** @This switches the dejittering to a proportional-integral clock
+ * recovery with the given loop bandwidth. The first references are
+ * locked on quickly, and discontinuities only reset the phase, keeping the
+ * drift estimation. A bandwidth of 0 restores the stepping PLL.
+ *
+ * @param uprobe pointer to probe
+ * @param bandwidth loop bandwidth in millihertz, or 0
+ */
+void uprobe_dejitter_set_bandwidth(struct uprobe *uprobe,
+                                   unsigned int bandwidth)
+{
+    struct uprobe_dejitter *uprobe_dejitter =
+        uprobe_dejitter_from_uprobe(uprobe);
+    if (bandwidth > PLL_MAX_BANDWIDTH)
+        bandwidth = PLL_MAX_BANDWIDTH;
+    uprobe_dejitter->bandwidth = bandwidth;
+    uprobe_dejitter->pll_pulsation = (PLL_2PI * bandwidth << 24) /
+                                     (UINT64_C(1000) * UCLOCK_FREQ);
+    uprobe_dejitter->offset_count = 0;
+    uprobe_dejitter->pll_phase_count = 0;
+    uprobe_dejitter->drift_rate.num = uprobe_dejitter->drift_rate.den = 1;
+}
+
+/** @This makes a probe use the drift estimated by another uprobe_dejitter,
+ * typically for the programs of a multiplex sharing the clock of the same
+ * source. Only the phase is then recovered locally.
+ *
+ * @param uprobe pointer to probe
+ * @param master pointer to the uprobe_dejitter estimating the drift, or NULL
+ */
+void uprobe_dejitter_set_master(struct uprobe *uprobe, struct uprobe *master)
+{
+    struct uprobe_dejitter *uprobe_dejitter =
+        uprobe_dejitter_from_uprobe(uprobe);
+    if (master == uprobe)
+        master = NULL;
+    uprobe_release(uprobe_dejitter->pll_master);
+    uprobe_dejitter->pll_master = uprobe_use(master);
 }
 
 /** @This initializes an already allocated uprobe_dejitter structure.
@@ -304,8 +505,14 @@ struct uprobe *uprobe_dejitter_init(struct uprobe_dejitter *uprobe_dejitter,
     struct uprobe *uprobe = uprobe_dejitter_to_uprobe(uprobe_dejitter);
     uprobe_dejitter->drift_rate.num = uprobe_dejitter->drift_rate.den = 1;
     uprobe_dejitter->last_print = 0;
+    uprobe_dejitter->bandwidth = 0;
+    uprobe_dejitter->pll_pulsation = 0;
+    uprobe_dejitter->pll_master = NULL;
     uprobe_dejitter_set(uprobe, enabled, deviation);
     uprobe_init(uprobe, uprobe_dejitter_throw, next);
+    uprobe->log_forward = true;
+    uprobe->events = UPROBE_EVENT_BIT(UPROBE_CLOCK_REF) |
+                     UPROBE_EVENT_BIT(UPROBE_CLOCK_TS);
     return uprobe;
 }
 
@@ -317,6 +524,7 @@ void uprobe_dejitter_clean(struct uprobe_dejitter *uprobe_dejitter)
 {
     assert(uprobe_dejitter != NULL);
     struct uprobe *uprobe = uprobe_dejitter_to_uprobe(uprobe_dejitter);
+    uprobe_release(uprobe_dejitter->pll_master);
     uprobe_clean(uprobe);
 }
 
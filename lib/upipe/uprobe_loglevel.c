@@ -79,6 +79,9 @@ struct uprobe *uprobe_loglevel_init(struct uprobe_loglevel *uprobe_loglevel,
     assert(uprobe_loglevel);
     struct uprobe *uprobe = uprobe_loglevel_to_uprobe(uprobe_loglevel);
     uprobe_init(uprobe, uprobe_loglevel_throw, next);
+    uprobe->log_level = min_level;
+    uprobe->log_forward = true;
+    uprobe->events = UPROBE_EVENT_BIT(UPROBE_LOG);
     ulist_init(&uprobe_loglevel->patterns);
     uprobe_loglevel->min_level = min_level;
     return uprobe;
@@ -115,6 +118,8 @@ int uprobe_loglevel_set(struct uprobe *uprobe,
     }
     pattern->log_level = log_level;
     ulist_add(&uprobe_loglevel->patterns, pattern_to_uchain(pattern));
+    if (log_level < uprobe->log_level)
+        uprobe_set_log_filter(uprobe, log_level, true);
 
     return UBASE_ERR_NONE;
 }
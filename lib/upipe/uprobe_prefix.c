@@ -91,6 +91,9 @@ struct uprobe *uprobe_pfx_init(struct uprobe_pfx *uprobe_pfx,
         uprobe_pfx->name = NULL;
     uprobe_pfx->min_level = min_level;
     uprobe_init(uprobe, uprobe_pfx_throw, next);
+    uprobe->log_level = min_level;
+    uprobe->log_forward = true;
+    uprobe->events = UPROBE_EVENT_BIT(UPROBE_LOG);
     return uprobe;
 }
 
@@ -67,6 +67,8 @@ uprobe_source_mgr_init(struct uprobe_source_mgr *uprobe_source_mgr,
 {
     struct uprobe *uprobe = uprobe_source_mgr_to_uprobe(uprobe_source_mgr);
     uprobe_init(uprobe, catch_source_mgr, next);
+    uprobe->log_forward = true;
+    uprobe->events = UPROBE_EVENT_BIT(UPROBE_NEED_SOURCE_MGR);
     uprobe_source_mgr->source_mgr = upipe_mgr_use(source_mgr);
     return uprobe;
 }
@@ -209,6 +209,8 @@ struct uprobe *uprobe_stdio_init(struct uprobe_stdio *uprobe_stdio,
     uprobe_stdio->min_level = min_level;
     uprobe_stdio->colored = isatty(fileno(stream));
     uprobe_init(uprobe, uprobe_stdio_throw, next);
+    uprobe->log_level = min_level;
+    uprobe->events = UPROBE_EVENT_BIT(UPROBE_LOG);
     return uprobe;
 }
 
@@ -130,6 +130,8 @@ struct uprobe *uprobe_syslog_init(struct uprobe_syslog *uprobe_syslog,
         openlog(uprobe_syslog->ident, option, facility);
 
     uprobe_init(uprobe, uprobe_syslog_throw, next);
+    uprobe->log_level = min_level;
+    uprobe->events = UPROBE_EVENT_BIT(UPROBE_LOG);
     return uprobe;
 }
 
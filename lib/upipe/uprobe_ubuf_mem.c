@@ -28,9 +28,14 @@
  */
 
 #include <upipe/ubase.h>
+#include <upipe/ulist.h>
 #include <upipe/umem.h>
 #include <upipe/ubuf.h>
 #include <upipe/ubuf_mem.h>
+#include <upipe/ubuf_pic_mem.h>
+#include <upipe/udict.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_pic_flow.h>
 #include <upipe/uprobe.h>
 #include <upipe/uprobe_ubuf_mem.h>
 #include <upipe/uprobe_helper_alloc.h>
@@ -40,6 +45,97 @@
 #include <string.h>
 #include <stdarg.h>
 
+/** @internal @This is a cached ubuf manager. */
+struct uprobe_ubuf_mem_entry {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** amended flow format the manager was allocated for */
+    struct uref *flow_format;
+    /** pointer to the ubuf manager */
+    struct ubuf_mgr *ubuf_mgr;
+};
+
+UBASE_FROM_TO(uprobe_ubuf_mem_entry, uchain, uchain, uchain)
+
+/** @internal @This frees a cache entry.
+ *
+ * @param entry cache entry
+ */
+static void uprobe_ubuf_mem_entry_free(struct uprobe_ubuf_mem_entry *entry)
+{
+    ulist_delete(&entry->uchain);
+    uref_free(entry->flow_format);
+    ubuf_mgr_release(entry->ubuf_mgr);
+    free(entry);
+}
+
+/** @internal @This drops the least recently used managers of the cache
+ * until it holds at most the given number of entries.
+ *
+ * @param uprobe_ubuf_mem pointer to the probe
+ * @param size maximum number of entries to keep
+ */
+static void uprobe_ubuf_mem_trim(struct uprobe_ubuf_mem *uprobe_ubuf_mem,
+                                 unsigned int size)
+{
+    while (uprobe_ubuf_mem->cache_size > size) {
+        struct uchain *uchain = uprobe_ubuf_mem->cache.prev;
+        uprobe_ubuf_mem_entry_free(uprobe_ubuf_mem_entry_from_uchain(uchain));
+        uprobe_ubuf_mem->cache_size--;
+    }
+}
+
+/** @internal @This looks up the cache for a flow format.
+ *
+ * @param uprobe_ubuf_mem pointer to the probe
+ * @param flow_format amended flow format
+ * @return pointer to the manager (belongs to the cache), or NULL
+ */
+static struct ubuf_mgr *
+    uprobe_ubuf_mem_lookup(struct uprobe_ubuf_mem *uprobe_ubuf_mem,
+                           struct uref *flow_format)
+{
+    struct uchain *uchain;
+    ulist_foreach (&uprobe_ubuf_mem->cache, uchain) {
+        struct uprobe_ubuf_mem_entry *entry =
+            uprobe_ubuf_mem_entry_from_uchain(uchain);
+        if (entry->flow_format->udict == flow_format->udict ||
+            (entry->flow_format->udict != NULL && flow_format->udict != NULL &&
+             !udict_cmp(entry->flow_format->udict, flow_format->udict))) {
+            /* move to the head of the list */
+            ulist_delete(uchain);
+            ulist_unshift(&uprobe_ubuf_mem->cache, uchain);
+            return entry->ubuf_mgr;
+        }
+    }
+    return NULL;
+}
+
+/** @internal @This adds a manager to the cache.
+ *
+ * @param uprobe_ubuf_mem pointer to the probe
+ * @param flow_format amended flow format
+ * @param ubuf_mgr pointer to the manager
+ */
+static void uprobe_ubuf_mem_insert(struct uprobe_ubuf_mem *uprobe_ubuf_mem,
+                                   struct uref *flow_format,
+                                   struct ubuf_mgr *ubuf_mgr)
+{
+    struct uprobe_ubuf_mem_entry *entry =
+        malloc(sizeof(struct uprobe_ubuf_mem_entry));
+    if (unlikely(entry == NULL))
+        return;
+    entry->flow_format = uref_dup(flow_format);
+    if (unlikely(entry->flow_format == NULL)) {
+        free(entry);
+        return;
+    }
+    entry->ubuf_mgr = ubuf_mgr_use(ubuf_mgr);
+    ulist_unshift(&uprobe_ubuf_mem->cache, &entry->uchain);
+    uprobe_ubuf_mem->cache_size++;
+    uprobe_ubuf_mem_trim(uprobe_ubuf_mem, uprobe_ubuf_mem->cache_depth);
+}
+
 /** @internal @This catches events thrown by pipes.
  *
  * @param uprobe pointer to probe
@@ -76,6 +172,24 @@ static int uprobe_ubuf_mem_throw(struct uprobe *uprobe, struct upipe *upipe,
     if (urequest->type == UREQUEST_FLOW_FORMAT)
         return urequest_provide_flow_format(urequest, uref);
 
+    const char *def;
+    bool pic = ubase_check(uref_flow_get_def(uref, &def)) &&
+               !ubase_ncmp(def, "pic.");
+    if (pic) {
+        uref_pic_flow_require_align(uref, uprobe_ubuf_mem->pic_align);
+        uref_pic_flow_require_padding(uref,
+                uprobe_ubuf_mem->pic_hmpadding, uprobe_ubuf_mem->pic_hmpadding,
+                uprobe_ubuf_mem->pic_vpadding, uprobe_ubuf_mem->pic_vpadding);
+    }
+
+    if (uprobe_ubuf_mem->cache_depth) {
+        struct ubuf_mgr *ubuf_mgr =
+            uprobe_ubuf_mem_lookup(uprobe_ubuf_mem, uref);
+        if (ubuf_mgr != NULL)
+            return urequest_provide_ubuf_mgr(urequest, ubuf_mgr_use(ubuf_mgr),
+                                             uref);
+    }
+
     struct ubuf_mgr *ubuf_mgr =
         ubuf_mem_mgr_alloc_from_flow_def(uprobe_ubuf_mem->ubuf_pool_depth,
                                          uprobe_ubuf_mem->shared_pool_depth,
@@ -84,7 +198,13 @@ static int uprobe_ubuf_mem_throw(struct uprobe *uprobe, struct upipe *upipe,
         uref_free(uref);
         return uprobe_throw_next(uprobe, upipe, event, args);
     }
+    if (pic && uprobe_ubuf_mem->pic_frame_pool_depth &&
+        !ubase_check(ubuf_pic_mem_mgr_set_frame_pool(ubuf_mgr,
+                        uprobe_ubuf_mem->pic_frame_pool_depth)))
+        upipe_warn(upipe, "unable to enable the frame pool");
 
+    if (uprobe_ubuf_mem->cache_depth)
+        uprobe_ubuf_mem_insert(uprobe_ubuf_mem, uref, ubuf_mgr);
     return urequest_provide_ubuf_mgr(urequest, ubuf_mgr, uref);
 }
 
@@ -108,7 +228,15 @@ struct uprobe *uprobe_ubuf_mem_init(struct uprobe_ubuf_mem *uprobe_ubuf_mem,
     uprobe_ubuf_mem->umem_mgr = umem_mgr_use(umem_mgr);
     uprobe_ubuf_mem->ubuf_pool_depth = ubuf_pool_depth;
     uprobe_ubuf_mem->shared_pool_depth = shared_pool_depth;
+    uprobe_ubuf_mem->pic_align = 0;
+    uprobe_ubuf_mem->pic_hmpadding = uprobe_ubuf_mem->pic_vpadding = 0;
+    uprobe_ubuf_mem->pic_frame_pool_depth = 0;
+    ulist_init(&uprobe_ubuf_mem->cache);
+    uprobe_ubuf_mem->cache_size = 0;
+    uprobe_ubuf_mem->cache_depth = 0;
     uprobe_init(uprobe, uprobe_ubuf_mem_throw, next);
+    uprobe->log_forward = true;
+    uprobe->events = UPROBE_EVENT_BIT(UPROBE_PROVIDE_REQUEST);
     return uprobe;
 }
 
@@ -120,6 +248,7 @@ void uprobe_ubuf_mem_clean(struct uprobe_ubuf_mem *uprobe_ubuf_mem)
 {
     assert(uprobe_ubuf_mem != NULL);
     struct uprobe *uprobe = uprobe_ubuf_mem_to_uprobe(uprobe_ubuf_mem);
+    uprobe_ubuf_mem_trim(uprobe_ubuf_mem, 0);
     umem_mgr_release(uprobe_ubuf_mem->umem_mgr);
     uprobe_clean(uprobe);
 }
@@ -139,6 +268,59 @@ void uprobe_ubuf_mem_set(struct uprobe *uprobe, struct umem_mgr *umem_mgr)
 {
     struct uprobe_ubuf_mem *uprobe_ubuf_mem =
         uprobe_ubuf_mem_from_uprobe(uprobe);
+    uprobe_ubuf_mem_trim(uprobe_ubuf_mem, 0);
     umem_mgr_release(uprobe_ubuf_mem->umem_mgr);
     uprobe_ubuf_mem->umem_mgr = umem_mgr_use(umem_mgr);
 }
+
+/** @This sets the minimum alignment and padding of the picture managers
+ * allocated by this probe.
+ *
+ * @param uprobe pointer to probe
+ * @param align minimum alignment of lines in octets, or 0
+ * @param hmpadding minimum number of extra macropixels before and after
+ * each line
+ * @param vpadding minimum number of extra lines before and after each
+ * picture
+ */
+void uprobe_ubuf_mem_set_pic_align(struct uprobe *uprobe, uint64_t align,
+                                   uint8_t hmpadding, uint8_t vpadding)
+{
+    struct uprobe_ubuf_mem *uprobe_ubuf_mem =
+        uprobe_ubuf_mem_from_uprobe(uprobe);
+    uprobe_ubuf_mem->pic_align = align;
+    uprobe_ubuf_mem->pic_hmpadding = hmpadding;
+    uprobe_ubuf_mem->pic_vpadding = vpadding;
+}
+
+/** @This enables an exact-size frame pool in the picture managers allocated
+ * by this probe.
+ *
+ * @param uprobe pointer to probe
+ * @param depth maximum number of frames kept by each manager, or 0 to
+ * disable
+ */
+void uprobe_ubuf_mem_set_pic_frame_pool(struct uprobe *uprobe,
+                                        uint16_t depth)
+{
+    struct uprobe_ubuf_mem *uprobe_ubuf_mem =
+        uprobe_ubuf_mem_from_uprobe(uprobe);
+    uprobe_ubuf_mem->pic_frame_pool_depth = depth;
+    /* cached managers were allocated with the previous frame pool */
+    uprobe_ubuf_mem_trim(uprobe_ubuf_mem, 0);
+}
+
+/** @This enables a cache of the managers allocated by this probe, keyed by
+ * the requested flow format.
+ *
+ * @param uprobe pointer to probe
+ * @param depth maximum number of managers kept in the cache, or 0 to
+ * disable
+ */
+void uprobe_ubuf_mem_set_cache(struct uprobe *uprobe, unsigned int depth)
+{
+    struct uprobe_ubuf_mem *uprobe_ubuf_mem =
+        uprobe_ubuf_mem_from_uprobe(uprobe);
+    uprobe_ubuf_mem->cache_depth = depth;
+    uprobe_ubuf_mem_trim(uprobe_ubuf_mem, depth);
+}
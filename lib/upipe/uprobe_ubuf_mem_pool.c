@@ -39,16 +39,36 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 /** @This is a manager registered into the probe as a thread-safe linked list.
  */
 struct uprobe_ubuf_mem_pool_element {
     /** pointer to ubuf manager */
     struct ubuf_mgr *ubuf_mgr;
+    /** NUMA node of the umem manager, or -1 for the default one */
+    int node;
     /** pointer to next element */
     uatomic_ptr_t next;
 };
 
+/** @internal @This returns the NUMA node of the calling thread.
+ *
+ * @return NUMA node, or -1 if unknown
+ */
+static int uprobe_ubuf_mem_pool_current_node(void)
+{
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned int cpu, node;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0)
+        return node;
+#endif
+    return -1;
+}
+
 /** @internal @This catches events thrown by pipes.
  *
  * @param uprobe pointer to probe
@@ -87,13 +107,22 @@ static int uprobe_ubuf_mem_pool_throw(struct uprobe *uprobe,
     if (urequest->type == UREQUEST_FLOW_FORMAT)
         return urequest_provide_flow_format(urequest, uref);
 
+    struct umem_mgr *umem_mgr = uprobe_ubuf_mem_pool->umem_mgr;
+    int node = uprobe_ubuf_mem_pool_current_node();
+    if (node >= 0 && node < UPROBE_UBUF_MEM_POOL_MAX_NODES &&
+        uprobe_ubuf_mem_pool->node_umem_mgrs[node] != NULL)
+        umem_mgr = uprobe_ubuf_mem_pool->node_umem_mgrs[node];
+    else
+        node = -1;
+
     uatomic_ptr_t *elem_p = &uprobe_ubuf_mem_pool->first;
     struct uprobe_ubuf_mem_pool_element *elem;
 
     for ( ; ; ) {
         while ((elem = uatomic_ptr_load_ptr(elem_p,
                             struct uprobe_ubuf_mem_pool_element *)) != NULL) {
-            if (ubase_check(ubuf_mgr_check(elem->ubuf_mgr, uref)))
+            if (elem->node == node &&
+                ubase_check(ubuf_mgr_check(elem->ubuf_mgr, uref)))
                 return urequest_provide_ubuf_mgr(urequest,
                             ubuf_mgr_use(elem->ubuf_mgr), uref);
             elem_p = &elem->next;
@@ -102,7 +131,7 @@ static int uprobe_ubuf_mem_pool_throw(struct uprobe *uprobe,
         struct ubuf_mgr *ubuf_mgr = ubuf_mem_mgr_alloc_from_flow_def(
                 uprobe_ubuf_mem_pool->ubuf_pool_depth,
                 uprobe_ubuf_mem_pool->shared_pool_depth,
-                uprobe_ubuf_mem_pool->umem_mgr, uref);
+                umem_mgr, uref);
         if (unlikely(ubuf_mgr == NULL)) {
             uref_free(uref);
             return uprobe_throw_next(uprobe, upipe, event, args);
@@ -114,6 +143,7 @@ static int uprobe_ubuf_mem_pool_throw(struct uprobe *uprobe,
             return urequest_provide_ubuf_mgr(urequest, ubuf_mgr, uref);
 
         new_elem->ubuf_mgr = ubuf_mgr;
+        new_elem->node = node;
         uatomic_ptr_init(&new_elem->next, NULL);
         if (likely(uatomic_ptr_compare_exchange_ptr(elem_p, &elem, new_elem)))
             return urequest_provide_ubuf_mgr(urequest, ubuf_mgr_use(ubuf_mgr),
@@ -144,10 +174,14 @@ struct uprobe *
     assert(uprobe_ubuf_mem_pool != NULL);
     struct uprobe *uprobe = uprobe_ubuf_mem_pool_to_uprobe(uprobe_ubuf_mem_pool);
     uprobe_ubuf_mem_pool->umem_mgr = umem_mgr_use(umem_mgr);
+    for (unsigned int i = 0; i < UPROBE_UBUF_MEM_POOL_MAX_NODES; i++)
+        uprobe_ubuf_mem_pool->node_umem_mgrs[i] = NULL;
     uprobe_ubuf_mem_pool->ubuf_pool_depth = ubuf_pool_depth;
     uprobe_ubuf_mem_pool->shared_pool_depth = shared_pool_depth;
     uatomic_ptr_init(&uprobe_ubuf_mem_pool->first, NULL);
     uprobe_init(uprobe, uprobe_ubuf_mem_pool_throw, next);
+    uprobe->log_forward = true;
+    uprobe->events = UPROBE_EVENT_BIT(UPROBE_PROVIDE_REQUEST);
     return uprobe;
 }
 
@@ -186,6 +220,8 @@ void uprobe_ubuf_mem_pool_clean(struct uprobe_ubuf_mem_pool *uprobe_ubuf_mem_poo
     uprobe_ubuf_mem_pool_vacuum(uprobe_ubuf_mem_pool);
     uatomic_ptr_clean(&uprobe_ubuf_mem_pool->first);
     umem_mgr_release(uprobe_ubuf_mem_pool->umem_mgr);
+    for (unsigned int i = 0; i < UPROBE_UBUF_MEM_POOL_MAX_NODES; i++)
+        umem_mgr_release(uprobe_ubuf_mem_pool->node_umem_mgrs[i]);
     struct uprobe *uprobe = uprobe_ubuf_mem_pool_to_uprobe(uprobe_ubuf_mem_pool);
     uprobe_clean(uprobe);
 }
@@ -208,3 +244,28 @@ void uprobe_ubuf_mem_pool_set(struct uprobe *uprobe, struct umem_mgr *umem_mgr)
     umem_mgr_release(uprobe_ubuf_mem_pool->umem_mgr);
     uprobe_ubuf_mem_pool->umem_mgr = umem_mgr_use(umem_mgr);
 }
+
+/** @This changes the umem_mgr used by this probe when the event is thrown
+ * from a thread running on the given NUMA node, so that pipes get node-local
+ * buffers. Threads on nodes without a dedicated manager (or when the node
+ * cannot be determined) use the default umem_mgr. Please note that this
+ * function is not thread-safe, and mustn't be used if the probe may be called
+ * from another thread.
+ *
+ * @param uprobe pointer to probe
+ * @param node NUMA node
+ * @param umem_mgr umem manager to use on this node, or NULL to revert to the
+ * default umem manager
+ * @return an error code
+ */
+int uprobe_ubuf_mem_pool_set_node(struct uprobe *uprobe, unsigned int node,
+                                  struct umem_mgr *umem_mgr)
+{
+    struct uprobe_ubuf_mem_pool *uprobe_ubuf_mem_pool =
+        uprobe_ubuf_mem_pool_from_uprobe(uprobe);
+    if (unlikely(node >= UPROBE_UBUF_MEM_POOL_MAX_NODES))
+        return UBASE_ERR_INVALID;
+    umem_mgr_release(uprobe_ubuf_mem_pool->node_umem_mgrs[node]);
+    uprobe_ubuf_mem_pool->node_umem_mgrs[node] = umem_mgr_use(umem_mgr);
+    return UBASE_ERR_NONE;
+}
@@ -29,6 +29,8 @@
 
 #include <upipe/ubase.h>
 #include <upipe/uclock.h>
+#include <upipe/uclock_virtual.h>
+#include <upipe/upump.h>
 #include <upipe/uprobe.h>
 #include <upipe/uprobe_uclock.h>
 #include <upipe/uprobe_helper_alloc.h>
@@ -80,6 +82,8 @@ struct uprobe *uprobe_uclock_init(struct uprobe_uclock *uprobe_uclock,
     struct uprobe *uprobe = uprobe_uclock_to_uprobe(uprobe_uclock);
     uprobe_uclock->uclock = uclock_use(uclock);
     uprobe_init(uprobe, uprobe_uclock_throw, next);
+    uprobe->log_forward = true;
+    uprobe->events = UPROBE_EVENT_BIT(UPROBE_PROVIDE_REQUEST);
     return uprobe;
 }
 
@@ -113,3 +117,29 @@ void uprobe_uclock_set(struct uprobe *uprobe, struct uclock *uclock)
     uclock_release(uprobe_uclock->uclock);
     uprobe_uclock->uclock = uclock_use(uclock);
 }
+
+/** @This allocates a new uprobe_uclock structure providing a virtual clock,
+ * which also drives the timers of the given event loop.
+ *
+ * @param next next probe to test if this one doesn't catch the event
+ * @param upump_mgr event loop running the pipes
+ * @param start initial date of the clock, in 27 MHz ticks
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_uclock_alloc_virtual(struct uprobe *next,
+                                           struct upump_mgr *upump_mgr,
+                                           uint64_t start)
+{
+    struct uclock *uclock = uclock_virtual_alloc(start);
+    if (unlikely(uclock == NULL ||
+                 !ubase_check(upump_mgr_set_virtual_clock(upump_mgr,
+                                                          uclock)))) {
+        uclock_release(uclock);
+        uprobe_release(next);
+        return NULL;
+    }
+
+    struct uprobe *uprobe = uprobe_uclock_alloc(next, uclock);
+    uclock_release(uclock);
+    return uprobe;
+}
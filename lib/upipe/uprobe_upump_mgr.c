@@ -88,6 +88,10 @@ struct uprobe *uprobe_upump_mgr_init(struct uprobe_upump_mgr *uprobe_upump_mgr,
     uprobe_upump_mgr->upump_mgr = upump_mgr_use(upump_mgr);
     uprobe_upump_mgr->frozen = false;
     uprobe_init(uprobe, uprobe_upump_mgr_throw, next);
+    uprobe->log_forward = true;
+    uprobe->events = UPROBE_EVENT_BIT(UPROBE_NEED_UPUMP_MGR) |
+        UPROBE_EVENT_BIT(UPROBE_FREEZE_UPUMP_MGR) |
+        UPROBE_EVENT_BIT(UPROBE_THAW_UPUMP_MGR);
     return uprobe;
 }
 
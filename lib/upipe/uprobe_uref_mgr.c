@@ -80,6 +80,8 @@ struct uprobe *uprobe_uref_mgr_init(struct uprobe_uref_mgr *uprobe_uref_mgr,
     struct uprobe *uprobe = uprobe_uref_mgr_to_uprobe(uprobe_uref_mgr);
     uprobe_uref_mgr->uref_mgr = uref_mgr_use(uref_mgr);
     uprobe_init(uprobe, uprobe_uref_mgr_throw, next);
+    uprobe->log_forward = true;
+    uprobe->events = UPROBE_EVENT_BIT(UPROBE_PROVIDE_REQUEST);
     return uprobe;
 }
 
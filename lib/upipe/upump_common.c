@@ -30,10 +30,15 @@
 #include <upipe/ubase.h>
 #include <upipe/ulist.h>
 #include <upipe/upool.h>
+#include <upipe/uclock.h>
+#include <upipe/uclock_std.h>
+#include <upipe/uclock_virtual.h>
 #include <upipe/upump_common.h>
 #include <upipe/upump_blocker.h>
+#include <upipe/utrace.h>
 
 #include <stdlib.h>
+#include <string.h>
 
 /** @This stores extra opaque structures for blockers.
  */
@@ -48,6 +53,321 @@ struct upump_blocker_common {
 UBASE_FROM_TO(upump_blocker_common, upump_blocker, upump_blocker, blocker)
 UBASE_FROM_TO(upump_blocker_common, uchain, uchain, uchain)
 
+/** @internal @This compares the virtual deadlines of two timers. Timers
+ * with the same deadline are kept in the order they were scheduled.
+ *
+ * @param uchain1 pointer to the timer being scheduled
+ * @param uchain2 pointer to a scheduled timer
+ * @return -1 if the first timer triggers before the second, 1 otherwise
+ */
+static int upump_common_virtual_cmp(struct uchain *uchain1,
+                                    struct uchain *uchain2)
+{
+    struct upump_common *common1 = upump_common_from_virtual_uchain(uchain1);
+    struct upump_common *common2 = upump_common_from_virtual_uchain(uchain2);
+    return common1->virtual_deadline < common2->virtual_deadline ? -1 : 1;
+}
+
+/** @internal @This schedules a timer on the virtual clock.
+ *
+ * @param upump description structure of the pump
+ * @param deadline date of the next trigger
+ */
+static void upump_common_virtual_schedule(struct upump *upump,
+                                          uint64_t deadline)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_mgr(upump->mgr);
+    common->virtual_deadline = deadline;
+    ulist_bubble_reverse(&common_mgr->virtual_timers, &common->virtual_uchain,
+                         upump_common_virtual_cmp);
+    if (common->status)
+        common_mgr->nb_virtual_active++;
+}
+
+/** @internal @This unschedules a timer from the virtual clock.
+ *
+ * @param upump description structure of the pump
+ */
+static void upump_common_virtual_unschedule(struct upump *upump)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_mgr(upump->mgr);
+    if (!ulist_is_in(&common->virtual_uchain))
+        return;
+    ulist_delete(&common->virtual_uchain);
+    if (common->status)
+        common_mgr->nb_virtual_active--;
+}
+
+/** @internal @This converts a duration to a number of ticks of the timer
+ * wheel, rounded up.
+ *
+ * @param duration duration in ticks of a 27 MHz clock
+ * @return number of ticks of the timer wheel, at least 1
+ */
+static inline uint64_t upump_common_wheel_ticks(uint64_t duration)
+{
+    uint64_t ticks = (duration + UPUMP_TIMER_COARSE_TICK - 1) /
+                     UPUMP_TIMER_COARSE_TICK;
+    return ticks ? ticks : 1;
+}
+
+/** @internal @This inserts a timer in the slot of the timer wheel matching
+ * its expiry. Timers expiring beyond the range of the wheel are parked in
+ * the farthest slot, and inserted again when it is cascaded.
+ *
+ * @param common_mgr pointer to a upump_common_mgr structure
+ * @param common pointer to the timer
+ */
+static void upump_common_wheel_insert(struct upump_common_mgr *common_mgr,
+                                      struct upump_common *common)
+{
+    uint64_t expiry = common->wheel_expiry;
+    if (expiry < common_mgr->wheel_next)
+        expiry = common_mgr->wheel_next;
+    uint64_t delta = expiry - common_mgr->wheel_next;
+    unsigned int level = 0;
+    while (level < UPUMP_COMMON_WHEEL_LEVELS - 1 &&
+           delta >= UINT64_C(1) << (UPUMP_COMMON_WHEEL_BITS * (level + 1)))
+        level++;
+    uint64_t range = UINT64_C(1) <<
+                     (UPUMP_COMMON_WHEEL_BITS * UPUMP_COMMON_WHEEL_LEVELS);
+    if (delta >= range)
+        expiry = common_mgr->wheel_next + range - 1;
+
+    unsigned int slot = (expiry >> (UPUMP_COMMON_WHEEL_BITS * level)) &
+                        (UPUMP_COMMON_WHEEL_SLOTS - 1);
+    ulist_add(&common_mgr->wheel[level][slot], &common->wheel_uchain);
+}
+
+static void upump_common_wheel_tick(struct upump *upump);
+
+/** @internal @This allocates, starts or releases the real timer driving the
+ * timer wheel, depending on the timers it holds.
+ *
+ * @param common_mgr pointer to a upump_common_mgr structure
+ * @return false if the real timer couldn't be allocated
+ */
+static bool upump_common_wheel_update(struct upump_common_mgr *common_mgr)
+{
+    /* the real timer is dispatching, this is done once it is over */
+    if (common_mgr->wheel_running)
+        return true;
+
+    if (!common_mgr->nb_wheel) {
+        if (common_mgr->wheel_pump != NULL) {
+            /* the real timer holds a reference to the manager */
+            upump_stop(common_mgr->wheel_pump);
+            upump_free(common_mgr->wheel_pump);
+            common_mgr->wheel_pump = NULL;
+        }
+        return true;
+    }
+
+    bool status = common_mgr->nb_wheel_active != 0;
+    if (common_mgr->wheel_pump == NULL) {
+        if (common_mgr->wheel_clock == NULL &&
+            unlikely((common_mgr->wheel_clock = uclock_std_alloc(0)) == NULL))
+            return false;
+        common_mgr->wheel_pump = upump_alloc_timer(&common_mgr->mgr,
+                upump_common_wheel_tick, common_mgr, NULL,
+                UPUMP_TIMER_COARSE_TICK, UPUMP_TIMER_COARSE_TICK);
+        if (unlikely(common_mgr->wheel_pump == NULL))
+            return false;
+        common_mgr->wheel_date = uclock_now(common_mgr->wheel_clock) +
+                                 UPUMP_TIMER_COARSE_TICK;
+        upump_common_from_upump(common_mgr->wheel_pump)->status = status;
+        upump_start(common_mgr->wheel_pump);
+    } else if (upump_common_from_upump(common_mgr->wheel_pump)->status !=
+               status)
+        upump_set_status(common_mgr->wheel_pump, status);
+    return true;
+}
+
+/** @internal @This schedules a timer on the timer wheel.
+ *
+ * @param upump description structure of the pump
+ * @param expiry tick of the timer wheel at which it triggers
+ * @return false if the timer wheel couldn't be started
+ */
+static bool upump_common_wheel_schedule(struct upump *upump, uint64_t expiry)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_mgr(upump->mgr);
+    common->wheel_expiry = expiry;
+    common_mgr->nb_wheel++;
+    if (common->status)
+        common_mgr->nb_wheel_active++;
+    if (unlikely(!upump_common_wheel_update(common_mgr))) {
+        common_mgr->nb_wheel--;
+        if (common->status)
+            common_mgr->nb_wheel_active--;
+        return false;
+    }
+    upump_common_wheel_insert(common_mgr, common);
+    return true;
+}
+
+/** @internal @This unschedules a timer from the timer wheel.
+ *
+ * @param upump description structure of the pump
+ */
+static void upump_common_wheel_unschedule(struct upump *upump)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_mgr(upump->mgr);
+    if (!ulist_is_in(&common->wheel_uchain))
+        return;
+    ulist_delete(&common->wheel_uchain);
+    common_mgr->nb_wheel--;
+    if (common->status)
+        common_mgr->nb_wheel_active--;
+    upump_common_wheel_update(common_mgr);
+}
+
+/** @internal @This distributes the timers of a slot over the finer levels
+ * of the timer wheel.
+ *
+ * @param common_mgr pointer to a upump_common_mgr structure
+ * @param level level of the slot
+ * @return index of the slot
+ */
+static unsigned int upump_common_wheel_cascade(
+        struct upump_common_mgr *common_mgr, unsigned int level)
+{
+    unsigned int slot =
+        (common_mgr->wheel_next >> (UPUMP_COMMON_WHEEL_BITS * level)) &
+        (UPUMP_COMMON_WHEEL_SLOTS - 1);
+    struct uchain list;
+    ulist_init(&list);
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&common_mgr->wheel[level][slot])) != NULL)
+        ulist_add(&list, uchain);
+    while ((uchain = ulist_pop(&list)) != NULL)
+        upump_common_wheel_insert(common_mgr,
+                                  upump_common_from_wheel_uchain(uchain));
+    return slot;
+}
+
+/** @internal @This processes the next tick of the timer wheel, dispatching
+ * the timers expiring during this tick.
+ *
+ * @param common_mgr pointer to a upump_common_mgr structure
+ */
+static void upump_common_wheel_advance(struct upump_common_mgr *common_mgr)
+{
+    uint64_t now = common_mgr->wheel_next;
+    unsigned int slot = now & (UPUMP_COMMON_WHEEL_SLOTS - 1);
+    for (unsigned int level = 1;
+         !slot && level < UPUMP_COMMON_WHEEL_LEVELS; level++)
+        slot = upump_common_wheel_cascade(common_mgr, level);
+    common_mgr->wheel_next++;
+
+    /* the expired timers are moved away first, so that restarting them
+     * from their callbacks doesn't put them back in the batch */
+    struct uchain batch;
+    ulist_init(&batch);
+    struct uchain *uchain;
+    struct uchain *expired =
+        &common_mgr->wheel[0][now & (UPUMP_COMMON_WHEEL_SLOTS - 1)];
+    while ((uchain = ulist_pop(expired)) != NULL)
+        ulist_add(&batch, uchain);
+
+    while ((uchain = ulist_peek(&batch)) != NULL) {
+        struct upump_common *common = upump_common_from_wheel_uchain(uchain);
+        struct upump *timer = upump_common_to_upump(common);
+        /* like other event loops, a one-shot timer stops by itself */
+        upump_common_wheel_unschedule(timer);
+        if (common->repeat)
+            upump_common_wheel_schedule(timer,
+                    now + upump_common_wheel_ticks(common->repeat));
+        upump_common_dispatch(timer);
+    }
+}
+
+/** @internal @This is called by the real timer driving the timer wheel. As
+ * the real timer may be late, all the ticks which are due are processed, so
+ * that the timer wheel doesn't drift from the clock.
+ *
+ * @param upump description structure of the real timer
+ */
+static void upump_common_wheel_tick(struct upump *upump)
+{
+    struct upump_common_mgr *common_mgr =
+        upump_get_opaque(upump, struct upump_common_mgr *);
+    uint64_t date = uclock_now(common_mgr->wheel_clock);
+
+    common_mgr->wheel_running = true;
+    while (common_mgr->nb_wheel && common_mgr->wheel_date <= date) {
+        upump_common_wheel_advance(common_mgr);
+        common_mgr->wheel_date += UPUMP_TIMER_COARSE_TICK;
+    }
+    common_mgr->wheel_running = false;
+    upump_common_wheel_update(common_mgr);
+}
+
+/** @internal @This schedules a coarse timer on the timer wheel, accounting
+ * for the ticks which are already due but not yet processed.
+ *
+ * @param upump description structure of the pump
+ * @return false if the timer wheel couldn't be started
+ */
+static bool upump_common_wheel_start(struct upump *upump)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_mgr(upump->mgr);
+    uint64_t after = common->after;
+    if (common_mgr->wheel_pump != NULL) {
+        uint64_t date = uclock_now(common_mgr->wheel_clock);
+        if (date > common_mgr->wheel_date)
+            after += date - common_mgr->wheel_date;
+    }
+    return upump_common_wheel_schedule(upump, common_mgr->wheel_next +
+                                       upump_common_wheel_ticks(after));
+}
+
+/** @internal @This really starts a pump, or schedules it on the virtual
+ * clock if it is a timer and the manager runs on virtual time.
+ *
+ * @param upump description structure of the pump
+ */
+static void upump_common_real_start(struct upump *upump)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_mgr(upump->mgr);
+    if (common_mgr->virtual_clock != NULL && common->timer) {
+        upump_common_virtual_unschedule(upump);
+        upump_common_virtual_schedule(upump,
+                uclock_now(common_mgr->virtual_clock) + common->after);
+    } else if (!common->coarse || !upump_common_wheel_start(upump))
+        common_mgr->upump_real_start(upump, common->status);
+}
+
+/** @internal @This really stops a pump, or unschedules it from the virtual
+ * clock.
+ *
+ * @param upump description structure of the pump
+ */
+static void upump_common_real_stop(struct upump *upump)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_mgr(upump->mgr);
+    if (ulist_is_in(&common->virtual_uchain))
+        upump_common_virtual_unschedule(upump);
+    else if (ulist_is_in(&common->wheel_uchain))
+        upump_common_wheel_unschedule(upump);
+    else
+        common_mgr->upump_real_stop(upump, common->status);
+}
+
 /** @This allocates and initializes a blocker.
  *
  * @param upump description structure of the pump
@@ -71,11 +391,8 @@ struct upump_blocker *upump_common_blocker_alloc(struct upump *upump)
     bool was_blocked = !ulist_empty(&common->blockers);
     ulist_add(&common->blockers,
               upump_blocker_common_to_uchain(blocker_common));
-    if (common->started && !was_blocked) {
-        struct upump_common_mgr *common_mgr =
-            upump_common_mgr_from_upump_mgr(upump->mgr);
-        common_mgr->upump_real_stop(upump, common->status);
-    }
+    if (common->started && !was_blocked)
+        upump_common_real_stop(upump);
     return blocker;
 }
 
@@ -92,11 +409,8 @@ void upump_common_blocker_free(struct upump_blocker *blocker)
     struct upump_common *common = upump_common_from_upump(blocker->upump);
 
     ulist_delete(upump_blocker_common_to_uchain(blocker_common));
-    if (common->started && ulist_empty(&common->blockers)) {
-        struct upump_common_mgr *common_mgr =
-            upump_common_mgr_from_upump_mgr(blocker->upump->mgr);
-        common_mgr->upump_real_start(blocker->upump, common->status);
-    }
+    if (common->started && ulist_empty(&common->blockers))
+        upump_common_real_start(blocker->upump);
 
     upool_free(&common_mgr->upump_blocker_pool, blocker_common);
 }
@@ -132,6 +446,87 @@ void upump_common_init(struct upump *upump)
     common->started = false;
     common->status = true;
     ulist_init(&common->blockers);
+    common->timer = false;
+    common->after = common->repeat = 0;
+    common->deadline = 0;
+    uchain_init(&common->virtual_uchain);
+    common->virtual_deadline = 0;
+    common->coarse = false;
+    uchain_init(&common->wheel_uchain);
+    common->wheel_expiry = 0;
+    memset(&common->profile, 0, sizeof(common->profile));
+}
+
+/** @This declares a pump as a timer, so that its lateness is profiled.
+ *
+ * @param upump description structure of the pump
+ * @param after delay of the first trigger
+ * @param repeat period of the timer, or 0
+ */
+void upump_common_set_timer(struct upump *upump, uint64_t after,
+                            uint64_t repeat)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    common->timer = true;
+    common->after = after;
+    common->repeat = repeat;
+}
+
+/** @This declares a pump as a coarse timer, scheduled on the timer wheel of
+ * the manager instead of a real watcher.
+ *
+ * @param upump description structure of the pump
+ * @param after delay of the first trigger
+ * @param repeat period of the timer, or 0
+ */
+void upump_common_set_timer_coarse(struct upump *upump, uint64_t after,
+                                   uint64_t repeat)
+{
+    upump_common_set_timer(upump, after, repeat);
+    upump_common_from_upump(upump)->coarse = true;
+}
+
+/** @internal @This dispatches a pump while profiling.
+ *
+ * @param upump description structure of the pump
+ * @param uclock clock used to measure time
+ */
+static void upump_common_dispatch_profile(struct upump *upump,
+                                          struct uclock *uclock)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    uint64_t start = uclock_now(uclock);
+
+    if (common->timer) {
+        if (common->deadline) {
+            uint64_t lateness = start > common->deadline ?
+                                start - common->deadline : 0;
+            common->profile.lateness += lateness;
+            if (lateness > common->profile.max_lateness)
+                common->profile.max_lateness = lateness;
+        }
+        /* event loops reschedule late timers from the current date */
+        if (common->repeat && common->deadline &&
+            common->deadline + common->repeat > start)
+            common->deadline += common->repeat;
+        else
+            common->deadline = common->repeat ? start + common->repeat : 0;
+    }
+
+    /* the pump may be freed by its callback, which resets current */
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_mgr(upump->mgr);
+    struct upump_common *current = common_mgr->current;
+    common_mgr->current = common;
+    upump->cb(upump);
+    uint64_t duration = uclock_now(uclock) - start;
+    if (likely(common_mgr->current == common)) {
+        common->profile.count++;
+        common->profile.run_time += duration;
+        if (duration > common->profile.max_run_time)
+            common->profile.max_run_time = duration;
+    }
+    common_mgr->current = current;
 }
 
 /** @This dispatches a pump.
@@ -140,11 +535,36 @@ void upump_common_init(struct upump *upump)
  */
 void upump_common_dispatch(struct upump *upump)
 {
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_mgr(upump->mgr);
     struct urefcount *refcount = urefcount_use(upump->refcount);
-    upump->cb(upump);
+    UTRACE2(upump_enter, upump, upump->cb);
+    if (unlikely(common_mgr->uclock != NULL))
+        upump_common_dispatch_profile(upump, common_mgr->uclock);
+    else
+        upump->cb(upump);
+    /* the pump may have been freed by its callback, only trace its address */
+    UTRACE1(upump_exit, upump);
     urefcount_release(refcount);
 }
 
+/** @This gets the profiling counters of a pump.
+ *
+ * @param upump description structure of the pump
+ * @param profile filled in with the profiling counters
+ * @return an error code
+ */
+int upump_common_get_profile(struct upump *upump,
+                             struct upump_profile *profile)
+{
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_mgr(upump->mgr);
+    if (common_mgr->uclock == NULL)
+        return UBASE_ERR_INVALID;
+    *profile = upump_common_from_upump(upump)->profile;
+    return UBASE_ERR_NONE;
+}
+
 /** @This starts a pump if allowed.
  *
  * @param upump description structure of the pump
@@ -152,12 +572,13 @@ void upump_common_dispatch(struct upump *upump)
 void upump_common_start(struct upump *upump)
 {
     struct upump_common *common = upump_common_from_upump(upump);
+    struct upump_common_mgr *mgr = upump_common_mgr_from_upump_mgr(upump->mgr);
     common->started = true;
-    if (ulist_empty(&common->blockers)) {
-        struct upump_common_mgr *common_mgr =
-            upump_common_mgr_from_upump_mgr(upump->mgr);
-        common_mgr->upump_real_start(upump, common->status);
-    }
+    if (common->timer)
+        common->deadline = mgr->uclock != NULL ?
+                           uclock_now(mgr->uclock) + common->after : 0;
+    if (ulist_empty(&common->blockers))
+        upump_common_real_start(upump);
 }
 
 /** @This stops a pump if needed.
@@ -168,11 +589,8 @@ void upump_common_stop(struct upump *upump)
 {
     struct upump_common *common = upump_common_from_upump(upump);
     common->started = false;
-    if (ulist_empty(&common->blockers)) {
-        struct upump_common_mgr *common_mgr =
-            upump_common_mgr_from_upump_mgr(upump->mgr);
-        common_mgr->upump_real_stop(upump, common->status);
-    }
+    if (ulist_empty(&common->blockers))
+        upump_common_real_stop(upump);
 }
 
 /** @This gets the blocking status of a pump.
@@ -209,6 +627,12 @@ void upump_common_set_status(struct upump *upump, int status)
 void upump_common_clean(struct upump *upump)
 {
     struct upump_common *common = upump_common_from_upump(upump);
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_mgr(upump->mgr);
+    if (common_mgr->current == common)
+        common_mgr->current = NULL;
+    upump_common_virtual_unschedule(upump);
+    upump_common_wheel_unschedule(upump);
     struct uchain *uchain, *uchain_tmp;
     struct urefcount *refcount = urefcount_use(upump->refcount);
     ulist_delete_foreach (&common->blockers, uchain, uchain_tmp) {
@@ -221,6 +645,144 @@ void upump_common_clean(struct upump *upump)
     urefcount_release(refcount);
 }
 
+/** @This enables or disables profiling.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_common_mgr structure
+ * @param uclock clock used to measure time, or NULL to disable profiling
+ */
+void upump_common_mgr_set_profiling(struct upump_mgr *mgr,
+                                    struct uclock *uclock)
+{
+    struct upump_common_mgr *common_mgr = upump_common_mgr_from_upump_mgr(mgr);
+    uclock_release(common_mgr->uclock);
+    common_mgr->uclock = uclock_use(uclock);
+    common_mgr->iteration_start = 0;
+    memset(&common_mgr->profile, 0, sizeof(common_mgr->profile));
+}
+
+/** @This gets the profiling counters of the event loop.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_common_mgr structure
+ * @param profile filled in with the profiling counters
+ * @return an error code
+ */
+int upump_common_mgr_get_profile(struct upump_mgr *mgr,
+                                 struct upump_mgr_profile *profile)
+{
+    struct upump_common_mgr *common_mgr = upump_common_mgr_from_upump_mgr(mgr);
+    if (common_mgr->uclock == NULL)
+        return UBASE_ERR_INVALID;
+    *profile = common_mgr->profile;
+    return UBASE_ERR_NONE;
+}
+
+/** @This makes timers run on a virtual clock.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_common_mgr structure
+ * @param uclock virtual clock (see @ref uclock_virtual_alloc), or NULL to
+ * go back to real time
+ * @return an error code
+ */
+int upump_common_mgr_set_virtual_clock(struct upump_mgr *mgr,
+                                       struct uclock *uclock)
+{
+    struct upump_common_mgr *common_mgr = upump_common_mgr_from_upump_mgr(mgr);
+    if (uclock != NULL)
+        UBASE_RETURN(uclock_virtual_advance(uclock, 0))
+    if (unlikely(!ulist_empty(&common_mgr->virtual_timers)))
+        return UBASE_ERR_BUSY;
+    uclock_release(common_mgr->virtual_clock);
+    common_mgr->virtual_clock = uclock_use(uclock);
+    return UBASE_ERR_NONE;
+}
+
+/** @This checks whether timers are scheduled on the virtual clock.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_common_mgr structure
+ * @param active_p filled in with true if one of them is blocking, or NULL
+ * @return true if timers are scheduled
+ */
+bool upump_common_mgr_virtual_pending(struct upump_mgr *mgr, bool *active_p)
+{
+    struct upump_common_mgr *common_mgr = upump_common_mgr_from_upump_mgr(mgr);
+    if (active_p != NULL)
+        *active_p = common_mgr->nb_virtual_active != 0;
+    return !ulist_empty(&common_mgr->virtual_timers);
+}
+
+/** @This advances the virtual clock to the date of the next timer, and
+ * dispatches it. It is called by the event loop instead of sleeping.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_common_mgr structure
+ * @return false if no timer is scheduled
+ */
+bool upump_common_mgr_dispatch_virtual(struct upump_mgr *mgr)
+{
+    struct upump_common_mgr *common_mgr = upump_common_mgr_from_upump_mgr(mgr);
+    struct uchain *uchain = ulist_peek(&common_mgr->virtual_timers);
+    if (uchain == NULL)
+        return false;
+
+    struct upump_common *common = upump_common_from_virtual_uchain(uchain);
+    struct upump *upump = upump_common_to_upump(common);
+    uint64_t deadline = common->virtual_deadline;
+    uclock_virtual_advance(common_mgr->virtual_clock, deadline);
+
+    /* like other event loops, a one-shot timer stops by itself */
+    upump_common_virtual_unschedule(upump);
+    if (common->repeat)
+        upump_common_virtual_schedule(upump, deadline + common->repeat);
+    upump_common_dispatch(upump);
+    return true;
+}
+
+/** @This is called by the event loop when it wakes up to process events.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_common_mgr structure
+ */
+void upump_common_mgr_wake(struct upump_mgr *mgr)
+{
+    struct upump_common_mgr *common_mgr = upump_common_mgr_from_upump_mgr(mgr);
+    if (likely(common_mgr->uclock == NULL))
+        return;
+
+    uint64_t now = uclock_now(common_mgr->uclock);
+    if (common_mgr->iteration_start) {
+        uint64_t duration = now - common_mgr->iteration_start;
+        common_mgr->profile.iterations++;
+        common_mgr->profile.total_time += duration;
+        common_mgr->profile.last_total_time = duration;
+    }
+    common_mgr->iteration_start = now;
+    common_mgr->busy_start = now;
+}
+
+/** @This is called by the event loop before it goes to sleep.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_common_mgr structure
+ */
+void upump_common_mgr_sleep(struct upump_mgr *mgr)
+{
+    struct upump_common_mgr *common_mgr = upump_common_mgr_from_upump_mgr(mgr);
+    if (likely(common_mgr->uclock == NULL) || !common_mgr->busy_start)
+        return;
+
+    uint64_t duration = uclock_now(common_mgr->uclock) -
+                        common_mgr->busy_start;
+    common_mgr->busy_start = 0;
+    common_mgr->profile.busy_time += duration;
+    common_mgr->profile.last_busy_time = duration;
+    if (duration > common_mgr->profile.max_busy_time)
+        common_mgr->profile.max_busy_time = duration;
+}
+
 /** @This returns the extra buffer space needed for pools.
  *
  * @param upump_pool_depth maximum number of upump structures in the pool
@@ -258,6 +820,9 @@ void upump_common_mgr_clean(struct upump_mgr *mgr)
     struct upump_common_mgr *common_mgr = upump_common_mgr_from_upump_mgr(mgr);
     upool_clean(&common_mgr->upump_pool);
     upool_clean(&common_mgr->upump_blocker_pool);
+    uclock_release(common_mgr->uclock);
+    uclock_release(common_mgr->virtual_clock);
+    uclock_release(common_mgr->wheel_clock);
 }
 
 /** @This initializes the common parts of a upump_common_mgr structure.
@@ -287,6 +852,22 @@ void upump_common_mgr_init(struct upump_mgr *mgr,
     struct upump_common_mgr *common_mgr = upump_common_mgr_from_upump_mgr(mgr);
     common_mgr->upump_real_start = upump_real_start;
     common_mgr->upump_real_stop = upump_real_stop;
+    common_mgr->uclock = NULL;
+    common_mgr->virtual_clock = NULL;
+    ulist_init(&common_mgr->virtual_timers);
+    common_mgr->nb_virtual_active = 0;
+    for (unsigned int i = 0; i < UPUMP_COMMON_WHEEL_LEVELS; i++)
+        for (unsigned int j = 0; j < UPUMP_COMMON_WHEEL_SLOTS; j++)
+            ulist_init(&common_mgr->wheel[i][j]);
+    common_mgr->wheel_next = 0;
+    common_mgr->nb_wheel = common_mgr->nb_wheel_active = 0;
+    common_mgr->wheel_pump = NULL;
+    common_mgr->wheel_clock = NULL;
+    common_mgr->wheel_date = 0;
+    common_mgr->wheel_running = false;
+    common_mgr->current = NULL;
+    common_mgr->iteration_start = common_mgr->busy_start = 0;
+    memset(&common_mgr->profile, 0, sizeof(common_mgr->profile));
 
     upool_init(&common_mgr->upump_pool, mgr->refcount, upump_pool_depth,
                pool_extra, upump_alloc_inner, upump_free_inner);
@@ -0,0 +1,408 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe compact binary serialization of urefs
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/udict.h>
+#include <upipe/uref.h>
+#include <upipe/uref_serial.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/** bit set in the type of an attribute to mark its deletion */
+#define UREF_SERIAL_DELETE 0x80
+
+/** @internal @This describes the buffer being written. */
+struct uref_serial_writer {
+    /** buffer, or NULL if only computing the size */
+    uint8_t *buffer;
+    /** size of the buffer */
+    size_t size;
+    /** number of octets written so far */
+    size_t pos;
+};
+
+/** @internal @This describes the buffer being read. */
+struct uref_serial_reader {
+    /** buffer */
+    const uint8_t *buffer;
+    /** size of the buffer */
+    size_t size;
+    /** number of octets read so far */
+    size_t pos;
+};
+
+/** @internal @This writes octets.
+ *
+ * @param writer description of the buffer
+ * @param data octets to write
+ * @param size number of octets
+ */
+static void uref_serial_put(struct uref_serial_writer *writer,
+                            const void *data, size_t size)
+{
+    if (writer->buffer != NULL && writer->pos + size <= writer->size)
+        memcpy(writer->buffer + writer->pos, data, size);
+    writer->pos += size;
+}
+
+/** @internal @This writes a variable-length unsigned integer, 7 bits per
+ * octet, least significant first.
+ *
+ * @param writer description of the buffer
+ * @param value value to write
+ */
+static void uref_serial_put_varint(struct uref_serial_writer *writer,
+                                   uint64_t value)
+{
+    uint8_t octets[10];
+    size_t size = 0;
+    do {
+        octets[size] = value & 0x7f;
+        value >>= 7;
+        if (value)
+            octets[size] |= 0x80;
+        size++;
+    } while (value);
+    uref_serial_put(writer, octets, size);
+}
+
+/** @internal @This reads octets.
+ *
+ * @param reader description of the buffer
+ * @param size number of octets
+ * @return pointer to the octets, or NULL if the buffer is too short
+ */
+static const uint8_t *uref_serial_get(struct uref_serial_reader *reader,
+                                      size_t size)
+{
+    if (unlikely(size > reader->size - reader->pos))
+        return NULL;
+    const uint8_t *data = reader->buffer + reader->pos;
+    reader->pos += size;
+    return data;
+}
+
+/** @internal @This reads a variable-length unsigned integer.
+ *
+ * @param reader description of the buffer
+ * @param value_p filled in with the value
+ * @return an error code
+ */
+static int uref_serial_get_varint(struct uref_serial_reader *reader,
+                                  uint64_t *value_p)
+{
+    uint64_t value = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7) {
+        const uint8_t *octet = uref_serial_get(reader, 1);
+        if (unlikely(octet == NULL))
+            return UBASE_ERR_INVALID;
+        value |= (uint64_t)(*octet & 0x7f) << shift;
+        if (!(*octet & 0x80)) {
+            *value_p = value;
+            return UBASE_ERR_NONE;
+        }
+    }
+    return UBASE_ERR_INVALID;
+}
+
+/** @internal @This checks the type of a received attribute, and returns
+ * its base type.
+ *
+ * @param udict udict the attribute is written to
+ * @param type type of the attribute
+ * @param base_type_p filled in with the base type of the attribute
+ * @return an error code
+ */
+static int uref_serial_check_type(struct udict *udict, enum udict_type type,
+                                  enum udict_type *base_type_p)
+{
+    if (type > UDICT_TYPE_SHORTHAND) {
+        const char *name;
+        UBASE_RETURN(udict_name(udict, type, &name, base_type_p))
+        return UBASE_ERR_NONE;
+    }
+    if (unlikely(type == UDICT_TYPE_END || type > UDICT_TYPE_FLOAT))
+        return UBASE_ERR_INVALID;
+    *base_type_p = type;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This checks the value of a received attribute against its
+ * type, so that it can be stored in a udict.
+ *
+ * @param type type of the attribute
+ * @param base_type base type of the attribute
+ * @param name_len length of the name of the attribute
+ * @param value value of the attribute
+ * @param value_size size of the value
+ * @return an error code
+ */
+static int uref_serial_check_value(enum udict_type type,
+                                   enum udict_type base_type, size_t name_len,
+                                   const uint8_t *value, uint64_t value_size)
+{
+    switch (base_type) {
+        case UDICT_TYPE_STRING:
+            if (unlikely(!value_size || value[value_size - 1] != '\0'))
+                return UBASE_ERR_INVALID;
+            /* fallthrough */
+        case UDICT_TYPE_OPAQUE:
+            /* the size of the value and the name are stored on 16 bits */
+            if (type > UDICT_TYPE_SHORTHAND)
+                return value_size <= UINT16_MAX ? UBASE_ERR_NONE :
+                                                  UBASE_ERR_INVALID;
+            break;
+        case UDICT_TYPE_VOID:
+            if (unlikely(value_size != 0))
+                return UBASE_ERR_INVALID;
+            break;
+        case UDICT_TYPE_BOOL:
+        case UDICT_TYPE_SMALL_UNSIGNED:
+        case UDICT_TYPE_SMALL_INT:
+            if (unlikely(value_size != sizeof(uint8_t)))
+                return UBASE_ERR_INVALID;
+            break;
+        case UDICT_TYPE_UNSIGNED:
+        case UDICT_TYPE_INT:
+        case UDICT_TYPE_FLOAT:
+            if (unlikely(value_size != sizeof(uint64_t)))
+                return UBASE_ERR_INVALID;
+            break;
+        case UDICT_TYPE_RATIONAL:
+            if (unlikely(value_size != 2 * sizeof(uint64_t)))
+                return UBASE_ERR_INVALID;
+            break;
+        default:
+            return UBASE_ERR_INVALID;
+    }
+    if (type <= UDICT_TYPE_SHORTHAND &&
+        unlikely(name_len + 1 + value_size > UINT16_MAX))
+        return UBASE_ERR_INVALID;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This writes the type and name of an attribute.
+ *
+ * @param writer description of the buffer
+ * @param type type of the attribute
+ * @param name name of the attribute
+ * @param delete true if the attribute is deleted
+ */
+static void uref_serial_put_key(struct uref_serial_writer *writer,
+                                enum udict_type type, const char *name,
+                                bool delete)
+{
+    uint8_t octet = type | (delete ? UREF_SERIAL_DELETE : 0);
+    uref_serial_put(writer, &octet, 1);
+    if (type <= UDICT_TYPE_SHORTHAND) {
+        size_t name_len = strlen(name);
+        uref_serial_put_varint(writer, name_len);
+        uref_serial_put(writer, name, name_len);
+    }
+}
+
+/** @internal @This returns the clock fields of a uref.
+ *
+ * @param uref pointer to uref
+ * @param fields filled in with pointers to the fields
+ */
+static void uref_serial_fields(struct uref *uref, uint64_t *fields[8])
+{
+    fields[0] = &uref->date_sys;
+    fields[1] = &uref->date_prog;
+    fields[2] = &uref->date_orig;
+    fields[3] = &uref->dts_pts_delay;
+    fields[4] = &uref->cr_dts_delay;
+    fields[5] = &uref->rap_cr_delay;
+    fields[6] = &uref->duration;
+    fields[7] = &uref->pic_number;
+}
+
+/** @This serializes a uref, except its buffer.
+ *
+ * @param uref uref to serialize
+ * @param ref reference uref, or NULL to write all attributes
+ * @param buffer buffer to write to, or NULL to only compute the size
+ * @param size_p size of the buffer, filled in with the size of the
+ * serialized uref
+ * @return an error code, UBASE_ERR_NOSPC if the buffer is too small
+ */
+int uref_serial_encode(struct uref *uref, struct uref *ref,
+                       uint8_t *buffer, size_t *size_p)
+{
+    struct uref_serial_writer writer = {
+        .buffer = buffer,
+        .size = buffer != NULL ? *size_p : 0,
+        .pos = 0
+    };
+
+    uref_serial_put_varint(&writer, uref->flags);
+    uint64_t *fields[8];
+    uref_serial_fields(uref, fields);
+    uint8_t present = 0;
+    for (int i = 0; i < 8; i++)
+        if (*fields[i] != UINT64_MAX)
+            present |= 1 << i;
+    uref_serial_put(&writer, &present, 1);
+    for (int i = 0; i < 8; i++)
+        if (present & (1 << i))
+            uref_serial_put_varint(&writer, *fields[i]);
+
+    struct udict *ref_udict = ref != NULL ? ref->udict : NULL;
+    if (uref->udict != NULL) {
+        const char *name = NULL;
+        enum udict_type type = UDICT_TYPE_END;
+        while (ubase_check(udict_iterate(uref->udict, &name, &type)) &&
+               type != UDICT_TYPE_END) {
+            size_t size;
+            const uint8_t *value;
+            UBASE_RETURN(udict_get(uref->udict, name, type, &size, &value))
+
+            size_t ref_size;
+            const uint8_t *ref_value;
+            if (ref_udict != NULL &&
+                ubase_check(udict_get(ref_udict, name, type,
+                                      &ref_size, &ref_value)) &&
+                ref_size == size && !memcmp(ref_value, value, size))
+                continue;
+
+            uref_serial_put_key(&writer, type, name, false);
+            uref_serial_put_varint(&writer, size);
+            uref_serial_put(&writer, value, size);
+        }
+    }
+
+    if (ref_udict != NULL) {
+        const char *name = NULL;
+        enum udict_type type = UDICT_TYPE_END;
+        while (ubase_check(udict_iterate(ref_udict, &name, &type)) &&
+               type != UDICT_TYPE_END) {
+            if (uref->udict == NULL ||
+                !ubase_check(udict_get(uref->udict, name, type, NULL, NULL)))
+                uref_serial_put_key(&writer, type, name, true);
+        }
+    }
+
+    uint8_t end = UDICT_TYPE_END;
+    uref_serial_put(&writer, &end, 1);
+
+    bool nospc = buffer != NULL && writer.pos > *size_p;
+    *size_p = writer.pos;
+    return nospc ? UBASE_ERR_NOSPC : UBASE_ERR_NONE;
+}
+
+/** @This deserializes a uref, except its buffer. The attributes of the uref
+ * are replaced.
+ *
+ * @param uref uref to fill in
+ * @param ref reference uref that was passed to @ref uref_serial_encode, or
+ * NULL
+ * @param buffer serialized uref
+ * @param size size of the serialized uref
+ * @return an error code
+ */
+int uref_serial_decode(struct uref *uref, struct uref *ref,
+                       const uint8_t *buffer, size_t size)
+{
+    struct uref_serial_reader reader = {
+        .buffer = buffer,
+        .size = size,
+        .pos = 0
+    };
+
+    UBASE_RETURN(uref_serial_get_varint(&reader, &uref->flags))
+    const uint8_t *present = uref_serial_get(&reader, 1);
+    if (unlikely(present == NULL))
+        return UBASE_ERR_INVALID;
+    uint64_t *fields[8];
+    uref_serial_fields(uref, fields);
+    for (int i = 0; i < 8; i++) {
+        *fields[i] = UINT64_MAX;
+        if (*present & (1 << i))
+            UBASE_RETURN(uref_serial_get_varint(&reader, fields[i]))
+    }
+
+    if (uref->udict != NULL) {
+        udict_free(uref->udict);
+        uref->udict = NULL;
+    }
+    if (ref != NULL && ref->udict != NULL) {
+        uref->udict = udict_dup(ref->udict);
+        UBASE_ALLOC_RETURN(uref->udict)
+    }
+
+    for ( ; ; ) {
+        const uint8_t *octet = uref_serial_get(&reader, 1);
+        if (unlikely(octet == NULL))
+            return UBASE_ERR_INVALID;
+        if (*octet == UDICT_TYPE_END)
+            break;
+        enum udict_type type = *octet & ~UREF_SERIAL_DELETE;
+        bool delete = *octet & UREF_SERIAL_DELETE;
+
+        uint64_t name_len = 0;
+        const uint8_t *name_data = NULL;
+        if (type <= UDICT_TYPE_SHORTHAND) {
+            UBASE_RETURN(uref_serial_get_varint(&reader, &name_len))
+            if (unlikely(name_len > UINT8_MAX))
+                return UBASE_ERR_INVALID;
+            name_data = uref_serial_get(&reader, name_len);
+            if (unlikely(name_data == NULL ||
+                         memchr(name_data, '\0', name_len) != NULL))
+                return UBASE_ERR_INVALID;
+        }
+        char name[name_len + 1];
+        if (name_data != NULL)
+            memcpy(name, name_data, name_len);
+        name[name_len] = '\0';
+
+        if (uref->udict == NULL) {
+            uref->udict = udict_alloc(uref->mgr->udict_mgr, 0);
+            UBASE_ALLOC_RETURN(uref->udict)
+        }
+
+        enum udict_type base_type;
+        UBASE_RETURN(uref_serial_check_type(uref->udict, type, &base_type))
+        if (delete) {
+            UBASE_RETURN(udict_delete(uref->udict, type, name))
+            continue;
+        }
+
+        uint64_t value_size;
+        UBASE_RETURN(uref_serial_get_varint(&reader, &value_size))
+        const uint8_t *value_data = uref_serial_get(&reader, value_size);
+        if (unlikely(value_data == NULL))
+            return UBASE_ERR_INVALID;
+        UBASE_RETURN(uref_serial_check_value(type, base_type, name_len,
+                                             value_data, value_size))
+        uint8_t *value;
+        UBASE_RETURN(udict_set(uref->udict, name, type, value_size, &value))
+        memcpy(value, value_data, value_size);
+    }
+    return reader.pos == size ? UBASE_ERR_NONE : UBASE_ERR_INVALID;
+}
@@ -49,6 +49,12 @@ struct upump_ev_mgr {
     struct ev_loop *ev_loop;
     /** true if the loop has to be destroyed at the end */
     bool destroy;
+    /** true if the loop is profiled */
+    bool profiling;
+    /** watcher called before the loop goes to sleep, for profiling */
+    struct ev_prepare ev_prepare;
+    /** watcher called when the loop wakes up, for profiling */
+    struct ev_check ev_check;
 
     /** common structure */
     struct upump_common_mgr common_mgr;
@@ -155,14 +161,18 @@ static struct upump *upump_ev_alloc(struct upump_mgr *mgr,
     if (unlikely(upump_ev == NULL))
         return NULL;
     struct upump *upump = upump_ev_to_upump(upump_ev);
+    uint64_t after = 0, repeat = 0;
+    bool coarse = event == UPUMP_TYPE_TIMER_COARSE;
+    if (coarse)
+        event = UPUMP_TYPE_TIMER;
 
     switch (event) {
         case UPUMP_TYPE_IDLER:
             ev_idle_init(&upump_ev->ev_idle, upump_ev_dispatch_idle);
             break;
         case UPUMP_TYPE_TIMER: {
-            uint64_t after = va_arg(args, uint64_t);
-            uint64_t repeat = va_arg(args, uint64_t);
+            after = va_arg(args, uint64_t);
+            repeat = va_arg(args, uint64_t);
             ev_timer_init(&upump_ev->ev_timer, upump_ev_dispatch_timer,
                           (ev_tstamp)after / UCLOCK_FREQ,
                           (ev_tstamp)repeat / UCLOCK_FREQ);
@@ -191,6 +201,10 @@ static struct upump *upump_ev_alloc(struct upump_mgr *mgr,
     upump_ev->event = event;
 
     upump_common_init(upump);
+    if (coarse)
+        upump_common_set_timer_coarse(upump, after, repeat);
+    else if (event == UPUMP_TYPE_TIMER)
+        upump_common_set_timer(upump, after, repeat);
 
     return upump;
 }
@@ -338,11 +352,71 @@ static int upump_ev_control(struct upump *upump, int command, va_list args)
             upump_common_blocker_free(blocker);
             return UBASE_ERR_NONE;
         }
+        case UPUMP_GET_PROFILE: {
+            struct upump_profile *profile =
+                va_arg(args, struct upump_profile *);
+            return upump_common_get_profile(upump, profile);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
 }
 
+/** @internal @This is called before the event loop goes to sleep.
+ *
+ * @param ev_loop ev loop
+ * @param ev_prepare ev watcher
+ * @param revents events triggered (unused parameter)
+ */
+static void upump_ev_mgr_prepare(struct ev_loop *ev_loop,
+                                 struct ev_prepare *ev_prepare, int revents)
+{
+    struct upump_ev_mgr *ev_mgr =
+        container_of(ev_prepare, struct upump_ev_mgr, ev_prepare);
+    upump_common_mgr_sleep(upump_ev_mgr_to_upump_mgr(ev_mgr));
+}
+
+/** @internal @This is called when the event loop wakes up.
+ *
+ * @param ev_loop ev loop
+ * @param ev_check ev watcher
+ * @param revents events triggered (unused parameter)
+ */
+static void upump_ev_mgr_check(struct ev_loop *ev_loop,
+                               struct ev_check *ev_check, int revents)
+{
+    struct upump_ev_mgr *ev_mgr =
+        container_of(ev_check, struct upump_ev_mgr, ev_check);
+    upump_common_mgr_wake(upump_ev_mgr_to_upump_mgr(ev_mgr));
+}
+
+/** @internal @This enables or disables the profiling of the loop.
+ *
+ * @param mgr pointer to a upump_mgr structure
+ * @param uclock clock used to measure time, or NULL to disable profiling
+ */
+static void upump_ev_mgr_set_profiling(struct upump_mgr *mgr,
+                                       struct uclock *uclock)
+{
+    struct upump_ev_mgr *ev_mgr = upump_ev_mgr_from_upump_mgr(mgr);
+    upump_common_mgr_set_profiling(mgr, uclock);
+
+    if (uclock != NULL && !ev_mgr->profiling) {
+        /* the watchers must not keep the loop alive */
+        ev_prepare_start(ev_mgr->ev_loop, &ev_mgr->ev_prepare);
+        ev_unref(ev_mgr->ev_loop);
+        ev_check_start(ev_mgr->ev_loop, &ev_mgr->ev_check);
+        ev_unref(ev_mgr->ev_loop);
+        ev_mgr->profiling = true;
+    } else if (uclock == NULL && ev_mgr->profiling) {
+        ev_ref(ev_mgr->ev_loop);
+        ev_prepare_stop(ev_mgr->ev_loop, &ev_mgr->ev_prepare);
+        ev_ref(ev_mgr->ev_loop);
+        ev_check_stop(ev_mgr->ev_loop, &ev_mgr->ev_check);
+        ev_mgr->profiling = false;
+    }
+}
+
 /** @internal @This is called when the event loop starts invoking watchers.
  *
  * @param ev_loop ev loop
@@ -414,6 +488,16 @@ static int upump_ev_mgr_control(struct upump_mgr *mgr,
         case UPUMP_MGR_VACUUM:
             upump_common_mgr_vacuum(mgr);
             return UBASE_ERR_NONE;
+        case UPUMP_MGR_SET_PROFILING: {
+            struct uclock *uclock = va_arg(args, struct uclock *);
+            upump_ev_mgr_set_profiling(mgr, uclock);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_MGR_GET_PROFILE: {
+            struct upump_mgr_profile *profile =
+                va_arg(args, struct upump_mgr_profile *);
+            return upump_common_mgr_get_profile(mgr, profile);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -426,6 +510,7 @@ static int upump_ev_mgr_control(struct upump_mgr *mgr,
 static void upump_ev_mgr_free(struct urefcount *urefcount)
 {
     struct upump_ev_mgr *ev_mgr = upump_ev_mgr_from_urefcount(urefcount);
+    upump_ev_mgr_set_profiling(upump_ev_mgr_to_upump_mgr(ev_mgr), NULL);
     upump_common_mgr_clean(upump_ev_mgr_to_upump_mgr(ev_mgr));
     if (ev_mgr->destroy)
         ev_loop_destroy(ev_mgr->ev_loop);
@@ -466,6 +551,9 @@ struct upump_mgr *upump_ev_mgr_alloc(struct ev_loop *ev_loop,
 
     ev_mgr->ev_loop = ev_loop;
     ev_mgr->destroy = false;
+    ev_mgr->profiling = false;
+    ev_prepare_init(&ev_mgr->ev_prepare, upump_ev_mgr_prepare);
+    ev_check_init(&ev_mgr->ev_check, upump_ev_mgr_check);
     return mgr;
 }
 
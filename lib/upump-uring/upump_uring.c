@@ -0,0 +1,1247 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short implementation of a Upipe event loop using Linux io_uring
+ *
+ * The ring is driven with raw system calls, so that no dependency on liburing
+ * is required. Every pump owns a slot in a table; operations in flight carry
+ * the slot index and a generation number, so that completions of operations
+ * belonging to a stopped or freed pump are recognized and dropped.
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/ulist.h>
+#include <upipe/urefcount.h>
+#include <upipe/uclock.h>
+#include <upipe/umutex.h>
+#include <upipe/upump.h>
+#include <upipe/upump_common.h>
+#include <upump-uring/upump_uring.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/signalfd.h>
+#include <linux/io_uring.h>
+
+/** number of entries in the submission queue */
+#define UPUMP_URING_ENTRIES 256
+/** user data of operations whose completion is ignored */
+#define UPUMP_URING_IGNORE UINT64_MAX
+/** initial number of slots */
+#define UPUMP_URING_SLOTS 16
+
+/** @This is a slot referencing a pump from in-flight operations. */
+struct upump_uring_slot {
+    /** pointer to the pump, or NULL if the pump was freed */
+    struct upump_uring *upump_uring;
+    /** generation of the current operation */
+    uint32_t gen;
+    /** number of operations in flight */
+    uint32_t pending;
+    /** next free slot */
+    uint32_t next_free;
+};
+
+/** @This stores management parameters and local structures.
+ */
+struct upump_uring_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** io_uring file descriptor */
+    int fd;
+    /** mapping of the submission ring */
+    void *sq_ring;
+    /** size of the mapping of the submission ring */
+    size_t sq_ring_size;
+    /** mapping of the completion ring, may be the same as sq_ring */
+    void *cq_ring;
+    /** size of the mapping of the completion ring */
+    size_t cq_ring_size;
+    /** array of submission entries */
+    struct io_uring_sqe *sqes;
+    /** size of the mapping of submission entries */
+    size_t sqes_size;
+
+    /** submission head (written by the kernel) */
+    unsigned *sq_head;
+    /** submission tail */
+    unsigned *sq_tail;
+    /** submission ring mask */
+    unsigned sq_mask;
+    /** submission index array */
+    unsigned *sq_array;
+    /** number of entries queued but not submitted */
+    unsigned to_submit;
+    /** completion head */
+    unsigned *cq_head;
+    /** completion tail (written by the kernel) */
+    unsigned *cq_tail;
+    /** completion ring mask */
+    unsigned cq_mask;
+    /** array of completion entries */
+    struct io_uring_cqe *cqes;
+
+    /** table of slots */
+    struct upump_uring_slot *slots;
+    /** number of slots */
+    uint32_t nb_slots;
+    /** first free slot, or UINT32_MAX */
+    uint32_t free_slot;
+
+    /** completions reaped while waiting for an I/O to finish */
+    struct io_uring_cqe *deferred;
+    /** number of deferred completions */
+    unsigned int nb_deferred;
+    /** allocated size of the deferred array */
+    unsigned int max_deferred;
+
+    /** list of started idlers */
+    struct uchain idlers;
+    /** list of I/O pumps whose completion is waiting for a restart */
+    struct uchain ready;
+    /** number of operations and idlers keeping the loop alive */
+    unsigned int active;
+
+    /** common structure */
+    struct upump_common_mgr common_mgr;
+
+    /** extra space for upool */
+    uint8_t upool_extra[];
+};
+
+UBASE_FROM_TO(upump_uring_mgr, upump_mgr, upump_mgr, common_mgr.mgr)
+UBASE_FROM_TO(upump_uring_mgr, urefcount, urefcount, urefcount)
+
+/** @This stores local structures.
+ */
+struct upump_uring {
+    /** type of event to watch */
+    int event;
+    /** index of the slot */
+    uint32_t slot;
+    /** true if the pump was really started */
+    bool running;
+    /** true if an operation is in flight for the current generation */
+    bool armed;
+    /** true if the operation in flight keeps the loop alive */
+    bool counted;
+    /** true if an I/O completed while the pump was not running */
+    bool completed;
+    /** structure for the lists of idlers or ready pumps */
+    struct uchain uchain;
+
+    /** type-specific parameters */
+    union {
+        /** file descriptor for fd pumps */
+        int fd;
+        /** timer pumps */
+        struct {
+            /** delay before the first trigger */
+            uint64_t after;
+            /** delay between subsequent triggers, or 0 */
+            uint64_t repeat;
+            /** timeout passed to the kernel */
+            struct __kernel_timespec ts;
+        } timer;
+        /** signal pumps */
+        struct {
+            /** signal number */
+            int signal;
+            /** signalfd */
+            int fd;
+        } signal;
+        /** asynchronous I/O pumps */
+        struct {
+            /** file descriptor */
+            int fd;
+            /** result of the last completed I/O */
+            ssize_t result;
+        } io;
+    };
+
+    /** common structure */
+    struct upump_common common;
+};
+
+UBASE_FROM_TO(upump_uring, upump, upump, common.upump)
+UBASE_FROM_TO(upump_uring, uchain, uchain, uchain)
+
+/** @internal @This submits the queued entries and optionally waits for
+ * completions.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @param wait true to wait for at least one completion
+ * @return false in case of fatal error
+ */
+static bool upump_uring_mgr_enter(struct upump_uring_mgr *uring_mgr, bool wait)
+{
+    for ( ; ; ) {
+        int ret = syscall(__NR_io_uring_enter, uring_mgr->fd,
+                          uring_mgr->to_submit, wait ? 1 : 0,
+                          wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (likely(ret >= 0)) {
+            uring_mgr->to_submit -= ret;
+            return true;
+        }
+        if (errno == EINTR)
+            continue;
+        /* completion ring full; let the caller reap it */
+        return errno == EBUSY || errno == EAGAIN;
+    }
+}
+
+/** @internal @This returns a free submission entry.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @return pointer to submission entry, or NULL if the ring is full
+ */
+static struct io_uring_sqe *upump_uring_mgr_get_sqe(
+        struct upump_uring_mgr *uring_mgr)
+{
+    unsigned tail = *uring_mgr->sq_tail;
+    unsigned head = __atomic_load_n(uring_mgr->sq_head, __ATOMIC_ACQUIRE);
+    if (unlikely(tail - head > uring_mgr->sq_mask)) {
+        upump_uring_mgr_enter(uring_mgr, false);
+        head = __atomic_load_n(uring_mgr->sq_head, __ATOMIC_ACQUIRE);
+        if (unlikely(tail - head > uring_mgr->sq_mask))
+            return NULL;
+    }
+
+    unsigned index = tail & uring_mgr->sq_mask;
+    struct io_uring_sqe *sqe = &uring_mgr->sqes[index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    uring_mgr->sq_array[index] = index;
+    return sqe;
+}
+
+/** @internal @This queues the submission entry returned by
+ * @ref upump_uring_mgr_get_sqe.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ */
+static void upump_uring_mgr_queue_sqe(struct upump_uring_mgr *uring_mgr)
+{
+    __atomic_store_n(uring_mgr->sq_tail, *uring_mgr->sq_tail + 1,
+                     __ATOMIC_RELEASE);
+    uring_mgr->to_submit++;
+}
+
+/** @internal @This prepares a new operation for a pump.
+ *
+ * @param upump_uring pointer to a upump_uring structure
+ * @param opcode io_uring operation
+ * @return pointer to submission entry, or NULL if the ring is full
+ */
+static struct io_uring_sqe *upump_uring_arm(struct upump_uring *upump_uring,
+                                            uint8_t opcode)
+{
+    struct upump *upump = upump_uring_to_upump(upump_uring);
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+    struct io_uring_sqe *sqe = upump_uring_mgr_get_sqe(uring_mgr);
+    if (unlikely(sqe == NULL))
+        return NULL;
+
+    struct upump_uring_slot *slot = &uring_mgr->slots[upump_uring->slot];
+    slot->gen++;
+    slot->pending++;
+    sqe->opcode = opcode;
+    sqe->user_data = ((uint64_t)upump_uring->slot << 32) | slot->gen;
+    upump_uring->armed = true;
+    upump_uring->counted = upump_uring->common.status;
+    if (upump_uring->counted)
+        uring_mgr->active++;
+    return sqe;
+}
+
+/** @internal @This cancels the operation in flight of a pump, if any.
+ *
+ * @param upump_uring pointer to a upump_uring structure
+ */
+static void upump_uring_disarm(struct upump_uring *upump_uring)
+{
+    if (!upump_uring->armed)
+        return;
+
+    struct upump *upump = upump_uring_to_upump(upump_uring);
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+    struct upump_uring_slot *slot = &uring_mgr->slots[upump_uring->slot];
+    uint64_t user_data = ((uint64_t)upump_uring->slot << 32) | slot->gen;
+    upump_uring->armed = false;
+    if (upump_uring->counted) {
+        uring_mgr->active--;
+        upump_uring->counted = false;
+    }
+    /* the generation changes so that a late completion is dropped */
+    slot->gen++;
+
+    struct io_uring_sqe *sqe = upump_uring_mgr_get_sqe(uring_mgr);
+    if (unlikely(sqe == NULL))
+        return;
+    switch (upump_uring->event) {
+        case UPUMP_TYPE_TIMER:
+            sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+            break;
+        case UPUMP_TYPE_FD_READ:
+        case UPUMP_TYPE_FD_WRITE:
+        case UPUMP_TYPE_SIGNAL:
+            sqe->opcode = IORING_OP_POLL_REMOVE;
+            break;
+        default:
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            break;
+    }
+    sqe->fd = -1;
+    sqe->addr = user_data;
+    sqe->user_data = UPUMP_URING_IGNORE;
+    upump_uring_mgr_queue_sqe(uring_mgr);
+}
+
+/** @internal @This submits a poll operation.
+ *
+ * @param upump_uring pointer to a upump_uring structure
+ * @param fd file descriptor to poll
+ * @param events poll events
+ */
+static void upump_uring_arm_poll(struct upump_uring *upump_uring, int fd,
+                                 uint32_t events)
+{
+    struct io_uring_sqe *sqe = upump_uring_arm(upump_uring,
+                                               IORING_OP_POLL_ADD);
+    if (unlikely(sqe == NULL))
+        return;
+    sqe->fd = fd;
+    sqe->poll32_events = events;
+    upump_uring_mgr_queue_sqe(
+        upump_uring_mgr_from_upump_mgr(upump_uring->common.upump.mgr));
+}
+
+/** @internal @This submits a timeout operation.
+ *
+ * @param upump_uring pointer to a upump_uring structure
+ * @param delay delay in 27 MHz ticks
+ */
+static void upump_uring_arm_timer(struct upump_uring *upump_uring,
+                                  uint64_t delay)
+{
+    upump_uring->timer.ts.tv_sec = delay / UCLOCK_FREQ;
+    upump_uring->timer.ts.tv_nsec =
+        (delay % UCLOCK_FREQ) * UINT64_C(1000000000) / UCLOCK_FREQ;
+    struct io_uring_sqe *sqe = upump_uring_arm(upump_uring,
+                                               IORING_OP_TIMEOUT);
+    if (unlikely(sqe == NULL))
+        return;
+    sqe->fd = -1;
+    sqe->addr = (uintptr_t)&upump_uring->timer.ts;
+    sqe->len = 1;
+    sqe->off = 0;
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump_uring->common.upump.mgr);
+    upump_uring_mgr_queue_sqe(uring_mgr);
+    /* the timespec is read at submission time */
+    upump_uring_mgr_enter(uring_mgr, false);
+}
+
+/** @internal @This rearms the watcher of a running pump after an event.
+ *
+ * @param upump_uring pointer to a upump_uring structure
+ */
+static void upump_uring_rearm(struct upump_uring *upump_uring)
+{
+    switch (upump_uring->event) {
+        case UPUMP_TYPE_FD_READ:
+            upump_uring_arm_poll(upump_uring, upump_uring->fd, POLLIN);
+            break;
+        case UPUMP_TYPE_FD_WRITE:
+            upump_uring_arm_poll(upump_uring, upump_uring->fd, POLLOUT);
+            break;
+        case UPUMP_TYPE_SIGNAL:
+            upump_uring_arm_poll(upump_uring, upump_uring->signal.fd, POLLIN);
+            break;
+        case UPUMP_TYPE_TIMER:
+            upump_uring_arm_timer(upump_uring, upump_uring->timer.repeat);
+            break;
+        default:
+            break;
+    }
+}
+
+/** @internal @This allocates a slot for a pump.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @param upump_uring pointer to a upump_uring structure
+ * @return false in case of allocation error
+ */
+static bool upump_uring_mgr_alloc_slot(struct upump_uring_mgr *uring_mgr,
+                                       struct upump_uring *upump_uring)
+{
+    if (uring_mgr->free_slot == UINT32_MAX) {
+        uint32_t nb_slots = uring_mgr->nb_slots * 2;
+        struct upump_uring_slot *slots = realloc(uring_mgr->slots,
+                nb_slots * sizeof(struct upump_uring_slot));
+        if (unlikely(slots == NULL))
+            return false;
+        for (uint32_t i = uring_mgr->nb_slots; i < nb_slots; i++) {
+            slots[i].upump_uring = NULL;
+            slots[i].gen = 0;
+            slots[i].pending = 0;
+            slots[i].next_free = i + 1 < nb_slots ? i + 1 : UINT32_MAX;
+        }
+        uring_mgr->free_slot = uring_mgr->nb_slots;
+        uring_mgr->slots = slots;
+        uring_mgr->nb_slots = nb_slots;
+    }
+
+    uint32_t index = uring_mgr->free_slot;
+    struct upump_uring_slot *slot = &uring_mgr->slots[index];
+    uring_mgr->free_slot = slot->next_free;
+    slot->upump_uring = upump_uring;
+    upump_uring->slot = index;
+    return true;
+}
+
+/** @internal @This releases the slot of a pump, or defers it until all
+ * operations in flight have completed.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @param index index of the slot
+ */
+static void upump_uring_mgr_release_slot(struct upump_uring_mgr *uring_mgr,
+                                         uint32_t index)
+{
+    struct upump_uring_slot *slot = &uring_mgr->slots[index];
+    slot->upump_uring = NULL;
+    if (slot->pending)
+        return;
+    slot->next_free = uring_mgr->free_slot;
+    uring_mgr->free_slot = index;
+}
+
+/** @This allocates a new upump_uring.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_uring_mgr structure
+ * @param event type of event to watch for
+ * @param args optional parameters depending on event type
+ * @return pointer to allocated pump, or NULL in case of failure
+ */
+static struct upump *upump_uring_alloc(struct upump_mgr *mgr,
+                                       int event, va_list args)
+{
+    struct upump_uring_mgr *uring_mgr = upump_uring_mgr_from_upump_mgr(mgr);
+    struct upump_uring *upump_uring =
+        upool_alloc(&uring_mgr->common_mgr.upump_pool, struct upump_uring *);
+    if (unlikely(upump_uring == NULL))
+        return NULL;
+    struct upump *upump = upump_uring_to_upump(upump_uring);
+    bool coarse = event == UPUMP_TYPE_TIMER_COARSE;
+    if (coarse)
+        event = UPUMP_TYPE_TIMER;
+
+    switch (event) {
+        case UPUMP_TYPE_IDLER:
+            break;
+        case UPUMP_TYPE_TIMER:
+            upump_uring->timer.after = va_arg(args, uint64_t);
+            upump_uring->timer.repeat = va_arg(args, uint64_t);
+            break;
+        case UPUMP_TYPE_FD_READ:
+        case UPUMP_TYPE_FD_WRITE:
+            upump_uring->fd = va_arg(args, int);
+            break;
+        case UPUMP_TYPE_SIGNAL: {
+            upump_uring->signal.signal = va_arg(args, int);
+            sigset_t mask;
+            sigemptyset(&mask);
+            sigaddset(&mask, upump_uring->signal.signal);
+            upump_uring->signal.fd = signalfd(-1, &mask,
+                                              SFD_NONBLOCK | SFD_CLOEXEC);
+            if (unlikely(upump_uring->signal.fd == -1)) {
+                upool_free(&uring_mgr->common_mgr.upump_pool, upump_uring);
+                return NULL;
+            }
+            break;
+        }
+        case UPUMP_URING_TYPE_FD_IO:
+            upump_uring->io.fd = va_arg(args, int);
+            upump_uring->io.result = 0;
+            break;
+        default:
+            upool_free(&uring_mgr->common_mgr.upump_pool, upump_uring);
+            return NULL;
+    }
+
+    if (unlikely(!upump_uring_mgr_alloc_slot(uring_mgr, upump_uring))) {
+        if (event == UPUMP_TYPE_SIGNAL)
+            close(upump_uring->signal.fd);
+        upool_free(&uring_mgr->common_mgr.upump_pool, upump_uring);
+        return NULL;
+    }
+
+    upump_uring->event = event;
+    upump_uring->running = false;
+    upump_uring->armed = false;
+    upump_uring->counted = false;
+    upump_uring->completed = false;
+    uchain_init(&upump_uring->uchain);
+
+    upump_common_init(upump);
+    if (coarse)
+        upump_common_set_timer_coarse(upump, upump_uring->timer.after,
+                                      upump_uring->timer.repeat);
+    else if (event == UPUMP_TYPE_TIMER)
+        upump_common_set_timer(upump, upump_uring->timer.after,
+                               upump_uring->timer.repeat);
+
+    return upump;
+}
+
+/** @This starts a pump.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ */
+static void upump_uring_real_start(struct upump *upump, bool status)
+{
+    struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+    if (upump_uring->running)
+        return;
+    upump_uring->running = true;
+
+    switch (upump_uring->event) {
+        case UPUMP_TYPE_IDLER:
+            ulist_add(&uring_mgr->idlers, &upump_uring->uchain);
+            if (status)
+                uring_mgr->active++;
+            break;
+        case UPUMP_TYPE_SIGNAL: {
+            sigset_t mask;
+            sigemptyset(&mask);
+            sigaddset(&mask, upump_uring->signal.signal);
+            sigprocmask(SIG_BLOCK, &mask, NULL);
+            upump_uring_rearm(upump_uring);
+            break;
+        }
+        case UPUMP_TYPE_TIMER:
+            upump_uring_arm_timer(upump_uring, upump_uring->timer.after);
+            break;
+        case UPUMP_URING_TYPE_FD_IO:
+            if (upump_uring->completed) {
+                upump_uring->completed = false;
+                ulist_add(&uring_mgr->ready, &upump_uring->uchain);
+            }
+            break;
+        default:
+            upump_uring_rearm(upump_uring);
+            break;
+    }
+}
+
+/** @This stops a pump.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ */
+static void upump_uring_real_stop(struct upump *upump, bool status)
+{
+    struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+    if (!upump_uring->running)
+        return;
+    upump_uring->running = false;
+
+    switch (upump_uring->event) {
+        case UPUMP_TYPE_IDLER:
+            ulist_delete(&upump_uring->uchain);
+            if (status)
+                uring_mgr->active--;
+            break;
+        case UPUMP_URING_TYPE_FD_IO:
+            /* the I/O in flight is not cancelled, its completion will be
+             * reported when the pump is restarted */
+            if (ulist_is_in(&upump_uring->uchain)) {
+                ulist_delete(&upump_uring->uchain);
+                upump_uring->completed = true;
+            }
+            break;
+        default:
+            upump_uring_disarm(upump_uring);
+            break;
+    }
+}
+
+/** @internal @This submits an asynchronous I/O.
+ *
+ * @param upump description structure of the pump
+ * @param write true for a write
+ * @param buffer buffer to read or write
+ * @param size size of the buffer
+ * @param offset offset in the file, or UINT64_MAX for the current position
+ * @param buf_index index of the registered buffer, or -1
+ * @return an error code
+ */
+static int upump_uring_submit_io(struct upump *upump, bool write,
+                                 const void *buffer, size_t size,
+                                 uint64_t offset, int buf_index)
+{
+    struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+    if (unlikely(upump_uring->event != UPUMP_URING_TYPE_FD_IO ||
+                 upump_uring->armed || size > UINT32_MAX))
+        return UBASE_ERR_INVALID;
+
+    uint8_t opcode;
+    if (buf_index >= 0)
+        opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+    else
+        opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+
+    struct io_uring_sqe *sqe = upump_uring_arm(upump_uring, opcode);
+    if (unlikely(sqe == NULL))
+        return UBASE_ERR_BUSY;
+    /* an I/O keeps the loop alive whatever the state of the pump */
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+    if (!upump_uring->counted) {
+        upump_uring->counted = true;
+        uring_mgr->active++;
+    }
+    sqe->fd = upump_uring->io.fd;
+    sqe->addr = (uintptr_t)buffer;
+    sqe->len = size;
+    sqe->off = offset;
+    if (buf_index >= 0)
+        sqe->buf_index = buf_index;
+    upump_uring_mgr_queue_sqe(uring_mgr);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This handles a completion.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @param cqe completion entry
+ */
+static void upump_uring_mgr_complete(struct upump_uring_mgr *uring_mgr,
+                                     const struct io_uring_cqe *cqe)
+{
+    if (cqe->user_data == UPUMP_URING_IGNORE)
+        return;
+
+    uint32_t index = cqe->user_data >> 32;
+    uint32_t gen = cqe->user_data & UINT32_MAX;
+    if (unlikely(index >= uring_mgr->nb_slots))
+        return;
+    struct upump_uring_slot *slot = &uring_mgr->slots[index];
+    slot->pending--;
+    struct upump_uring *upump_uring = slot->upump_uring;
+    if (upump_uring == NULL) {
+        if (!slot->pending)
+            upump_uring_mgr_release_slot(uring_mgr, index);
+        return;
+    }
+    if (gen != slot->gen || !upump_uring->armed)
+        return;
+
+    upump_uring->armed = false;
+    if (upump_uring->counted) {
+        upump_uring->counted = false;
+        uring_mgr->active--;
+    }
+
+    struct upump *upump = upump_uring_to_upump(upump_uring);
+    switch (upump_uring->event) {
+        case UPUMP_TYPE_FD_READ:
+        case UPUMP_TYPE_FD_WRITE:
+            upump_common_dispatch(upump);
+            break;
+        case UPUMP_TYPE_SIGNAL: {
+            struct signalfd_siginfo siginfo;
+            while (read(upump_uring->signal.fd, &siginfo,
+                        sizeof(siginfo)) == sizeof(siginfo))
+                upump_common_dispatch(upump);
+            break;
+        }
+        case UPUMP_TYPE_TIMER:
+            /* like other event loops, a one-shot timer stops by itself */
+            if (!upump_uring->timer.repeat)
+                upump_uring->running = false;
+            upump_common_dispatch(upump);
+            break;
+        case UPUMP_URING_TYPE_FD_IO:
+            upump_uring->io.result = cqe->res;
+            if (upump_uring->running)
+                upump_common_dispatch(upump);
+            else
+                upump_uring->completed = true;
+            return;
+        default:
+            return;
+    }
+
+    /* the pump may have been freed or restarted by the callback */
+    slot = &uring_mgr->slots[index];
+    if (slot->upump_uring == upump_uring && upump_uring->running &&
+        !upump_uring->armed)
+        upump_uring_rearm(upump_uring);
+}
+
+/** @internal @This reaps all available completions.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @return number of completions
+ */
+static unsigned int upump_uring_mgr_reap(struct upump_uring_mgr *uring_mgr)
+{
+    unsigned int nb = 0;
+    /* callbacks may append new deferred completions */
+    for (unsigned int i = 0; i < uring_mgr->nb_deferred; i++, nb++) {
+        struct io_uring_cqe cqe = uring_mgr->deferred[i];
+        upump_uring_mgr_complete(uring_mgr, &cqe);
+    }
+    uring_mgr->nb_deferred = 0;
+
+    unsigned head = *uring_mgr->cq_head;
+    for ( ; ; ) {
+        unsigned tail = __atomic_load_n(uring_mgr->cq_tail, __ATOMIC_ACQUIRE);
+        if (head == tail)
+            break;
+        struct io_uring_cqe cqe = uring_mgr->cqes[head & uring_mgr->cq_mask];
+        head++;
+        /* release the entry before the callback, which may submit */
+        __atomic_store_n(uring_mgr->cq_head, head, __ATOMIC_RELEASE);
+        upump_uring_mgr_complete(uring_mgr, &cqe);
+        nb++;
+    }
+    return nb;
+}
+
+/** @internal @This dispatches I/O pumps whose completion happened while
+ * they were stopped.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @return number of dispatched pumps
+ */
+static unsigned int upump_uring_mgr_dispatch_ready(
+        struct upump_uring_mgr *uring_mgr)
+{
+    unsigned int nb = 0;
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&uring_mgr->ready)) != NULL) {
+        uchain_init(uchain);
+        struct upump_uring *upump_uring = upump_uring_from_uchain(uchain);
+        upump_common_dispatch(upump_uring_to_upump(upump_uring));
+        nb++;
+    }
+    return nb;
+}
+
+/** @internal @This dispatches idlers.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ */
+static void upump_uring_mgr_dispatch_idle(struct upump_uring_mgr *uring_mgr)
+{
+    /* give each idler one turn, even if the list changes meanwhile */
+    struct uchain *uchain;
+    unsigned int nb = 0;
+    ulist_foreach (&uring_mgr->idlers, uchain)
+        nb++;
+    while (nb-- && (uchain = ulist_pop(&uring_mgr->idlers)) != NULL) {
+        ulist_add(&uring_mgr->idlers, uchain);
+        struct upump_uring *upump_uring = upump_uring_from_uchain(uchain);
+        upump_common_dispatch(upump_uring_to_upump(upump_uring));
+    }
+}
+
+/** @internal @This waits until all operations in flight of a slot are
+ * completed, deferring the completions of other slots.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @param index index of the slot
+ */
+static void upump_uring_mgr_drain_slot(struct upump_uring_mgr *uring_mgr,
+                                       uint32_t index)
+{
+    while (uring_mgr->slots[index].pending) {
+        if (unlikely(!upump_uring_mgr_enter(uring_mgr, true)))
+            return;
+
+        unsigned head = *uring_mgr->cq_head;
+        unsigned tail = __atomic_load_n(uring_mgr->cq_tail, __ATOMIC_ACQUIRE);
+        for ( ; head != tail; head++) {
+            struct io_uring_cqe *cqe =
+                &uring_mgr->cqes[head & uring_mgr->cq_mask];
+            if (cqe->user_data != UPUMP_URING_IGNORE &&
+                cqe->user_data >> 32 == index) {
+                uring_mgr->slots[index].pending--;
+                continue;
+            }
+
+            if (uring_mgr->nb_deferred == uring_mgr->max_deferred) {
+                unsigned int max = uring_mgr->max_deferred * 2 +
+                                   uring_mgr->cq_mask + 1;
+                struct io_uring_cqe *deferred = realloc(uring_mgr->deferred,
+                        max * sizeof(struct io_uring_cqe));
+                if (unlikely(deferred == NULL))
+                    break;
+                uring_mgr->deferred = deferred;
+                uring_mgr->max_deferred = max;
+            }
+            uring_mgr->deferred[uring_mgr->nb_deferred++] = *cqe;
+        }
+        __atomic_store_n(uring_mgr->cq_head, head, __ATOMIC_RELEASE);
+    }
+}
+
+/** @This released the memory space previously used by a pump.
+ * Please note that the pump must be stopped before.
+ *
+ * @param upump description structure of the pump
+ */
+static void upump_uring_free(struct upump *upump)
+{
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+    struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+    upump_stop(upump);
+    if (upump_uring->event == UPUMP_URING_TYPE_FD_IO) {
+        if (ulist_is_in(&upump_uring->uchain))
+            ulist_delete(&upump_uring->uchain);
+        upump_uring_disarm(upump_uring);
+    }
+    if (upump_uring->counted) {
+        uring_mgr->active--;
+        upump_uring->counted = false;
+    }
+    /* make sure the kernel consumed the entries pointing to this pump */
+    if (uring_mgr->to_submit)
+        upump_uring_mgr_enter(uring_mgr, false);
+    /* the buffer of an I/O may be released after upump_free() */
+    if (upump_uring->event == UPUMP_URING_TYPE_FD_IO)
+        upump_uring_mgr_drain_slot(uring_mgr, upump_uring->slot);
+    if (upump_uring->event == UPUMP_TYPE_SIGNAL)
+        close(upump_uring->signal.fd);
+    upump_uring_mgr_release_slot(uring_mgr, upump_uring->slot);
+    upump_common_clean(upump);
+    upool_free(&uring_mgr->common_mgr.upump_pool, upump_uring);
+}
+
+/** @internal @This allocates the data structure.
+ *
+ * @param upool pointer to upool
+ * @return pointer to upump_uring or NULL in case of allocation error
+ */
+static void *upump_uring_alloc_inner(struct upool *upool)
+{
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_pool(upool);
+    struct upump_uring *upump_uring = malloc(sizeof(struct upump_uring));
+    if (unlikely(upump_uring == NULL))
+        return NULL;
+    struct upump *upump = upump_uring_to_upump(upump_uring);
+    upump->mgr = upump_common_mgr_to_upump_mgr(common_mgr);
+    return upump_uring;
+}
+
+/** @internal @This frees a upump_uring.
+ *
+ * @param upool pointer to upool
+ * @param upump_uring pointer to a upump_uring structure to free
+ */
+static void upump_uring_free_inner(struct upool *upool, void *upump_uring)
+{
+    free(upump_uring);
+}
+
+/** @This processes control commands on a upump_uring.
+ *
+ * @param upump description structure of the pump
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upump_uring_control(struct upump *upump, int command, va_list args)
+{
+    switch (command) {
+        case UPUMP_START:
+            upump_common_start(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_STOP:
+            upump_common_stop(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_FREE:
+            upump_uring_free(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_GET_STATUS: {
+            int *status_p = va_arg(args, int *);
+            upump_common_get_status(upump, status_p);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_SET_STATUS: {
+            int status = va_arg(args, int);
+            upump_common_set_status(upump, status);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_ALLOC_BLOCKER: {
+            struct upump_blocker **p = va_arg(args, struct upump_blocker **);
+            *p = upump_common_blocker_alloc(upump);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_FREE_BLOCKER: {
+            struct upump_blocker *blocker =
+                va_arg(args, struct upump_blocker *);
+            upump_common_blocker_free(blocker);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_GET_PROFILE: {
+            struct upump_profile *profile =
+                va_arg(args, struct upump_profile *);
+            return upump_common_get_profile(upump, profile);
+        }
+
+        case UPUMP_URING_SUBMIT_READ:
+        case UPUMP_URING_SUBMIT_WRITE: {
+            UBASE_SIGNATURE_CHECK(args, UPUMP_URING_SIGNATURE)
+            const void *buffer = va_arg(args, const void *);
+            size_t size = va_arg(args, size_t);
+            uint64_t offset = va_arg(args, uint64_t);
+            int buf_index = va_arg(args, int);
+            return upump_uring_submit_io(upump,
+                    command == UPUMP_URING_SUBMIT_WRITE, buffer, size,
+                    offset, buf_index);
+        }
+        case UPUMP_URING_GET_RESULT: {
+            UBASE_SIGNATURE_CHECK(args, UPUMP_URING_SIGNATURE)
+            ssize_t *result_p = va_arg(args, ssize_t *);
+            struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+            if (unlikely(upump_uring->event != UPUMP_URING_TYPE_FD_IO))
+                return UBASE_ERR_INVALID;
+            *result_p = upump_uring->io.result;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This runs an event loop.
+ *
+ * @param mgr pointer to a upump_mgr structure
+ * @param mutex mutual exclusion primitives to access the event loop
+ * @return an error code
+ */
+static int upump_uring_mgr_run(struct upump_mgr *mgr, struct umutex *mutex)
+{
+    struct upump_uring_mgr *uring_mgr = upump_uring_mgr_from_upump_mgr(mgr);
+    int err = UBASE_ERR_NONE;
+
+    if (mutex != NULL)
+        umutex_lock(mutex);
+
+    for ( ; ; ) {
+        bool virtual_active;
+        bool virtual_pending = upump_common_mgr_virtual_pending(mgr,
+                                                                &virtual_active);
+        if (!uring_mgr->active && ulist_empty(&uring_mgr->ready) &&
+            !uring_mgr->nb_deferred && !virtual_active)
+            break;
+
+        bool wait = ulist_empty(&uring_mgr->idlers) &&
+                    ulist_empty(&uring_mgr->ready) && !uring_mgr->nb_deferred &&
+                    !virtual_pending;
+        if (wait)
+            upump_common_mgr_sleep(mgr);
+        if (wait && mutex != NULL)
+            umutex_unlock(mutex);
+        bool ret = upump_uring_mgr_enter(uring_mgr, wait);
+        if (wait && mutex != NULL)
+            umutex_lock(mutex);
+        if (wait)
+            upump_common_mgr_wake(mgr);
+        if (unlikely(!ret)) {
+            err = UBASE_ERR_EXTERNAL;
+            break;
+        }
+
+        /* like other event loops, idlers only run when no event is
+         * pending */
+        if (!upump_uring_mgr_reap(uring_mgr) &&
+            !upump_uring_mgr_dispatch_ready(uring_mgr) &&
+            !uring_mgr->to_submit) {
+            /* on virtual time, the next timer is due as soon as the loop
+             * would otherwise sleep */
+            if (!ulist_empty(&uring_mgr->idlers))
+                upump_uring_mgr_dispatch_idle(uring_mgr);
+            else
+                upump_common_mgr_dispatch_virtual(mgr);
+        }
+    }
+
+    if (mutex != NULL)
+        umutex_unlock(mutex);
+    return err;
+}
+
+/** @internal @This registers fixed buffers.
+ *
+ * @param mgr pointer to a upump_mgr structure
+ * @param iovecs array of buffers
+ * @param nb number of buffers
+ * @return an error code
+ */
+static int upump_uring_mgr_register_buffers_real(struct upump_mgr *mgr,
+        const struct iovec *iovecs, unsigned int nb)
+{
+    struct upump_uring_mgr *uring_mgr = upump_uring_mgr_from_upump_mgr(mgr);
+    if (syscall(__NR_io_uring_register, uring_mgr->fd,
+                IORING_REGISTER_BUFFERS, iovecs, nb) < 0)
+        return UBASE_ERR_EXTERNAL;
+    return UBASE_ERR_NONE;
+}
+
+/** @This processes control commands on a upump_uring_mgr.
+ *
+ * @param mgr pointer to a upump_mgr structure
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upump_uring_mgr_control(struct upump_mgr *mgr,
+                                   int command, va_list args)
+{
+    switch (command) {
+        case UPUMP_MGR_RUN: {
+            struct umutex *mutex = va_arg(args, struct umutex *);
+            return upump_uring_mgr_run(mgr, mutex);
+        }
+        case UPUMP_MGR_VACUUM:
+            upump_common_mgr_vacuum(mgr);
+            return UBASE_ERR_NONE;
+        case UPUMP_MGR_SET_PROFILING: {
+            struct uclock *uclock = va_arg(args, struct uclock *);
+            upump_common_mgr_set_profiling(mgr, uclock);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_MGR_GET_PROFILE: {
+            struct upump_mgr_profile *profile =
+                va_arg(args, struct upump_mgr_profile *);
+            return upump_common_mgr_get_profile(mgr, profile);
+        }
+        case UPUMP_MGR_SET_VIRTUAL_CLOCK: {
+            struct uclock *uclock = va_arg(args, struct uclock *);
+            return upump_common_mgr_set_virtual_clock(mgr, uclock);
+        }
+
+        case UPUMP_URING_MGR_REGISTER_BUFFERS: {
+            UBASE_SIGNATURE_CHECK(args, UPUMP_URING_SIGNATURE)
+            const struct iovec *iovecs = va_arg(args, const struct iovec *);
+            unsigned int nb = va_arg(args, unsigned int);
+            return upump_uring_mgr_register_buffers_real(mgr, iovecs, nb);
+        }
+        case UPUMP_URING_MGR_UNREGISTER_BUFFERS: {
+            UBASE_SIGNATURE_CHECK(args, UPUMP_URING_SIGNATURE)
+            struct upump_uring_mgr *uring_mgr =
+                upump_uring_mgr_from_upump_mgr(mgr);
+            if (syscall(__NR_io_uring_register, uring_mgr->fd,
+                        IORING_UNREGISTER_BUFFERS, NULL, 0) < 0)
+                return UBASE_ERR_EXTERNAL;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This unmaps the rings.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ */
+static void upump_uring_mgr_unmap(struct upump_uring_mgr *uring_mgr)
+{
+    if (uring_mgr->sqes != MAP_FAILED)
+        munmap(uring_mgr->sqes, uring_mgr->sqes_size);
+    if (uring_mgr->cq_ring != MAP_FAILED &&
+        uring_mgr->cq_ring != uring_mgr->sq_ring)
+        munmap(uring_mgr->cq_ring, uring_mgr->cq_ring_size);
+    if (uring_mgr->sq_ring != MAP_FAILED)
+        munmap(uring_mgr->sq_ring, uring_mgr->sq_ring_size);
+    close(uring_mgr->fd);
+}
+
+/** @This frees a upump manager.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void upump_uring_mgr_free(struct urefcount *urefcount)
+{
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_urefcount(urefcount);
+    upump_common_mgr_clean(upump_uring_mgr_to_upump_mgr(uring_mgr));
+    /* closing the ring cancels all operations in flight */
+    upump_uring_mgr_unmap(uring_mgr);
+    free(uring_mgr->deferred);
+    free(uring_mgr->slots);
+    urefcount_clean(urefcount);
+    free(uring_mgr);
+}
+
+/** @internal @This sets up the ring.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @return false in case of error
+ */
+static bool upump_uring_mgr_setup(struct upump_uring_mgr *uring_mgr)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    uring_mgr->fd = syscall(__NR_io_uring_setup, UPUMP_URING_ENTRIES, &params);
+    if (uring_mgr->fd < 0)
+        return false;
+
+    uring_mgr->sq_ring = uring_mgr->cq_ring = uring_mgr->sqes = MAP_FAILED;
+    uring_mgr->sq_ring_size =
+        params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    uring_mgr->cq_ring_size =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (uring_mgr->cq_ring_size > uring_mgr->sq_ring_size)
+            uring_mgr->sq_ring_size = uring_mgr->cq_ring_size;
+        uring_mgr->cq_ring_size = uring_mgr->sq_ring_size;
+    }
+
+    uring_mgr->sq_ring = mmap(NULL, uring_mgr->sq_ring_size,
+                              PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, uring_mgr->fd,
+                              IORING_OFF_SQ_RING);
+    if (uring_mgr->sq_ring == MAP_FAILED)
+        goto upump_uring_mgr_setup_err;
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        uring_mgr->cq_ring = uring_mgr->sq_ring;
+    else {
+        uring_mgr->cq_ring = mmap(NULL, uring_mgr->cq_ring_size,
+                                  PROT_READ | PROT_WRITE,
+                                  MAP_SHARED | MAP_POPULATE, uring_mgr->fd,
+                                  IORING_OFF_CQ_RING);
+        if (uring_mgr->cq_ring == MAP_FAILED)
+            goto upump_uring_mgr_setup_err;
+    }
+    uring_mgr->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    uring_mgr->sqes = mmap(NULL, uring_mgr->sqes_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, uring_mgr->fd,
+                           IORING_OFF_SQES);
+    if (uring_mgr->sqes == MAP_FAILED)
+        goto upump_uring_mgr_setup_err;
+
+    uint8_t *sq = uring_mgr->sq_ring;
+    uring_mgr->sq_head = (unsigned *)(sq + params.sq_off.head);
+    uring_mgr->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    uring_mgr->sq_mask = *(unsigned *)(sq + params.sq_off.ring_mask);
+    uring_mgr->sq_array = (unsigned *)(sq + params.sq_off.array);
+    uint8_t *cq = uring_mgr->cq_ring;
+    uring_mgr->cq_head = (unsigned *)(cq + params.cq_off.head);
+    uring_mgr->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    uring_mgr->cq_mask = *(unsigned *)(cq + params.cq_off.ring_mask);
+    uring_mgr->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    uring_mgr->to_submit = 0;
+    return true;
+
+upump_uring_mgr_setup_err:
+    upump_uring_mgr_unmap(uring_mgr);
+    return false;
+}
+
+/** @This allocates and initializes a upump_mgr structure bound to a new
+ * io_uring instance.
+ *
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @return pointer to the wrapped upump_mgr structure, or NULL if io_uring is
+ * not supported by the kernel
+ */
+struct upump_mgr *upump_uring_mgr_alloc(uint16_t upump_pool_depth,
+                                        uint16_t upump_blocker_pool_depth)
+{
+    struct upump_uring_mgr *uring_mgr =
+        malloc(sizeof(struct upump_uring_mgr) +
+               upump_common_mgr_sizeof(upump_pool_depth,
+                                       upump_blocker_pool_depth));
+    if (unlikely(uring_mgr == NULL))
+        return NULL;
+
+    uring_mgr->slots = malloc(UPUMP_URING_SLOTS *
+                              sizeof(struct upump_uring_slot));
+    if (unlikely(uring_mgr->slots == NULL)) {
+        free(uring_mgr);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < UPUMP_URING_SLOTS; i++) {
+        uring_mgr->slots[i].upump_uring = NULL;
+        uring_mgr->slots[i].gen = 0;
+        uring_mgr->slots[i].pending = 0;
+        uring_mgr->slots[i].next_free =
+            i + 1 < UPUMP_URING_SLOTS ? i + 1 : UINT32_MAX;
+    }
+    uring_mgr->nb_slots = UPUMP_URING_SLOTS;
+    uring_mgr->free_slot = 0;
+    uring_mgr->deferred = NULL;
+    uring_mgr->nb_deferred = 0;
+    uring_mgr->max_deferred = 0;
+
+    if (unlikely(!upump_uring_mgr_setup(uring_mgr))) {
+        free(uring_mgr->slots);
+        free(uring_mgr);
+        return NULL;
+    }
+
+    ulist_init(&uring_mgr->idlers);
+    ulist_init(&uring_mgr->ready);
+    uring_mgr->active = 0;
+
+    struct upump_mgr *mgr = upump_uring_mgr_to_upump_mgr(uring_mgr);
+    mgr->signature = UPUMP_URING_SIGNATURE;
+    urefcount_init(upump_uring_mgr_to_urefcount(uring_mgr),
+                   upump_uring_mgr_free);
+    uring_mgr->common_mgr.mgr.refcount =
+        upump_uring_mgr_to_urefcount(uring_mgr);
+    uring_mgr->common_mgr.mgr.upump_alloc = upump_uring_alloc;
+    uring_mgr->common_mgr.mgr.upump_control = upump_uring_control;
+    uring_mgr->common_mgr.mgr.upump_mgr_control = upump_uring_mgr_control;
+
+    upump_common_mgr_init(mgr, upump_pool_depth, upump_blocker_pool_depth,
+                          uring_mgr->upool_extra,
+                          upump_uring_real_start, upump_uring_real_stop,
+                          upump_uring_alloc_inner, upump_uring_free_inner);
+    return mgr;
+}
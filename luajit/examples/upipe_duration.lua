@@ -37,12 +37,16 @@ local count_mgr = upipe {
         pipe.props.duration = 0
     end,
 
-    input = function (pipe, ref, pump)
-        local duration = ref:clock_get_duration()
-        if duration then
-            pipe.props.duration = pipe.props.duration + duration
+    input_batch = function (pipe, refs, n, pump)
+        local total = pipe.props.duration
+        for i = 0, n - 1 do
+            local duration = refs[i]:clock_get_duration()
+            if duration then
+                total = total + duration
+            end
+            refs[i]:free()
         end
-        ref:free()
+        pipe.props.duration = total
     end,
 
     control = {
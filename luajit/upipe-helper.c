@@ -14,6 +14,12 @@
 #include <upipe/upipe_helper_uref_stream.h>
 #include <upipe/upipe_helper_flow_def.h>
 #include <upipe/upipe_helper_upump.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_block.h>
+#include <upipe/upump.h>
+
+#include <stdlib.h>
+#include <string.h>
 
 struct upipe_helper_mgr {
     struct upipe_mgr mgr;
@@ -34,6 +40,10 @@ struct upipe_helper_mgr {
 
     // uref_stream
     void (*stream_append_cb)(struct upipe *);
+
+    // batch
+    void (*input_batch)(struct upipe *, struct uref **, unsigned int,
+                        struct upump **);
 };
 
 struct upipe_helper {
@@ -95,6 +105,23 @@ struct upipe_helper {
 
     // upump
     struct upump *upump;
+
+    // batch
+    struct uref **batch;
+    unsigned int batch_count;
+    unsigned int batch_max;
+    struct upump *batch_idler;
+};
+
+/** @This contains the dates of a uref, UINT64_MAX when unset. */
+struct upipe_helper_dates {
+    uint64_t pts_sys;
+    uint64_t pts_prog;
+    uint64_t pts_orig;
+    uint64_t dts_sys;
+    uint64_t dts_prog;
+    uint64_t dts_orig;
+    uint64_t duration;
 };
 
 static struct upipe_helper_mgr *upipe_helper_mgr(struct upipe *upipe)
@@ -190,3 +217,176 @@ UPIPE_HELPER_UREF_STREAM(upipe_helper, next_uref, next_uref_size, stream_urefs,
                          append_cb);
 UPIPE_HELPER_FLOW_DEF(upipe_helper, flow_def_input, flow_def_attr);
 UPIPE_HELPER_UPUMP(upipe_helper, upump, upump_mgr);
+
+/** @This initializes the batched input of a helper pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_max maximum number of urefs per batch, 0 to disable
+ * @return an error code
+ */
+int upipe_helper_init_batch(struct upipe *upipe, unsigned int batch_max)
+{
+    struct upipe_helper *h = upipe_helper_from_upipe(upipe);
+
+    h->batch = NULL;
+    h->batch_count = 0;
+    h->batch_max = batch_max;
+    h->batch_idler = NULL;
+    if (!batch_max)
+        return UBASE_ERR_NONE;
+
+    h->batch = malloc(sizeof (struct uref *) * batch_max);
+    if (unlikely(h->batch == NULL)) {
+        h->batch_max = 0;
+        return UBASE_ERR_ALLOC;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @This delivers the pending urefs to the batch callback.
+ *
+ * The batch is copied out before calling the callback, so that urefs
+ * input from within the callback start a new batch.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffers
+ */
+void upipe_helper_batch_flush(struct upipe *upipe, struct upump **upump_p)
+{
+    struct upipe_helper_mgr *mgr = upipe_helper_mgr(upipe);
+    struct upipe_helper *h = upipe_helper_from_upipe(upipe);
+    unsigned int count = h->batch_count;
+
+    if (h->batch_idler != NULL) {
+        upump_stop(h->batch_idler);
+        upump_free(h->batch_idler);
+        h->batch_idler = NULL;
+    }
+    if (!count)
+        return;
+
+    struct uref *urefs[count];
+    memcpy(urefs, h->batch, sizeof (struct uref *) * count);
+    h->batch_count = 0;
+
+    if (mgr->input_batch == NULL) {
+        for (unsigned int i = 0; i < count; i++)
+            uref_free(urefs[i]);
+        return;
+    }
+
+    upipe_use(upipe);
+    mgr->input_batch(upipe, urefs, count, upump_p);
+    upipe_release(upipe);
+}
+
+/** @internal @This is called when the event loop is idle to deliver
+ * an incomplete batch.
+ *
+ * @param upump description structure of the idler
+ */
+void upipe_helper_batch_idler(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    upipe_helper_batch_flush(upipe, NULL);
+}
+
+/** @This queues an incoming uref into the current batch, which is
+ * delivered when full or when the event loop becomes idle.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+void upipe_helper_batch_input(struct upipe *upipe, struct uref *uref,
+                              struct upump **upump_p)
+{
+    struct upipe_helper *h = upipe_helper_from_upipe(upipe);
+
+    if (unlikely(!h->batch_max)) {
+        upipe_warn(upipe, "no batch allocated, dropping uref");
+        uref_free(uref);
+        return;
+    }
+
+    h->batch[h->batch_count++] = uref;
+    if (h->batch_count >= h->batch_max) {
+        upipe_helper_batch_flush(upipe, upump_p);
+        return;
+    }
+    if (h->batch_idler != NULL)
+        return;
+
+    upipe_helper_check_upump_mgr(upipe);
+    if (h->upump_mgr != NULL)
+        h->batch_idler = upump_alloc_idler(h->upump_mgr,
+                                           upipe_helper_batch_idler,
+                                           upipe, upipe->refcount);
+    if (h->batch_idler == NULL) {
+        upipe_helper_batch_flush(upipe, upump_p);
+        return;
+    }
+    upump_start(h->batch_idler);
+}
+
+/** @This releases the pending urefs and the idler of the batched input.
+ *
+ * @param upipe description structure of the pipe
+ */
+void upipe_helper_clean_batch(struct upipe *upipe)
+{
+    struct upipe_helper *h = upipe_helper_from_upipe(upipe);
+
+    if (h->batch_idler != NULL) {
+        upump_stop(h->batch_idler);
+        upump_free(h->batch_idler);
+        h->batch_idler = NULL;
+    }
+    for (unsigned int i = 0; i < h->batch_count; i++)
+        uref_free(h->batch[i]);
+    h->batch_count = 0;
+    free(h->batch);
+    h->batch = NULL;
+}
+
+/** @This reads all the dates of a uref at once.
+ *
+ * @param uref uref structure
+ * @param dates filled in with the dates, UINT64_MAX when unset
+ */
+void upipe_helper_uref_dates(struct uref *uref,
+                             struct upipe_helper_dates *dates)
+{
+    if (!ubase_check(uref_clock_get_pts_sys(uref, &dates->pts_sys)))
+        dates->pts_sys = UINT64_MAX;
+    if (!ubase_check(uref_clock_get_pts_prog(uref, &dates->pts_prog)))
+        dates->pts_prog = UINT64_MAX;
+    if (!ubase_check(uref_clock_get_pts_orig(uref, &dates->pts_orig)))
+        dates->pts_orig = UINT64_MAX;
+    if (!ubase_check(uref_clock_get_dts_sys(uref, &dates->dts_sys)))
+        dates->dts_sys = UINT64_MAX;
+    if (!ubase_check(uref_clock_get_dts_prog(uref, &dates->dts_prog)))
+        dates->dts_prog = UINT64_MAX;
+    if (!ubase_check(uref_clock_get_dts_orig(uref, &dates->dts_orig)))
+        dates->dts_orig = UINT64_MAX;
+    if (!ubase_check(uref_clock_get_duration(uref, &dates->duration)))
+        dates->duration = UINT64_MAX;
+}
+
+/** @This maps the block data of a uref for reading, without copying.
+ * The mapping must be released with uref_block_unmap.
+ *
+ * @param uref uref structure
+ * @param offset offset of the data to map
+ * @param size_p size of the data to map (-1 for end of buffer), filled in
+ * with the mapped size
+ * @return pointer to the mapped data, or NULL
+ */
+const uint8_t *upipe_helper_uref_block_read(struct uref *uref, int offset,
+                                            int *size_p)
+{
+    const uint8_t *buffer;
+    if (!ubase_check(uref_block_read(uref, offset, size_p, &buffer)))
+        return NULL;
+    return buffer;
+}
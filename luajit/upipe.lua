@@ -393,6 +393,7 @@ local function upipe_helper_alloc(cb)
             pipe:helper_init_uref_stream()
             pipe:helper_init_flow_def()
             pipe:helper_init_upump()
+            pipe:helper_init_batch(batch and (cb.batch_size or 64) or 0)
             pipe:throw_ready()
             pipe.props.helper = h_pipe
             if cb.init then cb.init(pipe, args) end
@@ -402,15 +403,34 @@ local function upipe_helper_alloc(cb)
 
 --     mgr.upipe_input = cb.input
 
-    mgr.upipe_input = function (pipe, ref, pump_p)
-        local errh = function (msg)
-            io.stderr:write(debug.traceback(msg, 2), "\n")
+    local errh = function (msg)
+        io.stderr:write(debug.traceback(msg, 2), "\n")
+    end
+
+    -- batched input: urefs are queued in C and handed over as an array,
+    -- crossing into Lua once per batch instead of once per uref
+    local batch = cb.input_batch ~= nil
+    if batch then
+        h_mgr.input_batch = function (pipe, refs, n, pump_p)
+            xpcall(cb.input_batch, errh, pipe, refs, n, pump_p)
+        end
+        mgr.upipe_input = C.upipe_helper_batch_input
+    else
+        h_mgr.input_batch = nil
+        mgr.upipe_input = function (pipe, ref, pump_p)
+            xpcall(cb.input, errh, pipe, ref, pump_p)
         end
-        xpcall(cb.input, errh, pipe, ref, pump_p)
     end
 
     if type(cb.control) == "function" then
-        mgr.upipe_control = cb.control
+        if batch then
+            mgr.upipe_control = function (pipe, cmd, args)
+                C.upipe_helper_batch_flush(pipe, nil)
+                return cb.control(pipe, cmd, args)
+            end
+        else
+            mgr.upipe_control = cb.control
+        end
     else
         local control = { }
 
@@ -436,6 +456,8 @@ local function upipe_helper_alloc(cb)
         end
 
         mgr.upipe_control = function (pipe, cmd, args)
+            -- pending urefs go out before the command is processed
+            if batch then C.upipe_helper_batch_flush(pipe, nil) end
             local f = control[cmd] or function () return "unhandled" end
             local ret = ubase_err(f(pipe, control_args(cmd, args)))
             if ret == C.UBASE_ERR_UNHANDLED and cb.bin_input then
@@ -455,6 +477,7 @@ local function upipe_helper_alloc(cb)
         if props[k] and props[k].clean then props[k].clean(pipe) end
         pipe:throw_dead()
         props[k] = nil
+        pipe:helper_clean_batch()
         pipe:helper_clean_upump()
         pipe:helper_clean_flow_def()
         pipe:helper_clean_uref_stream()
@@ -479,7 +502,9 @@ local function upipe_helper_alloc(cb)
         local mgr = h_mgr.mgr
         mgr.upipe_alloc:free()
         mgr.upipe_control:free()
-        if mgr.upipe_input ~= nil then
+        if batch then
+            h_mgr.input_batch:free()
+        elseif mgr.upipe_input ~= nil then
             mgr.upipe_input:free()
         end
         h_mgr.refcount_cb:free()
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <float.h>
+#include <string.h>
+
+#include "checkasm.h"
+#include "lib/upipe-filters/upipe_audio_peak.h"
+
+#define BUF_SIZE 1024
+
+/* the vector variants sum the squares in a different order */
+#define SUM_EPS(sum) ((sum) * 1e-12 + DBL_MIN)
+
+static void randomize_s16(int16_t *buf)
+{
+    for (int i = 0; i < BUF_SIZE; i++)
+        buf[i] = rnd();
+    /* the absolute value of INT16_MIN doesn't fit */
+    buf[rnd() % BUF_SIZE] = INT16_MIN;
+}
+
+static void randomize_s32(int32_t *buf)
+{
+    for (int i = 0; i < BUF_SIZE; i++)
+        buf[i] = rnd();
+    buf[rnd() % BUF_SIZE] = INT32_MIN;
+}
+
+static void randomize_f32(float *buf)
+{
+    for (int i = 0; i < BUF_SIZE; i++)
+        buf[i] = (int32_t)rnd() / (float)INT32_MAX;
+}
+
+void checkasm_check_audio_peak(void)
+{
+    struct {
+        upipe_audio_peak_s16_func s16;
+        upipe_audio_peak_s32_func s32;
+        upipe_audio_peak_f32_func f32;
+    } s = {
+        .s16 = upipe_audio_peak_s16_c,
+        .s32 = upipe_audio_peak_s32_c,
+        .f32 = upipe_audio_peak_f32_c,
+    };
+
+    int cpu_flags = av_get_cpu_flags();
+
+#if ARCH_X86
+    if (cpu_flags & AV_CPU_FLAG_SSE2) {
+        s.s16 = upipe_audio_peak_s16_sse2;
+        s.f32 = upipe_audio_peak_f32_sse2;
+    }
+    if (cpu_flags & AV_CPU_FLAG_AVX2) {
+        s.s16 = upipe_audio_peak_s16_avx2;
+        s.s32 = upipe_audio_peak_s32_avx2;
+        s.f32 = upipe_audio_peak_f32_avx2;
+    }
+#elif ARCH_AARCH64
+    if (cpu_flags & AV_CPU_FLAG_NEON) {
+        s.s16 = upipe_audio_peak_s16_neon;
+        s.s32 = upipe_audio_peak_s32_neon;
+        s.f32 = upipe_audio_peak_f32_neon;
+    }
+#endif
+
+    if (check_func(s.s16, "audio_peak_s16")) {
+        int16_t buf[BUF_SIZE];
+        declare_func(void, const int16_t *buf, size_t samples,
+                     uint32_t *peak_p, uint64_t *sum_p);
+        for (size_t samples = 0; samples <= BUF_SIZE; samples += 1 + samples) {
+            uint32_t peak_ref, peak_new;
+            uint64_t sum_ref, sum_new;
+            randomize_s16(buf);
+            call_ref(buf, samples, &peak_ref, &sum_ref);
+            call_new(buf, samples, &peak_new, &sum_new);
+            if (peak_ref != peak_new || sum_ref != sum_new)
+                fail();
+        }
+        uint32_t peak;
+        uint64_t sum;
+        bench_new_units(BUF_SIZE, "sample", buf, BUF_SIZE, &peak, &sum);
+    }
+    report("audio_peak_s16");
+
+    if (check_func(s.s32, "audio_peak_s32")) {
+        int32_t buf[BUF_SIZE];
+        declare_func(void, const int32_t *buf, size_t samples,
+                     uint32_t *peak_p, double *sum_p);
+        for (size_t samples = 0; samples <= BUF_SIZE; samples += 1 + samples) {
+            uint32_t peak_ref, peak_new;
+            double sum_ref, sum_new;
+            randomize_s32(buf);
+            call_ref(buf, samples, &peak_ref, &sum_ref);
+            call_new(buf, samples, &peak_new, &sum_new);
+            if (peak_ref != peak_new ||
+                !double_near_abs_eps(sum_ref, sum_new, SUM_EPS(sum_ref)))
+                fail();
+        }
+        uint32_t peak;
+        double sum;
+        bench_new_units(BUF_SIZE, "sample", buf, BUF_SIZE, &peak, &sum);
+    }
+    report("audio_peak_s32");
+
+    if (check_func(s.f32, "audio_peak_f32")) {
+        float buf[BUF_SIZE];
+        declare_func(void, const float *buf, size_t samples,
+                     float *peak_p, double *sum_p);
+        for (size_t samples = 0; samples <= BUF_SIZE; samples += 1 + samples) {
+            float peak_ref, peak_new;
+            double sum_ref, sum_new;
+            randomize_f32(buf);
+            call_ref(buf, samples, &peak_ref, &sum_ref);
+            call_new(buf, samples, &peak_new, &sum_new);
+            if (peak_ref != peak_new ||
+                !double_near_abs_eps(sum_ref, sum_new, SUM_EPS(sum_ref)))
+                fail();
+        }
+        float peak;
+        double sum;
+        bench_new_units(BUF_SIZE, "sample", buf, BUF_SIZE, &peak, &sum);
+    }
+    report("audio_peak_f32");
+}
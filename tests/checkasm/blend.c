@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "lib/upipe/ubuf_pic_blend.h"
+#include "lib/upipe-filters/upipe_filter_merge.h"
+
+#define NUM_SAMPLES 1024
+
+typedef void (*blend_8_func)(uint8_t *dst, const uint8_t *src,
+        const uint8_t *alpha_plane, uint8_t alpha_hsub, int samples,
+        uint8_t alpha);
+typedef void (*blend_16_func)(uint16_t *dst, const uint16_t *src,
+        const uint8_t *alpha_plane, uint8_t alpha_hsub, int samples,
+        uint8_t alpha);
+typedef void (*key_8_func)(uint8_t *dst, const uint8_t *src,
+        const uint8_t *alpha_plane, uint8_t alpha_hsub, int samples,
+        uint8_t alpha, uint8_t threshold);
+typedef void (*key_16_func)(uint16_t *dst, const uint16_t *src,
+        const uint8_t *alpha_plane, uint8_t alpha_hsub, int samples,
+        uint8_t alpha, uint8_t threshold);
+
+static void randomize_buffers(void *buf, size_t size)
+{
+    uint8_t *p = buf;
+    for (size_t i = 0; i < size; i++)
+        p[i] = rnd();
+}
+
+/* case 0 has no alpha plane, case 1 a full-width one and case 2 a
+ * subsampled one */
+#define ALPHA_HSUB (c == 2 ? 2 : 1)
+#define ALPHA (c == 1 ? 0xff : rnd())
+
+static void check_blend_8(blend_8_func func, const char *name)
+{
+    uint8_t src[NUM_SAMPLES], plane[2 * NUM_SAMPLES];
+    uint8_t dst0[NUM_SAMPLES], dst1[NUM_SAMPLES];
+    declare_func(void, uint8_t *dst, const uint8_t *src,
+                 const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                 int samples, uint8_t alpha);
+
+    if (check_func(func, "%s", name)) {
+        for (int samples = 1; samples <= NUM_SAMPLES;
+             samples += 1 + samples / 2) {
+            for (int c = 0; c < 3; c++) {
+                const uint8_t *alpha_plane = c ? plane : NULL;
+                uint8_t alpha = ALPHA;
+                randomize_buffers(src, sizeof(src));
+                randomize_buffers(plane, sizeof(plane));
+                randomize_buffers(dst0, sizeof(dst0));
+                memcpy(dst1, dst0, sizeof(dst1));
+                call_ref(dst0, src, alpha_plane, ALPHA_HSUB, samples, alpha);
+                call_new(dst1, src, alpha_plane, ALPHA_HSUB, samples, alpha);
+                if (memcmp(dst0, dst1, sizeof(dst0)))
+                    fail();
+            }
+        }
+        bench_new_units(NUM_SAMPLES, "pixel",
+                        dst1, src, plane, 1, NUM_SAMPLES, 0xff);
+    }
+    report("%s", name);
+}
+
+static void check_blend_16(blend_16_func func, const char *name)
+{
+    uint16_t src[NUM_SAMPLES], dst0[NUM_SAMPLES], dst1[NUM_SAMPLES];
+    uint8_t plane[2 * NUM_SAMPLES];
+    declare_func(void, uint16_t *dst, const uint16_t *src,
+                 const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                 int samples, uint8_t alpha);
+
+    if (check_func(func, "%s", name)) {
+        for (int samples = 1; samples <= NUM_SAMPLES;
+             samples += 1 + samples / 2) {
+            for (int c = 0; c < 3; c++) {
+                const uint8_t *alpha_plane = c ? plane : NULL;
+                uint8_t alpha = ALPHA;
+                randomize_buffers(src, sizeof(src));
+                randomize_buffers(plane, sizeof(plane));
+                randomize_buffers(dst0, sizeof(dst0));
+                memcpy(dst1, dst0, sizeof(dst1));
+                call_ref(dst0, src, alpha_plane, ALPHA_HSUB, samples, alpha);
+                call_new(dst1, src, alpha_plane, ALPHA_HSUB, samples, alpha);
+                if (memcmp(dst0, dst1, sizeof(dst0)))
+                    fail();
+            }
+        }
+        bench_new_units(NUM_SAMPLES, "pixel",
+                        dst1, src, plane, 1, NUM_SAMPLES, 0xff);
+    }
+    report("%s", name);
+}
+
+static void check_key_8(key_8_func func, const char *name)
+{
+    uint8_t src[NUM_SAMPLES], plane[2 * NUM_SAMPLES];
+    uint8_t dst0[NUM_SAMPLES], dst1[NUM_SAMPLES];
+    declare_func(void, uint8_t *dst, const uint8_t *src,
+                 const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                 int samples, uint8_t alpha, uint8_t threshold);
+
+    if (check_func(func, "%s", name)) {
+        for (int samples = 1; samples <= NUM_SAMPLES;
+             samples += 1 + samples / 2) {
+            /* the key variants require an alpha plane */
+            for (int c = 1; c < 3; c++) {
+                const uint8_t *alpha_plane = plane;
+                uint8_t alpha = ALPHA, threshold = rnd();
+                randomize_buffers(src, sizeof(src));
+                randomize_buffers(plane, sizeof(plane));
+                randomize_buffers(dst0, sizeof(dst0));
+                memcpy(dst1, dst0, sizeof(dst1));
+                call_ref(dst0, src, alpha_plane, ALPHA_HSUB, samples, alpha,
+                         threshold);
+                call_new(dst1, src, alpha_plane, ALPHA_HSUB, samples, alpha,
+                         threshold);
+                if (memcmp(dst0, dst1, sizeof(dst0)))
+                    fail();
+            }
+        }
+        bench_new_units(NUM_SAMPLES, "pixel",
+                        dst1, src, plane, 1, NUM_SAMPLES, 0xff, 0x80);
+    }
+    report("%s", name);
+}
+
+static void check_key_16(key_16_func func, const char *name)
+{
+    uint16_t src[NUM_SAMPLES], dst0[NUM_SAMPLES], dst1[NUM_SAMPLES];
+    uint8_t plane[2 * NUM_SAMPLES];
+    declare_func(void, uint16_t *dst, const uint16_t *src,
+                 const uint8_t *alpha_plane, uint8_t alpha_hsub,
+                 int samples, uint8_t alpha, uint8_t threshold);
+
+    if (check_func(func, "%s", name)) {
+        for (int samples = 1; samples <= NUM_SAMPLES;
+             samples += 1 + samples / 2) {
+            /* the key variants require an alpha plane */
+            for (int c = 1; c < 3; c++) {
+                const uint8_t *alpha_plane = plane;
+                uint8_t alpha = ALPHA, threshold = rnd();
+                randomize_buffers(src, sizeof(src));
+                randomize_buffers(plane, sizeof(plane));
+                randomize_buffers(dst0, sizeof(dst0));
+                memcpy(dst1, dst0, sizeof(dst1));
+                call_ref(dst0, src, alpha_plane, ALPHA_HSUB, samples, alpha,
+                         threshold);
+                call_new(dst1, src, alpha_plane, ALPHA_HSUB, samples, alpha,
+                         threshold);
+                if (memcmp(dst0, dst1, sizeof(dst0)))
+                    fail();
+            }
+        }
+        bench_new_units(NUM_SAMPLES, "pixel",
+                        dst1, src, plane, 1, NUM_SAMPLES, 0xff, 0x80);
+    }
+    report("%s", name);
+}
+
+static void check_merge(upipe_filter_merge_func func, const char *name)
+{
+    uint8_t s1[NUM_SAMPLES], s2[NUM_SAMPLES];
+    uint8_t dst0[NUM_SAMPLES], dst1[NUM_SAMPLES];
+    declare_func(void, void *dest, const void *s1, const void *s2,
+                 size_t bytes);
+
+    if (check_func(func, "%s", name)) {
+        for (size_t bytes = 2; bytes <= NUM_SAMPLES; bytes += 2 + bytes / 2) {
+            randomize_buffers(s1, sizeof(s1));
+            randomize_buffers(s2, sizeof(s2));
+            memset(dst0, 0, sizeof(dst0));
+            memset(dst1, 0, sizeof(dst1));
+            call_ref(dst0, s1, s2, bytes);
+            call_new(dst1, s1, s2, bytes);
+            if (memcmp(dst0, dst1, sizeof(dst0)))
+                fail();
+        }
+        bench_new_units(NUM_SAMPLES, "byte", dst1, s1, s2, NUM_SAMPLES);
+    }
+    report("%s", name);
+}
+
+void checkasm_check_blend(void)
+{
+    struct {
+        blend_8_func blend_8;
+        blend_16_func blend_16;
+        key_8_func key_8;
+        key_16_func key_16;
+        upipe_filter_merge_func merge8bit;
+        upipe_filter_merge_func merge16bit;
+    } s = {
+        .blend_8 = ubuf_pic_blend_8_c,
+        .blend_16 = ubuf_pic_blend_16_c,
+        .key_8 = ubuf_pic_key_8_c,
+        .key_16 = ubuf_pic_key_16_c,
+        .merge8bit = upipe_filter_merge8bit_c,
+        .merge16bit = upipe_filter_merge16bit_c,
+    };
+
+    int cpu_flags = av_get_cpu_flags();
+
+#if ARCH_X86
+    if (cpu_flags & AV_CPU_FLAG_SSE2) {
+        s.blend_8 = ubuf_pic_blend_8_sse2;
+        s.blend_16 = ubuf_pic_blend_16_sse2;
+        s.key_8 = ubuf_pic_key_8_sse2;
+        s.key_16 = ubuf_pic_key_16_sse2;
+        s.merge8bit = upipe_filter_merge8bit_sse2;
+        s.merge16bit = upipe_filter_merge16bit_sse2;
+    }
+    if (cpu_flags & AV_CPU_FLAG_AVX2) {
+        s.blend_8 = ubuf_pic_blend_8_avx2;
+        s.blend_16 = ubuf_pic_blend_16_avx2;
+        s.key_8 = ubuf_pic_key_8_avx2;
+        s.key_16 = ubuf_pic_key_16_avx2;
+        s.merge8bit = upipe_filter_merge8bit_avx2;
+        s.merge16bit = upipe_filter_merge16bit_avx2;
+    }
+#elif ARCH_AARCH64
+    if (cpu_flags & AV_CPU_FLAG_NEON) {
+        s.blend_8 = ubuf_pic_blend_8_neon;
+        s.blend_16 = ubuf_pic_blend_16_neon;
+        s.key_8 = ubuf_pic_key_8_neon;
+        s.key_16 = ubuf_pic_key_16_neon;
+        s.merge8bit = upipe_filter_merge8bit_neon;
+        s.merge16bit = upipe_filter_merge16bit_neon;
+    }
+#endif
+
+    check_blend_8(s.blend_8, "blend_8");
+    check_blend_16(s.blend_16, "blend_16");
+    check_key_8(s.key_8, "key_8");
+    check_key_16(s.key_16, "key_16");
+    check_merge(s.merge8bit, "merge8bit");
+    check_merge(s.merge16bit, "merge16bit");
+}
@@ -78,6 +78,18 @@ static const struct {
     { "sdidec", checkasm_check_sdidec },
     { "sdienc", checkasm_check_sdienc },
 #endif
+#ifdef HAVE_TS
+    { "crc32", checkasm_check_crc32 },
+    { "fec_xor", checkasm_check_fec_xor },
+    { "ts_etr290", checkasm_check_ts_etr290 },
+#endif
+#ifdef HAVE_FRAMERS
+    { "mpeg_scan", checkasm_check_mpeg_scan },
+#endif
+    { "audio_peak", checkasm_check_audio_peak },
+    { "blend", checkasm_check_blend },
+    { "ebur128", checkasm_check_ebur128 },
+    { "pcm_convert", checkasm_check_pcm_convert },
     { "v210dec", checkasm_check_v210dec },
     { "v210enc", checkasm_check_v210enc },
     { NULL, NULL }
@@ -333,16 +345,23 @@ static void *checkasm_malloc(size_t size)
     return ptr;
 }
 
-/* Get the suffix of the specified cpu flag */
-static const char *cpu_suffix(int cpu)
+/* Get the index in cpus[] of the highest specified cpu flag, -1 for C */
+static int cpu_index(int cpu)
 {
     int i = FF_ARRAY_ELEMS(cpus);
 
     while (--i >= 0)
         if (cpu & cpus[i].flag)
-            return cpus[i].suffix;
+            break;
 
-    return "c";
+    return i;
+}
+
+/* Get the suffix of the specified cpu flag */
+static const char *cpu_suffix(int cpu)
+{
+    int i = cpu_index(cpu);
+    return i >= 0 ? cpus[i].suffix : "c";
 }
 
 static int cmp_nop(const void *a, const void *b)
@@ -393,6 +412,79 @@ static void print_benchs(CheckasmFunc *f)
     }
 }
 
+/* Mark the cpu flags having at least one benchmarked function */
+static void mark_bench_cpus(CheckasmFunc *f, int *used)
+{
+    if (f) {
+        mark_bench_cpus(f->child[0], used);
+
+        if (f->versions.cpu || f->versions.next) {
+            CheckasmFuncVersion *v = &f->versions;
+            do {
+                if (v->perf.iterations && v->perf.units)
+                    used[cpu_index(v->cpu) + 1] = 1;
+            } while ((v = v->next));
+        }
+
+        mark_bench_cpus(f->child[1], used);
+    }
+}
+
+/* Print one row of the benchmark table per function */
+static void print_bench_rows(CheckasmFunc *f, const int *used)
+{
+    if (f) {
+        const CheckasmPerf *row[FF_ARRAY_ELEMS(cpus) + 1] = { NULL };
+        const char *unit = NULL;
+        CheckasmFuncVersion *v = &f->versions;
+        int i;
+
+        print_bench_rows(f->child[0], used);
+
+        /* Only print functions with at least one assembly version */
+        if (f->versions.cpu || f->versions.next) {
+            do {
+                if (v->perf.iterations && v->perf.units) {
+                    row[cpu_index(v->cpu) + 1] = &v->perf;
+                    unit = v->perf.unit;
+                }
+            } while ((v = v->next));
+        }
+
+        if (unit) {
+            printf("%-24s %-8s", f->name, unit);
+            for (i = 0; i < FF_ARRAY_ELEMS(row); i++) {
+                if (!used[i])
+                    continue;
+                if (row[i]) {
+                    double cycles = (10. * row[i]->cycles / row[i]->iterations -
+                                     state.nop_time) / 40.;
+                    printf(" %9.3f", FFMAX(cycles, 0.) / row[i]->units);
+                } else
+                    printf(" %9s", "-");
+            }
+            printf("\n");
+        }
+
+        print_bench_rows(f->child[1], used);
+    }
+}
+
+/* Print benchmark results per unit of work, with one column per cpu flag */
+static void print_bench_table(CheckasmFunc *f)
+{
+    int used[FF_ARRAY_ELEMS(cpus) + 1] = { 0 };
+    int i;
+
+    mark_bench_cpus(f, used);
+    printf("\n%-24s %-8s", "function", "unit");
+    for (i = 0; i < FF_ARRAY_ELEMS(used); i++)
+        if (used[i])
+            printf(" %9s", i ? cpus[i - 1].suffix : "c");
+    printf("\n");
+    print_bench_rows(f, used);
+}
+
 /* ASCIIbetical sort except preserving natural order for numbers */
 static int cmp_func_names(const char *a, const char *b)
 {
@@ -521,6 +613,9 @@ static int bench_init_ffmpeg(void)
 {
 #ifdef AV_READ_TIME
     printf("benchmarking with native FFmpeg timers\n");
+#ifdef AV_READ_TIME_FREQ
+    printf("timer frequency: %"PRIu64" Hz\n", AV_READ_TIME_FREQ());
+#endif
     return 0;
 #else
     fprintf(stderr, "checkasm: --bench is not supported on your system\n");
@@ -599,6 +694,7 @@ int main(int argc, char *argv[])
         fprintf(stderr, "checkasm: all %d tests passed\n", state.num_checked);
         if (state.bench_pattern) {
             print_benchs(state.funcs);
+            print_bench_table(state.funcs);
         }
     }
 
@@ -27,7 +27,6 @@
 #include "config.h"
 
 /* silence warnings caused by unknown config variables from FFmpeg */
-#define ARCH_AARCH64 0
 #define ARCH_ARM 0
 #define ARCH_PPC 0
 #define CONFIG_LINUX_PERF 0
@@ -50,6 +49,12 @@
     #define ARCH_X86_64 0
 #endif
 
+#if defined(__aarch64__)
+    #define ARCH_AARCH64 1
+#else
+    #define ARCH_AARCH64 0
+#endif
+
 #if CONFIG_LINUX_PERF
 #include <unistd.h> // read(3)
 #include <sys/ioctl.h>
@@ -67,8 +72,16 @@
 #define HAVE_RDTSC 0
 #include "timer.h"
 
+void checkasm_check_audio_peak(void);
+void checkasm_check_blend(void);
+void checkasm_check_crc32(void);
+void checkasm_check_ebur128(void);
+void checkasm_check_fec_xor(void);
+void checkasm_check_mpeg_scan(void);
+void checkasm_check_pcm_convert(void);
 void checkasm_check_sdidec(void);
 void checkasm_check_sdienc(void);
+void checkasm_check_ts_etr290(void);
 void checkasm_check_v210dec(void);
 void checkasm_check_v210enc(void);
 
@@ -198,6 +211,9 @@ typedef struct CheckasmPerf {
     int sysfd;
     uint64_t cycles;
     int iterations;
+    /* units of work done by one call, and their name */
+    unsigned units;
+    const char *unit;
 } CheckasmPerf;
 
 #if defined(AV_READ_TIME) || CONFIG_LINUX_PERF
@@ -216,8 +232,9 @@ typedef struct CheckasmPerf {
 #define PERF_STOP(t)  t = AV_READ_TIME() - t
 #endif
 
-/* Benchmark the function */
-#define bench_new(...)\
+/* Benchmark the function, which processes the given number of units of
+ * work (e.g. "pixel") per call, for the per unit summary table */
+#define bench_new_units(nb_units, unit_name, ...)\
     do {\
         if (checkasm_bench_func()) {\
             struct CheckasmPerf *perf = checkasm_get_perf_context();\
@@ -238,14 +255,19 @@ typedef struct CheckasmPerf {
                     tcount++;\
                 }\
             }\
-            perf->cycles += t;\
-            perf->iterations++;\
+            perf->cycles += tsum;\
+            perf->iterations += tcount;\
+            perf->units = (nb_units);\
+            perf->unit = (unit_name);\
         }\
     } while (0)
 #else
-#define bench_new(...) while(0)
+#define bench_new_units(nb_units, unit_name, ...) while(0)
 #define PERF_START(t)  while(0)
 #define PERF_STOP(t)   while(0)
 #endif
 
+/* Benchmark the function */
+#define bench_new(...) bench_new_units(0, NULL, __VA_ARGS__)
+
 #endif /* TESTS_CHECKASM_CHECKASM_H */
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "lib/upipe-ts/upipe_ts_crc.h"
+
+#define BUF_SIZE 4096
+
+void checkasm_check_crc32(void)
+{
+    struct {
+        uint32_t (*crc32)(uint32_t crc, const uint8_t *buffer, size_t size);
+    } s = {
+        .crc32 = upipe_ts_crc32_c,
+    };
+
+    int cpu_flags = av_get_cpu_flags();
+
+#if ARCH_X86
+    if ((cpu_flags & AV_CPU_FLAG_SSSE3) && __builtin_cpu_supports("pclmul"))
+        s.crc32 = upipe_ts_crc32_pclmul;
+#endif
+
+    if (check_func(s.crc32, "crc32_mpeg")) {
+        uint8_t buf[BUF_SIZE + 16];
+        declare_func(uint32_t, uint32_t crc, const uint8_t *buffer,
+                     size_t size);
+
+        for (size_t i = 0; i < sizeof(buf); i++)
+            buf[i] = rnd();
+
+        for (size_t size = 0; size <= BUF_SIZE; size += 1 + (rnd() & 63)) {
+            int offset = rnd() & 15;
+            uint32_t crc = rnd();
+            if (call_ref(crc, buf + offset, size) !=
+                call_new(crc, buf + offset, size))
+                fail();
+        }
+        bench_new_units(BUF_SIZE, "byte", 0xffffffff, buf, BUF_SIZE);
+    }
+    report("crc32_mpeg");
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "lib/upipe-filters/ebur128/ebur128_filter.h"
+
+#define CHANNELS 6
+#define FRAMES 1024
+#define SIZE (CHANNELS * FRAMES)
+
+/* K-weighting filter at 48 kHz */
+static const double coef_a[5] = {
+    1.0, -3.68070674801639, 5.08704524797113, -3.13154635144673,
+    0.72520888847787
+};
+static const double coef_b[5] = {
+    1.53512485958697, -5.76194590858032, 8.11691004925258, -5.08848181111208,
+    1.19839281085285
+};
+
+/* the C variant applied to each channel, with the vector state layout */
+static void filter_lanes(double *data, size_t stride, size_t frames,
+                         const double *a, const double *b, double *v,
+                         size_t lanes)
+{
+    for (size_t lane = 0; lane < lanes; lane++) {
+        double w[5];
+        for (int k = 0; k < 5; k++)
+            w[k] = v[k * lanes + lane];
+        ebur128_filter_c(data + lane, stride, frames, a, b, w);
+        for (int k = 0; k < 5; k++)
+            v[k * lanes + lane] = w[k];
+    }
+}
+
+static void ebur128_filter_x2_c(double *data, size_t stride, size_t frames,
+                                const double *a, const double *b, double *v)
+{
+    filter_lanes(data, stride, frames, a, b, v, 2);
+}
+
+static void ebur128_filter_x4_c(double *data, size_t stride, size_t frames,
+                                const double *a, const double *b, double *v)
+{
+    filter_lanes(data, stride, frames, a, b, v, 4);
+}
+
+static void randomize_buffers(double *buf, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        buf[i] = (int32_t)rnd() / (double)INT32_MAX;
+}
+
+/* the vector variants may contract multiplications and additions */
+static int near(const double *ref, const double *new, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        if (!double_near_abs_eps(ref[i], new[i], 1e-9))
+            return 0;
+    return 1;
+}
+
+static void check_filter(ebur128_filter_func func, size_t lanes,
+                         const char *name)
+{
+    double data0[SIZE], data1[SIZE];
+    double v0[5 * 4], v1[5 * 4];
+    declare_func(void, double *data, size_t stride, size_t frames,
+                 const double *a, const double *b, double *v);
+
+    if (check_func(func, "%s", name)) {
+        for (size_t stride = lanes; stride <= CHANNELS; stride++) {
+            for (size_t frames = 0; frames <= FRAMES;
+                 frames += 1 + frames / 2) {
+                randomize_buffers(data0, SIZE);
+                memcpy(data1, data0, sizeof(data1));
+                randomize_buffers(v0, 5 * lanes);
+                memcpy(v1, v0, sizeof(v1));
+                call_ref(data0, stride, frames, coef_a, coef_b, v0);
+                call_new(data1, stride, frames, coef_a, coef_b, v1);
+                if (!near(data0, data1, SIZE) || !near(v0, v1, 5 * lanes))
+                    fail();
+            }
+        }
+        memset(v1, 0, sizeof(v1));
+        bench_new_units(FRAMES, "frame",
+                        data1, CHANNELS, FRAMES, coef_a, coef_b, v1);
+    }
+    report("%s", name);
+}
+
+void checkasm_check_ebur128(void)
+{
+    struct {
+        ebur128_filter_func x2;
+        ebur128_filter_func x4;
+    } s = {
+        .x2 = ebur128_filter_x2_c,
+        .x4 = ebur128_filter_x4_c,
+    };
+
+    int cpu_flags = av_get_cpu_flags();
+
+#if ARCH_X86
+    if (cpu_flags & AV_CPU_FLAG_SSE2)
+        s.x2 = ebur128_filter_x2_sse2;
+    if (cpu_flags & AV_CPU_FLAG_AVX2)
+        s.x4 = ebur128_filter_x4_avx2;
+#elif ARCH_AARCH64
+    if (cpu_flags & AV_CPU_FLAG_NEON)
+        s.x2 = ebur128_filter_x2_neon;
+#endif
+
+    check_filter(s.x2, 2, "ebur128_filter_x2");
+    check_filter(s.x4, 4, "ebur128_filter_x4");
+}
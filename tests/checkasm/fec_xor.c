@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "lib/upipe-ts/upipe_rtp_fec_xor.h"
+
+/* payload of 7 TS packets */
+#define PAYLOAD_SIZE 1316
+/* columns and rows of the synthetic FEC matrix */
+#define COLS 20
+#define ROWS 10
+
+static void randomize_buffers(uint8_t *buf, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        buf[i] = rnd();
+}
+
+/* rebuilds every packet of a column lost in a burst, from the column FEC
+ * packet and the other packets of the column */
+static int check_burst_recovery(uint8_t matrix[ROWS * COLS][PAYLOAD_SIZE],
+        uint8_t parity[COLS][PAYLOAD_SIZE])
+{
+    declare_func(void, uint8_t *dst, const uint8_t *const *src,
+                 unsigned int nb_src, size_t size);
+    int start = rnd() % (ROWS * COLS);
+    int burst = 1 + rnd() % COLS;
+
+    for (int lost = start; lost < start + burst && lost < ROWS * COLS;
+         lost++) {
+        const uint8_t *src[ROWS - 1];
+        unsigned int nb_src = 0;
+        for (int row = 0; row < ROWS; row++) {
+            int seq = row * COLS + lost % COLS;
+            if (seq != lost)
+                src[nb_src++] = matrix[seq];
+        }
+
+        uint8_t rec[PAYLOAD_SIZE];
+        memcpy(rec, parity[lost % COLS], sizeof(rec));
+        call_new(rec, src, nb_src, PAYLOAD_SIZE);
+        if (memcmp(rec, matrix[lost], sizeof(rec)))
+            return 0;
+    }
+    return 1;
+}
+
+void checkasm_check_fec_xor(void)
+{
+    struct {
+        upipe_rtp_fec_xor_func xor;
+    } s = {
+        .xor = upipe_rtp_fec_xor_c,
+    };
+
+    int cpu_flags = av_get_cpu_flags();
+
+#if ARCH_X86
+    if (cpu_flags & AV_CPU_FLAG_SSE2)
+        s.xor = upipe_rtp_fec_xor_sse2;
+    if (cpu_flags & AV_CPU_FLAG_AVX2)
+        s.xor = upipe_rtp_fec_xor_avx2;
+#elif ARCH_AARCH64
+    if (cpu_flags & AV_CPU_FLAG_NEON)
+        s.xor = upipe_rtp_fec_xor_neon;
+#endif
+
+    if (check_func(s.xor, "fec_xor")) {
+        static uint8_t matrix[ROWS * COLS][PAYLOAD_SIZE + 16];
+        uint8_t dst0[PAYLOAD_SIZE], dst1[PAYLOAD_SIZE];
+        const uint8_t *src[COLS];
+        declare_func(void, uint8_t *dst, const uint8_t *const *src,
+                     unsigned int nb_src, size_t size);
+
+        for (int i = 0; i < ROWS * COLS; i++)
+            randomize_buffers(matrix[i], sizeof(matrix[i]));
+
+        /* random number of sources, sizes and alignments */
+        for (int i = 0; i < 200; i++) {
+            unsigned int nb_src = rnd() % (COLS + 1);
+            size_t size = rnd() % (PAYLOAD_SIZE + 1);
+            for (unsigned int j = 0; j < nb_src; j++)
+                src[j] = matrix[rnd() % (ROWS * COLS)] + (rnd() & 15);
+            randomize_buffers(dst0, sizeof(dst0));
+            memcpy(dst1, dst0, sizeof(dst1));
+            call_ref(dst0, src, nb_src, size);
+            call_new(dst1, src, nb_src, size);
+            if (memcmp(dst0, dst1, sizeof(dst0)))
+                fail();
+        }
+
+        /* synthetic loss patterns on a COLS x ROWS matrix */
+        static uint8_t packets[ROWS * COLS][PAYLOAD_SIZE];
+        static uint8_t col_parity[COLS][PAYLOAD_SIZE];
+        for (int i = 0; i < ROWS * COLS; i++)
+            memcpy(packets[i], matrix[i], PAYLOAD_SIZE);
+        for (int col = 0; col < COLS; col++) {
+            const uint8_t *column[ROWS];
+            for (int row = 0; row < ROWS; row++)
+                column[row] = packets[row * COLS + col];
+            memset(col_parity[col], 0, PAYLOAD_SIZE);
+            call_ref(col_parity[col], column, ROWS, PAYLOAD_SIZE);
+        }
+        for (int i = 0; i < 50; i++)
+            if (!check_burst_recovery(packets, col_parity))
+                fail();
+
+        /* recovery of a packet protected by a row FEC packet */
+        for (int j = 0; j < COLS - 1; j++)
+            src[j] = packets[j];
+        bench_new_units((COLS - 1) * PAYLOAD_SIZE, "byte",
+                        dst1, src, COLS - 1, PAYLOAD_SIZE);
+    }
+    report("fec_xor");
+}
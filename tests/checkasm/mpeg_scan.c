@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "lib/upipe-framers/upipe_framers_scan.h"
+
+#define BUF_SIZE 4096
+
+void checkasm_check_mpeg_scan(void)
+{
+    struct {
+        const uint8_t *(*scan)(const uint8_t *restrict p, const uint8_t *end,
+                               uint32_t *restrict state);
+    } s = {
+        .scan = upipe_framers_mpeg_scan_c,
+    };
+
+    int cpu_flags = av_get_cpu_flags();
+
+#if ARCH_X86
+    if (cpu_flags & AV_CPU_FLAG_SSE2)
+        s.scan = upipe_framers_mpeg_scan_sse2;
+    if (cpu_flags & AV_CPU_FLAG_AVX2)
+        s.scan = upipe_framers_mpeg_scan_avx2;
+#elif ARCH_AARCH64
+    if (cpu_flags & AV_CPU_FLAG_NEON)
+        s.scan = upipe_framers_mpeg_scan_neon;
+#endif
+
+    if (check_func(s.scan, "mpeg_scan")) {
+        uint8_t buf[BUF_SIZE];
+        declare_func(const uint8_t *, const uint8_t *restrict p,
+                     const uint8_t *end, uint32_t *restrict state);
+
+        /* sparse start codes, and runs of zeros */
+        for (size_t i = 0; i < sizeof(buf); i++) {
+            unsigned int r = rnd();
+            buf[i] = (r & 0x300) ? r : (r >> 10) & 1;
+        }
+
+        for (int i = 0; i < 200; i++) {
+            size_t offset = rnd() % BUF_SIZE;
+            size_t size = 1 + rnd() % (BUF_SIZE - offset);
+            const uint8_t *p = buf + offset, *end = p + size;
+            uint32_t state_ref = rnd() & 1 ? UINT32_MAX : 0x1;
+            uint32_t state_new = state_ref;
+            while (p < end) {
+                const uint8_t *ref = call_ref(p, end, &state_ref);
+                const uint8_t *new = call_new(p, end, &state_new);
+                if (ref != new || state_ref != state_new) {
+                    fail();
+                    break;
+                }
+                p = ref;
+            }
+        }
+
+        memset(buf, 0x42, sizeof(buf));
+        uint32_t state = UINT32_MAX;
+        bench_new_units(BUF_SIZE, "byte", buf, buf + BUF_SIZE, &state);
+    }
+    report("mpeg_scan");
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "lib/upipe-modules/upipe_pcm_convert.h"
+
+#define NUM_SAMPLES 1024
+
+static void randomize(uint8_t *buf, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        buf[i] = rnd();
+}
+
+static void check_to_s32(upipe_pcm_to_s32_func func, const char *name)
+{
+    if (check_func(func, "%s", name)) {
+        uint8_t src[NUM_SAMPLES * 4];
+        int32_t dst0[NUM_SAMPLES + 1], dst1[NUM_SAMPLES + 1];
+        declare_func(void, int32_t *dst, const uint8_t *src, size_t samples);
+        for (size_t samples = 0; samples <= NUM_SAMPLES;
+             samples += 1 + samples) {
+            randomize(src, sizeof (src));
+            /* check the kernels do not write past the end */
+            memset(dst0, 0, sizeof (dst0));
+            memset(dst1, 0, sizeof (dst1));
+            call_ref(dst0, src, samples);
+            call_new(dst1, src, samples);
+            if (memcmp(dst0, dst1, sizeof (dst0)))
+                fail();
+        }
+        bench_new_units(NUM_SAMPLES, "sample", dst1, src, NUM_SAMPLES);
+    }
+    report("%s", name);
+}
+
+void checkasm_check_pcm_convert(void)
+{
+    struct {
+        upipe_pcm_bswap16_func bswap16;
+        upipe_pcm_to_s32_func s16be;
+        upipe_pcm_to_s32_func s24be;
+        upipe_pcm_to_s32_func s32be;
+    } s = {
+        .bswap16 = upipe_pcm_bswap16_c,
+        .s16be = upipe_pcm_s16be_to_s32_c,
+        .s24be = upipe_pcm_s24be_to_s32_c,
+        .s32be = upipe_pcm_s32be_to_s32_c,
+    };
+
+    int cpu_flags = av_get_cpu_flags();
+
+#if ARCH_X86
+    if (cpu_flags & AV_CPU_FLAG_SSSE3) {
+        s.bswap16 = upipe_pcm_bswap16_ssse3;
+        s.s16be = upipe_pcm_s16be_to_s32_ssse3;
+        s.s24be = upipe_pcm_s24be_to_s32_ssse3;
+        s.s32be = upipe_pcm_s32be_to_s32_ssse3;
+    }
+    if (cpu_flags & AV_CPU_FLAG_AVX2) {
+        s.bswap16 = upipe_pcm_bswap16_avx2;
+        s.s16be = upipe_pcm_s16be_to_s32_avx2;
+        s.s24be = upipe_pcm_s24be_to_s32_avx2;
+        s.s32be = upipe_pcm_s32be_to_s32_avx2;
+    }
+#elif ARCH_AARCH64
+    if (cpu_flags & AV_CPU_FLAG_NEON) {
+        s.bswap16 = upipe_pcm_bswap16_neon;
+        s.s16be = upipe_pcm_s16be_to_s32_neon;
+        s.s24be = upipe_pcm_s24be_to_s32_neon;
+        s.s32be = upipe_pcm_s32be_to_s32_neon;
+    }
+#endif
+
+    if (check_func(s.bswap16, "pcm_bswap16")) {
+        uint8_t src[NUM_SAMPLES * 2];
+        uint8_t dst0[NUM_SAMPLES * 2 + 2], dst1[NUM_SAMPLES * 2 + 2];
+        declare_func(void, uint8_t *dst, const uint8_t *src, size_t words);
+        for (size_t words = 0; words <= NUM_SAMPLES; words += 1 + words) {
+            randomize(src, sizeof (src));
+            memset(dst0, 0, sizeof (dst0));
+            memset(dst1, 0, sizeof (dst1));
+            call_ref(dst0, src, words);
+            call_new(dst1, src, words);
+            if (memcmp(dst0, dst1, sizeof (dst0)))
+                fail();
+
+            /* in place */
+            memcpy(dst1, src, words * 2);
+            call_new(dst1, dst1, words);
+            if (memcmp(dst0, dst1, words * 2))
+                fail();
+        }
+        bench_new_units(NUM_SAMPLES, "sample", dst1, src, NUM_SAMPLES);
+    }
+    report("pcm_bswap16");
+
+    check_to_s32(s.s16be, "pcm_s16be_to_s32");
+    check_to_s32(s.s24be, "pcm_s24be_to_s32");
+    check_to_s32(s.s32be, "pcm_s32be_to_s32");
+}
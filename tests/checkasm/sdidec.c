@@ -39,8 +39,11 @@ void checkasm_check_sdidec(void)
 {
     struct {
         void (*uyvy)(const uint8_t *src, uint16_t *dst, int64_t pixels);
+        void (*planar10)(const uint8_t *src, uint16_t *y, uint16_t *u,
+                         uint16_t *v, int64_t pixels);
     } s = {
         .uyvy = upipe_sdi_to_uyvy_c,
+        .planar10 = upipe_sdi_to_planar10_c,
     };
 
     int cpu_flags = av_get_cpu_flags();
@@ -53,6 +56,24 @@ void checkasm_check_sdidec(void)
         s.uyvy = upipe_sdi_to_uyvy_avx2;
     }
 #endif
+#if ARCH_X86 && defined(AV_CPU_FLAG_AVX512)
+    if (cpu_flags & AV_CPU_FLAG_AVX512) {
+        s.uyvy = upipe_sdi_to_uyvy_avx512;
+    }
+#elif ARCH_AARCH64
+    if (cpu_flags & AV_CPU_FLAG_NEON) {
+        s.uyvy = upipe_sdi_to_uyvy_neon;
+        s.planar10 = upipe_sdi_to_planar10_neon;
+    }
+#endif
+#if ARCH_X86
+    if (cpu_flags & AV_CPU_FLAG_SSSE3) {
+        s.planar10 = upipe_sdi_to_planar10_ssse3;
+    }
+    if (cpu_flags & AV_CPU_FLAG_AVX2) {
+        s.planar10 = upipe_sdi_to_planar10_avx2;
+    }
+#endif
 
     if (check_func(s.uyvy, "sdi_to_uyvy")) {
         uint8_t  src0[NUM_SAMPLES * 10 / 8];
@@ -67,7 +88,32 @@ void checkasm_check_sdidec(void)
         if (memcmp(src0, src1, NUM_SAMPLES * 10 / 8)
                 || memcmp(dst0, dst1, NUM_SAMPLES))
             fail();
-        bench_new(src1, dst1, NUM_SAMPLES / 2);
+        bench_new_units(NUM_SAMPLES / 2, "pixel", src1, dst1, NUM_SAMPLES / 2);
     }
     report("sdi_to_uyvy");
+
+    if (check_func(s.planar10, "sdi_to_planar10")) {
+        uint8_t  src0[NUM_SAMPLES * 10 / 8];
+        uint8_t  src1[NUM_SAMPLES * 10 / 8];
+        DECLARE_ALIGNED(32, uint16_t, y0)[NUM_SAMPLES / 2];
+        DECLARE_ALIGNED(32, uint16_t, y1)[NUM_SAMPLES / 2];
+        DECLARE_ALIGNED(32, uint16_t, u0)[NUM_SAMPLES / 4];
+        DECLARE_ALIGNED(32, uint16_t, u1)[NUM_SAMPLES / 4];
+        DECLARE_ALIGNED(32, uint16_t, v0)[NUM_SAMPLES / 4];
+        DECLARE_ALIGNED(32, uint16_t, v1)[NUM_SAMPLES / 4];
+        declare_func(void, const uint8_t *src, uint16_t *y, uint16_t *u,
+                     uint16_t *v, int64_t pixels);
+
+        randomize_buffers(src0, src1);
+        call_ref(src0, y0, u0, v0, NUM_SAMPLES / 2);
+        call_new(src1, y1, u1, v1, NUM_SAMPLES / 2);
+        if (memcmp(src0, src1, NUM_SAMPLES * 10 / 8)
+                || memcmp(y0, y1, sizeof (y0))
+                || memcmp(u0, u1, sizeof (u0))
+                || memcmp(v0, v1, sizeof (v0)))
+            fail();
+        bench_new_units(NUM_SAMPLES / 2, "pixel",
+                        src1, y1, u1, v1, NUM_SAMPLES / 2);
+    }
+    report("sdi_to_planar10");
 }
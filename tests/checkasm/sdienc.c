@@ -56,6 +56,15 @@ void checkasm_check_sdienc(void)
         s.uyvy = upipe_uyvy_to_sdi_avx2;
     }
 #endif
+#if ARCH_X86 && defined(AV_CPU_FLAG_AVX512)
+    if (cpu_flags & AV_CPU_FLAG_AVX512) {
+        s.uyvy = upipe_uyvy_to_sdi_avx512;
+    }
+#elif ARCH_AARCH64
+    if (cpu_flags & AV_CPU_FLAG_NEON) {
+        s.uyvy = upipe_uyvy_to_sdi_neon;
+    }
+#endif
 
     if (check_func(s.uyvy, "uyvy_to_sdi")) {
         DECLARE_ALIGNED(16, uint16_t, src0)[NUM_SAMPLES];
@@ -70,7 +79,49 @@ void checkasm_check_sdienc(void)
         if (memcmp(src0, src1, NUM_SAMPLES)
                 || memcmp(dst0, dst1, NUM_SAMPLES * 10 / 8))
             fail();
-        bench_new(dst1, (const uint8_t*)src1, NUM_SAMPLES / 2);
+        bench_new_units(NUM_SAMPLES / 2, "pixel",
+                        dst1, (const uint8_t*)src1, NUM_SAMPLES / 2);
     }
     report("uyvy_to_sdi");
+
+    void (*v210)(uint8_t *dst, const uint8_t *src, int64_t pixels) =
+        upipe_v210_to_sdi_c;
+#if ARCH_X86
+    if (cpu_flags & AV_CPU_FLAG_AVX2) {
+        v210 = upipe_v210_to_sdi_avx2;
+    }
+#if defined(AV_CPU_FLAG_AVX512)
+    if (cpu_flags & AV_CPU_FLAG_AVX512) {
+        v210 = upipe_v210_to_sdi_avx512;
+    }
+#endif
+#elif ARCH_AARCH64
+    if (cpu_flags & AV_CPU_FLAG_NEON) {
+        v210 = upipe_v210_to_sdi_neon;
+    }
+#endif
+
+    if (check_func(v210, "v210_to_sdi")) {
+        /* 3 samples per word */
+        uint32_t src0[NUM_SAMPLES / 3 + 1];
+        uint32_t src1[NUM_SAMPLES / 3 + 1];
+        uint8_t dst0[NUM_SAMPLES * 10 / 8];
+        uint8_t dst1[NUM_SAMPLES * 10 / 8];
+        declare_func(void, uint8_t *dst, const uint8_t *src, int64_t pixels);
+
+        for (int i = 0; i < NUM_SAMPLES / 3 + 1; i++) {
+            uint32_t word = rnd() & 0x3fffffff;
+            src0[i] = word;
+            src1[i] = word;
+        }
+        memset(dst0, 0, sizeof(dst0));
+        memset(dst1, 0, sizeof(dst1));
+        call_ref(dst0, (const uint8_t*)src0, NUM_SAMPLES / 2);
+        call_new(dst1, (const uint8_t*)src1, NUM_SAMPLES / 2);
+        if (memcmp(dst0, dst1, sizeof(dst0)))
+            fail();
+        bench_new_units(NUM_SAMPLES / 2, "pixel",
+                        dst1, (const uint8_t*)src1, NUM_SAMPLES / 2);
+    }
+    report("v210_to_sdi");
 }
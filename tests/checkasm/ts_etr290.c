@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "lib/upipe-ts/upipe_ts_etr290_headers.h"
+
+#define PACKET_SIZE UPIPE_TS_ETR290_PACKET_SIZE
+#define MAX_PACKETS UPIPE_TS_ETR290_HEADERS_MAX
+
+/* packets with a valid sync byte, and random errors */
+static void randomize_packets(uint8_t *buf, unsigned int nb)
+{
+    for (unsigned int i = 0; i < nb * PACKET_SIZE; i++)
+        buf[i] = rnd();
+    for (unsigned int i = 0; i < nb; i++) {
+        uint8_t *packet = buf + i * PACKET_SIZE;
+        packet[0] = 0x47;
+        if (!(rnd() % 8))
+            packet[0] = rnd();
+        if (rnd() % 4)
+            packet[1] &= 0x7f;
+    }
+}
+
+void checkasm_check_ts_etr290(void)
+{
+    struct {
+        upipe_ts_etr290_headers_func headers;
+    } s = {
+        .headers = upipe_ts_etr290_headers_c,
+    };
+
+    int cpu_flags = av_get_cpu_flags();
+
+#if ARCH_X86
+    if (cpu_flags & AV_CPU_FLAG_AVX2)
+        s.headers = upipe_ts_etr290_headers_avx2;
+#elif ARCH_AARCH64
+    if (cpu_flags & AV_CPU_FLAG_NEON)
+        s.headers = upipe_ts_etr290_headers_neon;
+#endif
+
+    if (check_func(s.headers, "ts_etr290_headers")) {
+        static uint8_t buf[MAX_PACKETS * PACKET_SIZE];
+        uint32_t headers0[MAX_PACKETS], headers1[MAX_PACKETS];
+        declare_func(uint64_t, const uint8_t *buf, unsigned int nb,
+                     uint32_t *headers);
+
+        /* random number of packets, to exercise the tail handling */
+        for (int i = 0; i < 200; i++) {
+            unsigned int nb = 1 + rnd() % MAX_PACKETS;
+            randomize_packets(buf, nb);
+            memset(headers0, 0, sizeof(headers0));
+            memset(headers1, 0, sizeof(headers1));
+            uint64_t errors0 = call_ref(buf, nb, headers0);
+            uint64_t errors1 = call_new(buf, nb, headers1);
+            if (errors0 != errors1 ||
+                memcmp(headers0, headers1, nb * sizeof(uint32_t)))
+                fail();
+        }
+
+        randomize_packets(buf, MAX_PACKETS);
+        bench_new_units(MAX_PACKETS, "packet", buf, MAX_PACKETS, headers1);
+    }
+    report("ts_etr290_headers");
+}
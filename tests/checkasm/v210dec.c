@@ -95,6 +95,17 @@ void checkasm_check_v210dec(void)
         s.planar_8  = upipe_v210_to_planar_8_aligned_avx2;
     }
 #endif
+#if ARCH_X86 && defined(AV_CPU_FLAG_AVX512)
+    if (cpu_flags & AV_CPU_FLAG_AVX512) {
+        s.planar_10 = upipe_v210_to_planar_10_avx512;
+        s.planar_8  = upipe_v210_to_planar_8_avx512;
+    }
+#elif ARCH_AARCH64
+    if (cpu_flags & AV_CPU_FLAG_NEON) {
+        s.planar_10 = upipe_v210_to_planar_10_neon;
+        s.planar_8  = upipe_v210_to_planar_8_neon;
+    }
+#endif
 
     if (check_func(s.planar_8, "v210_to_planar8")) {
         declare(uint8_t);
@@ -104,7 +115,7 @@ void checkasm_check_v210dec(void)
             call_new(src1, y1, u1, v1, width);
             if (memcmp(y0, y1, width) || memcmp(u0, u1, width / 2) || memcmp(v0, v1, width / 2))
                 fail();
-            bench_new(src1, y1, u1, v1, width);
+            bench_new_units(width, "pixel", src1, y1, u1, v1, width);
         }
     }
     report("v210_to_planar8");
@@ -117,7 +128,7 @@ void checkasm_check_v210dec(void)
             call_new(src1, y1, u1, v1, width);
             if (memcmp(y0, y1, width) || memcmp(u0, u1, width / 2) || memcmp(v0, v1, width / 2))
                 fail();
-            bench_new(src1, y1, u1, v1, width);
+            bench_new_units(width, "pixel", src1, y1, u1, v1, width);
         }
     }
     report("v210_to_planar10");
@@ -73,7 +73,8 @@
             if (memcmp(y0, y1, BUF_SIZE) || memcmp(u0, u1, BUF_SIZE / 2) ||        \
                 memcmp(v0, v1, BUF_SIZE / 2) || memcmp(dst0, dst1, width * 8 / 3)) \
                 fail();                                                            \
-            bench_new(y1 + y_offset, u1 + uv_offset, v1 + uv_offset, dst1, width); \
+            bench_new_units(width, "pixel", y1 + y_offset, u1 + uv_offset,         \
+                            v1 + uv_offset, dst1, width);                          \
         }                                                                          \
     } while (0)
 
@@ -101,6 +102,17 @@ void checkasm_check_v210enc(void)
         s.planar_8  = upipe_planar_to_v210_8_avx2;
     }
 #endif
+#if ARCH_X86 && defined(AV_CPU_FLAG_AVX512)
+    if (cpu_flags & AV_CPU_FLAG_AVX512) {
+        s.planar_10 = upipe_planar_to_v210_10_avx512;
+        s.planar_8  = upipe_planar_to_v210_8_avx512;
+    }
+#elif ARCH_AARCH64
+    if (cpu_flags & AV_CPU_FLAG_NEON) {
+        s.planar_10 = upipe_planar_to_v210_10_neon;
+        s.planar_8  = upipe_planar_to_v210_8_neon;
+    }
+#endif
 
     if (check_func(s.planar_8, "planar_to_v210_8"))
         check_pack_line(uint8_t, 0xffffffff);
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short unit tests for the audit of fallback allocations
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/ulog.h>
+#include <upipe/uprobe.h>
+#include <upipe/upool.h>
+#include <upipe/umem.h>
+#include <upipe/umem_pool.h>
+#include <upipe/ualloc_audit.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#define POOL0_SIZE 128
+#define POOL_DEPTH 2
+#define UPOOL_DEPTH 1
+
+static unsigned int nb_notices = 0;
+static unsigned int nb_warnings = 0;
+static bool found_umem_pool = false;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    assert(event == UPROBE_LOG);
+    struct ulog *ulog = va_arg(args, struct ulog *);
+    if (ulog->level == UPROBE_LOG_NOTICE)
+        nb_notices++;
+    else if (ulog->level == UPROBE_LOG_WARNING) {
+        nb_warnings++;
+        if (strstr(ulog->msg, "from umem_pool") != NULL)
+            found_umem_pool = true;
+    }
+    return UBASE_ERR_NONE;
+}
+
+static void *test_alloc_cb(struct upool *upool)
+{
+    return malloc(1);
+}
+
+static void test_free_cb(struct upool *upool, void *obj)
+{
+    free(obj);
+}
+
+int main(int argc, char **argv)
+{
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+
+    struct umem_mgr *umem_mgr = umem_pool_mgr_alloc(POOL0_SIZE, 1,
+                                                    POOL_DEPTH);
+    assert(umem_mgr != NULL);
+
+    /* warm up the pool before the checkpoint */
+    struct umem umems[POOL_DEPTH + 1];
+    for (unsigned int i = 0; i < POOL_DEPTH; i++)
+        assert(umem_alloc(umem_mgr, &umems[i], POOL0_SIZE));
+    for (unsigned int i = 0; i < POOL_DEPTH; i++)
+        umem_free(&umems[i]);
+
+    ualloc_audit_checkpoint(true);
+    for (unsigned int i = 0; i < POOL_DEPTH; i++)
+        assert(umem_alloc(umem_mgr, &umems[i], POOL0_SIZE));
+    assert(ualloc_audit_count() == 0);
+    assert(ualloc_audit_report(&uprobe) == 0);
+    assert(nb_notices == 1);
+    assert(nb_warnings == 0);
+
+    /* the pool is exhausted */
+    assert(umem_alloc(umem_mgr, &umems[POOL_DEPTH], POOL0_SIZE));
+    assert(ualloc_audit_count() == 1);
+
+    uint8_t upool_extra[upool_sizeof(UPOOL_DEPTH)];
+    struct upool upool;
+    upool_init(&upool, NULL, UPOOL_DEPTH, upool_extra,
+               test_alloc_cb, test_free_cb);
+    void *obj = upool_alloc(&upool, void *);
+    assert(obj != NULL);
+    assert(ualloc_audit_count() == 2);
+
+    assert(ualloc_audit_report(&uprobe) == 2);
+    assert(nb_notices == 1);
+    assert(nb_warnings >= 2);
+    assert(found_umem_pool);
+
+    /* once disarmed, fallbacks are not counted anymore */
+    ualloc_audit_disarm();
+    void *obj2 = upool_alloc(&upool, void *);
+    assert(obj2 != NULL);
+    assert(ualloc_audit_count() == 2);
+    upool_free(&upool, obj);
+    upool_free(&upool, obj2);
+
+    /* a new checkpoint resets the counters */
+    ualloc_audit_checkpoint(false);
+    assert(ualloc_audit_count() == 0);
+    ualloc_audit_disarm();
+
+    upool_clean(&upool);
+    for (unsigned int i = 0; i <= POOL_DEPTH; i++)
+        umem_free(&umems[i]);
+    umem_mgr_release(umem_mgr);
+    uprobe_clean(&uprobe);
+    return 0;
+}
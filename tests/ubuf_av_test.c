@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for ubuf manager for picture formats with libav frames
+ */
+
+#undef NDEBUG
+
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_pic.h>
+#include <upipe-av/ubuf_av.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include <libavutil/frame.h>
+
+#define UDICT_POOL_DEPTH    1
+#define UREF_POOL_DEPTH     1
+#define UBUF_POOL_DEPTH     1
+
+int main(int argc, char **argv)
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                   udict_mgr, 0);
+    assert(uref_mgr != NULL);
+
+    /* planar I420 */
+    struct uref *flow_def = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(flow_def != NULL);
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 1, 1, 1, "y8"));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 2, 2, 1, "u8"));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 2, 2, 1, "v8"));
+
+    struct ubuf_mgr *mgr = ubuf_pic_av_mgr_alloc(UBUF_POOL_DEPTH,
+                                                 AV_PIX_FMT_YUV420P, flow_def);
+    assert(mgr != NULL);
+    uref_free(flow_def);
+
+    AVFrame *frame = av_frame_alloc();
+    assert(frame != NULL);
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width = 32;
+    frame->height = 16;
+    assert(av_frame_get_buffer(frame, 32) >= 0);
+    for (int y = 0; y < 16; y++)
+        memset(frame->data[0] + y * frame->linesize[0], y, 32);
+    for (int y = 0; y < 8; y++) {
+        memset(frame->data[1] + y * frame->linesize[1], 0x80 + y, 16);
+        memset(frame->data[2] + y * frame->linesize[2], 0xc0 + y, 16);
+    }
+
+    struct ubuf *ubuf1 = ubuf_pic_av_alloc(mgr, frame);
+    assert(ubuf1 != NULL);
+
+    /* frames of another format are rejected */
+    frame->format = AV_PIX_FMT_NV12;
+    assert(ubuf_pic_av_alloc(mgr, frame) == NULL);
+    frame->format = AV_PIX_FMT_YUV420P;
+
+    size_t hsize, vsize;
+    uint8_t macropixel;
+    ubase_assert(ubuf_pic_size(ubuf1, &hsize, &vsize, &macropixel));
+    assert(hsize == 32);
+    assert(vsize == 16);
+    assert(macropixel == 1);
+
+    size_t stride;
+    uint8_t hsub, vsub, macropixel_size;
+    ubase_assert(ubuf_pic_plane_size(ubuf1, "u8", &stride, &hsub, &vsub,
+                                     &macropixel_size));
+    assert(stride == frame->linesize[1]);
+    assert(hsub == 2);
+    assert(vsub == 2);
+    assert(macropixel_size == 1);
+
+    /* planes point to the frame */
+    const uint8_t *r;
+    ubase_assert(ubuf_pic_plane_read(ubuf1, "y8", 0, 2, -1, -1, &r));
+    assert(r == frame->data[0] + 2 * frame->linesize[0]);
+    assert(r[0] == 2);
+    ubase_assert(ubuf_pic_plane_unmap(ubuf1, "y8", 0, 2, -1, -1));
+    ubase_assert(ubuf_pic_plane_read(ubuf1, "v8", 0, 0, -1, -1, &r));
+    assert(r[0] == 0xc0);
+    ubase_assert(ubuf_pic_plane_unmap(ubuf1, "v8", 0, 0, -1, -1));
+    assert(!ubase_check(ubuf_pic_plane_read(ubuf1, "a8", 0, 0, -1, -1, &r)));
+
+    /* the frame is shared with libav */
+    uint8_t *w;
+    assert(!ubase_check(ubuf_pic_plane_write(ubuf1, "y8", 0, 0, -1, -1, &w)));
+
+    AVFrame *frame_p;
+    ubase_assert(ubuf_pic_av_get_frame(ubuf1, &frame_p));
+    assert(frame_p != frame);
+    assert(frame_p->data[0] == frame->data[0]);
+    av_frame_free(&frame);
+
+    struct ubuf *ubuf2 = ubuf_dup(ubuf1);
+    assert(ubuf2 != NULL);
+    ubase_assert(ubuf_pic_resize(ubuf2, 2, 2, 16, 8));
+    ubase_assert(ubuf_pic_size(ubuf2, &hsize, &vsize, NULL));
+    assert(hsize == 16);
+    assert(vsize == 8);
+    ubase_assert(ubuf_pic_plane_read(ubuf2, "y8", 0, 0, -1, -1, &r));
+    assert(r == frame_p->data[0] + 2 * frame_p->linesize[0] + 2);
+    assert(r[0] == 2);
+    ubase_assert(ubuf_pic_plane_unmap(ubuf2, "y8", 0, 0, -1, -1));
+
+    ubuf_free(ubuf1);
+    ubase_assert(ubuf_pic_plane_read(ubuf2, "u8", 0, 0, -1, -1, &r));
+    assert(r[0] == 0x81);
+    ubase_assert(ubuf_pic_plane_unmap(ubuf2, "u8", 0, 0, -1, -1));
+    ubuf_free(ubuf2);
+
+    ubuf_mgr_release(mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    return 0;
+}
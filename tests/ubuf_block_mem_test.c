@@ -266,6 +266,40 @@ int main(int argc, char **argv)
     ubase_assert(ubuf_block_scan(ubuf1, &offset, 3));
     assert(offset == 3);
 
+    /* test ubuf_block_scan_stride, with candidates spanning segments */
+    ubuf2 = ubuf_block_alloc(mgr, 400);
+    assert(ubuf2 != NULL);
+    wanted = -1;
+    ubase_assert(ubuf_block_write(ubuf2, 0, &wanted, &w));
+    assert(wanted == 400);
+    memset(w, 0, 400);
+    w[10] = w[110] = w[250] = w[350] = 0x47;
+    ubase_assert(ubuf_block_unmap(ubuf2, 0));
+    ubuf3 = ubuf_block_alloc(mgr, 400);
+    assert(ubuf3 != NULL);
+    wanted = -1;
+    ubase_assert(ubuf_block_write(ubuf3, 0, &wanted, &w));
+    memset(w, 0, 400);
+    w[50] = w[150] = w[200] = w[300] = 0x47;
+    ubase_assert(ubuf_block_unmap(ubuf3, 0));
+    ubase_assert(ubuf_block_append(ubuf2, ubuf3));
+    offset = 0;
+    ubase_assert(ubuf_block_scan_stride(ubuf2, &offset, 0x47, 100, 2));
+    assert(offset == 10);
+    offset = 0;
+    ubase_assert(ubuf_block_scan_stride(ubuf2, &offset, 0x47, 100, 3));
+    assert(offset == 250);
+    offset = 251;
+    ubase_assert(ubuf_block_scan_stride(ubuf2, &offset, 0x47, 100, 3));
+    assert(offset == 350);
+    offset = 351;
+    ubase_nassert(ubuf_block_scan_stride(ubuf2, &offset, 0x47, 100, 3));
+    assert(offset == 600);
+    offset = 0;
+    ubase_nassert(ubuf_block_scan_stride(ubuf2, &offset, 0x42, 100, 2));
+    assert(offset == 800);
+    ubuf_free(ubuf2);
+
     /* test ubuf_block_find */
     offset = 0;
     ubase_assert(ubuf_block_find(ubuf1, &offset, 2, 2, 3));
@@ -312,6 +346,177 @@ int main(int argc, char **argv)
     ubuf_free(ubuf1);
     ubuf_free(ubuf2);
 
+    /* test the segment index on a long chain */
+    ubuf1 = NULL;
+    for (int i = 0; i < 64; i++) {
+        ubuf2 = ubuf_block_alloc(mgr, 8);
+        assert(ubuf2 != NULL);
+        wanted = -1;
+        ubase_assert(ubuf_block_write(ubuf2, 0, &wanted, &w));
+        assert(wanted == 8);
+        for (int j = 0; j < 8; j++)
+            w[j] = i * 8 + j;
+        ubase_assert(ubuf_block_unmap(ubuf2, 0));
+        if (ubuf1 == NULL)
+            ubuf1 = ubuf2;
+        else
+            ubase_assert(ubuf_block_append(ubuf1, ubuf2));
+    }
+    assert(ubuf_block_from_ubuf(ubuf1)->index == NULL);
+    wanted = 1;
+    ubase_assert(ubuf_block_read(ubuf1, 511, &wanted, &r));
+    assert(wanted == 1 && r[0] == 255);
+    ubase_assert(ubuf_block_unmap(ubuf1, 511));
+    assert(ubuf_block_from_ubuf(ubuf1)->index != NULL);
+    for (int i = 510; i >= 0; i -= 7) {
+        wanted = -1;
+        ubase_assert(ubuf_block_read(ubuf1, i, &wanted, &r));
+        assert(wanted == 8 - i % 8);
+        assert(r[0] == (uint8_t)i);
+        ubase_assert(ubuf_block_unmap(ubuf1, i));
+    }
+    ubase_assert(ubuf_block_extract(ubuf1, 300, 4, buffer));
+    assert(buffer[0] == 44 && buffer[3] == 47);
+    ubase_nassert(ubuf_block_read(ubuf1, 512, &wanted, &r));
+
+    /* test sequential stream reads across segments */
+    uint8_t large[64];
+    ubuf_block_stream_init(&s, ubuf1, 5);
+    ubase_assert(ubuf_block_stream_peek(&s, 20, large));
+    for (int i = 0; i < 20; i++)
+        assert(large[i] == i + 5);
+    ubase_assert(ubuf_block_stream_skip(&s, 20));
+    assert(ubuf_block_stream_position(&s) == 25 * 8);
+    assert(ubuf_block_stream_read_bits(&s, 4) == 25 >> 4);
+    ubase_assert(ubuf_block_stream_read(&s, 2, large));
+    assert(large[0] == (uint8_t)((25 << 4) | (26 >> 4)));
+    assert(large[1] == (uint8_t)((26 << 4) | (27 >> 4)));
+    assert(ubuf_block_stream_read_bits(&s, 4) == (27 & 0xf));
+    ubase_assert(ubuf_block_stream_read(&s, 64, large));
+    for (int i = 0; i < 64; i++)
+        assert(large[i] == i + 28);
+    ubase_assert(ubuf_block_stream_skip(&s, 400));
+    ubase_nassert(ubuf_block_stream_read(&s, 30, large));
+    assert(large[19] == 255 && large[20] == 0);
+    ubuf_block_stream_clean(&s);
+
+    /* the index is dropped when the layout changes */
+    ubase_assert(ubuf_block_delete(ubuf1, 4, 8));
+    assert(ubuf_block_from_ubuf(ubuf1)->index == NULL);
+    ubase_assert(ubuf_block_extract(ubuf1, 400, 4, buffer));
+    assert(buffer[0] == 152 && buffer[3] == 155);
+
+    /* test ubuf_block_compact */
+    ubase_assert(ubuf_block_compact(mgr, &ubuf1, 64));
+    assert(ubuf_block_iovec_count(ubuf1, 0, -1) == 64);
+    ubase_assert(ubuf_block_compact(mgr, &ubuf1,
+                                    UBUF_BLOCK_COMPACT_THRESHOLD));
+    assert(ubuf_block_iovec_count(ubuf1, 0, -1) == 1);
+    ubase_assert(ubuf_block_size(ubuf1, &size));
+    assert(size == 504);
+    wanted = -1;
+    ubase_assert(ubuf_block_read(ubuf1, 0, &wanted, &r));
+    assert(wanted == 504);
+    for (int i = 0; i < 4; i++)
+        assert(r[i] == i);
+    for (int i = 4; i < 504; i++)
+        assert(r[i] == (uint8_t)(i + 8));
+    ubase_assert(ubuf_block_unmap(ubuf1, 0));
+    ubuf_free(ubuf1);
+
+    /* test ubuf_block_append_gather */
+    ubuf1 = ubuf_block_alloc(mgr, 184);
+    assert(ubuf1 != NULL);
+    ubuf2 = ubuf_block_splice(ubuf1, 0, -1);
+    assert(ubuf2 != NULL);
+    ubase_nassert(ubuf_block_extend(ubuf1, 1));
+    ubuf_free(ubuf2);
+    ubase_assert(ubuf_block_tailroom(ubuf1, &size));
+    ubuf_free(ubuf1);
+
+    ubuf1 = ubuf_block_alloc(mgr, 0);
+    assert(ubuf1 != NULL);
+    for (int i = 0; i < 100; i++) {
+        ubuf2 = ubuf_block_alloc(mgr, 184);
+        assert(ubuf2 != NULL);
+        wanted = -1;
+        ubase_assert(ubuf_block_write(ubuf2, 0, &wanted, &w));
+        memset(w, i, 184);
+        ubase_assert(ubuf_block_unmap(ubuf2, 0));
+        ubase_assert(ubuf_block_append_gather(ubuf1, ubuf2));
+    }
+    ubase_assert(ubuf_block_size(ubuf1, &size));
+    assert(size == 100 * 184);
+    /* chunks grow with the block */
+    int count = ubuf_block_iovec_count(ubuf1, 0, -1);
+    assert(count > 1 && count <= 4);
+    for (int i = 0; i < 100; i++) {
+        ubase_assert(ubuf_block_extract(ubuf1, i * 184 + 7, 1, buffer));
+        assert(buffer[0] == i);
+    }
+    ubuf2 = ubuf_block_alloc(mgr, UBUF_BLOCK_GATHER_SIZE);
+    assert(ubuf2 != NULL);
+    ubase_assert(ubuf_block_append_gather(ubuf1, ubuf2));
+    assert(ubuf_block_iovec_count(ubuf1, 0, -1) == count + 1);
+    ubuf_free(ubuf1);
+
+    /* thread-local reference counts */
+    ubuf_mgr_use(mgr);
+    ubase_nassert(ubuf_block_mem_mgr_set_local(mgr, true));
+    ubuf_mgr_release(mgr);
+    ubase_assert(ubuf_block_mem_mgr_set_local(mgr, true));
+    ubuf1 = ubuf_block_alloc(mgr, UBUF_SIZE);
+    assert(ubuf1 != NULL);
+    ubuf2 = ubuf_block_alloc(mgr, UBUF_SIZE);
+    assert(ubuf2 != NULL);
+    ubase_assert(ubuf_block_append(ubuf1, ubuf2));
+    ubuf2 = ubuf_dup(ubuf1);
+    assert(ubuf2 != NULL);
+    ubase_nassert(ubuf_control(ubuf1, UBUF_SINGLE));
+    ubuf3 = ubuf_block_splice(ubuf1, UBUF_SIZE, UBUF_SIZE);
+    assert(ubuf3 != NULL);
+    ubuf_free(ubuf2);
+    ubase_assert(ubuf_control(ubuf1, UBUF_SINGLE));
+    ubuf_share(ubuf1);
+    ubase_assert(ubuf_control(ubuf1, UBUF_SINGLE));
+    ubase_nassert(ubuf_control(ubuf3, UBUF_SINGLE));
+    ubuf_free(ubuf1);
+    ubase_assert(ubuf_control(ubuf3, UBUF_SINGLE));
+    ubuf_free(ubuf3);
+    ubase_assert(ubuf_block_mem_mgr_set_local(mgr, false));
+
+    /* slab elements */
+    ubase_assert(ubuf_block_mem_mgr_set_slab(mgr, 256, UBUF_POOL_DEPTH));
+    ubase_nassert(ubuf_block_mem_mgr_set_slab(mgr, 256, UBUF_POOL_DEPTH));
+    ubuf1 = ubuf_block_alloc(mgr, UBUF_SIZE);
+    assert(ubuf1 != NULL);
+    wanted = -1;
+    ubase_assert(ubuf_block_write(ubuf1, 0, &wanted, &w));
+    assert(wanted == UBUF_SIZE);
+    assert(!((uintptr_t)w % UBUF_ALIGN));
+    memset(w, 0x47, UBUF_SIZE);
+    ubase_assert(ubuf_block_unmap(ubuf1, 0));
+    ubuf2 = ubuf_block_splice(ubuf1, 1, UBUF_SIZE - 1);
+    assert(ubuf2 != NULL);
+    /* the slab survives its own ubuf */
+    ubuf_free(ubuf1);
+    wanted = -1;
+    ubase_assert(ubuf_block_read(ubuf2, 0, &wanted, &r));
+    assert(wanted == UBUF_SIZE - 1);
+    assert(r[0] == 0x47 && r[UBUF_SIZE - 2] == 0x47);
+    ubase_assert(ubuf_block_unmap(ubuf2, 0));
+    ubase_assert(ubuf_control(ubuf2, UBUF_SINGLE));
+    ubuf_free(ubuf2);
+    /* the element is recycled */
+    ubuf1 = ubuf_block_alloc(mgr, UBUF_SIZE);
+    assert(ubuf1 != NULL);
+    ubuf2 = ubuf_block_alloc(mgr, 1024);
+    assert(ubuf2 != NULL);
+    ubase_assert(ubuf_block_size(ubuf2, &size));
+    assert(size == 1024);
+    ubuf_free(ubuf1);
+    ubuf_free(ubuf2);
+
     ubuf_mgr_release(mgr);
     umem_mgr_release(umem_mgr);
     return 0;
@@ -36,6 +36,7 @@
 #include <upipe/ubuf_block.h>
 #include <upipe/ubuf_pic_mem.h>
 #include <upipe/ubuf_block_mem.h>
+#include <upipe/ubuf_mem_common.h>
 
 #include <stdio.h>
 #include <string.h>
@@ -299,6 +300,68 @@ int main(int argc, char **argv)
     ubuf_mgr_release(block_mgr);
     ubuf_free(ubuf1);
 
+    ubuf_mgr_release(mgr);
+
+    /* exact-size frame pool */
+    mgr = ubuf_pic_mem_mgr_alloc(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH, umem_mgr, 1,
+                                 0, 0, 0, 0, UBUF_ALIGN, UBUF_ALIGN_HOFFSET);
+    assert(mgr != NULL);
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(mgr, "y8", 1, 1, 1));
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(mgr, "u8", 2, 2, 1));
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(mgr, "v8", 2, 2, 1));
+    ubase_nassert(ubuf_pic_mem_mgr_set_frame_pool(mgr, 0));
+    ubase_assert(ubuf_pic_mem_mgr_set_frame_pool(mgr, 2));
+    ubase_nassert(ubuf_pic_mem_mgr_set_frame_pool(mgr, 2));
+
+    ubuf1 = ubuf_pic_alloc(mgr, 1920, 1080);
+    assert(ubuf1 != NULL);
+    ubuf2 = ubuf_pic_alloc(mgr, 1920, 1080);
+    assert(ubuf2 != NULL);
+    struct ubuf *ubuf3 = ubuf_pic_alloc(mgr, 1920, 1080);
+    assert(ubuf3 != NULL);
+    struct ubuf_mem_shared *shared;
+    size_t offset;
+    ubase_assert(ubuf_pic_mem_get_shared(ubuf1, "y8", &shared, &offset,
+                                         &size));
+    uint8_t *frame1 = ubuf_mem_shared_buffer(shared);
+    size_t frame_size = ubuf_mem_shared_size(shared);
+    assert(frame_size < 1920 * 1080 * 2);
+    ubase_assert(ubuf_pic_mem_get_shared(ubuf2, "y8", &shared, &offset,
+                                         &size));
+    uint8_t *frame2 = ubuf_mem_shared_buffer(shared);
+    ubuf_free(ubuf1);
+    ubuf_free(ubuf2);
+    /* the pool is full */
+    ubuf_free(ubuf3);
+
+    ubuf1 = ubuf_pic_alloc(mgr, 1920, 1080);
+    assert(ubuf1 != NULL);
+    ubase_assert(ubuf_pic_mem_get_shared(ubuf1, "y8", &shared, &offset,
+                                         &size));
+    assert(ubuf_mem_shared_buffer(shared) == frame2);
+    assert(ubuf_mem_shared_size(shared) == frame_size);
+    ubuf2 = ubuf_pic_alloc(mgr, 1920, 1080);
+    assert(ubuf2 != NULL);
+    ubase_assert(ubuf_pic_mem_get_shared(ubuf2, "y8", &shared, &offset,
+                                         &size));
+    assert(ubuf_mem_shared_buffer(shared) == frame1);
+
+    /* a shared frame is only recycled on the last release */
+    ubuf3 = ubuf_dup(ubuf1);
+    assert(ubuf3 != NULL);
+    ubuf_free(ubuf1);
+    ubuf_free(ubuf2);
+    ubuf_free(ubuf3);
+
+    /* buffers of other dimensions are not reused */
+    ubuf1 = ubuf_pic_alloc(mgr, 720, 576);
+    assert(ubuf1 != NULL);
+    ubase_assert(ubuf_pic_mem_get_shared(ubuf1, "y8", &shared, &offset,
+                                         &size));
+    assert(ubuf_mem_shared_size(shared) < frame_size);
+    ubuf_free(ubuf1);
+
+    ubuf_mgr_vacuum(mgr);
     ubuf_mgr_release(mgr);
     umem_mgr_release(umem_mgr);
     return 0;
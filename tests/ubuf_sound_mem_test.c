@@ -232,6 +232,78 @@ int main(int argc, char **argv)
     ubuf_mgr_release(block_mgr);
     ubuf_free(ubuf1);
 
+    ubuf_mgr_release(mgr);
+
+    /* zero-copy views of channel pairs */
+    mgr = ubuf_sound_mem_mgr_alloc(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH, umem_mgr,
+                                   4, 32);
+    assert(mgr != NULL);
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(mgr, "a"));
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(mgr, "b"));
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(mgr, "c"));
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(mgr, "d"));
+    ubuf1 = ubuf_sound_alloc(mgr, 32);
+    assert(ubuf1 != NULL);
+    fill_in(ubuf1);
+
+    struct ubuf_mgr *pair_mgr = ubuf_sound_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 4, 0);
+    assert(pair_mgr != NULL);
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(pair_mgr, "l"));
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(pair_mgr, "r"));
+    const char *pair[] = { "c", "d" };
+    ubuf2 = ubuf_sound_mem_alloc_view(pair_mgr, ubuf1, pair);
+    assert(ubuf2 != NULL);
+    ubase_assert(ubuf_sound_size(ubuf2, &size, &sample_size));
+    assert(size == 32);
+    assert(sample_size == 4);
+
+    const uint8_t *r2;
+    ubase_assert(ubuf_sound_plane_read_uint8_t(ubuf1, "d", 0, -1, &r));
+    ubase_assert(ubuf_sound_plane_read_uint8_t(ubuf2, "r", 0, -1, &r2));
+    assert(r == r2);
+    assert(r2[0] == 'd');
+    ubase_assert(ubuf_sound_plane_unmap(ubuf2, "r", 0, -1));
+    ubase_assert(ubuf_sound_plane_unmap(ubuf1, "d", 0, -1));
+
+    /* windowing the original is reflected in new views */
+    struct ubuf *ubuf3 = ubuf_dup(ubuf1);
+    assert(ubuf3 != NULL);
+    ubase_assert(ubuf_sound_resize(ubuf3, 2, 8));
+    struct ubuf *ubuf4 = ubuf_sound_mem_alloc_view(pair_mgr, ubuf3, pair);
+    assert(ubuf4 != NULL);
+    ubase_assert(ubuf_sound_size(ubuf4, &size, NULL));
+    assert(size == 8);
+    ubase_assert(ubuf_sound_plane_read_uint8_t(ubuf4, "l", 0, -1, &r2));
+    assert(r2[0] == 'c' + 8);
+    ubase_assert(ubuf_sound_plane_unmap(ubuf4, "l", 0, -1));
+    ubuf_free(ubuf3);
+
+    /* writing copies the samples of the view */
+    ubase_assert(ubuf_sound_plane_write_uint8_t(ubuf4, "l", 0, -1, &w));
+    assert(w[0] == 'c' + 8);
+    w[0] = 0;
+    ubase_assert(ubuf_sound_plane_unmap(ubuf4, "l", 0, -1));
+    ubase_assert(ubuf_sound_plane_read_uint8_t(ubuf1, "c", 0, -1, &r));
+    assert(r[8] == 'c' + 8);
+    ubase_assert(ubuf_sound_plane_unmap(ubuf1, "c", 0, -1));
+    ubuf_free(ubuf4);
+
+    /* unknown channels and mismatched sample sizes are refused */
+    const char *wrong[] = { "c", "e" };
+    assert(ubuf_sound_mem_alloc_view(pair_mgr, ubuf1, wrong) == NULL);
+    assert(ubuf_sound_mem_alloc_view(pair_mgr, ubuf1, NULL) == NULL);
+
+    /* once the original is gone, the view is written in place */
+    ubuf_free(ubuf1);
+    ubase_assert(ubuf_sound_plane_read_uint8_t(ubuf2, "l", 0, -1, &r2));
+    ubase_assert(ubuf_sound_plane_unmap(ubuf2, "l", 0, -1));
+    ubase_assert(ubuf_sound_plane_write_uint8_t(ubuf2, "l", 0, -1, &w));
+    assert(w == r2);
+    ubase_assert(ubuf_sound_plane_unmap(ubuf2, "l", 0, -1));
+    ubuf_free(ubuf2);
+
+    ubuf_mgr_release(pair_mgr);
     ubuf_mgr_release(mgr);
     umem_mgr_release(umem_mgr);
     return 0;
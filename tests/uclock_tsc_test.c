@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short unit tests for uclock_tsc implementation
+ */
+
+#undef NDEBUG
+
+#include <upipe/uclock.h>
+#include <upipe/uclock_std.h>
+#include <upipe/uclock_tsc.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <time.h>
+#include <assert.h>
+
+#define NB_READS 1000000
+/* tolerance against the monotonic clock: 1 ms */
+#define TOLERANCE (UCLOCK_FREQ / 1000)
+
+static uint64_t distance(uint64_t a, uint64_t b)
+{
+    return a > b ? a - b : b - a;
+}
+
+static void check(struct uclock *uclock, struct uclock *uclock_std)
+{
+    uint64_t now = uclock_now(uclock);
+    uint64_t now_std = uclock_now(uclock_std);
+    printf("tsc: %"PRIu64" std: %"PRIu64"\n", now, now_std);
+    assert(distance(now, now_std) < TOLERANCE);
+}
+
+int main(int argc, char **argv)
+{
+    struct uclock *uclock = uclock_tsc_alloc();
+    struct uclock *uclock_std = uclock_std_alloc(0);
+    struct uclock *uclock_cal = uclock_std_alloc(UCLOCK_FLAG_REALTIME);
+    assert(uclock != NULL);
+    assert(uclock_std != NULL);
+    assert(uclock_cal != NULL);
+    check(uclock, uclock_std);
+
+    uint64_t last = uclock_now(uclock);
+    for (int i = 0; i < NB_READS; i++) {
+        uint64_t now = uclock_now(uclock);
+        assert(now >= last);
+        last = now;
+    }
+    check(uclock, uclock_std);
+
+    /* wait for a recalibration */
+    struct timespec ts = { .tv_sec = 1, .tv_nsec = 200000000 };
+    nanosleep(&ts, NULL);
+    check(uclock, uclock_std);
+    check(uclock, uclock_std);
+
+    uint64_t real = uclock_to_real(uclock, uclock_now(uclock));
+    assert(distance(real, uclock_now(uclock_cal)) < TOLERANCE);
+    uint64_t now = uclock_now(uclock);
+    assert(distance(uclock_from_real(uclock, uclock_to_real(uclock, now)),
+                    now) < TOLERANCE);
+
+    uclock_release(uclock);
+    uclock_release(uclock_std);
+    uclock_release(uclock_cal);
+    return 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short unit tests for the virtual uclock and virtual timers
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/uclock.h>
+#include <upipe/uclock_std.h>
+#include <upipe/uclock_virtual.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_uclock.h>
+#include <upipe/urequest.h>
+#include <upipe/upump.h>
+#include <upump-uring/upump_uring.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#define UPUMP_POOL 0
+#define UPUMP_BLOCKER_POOL 0
+#define START (UCLOCK_FREQ * 1000)
+#define PERIOD (UCLOCK_FREQ * 3600)
+#define NB_TICKS 24
+#define AFTER (PERIOD * NB_TICKS + 1)
+
+static struct uclock *uclock = NULL;
+static struct upump *upump_tick;
+static unsigned int ticks = 0;
+static bool fired = false;
+
+static int provide_uclock(struct urequest *urequest, va_list args)
+{
+    uclock = va_arg(args, struct uclock *);
+    return UBASE_ERR_NONE;
+}
+
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    return UBASE_ERR_UNHANDLED;
+}
+
+/** periodic timer, started first */
+static void tick(struct upump *upump)
+{
+    ticks++;
+    assert(uclock_now(uclock) == START + ticks * PERIOD);
+    if (ticks == NB_TICKS)
+        upump_stop(upump);
+}
+
+/** one-shot timer, due just after the last tick */
+static void one_shot(struct upump *upump)
+{
+    assert(!fired);
+    assert(ticks == NB_TICKS);
+    assert(uclock_now(uclock) == START + AFTER);
+    fired = true;
+}
+
+int main(int argc, char **argv)
+{
+    struct uclock *uclock_std = uclock_std_alloc(0);
+    assert(uclock_std != NULL);
+    uint64_t real_start = uclock_now(uclock_std);
+
+    struct uclock *vclock = uclock_virtual_alloc(0);
+    assert(vclock != NULL);
+    assert(uclock_now(vclock) == 0);
+    ubase_assert(uclock_virtual_advance(vclock, 42));
+    ubase_assert(uclock_virtual_advance(vclock, 12));
+    assert(uclock_now(vclock) == 42);
+    assert(uclock_from_real(vclock, uclock_to_real(vclock, 42)) == 42);
+    ubase_nassert(uclock_virtual_advance(uclock_std, 42));
+    uclock_release(vclock);
+
+    struct upump_mgr *upump_mgr =
+        upump_uring_mgr_alloc(UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+    ubase_nassert(upump_mgr_set_virtual_clock(upump_mgr, uclock_std));
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *uprobe_uclock =
+        uprobe_uclock_alloc_virtual(uprobe_use(&uprobe), upump_mgr, START);
+    assert(uprobe_uclock != NULL);
+
+    struct urequest urequest;
+    urequest_init_uclock(&urequest, provide_uclock, NULL);
+    ubase_assert(uprobe_throw(uprobe_uclock, NULL, UPROBE_PROVIDE_REQUEST,
+                              &urequest));
+    urequest_clean(&urequest);
+    assert(uclock != NULL);
+    assert(uclock_now(uclock) == START);
+
+    upump_tick = upump_alloc_timer(upump_mgr, tick, NULL, NULL,
+                                   PERIOD, PERIOD);
+    assert(upump_tick != NULL);
+    upump_start(upump_tick);
+    struct upump *upump_one_shot = upump_alloc_timer(upump_mgr, one_shot,
+                                                     NULL, NULL, AFTER, 0);
+    assert(upump_one_shot != NULL);
+    upump_start(upump_one_shot);
+
+    /* a day of virtual time runs instantly */
+    upump_mgr_run(upump_mgr, NULL);
+    assert(ticks == NB_TICKS);
+    assert(fired);
+    assert(uclock_now(uclock) == START + AFTER);
+    assert(uclock_now(uclock_std) - real_start < UCLOCK_FREQ);
+
+    upump_free(upump_tick);
+    upump_free(upump_one_shot);
+    uclock_release(uclock);
+    uprobe_release(uprobe_uclock);
+    uprobe_clean(&uprobe);
+    upump_mgr_release(upump_mgr);
+    uclock_release(uclock_std);
+    return 0;
+}
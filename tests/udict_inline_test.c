@@ -123,6 +123,20 @@ int main(int argc, char **argv)
     struct udict *udict2 = udict_dup(udict1);
     assert(udict2 != NULL);
     udict_dump(udict2, uprobe);
+
+    /* duplicates share their attributes until one of them is modified */
+    ubase_assert(udict_set_bool(udict2, false, UDICT_TYPE_BOOL, "x.truc"));
+    ubase_assert(udict_get_bool(udict2, &b, UDICT_TYPE_BOOL, "x.truc"));
+    assert(!b);
+    ubase_assert(udict_get_bool(udict1, &b, UDICT_TYPE_BOOL, "x.truc"));
+    assert(b);
+    struct udict *udict3 = udict_dup(udict1);
+    assert(udict3 != NULL);
+    ubase_assert(udict_delete(udict3, UDICT_TYPE_INT, "x.date"));
+    ubase_nassert(udict_get_int(udict3, &d, UDICT_TYPE_INT, "x.date"));
+    ubase_assert(udict_get_int(udict1, &d, UDICT_TYPE_INT, "x.date"));
+    assert(d == INT64_MAX);
+    udict_free(udict3);
     udict_free(udict2);
 
     udict2 = udict_copy(mgr, udict1);
@@ -130,6 +144,75 @@ int main(int argc, char **argv)
     udict_dump(udict2, uprobe);
     udict_free(udict2);
 
+    udict_free(udict1);
+
+    /* large dictionaries are looked up through an index */
+    udict1 = udict_alloc(mgr, 0);
+    assert(udict1 != NULL);
+    char name[16];
+    for (int i = 0; i < 64; i++) {
+        snprintf(name, sizeof(name), "x.attr%d", i);
+        ubase_assert(udict_set_unsigned(udict1, i, UDICT_TYPE_UNSIGNED, name));
+        ubase_assert(udict_set_unsigned(udict1, i, UDICT_TYPE_UNSIGNED, name));
+        if (i == 20)
+            ubase_assert(udict_set_void(udict1, NULL, UDICT_TYPE_FLOW_RANDOM,
+                                        NULL));
+        for (int j = 0; j <= i; j++) {
+            snprintf(name, sizeof(name), "x.attr%d", j);
+            ubase_assert(udict_get_unsigned(udict1, &u, UDICT_TYPE_UNSIGNED,
+                                            name));
+            assert(u == j);
+        }
+        ubase_nassert(udict_get_unsigned(udict1, &u, UDICT_TYPE_UNSIGNED,
+                                         "x.none"));
+        ubase_nassert(udict_get_void(udict1, NULL, UDICT_TYPE_FLOW_ERROR,
+                                     NULL));
+        assert(ubase_check(udict_get_void(udict1, NULL, UDICT_TYPE_FLOW_RANDOM,
+                                          NULL)) == (i >= 20));
+    }
+    udict2 = udict_dup(udict1);
+    assert(udict2 != NULL);
+    for (int i = 0; i < 64; i += 2) {
+        snprintf(name, sizeof(name), "x.attr%d", i);
+        ubase_assert(udict_delete(udict2, UDICT_TYPE_UNSIGNED, name));
+    }
+    for (int i = 0; i < 64; i++) {
+        snprintf(name, sizeof(name), "x.attr%d", i);
+        ubase_assert(udict_get_unsigned(udict1, &u, UDICT_TYPE_UNSIGNED, name));
+        assert(u == i);
+        assert(ubase_check(udict_get_unsigned(udict2, &u, UDICT_TYPE_UNSIGNED,
+                                              name)) == (i % 2));
+    }
+    udict_free(udict2);
+    udict_free(udict1);
+
+    /* hashes don't depend on the order of the attributes */
+    udict1 = udict_alloc(mgr, 0);
+    assert(udict1 != NULL);
+    udict2 = udict_alloc(mgr, 0);
+    assert(udict2 != NULL);
+    ubase_assert(udict_set_string(udict1, "pouet", UDICT_TYPE_FLOW_DEF, NULL));
+    ubase_assert(udict_set_bool(udict1, true, UDICT_TYPE_BOOL, "x.truc"));
+    ubase_assert(udict_set_bool(udict2, true, UDICT_TYPE_BOOL, "x.truc"));
+    ubase_assert(udict_set_string(udict2, "pouet", UDICT_TYPE_FLOW_DEF, NULL));
+    uint64_t hash1, hash2;
+    ubase_assert(udict_hash(udict1, &hash1));
+    ubase_assert(udict_hash(udict2, &hash2));
+    assert(hash1 == hash2);
+    assert(udict_equal_fast(udict1, udict2));
+    ubase_assert(udict_set_bool(udict2, false, UDICT_TYPE_BOOL, "x.truc"));
+    ubase_assert(udict_hash(udict2, &hash2));
+    assert(hash1 != hash2);
+    assert(!udict_equal_fast(udict1, udict2));
+    udict_free(udict2);
+    udict2 = udict_dup(udict1);
+    assert(udict2 != NULL);
+    ubase_assert(udict_hash(udict2, &hash2));
+    assert(hash1 == hash2);
+    assert(udict_equal_fast(udict1, udict2));
+    ubase_assert(udict_delete(udict2, UDICT_TYPE_BOOL, "x.truc"));
+    assert(!udict_equal_fast(udict1, udict2));
+    udict_free(udict2);
     udict_free(udict1);
     udict_mgr_release(mgr);
 
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for uheap
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/uheap.h>
+
+#include <stdlib.h>
+#include <assert.h>
+
+#define NB_ELEMS 100
+
+struct elem {
+    struct uheap_node node;
+    unsigned int value;
+};
+
+UBASE_FROM_TO(elem, uheap_node, node, node)
+
+int main(int argc, char **argv)
+{
+    struct elem elems[NB_ELEMS];
+    struct uheap uheap;
+    uheap_init(&uheap);
+    assert(uheap_empty(&uheap));
+    assert(uheap_pop(&uheap) == NULL);
+
+    srand(42);
+    for (unsigned int i = 0; i < NB_ELEMS; i++) {
+        uheap_node_init(&elems[i].node);
+        assert(!uheap_node_is_in(&elems[i].node));
+        elems[i].value = i;
+        ubase_assert(uheap_push(&uheap, &elems[i].node, rand() % 1000));
+        assert(uheap_node_is_in(&elems[i].node));
+    }
+    assert(uheap_size(&uheap) == NB_ELEMS);
+
+    /* remove every third element, and move some others */
+    for (unsigned int i = 0; i < NB_ELEMS; i += 3)
+        uheap_delete(&uheap, &elems[i].node);
+    for (unsigned int i = 1; i < NB_ELEMS; i += 3)
+        uheap_update(&uheap, &elems[i].node, rand() % 1000);
+    assert(uheap_size(&uheap) == NB_ELEMS - (NB_ELEMS + 2) / 3);
+
+    uint64_t last = 0;
+    unsigned int nb = 0;
+    struct uheap_node *node;
+    while ((node = uheap_pop(&uheap)) != NULL) {
+        struct elem *elem = elem_from_node(node);
+        assert(elem->value % 3);
+        assert(node->key >= last);
+        assert(!uheap_node_is_in(node));
+        last = node->key;
+        nb++;
+    }
+    assert(nb == NB_ELEMS - (NB_ELEMS + 2) / 3);
+
+    ubase_assert(uheap_push(&uheap, &elems[0].node, 10));
+    ubase_assert(uheap_push(&uheap, &elems[1].node, 5));
+    assert(uheap_peek(&uheap) == &elems[1].node);
+    assert(uheap_at(&uheap, 2) == NULL);
+    uheap_clean(&uheap);
+    assert(uheap_empty(&uheap));
+    assert(!uheap_node_is_in(&elems[0].node));
+    return 0;
+}
@@ -177,6 +177,27 @@ int main(int argc, char **argv)
     }
 
     assert(uqueue_init(&uqueue, UQUEUE_MAX_DEPTH, uqueue_buffer));
+
+    /* batch operations */
+    void *batch[UQUEUE_MAX_DEPTH + 2];
+    for (int i = 0; i < UQUEUE_MAX_DEPTH + 2; i++)
+        batch[i] = &elems[i].uchain;
+    assert(uqueue_push_batch(&uqueue, batch, UQUEUE_MAX_DEPTH + 2) ==
+           UQUEUE_MAX_DEPTH);
+    assert(uqueue_length(&uqueue) == UQUEUE_MAX_DEPTH);
+    assert(uqueue_push_batch(&uqueue, batch, 1) == 0);
+    memset(batch, 0, sizeof(batch));
+    assert(uqueue_pop_batch(&uqueue, batch, 2) == 2);
+    assert(batch[0] == &elems[0].uchain);
+    assert(batch[1] == &elems[1].uchain);
+    assert(uqueue_pop_batch(&uqueue, batch, UQUEUE_MAX_DEPTH + 2) ==
+           UQUEUE_MAX_DEPTH - 2);
+    assert(batch[0] == &elems[2].uchain);
+    assert(uqueue_length(&uqueue) == 0);
+    assert(uqueue_pop_batch(&uqueue, batch, 1) == 0);
+
+    /* the reader busy-polls a little before blocking */
+    uqueue_set_wait_policy(&uqueue, 10000, 1);
     struct upump *upump = uqueue_upump_alloc_pop(&uqueue, upump_mgr, pop, NULL,
                                                  NULL);
     assert(upump != NULL);
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for umem manager carving buffers out of hugepage arenas
+ */
+
+#undef NDEBUG
+
+#include <upipe/umem.h>
+#include <upipe/umem_hugepage.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#define ARENA_SIZE (4 << 20)
+
+int main(int argc, char **argv)
+{
+    struct umem_mgr *mgr = umem_hugepage_mgr_alloc_simple(ARENA_SIZE, 0, 32);
+    assert(mgr != NULL);
+
+    struct umem umem;
+    assert(umem_alloc(mgr, &umem, 42));
+    uint8_t *p = umem_buffer(&umem);
+    assert(p != NULL);
+    assert(((uintptr_t)p & 63) == 0);
+    memset(p, 0x42, 42);
+    printf("Passed 1\n");
+
+    assert(umem_realloc(&umem, 8192));
+    p = umem_buffer(&umem);
+    assert(p != NULL);
+    assert(p[0] == 0x42);
+    assert(p[41] == 0x42);
+    memset(p + 42, 0x43, 8192 - 42);
+    printf("Passed 2\n");
+
+    assert(umem_realloc(&umem, 64));
+    assert(umem_buffer(&umem) == p);
+    umem_free(&umem);
+    printf("Passed 3\n");
+
+    /* buffers are recycled in their pool */
+    assert(umem_alloc(mgr, &umem, 8192));
+    assert(umem_buffer(&umem) == p);
+    umem_free(&umem);
+    printf("Passed 4\n");
+
+    /* exhaust the 2 Mi pool, then revert to malloc */
+    struct umem umems[5];
+    for (int i = 0; i < 5; i++) {
+        assert(umem_alloc(mgr, &umems[i], 2 << 20));
+        memset(umem_buffer(&umems[i]), i, 2 << 20);
+    }
+    for (int i = 0; i < 5; i++) {
+        assert(umem_buffer(&umems[i])[(2 << 20) - 1] == i);
+        umem_free(&umems[i]);
+    }
+    printf("Passed 5\n");
+
+    umem_mgr_release(mgr);
+
+    /* node-bound arena */
+    assert(UMEM_HUGEPAGE_FLAGS_NODE(0) == -1);
+    assert(UMEM_HUGEPAGE_FLAGS_NODE(UMEM_HUGEPAGE_NODE(0) |
+                                    UMEM_HUGEPAGE_1G) == 0);
+    mgr = umem_hugepage_mgr_alloc_simple(ARENA_SIZE, UMEM_HUGEPAGE_NODE(0), 32);
+    assert(mgr != NULL);
+    assert(umem_alloc(mgr, &umem, 4096));
+    memset(umem_buffer(&umem), 0x42, 4096);
+    umem_free(&umem);
+    umem_mgr_release(mgr);
+    printf("Passed 6\n");
+    return 0;
+}
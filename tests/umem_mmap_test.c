@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for umem manager using memory mappings
+ */
+
+#undef NDEBUG
+
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/umem_mmap.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+
+#define UBUF_POOL_DEPTH 1
+#define FILE_SIZE 20000
+
+int main(int argc, char **argv)
+{
+    struct umem_mgr *mgr = umem_mmap_mgr_alloc();
+    assert(mgr != NULL);
+    size_t page_size = umem_mmap_page_size();
+    assert(page_size && !(page_size & (page_size - 1)));
+
+    struct umem umem;
+    assert(umem_alloc(mgr, &umem, 42));
+    uint8_t *p = umem_buffer(&umem);
+    assert(p != NULL);
+    memset(p, 0x42, 42);
+    assert(umem_realloc(&umem, 3 * page_size));
+    p = umem_buffer(&umem);
+    assert(p[0] == 0x42);
+    assert(p[41] == 0x42);
+    memset(p, 0x43, 3 * page_size);
+    umem_free(&umem);
+    printf("Passed 1\n");
+
+    char path[] = "/tmp/umem_mmap_test.XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    unlink(path);
+    uint8_t data[FILE_SIZE];
+    for (int i = 0; i < FILE_SIZE; i++)
+        data[i] = i % 251;
+    assert(write(fd, data, FILE_SIZE) == FILE_SIZE);
+
+    assert(!umem_mmap_file(&umem, fd, 1, FILE_SIZE - 1));
+    assert(umem_mmap_file(&umem, fd, page_size, FILE_SIZE - page_size));
+    assert(umem_size(&umem) == FILE_SIZE - page_size);
+    assert(!memcmp(umem_buffer(&umem), data + page_size,
+                   FILE_SIZE - page_size));
+    /* the mapping is private */
+    umem_buffer(&umem)[0] = 0;
+    uint8_t byte;
+    assert(pread(fd, &byte, 1, page_size) == 1);
+    assert(byte == data[page_size]);
+    printf("Passed 2\n");
+
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, -1, 0, -1, 0);
+    assert(ubuf_mgr != NULL);
+    struct ubuf *ubuf = ubuf_block_mem_alloc_from_umem(ubuf_mgr, &umem);
+    assert(ubuf != NULL);
+    size_t size;
+    assert(ubase_check(ubuf_block_size(ubuf, &size)));
+    assert(size == FILE_SIZE - page_size);
+
+    struct ubuf *ubuf2 = ubuf_dup(ubuf);
+    assert(ubuf2 != NULL);
+    ubuf_free(ubuf);
+    assert(ubase_check(ubuf_block_resize(ubuf2, 100, 200)));
+    const uint8_t *r;
+    int rsize = -1;
+    assert(ubase_check(ubuf_block_read(ubuf2, 0, &rsize, &r)));
+    assert(rsize == 200);
+    assert(!memcmp(r, data + page_size + 100, 200));
+    assert(ubase_check(ubuf_block_unmap(ubuf2, 0)));
+    ubuf_free(ubuf2);
+    printf("Passed 3\n");
+
+    ubuf_mgr_release(ubuf_mgr);
+    umem_mgr_release(umem_mgr);
+    umem_mgr_release(mgr);
+    close(fd);
+    return 0;
+}
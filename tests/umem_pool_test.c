@@ -32,11 +32,94 @@
 #include <upipe/umem.h>
 #include <upipe/umem_pool.h>
 
+#include <upipe/ubase.h>
+
 #include <stdint.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
 
+#define ADAPTIVE_MEMORY 512
+#define ADAPTIVE_DEPTH 16
+#define ADAPTIVE_WINDOW 8
+#define BURST 4
+#define BIG_BURST 10
+
+/** allocates and releases a burst of buffers */
+static void burst(struct umem_mgr *mgr, size_t size, unsigned int nb,
+                  uint8_t **buffers)
+{
+    struct umem umems[nb];
+    for (unsigned int i = 0; i < nb; i++) {
+        assert(umem_alloc(mgr, &umems[i], size));
+        if (buffers != NULL)
+            buffers[i] = umem_buffer(&umems[i]);
+    }
+    for (unsigned int i = 0; i < nb; i++)
+        umem_free(&umems[i]);
+}
+
+/** checks the state of an adaptive pool */
+static void check_pool(struct umem_mgr *mgr, unsigned int pool,
+                       unsigned int depth, unsigned int cached)
+{
+    struct umem_pool_stats stats;
+    ubase_assert(umem_pool_mgr_get_pool_stats(mgr, pool, &stats));
+    assert(stats.size == (size_t)32 << pool);
+    assert(stats.depth == depth);
+    assert(stats.cached == cached);
+    assert(stats.in_use == 0);
+}
+
+static void test_adaptive(void)
+{
+    struct umem_mgr *mgr = umem_pool_mgr_alloc_adaptive(32, 4,
+            ADAPTIVE_MEMORY, ADAPTIVE_DEPTH, ADAPTIVE_WINDOW);
+    assert(mgr != NULL);
+    ubase_nassert(umem_pool_mgr_get_pool_stats(mgr, 4, NULL));
+    check_pool(mgr, 0, 0, 0);
+
+    /* pools start empty, and grow to the peak usage of the first window */
+    for (unsigned int i = 0; i < ADAPTIVE_WINDOW / BURST; i++)
+        burst(mgr, 32, BURST, NULL);
+    check_pool(mgr, 0, BURST, BURST);
+
+    /* the steady state is served from the pool */
+    uint8_t *first[BURST], *again[BURST];
+    burst(mgr, 32, BURST, first);
+    for (unsigned int i = 0; i < ADAPTIVE_WINDOW / BURST; i++)
+        burst(mgr, 32, BURST, again);
+    for (unsigned int i = 0; i < BURST; i++) {
+        bool found = false;
+        for (unsigned int j = 0; j < BURST; j++)
+            found = found || again[i] == first[j];
+        assert(found);
+    }
+    check_pool(mgr, 0, BURST, BURST);
+
+    /* growth is bounded by the memory left */
+    burst(mgr, 64, BIG_BURST, NULL);
+    unsigned int room = (ADAPTIVE_MEMORY - BURST * 32) / 64;
+    check_pool(mgr, 1, room, room);
+    uint64_t reserved, max;
+    ubase_assert(umem_pool_mgr_get_memory(mgr, &reserved, &max));
+    assert(reserved == ADAPTIVE_MEMORY);
+    assert(max == ADAPTIVE_MEMORY);
+
+    /* an idle pool shrinks halfway at each window */
+    for (unsigned int i = 0; i < 2 * ADAPTIVE_WINDOW; i++)
+        burst(mgr, 32, 1, NULL);
+    check_pool(mgr, 0, (BURST + 1) / 2, (BURST + 1) / 2);
+    ubase_assert(umem_pool_mgr_get_memory(mgr, &reserved, &max));
+    assert(reserved == (BURST + 1) / 2 * 32 + room * 64);
+
+    umem_mgr_vacuum(mgr);
+    check_pool(mgr, 0, (BURST + 1) / 2, 0);
+    umem_mgr_release(mgr);
+    printf("Passed adaptive\n");
+}
+
 int main(int argc, char **argv)
 {
     struct umem_mgr *mgr = umem_pool_mgr_alloc_simple(32);
@@ -88,5 +171,7 @@ int main(int argc, char **argv)
     printf("Passed 6\n");
 
     umem_mgr_release(mgr);
+
+    test_adaptive();
     return 0;
 }
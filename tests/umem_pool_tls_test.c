@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for umem pool manager with per-thread magazines
+ */
+
+#undef NDEBUG
+
+#include <upipe/umem.h>
+#include <upipe-pthread/umem_pool_tls.h>
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#define NB_THREADS 4
+#define NB_LOOPS 1000
+#define NB_BUFFERS 16
+#define MAGAZINE_SIZE 8
+
+static struct umem_mgr *mgr;
+
+static void *thread_entry(void *unused)
+{
+    struct umem umems[NB_BUFFERS];
+    for (int i = 0; i < NB_LOOPS; i++) {
+        for (int j = 0; j < NB_BUFFERS; j++) {
+            assert(umem_alloc(mgr, &umems[j], 1316));
+            memset(umem_buffer(&umems[j]), j, 1316);
+        }
+        for (int j = 0; j < NB_BUFFERS; j++) {
+            assert(umem_buffer(&umems[j])[1315] == j);
+            umem_free(&umems[j]);
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    mgr = umem_pool_mgr_alloc_tls_simple(32, MAGAZINE_SIZE);
+    assert(mgr != NULL);
+
+    struct umem_mgr_stats stats;
+    ubase_assert(umem_mgr_get_stats(mgr, &stats));
+    assert(stats.hits == 0);
+    assert(stats.misses == 0);
+    assert(stats.fallbacks == 0);
+
+    struct umem umem;
+    assert(umem_alloc(mgr, &umem, 42));
+    uint8_t *p = umem_buffer(&umem);
+    assert(p != NULL);
+    memset(p, 0x42, 42);
+    ubase_assert(umem_mgr_get_stats(mgr, &stats));
+    assert(stats.misses == 1);
+    assert(stats.fallbacks == 1);
+    printf("Passed 1\n");
+
+    assert(umem_realloc(&umem, 8192));
+    p = umem_buffer(&umem);
+    assert(p[0] == 0x42);
+    assert(p[41] == 0x42);
+    umem_free(&umem);
+    printf("Passed 2\n");
+
+    /* the buffer is now in the magazine of this thread */
+    assert(umem_alloc(mgr, &umem, 8000));
+    assert(umem_buffer(&umem) == p);
+    ubase_assert(umem_mgr_get_stats(mgr, &stats));
+    assert(stats.hits == 1);
+    umem_free(&umem);
+    printf("Passed 3\n");
+
+    pthread_t threads[NB_THREADS];
+    for (int i = 0; i < NB_THREADS; i++)
+        assert(pthread_create(&threads[i], NULL, thread_entry, NULL) == 0);
+    for (int i = 0; i < NB_THREADS; i++)
+        assert(pthread_join(threads[i], NULL) == 0);
+
+    ubase_assert(umem_mgr_get_stats(mgr, &stats));
+    printf("hits %"PRIu64" misses %"PRIu64" fallbacks %"PRIu64"\n",
+           stats.hits, stats.misses, stats.fallbacks);
+    assert(stats.hits + stats.misses >= NB_THREADS * NB_LOOPS * NB_BUFFERS);
+    /* most allocations must not touch the shared pools */
+    assert(stats.misses < NB_THREADS * NB_LOOPS * NB_BUFFERS / 2);
+    printf("Passed 4\n");
+
+    umem_mgr_vacuum(mgr);
+    umem_mgr_release(mgr);
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short unit tests for umem_ring manager
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/umem.h>
+#include <upipe/umem_ring.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#define RING_SIZE 1024
+#define NB_CHUNKS 8
+
+int main(int argc, char **argv)
+{
+    struct umem_mgr *mgr = umem_ring_mgr_alloc(RING_SIZE);
+    assert(mgr != NULL);
+
+    struct umem_mgr_stats stats;
+    ubase_assert(umem_mgr_get_stats(mgr, &stats));
+    assert(stats.hits == 0);
+    assert(stats.fallbacks == 0);
+
+    /* each 64-octet buffer takes 128 octets in the ring */
+    struct umem umems[NB_CHUNKS];
+    for (int i = 0; i < NB_CHUNKS; i++) {
+        assert(umem_alloc(mgr, &umems[i], 64));
+        assert(((uintptr_t)umem_buffer(&umems[i]) & 63) == 0);
+        memset(umem_buffer(&umems[i]), i, 64);
+    }
+    ubase_assert(umem_mgr_get_stats(mgr, &stats));
+    assert(stats.hits == NB_CHUNKS);
+    assert(stats.fallbacks == 0);
+
+    /* the ring is full */
+    struct umem umem;
+    assert(umem_alloc(mgr, &umem, 64));
+    ubase_assert(umem_mgr_get_stats(mgr, &stats));
+    assert(stats.fallbacks == 1);
+    umem_free(&umem);
+
+    /* space released out of order is not reclaimed before the tail */
+    uint8_t *first = umem_buffer(&umems[0]);
+    umem_free(&umems[3]);
+    assert(umem_alloc(mgr, &umem, 64));
+    assert(umem_buffer(&umem) != umem_buffer(&umems[3]));
+    ubase_assert(umem_mgr_get_stats(mgr, &stats));
+    assert(stats.fallbacks == 2);
+    umem_free(&umem);
+
+    /* releasing the tail makes its space available again */
+    umem_free(&umems[0]);
+    assert(umem_alloc(mgr, &umems[0], 64));
+    assert(umem_buffer(&umems[0]) == first);
+    ubase_assert(umem_mgr_get_stats(mgr, &stats));
+    assert(stats.hits == NB_CHUNKS + 1);
+
+    for (int i = 0; i < NB_CHUNKS; i++) {
+        if (i == 3)
+            continue;
+        assert(umem_buffer(&umems[i])[63] == i);
+        umem_free(&umems[i]);
+    }
+
+    /* a buffer which doesn't fit before the end of the ring wraps around */
+    for (int i = 0; i < 6; i++)
+        assert(umem_alloc(mgr, &umems[i], 64));
+    assert(umem_buffer(&umems[0]) == first);
+    for (int i = 0; i < 3; i++)
+        umem_free(&umems[i]);
+    assert(umem_alloc(mgr, &umem, 256));
+    assert(umem_buffer(&umem) == first);
+    memset(umem_buffer(&umem), 0x42, 256);
+    ubase_assert(umem_mgr_get_stats(mgr, &stats));
+    assert(stats.hits == NB_CHUNKS + 1 + 7);
+    assert(stats.fallbacks == 2);
+
+    /* resizing within the reserved space keeps the buffer in place */
+    assert(umem_realloc(&umem, 200));
+    assert(umem_buffer(&umem) == first);
+    assert(umem_realloc(&umem, 256));
+    assert(umem_buffer(&umem) == first);
+
+    /* growing beyond it moves the buffer out of the ring */
+    assert(umem_realloc(&umem, 4096));
+    assert(umem_buffer(&umem) != first);
+    assert(umem_buffer(&umem)[0] == 0x42);
+    assert(umem_buffer(&umem)[255] == 0x42);
+
+    /* the moved buffer released its chunk */
+    for (int i = 3; i < 6; i++)
+        umem_free(&umems[i]);
+    struct umem umem2;
+    assert(umem_alloc(mgr, &umem2, RING_SIZE - 64));
+    assert(umem_buffer(&umem2) == first);
+    umem_free(&umem2);
+    umem_free(&umem);
+
+    umem_mgr_release(mgr);
+    return 0;
+}
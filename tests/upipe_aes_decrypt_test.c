@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for AES-128-CBC decryption pipe
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/upipe.h>
+#include <upipe-modules/upipe_aes_decrypt.h>
+#include <upipe-modules/uref_aes_flow.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH    5
+#define UREF_POOL_DEPTH     5
+#define UBUF_POOL_DEPTH     5
+#define UBUF_PREPEND        0
+#define UBUF_APPEND         0
+#define UBUF_ALIGN          32
+#define UBUF_ALIGN_OFFSET   0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+
+#define SIZE                160
+#define RUNS                3
+
+/** key and initialization vector of NIST SP 800-38A F.2 */
+static const uint8_t key[16] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+static const uint8_t iv[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+
+/** octets i * 7 for i in [0, SIZE[ encrypted with the key and iv above */
+static const uint8_t cipher[SIZE] = {
+    0x7f, 0x80, 0x7b, 0x31, 0x17, 0x07, 0xf7, 0x22,
+    0xe7, 0xe2, 0x37, 0xb6, 0x5a, 0x78, 0xa5, 0x37,
+    0xb5, 0x27, 0xff, 0x95, 0x0c, 0xaf, 0xb2, 0xb0,
+    0x93, 0xd2, 0xd2, 0x05, 0x2c, 0xf2, 0x7f, 0xd4,
+    0x9d, 0x48, 0x1d, 0x5e, 0xf9, 0xb1, 0x16, 0xb3,
+    0x6e, 0x7b, 0x5b, 0x12, 0x53, 0xe8, 0xc4, 0x9c,
+    0xf6, 0xe2, 0x33, 0x3b, 0xbe, 0x81, 0x60, 0xbd,
+    0xb1, 0xf5, 0x5d, 0xf6, 0xaa, 0x8b, 0x41, 0x5a,
+    0x6c, 0xfe, 0xfc, 0x86, 0x15, 0x2e, 0x49, 0x74,
+    0x0a, 0xb0, 0x54, 0xb2, 0x04, 0xdc, 0x27, 0x6b,
+    0xda, 0x61, 0x3b, 0xc7, 0x37, 0xf3, 0x33, 0xc2,
+    0xfe, 0x1a, 0x20, 0x08, 0x55, 0xb9, 0x2c, 0xe4,
+    0xc5, 0xfa, 0x05, 0x3f, 0x6d, 0xa6, 0x00, 0x9b,
+    0xa2, 0x5d, 0xfc, 0xa8, 0x2f, 0x8b, 0xc7, 0x01,
+    0x51, 0x16, 0x67, 0xa5, 0x79, 0xb2, 0x38, 0xc4,
+    0x45, 0x49, 0xf5, 0x39, 0x4d, 0x95, 0xcd, 0x93,
+    0x6f, 0x5d, 0xfb, 0x6e, 0xb8, 0x0f, 0x59, 0x80,
+    0xfa, 0xf9, 0x5b, 0xc9, 0xaa, 0xf0, 0x8e, 0x23,
+    0xda, 0x5e, 0x4f, 0x96, 0x64, 0xc2, 0xbe, 0x15,
+    0xcb, 0x1a, 0xeb, 0x1c, 0x13, 0x4c, 0xe2, 0x5c
+};
+
+static struct uref_mgr *uref_mgr;
+static struct ubuf_mgr *ubuf_mgr;
+static size_t received = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    assert(size % 16 == 0);
+    for (size_t offset = 0; offset < size; offset++, received++) {
+        uint8_t octet;
+        ubase_assert(uref_block_extract(uref, offset, 1, &octet));
+        assert(octet == (uint8_t)((received % SIZE) * 7));
+    }
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_SET_FLOW_DEF:
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** sets a new flow definition, restarting the decryption */
+static void test_flow_def(struct upipe *upipe)
+{
+    struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr, "aes.");
+    assert(flow_def != NULL);
+    ubase_assert(uref_aes_set_method(flow_def, "AES-128"));
+    ubase_assert(uref_aes_set_key(flow_def, key, sizeof (key)));
+    ubase_assert(uref_aes_set_iv(flow_def, iv, sizeof (iv)));
+    ubase_assert(upipe_set_flow_def(upipe, flow_def));
+    uref_free(flow_def);
+}
+
+/** sends a part of the encrypted stream */
+static void test_send(struct upipe *upipe, size_t offset, size_t size,
+                      bool shared)
+{
+    struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, size);
+    assert(uref != NULL);
+    uint8_t *buffer;
+    int wsize = size;
+    ubase_assert(uref_block_write(uref, 0, &wsize, &buffer));
+    assert(wsize == (int)size);
+    memcpy(buffer, cipher + offset, size);
+    uref_block_unmap(uref, 0);
+
+    struct uref *dup = NULL;
+    if (shared) {
+        dup = uref_dup(uref);
+        assert(dup != NULL);
+    }
+    upipe_input(upipe, uref, NULL);
+    if (dup != NULL) {
+        /* the encrypted buffer must not have been modified */
+        uint8_t copy[size];
+        ubase_assert(uref_block_extract(dup, 0, size, copy));
+        assert(!memcmp(copy, cipher + offset, size));
+        uref_free(dup);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    printf("Compiled %s %s - %s\n", __DATE__, __TIME__, __FILE__);
+
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr =
+        udict_inline_mgr_alloc(UDICT_POOL_DEPTH, umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH,
+                                        umem_mgr, UBUF_PREPEND, UBUF_APPEND,
+                                        UBUF_ALIGN, UBUF_ALIGN_OFFSET);
+    assert(ubuf_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    struct upipe *sink = upipe_void_alloc(&test_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "sink"));
+    assert(sink != NULL);
+
+    struct upipe_mgr *upipe_aes_decrypt_mgr = upipe_aes_decrypt_mgr_alloc();
+    assert(upipe_aes_decrypt_mgr != NULL);
+    struct upipe *aes_decrypt = upipe_void_alloc(upipe_aes_decrypt_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "aes"));
+    assert(aes_decrypt != NULL);
+    ubase_assert(upipe_set_output(aes_decrypt, sink));
+
+    /* contiguous buffer, decrypted in place */
+    test_flow_def(aes_decrypt);
+    test_send(aes_decrypt, 0, SIZE, false);
+    assert(received == SIZE);
+
+    /* segmented buffers, with blocks spanning several segments */
+    static const size_t sizes[] = { 5, 27, 33, 95 };
+    test_flow_def(aes_decrypt);
+    for (size_t i = 0, offset = 0; i < UBASE_ARRAY_SIZE(sizes); i++) {
+        test_send(aes_decrypt, offset, sizes[i], false);
+        offset += sizes[i];
+    }
+    assert(received == 2 * SIZE);
+
+    /* shared buffer, decrypted to a new buffer */
+    test_flow_def(aes_decrypt);
+    test_send(aes_decrypt, 0, SIZE, true);
+    assert(received == RUNS * SIZE);
+
+    upipe_release(aes_decrypt);
+    upipe_mgr_release(upipe_aes_decrypt_mgr);
+    upipe_release(sink);
+
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
@@ -44,7 +44,9 @@
 #include <upipe/uref_flow.h>
 #include <upipe/uref_block_flow.h>
 #include <upipe/uref_block.h>
+#include <upipe/uref_clock.h>
 #include <upipe/uref_std.h>
+#include <upipe/uclock.h>
 #include <upipe/upipe.h>
 #include <upipe-modules/upipe_aggregate.h>
 
@@ -73,6 +75,7 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
         case UPROBE_READY:
         case UPROBE_DEAD:
         case UPROBE_NEW_FLOW_DEF:
+        case UPROBE_NEED_UPUMP_MGR:
             break;
     }
     return UBASE_ERR_NONE;
@@ -189,6 +192,20 @@ int main(int argc, char *argv[])
     upipe_input(upipe_agg, uref, NULL);
     assert(nb_packets == 1);
 
+    /* the maximum delay bounds the output latency */
+    uint64_t max_delay, latency;
+    ubase_assert(upipe_agg_get_max_delay(upipe_agg, &max_delay));
+    assert(max_delay == 0);
+    ubase_assert(upipe_get_flow_def(upipe_agg, &uref));
+    assert(!ubase_check(uref_clock_get_latency(uref, &latency)));
+    ubase_assert(upipe_agg_set_max_delay(upipe_agg, UCLOCK_FREQ / 100));
+    ubase_assert(upipe_agg_get_max_delay(upipe_agg, &max_delay));
+    assert(max_delay == UCLOCK_FREQ / 100);
+    ubase_assert(upipe_get_flow_def(upipe_agg, &uref));
+    ubase_assert(uref_clock_get_latency(uref, &latency));
+    assert(latency == UCLOCK_FREQ / 100);
+    assert(nb_packets == 1);
+
     /* flush */
     upipe_release(upipe_agg);
 
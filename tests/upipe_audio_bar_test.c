@@ -37,12 +37,14 @@
 #include <upipe/ubuf_block.h>
 #include <upipe/ubuf_block_mem.h>
 #include <upipe/uref.h>
+#include <upipe/uref_pic.h>
 #include <upipe/uref_pic_flow.h>
 #include <upipe/uref_sound_flow.h>
 #include <upipe/uref_flow.h>
 #include <upipe/uref_std.h>
 #include <upipe/uref_dump.h>
 #include <upipe/uref_clock.h>
+#include <upipe/uclock.h>
 #include <upipe-filters/upipe_audio_bar.h>
 #include <upipe-filters/upipe_audio_max.h>
 
@@ -60,6 +62,7 @@
 #define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
 
 static bool got_uref = false;
+static struct uref *output = NULL;
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe, int event, va_list args)
@@ -93,7 +96,8 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     assert(uref != NULL);
     upipe_dbg(upipe, "===> received input uref");
     uref_dump(uref, upipe->uprobe);
-    uref_free(uref);
+    uref_free(output);
+    output = uref;
     got_uref = true;
 }
 
@@ -133,6 +137,78 @@ static struct upipe_mgr audiobar_test_mgr = {
     .upipe_control = test_control
 };
 
+/** allocates an audiobar pipe with a 100x100 picture and 2 channels */
+static struct upipe *audiobar_alloc(struct uref_mgr *uref_mgr,
+                                    struct uprobe *logger,
+                                    struct upipe *audiobar_test,
+                                    const char *name)
+{
+    struct uref *uref = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(uref);
+    ubase_assert(uref_pic_flow_set_hsize(uref, 100));
+    ubase_assert(uref_pic_flow_set_vsize(uref, 100));
+
+    struct upipe_mgr *upipe_audiobar_mgr = upipe_audiobar_mgr_alloc();
+    assert(upipe_audiobar_mgr);
+    struct upipe *audiobar = upipe_flow_alloc(upipe_audiobar_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, name),
+            uref);
+    uref_free(uref);
+    assert(audiobar);
+    upipe_mgr_release(upipe_audiobar_mgr);
+    ubase_assert(upipe_set_output(audiobar, audiobar_test));
+
+    uref = uref_sound_flow_alloc_def(uref_mgr, "s16.", 2, 2);
+    assert(uref);
+    ubase_assert(uref_sound_flow_add_plane(uref, "l"));
+    ubase_assert(uref_sound_flow_add_plane(uref, "r"));
+    ubase_assert(upipe_set_flow_def(audiobar, uref));
+    uref_free(uref);
+    return audiobar;
+}
+
+/** sends the amplitudes of both channels to an audiobar pipe */
+static struct uref *audiobar_send(struct upipe *audiobar,
+                                  struct uref_mgr *uref_mgr,
+                                  double left, double right, uint64_t pts)
+{
+    struct uref *uref = uref_alloc(uref_mgr);
+    assert(uref);
+    ubase_assert(uref_amax_set_amplitude(uref, left, 0));
+    ubase_assert(uref_amax_set_amplitude(uref, right, 1));
+    uref_clock_set_pts_prog(uref, pts);
+    got_uref = false;
+    upipe_input(audiobar, uref, NULL);
+    assert(got_uref);
+    uref = output;
+    output = NULL;
+    return uref;
+}
+
+/** checks that two pictures are identical */
+static void compare(struct uref *uref1, struct uref *uref2)
+{
+    static const char *chroma[4] = { "y8", "u8", "v8", "a8" };
+    for (int i = 0; i < 4; i++) {
+        const uint8_t *buf1, *buf2;
+        size_t stride1, stride2;
+        uint8_t hsub, vsub;
+        ubase_assert(uref_pic_plane_size(uref1, chroma[i], &stride1,
+                                         &hsub, &vsub, NULL));
+        ubase_assert(uref_pic_plane_size(uref2, chroma[i], &stride2,
+                                         NULL, NULL, NULL));
+        ubase_assert(uref_pic_plane_read(uref1, chroma[i], 0, 0, -1, -1,
+                                         &buf1));
+        ubase_assert(uref_pic_plane_read(uref2, chroma[i], 0, 0, -1, -1,
+                                         &buf2));
+        for (int row = 0; row < 100 / vsub; row++)
+            assert(!memcmp(buf1 + row * stride1, buf2 + row * stride2,
+                           100 / hsub));
+        ubase_assert(uref_pic_plane_unmap(uref1, chroma[i], 0, 0, -1, -1));
+        ubase_assert(uref_pic_plane_unmap(uref2, chroma[i], 0, 0, -1, -1));
+    }
+}
+
 int main(int argc, char **argv)
 {
     printf("Compiled %s %s - %s\n", __DATE__, __TIME__, __FILE__);
@@ -193,7 +269,35 @@ int main(int argc, char **argv)
     /* Now send uref */
     upipe_input(audiobar, uref, NULL);
     assert(got_uref);
+    upipe_release(audiobar);
 
+    /* pictures patched from the previous one must match a full drawing;
+     * 10 s between urefs lets the peaks fall back to the amplitudes */
+    static const double levels[][2] = {
+        { 0.8, 0.6 }, { 0.8, 0.6 }, { 0.1, 0.9 }, { 0., 0.3 },
+        { 1., 0.05 }, { 0.3, 0.3 },
+    };
+    audiobar = audiobar_alloc(uref_mgr, logger, audiobar_test, "incremental");
+    uref = audiobar_send(audiobar, uref_mgr, 0.5, 0.5, UCLOCK_FREQ);
+    uref_free(uref);
+    for (int i = 0; i < sizeof (levels) / sizeof (levels[0]); i++) {
+        uint64_t pts = (i + 2) * 10 * UCLOCK_FREQ;
+        uref = audiobar_send(audiobar, uref_mgr,
+                             levels[i][0], levels[i][1], pts);
+
+        struct upipe *reference =
+            audiobar_alloc(uref_mgr, logger, audiobar_test, "reference");
+        struct uref *ref = audiobar_send(reference, uref_mgr, 0.5, 0.5,
+                                         UCLOCK_FREQ);
+        uref_free(ref);
+        ref = audiobar_send(reference, uref_mgr,
+                            levels[i][0], levels[i][1], pts);
+        upipe_release(reference);
+
+        compare(uref, ref);
+        uref_free(uref);
+        uref_free(ref);
+    }
     upipe_release(audiobar);
     test_free(audiobar_test);
 
@@ -100,6 +100,16 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     ubase_assert(uref_amax_get_amplitude(uref, &amplitude, 1));
     assert(amplitude == (SAMPLES * 2 - 1) * 1.0f / INT16_MAX);
 
+    /* sum of the squares of 0 to SAMPLES - 1, then SAMPLES to 2 SAMPLES - 1 */
+    double sum0 = (SAMPLES - 1.) * SAMPLES * (2. * SAMPLES - 1.) / 6.;
+    double sum1 = (2. * SAMPLES - 1.) * 2. * SAMPLES * (4. * SAMPLES - 1.) / 6.
+                  - sum0;
+    double rms;
+    ubase_assert(uref_amax_get_rms(uref, &rms, 0));
+    assert(fabs(rms - sqrt(sum0 / SAMPLES) / INT16_MAX) < 1e-9);
+    ubase_assert(uref_amax_get_rms(uref, &rms, 1));
+    assert(fabs(rms - sqrt(sum1 / SAMPLES) / INT16_MAX) < 1e-9);
+
     uref_free(uref);
     got_input = true;
 }
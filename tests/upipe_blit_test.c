@@ -62,6 +62,11 @@
 #define BGSIZE              (2 * SUBSIZE)
 #define UPROBE_LOG_LEVEL UPROBE_LOG_VERBOSE
 
+/** expected value of the top left and top right subpictures */
+static uint8_t expected_sub1 = 1, expected_sub2 = 2;
+/** number of pictures received */
+static unsigned int nb_pics = 0;
+
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
                  int event, va_list args)
@@ -204,6 +209,7 @@ static void test_input(struct upipe *upipe, struct uref *uref,
 
     uint64_t priv;
     ubase_assert(uref_attr_get_priv(uref, &priv));
+    nb_pics++;
     switch (priv) {
         case 0:
             check_chroma(uref, "y8", 0);
@@ -212,15 +218,15 @@ static void test_input(struct upipe *upipe, struct uref *uref,
             break;
         case 1:
             uref_pic_resize(uref, 0, 0, SUBSIZE, SUBSIZE);
-            check_chroma(uref, "y8", 1);
-            check_chroma(uref, "u8", 1);
-            check_chroma(uref, "v8", 1);
+            check_chroma(uref, "y8", expected_sub1);
+            check_chroma(uref, "u8", expected_sub1);
+            check_chroma(uref, "v8", expected_sub1);
             uref_pic_resize(uref, 0, 0, BGSIZE, BGSIZE);
 
             uref_pic_resize(uref, SUBSIZE, 0, SUBSIZE, SUBSIZE);
-            check_chroma(uref, "y8", 2);
-            check_chroma(uref, "u8", 2);
-            check_chroma(uref, "v8", 2);
+            check_chroma(uref, "y8", expected_sub2);
+            check_chroma(uref, "u8", expected_sub2);
+            check_chroma(uref, "v8", expected_sub2);
             uref_pic_resize(uref, -SUBSIZE, 0, BGSIZE, BGSIZE);
 
             uref_pic_resize(uref, 0, SUBSIZE, SUBSIZE, SUBSIZE);
@@ -374,9 +380,35 @@ int main(int argc, char **argv)
     upipe_input(blit, uref, NULL);
     ubase_assert(upipe_blit_prepare(blit, NULL));
 
+    /* unchanged subpictures */
+    ubase_assert(upipe_blit_prepare(blit, NULL));
+
+    /* new top left subpicture, composed over the same background */
+    uref = uref_pic_alloc(uref_mgr, pic_mgr, SUBSIZE, SUBSIZE);
+    assert(uref != NULL);
+    uref_pic_set_progressive(uref);
+    fill_in(uref, "y8", 4);
+    fill_in(uref, "u8", 4);
+    fill_in(uref, "v8", 4);
+    upipe_input(subpipe1, uref, NULL);
+    expected_sub1 = 4;
+    ubase_assert(upipe_blit_prepare(blit, NULL));
+
+    /* transparent top right subpicture */
+    upipe_blit_sub_set_alpha_threshold(subpipe2, 0xff);
+    upipe_blit_sub_set_alpha(subpipe2, 0);
+    expected_sub2 = 0;
+    ubase_assert(upipe_blit_prepare(blit, NULL));
+
+    /* removed top right subpicture */
+    upipe_blit_sub_set_alpha(subpipe2, 0xff);
+    upipe_blit_sub_set_alpha_threshold(subpipe2, 0);
+    upipe_release(subpipe2);
+    ubase_assert(upipe_blit_prepare(blit, NULL));
+    assert(nb_pics == 6);
+
     /* release blit pipe and subpipes */
     upipe_release(subpipe1);
-    upipe_release(subpipe2);
     upipe_release(subpipe3);
     upipe_release(blit);
     test_free(test);
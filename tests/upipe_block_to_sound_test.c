@@ -61,7 +61,7 @@
 
 static struct uref *output = NULL;
 
-static void block_fill_in(struct ubuf *ubuf)
+static void block_fill_in(struct ubuf *ubuf, uint8_t start)
 {
     size_t size;
     ubase_assert(ubuf_block_size(ubuf, &size));
@@ -71,7 +71,7 @@ static void block_fill_in(struct ubuf *ubuf)
     ubase_assert(ubuf_block_write(ubuf, 0, &block_size, &buffer));
 
     for (int x = 0; x < size; x++)
-        buffer[x] = x;
+        buffer[x] = start + x;
 
     ubase_assert(ubuf_block_unmap(ubuf, 0));
 }
@@ -216,7 +216,7 @@ int main(int argc, char **argv)
 
     uref = uref_block_alloc(uref_mgr, block_mgr, block_size);
     assert(uref);
-    block_fill_in(uref->ubuf);
+    block_fill_in(uref->ubuf, 0);
 
     /* Now send uref */
     upipe_input(upipe_block_to_sound, uref, NULL);
@@ -239,6 +239,35 @@ int main(int argc, char **argv)
     }
     uref_sound_plane_unmap(output, "lr", 0, -1);
     uref_free(output);
+    output = NULL;
+
+    /* s24be input, in two segments splitting a sample */
+    flow_def = uref_block_flow_alloc_def(uref_mgr, "s24be.sound.");
+    assert(flow_def);
+    ubase_assert(upipe_set_flow_def(upipe_block_to_sound, flow_def));
+    uref_free(flow_def);
+
+    no_samples = 10;
+    uref = uref_block_alloc(uref_mgr, block_mgr, 31);
+    assert(uref);
+    block_fill_in(uref->ubuf, 0);
+    struct ubuf *ubuf = ubuf_block_alloc(block_mgr, no_samples * 6 - 31);
+    assert(ubuf);
+    block_fill_in(ubuf, 31);
+    ubase_assert(uref_block_append(uref, ubuf));
+
+    upipe_input(upipe_block_to_sound, uref, NULL);
+    assert(output != NULL);
+    ubase_assert(ubuf_sound_size(output->ubuf, &size, &sample_size));
+    assert(size == no_samples);
+
+    ubase_assert(uref_sound_plane_read_int32_t(output, "lr", 0, -1, &r));
+    for (int x = 0 ; x < no_samples * channels; x++) {
+        uint32_t s = ((uint32_t)(3*x) << 24) | ((3*x+1) << 16) | ((3*x+2) << 8);
+        assert((int32_t)s == r[x]);
+    }
+    uref_sound_plane_unmap(output, "lr", 0, -1);
+    uref_free(output);
 
     upipe_release(upipe_block_to_sound);
     test_free(block_to_sound_test);
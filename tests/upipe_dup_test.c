@@ -55,6 +55,9 @@
 static int counter = 0;
 static int flow_foo_counter = 0;
 static int flow_bar_counter = 0;
+static struct upipe *writer = NULL;
+static struct uref *original = NULL;
+static bool got_original = false;
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
@@ -89,6 +92,16 @@ static void test_input(struct upipe *upipe, struct uref *uref,
 {
     assert(uref != NULL);
     counter++;
+    if (uref == original)
+        got_original = true;
+    if (writer != NULL) {
+        /* attributes written by an output are not seen by the others */
+        const char *def;
+        if (upipe == writer)
+            ubase_assert(uref_flow_set_def(uref, "block.baz."));
+        else
+            ubase_nassert(uref_flow_get_def(uref, &def));
+    }
     uref_free(uref);
 }
 
@@ -195,6 +208,13 @@ int main(int argc, char *argv[])
     assert(flow_foo_counter == 1);
     assert(flow_bar_counter == 2);
 
+    writer = upipe_sink0;
+    original = uref_alloc(uref_mgr);
+    assert(original != NULL);
+    upipe_input(upipe_dup, original, NULL);
+    assert(counter == 4);
+    assert(got_original);
+
     upipe_release(upipe_dup);
     upipe_release(upipe_dup_output0);
     upipe_release(upipe_dup_output1);
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for file source and sink pipes with an io_uring event
+ * loop
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_upump_mgr.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/upump.h>
+#include <upipe/upipe.h>
+#include <upump-uring/upump_uring.h>
+#include <upipe-modules/upipe_file_source.h>
+#include <upipe-modules/upipe_file_sink.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPUMP_POOL 0
+#define UPUMP_BLOCKER_POOL 0
+#define READ_SIZE 4096
+#define FILE_SIZE (64 * READ_SIZE + 1234)
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+        case UPROBE_SOURCE_END:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** copies the source file to the sink file with the given mode */
+static void copy(struct upump_mgr *upump_mgr, struct uprobe *logger,
+                 const char *src_file, const char *sink_file,
+                 enum upipe_fsink_mode mode)
+{
+    struct upipe_mgr *upipe_fsrc_mgr = upipe_fsrc_mgr_alloc();
+    assert(upipe_fsrc_mgr != NULL);
+    struct upipe *upipe_fsrc = upipe_void_alloc(upipe_fsrc_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger),
+                             UPROBE_LOG_LEVEL, "file source"));
+    assert(upipe_fsrc != NULL);
+    ubase_assert(upipe_set_output_size(upipe_fsrc, READ_SIZE));
+    ubase_assert(upipe_set_uri(upipe_fsrc, src_file));
+
+    struct upipe_mgr *upipe_fsink_mgr = upipe_fsink_mgr_alloc();
+    assert(upipe_fsink_mgr != NULL);
+    struct upipe *upipe_fsink = upipe_void_alloc_output(upipe_fsrc,
+            upipe_fsink_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "file sink"));
+    assert(upipe_fsink != NULL);
+    ubase_assert(upipe_fsink_set_path(upipe_fsink, sink_file, mode));
+    upipe_release(upipe_fsink);
+
+    upump_mgr_run(upump_mgr, NULL);
+
+    upipe_release(upipe_fsrc);
+    upipe_mgr_release(upipe_fsrc_mgr); // nop
+    upipe_mgr_release(upipe_fsink_mgr); // nop
+}
+
+/** checks that the file contains the pattern nb times */
+static void check(const char *file, unsigned int nb)
+{
+    FILE *f = fopen(file, "r");
+    assert(f != NULL);
+    for (unsigned int n = 0; n < nb; n++)
+        for (unsigned int i = 0; i < FILE_SIZE; i++)
+            assert(fgetc(f) == (uint8_t)(i * 7 + i / 251));
+    assert(fgetc(f) == EOF);
+    fclose(f);
+}
+
+int main(int argc, char *argv[])
+{
+    char src_file[] = "upipe_file_uring_test.src.XXXXXX";
+    char sink_file[] = "upipe_file_uring_test.sink.XXXXXX";
+    int fd = mkstemp(src_file);
+    assert(fd != -1);
+    FILE *f = fdopen(fd, "w");
+    assert(f != NULL);
+    for (unsigned int i = 0; i < FILE_SIZE; i++)
+        assert(fputc((uint8_t)(i * 7 + i / 251), f) != EOF);
+    fclose(f);
+    fd = mkstemp(sink_file);
+    assert(fd != -1);
+    close(fd);
+
+    struct upump_mgr *upump_mgr =
+        upump_uring_mgr_alloc(UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_upump_mgr_alloc(logger, upump_mgr);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    copy(upump_mgr, logger, src_file, sink_file, UPIPE_FSINK_OVERWRITE);
+    check(sink_file, 1);
+    /* the asynchronous writes start at the end of the file */
+    copy(upump_mgr, logger, src_file, sink_file, UPIPE_FSINK_APPEND);
+    check(sink_file, 2);
+
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    upump_mgr_release(upump_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+
+    unlink(src_file);
+    unlink(sink_file);
+    return 0;
+}
@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for flad pipes
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_sound_flow.h>
+#include <upipe/upipe.h>
+#include <upipe-filters/upipe_filter_audio_ladder.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH        0
+#define UREF_POOL_DEPTH         0
+#define RENDITIONS              3
+#define PACKETS                 10
+#define UPROBE_LOG_LEVEL UPROBE_LOG_VERBOSE
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+        case UPROBE_SOURCE_END:
+            break;
+        default:
+            assert(0);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** phony pipe standing for converters, encoders and sinks */
+struct test_pipe {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** flow definition given at allocation */
+    struct uref *flow_def;
+    /** output */
+    struct upipe *output;
+    /** number of flow definitions received */
+    unsigned int flow_defs;
+    /** number of urefs received */
+    unsigned int urefs;
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UBASE_FROM_TO(test_pipe, upipe, upipe, upipe)
+UBASE_FROM_TO(test_pipe, urefcount, urefcount, urefcount)
+
+/** @hidden */
+static void test_free(struct urefcount *urefcount);
+
+/** number of live phony converters */
+static unsigned int convert_live = 0;
+/** number of phony converters allocated */
+static unsigned int convert_allocs = 0;
+/** number of live phony encoders */
+static unsigned int encode_live = 0;
+/** number of phony encoders allocated */
+static unsigned int encode_allocs = 0;
+
+/** phony managers */
+static struct upipe_mgr convert_mgr;
+static struct upipe_mgr encode_mgr;
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct test_pipe *test_pipe = malloc(sizeof(struct test_pipe));
+    assert(test_pipe != NULL);
+    upipe_init(&test_pipe->upipe, mgr, uprobe);
+    urefcount_init(&test_pipe->urefcount, test_free);
+    test_pipe->upipe.refcount = &test_pipe->urefcount;
+    test_pipe->flow_def = NULL;
+    test_pipe->output = NULL;
+    test_pipe->flow_defs = 0;
+    test_pipe->urefs = 0;
+    if (mgr == &convert_mgr || mgr == &encode_mgr) {
+        assert(signature == UPIPE_FLOW_SIGNATURE);
+        struct uref *flow_def = va_arg(args, struct uref *);
+        test_pipe->flow_def = uref_dup(flow_def);
+        assert(test_pipe->flow_def != NULL);
+        if (mgr == &convert_mgr) {
+            convert_live++;
+            convert_allocs++;
+        } else {
+            encode_live++;
+            encode_allocs++;
+        }
+    }
+    upipe_throw_ready(&test_pipe->upipe);
+    return &test_pipe->upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    struct test_pipe *test_pipe = test_pipe_from_upipe(upipe);
+    test_pipe->urefs++;
+    if (test_pipe->output != NULL)
+        upipe_input(test_pipe->output, uref, upump_p);
+    else
+        uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    struct test_pipe *test_pipe = test_pipe_from_upipe(upipe);
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            test_pipe->flow_defs++;
+            if (test_pipe->output != NULL && test_pipe->flow_def != NULL)
+                return upipe_set_flow_def(test_pipe->output,
+                                          test_pipe->flow_def);
+            return UBASE_ERR_NONE;
+        case UPIPE_SET_OUTPUT: {
+            struct upipe *output = va_arg(args, struct upipe *);
+            upipe_release(test_pipe->output);
+            test_pipe->output = upipe_use(output);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_REGISTER_REQUEST:
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_UNHANDLED;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct urefcount *urefcount)
+{
+    struct test_pipe *test_pipe = test_pipe_from_urefcount(urefcount);
+    struct upipe *upipe = test_pipe_to_upipe(test_pipe);
+    if (upipe->mgr == &convert_mgr)
+        convert_live--;
+    else if (upipe->mgr == &encode_mgr)
+        encode_live--;
+    upipe_throw_dead(upipe);
+    upipe_release(test_pipe->output);
+    uref_free(test_pipe->flow_def);
+    upipe_clean(upipe);
+    urefcount_clean(urefcount);
+    free(test_pipe);
+}
+
+/** helper phony pipe */
+static void test_mgr_init(struct upipe_mgr *mgr)
+{
+    memset(mgr, 0, sizeof(*mgr));
+    mgr->signature = 0;
+    mgr->upipe_alloc = test_alloc;
+    mgr->upipe_input = test_input;
+    mgr->upipe_control = test_control;
+}
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+
+    struct upipe_mgr sink_mgr;
+    test_mgr_init(&convert_mgr);
+    test_mgr_init(&encode_mgr);
+    test_mgr_init(&sink_mgr);
+
+    struct upipe_mgr *upipe_flad_mgr = upipe_flad_mgr_alloc();
+    assert(upipe_flad_mgr != NULL);
+    ubase_assert(upipe_flad_mgr_set_convert_mgr(upipe_flad_mgr,
+                                                &convert_mgr));
+    ubase_assert(upipe_flad_mgr_set_encode_mgr(upipe_flad_mgr, &encode_mgr));
+    unsigned int nb_workers;
+    ubase_assert(upipe_flad_mgr_get_workers(upipe_flad_mgr, &nb_workers));
+    assert(nb_workers == 0);
+
+    struct upipe *flad = upipe_void_alloc(upipe_flad_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "flad"));
+    assert(flad != NULL);
+    ubase_nassert(upipe_flad_mgr_set_encode_mgr(upipe_flad_mgr, &encode_mgr));
+
+    /* two renditions share the first format, given in distinct packets */
+    struct uref *formats[RENDITIONS];
+    for (int i = 0; i < RENDITIONS; i++) {
+        formats[i] = uref_sound_flow_alloc_def(uref_mgr,
+                                               i < 2 ? "s16." : "f32.", 2, 4);
+        assert(formats[i] != NULL);
+        ubase_assert(uref_sound_flow_set_rate(formats[i], 48000));
+    }
+    ubase_assert(uref_sound_flow_add_plane(formats[0], "lr"));
+    ubase_assert(uref_sound_flow_add_plane(formats[1], "lr"));
+    ubase_assert(uref_sound_flow_add_plane(formats[2], "l"));
+    ubase_assert(uref_sound_flow_add_plane(formats[2], "r"));
+
+    struct upipe *outputs[RENDITIONS];
+    struct upipe *sinks[RENDITIONS];
+    for (int i = 0; i < RENDITIONS; i++) {
+        struct uref *flow_def = uref_alloc_control(uref_mgr);
+        assert(flow_def != NULL);
+        ubase_assert(uref_flow_set_def(flow_def,
+                                       i < 2 ? "block.aac.sound." :
+                                               "block.ac3.sound."));
+        outputs[i] = upipe_flad_output_alloc_sub(flad,
+                uprobe_pfx_alloc_va(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                                    "rendition %d", i),
+                formats[i], flow_def);
+        assert(outputs[i] != NULL);
+        uref_free(flow_def);
+
+        sinks[i] = upipe_void_alloc(&sink_mgr, uprobe_pfx_alloc_va(
+                    uprobe_use(logger), UPROBE_LOG_LEVEL, "sink %d", i));
+        assert(sinks[i] != NULL);
+        ubase_assert(upipe_set_output(outputs[i], sinks[i]));
+    }
+    assert(convert_allocs == 2);
+    assert(convert_live == 2);
+    assert(encode_allocs == RENDITIONS);
+
+    struct uref *flow_def = uref_sound_flow_alloc_def(uref_mgr, "s32.", 2, 8);
+    assert(flow_def != NULL);
+    ubase_assert(uref_sound_flow_add_plane(flow_def, "lr"));
+    ubase_assert(uref_sound_flow_set_rate(flow_def, 48000));
+    ubase_assert(upipe_set_flow_def(flad, flow_def));
+    uref_free(flow_def);
+
+    flow_def = uref_alloc_control(uref_mgr);
+    assert(flow_def != NULL);
+    ubase_assert(uref_flow_set_def(flow_def, "pic."));
+    ubase_nassert(upipe_set_flow_def(flad, flow_def));
+    uref_free(flow_def);
+
+    for (int i = 0; i < PACKETS; i++) {
+        struct uref *uref = uref_alloc(uref_mgr);
+        assert(uref != NULL);
+        upipe_input(flad, uref, NULL);
+    }
+
+    for (int i = 0; i < RENDITIONS; i++) {
+        struct test_pipe *sink = test_pipe_from_upipe(sinks[i]);
+        assert(sink->flow_defs == 1);
+        assert(sink->urefs == PACKETS);
+    }
+
+    /* the shared conversion stays until its last rendition is released */
+    upipe_release(outputs[0]);
+    assert(convert_live == 2);
+    assert(encode_live == RENDITIONS - 1);
+    upipe_release(outputs[2]);
+    assert(convert_live == 1);
+
+    struct uref *uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    upipe_input(flad, uref, NULL);
+    assert(test_pipe_from_upipe(sinks[1])->urefs == PACKETS + 1);
+
+    upipe_release(flad);
+    upipe_release(outputs[1]);
+    assert(convert_live == 0);
+    assert(encode_live == 0);
+
+    for (int i = 0; i < RENDITIONS; i++) {
+        upipe_release(sinks[i]);
+        uref_free(formats[i]);
+    }
+    upipe_mgr_release(upipe_flad_mgr);
+
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    return 0;
+}
@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for deint pipes
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_pic.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/ubuf_pic_mem.h>
+#include <upipe/upipe.h>
+#include <upipe-filters/upipe_filter_deint.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH        0
+#define UREF_POOL_DEPTH         0
+#define UBUF_POOL_DEPTH         0
+#define UBUF_SHARED_POOL_DEPTH  0
+#define WIDTH                   32
+#define HEIGHT                  16
+#define UPROBE_LOG_LEVEL UPROBE_LOG_VERBOSE
+
+/** kind of pictures sent to the pipe */
+enum pattern {
+    /** identical pictures with vertical detail */
+    PATTERN_STATIC,
+    /** top field at 100, bottom field at 0 */
+    PATTERN_FIELDS,
+};
+
+/** sent pattern */
+static enum pattern pattern;
+/** number of pictures received by the sink */
+static unsigned int count;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+        default:
+            assert(0);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** returns the luma value of the pattern */
+static uint8_t value(int x, int y)
+{
+    if (pattern == PATTERN_FIELDS)
+        return y & 1 ? 0 : 100;
+    return y * 5 + x * 3;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    ubase_assert(uref_pic_get_progressive(uref));
+    ubase_nassert(uref_pic_get_tff(uref));
+
+    const uint8_t *r;
+    size_t stride;
+    ubase_assert(uref_pic_plane_read(uref, "y8", 0, 0, -1, -1, &r));
+    ubase_assert(uref_pic_plane_size(uref, "y8", &stride, NULL, NULL, NULL));
+    /* the last line is interpolated from mirrored neighbors */
+    for (int y = 0; y < HEIGHT - 1; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            uint8_t expected = pattern == PATTERN_FIELDS ? 100 : value(x, y);
+            assert(r[x] == expected);
+        }
+        r += stride;
+    }
+    ubase_assert(uref_pic_plane_unmap(uref, "y8", 0, 0, -1, -1));
+    count++;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            ubase_assert(uref_pic_get_progressive(flow_def));
+            return UBASE_ERR_NONE;
+        }
+    }
+    return UBASE_ERR_UNHANDLED;
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** sends a picture of the current pattern */
+static void send_pic(struct upipe *deint, struct uref_mgr *uref_mgr,
+                     struct ubuf_mgr *pic_mgr)
+{
+    struct uref *uref = uref_pic_alloc(uref_mgr, pic_mgr, WIDTH, HEIGHT);
+    assert(uref != NULL);
+    const char *chroma = NULL;
+    while (ubase_check(uref_pic_plane_iterate(uref, &chroma)) &&
+           chroma != NULL)
+        ubase_assert(uref_pic_plane_clear(uref, chroma, 0, 0, -1, -1, 0));
+
+    uint8_t *w;
+    size_t stride;
+    ubase_assert(uref_pic_plane_write(uref, "y8", 0, 0, -1, -1, &w));
+    ubase_assert(uref_pic_plane_size(uref, "y8", &stride, NULL, NULL, NULL));
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++)
+            w[x] = value(x, y);
+        w += stride;
+    }
+    ubase_assert(uref_pic_plane_unmap(uref, "y8", 0, 0, -1, -1));
+    ubase_assert(uref_pic_set_tff(uref));
+    upipe_input(deint, uref, NULL);
+}
+
+int main(int argc, char **argv)
+{
+    printf("Compiled %s %s - %s\n", __DATE__, __TIME__, __FILE__);
+
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr =
+        udict_inline_mgr_alloc(UDICT_POOL_DEPTH, umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr =
+        uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *pic_mgr = ubuf_pic_mem_mgr_alloc_fourcc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, "I420", 0, 0, 0, 0, 0, 0);
+    assert(pic_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_SHARED_POOL_DEPTH);
+    assert(logger != NULL);
+
+    struct upipe_mgr *upipe_filter_deint_mgr = upipe_filter_deint_mgr_alloc();
+    assert(upipe_filter_deint_mgr != NULL);
+
+    struct upipe *test = upipe_void_alloc(&test_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "test"));
+    assert(test != NULL);
+
+    struct upipe *deint = upipe_void_alloc(upipe_filter_deint_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "deint"));
+    assert(deint != NULL);
+    ubase_assert(upipe_set_output(deint, test));
+
+    struct uref *flow_def = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(flow_def != NULL);
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 1, 1, 1, "y8"));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 2, 2, 1, "u8"));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 2, 2, 1, "v8"));
+    ubase_assert(uref_pic_flow_set_hsize(flow_def, WIDTH));
+    ubase_assert(uref_pic_flow_set_vsize(flow_def, HEIGHT));
+    ubase_assert(upipe_set_flow_def(deint, flow_def));
+
+    /* static pictures keep their vertical detail, with one picture of
+     * latency */
+    int mode;
+    ubase_assert(upipe_filter_deint_get_mode(deint, &mode));
+    assert(mode == UPIPE_FILTER_DEINT_YADIF);
+    pattern = PATTERN_STATIC;
+    count = 0;
+    for (int i = 0; i < 4; i++)
+        send_pic(deint, uref_mgr, pic_mgr);
+    assert(count == 3);
+
+    /* switching to bob outputs the held picture */
+    ubase_assert(upipe_filter_deint_set_mode(deint, UPIPE_FILTER_DEINT_BOB));
+    assert(count == 4);
+
+    /* bob interpolates the bottom field from the top field */
+    pattern = PATTERN_FIELDS;
+    count = 0;
+    for (int i = 0; i < 2; i++)
+        send_pic(deint, uref_mgr, pic_mgr);
+    assert(count == 2);
+
+    /* motion adaptive mode on static pictures, flushed by a new flow */
+    ubase_assert(upipe_set_option(deint, "mode", "motion"));
+    pattern = PATTERN_STATIC;
+    count = 0;
+    for (int i = 0; i < 3; i++)
+        send_pic(deint, uref_mgr, pic_mgr);
+    assert(count == 2);
+    ubase_assert(upipe_set_flow_def(deint, flow_def));
+    assert(count == 3);
+    uref_free(flow_def);
+
+    ubase_nassert(upipe_set_option(deint, "mode", "unknown"));
+
+    upipe_release(deint);
+    test_free(test);
+
+    upipe_mgr_release(upipe_filter_deint_mgr); // no-op
+    ubuf_mgr_release(pic_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
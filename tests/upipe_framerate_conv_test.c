@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for framerate_conv pipes
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/uclock.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_pic.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/ubuf_pic_mem.h>
+#include <upipe/upipe.h>
+#include <upipe-modules/upipe_framerate_conv.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH        0
+#define UREF_POOL_DEPTH         0
+#define UBUF_POOL_DEPTH         0
+#define UBUF_SHARED_POOL_DEPTH  0
+#define SIZE                    16
+#define UPROBE_LOG_LEVEL UPROBE_LOG_VERBOSE
+
+/** number of pictures received by the sink */
+static unsigned int count;
+/** expected luma values */
+static const uint8_t *expected;
+/** expected number of frames */
+static unsigned int nb_expected;
+/** expected output date step */
+static uint64_t expected_step;
+/** last received picture, kept so that its buffer is not recycled */
+static struct uref *last_uref;
+/** luma buffer of the last received picture */
+static const uint8_t *last_buffer;
+/** number of received pictures sharing the buffer of the previous one */
+static unsigned int shared;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+        default:
+            assert(0);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    assert(count < nb_expected);
+
+    uint64_t pts;
+    ubase_assert(uref_clock_get_pts_prog(uref, &pts));
+    assert(pts == UCLOCK_FREQ + count * expected_step);
+
+    const uint8_t *r;
+    ubase_assert(uref_pic_plane_read(uref, "y8", 0, 0, -1, -1, &r));
+    upipe_dbg_va(upipe, "received picture %u: %u", count, r[0]);
+    assert(r[0] == expected[count]);
+    assert(r[SIZE * SIZE - 1] == expected[count]);
+    if (r == last_buffer)
+        shared++;
+    last_buffer = r;
+    ubase_assert(uref_pic_plane_unmap(uref, "y8", 0, 0, -1, -1));
+
+    count++;
+    if (last_uref != NULL)
+        uref_free(last_uref);
+    last_uref = uref;
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+    }
+    return UBASE_ERR_UNHANDLED;
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** runs a conversion and checks the output */
+static void run(struct uref_mgr *uref_mgr, struct ubuf_mgr *pic_mgr,
+                struct upipe *conv, struct urational in_fps,
+                struct urational out_fps, int mode,
+                const uint8_t *values, unsigned int nb_values,
+                const uint8_t *exp, unsigned int nb_exp)
+{
+    ubase_assert(upipe_framerate_conv_set_mode(conv, mode));
+
+    struct uref *flow_def = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(flow_def != NULL);
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 1, 1, 1, "y8"));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 2, 2, 1, "u8"));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 2, 2, 1, "v8"));
+    ubase_assert(uref_pic_flow_set_hsize(flow_def, SIZE));
+    ubase_assert(uref_pic_flow_set_vsize(flow_def, SIZE));
+    ubase_assert(uref_pic_flow_set_fps(flow_def, in_fps));
+    ubase_assert(upipe_set_flow_def(conv, flow_def));
+    uref_free(flow_def);
+
+    count = 0;
+    shared = 0;
+    last_buffer = NULL;
+    expected = exp;
+    nb_expected = nb_exp;
+    expected_step = UCLOCK_FREQ * out_fps.den / out_fps.num;
+
+    for (unsigned int i = 0; i < nb_values; i++) {
+        struct uref *uref = uref_pic_alloc(uref_mgr, pic_mgr, SIZE, SIZE);
+        assert(uref != NULL);
+        const char *chroma = NULL;
+        while (ubase_check(uref_pic_plane_iterate(uref, &chroma)) &&
+               chroma != NULL)
+            ubase_assert(uref_pic_plane_clear(uref, chroma, 0, 0, -1, -1, 0));
+        uint8_t *w;
+        ubase_assert(uref_pic_plane_write(uref, "y8", 0, 0, -1, -1, &w));
+        memset(w, values[i], SIZE * SIZE);
+        ubase_assert(uref_pic_plane_unmap(uref, "y8", 0, 0, -1, -1));
+        uref_clock_set_pts_prog(uref, UCLOCK_FREQ +
+                                i * UCLOCK_FREQ * in_fps.den / in_fps.num);
+        upipe_input(conv, uref, NULL);
+    }
+    assert(count == nb_expected);
+    if (last_uref != NULL)
+        uref_free(last_uref);
+    last_uref = NULL;
+}
+
+int main(int argc, char **argv)
+{
+    printf("Compiled %s %s - %s\n", __DATE__, __TIME__, __FILE__);
+
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr =
+        udict_inline_mgr_alloc(UDICT_POOL_DEPTH, umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr =
+        uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *pic_mgr = ubuf_pic_mem_mgr_alloc_fourcc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, "I420", 0, 0, 0, 0, 0, 0);
+    assert(pic_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_SHARED_POOL_DEPTH);
+    assert(logger != NULL);
+
+    struct upipe_mgr *upipe_framerate_conv_mgr =
+        upipe_framerate_conv_mgr_alloc();
+    assert(upipe_framerate_conv_mgr != NULL);
+
+    struct upipe *test = upipe_void_alloc(&test_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "test"));
+    assert(test != NULL);
+
+    static const uint8_t values[] = { 0, 40, 80, 120, 160 };
+
+    /* 25 to 50 fps: every picture is repeated by reference */
+    struct upipe *conv = upipe_void_alloc(upipe_framerate_conv_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "frc"));
+    assert(conv != NULL);
+    ubase_assert(upipe_framerate_conv_set_fps(conv,
+                (struct urational){ 50, 1 }));
+    ubase_assert(upipe_set_output(conv, test));
+    static const uint8_t repeat_up[] = { 0, 0, 40, 40, 80, 80, 120, 120 };
+    run(uref_mgr, pic_mgr, conv, (struct urational){ 25, 1 },
+        (struct urational){ 50, 1 }, UPIPE_FRAMERATE_CONV_REPEAT,
+        values, 5, repeat_up, 8);
+    assert(shared == 4);
+    ubase_nassert(upipe_framerate_conv_set_fps(conv,
+                (struct urational){ 25, 1 }));
+    upipe_release(conv);
+
+    /* 25 to 50 fps, blended */
+    conv = upipe_void_alloc(upipe_framerate_conv_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "frc"));
+    assert(conv != NULL);
+    ubase_assert(upipe_framerate_conv_set_fps(conv,
+                (struct urational){ 50, 1 }));
+    ubase_assert(upipe_set_output(conv, test));
+    static const uint8_t blend_up[] = { 0, 20, 40, 60, 80, 100, 120, 140 };
+    run(uref_mgr, pic_mgr, conv, (struct urational){ 25, 1 },
+        (struct urational){ 50, 1 }, UPIPE_FRAMERATE_CONV_BLEND,
+        values, 5, blend_up, 8);
+    assert(shared == 0);
+    upipe_release(conv);
+
+    /* 50 to 25 fps: every other picture is dropped */
+    conv = upipe_void_alloc(upipe_framerate_conv_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "frc"));
+    assert(conv != NULL);
+    ubase_assert(upipe_framerate_conv_set_fps(conv,
+                (struct urational){ 25, 1 }));
+    ubase_assert(upipe_set_output(conv, test));
+    static const uint8_t repeat_down[] = { 0, 80 };
+    run(uref_mgr, pic_mgr, conv, (struct urational){ 50, 1 },
+        (struct urational){ 25, 1 }, UPIPE_FRAMERATE_CONV_BLEND,
+        values, 5, repeat_down, 2);
+    upipe_release(conv);
+
+    /* 2 to 3 fps, blended at one third and two thirds */
+    conv = upipe_void_alloc(upipe_framerate_conv_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "frc"));
+    assert(conv != NULL);
+    ubase_assert(upipe_framerate_conv_set_fps(conv,
+                (struct urational){ 3, 1 }));
+    ubase_assert(upipe_set_output(conv, test));
+    static const uint8_t blend_frac[] = { 0, 27, 53 };
+    run(uref_mgr, pic_mgr, conv, (struct urational){ 2, 1 },
+        (struct urational){ 3, 1 }, UPIPE_FRAMERATE_CONV_BLEND,
+        values, 3, blend_frac, 3);
+    upipe_release(conv);
+
+    test_free(test);
+
+    upipe_mgr_release(upipe_framerate_conv_mgr); // no-op
+    ubuf_mgr_release(pic_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for fuse pipes
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/uref.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_pic.h>
+#include <upipe/uref_std.h>
+#include <upipe/upipe.h>
+#include <upipe-modules/upipe_fuse.h>
+#include <upipe-modules/upipe_probe_uref.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+
+UREF_ATTR_STRING(test, 1, "x.test1", test 1)
+UREF_ATTR_UNSIGNED(test, 2, "x.test2", test 2)
+UREF_ATTR_UNSIGNED(test, 3, "x.test3", test 3)
+
+static unsigned int nb_packets = 0;
+static unsigned int nb_probed = 0;
+static unsigned int nb_callbacks = 0;
+static unsigned int nb_flow_defs = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+        case UPROBE_PROBE_UREF: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_PROBE_UREF_SIGNATURE)
+            struct uref *uref = va_arg(args, struct uref *);
+            va_arg(args, struct upump **);
+            bool *drop = va_arg(args, bool *);
+            /* the callback stage ran before */
+            uint64_t num;
+            ubase_assert(uref_test_get_3(uref, &num));
+            *drop = num == 2;
+            nb_probed++;
+            break;
+        }
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** callback stage */
+static bool test_cb(void *opaque, struct upipe *upipe, struct uref *uref,
+                    struct upump **upump_p)
+{
+    assert(opaque == &nb_callbacks);
+    /* the setattr stages ran before */
+    uint64_t num;
+    ubase_assert(uref_test_get_2(uref, &num));
+    assert(num == 42);
+    nb_callbacks++;
+    ubase_assert(uref_test_set_3(uref, nb_callbacks));
+    return true;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    const char *string;
+    ubase_assert(uref_test_get_1(uref, &string));
+    assert(!strcmp(string, "test"));
+    uint64_t num;
+    ubase_assert(uref_test_get_2(uref, &num));
+    assert(num == 42);
+    ubase_assert(uref_test_get_3(uref, &num));
+    assert(num != 2);
+    ubase_assert(uref_clock_get_duration(uref, &num));
+    assert(num == 1080000);
+    ubase_assert(uref_pic_get_number(uref, &num));
+    assert(num == 7);
+    ubase_assert(uref_pic_get_key(uref));
+    uref_free(uref);
+    nb_packets++;
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            const char *def;
+            ubase_assert(uref_flow_get_def(flow_def, &def));
+            assert(!strcmp(def, "internal."));
+            uint64_t num;
+            ubase_assert(uref_test_get_2(flow_def, &num));
+            assert(num == 12);
+            /* per-uref attributes are not set into the flow def */
+            assert(!ubase_check(uref_test_get_3(flow_def, &num)));
+            nb_flow_defs++;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *uprobe_stdio = uprobe_stdio_alloc(&uprobe, stdout,
+                                                     UPROBE_LOG_LEVEL);
+    assert(uprobe_stdio != NULL);
+
+    struct upipe *upipe_sink = upipe_void_alloc(&test_mgr,
+                                                uprobe_use(uprobe_stdio));
+    assert(upipe_sink != NULL);
+
+    struct upipe_mgr *upipe_fuse_mgr = upipe_fuse_mgr_alloc();
+    assert(upipe_fuse_mgr != NULL);
+    struct upipe *upipe_fuse = upipe_void_alloc(upipe_fuse_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "fuse"));
+    assert(upipe_fuse != NULL);
+    ubase_assert(upipe_set_output(upipe_fuse, upipe_sink));
+
+    /* two consecutive setattr stages, merged */
+    struct uref *dict = uref_alloc(uref_mgr);
+    assert(dict != NULL);
+    ubase_assert(uref_test_set_1(dict, "test"));
+    ubase_assert(upipe_fuse_add_setattr(upipe_fuse, dict));
+    uref_free(dict);
+    dict = uref_alloc(uref_mgr);
+    assert(dict != NULL);
+    ubase_assert(uref_test_set_2(dict, 42));
+    /* attributes stored in the uref structure */
+    ubase_assert(uref_clock_set_duration(dict, 1080000));
+    ubase_assert(uref_pic_set_number(dict, 7));
+    ubase_assert(uref_pic_set_key(dict));
+    ubase_assert(upipe_fuse_add_setattr(upipe_fuse, dict));
+    uref_free(dict);
+
+    ubase_assert(upipe_fuse_add_callback(upipe_fuse, test_cb, &nb_callbacks));
+    ubase_assert(upipe_fuse_add_probe(upipe_fuse));
+
+    dict = uref_alloc(uref_mgr);
+    assert(dict != NULL);
+    ubase_assert(uref_test_set_2(dict, 12));
+    ubase_assert(upipe_fuse_add_setflowdef(upipe_fuse, dict));
+    uref_free(dict);
+
+    struct uref *uref;
+    uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    ubase_assert(uref_flow_set_def(uref, "internal."));
+    ubase_assert(upipe_set_flow_def(upipe_fuse, uref));
+    uref_free(uref);
+
+    for (int i = 0; i < 3; i++) {
+        uref = uref_alloc(uref_mgr);
+        assert(uref != NULL);
+        upipe_input(upipe_fuse, uref, NULL);
+    }
+    assert(nb_callbacks == 3);
+    assert(nb_probed == 3);
+    /* the second uref was dropped by the probe */
+    assert(nb_packets == 2);
+    assert(nb_flow_defs == 1);
+
+    upipe_release(upipe_fuse);
+    upipe_mgr_release(upipe_fuse_mgr); // nop
+
+    test_free(upipe_sink);
+
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(uprobe_stdio);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for genrap module
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_dump.h>
+#include <upipe/uref_clock.h>
+#include <upipe-modules/upipe_genrap.h>
+
+#include <upipe/upipe_helper_upipe.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH    0
+#define UREF_POOL_DEPTH     0
+#define UBUF_POOL_DEPTH     0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe, int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+struct genrap_test {
+    struct uref *entry;
+    unsigned int nb_entries;
+    struct upipe upipe;
+};
+
+/** helper phony pipe */
+UPIPE_HELPER_UPIPE(genrap_test, upipe, 0);
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct genrap_test *genrap_test = malloc(sizeof(struct genrap_test));
+    assert(genrap_test != NULL);
+    upipe_init(&genrap_test->upipe, mgr, uprobe);
+    genrap_test->entry = NULL;
+    genrap_test->nb_entries = 0;
+    return &genrap_test->upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    struct genrap_test *genrap_test = genrap_test_from_upipe(upipe);
+    assert(uref != NULL);
+    upipe_dbg(upipe, "===> received input uref");
+    uref_dump(uref, upipe->uprobe);
+
+    if (genrap_test->entry) {
+        uref_free(genrap_test->entry);
+    }
+    genrap_test->entry = uref;
+    genrap_test->nb_entries++;
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_dbg_va(upipe, "releasing pipe %p", upipe);
+    struct genrap_test *genrap_test = genrap_test_from_upipe(upipe);
+    if (genrap_test->entry)
+        uref_free(genrap_test->entry);
+    upipe_clean(upipe);
+    free(genrap_test);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr genrap_test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+int main(int argc, char **argv)
+{
+    printf("Compiled %s %s - %s\n", __DATE__, __TIME__, __FILE__);
+
+    struct uref *uref;
+    uint8_t buf[UPIPE_GENRAP_RECORD_SIZE];
+    struct upipe_genrap_record record;
+
+    /* uref and mem management */
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH, umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
+    assert(uref_mgr != NULL);
+
+    /* uprobe stuff */
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_DEBUG);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    /* set up flow definition packet */
+    uref = uref_block_flow_alloc_def(uref_mgr, "mpeg2video.pic.");
+    assert(uref);
+
+    /* build genrap pipe */
+    struct upipe_mgr *upipe_genrap_mgr = upipe_genrap_mgr_alloc();
+    assert(upipe_genrap_mgr);
+    struct upipe *genrap = upipe_void_alloc(upipe_genrap_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "genrap"));
+    assert(genrap);
+    ubase_assert(upipe_set_flow_def(genrap, uref));
+
+    uref_free(uref);
+    ubase_assert(upipe_get_flow_def(genrap, &uref));
+    const char *def;
+    ubase_assert(uref_flow_get_def(uref, &def));
+    assert(!strcmp(def, "block.rap."));
+
+    struct upipe *genrap_test = upipe_void_alloc(&genrap_test_mgr,
+                                                 uprobe_use(logger));
+    assert(genrap_test != NULL);
+    ubase_assert(upipe_set_output(genrap, genrap_test));
+
+    /* random access point */
+    uref = uref_alloc(uref_mgr);
+    assert(uref);
+    uref_clock_set_cr_sys(uref, 27000000);
+    uref_clock_set_pts_orig(uref, 27000000 * 3);
+    uref_clock_set_dts_pts_delay(uref, 0);
+    uref_clock_set_cr_dts_delay(uref, 27000000);
+    uref_flow_set_random(uref);
+    upipe_input(genrap, uref, NULL);
+
+    assert(genrap_test_from_upipe(genrap_test)->nb_entries == 1);
+    uref = genrap_test_from_upipe(genrap_test)->entry;
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    assert(size == UPIPE_GENRAP_RECORD_SIZE);
+    ubase_assert(uref_block_extract(uref, 0, UPIPE_GENRAP_RECORD_SIZE, buf));
+    upipe_genrap_read(buf, &record);
+    assert(record.cr_sys == 27000000);
+    assert(record.pts_orig == 27000000 * 3);
+    assert(record.cr_orig == 27000000 * 2);
+
+    /* other pictures are dropped */
+    uref = uref_alloc(uref_mgr);
+    assert(uref);
+    uref_clock_set_cr_sys(uref, 27000000 * 4);
+    upipe_input(genrap, uref, NULL);
+    assert(genrap_test_from_upipe(genrap_test)->nb_entries == 1);
+
+    /* unknown timestamps */
+    uref = uref_alloc(uref_mgr);
+    assert(uref);
+    uref_clock_set_cr_sys(uref, 27000000 * 5);
+    uref_flow_set_random(uref);
+    upipe_input(genrap, uref, NULL);
+    assert(genrap_test_from_upipe(genrap_test)->nb_entries == 2);
+    ubase_assert(uref_block_extract(genrap_test_from_upipe(genrap_test)->entry,
+                                    0, UPIPE_GENRAP_RECORD_SIZE, buf));
+    upipe_genrap_read(buf, &record);
+    assert(record.cr_sys == 27000000 * 5);
+    assert(record.pts_orig == UINT64_MAX);
+    assert(record.cr_orig == UINT64_MAX);
+
+    upipe_release(genrap);
+    test_free(genrap_test);
+
+    /* index lookup */
+    uint8_t index[4 * UPIPE_GENRAP_RECORD_SIZE];
+    for (int i = 0; i < 4; i++) {
+        record.cr_sys = (i + 1) * 100;
+        record.pts_orig = record.cr_orig = UINT64_MAX;
+        upipe_genrap_write(index + i * UPIPE_GENRAP_RECORD_SIZE, &record);
+    }
+    assert(upipe_genrap_find(index, 4, 50) == -1);
+    assert(upipe_genrap_find(index, 4, 100) == 0);
+    assert(upipe_genrap_find(index, 4, 250) == 1);
+    assert(upipe_genrap_find(index, 4, 400) == 3);
+    assert(upipe_genrap_find(index, 4, 1000) == 3);
+    assert(upipe_genrap_find(index, 0, 1000) == -1);
+
+    /* release managers */
+    uref_mgr_release(uref_mgr);
+    umem_mgr_release(umem_mgr);
+    udict_mgr_release(udict_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
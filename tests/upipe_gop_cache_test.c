@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for gop cache pipes
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/upipe.h>
+#include <upipe-modules/upipe_gop_cache.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+#define PACKET_SIZE 188
+#define MAX_PACKETS 32
+
+/** phony sink recording the received packets */
+struct test_sink {
+    /** packet numbers */
+    uint8_t packets[MAX_PACKETS];
+    /** number of received packets */
+    unsigned int nb;
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+        case UPROBE_SOURCE_END:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct test_sink *test_sink = malloc(sizeof(struct test_sink));
+    assert(test_sink != NULL);
+    test_sink->nb = 0;
+    upipe_init(&test_sink->upipe, mgr, uprobe);
+    return &test_sink->upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    struct test_sink *test_sink = container_of(upipe, struct test_sink, upipe);
+    assert(uref != NULL);
+    assert(test_sink->nb < MAX_PACKETS);
+    ubase_assert(uref_block_extract(uref, 0, 1,
+                                    &test_sink->packets[test_sink->nb]));
+    test_sink->nb++;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            ubase_assert(uref_flow_match_def(flow_def, "block.mpegts."));
+            return UBASE_ERR_NONE;
+        }
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    struct test_sink *test_sink = container_of(upipe, struct test_sink, upipe);
+    upipe_clean(upipe);
+    free(test_sink);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr gop_cache_test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** sends a packet */
+static void send_packet(struct upipe *upipe, struct uref_mgr *uref_mgr,
+                        struct ubuf_mgr *ubuf_mgr, uint8_t number,
+                        bool random)
+{
+    struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, PACKET_SIZE);
+    assert(uref != NULL);
+    uint8_t *buffer;
+    int size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    memset(buffer, number, size);
+    uref_block_unmap(uref, 0);
+    if (random)
+        uref_flow_set_random(uref);
+    upipe_input(upipe, uref, NULL);
+}
+
+/** checks the packets received by a sink */
+static void check_sink(struct upipe *upipe, const uint8_t *packets,
+                       unsigned int nb)
+{
+    struct test_sink *test_sink = container_of(upipe, struct test_sink, upipe);
+    assert(test_sink->nb == nb);
+    assert(!memcmp(test_sink->packets, packets, nb));
+    test_sink->nb = 0;
+}
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 0, 0, 0, 0);
+    assert(ubuf_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+
+    struct upipe *upipe_sink0 = upipe_void_alloc(&gop_cache_test_mgr,
+                                                 uprobe_use(logger));
+    assert(upipe_sink0 != NULL);
+    struct upipe *upipe_sink1 = upipe_void_alloc(&gop_cache_test_mgr,
+                                                 uprobe_use(logger));
+    assert(upipe_sink1 != NULL);
+
+    struct upipe_mgr *upipe_gop_cache_mgr = upipe_gop_cache_mgr_alloc();
+    assert(upipe_gop_cache_mgr != NULL);
+    struct upipe *upipe_gop_cache = upipe_void_alloc(upipe_gop_cache_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "gop cache"));
+    assert(upipe_gop_cache != NULL);
+
+    struct uref *uref = uref_block_flow_alloc_def(uref_mgr, "mpegts.");
+    assert(uref != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_gop_cache, uref));
+    uref_free(uref);
+
+    struct upipe *upipe_output0 = upipe_void_alloc_sub(upipe_gop_cache,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "gop cache output 0"));
+    assert(upipe_output0 != NULL);
+    ubase_assert(upipe_set_output(upipe_output0, upipe_sink0));
+
+    /* nothing is cached before the first random access point */
+    uint64_t size;
+    send_packet(upipe_gop_cache, uref_mgr, ubuf_mgr, 0, false);
+    ubase_assert(upipe_gop_cache_get_size(upipe_gop_cache, &size));
+    assert(size == 0);
+    for (uint8_t i = 1; i < 7; i++)
+        send_packet(upipe_gop_cache, uref_mgr, ubuf_mgr, i, i == 1 || i == 4);
+    ubase_assert(upipe_gop_cache_get_size(upipe_gop_cache, &size));
+    assert(size == 3 * PACKET_SIZE);
+    const uint8_t live[] = { 0, 1, 2, 3, 4, 5, 6 };
+    check_sink(upipe_sink0, live, 7);
+
+    /* a new output gets the stream since the last random access point */
+    struct upipe *upipe_output1 = upipe_void_alloc_sub(upipe_gop_cache,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "gop cache output 1"));
+    assert(upipe_output1 != NULL);
+    ubase_assert(upipe_set_output(upipe_output1, upipe_sink1));
+    send_packet(upipe_gop_cache, uref_mgr, ubuf_mgr, 7, false);
+    const uint8_t joined[] = { 4, 5, 6, 7 };
+    check_sink(upipe_sink1, joined, 4);
+    check_sink(upipe_sink0, joined + 3, 1);
+    send_packet(upipe_gop_cache, uref_mgr, ubuf_mgr, 8, false);
+    const uint8_t next[] = { 8 };
+    check_sink(upipe_sink0, next, 1);
+    check_sink(upipe_sink1, next, 1);
+    upipe_release(upipe_output1);
+
+    /* a new output joining on a random access point gets no cache */
+    upipe_output1 = upipe_void_alloc_sub(upipe_gop_cache,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "gop cache output 1"));
+    assert(upipe_output1 != NULL);
+    ubase_assert(upipe_set_output(upipe_output1, upipe_sink1));
+    send_packet(upipe_gop_cache, uref_mgr, ubuf_mgr, 9, true);
+    const uint8_t random[] = { 9 };
+    check_sink(upipe_sink0, random, 1);
+    check_sink(upipe_sink1, random, 1);
+
+    /* the cache is disabled when it grows too much */
+    uint64_t max_size;
+    ubase_assert(upipe_gop_cache_set_max_size(upipe_gop_cache,
+                                              2 * PACKET_SIZE));
+    ubase_assert(upipe_gop_cache_get_max_size(upipe_gop_cache, &max_size));
+    assert(max_size == 2 * PACKET_SIZE);
+    send_packet(upipe_gop_cache, uref_mgr, ubuf_mgr, 10, false);
+    ubase_assert(upipe_gop_cache_get_size(upipe_gop_cache, &size));
+    assert(size == 2 * PACKET_SIZE);
+    send_packet(upipe_gop_cache, uref_mgr, ubuf_mgr, 11, false);
+    ubase_assert(upipe_gop_cache_get_size(upipe_gop_cache, &size));
+    assert(size == 0);
+    send_packet(upipe_gop_cache, uref_mgr, ubuf_mgr, 12, true);
+    ubase_assert(upipe_gop_cache_get_size(upipe_gop_cache, &size));
+    assert(size == PACKET_SIZE);
+    const uint8_t end[] = { 10, 11, 12 };
+    check_sink(upipe_sink0, end, 3);
+    check_sink(upipe_sink1, end, 3);
+
+    upipe_release(upipe_gop_cache);
+    upipe_release(upipe_output0);
+    upipe_release(upipe_output1);
+
+    test_free(upipe_sink0);
+    test_free(upipe_sink1);
+
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    return 0;
+}
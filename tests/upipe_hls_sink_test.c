@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short unit tests for hls sink pipes
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uclock.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_std.h>
+#include <upipe/upipe.h>
+#include <upipe-modules/upipe_file_sink.h>
+#include <upipe-modules/upipe_hls_sink.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH    0
+#define UREF_POOL_DEPTH     0
+#define UBUF_POOL_DEPTH     0
+#define UPROBE_LOG_LEVEL    UPROBE_LOG_DEBUG
+#define PACKET_SIZE         188
+#define NB_PACKETS          22
+
+/** playlist after the first segment */
+static const char *playlist_head =
+    "#EXTM3U\n"
+    "#EXT-X-VERSION:3\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-MEDIA-SEQUENCE:0\n"
+    "#EXT-X-PLAYLIST-TYPE:EVENT\n"
+    "#EXTINF:4.000,\n"
+    "test0.ts\n";
+
+/** playlist at the end */
+static const char *playlist_tail =
+    "#EXTINF:4.000,\n"
+    "test1.ts\n"
+    "#EXTINF:2.000,\n"
+    "test2.ts\n"
+    "#EXT-X-ENDLIST\n";
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_LOG:
+        case UPROBE_NEED_UPUMP_MGR:
+            break;
+        default:
+            assert(0);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** reads a whole file into a static buffer */
+static const char *read_file(const char *path, size_t *size_p)
+{
+    static char buffer[4096];
+    FILE *file = fopen(path, "r");
+    assert(file != NULL);
+    size_t size = fread(buffer, 1, sizeof (buffer) - 1, file);
+    fclose(file);
+    buffer[size] = '\0';
+    if (size_p != NULL)
+        *size_p = size;
+    return buffer;
+}
+
+int main(int argc, char **argv)
+{
+    printf("Compiled %s %s - %s\n", __DATE__, __TIME__, __FILE__);
+
+    char dir[] = "/tmp/upipe_hls_sink_test.XXXXXX";
+    assert(mkdtemp(dir) != NULL);
+    char playlist[sizeof (dir) + 16];
+    snprintf(playlist, sizeof (playlist), "%s/test.m3u8", dir);
+
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr =
+        udict_inline_mgr_alloc(UDICT_POOL_DEPTH, umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr =
+        uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr =
+        ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH, umem_mgr,
+                                 0, 0, -1, 0);
+    assert(ubuf_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    struct upipe_mgr *upipe_fsink_mgr = upipe_fsink_mgr_alloc();
+    assert(upipe_fsink_mgr != NULL);
+    struct upipe_mgr *upipe_hls_sink_mgr = upipe_hls_sink_mgr_alloc();
+    assert(upipe_hls_sink_mgr != NULL);
+    struct upipe *hls_sink = upipe_void_alloc(upipe_hls_sink_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "hls"));
+    assert(hls_sink != NULL);
+    ubase_assert(upipe_hls_sink_set_writer_mgr(hls_sink, upipe_fsink_mgr));
+    ubase_assert(upipe_hls_sink_set_duration(hls_sink, UCLOCK_FREQ * 3));
+    ubase_assert(upipe_set_uri(hls_sink, playlist));
+
+    struct uref *uref = uref_block_flow_alloc_def(uref_mgr, "mpegts.");
+    assert(uref != NULL);
+    ubase_assert(upipe_set_flow_def(hls_sink, uref));
+    uref_free(uref);
+
+    /* one packet every 500 ms, a random access point every 2 s starting
+     * after the first packet */
+    for (unsigned int i = 0; i < NB_PACKETS; i++) {
+        uref = uref_block_alloc(uref_mgr, ubuf_mgr, PACKET_SIZE);
+        assert(uref != NULL);
+        uint8_t *buffer;
+        int size = -1;
+        ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+        memset(buffer, i, size);
+        uref_block_unmap(uref, 0);
+        uref_clock_set_cr_sys(uref, i * UCLOCK_FREQ / 2);
+        if (i % 4 == 1)
+            uref_flow_set_random(uref);
+        upipe_input(hls_sink, uref, NULL);
+
+        if (i == 9) {
+            /* the first segment was appended to the playlist */
+            assert(!strcmp(read_file(playlist, NULL), playlist_head));
+        }
+    }
+
+    upipe_release(hls_sink);
+    upipe_mgr_release(upipe_hls_sink_mgr);
+    upipe_mgr_release(upipe_fsink_mgr);
+
+    const char *content = read_file(playlist, NULL);
+    printf("%s", content);
+    assert(!strncmp(content, playlist_head, strlen(playlist_head)));
+    assert(!strcmp(content + strlen(playlist_head), playlist_tail));
+
+    static const unsigned int nb_packets[] = { 8, 8, 5 };
+    static const unsigned int first_packets[] = { 1, 9, 17 };
+    for (unsigned int i = 0; i < 3; i++) {
+        char segment[sizeof (dir) + 16];
+        snprintf(segment, sizeof (segment), "%s/test%u.ts", dir, i);
+        size_t size;
+        const char *data = read_file(segment, &size);
+        assert(size == nb_packets[i] * PACKET_SIZE);
+        assert(data[0] == first_packets[i]);
+        unlink(segment);
+    }
+    unlink(playlist);
+    rmdir(dir);
+
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
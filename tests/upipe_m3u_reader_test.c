@@ -22,6 +22,8 @@
 #include <upipe-modules/upipe_null.h>
 
 #include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
 #include <assert.h>
 
 #define UDICT_POOL_DEPTH 0
@@ -81,6 +83,15 @@ static int catch_uref(struct uprobe *uprobe,
         if (ubase_check(uref_m3u_playlist_flow_get_endlist(uref)))
             printf("playlist end\n");
 
+        uint64_t part_target;
+        if (ubase_check(uref_m3u_playlist_flow_get_part_target(
+                    uref, &part_target)))
+            printf("playlist part target: %"PRIu64"\n", part_target);
+
+        uint64_t update;
+        if (ubase_check(uref_m3u_playlist_flow_get_update(uref, &update)))
+            printf("playlist update: %"PRIu64"\n", update);
+
         return UBASE_ERR_NONE;
     }
 
@@ -110,6 +121,15 @@ static int catch_uref(struct uprobe *uprobe,
             printf("playlist byte range offset: %"PRIu64"\n",
                    playlist_byte_range_off);
 
+        if (ubase_check(uref_m3u_playlist_get_part(uref)))
+            printf("playlist part\n");
+
+        if (ubase_check(uref_m3u_playlist_get_independent(uref)))
+            printf("playlist independent\n");
+
+        if (ubase_check(uref_m3u_playlist_get_preload_hint(uref)))
+            printf("playlist preload hint\n");
+
         uint64_t master_bandwidth;
         if (ubase_check(uref_m3u_master_get_bandwidth(
                     uref, &master_bandwidth)))
@@ -159,6 +179,12 @@ static int catch_uref(struct uprobe *uprobe,
 
 int main(int argc, char *argv[])
 {
+    bool incremental = false;
+    if (argc >= 2 && !strcmp(argv[1], "-i")) {
+        incremental = true;
+        argc--;
+        argv++;
+    }
     assert(argc >= 2);
     nb_files = argc - 1;
     files = argv + 1;
@@ -207,6 +233,8 @@ int main(int argc, char *argv[])
                          UPROBE_LOG_VERBOSE, "m3u reader"));
     upipe_mgr_release(upipe_m3u_reader_mgr);
     assert(upipe_m3u_reader != NULL);
+    ubase_assert(upipe_m3u_reader_set_incremental(upipe_m3u_reader,
+                                                  incremental));
 
     struct uprobe uprobe_uref;
     uprobe_init(&uprobe_uref, catch_uref, uprobe_use(logger));
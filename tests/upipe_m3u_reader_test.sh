@@ -13,3 +13,10 @@ for file in "$srcdir"/upipe_m3u_reader_test_files/*.m3u; do
     "$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_m3u_reader_test $file > "$TMP"/logs
     diff -u "$file".logs "$TMP"/logs
 done
+
+# successive loads of a live playlist, as incremental updates
+dir="$srcdir"/upipe_m3u_reader_test_files/incremental
+echo "$dir"
+"$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_m3u_reader_test -i \
+    "$dir"/1.m3u "$dir"/2.m3u "$dir"/3.m3u "$dir"/4.m3u > "$TMP"/logs
+diff -u "$dir"/incremental.logs "$TMP"/logs
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short unit tests for the metrics exporter
+ */
+
+#undef NDEBUG
+
+#include <upipe/uclock.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_std.h>
+#include <upipe/upipe.h>
+#include <upipe-modules/upipe_null.h>
+#include <upipe-modules/upipe_metrics.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH    5
+#define UREF_POOL_DEPTH     5
+#define UBUF_POOL_DEPTH     5
+#define ITERATIONS          10
+#define BLOCK_SIZE          188
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+
+static unsigned int nb_collects = 0;
+
+/** custom collector */
+static void collect(void *opaque, FILE *file)
+{
+    assert(opaque == &nb_collects);
+    nb_collects++;
+    fprintf(file, "# TYPE test_custom gauge\ntest_custom 42\n");
+}
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe, int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_LOG:
+            break;
+        default:
+            assert(0);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+int main(int argc, char **argv)
+{
+    printf("Compiled %s %s - %s\n", __DATE__, __TIME__, __FILE__);
+
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                   udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 0, 0, -1, 0);
+    assert(ubuf_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+
+    struct upipe_mgr *upipe_null_mgr = upipe_null_mgr_alloc();
+    assert(upipe_null_mgr);
+    struct upipe *nullpipe = upipe_void_alloc(upipe_null_mgr,
+               uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "null"));
+    assert(nullpipe);
+    ubase_assert(upipe_stats_enable(nullpipe, NULL, 0));
+
+    struct upipe_metrics *metrics =
+        upipe_metrics_alloc(NULL, NULL, 0, NULL, NULL);
+    assert(metrics != NULL);
+    ubase_assert(upipe_metrics_add_pipe(metrics, nullpipe, "null \"1\""));
+    ubase_assert(upipe_metrics_add_umem_mgr(metrics, umem_mgr, "alloc"));
+    ubase_assert(upipe_metrics_add_collector(metrics, collect,
+                                             &nb_collects));
+    ubase_nassert(upipe_metrics_add_pipe(metrics, NULL, "none"));
+
+    for (int i = 0; i < ITERATIONS; i++) {
+        struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, BLOCK_SIZE);
+        assert(uref != NULL);
+        upipe_input(nullpipe, uref, NULL);
+    }
+    upipe_stats_error(nullpipe, 3);
+    upipe_stats_jitter(nullpipe, UCLOCK_FREQ / 1000);
+
+    FILE *file = tmpfile();
+    assert(file != NULL);
+    upipe_metrics_print(metrics, file);
+    char buffer[8192];
+    rewind(file);
+    size_t len = fread(buffer, 1, sizeof(buffer) - 1, file);
+    buffer[len] = '\0';
+    fclose(file);
+    printf("%s", buffer);
+
+    assert(nb_collects == 1);
+    assert(strstr(buffer, "# TYPE upipe_urefs counter\n") != NULL);
+    assert(strstr(buffer, "upipe_urefs_total{pipe=\"null \\\"1\\\"\"} 10\n")
+           != NULL);
+    assert(strstr(buffer, "upipe_bytes_total{pipe=\"null \\\"1\\\"\"} 1880\n")
+           != NULL);
+    assert(strstr(buffer, "upipe_errors_total{pipe=\"null \\\"1\\\"\"} 3\n")
+           != NULL);
+    assert(strstr(buffer, "upipe_jitter_seconds{pipe=\"null \\\"1\\\"\"} "
+                          "0.001000000\n") != NULL);
+    assert(strstr(buffer, "upipe_held_bytes{pipe=\"null \\\"1\\\"\"} 0\n")
+           != NULL);
+    assert(strstr(buffer, "upipe_queue_length{pipe=\"null \\\"1\\\"\"} 0\n")
+           != NULL);
+    assert(strstr(buffer, "# TYPE upipe_ingress_latency_seconds histogram\n")
+           != NULL);
+    assert(strstr(buffer, "upipe_ingress_latency_seconds_count") == NULL);
+    assert(strstr(buffer, "umem=\"alloc\"") == NULL);
+    assert(strstr(buffer, "test_custom 42\n") != NULL);
+    assert(strstr(buffer, "upipe_loop_lag_seconds") == NULL);
+    assert(len > strlen("# EOF\n") &&
+           !strcmp(buffer + len - strlen("# EOF\n"), "# EOF\n"));
+
+    upipe_metrics_free(metrics);
+    upipe_release(nullpipe);
+
+    upipe_mgr_release(upipe_null_mgr); // no-op
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
@@ -85,6 +85,7 @@ static struct upump *idler;
 static uint64_t rotate = 0;
 static uint64_t rotate_offset = 0;
 static uint64_t gen_systime = 0;
+static unsigned int direct = 0;
 
 static void sig_handler(int sig)
 {
@@ -93,7 +94,7 @@ static void sig_handler(int sig)
 }
 
 static void usage(const char *argv0) {
-    fprintf(stdout, "Usage: %s [-r <rotate> [-O <rotate offset>]] <dest dir> <suffix>\n", argv0);
+    fprintf(stdout, "Usage: %s [-d <direct I/O size>] [-r <rotate> [-O <rotate offset>]] <dest dir> <suffix>\n", argv0);
     exit(EXIT_FAILURE);
 }
 
@@ -215,8 +216,11 @@ int main(int argc, char *argv[])
 
     signal (SIGINT, sig_handler);
 
-    while ((opt = getopt(argc, argv, "r:O:")) != -1) {
+    while ((opt = getopt(argc, argv, "d:r:O:")) != -1) {
         switch (opt) {
+            case 'd':
+                direct = strtoul(optarg, NULL, 0);
+                break;
             case 'r':
                 rotate = strtoull(optarg, NULL, 0);
                 break;
@@ -288,6 +292,10 @@ int main(int argc, char *argv[])
         upipe_multicat_sink_get_rotate(multicat_sink, &rotate, &rotate_offset);
     }
     ubase_assert(upipe_multicat_sink_set_mode(multicat_sink, UPIPE_FSINK_OVERWRITE));
+    if (direct) {
+        ubase_assert(upipe_fsink_set_direct(multicat_sink, direct));
+        ubase_assert(upipe_fsink_set_preallocate(multicat_sink, direct));
+    }
     ubase_assert(upipe_multicat_sink_set_path(multicat_sink, dirpath, suffix));
 
     // idler - packet generator
@@ -338,10 +346,19 @@ int main(int argc, char *argv[])
     ubase_assert(uref_msrc_flow_set_aux(flow, suffix));
     ubase_assert(uref_msrc_flow_set_rotate(flow, rotate));
     ubase_assert(uref_msrc_flow_set_offset(flow, rotate_offset));
+    if (direct)
+        ubase_assert(uref_msrc_flow_set_direct(flow, direct));
     ubase_assert(upipe_set_flow_def(msrc, flow));
     uref_free(flow);
     ubase_assert(upipe_set_output_size(msrc, sizeof(uint64_t)));
 
+    /* records which are not made of TS packets are left untouched */
+    static const uint8_t pid_filter[8192 / 8];
+    const uint8_t *pid_filter_p;
+    ubase_assert(upipe_msrc_set_pid_filter(msrc, pid_filter, NULL));
+    ubase_assert(upipe_msrc_get_pid_filter(msrc, &pid_filter_p));
+    assert(pid_filter_p == pid_filter);
+
     struct upipe *test = upipe_void_alloc(&test_mgr, uprobe_use(logger));
     assert(test != NULL);
     ubase_assert(upipe_set_output(msrc, test));
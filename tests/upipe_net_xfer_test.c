@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for net xfer sink and source pipes
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_upump_mgr.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_attr.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_serial.h>
+#include <upipe/upump.h>
+#include <upipe/upipe.h>
+#include <upump-uring/upump_uring.h>
+#include <upipe-modules/upipe_net_xfer_sink.h>
+#include <upipe-modules/upipe_net_xfer_source.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPUMP_POOL 0
+#define UPUMP_BLOCKER_POOL 0
+#define WINDOW 4
+#define BATCH 2
+#define NB_UREFS 20
+#define MAX_FRAME_SIZE 4096
+#define UPROBE_LOG_LEVEL UPROBE_LOG_VERBOSE
+
+UREF_ATTR_UNSIGNED(test, test, "x.test", test)
+
+static unsigned int received = 0;
+static bool got_flow_def = false;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+        case UPROBE_LOG:
+            break;
+        case UPROBE_SOURCE_END:
+            upipe_release(upipe);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    uint64_t value, pts;
+    ubase_assert(uref_test_get_test(uref, &value));
+    assert(value == received);
+    ubase_assert(uref_clock_get_pts_prog(uref, &pts));
+    assert(pts == 1000);
+
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    assert(size == 100 + 1000 * value);
+    uint8_t buffer[size];
+    ubase_assert(uref_block_extract(uref, 0, size, buffer));
+    for (size_t i = 0; i < size; i++)
+        assert(buffer[i] == (uint8_t)(i + value));
+    received++;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            const char *def;
+            ubase_assert(uref_flow_get_def(flow_def, &def));
+            assert(!strcmp(def, "block.test."));
+            got_flow_def = true;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr net_xfer_test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+int main(int argc, char *argv[])
+{
+    struct upump_mgr *upump_mgr =
+        upump_uring_mgr_alloc(UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                   udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 0, 0, 0, 0);
+    assert(ubuf_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_upump_mgr_alloc(logger, upump_mgr);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    struct upipe_mgr *upipe_net_xfer_sink_mgr =
+        upipe_net_xfer_sink_mgr_alloc();
+    assert(upipe_net_xfer_sink_mgr != NULL);
+    struct upipe *upipe_net_xfer_sink = upipe_void_alloc(
+            upipe_net_xfer_sink_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "net xfer sink"));
+    assert(upipe_net_xfer_sink != NULL);
+    ubase_nassert(upipe_net_xfer_sink_set_batch(upipe_net_xfer_sink, 0));
+    ubase_assert(upipe_net_xfer_sink_set_batch(upipe_net_xfer_sink, BATCH));
+    ubase_nassert(upipe_set_uri(upipe_net_xfer_sink, "invalid"));
+    ubase_assert(upipe_net_xfer_sink_set_fd(upipe_net_xfer_sink, fds[0]));
+    int fd;
+    ubase_assert(upipe_net_xfer_sink_get_fd(upipe_net_xfer_sink, &fd));
+    assert(fd == fds[0]);
+    uint64_t credits;
+    ubase_assert(upipe_net_xfer_sink_get_credits(upipe_net_xfer_sink,
+                                                 &credits));
+    assert(credits == 0);
+
+    struct upipe_mgr *upipe_net_xfer_src_mgr = upipe_net_xfer_src_mgr_alloc();
+    assert(upipe_net_xfer_src_mgr != NULL);
+    struct upipe *upipe_net_xfer_src = upipe_void_alloc(
+            upipe_net_xfer_src_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "net xfer source"));
+    assert(upipe_net_xfer_src != NULL);
+    ubase_nassert(upipe_net_xfer_src_set_window(upipe_net_xfer_src, 0));
+    ubase_assert(upipe_net_xfer_src_set_window(upipe_net_xfer_src, WINDOW));
+    unsigned int window;
+    ubase_assert(upipe_net_xfer_src_get_window(upipe_net_xfer_src, &window));
+    assert(window == WINDOW);
+    ubase_assert(upipe_net_xfer_src_set_fd(upipe_net_xfer_src, fds[1]));
+
+    struct upipe *upipe_sink = upipe_void_alloc(&net_xfer_test_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "sink"));
+    assert(upipe_sink != NULL);
+    ubase_assert(upipe_set_output(upipe_net_xfer_src, upipe_sink));
+
+    struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr, "test.");
+    assert(flow_def != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_net_xfer_sink, flow_def));
+    uref_free(flow_def);
+
+    /* no credits have been received yet, so everything is held */
+    for (unsigned int i = 0; i < NB_UREFS; i++) {
+        size_t size = 100 + 1000 * i;
+        struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, size);
+        assert(uref != NULL);
+        uint8_t *buffer;
+        int write_size = -1;
+        ubase_assert(uref_block_write(uref, 0, &write_size, &buffer));
+        assert(write_size == size);
+        for (size_t j = 0; j < size; j++)
+            buffer[j] = j + i;
+        ubase_assert(uref_block_unmap(uref, 0));
+        ubase_assert(uref_test_set_test(uref, i));
+        uref_clock_set_pts_prog(uref, 1000);
+        upipe_input(upipe_net_xfer_sink, uref, NULL);
+    }
+    assert(received == 0);
+    upipe_release(upipe_net_xfer_sink);
+
+    upump_mgr_run(upump_mgr, NULL);
+    assert(got_flow_def);
+    assert(received == NB_UREFS);
+
+    /* a frame exceeding the maximum size closes the connection */
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    upipe_net_xfer_src = upipe_void_alloc(upipe_net_xfer_src_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "net xfer source"));
+    assert(upipe_net_xfer_src != NULL);
+    ubase_nassert(upipe_net_xfer_src_set_max_frame_size(upipe_net_xfer_src,
+                                                        0));
+    ubase_assert(upipe_net_xfer_src_set_max_frame_size(upipe_net_xfer_src,
+                                                       MAX_FRAME_SIZE));
+    unsigned int max_frame_size;
+    ubase_assert(upipe_net_xfer_src_get_max_frame_size(upipe_net_xfer_src,
+                                                       &max_frame_size));
+    assert(max_frame_size == MAX_FRAME_SIZE);
+    ubase_assert(upipe_net_xfer_src_set_fd(upipe_net_xfer_src, fds[1]));
+    ubase_assert(upipe_set_output(upipe_net_xfer_src, upipe_sink));
+
+    uint8_t frame[UREF_SERIAL_FRAME_SIZE];
+    uref_serial_write_frame(frame, UREF_SERIAL_FRAME_UREF, 16,
+                            MAX_FRAME_SIZE);
+    assert(write(fds[0], frame, sizeof(frame)) == sizeof(frame));
+    upump_mgr_run(upump_mgr, NULL);
+    assert(received == NB_UREFS);
+    close(fds[0]);
+
+    test_free(upipe_sink);
+    upipe_mgr_release(upipe_net_xfer_src_mgr); // nop
+    upipe_mgr_release(upipe_net_xfer_sink_mgr); // nop
+
+    ubuf_mgr_release(ubuf_mgr);
+    upump_mgr_release(upump_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    return 0;
+}
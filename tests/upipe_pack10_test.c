@@ -41,10 +41,13 @@
 #include <upipe/ubuf_block.h>
 #include <upipe/ubuf_block_mem.h>
 #include <upipe/ubuf_block_stream.h>
+#include <upipe/ubuf_pic_mem.h>
 #include <upipe/uref.h>
 #include <upipe/uref_flow.h>
 #include <upipe/uref_block_flow.h>
 #include <upipe/uref_block.h>
+#include <upipe/uref_pic.h>
+#include <upipe/uref_pic_flow.h>
 #include <upipe/uref_std.h>
 #include <upipe/upipe.h>
 #include <upipe-hbrmt/upipe_pack10bit.h>
@@ -57,8 +60,12 @@
 #define UBUF_ALIGN 32 /* 256-bits simd */
 
 #define WIDTH 1024
+#define V210_WIDTH 516
+#define V210_HEIGHT 2
+#define V210_CHROMA "u10y10v10y10u10y10v10y10u10y10v10y10"
 
 static bool received_block = false;
+static int expected_samples = WIDTH;
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
@@ -93,15 +100,15 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     assert(uref != NULL);
     size_t size;
     ubase_assert(uref_block_size(uref, &size));
-    assert(size == WIDTH * 10 / 8);
+    assert(size == expected_samples * 10 / 8);
     received_block = true;
 
     struct ubuf_block_stream s;
     ubase_assert(ubuf_block_stream_init(&s, uref->ubuf, 0));
 
-    for (int i = 0; i < WIDTH; i++) {
+    for (int i = 0; i < expected_samples; i++) {
         ubuf_block_stream_fill_bits(&s, 10);
-        assert(ubuf_block_stream_show_bits(&s, 10) == i);
+        assert(ubuf_block_stream_show_bits(&s, 10) == (i & 0x3ff));
         ubuf_block_stream_skip_bits(&s, 10);
     }
 
@@ -200,6 +207,46 @@ int main(int argc, char *argv[])
     upipe_input(upipe_pack10, uref, NULL);
     assert(received_block);
 
+    /* v210 pictures are packed directly */
+    uref = uref_pic_flow_alloc_def(uref_mgr, 6);
+    assert(uref != NULL);
+    ubase_assert(uref_pic_flow_add_plane(uref, 1, 1, 16, V210_CHROMA));
+    ubase_assert(uref_pic_flow_set_hsize(uref, V210_WIDTH));
+    ubase_assert(uref_pic_flow_set_vsize(uref, V210_HEIGHT));
+    ubase_assert(upipe_set_flow_def(upipe_pack10, uref));
+    uref_free(uref);
+
+    struct ubuf_mgr *pic_mgr = ubuf_pic_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 6, 0, 0, 0, 0, UBUF_ALIGN, 0);
+    assert(pic_mgr != NULL);
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(pic_mgr, V210_CHROMA, 1, 1, 16));
+    uref = uref_pic_alloc(uref_mgr, pic_mgr, V210_WIDTH, V210_HEIGHT);
+    assert(uref != NULL);
+    size_t stride;
+    ubase_assert(uref_pic_plane_size(uref, V210_CHROMA, &stride,
+                                     NULL, NULL, NULL));
+    ubase_assert(uref_pic_plane_write(uref, V210_CHROMA, 0, 0, -1, -1,
+                                      &buffer));
+    int sample = 0;
+    for (int y = 0; y < V210_HEIGHT; y++) {
+        uint8_t *line = buffer + y * stride;
+        for (int x = 0; x < V210_WIDTH * 2 / 3; x++) {
+            uint32_t w = 0;
+            for (int j = 0; j < 3; j++)
+                w |= (uint32_t)(sample++ & 0x3ff) << (10 * j);
+            line[4 * x + 0] = w;
+            line[4 * x + 1] = w >> 8;
+            line[4 * x + 2] = w >> 16;
+            line[4 * x + 3] = w >> 24;
+        }
+    }
+    uref_pic_plane_unmap(uref, V210_CHROMA, 0, 0, -1, -1);
+    received_block = false;
+    expected_samples = V210_WIDTH * 2 * V210_HEIGHT;
+    upipe_input(upipe_pack10, uref, NULL);
+    assert(received_block);
+    ubuf_mgr_release(pic_mgr);
+
     upipe_release(upipe_pack10);
     upipe_mgr_release(upipe_pack10bit_mgr); // nop
 
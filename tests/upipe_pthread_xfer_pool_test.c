@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short unit tests for pools of xfer threads and xfer fast paths
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/urefcount.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uclock.h>
+#include <upipe/upump.h>
+#include <upipe/upipe.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upump-uring/upump_uring.h>
+#include <upipe-modules/upipe_transfer.h>
+#include <upipe-pthread/upipe_pthread_transfer.h>
+#include <upipe-pthread/uprobe_pthread_upump_mgr.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <assert.h>
+
+#define UPUMP_POOL 0
+#define UPUMP_BLOCKER_POOL 0
+#define XFER_QUEUE 255
+#define XFER_POOL 1
+#define SMALL_XFER_QUEUE 2
+#define NB_THREADS 2
+#define PREFAULT_UPUMP_POOL 8
+#define PREFAULT_STACK 65536
+#define PREFAULT_UMEM_SIZE 4096
+#define PREFAULT_UMEM_NB 4
+
+static struct uprobe *logger;
+
+/** helper phony pipe */
+struct test_pipe {
+    struct urefcount urefcount;
+    pthread_t *thread_p;
+    bool *attached_p;
+    struct upipe upipe;
+};
+
+/** helper phony pipe */
+static void test_free(struct urefcount *urefcount)
+{
+    struct test_pipe *test_pipe =
+        container_of(urefcount, struct test_pipe, urefcount);
+    urefcount_clean(&test_pipe->urefcount);
+    upipe_clean(&test_pipe->upipe);
+    free(test_pipe);
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr,
+                                struct uprobe *uprobe, uint32_t signature,
+                                va_list args)
+{
+    struct test_pipe *test_pipe = malloc(sizeof(struct test_pipe));
+    assert(test_pipe != NULL);
+    upipe_init(&test_pipe->upipe, mgr, uprobe);
+    urefcount_init(&test_pipe->urefcount, test_free);
+    test_pipe->upipe.refcount = &test_pipe->urefcount;
+    test_pipe->thread_p = NULL;
+    test_pipe->attached_p = NULL;
+    return &test_pipe->upipe;
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    struct test_pipe *test_pipe = container_of(upipe, struct test_pipe, upipe);
+    switch (command) {
+        case UPIPE_ATTACH_UPUMP_MGR:
+            /* read by the main thread after the remote thread is joined */
+            *test_pipe->thread_p = pthread_self();
+            *test_pipe->attached_p = true;
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = NULL,
+    .upipe_control = test_control
+};
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe, int event,
+                 va_list args)
+{
+    switch (event) {
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEED_UPUMP_MGR:
+            break;
+        default:
+            assert(0);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** allocates an xfer pipe on the manager selected by the pool */
+static struct upipe *transfer(struct upipe_mgr *pool, pthread_t *thread_p,
+                              bool *attached_p, struct upipe_mgr **xfer_mgr_p)
+{
+    *attached_p = false;
+    ubase_assert(upipe_xfer_mgr_select(pool, xfer_mgr_p));
+    assert(*xfer_mgr_p != NULL);
+
+    struct upipe *upipe_test = upipe_void_alloc(&test_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_VERBOSE, "test"));
+    assert(upipe_test != NULL);
+    container_of(upipe_test, struct test_pipe, upipe)->thread_p = thread_p;
+    container_of(upipe_test, struct test_pipe, upipe)->attached_p = attached_p;
+
+    struct upipe *upipe_xfer = upipe_xfer_alloc(*xfer_mgr_p,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_VERBOSE, "xfer"),
+            upipe_test);
+    assert(upipe_xfer != NULL);
+    ubase_assert(upipe_attach_upump_mgr(upipe_xfer));
+    return upipe_xfer;
+}
+
+/** manager with a full queue, and its pipes */
+static struct upipe_mgr *small_mgr;
+static struct upipe *small_pipes[2];
+
+/** sends the batch left over when the queue was full once it is drained,
+ * then releases the pipes once the batch is executed */
+static void small_retry(struct upump *upump)
+{
+    static bool retried = false;
+    if (!retried) {
+        ubase_assert(upipe_xfer_mgr_end_batch(small_mgr));
+        retried = true;
+        return;
+    }
+    upump_free(upump);
+    upipe_release(small_pipes[0]);
+    upipe_release(small_pipes[1]);
+    upipe_mgr_release(small_mgr);
+}
+
+int main(int argc, char **argv)
+{
+    struct upump_mgr *upump_mgr =
+        upump_uring_mgr_alloc(UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    logger = uprobe_stdio_alloc(&uprobe, stdout, UPROBE_LOG_WARNING);
+    assert(logger != NULL);
+    logger = uprobe_pthread_upump_mgr_alloc(logger);
+    assert(logger != NULL);
+    uprobe_pthread_upump_mgr_set(logger, upump_mgr);
+
+    /* commands to a manager attached to the calling event loop are run
+     * synchronously, unless they are coalesced */
+    struct upipe_mgr *local_mgr = upipe_xfer_mgr_alloc(XFER_QUEUE, XFER_POOL,
+                                                       NULL);
+    assert(local_mgr != NULL);
+    ubase_assert(upipe_xfer_mgr_attach(local_mgr, upump_mgr));
+
+    pthread_t thread0, thread4;
+    bool attached0, attached4;
+    struct upipe_mgr *xfer_mgr0, *xfer_mgr4;
+    struct upipe *upipe_xfer0 = transfer(local_mgr, &thread0, &attached0,
+                                         &xfer_mgr0);
+    assert(xfer_mgr0 == local_mgr);
+    assert(attached0);
+    assert(pthread_equal(thread0, pthread_self()));
+
+    ubase_assert(upipe_xfer_mgr_start_batch(local_mgr));
+    ubase_assert(upipe_xfer_mgr_start_batch(local_mgr));
+    struct upipe *upipe_xfer4 = transfer(local_mgr, &thread4, &attached4,
+                                         &xfer_mgr4);
+    upipe_release(upipe_xfer0);
+    ubase_assert(upipe_xfer_mgr_end_batch(local_mgr));
+    assert(!attached4);
+    ubase_assert(upipe_xfer_mgr_end_batch(local_mgr));
+    assert(!attached4);
+    upipe_release(upipe_xfer4);
+    upipe_mgr_release(xfer_mgr0);
+    upipe_mgr_release(xfer_mgr4);
+    upipe_mgr_release(local_mgr);
+
+    /* commands sent after a batch that didn't fit in the queue fail, instead
+     * of being coalesced after the end of the batch */
+    small_mgr = upipe_xfer_mgr_alloc(SMALL_XFER_QUEUE, XFER_POOL, NULL);
+    assert(small_mgr != NULL);
+    ubase_assert(upipe_xfer_mgr_attach(small_mgr, upump_mgr));
+    pthread_t thread6, thread7;
+    bool attached6, attached7;
+    struct upipe_mgr *xfer_mgr6, *xfer_mgr7;
+    ubase_assert(upipe_xfer_mgr_start_batch(small_mgr));
+    small_pipes[0] = transfer(small_mgr, &thread6, &attached6, &xfer_mgr6);
+    ubase_assert(upipe_xfer_mgr_end_batch(small_mgr));
+    small_pipes[1] = transfer(small_mgr, &thread7, &attached7, &xfer_mgr7);
+    ubase_assert(upipe_xfer_mgr_start_batch(small_mgr));
+    ubase_assert(upipe_attach_upump_mgr(small_pipes[1]));
+    assert(!ubase_check(upipe_xfer_mgr_end_batch(small_mgr)));
+    assert(!ubase_check(upipe_attach_upump_mgr(small_pipes[0])));
+    assert(!attached6 && !attached7);
+    upipe_mgr_release(xfer_mgr6);
+    upipe_mgr_release(xfer_mgr7);
+    struct upump *upump = upump_alloc_timer(upump_mgr, small_retry, NULL,
+                                            NULL, UCLOCK_FREQ / 100,
+                                            UCLOCK_FREQ / 100);
+    assert(upump != NULL);
+    upump_start(upump);
+
+    /* a thread with scheduling and memory options */
+    struct upipe_pthread_attr pthread_attr;
+    upipe_pthread_attr_init(&pthread_attr);
+    pthread_attr.cpus = "0-";
+    assert(upipe_pthread_xfer_mgr_alloc_attr(XFER_QUEUE, XFER_POOL,
+                uprobe_use(logger), upump_uring_mgr_alloc, UPUMP_POOL,
+                UPUMP_BLOCKER_POOL, NULL, NULL, NULL, &pthread_attr) == NULL);
+    pthread_attr.cpus = "0";
+    pthread_attr.priority = -1;
+    assert(upipe_pthread_xfer_mgr_alloc_attr(XFER_QUEUE, XFER_POOL,
+                uprobe_use(logger), upump_uring_mgr_alloc, UPUMP_POOL,
+                UPUMP_BLOCKER_POOL, NULL, NULL, NULL, &pthread_attr) == NULL);
+    pthread_attr.priority = 0;
+    pthread_attr.prefault_stack = PREFAULT_STACK;
+    pthread_attr.prefault_pools = true;
+    pthread_attr.umem_mgr = umem_alloc_mgr_alloc();
+    assert(pthread_attr.umem_mgr != NULL);
+    pthread_attr.umem_size = PREFAULT_UMEM_SIZE;
+    pthread_attr.umem_nb = PREFAULT_UMEM_NB;
+    struct upipe_mgr *attr_mgr = upipe_pthread_xfer_mgr_alloc_attr(
+            XFER_QUEUE, XFER_POOL, uprobe_use(logger), upump_uring_mgr_alloc,
+            PREFAULT_UPUMP_POOL, UPUMP_BLOCKER_POOL, NULL, NULL, NULL,
+            &pthread_attr);
+    assert(attr_mgr != NULL);
+    umem_mgr_release(pthread_attr.umem_mgr);
+
+    pthread_t thread5;
+    bool attached5;
+    struct upipe_mgr *xfer_mgr5;
+    struct upipe *upipe_xfer5 = transfer(attr_mgr, &thread5, &attached5,
+                                         &xfer_mgr5);
+    assert(xfer_mgr5 == attr_mgr);
+    upipe_release(upipe_xfer5);
+    upipe_mgr_release(xfer_mgr5);
+    upipe_mgr_release(attr_mgr);
+
+    struct upipe_mgr *pool = upipe_pthread_xfer_pool_alloc(NB_THREADS,
+            XFER_QUEUE, XFER_POOL, uprobe_use(logger), upump_uring_mgr_alloc,
+            UPUMP_POOL, UPUMP_BLOCKER_POOL, NULL, false);
+    assert(pool != NULL);
+
+    unsigned int load;
+    ubase_assert(upipe_xfer_mgr_get_load(pool, &load));
+    assert(load == 0);
+
+    pthread_t thread1, thread2, thread3;
+    bool attached1, attached2, attached3;
+    struct upipe_mgr *xfer_mgr1, *xfer_mgr2, *xfer_mgr3;
+    struct upipe *upipe_xfer1 = transfer(pool, &thread1, &attached1,
+                                         &xfer_mgr1);
+    ubase_assert(upipe_xfer_mgr_get_load(xfer_mgr1, &load));
+    assert(load == 1);
+
+    /* the second set of pipes goes to the idle thread */
+    struct upipe *upipe_xfer2 = transfer(pool, &thread2, &attached2,
+                                         &xfer_mgr2);
+    assert(xfer_mgr2 != xfer_mgr1);
+    ubase_assert(upipe_xfer_mgr_get_load(pool, &load));
+    assert(load == 2);
+
+    /* the first thread is the least loaded again */
+    upipe_release(upipe_xfer1);
+    struct upipe *upipe_xfer3 = transfer(pool, &thread3, &attached3,
+                                         &xfer_mgr3);
+    assert(xfer_mgr3 == xfer_mgr1);
+
+    upipe_release(upipe_xfer2);
+    upipe_release(upipe_xfer3);
+    upipe_mgr_release(xfer_mgr1);
+    upipe_mgr_release(xfer_mgr2);
+    upipe_mgr_release(xfer_mgr3);
+    upipe_mgr_release(pool);
+
+    /* returns when all the threads of the pool are joined */
+    upump_mgr_run(upump_mgr, NULL);
+
+    assert(attached4);
+    assert(pthread_equal(thread4, pthread_self()));
+    assert(attached6 && attached7);
+    assert(pthread_equal(thread6, pthread_self()));
+    assert(attached1 && attached2 && attached3);
+    assert(!pthread_equal(thread1, pthread_self()));
+    assert(!pthread_equal(thread1, thread2));
+    assert(pthread_equal(thread1, thread3));
+    assert(attached5);
+    assert(!pthread_equal(thread5, pthread_self()));
+
+    upump_mgr_release(upump_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    return 0;
+}
@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short unit tests for queue sink watermarks
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_upump_mgr.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_attr.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/upump.h>
+#include <upipe/upipe.h>
+#include <upump-uring/upump_uring.h>
+#include <upipe-modules/upipe_queue_source.h>
+#include <upipe-modules/upipe_queue_sink.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UPUMP_POOL 0
+#define UPUMP_BLOCKER_POOL 0
+#define QUEUE_LENGTH 8
+#define HIGH_MARK 6
+#define LOW_MARK 2
+#define BURST 6
+#define NB_BURSTS 10
+#define UPROBE_LOG_LEVEL UPROBE_LOG_VERBOSE
+
+UREF_ATTR_UNSIGNED(test, test, "x.test", test)
+
+static struct uref_mgr *uref_mgr;
+static struct upipe *upipe_qsink;
+static uint64_t sent = 0;
+static uint64_t received = 0;
+static unsigned int bursts = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+        case UPROBE_SOURCE_END:
+            upipe_release(upipe);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    uint64_t value;
+    ubase_assert(uref_test_get_test(uref, &value));
+    assert(value == received);
+    received++;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr queue_test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** source pump feeding the queue by bursts */
+static void source_idler(struct upump *upump)
+{
+    struct upipe_qsink_stats stats;
+    ubase_assert(upipe_qsink_get_stats(upipe_qsink, &stats));
+    assert(!stats.blocked);
+    assert(stats.depth <= LOW_MARK);
+    assert(stats.nb_blocks == bursts);
+
+    for (int i = 0; i < BURST; i++) {
+        struct uref *uref = uref_alloc(uref_mgr);
+        assert(uref != NULL);
+        ubase_assert(uref_test_set_test(uref, sent++));
+        upipe_input(upipe_qsink, uref, &upump);
+    }
+    bursts++;
+
+    /* the high watermark is reached at the end of each burst */
+    ubase_assert(upipe_qsink_get_stats(upipe_qsink, &stats));
+    assert(stats.blocked);
+    assert(stats.depth >= HIGH_MARK);
+    assert(stats.high_mark == HIGH_MARK);
+    assert(stats.low_mark == LOW_MARK);
+    assert(stats.nb_blocks == bursts);
+
+    if (bursts == NB_BURSTS) {
+        upump_stop(upump);
+        upipe_release(upipe_qsink);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    struct upump_mgr *upump_mgr =
+        upump_uring_mgr_alloc(UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
+    assert(uref_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_upump_mgr_alloc(logger, upump_mgr);
+    assert(logger != NULL);
+
+    struct upipe *upipe_sink = upipe_void_alloc(&queue_test_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "sink"));
+    assert(upipe_sink != NULL);
+
+    struct upipe_mgr *upipe_qsrc_mgr = upipe_qsrc_mgr_alloc();
+    assert(upipe_qsrc_mgr != NULL);
+    struct upipe *upipe_qsrc = upipe_qsrc_alloc(upipe_qsrc_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "queue source"), QUEUE_LENGTH);
+    assert(upipe_qsrc != NULL);
+    ubase_assert(upipe_set_output(upipe_qsrc, upipe_sink));
+
+    struct upipe_mgr *upipe_qsink_mgr = upipe_qsink_mgr_alloc();
+    assert(upipe_qsink_mgr != NULL);
+    upipe_qsink = upipe_qsink_alloc(upipe_qsink_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "queue sink"),
+            upipe_qsrc);
+    assert(upipe_qsink != NULL);
+    upipe_release(upipe_qsrc);
+
+    struct uref *uref = uref_block_flow_alloc_def(uref_mgr, NULL);
+    assert(uref != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_qsink, uref));
+    uref_free(uref);
+
+    ubase_nassert(upipe_qsink_set_watermarks(upipe_qsink,
+                                             QUEUE_LENGTH + 1, LOW_MARK));
+    ubase_nassert(upipe_qsink_set_watermarks(upipe_qsink,
+                                             HIGH_MARK, HIGH_MARK));
+    ubase_assert(upipe_qsink_set_watermarks(upipe_qsink,
+                                            HIGH_MARK, LOW_MARK));
+
+    struct upump *upump = upump_alloc_idler(upump_mgr, source_idler, NULL,
+                                            NULL);
+    assert(upump != NULL);
+    upump_start(upump);
+
+    upump_mgr_run(upump_mgr, NULL);
+
+    assert(bursts == NB_BURSTS);
+    assert(received == BURST * NB_BURSTS);
+
+    upump_free(upump);
+    upipe_mgr_release(upipe_qsink_mgr); // nop
+    upipe_mgr_release(upipe_qsrc_mgr); // nop
+    test_free(upipe_sink);
+
+    upump_mgr_release(upump_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    return 0;
+}
@@ -0,0 +1,345 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for rtcpfb pipes
+ */
+
+#undef NDEBUG
+
+#include <upipe/uclock.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/uprobe_uclock.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_std.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe-filters/upipe_rtcp_fb_receiver.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include <bitstream/ietf/rtp.h>
+#include <bitstream/ietf/rtcp.h>
+#include <bitstream/ietf/rtcp_fb.h>
+
+#define UDICT_POOL_DEPTH    0
+#define UREF_POOL_DEPTH     0
+#define UBUF_POOL_DEPTH     0
+#define UPROBE_LOG_LEVEL    UPROBE_LOG_DEBUG
+#define FIRST_SEQNUM        65500
+#define PACKET_SIZE         1000
+#define PACKETS             100
+#define LATENCY             "50"
+#define RATE                (PACKET_SIZE * 8 * 80)
+#define SINKS               3
+
+/** current date */
+static uint64_t date = 0;
+/** sequence numbers received per sink */
+static uint16_t seqnums[SINKS][PACKETS * 2];
+/** number of packets received per sink */
+static unsigned int nb_packets[SINKS];
+/** data of the last packet received per sink */
+static const uint8_t *last_data[SINKS];
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+        case UPROBE_SOURCE_END:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper uclock */
+static uint64_t now(struct uclock *unused)
+{
+    return date;
+}
+
+/** helper phony pipe */
+struct rtcpfb_test {
+    int kind;
+    struct upipe upipe;
+};
+
+/** helper phony pipe */
+UPIPE_HELPER_UPIPE(rtcpfb_test, upipe, 0);
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct rtcpfb_test *rtcpfb_test = malloc(sizeof(struct rtcpfb_test));
+    assert(rtcpfb_test != NULL);
+    upipe_init(&rtcpfb_test->upipe, mgr, uprobe);
+    rtcpfb_test->kind = va_arg(args, int);
+    return &rtcpfb_test->upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    struct rtcpfb_test *rtcpfb_test = rtcpfb_test_from_upipe(upipe);
+    uint8_t buffer[RTP_HEADER_SIZE];
+    const uint8_t *rtp = uref_block_peek(uref, 0, RTP_HEADER_SIZE, buffer);
+    assert(rtp != NULL);
+    assert(nb_packets[rtcpfb_test->kind] < PACKETS * 2);
+    seqnums[rtcpfb_test->kind][nb_packets[rtcpfb_test->kind]++] =
+        rtp_get_seqnum(rtp);
+    uref_block_peek_unmap(uref, 0, buffer, rtp);
+    int size = -1;
+    ubase_assert(uref_block_read(uref, 0, &size,
+                                 &last_data[rtcpfb_test->kind]));
+    uref_block_unmap(uref, 0);
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    struct rtcpfb_test *rtcpfb_test = rtcpfb_test_from_upipe(upipe);
+    upipe_clean(upipe);
+    free(rtcpfb_test);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr rtcpfb_test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** builds a RTP packet sent at the given date */
+static struct uref *build_packet(struct uref_mgr *uref_mgr,
+                                 struct ubuf_mgr *ubuf_mgr, unsigned int n)
+{
+    struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, PACKET_SIZE);
+    assert(uref != NULL);
+    int size = -1;
+    uint8_t *buf;
+    ubase_assert(uref_block_write(uref, 0, &size, &buf));
+    memset(buf, n, size);
+    rtp_set_hdr(buf);
+    rtp_set_type(buf, 33);
+    rtp_set_seqnum(buf, FIRST_SEQNUM + n);
+    uref_block_unmap(uref, 0);
+    uref_clock_set_cr_sys(uref, n * UCLOCK_FREQ / 1000);
+    return uref;
+}
+
+/** builds a generic NACK message with a single FCI */
+static struct uref *build_nack(struct uref_mgr *uref_mgr,
+                               struct ubuf_mgr *ubuf_mgr,
+                               unsigned int n, uint16_t mask)
+{
+    int size = RTCP_FB_HEADER_SIZE + RTCP_FB_FCI_GENERIC_NACK_SIZE;
+    struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, size);
+    assert(uref != NULL);
+    uint8_t *buf;
+    ubase_assert(uref_block_write(uref, 0, &size, &buf));
+    memset(buf, 0, size);
+    rtcp_set_rtp_version(buf);
+    rtcp_fb_set_fmt(buf, RTCP_PT_RTPFB_GENERIC_NACK);
+    rtcp_set_pt(buf, RTCP_PT_RTPFB);
+    rtcp_set_length(buf, size / 4 - 1);
+    uint8_t *fci = &buf[RTCP_FB_HEADER_SIZE];
+    rtcp_fb_nack_set_packet_id(fci, FIRST_SEQNUM + n);
+    rtcp_fb_nack_set_bitmask_lost(fci, mask);
+    uref_block_unmap(uref, 0);
+    return uref;
+}
+
+int main(int argc, char **argv)
+{
+    printf("Compiled %s %s - %s\n", __DATE__, __TIME__, __FILE__);
+
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                   udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 0, 0, 0, 0);
+    assert(ubuf_mgr != NULL);
+
+    struct uclock uclock;
+    uclock.refcount = NULL;
+    uclock.uclock_now = now;
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+    logger = uprobe_uclock_alloc(logger, &uclock);
+    assert(logger != NULL);
+
+    struct upipe *sinks[SINKS];
+    for (int i = 0; i < SINKS; i++) {
+        sinks[i] = upipe_alloc(&rtcpfb_test_mgr, uprobe_use(logger), 0, i);
+        assert(sinks[i] != NULL);
+    }
+
+    struct upipe_mgr *upipe_rtcpfb_mgr = upipe_rtcpfb_mgr_alloc();
+    assert(upipe_rtcpfb_mgr != NULL);
+    struct upipe *rtcpfb = upipe_void_alloc(upipe_rtcpfb_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "rtcpfb"));
+    assert(rtcpfb != NULL);
+    ubase_assert(upipe_set_option(rtcpfb, "latency", LATENCY));
+
+    struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr, NULL);
+    assert(flow_def != NULL);
+    ubase_assert(upipe_set_flow_def(rtcpfb, flow_def));
+    ubase_assert(upipe_set_output(rtcpfb, sinks[0]));
+
+    /* one input subpipe per receiver */
+    struct upipe *receivers[2];
+    for (int i = 0; i < 2; i++) {
+        receivers[i] = upipe_void_alloc_sub(rtcpfb,
+                uprobe_pfx_alloc_va(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                                    "receiver %d", i));
+        assert(receivers[i] != NULL);
+        ubase_assert(upipe_set_flow_def(receivers[i], flow_def));
+        ubase_assert(upipe_set_output(receivers[i], sinks[i + 1]));
+    }
+    uref_free(flow_def);
+
+    uint64_t max_rate;
+    ubase_assert(upipe_rtcpfb_input_get_max_rate(receivers[1], &max_rate));
+    assert(max_rate == 0);
+    ubase_assert(upipe_rtcpfb_input_set_max_rate(receivers[1], RATE));
+    ubase_assert(upipe_rtcpfb_input_get_max_rate(receivers[1], &max_rate));
+    assert(max_rate == RATE);
+
+    for (unsigned int n = 0; n < PACKETS; n++)
+        upipe_input(rtcpfb, build_packet(uref_mgr, ubuf_mgr, n), NULL);
+    assert(nb_packets[0] == PACKETS);
+
+    /* packets 60, 61 and 63, packet 10 has expired */
+    upipe_input(receivers[0], build_nack(uref_mgr, ubuf_mgr, 60, 0x5), NULL);
+    upipe_input(receivers[0], build_nack(uref_mgr, ubuf_mgr, 10, 0), NULL);
+    assert(nb_packets[1] == 3);
+    assert(seqnums[1][0] == (uint16_t)(FIRST_SEQNUM + 60));
+    assert(seqnums[1][1] == (uint16_t)(FIRST_SEQNUM + 61));
+    assert(seqnums[1][2] == (uint16_t)(FIRST_SEQNUM + 63));
+    assert(nb_packets[2] == 0);
+
+    /* the retransmission shares the buffer of the stream */
+    const uint8_t *data = last_data[0];
+    upipe_input(receivers[0],
+                build_nack(uref_mgr, ubuf_mgr, PACKETS - 1, 0), NULL);
+    assert(nb_packets[1] == 4);
+    assert(last_data[1] == data);
+
+    /* 16 packets, the credit of receiver 1 covers a burst of 8 */
+    upipe_input(receivers[1], build_nack(uref_mgr, ubuf_mgr, 70, 0x7fff),
+                NULL);
+    assert(nb_packets[2] == 8);
+    for (unsigned int i = 0; i < 8; i++)
+        assert(seqnums[2][i] == (uint16_t)(FIRST_SEQNUM + 70 + i));
+
+    /* 50 ms later, the credit covers 4 more packets */
+    date += UCLOCK_FREQ / 20;
+    upipe_input(rtcpfb, build_packet(uref_mgr, ubuf_mgr, PACKETS), NULL);
+    assert(nb_packets[2] == 12);
+    date += UCLOCK_FREQ;
+    upipe_input(rtcpfb, build_packet(uref_mgr, ubuf_mgr, PACKETS + 1), NULL);
+    assert(nb_packets[2] == 16);
+    for (unsigned int i = 8; i < 16; i++)
+        assert(seqnums[2][i] == (uint16_t)(FIRST_SEQNUM + 70 + i));
+    assert(nb_packets[1] == 4);
+    assert(nb_packets[0] == PACKETS + 2);
+
+    for (int i = 0; i < 2; i++)
+        upipe_release(receivers[i]);
+    upipe_release(rtcpfb);
+    upipe_mgr_release(upipe_rtcpfb_mgr);
+    for (int i = 0; i < SINKS; i++)
+        test_free(sinks[i]);
+
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for rtp fec enc pipes
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_std.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe-ts/upipe_rtp_fec_enc.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include <bitstream/ietf/rtp.h>
+#include <bitstream/mpeg/ts.h>
+#include <bitstream/smpte/2022_1_fec.h>
+
+#define UDICT_POOL_DEPTH    0
+#define UREF_POOL_DEPTH     0
+#define UBUF_POOL_DEPTH     0
+#define UPROBE_LOG_LEVEL    UPROBE_LOG_DEBUG
+#define COLS                4
+#define ROWS                5
+#define MATRICES            3
+#define PACKETS             (COLS * ROWS * MATRICES)
+#define FIRST_SEQNUM        65530
+#define PAYLOAD_SIZE        (7 * TS_SIZE)
+
+/** payloads of the sent packets, indexed by packet number */
+static uint8_t payloads[PACKETS][PAYLOAD_SIZE];
+/** payload sizes of the sent packets */
+static int sizes[PACKETS];
+/** number of received packets per output */
+static unsigned int nb_media, nb_col, nb_row;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** checks a FEC packet against the protected packets */
+static void check_fec(struct uref *uref, bool row)
+{
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    uint8_t buffer[RTP_HEADER_SIZE + SMPTE_2022_FEC_HEADER_SIZE +
+                   PAYLOAD_SIZE];
+    assert(size <= sizeof(buffer));
+    ubase_assert(uref_block_extract(uref, 0, size, buffer));
+
+    const uint8_t *fec = buffer + RTP_HEADER_SIZE;
+    assert(smpte_fec_check_d(fec) == row);
+    assert(smpte_fec_get_offset(fec) == (row ? 1 : COLS));
+    assert(smpte_fec_get_na(fec) == (row ? COLS : ROWS));
+    unsigned int first = (uint16_t)(smpte_fec_get_snbase_low(fec) -
+                                    FIRST_SEQNUM);
+    assert(first < PACKETS);
+
+    uint8_t expected[PAYLOAD_SIZE];
+    memset(expected, 0, sizeof(expected));
+    uint16_t length_rec = 0;
+    int max_size = 0;
+    for (unsigned int i = 0; i < (row ? COLS : ROWS); i++) {
+        unsigned int n = first + i * (row ? 1 : COLS);
+        for (int j = 0; j < sizes[n]; j++)
+            expected[j] ^= payloads[n][j];
+        length_rec ^= sizes[n];
+        if (max_size < sizes[n])
+            max_size = sizes[n];
+    }
+    assert(smpte_fec_get_length_rec(fec) == length_rec);
+    assert(size == RTP_HEADER_SIZE + SMPTE_2022_FEC_HEADER_SIZE + max_size);
+    assert(!memcmp(fec + SMPTE_2022_FEC_HEADER_SIZE, expected, max_size));
+}
+
+/** helper phony pipe */
+struct fec_test {
+    int kind;
+    struct upipe upipe;
+};
+
+/** helper phony pipe */
+UPIPE_HELPER_UPIPE(fec_test, upipe, 0);
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct fec_test *fec_test = malloc(sizeof(struct fec_test));
+    assert(fec_test != NULL);
+    upipe_init(&fec_test->upipe, mgr, uprobe);
+    fec_test->kind = va_arg(args, int);
+    return &fec_test->upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    struct fec_test *fec_test = fec_test_from_upipe(upipe);
+    switch (fec_test->kind) {
+        case 0:
+            nb_media++;
+            break;
+        case 1:
+            check_fec(uref, false);
+            nb_col++;
+            break;
+        case 2:
+            check_fec(uref, true);
+            nb_row++;
+            break;
+    }
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    struct fec_test *fec_test = fec_test_from_upipe(upipe);
+    upipe_clean(upipe);
+    free(fec_test);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr fec_test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** builds a RTP packet, with the header in a separate segment like
+ * upipe_rtp_prepend */
+static struct uref *build_packet(struct uref_mgr *uref_mgr,
+                                 struct ubuf_mgr *ubuf_mgr, unsigned int n)
+{
+    struct ubuf *header = ubuf_block_alloc(ubuf_mgr, RTP_HEADER_SIZE);
+    assert(header != NULL);
+    int size = -1;
+    uint8_t *buf;
+    ubase_assert(ubuf_block_write(header, 0, &size, &buf));
+    rtp_set_hdr(buf);
+    rtp_set_type(buf, 33);
+    rtp_set_seqnum(buf, FIRST_SEQNUM + n);
+    rtp_set_timestamp(buf, n * 1000);
+    ubuf_block_unmap(header, 0);
+
+    sizes[n] = n % 7 == 3 ? 3 * TS_SIZE : PAYLOAD_SIZE;
+    for (int i = 0; i < sizes[n]; i++)
+        payloads[n][i] = rand();
+    struct ubuf *payload = ubuf_block_alloc(ubuf_mgr, sizes[n]);
+    assert(payload != NULL);
+    ubase_assert(ubuf_block_write(payload, 0, &size, &buf));
+    memcpy(buf, payloads[n], sizes[n]);
+    ubuf_block_unmap(payload, 0);
+
+    if (n % 2) {
+        ubase_assert(ubuf_block_append(header, payload));
+    } else {
+        /* contiguous packet */
+        size_t total = RTP_HEADER_SIZE + sizes[n];
+        struct ubuf *ubuf = ubuf_block_alloc(ubuf_mgr, total);
+        assert(ubuf != NULL);
+        size = -1;
+        ubase_assert(ubuf_block_write(ubuf, 0, &size, &buf));
+        ubase_assert(ubuf_block_extract(header, 0, RTP_HEADER_SIZE, buf));
+        ubase_assert(ubuf_block_extract(payload, 0, sizes[n],
+                                        buf + RTP_HEADER_SIZE));
+        ubuf_block_unmap(ubuf, 0);
+        ubuf_free(header);
+        ubuf_free(payload);
+        header = ubuf;
+    }
+
+    struct uref *uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    uref_attach_ubuf(uref, header);
+    return uref;
+}
+
+int main(int argc, char **argv)
+{
+    printf("Compiled %s %s - %s\n", __DATE__, __TIME__, __FILE__);
+
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                   udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 0, 0, 0, 0);
+    assert(ubuf_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+
+    struct upipe_mgr *upipe_rtp_fec_enc_mgr = upipe_rtp_fec_enc_mgr_alloc();
+    assert(upipe_rtp_fec_enc_mgr != NULL);
+    struct upipe *fec_enc = upipe_rtp_fec_enc_alloc(upipe_rtp_fec_enc_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "fec enc"),
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "fec col"),
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "fec row"));
+    assert(fec_enc != NULL);
+
+    unsigned int cols, rows;
+    ubase_nassert(upipe_rtp_fec_enc_set_matrix(fec_enc, 20, 20));
+    ubase_nassert(upipe_rtp_fec_enc_set_matrix(fec_enc, 4, 2));
+    ubase_assert(upipe_rtp_fec_enc_set_matrix(fec_enc, COLS, ROWS));
+    ubase_assert(upipe_rtp_fec_enc_get_matrix(fec_enc, &cols, &rows));
+    assert(cols == COLS && rows == ROWS);
+
+    struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr, "rtp.");
+    assert(flow_def != NULL);
+    ubase_assert(upipe_set_flow_def(fec_enc, flow_def));
+    uref_free(flow_def);
+
+    struct upipe *col, *row;
+    ubase_assert(upipe_rtp_fec_enc_get_col_sub(fec_enc, &col));
+    ubase_assert(upipe_rtp_fec_enc_get_row_sub(fec_enc, &row));
+
+    struct upipe *sinks[3];
+    for (int i = 0; i < 3; i++) {
+        sinks[i] = upipe_alloc(&fec_test_mgr, uprobe_use(logger), 0, i);
+        assert(sinks[i] != NULL);
+    }
+    ubase_assert(upipe_set_output(fec_enc, sinks[0]));
+    ubase_assert(upipe_set_output(col, sinks[1]));
+    ubase_assert(upipe_set_output(row, sinks[2]));
+
+    for (unsigned int n = 0; n < PACKETS; n++)
+        upipe_input(fec_enc, build_packet(uref_mgr, ubuf_mgr, n), NULL);
+    assert(nb_media == PACKETS);
+    assert(nb_col == COLS * MATRICES);
+    assert(nb_row == ROWS * MATRICES);
+
+    /* a discontinuity drops the current matrix */
+    for (unsigned int n = 0; n < 2; n++)
+        upipe_input(fec_enc, build_packet(uref_mgr, ubuf_mgr, n), NULL);
+    for (unsigned int n = 10; n < 10 + COLS; n++)
+        upipe_input(fec_enc, build_packet(uref_mgr, ubuf_mgr, n), NULL);
+    assert(nb_media == PACKETS + 2 + COLS);
+    assert(nb_col == COLS * MATRICES);
+    assert(nb_row == ROWS * MATRICES + 1);
+
+    upipe_release(fec_enc);
+    for (int i = 0; i < 3; i++)
+        test_free(sinks[i]);
+
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
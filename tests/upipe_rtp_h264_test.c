@@ -0,0 +1,391 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for rtp h264 and rtp h265 pipes
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_flow.h>
+#include <upipe/upipe.h>
+#include <upipe-modules/upipe_rtp_h264.h>
+#include <upipe-modules/upipe_rtp_h265.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH    0
+#define UREF_POOL_DEPTH     0
+#define UBUF_POOL_DEPTH     0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_VERBOSE
+
+#define MAX_PACKETS         16
+#define MAX_PACKET_SIZE     1500
+#define BIG_NALU_SIZE       3000
+
+static uint8_t packets[MAX_PACKETS][MAX_PACKET_SIZE];
+static size_t packet_sizes[MAX_PACKETS];
+static unsigned int nb_packets = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    assert(nb_packets < MAX_PACKETS);
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    assert(size <= MAX_PACKET_SIZE);
+    ubase_assert(uref_block_extract(uref, 0, size, packets[nb_packets]));
+    packet_sizes[nb_packets++] = size;
+    upipe_dbg_va(upipe, "received packet of %zu octets", size);
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+        case UPIPE_REGISTER_REQUEST:
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr rtp_h264_test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** payload octet of a NAL unit, never zero so that no start code is
+ * emulated */
+static uint8_t payload_value(size_t i)
+{
+    return i % 200 + 1;
+}
+
+/** copies a buffer into a block */
+static void write_block(struct ubuf *ubuf, const uint8_t *src, size_t size)
+{
+    uint8_t *buffer;
+    int buffer_size = -1;
+    ubase_assert(ubuf_block_write(ubuf, 0, &buffer_size, &buffer));
+    assert(buffer_size == size);
+    memcpy(buffer, src, size);
+    ubase_assert(ubuf_block_unmap(ubuf, 0));
+}
+
+/** NAL unit to put in an access unit */
+struct nalu {
+    /** NAL unit header */
+    uint8_t header[2];
+    /** size of the NAL unit header */
+    size_t header_size;
+    /** size of the payload */
+    size_t size;
+};
+
+/** sends an access unit made of two segments, with 4-byte start codes for
+ * the first and the last NAL units */
+static void send_au(struct upipe *upipe, struct uref_mgr *uref_mgr,
+                    struct ubuf_mgr *ubuf_mgr, const struct nalu *nalus,
+                    unsigned int nb)
+{
+    size_t size = 0;
+    for (unsigned int i = 0; i < nb; i++)
+        size += 4 + nalus[i].header_size + nalus[i].size;
+
+    uint8_t buffer[size];
+    uint8_t *p = buffer;
+    for (unsigned int i = 0; i < nb; i++) {
+        if (i == 0 || i == nb - 1)
+            *p++ = 0;
+        *p++ = 0;
+        *p++ = 0;
+        *p++ = 1;
+        memcpy(p, nalus[i].header, nalus[i].header_size);
+        p += nalus[i].header_size;
+        for (size_t j = 0; j < nalus[i].size; j++)
+            *p++ = payload_value(j);
+    }
+    size = p - buffer;
+
+    /* split in the middle of the second start code, if any */
+    size_t split = size / 2;
+    if (nb > 1)
+        split = 4 + nalus[0].header_size + nalus[0].size + 1;
+    struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, split);
+    assert(uref != NULL);
+    write_block(uref->ubuf, buffer, split);
+    struct ubuf *ubuf = ubuf_block_alloc(ubuf_mgr, size - split);
+    assert(ubuf != NULL);
+    write_block(ubuf, buffer + split, size - split);
+    ubase_assert(uref_block_append(uref, ubuf));
+    upipe_input(upipe, uref, NULL);
+}
+
+/** checks that a packet carries a whole NAL unit after some header */
+static void check_nalu(const uint8_t *p, const struct nalu *nalu)
+{
+    assert(!memcmp(p, nalu->header, nalu->header_size));
+    for (size_t j = 0; j < nalu->size; j++)
+        assert(p[nalu->header_size + j] == payload_value(j));
+}
+
+/** checks a packet carrying a single NAL unit */
+static void check_single(unsigned int packet, const struct nalu *nalu)
+{
+    assert(packet_sizes[packet] == nalu->header_size + nalu->size);
+    check_nalu(packets[packet], nalu);
+}
+
+/** checks an aggregation packet */
+static void check_aggregate(unsigned int packet, const uint8_t *header,
+                            size_t header_size, const struct nalu *nalus,
+                            unsigned int nb)
+{
+    const uint8_t *p = packets[packet];
+    assert(!memcmp(p, header, header_size));
+    p += header_size;
+    for (unsigned int i = 0; i < nb; i++) {
+        size_t size = nalus[i].header_size + nalus[i].size;
+        assert(((p[0] << 8) | p[1]) == size);
+        check_nalu(p + 2, &nalus[i]);
+        p += 2 + size;
+    }
+    assert(p == packets[packet] + packet_sizes[packet]);
+}
+
+/** checks fragmentation units, starting at the given packet */
+static void check_fragments(unsigned int packet, const uint8_t *header,
+                            size_t header_size, uint8_t fu_type,
+                            const struct nalu *nalu)
+{
+    size_t j = 0;
+    while (j < nalu->size) {
+        assert(packet < nb_packets);
+        const uint8_t *p = packets[packet];
+        size_t size = packet_sizes[packet] - header_size - 1;
+        assert(!memcmp(p, header, header_size));
+        uint8_t fu = fu_type;
+        if (j == 0)
+            fu |= 0x80;
+        else if (j + size == nalu->size)
+            fu |= 0x40;
+        assert(p[header_size] == fu);
+        assert(size <= 1400);
+        for (size_t k = 0; k < size; k++)
+            assert(p[header_size + 1 + k] == payload_value(j + k));
+        j += size;
+        packet++;
+    }
+    assert(j == nalu->size);
+    assert(packet == nb_packets);
+}
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 0, 0, 0, 0);
+    assert(ubuf_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+
+    struct upipe *upipe_sink = upipe_void_alloc(&rtp_h264_test_mgr,
+                                                uprobe_use(logger));
+    assert(upipe_sink != NULL);
+
+    /* H.264 */
+    struct upipe_mgr *upipe_rtp_h264_mgr = upipe_rtp_h264_mgr_alloc();
+    assert(upipe_rtp_h264_mgr != NULL);
+    struct upipe *upipe_rtp_h264 = upipe_void_alloc(upipe_rtp_h264_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "rtp h264"));
+    assert(upipe_rtp_h264 != NULL);
+    ubase_assert(upipe_set_output(upipe_rtp_h264, upipe_sink));
+
+    struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr, "h264.");
+    assert(flow_def != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_rtp_h264, flow_def));
+    uref_free(flow_def);
+
+    const struct nalu h264_nalus[] = {
+        { { 0x67 }, 1, 10 },
+        { { 0x68 }, 1, 4 },
+        { { 0x06 }, 1, 5 },
+        { { 0x65 }, 1, BIG_NALU_SIZE },
+    };
+    const uint8_t fu_a[] = { 0x7c };
+
+    bool aggregate;
+    ubase_assert(upipe_rtp_h264_get_aggregate(upipe_rtp_h264, &aggregate));
+    assert(!aggregate);
+    send_au(upipe_rtp_h264, uref_mgr, ubuf_mgr, h264_nalus, 4);
+    check_single(0, &h264_nalus[0]);
+    check_single(1, &h264_nalus[1]);
+    check_single(2, &h264_nalus[2]);
+    check_fragments(3, fu_a, sizeof (fu_a), 0x05, &h264_nalus[3]);
+    assert(nb_packets == 6);
+
+    nb_packets = 0;
+    ubase_assert(upipe_rtp_h264_set_aggregate(upipe_rtp_h264, true));
+    ubase_assert(upipe_rtp_h264_get_aggregate(upipe_rtp_h264, &aggregate));
+    assert(aggregate);
+    send_au(upipe_rtp_h264, uref_mgr, ubuf_mgr, h264_nalus, 4);
+    const uint8_t stap_a[] = { 0x78 };
+    check_aggregate(0, stap_a, sizeof (stap_a), h264_nalus, 3);
+    check_fragments(1, fu_a, sizeof (fu_a), 0x05, &h264_nalus[3]);
+    assert(nb_packets == 4);
+
+    /* a lone small NAL unit is not aggregated */
+    nb_packets = 0;
+    send_au(upipe_rtp_h264, uref_mgr, ubuf_mgr, h264_nalus + 1, 1);
+    assert(nb_packets == 1);
+    check_single(0, &h264_nalus[1]);
+
+    upipe_release(upipe_rtp_h264);
+
+    /* HEVC */
+    struct upipe_mgr *upipe_rtp_h265_mgr = upipe_rtp_h265_mgr_alloc();
+    assert(upipe_rtp_h265_mgr != NULL);
+    struct upipe *upipe_rtp_h265 = upipe_void_alloc(upipe_rtp_h265_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "rtp h265"));
+    assert(upipe_rtp_h265 != NULL);
+    ubase_assert(upipe_set_output(upipe_rtp_h265, upipe_sink));
+
+    flow_def = uref_block_flow_alloc_def(uref_mgr, "hevc.");
+    assert(flow_def != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_rtp_h265, flow_def));
+    uref_free(flow_def);
+
+    const struct nalu h265_nalus[] = {
+        { { 0x40, 0x01 }, 2, 8 },
+        { { 0x42, 0x01 }, 2, 8 },
+        { { 0x44, 0x02 }, 2, 4 },
+        { { 0x26, 0x01 }, 2, BIG_NALU_SIZE },
+    };
+    const uint8_t fu[] = { 0x62, 0x01 };
+
+    nb_packets = 0;
+    send_au(upipe_rtp_h265, uref_mgr, ubuf_mgr, h265_nalus, 4);
+    check_single(0, &h265_nalus[0]);
+    check_single(1, &h265_nalus[1]);
+    check_single(2, &h265_nalus[2]);
+    check_fragments(3, fu, sizeof (fu), 19, &h265_nalus[3]);
+    assert(nb_packets == 6);
+
+    nb_packets = 0;
+    ubase_assert(upipe_rtp_h265_set_aggregate(upipe_rtp_h265, true));
+    ubase_assert(upipe_rtp_h265_get_aggregate(upipe_rtp_h265, &aggregate));
+    assert(aggregate);
+    send_au(upipe_rtp_h265, uref_mgr, ubuf_mgr, h265_nalus, 4);
+    /* the aggregation packet has the lowest TID */
+    const uint8_t ap[] = { 0x60, 0x01 };
+    check_aggregate(0, ap, sizeof (ap), h265_nalus, 3);
+    check_fragments(1, fu, sizeof (fu), 19, &h265_nalus[3]);
+    assert(nb_packets == 4);
+
+    upipe_release(upipe_rtp_h265);
+    test_free(upipe_sink);
+
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
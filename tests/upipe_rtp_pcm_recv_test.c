@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for rtp_pcm_recv pipe
+ */
+
+#undef NDEBUG
+
+#include <upipe/uclock.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_sound.h>
+#include <upipe/uref_sound_flow.h>
+#include <upipe/upipe.h>
+#include <upipe-modules/upipe_rtp_pcm_recv.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include <bitstream/ietf/rtp.h>
+
+#define UDICT_POOL_DEPTH    0
+#define UREF_POOL_DEPTH     0
+#define UBUF_POOL_DEPTH     0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_VERBOSE
+
+#define RATE                48000
+#define CHANNELS            2
+#define FRAME_SIZE          4
+#define PACKET_SAMPLES      2
+#define TIMESTAMP_BASE      UINT32_MAX - 5
+
+static unsigned int nb_frames = 0;
+static uint64_t expected_sample = 0;
+/** samples of the next frame which were never sent */
+static uint64_t missing_from = UINT64_MAX;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+        case UPROBE_CLOCK_TS:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** value of a sample in host order */
+static int16_t sample_value(uint64_t sample, unsigned int channel)
+{
+    return sample * 16 + channel + 1;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    size_t size;
+    uint8_t sample_size;
+    ubase_assert(uref_sound_size(uref, &size, &sample_size));
+    assert(size == FRAME_SIZE);
+    assert(sample_size == 4 * CHANNELS);
+
+    uint64_t pts;
+    ubase_assert(uref_clock_get_pts_orig(uref, &pts));
+    assert(pts == ((UINT64_C(1) << 32) + TIMESTAMP_BASE + expected_sample) *
+                  UCLOCK_FREQ / RATE);
+
+    const int32_t *buffer;
+    ubase_assert(uref_sound_plane_read_int32_t(uref, "all", 0, -1, &buffer));
+    for (unsigned int i = 0; i < FRAME_SIZE; i++) {
+        uint64_t sample = expected_sample + i;
+        for (unsigned int c = 0; c < CHANNELS; c++) {
+            int32_t expected = 0;
+            if (sample < missing_from || sample >= missing_from + PACKET_SAMPLES)
+                expected = (int32_t)((uint32_t)sample_value(sample, c) << 16);
+            assert(buffer[i * CHANNELS + c] == expected);
+        }
+    }
+    uref_sound_plane_unmap(uref, "all", 0, -1);
+    upipe_dbg_va(upipe, "received frame at sample %"PRIu64, expected_sample);
+    uref_free(uref);
+    expected_sample += FRAME_SIZE;
+    nb_frames++;
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            ubase_assert(uref_flow_match_def(flow_def, "sound.s32."));
+            uint8_t channels;
+            ubase_assert(uref_sound_flow_get_channels(flow_def, &channels));
+            assert(channels == CHANNELS);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr rtp_pcm_recv_test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** sends a packet of PACKET_SAMPLES samples */
+static void send_packet(struct upipe *upipe, struct uref_mgr *uref_mgr,
+                        struct ubuf_mgr *ubuf_mgr, uint16_t seqnum,
+                        uint64_t sample)
+{
+    size_t size = RTP_HEADER_SIZE + PACKET_SAMPLES * CHANNELS * 2;
+    struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, size);
+    assert(uref != NULL);
+    uint8_t *buffer;
+    int buffer_size = -1;
+    ubase_assert(uref_block_write(uref, 0, &buffer_size, &buffer));
+    assert(buffer_size == size);
+    memset(buffer, 0, RTP_HEADER_SIZE);
+    rtp_set_hdr(buffer);
+    rtp_set_type(buffer, 96);
+    rtp_set_seqnum(buffer, seqnum);
+    rtp_set_timestamp(buffer, TIMESTAMP_BASE + sample);
+    uint8_t *payload = buffer + RTP_HEADER_SIZE;
+    for (unsigned int i = 0; i < PACKET_SAMPLES; i++)
+        for (unsigned int c = 0; c < CHANNELS; c++) {
+            uint16_t value = sample_value(sample + i, c);
+            *payload++ = value >> 8;
+            *payload++ = value & 0xff;
+        }
+    uref_block_unmap(uref, 0);
+    uref_clock_set_cr_sys(uref, UCLOCK_FREQ);
+    upipe_input(upipe, uref, NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 0, 0, 0, 0);
+    assert(ubuf_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    struct upipe *upipe_sink = upipe_void_alloc(&rtp_pcm_recv_test_mgr,
+                                                uprobe_use(logger));
+    assert(upipe_sink != NULL);
+
+    struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr,
+                                                      "s16be.sound.");
+    assert(flow_def != NULL);
+    ubase_assert(uref_sound_flow_set_rate(flow_def, RATE));
+    ubase_assert(uref_sound_flow_set_channels(flow_def, CHANNELS));
+
+    struct upipe_mgr *upipe_rtp_pcm_recv_mgr = upipe_rtp_pcm_recv_mgr_alloc();
+    assert(upipe_rtp_pcm_recv_mgr != NULL);
+    struct upipe *upipe_rtp_pcm_recv = upipe_flow_alloc(upipe_rtp_pcm_recv_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "rtp_pcm_recv"), flow_def);
+    assert(upipe_rtp_pcm_recv != NULL);
+    uref_free(flow_def);
+    ubase_assert(upipe_set_output(upipe_rtp_pcm_recv, upipe_sink));
+
+    unsigned int value;
+    ubase_assert(upipe_rtp_pcm_recv_set_frame_size(upipe_rtp_pcm_recv,
+                                                   FRAME_SIZE));
+    ubase_assert(upipe_rtp_pcm_recv_get_frame_size(upipe_rtp_pcm_recv,
+                                                   &value));
+    assert(value == FRAME_SIZE);
+    ubase_assert(upipe_rtp_pcm_recv_set_latency(upipe_rtp_pcm_recv, 1));
+    ubase_assert(upipe_rtp_pcm_recv_get_latency(upipe_rtp_pcm_recv, &value));
+    assert(value == 1);
+
+    flow_def = uref_block_flow_alloc_def(uref_mgr, NULL);
+    assert(flow_def != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_rtp_pcm_recv, flow_def));
+    uref_free(flow_def);
+
+    /* the timestamp wraps between the first and the second frames */
+    send_packet(upipe_rtp_pcm_recv, uref_mgr, ubuf_mgr, 0, 0);
+    send_packet(upipe_rtp_pcm_recv, uref_mgr, ubuf_mgr, 2, 4);
+    assert(nb_frames == 0);
+    /* reordered packet completes the first frame */
+    send_packet(upipe_rtp_pcm_recv, uref_mgr, ubuf_mgr, 1, 2);
+    assert(nb_frames == 1);
+
+    /* packet 3 at sample 6 is lost */
+    missing_from = 6;
+    send_packet(upipe_rtp_pcm_recv, uref_mgr, ubuf_mgr, 4, 8);
+    send_packet(upipe_rtp_pcm_recv, uref_mgr, ubuf_mgr, 5, 10);
+    assert(nb_frames == 1);
+    /* the jitter window moves past the incomplete frame */
+    send_packet(upipe_rtp_pcm_recv, uref_mgr, ubuf_mgr, 6, 12);
+    assert(nb_frames == 3);
+    /* a late packet is dropped */
+    send_packet(upipe_rtp_pcm_recv, uref_mgr, ubuf_mgr, 3, 6);
+    send_packet(upipe_rtp_pcm_recv, uref_mgr, ubuf_mgr, 7, 14);
+    assert(nb_frames == 4);
+
+    upipe_release(upipe_rtp_pcm_recv);
+    test_free(upipe_sink);
+
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
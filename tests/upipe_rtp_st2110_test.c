@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for ST 2110-20 RTP pack and unpack pipes
+ */
+
+#undef NDEBUG
+
+#include <upipe/uclock.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_pic_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_pic.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/upipe.h>
+#include <upipe-hbrmt/upipe_rtp_st2110_pack.h>
+#include <upipe-hbrmt/upipe_rtp_st2110_unpack.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include <bitstream/ietf/rtp.h>
+
+#define UDICT_POOL_DEPTH    0
+#define UREF_POOL_DEPTH     0
+#define UBUF_POOL_DEPTH     0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_VERBOSE
+
+/* 3 packets per line */
+#define WIDTH               1280
+#define HEIGHT              6
+#define PTS                 (UCLOCK_FREQ * 10)
+#define DURATION            (UCLOCK_FREQ / 25)
+
+static const char *chroma[3] = { "y10l", "u10l", "v10l" };
+static struct uref *packets[3 * HEIGHT];
+static unsigned int nb_packets = 0;
+static unsigned int nb_markers = 0;
+static unsigned int nb_pics = 0;
+static bool progressive;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+        case UPROBE_CLOCK_TS:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** value of a sample */
+static uint16_t sample_value(int plane, size_t x, size_t y)
+{
+    return (plane * 331 + x * 7 + y * 113) & 0x3ff;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    size_t block_size;
+    if (ubase_check(uref_block_size(uref, &block_size))) {
+        const uint8_t *buffer;
+        int size = -1;
+        ubase_assert(uref_block_read(uref, 0, &size, &buffer));
+        assert(rtp_check_hdr(buffer));
+        assert(rtp_get_seqnum(buffer) == (nb_packets & UINT16_MAX));
+        uint32_t timestamp = (uint64_t)PTS * 90000 / UCLOCK_FREQ;
+        if (!progressive && (buffer[RTP_HEADER_SIZE + 4] & 0x80))
+            timestamp += DURATION / 2 * 90000 / UCLOCK_FREQ;
+        assert(rtp_get_timestamp(buffer) == timestamp);
+        if (rtp_check_marker(buffer))
+            nb_markers++;
+        uref_block_unmap(uref, 0);
+        assert(nb_packets < 3 * HEIGHT);
+        packets[nb_packets++] = uref;
+        return;
+    }
+
+    size_t hsize, vsize;
+    ubase_assert(uref_pic_size(uref, &hsize, &vsize, NULL));
+    assert(hsize == WIDTH);
+    assert(vsize == HEIGHT);
+    uint64_t pts;
+    ubase_assert(uref_clock_get_pts_orig(uref, &pts));
+    assert(pts == (uint64_t)PTS * 90000 / UCLOCK_FREQ * UCLOCK_FREQ / 90000);
+    assert(ubase_check(uref_pic_get_progressive(uref)) == progressive);
+
+    for (int i = 0; i < 3; i++) {
+        size_t stride;
+        uint8_t hsub;
+        const uint8_t *buffer;
+        ubase_assert(uref_pic_plane_size(uref, chroma[i], &stride, &hsub,
+                                         NULL, NULL));
+        ubase_assert(uref_pic_plane_read(uref, chroma[i], 0, 0, -1, -1,
+                                         &buffer));
+        for (size_t y = 0; y < HEIGHT; y++) {
+            const uint16_t *line = (const uint16_t *)(buffer + y * stride);
+            for (size_t x = 0; x < WIDTH / hsub; x++)
+                assert(line[x] == sample_value(i, x, y));
+        }
+        uref_pic_plane_unmap(uref, chroma[i], 0, 0, -1, -1);
+    }
+    uref_free(uref);
+    nb_pics++;
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr st2110_test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** packs a picture, and unpacks the reordered packets */
+static void test_round_trip(struct uref_mgr *uref_mgr,
+                            struct ubuf_mgr *pic_mgr, struct uprobe *logger)
+{
+    struct upipe *upipe_sink = upipe_void_alloc(&st2110_test_mgr,
+                                                uprobe_use(logger));
+    assert(upipe_sink != NULL);
+
+    struct uref *flow_def = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(flow_def != NULL);
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 1, 1, 2, "y10l"));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 2, 1, 2, "u10l"));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 2, 1, 2, "v10l"));
+    ubase_assert(uref_pic_flow_set_hsize(flow_def, WIDTH));
+    ubase_assert(uref_pic_flow_set_vsize(flow_def, HEIGHT));
+    if (progressive)
+        ubase_assert(uref_pic_set_progressive(flow_def));
+
+    struct upipe_mgr *upipe_rtp_st2110_pack_mgr =
+        upipe_rtp_st2110_pack_mgr_alloc();
+    assert(upipe_rtp_st2110_pack_mgr != NULL);
+    struct upipe *upipe_pack = upipe_void_alloc(upipe_rtp_st2110_pack_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "pack"));
+    assert(upipe_pack != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_pack, flow_def));
+    ubase_assert(upipe_set_output(upipe_pack, upipe_sink));
+
+    struct upipe_mgr *upipe_rtp_st2110_unpack_mgr =
+        upipe_rtp_st2110_unpack_mgr_alloc();
+    assert(upipe_rtp_st2110_unpack_mgr != NULL);
+    struct upipe *upipe_unpack = upipe_flow_alloc(upipe_rtp_st2110_unpack_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "unpack"),
+            flow_def);
+    assert(upipe_unpack != NULL);
+    uref_free(flow_def);
+    ubase_assert(upipe_set_output(upipe_unpack, upipe_sink));
+
+    struct uref *uref = uref_pic_alloc(uref_mgr, pic_mgr, WIDTH, HEIGHT);
+    assert(uref != NULL);
+    for (int i = 0; i < 3; i++) {
+        size_t stride;
+        uint8_t hsub;
+        uint8_t *buffer;
+        ubase_assert(uref_pic_plane_size(uref, chroma[i], &stride, &hsub,
+                                         NULL, NULL));
+        ubase_assert(uref_pic_plane_write(uref, chroma[i], 0, 0, -1, -1,
+                                          &buffer));
+        for (size_t y = 0; y < HEIGHT; y++) {
+            uint16_t *line = (uint16_t *)(buffer + y * stride);
+            for (size_t x = 0; x < WIDTH / hsub; x++)
+                line[x] = sample_value(i, x, y);
+        }
+        uref_pic_plane_unmap(uref, chroma[i], 0, 0, -1, -1);
+    }
+    uref_clock_set_pts_prog(uref, PTS);
+    uref_clock_set_duration(uref, DURATION);
+    if (progressive)
+        uref_pic_set_progressive(uref);
+
+    nb_packets = nb_markers = nb_pics = 0;
+    upipe_input(upipe_pack, uref, NULL);
+    assert(nb_packets == 3 * HEIGHT);
+    assert(nb_markers == (progressive ? 1 : 2));
+
+    /* packets are reordered within each field, and the marker of the first
+     * field must not end the picture */
+    unsigned int per_field = nb_packets / (progressive ? 1 : 2);
+    for (unsigned int i = per_field; i <= nb_packets; i += per_field) {
+        struct uref *packet = packets[i - 2];
+        packets[i - 2] = packets[i - 3];
+        packets[i - 3] = packet;
+    }
+    for (unsigned int i = 0; i < nb_packets; i++) {
+        upipe_input(upipe_unpack, packets[i], NULL);
+        assert(nb_pics == (i == nb_packets - 1));
+    }
+    assert(nb_pics == 1);
+
+    upipe_release(upipe_pack);
+    upipe_release(upipe_unpack);
+    test_free(upipe_sink);
+}
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *pic_mgr = ubuf_pic_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 1, 0, 0, 0, 0, 32, 0);
+    assert(pic_mgr != NULL);
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(pic_mgr, "y10l", 1, 1, 2));
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(pic_mgr, "u10l", 2, 1, 2));
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(pic_mgr, "v10l", 2, 1, 2));
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    progressive = true;
+    test_round_trip(uref_mgr, pic_mgr, logger);
+    progressive = false;
+    test_round_trip(uref_mgr, pic_mgr, logger);
+
+    ubuf_mgr_release(pic_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
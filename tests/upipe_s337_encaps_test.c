@@ -35,6 +35,7 @@
 #include <upipe/udict.h>
 #include <upipe/udict_inline.h>
 #include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
 #include <upipe/ubuf_block_mem.h>
 #include <upipe/uref.h>
 #include <upipe/uref_block.h>
@@ -123,11 +124,10 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     assert(sample_size == 2 * 4);
 
     /* map header */
-    int size = 2;
+    int size = -1;
     const int32_t *buf;
 
-    uref_sound_read_int32_t(uref, 0, size, &buf, 1);
-    assert(size == 2);
+    ubase_assert(uref_sound_read_int32_t(uref, 0, size, &buf, 1));
 
     /* 16-bit big endian */
     uint8_t s337[S337_PREAMBLE_SIZE];
@@ -146,6 +146,15 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     assert(s337_get_error(s337) == false);
     assert(s337_get_length(s337) == PACKET_SIZE * 8);
 
+    /* payload words, split across odd-sized segments at input */
+    for (int i = 0; i < PACKET_SIZE / 2; i++) {
+        uint32_t word = (uint32_t)buf[4 + i];
+        assert(word == (((uint32_t)(2*i) << 24) |
+                        ((uint32_t)(2*i + 1) << 16)));
+    }
+    for (int i = 4 + PACKET_SIZE / 2; i < A52_FRAME_SAMPLES * 2; i++)
+        assert(buf[i] == 0);
+
     /* unmap */
     uref_sound_unmap(uref, 0, -1, 1);
 
@@ -251,8 +260,22 @@ int main(int argc, char **argv)
 
     /* Now send uref */
     for (int i=0; i < PACKETS; i++) {
-        uref = uref_block_alloc(uref_mgr, ubuf_mgr, PACKET_SIZE);
+        uref = uref_block_alloc(uref_mgr, ubuf_mgr, PACKET_SIZE / 2);
         assert(uref);
+        struct ubuf *ubuf = ubuf_block_alloc(ubuf_mgr, PACKET_SIZE / 2);
+        assert(ubuf);
+        uint8_t *w;
+        int size = -1;
+        ubase_assert(uref_block_write(uref, 0, &size, &w));
+        for (int j = 0; j < size; j++)
+            w[j] = j;
+        uref_block_unmap(uref, 0);
+        size = -1;
+        ubase_assert(ubuf_block_write(ubuf, 0, &size, &w));
+        for (int j = 0; j < size; j++)
+            w[j] = PACKET_SIZE / 2 + j;
+        ubuf_block_unmap(ubuf, 0);
+        ubase_assert(uref_block_append(uref, ubuf));
         upipe_input(s337_encaps, uref, NULL);
         assert(s337_encaps_test_from_upipe(s337_encaps_test)->entry);
     }
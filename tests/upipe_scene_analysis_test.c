@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for scene analysis pipes
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_pic.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/ubuf_pic_mem.h>
+#include <upipe/upipe.h>
+#include <upipe-filters/upipe_scene_analysis.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH        0
+#define UREF_POOL_DEPTH         0
+#define UBUF_POOL_DEPTH         0
+#define WIDTH                   128
+#define HEIGHT                  72
+#define MIN_KEYINT              2
+#define MAX_KEYINT              8
+#define NB_PICTURES             20
+#define UPROBE_LOG_LEVEL UPROBE_LOG_VERBOSE
+
+/** pattern of each sent picture */
+static const bool inverted[NB_PICTURES] = {
+    false, false, false, false, false,
+    true, true, true, true, true, true, true, true, true,
+    false, false, false, false, false, false
+};
+/** number of pictures received by the sink */
+static unsigned int count;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+        default:
+            assert(0);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** returns the luma value of the pattern */
+static uint8_t value(int x, int y, bool invert)
+{
+    uint8_t v = x + y;
+    return invert ? 255 - v : v;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    bool key = count == 0 || count == 5 || count == 13;
+    bool cut = count == 5 || count == 14;
+    assert(ubase_check(uref_scene_get_key(uref)) == key);
+    assert(ubase_check(uref_scene_get_cut(uref)) == cut);
+
+    uint64_t complexity;
+    if (count) {
+        ubase_assert(uref_scene_get_complexity(uref, &complexity));
+        assert((complexity != 0) == cut);
+    } else
+        ubase_nassert(uref_scene_get_complexity(uref, &complexity));
+    /* static pictures after a static average need no offset */
+    int64_t qp_offset;
+    ubase_nassert(uref_scene_get_qp_offset(uref, &qp_offset));
+    count++;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+    }
+    return UBASE_ERR_UNHANDLED;
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** sends a picture of the given pattern */
+static void send_pic(struct upipe *scene, struct uref_mgr *uref_mgr,
+                     struct ubuf_mgr *pic_mgr, bool invert)
+{
+    struct uref *uref = uref_pic_alloc(uref_mgr, pic_mgr, WIDTH, HEIGHT);
+    assert(uref != NULL);
+    const char *chroma = NULL;
+    while (ubase_check(uref_pic_plane_iterate(uref, &chroma)) &&
+           chroma != NULL)
+        ubase_assert(uref_pic_plane_clear(uref, chroma, 0, 0, -1, -1, 0));
+
+    uint8_t *w;
+    size_t stride;
+    ubase_assert(uref_pic_plane_write(uref, "y8", 0, 0, -1, -1, &w));
+    ubase_assert(uref_pic_plane_size(uref, "y8", &stride, NULL, NULL, NULL));
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++)
+            w[x] = value(x, y, invert);
+        w += stride;
+    }
+    ubase_assert(uref_pic_plane_unmap(uref, "y8", 0, 0, -1, -1));
+    upipe_input(scene, uref, NULL);
+}
+
+int main(int argc, char **argv)
+{
+    printf("Compiled %s %s - %s\n", __DATE__, __TIME__, __FILE__);
+
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr =
+        udict_inline_mgr_alloc(UDICT_POOL_DEPTH, umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr =
+        uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *pic_mgr = ubuf_pic_mem_mgr_alloc_fourcc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, "I420", 0, 0, 0, 0, 0, 0);
+    assert(pic_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+
+    struct upipe_mgr *upipe_scene_analysis_mgr =
+        upipe_scene_analysis_mgr_alloc();
+    assert(upipe_scene_analysis_mgr != NULL);
+
+    struct upipe *test = upipe_void_alloc(&test_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "test"));
+    assert(test != NULL);
+
+    struct upipe *scene = upipe_void_alloc(upipe_scene_analysis_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "scene"));
+    assert(scene != NULL);
+    ubase_assert(upipe_set_output(scene, test));
+
+    /* a luma plane is required */
+    struct uref *flow_def = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(flow_def != NULL);
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 1, 1, 2, "r8g8"));
+    ubase_nassert(upipe_set_flow_def(scene, flow_def));
+    uref_free(flow_def);
+
+    flow_def = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(flow_def != NULL);
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 1, 1, 1, "y8"));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 2, 2, 1, "u8"));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 2, 2, 1, "v8"));
+    ubase_assert(uref_pic_flow_set_hsize(flow_def, WIDTH));
+    ubase_assert(uref_pic_flow_set_vsize(flow_def, HEIGHT));
+    ubase_assert(upipe_set_flow_def(scene, flow_def));
+    uref_free(flow_def);
+
+    ubase_nassert(upipe_scene_analysis_set_keyint(scene, 3, 2));
+    ubase_assert(upipe_scene_analysis_set_keyint(scene, MIN_KEYINT,
+                                                 MAX_KEYINT));
+    unsigned int min, max;
+    ubase_assert(upipe_scene_analysis_get_keyint(scene, &min, &max));
+    assert(min == MIN_KEYINT && max == MAX_KEYINT);
+    ubase_nassert(upipe_scene_analysis_set_threshold(scene, 101));
+
+    /* keyframes on the first picture, on the first scene cut and after the
+     * maximum interval; the second scene cut is too close to the previous
+     * keyframe */
+    count = 0;
+    for (int i = 0; i < NB_PICTURES; i++)
+        send_pic(scene, uref_mgr, pic_mgr, inverted[i]);
+    assert(count == NB_PICTURES);
+
+    upipe_release(scene);
+    test_free(test);
+
+    upipe_mgr_release(upipe_scene_analysis_mgr); // no-op
+    ubuf_mgr_release(pic_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
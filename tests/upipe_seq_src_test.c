@@ -69,7 +69,7 @@
 #define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
 
 static void usage(const char *argv0) {
-    fprintf(stdout, "Usage: %s [-d <delay>] <source files>\n", argv0);
+    fprintf(stdout, "Usage: %s [-d <delay>] [-p <prefetch>] <source files>\n", argv0);
     exit(EXIT_FAILURE);
 }
 
@@ -92,12 +92,16 @@ unsigned source_nb = SOURCE_MAX + 1;
 int main(int argc, char *argv[])
 {
     int64_t delay = 0;
+    uint64_t prefetch = 0;
     int opt;
-    while ((opt = getopt(argc, argv, "d:ao")) != -1) {
+    while ((opt = getopt(argc, argv, "d:p:ao")) != -1) {
         switch (opt) {
             case 'd':
                 delay = atoi(optarg);
                 break;
+            case 'p':
+                prefetch = strtoull(optarg, NULL, 10);
+                break;
             default:
                 usage(argv[0]);
         }
@@ -145,6 +149,7 @@ int main(int argc, char *argv[])
                 upipe_seq_src_mgr, upipe_fsrc_mgr));
         upipe_mgr_release(upipe_fsrc_mgr);
     }
+    ubase_assert(upipe_seq_src_mgr_set_prefetch(upipe_seq_src_mgr, prefetch));
 
     struct upipe *sources[source_nb];
     for (unsigned i = 0; i < source_nb; i++) {
@@ -38,6 +38,8 @@
 #include <upipe/udict_inline.h>
 #include <upipe/uref.h>
 #include <upipe/uref_flow.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_pic.h>
 #include <upipe/uref_std.h>
 #include <upipe/upipe.h>
 #include <upipe-modules/upipe_setattr.h>
@@ -95,6 +97,11 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     uint64_t num;
     ubase_assert(uref_test_get_2(uref, &num));
     assert(num == 42);
+    ubase_assert(uref_clock_get_duration(uref, &num));
+    assert(num == 1080000);
+    ubase_assert(uref_pic_get_number(uref, &num));
+    assert(num == 7);
+    ubase_assert(uref_pic_get_key(uref));
     uref_free(uref);
     nb_packets++;
 }
@@ -164,6 +171,10 @@ int main(int argc, char *argv[])
     struct uref *dict = uref_alloc(uref_mgr);
     ubase_assert(uref_test_set_1(dict, "test"));
     ubase_assert(uref_test_set_2(dict, 42));
+    /* attributes stored in the uref structure */
+    ubase_assert(uref_clock_set_duration(dict, 1080000));
+    ubase_assert(uref_pic_set_number(dict, 7));
+    ubase_assert(uref_pic_set_key(dict));
     ubase_assert(upipe_setattr_set_dict(upipe_setattr, dict));
     uref_free(dict);
 
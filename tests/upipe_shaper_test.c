@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for shaper module
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_upump_mgr.h>
+#include <upipe/uprobe_uclock.h>
+#include <upipe/uclock.h>
+#include <upipe/uclock_std.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_std.h>
+#include <upipe/upump.h>
+#include <upipe/upipe.h>
+#include <upump-uring/upump_uring.h>
+#include <upipe-modules/upipe_shaper.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPUMP_POOL 0
+#define UPUMP_BLOCKER_POOL 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+#define TS_SIZE 188
+/** aggregate rate, in packets per second */
+#define RATE 1000
+/** rate of the limited flow, in packets per second */
+#define SUB_RATE 250
+/** burst budget, in packets */
+#define BURST 10
+#define NB_FAST 200
+#define NB_SLOW 50
+
+static struct uclock *uclock;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_FATAL:
+        case UPROBE_ERROR:
+            assert(0);
+            break;
+        default:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** phony sink */
+struct test_sink {
+    struct upipe upipe;
+    unsigned int count;
+    uint64_t last;
+};
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct test_sink *sink = malloc(sizeof(struct test_sink));
+    assert(sink != NULL);
+    upipe_init(&sink->upipe, mgr, uprobe);
+    sink->count = 0;
+    sink->last = 0;
+    return &sink->upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    struct test_sink *sink = container_of(upipe, struct test_sink, upipe);
+    uint64_t seq = 0;
+    ubase_assert(uref_attr_get_unsigned(uref, &seq, UDICT_TYPE_UNSIGNED,
+                                        "test.seq"));
+    assert(seq == sink->count);
+    sink->count++;
+    sink->last = uclock_now(uclock);
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+        case UPIPE_REGISTER_REQUEST:
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    struct test_sink *sink = container_of(upipe, struct test_sink, upipe);
+    upipe_clean(upipe);
+    free(sink);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr shaper_test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+static struct upipe *alloc_flow(struct upipe *shaper, struct uprobe *logger,
+                                struct uref *flow_def, struct upipe *sink,
+                                const char *name)
+{
+    struct upipe *flow = upipe_void_alloc_sub(shaper,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, name));
+    assert(flow != NULL);
+    ubase_assert(upipe_set_flow_def(flow, flow_def));
+    ubase_assert(upipe_set_output(flow, sink));
+    return flow;
+}
+
+static void feed(struct upipe *flow, struct uref_mgr *uref_mgr,
+                 struct ubuf_mgr *ubuf_mgr, unsigned int nb)
+{
+    for (unsigned int i = 0; i < nb; i++) {
+        struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, TS_SIZE);
+        assert(uref != NULL);
+        ubase_assert(uref_attr_set_unsigned(uref, i, UDICT_TYPE_UNSIGNED,
+                                            "test.seq"));
+        upipe_input(flow, uref, NULL);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    struct upump_mgr *upump_mgr =
+        upump_uring_mgr_alloc(UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+    uclock = uclock_std_alloc(0);
+    assert(uclock != NULL);
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                   udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 0, 0, 0, 0);
+    assert(ubuf_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_upump_mgr_alloc(logger, upump_mgr);
+    assert(logger != NULL);
+    logger = uprobe_uclock_alloc(logger, uclock);
+    assert(logger != NULL);
+
+    struct upipe_mgr *upipe_shaper_mgr = upipe_shaper_mgr_alloc();
+    assert(upipe_shaper_mgr != NULL);
+    struct upipe *shaper = upipe_void_alloc(upipe_shaper_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "shaper"));
+    assert(shaper != NULL);
+    upipe_mgr_release(upipe_shaper_mgr);
+
+    uint64_t value;
+    ubase_assert(upipe_shaper_get_tick(shaper, &value));
+    assert(value == UCLOCK_FREQ / 1000);
+    ubase_assert(upipe_shaper_set_rate(shaper, RATE * TS_SIZE));
+    ubase_assert(upipe_shaper_get_rate(shaper, &value));
+    assert(value == RATE * TS_SIZE);
+    ubase_assert(upipe_shaper_get_burst(shaper, &value));
+    assert(value == RATE * TS_SIZE / 100);
+    ubase_assert(upipe_shaper_set_burst(shaper, BURST * TS_SIZE));
+    ubase_assert(upipe_shaper_get_burst(shaper, &value));
+    assert(value == BURST * TS_SIZE);
+
+    struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr, "mpegts.");
+    assert(flow_def != NULL);
+    struct upipe *sink_fast = upipe_void_alloc(&shaper_test_mgr,
+                                               uprobe_use(logger));
+    assert(sink_fast != NULL);
+    struct upipe *sink_slow = upipe_void_alloc(&shaper_test_mgr,
+                                               uprobe_use(logger));
+    assert(sink_slow != NULL);
+    struct upipe *fast = alloc_flow(shaper, logger, flow_def, sink_fast,
+                                    "fast");
+    struct upipe *slow = alloc_flow(shaper, logger, flow_def, sink_slow,
+                                    "slow");
+    uref_free(flow_def);
+    ubase_assert(upipe_shaper_sub_set_rate(slow, SUB_RATE * TS_SIZE));
+    ubase_assert(upipe_shaper_sub_set_burst(slow, TS_SIZE));
+    ubase_assert(upipe_shaper_sub_get_rate(slow, &value));
+    assert(value == SUB_RATE * TS_SIZE);
+    ubase_assert(upipe_shaper_sub_get_rate(fast, &value));
+    assert(value == 0);
+
+    uint64_t start = uclock_now(uclock);
+    feed(fast, uref_mgr, ubuf_mgr, NB_FAST);
+    feed(slow, uref_mgr, ubuf_mgr, NB_SLOW);
+    struct test_sink *fast_sink =
+        container_of(sink_fast, struct test_sink, upipe);
+    struct test_sink *slow_sink =
+        container_of(sink_slow, struct test_sink, upipe);
+    /* only the burst budget goes through at once */
+    assert(fast_sink->count + slow_sink->count <= BURST + 1);
+
+    upump_mgr_run(upump_mgr, NULL);
+
+    assert(fast_sink->count == NB_FAST);
+    assert(slow_sink->count == NB_SLOW);
+    uint64_t end = fast_sink->last > slow_sink->last ?
+                   fast_sink->last : slow_sink->last;
+    uint64_t expected = (uint64_t)(NB_FAST + NB_SLOW - BURST) *
+                        UCLOCK_FREQ / RATE;
+    printf("shaped %u packets in %"PRIu64" ms, expected %"PRIu64" ms\n",
+           NB_FAST + NB_SLOW, (end - start) * 1000 / UCLOCK_FREQ,
+           expected * 1000 / UCLOCK_FREQ);
+    assert(end - start >= expected * 9 / 10);
+    assert(end - start <= expected * 3);
+    /* the limited flow did not go faster than its own rate */
+    assert(slow_sink->last - start >=
+           (uint64_t)(NB_SLOW - 1) * UCLOCK_FREQ / SUB_RATE * 9 / 10);
+
+    upipe_release(fast);
+    upipe_release(slow);
+    upipe_release(shaper);
+    test_free(sink_fast);
+    test_free(sink_slow);
+
+    upump_mgr_release(upump_mgr);
+    uref_mgr_release(uref_mgr);
+    ubuf_mgr_release(ubuf_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uclock_release(uclock);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    return 0;
+}
@@ -0,0 +1,458 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for shared memory umem manager and shm sink/source
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_upump_mgr.h>
+#include <upipe/uclock.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/umem_shm.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_attr.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_flow.h>
+#include <upipe/urequest.h>
+#include <upipe/upump.h>
+#include <upipe/upipe.h>
+#include <upump-uring/upump_uring.h>
+#include <upipe-modules/upipe_shm_sink.h>
+#include <upipe-modules/upipe_shm_source.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPUMP_POOL 0
+#define UPUMP_BLOCKER_POOL 0
+#define SLOT_SIZE 4096
+#define NB_SLOTS 8
+#define RING_LENGTH 4
+#define SINK_RING_LENGTH 8
+#define NB_UREFS 3
+#define UPROBE_LOG_LEVEL UPROBE_LOG_VERBOSE
+
+UREF_ATTR_UNSIGNED(test, test, "x.test", test)
+
+/** message used by the umem tests */
+struct test_msg {
+    uint32_t slot;
+    uint32_t offset;
+    uint32_t size;
+    uint8_t pad[13];
+};
+
+static char name[64];
+static unsigned int received = 0;
+static bool got_flow_def = false;
+static struct ubuf_mgr *provided_ubuf_mgr = NULL;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+        case UPROBE_LOG:
+            break;
+        case UPROBE_SOURCE_END:
+            upipe_release(upipe);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    uint64_t value, pts;
+    ubase_assert(uref_test_get_test(uref, &value));
+    assert(value == received);
+    ubase_assert(uref_clock_get_pts_prog(uref, &pts));
+    assert(pts == 1000 + value);
+
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    assert(size == 100 + 1000 * value);
+    uint8_t buffer[size];
+    ubase_assert(uref_block_extract(uref, 0, size, buffer));
+    for (size_t i = 0; i < size; i++)
+        assert(buffer[i] == (uint8_t)(i + value));
+    received++;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            const char *def;
+            ubase_assert(uref_flow_get_def(flow_def, &def));
+            assert(!strcmp(def, "block.test."));
+            got_flow_def = true;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr shm_test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** catches the ubuf manager provided by the shm sink */
+static int test_provide_ubuf_mgr(struct urequest *urequest, va_list args)
+{
+    struct ubuf_mgr *ubuf_mgr = va_arg(args, struct ubuf_mgr *);
+    struct uref *flow_format = va_arg(args, struct uref *);
+    ubuf_mgr_release(provided_ubuf_mgr);
+    provided_ubuf_mgr = ubuf_mgr;
+    uref_free(flow_format);
+    return UBASE_ERR_NONE;
+}
+
+/** fills in a block uref */
+static void test_fill(struct uref *uref, uint64_t value)
+{
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    size_t offset = 0;
+    while (offset < size) {
+        int chunk = -1;
+        uint8_t *buffer;
+        ubase_assert(uref_block_write(uref, offset, &chunk, &buffer));
+        for (int i = 0; i < chunk; i++)
+            buffer[i] = offset + i + value;
+        ubase_assert(uref_block_unmap(uref, offset));
+        offset += chunk;
+    }
+    ubase_assert(uref_test_set_test(uref, value));
+    uref_clock_set_pts_prog(uref, 1000 + value);
+}
+
+/** checks that all slots are free by allocating all of them */
+static void test_all_free(struct umem_mgr *mgr)
+{
+    struct umem umems[NB_SLOTS];
+    for (int i = 0; i < NB_SLOTS; i++) {
+        uint32_t slot, offset;
+        assert(umem_alloc(mgr, &umems[i], SLOT_SIZE));
+        ubase_assert(umem_shm_mgr_export(mgr, umem_buffer(&umems[i]),
+                                         SLOT_SIZE, &slot, &offset));
+        umem_shm_mgr_unref(mgr, slot);
+    }
+    for (int i = 0; i < NB_SLOTS; i++)
+        umem_free(&umems[i]);
+}
+
+static void test_umem(void)
+{
+    struct umem_mgr *mgr = umem_shm_mgr_alloc(name, SLOT_SIZE, NB_SLOTS,
+                                              RING_LENGTH,
+                                              sizeof(struct test_msg));
+    assert(mgr != NULL);
+    assert(umem_shm_mgr_slot_size(mgr) == SLOT_SIZE);
+    assert(umem_shm_mgr_msg_size(mgr) == sizeof(struct test_msg));
+
+    struct umem_mgr *peer = umem_shm_mgr_attach(name);
+    assert(peer != NULL);
+    assert(umem_shm_mgr_slot_size(peer) == SLOT_SIZE);
+
+    /* buffers in slots are shared with the peer */
+    struct umem umem;
+    assert(umem_alloc(mgr, &umem, 1000));
+    memset(umem_buffer(&umem), 0x42, 1000);
+    uint32_t slot, offset;
+    ubase_assert(umem_shm_mgr_export(mgr, umem_buffer(&umem) + 10, 990,
+                                     &slot, &offset));
+    assert(slot < NB_SLOTS);
+    assert(offset == 10);
+    umem_free(&umem);
+
+    struct umem imported;
+    ubase_assert(umem_shm_mgr_import(peer, &imported, slot));
+    assert(umem_size(&imported) == SLOT_SIZE);
+    assert(umem_buffer(&imported)[offset] == 0x42);
+    umem_free(&imported);
+    test_all_free(mgr);
+
+    /* too large buffers are not in the segment */
+    assert(umem_alloc(mgr, &umem, SLOT_SIZE + 1));
+    ubase_nassert(umem_shm_mgr_export(mgr, umem_buffer(&umem), 1,
+                                      &slot, &offset));
+    umem_free(&umem);
+
+    /* buffers moved out of their slot */
+    assert(umem_alloc(mgr, &umem, 100));
+    umem_buffer(&umem)[0] = 0x43;
+    assert(umem_realloc(&umem, 2 * SLOT_SIZE));
+    assert(umem_buffer(&umem)[0] == 0x43);
+    ubase_nassert(umem_shm_mgr_export(mgr, umem_buffer(&umem), 1,
+                                      &slot, &offset));
+    umem_free(&umem);
+    test_all_free(mgr);
+
+    /* ring */
+    struct test_msg msg;
+    memset(&msg, 0, sizeof(msg));
+    assert(!umem_shm_mgr_pop(peer, &msg));
+    for (uint32_t i = 0; i < RING_LENGTH; i++) {
+        msg.slot = i;
+        assert(umem_shm_mgr_push(mgr, &msg));
+    }
+    assert(!umem_shm_mgr_push(mgr, &msg));
+    for (uint32_t i = 0; i < RING_LENGTH; i++) {
+        assert(umem_shm_mgr_pop(peer, &msg));
+        assert(msg.slot == i);
+    }
+    assert(!umem_shm_mgr_pop(peer, &msg));
+
+    /* another process writes into a slot */
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (!pid) {
+        struct umem_mgr *child = umem_shm_mgr_attach(name);
+        if (child == NULL)
+            _exit(1);
+        struct umem child_umem;
+        if (!umem_alloc(child, &child_umem, 500))
+            _exit(2);
+        for (int i = 0; i < 500; i++)
+            umem_buffer(&child_umem)[i] = i;
+        struct test_msg child_msg;
+        memset(&child_msg, 0, sizeof(child_msg));
+        child_msg.size = 500;
+        if (!ubase_check(umem_shm_mgr_export(child,
+                        umem_buffer(&child_umem), 500,
+                        &child_msg.slot, &child_msg.offset)))
+            _exit(3);
+        umem_free(&child_umem);
+        if (!umem_shm_mgr_push(child, &child_msg))
+            _exit(4);
+        umem_mgr_release(child);
+        _exit(0);
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    assert(umem_shm_mgr_pop(mgr, &msg));
+    assert(msg.size == 500);
+    ubase_assert(umem_shm_mgr_import(mgr, &imported, msg.slot));
+    for (int i = 0; i < 500; i++)
+        assert(umem_buffer(&imported)[msg.offset + i] == (uint8_t)i);
+    umem_free(&imported);
+    test_all_free(mgr);
+
+    umem_mgr_release(peer);
+    umem_mgr_release(mgr);
+    assert(umem_shm_mgr_attach(name) == NULL);
+}
+
+static void test_pipes(struct uprobe *logger, struct uref_mgr *uref_mgr,
+                       struct umem_mgr *umem_mgr, struct upump_mgr *upump_mgr)
+{
+    struct upipe_mgr *upipe_shm_sink_mgr = upipe_shm_sink_mgr_alloc();
+    assert(upipe_shm_sink_mgr != NULL);
+    struct upipe *upipe_shm_sink = upipe_void_alloc(upipe_shm_sink_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "shm sink"));
+    assert(upipe_shm_sink != NULL);
+    ubase_assert(upipe_shm_sink_set_arena(upipe_shm_sink, SLOT_SIZE,
+                                          NB_SLOTS, SINK_RING_LENGTH));
+    ubase_assert(upipe_set_uri(upipe_shm_sink, name));
+    const char *uri;
+    ubase_assert(upipe_get_uri(upipe_shm_sink, &uri));
+    assert(!strcmp(uri, name));
+
+    struct uref *flow_def = uref_alloc_control(uref_mgr);
+    assert(flow_def != NULL);
+    ubase_assert(uref_flow_set_def(flow_def, "sound.s16."));
+    ubase_nassert(upipe_set_flow_def(upipe_shm_sink, flow_def));
+    ubase_assert(uref_flow_set_def(flow_def, "block.test."));
+    ubase_assert(upipe_set_flow_def(upipe_shm_sink, flow_def));
+
+    /* upstream allocates in the segment */
+    struct urequest request;
+    urequest_init_ubuf_mgr(&request, uref_dup(flow_def),
+                           test_provide_ubuf_mgr, NULL);
+    ubase_assert(upipe_register_request(upipe_shm_sink, &request));
+    ubase_assert(upipe_unregister_request(upipe_shm_sink, &request));
+    urequest_clean(&request);
+    assert(provided_ubuf_mgr != NULL);
+    uref_free(flow_def);
+
+    struct upipe_mgr *upipe_shm_src_mgr = upipe_shm_src_mgr_alloc();
+    assert(upipe_shm_src_mgr != NULL);
+    struct upipe *upipe_shm_src = upipe_void_alloc(upipe_shm_src_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "shm source"));
+    assert(upipe_shm_src != NULL);
+    uint64_t interval;
+    ubase_assert(upipe_shm_src_get_interval(upipe_shm_src, &interval));
+    assert(interval);
+    ubase_nassert(upipe_shm_src_set_interval(upipe_shm_src, 0));
+    ubase_assert(upipe_shm_src_set_interval(upipe_shm_src, UCLOCK_FREQ / 100));
+    ubase_assert(upipe_set_uri(upipe_shm_src, name));
+
+    struct upipe *upipe_sink = upipe_void_alloc(&shm_test_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "sink"));
+    assert(upipe_sink != NULL);
+    ubase_assert(upipe_set_output(upipe_shm_src, upipe_sink));
+
+    /* zero copy */
+    struct uref *uref = uref_block_alloc(uref_mgr, provided_ubuf_mgr, 100);
+    assert(uref != NULL);
+    test_fill(uref, 0);
+    upipe_input(upipe_shm_sink, uref, NULL);
+
+    /* copied, spanning several slots */
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 0, 0, 0, 0);
+    assert(ubuf_mgr != NULL);
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 1100 + 2 * SLOT_SIZE);
+    assert(uref != NULL);
+    ubase_assert(uref_block_resize(uref, 0, 1100));
+    test_fill(uref, 1);
+    upipe_input(upipe_shm_sink, uref, NULL);
+
+    /* mixed */
+    uref = uref_block_alloc(uref_mgr, provided_ubuf_mgr, 1000);
+    assert(uref != NULL);
+    struct ubuf *ubuf = ubuf_block_alloc(ubuf_mgr, 1100);
+    assert(ubuf != NULL);
+    ubase_assert(uref_block_append(uref, ubuf));
+    test_fill(uref, 2);
+    upipe_input(upipe_shm_sink, uref, NULL);
+
+    uint64_t dropped;
+    ubase_assert(upipe_shm_sink_get_dropped(upipe_shm_sink, &dropped));
+    assert(dropped == 0);
+    upipe_release(upipe_shm_sink);
+
+    upump_mgr_run(upump_mgr, NULL);
+    assert(got_flow_def);
+    assert(received == NB_UREFS);
+
+    ubuf_mgr_release(ubuf_mgr);
+    ubuf_mgr_release(provided_ubuf_mgr);
+    test_free(upipe_sink);
+    upipe_mgr_release(upipe_shm_src_mgr); // nop
+    upipe_mgr_release(upipe_shm_sink_mgr); // nop
+}
+
+int main(int argc, char *argv[])
+{
+    snprintf(name, sizeof(name), "/upipe_shm_test.%d", (int)getpid());
+    test_umem();
+
+    struct upump_mgr *upump_mgr =
+        upump_uring_mgr_alloc(UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                   udict_mgr, 0);
+    assert(uref_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_upump_mgr_alloc(logger, upump_mgr);
+    assert(logger != NULL);
+
+    test_pipes(logger, uref_mgr, umem_mgr, upump_mgr);
+
+    upump_mgr_release(upump_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    return 0;
+}
@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short unit tests for pipe instrumentation
+ */
+
+#undef NDEBUG
+
+#include <upipe/uclock.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_trace.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_dump.h>
+#include <upipe-modules/upipe_null.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH    5
+#define UREF_POOL_DEPTH     5
+#define UBUF_POOL_DEPTH     5
+#define ITERATIONS          50
+#define BLOCK_SIZE          188
+#define CLOCK_STEP          10
+#define PERIOD              100
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+
+/** fake clock advancing at each call */
+static uint64_t now = 0;
+static unsigned int nb_events = 0;
+static unsigned int nb_caps = 0;
+
+static uint64_t test_now(struct uclock *uclock)
+{
+    now += CLOCK_STEP;
+    return now;
+}
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe, int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_LOG:
+            break;
+        case UPROBE_STATS: {
+            const struct upipe_stats *stats =
+                va_arg(args, const struct upipe_stats *);
+            assert(stats->urefs);
+            nb_events++;
+            break;
+        }
+        case UPROBE_MEMORY_CAP: {
+            uint64_t held = va_arg(args, uint64_t);
+            assert(held == 2 * BLOCK_SIZE);
+            nb_caps++;
+            break;
+        }
+        default:
+            assert(0);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+int main(int argc, char **argv)
+{
+    printf("Compiled %s %s - %s\n", __DATE__, __TIME__, __FILE__);
+
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                   udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 0, 0, -1, 0);
+    assert(ubuf_mgr != NULL);
+
+    struct uclock uclock;
+    uclock.refcount = NULL;
+    uclock.uclock_now = test_now;
+    uclock.uclock_to_real = NULL;
+    uclock.uclock_from_real = NULL;
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+
+    struct upipe_mgr *upipe_null_mgr = upipe_null_mgr_alloc();
+    assert(upipe_null_mgr);
+    struct upipe *nullpipe = upipe_void_alloc(upipe_null_mgr,
+               uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "null"));
+    assert(nullpipe);
+
+    /* disabled by default */
+    struct upipe_stats stats;
+    ubase_nassert(upipe_get_stats(nullpipe, &stats));
+    upipe_input(nullpipe, uref_alloc(uref_mgr), NULL);
+
+    ubase_assert(upipe_stats_enable(nullpipe, &uclock, PERIOD));
+    ubase_assert(upipe_get_stats(nullpipe, &stats));
+    assert(stats.urefs == 0);
+
+    for (int i = 0; i < ITERATIONS; i++) {
+        struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, BLOCK_SIZE);
+        assert(uref != NULL);
+        upipe_input(nullpipe, uref, NULL);
+        upipe_input(nullpipe, uref_alloc(uref_mgr), NULL);
+    }
+
+    ubase_assert(upipe_get_stats(nullpipe, &stats));
+    assert(stats.urefs == 2 * ITERATIONS);
+    assert(stats.bytes == ITERATIONS * BLOCK_SIZE);
+    assert(stats.input_time == 2 * ITERATIONS * CLOCK_STEP);
+    assert(stats.max_input_time == CLOCK_STEP);
+    assert(stats.max_queue == 0);
+    /* each input reads the clock twice */
+    assert(nb_events == 2 * ITERATIONS * 2 * CLOCK_STEP / PERIOD);
+    /* all calls last CLOCK_STEP, between 8 and 16 ticks */
+    assert(stats.latency[3] == 2 * ITERATIONS);
+    assert(upipe_stats_latency_percentile(&stats, 99) == 16);
+    assert(stats.last > stats.start);
+
+    /* the JSON dump reports the counters */
+    FILE *file = tmpfile();
+    assert(file != NULL);
+    upipe_dump_json(file, NULL, nullpipe, NULL);
+    char buffer[4096];
+    rewind(file);
+    size_t len = fread(buffer, 1, sizeof(buffer) - 1, file);
+    buffer[len] = '\0';
+    fclose(file);
+    printf("%s", buffer);
+    assert(strstr(buffer, "\"name\": \"null\"") != NULL);
+    assert(strstr(buffer, "\"urefs\": 100,") != NULL);
+    assert(strstr(buffer, "\"bytes\": 9400,") != NULL);
+    assert(strstr(buffer, "\"held_bytes\": 0,") != NULL);
+
+    upipe_stats_disable(nullpipe);
+    ubase_nassert(upipe_get_stats(nullpipe, &stats));
+
+    /* counters are released with the pipe */
+    ubase_assert(upipe_stats_enable(nullpipe, NULL, 0));
+    upipe_input(nullpipe, uref_alloc(uref_mgr), NULL);
+    ubase_assert(upipe_get_stats(nullpipe, &stats));
+    assert(stats.urefs == 1);
+    assert(stats.input_time == 0);
+    /* tracing requires a uclock */
+    ubase_nassert(upipe_stats_set_trace(nullpipe, 4));
+
+    /* one uref out of four is stamped on entry */
+    ubase_assert(upipe_stats_enable(nullpipe, &uclock, 0));
+    ubase_assert(upipe_stats_set_trace(nullpipe, 4));
+    for (int i = 0; i < 8; i++)
+        upipe_input(nullpipe, uref_alloc(uref_mgr), NULL);
+    ubase_assert(upipe_get_stats(nullpipe, &stats));
+    assert(stats.traced == 2);
+    assert(stats.trace[0] == 2);
+
+    /* urefs stamped upstream are measured */
+    struct uref *uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    uref_trace_set_ingress(uref, now + CLOCK_STEP - 1000);
+    upipe_input(nullpipe, uref, NULL);
+    ubase_assert(upipe_get_stats(nullpipe, &stats));
+    assert(stats.traced == 3);
+    assert(stats.max_trace == 1000);
+    assert(stats.trace_time == 1000);
+    assert(upipe_stats_trace_bucket(1000) == 63);
+    assert(stats.trace[63] == 1);
+    assert(upipe_stats_trace_percentile(&stats, 50) == 1);
+    assert(upipe_stats_trace_percentile(&stats, 99) == 1000);
+
+    /* the bounds of the buckets match their indices */
+    for (unsigned int i = 0; i < UPIPE_STATS_TRACE_BUCKETS - 1; i++) {
+        assert(upipe_stats_trace_bucket(upipe_stats_trace_bound(i) - 1) == i);
+        assert(upipe_stats_trace_bucket(upipe_stats_trace_bound(i)) == i + 1);
+    }
+    assert(upipe_stats_trace_bucket(UINT64_MAX) ==
+           UPIPE_STATS_TRACE_BUCKETS - 1);
+
+    /* merging keeps the earliest ingress date */
+    uint64_t ingress;
+    uref = uref_alloc(uref_mgr);
+    struct uref *from = uref_alloc(uref_mgr);
+    assert(uref != NULL && from != NULL);
+    uref_trace_merge(uref, from);
+    ubase_nassert(uref_trace_get_ingress(uref, &ingress));
+    uref_trace_set_ingress(from, 42);
+    uref_trace_merge(uref, from);
+    ubase_assert(uref_trace_get_ingress(uref, &ingress));
+    assert(ingress == 42);
+    uref_trace_set_ingress(from, 43);
+    uref_trace_merge(uref, from);
+    ubase_assert(uref_trace_get_ingress(uref, &ingress));
+    assert(ingress == 42);
+    uref_free(from);
+    uref_free(uref);
+
+    /* held buffers are accounted, and the cap triggers an event */
+    ubase_assert(upipe_stats_set_memory_cap(nullpipe, BLOCK_SIZE + 1));
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, BLOCK_SIZE);
+    from = uref_block_alloc(uref_mgr, ubuf_mgr, BLOCK_SIZE);
+    assert(uref != NULL && from != NULL);
+    upipe_stats_hold(nullpipe, uref);
+    assert(nb_caps == 0);
+    upipe_stats_hold(nullpipe, from);
+    assert(nb_caps == 1);
+    upipe_stats_unhold(nullpipe, from);
+    upipe_stats_hold(nullpipe, from);
+    assert(nb_caps == 2);
+    upipe_stats_unhold(nullpipe, from);
+    upipe_stats_unhold(nullpipe, uref);
+    ubase_assert(upipe_get_stats(nullpipe, &stats));
+    assert(stats.held_bytes == 0);
+    assert(stats.max_held_bytes == 2 * BLOCK_SIZE);
+    assert(stats.memory_cap == BLOCK_SIZE + 1);
+    uref_free(from);
+    uref_free(uref);
+    upipe_release(nullpipe);
+
+    upipe_mgr_release(upipe_null_mgr); // no-op
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
@@ -63,6 +63,7 @@
 #define FRAMES_LIMIT        100
 #define INPUT_RATE          48000
 #define OUTPUT_RATE         44100
+#define BLOCK_SIZE          4096
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
@@ -145,6 +146,14 @@ int main(int argc, char **argv)
 
     uint64_t next_pts = UCLOCK_FREQ;
     for (i=0; i < FRAMES_LIMIT; i++) {
+        if (i == FRAMES_LIMIT / 2) {
+            /* aggregate the second half into blocks */
+            unsigned int block_size;
+            ubase_assert(upipe_swr_set_block_size(swr, BLOCK_SIZE));
+            ubase_assert(upipe_swr_get_block_size(swr, &block_size));
+            assert(block_size == BLOCK_SIZE);
+        }
+
         uint8_t *buf = NULL;
         int samples = (1024+i-FRAMES_LIMIT/2);
         //int samples = 1024;
@@ -0,0 +1,369 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for sws_ladder pipes
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_pic.h>
+#include <upipe/ubuf_pic_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/uref_pic.h>
+#include <upipe/uref_std.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe-swscale/upipe_sws_ladder.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include <libswscale/swscale.h>
+
+#define UDICT_POOL_DEPTH    0
+#define UREF_POOL_DEPTH     0
+#define UBUF_POOL_DEPTH     0
+#define UBUF_PREPEND        0
+#define UBUF_APPEND         0
+#define UBUF_ALIGN          16
+#define UBUF_ALIGN_HOFFSET  0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+
+#define SRCSIZE             32
+#define NB_OUTPUTS          3
+
+/** sizes of the outputs, in allocation order */
+static const int sizes[NB_OUTPUTS] = { 8, 24, 16 };
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+        case UPROBE_SOURCE_END:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+struct sws_ladder_test {
+    struct uref *pic;
+    struct upipe upipe;
+};
+
+/** helper phony pipe */
+UPIPE_HELPER_UPIPE(sws_ladder_test, upipe, 0);
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct sws_ladder_test *sws_ladder_test =
+        malloc(sizeof(struct sws_ladder_test));
+    assert(sws_ladder_test != NULL);
+    sws_ladder_test->pic = NULL;
+    upipe_init(&sws_ladder_test->upipe, mgr, uprobe);
+    upipe_throw_ready(&sws_ladder_test->upipe);
+    return &sws_ladder_test->upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    struct sws_ladder_test *sws_ladder_test =
+        sws_ladder_test_from_upipe(upipe);
+    assert(uref != NULL);
+    assert(sws_ladder_test->pic == NULL);
+    sws_ladder_test->pic = uref;
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    struct sws_ladder_test *sws_ladder_test =
+        sws_ladder_test_from_upipe(upipe);
+    uref_free(sws_ladder_test->pic);
+    upipe_clean(upipe);
+    free(sws_ladder_test);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr sws_ladder_test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** fills a picture with some reference */
+static void fill_in(struct uref *uref, const char *chroma,
+                    uint8_t hsub, uint8_t vsub)
+{
+    size_t hsize, vsize, stride;
+    uint8_t *buffer = NULL;
+    ubase_assert(uref_pic_plane_write(uref, chroma, 0, 0, -1, -1, &buffer));
+    ubase_assert(uref_pic_plane_size(uref, chroma, &stride, NULL, NULL,
+                                     NULL));
+    ubase_assert(uref_pic_size(uref, &hsize, &vsize, NULL));
+    hsize /= hsub;
+    vsize /= vsub;
+    for (int y = 0; y < vsize; y++) {
+        for (int x = 0; x < hsize; x++)
+            buffer[x] = 1 + (y * hsize) + x;
+        buffer += stride;
+    }
+    ubase_assert(uref_pic_plane_unmap(uref, chroma, 0, 0, -1, -1));
+}
+
+/** maps the planes of a picture */
+static void map_planes(struct uref *uref, uint8_t *planes[4], int strides[4],
+                       bool write)
+{
+    static const char *chromas[3] = { "y8", "u8", "v8" };
+    for (int i = 0; i < 3; i++) {
+        size_t stride;
+        if (write)
+            ubase_assert(uref_pic_plane_write(uref, chromas[i],
+                                              0, 0, -1, -1, &planes[i]));
+        else
+            ubase_assert(uref_pic_plane_read(uref, chromas[i], 0, 0, -1, -1,
+                                             (const uint8_t **)&planes[i]));
+        ubase_assert(uref_pic_plane_size(uref, chromas[i], &stride,
+                                         NULL, NULL, NULL));
+        strides[i] = stride;
+    }
+    planes[3] = NULL;
+    strides[3] = 0;
+}
+
+/** unmaps the planes of a picture */
+static void unmap_planes(struct uref *uref)
+{
+    ubase_assert(uref_pic_plane_unmap(uref, "y8", 0, 0, -1, -1));
+    ubase_assert(uref_pic_plane_unmap(uref, "u8", 0, 0, -1, -1));
+    ubase_assert(uref_pic_plane_unmap(uref, "v8", 0, 0, -1, -1));
+}
+
+/** checks that a picture was scaled from another one */
+static void check_scaled(struct uref *src, struct uref *dst,
+                         struct ubuf_mgr *ubuf_mgr)
+{
+    size_t src_size, dst_size;
+    ubase_assert(uref_pic_size(src, &src_size, NULL, NULL));
+    ubase_assert(uref_pic_size(dst, &dst_size, NULL, NULL));
+
+    struct ubuf *ubuf = ubuf_pic_alloc(ubuf_mgr, dst_size, dst_size);
+    assert(ubuf != NULL);
+    struct uref *ref = uref_dup(dst);
+    assert(ref != NULL);
+    uref_attach_ubuf(ref, ubuf);
+
+    struct SwsContext *ctx = sws_getCachedContext(NULL,
+            src_size, src_size, AV_PIX_FMT_YUV420P,
+            dst_size, dst_size, AV_PIX_FMT_YUV420P,
+            SWS_FULL_CHR_H_INP | SWS_ACCURATE_RND | SWS_LANCZOS,
+            NULL, NULL, NULL);
+    assert(ctx != NULL);
+
+    uint8_t *src_planes[4], *ref_planes[4];
+    int src_strides[4], ref_strides[4];
+    map_planes(src, src_planes, src_strides, false);
+    map_planes(ref, ref_planes, ref_strides, true);
+    assert(sws_scale(ctx, (const uint8_t * const *)src_planes, src_strides,
+                     0, src_size, ref_planes, ref_strides) > 0);
+    sws_freeContext(ctx);
+    unmap_planes(src);
+    unmap_planes(ref);
+
+    const uint8_t *a, *b;
+    size_t a_stride, b_stride;
+    ubase_assert(uref_pic_plane_read(ref, "y8", 0, 0, -1, -1, &a));
+    ubase_assert(uref_pic_plane_read(dst, "y8", 0, 0, -1, -1, &b));
+    ubase_assert(uref_pic_plane_size(ref, "y8", &a_stride, NULL, NULL, NULL));
+    ubase_assert(uref_pic_plane_size(dst, "y8", &b_stride, NULL, NULL, NULL));
+    for (int y = 0; y < dst_size; y++)
+        assert(!memcmp(a + y * a_stride, b + y * b_stride, dst_size));
+    ubase_assert(uref_pic_plane_unmap(ref, "y8", 0, 0, -1, -1));
+    ubase_assert(uref_pic_plane_unmap(dst, "y8", 0, 0, -1, -1));
+    uref_free(ref);
+}
+
+int main(int argc, char **argv)
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr =
+        udict_inline_mgr_alloc(UDICT_POOL_DEPTH, umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr =
+        uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
+    assert(uref_mgr != NULL);
+
+    /* planar I420 */
+    struct ubuf_mgr *ubuf_mgr =
+        ubuf_pic_mem_mgr_alloc(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH, umem_mgr, 1,
+                               UBUF_PREPEND, UBUF_APPEND,
+                               UBUF_PREPEND, UBUF_APPEND,
+                               UBUF_ALIGN, UBUF_ALIGN_HOFFSET);
+    assert(ubuf_mgr != NULL);
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(ubuf_mgr, "y8", 1, 1, 1));
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(ubuf_mgr, "u8", 2, 2, 1));
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(ubuf_mgr, "v8", 2, 2, 1));
+
+    struct uref *pic_flow = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(pic_flow != NULL);
+    ubase_assert(uref_pic_flow_add_plane(pic_flow, 1, 1, 1, "y8"));
+    ubase_assert(uref_pic_flow_add_plane(pic_flow, 2, 2, 1, "u8"));
+    ubase_assert(uref_pic_flow_add_plane(pic_flow, 2, 2, 1, "v8"));
+    ubase_assert(uref_pic_flow_set_hsize(pic_flow, SRCSIZE));
+    ubase_assert(uref_pic_flow_set_vsize(pic_flow, SRCSIZE));
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    struct upipe_mgr *upipe_sws_ladder_mgr = upipe_sws_ladder_mgr_alloc();
+    assert(upipe_sws_ladder_mgr != NULL);
+    struct upipe *sws_ladder = upipe_void_alloc(upipe_sws_ladder_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "sws_ladder"));
+    assert(sws_ladder != NULL);
+    ubase_assert(upipe_set_flow_def(sws_ladder, pic_flow));
+
+    struct upipe *outputs[NB_OUTPUTS];
+    struct upipe *sinks[NB_OUTPUTS];
+    for (int i = 0; i < NB_OUTPUTS; i++) {
+        struct uref *output_flow = uref_dup(pic_flow);
+        assert(output_flow != NULL);
+        ubase_assert(uref_pic_flow_set_hsize(output_flow, sizes[i]));
+        ubase_assert(uref_pic_flow_set_vsize(output_flow, sizes[i]));
+        outputs[i] = upipe_flow_alloc_sub(sws_ladder,
+                uprobe_pfx_alloc_va(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                                    "output %d", sizes[i]),
+                output_flow);
+        assert(outputs[i] != NULL);
+        uref_free(output_flow);
+
+        sinks[i] = upipe_void_alloc(&sws_ladder_test_mgr,
+                uprobe_pfx_alloc_va(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                                    "sink %d", sizes[i]));
+        assert(sinks[i] != NULL);
+        ubase_assert(upipe_set_output(outputs[i], sinks[i]));
+    }
+    uref_free(pic_flow);
+
+    struct uref *pic = uref_pic_alloc(uref_mgr, ubuf_mgr, SRCSIZE, SRCSIZE);
+    assert(pic != NULL);
+    ubase_assert(uref_pic_set_progressive(pic));
+    fill_in(pic, "y8", 1, 1);
+    fill_in(pic, "u8", 2, 2);
+    fill_in(pic, "v8", 2, 2);
+    upipe_input(sws_ladder, uref_dup(pic), NULL);
+
+    struct uref *results[NB_OUTPUTS];
+    for (int i = 0; i < NB_OUTPUTS; i++) {
+        results[i] = sws_ladder_test_from_upipe(sinks[i])->pic;
+        assert(results[i] != NULL);
+        size_t hsize, vsize;
+        ubase_assert(uref_pic_size(results[i], &hsize, &vsize, NULL));
+        assert(hsize == sizes[i] && vsize == sizes[i]);
+    }
+
+    /* 24 is scaled from the source, 16 from 24 and 8 from 16 */
+    check_scaled(pic, results[1], ubuf_mgr);
+    check_scaled(results[1], results[2], ubuf_mgr);
+    check_scaled(results[2], results[0], ubuf_mgr);
+
+    /* 8 is now scaled from the source */
+    ubase_assert(upipe_sws_ladder_output_set_direct(outputs[0], true));
+    for (int i = 0; i < NB_OUTPUTS; i++) {
+        uref_free(sws_ladder_test_from_upipe(sinks[i])->pic);
+        sws_ladder_test_from_upipe(sinks[i])->pic = NULL;
+    }
+    upipe_input(sws_ladder, uref_dup(pic), NULL);
+    check_scaled(pic, sws_ladder_test_from_upipe(sinks[0])->pic, ubuf_mgr);
+    uref_free(pic);
+
+    for (int i = 0; i < NB_OUTPUTS; i++) {
+        upipe_release(outputs[i]);
+        test_free(sinks[i]);
+    }
+    upipe_release(sws_ladder);
+
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+
+    return 0;
+}
@@ -263,6 +263,28 @@ int main(int argc, char *argv[])
     assert(count_subpic == 0);
     count_pic = 0;
 
+    /* fast forward on key pictures only */
+    struct urational rate;
+    rate.num = 2;
+    rate.den = 1;
+    ubase_assert(upipe_trickp_set_keyframe_rate(upipe_trickp, rate));
+    rate.num = 8;
+    ubase_assert(upipe_trickp_set_rate(upipe_trickp, rate));
+
+    uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    uref_clock_set_pts_prog(uref, (uint64_t)UINT32_MAX + 3);
+    upipe_input(upipe_trickp_pic, uref, NULL);
+    assert(count_pic == 0);
+
+    uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    uref_clock_set_pts_prog(uref, (uint64_t)UINT32_MAX + 4);
+    uref_flow_set_random(uref);
+    upipe_input(upipe_trickp_pic, uref, NULL);
+    assert(count_pic == 42);
+    count_pic = 0;
+
     upipe_release(upipe_trickp);
     upipe_release(upipe_trickp_pic);
     upipe_release(upipe_trickp_sound);
@@ -262,10 +262,20 @@ int main(int argc, char *argv[])
     desc4d_set_length(desc);
     psi_set_crc(buffer);
     uref_block_unmap(uref, 0);
+    struct uref *dup = uref_dup(uref);
+    assert(dup != NULL);
     complete = true;
     upipe_input(upipe_ts_eitd, uref, NULL);
     assert(!complete);
 
+    /* repetition of the same section */
+    uint64_t unchanged;
+    complete = true;
+    upipe_input(upipe_ts_eitd, dup, NULL);
+    assert(complete);
+    ubase_assert(upipe_ts_eitd_get_unchanged(upipe_ts_eitd, &unchanged));
+    assert(unchanged == 1);
+
     upipe_release(upipe_ts_eitd);
 
     upipe_mgr_release(upipe_ts_eitd_mgr); // nop
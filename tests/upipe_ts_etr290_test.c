@@ -0,0 +1,448 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for TS ETR 290 analyser module
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uclock.h>
+#include <upipe/uref.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_std.h>
+#include <upipe/upipe.h>
+#include <upipe-ts/upipe_ts_etr290.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#include <bitstream/mpeg/ts.h>
+#include <bitstream/mpeg/psi.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+
+#define PMT_PID 0x100
+#define ES_PID 0x101
+#define MAX_PACKETS 80
+
+static struct uref_mgr *uref_mgr;
+static struct ubuf_mgr *ubuf_mgr;
+static unsigned int nb_packets = 0;
+static unsigned int nb_errors[UPIPE_TS_ETR290_INDICATORS];
+static uint8_t packets[MAX_PACKETS][TS_SIZE];
+static uint8_t pat_version = 0;
+static uint8_t pat_cc = 0;
+static uint8_t pmt_cc = 0;
+static uint8_t es_cc = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+        case UPROBE_TS_ETR290_ERROR: {
+            assert(va_arg(args, unsigned int) == UPIPE_TS_ETR290_SIGNATURE);
+            int indicator = va_arg(args, int);
+            unsigned int pid = va_arg(args, unsigned int);
+            assert(indicator >= 0 && indicator < UPIPE_TS_ETR290_INDICATORS);
+            assert(pid <= 8192);
+            nb_errors[indicator]++;
+            break;
+        }
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    assert(size == nb_packets * TS_SIZE);
+    uref_free(uref);
+    nb_packets = 0;
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** builds a packet with a payload */
+static uint8_t *build_packet(uint16_t pid, uint8_t *cc_p)
+{
+    uint8_t *packet = packets[nb_packets++];
+    assert(nb_packets <= MAX_PACKETS);
+    ts_init(packet);
+    ts_set_pid(packet, pid);
+    ts_set_cc(packet, *cc_p);
+    ts_set_payload(packet);
+    memset(packet + TS_HEADER_SIZE, 0xff, TS_SIZE - TS_HEADER_SIZE);
+    *cc_p = (*cc_p + 1) & 0xf;
+    return packet;
+}
+
+/** builds a packet carrying a PCR */
+static void build_pcr(uint64_t pcr)
+{
+    uint8_t *packet = build_packet(ES_PID, &es_cc);
+    ts_set_adaptation(packet, TS_HEADER_SIZE_PCR - TS_HEADER_SIZE - 1);
+    tsaf_set_pcr(packet, pcr / 300);
+    tsaf_set_pcrext(packet, pcr % 300);
+}
+
+/** builds a packet carrying the PAT */
+static void build_pat(bool valid_crc)
+{
+    uint8_t *packet = build_packet(0, &pat_cc);
+    ts_set_unitstart(packet);
+    packet[TS_HEADER_SIZE] = 0;
+    uint8_t *section = packet + TS_HEADER_SIZE + 1;
+    pat_init(section);
+    pat_set_length(section, PAT_PROGRAM_SIZE);
+    pat_set_tsid(section, 1);
+    psi_set_version(section, pat_version);
+    psi_set_current(section);
+    psi_set_section(section, 0);
+    psi_set_lastsection(section, 0);
+    uint8_t *program = pat_get_program(section, 0);
+    patn_init(program);
+    patn_set_program(program, 1);
+    patn_set_pid(program, PMT_PID);
+    psi_set_crc(section);
+    if (!valid_crc)
+        section[psi_get_length(section) + PSI_HEADER_SIZE - 1] ^= 0xff;
+}
+
+/** builds a packet carrying the PMT */
+static void build_pmt(void)
+{
+    uint8_t *packet = build_packet(PMT_PID, &pmt_cc);
+    ts_set_unitstart(packet);
+    packet[TS_HEADER_SIZE] = 0;
+    uint8_t *section = packet + TS_HEADER_SIZE + 1;
+    pmt_init(section);
+    pmt_set_length(section, PMT_ES_SIZE);
+    pmt_set_program(section, 1);
+    psi_set_version(section, 0);
+    psi_set_current(section);
+    pmt_set_pcrpid(section, ES_PID);
+    pmt_set_desclength(section, 0);
+    uint8_t *es = pmt_get_es(section, 0);
+    pmtn_init(es);
+    pmtn_set_streamtype(es, 0x2);
+    pmtn_set_pid(es, ES_PID);
+    pmtn_set_desclength(es, 0);
+    psi_set_crc(section);
+}
+
+/** sends the packets built so far */
+static void send_packets(struct upipe *upipe, uint64_t cr_sys)
+{
+    struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr,
+                                         nb_packets * TS_SIZE);
+    assert(uref != NULL);
+    uint8_t *buffer;
+    int size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == nb_packets * TS_SIZE);
+    memcpy(buffer, packets, size);
+    uref_block_unmap(uref, 0);
+    uref_clock_set_cr_sys(uref, cr_sys);
+    memset(nb_errors, 0, sizeof(nb_errors));
+    upipe_input(upipe, uref, NULL);
+    assert(!nb_packets);
+}
+
+/** checks that only the given indicator was raised, nb times */
+static void check_errors(int indicator, unsigned int nb)
+{
+    for (int i = 0; i < UPIPE_TS_ETR290_INDICATORS; i++) {
+        if (nb_errors[i] != (i == indicator ? nb : 0))
+            fprintf(stderr, "%s: %u\n", upipe_ts_etr290_indicator_str(i),
+                    nb_errors[i]);
+        assert(nb_errors[i] == (i == indicator ? nb : 0));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH,
+                                        umem_mgr, 0, 0, -1, 0);
+    assert(ubuf_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *uprobe_stdio = uprobe_stdio_alloc(&uprobe, stdout,
+                                                     UPROBE_LOG_LEVEL);
+    assert(uprobe_stdio != NULL);
+
+    struct uref *uref;
+    uref = uref_block_flow_alloc_def(uref_mgr, "mpegts.");
+    assert(uref != NULL);
+
+    struct upipe *upipe_sink = upipe_void_alloc(&test_mgr,
+                                                uprobe_use(uprobe_stdio));
+    assert(upipe_sink != NULL);
+
+    struct upipe_mgr *upipe_ts_etr290_mgr = upipe_ts_etr290_mgr_alloc();
+    assert(upipe_ts_etr290_mgr != NULL);
+    struct upipe *upipe_ts_etr290 = upipe_void_alloc(upipe_ts_etr290_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "ts etr290"));
+    assert(upipe_ts_etr290 != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_ts_etr290, uref));
+    ubase_assert(upipe_set_output(upipe_ts_etr290, upipe_sink));
+    uref_free(uref);
+
+    uint64_t timeout;
+    ubase_assert(upipe_ts_etr290_get_pid_timeout(upipe_ts_etr290, &timeout));
+    assert(timeout == UCLOCK_FREQ * 5);
+
+    /* PSI and many null packets, so that the vector kernel loops */
+    uint64_t now = UCLOCK_FREQ;
+    uint64_t pcr = 0;
+    build_pat(true);
+    build_pmt();
+    uint8_t null_cc = 0;
+    while (nb_packets < 69)
+        build_packet(8191, &null_cc);
+    build_pcr(pcr);
+    send_packets(upipe_ts_etr290, now);
+    check_errors(-1, 0);
+
+    struct upipe_ts_etr290_counters counters;
+    ubase_assert(upipe_ts_etr290_get_counters(upipe_ts_etr290, &counters));
+    assert(counters.packets == 70);
+
+    /* regular PCRs */
+    for (int i = 0; i < 4; i++) {
+        now += UCLOCK_FREQ / 50;
+        pcr += UCLOCK_FREQ / 50;
+        build_packet(ES_PID, &es_cc);
+        build_pcr(pcr);
+        send_packets(upipe_ts_etr290, now);
+        check_errors(-1, 0);
+    }
+
+    /* PCR with a 500 ns jitter */
+    now += UCLOCK_FREQ / 50;
+    pcr += UCLOCK_FREQ / 50 + 27 / 2 + 1;
+    build_packet(ES_PID, &es_cc);
+    build_pcr(pcr);
+    send_packets(upipe_ts_etr290, now);
+    check_errors(UPIPE_TS_ETR290_PCR_ACCURACY, 1);
+    ubase_assert(upipe_ts_etr290_get_counters(upipe_ts_etr290, &counters));
+    assert(counters.max_pcr_accuracy == 27 / 2 + 1);
+
+    /* missing packet */
+    es_cc++;
+    build_packet(ES_PID, &es_cc);
+    send_packets(upipe_ts_etr290, now);
+    check_errors(UPIPE_TS_ETR290_CC, 1);
+
+    /* a duplicate packet is allowed, not two */
+    es_cc--;
+    build_packet(ES_PID, &es_cc);
+    es_cc--;
+    build_packet(ES_PID, &es_cc);
+    send_packets(upipe_ts_etr290, now);
+    check_errors(UPIPE_TS_ETR290_CC, 1);
+
+    /* discontinuity indicator */
+    es_cc += 5;
+    uint8_t *packet = build_packet(ES_PID, &es_cc);
+    ts_set_adaptation(packet, 1);
+    tsaf_set_discontinuity(packet);
+    send_packets(upipe_ts_etr290, now);
+    check_errors(-1, 0);
+
+    /* transport error and sync byte error */
+    packet = build_packet(ES_PID, &es_cc);
+    ts_set_transporterror(packet);
+    packet = build_packet(ES_PID, &es_cc);
+    packet[0] = 0x48;
+    build_packet(ES_PID, &es_cc);
+    send_packets(upipe_ts_etr290, now);
+    assert(nb_errors[UPIPE_TS_ETR290_TRANSPORT] == 1);
+    assert(nb_errors[UPIPE_TS_ETR290_SYNC_BYTE] == 1);
+    /* the packets in error are not taken into account for continuity */
+    assert(nb_errors[UPIPE_TS_ETR290_CC] == 1);
+
+    /* late PCR */
+    now += UCLOCK_FREQ / 20;
+    pcr += UCLOCK_FREQ / 20;
+    build_pcr(pcr);
+    send_packets(upipe_ts_etr290, now);
+    assert(nb_errors[UPIPE_TS_ETR290_PCR_REPETITION] == 1);
+    assert(nb_errors[UPIPE_TS_ETR290_PCR_DISCONTINUITY] == 0);
+    assert(nb_errors[UPIPE_TS_ETR290_CC] == 0);
+
+    /* PCR jump */
+    now += UCLOCK_FREQ / 50;
+    pcr += UCLOCK_FREQ;
+    build_pcr(pcr);
+    send_packets(upipe_ts_etr290, now);
+    check_errors(UPIPE_TS_ETR290_PCR_DISCONTINUITY, 1);
+
+    /* PCR jump with discontinuity indicator */
+    now += UCLOCK_FREQ / 50;
+    pcr = 0;
+    build_pcr(pcr);
+    tsaf_set_discontinuity(packets[0]);
+    send_packets(upipe_ts_etr290, now);
+    check_errors(-1, 0);
+
+    /* corrupt PAT */
+    now += UCLOCK_FREQ / 50;
+    pcr += UCLOCK_FREQ / 50;
+    build_pat(false);
+    build_pmt();
+    build_pcr(pcr);
+    send_packets(upipe_ts_etr290, now);
+    check_errors(UPIPE_TS_ETR290_CRC, 1);
+
+    /* PAT and PMT timeouts, PMT repetition timeout */
+    now += UCLOCK_FREQ * 3 / 4;
+    build_packet(ES_PID, &es_cc);
+    send_packets(upipe_ts_etr290, now);
+    assert(nb_errors[UPIPE_TS_ETR290_PAT] == 1);
+    assert(nb_errors[UPIPE_TS_ETR290_PMT] == 1);
+    assert(nb_errors[UPIPE_TS_ETR290_PCR_REPETITION] == 1);
+    assert(nb_errors[UPIPE_TS_ETR290_CC] == 0);
+
+    /* the late PCR is only reported once */
+    now += UCLOCK_FREQ / 50;
+    pcr += UCLOCK_FREQ * 3 / 4 + UCLOCK_FREQ / 50;
+    build_pat(true);
+    build_pmt();
+    build_pcr(pcr);
+    send_packets(upipe_ts_etr290, now);
+    check_errors(UPIPE_TS_ETR290_PCR_DISCONTINUITY, 1);
+
+    /* missing elementary stream, which also carries the PCR */
+    ubase_assert(upipe_ts_etr290_set_pid_timeout(upipe_ts_etr290,
+                                                 UCLOCK_FREQ / 5));
+    build_pat(true);
+    send_packets(upipe_ts_etr290, now);
+    check_errors(-1, 0);
+    for (int i = 0; i < 2; i++) {
+        now += UCLOCK_FREQ / 5;
+        build_pat(true);
+        build_pmt();
+        send_packets(upipe_ts_etr290, now);
+        assert(nb_errors[UPIPE_TS_ETR290_PCR_REPETITION] == 1);
+        assert(nb_errors[UPIPE_TS_ETR290_PID] == i);
+    }
+
+    ubase_assert(upipe_ts_etr290_get_counters(upipe_ts_etr290, &counters));
+    assert(counters.errors[UPIPE_TS_ETR290_PID] == 1);
+    assert(counters.errors[UPIPE_TS_ETR290_CC] == 3);
+    ubase_assert(upipe_ts_etr290_reset_counters(upipe_ts_etr290));
+    ubase_assert(upipe_ts_etr290_get_counters(upipe_ts_etr290, &counters));
+    assert(counters.packets == 0);
+    assert(counters.errors[UPIPE_TS_ETR290_CC] == 0);
+
+    upipe_release(upipe_ts_etr290);
+    upipe_mgr_release(upipe_ts_etr290_mgr); // nop
+
+    test_free(upipe_sink);
+
+    uref_mgr_release(uref_mgr);
+    ubuf_mgr_release(ubuf_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(uprobe_stdio);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short benchmark for TS mux scheduling with many programs
+ *
+ * This muxes NB_PROGRAMS programs of one video and three audio elementary
+ * streams in file mode, and prints the time spent per output TS packet.
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/uclock.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/uref_sound_flow.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_std.h>
+#include <upipe/upipe.h>
+#include <upipe-ts/upipe_ts_mux.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_WARNING
+#define NB_PROGRAMS 50
+#define NB_AUDIOS 3
+#define NB_FRAMES 250
+#define FRAME_DURATION (UCLOCK_FREQ / 25)
+#define VIDEO_OCTETRATE 500000
+#define AUDIO_OCTETRATE 24000
+#define START_SYS (UINT32_MAX + UCLOCK_FREQ)
+
+static uint64_t nb_packets = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_TS_MUX_LAST_CC:
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
+            break;
+        default:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    nb_packets += size / 188;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr ts_test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** helper to send an access unit */
+static void send_au(struct upipe *input, struct uref_mgr *uref_mgr,
+                    struct ubuf_mgr *ubuf_mgr, int size, uint64_t dts,
+                    bool random)
+{
+    struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, size);
+    assert(uref != NULL);
+    uint8_t *buffer;
+    int wsize = -1;
+    ubase_assert(uref_block_write(uref, 0, &wsize, &buffer));
+    memset(buffer, 0, wsize);
+    uref_block_unmap(uref, 0);
+    uref_clock_set_dts_sys(uref, dts);
+    uref_clock_set_dts_prog(uref, dts - START_SYS);
+    uref_clock_set_dts_pts_delay(uref, 0);
+    uref_clock_set_cr_dts_delay(uref, FRAME_DURATION);
+    uref_clock_set_duration(uref, FRAME_DURATION);
+    if (random)
+        uref_flow_set_random(uref);
+    upipe_input(input, uref, NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+                                                         UBUF_POOL_DEPTH,
+                                                         umem_mgr, 0, 0, -1, 0);
+    assert(ubuf_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    struct upipe_mgr *upipe_ts_mux_mgr = upipe_ts_mux_mgr_alloc();
+    assert(upipe_ts_mux_mgr != NULL);
+    struct upipe *upipe_ts_mux = upipe_void_alloc(upipe_ts_mux_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "ts mux"));
+    assert(upipe_ts_mux != NULL);
+
+    struct uref *uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    ubase_assert(uref_flow_set_def(uref, "void."));
+    ubase_assert(upipe_set_flow_def(upipe_ts_mux, uref));
+
+    struct upipe *upipe_sink = upipe_void_alloc(&ts_test_mgr,
+                                                uprobe_use(logger));
+    assert(upipe_sink != NULL);
+    ubase_assert(upipe_set_output(upipe_ts_mux, upipe_sink));
+    ubase_assert(upipe_ts_mux_set_mode(upipe_ts_mux,
+                                       UPIPE_TS_MUX_MODE_CAPPED));
+    ubase_assert(upipe_ts_mux_set_octetrate(upipe_ts_mux,
+            NB_PROGRAMS * (VIDEO_OCTETRATE + NB_AUDIOS * AUDIO_OCTETRATE) *
+            3 / 2));
+
+    struct upipe *programs[NB_PROGRAMS];
+    struct upipe *inputs[NB_PROGRAMS][1 + NB_AUDIOS];
+    for (int i = 0; i < NB_PROGRAMS; i++) {
+        ubase_assert(uref_flow_set_id(uref, i + 1));
+        programs[i] = upipe_void_alloc_sub(upipe_ts_mux,
+                uprobe_pfx_alloc_va(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                                    "program %d", i + 1));
+        assert(programs[i] != NULL);
+        ubase_assert(upipe_set_flow_def(programs[i], uref));
+    }
+    uref_free(uref);
+
+    struct uref *flow_video = uref_block_flow_alloc_def(uref_mgr,
+                                                        "mpeg2video.pic.");
+    assert(flow_video != NULL);
+    ubase_assert(uref_block_flow_set_octetrate(flow_video, VIDEO_OCTETRATE));
+    ubase_assert(uref_block_flow_set_buffer_size(flow_video, 229376));
+    struct urational fps = { .num = 25, .den = 1 };
+    ubase_assert(uref_pic_flow_set_fps(flow_video, fps));
+
+    struct uref *flow_audio = uref_block_flow_alloc_def(uref_mgr,
+                                                        "mp2.sound.");
+    assert(flow_audio != NULL);
+    ubase_assert(uref_block_flow_set_octetrate(flow_audio, AUDIO_OCTETRATE));
+    ubase_assert(uref_sound_flow_set_rate(flow_audio, 48000));
+
+    for (int i = 0; i < NB_PROGRAMS; i++) {
+        for (int j = 0; j < 1 + NB_AUDIOS; j++) {
+            inputs[i][j] = upipe_void_alloc_sub(programs[i],
+                    uprobe_pfx_alloc_va(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                                        "input %d.%d", i + 1, j));
+            assert(inputs[i][j] != NULL);
+            ubase_assert(upipe_set_flow_def(inputs[i][j],
+                                            j ? flow_audio : flow_video));
+        }
+    }
+    uref_free(flow_video);
+    uref_free(flow_audio);
+
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (int n = 0; n < NB_FRAMES; n++) {
+        uint64_t dts = START_SYS + n * FRAME_DURATION;
+        for (int i = 0; i < NB_PROGRAMS; i++) {
+            send_au(inputs[i][0], uref_mgr, ubuf_mgr, VIDEO_OCTETRATE / 25,
+                    dts, !(n % 12));
+            for (int j = 1; j < 1 + NB_AUDIOS; j++)
+                send_au(inputs[i][j], uref_mgr, ubuf_mgr,
+                        AUDIO_OCTETRATE / 25, dts, true);
+        }
+    }
+
+    for (int i = 0; i < NB_PROGRAMS; i++) {
+        for (int j = 0; j < 1 + NB_AUDIOS; j++)
+            upipe_release(inputs[i][j]);
+        upipe_release(programs[i]);
+    }
+    upipe_release(upipe_ts_mux);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    uint64_t ns = (end.tv_sec - begin.tv_sec) * UINT64_C(1000000000) +
+                  end.tv_nsec - begin.tv_nsec;
+    printf("%d programs x %d ES: %"PRIu64" packets in %"PRIu64" ms "
+           "(%"PRIu64" ns/packet)\n", NB_PROGRAMS, 1 + NB_AUDIOS,
+           nb_packets, ns / 1000000, nb_packets ? ns / nb_packets : 0);
+
+    test_free(upipe_sink);
+    upipe_mgr_release(upipe_ts_mux_mgr);
+
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
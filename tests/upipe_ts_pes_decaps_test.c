@@ -51,6 +51,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <inttypes.h>
 #include <assert.h>
@@ -70,6 +71,8 @@ static int end = UBASE_ERR_NONE;
 static size_t payload_size = 12;
 static bool expect_lost = false;
 static bool expect_acquired = true;
+static bool headers_only = false;
+static uint64_t pes_size = 0;
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
@@ -121,10 +124,19 @@ static void test_input(struct upipe *upipe, struct uref *uref,
                           struct upump **upump_p)
 {
     assert(uref != NULL);
+    assert(dataalignment == uref_flow_get_random(uref));
+    if (headers_only) {
+        uint64_t size;
+        assert(uref->ubuf == NULL);
+        ubase_assert(uref_ts_pesd_get_pes_size(uref, &size));
+        assert(size == pes_size);
+        uref_free(uref);
+        nb_packets--;
+        return;
+    }
     size_t size;
     ubase_assert(uref_block_size(uref, &size));
     assert(size == payload_size);
-    assert(dataalignment == uref_flow_get_random(uref));
     assert(end == uref_block_get_end(uref));
     uref_free(uref);
     nb_packets--;
@@ -350,6 +362,77 @@ int main(int argc, char *argv[])
     assert(!nb_packets);
     assert(!expect_lost);
 
+    bool headers_only_get;
+    ubase_assert(upipe_ts_pesd_get_headers_only(upipe_ts_pesd,
+                                                &headers_only_get));
+    assert(!headers_only_get);
+    ubase_assert(upipe_ts_pesd_set_headers_only(upipe_ts_pesd, true));
+    ubase_assert(upipe_ts_pesd_get_headers_only(upipe_ts_pesd,
+                                                &headers_only_get));
+    assert(headers_only_get);
+    headers_only = true;
+
+    dts = pts = 0x112121212;
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, PES_HEADER_SIZE_PTS + 12);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == PES_HEADER_SIZE_PTS + 12);
+    pes_init(buffer);
+    pes_set_streamid(buffer, PES_STREAM_ID_VIDEO_MPEG);
+    pes_set_length(buffer, PES_HEADER_SIZE_PTS + 42 - PES_HEADER_SIZE);
+    pes_set_headerlength(buffer, PES_HEADER_SIZE_PTS - PES_HEADER_SIZE_NOPTS);
+    pes_set_dataalignment(buffer);
+    pes_set_pts(buffer, pts);
+    uref_block_unmap(uref, 0);
+    uref_block_set_start(uref);
+    dataalignment = UBASE_ERR_NONE;
+    pes_size = PES_HEADER_SIZE_PTS + 42;
+    nb_packets++;
+    upipe_input(upipe_ts_pesd, uref, NULL);
+    assert(!nb_packets);
+    assert(!pts);
+
+    /* the rest of the payload is dropped */
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 30);
+    assert(uref != NULL);
+    upipe_input(upipe_ts_pesd, uref, NULL);
+
+    /* a PES header spanning several TS payloads is accumulated */
+    dts = pts = 0x112121212;
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, PES_HEADER_SIZE_NOPTS + 150);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == PES_HEADER_SIZE_NOPTS + 150);
+    memset(buffer, 0xff, size);
+    pes_init(buffer);
+    pes_set_streamid(buffer, PES_STREAM_ID_VIDEO_MPEG);
+    pes_set_length(buffer, PES_HEADER_SIZE_NOPTS + 200 + 42 - PES_HEADER_SIZE);
+    pes_set_headerlength(buffer, 200);
+    pes_set_dataalignment(buffer);
+    pes_set_pts(buffer, pts);
+    uref_block_unmap(uref, 0);
+    uref_block_set_start(uref);
+    pes_size = PES_HEADER_SIZE_NOPTS + 200 + 42;
+    nb_packets++;
+    upipe_input(upipe_ts_pesd, uref, NULL);
+    assert(nb_packets == 1);
+
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 100);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    memset(buffer, 0xff, size);
+    uref_block_unmap(uref, 0);
+    upipe_input(upipe_ts_pesd, uref, NULL);
+    assert(!nb_packets);
+    assert(!pts);
+
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 92);
+    assert(uref != NULL);
+    upipe_input(upipe_ts_pesd, uref, NULL);
+
     upipe_release(upipe_ts_pesd);
     upipe_mgr_release(upipe_ts_pesd_mgr); // nop
 
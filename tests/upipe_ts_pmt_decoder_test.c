@@ -411,12 +411,25 @@ int main(int argc, char *argv[])
     desc_size_sum = 0;
     systime = 6 * UINT32_MAX;
     uref_clock_set_cr_sys(uref, systime);
+    struct uref *dup = uref_dup(uref);
+    assert(dup != NULL);
     upipe_input(upipe_ts_pmtd, uref, NULL);
     assert(pcrpid == 143);
     assert(!pid_sum);
     assert(!desc_size_sum);
     assert(!systime);
 
+    /* repetition of the same PMT */
+    uint64_t unchanged;
+    ubase_assert(upipe_ts_pmtd_get_unchanged(upipe_ts_pmtd, &unchanged));
+    assert(unchanged == 0);
+    systime = 6 * UINT32_MAX;
+    upipe_input(upipe_ts_pmtd, dup, NULL);
+    assert(pcrpid == 143);
+    assert(!systime);
+    ubase_assert(upipe_ts_pmtd_get_unchanged(upipe_ts_pmtd, &unchanged));
+    assert(unchanged == 1);
+
     upipe_release(upipe_ts_pmtd);
     assert(!pid_sum);
     assert(!desc_size_sum);
@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for TS remux module
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_std.h>
+#include <upipe/upipe.h>
+#include <upipe-ts/upipe_ts_remux.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#include <bitstream/mpeg/ts.h>
+#include <bitstream/mpeg/psi.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+
+static unsigned int nb_packets = 0;
+static uint16_t received_pids[4];
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    size_t total;
+    ubase_assert(uref_block_size(uref, &total));
+    assert(total % TS_SIZE == 0);
+    for (size_t offset = 0; offset < total; offset += TS_SIZE) {
+        uint8_t *buffer;
+        int size = TS_SIZE;
+        ubase_assert(uref_block_write(uref, offset, &size, &buffer));
+        assert(size == TS_SIZE);
+        assert(ts_validate(buffer));
+        uint16_t pid = ts_get_pid(buffer);
+        assert(nb_packets < 4);
+        received_pids[nb_packets++] = pid;
+
+        if (ts_get_unitstart(buffer)) {
+            uint8_t *section = buffer + TS_HEADER_SIZE + 1;
+            assert(psi_check_crc(section));
+            if (pid == 0) {
+                assert(patn_get_pid(pat_get_program(section, 0)) == 0x200);
+            } else {
+                assert(pid == 0x200);
+                assert(pmt_get_pcrpid(section) == 0x201);
+                assert(pmtn_get_pid(pmt_get_es(section, 0)) == 0x201);
+                /* the removed PID is no longer announced */
+                assert(pmt_get_es(section, 1) == NULL);
+            }
+        }
+        uref_block_unmap(uref, offset);
+    }
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** fills a packet with a PAT, a PMT or a payload */
+static void fill_packet(uint8_t *buffer, uint16_t pid)
+{
+    ts_pad(buffer);
+    ts_set_pid(buffer, pid);
+    if (pid == 0) {
+        ts_set_unitstart(buffer);
+        buffer[TS_HEADER_SIZE] = 0;
+        uint8_t *section = buffer + TS_HEADER_SIZE + 1;
+        pat_init(section);
+        pat_set_length(section, PAT_PROGRAM_SIZE);
+        pat_set_tsid(section, 1);
+        psi_set_version(section, 0);
+        psi_set_current(section);
+        psi_set_section(section, 0);
+        psi_set_lastsection(section, 0);
+        uint8_t *program = pat_get_program(section, 0);
+        patn_init(program);
+        patn_set_program(program, 1);
+        patn_set_pid(program, 0x100);
+        psi_set_crc(section);
+    } else if (pid == 0x100) {
+        ts_set_unitstart(buffer);
+        buffer[TS_HEADER_SIZE] = 0;
+        uint8_t *section = buffer + TS_HEADER_SIZE + 1;
+        pmt_init(section);
+        pmt_set_length(section, 2 * PMT_ES_SIZE);
+        pmt_set_program(section, 1);
+        psi_set_version(section, 0);
+        psi_set_current(section);
+        pmt_set_pcrpid(section, 0x101);
+        pmt_set_desclength(section, 0);
+        uint8_t *es = pmt_get_es(section, 0);
+        pmtn_init(es);
+        pmtn_set_pid(es, 0x101);
+        pmtn_set_streamtype(es, PMT_STREAMTYPE_VIDEO_MPEG2);
+        pmtn_set_desclength(es, 0);
+        es = pmt_get_es(section, 1);
+        pmtn_init(es);
+        pmtn_set_pid(es, 0x102);
+        pmtn_set_streamtype(es, PMT_STREAMTYPE_AUDIO_MPEG2);
+        pmtn_set_desclength(es, 0);
+        psi_set_crc(section);
+    }
+}
+
+/** sends a block of packets */
+static void send_packets(struct upipe *upipe, struct uref_mgr *uref_mgr,
+                         struct ubuf_mgr *ubuf_mgr, const uint16_t *pids,
+                         unsigned int nb)
+{
+    struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, nb * TS_SIZE);
+    assert(uref != NULL);
+    uint8_t *buffer;
+    int size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == nb * TS_SIZE);
+    for (unsigned int i = 0; i < nb; i++)
+        fill_packet(buffer + i * TS_SIZE, pids[i]);
+    uref_block_unmap(uref, 0);
+    upipe_input(upipe, uref, NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+                                                         UBUF_POOL_DEPTH,
+                                                         umem_mgr, 0, 0, -1, 0);
+    assert(ubuf_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *uprobe_stdio = uprobe_stdio_alloc(&uprobe, stdout,
+                                                     UPROBE_LOG_LEVEL);
+    assert(uprobe_stdio != NULL);
+
+    struct upipe *sink = upipe_void_alloc(&test_mgr, uprobe_use(uprobe_stdio));
+    assert(sink != NULL);
+
+    struct upipe_mgr *upipe_ts_remux_mgr = upipe_ts_remux_mgr_alloc();
+    assert(upipe_ts_remux_mgr != NULL);
+
+    /* single packets */
+    struct uref *uref;
+    uref = uref_block_flow_alloc_def(uref_mgr, "mpegts.");
+    assert(uref != NULL);
+    struct upipe *upipe_ts_remux = upipe_void_alloc(upipe_ts_remux_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "ts remux"));
+    assert(upipe_ts_remux != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_ts_remux, uref));
+    uref_free(uref);
+    ubase_assert(upipe_set_output(upipe_ts_remux, sink));
+
+    ubase_assert(upipe_ts_remux_set_pid(upipe_ts_remux, 0x100, 0x200));
+    ubase_assert(upipe_ts_remux_set_pid(upipe_ts_remux, 0x101, 0x201));
+    ubase_assert(upipe_ts_remux_set_pid(upipe_ts_remux, 0x102, 0x1fff));
+    ubase_nassert(upipe_ts_remux_set_pid(upipe_ts_remux, 0x102, 8192));
+
+    static const uint16_t pids[] = { 0, 0x100, 0x101, 0x102 };
+    for (unsigned int i = 0; i < 4; i++)
+        send_packets(upipe_ts_remux, uref_mgr, ubuf_mgr, pids + i, 1);
+    /* the packet of the removed PID is dropped */
+    assert(nb_packets == 3);
+    assert(received_pids[0] == 0);
+    assert(received_pids[1] == 0x200);
+    assert(received_pids[2] == 0x201);
+    upipe_release(upipe_ts_remux);
+
+    /* bursts */
+    nb_packets = 0;
+    uref = uref_block_flow_alloc_def(uref_mgr, "mpegtsburst.");
+    assert(uref != NULL);
+    upipe_ts_remux = upipe_void_alloc(upipe_ts_remux_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "ts remux burst"));
+    assert(upipe_ts_remux != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_ts_remux, uref));
+    uref_free(uref);
+    ubase_assert(upipe_set_output(upipe_ts_remux, sink));
+
+    ubase_assert(upipe_ts_remux_set_pid(upipe_ts_remux, 0x100, 0x200));
+    ubase_assert(upipe_ts_remux_set_pid(upipe_ts_remux, 0x101, 0x201));
+    ubase_assert(upipe_ts_remux_set_pid(upipe_ts_remux, 0x102, 0x1fff));
+    ubase_assert(upipe_ts_remux_set_pid(upipe_ts_remux, 0x103, 0x103));
+    ubase_assert(upipe_ts_remux_del_pid(upipe_ts_remux, 0x103));
+
+    send_packets(upipe_ts_remux, uref_mgr, ubuf_mgr, pids, 4);
+    /* the packet of the removed PID is replaced by a null packet */
+    assert(nb_packets == 4);
+    assert(received_pids[0] == 0);
+    assert(received_pids[1] == 0x200);
+    assert(received_pids[2] == 0x201);
+    assert(received_pids[3] == 0x1fff);
+
+    upipe_release(upipe_ts_remux);
+    upipe_mgr_release(upipe_ts_remux_mgr); // nop
+
+    test_free(sink);
+
+    uref_mgr_release(uref_mgr);
+    ubuf_mgr_release(ubuf_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(uprobe_stdio);
+
+    return 0;
+}
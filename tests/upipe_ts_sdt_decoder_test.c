@@ -316,6 +316,8 @@ int main(int argc, char *argv[])
     desc48_set_length(desc);
     psi_set_crc(buffer);
     uref_block_unmap(uref, 0);
+    struct uref *dup = uref_dup(uref);
+    assert(dup != NULL);
     upipe_input(upipe_ts_sdtd, uref, NULL);
     assert(sid_sum == 13 + 14);
     assert(eitschedule_sum == 1);
@@ -325,6 +327,14 @@ int main(int argc, char *argv[])
     assert(provider_sum == string_to_sum("meuh") + string_to_sum("coin"));
     assert(service_sum == string_to_sum("coin") + string_to_sum("meuh"));
 
+    /* repetition of the same SDT */
+    sid_sum = 0;
+    uint64_t unchanged;
+    upipe_input(upipe_ts_sdtd, dup, NULL);
+    assert(sid_sum == 0);
+    ubase_assert(upipe_ts_sdtd_get_unchanged(upipe_ts_sdtd, &unchanged));
+    assert(unchanged == 1);
+
     upipe_release(upipe_ts_sdtd);
 
     upipe_mgr_release(upipe_ts_sdtd_mgr); // nop
@@ -44,8 +44,10 @@
 #include <upipe/uref_block_flow.h>
 #include <upipe/uref_block.h>
 #include <upipe/uref_std.h>
+#include <upipe/uref_clock.h>
 #include <upipe/upipe.h>
 #include <upipe-ts/uref_ts_flow.h>
+#include <upipe-ts/uref_ts_burst.h>
 #include <upipe-ts/upipe_ts_split.h>
 
 #include <stdbool.h>
@@ -94,6 +96,7 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
 
 struct test {
     uint16_t pid;
+    uint64_t cr_sys;
     bool got_packet;
     struct upipe upipe;
 };
@@ -110,6 +113,7 @@ static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
     upipe_init(&test->upipe, mgr, uprobe);
     test->got_packet = false;
     test->pid = pid;
+    test->cr_sys = UINT64_MAX;
     return &test->upipe;
 }
 
@@ -127,6 +131,11 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     assert(ts_validate(buffer));
     assert(ts_get_pid(buffer) == test->pid);
     uref_block_unmap(uref, 0);
+    if (test->cr_sys != UINT64_MAX) {
+        uint64_t cr_sys;
+        ubase_assert(uref_clock_get_cr_sys(uref, &cr_sys));
+        assert(cr_sys == test->cr_sys);
+    }
     uref_free(uref);
 }
 
@@ -236,6 +245,68 @@ int main(int argc, char *argv[])
     uref_block_unmap(uref, 0);
     upipe_input(upipe_ts_split, uref, NULL);
 
+    upipe_release(upipe_ts_split_output68);
+    upipe_release(upipe_ts_split_output69);
+    upipe_release(upipe_ts_split);
+
+    test_free(upipe_sink68);
+    test_free(upipe_sink69);
+
+    /* bursts of packets, with a per-packet cr_sys index */
+    uref = uref_block_flow_alloc_def(uref_mgr, "mpegtsburst.");
+    assert(uref != NULL);
+    upipe_ts_split = upipe_void_alloc(upipe_ts_split_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "ts split burst"));
+    assert(upipe_ts_split != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_ts_split, uref));
+
+    ubase_assert(uref_ts_flow_set_pid(uref, 68));
+    upipe_sink68 = upipe_flow_alloc(&test_mgr, uprobe_use(uprobe_stdio), uref);
+    assert(upipe_sink68 != NULL);
+    upipe_ts_split_output68 = upipe_flow_alloc_sub(upipe_ts_split,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "ts split output 68"), uref);
+    assert(upipe_ts_split_output68 != NULL);
+    ubase_assert(upipe_set_output(upipe_ts_split_output68, upipe_sink68));
+
+    ubase_assert(uref_ts_flow_set_pid(uref, 69));
+    upipe_sink69 = upipe_flow_alloc(&test_mgr, uprobe_use(uprobe_stdio), uref);
+    assert(upipe_sink69 != NULL);
+    upipe_ts_split_output69 = upipe_flow_alloc_sub(upipe_ts_split,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "ts split output 69"), uref);
+    assert(upipe_ts_split_output69 != NULL);
+    ubase_assert(upipe_set_output(upipe_ts_split_output69, upipe_sink69));
+    uref_free(uref);
+
+    const uint8_t *pid_filter;
+    struct urefcount *pid_filter_owner;
+    ubase_assert(upipe_ts_split_get_pid_filter(upipe_ts_split, &pid_filter,
+                                               &pid_filter_owner));
+    assert(pid_filter_owner != NULL);
+    assert(pid_filter[68 >> 3] & (1 << (68 & 7)));
+    assert(pid_filter[69 >> 3] & (1 << (69 & 7)));
+    assert(!(pid_filter[70 >> 3] & (1 << (70 & 7))));
+
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 3 * TS_SIZE);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == 3 * TS_SIZE);
+    ts_pad(buffer);
+    ts_set_pid(buffer, 68);
+    ts_pad(buffer + TS_SIZE);
+    ts_set_pid(buffer + TS_SIZE, 70);
+    ts_pad(buffer + 2 * TS_SIZE);
+    ts_set_pid(buffer + 2 * TS_SIZE, 69);
+    uref_block_unmap(uref, 0);
+    uint64_t cr_sys[3] = { 1000, 2000, 3000 };
+    ubase_assert(uref_ts_burst_set_cr_sys(uref, cr_sys, 3));
+    container_of(upipe_sink68, struct test, upipe)->cr_sys = 1000;
+    container_of(upipe_sink69, struct test, upipe)->cr_sys = 3000;
+    upipe_input(upipe_ts_split, uref, NULL);
+
     upipe_release(upipe_ts_split_output68);
     upipe_release(upipe_ts_split_output69);
     upipe_release(upipe_ts_split);
@@ -101,16 +101,18 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     assert(uref != NULL);
     size_t size;
     ubase_assert(uref_block_size(uref, &size));
-    assert(size == TS_SIZE);
+    assert(size && !(size % TS_SIZE));
 
-    const uint8_t *buffer;
-    int rsize = 1;
-    ubase_assert(uref_block_read(uref, 0, &rsize, &buffer));
-    assert(rsize == 1);
-    assert(ts_validate(buffer));
-    uref_block_unmap(uref, 0);
+    for (size_t offset = 0; offset < size; offset += TS_SIZE) {
+        const uint8_t *buffer;
+        int rsize = 1;
+        ubase_assert(uref_block_read(uref, offset, &rsize, &buffer));
+        assert(rsize == 1);
+        assert(ts_validate(buffer));
+        uref_block_unmap(uref, offset);
+        nb_packets--;
+    }
     uref_free(uref);
-    nb_packets--;
 }
 
 /** helper phony pipe */
@@ -230,6 +232,40 @@ int main(int argc, char *argv[])
     upipe_input(upipe_ts_sync, uref, NULL);
     assert(!nb_packets);
 
+    nb_packets++;
+    upipe_release(upipe_ts_sync);
+    assert(!nb_packets);
+
+    /* output several packets per buffer */
+    uref = uref_block_flow_alloc_def(uref_mgr, NULL);
+    assert(uref != NULL);
+    upipe_ts_sync = upipe_void_alloc(upipe_ts_sync_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "ts sync batch"));
+    assert(upipe_ts_sync != NULL);
+    ubase_assert(upipe_ts_sync_set_batch(upipe_ts_sync, 4));
+    unsigned int batch;
+    ubase_assert(upipe_ts_sync_get_batch(upipe_ts_sync, &batch));
+    assert(batch == 4);
+    ubase_assert(upipe_set_flow_def(upipe_ts_sync, uref));
+    ubase_assert(upipe_set_output(upipe_ts_sync, upipe_sink));
+    uref_free(uref);
+
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 12 + 7 * TS_SIZE);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == 12 + 7 * TS_SIZE);
+    memset(buffer, 0, 12);
+    for (int i = 0; i < 7; i++)
+        ts_pad(buffer + 12 + i * TS_SIZE);
+    uref_block_unmap(uref, 0);
+    /* 4 packets, then 2 packets followed by enough sync words */
+    nb_packets += 6;
+    expect_loss = 6;
+    upipe_input(upipe_ts_sync, uref, NULL);
+    assert(!nb_packets);
+
     nb_packets++;
     upipe_release(upipe_ts_sync);
     assert(!nb_packets);
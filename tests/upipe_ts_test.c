@@ -29,6 +29,7 @@
 
 #undef NDEBUG
 
+#include <upipe/uclock.h>
 #include <upipe/uprobe.h>
 #include <upipe/uprobe_stdio.h>
 #include <upipe/uprobe_prefix.h>
@@ -273,6 +274,12 @@ static int catch_ts_demux(struct uprobe *uprobe, struct upipe *upipe,
                                             "ts mux program %"PRIu64, flow_id));
                 assert(program != NULL);
                 ubase_assert(upipe_ts_mux_set_version(program, 1));
+                unsigned int weight;
+                ubase_assert(upipe_ts_mux_get_statmux_weight(program, &weight));
+                assert(weight == 1);
+                ubase_assert(upipe_ts_mux_set_statmux_weight(program, 2));
+                ubase_assert(upipe_ts_mux_get_statmux_weight(program, &weight));
+                assert(weight == 2);
                 upipe_release(program);
             }
             return UBASE_ERR_NONE;
@@ -394,6 +401,18 @@ int main(int argc, char *argv[])
     ubase_assert(upipe_ts_mux_set_mode(upipe_ts, UPIPE_TS_MUX_MODE_CAPPED));
     ubase_assert(upipe_ts_mux_set_version(upipe_ts, 1));
     ubase_assert(upipe_ts_mux_set_cr_prog(upipe_ts, 0));
+    uint64_t statmux_period;
+    ubase_assert(upipe_ts_mux_get_statmux_period(upipe_ts, &statmux_period));
+    assert(statmux_period == 0);
+    ubase_nassert(upipe_ts_mux_set_statmux_period(upipe_ts, 1));
+    ubase_assert(upipe_ts_mux_set_statmux_period(upipe_ts, UCLOCK_FREQ));
+    ubase_assert(upipe_ts_mux_get_statmux_period(upipe_ts, &statmux_period));
+    assert(statmux_period == UCLOCK_FREQ);
+    ubase_assert(upipe_ts_mux_set_statmux_period(upipe_ts, 0));
+    uint64_t vbr_jitter;
+    ubase_assert(upipe_ts_mux_set_vbr_jitter(upipe_ts, UCLOCK_FREQ / 50));
+    ubase_assert(upipe_ts_mux_get_vbr_jitter(upipe_ts, &vbr_jitter));
+    assert(vbr_jitter == UCLOCK_FREQ / 50);
 
     /* file sink */
     struct upipe_mgr *upipe_fsink_mgr = upipe_fsink_mgr_alloc();
@@ -61,6 +61,7 @@
 
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <inttypes.h>
@@ -70,6 +71,7 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <time.h>
 
 #define UDICT_POOL_DEPTH 0
 #define UREF_POOL_DEPTH 0
@@ -102,6 +104,13 @@ struct addrinfo hints, *servinfo, *p;
 struct upipe *upipe_udpsrc;
 struct upipe *upipe_udpsink;
 static int counter = 0;
+static bool pid_filter_freed = false;
+
+/** free callback of the owner of the PID filter */
+static void pid_filter_free(struct urefcount *urefcount)
+{
+    pid_filter_freed = true;
+}
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
@@ -249,6 +258,89 @@ static void genpackets2(struct upump *upump)
     }
 }
 
+#define NB_PEERS 3
+
+/** tests a udp sink sending to several destinations */
+static void test_peers(struct upipe_mgr *upipe_udpsink_mgr,
+                       struct uprobe *logger)
+{
+    int fds[NB_PEERS];
+    struct sockaddr_in addrs[NB_PEERS];
+    for (int i = 0; i < NB_PEERS; i++) {
+        fds[i] = socket(AF_INET, SOCK_DGRAM, 0);
+        assert(fds[i] != -1);
+        memset(&addrs[i], 0, sizeof(addrs[i]));
+        addrs[i].sin_family = AF_INET;
+        addrs[i].sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addrs[i].sin_port = 0;
+        assert(bind(fds[i], (struct sockaddr *)&addrs[i],
+                    sizeof(addrs[i])) == 0);
+        socklen_t addrlen = sizeof(addrs[i]);
+        assert(getsockname(fds[i], (struct sockaddr *)&addrs[i],
+                           &addrlen) == 0);
+    }
+
+    struct upipe *upipe_udpsink = upipe_void_alloc(upipe_udpsink_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "udp sink peers"));
+    assert(upipe_udpsink != NULL);
+    struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr, "bar");
+    assert(flow_def != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_udpsink, flow_def));
+    uref_free(flow_def);
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(fd != -1);
+    ubase_assert(upipe_udpsink_set_fd(upipe_udpsink, fd));
+    for (int i = 0; i < NB_PEERS; i++)
+        ubase_assert(upipe_udpsink_add_peer(upipe_udpsink,
+                (struct sockaddr *)&addrs[i], sizeof(addrs[i])));
+    unsigned int nb_peers;
+    ubase_assert(upipe_udpsink_get_peers(upipe_udpsink, &nb_peers));
+    assert(nb_peers == NB_PEERS);
+
+    for (int round = 0; round < 2; round++) {
+        for (int j = 0; j < 4; j++) {
+            struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr,
+                                                 BUF_SIZE);
+            assert(uref != NULL);
+            uint8_t *buf;
+            int size = -1;
+            ubase_assert(uref_block_write(uref, 0, &size, &buf));
+            memset(buf, 0, size);
+            snprintf((char *)buf, BUF_SIZE, FORMAT, j);
+            uref_block_unmap(uref, 0);
+            upipe_input(upipe_udpsink, uref, NULL);
+        }
+
+        for (int i = 0; i < NB_PEERS; i++) {
+            int received = 0;
+            char buf[BUF_SIZE];
+            while (recv(fds[i], buf, sizeof(buf), MSG_DONTWAIT) == BUF_SIZE) {
+                char expected[BUF_SIZE];
+                snprintf(expected, sizeof(expected), FORMAT, received);
+                assert(!strcmp(buf, expected));
+                received++;
+            }
+            /* the first destination is removed after the first round */
+            assert(received == (round && !i ? 0 : 4));
+        }
+
+        if (round) {
+            ubase_nassert(upipe_udpsink_del_peer(upipe_udpsink,
+                    (struct sockaddr *)&addrs[0], sizeof(addrs[0])));
+            continue;
+        }
+        ubase_assert(upipe_udpsink_del_peer(upipe_udpsink,
+                (struct sockaddr *)&addrs[0], sizeof(addrs[0])));
+        ubase_assert(upipe_udpsink_get_peers(upipe_udpsink, &nb_peers));
+        assert(nb_peers == NB_PEERS - 1);
+    }
+
+    upipe_release(upipe_udpsink);
+    for (int i = 0; i < NB_PEERS; i++)
+        close(fds[i]);
+}
+
 int main(int argc, char *argv[])
 {
     char udp_uri[512], port_str[8];
@@ -351,6 +443,31 @@ int main(int argc, char *argv[])
     assert(upipe_udpsink != NULL);
     ubase_assert(upipe_set_flow_def(upipe_udpsink, flow_def));
     uref_free(flow_def);
+    ubase_assert(upipe_udpsink_set_batch(upipe_udpsink, 8, 0));
+    ubase_assert(upipe_udpsink_set_txtime(upipe_udpsink, CLOCK_MONOTONIC,
+                                          UCLOCK_FREQ / 100));
+
+    /* read the second run in batch mode */
+    unsigned int batch_size;
+    ubase_assert(upipe_udpsrc_set_batch_size(upipe_udpsrc, 8));
+    ubase_assert(upipe_udpsrc_get_batch_size(upipe_udpsrc, &batch_size));
+    assert(batch_size == 8);
+
+    /* datagrams which are not made of TS packets are not filtered */
+    static const uint8_t pid_filter[8192 / 8];
+    const uint8_t *pid_filter_p;
+    ubase_assert(upipe_udpsrc_set_pid_filter(upipe_udpsrc, pid_filter,
+                                             NULL));
+    ubase_assert(upipe_udpsrc_get_pid_filter(upipe_udpsrc, &pid_filter_p));
+    assert(pid_filter_p == pid_filter);
+
+    /* the source keeps the owner of the bitmap alive */
+    struct urefcount pid_filter_owner;
+    urefcount_init(&pid_filter_owner, pid_filter_free);
+    ubase_assert(upipe_udpsrc_set_pid_filter(upipe_udpsrc, pid_filter,
+                                             &pid_filter_owner));
+    urefcount_release(&pid_filter_owner);
+    assert(!pid_filter_freed);
 
     /* reset source uri */
     for (i=0; i < 10; i++) {
@@ -372,9 +489,12 @@ int main(int argc, char *argv[])
     /* fire again */
     upump_mgr_run(upump_mgr, NULL);
 
+    test_peers(upipe_udpsink_mgr, logger);
+
     /* release */
     upump_free(write_pump);
     upipe_release(upipe_udpsrc);
+    assert(pid_filter_freed);
     upipe_release(upipe_udpsink);
     test_free(udpsrc_test);
     upipe_mgr_release(upipe_udpsrc_mgr); /* nop */
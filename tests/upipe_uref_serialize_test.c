@@ -0,0 +1,481 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for uref serialization and the uref serializer and
+ * deserializer pipes
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_attr.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_serial.h>
+#include <upipe/upipe.h>
+#include <upipe-modules/upipe_uref_serialize.h>
+#include <upipe-modules/upipe_uref_deserialize.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH    0
+#define UREF_POOL_DEPTH     0
+#define UBUF_POOL_DEPTH     0
+#define UPROBE_LOG_LEVEL    UPROBE_LOG_VERBOSE
+#define NB_UREFS            4
+#define CHUNK_SIZE          5
+
+UREF_ATTR_UNSIGNED(test, index, "x.index", test index)
+UREF_ATTR_STRING(test, constant, "x.constant", constant attribute)
+
+static struct uref *stream = NULL;
+static unsigned int nb_frames = 0;
+static unsigned int received = 0;
+static bool got_flow_def = false;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe gathering the serialized stream */
+static void capture_input(struct upipe *upipe, struct uref *uref,
+                          struct upump **upump_p)
+{
+    nb_frames++;
+    if (stream == NULL) {
+        stream = uref;
+        return;
+    }
+    ubase_assert(uref_block_append(stream, uref_detach_ubuf(uref)));
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int capture_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            const char *def;
+            ubase_assert(uref_flow_get_def(flow_def, &def));
+            assert(!strcmp(def, "block.uref."));
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe checking the deserialized urefs */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(got_flow_def);
+    uint64_t index, pts;
+    ubase_assert(uref_test_get_index(uref, &index));
+    assert(index == received);
+    ubase_assert(uref_clock_get_pts_prog(uref, &pts));
+    assert(pts == 27000000 * index);
+    assert(uref->date_orig == UINT64_MAX);
+    assert(ubase_check(uref_block_get_start(uref)) == !index);
+
+    const char *constant;
+    if (index == NB_UREFS - 1) {
+        ubase_nassert(uref_test_get_constant(uref, &constant));
+        assert(uref->ubuf == NULL);
+    } else {
+        ubase_assert(uref_test_get_constant(uref, &constant));
+        assert(!strcmp(constant, "same"));
+        size_t size;
+        ubase_assert(uref_block_size(uref, &size));
+        assert(size == 100 * (index + 1));
+        uint8_t buffer[size];
+        ubase_assert(uref_block_extract(uref, 0, size, buffer));
+        for (size_t i = 0; i < size; i++)
+            assert(buffer[i] == (uint8_t)(i + index));
+    }
+    received++;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            const char *def;
+            ubase_assert(uref_flow_get_def(flow_def, &def));
+            assert(!strcmp(def, "block.foo."));
+            const char *constant;
+            ubase_assert(uref_test_get_constant(flow_def, &constant));
+            assert(!strcmp(constant, "flow"));
+            got_flow_def = true;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr capture_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+
+    .upipe_alloc = test_alloc,
+    .upipe_input = capture_input,
+    .upipe_control = capture_control
+};
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** checks that two urefs have the same attributes */
+static void check_same(struct uref *uref1, struct uref *uref2)
+{
+    assert(uref1->flags == uref2->flags);
+    assert(uref1->date_sys == uref2->date_sys);
+    assert(uref1->date_prog == uref2->date_prog);
+    assert(uref1->date_orig == uref2->date_orig);
+    assert(uref1->dts_pts_delay == uref2->dts_pts_delay);
+    assert(uref1->duration == uref2->duration);
+
+    unsigned int nb_attrs = 0;
+    const char *name = NULL;
+    enum udict_type type = UDICT_TYPE_END;
+    while (ubase_check(udict_iterate(uref1->udict, &name, &type)) &&
+           type != UDICT_TYPE_END) {
+        size_t size1, size2;
+        const uint8_t *value1, *value2;
+        ubase_assert(udict_get(uref1->udict, name, type, &size1, &value1));
+        ubase_assert(udict_get(uref2->udict, name, type, &size2, &value2));
+        assert(size1 == size2);
+        assert(!memcmp(value1, value2, size1));
+        nb_attrs++;
+    }
+    while (ubase_check(udict_iterate(uref2->udict, &name, &type)) &&
+           type != UDICT_TYPE_END)
+        nb_attrs--;
+    assert(!nb_attrs);
+}
+
+static void test_serial(struct uref_mgr *uref_mgr)
+{
+    struct uref *uref1 = uref_block_flow_alloc_def(uref_mgr, "foo.");
+    assert(uref1 != NULL);
+    ubase_assert(uref_test_set_index(uref1, 1));
+    ubase_assert(uref_test_set_constant(uref1, "same"));
+    uref_block_set_start(uref1);
+    uref_clock_set_pts_prog(uref1, 27000000);
+    uref_clock_set_dts_pts_delay(uref1, 1080000);
+    uref_clock_set_duration(uref1, 1080000);
+
+    size_t size1;
+    ubase_assert(uref_serial_encode(uref1, NULL, NULL, &size1));
+    uint8_t buffer1[size1];
+    size_t size = size1 - 1;
+    assert(uref_serial_encode(uref1, NULL, buffer1, &size) ==
+           UBASE_ERR_NOSPC);
+    size = size1;
+    ubase_assert(uref_serial_encode(uref1, NULL, buffer1, &size));
+    assert(size == size1);
+
+    struct uref *decoded1 = uref_alloc(uref_mgr);
+    assert(decoded1 != NULL);
+    ubase_assert(uref_serial_decode(decoded1, NULL, buffer1, size1));
+    check_same(uref1, decoded1);
+    ubase_nassert(uref_serial_decode(decoded1, NULL, buffer1, size1 - 1));
+
+    /* only the differences with the reference are written */
+    struct uref *uref2 = uref_dup(uref1);
+    assert(uref2 != NULL);
+    ubase_assert(uref_test_set_index(uref2, 2));
+    uref_block_delete_start(uref2);
+    uref_clock_set_pts_prog(uref2, 2 * 27000000);
+
+    size_t size2;
+    ubase_assert(uref_serial_encode(uref2, uref1, NULL, &size2));
+    assert(size2 < size1);
+    uint8_t buffer2[size2];
+    ubase_assert(uref_serial_encode(uref2, uref1, buffer2, &size2));
+
+    struct uref *decoded2 = uref_alloc(uref_mgr);
+    assert(decoded2 != NULL);
+    ubase_assert(uref_serial_decode(decoded2, decoded1, buffer2, size2));
+    check_same(uref2, decoded2);
+
+    uref_free(decoded2);
+    uref_free(decoded1);
+    uref_free(uref2);
+    uref_free(uref1);
+}
+
+static void test_serial_invalid(struct uref_mgr *uref_mgr)
+{
+    struct uref *uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+
+    /* valid shorthand attribute */
+    const uint8_t duration[] = { 0, 0, UDICT_TYPE_CLOCK_DURATION, 8,
+                                 0, 0, 0, 0, 0, 0, 0, 42, UDICT_TYPE_END };
+    ubase_assert(uref_serial_decode(uref, NULL, duration, sizeof(duration)));
+
+    /* deletion of the end marker */
+    const uint8_t delete_end[] = { 0, 0, 0x80, UDICT_TYPE_END };
+    ubase_nassert(uref_serial_decode(uref, NULL, delete_end,
+                                     sizeof(delete_end)));
+
+    /* fixed-size types with a wrong size */
+    const uint8_t bad_shorthand[] = { 0, 0, UDICT_TYPE_CLOCK_DURATION, 1, 42,
+                                      UDICT_TYPE_END };
+    ubase_nassert(uref_serial_decode(uref, NULL, bad_shorthand,
+                                     sizeof(bad_shorthand)));
+    const uint8_t bad_rational[] = { 0, 0, UDICT_TYPE_RATIONAL, 1, 'a', 8,
+                                     0, 0, 0, 0, 0, 0, 0, 1, UDICT_TYPE_END };
+    ubase_nassert(uref_serial_decode(uref, NULL, bad_rational,
+                                     sizeof(bad_rational)));
+    const uint8_t bad_void[] = { 0, 0, UDICT_TYPE_VOID, 1, 'a', 1, 0,
+                                 UDICT_TYPE_END };
+    ubase_nassert(uref_serial_decode(uref, NULL, bad_void, sizeof(bad_void)));
+
+    /* undefined types */
+    const uint8_t undefined[] = { 0, 0, UDICT_TYPE_FLOAT + 1, 1, 'a', 0,
+                                  UDICT_TYPE_END };
+    ubase_nassert(uref_serial_decode(uref, NULL, undefined,
+                                     sizeof(undefined)));
+    const uint8_t undefined_shorthand[] = { 0, 0, UDICT_TYPE_PIC_CEA_708 + 1,
+                                            0, UDICT_TYPE_END };
+    ubase_nassert(uref_serial_decode(uref, NULL, undefined_shorthand,
+                                     sizeof(undefined_shorthand)));
+
+    /* unterminated string and name containing a nul */
+    const uint8_t bad_string[] = { 0, 0, UDICT_TYPE_STRING, 1, 'a', 1, 'x',
+                                   UDICT_TYPE_END };
+    ubase_nassert(uref_serial_decode(uref, NULL, bad_string,
+                                     sizeof(bad_string)));
+    const uint8_t bad_name[] = { 0, 0, UDICT_TYPE_VOID, 2, 'a', 0, 0,
+                                 UDICT_TYPE_END };
+    ubase_nassert(uref_serial_decode(uref, NULL, bad_name, sizeof(bad_name)));
+
+    /* value too large for a udict */
+    size_t large_size = 70000 + 8;
+    uint8_t *large = calloc(1, large_size);
+    assert(large != NULL);
+    const uint8_t large_header[] = { 0, 0, UDICT_TYPE_OPAQUE, 1, 'a',
+                                     0xf0, 0xa2, 0x04 };
+    memcpy(large, large_header, sizeof(large_header));
+    large[large_size - 1] = UDICT_TYPE_END;
+    ubase_nassert(uref_serial_decode(uref, NULL, large, large_size));
+    free(large);
+
+    uref_free(uref);
+}
+
+static void test_pipes(struct uprobe *logger, struct uref_mgr *uref_mgr,
+                       struct ubuf_mgr *ubuf_mgr)
+{
+    struct upipe_mgr *upipe_urefser_mgr = upipe_urefser_mgr_alloc();
+    assert(upipe_urefser_mgr != NULL);
+    struct upipe *urefser = upipe_void_alloc(upipe_urefser_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "urefser"));
+    assert(urefser != NULL);
+    struct upipe *capture = upipe_void_alloc(&capture_mgr, uprobe_use(logger));
+    assert(capture != NULL);
+    ubase_assert(upipe_set_output(urefser, capture));
+
+    struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr, "foo.");
+    assert(flow_def != NULL);
+    ubase_assert(uref_test_set_constant(flow_def, "flow"));
+    ubase_assert(upipe_set_flow_def(urefser, flow_def));
+    uref_free(flow_def);
+
+    for (int i = 0; i < NB_UREFS; i++) {
+        struct uref *uref;
+        if (i == NB_UREFS - 1)
+            uref = uref_alloc(uref_mgr);
+        else {
+            uref = uref_block_alloc(uref_mgr, ubuf_mgr, 100 * (i + 1));
+            assert(uref != NULL);
+            int size = -1;
+            uint8_t *buffer;
+            ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+            for (int j = 0; j < size; j++)
+                buffer[j] = j + i;
+            ubase_assert(uref_block_unmap(uref, 0));
+            ubase_assert(uref_test_set_constant(uref, "same"));
+        }
+        assert(uref != NULL);
+        ubase_assert(uref_test_set_index(uref, i));
+        if (!i)
+            uref_block_set_start(uref);
+        uref_clock_set_pts_prog(uref, 27000000 * i);
+        upipe_input(urefser, uref, NULL);
+    }
+    assert(nb_frames == NB_UREFS + 1);
+    assert(stream != NULL);
+    upipe_release(urefser);
+
+    struct upipe_mgr *upipe_urefdeser_mgr = upipe_urefdeser_mgr_alloc();
+    assert(upipe_urefdeser_mgr != NULL);
+    struct upipe *urefdeser = upipe_void_alloc(upipe_urefdeser_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "urefdeser"));
+    assert(urefdeser != NULL);
+    struct upipe *sink = upipe_void_alloc(&test_mgr, uprobe_use(logger));
+    assert(sink != NULL);
+    ubase_assert(upipe_set_output(urefdeser, sink));
+
+    flow_def = uref_block_flow_alloc_def(uref_mgr, "foo.");
+    assert(flow_def != NULL);
+    ubase_nassert(upipe_set_flow_def(urefdeser, flow_def));
+    uref_free(flow_def);
+    flow_def = uref_block_flow_alloc_def(uref_mgr, "uref.");
+    assert(flow_def != NULL);
+    ubase_assert(upipe_set_flow_def(urefdeser, flow_def));
+    uref_free(flow_def);
+
+    /* feed the stream by small chunks */
+    size_t total;
+    ubase_assert(uref_block_size(stream, &total));
+    for (size_t offset = 0; offset < total; offset += CHUNK_SIZE) {
+        size_t size = total - offset < CHUNK_SIZE ? total - offset :
+                                                    CHUNK_SIZE;
+        struct uref *chunk = uref_block_splice(stream, offset, size);
+        assert(chunk != NULL);
+        upipe_input(urefdeser, chunk, NULL);
+    }
+    assert(received == NB_UREFS);
+    uref_free(stream);
+
+    upipe_release(urefdeser);
+    test_free(sink);
+    test_free(capture);
+    upipe_mgr_release(upipe_urefdeser_mgr); // nop
+    upipe_mgr_release(upipe_urefser_mgr); // nop
+}
+
+int main(int argc, char **argv)
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                   udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 0, 0, 0, 0);
+    assert(ubuf_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    test_serial(uref_mgr);
+    test_serial_invalid(uref_mgr);
+    test_pipes(logger, uref_mgr, ubuf_mgr);
+
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    return 0;
+}
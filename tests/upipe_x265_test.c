@@ -179,6 +179,9 @@ static void fill_pic(struct uref *uref, int counter)
     }
 }
 
+/** number of stats events received */
+static unsigned int nb_stats = 0;
+
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
                  int event, va_list args)
@@ -191,6 +194,15 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
         case UPROBE_DEAD:
         case UPROBE_NEW_FLOW_DEF:
             break;
+        case UPROBE_X265_STATS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_X265_SIGNATURE)
+            unsigned int queued = va_arg(args, unsigned int);
+            uint64_t latency = va_arg(args, uint64_t);
+            assert(queued < LIMIT);
+            assert(latency < LIMIT * UCLOCK_FREQ);
+            nb_stats++;
+            break;
+        }
     }
     return UBASE_ERR_NONE;
 }
@@ -283,6 +295,8 @@ int main(int argc, char **argv)
 
     /* release pipes */
     upipe_release(x265);
+    assert(nb_stats ==
+           (unsigned int)x265_test_from_upipe(x265_test)->counter);
     test_free(x265_test);
 
     /* clean everything */
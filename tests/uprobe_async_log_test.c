@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short unit tests for asynchronous logging probe
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe-pthread/uprobe_async_log.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#define NB_THREADS 4
+#define NB_MSGS 500
+
+static struct uprobe *logger;
+
+static void *thread_entry(void *opaque)
+{
+    int id = (intptr_t)opaque;
+    for (int i = 0; i < NB_MSGS; i++)
+        uprobe_dbg_va(logger, NULL, "thread %d message %d", id, i);
+    return NULL;
+}
+
+static unsigned int count_lines(FILE *f, const char *prefix)
+{
+    char line[UPROBE_ASYNC_LOG_MSG_SIZE + 1];
+    unsigned int count = 0;
+    rewind(f);
+    while (fgets(line, sizeof(line), f) != NULL)
+        if (!strncmp(line, prefix, strlen(prefix)))
+            count++;
+    return count;
+}
+
+static unsigned int run(unsigned int ring_size)
+{
+    FILE *f = tmpfile();
+    assert(f != NULL);
+    logger = uprobe_async_log_alloc(NULL, f, UPROBE_LOG_DEBUG, ring_size);
+    assert(logger != NULL);
+
+    uprobe_verbose(logger, NULL, "filtered out");
+    uprobe_notice(logger, NULL, "main thread");
+    uprobe_async_log_flush(logger);
+    assert(count_lines(f, "notice: main thread\n") == 1);
+    assert(count_lines(f, "verbose:") == 0);
+    fseek(f, 0, SEEK_END);
+
+    pthread_t threads[NB_THREADS];
+    for (intptr_t i = 0; i < NB_THREADS; i++)
+        assert(pthread_create(&threads[i], NULL, thread_entry,
+                              (void *)i) == 0);
+    for (int i = 0; i < NB_THREADS; i++)
+        assert(pthread_join(threads[i], NULL) == 0);
+
+    uprobe_async_log_flush(logger);
+    unsigned int dropped = uprobe_async_log_get_dropped(logger);
+    assert(dropped <= NB_THREADS * NB_MSGS);
+    assert(count_lines(f, "debug: thread ") == NB_THREADS * NB_MSGS - dropped);
+    if (dropped)
+        assert(count_lines(f, "warning: ") >= 1);
+
+    uprobe_release(logger);
+    fclose(f);
+    return dropped;
+}
+
+int main(int argc, char **argv)
+{
+    /* each thread fits in its ring */
+    assert(run(NB_MSGS) == 0);
+    printf("Passed 1\n");
+
+    /* tiny rings may overflow but never block */
+    unsigned int dropped = run(2);
+    printf("Passed 2 (%u dropped)\n", dropped);
+    return 0;
+}
@@ -33,6 +33,7 @@
 #include <upipe/uprobe.h>
 #include <upipe/uprobe_stdio.h>
 #include <upipe/uprobe_dejitter.h>
+#include <upipe/uprobe_prefix.h>
 #include <upipe/upipe.h>
 #include <upipe/umem.h>
 #include <upipe/umem_alloc.h>
@@ -40,6 +41,7 @@
 #include <upipe/udict_inline.h>
 #include <upipe/uref.h>
 #include <upipe/uref_clock.h>
+#include <upipe/uclock.h>
 #include <upipe/uref_std.h>
 
 #include <stdio.h>
@@ -87,9 +89,17 @@ int main(int argc, char **argv)
                                                            true, 1);
     assert(uprobe_dejitter != NULL);
 
+    struct uprobe *uprobe_pfx = uprobe_pfx_alloc(uprobe_use(uprobe_dejitter),
+                                                 UPROBE_LOG_VERBOSE, "test");
+    assert(uprobe_pfx != NULL);
+
     struct upipe test_pipe;
-    test_pipe.uprobe = uprobe_dejitter;
+    upipe_init(&test_pipe, NULL, uprobe_pfx);
     struct upipe *upipe = &test_pipe;
+    /* clock events skip the prefix probe */
+    assert(upipe->uprobe_clock[UPROBE_CLOCK_REF - UPROBE_CLOCK_REF] ==
+           uprobe_dejitter);
+    assert(upipe->uprobe_clock[UPROBE_CLOCK_UTC - UPROBE_CLOCK_REF] == &uprobe);
 
     uint64_t systime = UINT32_MAX;
     uint64_t clock = 0;
@@ -115,7 +125,73 @@ int main(int argc, char **argv)
     ubase_assert(uref_clock_get_pts_sys(uref, &pts));
     assert(pts == systime + 2002);
 
+    /* the dispatch table is refreshed when a probe changes its events */
+    uprobe_set_events(uprobe_pfx, UPROBE_EVENTS_ALL);
+    uref_clock_set_pts_prog(uref, clock);
+    upipe_throw_clock_ts(upipe, uref);
+    ubase_assert(uref_clock_get_pts_sys(uref, &pts));
+    assert(pts == systime + 2002);
+    assert(upipe->uprobe_clock[UPROBE_CLOCK_TS - UPROBE_CLOCK_REF] ==
+           uprobe_pfx);
+
+    /* PI controller locking on a stream clock running 50 ppm fast */
+    struct uprobe_dejitter *dejitter =
+        uprobe_dejitter_from_uprobe(uprobe_dejitter);
+    uprobe_dejitter_set_bandwidth(uprobe_dejitter, 100);
+    systime = UINT32_MAX;
+    clock = UINT32_MAX;
+    for (int i = 0; i < 250; i++) {
+        /* up to 1 ms of network jitter */
+        uref_clock_set_cr_sys(uref, systime + (i * 7919) % 27001);
+        upipe_throw_clock_ref(upipe, uref, clock, 0);
+        systime += 1080054;
+        clock += 1080000;
+    }
+    int64_t ppm = (dejitter->drift_rate.num - (int64_t)dejitter->drift_rate.den) *
+                  1000000 / (int64_t)dejitter->drift_rate.den;
+    assert(ppm >= 40 && ppm <= 60);
+
+    uref_clock_set_pts_prog(uref, clock);
+    upipe_throw_clock_ts(upipe, uref);
+    ubase_assert(uref_clock_get_pts_sys(uref, &pts));
+    assert(pts >= systime && pts <= systime + UCLOCK_FREQ / 100);
+
+    /* a discontinuity keeps the drift and dates again immediately */
+    struct urational rate = dejitter->drift_rate;
+    clock += 100 * UCLOCK_FREQ;
+    uref_clock_set_cr_sys(uref, systime);
+    upipe_throw_clock_ref(upipe, uref, clock, 1);
+    assert(dejitter->drift_rate.num == rate.num &&
+           dejitter->drift_rate.den == rate.den);
+    uref_clock_set_pts_prog(uref, clock + 1080000);
+    upipe_throw_clock_ts(upipe, uref);
+    ubase_assert(uref_clock_get_pts_sys(uref, &pts));
+    assert(pts >= systime + 1080000 &&
+           pts <= systime + 1080000 + UCLOCK_FREQ / 100);
+
+    /* another program of the same source shares the drift */
+    struct uprobe *follower = uprobe_dejitter_alloc(uprobe_use(logger),
+                                                    true, 0);
+    assert(follower != NULL);
+    uprobe_dejitter_set_bandwidth(follower, 100);
+    uprobe_dejitter_set_master(follower, uprobe_dejitter);
+    struct upipe follower_pipe;
+    upipe_init(&follower_pipe, NULL, uprobe_use(follower));
+    for (int i = 0; i < 2; i++) {
+        uref_clock_set_cr_sys(uref, systime);
+        upipe_throw_clock_ref(&follower_pipe, uref, clock + UCLOCK_FREQ, 0);
+        systime += 1080054;
+        clock += 1080000;
+    }
+    struct uprobe_dejitter *follower_dejitter =
+        uprobe_dejitter_from_uprobe(follower);
+    assert(follower_dejitter->drift_rate.num == rate.num &&
+           follower_dejitter->drift_rate.den == rate.den);
+    upipe_clean(&follower_pipe);
+    uprobe_release(follower);
+
     uref_free(uref);
+    uprobe_release(uprobe_pfx);
     uprobe_release(uprobe_dejitter);
     uprobe_release(logger);
     uprobe_clean(&uprobe);
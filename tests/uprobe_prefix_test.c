@@ -32,6 +32,7 @@
 #include <upipe/uprobe.h>
 #include <upipe/uprobe_stdio.h>
 #include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_loglevel.h>
 
 #include <stdio.h>
 #include <string.h>
@@ -45,6 +46,7 @@ int main(int argc, char **argv)
     struct uprobe *uprobe1 = uprobe_pfx_alloc(uprobe_use(uprobe2),
                                               UPROBE_LOG_DEBUG, "pfx");
     assert(uprobe1 != NULL);
+    assert(uprobe_get_log_level(uprobe1) == UPROBE_LOG_DEBUG);
 
     uprobe_err(uprobe1, NULL, "This is an error");
     uprobe_warn_va(uprobe1, NULL, "This is a %s warning with %d", "composite",
@@ -56,10 +58,24 @@ int main(int argc, char **argv)
     uprobe1 = uprobe_pfx_alloc_va(uprobe_use(uprobe2),
                                   UPROBE_LOG_ERROR, "pfx[%d]", 2);
     assert(uprobe1 != NULL);
+    assert(uprobe_get_log_level(uprobe1) == UPROBE_LOG_ERROR);
     uprobe_err_va(uprobe1, NULL, "This is another error with %d", 0x43);
     uprobe_warn(uprobe1, NULL, "This is a warning that you shouldn't see");
     uprobe_release(uprobe1);
 
+    struct uprobe *uprobe3 = uprobe_loglevel_alloc(uprobe_use(uprobe2),
+                                                   UPROBE_LOG_WARNING);
+    assert(uprobe3 != NULL);
+    uprobe1 = uprobe_pfx_alloc(uprobe_use(uprobe3), UPROBE_LOG_VERBOSE, "pfx");
+    assert(uprobe1 != NULL);
+    assert(uprobe_get_log_level(uprobe1) == UPROBE_LOG_WARNING);
+    uint32_t log_generation = uprobe_log_generation;
+    ubase_assert(uprobe_loglevel_set(uprobe3, "pfx", UPROBE_LOG_NOTICE));
+    assert(uprobe_log_generation != log_generation);
+    assert(uprobe_get_log_level(uprobe1) == UPROBE_LOG_NOTICE);
+    uprobe_release(uprobe1);
+    uprobe_release(uprobe3);
+
     uprobe_release(uprobe2);
     return 0;
 }
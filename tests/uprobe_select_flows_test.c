@@ -410,6 +410,47 @@ int main(int argc, char **argv)
     assert(!add_flows);
     assert(!del_flows);
 
+    uprobe_release(uprobe_selflow);
+    uprobe_release(upipe->uprobe);
+
+    /* one program out of many: the others never get a subpipe */
+
+    uprobe_selflow = uprobe_selflow_alloc(uprobe_use(logger), uprobe_use(logger), UPROBE_SELFLOW_VOID, "105");
+    assert(uprobe_selflow != NULL);
+    upipe->uprobe = uprobe_use(uprobe_selflow);
+
+    for (uint64_t id = 100; id < 120; id++) {
+        flow_def = uref_program_flow_alloc_def(uref_mgr);
+        assert(flow_def != NULL);
+        ubase_assert(uref_flow_set_id(flow_def, id));
+        ulist_add(&flow_defs, uref_to_uchain(flow_def));
+    }
+    add_flows = 105;
+    upipe_split_throw_update(upipe);
+    assert(!add_flows);
+    assert(!del_flows);
+    upipe_split_throw_update(upipe);
+    assert(!add_flows);
+    assert(!del_flows);
+    uprobe_selflow_get(uprobe_selflow, &flows);
+    assert(!strcmp(flows, "105,"));
+
+    add_flows = 110;
+    del_flows = 105;
+    uprobe_selflow_set(uprobe_selflow, "110");
+    assert(!add_flows);
+    assert(!del_flows);
+
+    ulist_delete_foreach (&flow_defs, uchain, uchain_tmp) {
+        struct uref *flow_def = uref_from_uchain(uchain);
+        ulist_delete(uchain);
+        uref_free(flow_def);
+    }
+    del_flows = 110;
+    upipe_split_throw_update(upipe);
+    assert(!add_flows);
+    assert(!del_flows);
+
     test_free(upipe);
 
     uprobe_release(uprobe_selflow);
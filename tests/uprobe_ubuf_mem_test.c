@@ -161,6 +161,36 @@ static void test_YUYV(struct ubuf_mgr *mgr)
     ubuf_free(ubuf);
 }
 
+static void test_simd(struct ubuf_mgr *mgr)
+{
+    /* the manager has more padding than the flow format requires */
+    ubase_assert(ubuf_mgr_check(mgr, flow_def));
+
+    struct ubuf *ubuf = ubuf_pic_alloc(mgr, 30, 32);
+    assert(ubuf != NULL);
+
+    size_t stride;
+    ubase_assert(ubuf_pic_plane_size(ubuf, "y8", &stride, NULL, NULL, NULL));
+    assert(!(stride % UPROBE_UBUF_MEM_SIMD_ALIGN));
+    assert(stride >= 30 + 2 * 4);
+
+    const uint8_t *r;
+    ubase_assert(ubuf_pic_plane_read(ubuf, "y8", 0, 0, -1, -1, &r));
+    assert(!((uintptr_t)r % UPROBE_UBUF_MEM_SIMD_ALIGN));
+    ubase_assert(ubuf_pic_plane_unmap(ubuf, "y8", 0, 0, -1, -1));
+
+    ubase_assert(ubuf_pic_resize(ubuf, -4, -2, 38, 36));
+    ubase_nassert(ubuf_pic_resize(ubuf, -1, 0, -1, -1));
+    ubuf_free(ubuf);
+}
+
+static struct ubuf_mgr *cached_mgr;
+
+static void test_cache(struct ubuf_mgr *mgr)
+{
+    cached_mgr = mgr;
+}
+
 /** helper phony pipe to test uprobe_ubuf_mem */
 static int uprobe_test_provide_ubuf_mgr(struct urequest *urequest, va_list args)
 {
@@ -251,6 +281,89 @@ int main(int argc, char **argv)
     uprobe_test_free(upipe);
     uref_free(flow_def);
 
+    /* minimum alignment and padding set on the probe */
+    uprobe_ubuf_mem_set_pic_align(uprobe, UPROBE_UBUF_MEM_SIMD_ALIGN, 4, 2);
+    test_mgr = test_simd;
+    flow_def = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(flow_def != NULL);
+    ubase_assert(uref_pic_flow_set_hmappend(flow_def, 1));
+    ubase_assert(uref_pic_flow_set_align(flow_def, 16));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 1, 1, 1, "y8"));
+
+    upipe = upipe_void_alloc(&uprobe_test_mgr, uprobe_use(uprobe));
+    struct urequest request;
+    urequest_init_ubuf_mgr(&request, uref_dup(flow_def),
+                           uprobe_test_provide_ubuf_mgr, NULL);
+    ubase_assert(upipe_throw_provide_request(upipe, &request));
+    urequest_clean(&request);
+    uprobe_test_free(upipe);
+    uref_free(flow_def);
+
+    /* managers are reused for recently seen flow formats */
+    uprobe_ubuf_mem_set_cache(uprobe, 2);
+    test_mgr = test_cache;
+    struct uref *flow_defs[3];
+    for (int i = 0; i < 3; i++) {
+        flow_defs[i] = uref_pic_flow_alloc_def(uref_mgr, 1);
+        assert(flow_defs[i] != NULL);
+        ubase_assert(uref_pic_flow_add_plane(flow_defs[i], 1, 1, 1, "y8"));
+        ubase_assert(uref_pic_flow_set_hsize(flow_defs[i], 16 << i));
+    }
+    struct ubuf_mgr *mgrs[3];
+    upipe = upipe_void_alloc(&uprobe_test_mgr, uprobe_use(uprobe));
+    for (int i = 0; i < 3; i++) {
+        urequest_init_ubuf_mgr(&request, uref_dup(flow_defs[i % 2]),
+                               uprobe_test_provide_ubuf_mgr, NULL);
+        ubase_assert(upipe_throw_provide_request(upipe, &request));
+        urequest_clean(&request);
+        mgrs[i] = cached_mgr;
+    }
+    assert(mgrs[0] != mgrs[1]);
+    assert(mgrs[0] == mgrs[2]);
+
+    /* the least recently used manager is evicted */
+    urequest_init_ubuf_mgr(&request, uref_dup(flow_defs[2]),
+                           uprobe_test_provide_ubuf_mgr, NULL);
+    ubase_assert(upipe_throw_provide_request(upipe, &request));
+    urequest_clean(&request);
+    urequest_init_ubuf_mgr(&request, uref_dup(flow_defs[0]),
+                           uprobe_test_provide_ubuf_mgr, NULL);
+    ubase_assert(upipe_throw_provide_request(upipe, &request));
+    urequest_clean(&request);
+    assert(cached_mgr == mgrs[0]);
+    urequest_init_ubuf_mgr(&request, uref_dup(flow_defs[1]),
+                           uprobe_test_provide_ubuf_mgr, NULL);
+    ubase_assert(upipe_throw_provide_request(upipe, &request));
+    urequest_clean(&request);
+    uprobe_test_free(upipe);
+    for (int i = 0; i < 3; i++)
+        uref_free(flow_defs[i]);
+    uprobe_ubuf_mem_set_cache(uprobe, 0);
+
+    /* flow format helpers */
+    flow_def = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(flow_def != NULL);
+    uint64_t align;
+    ubase_assert(uref_pic_flow_require_align(flow_def, 16));
+    ubase_assert(uref_pic_flow_get_align(flow_def, &align));
+    assert(align == 16);
+    ubase_assert(uref_pic_flow_require_align(flow_def, 8));
+    ubase_assert(uref_pic_flow_get_align(flow_def, &align));
+    assert(align == 16);
+    ubase_assert(uref_pic_flow_require_align(flow_def, 24));
+    ubase_assert(uref_pic_flow_get_align(flow_def, &align));
+    assert(align == 48);
+    uint8_t padding;
+    ubase_assert(uref_pic_flow_set_vappend(flow_def, 8));
+    ubase_assert(uref_pic_flow_require_padding(flow_def, 2, 0, 4, 4));
+    ubase_assert(uref_pic_flow_get_hmprepend(flow_def, &padding));
+    assert(padding == 2);
+    ubase_assert(uref_pic_flow_get_vprepend(flow_def, &padding));
+    assert(padding == 4);
+    ubase_assert(uref_pic_flow_get_vappend(flow_def, &padding));
+    assert(padding == 8);
+    uref_free(flow_def);
+
     uprobe_release(uprobe);
     uref_mgr_release(uref_mgr);
     udict_mgr_release(udict_mgr);
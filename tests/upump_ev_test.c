@@ -29,6 +29,8 @@
 
 #undef NDEBUG
 
+#include <upipe/uclock.h>
+#include <upipe/uclock_std.h>
 #include <upipe/upump.h>
 #include <upipe/upump_blocker.h>
 #include <upump-ev/upump_ev.h>
@@ -130,12 +132,33 @@ int main(int argc, char **argv)
                                        pipefd[0]);
     assert(read_watcher != NULL);
 
+    /* Profile the loop */
+    struct uclock *uclock = uclock_std_alloc(0);
+    assert(uclock != NULL);
+    struct upump_profile profile;
+    struct upump_mgr_profile mgr_profile;
+    ubase_nassert(upump_mgr_get_profile(mgr, &mgr_profile));
+    ubase_assert(upump_mgr_set_profiling(mgr, uclock));
+
     /* Start tests */
     upump_start(write_idler);
     upump_mgr_run(mgr, NULL);
     assert(bytes_read);
     assert(bytes_read == bytes_written);
 
+    ubase_assert(upump_get_profile(read_timer, &profile));
+    assert(profile.count == 1);
+    assert(profile.max_lateness < timeout);
+    ubase_assert(upump_get_profile(write_idler, &profile));
+    assert(profile.count > 1);
+    assert(profile.max_run_time <= profile.run_time);
+    ubase_assert(upump_mgr_get_profile(mgr, &mgr_profile));
+    assert(mgr_profile.iterations);
+    assert(mgr_profile.max_busy_time <= mgr_profile.busy_time);
+    ubase_assert(upump_mgr_set_profiling(mgr, NULL));
+    ubase_nassert(upump_get_profile(read_timer, &profile));
+    uclock_release(uclock);
+
     /* Clean up */
     upump_free(write_idler);
     upump_free(write_watcher);
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/** @file
+ * @short unit tests for coarse timers scheduled on the timer wheel
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/uclock.h>
+#include <upipe/uclock_std.h>
+#include <upipe/upump.h>
+#include <upump-uring/upump_uring.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#define UPUMP_POOL 0
+#define UPUMP_BLOCKER_POOL 0
+#define NB_TIMERS 64
+#define STEP (UCLOCK_FREQ / 200)
+#define PERIOD (UCLOCK_FREQ / 150)
+#define NB_REPEATS 20
+#define NB_RESTARTS 3
+#define SLACK (UCLOCK_FREQ / 20)
+
+static struct uclock *uclock;
+static uint64_t start;
+static unsigned int nb_fired = 0;
+static unsigned int nb_repeats = 0;
+static unsigned int nb_restarts = 0;
+static struct upump *upump_victim;
+
+/** checks that a timer triggers after its delay, within the slack */
+static void check_elapsed(uint64_t after)
+{
+    uint64_t elapsed = uclock_now(uclock) - start;
+    assert(elapsed >= after);
+    assert(elapsed < after + UPUMP_TIMER_COARSE_TICK + SLACK);
+}
+
+static void one_shot(struct upump *upump)
+{
+    uint64_t after = (uintptr_t)upump_get_opaque(upump, void *);
+    check_elapsed(after);
+    nb_fired++;
+}
+
+static void canceled(struct upump *upump)
+{
+    abort();
+}
+
+static void repeat(struct upump *upump)
+{
+    nb_repeats++;
+    assert(uclock_now(uclock) - start >= nb_repeats * PERIOD);
+    if (nb_repeats == NB_REPEATS)
+        upump_stop(upump);
+}
+
+static void restart(struct upump *upump)
+{
+    nb_restarts++;
+    check_elapsed(nb_restarts * STEP);
+    if (nb_restarts < NB_RESTARTS)
+        upump_start(upump);
+}
+
+/** expires in the same tick as the victim, and frees it */
+static void killer(struct upump *upump)
+{
+    if (upump_victim != NULL) {
+        upump_free(upump_victim);
+        upump_victim = NULL;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uclock = uclock_std_alloc(0);
+    assert(uclock != NULL);
+    struct upump_mgr *upump_mgr =
+        upump_uring_mgr_alloc(UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+
+    /* the latest timers go beyond the first level of the wheel */
+    struct upump *upumps[NB_TIMERS];
+    for (unsigned int i = 0; i < NB_TIMERS; i++) {
+        uint64_t after = i * STEP;
+        upumps[i] = upump_alloc_timer_coarse(upump_mgr, one_shot,
+                                             (void *)(uintptr_t)after, NULL,
+                                             after, 0);
+        assert(upumps[i] != NULL);
+    }
+    struct upump *upump_canceled =
+        upump_alloc_timer_coarse(upump_mgr, canceled, NULL, NULL, STEP, 0);
+    assert(upump_canceled != NULL);
+    struct upump *upump_repeat =
+        upump_alloc_timer_coarse(upump_mgr, repeat, NULL, NULL,
+                                 PERIOD, PERIOD);
+    assert(upump_repeat != NULL);
+    struct upump *upump_restart =
+        upump_alloc_timer_coarse(upump_mgr, restart, NULL, NULL, STEP, 0);
+    assert(upump_restart != NULL);
+    struct upump *upump_killer =
+        upump_alloc_timer_coarse(upump_mgr, killer, NULL, NULL, STEP, 0);
+    assert(upump_killer != NULL);
+    upump_victim =
+        upump_alloc_timer_coarse(upump_mgr, canceled, NULL, NULL, STEP, 0);
+    assert(upump_victim != NULL);
+
+    start = uclock_now(uclock);
+    for (unsigned int i = 0; i < NB_TIMERS; i++)
+        upump_start(upumps[i]);
+    upump_start(upump_canceled);
+    upump_start(upump_repeat);
+    upump_start(upump_restart);
+    upump_start(upump_killer);
+    upump_start(upump_victim);
+    upump_stop(upump_canceled);
+
+    /* the loop exits once the wheel is empty */
+    upump_mgr_run(upump_mgr, NULL);
+    assert(nb_fired == NB_TIMERS);
+    assert(nb_repeats == NB_REPEATS);
+    assert(nb_restarts == NB_RESTARTS);
+    assert(upump_victim == NULL);
+
+    for (unsigned int i = 0; i < NB_TIMERS; i++)
+        upump_free(upumps[i]);
+    upump_free(upump_canceled);
+    upump_free(upump_repeat);
+    upump_free(upump_restart);
+    upump_free(upump_killer);
+    upump_mgr_release(upump_mgr);
+    uclock_release(uclock);
+    return 0;
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for upump manager with io_uring event loop
+ */
+
+#undef NDEBUG
+
+#include <upipe/uclock.h>
+#include <upipe/uclock_std.h>
+#include <upipe/upump.h>
+#include <upipe/upump_blocker.h>
+#include <upump-uring/upump_uring.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <assert.h>
+
+#define UPUMP_POOL 1
+#define UPUMP_BLOCKER_POOL 1
+
+static uint64_t timeout = UINT64_C(27000000); /* 1 s */
+static const char *padding = "This is an initialized bit of space used to pad sufficiently !";
+/* This is an arbitrarily large number that is just supposed to be bigger than
+ * the buffer space of a pipe. */
+#define MIN_READ (128*1024)
+
+static int pipefd[2];
+static struct upump_mgr *mgr;
+static struct upump *write_idler;
+static struct upump *read_timer;
+static struct upump *write_watcher;
+static struct upump *read_watcher;
+static struct upump *io_reader;
+static struct upump_blocker *blocker = NULL;
+static ssize_t bytes_written = 0, bytes_read = 0;
+static char io_buffer[64];
+static unsigned int io_reads = 0;
+
+static void blocker_cb(struct upump_blocker *blocker)
+{
+    upump_blocker_free(blocker);
+}
+
+static void write_idler_cb(struct upump *upump)
+{
+    ssize_t ret = write(pipefd[1], padding, strlen(padding) + 1);
+    if (ret == -1 && (errno == EWOULDBLOCK || errno == EAGAIN)) {
+        printf("write idler blocked\n");
+        blocker = upump_blocker_alloc(write_idler, blocker_cb, NULL, NULL);
+        assert(blocker != NULL);
+        upump_start(write_watcher);
+        upump_start(read_timer);
+    } else {
+        assert(ret != -1);
+        bytes_written += ret;
+    }
+}
+
+static void write_watcher_cb(struct upump *unused)
+{
+    printf("write watcher passed\n");
+    upump_blocker_free(blocker);
+    upump_stop(write_watcher);
+}
+
+static void read_timer_cb(struct upump *unused)
+{
+    printf("read timer passed\n");
+    upump_start(read_watcher);
+    /* The timer is automatically stopped */
+}
+
+static void read_watcher_cb(struct upump *unused)
+{
+    char buffer[strlen(padding) + 1];
+    ssize_t ret = read(pipefd[0], buffer, strlen(padding) + 1);
+    assert(ret != -1);
+    bytes_read += ret;
+    if (bytes_read > MIN_READ) {
+        printf("read watcher passed\n");
+        upump_stop(write_idler);
+        upump_stop(read_watcher);
+    }
+}
+
+static void io_reader_cb(struct upump *upump)
+{
+    ssize_t result;
+    ubase_assert(upump_uring_get_result(upump, &result));
+    assert(result == strlen(padding) + 1);
+    assert(!strcmp(io_buffer, padding));
+    io_reads++;
+    if (io_reads == 1) {
+        /* second read, into a registered buffer */
+        memset(io_buffer, 0, sizeof(io_buffer));
+        ubase_assert(upump_uring_submit_read(upump, io_buffer,
+                                             strlen(padding) + 1, 0, 0));
+    } else {
+        printf("io reader passed\n");
+        upump_stop(upump);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    long flags;
+    mgr = upump_uring_mgr_alloc(UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    if (mgr == NULL) {
+        printf("io_uring not supported, skipping\n");
+        return 77;
+    }
+
+    /* Create a pipe with non-blocking write */
+    assert(pipe(pipefd) != -1);
+    flags = fcntl(pipefd[1], F_GETFL);
+    assert(flags != -1);
+    flags |= O_NONBLOCK;
+    assert(fcntl(pipefd[1], F_SETFL, flags) != -1);
+
+    /* Create watchers */
+    write_idler = upump_alloc_idler(mgr, write_idler_cb, NULL, NULL);
+    assert(write_idler != NULL);
+    write_watcher = upump_alloc_fd_write(mgr, write_watcher_cb, NULL, NULL,
+                                         pipefd[1]);
+    assert(write_watcher != NULL);
+    read_timer = upump_alloc_timer(mgr, read_timer_cb, NULL, NULL, timeout, 0);
+    assert(read_timer != NULL);
+    read_watcher = upump_alloc_fd_read(mgr, read_watcher_cb, NULL, NULL,
+                                       pipefd[0]);
+    assert(read_watcher != NULL);
+
+    /* Profile the loop */
+    struct uclock *uclock = uclock_std_alloc(0);
+    assert(uclock != NULL);
+    struct upump_profile profile;
+    struct upump_mgr_profile mgr_profile;
+    ubase_nassert(upump_mgr_get_profile(mgr, &mgr_profile));
+    ubase_assert(upump_mgr_set_profiling(mgr, uclock));
+
+    /* Start tests */
+    upump_start(write_idler);
+    upump_mgr_run(mgr, NULL);
+    assert(bytes_read);
+    assert(bytes_read == bytes_written);
+
+    ubase_assert(upump_get_profile(read_timer, &profile));
+    assert(profile.count == 1);
+    assert(profile.max_lateness < timeout);
+    ubase_assert(upump_get_profile(write_idler, &profile));
+    assert(profile.count > 1);
+    assert(profile.max_run_time <= profile.run_time);
+    ubase_assert(upump_mgr_get_profile(mgr, &mgr_profile));
+    assert(mgr_profile.iterations);
+    assert(mgr_profile.max_busy_time <= mgr_profile.busy_time);
+    ubase_assert(upump_mgr_set_profiling(mgr, NULL));
+    ubase_nassert(upump_get_profile(read_timer, &profile));
+    uclock_release(uclock);
+
+    /* Asynchronous I/O on a regular file */
+    char path[] = "/tmp/upump_uring_test.XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    unlink(path);
+    assert(write(fd, padding, strlen(padding) + 1) == strlen(padding) + 1);
+    struct iovec iovec = { .iov_base = io_buffer, .iov_len = sizeof(io_buffer) };
+    ubase_assert(upump_uring_mgr_register_buffers(mgr, &iovec, 1));
+    io_reader = upump_uring_alloc_fd_io(mgr, io_reader_cb, NULL, NULL, fd);
+    assert(io_reader != NULL);
+    upump_start(io_reader);
+    ubase_assert(upump_uring_submit_read(io_reader, io_buffer,
+                                         strlen(padding) + 1, 0, -1));
+    upump_mgr_run(mgr, NULL);
+    assert(io_reads == 2);
+    ubase_assert(upump_uring_mgr_unregister_buffers(mgr));
+
+    /* Clean up */
+    upump_free(write_idler);
+    upump_free(write_watcher);
+    upump_free(read_timer);
+    upump_free(read_watcher);
+    upump_free(io_reader);
+    upump_mgr_release(mgr);
+    close(fd);
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for rings of urefs
+ */
+
+#undef NDEBUG
+
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_ring.h>
+
+#include <stdio.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 1
+#define UREF_POOL_DEPTH 1
+#define RING_SIZE 64
+
+int main(int argc, char **argv)
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
+    assert(mgr != NULL);
+
+    struct uref_ring ring;
+    ubase_nassert(uref_ring_init(&ring, 48));
+    ubase_assert(uref_ring_init(&ring, RING_SIZE));
+    assert(uref_ring_peek(&ring, NULL) == NULL);
+    assert(uref_ring_pop(&ring, NULL) == NULL);
+
+    /* out of order insertion across the wrap of sequence numbers */
+    static const uint16_t seqnums[] = { 65534, 0, 65535, 2, 1, 65533 };
+    struct uref *urefs[UBASE_ARRAY_SIZE(seqnums)];
+    for (unsigned i = 0; i < UBASE_ARRAY_SIZE(seqnums); i++) {
+        urefs[i] = uref_alloc(mgr);
+        assert(urefs[i] != NULL);
+        assert(uref_ring_is_late(&ring, seqnums[i]) ==
+               (i == 2 || i == 4 || i == 5));
+        ubase_assert(uref_ring_insert(&ring, seqnums[i], urefs[i]));
+    }
+    assert(uref_ring_count(&ring) == UBASE_ARRAY_SIZE(seqnums));
+    for (unsigned i = 0; i < UBASE_ARRAY_SIZE(seqnums); i++)
+        assert(uref_ring_get(&ring, seqnums[i]) == urefs[i]);
+    assert(uref_ring_get(&ring, 3) == NULL);
+    assert(uref_ring_get(&ring, 65532) == NULL);
+
+    /* duplicates and sequence numbers outside of the window */
+    struct uref *uref = uref_alloc(mgr);
+    assert(uref != NULL);
+    assert(uref_ring_insert(&ring, 1, uref) == UBASE_ERR_BUSY);
+    assert(!uref_ring_fits(&ring, (uint16_t)(65533 + RING_SIZE)));
+    assert(uref_ring_insert(&ring, (uint16_t)(65533 + RING_SIZE), uref) ==
+           UBASE_ERR_INVALID);
+    assert(uref_ring_fits(&ring, (uint16_t)(65533 + RING_SIZE - 1)));
+    assert(!uref_ring_fits(&ring, (uint16_t)(2 - RING_SIZE)));
+
+    /* holes are skipped */
+    ubase_assert(uref_ring_insert(&ring, 10, uref));
+    uint16_t seqnum;
+    uint16_t expected = 65533;
+    while ((uref = uref_ring_pop(&ring, &seqnum)) != NULL) {
+        assert(seqnum == expected);
+        expected = seqnum == 2 ? 10 : seqnum + 1;
+        uref_free(uref);
+    }
+    assert(expected == 11);
+    assert(uref_ring_count(&ring) == 0);
+
+    /* a late uref moves the window back */
+    uref = uref_alloc(mgr);
+    ubase_assert(uref_ring_insert(&ring, 100, uref));
+    assert(uref_ring_pop(&ring, NULL) == uref);
+    ubase_assert(uref_ring_insert(&ring, 100, uref));
+    uref = uref_alloc(mgr);
+    ubase_assert(uref_ring_insert(&ring, 98, uref));
+    assert(uref_ring_peek(&ring, &seqnum) == uref);
+    assert(seqnum == 98);
+
+    uref_ring_clean(&ring);
+    uref_mgr_release(mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    return 0;
+}
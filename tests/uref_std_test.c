@@ -35,6 +35,8 @@
 #include <upipe/udict_inline.h>
 #include <upipe/uref.h>
 #include <upipe/uref_std.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_pic.h>
 
 #include <stdio.h>
 #include <string.h>
@@ -71,6 +73,34 @@ int main(int argc, char **argv)
     assert(uref1 != NULL);
     uref_free(uref1);
 
+    /* per-packet attributes stored in the uref structure */
+    uref1 = uref_alloc(mgr);
+    assert(uref1 != NULL);
+    uint64_t v;
+    ubase_nassert(uref_clock_get_duration(uref1, &v));
+    ubase_nassert(uref_clock_delete_duration(uref1));
+    ubase_assert(uref_clock_set_duration(uref1, 42));
+    ubase_assert(uref_pic_set_number(uref1, 12));
+    ubase_nassert(uref_pic_get_key(uref1));
+    ubase_assert(uref_pic_set_key(uref1));
+    assert(uref1->udict == NULL);
+    uref2 = uref_dup(uref1);
+    assert(uref2 != NULL);
+    ubase_assert(uref_clock_get_duration(uref2, &v));
+    assert(v == 42);
+    ubase_assert(uref_pic_get_number(uref2, &v));
+    assert(v == 12);
+    ubase_assert(uref_pic_get_key(uref2));
+    ubase_assert(uref_pic_delete_key(uref2));
+    ubase_nassert(uref_pic_get_key(uref2));
+    ubase_assert(uref_pic_copy_key(uref2, uref1));
+    ubase_assert(uref_pic_get_key(uref2));
+    ubase_assert(uref_clock_delete_duration(uref1));
+    ubase_assert(uref_clock_copy_duration(uref2, uref1));
+    ubase_nassert(uref_clock_get_duration(uref2, &v));
+    uref_free(uref2);
+    uref_free(uref1);
+
     uref_mgr_release(mgr);
     udict_mgr_release(udict_mgr);
     umem_mgr_release(umem_mgr);
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for in-place filtering of TS packets by PID
+ */
+
+#undef NDEBUG
+
+#include <upipe/uts_filter.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#define NB_PACKETS 7
+
+static void build_packet(uint8_t *ts, uint16_t pid)
+{
+    memset(ts, pid & 0xff, UTS_FILTER_PACKET_SIZE);
+    ts[0] = UTS_FILTER_SYNC;
+    ts[1] = pid >> 8;
+    ts[2] = pid & 0xff;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint16_t pids[NB_PACKETS] =
+        { 0, 8191, 68, 8191, 8191, 69, 68 };
+    uint8_t buffer[NB_PACKETS * UTS_FILTER_PACKET_SIZE];
+    uint8_t filter[UTS_FILTER_SIZE];
+    memset(filter, 0, sizeof(filter));
+    uts_filter_set_pid(filter, 0);
+    uts_filter_set_pid(filter, 68);
+    uts_filter_set_pid(filter, 69);
+    assert(uts_filter_check_pid(filter, 68));
+    assert(!uts_filter_check_pid(filter, 8191));
+
+    for (int i = 0; i < NB_PACKETS; i++)
+        build_packet(buffer + i * UTS_FILTER_PACKET_SIZE, pids[i]);
+    assert(uts_filter_compact(NULL, buffer, sizeof(buffer)) ==
+           sizeof(buffer));
+
+    /* null packets are removed and the others moved down */
+    size_t size = uts_filter_compact(filter, buffer, sizeof(buffer));
+    assert(size == 4 * UTS_FILTER_PACKET_SIZE);
+    static const uint16_t kept[4] = { 0, 68, 69, 68 };
+    for (int i = 0; i < 4; i++) {
+        uint8_t ts[UTS_FILTER_PACKET_SIZE];
+        build_packet(ts, kept[i]);
+        assert(!memcmp(buffer + i * UTS_FILTER_PACKET_SIZE, ts, sizeof(ts)));
+    }
+
+    /* nothing left */
+    uts_filter_clear_pid(filter, 0);
+    uts_filter_clear_pid(filter, 68);
+    uts_filter_clear_pid(filter, 69);
+    assert(uts_filter_compact(filter, buffer, size) == 0);
+
+    /* packets without a sync byte, or partial packets, are not dropped */
+    for (int i = 0; i < NB_PACKETS; i++)
+        build_packet(buffer + i * UTS_FILTER_PACKET_SIZE, pids[i]);
+    buffer[UTS_FILTER_PACKET_SIZE] = 0;
+    assert(uts_filter_compact(filter, buffer, 2 * UTS_FILTER_PACKET_SIZE) ==
+           UTS_FILTER_PACKET_SIZE);
+    assert(uts_filter_compact(filter, buffer, sizeof(buffer) - 1) ==
+           sizeof(buffer) - 1);
+    return 0;
+}
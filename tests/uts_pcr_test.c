@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for in-place access to the PCR of TS packets
+ */
+
+#undef NDEBUG
+
+#include <upipe/uts_pcr.h>
+
+#include <string.h>
+#include <assert.h>
+
+#define NB_PACKETS 3
+
+static void build_packet(uint8_t *ts, bool pcr)
+{
+    memset(ts, 0xff, UTS_PCR_PACKET_SIZE);
+    ts[0] = UTS_PCR_SYNC;
+    ts[1] = 0x00;
+    ts[2] = 68;
+    if (!pcr) {
+        ts[3] = 0x10;
+        return;
+    }
+    ts[3] = 0x30;
+    ts[4] = 7;
+    ts[5] = 0x10;
+    uts_pcr_set(ts, 0);
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t buffer[NB_PACKETS * UTS_PCR_PACKET_SIZE];
+    uint64_t pcr;
+
+    build_packet(buffer, true);
+    build_packet(buffer + UTS_PCR_PACKET_SIZE, false);
+    build_packet(buffer + 2 * UTS_PCR_PACKET_SIZE, true);
+
+    /* round trip, including the extension and the reserved bits */
+    uts_pcr_set(buffer, UTS_PCR_WRAP - 1);
+    assert(uts_pcr_get(buffer, &pcr));
+    assert(pcr == UTS_PCR_WRAP - 1);
+    assert((buffer[10] & 0x7e) == 0x7e);
+    assert(!uts_pcr_get(buffer + UTS_PCR_PACKET_SIZE, &pcr));
+
+    assert(uts_pcr_add(UTS_PCR_WRAP - 1, 2) == 1);
+    assert(uts_pcr_add(1, -2) == UTS_PCR_WRAP - 1);
+    assert(uts_pcr_add(1000, -(int64_t)UTS_PCR_WRAP) == 1000);
+
+    /* only the packets carrying a PCR are modified */
+    uts_pcr_set(buffer, 27000000);
+    uts_pcr_set(buffer + 2 * UTS_PCR_PACKET_SIZE, 27027000);
+    uint8_t payload[UTS_PCR_PACKET_SIZE];
+    memcpy(payload, buffer + UTS_PCR_PACKET_SIZE, sizeof(payload));
+    assert(uts_pcr_restamp(buffer, sizeof(buffer), 27 * 300) == 2);
+    assert(uts_pcr_get(buffer, &pcr));
+    assert(pcr == 27000000 + 27 * 300);
+    assert(uts_pcr_get(buffer + 2 * UTS_PCR_PACKET_SIZE, &pcr));
+    assert(pcr == 27027000 + 27 * 300);
+    assert(!memcmp(payload, buffer + UTS_PCR_PACKET_SIZE, sizeof(payload)));
+
+    assert(uts_pcr_restamp(buffer, sizeof(buffer), -27 * 301) == 2);
+    assert(uts_pcr_get(buffer, &pcr));
+    assert(pcr == 27000000 - 27);
+
+    /* partial packets are left untouched */
+    assert(uts_pcr_restamp(buffer, sizeof(buffer) - 1, 1) == 0);
+    assert(uts_pcr_get(buffer, &pcr));
+    assert(pcr == 27000000 - 27);
+
+    /* interpolation needs two PCRs */
+    struct uts_pcr_interp interp;
+    uts_pcr_interp_init(&interp);
+    assert(!uts_pcr_interp_update(&interp, 0, UTS_PCR_WRAP - 27000));
+    assert(!uts_pcr_interp_get(&interp, UTS_PCR_PACKET_SIZE, &pcr));
+    assert(uts_pcr_interp_update(&interp, 10 * UTS_PCR_PACKET_SIZE, 27000));
+    assert(uts_pcr_interp_get(&interp, 15 * UTS_PCR_PACKET_SIZE, &pcr));
+    assert(pcr == 27000 + 27000);
+    assert(uts_pcr_interp_get(&interp, 20 * UTS_PCR_PACKET_SIZE, &pcr));
+    assert(pcr == 27000 + 54000);
+    assert(!uts_pcr_interp_get(&interp, 0, &pcr));
+
+    /* a burst gives the same dates as single packets */
+    uint64_t pcrs[7];
+    assert(uts_pcr_interp_burst(&interp, 11 * UTS_PCR_PACKET_SIZE, 7, pcrs));
+    for (unsigned int i = 0; i < 7; i++) {
+        assert(uts_pcr_interp_get(&interp, (11 + i) * UTS_PCR_PACKET_SIZE,
+                                  &pcr));
+        assert(pcrs[i] == pcr);
+    }
+    assert(pcrs[4] == 27000 + 5400 * 5);
+
+    /* the rate survives discontinuities and too large intervals */
+    uts_pcr_interp_discontinuity(&interp);
+    assert(!uts_pcr_interp_get(&interp, 21 * UTS_PCR_PACKET_SIZE, &pcr));
+    assert(!uts_pcr_interp_update(&interp, 30 * UTS_PCR_PACKET_SIZE, 1000));
+    assert(uts_pcr_interp_get(&interp, 31 * UTS_PCR_PACKET_SIZE, &pcr));
+    assert(pcr == 1000 + 5400);
+    assert(!uts_pcr_interp_update(&interp, 32 * UTS_PCR_PACKET_SIZE, 500));
+    assert(uts_pcr_interp_get(&interp, 33 * UTS_PCR_PACKET_SIZE, &pcr));
+    assert(pcr == 500 + 5400);
+    return 0;
+}